@@ -0,0 +1,151 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "analysis/liveness.h"
+#include "analysis/loop_info.h"
+#include "analysis/post_dom_tree.h"
+#include "ir/function.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * =================================================================
+ * --- 分析管理器 (Analysis Manager) ---
+ * =================================================================
+ *
+ * 按函数缓存分析结果，让一条流水线中的各个变换和验证器共享它们，而不是各自重算。
+ * 每个函数的每种分析有自己的 Arena；分析失效时它的 Arena 被重置，内存留给下一次计算。
+ *
+ * 用法: 需要分析时调用 ir_analysis_get_* (没有缓存才计算)；变换修改了函数之后
+ * 调用 ir_analysis_invalidate，传入它保留的分析集合。依赖于失效分析的结果
+ * (例如 CFG 失效时的支配树) 会一起失效。
+ *
+ * 管理器不是线程安全的。
+ */
+
+/** @brief 管理器知道的分析 (依赖只指向编号更小的分析) */
+typedef enum IRAnalysisKind
+{
+  /// 控制流图 (FunctionCFG)
+  IR_ANALYSIS_CFG,
+  /// 支配树 (DominatorTree，依赖 CFG)
+  IR_ANALYSIS_DOM_TREE,
+  /// 支配边界 (DominanceFrontier，依赖支配树)
+  IR_ANALYSIS_DOM_FRONTIER,
+  /// 后支配树 (PostDominatorTree，依赖 CFG)
+  IR_ANALYSIS_POST_DOM_TREE,
+  /// 后支配边界 (DominanceFrontier，依赖后支配树)
+  IR_ANALYSIS_POST_DOM_FRONTIER,
+  /// 循环嵌套森林 (LoopInfo，依赖支配树)
+  IR_ANALYSIS_LOOPS,
+  /// 活跃变量 (Liveness，依赖 CFG；还依赖指令，所以不在 IR_PRESERVE_CFG_ANALYSES 中)
+  IR_ANALYSIS_LIVENESS,
+  IR_ANALYSIS_COUNT
+} IRAnalysisKind;
+
+/** @brief 分析的集合 (每种分析一位) */
+typedef uint32_t IRAnalysisSet;
+
+#define IR_ANALYSIS_BIT(kind) ((IRAnalysisSet)1 << (kind))
+
+/** @brief 什么都不保留 (默认的保守选择) */
+#define IR_PRESERVE_NONE ((IRAnalysisSet)0)
+/** @brief 全部保留 (没有修改函数) */
+#define IR_PRESERVE_ALL (IR_ANALYSIS_BIT(IR_ANALYSIS_COUNT) - 1)
+/** @brief 只依赖控制流的分析: 只改了指令、没有增删基本块或改动终结指令的变换保留它们 */
+#define IR_PRESERVE_CFG_ANALYSES                                                                                       \
+  (IR_ANALYSIS_BIT(IR_ANALYSIS_CFG) | IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_TREE) |                                          \
+   IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_FRONTIER) | IR_ANALYSIS_BIT(IR_ANALYSIS_POST_DOM_TREE) |                            \
+   IR_ANALYSIS_BIT(IR_ANALYSIS_POST_DOM_FRONTIER) | IR_ANALYSIS_BIT(IR_ANALYSIS_LOOPS))
+
+/** @brief 分析管理器 (定义在 analysis_manager.c 内部) */
+typedef struct IRAnalysisManager IRAnalysisManager;
+
+/**
+ * @brief 创建一个空的分析管理器。
+ * @return 新管理器；OOM 时返回 NULL
+ */
+IRAnalysisManager *ir_analysis_manager_create(void);
+
+/**
+ * @brief 销毁管理器和它缓存的所有结果。
+ */
+void ir_analysis_manager_destroy(IRAnalysisManager *am);
+
+/**
+ * @brief 取得 func 的某种分析结果，没有缓存时先计算 (连同它依赖的分析)。
+ *
+ * 延迟加载的函数体会先被物化。结果在对应的分析失效之前一直有效。
+ *
+ * @return 分析结果 (类型见 IRAnalysisKind)；声明 (没有基本块) 或物化失败时返回 NULL
+ */
+void *ir_analysis_get(IRAnalysisManager *am, IRFunction *func, IRAnalysisKind kind);
+
+/** @brief ir_analysis_get 的 CFG 版本 */
+FunctionCFG *ir_analysis_get_cfg(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的支配树版本 */
+DominatorTree *ir_analysis_get_dom_tree(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的支配边界版本 */
+DominanceFrontier *ir_analysis_get_dom_frontier(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的后支配树版本 */
+PostDominatorTree *ir_analysis_get_post_dom_tree(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的后支配边界版本 */
+DominanceFrontier *ir_analysis_get_post_dom_frontier(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的循环信息版本 */
+LoopInfo *ir_analysis_get_loops(IRAnalysisManager *am, IRFunction *func);
+
+/** @brief ir_analysis_get 的活跃变量版本 */
+Liveness *ir_analysis_get_liveness(IRAnalysisManager *am, IRFunction *func);
+
+/**
+ * @brief func 的某种分析当前是否有缓存 (不会触发计算)。
+ */
+bool ir_analysis_is_cached(IRAnalysisManager *am, IRFunction *func, IRAnalysisKind kind);
+
+/**
+ * @brief 修改 func 之后让不再成立的分析失效。
+ *
+ * 不在 preserved 中的分析失效；依赖于失效分析的分析即使在 preserved 中也一起失效。
+ *
+ * @param preserved 变换保留的分析 (IR_PRESERVE_*)
+ */
+void ir_analysis_invalidate(IRAnalysisManager *am, IRFunction *func, IRAnalysisSet preserved);
+
+/**
+ * @brief 对模块中的每个函数调用 ir_analysis_invalidate (模块级变换之后使用)。
+ */
+void ir_analysis_invalidate_module(IRAnalysisManager *am, IRModule *mod, IRAnalysisSet preserved);
+
+/**
+ * @brief 丢掉 func 的全部缓存 (函数被删除之前调用)。
+ */
+void ir_analysis_forget(IRAnalysisManager *am, IRFunction *func);
+
+/**
+ * @brief 到目前为止某种分析被计算了多少次 (用于测试和统计缓存的效果)。
+ */
+size_t ir_analysis_num_computed(const IRAnalysisManager *am, IRAnalysisKind kind);
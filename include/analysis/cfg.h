@@ -20,37 +20,36 @@
 #include "ir/function.h"
 #include "ir/instruction.h"
 #include "utils/bump.h"
-#include "utils/hashmap.h"
-#include "utils/id_list.h"
 
 typedef struct CFGNode CFGNode;
 
-/**
- * @brief CFG 图中的一条边
- * 存储在 CFGNode 的 successors/predecessors 链表中
- */
-typedef struct CFGEdge
-{
-  CFGNode *node;
-  IDList list_node;
-} CFGEdge;
-
 /**
  * @brief CFG 图中的一个节点
+ *
+ * 后继和前驱是节点 id 的连续数组 (CSR)：cfg_build 把所有节点的后继放在一整块数组里，
+ * 前驱放在另一块里，按节点顺序相邻；遍历边就是线性扫描。
+ * 增量修改 (cfg_insert_edge 等) 让某个节点的数组放不下时，只把它搬到新的位置。
  */
 struct CFGNode
 {
   IRBasicBlock *block;
   int id;
 
-  IDList successors;
-  IDList predecessors;
+  int *succs;
+  int num_succs;
+  int succ_capacity;
+
+  int *preds;
+  int num_preds;
+  int pred_capacity;
 };
 
 typedef struct FunctionCFG
 {
   IRFunction *func;
   int num_nodes;
+  /// nodes 数组的容量 (cfg_split_block 添加节点时按倍数增长)
+  int capacity;
 
   Bump arena;
 
@@ -58,8 +57,6 @@ typedef struct FunctionCFG
 
   CFGNode *entry_node;
 
-  PtrHashMap *block_to_node_map;
-
 } FunctionCFG;
 
 /**
@@ -72,15 +69,78 @@ typedef struct FunctionCFG
 FunctionCFG *cfg_build(IRFunction *func, Bump *arena);
 
 /**
- * @brief 销毁 CFG (释放其内部竞技场和 hashmap)
+ * @brief 构建反向 CFG (后支配树用): 所有边反向，再加一个虚拟出口节点作为入口
+ *
+ * 节点 i (i < cfg->num_nodes) 与 cfg 中的节点 i 是同一个块；虚拟出口是最后一个节点
+ * (id 为 cfg->num_nodes，block 为 NULL)，它指向每个没有后继的块 (ret / unreachable)。
+ * 到不了任何出口的块 (无限循环) 也要从虚拟出口可达：按 id 从大到小，对每个仍然不可达的块
+ * 加一条虚拟出口到它的边，它能 (反向) 到达的块随之可达。
+ *
+ * @param cfg 正向 CFG (不会被修改)
+ * @param arena 用于 FunctionCFG 结构自身 (与 cfg_build 相同，节点在它自己的 arena 中，用 cfg_destroy 释放)
+ * @return 反向 CFG；cfg 没有节点时返回一个空的 CFG (entry_node 为 NULL)
+ */
+FunctionCFG *cfg_build_reverse(FunctionCFG *cfg, Bump *arena);
+
+/**
+ * @brief 销毁 CFG (释放其内部竞技场)
  */
 void cfg_destroy(FunctionCFG *cfg);
 
 /**
- * @brief [辅助函数] 通过 IRBasicBlock* 获取 CFGNode*
+ * @brief 检查边 from -> to 是否存在
+ */
+bool cfg_contains_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to);
+
+/**
+ * @brief 添加一条边 from -> to (边是集合: 已经存在时什么都不做)
+ *
+ * 只修改 CFG，不修改 IR；支配树请用 analysis/dom_update.h 一起更新。
+ * @return 新加了边时返回 true
+ */
+bool cfg_insert_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to);
+
+/**
+ * @brief 删除边 from -> to
+ * @return 边存在并被删除时返回 true
+ */
+bool cfg_remove_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to);
+
+/**
+ * @brief 拆分基本块: new_block 接管 block 的所有出边，block 只剩一条边 block -> new_block
+ *
+ * 对应 IR 上把 block 的后半部分 (含终结指令) 移到 new_block，再在 block 末尾加 br。
+ * 容量不够时 nodes 数组会被重新分配，之前取得的 CFGNode* 随之失效 (id 不变)。
+ * new_block->id 被设为新节点的 id。
+ *
+ * @return new_block 的节点 (id 为原来的 num_nodes)；block 不在 CFG 中时返回 NULL
+ */
+CFGNode *cfg_split_block(FunctionCFG *cfg, IRBasicBlock *block, IRBasicBlock *new_block);
+
+/**
+ * @brief [辅助函数] 通过 IRBasicBlock* 获取 CFGNode* (O(1): 用块上的 id 下标)
+ *
+ * 块不在这个 CFG 中 (或 id 属于之后为同一函数构建的另一个 CFG) 时返回 NULL。
  */
 static inline CFGNode *
 cfg_get_node(FunctionCFG *cfg, IRBasicBlock *bb)
 {
-  return (CFGNode *)ptr_hashmap_get(cfg->block_to_node_map, bb);
+  int id = bb->id;
+  if (id < 0 || id >= cfg->num_nodes || cfg->nodes[id].block != bb)
+    return NULL;
+  return &cfg->nodes[id];
+}
+
+/** @brief 节点的第 i 个后继 */
+static inline CFGNode *
+cfg_succ(FunctionCFG *cfg, const CFGNode *node, int i)
+{
+  return &cfg->nodes[node->succs[i]];
+}
+
+/** @brief 节点的第 i 个前驱 */
+static inline CFGNode *
+cfg_pred(FunctionCFG *cfg, const CFGNode *node, int i)
+{
+  return &cfg->nodes[node->preds[i]];
 }
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "analysis/cfg.h"
+#include "utils/bitset.h"
+#include "utils/bump.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * =================================================================
+ * --- 通用数据流求解器 (Dataflow Framework) ---
+ * =================================================================
+ *
+ * 在 FunctionCFG 上求单调数据流问题的不动点。问题由格值的回调描述 (格值对求解器是不透明的
+ * void*)，常见的 Bitset gen/kill 问题可以直接用 dataflow_gen_kill_problem。
+ *
+ * 每个块有入口值 in 和出口值 out:
+ * - 前向: in(B) = reset(B) ⊓ (⊓ out(P), P 是前驱)，out(B) = transfer(B, in(B))
+ * - 后向: out(B) = reset(B) ⊓ (⊓ in(S), S 是后继)，in(B) = transfer(B, out(B))
+ *
+ * 工作表按块的顺序排列 (前向用逆后序，后向用后序；不可达的块排在最后)，
+ * 每一轮按这个顺序处理所有待处理的块；一个块的结果变化时，它的后继 (后向为前驱) 重新待处理。
+ */
+
+typedef enum DataflowDirection
+{
+  DATAFLOW_FORWARD,
+  DATAFLOW_BACKWARD
+} DataflowDirection;
+
+/**
+ * @brief 一个数据流问题: 方向和格上的操作
+ *
+ * 回调的第一个参数都是 user_data。求解器只通过这些回调访问格值。
+ */
+typedef struct DataflowProblem
+{
+  DataflowDirection direction;
+  void *user_data;
+
+  /// 在 arena 中分配一个格值，初始为 top (meet 的单位元)
+  void *(*create)(void *user_data, Bump *arena);
+  /// 把 value 设为 meet 的起点: 边界块 (前向为入口块，后向为没有后继的块) 是边界值，其余一般是 top
+  void (*reset)(void *user_data, const CFGNode *node, bool boundary, void *value);
+  /// dest = dest ⊓ src
+  void (*meet)(void *user_data, void *dest, const void *src);
+  /// output = f_B(input)；返回 output 是否改变
+  bool (*transfer)(void *user_data, const CFGNode *node, const void *input, void *output);
+} DataflowProblem;
+
+/**
+ * @brief 求解结果: 每个块 (按 id) 的入口值和出口值
+ */
+typedef struct DataflowResult
+{
+  FunctionCFG *cfg;
+  void **in;
+  void **out;
+  /// 处理块 (调用 transfer) 的次数
+  size_t num_visits;
+} DataflowResult;
+
+/**
+ * @brief 求 problem 在 cfg 上的最大不动点
+ *
+ * @param arena 用于分配结果和所有格值 (工作表在内部的临时 Arena 中)
+ * @return DataflowResult*
+ */
+DataflowResult *dataflow_solve(FunctionCFG *cfg, const DataflowProblem *problem, Bump *arena);
+
+/**
+ * @brief 并行求解中的一个任务 (通常是一个函数)
+ *
+ * 不同任务的 arena 和 problem->user_data 必须互不共享；回调只能读写自己任务的数据。
+ */
+typedef struct DataflowJob
+{
+  FunctionCFG *cfg;
+  const DataflowProblem *problem;
+  Bump *arena;
+  /// 输出: dataflow_solve 的结果
+  DataflowResult *result;
+} DataflowJob;
+
+/**
+ * @brief 在 num_threads 个线程上 (调用线程是其中之一) 求解互相独立的任务
+ *
+ * num_threads 为 0 或 1，或者平台没有 <threads.h> 时，按顺序在调用线程上求解。
+ */
+void dataflow_solve_parallel(DataflowJob *jobs, size_t num_jobs, size_t num_threads);
+
+/*
+ * --- Bitset gen/kill 问题 ---
+ */
+
+/**
+ * @brief 格值是 Bitset 的 gen/kill 问题: f_B(x) = gen(B) ∪ (x - kill(B))
+ *
+ * meet 是并集 (may 问题，top 为空集) 或交集 (must 问题，top 为全集)。
+ * 例如活跃变量是后向的并集问题，可用表达式是前向的交集问题。
+ */
+typedef struct DataflowGenKill
+{
+  size_t num_bits;
+  /// 每个块 (按 id) 的 gen / kill 集合
+  Bitset **gen;
+  Bitset **kill;
+  /// 可选: 每个块 meet 的起点再并上的集合 (例如活跃变量中 phi 在前驱出口处的使用)
+  Bitset **init;
+  /// 可选: 边界块的值 (NULL 表示空集)
+  const Bitset *boundary;
+  /// true 时 meet 是交集，否则是并集
+  bool intersect;
+} DataflowGenKill;
+
+/**
+ * @brief 用 gk 的集合构造一个数据流问题 (gk 在求解期间必须有效)
+ */
+DataflowProblem dataflow_gen_kill_problem(DataflowGenKill *gk, DataflowDirection direction);
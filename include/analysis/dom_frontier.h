@@ -20,8 +20,20 @@
 #include "analysis/dom_tree.h"
 #include "ir/basicblock.h"
 #include "ir/function.h"
-#include "utils/bitset.h"
 #include "utils/bump.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 一个块的支配边界: 按升序排列的块 id
+ */
+typedef struct DomFrontierSet
+{
+  int *ids;
+  int count;
+  /// ids 的容量 (增量更新时放不下才换一块新的)
+  int capacity;
+} DomFrontierSet;
 
 /**
  * @struct DominanceFrontier
@@ -30,7 +42,9 @@
  * 对于每个基本块 B，它的支配边界 DF(B) 是这样一个块 Y 的集合：
  * B 支配 Y 的一个前驱，但 B 并不严格支配 Y。
  *
- * 这个结构主要用于 SSA 构造（mem2reg），以确定在何处插入 PHI 节点。
+ * 集合是稀疏的 (有序的 id 数组)，总大小与所有边界的元素个数成正比，
+ * 而不是块数的平方。只需要迭代支配边界 (插入 phi 的位置) 时，
+ * 用下面的 IDFCalculator 直接计算，不必先算出全部的支配边界。
  */
 typedef struct DominanceFrontier
 {
@@ -41,11 +55,17 @@ typedef struct DominanceFrontier
 
   /**
    * 支配边界集合的数组。
-   * 这是一个大小为 N (函数中的块数) 的数组，其中每个元素是一个 BitSet。
-   * frontiers[i] 存储的是 ID 为 i 的基本块的支配边界集合。
+   * 这是一个大小为 N (函数中的块数) 的数组。
+   * frontiers[i] 存储的是 ID 为 i 的基本块的支配边界集合；
+   * 刚计算完时所有集合的 ids 连续地放在同一个数组中。
    */
-  Bitset **frontiers;
+  DomFrontierSet *frontiers;
   size_t num_blocks;
+  /// frontiers 数组的容量 (拆分基本块时按倍数增长)
+  size_t capacity;
+  /// 增量重算用的临时数据: 去重标记和收集缓冲区 (大小为 capacity)
+  bool *mark;
+  int *buffer;
 
   Bump *arena;
 
@@ -66,13 +86,75 @@ DominanceFrontier *ir_analysis_dom_frontier_compute(DominatorTree *dt, Bump *are
  */
 void ir_analysis_dom_frontier_destroy(DominanceFrontier *df);
 
+/**
+ * @brief 重新计算 dirty[id] 为 true 的块的支配边界 (增量更新用)
+ *
+ * 要求: 支配树已经更新并重新编号；dirty 集合在支配树上向上封闭
+ * (一个块是 dirty 时它的所有支配者也是)，其余块的边界仍然正确。
+ * 不可达的 dirty 块的边界被清空。
+ */
+void ir_analysis_dom_frontier_refresh(DominanceFrontier *df, const bool *dirty);
+
+/**
+ * @brief 让支配边界容纳 num_blocks 个块 (新块的边界为空)
+ */
+void ir_analysis_dom_frontier_grow(DominanceFrontier *df, size_t num_blocks);
+
 /**
  * @brief 获取指定基本块的支配边界集合。
  * @param df 计算好的 DominanceFrontier 实例。
  * @param bb 要查询的基本块。
- * @return 一个 (const) BitSet，表示 bb 的支配边界。
- * 如果块无效，则返回 NULL。
+ * @return bb 的支配边界 (升序的块 id)。如果块无效，则返回 NULL。
+ */
+const DomFrontierSet *ir_analysis_dom_frontier_get(DominanceFrontier *df, IRBasicBlock *bb);
+
+/**
+ * @brief y 是否在 bb 的支配边界中 (二分查找)
+ */
+bool ir_analysis_dom_frontier_contains(DominanceFrontier *df, IRBasicBlock *bb, IRBasicBlock *y);
+
+/*
+ * =================================================================
+ * --- 迭代支配边界 (IDF) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 迭代支配边界的计算器 (Sreedhar-Gao 的 DJ 图算法)
+ *
+ * 给定一组定义块，直接求出它们的迭代支配边界 DF+(defs) (即 SSA 构造中要放 phi 的块)，
+ * 只用支配树和 CFG，不需要 DominanceFrontier。按支配树深度从深到浅处理定义块，
+ * 每个块在一次计算中最多访问一次，所以一次计算是 O(块数 + 边数)。
+ * 临时数组在 init 时分配一次，之后可以对同一棵支配树反复计算 (例如每个变量一次)。
+ */
+typedef struct IDFCalculator
+{
+  DominatorTree *dom_tree;
+  int capacity;
+  /// 标记: 数组元素等于 epoch 表示本次计算中已设置
+  unsigned epoch;
+  unsigned *is_def;
+  unsigned *in_idf;
+  unsigned *visited;
+  /// 按深度的最大堆，和支配树上向下遍历用的栈
+  DomTreeNode **heap;
+  DomTreeNode **worklist;
+} IDFCalculator;
+
+/**
+ * @brief 为支配树 dt 准备一个 IDF 计算器 (临时数组分配在 arena 中)
+ * @return 分配失败时返回 false
+ */
+bool ir_analysis_idf_init(IDFCalculator *calc, DominatorTree *dt, Bump *arena);
+
+/**
+ * @brief 计算定义块集合的迭代支配边界
+ *
+ * @param def_blocks 定义块的 id (可以重复；不可达的块被忽略)
+ * @param num_defs def_blocks 的个数
+ * @param out_blocks 输出 DF+ 中的块 id (至少要能放下块数个，顺序不确定)
+ * @return DF+ 中的块数
  */
-Bitset *ir_analysis_dom_frontier_get(DominanceFrontier *df, IRBasicBlock *bb);
+size_t ir_analysis_idf_compute(IDFCalculator *calc, const int *def_blocks, size_t num_defs, int *out_blocks);
 
 #endif
\ No newline at end of file
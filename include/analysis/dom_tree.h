@@ -64,6 +64,15 @@ struct DomTreeNode
 
   DomTreeNode *ancestor;
   DomTreeNode *label;
+
+  /// 支配树上的 DFS 先序/后序编号 (从 1 开始；不可达的节点为 0)：
+  /// a 支配 b 当且仅当 a->dom_pre <= b->dom_pre 且 b->dom_post <= a->dom_post
+  int dom_pre;
+  int dom_post;
+  /// 在支配树上的深度 (根为 1，不可达的节点为 0)
+  int depth;
+  /// 父节点 children 链表中代表自己的项 (根和不可达的节点为 NULL)，增量更新时用来移动子树
+  DomTreeChild *child_link;
 };
 
 /**
@@ -77,10 +86,29 @@ struct DominatorTree
   DomTreeNode *root;
 
   DomTreeNode **nodes;
+  /// nodes / dom_preorder 数组的容量 (拆分基本块时增长)
+  int capacity;
 
+  /// Lengauer-Tarjan / CHK 的 DFS 顺序，只在建树之后有效 (增量更新不维护)
   DomTreeNode **dfs_order;
+
+  /// 可达的节点按支配树先序排列 (dom_preorder[i]->dom_pre == i + 1)；
+  /// 倒着遍历时每个节点都排在它的所有子孙之后
+  DomTreeNode **dom_preorder;
+  int num_reachable;
 };
 
+/**
+ * @brief 构建支配树的算法 (两者得到同一棵树)
+ */
+typedef enum DomTreeAlgorithm
+{
+  /// Lengauer-Tarjan (默认): 近似线性，适合巨大的 CFG
+  DOM_TREE_LENGAUER_TARJAN,
+  /// Cooper-Harvey-Kennedy: 在 RPO 编号的稠密数组上迭代求 idom，常数小
+  DOM_TREE_COOPER_HARVEY_KENNEDY,
+} DomTreeAlgorithm;
+
 /**
  * @brief [核心] 使用 Lengauer-Tarjan 算法构建支配树
  *
@@ -90,6 +118,21 @@ struct DominatorTree
  */
 DominatorTree *dom_tree_build(FunctionCFG *cfg, Bump *arena);
 
+/**
+ * @brief 用指定的算法构建支配树
+ *
+ * 所有遍历都使用显式栈，几十万个块的长链 CFG 也不会耗尽 C 栈。
+ * 子节点链表的顺序取决于算法 (LT 按 DFS 序，CHK 按 RPO)。
+ */
+DominatorTree *dom_tree_build_with_algorithm(FunctionCFG *cfg, Bump *arena, DomTreeAlgorithm algorithm);
+
+/**
+ * @brief 根据当前的 idom / children 重新计算 dom_pre、dom_post、depth 和 dom_preorder
+ *
+ * O(N)，不分配内存 (容量不变时)。增量更新 (analysis/dom_update.h) 在每批更新之后调用。
+ */
+void dom_tree_renumber(DominatorTree *tree);
+
 /**
  * @brief 销毁支配树 (通常为空，因为内存由竞技场管理)
  */
@@ -98,6 +141,8 @@ void dom_tree_destroy(DominatorTree *tree);
 /**
  * @brief [查询 API] 检查 A 是否支配 B
  *
+ * O(1): 比较两个节点在支配树上的 DFS 编号区间 (建树时计算)。
+ *
  * @param tree 支配树
  * @param a 潜在的支配者
  * @param b 潜在的被支配者
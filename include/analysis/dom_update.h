@@ -0,0 +1,90 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CALIR_ANALYSIS_DOM_UPDATE_H
+#define CALIR_ANALYSIS_DOM_UPDATE_H
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * =================================================================
+ * --- 支配树的增量更新 ---
+ * =================================================================
+ *
+ * 变换修改了控制流之后，不必重新 cfg_build + dom_tree_build：把修改告诉这里的 API，
+ * 它同时更新 tree->cfg、支配树和 (可选的) 支配边界，只重算受影响的部分。
+ *
+ * - 插入边 (x, y): 用按深度的搜索 (Georgiadis 等人的 depth-based search，也是 LLVM
+ *   DomTreeUpdater 的做法) 找出 idom 变成 NCA(x, y) 的节点；y 原来不可达时，
+ *   先在新变得可达的区域内求支配树，再把从该区域出去的边当作插入处理。
+ * - 删除边 (x, y): y 仍然可达时只重算以 NCA(x, y) 为根的子树；y 变得不可达时
+ *   删掉它的整棵子树，再重算被它影响到的最小子树。
+ * - 拆分基本块: 新块成为原块唯一的子节点并接管原块的所有子节点。
+ * 每批更新结束时重新编号一次 (O(N)，dom_tree_dominates 仍是 O(1))，
+ * 支配边界只重算 idom 或子树发生变化的块及其支配者。
+ *
+ * CFG 的边是集合: 插入已有的边、删除不存在的边都被忽略。
+ * 调用者负责修改 IR 本身 (终结指令)，再用同样的修改调用这里的 API。
+ */
+
+typedef enum DomUpdateKind
+{
+  /// 添加边 from -> to
+  DOM_UPDATE_INSERT_EDGE,
+  /// 删除边 from -> to
+  DOM_UPDATE_DELETE_EDGE,
+  /// 拆分 from: to 是新块，接管 from 的所有出边 (见 cfg_split_block)
+  DOM_UPDATE_SPLIT_BLOCK,
+} DomUpdateKind;
+
+typedef struct DomUpdate
+{
+  DomUpdateKind kind;
+  IRBasicBlock *from;
+  IRBasicBlock *to;
+} DomUpdate;
+
+/**
+ * @brief 按顺序应用一批更新，最后统一重新编号并更新支配边界
+ *
+ * 对 CFG 没有作用的更新被跳过；同一条边先插入后删除 (或先删除后插入) 的一对更新
+ * 相互抵消，不做任何工作。
+ *
+ * @param tree 要更新的支配树 (tree->cfg 也会被修改)
+ * @param df 依赖 tree 的支配边界；为 NULL 时不更新
+ * @param updates 更新列表
+ * @param num_updates 更新的个数
+ * @return 内存不足时返回 false (此时 tree 和 df 都不可再用，需要重新构建)
+ */
+bool dom_tree_apply_updates(DominatorTree *tree, DominanceFrontier *df, const DomUpdate *updates,
+                            size_t num_updates);
+
+/** @brief 单个更新: 添加边 from -> to */
+bool dom_tree_insert_edge(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *from, IRBasicBlock *to);
+
+/** @brief 单个更新: 删除边 from -> to */
+bool dom_tree_delete_edge(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *from, IRBasicBlock *to);
+
+/** @brief 单个更新: 拆分 block，new_block 接管它的所有出边 */
+bool dom_tree_split_block(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *block, IRBasicBlock *new_block);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "analysis/cfg.h"
+#include "ir/basicblock.h"
+#include "ir/instruction.h"
+#include "ir/value.h"
+#include "utils/bitset.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 每个基本块入口和出口的活跃值 (Liveness)
+ *
+ * 只有跨块的 SSA 值 (指令结果和函数参数) 有编号: 在定义块之外被使用，或者被 phi 使用的值。
+ * 只在定义块内使用的值不会出现在任何块的入口或出口，不占 Bitset 的位；
+ * 它们仍然可以用 liveness_is_live_after 查询。
+ *
+ * phi 的约定: phi 的结果在它所在的块中定义 (不算入口活跃)；
+ * phi 的入边值 [v, P] 算作在前驱 P 的出口处被使用 (v 在 P 的出口活跃)。
+ */
+typedef struct Liveness
+{
+  FunctionCFG *cfg;
+
+  /// 跨块值的稠密编号: values[i] 是编号为 i 的值
+  IRValueNode **values;
+  int num_values;
+  /// IRValueNode* -> 编号 + 1
+  PtrHashMap *value_index;
+
+  /// 每个块 (按 id) 入口 / 出口活跃的值的编号集合
+  Bitset **live_in;
+  Bitset **live_out;
+  /// 后向工作表算法处理块的次数 (用于测试和统计收敛速度)
+  size_t num_block_visits;
+} Liveness;
+
+/**
+ * @brief 计算函数中每个块的入口 / 出口活跃集合
+ *
+ * 先按块算出 use (向上暴露的使用) 和 def，再用 analysis/dataflow.h 的后向 gen/kill 求解器
+ * (工作表按 CFG 的后序) 求:
+ * LiveOut(B) = PhiUses(B) ∪ (∪ LiveIn(S))，LiveIn(B) = Use(B) ∪ (LiveOut(B) - Def(B))。
+ *
+ * @param cfg 函数的 CFG (必须是最新的)
+ * @param arena 用于分配 Liveness 和所有集合 (中间数据在内部的临时 Arena 中)
+ * @return Liveness*
+ */
+Liveness *liveness_compute(FunctionCFG *cfg, Bump *arena);
+
+/**
+ * @brief [查询 API] 值的稠密编号
+ * @return 编号；value 不跨块 (或不是指令结果 / 参数) 时返回 -1
+ */
+int liveness_value_index(const Liveness *lv, IRValueNode *value);
+
+/**
+ * @brief [查询 API] bb 入口活跃的值的编号集合 (bb 不在 CFG 中时返回 NULL)
+ */
+const Bitset *liveness_live_in(const Liveness *lv, IRBasicBlock *bb);
+
+/**
+ * @brief [查询 API] bb 出口活跃的值的编号集合 (bb 不在 CFG 中时返回 NULL)
+ */
+const Bitset *liveness_live_out(const Liveness *lv, IRBasicBlock *bb);
+
+/** @brief [查询 API] value 是否在 bb 的入口活跃 */
+bool liveness_is_live_in(const Liveness *lv, IRBasicBlock *bb, IRValueNode *value);
+
+/** @brief [查询 API] value 是否在 bb 的出口活跃 */
+bool liveness_is_live_out(const Liveness *lv, IRBasicBlock *bb, IRValueNode *value);
+
+/**
+ * @brief [查询 API] value 在 inst 之后 (inst 与下一条指令之间) 是否活跃
+ *
+ * 从块的出口往回扫到 inst，O(块内 inst 之后的指令数)。对只在块内使用的值同样成立。
+ */
+bool liveness_is_live_after(const Liveness *lv, IRValueNode *value, IRInstruction *inst);
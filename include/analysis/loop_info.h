@@ -0,0 +1,119 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CALIR_ANALYSIS_LOOP_INFO_H
+#define CALIR_ANALYSIS_LOOP_INFO_H
+
+#include "analysis/cfg.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "utils/bump.h"
+#include <stdbool.h>
+
+typedef struct IRLoop IRLoop;
+
+/**
+ * @brief 一个自然循环 (natural loop)
+ *
+ * 回边 (back edge) 是 latch -> header 且 header 支配 latch 的边；同一个 header 的所有回边
+ * 合成一个循环，它的块是不经过 header 就能到达某个 latch 的块，再加上 header 本身。
+ * 块、latch、出口都用 CFG 中的块 id 表示。
+ */
+struct IRLoop
+{
+  IRBasicBlock *header;
+  /// 外层循环 (最外层的循环为 NULL)
+  IRLoop *parent;
+  /// 嵌套深度 (最外层为 1)
+  int depth;
+
+  /// 循环中的所有块 (包括内层循环的块)，按支配树先序排列，所以 header 总是第一个
+  int *blocks;
+  int num_blocks;
+  /// 回边的源块 (循环中跳回 header 的块)
+  int *latches;
+  int num_latches;
+  /// 出口块: 不在循环中、但有前驱在循环中的块 (不重复)
+  int *exits;
+  int num_exits;
+  /// 前置块 (preheader): header 在循环外的唯一前驱，而且它只跳到 header；没有时为 NULL
+  IRBasicBlock *preheader;
+
+  /// 直接的内层循环
+  IRLoop **subloops;
+  int num_subloops;
+
+  /// 循环嵌套森林上的先序/后序编号: a 包含 b 当且仅当 a->pre <= b->pre 且 b->post <= a->post
+  int pre;
+  int post;
+};
+
+/**
+ * @brief 一个函数的循环嵌套森林 (Loop Nesting Forest)
+ */
+typedef struct LoopInfo
+{
+  FunctionCFG *cfg;
+  DominatorTree *dom_tree;
+
+  /// 所有循环，按嵌套森林的先序排列 (外层在内层之前)
+  IRLoop **loops;
+  int num_loops;
+  /// 最外层的循环
+  IRLoop **top_level;
+  int num_top_level;
+
+  /// 每个块 (按 id) 所在的最内层循环，不在任何循环中时为 NULL
+  IRLoop **block_loop;
+  /// block_loop 的大小 (计算时 CFG 的块数)
+  int num_blocks;
+} LoopInfo;
+
+/**
+ * @brief 从支配树 (和它的 CFG) 找出所有自然循环
+ *
+ * O(块数 + 边数 + 所有循环的块数之和)。只识别自然循环: 入口不唯一的不可归约环
+ * (跳回去的边的目标不支配源) 不算循环。不可达的块不在任何循环中。
+ *
+ * @param dt 支配树 (必须是最新的；dom_update 修改 CFG 之后要重新计算)
+ * @param arena 用于分配 LoopInfo 和所有循环
+ * @return LoopInfo*
+ */
+LoopInfo *loop_info_compute(DominatorTree *dt, Bump *arena);
+
+/**
+ * @brief [查询 API] bb 所在的最内层循环 (O(1))
+ * @return IRLoop*；bb 不在任何循环中 (或不在 CFG 中) 时返回 NULL
+ */
+IRLoop *loop_info_get_loop(LoopInfo *li, IRBasicBlock *bb);
+
+/**
+ * @brief [查询 API] bb 的循环嵌套深度 (不在循环中为 0)
+ */
+int loop_info_get_depth(LoopInfo *li, IRBasicBlock *bb);
+
+/**
+ * @brief [查询 API] bb 是否是某个循环的 header
+ */
+bool loop_info_is_header(LoopInfo *li, IRBasicBlock *bb);
+
+/**
+ * @brief [查询 API] loop 是否包含 bb (包括在内层循环中的情况，O(1))
+ */
+bool loop_info_contains(LoopInfo *li, const IRLoop *loop, IRBasicBlock *bb);
+
+#endif
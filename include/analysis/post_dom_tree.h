@@ -0,0 +1,89 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CALIR_ANALYSIS_POST_DOM_TREE_H
+#define CALIR_ANALYSIS_POST_DOM_TREE_H
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "utils/bump.h"
+#include <stdbool.h>
+
+/**
+ * @brief 后支配树 (Post-Dominator Tree)
+ *
+ * a 后支配 b: 从 b 到函数出口的每条路径都经过 a。
+ * 后支配树就是反向 CFG (cfg_build_reverse) 上的支配树，所以直接复用 DominatorTree：
+ * tree 的根是虚拟出口 (多个 ret 汇合到它)，tree 上的 idom 就是直接后支配者，
+ * 在 tree 上算出的支配边界就是后支配边界 (控制依赖)。
+ * 到不了任何出口的块 (无限循环) 通过反向 CFG 中补上的虚拟边挂在虚拟出口下面。
+ */
+typedef struct PostDominatorTree
+{
+  /// 正向 CFG (不属于后支配树)
+  FunctionCFG *cfg;
+  /// 反向 CFG，节点 id 与 cfg 相同，另加虚拟出口
+  FunctionCFG *reverse_cfg;
+  /// reverse_cfg 上的支配树
+  DominatorTree *tree;
+  /// 虚拟出口 (tree 的根，id 为 cfg->num_nodes，block 为 NULL)
+  CFGNode *virtual_exit;
+} PostDominatorTree;
+
+/**
+ * @brief 构建后支配树
+ *
+ * @param cfg 正向 CFG
+ * @param arena 用于分配后支配树和它的支配树节点
+ * @return PostDominatorTree*；cfg 没有节点时返回 NULL
+ */
+PostDominatorTree *post_dom_tree_build(FunctionCFG *cfg, Bump *arena);
+
+/**
+ * @brief 用指定的算法构建后支配树 (见 DomTreeAlgorithm)
+ */
+PostDominatorTree *post_dom_tree_build_with_algorithm(FunctionCFG *cfg, Bump *arena, DomTreeAlgorithm algorithm);
+
+/**
+ * @brief 销毁后支配树 (释放反向 CFG 内部的 Arena)
+ */
+void post_dom_tree_destroy(PostDominatorTree *pdt);
+
+/**
+ * @brief [查询 API] 检查 a 是否后支配 b (O(1))
+ */
+bool post_dom_tree_postdominates(PostDominatorTree *pdt, IRBasicBlock *a, IRBasicBlock *b);
+
+/**
+ * @brief [查询 API] 获取 b 的直接后支配者
+ * @return IRBasicBlock*；b 的直接后支配者是虚拟出口 (例如 b 以 ret 结束) 时返回 NULL
+ */
+IRBasicBlock *post_dom_tree_get_ipdom(PostDominatorTree *pdt, IRBasicBlock *b);
+
+/**
+ * @brief 计算后支配边界
+ *
+ * PDF(b) 是这样的块 y 的集合: b 后支配 y 的某个后继，但不严格后支配 y。
+ * 也就是 b 控制依赖于 y 末尾的分支。集合中的 id 与正向 CFG 相同 (不会包含虚拟出口)。
+ *
+ * @return DominanceFrontier*，用 ir_analysis_dom_frontier_get / contains 查询
+ */
+DominanceFrontier *post_dom_frontier_compute(PostDominatorTree *pdt, Bump *arena);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 判断一个函数是否为纯函数: 返回值只取决于参数，执行没有可观察的副作用
+ *
+ * 满足以下所有条件时返回 true:
+ * - 是定义 (不是外部声明)
+ * - load / store 只访问本函数 alloca 出来的内存 (地址是 alloca 的结果，
+ * 或以它为基址的 gep)，因此既不读取也不修改全局变量或指针参数指向的内存
+ * - 每个 'call' 都直接调用一个同样是纯函数的 IR 函数 (递归调用视为纯)
+ *
+ * 纯函数仍然可能因运行时错误 (e.g., 除零) 而失败。
+ *
+ * @param func 要分析的函数 (会沿调用图分析所有可达的被调者)
+ * @return 是纯函数时返回 true；OOM 时保守地返回 false
+ */
+bool purity_is_pure_function(IRFunction *func);
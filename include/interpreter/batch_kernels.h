@@ -0,0 +1,164 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "interpreter/interpreter.h"
+#include "ir/instruction.h"
+#include "utils/cpu_features.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * =================================================================
+ * --- 批量执行的列内核 (Batch Column Kernels) ---
+ * =================================================================
+ *
+ * 批量模式下，一个槽位不再是一个 RuntimeValue，而是一列 lane
+ * (每个 lane 对应一组输入)。每个 lane 是一个 64 位的 "规范" 值:
+ *
+ * - 整数: 符号扩展到 64 位 (i1 为 0 / 1)
+ * - f32 / f64: 都以 double 存放 (f32 的值总是可以精确地用 double 表示)
+ * - ptr: 地址
+ *
+ * 所有内核都是 "带掩码的写": mask[i] (0 / 1) 为 0 的 lane 保持 dst[i] 不变，
+ * 因此同一列可以被走不同控制流路径的 lane 共享。
+ * 每个内核处理一整组 INTERP_BATCH_WIDTH 个 lane: 运算种类在循环外选择，
+ * 循环体没有分支且长度固定，由编译器向量化。同一份实现按基线、AVX2 和 AVX-512 各编译一次，
+ * 第一次使用时按 cpu_features() 选定 (见 batch_kernels())。
+ */
+
+/**
+ * @brief 一个 lane 的 64 位值 (浮点存放 double 的位模式)
+ *
+ * 用普通整数而不是 union: GCC 不会向量化逐元素访问 union 成员的循环。
+ */
+typedef uint64_t BatchLane;
+
+/** @brief 把 lane 的位模式解释为 double */
+static inline double
+batch_lane_as_f64(BatchLane lane)
+{
+  double value;
+  memcpy(&value, &lane, sizeof(value));
+  return value;
+}
+
+/** @brief 把 double 的位模式存为 lane */
+static inline BatchLane
+batch_lane_from_f64(double value)
+{
+  BatchLane lane;
+  memcpy(&lane, &value, sizeof(lane));
+  return lane;
+}
+
+/**
+ * @brief dst = lhs op rhs (add / sub / mul / and / or / xor / shl / lshr / ashr)
+ *
+ * @param bits 整数位宽 (8 / 16 / 32 / 64)，结果会重新符号扩展到 64 位
+ */
+void batch_kernel_int_binary(IROpcode opcode, unsigned bits, BatchLane *dst, const BatchLane *lhs,
+                             const BatchLane *rhs, const uint8_t *mask);
+
+/**
+ * @brief dst = lhs op rhs (fadd / fsub / fmul / fdiv)
+ *
+ * @param is_f32 结果是否需要舍入到 f32 精度
+ * @return 某个活跃 lane 上发生浮点除以零时返回 false (此时 dst 未被修改)
+ */
+bool batch_kernel_float_binary(IROpcode opcode, bool is_f32, BatchLane *dst, const BatchLane *lhs,
+                               const BatchLane *rhs, const uint8_t *mask);
+
+/**
+ * @brief dst = icmp pred lhs, rhs (结果为 0 / 1)
+ *
+ * @param bits 操作数位宽 (1 / 8 / 16 / 32 / 64，指针为 64)
+ */
+void batch_kernel_icmp(IRICmpPredicate pred, unsigned bits, BatchLane *dst, const BatchLane *lhs,
+                       const BatchLane *rhs, const uint8_t *mask);
+
+/**
+ * @brief dst = fcmp pred lhs, rhs (结果为 0 / 1)
+ */
+void batch_kernel_fcmp(IRFCmpPredicate pred, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                       const uint8_t *mask);
+
+/**
+ * @brief dst = cond ? on_true : on_false
+ */
+void batch_kernel_select(BatchLane *dst, const BatchLane *cond, const BatchLane *on_true, const BatchLane *on_false,
+                         const uint8_t *mask);
+
+/**
+ * @brief 整数之间的转换 (trunc / zext / sext)
+ *
+ * @param src_bits 源位宽 (1 / 8 / 16 / 32 / 64)
+ * @param dst_bits 目标位宽 (8 / 16 / 32 / 64)
+ */
+void batch_kernel_int_cast(IROpcode opcode, unsigned src_bits, unsigned dst_bits, BatchLane *dst,
+                           const BatchLane *src, const uint8_t *mask);
+
+/**
+ * @brief 结果为浮点的转换 (sitofp / uitofp / fpext / fptrunc)
+ *
+ * @param src_bits 整数源的位宽 (sitofp / uitofp 使用)
+ * @param dst_is_f32 结果是否需要舍入到 f32 精度
+ */
+void batch_kernel_float_cast(IROpcode opcode, unsigned src_bits, bool dst_is_f32, BatchLane *dst,
+                             const BatchLane *src, const uint8_t *mask);
+
+/**
+ * @brief dst = src
+ */
+void batch_kernel_copy(BatchLane *dst, const BatchLane *src, const uint8_t *mask);
+
+/*
+ * --- 按 CPU 选择实现 ---
+ */
+
+/** @brief 同一指令集的一组内核 (签名与上面的同名函数相同) */
+typedef struct BatchKernelTable
+{
+  /** 实现的名字: "generic" (基线) / "avx2" / "avx512" */
+  const char *name;
+  void (*int_binary)(IROpcode opcode, unsigned bits, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                     const uint8_t *mask);
+  bool (*float_binary)(IROpcode opcode, bool is_f32, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                       const uint8_t *mask);
+  void (*icmp)(IRICmpPredicate pred, unsigned bits, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+               const uint8_t *mask);
+  void (*fcmp)(IRFCmpPredicate pred, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs, const uint8_t *mask);
+  void (*select)(BatchLane *dst, const BatchLane *cond, const BatchLane *on_true, const BatchLane *on_false,
+                 const uint8_t *mask);
+  void (*int_cast)(IROpcode opcode, unsigned src_bits, unsigned dst_bits, BatchLane *dst, const BatchLane *src,
+                   const uint8_t *mask);
+  void (*float_cast)(IROpcode opcode, unsigned src_bits, bool dst_is_f32, BatchLane *dst, const BatchLane *src,
+                     const uint8_t *mask);
+  void (*copy)(BatchLane *dst, const BatchLane *src, const uint8_t *mask);
+} BatchKernelTable;
+
+/**
+ * @brief features 允许的最快实现 (没有更宽的实现时返回基线实现)
+ */
+const BatchKernelTable *batch_kernels_for(CpuFeatures features);
+
+/**
+ * @brief 当前进程使用的实现: 第一次调用时按 cpu_features() 选定，之后不变
+ */
+const BatchKernelTable *batch_kernels(void);
@@ -0,0 +1,365 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * =================================================================
+ * --- 预降级执行计划 (Pre-lowered Execution Plan) ---
+ * =================================================================
+ *
+ * 解释器不再直接遍历 IRFunction 的链表, 而是先把函数 "降级" 为一个
+ * 紧凑的执行计划:
+ *
+ * 1. 每个参数 / 有结果的指令 都被分配一个稠密的 "槽位" (slot) 编号。
+ * 2. 函数引用的常量 / 全局变量 / 函数地址 也各自占据一个槽位,
+ * 它们的值在第一次构建计划时求值到一个不可变的常量池中,
+ * 进入函数时只需一次 memcpy。
+ * 3. 所有指令被平铺到一个连续数组中, 操作数已解析为槽位编号,
+ * 跳转目标已解析为 CFG 边编号。
+ * 4. 每条边携带一个预先排好序的 "并行复制" 列表 (源槽位 -> PHI 槽位),
+ * 跳转时直接执行它, PHI 指令本身在运行时永远不会被执行。
+ *
+ * 执行时, 帧 (frame) 就是一个 RuntimeValue 数组, 每次操作数访问
+ * 都是一次数组索引, 而不是一次哈希查找。
+ */
+
+/** @brief 帧中一个槽位的编号 */
+typedef uint32_t ExecSlot;
+
+/** @brief 无效的槽位 / 基本块编号 */
+#define EXEC_INVALID_INDEX UINT32_MAX
+
+/**
+ * @brief 按静态类型特化的指令: X(名字, IR opcode, 类型)
+ *
+ * 对 icmp 来说类型是操作数的类型，其他指令是结果的类型。
+ */
+#define EXEC_TYPED_OPS(X)                                                                                              \
+  X(ADD_I32, IR_OP_ADD, IR_TYPE_I32)                                                                                   \
+  X(ADD_I64, IR_OP_ADD, IR_TYPE_I64)                                                                                   \
+  X(SUB_I32, IR_OP_SUB, IR_TYPE_I32)                                                                                   \
+  X(SUB_I64, IR_OP_SUB, IR_TYPE_I64)                                                                                   \
+  X(MUL_I32, IR_OP_MUL, IR_TYPE_I32)                                                                                   \
+  X(MUL_I64, IR_OP_MUL, IR_TYPE_I64)                                                                                   \
+  X(SHL_I32, IR_OP_SHL, IR_TYPE_I32)                                                                                   \
+  X(SHL_I64, IR_OP_SHL, IR_TYPE_I64)                                                                                   \
+  X(LSHR_I32, IR_OP_LSHR, IR_TYPE_I32)                                                                                 \
+  X(LSHR_I64, IR_OP_LSHR, IR_TYPE_I64)                                                                                 \
+  X(ASHR_I32, IR_OP_ASHR, IR_TYPE_I32)                                                                                 \
+  X(ASHR_I64, IR_OP_ASHR, IR_TYPE_I64)                                                                                 \
+  X(AND_I32, IR_OP_AND, IR_TYPE_I32)                                                                                   \
+  X(AND_I64, IR_OP_AND, IR_TYPE_I64)                                                                                   \
+  X(OR_I32, IR_OP_OR, IR_TYPE_I32)                                                                                     \
+  X(OR_I64, IR_OP_OR, IR_TYPE_I64)                                                                                     \
+  X(XOR_I32, IR_OP_XOR, IR_TYPE_I32)                                                                                   \
+  X(XOR_I64, IR_OP_XOR, IR_TYPE_I64)                                                                                   \
+  X(ICMP_I32, IR_OP_ICMP, IR_TYPE_I32)                                                                                 \
+  X(ICMP_I64, IR_OP_ICMP, IR_TYPE_I64)                                                                                 \
+  X(FADD_F64, IR_OP_FADD, IR_TYPE_F64)                                                                                 \
+  X(FSUB_F64, IR_OP_FSUB, IR_TYPE_F64)                                                                                 \
+  X(FMUL_F64, IR_OP_FMUL, IR_TYPE_F64)                                                                                 \
+  X(FDIV_F64, IR_OP_FDIV, IR_TYPE_F64)
+
+#define EXEC_TYPED_OP_ENUM(name, ir_op, type) EXEC_OP_##name,
+
+/**
+ * @brief 执行计划的操作码
+ *
+ * [0, IR_OP_CALL] 与 IROpcode 的值完全相同 (一条普通指令)；
+ * 之后是降级时融合出的 "超级指令"。超级指令位于组内第一条指令的位置，
+ * 组内其余指令仍然保留在数组中 (用于读取它们的操作数)，但不会被分派。
+ * 只有当中间值只有唯一一个使用者时才会融合，因此可以省略中间槽位的写入。
+ *
+ * 最后是按静态类型特化的单条指令 (EXEC_TYPED_OPS): SSA 值的类型在降级时已知，
+ * 所以没有被融合的常见运算直接读写对应类型的字段，执行时不再按 RuntimeValueKind 分派。
+ */
+typedef enum ExecOpcode
+{
+  EXEC_OP_FIRST_FUSED = IR_OP_CALL + 1,
+  /** icmp + cond_br (比较结果只被分支使用) */
+  EXEC_OP_ICMP_BR = EXEC_OP_FIRST_FUSED,
+  /** gep + load (地址只被 load 使用) */
+  EXEC_OP_GEP_LOAD,
+  /** load + 二元运算 + store (载入值和运算结果都只有一个使用者) */
+  EXEC_OP_LOAD_BINOP_STORE,
+  EXEC_OP_LAST_FUSED = EXEC_OP_LOAD_BINOP_STORE,
+  EXEC_TYPED_OPS(EXEC_TYPED_OP_ENUM) EXEC_OP_COUNT
+} ExecOpcode;
+
+#undef EXEC_TYPED_OP_ENUM
+
+/** @brief 超级指令的种类数 */
+#define EXEC_NUM_FUSED_OPS (EXEC_OP_LAST_FUSED + 1 - EXEC_OP_FIRST_FUSED)
+
+/** @brief 第一个按类型特化的指令 */
+#define EXEC_OP_FIRST_TYPED (EXEC_OP_LAST_FUSED + 1)
+
+/**
+ * @brief 'call' 是尾调用: 紧跟着 'ret' 它的结果 (或 'ret void')，
+ * 且所在函数没有 'alloca' (被调者不可能引用当前帧的栈内存)。
+ * 解释器会复用当前帧，而不是压入新帧。
+ */
+#define EXEC_INST_TAIL_CALL (1u << 0)
+
+/**
+ * @brief 一条已降级的指令
+ *
+ * 操作数的含义由 opcode 决定 (与 IRInstruction 的操作数顺序一一对应):
+ * - 值操作数: 槽位编号
+ * - 终结指令 (br / cond_br / switch) 的标签操作数: 边编号 (ExecEdge)
+ * - PHI 的标签操作数: 基本块编号
+ */
+typedef struct ExecInst
+{
+  /** IROpcode (普通指令) 或 ExecOpcode (超级指令) */
+  uint32_t opcode;
+  /** 结果槽位 (void 指令为 EXEC_INVALID_INDEX) */
+  ExecSlot result;
+  /** EXEC_INST_* 标志位 */
+  uint32_t flags;
+  /**
+   * 辅助数据编号 (switch: plan->switches 的下标；直接调用外部声明的 call: plan->host_calls 的下标，
+   * 其他 call 为 EXEC_INVALID_INDEX；alloca: 在帧内 alloca 区的偏移；
+   * gep: plan->geps 的下标，未能解析时为 EXEC_INVALID_INDEX；其他指令未使用)
+   */
+  uint32_t aux;
+  uint32_t num_operands;
+  uint32_t *operands;
+  /** 源指令 (用于读取类型、谓词、GEP 源类型等静态信息) */
+  IRInstruction *ir;
+} ExecInst;
+
+/**
+ * @brief 一个已降级的基本块
+ *
+ * 块内的 PHI 指令总是位于 [first_inst, first_inst + num_phis) 之间,
+ * 其余指令紧随其后, 最后一条是终结指令。
+ */
+typedef struct ExecBlock
+{
+  IRBasicBlock *ir;
+  uint32_t first_inst;
+  uint32_t num_insts;
+  uint32_t num_phis;
+} ExecBlock;
+
+/**
+ * @brief 一次槽位复制 (dst = src)
+ */
+typedef struct ExecCopy
+{
+  ExecSlot src;
+  ExecSlot dst;
+} ExecCopy;
+
+/**
+ * @brief 一条 CFG 边 (终结指令的一个跳转目标)
+ *
+ * copies[first_copy, first_copy + num_copies) 是目标块 PHI 的并行复制,
+ * 已经被顺序化 (必要时经由 copy_temp_slot 打破环), 按顺序执行即可。
+ */
+typedef struct ExecEdge
+{
+  uint32_t target;
+  uint32_t first_copy;
+  uint32_t num_copies;
+} ExecEdge;
+
+/**
+ * @brief switch 的查找策略
+ */
+typedef enum ExecSwitchKind
+{
+  /** case 很少: 线性比较 */
+  EXEC_SWITCH_LINEAR,
+  /** case 值稠密: 以 (值 - min_value) 为下标的跳转表 */
+  EXEC_SWITCH_TABLE,
+  /** case 值稀疏但很多: 有序数组 + 二分查找 */
+  EXEC_SWITCH_SORTED,
+} ExecSwitchKind;
+
+/** @brief case 数少于这个值时使用线性比较 */
+#define EXEC_SWITCH_LINEAR_MAX 8
+/** @brief 跳转表的最大长度 (超过则退化为二分查找) */
+#define EXEC_SWITCH_TABLE_MAX 4096
+
+/**
+ * @brief 一条 'switch' 的预计算查找结构
+ *
+ * case 值来自常量池，因此由解释器在求值常量池之后填充
+ * (exec_plan_build 只分配并编号，未填充前为 EXEC_SWITCH_LINEAR)。
+ */
+typedef struct ExecSwitch
+{
+  ExecSwitchKind kind;
+  uint32_t default_edge;
+
+  /** TABLE: table[v - min_value] 为目标边 (空洞为 default_edge) */
+  int64_t min_value;
+  uint32_t table_size;
+  uint32_t *table;
+
+  /** SORTED: 升序的 case 值及其目标边 */
+  uint32_t num_keys;
+  int64_t *keys;
+  uint32_t *key_edges;
+} ExecSwitch;
+
+/** @brief gep 的一个变量下标: 地址 += 下标 * scale */
+typedef struct ExecGepTerm
+{
+  /** ExecInst 的操作数下标 (不是槽位) */
+  uint32_t operand;
+  uint64_t scale;
+} ExecGepTerm;
+
+/**
+ * @brief 一条 'gep' 预先解析的地址: 基址 + offset + Σ 下标 * scale
+ *
+ * 常量下标 (包括所有结构体成员下标) 在构建计划时按 DataLayout 折叠进 offset，
+ * 执行时不再遍历类型或查询布局；全部是常量下标时 num_terms 为 0。
+ */
+typedef struct ExecGep
+{
+  int64_t offset;
+  uint32_t num_terms;
+  ExecGepTerm *terms;
+} ExecGep;
+
+/**
+ * @brief 一个 "外部" 槽位 (值来自常量池，进入函数时整体复制)
+ * (常量、全局变量地址、函数地址)
+ */
+typedef struct ExecExternSlot
+{
+  ExecSlot slot;
+  IRValueNode *value;
+} ExecExternSlot;
+
+/**
+ * @brief 一个计划的 profile 计数器 (只在开启 profiling 时分配)
+ */
+typedef struct ExecProfile
+{
+  /** 进入此函数的次数 (包括尾调用) */
+  uint64_t calls;
+  /** 在此函数自身中花费的周期数 (不含被调用的 IR 函数) */
+  uint64_t self_cycles;
+  /** 每个基本块的进入次数 (下标为块编号) */
+  uint64_t *block_entries;
+} ExecProfile;
+
+/**
+ * @brief 一个函数的完整执行计划
+ */
+struct ExecPlan
+{
+  IRFunction *func;
+
+  /** 帧中的槽位总数 (参数 + 指令结果 + 外部槽位) */
+  uint32_t num_slots;
+  uint32_t num_args;
+
+  ExecBlock *blocks;
+  uint32_t num_blocks;
+
+  ExecInst *insts;
+  uint32_t num_insts;
+
+  /** 外部槽位总是连续地位于 [first_extern_slot, num_slots) */
+  ExecExternSlot *externs;
+  uint32_t num_externs;
+  ExecSlot first_extern_slot;
+
+  /**
+   * @brief 不可变常量池 (大小为 num_externs，与 externs 一一对应)
+   *
+   * 由解释器在构建计划后填充 (见 interpreter.c)；
+   * exec_plan_build 只为它预留空间。
+   */
+  RuntimeValue *const_pool;
+
+  ExecEdge *edges;
+  uint32_t num_edges;
+
+  ExecCopy *copies;
+  uint32_t num_copies;
+
+  ExecSwitch *switches;
+  uint32_t num_switches;
+
+  /** 每个直接调用外部声明的 'call' 的链接结果 (由解释器填充，见 interpreter.c) */
+  struct HostBinding **host_calls;
+  uint32_t num_host_calls;
+
+  /** 每条 'gep' 预先解析的地址 (由解释器按 DataLayout 填充，见 interpreter.c) */
+  ExecGep *geps;
+  uint32_t num_geps;
+
+  /**
+   * 帧内 alloca 区的大小与对齐 (由解释器按 DataLayout 填充，见 interpreter.c)。
+   * 每条 alloca 在其中占据固定的一段，因此帧的大小与执行的指令数无关。
+   */
+  size_t alloca_size;
+  size_t alloca_align;
+
+  /** 顺序化并行复制时用于打破环的临时槽位 (没有 PHI 时为 EXEC_INVALID_INDEX) */
+  ExecSlot copy_temp_slot;
+
+  /** 每种超级指令在此计划中被融合的次数 (下标为 opcode - EXEC_OP_FIRST_FUSED) */
+  uint32_t fusion_counts[EXEC_NUM_FUSED_OPS];
+
+  /** profile 计数器 (未开启 profiling 时为 NULL；由解释器分配) */
+  ExecProfile *profile;
+
+  /**
+   * 函数只包含无副作用的标量运算、PHI 与控制流 (没有内存访问和调用)，
+   * 可以用批量模式在多组输入上同时执行 (见 interpreter_run_function_batch)
+   */
+  bool batchable;
+
+  /** 函数是纯函数且签名可以备忘 (由解释器在开启备忘时填充) */
+  bool memoizable;
+
+  /** 基线 JIT: 被调用的次数 (达到阈值时编译；由解释器维护，封存后不再计数) */
+  uint32_t jit_calls;
+  /** 基线 JIT: 计划的机器码 (尚未编译时为 NULL；由解释器持有，见 interpreter/jit.h) */
+  struct JitCode *jit_code;
+  /** 基线 JIT: 编译失败过 (不再重试) */
+  bool jit_failed;
+};
+
+/**
+ * @brief 将一个函数降级为执行计划
+ *
+ * @param func 要降级的函数 (不能是声明)
+ * @param arena 用于分配计划内所有数据的竞技场
+ * @param enable_fusion 是否把常见的指令序列融合为超级指令
+ * @return ExecPlan* 成功则返回计划；OOM、函数为空、某个基本块不以终结指令结束、
+ * 或某个 PHI 缺少某条入边的值时返回 NULL
+ */
+ExecPlan *exec_plan_build(IRFunction *func, Bump *arena, bool enable_fusion);
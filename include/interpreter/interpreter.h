@@ -16,14 +16,19 @@
 
 #pragma once
 
+#include "ir/basicblock.h"
+#include "ir/constant.h"
 #include "ir/function.h"
+#include "ir/instruction.h"
 #include "ir/module.h"
+#include "ir/printer.h"
 #include "utils/bump.h"
 #include "utils/data_layout.h"
 #include "utils/hashmap.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 /**
  * @brief 运行时值的类型标签
@@ -61,7 +66,7 @@ typedef struct RuntimeValue
     /**
      * @brief 模拟的指针。
      *
-     * 对于 'alloca'，这将指向由 'ExecutionContext' 的 'stack_arena' 分配的内存。
+     * 对于 'alloca'，这将指向当前解释器栈 (InterpreterStack) 中的内存。
      * 对于 'global'，这将指向由 'Interpreter' 的 'global_memory' (未来) 分配的内存。
      * 对于 'load'/'store'，这必须是一个有效的 void*。
      */
@@ -80,14 +85,119 @@ typedef enum ExecutionResultKind
   EXEC_ERR_INVALID_PTR,
 } ExecutionResultKind;
 
+/**
+ * @brief 是否编译了直接线程化 (computed goto) 引擎。
+ *
+ * 需要 GCC/Clang 的 '&&label' 扩展；可以用 -DCALICO_NO_THREADED_ENGINE 强制关闭。
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(CALICO_NO_THREADED_ENGINE)
+#define CALICO_HAS_THREADED_ENGINE 1
+#else
+#define CALICO_HAS_THREADED_ENGINE 0
+#endif
+
+/**
+ * @brief 是否编译了基线 JIT (x86-64 System V，需要 mmap / mprotect)。
+ *
+ * 可以用 -DCALICO_NO_JIT 强制关闭。
+ */
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(CALICO_NO_JIT)
+#define CALICO_HAS_JIT 1
+#else
+#define CALICO_HAS_JIT 0
+#endif
+
+/** @brief 函数被调用多少次后由 JIT 编译 (默认值，见 interpreter_set_jit_threshold) */
+#define INTERP_JIT_DEFAULT_THRESHOLD 16
+
+/** @brief 参数个数不超过这个值的纯函数才会被备忘 (见 interpreter_set_memoization) */
+#define INTERP_MEMO_MAX_ARGS 4
+
+/** @brief 备忘表默认能容纳的结果个数 */
+#define INTERP_MEMO_DEFAULT_CAPACITY 1024
+
+/**
+ * @brief 备忘表的统计数据 (见 interpreter_get_memo_stats)
+ */
+typedef struct InterpreterMemoStats
+{
+  /** 直接返回缓存结果的调用次数 */
+  uint64_t hits;
+  /** 需要实际执行 (之后缓存结果) 的调用次数 */
+  uint64_t misses;
+  /** 因表满而被替换掉的结果个数 */
+  uint64_t evictions;
+  /** 当前缓存的结果个数 */
+  size_t entries;
+  /** 最多能缓存的结果个数 */
+  size_t capacity;
+} InterpreterMemoStats;
+
+/**
+ * @brief 指令分派引擎
+ */
+typedef enum InterpreterEngine
+{
+  /** @brief 可移植的 'switch (opcode)' 分派循环 */
+  INTERP_ENGINE_SWITCH,
+  /** @brief 直接线程化分派 (每条指令末尾直接 'goto *table[next->opcode]') */
+  INTERP_ENGINE_THREADED,
+} InterpreterEngine;
+
+/**
+ * @brief 降级时融合出的超级指令种类 (用于统计)
+ */
+typedef enum InterpreterFusionKind
+{
+  /** @brief icmp + cond_br */
+  INTERP_FUSION_ICMP_BR,
+  /** @brief gep + load */
+  INTERP_FUSION_GEP_LOAD,
+  /** @brief load + 二元运算 + store */
+  INTERP_FUSION_LOAD_BINOP_STORE,
+  INTERP_FUSION_KIND_COUNT,
+} InterpreterFusionKind;
+
+/**
+ * @brief 解释器栈 (一段连续内存)。
+ *
+ * 帧头、寄存器堆和 'alloca' 的内存都按栈顺序从这里分配；
+ * 函数返回时直接把 top 回退到该帧入口处的水位线。
+ * IR 之间的 'call' 不再递归宿主 C 栈。
+ */
+typedef struct InterpreterStack
+{
+  char *base;
+  size_t size;
+  size_t top;
+} InterpreterStack;
+
+/**
+ * @brief 一个模块的全局变量镜像: 按 DataLayout 排好的一整块连续内存
+ *
+ * 模块第一次被用到时，它所有尚未放置的全局变量一次性布局到同一块内存中
+ * (初始值成批写入)，并保留一份初始内容用于 interpreter_reset_globals。
+ * 之后加入模块的全局变量会在下一次用到时组成该模块的另一个镜像。
+ */
+typedef struct GlobalImage
+{
+  IRModule *module;
+  uint8_t *memory;
+  /** 装载时的初始内容 (与 memory 大小相同) */
+  uint8_t *initial;
+  size_t size;
+  /** 解释器的所有镜像组成的链表 (按装载顺序) */
+  struct GlobalImage *next;
+} GlobalImage;
+
 /**
  * @brief 解释器主上下文 (Interpreter Main Context)
  *
  * 这是一个长时对象 (long-lived object)，它持有一个主内存竞技场
  * 用于在多次函数调用期间分配 *持久* 的运行时值。
  *
- * (这与 ExecutionContext 不同，后者是*每次*函数调用时
- * 在 .c 文件内部创建的临时对象)
+ * (这与 ExecutionContext 不同，后者是*每次* interpreter_run_function
+ * 调用时在 .c 文件内部创建的临时对象)
  */
 typedef struct Interpreter
 {
@@ -106,33 +216,112 @@ typedef struct Interpreter
    *
    * 这是一个持久映射:
    * Key: IRValueNode* (e.g., &global->value)
-   * Value: RuntimeValue* (一个 RUNTIME_VAL_PTR 类型的持久值)
+   * Value: void* (全局变量的宿主地址，位于所属模块的全局镜像中)
    */
   PtrHashMap *global_storage;
 
+  /** @brief 所有模块的全局镜像 (链表，按装载顺序；内存属于 arena) */
+  GlobalImage *global_images;
+
   /**
    * @brief FFI 链接表
-   * Map<const char* (函数名), CalicoHostFunction (函数指针)>
+   * Map<const char* (函数名), HostBinding* (链接结果，注册同名函数时原地更新)>
    */
   StrHashMap *external_function_map;
 
   DataLayout *data_layout;
 
+  /** @brief 当前使用的分派引擎 (默认: 可用时为 THREADED) */
+  InterpreterEngine engine;
+
+  /** @brief 降级时是否融合超级指令 (默认: true) */
+  bool enable_fusion;
+
+  /** @brief 是否收集 profile 数据 (默认: false) */
+  bool enable_profiling;
+
+  /** @brief 是否用 JIT 编译热函数 (默认: false) */
+  bool enable_jit;
+
+  /** @brief 函数被调用多少次后编译 (默认: INTERP_JIT_DEFAULT_THRESHOLD) */
+  uint32_t jit_threshold;
+
+  /** @brief 纯函数的备忘表 (未开启备忘时为 NULL，见 interpreter_set_memoization) */
+  struct MemoTable *memo;
+
+  /** @brief 所有已编译的机器码 (链表；invalidate_all / 销毁时释放) */
+  struct JitCode *jit_code;
+
+  /**
+   * @brief 执行计划竞技场。
+   *
+   * 所有缓存的 ExecPlan (以及 plan_cache 本身) 都分配在这里，
+   * interpreter_invalidate_all() 会整体重置它。
+   */
+  Bump *plan_arena;
+
+  /**
+   * @brief 执行计划缓存
+   * Map<IRFunction*, ExecPlan*>，在函数第一次被调用时惰性构建
+   */
+  PtrHashMap *plan_cache;
+
+  /** @brief interpreter_run_function 使用的默认栈 (工作线程各自拥有自己的栈) */
+  InterpreterStack stack;
+
+  /**
+   * @brief 是否已被 interpreter_prepare_module 封存。
+   *
+   * 封存后，执行期间不再修改任何共享状态 (全局变量存储、计划缓存)，
+   * 因此可以被多个 InterpreterWorker 并发使用。
+   */
+  bool sealed;
+
 } Interpreter;
 
+/** @brief 预降级的函数执行计划 (定义见 interpreter/exec_plan.h) */
+typedef struct ExecPlan ExecPlan;
+
+/** @brief 解释器栈上的一个调用帧 (定义在 interpreter.c 内部) */
+typedef struct ExecFrame ExecFrame;
+
 typedef struct ExecutionContext
 {
   /** @brief 指向父解释器，用于访问持久竞技场 (e.g., 用于常量) */
   Interpreter *interp;
 
-  /** @brief 寄存器堆 (Register File). 映射: IRValueNode* -> RuntimeValue* */
-  PtrHashMap *frame;
+  /** @brief 当前 (最内层) 调用帧 */
+  ExecFrame *frame;
+
+  /** @brief 当前帧的执行计划 */
+  ExecPlan *plan;
+
+  /** @brief 本次运行使用的解释器栈 (默认栈或某个工作线程的栈) */
+  InterpreterStack *stack;
 
-  /** @brief 临时值竞技场 (Temporary Value Arena)。*/
-  Bump value_arena;
+  /**
+   * @brief 当前帧的寄存器堆 (Register File).
+   * 按槽位编号索引的 RuntimeValue 数组 (大小为 plan->num_slots)
+   */
+  RuntimeValue *slots;
+
+  /** @brief (profiling) 上一次把周期数记到某个函数上的时间戳 */
+  uint64_t profile_stamp;
+
+  /** @brief 宿主 C 栈上嵌套的机器码调用层数 (超过上限后的调用改为解释执行) */
+  uint32_t native_depth;
 
-  /** @brief 模拟栈 (Stack Arena)。*/
-  Bump stack_arena;
+  /** @brief 本次运行是否查询 / 填充备忘表 (只有 interpreter_run_function 会) */
+  bool memoize;
+
+  /** @brief 宿主 C 栈上嵌套执行的备忘调用层数 (超过上限后的调用不再备忘) */
+  uint32_t memo_depth;
+
+  /** @brief (可恢复执行) 本次 step 剩余的指令预算 */
+  uint64_t budget;
+
+  /** @brief (可恢复执行) 挂起时当前帧即将进入的基本块 (新的运行从 0 号块开始) */
+  uint32_t resume_block;
 
   /** * @brief [!!] (重构) 存储运行时错误信息
    * 当辅助函数返回 ERR 时，它们会顺便设置这个。
@@ -140,6 +329,49 @@ typedef struct ExecutionContext
   const char *error_message;
 } ExecutionContext;
 
+/**
+ * @brief 一个工作线程的执行状态 (一个 Interpreter 可以有任意多个)。
+ *
+ * 每个工作者只拥有自己的解释器栈；计划、常量池和全局变量内存都共享自
+ * 封存后的 Interpreter。一个工作者同一时刻只能被一个线程使用。
+ */
+typedef struct InterpreterWorker
+{
+  Interpreter *interp;
+  InterpreterStack stack;
+} InterpreterWorker;
+
+/** @brief 可恢复执行默认使用的解释器栈大小 (远小于默认栈，以便同时存在成千上万个执行) */
+#define INTERP_EXECUTION_DEFAULT_STACK_SIZE (256 * 1024)
+
+/**
+ * @brief 一个可恢复的函数执行 (见 interpreter_execution_start)。
+ *
+ * 执行拥有自己的解释器栈和执行上下文；挂起时所有调用帧都留在这个栈上，
+ * 因此它可以在之后 (甚至在另一个线程上) 继续执行。同一时刻只能被一个线程使用。
+ */
+typedef struct InterpreterExecution
+{
+  Interpreter *interp;
+  InterpreterStack stack;
+  ExecutionContext ctx;
+
+  /** @brief EXEC_RUNNING 表示还没有结束；否则是最终状态 (错误信息在 ctx.error_message) */
+  ExecutionResultKind status;
+
+  /** @brief 'ret' 的返回值 (status == EXEC_OK 时有效) */
+  RuntimeValue result;
+
+  /** @brief 至今已消耗的指令预算 (按整个基本块计) */
+  uint64_t instructions;
+
+  /** @brief 调用者的私有数据 (解释器不使用) */
+  void *user_data;
+
+  /** @brief (调度器) 就绪队列中的下一个执行 */
+  struct InterpreterExecution *next;
+} InterpreterExecution;
+
 /**
  * @brief 所有宿主 FFI 函数必须匹配的 C 函数签名
  *
@@ -152,6 +384,30 @@ typedef struct ExecutionContext
 typedef ExecutionResultKind (*CalicoHostFunction)(ExecutionContext *ctx, RuntimeValue **args, size_t num_args,
                                                   RuntimeValue *result_out);
 
+/**
+ * @brief 类型化宿主函数的参数 / 返回值类型 (按值传递，不装箱)
+ */
+typedef enum CalicoHostType
+{
+  /** 无返回值 (只能用作返回类型) */
+  CALICO_HOST_VOID,
+  /** int64_t: IR 的整数 (符号扩展) 与指针 (intptr_t) */
+  CALICO_HOST_I64,
+  /** double: IR 的 f32 / f64 */
+  CALICO_HOST_F64,
+} CalicoHostType;
+
+/** @brief 类型化宿主函数最多的参数个数 */
+#define CALICO_TYPED_HOST_MAX_PARAMS 4
+
+/**
+ * @brief 类型化宿主函数的通用函数指针类型
+ *
+ * 注册时把真实的函数指针 (e.g., int64_t (*)(int64_t, int64_t)) 转换成这个类型，
+ * 解释器按注册时声明的签名转换回去再调用。
+ */
+typedef void (*CalicoTypedHostFunction)(void);
+
 /**
  * @brief 创建一个新的解释器实例。
  * @param data_layout [!!] 解释器将 *借用* 的数据布局。
@@ -176,6 +432,289 @@ void interpreter_destroy(Interpreter *interp);
  */
 void interpreter_register_external_function(Interpreter *interp, const char *name, CalicoHostFunction fn_ptr);
 
+/**
+ * @brief [FFI] 注册一个类型化宿主函数: 参数与返回值直接按 C 类型传递
+ * (不构造 RuntimeValue* 数组，也没有 ExecutionContext)。
+ *
+ * 签名为 ret_type (*)(param_type, ...)，num_params 个参数都是 param_type。
+ * IR 的整数参数符号扩展为 int64_t、指针转换为 intptr_t、浮点数转换为 double；
+ * 返回值按 'call' 的结果类型截断 / 转换。IR 声明的参数个数或类型与签名不符时，
+ * 调用返回运行时错误。
+ *
+ * 与 interpreter_register_external_function 共用同一个名字空间 (后注册的覆盖先注册的)。
+ * 已经构建的执行计划会立即使用新的函数。
+ *
+ * @param interp 解释器实例
+ * @param name IR 中的函数名 (e.g., "sqrt")
+ * @param fn_ptr 转换为 CalicoTypedHostFunction 的函数指针
+ * @param ret_type 返回类型
+ * @param param_type 所有参数的类型 (I64 或 F64；num_params 为 0 时忽略)
+ * @param num_params 参数个数 (最多 CALICO_TYPED_HOST_MAX_PARAMS)
+ * @return 注册成功返回 true；签名不受支持或 OOM 时返回 false
+ */
+bool interpreter_register_typed_function(Interpreter *interp, const char *name, CalicoTypedHostFunction fn_ptr,
+                                         CalicoHostType ret_type, CalicoHostType param_type, size_t num_params);
+
+/**
+ * @brief [FFI] 链接一个模块的所有外部声明。
+ *
+ * 每个外部函数名只解析一次: 之后构建的执行计划把直接调用外部声明的 'call'
+ * 解析到同一个链接结果上，调用时不再按名字查找 (之后注册的函数仍然生效)。
+ *
+ * @param interp 解释器实例
+ * @param mod 要链接的模块
+ * @return 所有外部声明都已注册宿主函数时返回 true (未注册的函数在被调用时报错)
+ */
+bool interpreter_link_module(Interpreter *interp, IRModule *mod);
+
+/**
+ * @brief 选择指令分派引擎。
+ *
+ * @param interp 解释器实例
+ * @param engine 要使用的引擎
+ * @return 成功返回 true；如果请求的引擎在当前编译器下不可用
+ * (CALICO_HAS_THREADED_ENGINE == 0)，返回 false 且保持原引擎不变。
+ */
+bool interpreter_set_engine(Interpreter *interp, InterpreterEngine engine);
+
+/**
+ * @brief 开启 / 关闭超级指令融合。
+ *
+ * 会丢弃所有缓存的执行计划 (它们会按新设置重新降级)。
+ *
+ * @param interp 解释器实例
+ * @param enabled 是否融合
+ */
+void interpreter_set_fusion(Interpreter *interp, bool enabled);
+
+/**
+ * @brief 获取某种超级指令在所有缓存的执行计划中被融合的次数。
+ * @param interp 解释器实例
+ * @param kind 超级指令种类
+ */
+size_t interpreter_get_fusion_count(Interpreter *interp, InterpreterFusionKind kind);
+
+/**
+ * @brief 打印超级指令融合报告 (每种超级指令的融合次数)。
+ * @param interp 解释器实例
+ * @param stream 输出流 (e.g., stdout)
+ */
+void interpreter_dump_fusion_stats(Interpreter *interp, FILE *stream);
+
+/**
+ * @brief 开启 / 关闭基线 JIT。
+ *
+ * 开启后，一个函数被调用 jit_threshold 次后会被编译为 x86-64 机器码，
+ * 之后的调用直接执行机器码 (返回值、FFI 与运行时错误的行为都与解释执行相同)。
+ * 机器码之间的 'call' 嵌套在宿主 C 栈上，超过一定深度后回到解释执行。
+ * 开启 profiling 时不编译任何函数 (profile 计数器只由解释器维护)。
+ *
+ * @param interp 解释器实例
+ * @param enabled 是否开启
+ * @return 成功返回 true；当前平台不支持 JIT (CALICO_HAS_JIT == 0) 时返回 false
+ */
+bool interpreter_set_jit(Interpreter *interp, bool enabled);
+
+/**
+ * @brief 设置 JIT 的编译阈值 (调用次数；0 表示第一次调用时就编译)。
+ *
+ * 已封存的解释器不计数: interpreter_prepare_module 会直接编译所有函数。
+ *
+ * @param interp 解释器实例
+ * @param calls 调用次数
+ */
+void interpreter_set_jit_threshold(Interpreter *interp, uint32_t calls);
+
+/**
+ * @brief 函数当前缓存的计划是否已被 JIT 编译。
+ * @param interp 解释器实例
+ * @param func 要查询的函数
+ */
+bool interpreter_is_jit_compiled(Interpreter *interp, IRFunction *func);
+
+/**
+ * @brief 开启 / 关闭纯函数的备忘 (memoization)。
+ *
+ * 开启后，对纯函数 (见 analysis/purity.h 的 purity_is_pure_function) 的调用
+ * 以 (函数, 参数值) 为键查询备忘表: 命中时直接返回缓存的结果，不再执行函数体。
+ * 只有返回整数或浮点数、参数不超过 INTERP_MEMO_MAX_ARGS 个的函数会被备忘，
+ * 出错的调用不缓存。表的大小固定 (满了之后替换最久未用的结果)。
+ *
+ * 备忘表属于解释器的默认栈: interpreter_run_function (及其中的嵌套调用) 使用它，
+ * 工作者、可恢复执行与批量执行不使用。切换此设置会丢弃所有缓存的执行计划。
+ *
+ * @param interp 解释器实例
+ * @param enabled 是否开启
+ * @param capacity 能缓存的结果个数 (0 表示 INTERP_MEMO_DEFAULT_CAPACITY；向上取整)
+ * @return 成功返回 true；OOM 时返回 false (备忘保持关闭)
+ */
+bool interpreter_set_memoization(Interpreter *interp, bool enabled, size_t capacity);
+
+/**
+ * @brief 获取备忘表的统计数据 (未开启备忘时全部为 0)。
+ */
+void interpreter_get_memo_stats(Interpreter *interp, InterpreterMemoStats *stats_out);
+
+/**
+ * @brief 丢弃备忘表中所有缓存的结果，并把统计数据清零。
+ *
+ * 使函数的计划失效 (interpreter_invalidate_*) 时也会丢弃缓存的结果 (IR 可能已被修改)。
+ */
+void interpreter_clear_memo(Interpreter *interp);
+
+/**
+ * @brief 开启 / 关闭 profiling。
+ *
+ * 开启后，解释器会记录每个函数的调用次数与自身周期数 (不含被调用的 IR 函数)、
+ * 每个基本块的进入次数，并由此推导出每种 opcode 的执行次数。
+ * profile 数据附着在缓存的执行计划上: 切换此设置、或使某个函数的计划失效，
+ * 都会丢弃对应的数据。
+ *
+ * @param interp 解释器实例
+ * @param enabled 是否开启
+ */
+void interpreter_set_profiling(Interpreter *interp, bool enabled);
+
+/**
+ * @brief 将所有 profile 计数器清零 (保留缓存的执行计划)。
+ * @param interp 解释器实例
+ */
+void interpreter_reset_profile(Interpreter *interp);
+
+/**
+ * @brief 获取某个函数被调用的次数 (未 profile 过时为 0)。
+ */
+uint64_t interpreter_profile_get_calls(Interpreter *interp, IRFunction *func);
+
+/**
+ * @brief 获取在某个函数自身中花费的周期数 (x86 上为 TSC，其他平台为纳秒)。
+ */
+uint64_t interpreter_profile_get_cycles(Interpreter *interp, IRFunction *func);
+
+/**
+ * @brief 获取某个基本块被进入的次数 (未 profile 过时为 0)。
+ */
+uint64_t interpreter_profile_get_block_entries(Interpreter *interp, IRBasicBlock *bb);
+
+/**
+ * @brief 获取某种 opcode 在所有被 profile 的函数中执行的次数。
+ *
+ * 由基本块进入次数乘以块内该 opcode 的数量得到 (每条 'phi' 也计一次)；
+ * 因运行时错误而中途退出的块仍按完整执行计数。
+ */
+uint64_t interpreter_profile_get_opcode_count(Interpreter *interp, IROpcode opcode);
+
+/**
+ * @brief 通过 IRPrinter 打印带 profile 注解的模块。
+ *
+ * 先以 ';' 注释输出 opcode 执行次数表，再打印整个模块：
+ * 每个函数前注明调用次数与自身周期占比，每个基本块标签后注明进入次数。
+ * 输出仍然是合法的 .cir 文本。
+ *
+ * @param interp 解释器实例
+ * @param mod 要打印的模块
+ * @param p 打印机 (原有的 annotator 会在打印期间被临时替换)
+ */
+void interpreter_dump_profile(Interpreter *interp, IRModule *mod, IRPrinter *p);
+
+/**
+ * @brief 使某个函数的缓存执行计划失效。
+ *
+ * 解释器会在函数第一次被调用时将其降级并缓存执行计划。
+ * 如果之后修改了该函数的 IR (指令、操作数、基本块)，
+ * 必须在下一次运行之前调用此函数。
+ *
+ * @param interp 解释器实例
+ * @param func 被修改的函数
+ */
+void interpreter_invalidate_function(Interpreter *interp, IRFunction *func);
+
+/**
+ * @brief 丢弃所有缓存的执行计划 (并释放它们占用的内存)。
+ * @param interp 解释器实例
+ */
+void interpreter_invalidate_all(Interpreter *interp);
+
+/**
+ * @brief 为并发执行做准备: 预先初始化模块的所有全局变量、
+ * 为所有已定义的函数构建执行计划，然后封存解释器。
+ *
+ * 封存后，解释器的共享状态只读，多个线程可以通过各自的 InterpreterWorker
+ * 并发调用 interpreter_worker_run_function。调用不属于已准备模块的函数会失败
+ * (而不是惰性构建计划)。
+ *
+ * 以下操作会修改共享状态，只能在没有工作者运行时调用:
+ * interpreter_register_external_function、interpreter_set_*、interpreter_invalidate_*、
+ * interpreter_reset_profile。其中 set / invalidate 会解除封存 (需要重新 prepare)。
+ * profiling 计数器不做同步，并发运行时应关闭 profiling (interpreter_set_profiling)。
+ *
+ * @param interp 解释器实例
+ * @param mod 要执行的模块 (之后不能再修改；可以多次调用以准备多个模块)
+ * @return 成功返回 true；某个函数无法降级时返回 false (解释器不会被封存)
+ */
+bool interpreter_prepare_module(Interpreter *interp, IRModule *mod);
+
+/** @brief 模块全局变量内容的快照 (不透明；见 interpreter_snapshot_globals) */
+typedef struct GlobalSnapshot GlobalSnapshot;
+
+/**
+ * @brief 装载模块的全局变量: 按 DataLayout 把所有全局变量排进一整块连续内存 (全局镜像)，
+ * 并成批写入初始值。
+ *
+ * 不调用时，模块的某个全局变量第一次被执行计划引用会自动装载整个模块；
+ * interpreter_prepare_module 也会装载。已装载的全局变量不会重新初始化，
+ * 之后加入模块的全局变量会组成一个新的镜像。
+ *
+ * @return 成功返回 true；OOM 时返回 false
+ */
+bool interpreter_load_globals(Interpreter *interp, IRModule *mod);
+
+/**
+ * @brief 把模块的全局变量恢复为初始值 (按镜像整块复制；必要时先装载)。
+ *
+ * 与 interpreter_restore_globals 一样只应在没有代码运行时调用。
+ */
+bool interpreter_reset_globals(Interpreter *interp, IRModule *mod);
+
+/**
+ * @brief 复制模块全局变量的当前内容 (必要时先装载)。
+ *
+ * 同一个快照可以多次恢复，例如让很多次运行都从同一个准备好的状态开始。
+ *
+ * @return 新快照 (用 interpreter_snapshot_destroy 释放)；OOM 时返回 NULL
+ */
+GlobalSnapshot *interpreter_snapshot_globals(Interpreter *interp, IRModule *mod);
+
+/**
+ * @brief 把快照的内容写回模块的全局镜像 (快照之后新增的全局变量保持不变)。
+ */
+void interpreter_restore_globals(Interpreter *interp, const GlobalSnapshot *snapshot);
+
+/**
+ * @brief 释放一个快照。
+ */
+void interpreter_snapshot_destroy(GlobalSnapshot *snapshot);
+
+/**
+ * @brief 创建一个工作者 (分配它自己的解释器栈)。
+ * @param interp 工作者所属的解释器 (必须比工作者存活更久)
+ * @return 新工作者；OOM 时返回 NULL
+ */
+InterpreterWorker *interpreter_worker_create(Interpreter *interp);
+
+/**
+ * @brief 销毁一个工作者。
+ */
+void interpreter_worker_destroy(InterpreterWorker *worker);
+
+/**
+ * @brief 在工作者自己的栈上运行一个 IR 函数 (参数与返回值同 interpreter_run_function)。
+ *
+ * 当解释器已封存时，不同工作者可以在不同线程上同时调用此函数。
+ */
+bool interpreter_worker_run_function(InterpreterWorker *worker, IRFunction *func, RuntimeValue **args,
+                                     size_t num_args, RuntimeValue *result_out);
+
 /**
  * @brief (公开 API) 运行 (解释) 一个 IR 函数。
  *
@@ -189,3 +728,88 @@ void interpreter_register_external_function(Interpreter *interp, const char *nam
  */
 bool interpreter_run_function(Interpreter *interp, IRFunction *func, RuntimeValue **args, size_t num_args,
                               RuntimeValue *result_out);
+
+/**
+ * @brief 开始一个可恢复的函数执行 (此时还没有执行任何指令)。
+ *
+ * 之后用 interpreter_execution_step 以指令预算为单位推进它。
+ * 执行期间不会进入 JIT 编译的机器码 (机器码无法在中途挂起)。
+ * 解释器未封存时计划会被惰性构建，同一时刻只能有一个线程推进它的执行；
+ * 封存后不同的执行可以在不同线程上同时推进。
+ *
+ * @param interp 解释器实例 (必须比执行存活更久)
+ * @param func 要运行的函数
+ * @param args (可选) 传递给函数的参数 (会被复制)
+ * @param num_args 参数的数量
+ * @param stack_size 执行的解释器栈大小 (0 表示 INTERP_EXECUTION_DEFAULT_STACK_SIZE)
+ * @return 新的执行；OOM、无法构建计划或栈放不下第一个帧时返回 NULL
+ */
+InterpreterExecution *interpreter_execution_start(Interpreter *interp, IRFunction *func, RuntimeValue **args,
+                                                  size_t num_args, size_t stack_size);
+
+/**
+ * @brief 推进一个执行，直到它结束或用完 budget 条指令的预算。
+ *
+ * 预算在进入每个基本块时按整块扣除 (一次 step 最多超出不到一个基本块)，
+ * 所以每次循环迭代与每次调用都会检查预算；预算用完时在下一个块的入口处挂起。
+ *
+ * @param exec 执行
+ * @param budget 指令预算 (必须大于 0 才能保证前进)
+ * @return EXEC_RUNNING 表示已挂起 (再次调用以继续)；EXEC_OK 表示已返回 (结果在 exec->result)；
+ * 其他值为运行时错误。已结束的执行会一直返回它的最终状态。
+ */
+ExecutionResultKind interpreter_execution_step(InterpreterExecution *exec, uint64_t budget);
+
+/**
+ * @brief 销毁一个执行 (无论它是否已经结束)。
+ */
+void interpreter_execution_destroy(InterpreterExecution *exec);
+
+/** @brief 批量模式中每组同时执行的 lane 数 */
+#define INTERP_BATCH_WIDTH 128
+
+/**
+ * @brief (公开 API) 在 num_lanes 组输入上运行同一个 IR 函数 (批量模式)。
+ *
+ * 参数按列传入: arg_columns[i][lane] 是第 lane 组输入的第 i 个参数。
+ * 如果函数只包含无副作用的标量运算、PHI 与控制流 (没有 alloca / load / store / call)，
+ * 解释器以 INTERP_BATCH_WIDTH 个 lane 为一组，按列 (SoA) 存放每个槽位，
+ * 对整列执行向量化的运算内核；走不同分支的 lane 通过掩码分开执行，
+ * 没有向量内核的指令 (整数除法、大部分转换等) 逐 lane 执行。
+ * 否则退化为对每组输入调用一次 interpreter_run_function。
+ * 结果与逐个调用 interpreter_run_function 相同 (批量执行不更新 profile 计数器)。
+ *
+ * @param interp 解释器实例
+ * @param func 要运行的函数
+ * @param arg_columns 参数列 (num_args 个数组，每个有 num_lanes 个值)
+ * @param num_args 参数的数量
+ * @param num_lanes 输入的组数
+ * @param results_out [out] 结果数组 (num_lanes 个值)
+ * @return 所有 lane 都成功返回时为 true；任何一个 lane 发生运行时错误时返回 false
+ */
+bool interpreter_run_function_batch(Interpreter *interp, IRFunction *func, RuntimeValue *const *arg_columns,
+                                    size_t num_args, size_t num_lanes, RuntimeValue *results_out);
+
+/**
+ * @brief 在工作者自己的栈上批量运行一个 IR 函数
+ * (参数与返回值同 interpreter_run_function_batch)。
+ */
+bool interpreter_worker_run_function_batch(InterpreterWorker *worker, IRFunction *func,
+                                           RuntimeValue *const *arg_columns, size_t num_args, size_t num_lanes,
+                                           RuntimeValue *results_out);
+
+/**
+ * @brief 常量折叠: 在常量操作数上求值一条指令，语义与解释器执行它时逐位相同
+ *
+ * 整数 / 位运算、浮点运算、icmp / fcmp、类型转换和 select 调用的是解释器执行这些指令的同一组求值函数，
+ * 所以变换 (例如 SCCP) 折叠出的常量与运行时算出的值一致。
+ *
+ * @param ctx 结果常量所在的 Context
+ * @param dl 数据布局 (bitcast 需要)
+ * @param inst 要求值的指令 (只读取它的操作码、谓词和结果类型)
+ * @param operands 每个操作数对应的常量 (按 inst 的操作数顺序)
+ * @return 结果常量；不支持的指令、指针类型的结果、有 undef 操作数，
+ *         或执行会产生运行时错误 (例如除以零) 时返回 NULL
+ */
+IRValueNode *interpreter_fold_instruction(IRContext *ctx, const DataLayout *dl, IRInstruction *inst,
+                                          IRConstant *const *operands);
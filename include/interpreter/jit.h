@@ -0,0 +1,88 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "interpreter/exec_plan.h"
+#include "interpreter/interpreter.h"
+#include "utils/data_layout.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * =================================================================
+ * --- 基线模板 JIT (Baseline Template JIT) ---
+ * =================================================================
+ *
+ * 把一个执行计划逐条翻译为 x86-64 机器码 (每种指令一个固定的模板)。
+ * 生成的代码直接读写帧的 RuntimeValue 槽位 (与解释器使用同一个帧布局)，
+ * 因此可以在任意一条指令上与解释器的辅助函数交替执行:
+ *
+ * - 整数 / 浮点运算、比较、select、整数转换、标量 load / store、gep、
+ * 分支与 PHI 边复制、ret: 内联模板
+ * - 其他指令 (除法、alloca、call、多数转换等): 调用 JitHelpers::execute
+ * - switch: 调用 JitHelpers::switch_edge 求目标边，再比较跳转
+ *
+ * 生成代码的寄存器约定: rbx = 槽位数组，r12 = ExecutionContext，r13 = result_out。
+ */
+
+/**
+ * @brief 编译后函数的入口
+ *
+ * @param ctx 当前执行上下文 (ctx->slots 必须等于 slots)
+ * @param slots 已初始化的帧 (参数与常量池已就位)
+ * @param result_out [out] 'ret' 的返回值
+ * @return EXEC_OK，或某个辅助函数返回的错误 (ctx->error_message 已设置)
+ */
+typedef ExecutionResultKind (*JitEntry)(ExecutionContext *ctx, RuntimeValue *slots, RuntimeValue *result_out);
+
+/**
+ * @brief 生成的代码回调的解释器辅助函数
+ */
+typedef struct JitHelpers
+{
+  /** 执行一条没有内联模板的非终结指令 (读写 ctx->slots) */
+  ExecutionResultKind (*execute)(ExecutionContext *ctx, ExecInst *ei);
+  /** 求 'switch' 的目标边编号 */
+  uint32_t (*switch_edge)(ExecutionContext *ctx, ExecInst *ei);
+} JitHelpers;
+
+/**
+ * @brief 一个函数的机器码 (位于独立映射的只读可执行页中)
+ */
+typedef struct JitCode
+{
+  JitEntry entry;
+  void *memory;
+  size_t size;
+  /** 解释器持有的所有机器码组成的链表 (用于统一释放) */
+  struct JitCode *next;
+} JitCode;
+
+/**
+ * @brief 把执行计划编译为机器码
+ *
+ * @param plan 已填充常量池与 switch 表的执行计划 (必须比机器码存活更久)
+ * @param dl 数据布局 (用于内联 load / store / gep 的大小与偏移)
+ * @param helpers 生成的代码回调的辅助函数
+ * @return 成功返回机器码；当前平台不支持 JIT、计划过大或 OOM 时返回 NULL
+ */
+JitCode *jit_compile(const ExecPlan *plan, const DataLayout *dl, const JitHelpers *helpers);
+
+/**
+ * @brief 释放机器码 (解除映射)
+ */
+void jit_code_free(JitCode *code);
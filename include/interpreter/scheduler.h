@@ -0,0 +1,95 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "interpreter/interpreter.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * =================================================================
+ * --- 协作式调度器 (Cooperative Scheduler) ---
+ * =================================================================
+ *
+ * 用固定数量的工作线程轮转推进任意多个可恢复执行 (InterpreterExecution):
+ * 工作线程从就绪队列头部取出一个执行，用一个时间片 (quantum 条指令的预算)
+ * 推进它；还没有结束的执行回到队列尾部。因此一个长时间运行的执行
+ * 只会让其他执行多等待若干个时间片，而不会独占某个线程直到结束。
+ */
+
+/**
+ * @brief 是否编译了调度器 (需要 C11 <threads.h>)。
+ */
+#if !defined(__STDC_NO_THREADS__)
+#define CALICO_HAS_SCHEDULER 1
+#else
+#define CALICO_HAS_SCHEDULER 0
+#endif
+
+/** @brief 默认时间片 (每次推进一个执行时的指令预算) */
+#define INTERP_SCHEDULER_DEFAULT_QUANTUM 10000
+
+/** @brief 调度器 (定义在 scheduler.c 内部) */
+typedef struct InterpreterScheduler InterpreterScheduler;
+
+/**
+ * @brief 执行结束 (返回或出错) 时在工作线程上调用的回调
+ *
+ * 回调返回后调度器不再访问 exec，所以回调可以销毁它。
+ *
+ * @param exec 已结束的执行 (exec->status 是它的最终状态)
+ * @param user_data 创建调度器时传入的数据
+ */
+typedef void (*InterpreterSchedulerCallback)(InterpreterExecution *exec, void *user_data);
+
+/**
+ * @brief 创建调度器并启动它的工作线程。
+ *
+ * @param interp 已封存的解释器 (interpreter_prepare_module；必须比调度器存活更久)
+ * @param num_threads 工作线程数 (大于 0)
+ * @param quantum 时间片 (0 表示 INTERP_SCHEDULER_DEFAULT_QUANTUM)
+ * @param on_complete (可选) 执行结束时的回调
+ * @param user_data 传给回调的数据
+ * @return 新调度器；解释器未封存、线程创建失败、OOM，
+ * 或不支持线程 (CALICO_HAS_SCHEDULER == 0) 时返回 NULL
+ */
+InterpreterScheduler *interpreter_scheduler_create(Interpreter *interp, size_t num_threads, uint64_t quantum,
+                                                   InterpreterSchedulerCallback on_complete, void *user_data);
+
+/**
+ * @brief 把一个执行加入就绪队列 (可以从任意线程调用，包括回调中)。
+ *
+ * 执行必须属于调度器的解释器，并且在它结束之前不能被调用者推进。
+ *
+ * @param sched 调度器
+ * @param exec 要运行的执行
+ */
+void interpreter_scheduler_submit(InterpreterScheduler *sched, InterpreterExecution *exec);
+
+/**
+ * @brief 等待所有已提交的执行结束 (包括它们的回调)。
+ */
+void interpreter_scheduler_wait(InterpreterScheduler *sched);
+
+/**
+ * @brief 停止并回收工作线程，然后销毁调度器。
+ *
+ * 每个线程推进完手上的时间片后退出；仍在队列中的执行保持挂起 (可以之后手动推进)，
+ * 调度器不会销毁任何执行。需要全部跑完时先调用 interpreter_scheduler_wait。
+ */
+void interpreter_scheduler_destroy(InterpreterScheduler *sched);
@@ -21,6 +21,10 @@
 #include "ir/value.h"
 #include "utils/id_list.h"
 
+#include <stdbool.h>
+
+typedef struct IRInstruction IRInstruction;
+
 /**
  * @brief 基本块
  */
@@ -31,6 +35,17 @@ typedef struct IRBasicBlock
 
   IDList instructions;
   IRFunction *parent;
+
+  /**
+   * @brief 块内指令的顺序号 (IRInstruction::order) 是否有效
+   *
+   * 顺序号带间隔 (IR_INSTRUCTION_ORDER_STEP)，插入时取前后邻居的中点；
+   * 没有空隙时只把它置为 false，下一次 ir_instruction_comes_before 再整块重新编号。
+   */
+  bool order_valid;
+
+  /// 在函数中的稠密编号，由 cfg_build 按块的顺序分配 (CFGNode::id；新建的块为 -1)
+  int id;
 } IRBasicBlock;
 
 /**
@@ -48,6 +63,36 @@ IRBasicBlock *ir_basic_block_create(IRFunction *func, const char *name);
  */
 void ir_function_append_basic_block(IRFunction *func, IRBasicBlock *bb);
 
+/**
+ * @brief 删除块中的所有指令 (仍被使用的结果替换为 undef)，再把块从函数中移除
+ *
+ * @pre 块之外没有指令引用这个块 (跳转目标或 phi 的入边)
+ * @param bb 要删除的基本块 (内存仍属于函数体 Arena)
+ */
+void ir_basic_block_erase_from_parent(IRBasicBlock *bb);
+
+/**
+ * @brief 在 inst 处把 bb 一分为二: inst 和它之后的指令移到一个新块中，新块紧接在 bb 之后
+ *
+ * 终结指令随之移到新块，所以后继中 phi 来自 bb 的入边改为来自新块。
+ * bb 留下时没有终结指令，由调用者添加 (例如跳到新块的 br)。
+ *
+ * @param inst bb 中的指令 (不能是 phi)
+ * @param name 新块的标签名 (将被 intern)
+ * @return 新块；OOM 时返回 NULL (bb 不变)
+ */
+IRBasicBlock *ir_basic_block_split(IRBasicBlock *bb, IRInstruction *inst, const char *name);
+
+/**
+ * @brief 指令被链入 bb->instructions 之后调用，为它分配顺序号，并把函数标记为已修改
+ *
+ * 所有把指令插入 (或移动到) 块中的代码都必须调用它 (builder 已经这样做)。
+ * 从块中删除指令不需要通知：剩下的顺序号仍然递增。
+ * @param bb 指令所在的基本块
+ * @param inst 刚插入的指令
+ */
+void ir_basic_block_instruction_inserted(IRBasicBlock *bb, IRInstruction *inst);
+
 /**
  * @brief 将单个基本块的 IR 打印到 IRPrinter
  * [!!] 签名已更改
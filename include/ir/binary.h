@@ -0,0 +1,101 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* include/ir/binary.h */
+#pragma once
+
+#include "ir/context.h"
+#include "ir/module.h"
+#include "utils/bump.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * =================================================================
+ * --- 二进制 IR 格式 (Binary IR Format) ---
+ * =================================================================
+ *
+ * 文本格式 (.cir) 的紧凑替代：保存时不需要格式化文本，加载时不需要词法分析。
+ * 所有整数都是 LEB128 变长编码 (有符号数先做 zigzag)，浮点数是 8 字节小端 IEEE 754。
+ *
+ *   header:    "CIRB" IR_BINARY_VERSION
+ *   strings:   count, (len, bytes)*          -- 名字 (模块、全局、函数、参数、基本块、指令、结构体)
+ *   types:     count, type*                  -- 被引用的类型排在引用者之前
+ *   constants: count, (type, kind, value)*
+ *   module:    name, globals, 函数头, (body_len, 函数体)*
+ *
+ * 函数体中每条指令是: opcode [name] [谓词 / GEP 源类型] operand_count operand*。
+ * 操作数是一个变长整数 (index << 2 | tag)，tag 区分
+ * 函数内的值 (参数和指令结果，按布局顺序编号)、基本块、常量池、全局变量/函数。
+ * 每个函数体开头记录所有指令的结果类型，所以读取时操作数可以引用后面才定义的值
+ * (例如循环中的 phi)。函数体前的字节长度让延迟加载可以跳过它。
+ *
+ * 读取端通过 IRBuilder 重建模块，并在返回前运行验证器。
+ */
+
+/** @brief 当前写出的格式版本 (读取端只接受相同版本) */
+#define IR_BINARY_VERSION 2
+
+/**
+ * @brief 把模块编码为二进制格式
+ *
+ * @param mod 要编码的模块
+ * @param arena 用于分配结果的 Arena
+ * @param out_size [out] 结果的字节数
+ * @return const uint8_t* 指向 arena 上的编码结果；
+ * 模块引用了不属于它的值 (例如其他模块的函数) 或 OOM 时返回 NULL
+ */
+const uint8_t *ir_binary_write_module(IRModule *mod, Bump *arena, size_t *out_size);
+
+/**
+ * @brief 把模块以二进制格式写入一个已打开的文件 (以 "wb" 打开)
+ *
+ * @return bool 编码或写入失败时返回 false
+ */
+bool ir_binary_write_module_file(IRModule *mod, FILE *stream);
+
+/**
+ * @brief 从二进制格式重建模块
+ *
+ * 输入会被完整地检查 (越界、非法的下标和类型)，损坏的输入不会导致崩溃。
+ *
+ * @param ctx 全局 IR 上下文
+ * @param data 编码数据 (不需要对齐，返回后不再被引用)
+ * @param size 字节数
+ * @return IRModule* 成功时返回新模块；格式错误、版本不符或验证失败时打印错误并返回 NULL
+ */
+IRModule *ir_binary_read_module(IRContext *ctx, const void *data, size_t size);
+
+/**
+ * @brief 延迟加载二进制模块：只重建全局变量和函数头，函数体在第一次访问时才解码
+ *
+ * 各个表和函数头的检查同 ir_binary_read_module；每个函数体在物化时
+ * (ir_function_materialize、ir_verify_function、解释器等，参见 ir_parse_module_lazy)
+ * 解码并验证，损坏的函数体在那时报告错误。
+ *
+ * @param data 编码数据 (被借用：必须在所有函数体物化之前保持有效且不被修改)
+ * @return IRModule* 成功时返回新模块 (不运行模块验证)；格式错误或版本不符时返回 NULL
+ */
+IRModule *ir_binary_read_module_lazy(IRContext *ctx, const void *data, size_t size);
+
+/**
+ * @brief 从文件读取二进制模块 (文件被只读映射，参见 utils/mapped_file.h)
+ *
+ * @return IRModule* 成功时返回新模块；文件无法读取或内容无效时返回 NULL
+ */
+IRModule *ir_binary_read_module_file(IRContext *ctx, const char *path);
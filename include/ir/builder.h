@@ -38,6 +38,16 @@ IRBuilder *ir_builder_create(IRContext *ctx);
 void ir_builder_destroy(IRBuilder *builder);
 void ir_builder_set_insertion_point(IRBuilder *builder, IRBasicBlock *bb);
 
+/**
+ * @brief 为插入点所在的函数预留 num_instructions 条指令、共 num_operands 个操作数的内存
+ *
+ * 一次分配；之后在这个函数中创建的指令依次从预留中切出，不再逐条分配。
+ * 适合知道每个基本块大致有多少条指令的前端。见 ir_function_reserve_body。
+ *
+ * @return bool OOM 时返回 false (之后照常逐条分配)
+ */
+bool ir_builder_reserve(IRBuilder *builder, size_t num_instructions, size_t num_operands);
+
 IRValueNode *ir_builder_create_ret(IRBuilder *builder, IRValueNode *val);
 IRValueNode *ir_builder_create_br(IRBuilder *builder, IRValueNode *target_bb);
 IRValueNode *ir_builder_create_cond_br(IRBuilder *builder, IRValueNode *cond, IRValueNode *true_bb,
@@ -143,6 +153,9 @@ IRValueNode *ir_builder_create_phi(IRBuilder *builder, IRType *type, const char
 /** @brief 向 PHI 节点添加 [value, basic_block] 对 (保持不变) */
 void ir_phi_add_incoming(IRValueNode *phi_node, IRValueNode *value, IRBasicBlock *incoming_bb);
 
+/** @brief 删除 PHI 节点的第 index 对 [value, basic_block] (后面的对前移，保持顺序) */
+void ir_phi_remove_incoming(IRValueNode *phi_node, size_t index);
+
 /**
  * @brief 构建 'call <callee>, <arg1>, ...'
  *
@@ -20,9 +20,11 @@
 #include "ir/value.h"
 #include "utils/bump.h"
 #include "utils/hashmap.h"
+#include "utils/id_list.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 /*
  * =================================================================
@@ -40,6 +42,55 @@
  * 都将持有一个指向此 IRContext 的指针。
  */
 
+/** @brief 小整数常量表覆盖的范围 (ir_constant_get_i16/i32/i64 在此范围内不查哈希表) */
+#define IR_SMALL_INT_MIN (-128)
+#define IR_SMALL_INT_MAX 1023
+
+/** @brief 常量缓存的分片数 (并发构建时每个分片有自己的锁) */
+#define IR_CONSTANT_CACHE_SHARDS 16
+
+/** @brief 共享值 (常量、全局变量、函数) 的 Use 链表锁的条数 (见 ir_context_use_lock_mask) */
+#define IR_USE_LOCK_STRIPES 64
+
+/** @brief 常量缓存中按类型分开的表 (IRConstantShard.values 的下标) */
+typedef enum
+{
+  IR_CONSTANT_TABLE_I16,
+  IR_CONSTANT_TABLE_I32,
+  IR_CONSTANT_TABLE_I64,
+  IR_CONSTANT_TABLE_F32,
+  IR_CONSTANT_TABLE_F64,
+  IR_CONSTANT_NUM_TABLES
+} IRConstantTable;
+
+/**
+ * @brief 常量缓存的一个分片
+ *
+ * 表本身和表中的常量都分配在分片自己的 Arena 中，
+ * 所以持有不同分片锁的线程不会同时使用同一个 Arena。表在第一次用到时才创建。
+ */
+typedef struct IRConstantShard
+{
+  Bump arena;
+  /** Key 是值的位模式 (整数的补码；浮点数转成 double 之后的位模式)，Value 是 IRConstant* */
+  I64HashMap *values[IR_CONSTANT_NUM_TABLES];
+  /** undef 常量，Key 是类型 */
+  PtrHashMap *undefs;
+} IRConstantShard;
+
+/**
+ * @brief 验证器的检查级别 (见 ir_context_set_verify_level)
+ */
+typedef enum IRVerifyLevel
+{
+  /** 没有通过任何验证 (只用于 IRFunction 的 verified_level) */
+  IR_VERIFY_NONE = 0,
+  /** 结构检查: 终结指令、操作数的个数和类型、phi 的入边是本函数的块；不构建任何分析 */
+  IR_VERIFY_STRUCTURAL,
+  /** 结构检查，加上 SSA 支配规则和 phi 的入边与前驱一一对应 (需要 CFG 和支配树) */
+  IR_VERIFY_FULL,
+} IRVerifyLevel;
+
 /**
  * @brief IR 上下文 (Context) 结构体定义
  */
@@ -53,13 +104,8 @@ struct IRContext
 
   PtrHashMap *pointer_type_cache;
 
-  I8HashMap *i8_constant_cache;
-  I16HashMap *i16_constant_cache;
-  I32HashMap *i32_constant_cache;
-  I64HashMap *i64_constant_cache;
-  F32HashMap *f32_constant_cache;
-  F64HashMap *f64_constant_cache;
-  PtrHashMap *undef_constant_cache;
+  /** 小整数表以外的整数常量、浮点常量和 undef，按 (类型, 值) 的哈希分片 */
+  IRConstantShard constant_shards[IR_CONSTANT_CACHE_SHARDS];
   PtrHashMap *array_type_cache;
 
   StrHashMap *named_struct_cache;
@@ -82,8 +128,43 @@ struct IRContext
 
   IRValueNode *const_i1_true;
   IRValueNode *const_i1_false;
+
+  /**
+   * 预先创建的小整数常量表 (IR_SMALL_INT_MIN..IR_SMALL_INT_MAX，i8 为整个取值范围)。
+   * 每种宽度一个连续数组，下标为 value - IR_SMALL_INT_MIN；范围外的值才查哈希表。
+   */
+  struct IRConstant *small_i8_constants;
+  struct IRConstant *small_i16_constants;
+  struct IRConstant *small_i32_constants;
+  struct IRConstant *small_i64_constants;
+
+  /** 并发构建期间的锁: 类型缓存、常量分片和共享值的 Use 链表 (见 ir_context_begin_concurrent；平时为 NULL) */
+  struct IRContextLock *lock;
+
+  /** 为 true 时每个函数在第一次分配函数体时自动获得私有 Arena */
+  bool private_function_arenas;
+  /** 所有函数私有 Arena 的链表 (IRFunctionArena) */
+  IDList function_arenas;
+
+  /** ir_verify_module 等 (包括解析器和加载器内部的验证) 使用的检查级别 */
+  IRVerifyLevel verify_level;
+
+  /**
+   * 进程内唯一的编号 (从 1 开始递增，不随地址复用)，记录在这个上下文创建的每个类型里。
+   * DataLayout 的布局缓存用 (类型地址, 编号) 作键，销毁上下文后被新上下文复用的地址不会命中旧条目。
+   */
+  uint32_t id;
 };
 
+/**
+ * @brief 一个函数的私有 Arena (见 ir_function_use_private_arena)
+ */
+typedef struct IRFunctionArena
+{
+  IDList list_node;
+  Bump arena;
+} IRFunctionArena;
+
 /*
  * =================================================================
  * --- 公共 API ---
@@ -115,6 +196,23 @@ void ir_context_destroy(IRContext *ctx);
  */
 void ir_context_reset_ir_arena(IRContext *ctx);
 
+/**
+ * @brief 之后开始构建的函数体是否自动使用私有 Arena (默认 false)
+ *
+ * 适合反复替换单个函数的长期运行的程序：每个函数体的内存可以单独释放
+ * (见 ir_function_use_private_arena)。代价是每个有函数体的函数至少占用一个 Chunk。
+ */
+void ir_context_set_private_function_arenas(IRContext *ctx, bool enabled);
+
+/**
+ * @brief 设置验证器的默认检查级别 (默认 IR_VERIFY_FULL)
+ *
+ * ir_verify_module、ir_verify_function 和它们的变体，以及解析器、二进制加载器和 Pass 流水线
+ * 内部的验证都使用这个级别。IR_VERIFY_STRUCTURAL 不构建 CFG 和支配树，适合信任输入来源的加载路径；
+ * 调试和 CI 保持 IR_VERIFY_FULL，或者用 ir_verify_module_level 显式地做完整检查。
+ */
+void ir_context_set_verify_level(IRContext *ctx, IRVerifyLevel level);
+
 IRType *ir_type_get_void(IRContext *ctx);
 IRType *ir_type_get_i1(IRContext *ctx);
 IRType *ir_type_get_i8(IRContext *ctx);
@@ -197,13 +295,15 @@ IRValueNode *ir_constant_get_i64(IRContext *ctx, int64_t value);
 
 /**
  * @brief 获取一个 f32 浮点常量 (唯一化)
- * @warning Key 不能是 NaN 或 Inf (根据你的哈希表实现)
+ *
+ * 按位模式唯一化: 0.0 和 -0.0 是两个常量，NaN 也可以作为常量。
  */
 IRValueNode *ir_constant_get_f32(IRContext *ctx, float value);
 
 /**
  * @brief 获取一个 f64 浮点常量 (唯一化)
- * @warning Key 不能是 NaN 或 Inf (根据你的哈希表实现)
+ *
+ * 按位模式唯一化: 0.0 和 -0.0 是两个常量，NaN 也可以作为常量。
  */
 IRValueNode *ir_constant_get_f64(IRContext *ctx, double value);
 
@@ -227,3 +327,197 @@ const char *ir_context_intern_str(IRContext *ctx, const char *str);
  * @return const char* 指向永久副本的指针 (注意: 它*不*保证以 '\0' 结尾)
  */
 const char *ir_context_intern_str_slice(IRContext *ctx, const char *str, size_t len);
+
+/**
+ * @brief 同 ir_context_intern_str_slice，但使用调用者算好的哈希
+ *
+ * 词法分析器等已经扫描过字符串的调用者用它避免再哈希一遍。
+ *
+ * @param hash 必须等于 str_hashmap_hash(str, len)
+ */
+const char *ir_context_intern_str_hashed(IRContext *ctx, const char *str, size_t len, uint64_t hash);
+
+/**
+ * @brief 驻留字符串前面的头部
+ *
+ * 每个驻留的字符串在 Arena 中都紧跟在这样一个头部之后，所以拿到驻留指针就能
+ * O(1) 地取回它的长度和哈希 (同一个 Context 中，两个驻留指针相等当且仅当内容相等)。
+ */
+typedef struct IRInternedStrHeader
+{
+  /** str_hashmap_hash(str, len) */
+  uint64_t hash;
+  size_t len;
+} IRInternedStrHeader;
+
+/**
+ * @brief 驻留字符串的哈希 (不重新计算)
+ *
+ * @param interned 必须是 ir_context_intern_str* 返回的指针
+ */
+static inline uint64_t
+ir_interned_str_hash(const char *interned)
+{
+  return ((const IRInternedStrHeader *)interned - 1)->hash;
+}
+
+/**
+ * @brief 驻留字符串的长度 (不调用 strlen)
+ *
+ * @param interned 必须是 ir_context_intern_str* 返回的指针
+ */
+static inline size_t
+ir_interned_str_len(const char *interned)
+{
+  return ((const IRInternedStrHeader *)interned - 1)->len;
+}
+
+/*
+ * =================================================================
+ * --- 内存统计 (Memory Report) ---
+ * =================================================================
+ */
+
+/** @brief 内存报告中的唯一化缓存 (IRContextMemoryReport.caches 的下标) */
+typedef enum IRContextCache
+{
+  IR_CACHE_POINTER_TYPES,
+  IR_CACHE_ARRAY_TYPES,
+  IR_CACHE_NAMED_STRUCTS,
+  IR_CACHE_ANON_STRUCTS,
+  IR_CACHE_FUNCTION_TYPES,
+  IR_CACHE_STRINGS,
+  /** 常量表按 IRConstantTable 的顺序排列，每种宽度汇总所有分片 */
+  IR_CACHE_CONSTANTS_I16,
+  IR_CACHE_CONSTANTS_I32,
+  IR_CACHE_CONSTANTS_I64,
+  IR_CACHE_CONSTANTS_F32,
+  IR_CACHE_CONSTANTS_F64,
+  IR_CACHE_UNDEFS,
+  IR_CONTEXT_NUM_CACHES
+} IRContextCache;
+
+/**
+ * @brief 一个 Context 的内存占用 (见 ir_context_memory_report)
+ */
+typedef struct IRContextMemoryReport
+{
+  /** 类型、驻留字符串、缓存的表和小整数常量表 */
+  BumpUsage permanent_arena;
+  /** 没有私有 Arena 的模块、函数和指令 */
+  BumpUsage ir_arena;
+  /** 所有常量分片的 Arena 之和 (常量表和其中的常量) */
+  BumpUsage constant_arenas;
+  /** 所有函数私有 Arena 之和 */
+  BumpUsage function_arenas;
+  size_t num_function_arenas;
+  /** 预先创建的小整数常量表占用的字节 (在 permanent_arena 中) */
+  size_t small_int_bytes;
+  HashMapStats caches[IR_CONTEXT_NUM_CACHES];
+} IRContextMemoryReport;
+
+/**
+ * @brief 统计 Context 的各个 Arena 和唯一化缓存的内存占用
+ *
+ * 需要遍历每个 Arena 的 Chunk 链表，开销与 Chunk 数成正比；不能在并发构建期间调用。
+ */
+void ir_context_memory_report(const IRContext *ctx, IRContextMemoryReport *report);
+
+/**
+ * @brief 缓存在报告中的名字 (例如 "constants.i32")
+ */
+const char *ir_context_cache_name(IRContextCache cache);
+
+/**
+ * @brief 以文本打印内存报告: 每个 Arena 的已用 / 保留字节，每个缓存的条目、桶、负载因子和墓碑
+ */
+void ir_context_print_memory_report(const IRContextMemoryReport *report, FILE *stream);
+
+/*
+ * =================================================================
+ * --- 并发构建 (Concurrent Construction) ---
+ * =================================================================
+ *
+ * 多个线程可以同时构建或变换*不同的*函数体 (例如并行解析、并行运行函数 Pass)：
+ * 1. 主线程调用 ir_context_begin_concurrent；
+ * 2. 每个工作线程调用 ir_context_enter_worker，此后该线程新建的 IR 对象
+ *    分配在它自己的 Arena 中，新驻留的字符串放在它自己的表中；
+ *    类型缓存由一把全局锁保护，常量缓存分成 IR_CONSTANT_CACHE_SHARDS 片、各有一把锁，
+ *    共享值 (常量、全局变量、函数) 的 Use 链表按值的地址分到 IR_USE_LOCK_STRIPES 把锁上；
+ * 3. 工作线程结束前调用 ir_context_leave_worker；
+ * 4. 所有工作线程结束后，主线程对每个 worker 调用 ir_context_adopt_worker，
+ *    然后调用 ir_context_end_concurrent。
+ *
+ * 并发期间不能在工作线程之外修改这个 Context，也不能改动模块的函数和全局变量链表。
+ * 替换共享值的所有使用 (ir_value_replace_all_uses_with) 会改写其他函数的操作数，
+ * 链表本身保持一致，但其他线程会看到它们的函数体被改动。
+ */
+
+/**
+ * @brief 一个工作线程的私有构建状态
+ */
+typedef struct IRContextWorker
+{
+  IRContext *context;
+  /** 该线程新建的 IR 对象 (adopt 时并入 ctx->ir_arena) */
+  Bump ir_arena;
+  /** 该线程新驻留的字符串 (adopt 时并入 ctx->permanent_arena) */
+  Bump string_arena;
+  /** 该线程新驻留、ctx 的驻留表中还没有的字符串 */
+  StrHashMap *strings;
+} IRContextWorker;
+
+/**
+ * @brief 进入并发构建模式 (在启动工作线程之前调用)
+ * @return bool 不支持线程 (__STDC_NO_THREADS__) 或 OOM 时返回 false
+ */
+bool ir_context_begin_concurrent(IRContext *ctx);
+
+/**
+ * @brief 退出并发构建模式 (所有 worker 都已 adopt 之后调用)
+ */
+void ir_context_end_concurrent(IRContext *ctx);
+
+/**
+ * @brief 在当前线程上开始作为 worker 构建 IR
+ * @return bool OOM 时返回 false
+ */
+bool ir_context_enter_worker(IRContext *ctx, IRContextWorker *worker);
+
+/**
+ * @brief 当前线程停止作为 worker (它创建的对象仍然有效)
+ */
+void ir_context_leave_worker(IRContextWorker *worker);
+
+/**
+ * @brief 把 worker 的 Arena 和驻留字符串并入 Context (在主线程上调用)
+ */
+void ir_context_adopt_worker(IRContext *ctx, IRContextWorker *worker);
+
+/**
+ * @brief 获取当前线程应该用来分配 IR 对象的 Arena
+ *
+ * 在 worker 线程上返回 worker 的 Arena，否则返回 &ctx->ir_arena。
+ */
+Bump *ir_context_ir_arena(IRContext *ctx);
+
+/**
+ * @brief 并发构建期间获取/释放共享锁 (不在并发模式时什么也不做；可重入)
+ */
+void ir_context_lock(IRContext *ctx);
+void ir_context_unlock(IRContext *ctx);
+
+/**
+ * @brief 修改 value 的 Use 链表之前需要持有的锁 (位掩码，每位是一条锁)
+ *
+ * value 不是共享值 (常量、全局变量、函数)，或者不在并发模式时返回 0。
+ * 涉及多个值时把各自的掩码按位或起来，一次 ir_context_lock_uses 全部获取：
+ * 锁总是按编号从小到大获取，所以不会死锁。
+ */
+uint64_t ir_context_use_lock_mask(IRContext *ctx, const IRValueNode *value);
+
+/**
+ * @brief 获取/释放 mask 中的 Use 链表锁 (mask 为 0 时什么也不做；不可重入)
+ */
+void ir_context_lock_uses(IRContext *ctx, uint64_t mask);
+void ir_context_unlock_uses(IRContext *ctx, uint64_t mask);
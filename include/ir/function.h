@@ -20,12 +20,26 @@
 #include "ir/printer.h"
 #include "ir/type.h"
 #include "ir/value.h"
+#include "utils/bump.h"
 #include "utils/id_list.h"
 
+typedef struct IRFunction IRFunction;
+
+/**
+ * @brief 延迟加载的函数体的构建函数 (见 ir_function_materialize)
+ *
+ * 由加载器安装 (例如 ir_parse_module_lazy)。它为 func 构建基本块，
+ * 成功时函数体必须已通过 ir_verify_function；失败时打印错误并返回 false。
+ *
+ * @param func 要物化的函数
+ * @param data 加载器记录的数据 (例如函数体在源码中的位置)
+ */
+typedef bool (*IRFunctionMaterializer)(IRFunction *func, void *data);
+
 /**
  * @brief 函数
  */
-typedef struct IRFunction
+struct IRFunction
 {
   IRValueNode entry_address;
   IRModule *parent;
@@ -42,7 +56,36 @@ typedef struct IRFunction
   /// 这将指向已链接的 CalicoHostFunction 包装器。
   /// 我们使用 void* 来避免 #include "interpreter.h" 造成的循环依赖。
   void *c_host_func_ptr;
-} IRFunction;
+
+  /// 延迟加载: 非 NULL 表示函数体还没有构建 (basic_blocks 为空)，
+  /// 第一次访问时由 ir_function_materialize 调用
+  IRFunctionMaterializer materializer;
+  void *materializer_data;
+
+  /// 函数体 (基本块、指令、Use 数组) 的私有 Arena；NULL 表示分配在 Context 的 IR Arena 中
+  /// (见 ir_function_use_private_arena)
+  struct IRFunctionArena *body_arena;
+
+  /// ir_function_reserve_body 预留、还没用完的函数体内存 [reserved_begin, reserved_end)
+  char *reserved_begin;
+  char *reserved_end;
+
+  /// 函数上次通过验证的级别；之后被修改过时为 IR_VERIFY_NONE
+  /// (见 ir_function_mark_modified、ir_verify_module_incremental)
+  IRVerifyLevel verified_level;
+};
+
+/**
+ * @brief 记录函数被修改了，下一次增量验证要重新检查它
+ *
+ * Builder 插入指令、ir_instruction_erase_from_parent、操作数的修改 (包括 RAUW)
+ * 和基本块的增删会自动调用它；直接改写指令字段或链表的代码需要自己调用。
+ */
+static inline void
+ir_function_mark_modified(IRFunction *func)
+{
+  func->verified_level = IR_VERIFY_NONE;
+}
 
 /**
  * @brief 函数参数
@@ -83,4 +126,84 @@ IRArgument *ir_argument_create(IRFunction *func, IRType *type, const char *name)
  */
 void ir_function_finalize_signature(IRFunction *func, bool is_variadic);
 
+/**
+ * @brief 函数体是否已经构建 (声明和普通创建的函数总是 true)
+ */
+bool ir_function_is_materialized(const IRFunction *func);
+
+/**
+ * @brief 构建延迟加载的函数体 (已构建时什么也不做)
+ *
+ * 解释器 (interpreter_run_function 等) 和 ir_verify_function 会自动调用它；
+ * 直接遍历 basic_blocks 的代码 (分析、变换) 需要先调用它。
+ * 失败时部分构建的函数体被丢弃，函数保持未物化状态。
+ *
+ * @return bool 函数体可用时返回 true
+ */
+bool ir_function_materialize(IRFunction *func);
+
+/**
+ * @brief 丢弃函数的所有基本块 (先解开指令对操作数的 Use)
+ *
+ * 函数有私有 Arena 时，函数体的内存随之释放 (只保留一个 Chunk 供重建时使用)；
+ * 否则内存仍属于 Context 的 IR Arena。函数的 is_declaration 不变。
+ */
+void ir_function_clear_body(IRFunction *func);
+
+/**
+ * @brief 把 src 的函数体复制到 dst 中 (内联等变换使用)
+ *
+ * 复制出的块插入在 insert_before 之前 (NULL 时追加到末尾)，顺序与 src 相同。
+ * remap 是旧 Value -> 新 Value 的表: 调用前放入 src 参数的替换值，返回时还包含 src 每个块和指令的克隆。
+ * 不在表中的操作数 (常量、全局变量、函数) 原样使用；名字也原样复制，需要时由调用者改名。
+ *
+ * @return 第一个复制出的块 (src 入口块的克隆)；src 没有函数体或 OOM 时返回 NULL
+ */
+IRBasicBlock *ir_function_clone_body_into(IRFunction *src, IRFunction *dst, IRBasicBlock *insert_before,
+                                          PtrHashMap *remap);
+
+/**
+ * @brief 让函数体分配在函数自己的 Arena 中
+ *
+ * 之后 ir_function_clear_body (以及物化失败、流式解析丢弃函数体) 会真正释放
+ * 函数体的内存，反复重建同一个函数不会让 Context 的 Arena 增长。
+ * 函数本身和参数仍在 Context 的 IR Arena 中；私有 Arena 随 Context 一起销毁
+ * (或随 ir_context_reset_ir_arena 释放)。
+ * 另见 ir_context_set_private_function_arenas。
+ *
+ * @pre 函数体为空 (还没有基本块)
+ * @return bool OOM 时返回 false (函数体继续使用 Context 的 Arena)
+ */
+bool ir_function_use_private_arena(IRFunction *func);
+
+/**
+ * @brief 获取分配函数体对象 (基本块、指令、Use 数组) 的 Arena
+ *
+ * 私有 Arena (如果有)，否则是 ir_context_ir_arena。
+ */
+Bump *ir_function_body_arena(IRFunction *func);
+
+/**
+ * @brief 一次性预留 num_instructions 条指令和共 num_operands 个操作数的函数体内存
+ *
+ * 预留的内存是函数体 Arena 中连续的一块 (一次 bump_alloc)。之后在这个函数中
+ * 创建的指令 (ir_function_alloc_instruction，Builder 的所有 create 函数) 依次从中
+ * 切出，直到剩下的放不下一条指令再回到逐条分配；phi 之后增长的 Use 数组不用预留。再次预留时，上一次剩下的部分被放弃 (留在 Arena 中)；
+ * ir_function_clear_body 也会放弃预留。
+ *
+ * @return bool OOM 时返回 false (之后照常逐条分配)
+ */
+bool ir_function_reserve_body(IRFunction *func, size_t num_instructions, size_t num_operands);
+
+/**
+ * @brief 分配一条指令和紧跟其后的 num_operands 个 Use 记录 (都清零)
+ *
+ * 有预留 (ir_function_reserve_body) 时从预留中切出，否则从函数体 Arena 分配。
+ * operands / operand_capacity 已指向这些 Use 记录，其余字段由调用者填写。
+ */
+struct IRInstruction *ir_function_alloc_instruction(IRFunction *func, size_t num_operands);
+
+/**
+ * @brief 打印函数 (延迟加载的函数体会先被物化)
+ */
 void ir_function_dump(IRFunction *func, IRPrinter *p);
@@ -20,6 +20,13 @@
 #include "ir/printer.h"
 #include "ir/value.h"
 #include "utils/id_list.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/** 重新编号时相邻指令顺序号的间隔 (留给之后的插入) */
+#define IR_INSTRUCTION_ORDER_STEP 1024
+
+typedef struct IRUse IRUse;
 
 typedef enum IROpcode
 {
@@ -129,8 +136,19 @@ typedef struct IRInstruction
   IDList list_node;
 
   IROpcode opcode;
-  IDList operands;
+  /**
+   * @brief 操作数的 Use 记录 (按操作数顺序连续存放)
+   *
+   * 创建时已知操作数个数的指令，记录紧跟在指令之后 (同一次分配)；
+   * phi / switch 增加操作数时换到 Arena 中一个更大的数组。
+   * 由 ir_use_create / ir_use_unlink 自动维护，ir_instruction_get_operand(inst, i) 为 O(1)。
+   */
+  IRUse *operands;
+  size_t num_operands;
+  size_t operand_capacity;
   IRBasicBlock *parent;
+  /** 块内顺序号 (只在 parent->order_valid 时有意义，见 ir_instruction_comes_before) */
+  uint64_t order;
   union {
 
     struct
@@ -148,9 +166,40 @@ typedef struct IRInstruction
       IRType *source_type;
       bool inbounds;
     } gep;
+
+    struct
+    {
+      /** 变换在一次运行中给 alloca 的临时编号 (例如 mem2reg 的稠密编号)；不属于 IR，不打印也不复制 */
+      uint32_t pass_index;
+    } alloca;
   } as;
 } IRInstruction;
 
+/**
+ * @brief 获取指令的操作数数量 (O(1))
+ */
+size_t ir_instruction_get_num_operands(const IRInstruction *inst);
+
+/**
+ * @brief 获取指令的第 N 个操作数的 Use 边 (O(1))
+ * @return IRUse* (如果越界则返回 NULL)
+ */
+IRUse *ir_instruction_get_operand_use(const IRInstruction *inst, size_t index);
+
+/**
+ * @brief 获取指令的第 N 个操作数 (O(1))
+ * @return IRValueNode* (如果越界则返回 NULL)
+ */
+IRValueNode *ir_instruction_get_operand(const IRInstruction *inst, size_t index);
+
+/**
+ * @brief 同一基本块中的 a 是否在 b 之前
+ *
+ * 均摊 O(1)：块的顺序号失效时先整块重新编号 (O(块大小))。
+ * @pre a->parent == b->parent
+ */
+bool ir_instruction_comes_before(IRInstruction *a, IRInstruction *b);
+
 /**
  * @brief 从其父基本块中安全地擦除一条指令
  */
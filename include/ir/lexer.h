@@ -156,12 +156,20 @@ typedef enum
  * @brief 词法单元 (Token) 结构体
  *
  * 存储类型和（如果适用）解析好的值。
+ *
+ * 标识符的文本是 as.ident_val 开始的 ident_len 个字节：
+ * - TK_IDENT / TK_GLOBAL_IDENT / TK_STRING_LITERAL: 驻留在 IRContext 中的 C 字符串
+ * - TK_LOCAL_IDENT / TK_LABEL_IDENT: 指向源码的切片 (不以 '\0' 结尾，不驻留)，
+ *   只在源码有效期间可用；需要长期保存时由使用者驻留
+ * 对这些 Token，ident_hash 是文本的 str_hashmap_hash，可直接传给 *_hashed 系列函数。
  */
 typedef struct Token
 {
   TokenType type;
   size_t line;
   size_t column;
+  size_t ident_len;
+  uint64_t ident_hash;
 
   union {
 
@@ -182,6 +190,8 @@ typedef struct Lexer
 {
   IRContext *context;
   const char *buffer_start;
+  /** 源码末尾 (不含)；词法分析从不读取它及之后的字节 */
+  const char *buffer_end;
   const char *ptr;
   const char *line_start;
   int line;
@@ -198,6 +208,15 @@ typedef struct Lexer
  */
 void ir_lexer_init(Lexer *lexer, const char *buffer, IRContext *ctx);
 
+/**
+ * @brief 在一段源码切片上初始化 Lexer
+ * @param lexer Lexer 实例
+ * @param buffer .cir 源码 (不需要以 '\0' 结尾，例如映射的文件；解析期间必须保持有效)
+ * @param len 源码长度 (字节)
+ * @param ctx IR 上下文 (用于字符串驻留)
+ */
+void ir_lexer_init_slice(Lexer *lexer, const char *buffer, size_t len, IRContext *ctx);
+
 /**
  * @brief "吃掉" 当前 Token，并让 Lexer 解析下一个 Token。
  *
@@ -47,23 +47,85 @@ typedef struct IRModule
  */
 IRModule *ir_module_create(IRContext *ctx, const char *name);
 
+/**
+ * @brief 在同一个 Context 中深拷贝一个模块
+ *
+ * 全局变量、函数、参数、基本块、指令和 Use 边都被复制 (按结构体复制，不经过打印和解析)，
+ * 操作数重映射到克隆出的对象；类型、常量和驻留的名字是 Context 中唯一化的不可变对象，
+ * 直接共享。克隆与源模块互不影响 (修改一个不会改变另一个)。
+ * 延迟加载的函数体会先被物化。源函数有私有 Arena 时，克隆出的函数也有。
+ *
+ * @param src 源模块
+ * @param name 新模块的名字 (NULL 表示沿用 src 的名字)
+ * @return IRModule* 新模块；物化失败或 OOM 时返回 NULL (可能留下部分构建的模块)
+ */
+IRModule *ir_module_clone(IRModule *src, const char *name);
+
+/**
+ * @brief 物化模块中所有延迟加载的函数体 (见 ir_function_materialize)
+ *
+ * @return bool 所有函数体都可用时返回 true
+ */
+bool ir_module_materialize_all(IRModule *mod);
+
 /**
  * @brief [策略 1] 将模块的 IR 打印到指定的流 (例如 stdout)
  * (这是旧的 ir_module_dump)
+ * 输出经过打印机自己的缓冲区 (ir_printer_init_file_buffered)，返回前全部交给 stream。
  */
 void ir_module_dump_to_file(IRModule *mod, FILE *stream);
 
 /**
  * @brief [策略 2] 将模块的 IR 打印到 arena 上的新字符串
  *
+ * 先在临时 Arena 上打印到 StringRope，再一次复制到 arena:
+ * arena 中只留下长度准确的字符串，打印期间的峰值约为文本的两倍。
+ * 不需要连续的字符串时 (例如写入文件)，ir_module_dump_to_rope 省掉这一次复制。
+ *
  * @param mod 要打印的模块
  * @param arena 用于分配字符串的 Bump arena
- * @return const char* 指向 arena 上的、以 '\0' 结尾的字符串
+ * @return const char* 指向 arena 上的、以 '\0' 结尾的字符串；OOM 时返回 NULL
  */
 const char *ir_module_dump_to_string(IRModule *mod, Bump *arena);
 
+/**
+ * @brief [策略 4] 将模块的 IR 追加到 rope (文本按 chunk 存放在 rope 的 Arena 上，从不复制)
+ *
+ * 之后可以用 string_rope_write / string_rope_writev 直接写出，
+ * 或用 string_rope_flatten 得到连续的字符串。
+ */
+void ir_module_dump_to_rope(IRModule *mod, StringRope *rope);
+
 /**
  * @brief [内部机制] 核心 dump 函数。
  * (除非你正在实现一个新的 IRPrinter 策略，否则不应直接调用)
  */
 void ir_module_dump_internal(IRModule *mod, IRPrinter *p);
+
+/**
+ * @brief 并行打印: 与 ir_module_dump_internal 输出逐字节相同
+ *
+ * 先在调用线程上物化所有延迟加载的函数体，然后由 num_threads 个线程 (包括调用线程)
+ * 把每个函数分别打印到自己的 StringBuf，最后按模块顺序把它们依次交给 p。
+ * 打印期间整个模块的文本都在内存中。
+ * p 的注解钩子会在 worker 线程上被并发调用 (它们只应读取 IR)。
+ * 打印期间不要修改模块或 Context。
+ *
+ * @param num_threads 线程数 (0 或 1 时等同于 ir_module_dump_internal；不支持线程时也是如此)
+ */
+void ir_module_dump_internal_parallel(IRModule *mod, IRPrinter *p, size_t num_threads);
+
+/**
+ * @brief ir_module_dump_to_file 的并行版本 (见 ir_module_dump_internal_parallel)
+ */
+void ir_module_dump_to_file_parallel(IRModule *mod, FILE *stream, size_t num_threads);
+
+/**
+ * @brief ir_module_dump_to_string 的并行版本 (见 ir_module_dump_internal_parallel)
+ */
+const char *ir_module_dump_to_string_parallel(IRModule *mod, Bump *arena, size_t num_threads);
+
+/**
+ * @brief ir_module_dump_to_rope 的并行版本 (见 ir_module_dump_internal_parallel)
+ */
+void ir_module_dump_to_rope_parallel(IRModule *mod, StringRope *rope, size_t num_threads);
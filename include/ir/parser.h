@@ -25,6 +25,37 @@
 #include "utils/bump.h"
 #include "utils/hashmap.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief 流式解析时，回调对刚解析完的函数的处理方式
+ */
+typedef enum IRStreamAction
+{
+  /** 保留函数体 (它会留在返回的模块中) */
+  IR_STREAM_KEEP,
+  /** 丢弃函数体并回收其内存；函数变为声明，之后的函数仍然可以调用它 */
+  IR_STREAM_DISCARD,
+} IRStreamAction;
+
+/**
+ * @brief 流式解析的函数回调：每个 `define` 解析完成后调用一次
+ *
+ * 此时函数体已完整 (尚未经过验证器)，后面的顶层元素还没有解析。
+ * 回调可以验证 (ir_verify_function)、解释执行或分析它，再决定保留还是丢弃。
+ *
+ * @param func 刚解析完的函数
+ * @param user_data 传给 ir_parse_module_stream 的 user_data
+ */
+typedef IRStreamAction (*IRStreamFunctionCallback)(IRFunction *func, void *user_data);
+
+/**
+ * @brief 流式解析的输入回调：向 buffer 写入至多 capacity 字节
+ *
+ * @return size_t 写入的字节数；返回 0 表示输入结束
+ */
+typedef size_t (*IRStreamReader)(void *reader_data, char *buffer, size_t capacity);
 
 /**
  * @brief Parser 状态机
@@ -52,14 +83,19 @@ typedef struct Parser
 
   /**
    * @brief 临时分配器。
-   * 用于分配 Parser 的临时数据，例如：
-   * 1. 当前函数的 local_value_map。
-   * 2. 解析 GEP 或 Call 指令时的临时参数数组。
+   * 用于分配 Parser 的临时数据，例如解析 GEP 或 Call 指令时的临时参数数组。
    *
-   * 它在进入新函数时被重置 (bump_reset)。
+   * 它在解析每个这样的列表之前都会被重置 (bump_reset)，
+   * 因此不能存放跨指令存活的数据。
    */
   Bump temp_arena;
 
+  /**
+   * @brief 局部符号表的分配器 (只存放 local_value_map 及其键)。
+   * 它只在需要重建局部符号表时被重置 (见 local_map_cache)。
+   */
+  Bump local_arena;
+
   /**
    * @brief 全局符号表 (值映射)。
    * Map<const char* (interned), IRValueNode*>
@@ -70,11 +106,29 @@ typedef struct Parser
 
   /**
    * @brief 局部符号表 (值映射)。
-   * Map<const char* (interned), IRValueNode*>
-   * 存储 %locals, %args, 和 %labels。
-   * 在进入函数时创建 (在 temp_arena 上)，在退出函数时销毁。
+   * Map<源码切片, IRValueNode*>
+   * 存储 %locals, %args, 和 %labels。局部名的 Token 是源码切片 (见 Token)，
+   * 查找时不需要先驻留；只有被定义的名字才驻留为值的名字。
+   * 在进入函数时就绪 (在 local_arena 上)，在退出函数时置为 NULL。
+   */
+  StrHashMap *local_value_map;
+
+  /**
+   * @brief 跨函数复用的局部符号表。
+   * 进入新函数时把它清空 (不分配内存) 作为 local_value_map；
+   * 上一个函数让它增长得过大时才重置 local_arena 并重新创建。
    */
-  PtrHashMap *local_value_map;
+  StrHashMap *local_map_cache;
+
+  /** @brief 流式解析的函数回调 (普通解析时为 NULL)。*/
+  IRStreamFunctionCallback on_function;
+  void *on_function_data;
+
+  /**
+   * @brief 当前函数体开始时 ir_arena 的位置。
+   * 回调丢弃函数时回退到这里，回收函数体占用的内存。
+   */
+  BumpMark body_mark;
 
   /** @brief 错误标志。如果解析过程中发生错误，则设置为 true。*/
   bool has_error;
@@ -104,3 +158,87 @@ typedef struct Parser
  * @return NULL 如果解析失败 (例如语法错误)。
  */
 IRModule *ir_parse_module(IRContext *ctx, const char *source_buffer);
+
+/**
+ * @brief 解析一个 .cir 文件
+ *
+ * 文件被只读映射进内存 (见 utils/mapped_file.h)，词法分析直接在映射上进行，
+ * 不会先复制到堆上；模块中的名字都驻留在 ctx 中，因此返回时映射已经解除。
+ *
+ * @param ctx 全局 IR 上下文
+ * @param path 文件路径
+ * @return IRModule* 成功时返回新模块；文件无法读取或解析失败时返回 NULL
+ */
+IRModule *ir_parse_module_file(IRContext *ctx, const char *path);
+
+/**
+ * @brief 并行解析一个完整的 IR 模块
+ *
+ * 分两个阶段：调用线程先按顶层边界切分源码，解析类型定义、全局变量、声明和所有函数头；
+ * 然后由 num_threads 个线程 (包括调用线程) 并行解析函数体，每个线程有自己的
+ * 局部符号表和 Arena (见 ir_context_begin_concurrent)，最后并入 ctx。
+ * 结果与 ir_parse_module 相同，但所有全局符号在解析任何函数体之前都已登记，
+ * 所以函数体可以引用定义在它后面的函数和全局变量。
+ *
+ * 函数体的 '}' 之后，下一个顶层元素必须另起一行 (打印器的输出总是如此)。
+ * 解析期间不能在其他线程上使用 ctx。
+ *
+ * @param ctx 全局 IR 上下文
+ * @param source_buffer 包含要解析的 IR 文本的 C 字符串
+ * @param num_threads 线程数 (0 或 1 时在调用线程上依次解析函数体；不支持线程时也是如此)
+ * @return IRModule* 成功时返回新模块；解析或验证失败时返回 NULL
+ */
+IRModule *ir_parse_module_parallel(IRContext *ctx, const char *source_buffer, size_t num_threads);
+
+/**
+ * @brief 并行解析一个 .cir 文件 (映射方式同 ir_parse_module_file)，参见 ir_parse_module_parallel
+ */
+IRModule *ir_parse_module_file_parallel(IRContext *ctx, const char *path, size_t num_threads);
+
+/**
+ * @brief 延迟解析一个完整的 IR 模块
+ *
+ * 只解析类型定义、全局变量、声明和函数头 (方式同 ir_parse_module_parallel 的第一阶段)，
+ * 每个函数体只记下它在源码中的位置。函数体在第一次被需要时才解析并验证：
+ * ir_function_materialize、ir_verify_function / ir_verify_module、
+ * 解释器的 interpreter_run_function 和 ir_function_dump 都会触发。
+ * 分析和变换在访问函数体之前需要先调用 ir_function_materialize (或 ir_module_materialize_all)。
+ *
+ * 与 ir_parse_module 不同，source_buffer 被借用而不是复制：
+ * 它必须在所有函数体物化之前保持有效且不被修改。
+ * 函数体的语法或验证错误在物化时报告，该函数保持未物化状态。
+ *
+ * @param ctx 全局 IR 上下文
+ * @param source_buffer 包含要解析的 IR 文本的 C 字符串 (被借用)
+ * @return IRModule* 成功时返回新模块 (不运行模块验证)；顶层解析失败时返回 NULL
+ */
+IRModule *ir_parse_module_lazy(IRContext *ctx, const char *source_buffer);
+
+/**
+ * @brief 流式解析一个模块
+ *
+ * 从 reader 分块读取源码，每次只对完整的顶层元素 (define / declare / 全局变量 / 类型定义)
+ * 做词法和语法分析，读缓冲区只需容纳最大的那个顶层元素。每个函数定义解析完成后交给
+ * on_function；返回 IR_STREAM_DISCARD 的函数体会立即被回收，因此在全部丢弃时，
+ * 内存占用取决于最大的函数而不是整个模块。
+ *
+ * 函数体被丢弃后，后面的函数仍然可以调用它 (它变为声明)。
+ * 如果回调用解释器执行过某个函数，丢弃它之后不要再用同一个解释器执行这个模块。
+ *
+ * @param ctx 全局 IR 上下文
+ * @param reader 输入回调
+ * @param reader_data 传给 reader 的指针
+ * @param on_function 函数回调 (可以为 NULL，此时保留所有函数)
+ * @param user_data 传给 on_function 的指针
+ * @return IRModule* 成功时返回模块 (只含被保留的函数体)；解析或验证失败时返回 NULL
+ */
+IRModule *ir_parse_module_stream(IRContext *ctx, IRStreamReader reader, void *reader_data,
+                                 IRStreamFunctionCallback on_function, void *user_data);
+
+/**
+ * @brief 从一个已打开的文件 (或管道) 流式解析模块，参见 ir_parse_module_stream
+ *
+ * @return IRModule* 成功时返回模块；读取出错、解析或验证失败时返回 NULL
+ */
+IRModule *ir_parse_module_stream_file(IRContext *ctx, FILE *stream, IRStreamFunctionCallback on_function,
+                                      void *user_data);
@@ -17,15 +17,42 @@
 #pragma once
 
 #include "utils/string_buf.h"
+#include "utils/string_rope.h"
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
+/** @brief 缓冲文件策略的输出缓冲区大小 (字节) */
+#define IR_PRINTER_BUFFER_SIZE ((size_t)256 * 1024)
+
+typedef struct IRPrinter IRPrinter;
+typedef struct IRFunction IRFunction;
+typedef struct IRBasicBlock IRBasicBlock;
+
+/**
+ * @brief 打印注解钩子 (可选)。
+ *
+ * 让打印机的使用者在不修改 dump 函数的前提下，在输出的 IR 中插入额外信息
+ * (例如解释器的 profile 数据)。钩子应只输出 ';' 注释，使结果仍能被解析。
+ * 每个钩子都可以为 NULL。
+ */
+typedef struct IRPrinterAnnotator
+{
+  void *user_data;
+
+  /** @brief 在函数的 'define' / 'declare' 行之前调用 (应输出完整的行) */
+  void (*annotate_function)(void *user_data, IRFunction *func, IRPrinter *p);
+
+  /** @brief 在基本块标签之后、换行之前调用 (应输出行尾注释) */
+  void (*annotate_block)(void *user_data, IRBasicBlock *bb, IRPrinter *p);
+} IRPrinterAnnotator;
+
 /**
  * @brief IR 打印机 (机制)。
  * 这是一个抽象，用于将所有 ir_..._dump 函数与
  * 它们的输出目标（策略）分离。
  */
-typedef struct IRPrinter
+struct IRPrinter
 {
 
   void *target;
@@ -33,7 +60,19 @@ typedef struct IRPrinter
   void (*append_str_func)(void *target, const char *str);
 
   void (*append_vfmt_func)(void *target, const char *fmt, va_list args);
-} IRPrinter;
+
+  /** @brief 附加 len 个字节 (不要求 '\0' 结尾；不解析格式串) */
+  void (*append_mem_func)(void *target, const char *data, size_t len);
+
+  /** @brief 写出缓冲的输出 (只有缓冲策略设置；其它策略为 NULL) */
+  void (*flush_func)(void *target);
+
+  /** @brief 释放策略持有的资源 (只有缓冲策略设置；其它策略为 NULL) */
+  void (*destroy_func)(void *target);
+
+  /** @brief 注解钩子 (借用；默认为 NULL) */
+  const IRPrinterAnnotator *annotator;
+};
 
 /*
  * --- 策略 API ---
@@ -49,6 +88,42 @@ void ir_printer_init_file(IRPrinter *p, FILE *f);
  */
 void ir_printer_init_string_buf(IRPrinter *p, StringBuf *buf);
 
+/**
+ * @brief 策略 3: 初始化打印机以缓冲写入 FILE*
+ *
+ * 输出先追加到打印机自己的 IR_PRINTER_BUFFER_SIZE 字节缓冲区，
+ * 缓冲区满、ir_printer_flush 或 ir_printer_destroy 时一次 fwrite 写出。
+ * 用完后必须调用 ir_printer_destroy (否则最后一段输出会丢失)。
+ * 打印期间不要直接写 f，否则输出顺序会交错。
+ * (如果缓冲区分配失败，退化为策略 1)
+ */
+void ir_printer_init_file_buffered(IRPrinter *p, FILE *f);
+
+/**
+ * @brief 策略 4: 初始化打印机以写入 StringRope*
+ *
+ * 与策略 2 相同，但输出按 chunk 存放，已经写入的文本从不复制 (见 utils/string_rope.h)。
+ */
+void ir_printer_init_string_rope(IRPrinter *p, StringRope *rope);
+
+/**
+ * @brief 写出缓冲策略中尚未写出的输出 (不会 fflush 底层的 FILE*)。
+ * 其它策略下什么也不做。
+ */
+void ir_printer_flush(IRPrinter *p);
+
+/**
+ * @brief 写出剩余的输出并释放策略持有的资源。
+ * 其它策略下什么也不做；之后不能再使用 p (除非重新初始化)。
+ */
+void ir_printer_destroy(IRPrinter *p);
+
+/**
+ * @brief 为打印机设置注解钩子 (传 NULL 清除)。
+ * 打印机只借用 annotator，它必须在打印期间保持有效。
+ */
+void ir_printer_set_annotator(IRPrinter *p, const IRPrinterAnnotator *annotator);
+
 /*
  * --- 机制 API (供 dump 函数使用) ---
  */
@@ -64,3 +139,40 @@ void ir_print_str(IRPrinter *p, const char *str);
  * (等同于 fprintf(f, "...", ...))
  */
 void ir_printf(IRPrinter *p, const char *fmt, ...);
+
+/*
+ * --- 快速路径 (不解析格式串) ---
+ */
+
+/**
+ * @brief 机制：附加 len 个字节
+ */
+void ir_print_mem(IRPrinter *p, const char *data, size_t len);
+
+/**
+ * @brief 机制：附加一个字符
+ */
+void ir_print_char(IRPrinter *p, char c);
+
+/**
+ * @brief 机制：附加一个有符号十进制整数 (等同于 "%" PRId64)
+ */
+void ir_print_int(IRPrinter *p, int64_t value);
+
+/**
+ * @brief 机制：附加一个无符号十进制整数 (等同于 "%" PRIu64)
+ */
+void ir_print_uint(IRPrinter *p, uint64_t value);
+
+/**
+ * @brief 机制：附加一个浮点数
+ *
+ * 输出能精确还原 value 的最短十进制形式，并且总是 .cir 浮点字面量的写法
+ * ([-]数字.数字，没有指数)，例如 1.0、-0.5、0.1。NaN 与无穷打印为 nan / inf / -inf。
+ */
+void ir_print_float(IRPrinter *p, double value);
+
+/**
+ * @brief 机制：附加一个带前缀的名字 (例如 sigil 为 '%' 时等同于 "%%%s")
+ */
+void ir_print_name(IRPrinter *p, char sigil, const char *name);
@@ -19,6 +19,7 @@
 #include "ir/printer.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct IRContext IRContext;
 
@@ -49,6 +50,8 @@ typedef struct IRType IRType;
 struct IRType
 {
   IRTypeKind kind;
+  /** 创建它的 IRContext 的编号 (见 IRContext::id)，让按地址缓存的表能区分被复用的地址 */
+  uint32_t context_id;
 
   union {
 
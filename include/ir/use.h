@@ -26,9 +26,11 @@
  *
  * 代表一个 "User" (例如一条指令) 对一个 "Value" (例如 %a) 的使用。
  *
- * 它同时存在于两个链表中：
- * 1. Value 的 "uses" 链表 (通过 value_node)
- * 2. User 的 "operands" 链表 (通过 user_node)
+ * Use 记录按操作数顺序连续存放在 User 的 operands 数组中 (见 IRInstruction)，
+ * 同时通过 value_node 链入 Value 的 "uses" 链表。
+ *
+ * 注意: 操作数数组增长或中间的操作数被移除时，Use 记录会被搬动，
+ * 所以不要跨越这些操作持有 IRUse* (Value->uses 链表会自动修复)。
  */
 typedef struct IRUse
 {
@@ -39,25 +41,27 @@ typedef struct IRUse
 
   /** 在 Value->uses 链表中的节点 */
   IDList value_node;
-  /** 在 User->operands 链表中的节点 */
-  IDList user_node;
 
 } IRUse;
 
 /**
- * @brief [内部] 创建一个 Use 边 (在 Arena 中)
+ * @brief [内部] 为 User 追加一个操作数
  *
- * 这将自动将 Use 边添加到 Value 和 User 的链表中。
+ * Use 记录放在 user 的 operands 数组末尾 (容量不够时在 Arena 中换一个 2 倍大的数组)，
+ * 并链入 Value 的 uses 链表。
  *
  * @param ctx Context (用于 Arena 分配)
  * @param user 使用此 Value 的指令
  * @param value 被使用的 Value
- * @return 指向新 IRUse 的指针 (或 OOM 时返回 NULL)
+ * @return 指向新 IRUse 的指针 (或 OOM 时返回 NULL)；下一次增长之前有效
  */
 IRUse *ir_use_create(IRContext *ctx, IRInstruction *user, IRValueNode *value);
 
 /**
- * @brief [内部] 将 Use 边从两个链表中完全解开
+ * @brief [内部] 从 User 中移除一个操作数，并把它从 Value 的 uses 链表中解开
+ *
+ * 后面的操作数前移一位 (保持顺序)。移除最后一个操作数是 O(1)。
+ *
  * @param use 要解开的 Use 边
  */
 void ir_use_unlink(IRUse *use);
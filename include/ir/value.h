@@ -20,6 +20,8 @@
 #include "ir/type.h"
 #include "utils/id_list.h"
 
+typedef struct PtrHashMap PtrHashMap;
+
 /**
  * @brief 区分 IRValueNode 到底“是”什么
  *
@@ -87,3 +89,16 @@ void ir_value_set_name(IRValueNode *val, const char *name);
  * @param new_val 替换后的新 Value
  */
 void ir_value_replace_all_uses_with(IRValueNode *old_val, IRValueNode *new_val);
+
+/**
+ * @brief 批量替换: 对 replacements 中的每一项 (IRValueNode* -> IRValueNode*)，
+ * 把所有对 Key 的使用替换为 Value
+ *
+ * Value 本身也可以是另一项的 Key (例如 mem2reg 中一个 load 被另一个待删除的 load 替换)，
+ * 这时按链解析到最终的值 (链不能成环)。每个被替换的 Value 的 uses 链表只整体搬动一次，
+ * 总开销是 O(项数 + 被改写的 Use 数)。
+ * 解析时会把 replacements 中的 Value 改写为最终的值。
+ *
+ * @param replacements 替换表 (Key: 被替换的 Value，Value: 替换后的 Value)
+ */
+void ir_value_replace_all_uses_with_map(PtrHashMap *replacements);
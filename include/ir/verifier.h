@@ -16,15 +16,18 @@
 
 #pragma once
 
+#include "analysis/analysis_manager.h"
 #include "ir/function.h"
 #include "ir/module.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @brief 验证一个完整的 IRModule.
  *
  * 遍历模块中的所有函数、基本块和指令，检查其是否符合 IR 规则。
  * 如果发现错误，将向 stderr 打印详细的错误信息。
+ * 检查级别取自模块的 Context (见 ir_context_set_verify_level)。
  *
  * @param mod 要验证的模块。
  * @return 如果模块是良构的 (well-formed)，返回 true；否则返回 false。
@@ -36,8 +39,63 @@ bool ir_verify_module(IRModule *mod);
  *
  * 遍历函数中的所有基本块和指令，检查其是否符合 IR 规则。
  * 如果发现错误，将向 stderr 打印详细的错误信息。
+ * 延迟加载的函数体会先被物化 (见 ir_function_materialize)。
+ * 检查级别取自函数所在的 Context (见 ir_context_set_verify_level)。
  *
  * @param func 要验证的函数。
  * @return 如果函数是良构的 (well-formed)，返回 true；否则返回 false。
  */
 bool ir_verify_function(IRFunction *func);
+
+/**
+ * @brief 与 ir_verify_function 相同，但支配树取自分析管理器的缓存。
+ *
+ * 没有缓存时计算出的结果留在 am 中，之后的变换可以直接使用。
+ * 调用者要保证缓存没有过期 (修改函数之后已经调用过 ir_analysis_invalidate)。
+ */
+bool ir_verify_function_with_analyses(IRFunction *func, IRAnalysisManager *am);
+
+/**
+ * @brief 与 ir_verify_module 相同，但每个函数的支配树取自分析管理器的缓存。
+ */
+bool ir_verify_module_with_analyses(IRModule *mod, IRAnalysisManager *am);
+
+/**
+ * @brief 以指定的级别验证模块，不管 Context 的设置 (例如加载时只做结构检查，CI 中再做一次完整检查)。
+ */
+bool ir_verify_module_level(IRModule *mod, IRVerifyLevel level);
+
+/**
+ * @brief 以指定的级别验证函数，不管 Context 的设置。
+ */
+bool ir_verify_function_level(IRFunction *func, IRVerifyLevel level);
+
+/**
+ * @brief 函数在上次修改之后是否已经以不低于 Context 级别的检查通过了验证。
+ */
+bool ir_function_is_verified(const IRFunction *func);
+
+/**
+ * @brief 与 ir_verify_module 相同，但跳过上次通过验证之后没有被修改的函数。
+ *
+ * 每次验证通过都会记录在 func->verified_level 中；Builder、ir_instruction_erase_from_parent、
+ * 操作数的修改 (包括 RAUW) 和基本块的增删会清除它 (见 ir_function_mark_modified)。
+ * 以结构级别通过的函数在完整级别下仍会重新检查。模块本身和全局变量总是重新检查。
+ * 直接改写指令字段或链表而不经过这些 API 的代码必须自己调用 ir_function_mark_modified，否则修改会被漏掉。
+ */
+bool ir_verify_module_incremental(IRModule *mod);
+
+/**
+ * @brief ir_verify_module_incremental 的分析管理器版本 (见 ir_verify_module_with_analyses)。
+ */
+bool ir_verify_module_incremental_with_analyses(IRModule *mod, IRAnalysisManager *am);
+
+/**
+ * @brief 与 ir_verify_module 相同，但函数在 num_threads 个线程上并行验证 (调用线程是其中之一)。
+ *
+ * 每个函数的错误信息先写到线程私有的缓冲区，最后只打印模块中第一个出错的函数的，
+ * 所以输出与 ir_verify_module 相同，与线程的调度无关。延迟加载的函数体先在调用线程上物化。
+ * 调用期间不要在其他线程上修改模块。
+ * num_threads 为 0 或 1，或者平台没有 <threads.h> 时，等同于 ir_verify_module。
+ */
+bool ir_verify_module_parallel(IRModule *mod, size_t num_threads);
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 执行激进的死代码删除 (Aggressive Dead Code Elimination)。
+ *
+ * 先假设所有指令都是死的，从有副作用的指令 (store、call、终结指令) 出发，沿操作数标记活的指令；
+ * 没有被标记的指令全部删除。与只删除没有 Use 的指令相比，它还能删掉只互相使用的死环
+ * (例如只被自己的回边使用的循环 phi)。
+ *
+ * 不删除 call (即使被调者是纯函数，它也可能不终止)，也不改动控制流。
+ *
+ * @param func 要变换的函数
+ * @return 如果删除了指令则返回 true，否则返回 false
+ */
+bool ir_transform_dce_run(IRFunction *func);
+
+/** @brief DCE 保留的分析: 它只删除非终结指令，不改控制流 */
+#define IR_TRANSFORM_DCE_PRESERVES IR_PRESERVE_CFG_ANALYSES
+
+/**
+ * @brief 与 ir_transform_dce_run 相同，修改了 IR 时按 IR_TRANSFORM_DCE_PRESERVES 让其余的分析失效
+ */
+bool ir_transform_dce_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "analysis/dom_tree.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 执行基于支配树的全局值编号 (Global Value Numbering, GVN) / 公共子表达式消除。
+ *
+ * 按支配树先序访问可达的块，用 GenericHashMap 按 (操作码, 结果类型, 谓词等属性, 操作数) 给纯运算编号；
+ * 如果支配它的某条指令已经算过同一个表达式，就用那条指令替换它 (RAUW) 并删除。
+ * 可交换的运算 (add、mul、and、or、xor、fadd、fmul 和 eq / ne 比较) 不区分操作数顺序。
+ *
+ * 参与编号的是算术、位运算、比较、类型转换、select 和 gep；load、call、alloca、phi 不参与。
+ *
+ * @param func 要变换的函数
+ * @param dt 此函数的支配树
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_gvn_run(IRFunction *func, DominatorTree *dt);
+
+/** @brief GVN 保留的分析: 它只删除非终结指令，不改控制流 */
+#define IR_TRANSFORM_GVN_PRESERVES IR_PRESERVE_CFG_ANALYSES
+
+/**
+ * @brief 与 ir_transform_gvn_run 相同，但支配树取自分析管理器，
+ * 修改了 IR 时再按 IR_TRANSFORM_GVN_PRESERVES 让其余的分析失效
+ */
+bool ir_transform_gvn_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 内联的代价模型
+ */
+typedef struct IRInlineParams
+{
+  /** 被调者最多有多少条指令时内联 */
+  size_t max_callee_insts;
+  /** 热的被调者 (见 profile) 使用的更宽的上限 */
+  size_t hot_max_callee_insts;
+  /** 被调者在 profile 中至少被调用这么多次时算作热的 */
+  uint64_t hot_call_threshold;
+  /** 内联之后调用者最多有多少条指令 (防止代码膨胀) */
+  size_t max_caller_insts;
+  /**
+   * (可选) 开启过 profiling 的解释器 (interpreter_set_profiling)。
+   * 它按函数统计调用次数 (interpreter_profile_get_calls)，不区分调用点；为 NULL 时所有被调者都按冷的处理
+   */
+  Interpreter *profile;
+} IRInlineParams;
+
+/**
+ * @brief 用默认的代价模型初始化 params (小于 32 条指令的被调者；热的被调者 256 条)
+ */
+void ir_inline_params_init(IRInlineParams *params);
+
+/**
+ * @brief 把一个调用点内联: 被调者的函数体复制到调用处
+ *
+ * 调用所在的块在调用之后被分开；复制出的函数体中参数换成实参，ret 改成跳到后半块的 br，
+ * 多个 ret 的返回值在后半块开头用 phi 合并。被调者入口块中的 alloca 移到调用者的入口块，
+ * 在循环中内联也不会让栈增长。复制出的值和块的名字加上 ".i<N>" 后缀。
+ *
+ * 不内联: 间接调用、调用外部声明、递归调用 (被调者就是调用者)、可变参数函数，
+ * 以及入口块有前驱的被调者。
+ *
+ * @param call IR_OP_CALL 指令 (成功时被删除)
+ * @return 内联了时返回 true；不能内联或 OOM 时返回 false (IR 不变)
+ */
+bool ir_transform_inline_call(IRInstruction *call);
+
+/**
+ * @brief 按 params 的代价模型内联模块中的调用
+ *
+ * 沿调用图自底向上处理 (被调者先于调用者)，所以被调者自己的小调用已经被内联过了。
+ * 每个函数只考虑运行前已有的调用点，内联进来的调用不会在同一次运行中继续展开。
+ *
+ * @param params 代价模型 (NULL 时使用 ir_inline_params_init 的默认值)
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_inline_run(IRModule *mod, const IRInlineParams *params);
+
+/**
+ * @brief 与 ir_transform_inline_run 相同 (默认的代价模型)，修改了 IR 时模块中所有函数的分析都失效
+ *
+ * 它会读其他函数的函数体，所以只能作为模块 pass 运行 (签名与 IRModulePassFn 相同)。
+ */
+bool ir_transform_inline_run_with_analyses(IRModule *mod, IRAnalysisManager *am);
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 执行窥孔优化 (InstCombine): 代数化简、强度削减和操作数规范化。
+ *
+ * 每个操作码有一张规则表，按顺序尝试，第一条成立的规则生效；被改写的指令的使用者重新进入工作表。
+ * - 常量折叠: 操作数都是常量时由 interpreter_fold_instruction 求值 (与解释器逐位相同)
+ * - 规范化: 可交换运算 (add / mul / and / or / xor) 和 icmp 的常量操作数换到右边
+ *   (icmp 同时交换谓词)，sub x, C 改成 add x, -C，让 GVN 找到更多相同的表达式
+ * - 代数恒等式: x+0、x*1、x*0、x-x、x&x、x|0、x^x、移位 0 位、除以 1、icmp x, x、
+ *   fmul x, 1.0、fsub x, 0.0 等
+ * - 连续的类型转换: trunc(zext/sext x)、zext(zext x)、sext(sext x)、sext(zext x)、
+ *   trunc(trunc x)、bitcast(bitcast x)
+ * - select: 条件是常量或两个值相同
+ * - 强度削减: mul / udiv / urem 2^k 换成 shl / lshr / and；sdiv / srem 2^k 换成移位序列
+ *   (先给负数加上 2^k-1，使结果向零取整)
+ *
+ * 有规则的操作码都没有副作用，它们的指令在没有使用者时直接删除 (操作数随后也会被检查)。
+ * 不改动控制流、内存操作、phi 和 call。
+ *
+ * @param func 要变换的函数
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_instcombine_run(IRFunction *func);
+
+/** @brief InstCombine 保留的分析: 它只替换非终结指令，不改控制流 */
+#define IR_TRANSFORM_INSTCOMBINE_PRESERVES IR_PRESERVE_CFG_ANALYSES
+
+/**
+ * @brief 与 ir_transform_instcombine_run 相同，修改了 IR 时按 IR_TRANSFORM_INSTCOMBINE_PRESERVES 让其余的分析失效
+ */
+bool ir_transform_instcombine_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
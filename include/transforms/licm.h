@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 执行循环不变量外提 (Loop-Invariant Code Motion, LICM)。
+ *
+ * 先给没有前置块 (preheader) 的循环创建一个: header 在循环外的前驱都改为跳到新块，
+ * header 中 phi 来自这些前驱的入边在新块中合并。然后由内向外处理每个循环，把操作数都在循环外定义的指令
+ * 移到前置块的末尾，内层循环外提的指令随后可以继续外提到外层循环。
+ *
+ * 外提的指令:
+ * - 算术、位运算、比较、类型转换、select 和 gep；除法和取余只在除数是非零常量
+ *   (有符号时还不能是 -1) 时外提，因为提前执行可能出错
+ * - load: 循环中没有 call，每个 store 写的对象 (去掉 gep 之后的 alloca 或全局变量) 与 load 读的对象
+ *   都能确定而且不同，load 所在的块支配所有离开循环的块 (进入循环就一定会执行它)
+ *
+ * @param func 要变换的函数 (CFG、支配树和循环信息在内部计算)
+ * @param out_cfg_changed (可选) 写入是否创建了前置块
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_licm_run(IRFunction *func, bool *out_cfg_changed);
+
+/**
+ * @brief 与 ir_transform_licm_run 相同，但循环信息取自分析管理器
+ *
+ * 只移动了指令时保留 IR_PRESERVE_CFG_ANALYSES，创建了前置块时所有分析都失效。
+ */
+bool ir_transform_licm_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
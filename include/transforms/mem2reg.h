@@ -16,19 +16,52 @@
 
 #pragma once
 
+#include "analysis/analysis_manager.h"
 #include "analysis/dom_frontier.h"
 #include "analysis/dom_tree.h"
 #include "ir/function.h"
 
+/**
+ * @brief mem2reg 放置 phi 的方式
+ *
+ * 候选位置总是 store 块集合的迭代支配边界 (IDF)；各方式的区别是变量在那里已经死了时是否还放 phi。
+ */
+typedef enum IRMem2RegPhiPlacement
+{
+  /// 最小 SSA: IDF 中的每个块都放 phi
+  IR_MEM2REG_MINIMAL,
+  /// 半剪枝 (semi-pruned): 只为跨块活跃的 alloca 放 phi (有块在 store 之前 load 它)，放在它的整个 IDF 上
+  IR_MEM2REG_SEMI_PRUNED,
+  /// 剪枝 (pruned，默认): 只在变量入口活跃的块 (到达某个 load 之前不经过 store) 放 phi
+  IR_MEM2REG_PRUNED,
+} IRMem2RegPhiPlacement;
+
 /**
  * @brief 执行 "Promote Memory to Register" (mem2reg) 变换。
  *
  * 这个 pass 会寻找入口块中的 'alloca' 指令，并尝试将它们
  * 提升到 SSA 寄存器中，用 PHI 节点替换 'load' 和 'store'。
+ * phi 按 IR_MEM2REG_PRUNED 放置。
  *
  * @param func 要变换的函数。
  * @param dt 此函数的支配树。
- * @param df 此函数的支配边界。
+ * @param df 不再使用，可以为 NULL (phi 的位置由支配树直接算出，参数为兼容保留)。
  * @return 如果 IR 被修改则返回 true，否则返回 false。
  */
 bool ir_transform_mem2reg_run(IRFunction *func, DominatorTree *dt, DominanceFrontier *df);
+
+/**
+ * @brief 与 ir_transform_mem2reg_run 相同，但指定 phi 的放置方式
+ */
+bool ir_transform_mem2reg_run_with_placement(IRFunction *func, DominatorTree *dt, IRMem2RegPhiPlacement placement);
+
+/** @brief mem2reg 保留的分析: 它只增删指令 (phi / load / store / alloca)，不改控制流 */
+#define IR_TRANSFORM_MEM2REG_PRESERVES IR_PRESERVE_CFG_ANALYSES
+
+/**
+ * @brief 与 ir_transform_mem2reg_run 相同，但支配树取自分析管理器 (不会计算支配边界)，
+ * 修改了 IR 时再按 IR_TRANSFORM_MEM2REG_PRESERVES 让其余的分析失效。
+ *
+ * @return 如果 IR 被修改则返回 true，否则返回 false (包括函数没有基本块时)。
+ */
+bool ir_transform_mem2reg_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
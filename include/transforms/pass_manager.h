@@ -0,0 +1,119 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * =================================================================
+ * --- Pass 流水线 (Pass Pipeline) ---
+ * =================================================================
+ *
+ * 按顺序运行一串模块 Pass 和函数 Pass，可选地在每个 Pass 之后运行验证器。
+ *
+ * 连续的函数 Pass 组成一组: 每个函数由同一个 worker 依次跑完整组 Pass，
+ * 所以组内的 Pass 共享 worker 的分析缓存。函数按指令数从大到小被领取，
+ * 最大的函数最先开始，整组的耗时接近最大的那个函数，而不是所有函数之和。
+ * worker 在 Context 的并发构建模式下运行 (见 ir_context_begin_concurrent)，
+ * 新建的 IR 对象分配在各自的 Arena 中。
+ *
+ * 函数 Pass 只能修改它拿到的函数 (以及通过 Context 唯一化的类型和常量)，
+ * 不能增删模块的函数和全局变量，也不能读写其他函数的函数体；需要这样做的变换写成模块 Pass。
+ */
+
+/**
+ * @brief 函数 Pass
+ *
+ * 修改了函数时负责调用 ir_analysis_invalidate (与 ir_transform_mem2reg_run_with_analyses 的约定相同，
+ * 所以它可以直接作为函数 Pass)。
+ *
+ * @param func 要变换的函数 (总是有函数体)
+ * @param am 当前 worker 的分析管理器
+ * @return 如果函数被修改则返回 true
+ */
+typedef bool (*IRFunctionPassFn)(IRFunction *func, IRAnalysisManager *am);
+
+/**
+ * @brief 模块 Pass (在调用线程上运行)
+ *
+ * @param mod 要变换的模块
+ * @param am 流水线的分析管理器 (ir_pass_pipeline_run 的参数)
+ * @return 如果模块被修改则返回 true
+ */
+typedef bool (*IRModulePassFn)(IRModule *mod, IRAnalysisManager *am);
+
+/** @brief Pass 流水线 (定义在 pass_manager.c 内部) */
+typedef struct IRPassPipeline IRPassPipeline;
+
+/**
+ * @brief 创建一个空的流水线 (单线程，不验证)。
+ * @return 新流水线；OOM 时返回 NULL
+ */
+IRPassPipeline *ir_pass_pipeline_create(void);
+
+/**
+ * @brief 销毁流水线 (不影响已经运行过的模块)。
+ */
+void ir_pass_pipeline_destroy(IRPassPipeline *pipeline);
+
+/**
+ * @brief 在流水线末尾添加一个函数 Pass
+ *
+ * @param name Pass 的名字 (验证失败时出现在错误信息中；必须比流水线存活更久)
+ * @return bool OOM 时返回 false
+ */
+bool ir_pass_pipeline_add_function_pass(IRPassPipeline *pipeline, const char *name, IRFunctionPassFn run);
+
+/**
+ * @brief 在流水线末尾添加一个模块 Pass
+ *
+ * @param name Pass 的名字 (同 ir_pass_pipeline_add_function_pass)
+ * @return bool OOM 时返回 false
+ */
+bool ir_pass_pipeline_add_module_pass(IRPassPipeline *pipeline, const char *name, IRModulePassFn run);
+
+/**
+ * @brief 运行函数 Pass 的线程数 (包括调用线程；0 和 1 都表示只用调用线程)
+ *
+ * 不支持线程 (__STDC_NO_THREADS__) 时总是只用调用线程。
+ */
+void ir_pass_pipeline_set_num_threads(IRPassPipeline *pipeline, size_t num_threads);
+
+/**
+ * @brief 是否在每个 Pass 之后运行验证器 (默认 false)
+ *
+ * 函数 Pass 之后验证它处理的函数，模块 Pass 之后验证整个模块。
+ * 两种情况都只检查上次通过验证之后被修改过的函数 (见 ir_verify_module_incremental)。
+ */
+void ir_pass_pipeline_set_verify_each(IRPassPipeline *pipeline, bool verify_each);
+
+/**
+ * @brief 在模块上运行流水线
+ *
+ * 延迟加载的函数体先全部物化。某个 Pass 之后验证失败时，打印出错的 Pass 和函数，
+ * 并停止运行之后的 Pass (同一组中其他函数已经开始的工作会先完成)。
+ *
+ * @param am 模块 Pass 使用的分析管理器。函数 Pass 组在单线程时也使用它；
+ *           并行时各 worker 用自己的管理器，被修改的函数在 am 中的缓存随后全部失效。
+ * @param out_changed (可选) 写入是否有 Pass 修改了模块
+ * @return bool 所有验证都通过 (或没有验证) 时返回 true；物化失败、验证失败或 OOM 时返回 false
+ */
+bool ir_pass_pipeline_run(IRPassPipeline *pipeline, IRModule *mod, IRAnalysisManager *am, bool *out_changed);
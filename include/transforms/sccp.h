@@ -0,0 +1,49 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 执行稀疏条件常量传播 (Sparse Conditional Constant Propagation, SCCP)。
+ *
+ * 沿 SSA 的 Use 链传播常量，同时只沿可能执行的边前进：条件是常量的分支只有一个后继可达，
+ * phi 只合并来自可达边的值。常量由 interpreter_fold_instruction 折叠，与解释器执行时的结果逐位相同
+ * (除以零之类会出错的运算不折叠)。
+ *
+ * 之后: 结果是常量的指令被替换 (RAUW) 并删除；条件是常量的 cond_br / switch 改成 br，
+ * phi 删掉来自不可达边的入边；不可达的块被删除。
+ *
+ * @param func 要变换的函数
+ * @param cfg 此函数的 CFG
+ * @param out_cfg_changed (可选) 写入是否改写了分支或删除了块 (此时 cfg 和依赖它的分析都已失效)
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_sccp_run(IRFunction *func, FunctionCFG *cfg, bool *out_cfg_changed);
+
+/**
+ * @brief 与 ir_transform_sccp_run 相同，但 CFG 取自分析管理器
+ *
+ * 只替换了常量时保留 IR_PRESERVE_CFG_ANALYSES，改动了控制流时所有分析都失效。
+ *
+ * @return 如果 IR 被修改则返回 true，否则返回 false (包括函数没有基本块时)
+ */
+bool ir_transform_sccp_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "analysis/analysis_manager.h"
+#include "ir/function.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief 简化控制流图 (SimplifyCFG)。
+ *
+ * 反复执行以下改写，直到没有变化:
+ * - 条件是常量 (或两个目标相同) 的 cond_br、条件是常量 (或所有目标相同) 的 switch 改成 br，
+ *   不再跳到的后继删掉 phi 中来自此块的入边
+ * - 删除从入口不可达的块
+ * - 只有一个前驱、而且这个前驱只跳到它的块并入前驱 (它的 phi 换成唯一的入边值)
+ * - 只含一条 br 的空块: 前驱直接跳到它的目标 (穿过空块)，目标的 phi 为每个前驱补上入边；
+ *   前驱已经跳到目标、而两条路径的 phi 值不同时不穿过
+ *
+ * 入口块不会被合并到别的块或被穿过。
+ *
+ * @param func 要变换的函数
+ * @return 如果 IR 被修改则返回 true，否则返回 false
+ */
+bool ir_transform_simplify_cfg_run(IRFunction *func);
+
+/**
+ * @brief 与 ir_transform_simplify_cfg_run 相同，修改了 IR 时让所有分析失效
+ */
+bool ir_transform_simplify_cfg_run_with_analyses(IRFunction *func, IRAnalysisManager *am);
@@ -106,6 +106,121 @@ void bitset_union(Bitset *dest, const Bitset *src1, const Bitset *src2);
 void bitset_difference(Bitset *dest, const Bitset *src1, const Bitset *src2);
 
 /**
- * @brief [调试用] 统计集合中 1 的数量 (较慢)
+ * @brief dest = dest ∪ src，返回 dest 是否改变 (数据流不动点迭代用，不需要额外的比较)
+ * @note 必须具有相同的 num_bits
+ */
+bool bitset_union_with(Bitset *dest, const Bitset *src);
+
+/**
+ * @brief dest = dest ∩ src，返回 dest 是否改变
+ * @note 必须具有相同的 num_bits
+ */
+bool bitset_intersect_with(Bitset *dest, const Bitset *src);
+
+/**
+ * @brief dest = dest \ src，返回 dest 是否改变
+ * @note 必须具有相同的 num_bits
+ */
+bool bitset_difference_with(Bitset *dest, const Bitset *src);
+
+/**
+ * @brief 统计集合中 1 的数量 (按字 popcount)
+ */
+size_t bitset_count(const Bitset *bs);
+
+/**
+ * @brief [调试用] 统计集合中 1 的数量 (逐位清除，较慢；用来校验 bitset_count)
  */
 size_t bitset_count_slow(const Bitset *bs);
+
+/**
+ * @brief 找到下标 >= from 的第一个 1
+ *
+ * 按字跳过全 0 的部分，字内用 ctz 定位，所以遍历的代价与字数和 1 的个数成正比，而不是与位数成正比。
+ *
+ * @return 位的下标；没有时返回 bs->num_bits
+ */
+size_t bitset_find_next(const Bitset *bs, size_t from);
+
+/**
+ * @brief 按升序遍历集合中的每个 1
+ *
+ * 用法:
+ * bitset_for_each(live, bit)
+ * {
+ *   ... bit 是 size_t 下标 ...
+ * }
+ * @note 遍历中可以清除已经访问过的位，也可以设置 / 清除当前位之后的位 (之后会被看到)
+ */
+#define bitset_for_each(bs, bit)                                                                                       \
+  for (size_t bit = bitset_find_next((bs), 0); bit < (bs)->num_bits; bit = bitset_find_next((bs), bit + 1))
+
+/*
+ * =================================================================
+ * --- 稀疏 / 稠密混合位集 ---
+ * =================================================================
+ *
+ * 位数很大、但几乎全为 0 的集合 (例如整个模块的值编号上的集合) 不值得分配
+ * num_bits / 8 字节并在每次运算时扫描所有的字。SparseBitset 开始时只记录非 0 的字:
+ * 按字下标排序的 (下标, 字) 数组；非 0 的字超过总字数的 1/SPARSE_BITSET_DENSE_RATIO 时
+ * 转换为普通的 Bitset (之后一直保持稠密)。很小的集合一开始就是稠密的。
+ */
+
+/** @brief 非 0 字的比例超过 1 / 该值时转为稠密形式 */
+#define SPARSE_BITSET_DENSE_RATIO 4
+
+/** @brief 字数不超过该值的集合直接使用稠密形式 */
+#define SPARSE_BITSET_MIN_SPARSE_WORDS 8
+
+typedef struct SparseBitset
+{
+  size_t num_bits;
+  /** 数组增长和转换为稠密形式时使用 */
+  Bump *arena;
+  /** 稠密形式；为 NULL 时使用下面的稀疏数组 */
+  Bitset *dense;
+  /** 稀疏形式: 非 0 的字，按 word_ids 升序排列 */
+  size_t num_words;
+  size_t capacity;
+  size_t *word_ids;
+  uint64_t *words;
+} SparseBitset;
+
+/**
+ * @brief 创建一个空的混合位集
+ */
+SparseBitset *sparse_bitset_create(size_t num_bits, Bump *arena);
+
+void sparse_bitset_set(SparseBitset *sbs, size_t bit);
+void sparse_bitset_clear(SparseBitset *sbs, size_t bit);
+bool sparse_bitset_test(const SparseBitset *sbs, size_t bit);
+
+/**
+ * @brief 统计集合中 1 的数量
+ */
+size_t sparse_bitset_count(const SparseBitset *sbs);
+
+/**
+ * @brief 当前是否已经是稠密形式
+ */
+bool sparse_bitset_is_dense(const SparseBitset *sbs);
+
+/**
+ * @brief dest = dest ∪ src，返回 dest 是否改变
+ *
+ * 两边都稀疏时按字下标归并；任意一边稠密时 dest 转为稠密后按字运算。
+ * @note 必须具有相同的 num_bits
+ */
+bool sparse_bitset_union_with(SparseBitset *dest, const SparseBitset *src);
+
+/**
+ * @brief 找到下标 >= from 的第一个 1；没有时返回 sbs->num_bits
+ */
+size_t sparse_bitset_find_next(const SparseBitset *sbs, size_t from);
+
+/**
+ * @brief 按升序遍历混合位集中的每个 1 (用法同 bitset_for_each，遍历中不要修改集合)
+ */
+#define sparse_bitset_for_each(sbs, bit)                                                                               \
+  for (size_t bit = sparse_bitset_find_next((sbs), 0); bit < (sbs)->num_bits;                                          \
+       bit = sparse_bitset_find_next((sbs), bit + 1))
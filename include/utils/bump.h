@@ -52,6 +52,9 @@ struct ChunkFooter
   unsigned char *ptr;
 
   size_t allocated_bytes;
+
+  /// 由 mmap 分配 (释放时用 munmap)
+  bool mapped;
 };
 
 /*
@@ -140,6 +143,91 @@ void bump_free(Bump *bump);
  */
 void bump_reset(Bump *bump);
 
+/**
+ * @brief Arena 中的一个位置 (由 bump_mark 返回，传给 bump_rewind)
+ */
+typedef struct
+{
+  ChunkFooter *chunk;
+  unsigned char *ptr;
+} BumpMark;
+
+/**
+ * @brief 记录 Arena 当前的分配位置。
+ *
+ * @param bump Arena。
+ * @return BumpMark 当前位置；在 bump_reset / bump_destroy 之后失效。
+ */
+BumpMark bump_mark(Bump *bump);
+
+/**
+ * @brief 回退到 bump_mark 记录的位置。
+ *
+ * 释放 mark 之后分配的所有内存 (包括之后新建的 Chunk)，
+ * 之后的分配会重用这段空间。mark 之后分配的对象都不能再使用。
+ *
+ * @param bump Arena。
+ * @param mark 之前在同一个 Arena 上调用 bump_mark 的结果。
+ */
+void bump_rewind(Bump *bump, BumpMark mark);
+
+/**
+ * @brief 把 src 的所有 Chunk 转交给 dst。
+ *
+ * src 中分配的对象保持有效，此后随 dst 一起被 bump_reset / bump_destroy 释放；
+ * src 变为空 Arena (可以继续使用或销毁)。两者不能同时被其他线程使用。
+ *
+ * @param dst 接收方 Arena。
+ * @param src 被合并的 Arena。
+ */
+void bump_adopt(Bump *dst, Bump *src);
+
+/*
+ * --- 线程私有的 Arena 组 ---
+ */
+
+/**
+ * @brief 一组线程私有的 Arena，最后一起并入 (或随之释放) 一个父 Arena。
+ *
+ * Bump 本身不是线程安全的。并行阶段的每个 worker 用自己的下标取得一个 Bump (bump_group_local)，
+ * 分配时不需要任何同步；所有 worker 结束之后，bump_group_finish 在一个线程上把各个 Arena 的
+ * Chunk 全部转交给父 Arena (bump_adopt)，分配出的对象此后随父 Arena 一起释放。
+ */
+typedef struct BumpGroup
+{
+  /** 接收所有 Chunk 的 Arena；NULL 表示对象只在 bump_group_finish 之前有效 */
+  Bump *parent;
+  size_t num_locals;
+  Bump *locals;
+} BumpGroup;
+
+/**
+ * @brief 初始化一个有 num_locals 个线程私有 Arena 的组。
+ *
+ * 每个 Arena 的最小对齐与 parent 相同 (parent 为 NULL 时为 1)。
+ *
+ * @param group 要初始化的组。
+ * @param parent 父 Arena (可以为 NULL)。
+ * @param num_locals 线程私有 Arena 的个数 (通常是 worker 的个数)。
+ * @return bool OOM 时返回 false (此时组为空，不需要 bump_group_finish)。
+ */
+bool bump_group_init(BumpGroup *group, Bump *parent, size_t num_locals);
+
+/**
+ * @brief 第 index 个 worker 的私有 Arena (index < num_locals)。
+ *
+ * 同一时刻只能有一个线程使用它；不同下标的 Arena 可以被不同线程同时使用。
+ */
+Bump *bump_group_local(BumpGroup *group, size_t index);
+
+/**
+ * @brief 结束组: 有父 Arena 时把所有 Chunk 转交给它，否则释放所有 Chunk。
+ *
+ * 必须在所有 worker 都停止使用各自的 Arena 之后，在单个线程上调用。
+ * 之后 group 为空，可以重新 bump_group_init。
+ */
+void bump_group_finish(BumpGroup *group);
+
 /*
  * --- 分配 API ---
  */
@@ -222,6 +310,67 @@ void bump_set_allocation_limit(Bump *bump, size_t limit);
  */
 size_t bump_get_allocated_bytes(Bump *bump);
 
+/** @brief Arena 的占用 (见 bump_get_usage) */
+typedef struct BumpUsage
+{
+  size_t num_chunks;
+  /** 所有 Chunk 中可以分配的字节 (不含 ChunkFooter) */
+  size_t reserved_bytes;
+  /** 已经分配出去的字节 (包括对齐的填充) */
+  size_t used_bytes;
+} BumpUsage;
+
+/**
+ * @brief 遍历 Chunk 链表，统计 Arena 的占用
+ *
+ * reserved_bytes - used_bytes 是已经申请但还没有用到的内存 (主要在当前 Chunk 中；
+ * 放不下的分配换新 Chunk 时，旧 Chunk 剩下的部分也会计入)。
+ */
+BumpUsage bump_get_usage(const Bump *bump);
+
+/** @brief 把 b 的占用加到 a 上 (汇总多个 Arena) */
+static inline void
+bump_usage_add(BumpUsage *a, BumpUsage b)
+{
+  a->num_chunks += b.num_chunks;
+  a->reserved_bytes += b.reserved_bytes;
+  a->used_bytes += b.used_bytes;
+}
+
+/*
+ * --- Chunk 缓存与大页 (进程级设置) ---
+ *
+ * bump_destroy / bump_reset / bump_rewind 释放的 Chunk 先进入一个进程级缓存 (线程安全)，
+ * 之后任何 Arena 新建 Chunk 时优先复用，避免频繁创建 / 销毁 Arena 时反复 malloc/free。
+ */
+
+/**
+ * @brief 设置 Chunk 缓存的容量上限 (字节)。
+ *
+ * 默认 64 MiB (AddressSanitizer 构建下为 0)。单个 Chunk 超过上限的四分之一时不缓存。
+ * 传入 0 关闭缓存并立即释放已缓存的 Chunk。
+ */
+void bump_set_chunk_cache_limit(size_t limit);
+
+/**
+ * @brief 把缓存中的 Chunk 全部还给系统 (上限不变)。
+ */
+void bump_trim_chunk_cache(void);
+
+/**
+ * @brief 当前缓存中 Chunk 的总字节数。
+ */
+size_t bump_chunk_cache_bytes(void);
+
+/**
+ * @brief 不小于 threshold 字节的新 Chunk 改用匿名 mmap 分配 (向上取整到 2 MiB)，
+ * 并用 madvise(MADV_HUGEPAGE) 建议内核使用透明大页。
+ *
+ * 用于数 GB 的 IR Arena，减少缺页和 TLB 未命中。默认 0 表示关闭；Windows 上无效。
+ * 可以在其它线程分配时调用，只影响之后新建的 Chunk。
+ */
+void bump_set_huge_page_threshold(size_t threshold);
+
 /**
  * @brief 分配单个 T 实例
  *
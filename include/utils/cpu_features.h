@@ -0,0 +1,71 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file cpu_features.h
+ * @brief 运行时检测 CPU 的 SIMD 能力，供各个内核在启动后选择一次实现。
+ *
+ * 库本身按目标平台的基线指令集编译 (x86-64: SSE2；AArch64: NEON)，
+ * 更宽的实现 (AVX2 / AVX-512) 用 target 属性单独编译，根据这里的检测结果经函数指针表选用。
+ * 这样同一个二进制可以部署到不同代的机器上。
+ *
+ * 目前按这里选用实现的是 Bitset 的按字运算和解释器的批量内核；哈希表的分组探测和词法分析的块扫描
+ * 只有基线的 16 字节实现 (SSE2 / NEON，词法分析在 ARM 上逐字节处理)。
+ */
+
+/** @brief 可以选用的 SIMD 能力 (位集合) */
+typedef enum CpuFeature
+{
+  CPU_FEATURE_SSE2 = 1u << 0,
+  CPU_FEATURE_AVX2 = 1u << 1,
+  /** AVX-512 F + VL + BW + DQ (内核需要的全部子集) */
+  CPU_FEATURE_AVX512 = 1u << 2,
+  CPU_FEATURE_NEON = 1u << 3,
+} CpuFeature;
+
+typedef uint32_t CpuFeatures;
+
+/**
+ * @brief 检测当前 CPU (以及操作系统是否保存了对应的寄存器状态)
+ *
+ * x86 上使用 cpuid (经由 __builtin_cpu_supports)，ARM 上使用 getauxval(AT_HWCAP)；
+ * 每次调用都重新检测。
+ */
+CpuFeatures cpu_features_detect(void);
+
+/**
+ * @brief 当前进程使用的能力: 第一次调用时检测并缓存 (线程安全)
+ */
+CpuFeatures cpu_features(void);
+
+/**
+ * @brief 屏蔽一部分能力 (例如强制所有内核走基线实现，用于排查或对比)
+ *
+ * 只影响之后第一次选择实现的内核，应在使用库之前调用。
+ */
+void cpu_features_restrict(CpuFeatures allowed);
+
+/**
+ * @brief 能力集合的可读名字 (例如 "sse2 avx2")，写入 buf
+ *
+ * @return buf
+ */
+const char *cpu_features_describe(CpuFeatures features, char *buf, size_t size);
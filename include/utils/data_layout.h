@@ -38,10 +38,17 @@ typedef struct
   size_t abi_align_in_bytes;
 } TypeLayoutInfo;
 
+/** @brief [内部] 聚合类型布局的缓存 (见 data_layout.c) */
+typedef struct DataLayoutCache DataLayoutCache;
+
 /**
  * @brief 定义目标平台的完整数据布局。
  *
  * 编译器/解释器的所有部分都应查询此结构以获取布局信息。
+ *
+ * 结构体和数组的布局在第一次查询时算出并缓存 (以类型地址和它所属 IRContext 的编号为键)，
+ * 之后的查询 (包括结构体成员偏移) 只是一次查表。缓存可以被多个线程同时读取和填充。
+ * 同一个 DataLayout 可以先后用于多个 IRContext；修改下面的布局规则之后须调用 datalayout_clear_cache()。
  */
 typedef struct
 {
@@ -62,6 +69,9 @@ typedef struct
    */
   size_t aggregate_preferred_align_in_bytes;
 
+  /** 聚合类型布局的缓存 (分配失败时为 NULL，此时每次查询都重新计算) */
+  DataLayoutCache *cache;
+
 } DataLayout;
 
 /*
@@ -83,6 +93,13 @@ DataLayout *datalayout_create_host(void);
  */
 void datalayout_destroy(DataLayout *dl);
 
+/**
+ * @brief 丢弃所有缓存的聚合类型布局 (也释放已销毁的上下文留下的条目)
+ *
+ * @note 不能与同一个 DataLayout 上的查询并发调用
+ */
+void datalayout_clear_cache(DataLayout *dl);
+
 /*
  * --- 核心 API ---
  */
@@ -122,6 +139,17 @@ size_t datalayout_get_type_align(const DataLayout *dl, IRType *type);
  */
 size_t datalayout_get_struct_member_offset(const DataLayout *dl, IRType *struct_type, size_t member_index);
 
+/**
+ * @brief 获取结构体所有成员的偏移量数组 (下标为成员索引)
+ *
+ * 数组归 DataLayout 的缓存所有，在 datalayout_clear_cache / datalayout_destroy 之前一直有效。
+ *
+ * @param dl 目标数据布局。
+ * @param struct_type 必须是 IR_TYPE_STRUCT 类型。
+ * @return const size_t* member_count 个偏移量；缓存不可用时返回 NULL
+ */
+const size_t *datalayout_get_struct_member_offsets(const DataLayout *dl, IRType *struct_type);
+
 /**
  * @brief (便捷函数) 获取指针的大小。
  */
@@ -17,19 +17,97 @@
 /* include/utils/hashmap/common.h */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /**
  * @brief 定义哈希表桶 (bucket) 的状态。
- * 使用一个并行的 'states' 数组 (uint8_t) 来存储这些值,
+ * 使用一个并行的 'states' 数组 (uint8_t，即控制字节) 来存储这些值,
  * 而不是依赖 Key 本身的“哨兵值”。
+ *
+ * 满的槽位的控制字节是 BUCKET_FILLED | 哈希的高 7 位 (见 bucket_tag)，
+ * 查找时先比较控制字节，只有 tag 相同的槽位才需要比较 Key。
  */
 typedef enum BucketState
 {
   /** @brief 槽位是空的, 从未被使用过。*/
   BUCKET_EMPTY = 0,
-  /** @brief 槽位是满的, 包含一个有效的键值对。*/
-  BUCKET_FILLED = 1,
   /** @brief 槽位曾被使用, 但现已被删除 (墓碑)。*/
-  BUCKET_TOMBSTONE = 2
+  BUCKET_TOMBSTONE = 2,
+  /** @brief 槽位是满的 (最高位；低 7 位是 tag)。*/
+  BUCKET_FILLED = 0x80
 } BucketState;
+
+/** @brief 满的槽位的控制字节 */
+static inline uint8_t
+bucket_tag(uint64_t hash)
+{
+  return (uint8_t)(BUCKET_FILLED | (hash >> 57));
+}
+
+static inline bool
+bucket_is_filled(uint8_t state)
+{
+  return (state & BUCKET_FILLED) != 0;
+}
+
+/*
+ * --- 分组探测 ---
+ *
+ * 桶数不少于 HASHMAP_GROUP_WIDTH 时，16 个控制字节一组一次比较完。
+ * 只使用平台的基线指令集 (x86-64: SSE2，AArch64: NEON)，不需要运行时分派:
+ * 每次探测都内联在查找里，换成函数指针反而更慢。
+ * 下面的函数返回组内满足条件的槽位的位掩码 (第 i 位对应 group[i])。
+ */
+
+#define HASHMAP_GROUP_WIDTH 16
+
+#if !defined(__SSE2__) && defined(__aarch64__) && defined(__ARM_NEON)
+/** @brief 把每个字节为 0x00 / 0xFF 的比较结果压成 16 位掩码 (NEON 没有 movemask) */
+static inline uint32_t
+hashmap_neon_movemask(uint8x16_t bytes)
+{
+  static const uint8_t BIT_WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t bits = vandq_u8(bytes, vld1q_u8(BIT_WEIGHTS));
+  return (uint32_t)vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#endif
+
+/** @brief 组内控制字节等于 byte 的槽位 */
+static inline uint32_t
+hashmap_group_match(const uint8_t *group, uint8_t byte)
+{
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  return hashmap_neon_movemask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(byte)));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] == byte) << i;
+  return mask;
+#endif
+}
+
+/** @brief 组内可以插入的槽位 (空槽或墓碑，即最高位为 0) */
+static inline uint32_t
+hashmap_group_match_free(const uint8_t *group)
+{
+#if defined(__SSE2__)
+  return ~(uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group)) & 0xFFFFu;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  return hashmap_neon_movemask(vcltq_u8(vld1q_u8(group), vdupq_n_u8(BUCKET_FILLED)));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)!bucket_is_filled(group[i]) << i;
+  return mask;
+#endif
+}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "utils/bump.h"
+#include "utils/hashmap/stats.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -101,6 +102,21 @@ CHASHMAP_FLOAT_TYPES(CHM_DECLARE_FLOAT_ITER_STRUCTS)
    */                                                                                                                  \
   size_t PREFIX##_hashmap_size(const API_TYPE *map);                                                                   \
                                                                                                                        \
+  /**                                                                                                                  \
+   * @brief 获取哈希表的占用统计 (条目、桶、墓碑和字节数)。                                      \
+   */                                                                                                                  \
+  HashMapStats PREFIX##_hashmap_stats(const API_TYPE *map);                                                            \
+                                                                                                                       \
+  /**                                                                                                                  \
+   * @brief 删除所有条目，保留桶数组以便复用 (不分配内存)。                                      \
+   */                                                                                                                  \
+  void PREFIX##_hashmap_clear(API_TYPE *map);                                                                          \
+                                                                                                                       \
+  /**                                                                                                                  \
+   * @brief 预留空间: 之后条目总数不超过 num_entries 时插入不会再扩容。                          \
+   */                                                                                                                  \
+  bool PREFIX##_hashmap_reserve(API_TYPE *map, size_t num_entries);                                                    \
+                                                                                                                       \
   /**                                                                                                                  \
    * @brief 初始化一个哈希表迭代器。                                                                       \
    */                                                                                                                  \
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "utils/bump.h"
+#include "utils/hashmap/stats.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -104,5 +105,31 @@ bool ptr_hashmap_contains(const PtrHashMap *map, void *key);
  */
 size_t ptr_hashmap_size(const PtrHashMap *map);
 
+/**
+ * @brief 获取哈希表的占用统计 (条目、桶、墓碑和字节数)。
+ *
+ * @param map 哈希表。
+ * @return HashMapStats 统计。
+ */
+HashMapStats ptr_hashmap_stats(const PtrHashMap *map);
+
+/**
+ * @brief 删除所有条目，但保留桶数组，可以直接复用于下一批 Key (不分配内存)。
+ *
+ * @param map 哈希表。
+ */
+void ptr_hashmap_clear(PtrHashMap *map);
+
+/**
+ * @brief 预留空间: 之后条目总数不超过 num_entries 时插入不会再扩容。
+ *
+ * 桶已经够用时什么也不做；否则按 num_entries 重新分配并重新哈希 (同时清掉墓碑)。
+ *
+ * @param map 哈希表。
+ * @param num_entries 预期的条目总数 (包括已有的条目)。
+ * @return bool true 表示成功，false 表示内存溢出。
+ */
+bool ptr_hashmap_reserve(PtrHashMap *map, size_t num_entries);
+
 PtrHashMapIter ptr_hashmap_iter(const PtrHashMap *map);
 bool ptr_hashmap_iter_next(PtrHashMapIter *iter, PtrHashMapEntry *entry_out);
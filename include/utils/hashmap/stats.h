@@ -0,0 +1,50 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* include/utils/hashmap/stats.h */
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief 一个哈希表的占用统计 (见各个 [prefix]_hashmap_stats)
+ */
+typedef struct HashMapStats
+{
+  size_t num_entries;
+  size_t num_buckets;
+  /** 从满的组中删除留下的墓碑 (插入时可以复用，扩容 / 清空时清除) */
+  size_t num_tombstones;
+  /** 表头、当前的桶数组和控制字节占用的字节 (扩容前的旧数组仍在 Arena 中，不计入) */
+  size_t bytes;
+} HashMapStats;
+
+/** @brief 负载因子 (不含墓碑；扩容看的是条目加墓碑) */
+static inline double
+hashmap_stats_load_factor(const HashMapStats *stats)
+{
+  return stats->num_buckets ? (double)stats->num_entries / (double)stats->num_buckets : 0.0;
+}
+
+/** @brief 把 b 加到 a 上 (汇总多个表) */
+static inline void
+hashmap_stats_add(HashMapStats *a, const HashMapStats *b)
+{
+  a->num_entries += b->num_entries;
+  a->num_buckets += b->num_buckets;
+  a->num_tombstones += b->num_tombstones;
+  a->bytes += b->bytes;
+}
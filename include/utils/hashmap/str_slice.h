@@ -18,6 +18,7 @@
 #pragma once
 
 #include "utils/bump.h"
+#include "utils/hashmap/stats.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -29,6 +30,8 @@
  * - 它使用 Bump Allocator 进行所有内存分配。
  * - Keys (字符串) 在 'put' 时被复制到 Arena 中。
  * - Values 存储为 void*，由调用者管理其生命周期。
+ * - 每个 Key 的哈希 (str_hashmap_hash) 和 Key 一起保存；已经算好哈希的调用者
+ *   可以用 *_hashed 系列函数，避免再扫描一遍字符串。
  */
 
 typedef struct StrHashMap StrHashMap;
@@ -37,6 +40,8 @@ typedef struct
 {
   const char *key_body;
   size_t key_len;
+  /** str_hashmap_hash(key_body, key_len) (表中保存的哈希，不重新计算) */
+  uint64_t key_hash;
   void *value;
 } StrHashMapEntry;
 
@@ -89,6 +94,23 @@ bool str_hashmap_put(StrHashMap *map, const char *key_body, size_t key_len, void
  */
 bool str_hashmap_put_preallocated_key(StrHashMap *map, const char *key_body, size_t key_len, void *value);
 
+/**
+ * @brief 计算 Key 的哈希 (所有 StrHashMap 使用同一个哈希函数)
+ *
+ * @param key_body 指向字符串内容的指针。
+ * @param key_len 字符串的长度。
+ * @return uint64_t 可以传给 *_hashed 系列函数的哈希
+ */
+uint64_t str_hashmap_hash(const char *key_body, size_t key_len);
+
+/**
+ * @brief 同 str_hashmap_put_preallocated_key，但使用调用者算好的哈希
+ *
+ * @param hash 必须等于 str_hashmap_hash(key_body, key_len)
+ */
+bool str_hashmap_put_preallocated_key_hashed(StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash,
+                                             void *value);
+
 /**
  * @brief 查找一个 Key 对应的 Value。
  *
@@ -99,6 +121,13 @@ bool str_hashmap_put_preallocated_key(StrHashMap *map, const char *key_body, siz
  */
 void *str_hashmap_get(const StrHashMap *map, const char *key_body, size_t key_len);
 
+/**
+ * @brief 同 str_hashmap_get，但使用调用者算好的哈希
+ *
+ * @param hash 必须等于 str_hashmap_hash(key_body, key_len)
+ */
+void *str_hashmap_get_hashed(const StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash);
+
 /**
  * @brief 从哈希表中移除一个 Key。
  *
@@ -119,6 +148,13 @@ bool str_hashmap_remove(StrHashMap *map, const char *key_body, size_t key_len);
  */
 bool str_hashmap_contains(const StrHashMap *map, const char *key_body, size_t key_len);
 
+/**
+ * @brief 同 str_hashmap_contains，但使用调用者算好的哈希
+ *
+ * @param hash 必须等于 str_hashmap_hash(key_body, key_len)
+ */
+bool str_hashmap_contains_hashed(const StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash);
+
 /**
  * @brief 获取哈希表中的条目数。
  *
@@ -127,5 +163,33 @@ bool str_hashmap_contains(const StrHashMap *map, const char *key_body, size_t ke
  */
 size_t str_hashmap_size(const StrHashMap *map);
 
+/**
+ * @brief 获取哈希表的占用统计 (条目、桶、墓碑和字节数)。
+ *
+ * @param map 哈希表。
+ * @return HashMapStats 统计。
+ */
+HashMapStats str_hashmap_stats(const StrHashMap *map);
+
+/**
+ * @brief 删除所有条目，但保留桶数组，可以直接复用于下一批 Key (不分配内存)。
+ *
+ * 由 put 复制的 Key 属于 Arena，不会被释放。
+ *
+ * @param map 哈希表。
+ */
+void str_hashmap_clear(StrHashMap *map);
+
+/**
+ * @brief 预留空间: 之后条目总数不超过 num_entries 时插入不会再扩容。
+ *
+ * 桶已经够用时什么也不做；否则按 num_entries 重新分配并重新哈希 (同时清掉墓碑)。
+ *
+ * @param map 哈希表。
+ * @param num_entries 预期的条目总数 (包括已有的条目)。
+ * @return bool true 表示成功，false 表示内存溢出。
+ */
+bool str_hashmap_reserve(StrHashMap *map, size_t num_entries);
+
 StrHashMapIter str_hashmap_iter(const StrHashMap *map);
 bool str_hashmap_iter_next(StrHashMapIter *iter, StrHashMapEntry *entry_out);
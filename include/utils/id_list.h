@@ -92,6 +92,29 @@ list_del(IDList *node)
   list_init(node);
 }
 
+/**
+ * @brief 把 list 的所有节点 (按原顺序) 移到 head 的尾部，然后把 list 置为空 (O(1))
+ * @param list 被搬空的链表头
+ * @param head 接收节点的链表头
+ */
+static inline void
+list_splice_tail(IDList *list, IDList *head)
+{
+  if (list->next == list)
+    return;
+
+  IDList *first = list->next;
+  IDList *last = list->prev;
+  IDList *tail = head->prev;
+
+  tail->next = first;
+  first->prev = tail;
+  last->next = head;
+  head->prev = last;
+
+  list_init(list);
+}
+
 /**
  * @brief 检查链表是否为空
  * @param head 链表头
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "utils/bump.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * =================================================================
+ * --- 阶段计时与分配统计 (Instrumentation) ---
+ * =================================================================
+ *
+ * 类似 LLVM 的 -time-passes: 解析、验证、cfg_build、dom_tree_build、支配边界、mem2reg、
+ * 解释执行等阶段用 INSTRUMENT_BEGIN / INSTRUMENT_END 包起来，每个阶段记录
+ * 墙钟时间和所跟踪的 Arena 的分配增量 (bump_get_allocated_bytes 的差)，
+ * 按 (阶段, 模块, 函数) 聚合，并可以按模块汇总。报告可以打印为文本或 JSON。
+ *
+ * 用法:
+ *
+ * Instrumentation *session = instrument_create();
+ * instrument_start(session);
+ * ... 解析 / 优化 / 运行 ...
+ * instrument_stop();
+ * instrument_print(session, stderr);          // 或 instrument_print_json
+ * instrument_destroy(session);
+ *
+ * - 没有会话在收集时，每个作用域只多一次原子读和一次分支。
+ * - 用 -DCALICO_NO_INSTRUMENTATION 编译时，所有的 INSTRUMENT_* 宏展开为空 (参数不会被求值)。
+ * - 作用域可以嵌套 (例如 dom_tree_build 中需要的 cfg_build)；self 时间扣除了
+ *   同一线程上嵌套作用域的时间，total 时间包括它们。
+ * - 多个线程 (并行验证 / 解析的工作线程) 可以同时记录到同一个会话。
+ */
+
+#if !defined(CALICO_NO_INSTRUMENTATION)
+#define CALICO_HAS_INSTRUMENTATION 1
+#else
+#define CALICO_HAS_INSTRUMENTATION 0
+#endif
+
+/** @brief 一个作用域最多跟踪的 Arena 数 */
+#define INSTRUMENT_MAX_ARENAS 4
+
+/** @brief 一个收集会话 (定义在 instrument.c 内部) */
+typedef struct Instrumentation Instrumentation;
+
+/** @brief 一个 (阶段, 模块, 函数) 的聚合结果 */
+typedef struct InstrumentRecord
+{
+  const char *stage;
+  /** 模块名；不属于某个模块时为 NULL */
+  const char *module;
+  /** 函数名；模块级的阶段 (例如解析) 为 NULL */
+  const char *function;
+  /** 进入该阶段的次数 */
+  uint64_t count;
+  /** 包括嵌套阶段的时间 */
+  uint64_t total_ns;
+  /** 扣除同一线程上嵌套阶段之后的时间 */
+  uint64_t self_ns;
+  /** 所跟踪 Arena 的增长 (按 chunk 计，所以小的分配可能是 0；Arena 被回退时可能为负) */
+  int64_t bytes;
+  /** [内部] 按第一次出现的顺序链接 */
+  struct InstrumentRecord *next;
+} InstrumentRecord;
+
+/** @brief 一个正在计时的作用域 (放在调用方的栈上) */
+typedef struct InstrumentScope
+{
+  /** 开始时正在收集的会话；为 NULL 时这个作用域什么都不做 */
+  Instrumentation *session;
+  struct InstrumentScope *parent;
+  const char *stage;
+  const char *module;
+  const char *function;
+  uint64_t start_ns;
+  uint64_t child_ns;
+  size_t num_arenas;
+  Bump *arenas[INSTRUMENT_MAX_ARENAS];
+  size_t arena_bytes[INSTRUMENT_MAX_ARENAS];
+} InstrumentScope;
+
+/*
+ * --- 会话 ---
+ */
+
+/**
+ * @brief 创建一个空的会话
+ * @return 会话；OOM 时返回 NULL
+ */
+Instrumentation *instrument_create(void);
+
+/**
+ * @brief 销毁会话 (如果它正在收集，先停止)
+ */
+void instrument_destroy(Instrumentation *session);
+
+/**
+ * @brief 让 session 成为进程中正在收集的会话 (替换之前的会话)
+ *
+ * @note 已经开始的作用域仍然记录到它们开始时的会话
+ */
+void instrument_start(Instrumentation *session);
+
+/**
+ * @brief 停止收集 (之后开始的作用域不再记录)
+ */
+void instrument_stop(void);
+
+/**
+ * @brief 清空会话中的所有记录
+ * @note 不能与记录到该会话的作用域并发调用
+ */
+void instrument_reset(Instrumentation *session);
+
+/**
+ * @brief 按第一次出现的顺序遍历记录: 传入 NULL 得到第一条
+ */
+const InstrumentRecord *instrument_next_record(const Instrumentation *session, const InstrumentRecord *record);
+
+/**
+ * @brief 查找一条记录 (module / function 为 NULL 表示模块级 / 不属于模块)
+ */
+const InstrumentRecord *instrument_find(const Instrumentation *session, const char *stage, const char *module,
+                                        const char *function);
+
+/**
+ * @brief 打印文本报告: 每个模块按阶段汇总，然后是每个函数的明细
+ */
+void instrument_print(const Instrumentation *session, FILE *stream);
+
+/**
+ * @brief 打印 JSON 报告: {"records": [...], "modules": [...]}
+ */
+void instrument_print_json(const Instrumentation *session, FILE *stream);
+
+/*
+ * --- 作用域 (一般通过下面的宏使用) ---
+ */
+
+/**
+ * @brief 开始一个作用域 (没有会话在收集时 scope->session 为 NULL)
+ *
+ * stage / module / function 只需要在 instrument_end 之前有效 (记录时会复制)。
+ */
+void instrument_begin(InstrumentScope *scope, const char *stage, const char *module, const char *function);
+
+/**
+ * @brief 跟踪一个 Arena 的分配增量 (应在 instrument_begin 之后立即调用)
+ */
+void instrument_track_arena(InstrumentScope *scope, Bump *arena);
+
+/**
+ * @brief 修改作用域所属的模块 (模块在作用域中途才创建时使用)
+ */
+static inline void
+instrument_set_module(InstrumentScope *scope, const char *module)
+{
+  scope->module = module;
+}
+
+/**
+ * @brief 结束作用域，把时间和分配增量加到会话中对应的记录
+ */
+void instrument_end(InstrumentScope *scope);
+
+#if CALICO_HAS_INSTRUMENTATION
+/// 声明并开始一个名为 scope 的作用域 (只能用在语句的位置)
+#define INSTRUMENT_BEGIN(scope, stage, module, function)                                                               \
+  InstrumentScope scope;                                                                                               \
+  instrument_begin(&(scope), (stage), (module), (function))
+#define INSTRUMENT_TRACK_ARENA(scope, arena) instrument_track_arena(&(scope), (arena))
+#define INSTRUMENT_SET_MODULE(scope, module) instrument_set_module(&(scope), (module))
+#define INSTRUMENT_END(scope) instrument_end(&(scope))
+#else
+#define INSTRUMENT_BEGIN(scope, stage, module, function) ((void)0)
+#define INSTRUMENT_TRACK_ARENA(scope, arena) ((void)0)
+#define INSTRUMENT_SET_MODULE(scope, module) ((void)0)
+#define INSTRUMENT_END(scope) ((void)0)
+#endif
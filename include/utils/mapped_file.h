@@ -0,0 +1,55 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file mapped_file.h
+ * @brief 以只读方式把整个文件映射进内存。
+ *
+ * POSIX 平台上使用 mmap (内容直接来自页缓存，不复制)；
+ * 其他平台退回把文件读进一块堆内存。映射的内容不以 '\0' 结尾。
+ */
+
+/**
+ * @brief 一个只读映射的文件
+ */
+typedef struct MappedFile
+{
+  /** 文件内容 (size 为 0 时不可解引用) */
+  const char *data;
+  /** 文件大小 (字节) */
+  size_t size;
+  /** data 来自 mmap (true) 还是堆内存 (false) */
+  bool mapped;
+} MappedFile;
+
+/**
+ * @brief 打开并映射整个文件
+ *
+ * @param file [输出] 映射结果
+ * @param path 文件路径
+ * @return true 成功；false 无法打开、读取或映射文件 (file 不需要关闭)
+ */
+bool mapped_file_open(MappedFile *file, const char *path);
+
+/**
+ * @brief 解除映射 (或释放读入的内存)
+ */
+void mapped_file_close(MappedFile *file);
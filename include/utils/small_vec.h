@@ -0,0 +1,151 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "utils/bump.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * =================================================================
+ * --- 带内联存储的类型化小向量 (Small Vector) ---
+ * =================================================================
+ *
+ * TempVec 只能存 void*，并且第一次 push 就要在 Arena 上分配。
+ * 分析的工作表、操作数数组、phi 复制列表等几乎总是只有几个元素:
+ * SMALL_VEC_DEFINE 生成一个按元素类型实例化的向量，前 N 个元素放在结构体内部，
+ * 超出时才溢出到 Arena (之后按两倍增长)。
+ *
+ * 用法 (通常在 .c 文件的顶部):
+ *
+ * SMALL_VEC_DEFINE(ValueVec, value_vec, IRValueNode *, 8)
+ *
+ * ValueVec args;
+ * value_vec_init(&args, &scratch);
+ * value_vec_push(&args, v);
+ * ... value_vec_data(&args)[i] / value_vec_len(&args) ...
+ *
+ * 生成的函数 (prefix 为第二个参数):
+ * - prefix_init(vec, arena):      空向量，使用内联存储
+ * - prefix_push(vec, elem):       追加；Arena 分配失败 (OOM / 超出上限) 时返回 false
+ * - prefix_pop(vec):              移除并返回最后一个元素 (向量不能为空)
+ * - prefix_len / prefix_data / prefix_get / prefix_is_inline
+ * - prefix_clear(vec):            长度置 0，保留容量
+ * - prefix_truncate(vec, len):    缩短到 len 个元素
+ * - prefix_reserve(vec, cap):     保证容量至少为 cap，之后的 push 不再分配
+ * - prefix_shrink_to_fit(vec):    元素放得进内联存储时搬回去 (Arena 上的空间不会归还，
+ *                                 但之后的访问回到结构体内部)
+ *
+ * [!!] 内联存储时 data 指向结构体自身: 不要按值复制或移动一个 SmallVec，
+ * 只通过指针传递。
+ */
+
+/**
+ * @brief [内部] 把容量增长到至少 needed (所有实例共用)
+ *
+ * 从内联存储溢出时新分配并复制；已经在 Arena 上时用 bump_realloc。
+ * @return false 表示 Arena 分配失败 (向量保持不变)
+ */
+bool small_vec_grow(Bump *arena, void **data, size_t *capacity, const void *inline_data, size_t len, size_t needed,
+                    size_t elem_size, size_t align);
+
+#define SMALL_VEC_DEFINE(Name, prefix, T, N)                                                                           \
+  typedef struct Name                                                                                                  \
+  {                                                                                                                    \
+    Bump *arena;                                                                                                       \
+    T *data;                                                                                                           \
+    size_t len;                                                                                                        \
+    size_t capacity;                                                                                                   \
+    T inline_data[N];                                                                                                  \
+  } Name;                                                                                                              \
+                                                                                                                       \
+  static inline void prefix##_init(Name *vec, Bump *arena)                                                             \
+  {                                                                                                                    \
+    vec->arena = arena;                                                                                                \
+    vec->data = vec->inline_data;                                                                                      \
+    vec->len = 0;                                                                                                      \
+    vec->capacity = (N);                                                                                               \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline size_t prefix##_len(const Name *vec)                                                                   \
+  {                                                                                                                    \
+    return vec->len;                                                                                                   \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline T *prefix##_data(Name *vec)                                                                            \
+  {                                                                                                                    \
+    return vec->data;                                                                                                  \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline T prefix##_get(const Name *vec, size_t index)                                                          \
+  {                                                                                                                    \
+    assert(index < vec->len && "SmallVec index out of bounds");                                                        \
+    return vec->data[index];                                                                                           \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline bool prefix##_is_inline(const Name *vec)                                                               \
+  {                                                                                                                    \
+    return vec->data == vec->inline_data;                                                                              \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline bool prefix##_reserve(Name *vec, size_t capacity)                                                      \
+  {                                                                                                                    \
+    if (capacity <= vec->capacity)                                                                                     \
+      return true;                                                                                                     \
+    void *data = vec->data;                                                                                            \
+    if (!small_vec_grow(vec->arena, &data, &vec->capacity, vec->inline_data, vec->len, capacity, sizeof(T),            \
+                        _Alignof(T)))                                                                                  \
+      return false;                                                                                                    \
+    vec->data = (T *)data;                                                                                             \
+    return true;                                                                                                       \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline bool prefix##_push(Name *vec, T elem)                                                                  \
+  {                                                                                                                    \
+    if (vec->len == vec->capacity && !prefix##_reserve(vec, vec->len + 1))                                             \
+      return false;                                                                                                    \
+    vec->data[vec->len++] = elem;                                                                                      \
+    return true;                                                                                                       \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline T prefix##_pop(Name *vec)                                                                              \
+  {                                                                                                                    \
+    assert(vec->len > 0 && "SmallVec pop from empty vector");                                                          \
+    return vec->data[--vec->len];                                                                                      \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline void prefix##_clear(Name *vec)                                                                         \
+  {                                                                                                                    \
+    vec->len = 0;                                                                                                      \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline void prefix##_truncate(Name *vec, size_t len)                                                          \
+  {                                                                                                                    \
+    if (len < vec->len)                                                                                                \
+      vec->len = len;                                                                                                  \
+  }                                                                                                                    \
+                                                                                                                       \
+  static inline void prefix##_shrink_to_fit(Name *vec)                                                                 \
+  {                                                                                                                    \
+    if (prefix##_is_inline(vec) || vec->len > (N))                                                                     \
+      return;                                                                                                          \
+    for (size_t i = 0; i < vec->len; i++)                                                                              \
+      vec->inline_data[i] = vec->data[i];                                                                              \
+    vec->data = vec->inline_data;                                                                                      \
+    vec->capacity = (N);                                                                                               \
+  }
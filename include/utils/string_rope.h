@@ -0,0 +1,157 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "utils/bump.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * =================================================================
+ * --- 分块的字符串缓冲区 (Rope) ---
+ * =================================================================
+ *
+ * StringBuf 的文本总是连续的: 每次增长都用 bump_realloc 把整个缓冲区复制一遍，
+ * 旧的副本留在 Arena 里成为死空间 (打印 N 字节最多要占用约 3N 的 Arena)。
+ * StringRope 把文本放在一串 chunk 中: 当前 chunk 满了就在 Arena 上接一个新的，
+ * 已经写入的字节从不移动或复制，Arena 中只有文本本身和每个 chunk 末尾的少量空闲。
+ *
+ * 文本不连续时有三种用法:
+ * - string_rope_write / string_rope_writev: 直接把每个 chunk 写到 FILE* / 文件描述符
+ * - string_rope_iovec: 把 chunk 填成 struct iovec 数组，交给调用者自己的 writev
+ * - string_rope_flatten: 需要一个 '\0' 结尾的字符串时，按准确的长度复制一次
+ *
+ * 与 StringBuf 一样，所有内存属于 Arena；OOM 之后的追加被丢弃 (见 string_rope_failed)。
+ */
+
+/** @brief 第一个 chunk 的容量；之后每个 chunk 翻倍，直到 STRING_ROPE_MAX_CHUNK */
+#define STRING_ROPE_MIN_CHUNK 4096
+
+/** @brief 普通 chunk 的最大容量 (一次追加更长的片段时为它单独分配一个刚好放得下的 chunk) */
+#define STRING_ROPE_MAX_CHUNK (1024 * 1024)
+
+typedef struct StringRopeChunk StringRopeChunk;
+
+/** @brief Arena 上的一段文本 */
+struct StringRopeChunk
+{
+  StringRopeChunk *next;
+  size_t len;
+  size_t capacity;
+  char data[];
+};
+
+typedef struct StringRope
+{
+  Bump *arena;
+  StringRopeChunk *head;
+  StringRopeChunk *tail;
+  /** 所有 chunk 的字节数之和 */
+  size_t len;
+  size_t num_chunks;
+  /** 下一个 chunk 的容量 */
+  size_t next_capacity;
+  /** 有追加因为 OOM 被丢弃 */
+  bool failed;
+} StringRope;
+
+void string_rope_init(StringRope *rope, Bump *arena);
+
+/**
+ * @brief 销毁 StringRope (无操作，内存属于 Arena；与 string_buf_destroy 对称)
+ */
+void string_rope_destroy(StringRope *rope);
+
+void string_rope_append_bytes(StringRope *rope, const char *data, size_t len);
+void string_rope_append_str(StringRope *rope, const char *str);
+
+/**
+ * @brief 附加格式化的字符串 (va_list 版本)
+ *
+ * 放不进当前 chunk 剩余空间的结果直接格式化到新 chunk 中 (旧 chunk 的剩余空间留空)。
+ */
+void string_rope_vappend_fmt(StringRope *rope, const char *fmt, va_list args);
+void string_rope_append_fmt(StringRope *rope, const char *fmt, ...);
+
+/**
+ * @brief (内联) 文本的总长度
+ */
+static inline size_t
+string_rope_len(const StringRope *rope)
+{
+  return rope->len;
+}
+
+/**
+ * @brief (内联) 是否有追加因为 OOM 被丢弃 (此时文本不完整)
+ */
+static inline bool
+string_rope_failed(const StringRope *rope)
+{
+  return rope->failed;
+}
+
+/**
+ * @brief 把整个文本复制成 arena 上一个 '\0' 结尾的字符串 (一次分配，长度准确)
+ *
+ * arena 可以不是 rope 自己的 Arena: 例如在临时 Arena 上构建 rope，
+ * 展平到最终的 Arena 后销毁临时 Arena，最终的 Arena 中只留下这一份文本。
+ *
+ * @return char* 字符串；OOM 时返回 NULL
+ */
+char *string_rope_flatten(const StringRope *rope, Bump *arena);
+
+/**
+ * @brief 把文本依次写入 stream (每个 chunk 一次 fwrite，不复制)
+ *
+ * @return bool 所有字节都写出时返回 true
+ */
+bool string_rope_write(const StringRope *rope, FILE *stream);
+
+#if !defined(_WIN32)
+/** @brief 支持 string_rope_iovec / string_rope_writev (使用 iovec 的调用者自己包含 <sys/uio.h>) */
+#define STRING_ROPE_HAS_IOVEC 1
+
+struct iovec;
+
+/**
+ * @brief 从 *cursor 指向的 chunk 开始，把最多 max_iov 个非空 chunk 填入 iov
+ *
+ * 用法 (cursor 初始为 rope->head，返回 0 时所有 chunk 都已填过):
+ * StringRopeChunk *cursor = rope.head;
+ * struct iovec iov[64];
+ * size_t n;
+ * while ((n = string_rope_iovec(&rope, &cursor, iov, 64)) > 0)
+ *   ... writev(fd, iov, n) ...
+ *
+ * iov 只借用 chunk 中的文本，在 rope 的 Arena 被销毁或重置之前有效。
+ *
+ * @return size_t 填入的 iovec 个数
+ */
+size_t string_rope_iovec(const StringRope *rope, StringRopeChunk **cursor, struct iovec *iov, size_t max_iov);
+
+/**
+ * @brief 用 writev 把整个文本写入文件描述符 fd (分批提交，处理部分写入和 EINTR)
+ *
+ * @return bool 所有字节都写出时返回 true
+ */
+bool string_rope_writev(const StringRope *rope, int fd);
+#else
+#define STRING_ROPE_HAS_IOVEC 0
+#endif
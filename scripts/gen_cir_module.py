@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""
+生成合成的 .cir 模块，用于解析器 / 词法分析器的吞吐量基准 (tests/bench_parser.c)。
+
+用法:
+    python3 scripts/gen_cir_module.py --shape mixed -o build/bench_inputs/mixed.cir
+    python3 scripts/gen_cir_module.py --shape small --functions 50000 > many.cir
+
+形状 (--shape):
+    small    许多小函数 (--functions 个，每个十几条指令，调用前面的函数)
+    huge     少数巨大的函数 (--huge-functions 个，每个约 --huge-insts 条指令，
+             每 --block-insts 条指令换一个基本块)
+    phi      深的 phi 网: --phi-depth 个连续的菱形，每个汇合块有 --phi-width 个 phi
+    switch   宽的 switch: 每个函数一个 --switch-cases 路的 switch，汇合处一个同样宽的 phi
+    structs  许多结构体类型 (--structs 个，嵌套前面定义的结构体) 和访问它们的函数
+    mixed    以上全部 (各自的规模按比例缩小)
+
+输出只依赖参数 (固定的随机种子，可用 --seed 修改)，所以每次运行结果相同。
+生成的 IR 只使用解析器支持的写法: 值不前向引用 (phi 的入边都在前面定义)，
+只调用前面已经定义的函数。
+"""
+import argparse
+import random
+import sys
+
+
+class Emitter:
+    """按行收集输出，并为局部值分配唯一的名字"""
+
+    def __init__(self, rng):
+        self.rng = rng
+        self.lines = []
+        self.counter = 0
+
+    def emit(self, line):
+        self.lines.append(line)
+
+    def fresh(self, prefix="v"):
+        self.counter += 1
+        return f"%{prefix}{self.counter}"
+
+    def begin_function(self):
+        self.counter = 0
+
+
+def arith(em, ty, a, b):
+    """a op b 的一条随机整数运算，返回结果名"""
+    op = em.rng.choice(["add", "sub", "mul", "and", "or", "xor"])
+    res = em.fresh()
+    em.emit(f"  {res}: {ty} = {op} {a}: {ty}, {b}: {ty}")
+    return res
+
+
+def gen_small(em, count, prefix="small"):
+    """许多小函数：一个条件分支、一个 phi，偶尔调用前一个函数"""
+    for i in range(count):
+        em.begin_function()
+        em.emit(f"define i32 @{prefix}{i}(%a: i32, %b: i32) {{")
+        em.emit("$entry:")
+        x = arith(em, "i32", "%a", "%b")
+        y = arith(em, "i32", x, str(em.rng.randint(1, 1000)))
+        if i > 0 and i % 4 == 0:
+            call = em.fresh("c")
+            em.emit(f"  {call}: i32 = call <i32 (i32, i32)> @{prefix}{i - 1}({y}: i32, %b: i32)")
+            y = call
+        cmp = em.fresh("cmp")
+        em.emit(f"  {cmp}: i1 = icmp slt {y}: i32, %b: i32")
+        em.emit(f"  br {cmp}: i1, $then, $else")
+        em.emit("$then:")
+        t = arith(em, "i32", y, "%a")
+        em.emit("  br $merge")
+        em.emit("$else:")
+        e = arith(em, "i32", y, "%b")
+        em.emit("  br $merge")
+        em.emit("$merge:")
+        phi = em.fresh("phi")
+        em.emit(f"  {phi}: i32 = phi [ {t}: i32, $then ], [ {e}: i32, $else ]")
+        em.emit(f"  ret {phi}: i32")
+        em.emit("}")
+        em.emit("")
+
+
+def gen_huge(em, count, insts, block_insts=64, prefix="huge"):
+    """少数巨大的函数：长的算术链，每 block_insts 条指令换一个基本块"""
+    for f in range(count):
+        em.begin_function()
+        em.emit(f"define i64 @{prefix}{f}(%a: i64, %b: i64) {{")
+        em.emit("$entry:")
+        slot = em.fresh("slot")
+        em.emit(f"  {slot}: <i64> = alloc i64")
+        em.emit(f"  store %a: i64, {slot}: <i64>")
+        recent = ["%a", "%b"]
+        block = 0
+        for i in range(insts):
+            if i % block_insts == block_insts - 1:
+                block += 1
+                em.emit(f"  br $b{block}")
+                em.emit(f"$b{block}:")
+                continue
+            kind = i % 16
+            if kind == 7:
+                v = em.fresh()
+                em.emit(f"  {v}: i64 = load {slot}: <i64>")
+            elif kind == 15:
+                em.emit(f"  store {recent[-1]}: i64, {slot}: <i64>")
+                continue
+            elif kind == 11:
+                v = em.fresh()
+                em.emit(f"  {v}: i64 = shl {recent[-1]}: i64, {em.rng.randint(1, 7)}: i64")
+            else:
+                a = recent[-1]
+                b = em.rng.choice(recent[-8:] + [str(em.rng.randint(-500, 500))])
+                v = arith(em, "i64", a, b)
+            recent.append(v)
+        em.emit(f"  ret {recent[-1]}: i64")
+        em.emit("}")
+        em.emit("")
+
+
+def gen_phi_web(em, depth, width, name="phi_web"):
+    """depth 个连续的菱形；每个汇合块用 width 个 phi 合并两条路径上的值"""
+    em.begin_function()
+    em.emit(f"define i32 @{name}(%a: i32, %b: i32) {{")
+    em.emit("$entry:")
+    live = [arith(em, "i32", "%a", str(k + 1)) for k in range(width)]
+    em.emit("  br $d0")
+    for d in range(depth):
+        em.emit(f"$d{d}:")
+        cmp = em.fresh("cmp")
+        em.emit(f"  {cmp}: i1 = icmp sgt {live[d % width]}: i32, %b: i32")
+        em.emit(f"  br {cmp}: i1, $l{d}, $r{d}")
+        em.emit(f"$l{d}:")
+        left = [arith(em, "i32", v, live[(k + 1) % width]) for k, v in enumerate(live)]
+        em.emit(f"  br $m{d}")
+        em.emit(f"$r{d}:")
+        right = [arith(em, "i32", v, "%b") for v in live]
+        em.emit(f"  br $m{d}")
+        em.emit(f"$m{d}:")
+        merged = []
+        for k in range(width):
+            phi = em.fresh("p")
+            em.emit(f"  {phi}: i32 = phi [ {left[k]}: i32, $l{d} ], [ {right[k]}: i32, $r{d} ]")
+            merged.append(phi)
+        live = merged
+        em.emit(f"  br $d{d + 1}")
+    em.emit(f"$d{depth}:")
+    acc = live[0]
+    for v in live[1:]:
+        acc = arith(em, "i32", acc, v)
+    em.emit(f"  ret {acc}: i32")
+    em.emit("}")
+    em.emit("")
+
+
+def gen_switch(em, count, cases, prefix="switch"):
+    """每个函数一个 cases 路的 switch，所有分支在同一个块汇合"""
+    for f in range(count):
+        em.begin_function()
+        em.emit(f"define i32 @{prefix}{f}(%x: i32, %y: i32) {{")
+        em.emit("$entry:")
+        em.emit("  switch %x: i32, default $default [")
+        for c in range(cases):
+            em.emit(f"    {c * 3}: i32, $case{c}")
+        em.emit("  ]")
+        incoming = []
+        for c in range(cases):
+            em.emit(f"$case{c}:")
+            v = arith(em, "i32", "%y", str(c + 1))
+            em.emit("  br $merge")
+            incoming.append((v, f"$case{c}"))
+        em.emit("$default:")
+        em.emit("  br $merge")
+        incoming.append(("%y", "$default"))
+        em.emit("$merge:")
+        phi = em.fresh("phi")
+        edges = ", ".join(f"[ {v}: i32, {bb} ]" for v, bb in incoming)
+        em.emit(f"  {phi}: i32 = phi {edges}")
+        em.emit(f"  ret {phi}: i32")
+        em.emit("}")
+        em.emit("")
+
+
+def gen_structs(em, count, prefix="S"):
+    """count 个结构体 (第一个字段总是 i32，部分嵌套前面的结构体) 和访问它们的函数"""
+    nested = {}
+    for i in range(count):
+        fields = ["i32", em.rng.choice(["i64", "f64", "i8", "i16"])]
+        if i > 0 and em.rng.random() < 0.7:
+            inner = em.rng.randrange(i)
+            nested[i] = (len(fields), inner)
+            fields.append(f"%{prefix}{inner}")
+        fields += [em.rng.choice(["i32", "f32", "<i8>", "[4 x i32]"]) for _ in range(em.rng.randint(0, 4))]
+        em.emit(f"%{prefix}{i} = type {{ {', '.join(fields)} }}")
+    em.emit("")
+
+    for i in range(count):
+        em.begin_function()
+        em.emit(f"define i32 @use_{prefix}{i}(%v: i32) {{")
+        em.emit("$entry:")
+        obj = em.fresh("obj")
+        em.emit(f"  {obj}: <%{prefix}{i}> = alloc %{prefix}{i}")
+        field = em.fresh("f")
+        em.emit(f"  {field}: <i32> = gep {obj}: <%{prefix}{i}>, 0: i32, 0: i32")
+        em.emit(f"  store %v: i32, {field}: <i32>")
+        result = em.fresh("r")
+        em.emit(f"  {result}: i32 = load {field}: <i32>")
+        if i in nested:
+            index, inner = nested[i]
+            sub = em.fresh("sub")
+            em.emit(f"  {sub}: <%{prefix}{inner}> = gep inbounds {obj}: <%{prefix}{i}>, 0: i32, {index}: i32")
+            inner_field = em.fresh("f")
+            em.emit(f"  {inner_field}: <i32> = gep {sub}: <%{prefix}{inner}>, 0: i32, 0: i32")
+            inner_val = em.fresh("r")
+            em.emit(f"  {inner_val}: i32 = load {inner_field}: <i32>")
+            result = arith(em, "i32", result, inner_val)
+        em.emit(f"  ret {result}: i32")
+        em.emit("}")
+        em.emit("")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a synthetic .cir module for parser benchmarks.")
+    parser.add_argument("--shape", choices=["small", "huge", "phi", "switch", "structs", "mixed"], default="mixed")
+    parser.add_argument("--functions", type=int, default=20000, help="number of small functions")
+    parser.add_argument("--huge-functions", type=int, default=4, help="number of huge functions")
+    parser.add_argument("--huge-insts", type=int, default=60000, help="instructions per huge function")
+    parser.add_argument("--block-insts", type=int, default=64, help="instructions per block in huge functions")
+    parser.add_argument("--phi-depth", type=int, default=2000, help="diamonds in the phi web")
+    parser.add_argument("--phi-width", type=int, default=16, help="phis per merge block")
+    parser.add_argument("--switch-functions", type=int, default=200, help="functions with a wide switch")
+    parser.add_argument("--switch-cases", type=int, default=512, help="cases per switch")
+    parser.add_argument("--structs", type=int, default=5000, help="number of struct types")
+    parser.add_argument("--seed", type=int, default=2025)
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    em = Emitter(random.Random(args.seed))
+    em.emit(f'module = "synthetic_{args.shape}"')
+    em.emit("")
+
+    shape = args.shape
+    if shape == "structs":
+        gen_structs(em, args.structs)
+    elif shape == "small":
+        gen_small(em, args.functions)
+    elif shape == "huge":
+        gen_huge(em, args.huge_functions, args.huge_insts, args.block_insts)
+    elif shape == "phi":
+        gen_phi_web(em, args.phi_depth, args.phi_width)
+    elif shape == "switch":
+        gen_switch(em, args.switch_functions, args.switch_cases)
+    else:
+        # 类型定义必须在使用它们的函数之前
+        gen_structs(em, args.structs // 4)
+        gen_small(em, args.functions // 4)
+        gen_huge(em, max(1, args.huge_functions // 4), args.huge_insts)
+        gen_phi_web(em, args.phi_depth // 4, args.phi_width)
+        gen_switch(em, args.switch_functions // 4, args.switch_cases)
+
+    text = "\n".join(em.lines) + "\n"
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
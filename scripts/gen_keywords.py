@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+生成 src/ir/lexer_keywords.inc: IR 词法分析器的关键字完美哈希表。
+
+用法:
+    python3 scripts/gen_keywords.py          # 重新生成
+    python3 scripts/gen_keywords.py --check  # 只检查已提交的文件是否最新 (CI)
+
+修改关键字时只需编辑下面的 KEYWORDS 列表并重新运行此脚本。
+哈希函数 (必须与生成的 keyword_hash 保持一致):
+
+    h = len
+    for c in s: h = (h * MUL + c) mod 2^32
+    slot = (h * MIX mod 2^32) >> (32 - TABLE_BITS)
+
+脚本用固定的随机种子搜索 (MUL, MIX)，直到所有关键字落在不同的槽位，
+因此每次运行的输出都相同。
+"""
+import random
+import sys
+from pathlib import Path
+
+# (拼写, TokenType)
+KEYWORDS = [
+    # 顶级关键字
+    ("module", "TK_KW_MODULE"),
+    ("define", "TK_KW_DEFINE"),
+    ("declare", "TK_KW_DECLARE"),
+    ("global", "TK_KW_GLOBAL"),
+    ("type", "TK_KW_TYPE"),
+    # 终结者指令
+    ("ret", "TK_KW_RET"),
+    ("br", "TK_KW_BR"),
+    ("switch", "TK_KW_SWITCH"),
+    ("default", "TK_KW_DEFAULT"),
+    # 二元运算
+    ("add", "TK_KW_ADD"),
+    ("sub", "TK_KW_SUB"),
+    ("mul", "TK_KW_MUL"),
+    ("udiv", "TK_KW_UDIV"),
+    ("sdiv", "TK_KW_SDIV"),
+    ("urem", "TK_KW_UREM"),
+    ("srem", "TK_KW_SREM"),
+    ("fadd", "TK_KW_FADD"),
+    ("fsub", "TK_KW_FSUB"),
+    ("fmul", "TK_KW_FMUL"),
+    ("fdiv", "TK_KW_FDIV"),
+    ("shl", "TK_KW_SHL"),
+    ("lshr", "TK_KW_LSHR"),
+    ("ashr", "TK_KW_ASHR"),
+    ("and", "TK_KW_AND"),
+    ("or", "TK_KW_OR"),
+    ("xor", "TK_KW_XOR"),
+    # 内存和比较
+    ("alloc", "TK_KW_ALLOCA"),
+    ("load", "TK_KW_LOAD"),
+    ("store", "TK_KW_STORE"),
+    ("gep", "TK_KW_GEP"),
+    ("inbounds", "TK_KW_INBOUNDS"),
+    ("icmp", "TK_KW_ICMP"),
+    ("fcmp", "TK_KW_FCMP"),
+    # 类型转换
+    ("trunc", "TK_KW_TRUNC"),
+    ("zext", "TK_KW_ZEXT"),
+    ("sext", "TK_KW_SEXT"),
+    ("fptrunc", "TK_KW_FPTRUNC"),
+    ("fpext", "TK_KW_FPEXT"),
+    ("fptoui", "TK_KW_FPTOUI"),
+    ("fptosi", "TK_KW_FPTOSI"),
+    ("uitofp", "TK_KW_UITOFP"),
+    ("sitofp", "TK_KW_SITOFP"),
+    ("ptrtoint", "TK_KW_PTRTOINT"),
+    ("inttoptr", "TK_KW_INTTOPTR"),
+    ("bitcast", "TK_KW_BITCAST"),
+    ("to", "TK_KW_TO"),
+    # 常量关键字
+    ("undef", "TK_KW_UNDEF"),
+    ("null", "TK_KW_NULL"),
+    ("zeroinitializer", "TK_KW_ZEROINITIALIZER"),
+    ("void", "TK_KW_VOID"),
+    ("true", "TK_KW_TRUE"),
+    ("false", "TK_KW_FALSE"),
+    # 其他
+    ("phi", "TK_KW_PHI"),
+    ("call", "TK_KW_CALL"),
+    ("select", "TK_KW_SELECT"),
+    # ICMP / FCMP 谓词
+    ("eq", "TK_KW_EQ"),
+    ("ne", "TK_KW_NE"),
+    ("ugt", "TK_KW_UGT"),
+    ("uge", "TK_KW_UGE"),
+    ("ult", "TK_KW_ULT"),
+    ("ule", "TK_KW_ULE"),
+    ("sgt", "TK_KW_SGT"),
+    ("sge", "TK_KW_SGE"),
+    ("slt", "TK_KW_SLT"),
+    ("sle", "TK_KW_SLE"),
+    ("oeq", "TK_KW_OEQ"),
+    ("ogt", "TK_KW_OGT"),
+    ("oge", "TK_KW_OGE"),
+    ("olt", "TK_KW_OLT"),
+    ("ole", "TK_KW_OLE"),
+    ("one", "TK_KW_ONE"),
+    ("ord", "TK_KW_ORD"),
+    ("ueq", "TK_KW_UEQ"),
+    ("une", "TK_KW_UNE"),
+    ("uno", "TK_KW_UNO"),
+]
+
+TABLE_BITS = 9
+SEED = 2025
+OUTPUT = Path(__file__).resolve().parent.parent / "src" / "ir" / "lexer_keywords.inc"
+
+MASK32 = 0xFFFFFFFF
+
+
+def slot_of(word, mul, mix):
+    h = len(word)
+    for c in word.encode():
+        h = (h * mul + c) & MASK32
+    return ((h * mix) & MASK32) >> (32 - TABLE_BITS)
+
+
+def find_parameters():
+    rng = random.Random(SEED)
+    for _ in range(1_000_000):
+        mul = rng.randrange(3, 256) | 1
+        mix = rng.getrandbits(32) | 1
+        slots = {slot_of(w, mul, mix) for w, _ in KEYWORDS}
+        if len(slots) == len(KEYWORDS):
+            return mul, mix
+    sys.exit("gen_keywords.py: no perfect hash found; increase TABLE_BITS")
+
+
+def render(mul, mix):
+    table = [0] * (1 << TABLE_BITS)
+    for i, (word, _) in enumerate(KEYWORDS):
+        table[slot_of(word, mul, mix)] = i + 1
+    max_len = max(len(w) for w, _ in KEYWORDS)
+
+    out = []
+    out.append("/*\n")
+    out.append(" * ir/lexer_keywords.inc\n")
+    out.append(" *\n")
+    out.append(" * [!!] 由 scripts/gen_keywords.py 生成，请勿手工修改。\n")
+    out.append(" *\n")
+    out.append(" * IR 关键字的完美哈希表: keyword_hash 把每个关键字映射到 KEYWORD_SLOTS 中不同的槽位，\n")
+    out.append(" * 槽位中存放 KEYWORD_ENTRIES 的下标 + 1 (0 表示空槽)。由 lexer.c 包含。\n")
+    out.append(" */\n\n")
+    out.append(f"#define KEYWORD_MAX_LEN {max_len}\n")
+    out.append(f"#define KEYWORD_TABLE_BITS {TABLE_BITS}\n")
+    out.append(f"#define KEYWORD_HASH_MUL {mul}u\n")
+    out.append(f"#define KEYWORD_HASH_MIX 0x{mix:08x}u\n\n")
+    out.append("typedef struct KeywordEntry\n{\n  const char *name;\n  uint8_t len;\n  TokenType type;\n} KeywordEntry;\n\n")
+    out.append("static const KeywordEntry KEYWORD_ENTRIES[] = {\n")
+    for word, token in KEYWORDS:
+        out.append(f'  {{"{word}", {len(word)}, {token}}},\n')
+    out.append("};\n\n")
+    out.append(f"static const uint8_t KEYWORD_SLOTS[{1 << TABLE_BITS}] = {{\n")
+    for row in range(0, len(table), 16):
+        out.append("  " + ", ".join(f"{v:2d}" for v in table[row : row + 16]) + ",\n")
+    out.append("};\n\n")
+    out.append("/**\n * @brief 关键字的完美哈希 (只对长度不超过 KEYWORD_MAX_LEN 的切片调用)\n */\n")
+    out.append("static inline uint32_t\nkeyword_hash(const char *s, size_t len)\n{\n")
+    out.append("  uint32_t h = (uint32_t)len;\n")
+    out.append("  for (size_t i = 0; i < len; i++)\n")
+    out.append("    h = h * KEYWORD_HASH_MUL + (unsigned char)s[i];\n")
+    out.append("  return (h * KEYWORD_HASH_MIX) >> (32 - KEYWORD_TABLE_BITS);\n")
+    out.append("}\n")
+    return "".join(out)
+
+
+def main():
+    assert len(KEYWORDS) < 256, "KEYWORD_SLOTS stores indexes as uint8_t"
+    assert len({w for w, _ in KEYWORDS}) == len(KEYWORDS), "duplicate keyword"
+    mul, mix = find_parameters()
+    text = render(mul, mix)
+
+    if "--check" in sys.argv[1:]:
+        if not OUTPUT.exists() or OUTPUT.read_text(encoding="utf-8") != text:
+            print(f"{OUTPUT} is out of date; run 'make keywords'.")
+            return 1
+        print("Keyword table is up to date.")
+        return 0
+
+    OUTPUT.write_text(text, encoding="utf-8")
+    print(f"Wrote {OUTPUT} ({len(KEYWORDS)} keywords, MUL={mul}, MIX=0x{mix:08x}).")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
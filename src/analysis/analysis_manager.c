@@ -0,0 +1,344 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysis/analysis_manager.h"
+#include "ir/module.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief 一个函数的缓存: 每种分析一个结果和一个 Arena
+ */
+typedef struct FunctionAnalyses
+{
+  IDList list_node;
+  IRFunction *func;
+  /// 当前有效的分析 (结果可能是 NULL，例如没有基本块时)
+  IRAnalysisSet valid;
+  void *results[IR_ANALYSIS_COUNT];
+  Bump arenas[IR_ANALYSIS_COUNT];
+} FunctionAnalyses;
+
+struct IRAnalysisManager
+{
+  /// FunctionAnalyses 本身和 func_map 的存储
+  Bump arena;
+  /// IRFunction* -> FunctionAnalyses*
+  PtrHashMap *func_map;
+  /// 所有 FunctionAnalyses (销毁时逐个释放它们的 Arena)
+  IDList functions;
+  size_t num_computed[IR_ANALYSIS_COUNT];
+};
+
+/*
+ * =================================================================
+ * --- 分析表 ---
+ * =================================================================
+ */
+
+static void *
+compute_cfg(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  (void)am;
+  return cfg_build(func, arena);
+}
+
+static void
+destroy_cfg(void *result)
+{
+  cfg_destroy(result);
+}
+
+static void *
+compute_dom_tree(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  FunctionCFG *cfg = ir_analysis_get_cfg(am, func);
+  return cfg ? dom_tree_build(cfg, arena) : NULL;
+}
+
+static void *
+compute_dom_frontier(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  DominatorTree *dt = ir_analysis_get_dom_tree(am, func);
+  return dt ? ir_analysis_dom_frontier_compute(dt, arena) : NULL;
+}
+
+static void *
+compute_post_dom_tree(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  FunctionCFG *cfg = ir_analysis_get_cfg(am, func);
+  return cfg ? post_dom_tree_build(cfg, arena) : NULL;
+}
+
+static void
+destroy_post_dom_tree(void *result)
+{
+  post_dom_tree_destroy(result);
+}
+
+static void *
+compute_post_dom_frontier(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  PostDominatorTree *pdt = ir_analysis_get_post_dom_tree(am, func);
+  return pdt ? post_dom_frontier_compute(pdt, arena) : NULL;
+}
+
+static void *
+compute_loops(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  DominatorTree *dt = ir_analysis_get_dom_tree(am, func);
+  return dt ? loop_info_compute(dt, arena) : NULL;
+}
+
+static void *
+compute_liveness(IRAnalysisManager *am, IRFunction *func, Bump *arena)
+{
+  FunctionCFG *cfg = ir_analysis_get_cfg(am, func);
+  return cfg ? liveness_compute(cfg, arena) : NULL;
+}
+
+/**
+ * @brief 一种分析: 它直接依赖的分析、计算函数和 (可选的) 额外的释放函数
+ *
+ * 结果分配在传入的 Arena 中；destroy 只负责 Arena 之外的资源 (例如 CFG 内部的 Arena)。
+ */
+typedef struct AnalysisInfo
+{
+  IRAnalysisSet depends;
+  void *(*compute)(IRAnalysisManager *am, IRFunction *func, Bump *arena);
+  void (*destroy)(void *result);
+} AnalysisInfo;
+
+static const AnalysisInfo ANALYSES[IR_ANALYSIS_COUNT] = {
+  [IR_ANALYSIS_CFG] = {0, compute_cfg, destroy_cfg},
+  [IR_ANALYSIS_DOM_TREE] = {IR_ANALYSIS_BIT(IR_ANALYSIS_CFG), compute_dom_tree, NULL},
+  [IR_ANALYSIS_DOM_FRONTIER] = {IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_TREE), compute_dom_frontier, NULL},
+  [IR_ANALYSIS_POST_DOM_TREE] = {IR_ANALYSIS_BIT(IR_ANALYSIS_CFG), compute_post_dom_tree, destroy_post_dom_tree},
+  [IR_ANALYSIS_POST_DOM_FRONTIER] = {IR_ANALYSIS_BIT(IR_ANALYSIS_POST_DOM_TREE), compute_post_dom_frontier, NULL},
+  [IR_ANALYSIS_LOOPS] = {IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_TREE), compute_loops, NULL},
+  [IR_ANALYSIS_LIVENESS] = {IR_ANALYSIS_BIT(IR_ANALYSIS_CFG), compute_liveness, NULL},
+};
+
+/*
+ * =================================================================
+ * --- 缓存 ---
+ * =================================================================
+ */
+
+IRAnalysisManager *
+ir_analysis_manager_create(void)
+{
+  IRAnalysisManager *am = calloc(1, sizeof(IRAnalysisManager));
+  if (!am)
+    return NULL;
+  bump_init(&am->arena);
+  am->func_map = ptr_hashmap_create(&am->arena, 16);
+  list_init(&am->functions);
+  if (!am->func_map)
+  {
+    bump_destroy(&am->arena);
+    free(am);
+    return NULL;
+  }
+  return am;
+}
+
+/**
+ * @brief [内部] 释放一种分析的结果并重置它的 Arena
+ */
+static void
+drop_result(FunctionAnalyses *fa, IRAnalysisKind kind)
+{
+  if (!(fa->valid & IR_ANALYSIS_BIT(kind)))
+    return;
+  if (fa->results[kind] && ANALYSES[kind].destroy)
+    ANALYSES[kind].destroy(fa->results[kind]);
+  fa->results[kind] = NULL;
+  fa->valid &= ~IR_ANALYSIS_BIT(kind);
+  bump_reset(&fa->arenas[kind]);
+}
+
+static void
+release_function(FunctionAnalyses *fa)
+{
+  for (int kind = 0; kind < IR_ANALYSIS_COUNT; kind++)
+  {
+    drop_result(fa, (IRAnalysisKind)kind);
+    bump_destroy(&fa->arenas[kind]);
+  }
+}
+
+void
+ir_analysis_manager_destroy(IRAnalysisManager *am)
+{
+  if (!am)
+    return;
+  IDList *iter;
+  list_for_each(&am->functions, iter)
+  {
+    release_function(list_entry(iter, FunctionAnalyses, list_node));
+  }
+  bump_destroy(&am->arena);
+  free(am);
+}
+
+static FunctionAnalyses *
+find_function(const IRAnalysisManager *am, IRFunction *func)
+{
+  return ptr_hashmap_get(am->func_map, func);
+}
+
+static FunctionAnalyses *
+get_or_create_function(IRAnalysisManager *am, IRFunction *func)
+{
+  FunctionAnalyses *fa = find_function(am, func);
+  if (fa)
+    return fa;
+
+  fa = BUMP_ALLOC_ZEROED(&am->arena, FunctionAnalyses);
+  if (!fa || !ptr_hashmap_put(am->func_map, func, fa))
+    return NULL;
+  fa->func = func;
+  for (int kind = 0; kind < IR_ANALYSIS_COUNT; kind++)
+    bump_init(&fa->arenas[kind]);
+  list_add_tail(&am->functions, &fa->list_node);
+  return fa;
+}
+
+void *
+ir_analysis_get(IRAnalysisManager *am, IRFunction *func, IRAnalysisKind kind)
+{
+  FunctionAnalyses *fa = get_or_create_function(am, func);
+  if (!fa)
+    return NULL;
+  if (fa->valid & IR_ANALYSIS_BIT(kind))
+    return fa->results[kind];
+
+  if (!ir_function_is_materialized(func) && !ir_function_materialize(func))
+    return NULL;
+
+  /// 没有基本块的函数 (声明) 没有任何分析结果；也记为有效，避免反复尝试
+  void *result = NULL;
+  if (!list_empty(&func->basic_blocks))
+  {
+    result = ANALYSES[kind].compute(am, func, &fa->arenas[kind]);
+    am->num_computed[kind]++;
+  }
+  fa->results[kind] = result;
+  fa->valid |= IR_ANALYSIS_BIT(kind);
+  return result;
+}
+
+FunctionCFG *
+ir_analysis_get_cfg(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_CFG);
+}
+
+DominatorTree *
+ir_analysis_get_dom_tree(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_DOM_TREE);
+}
+
+DominanceFrontier *
+ir_analysis_get_dom_frontier(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_DOM_FRONTIER);
+}
+
+PostDominatorTree *
+ir_analysis_get_post_dom_tree(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_POST_DOM_TREE);
+}
+
+DominanceFrontier *
+ir_analysis_get_post_dom_frontier(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_POST_DOM_FRONTIER);
+}
+
+LoopInfo *
+ir_analysis_get_loops(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_LOOPS);
+}
+
+Liveness *
+ir_analysis_get_liveness(IRAnalysisManager *am, IRFunction *func)
+{
+  return ir_analysis_get(am, func, IR_ANALYSIS_LIVENESS);
+}
+
+bool
+ir_analysis_is_cached(IRAnalysisManager *am, IRFunction *func, IRAnalysisKind kind)
+{
+  FunctionAnalyses *fa = find_function(am, func);
+  return fa && (fa->valid & IR_ANALYSIS_BIT(kind));
+}
+
+void
+ir_analysis_invalidate(IRAnalysisManager *am, IRFunction *func, IRAnalysisSet preserved)
+{
+  FunctionAnalyses *fa = find_function(am, func);
+  if (!fa)
+    return;
+
+  /// 依赖只指向编号更小的分析，所以按编号顺序一遍就能传递失效
+  IRAnalysisSet lost = 0;
+  for (int kind = 0; kind < IR_ANALYSIS_COUNT; kind++)
+  {
+    if (!(preserved & IR_ANALYSIS_BIT(kind)) || (ANALYSES[kind].depends & lost))
+      lost |= IR_ANALYSIS_BIT(kind);
+  }
+  /// 倒着释放: 依赖者先于被依赖者
+  for (int kind = IR_ANALYSIS_COUNT - 1; kind >= 0; kind--)
+  {
+    if (lost & IR_ANALYSIS_BIT(kind))
+      drop_result(fa, (IRAnalysisKind)kind);
+  }
+}
+
+void
+ir_analysis_invalidate_module(IRAnalysisManager *am, IRModule *mod, IRAnalysisSet preserved)
+{
+  IDList *iter;
+  list_for_each(&mod->functions, iter)
+  {
+    ir_analysis_invalidate(am, list_entry(iter, IRFunction, list_node), preserved);
+  }
+}
+
+void
+ir_analysis_forget(IRAnalysisManager *am, IRFunction *func)
+{
+  FunctionAnalyses *fa = find_function(am, func);
+  if (!fa)
+    return;
+  release_function(fa);
+  list_del(&fa->list_node);
+  ptr_hashmap_remove(am->func_map, func);
+}
+
+size_t
+ir_analysis_num_computed(const IRAnalysisManager *am, IRAnalysisKind kind)
+{
+  return am->num_computed[kind];
+}
@@ -15,10 +15,13 @@
  */
 
 #include "analysis/cfg.h"
+#include "ir/function.h"
 #include "ir/instruction.h"
+#include "ir/module.h"
 #include "ir/use.h"
 #include "ir/value.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
 
 /**
  * @brief 获取指令的第 N 个操作数 (ValueNode)
@@ -26,40 +29,70 @@
 static inline IRValueNode *
 get_operand(IRInstruction *inst, int index)
 {
-  int i = 0;
-  IDList *iter_node;
-  list_for_each(&inst->operands, iter_node)
-  {
-    if (i == index)
-    {
-      IRUse *use = list_entry(iter_node, IRUse, user_node);
-      return use->value;
-    }
-    i++;
-  }
-  return NULL;
+  return ir_instruction_get_operand(inst, (size_t)index);
 }
 
 /**
- * @brief [内部] 向 CFG 添加一条边 (使用你的 bump.h API)
+ * @brief [内部] 把终结指令的目标块 (同一目标只算一次) 的节点 id 写入 targets
+ *
+ * br 的目标是操作数 0；cond_br 是 1、2；switch 是 default (1) 和各 case (3, 5, 7...)。
+ * 去重用 seen: seen[id] == stamp 表示这个终结指令已经见过 id (每次调用用不同的 stamp)。
+ * 不在 CFG 中的目标被忽略。
+ *
+ * @return 目标数 (targets 至少要能放下终结指令的操作数个数)
  */
-static void
-cfg_add_edge(FunctionCFG *cfg, CFGNode *from, CFGNode *to)
+static int
+terminator_targets(FunctionCFG *cfg, IRBasicBlock *bb, int *targets, int *seen, int stamp)
 {
-  if (!from || !to)
-    return;
+  if (list_empty(&bb->instructions))
+    return 0;
 
-  CFGEdge *succ_edge = BUMP_ALLOC(&cfg->arena, CFGEdge);
-  succ_edge->node = to;
-  list_add_tail(&from->successors, &succ_edge->list_node);
+  IRInstruction *term = list_entry(bb->instructions.prev, IRInstruction, list_node);
+  int first = 0;
+  int step = 1;
+  switch (term->opcode)
+  {
+  case IR_OP_BR:
+    break;
+  case IR_OP_COND_BR:
+    first = 1;
+    break;
+  case IR_OP_SWITCH:
+    first = 1;
+    step = 2;
+    break;
+  case IR_OP_RET:
+  default:
+    return 0;
+  }
 
-  CFGEdge *pred_edge = BUMP_ALLOC(&cfg->arena, CFGEdge);
-  pred_edge->node = from;
-  list_add_tail(&to->predecessors, &pred_edge->list_node);
+  int op_count = term->opcode == IR_OP_BR ? 1 : (int)ir_instruction_get_num_operands(term);
+  int count = 0;
+  for (int op = first; op < op_count; op += step)
+  {
+    CFGNode *target = cfg_get_node(cfg, (IRBasicBlock *)get_operand(term, op));
+    if (!target || seen[target->id] == stamp)
+      continue;
+    seen[target->id] = stamp;
+    targets[count++] = target->id;
+  }
+  return count;
 }
 
-FunctionCFG *
-cfg_build(IRFunction *func, Bump *arena)
+/**
+ * @brief [内部] 终结指令的操作数个数 (目标数的上界)
+ */
+static int
+terminator_num_operands(IRBasicBlock *bb)
+{
+  if (list_empty(&bb->instructions))
+    return 0;
+  IRInstruction *term = list_entry(bb->instructions.prev, IRInstruction, list_node);
+  return (int)ir_instruction_get_num_operands(term);
+}
+
+static FunctionCFG *
+cfg_build_untimed(IRFunction *func, Bump *arena)
 {
 
   FunctionCFG *cfg = BUMP_ALLOC_ZEROED(arena, FunctionCFG);
@@ -68,13 +101,17 @@ cfg_build(IRFunction *func, Bump *arena)
   bump_init(&cfg->arena);
 
   cfg->num_nodes = 0;
+  int max_operands = 0;
   IDList *bb_it;
   list_for_each(&func->basic_blocks, bb_it)
   {
-    cfg->num_nodes++;
+    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+    bb->id = cfg->num_nodes++;
+    int num_operands = terminator_num_operands(bb);
+    if (num_operands > max_operands)
+      max_operands = num_operands;
   }
-
-  cfg->block_to_node_map = ptr_hashmap_create(&cfg->arena, cfg->num_nodes);
+  cfg->capacity = cfg->num_nodes;
 
   if (cfg->num_nodes == 0)
   {
@@ -84,82 +121,183 @@ cfg_build(IRFunction *func, Bump *arena)
     return cfg;
   }
 
-  cfg->nodes = BUMP_ALLOC_SLICE(&cfg->arena, CFGNode, cfg->num_nodes);
-
+  cfg->nodes = BUMP_ALLOC_SLICE_ZEROED(&cfg->arena, CFGNode, cfg->num_nodes);
   int current_id = 0;
   list_for_each(&func->basic_blocks, bb_it)
   {
-    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
     CFGNode *node = &cfg->nodes[current_id];
+    node->block = list_entry(bb_it, IRBasicBlock, list_node);
+    node->id = current_id++;
+  }
+  cfg->entry_node = &cfg->nodes[0];
 
-    node->block = bb;
-    node->id = current_id;
-
-    list_init(&node->successors);
-    list_init(&node->predecessors);
-
-    if (current_id == 0)
-    {
-      cfg->entry_node = node;
-    }
-
-    ptr_hashmap_put(cfg->block_to_node_map, bb, node);
+  /// 临时缓冲区: 一个终结指令的目标，和去重用的标记 (两遍用不同的 stamp)
+  int *targets = BUMP_ALLOC_SLICE(&cfg->arena, int, max_operands + 1);
+  int *seen = BUMP_ALLOC_SLICE(&cfg->arena, int, cfg->num_nodes);
+  for (int i = 0; i < cfg->num_nodes; i++)
+    seen[i] = -1;
 
-    current_id++;
+  /// 第一遍: 数出每个节点的后继和前驱个数
+  int num_edges = 0;
+  for (int i = 0; i < cfg->num_nodes; i++)
+  {
+    CFGNode *node = &cfg->nodes[i];
+    int count = terminator_targets(cfg, node->block, targets, seen, i);
+    node->num_succs = count;
+    num_edges += count;
+    for (int k = 0; k < count; k++)
+      cfg->nodes[targets[k]].num_preds++;
   }
 
+  /// 第二遍: 在两块连续的数组中按节点顺序分配，再填入后继和前驱 (前驱按来源的 id 排列)
+  int *succ_ids = BUMP_ALLOC_SLICE(&cfg->arena, int, num_edges > 0 ? num_edges : 1);
+  int *pred_ids = BUMP_ALLOC_SLICE(&cfg->arena, int, num_edges > 0 ? num_edges : 1);
+  int succ_offset = 0;
+  int pred_offset = 0;
   for (int i = 0; i < cfg->num_nodes; i++)
   {
-    CFGNode *current_node = &cfg->nodes[i];
-    IRBasicBlock *bb = current_node->block;
-
-    if (list_empty(&bb->instructions))
-    {
-      continue;
-    }
-
-    IRInstruction *term = list_entry(bb->instructions.prev, IRInstruction, list_node);
+    CFGNode *node = &cfg->nodes[i];
+    node->succs = succ_ids + succ_offset;
+    node->succ_capacity = node->num_succs;
+    succ_offset += node->num_succs;
+    node->preds = pred_ids + pred_offset;
+    node->pred_capacity = node->num_preds;
+    pred_offset += node->num_preds;
+    node->num_preds = 0;
+  }
 
-    switch (term->opcode)
+  for (int i = 0; i < cfg->num_nodes; i++)
+  {
+    CFGNode *node = &cfg->nodes[i];
+    int count = terminator_targets(cfg, node->block, node->succs, seen, cfg->num_nodes + i);
+    for (int k = 0; k < count; k++)
     {
-    case IR_OP_BR: {
-      IRValueNode *target_val = get_operand(term, 0);
-
-      IRBasicBlock *target_bb = (IRBasicBlock *)target_val;
-      CFGNode *target_node = cfg_get_node(cfg, target_bb);
-
-      cfg_add_edge(cfg, current_node, target_node);
-      break;
+      CFGNode *target = &cfg->nodes[node->succs[k]];
+      target->preds[target->num_preds++] = node->id;
     }
+  }
 
-    case IR_OP_COND_BR: {
-
-      IRValueNode *true_val = get_operand(term, 1);
-      IRBasicBlock *true_bb = (IRBasicBlock *)true_val;
-      CFGNode *true_node = cfg_get_node(cfg, true_bb);
-
-      cfg_add_edge(cfg, current_node, true_node);
+  return cfg;
+}
 
-      IRValueNode *false_val = get_operand(term, 2);
-      IRBasicBlock *false_bb = (IRBasicBlock *)false_val;
-      CFGNode *false_node = cfg_get_node(cfg, false_bb);
+FunctionCFG *
+cfg_build(IRFunction *func, Bump *arena)
+{
+  INSTRUMENT_BEGIN(scope, "cfg", func->parent ? func->parent->name : NULL, func->entry_address.name);
+  FunctionCFG *cfg = cfg_build_untimed(func, arena);
+  INSTRUMENT_END(scope);
+  return cfg;
+}
 
-      if (true_node != false_node)
+/**
+ * @brief [内部] 在反向 CFG 中从 start 出发做 DFS (沿正向的前驱)，标记 visited
+ */
+static void
+reverse_mark_reachable(const FunctionCFG *cfg, int start, bool *visited, int *stack)
+{
+  int top = 0;
+  visited[start] = true;
+  stack[top++] = start;
+  while (top > 0)
+  {
+    const CFGNode *node = &cfg->nodes[stack[--top]];
+    for (int i = 0; i < node->num_preds; i++)
+    {
+      int pred = node->preds[i];
+      if (!visited[pred])
       {
-        cfg_add_edge(cfg, current_node, false_node);
+        visited[pred] = true;
+        stack[top++] = pred;
       }
-      break;
     }
+  }
+}
 
-    case IR_OP_RET:
-    default: {
-
-      break;
+FunctionCFG *
+cfg_build_reverse(FunctionCFG *cfg, Bump *arena)
+{
+  FunctionCFG *rev = BUMP_ALLOC_ZEROED(arena, FunctionCFG);
+  rev->func = cfg->func;
+  bump_init(&rev->arena);
+  if (cfg->num_nodes == 0)
+    return rev;
+
+  int n = cfg->num_nodes;
+  int exit_id = n;
+  rev->num_nodes = n + 1;
+  rev->capacity = n + 1;
+  rev->nodes = BUMP_ALLOC_SLICE_ZEROED(&rev->arena, CFGNode, n + 1);
+
+  /// 出口: 没有后继的块；之后再补上到不了出口的区域里挑出的块
+  bool *is_exit = BUMP_ALLOC_SLICE_ZEROED(&rev->arena, bool, n);
+  bool *visited = BUMP_ALLOC_SLICE_ZEROED(&rev->arena, bool, n);
+  int *stack = BUMP_ALLOC_SLICE(&rev->arena, int, n);
+  int num_exits = 0;
+  int num_edges = 0;
+  for (int i = 0; i < n; i++)
+  {
+    num_edges += cfg->nodes[i].num_succs;
+    if (cfg->nodes[i].num_succs == 0)
+    {
+      is_exit[i] = true;
+      num_exits++;
+      if (!visited[i])
+        reverse_mark_reachable(cfg, i, visited, stack);
     }
+  }
+  for (int i = n - 1; i >= 0; i--)
+  {
+    if (!visited[i])
+    {
+      is_exit[i] = true;
+      num_exits++;
+      reverse_mark_reachable(cfg, i, visited, stack);
     }
   }
 
-  return cfg;
+  /// 与 cfg_build 一样，后继和前驱各放在一块连续的数组中
+  int total = num_edges + num_exits;
+  int *succ_ids = BUMP_ALLOC_SLICE(&rev->arena, int, total);
+  int *pred_ids = BUMP_ALLOC_SLICE(&rev->arena, int, total);
+  int succ_offset = 0;
+  int pred_offset = 0;
+  for (int i = 0; i < n; i++)
+  {
+    const CFGNode *fwd = &cfg->nodes[i];
+    CFGNode *node = &rev->nodes[i];
+    node->block = fwd->block;
+    node->id = i;
+
+    node->succs = succ_ids + succ_offset;
+    node->num_succs = fwd->num_preds;
+    node->succ_capacity = fwd->num_preds;
+    for (int k = 0; k < fwd->num_preds; k++)
+      node->succs[k] = fwd->preds[k];
+    succ_offset += fwd->num_preds;
+
+    node->preds = pred_ids + pred_offset;
+    node->num_preds = fwd->num_succs;
+    for (int k = 0; k < fwd->num_succs; k++)
+      node->preds[k] = fwd->succs[k];
+    if (is_exit[i])
+      node->preds[node->num_preds++] = exit_id;
+    node->pred_capacity = node->num_preds;
+    pred_offset += node->num_preds;
+  }
+
+  CFGNode *exit_node = &rev->nodes[exit_id];
+  exit_node->block = NULL;
+  exit_node->id = exit_id;
+  exit_node->succs = succ_ids + succ_offset;
+  exit_node->succ_capacity = num_exits;
+  for (int i = 0; i < n; i++)
+  {
+    if (is_exit[i])
+      exit_node->succs[exit_node->num_succs++] = i;
+  }
+  rev->entry_node = exit_node;
+
+  return rev;
 }
 
 void
@@ -169,4 +307,138 @@ cfg_destroy(FunctionCFG *cfg)
     return;
 
   bump_destroy(&cfg->arena);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief [内部] 在 ids 数组末尾加一个 id，放不下时把数组搬到 Arena 中的新位置 (容量翻倍)
+ */
+static void
+cfg_append_id(FunctionCFG *cfg, int **ids, int *count, int *capacity, int id)
+{
+  if (*count == *capacity)
+  {
+    int new_capacity = *capacity > 0 ? *capacity * 2 : 2;
+    int *grown = BUMP_ALLOC_SLICE(&cfg->arena, int, new_capacity);
+    for (int i = 0; i < *count; i++)
+      grown[i] = (*ids)[i];
+    *ids = grown;
+    *capacity = new_capacity;
+  }
+  (*ids)[(*count)++] = id;
+}
+
+/**
+ * @brief [内部] 从 ids 数组中删除 id (保持其余的顺序)
+ */
+static bool
+cfg_erase_id(int *ids, int *count, int id)
+{
+  for (int i = 0; i < *count; i++)
+  {
+    if (ids[i] == id)
+    {
+      for (int k = i + 1; k < *count; k++)
+        ids[k - 1] = ids[k];
+      (*count)--;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 检查 from -> to 是否已经存在
+ */
+static bool
+cfg_has_edge(const CFGNode *from, const CFGNode *to)
+{
+  for (int i = 0; i < from->num_succs; i++)
+  {
+    if (from->succs[i] == to->id)
+      return true;
+  }
+  return false;
+}
+
+bool
+cfg_contains_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to)
+{
+  CFGNode *from_node = cfg_get_node(cfg, from);
+  CFGNode *to_node = cfg_get_node(cfg, to);
+  return from_node && to_node && cfg_has_edge(from_node, to_node);
+}
+
+bool
+cfg_insert_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to)
+{
+  CFGNode *from_node = cfg_get_node(cfg, from);
+  CFGNode *to_node = cfg_get_node(cfg, to);
+  if (!from_node || !to_node || cfg_has_edge(from_node, to_node))
+    return false;
+  cfg_append_id(cfg, &from_node->succs, &from_node->num_succs, &from_node->succ_capacity, to_node->id);
+  cfg_append_id(cfg, &to_node->preds, &to_node->num_preds, &to_node->pred_capacity, from_node->id);
+  return true;
+}
+
+bool
+cfg_remove_edge(FunctionCFG *cfg, IRBasicBlock *from, IRBasicBlock *to)
+{
+  CFGNode *from_node = cfg_get_node(cfg, from);
+  CFGNode *to_node = cfg_get_node(cfg, to);
+  if (!from_node || !to_node || !cfg_erase_id(from_node->succs, &from_node->num_succs, to_node->id))
+    return false;
+  cfg_erase_id(to_node->preds, &to_node->num_preds, from_node->id);
+  return true;
+}
+
+CFGNode *
+cfg_split_block(FunctionCFG *cfg, IRBasicBlock *block, IRBasicBlock *new_block)
+{
+  if (!cfg_get_node(cfg, block))
+    return NULL;
+
+  /// 节点之间用 id 互相引用，扩容只需复制数组
+  if (cfg->num_nodes == cfg->capacity)
+  {
+    int new_capacity = cfg->capacity > 0 ? cfg->capacity * 2 : 8;
+    CFGNode *nodes = BUMP_ALLOC_SLICE(&cfg->arena, CFGNode, new_capacity);
+    for (int i = 0; i < cfg->num_nodes; i++)
+      nodes[i] = cfg->nodes[i];
+    cfg->entry_node = nodes + (cfg->entry_node - cfg->nodes);
+    cfg->nodes = nodes;
+    cfg->capacity = new_capacity;
+  }
+
+  CFGNode *node = cfg_get_node(cfg, block);
+  CFGNode *new_node = &cfg->nodes[cfg->num_nodes];
+  new_block->id = cfg->num_nodes++;
+  new_node->block = new_block;
+  new_node->id = new_block->id;
+
+  /// 出边整体交给 new_node，后继的前驱中 node 换成 new_node
+  new_node->succs = node->succs;
+  new_node->num_succs = node->num_succs;
+  new_node->succ_capacity = node->succ_capacity;
+  for (int i = 0; i < new_node->num_succs; i++)
+  {
+    CFGNode *succ = cfg_succ(cfg, new_node, i);
+    for (int k = 0; k < succ->num_preds; k++)
+    {
+      if (succ->preds[k] == node->id)
+      {
+        succ->preds[k] = new_node->id;
+        break;
+      }
+    }
+  }
+
+  node->succs = NULL;
+  node->num_succs = 0;
+  node->succ_capacity = 0;
+  new_node->preds = NULL;
+  new_node->num_preds = 0;
+  new_node->pred_capacity = 0;
+  cfg_append_id(cfg, &node->succs, &node->num_succs, &node->succ_capacity, new_node->id);
+  cfg_append_id(cfg, &new_node->preds, &new_node->num_preds, &new_node->pred_capacity, node->id);
+  return new_node;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/dataflow.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
+/**
+ * @brief [内部] CFG 的后序 (从入口出发的 DFS)，不可达的块按 id 排在最后
+ *
+ * @return 可达的块数 (order 的前这么多个)
+ */
+static int
+post_order(const FunctionCFG *cfg, int *order, Bump *scratch)
+{
+  int n = cfg->num_nodes;
+  bool *visited = BUMP_ALLOC_SLICE_ZEROED(scratch, bool, n);
+  int *stack = BUMP_ALLOC_SLICE(scratch, int, n);
+  int *next = BUMP_ALLOC_SLICE(scratch, int, n);
+  int count = 0;
+  int top = 0;
+
+  visited[cfg->entry_node->id] = true;
+  stack[top] = cfg->entry_node->id;
+  next[top++] = 0;
+  while (top > 0)
+  {
+    const CFGNode *node = &cfg->nodes[stack[top - 1]];
+    if (next[top - 1] < node->num_succs)
+    {
+      int succ = node->succs[next[top - 1]++];
+      if (!visited[succ])
+      {
+        visited[succ] = true;
+        stack[top] = succ;
+        next[top++] = 0;
+      }
+      continue;
+    }
+    order[count++] = node->id;
+    top--;
+  }
+
+  int reachable = count;
+  for (int i = 0; i < n; i++)
+  {
+    if (!visited[i])
+      order[count++] = i;
+  }
+  return reachable;
+}
+
+DataflowResult *
+dataflow_solve(FunctionCFG *cfg, const DataflowProblem *problem, Bump *arena)
+{
+  DataflowResult *result = BUMP_ALLOC_ZEROED(arena, DataflowResult);
+  result->cfg = cfg;
+  int n = cfg->num_nodes;
+  if (n == 0)
+    return result;
+
+  bool forward = problem->direction == DATAFLOW_FORWARD;
+  void *user = problem->user_data;
+  result->in = BUMP_ALLOC_SLICE(arena, void *, n);
+  result->out = BUMP_ALLOC_SLICE(arena, void *, n);
+  for (int b = 0; b < n; b++)
+  {
+    result->in[b] = problem->create(user, arena);
+    result->out[b] = problem->create(user, arena);
+  }
+  /// 前向时 meet 写 in、transfer 写 out；后向相反
+  void **meet_side = forward ? result->in : result->out;
+  void **transfer_side = forward ? result->out : result->in;
+
+  Bump scratch;
+  bump_init(&scratch);
+
+  /// order[pos] 是块 id，position[id] 是它在 order 中的位置
+  int *order = BUMP_ALLOC_SLICE(&scratch, int, n);
+  int *position = BUMP_ALLOC_SLICE(&scratch, int, n);
+  int reachable = post_order(cfg, order, &scratch);
+  if (forward)
+  {
+    /// 逆后序: 只反转可达的部分，不可达的块仍然在最后
+    for (int lo = 0, hi = reachable - 1; lo < hi; lo++, hi--)
+    {
+      int tmp = order[lo];
+      order[lo] = order[hi];
+      order[hi] = tmp;
+    }
+  }
+  for (int pos = 0; pos < n; pos++)
+    position[order[pos]] = pos;
+
+  /// 每一轮从头扫描待处理的块；处理中标记的、位置更靠后的块在同一轮里处理
+  bool *pending = BUMP_ALLOC_SLICE(&scratch, bool, n);
+  for (int pos = 0; pos < n; pos++)
+    pending[pos] = true;
+  int num_pending = n;
+  while (num_pending > 0)
+  {
+    for (int pos = 0; pos < n; pos++)
+    {
+      if (!pending[pos])
+        continue;
+      pending[pos] = false;
+      num_pending--;
+      result->num_visits++;
+
+      const CFGNode *node = &cfg->nodes[order[pos]];
+      const int *inputs = forward ? node->preds : node->succs;
+      int num_inputs = forward ? node->num_preds : node->num_succs;
+      bool boundary = forward ? node == cfg->entry_node : node->num_succs == 0;
+
+      void *meet = meet_side[node->id];
+      problem->reset(user, node, boundary, meet);
+      for (int k = 0; k < num_inputs; k++)
+        problem->meet(user, meet, transfer_side[inputs[k]]);
+      if (!problem->transfer(user, node, meet, transfer_side[node->id]))
+        continue;
+
+      const int *outputs = forward ? node->succs : node->preds;
+      int num_outputs = forward ? node->num_succs : node->num_preds;
+      for (int k = 0; k < num_outputs; k++)
+      {
+        int target = position[outputs[k]];
+        if (!pending[target])
+        {
+          pending[target] = true;
+          num_pending++;
+        }
+      }
+    }
+  }
+
+  bump_destroy(&scratch);
+  return result;
+}
+
+/*
+ * --- 并行求解 ---
+ */
+
+/** @brief 所有 worker 共享的任务列表 */
+typedef struct DataflowQueue
+{
+  DataflowJob *jobs;
+  size_t num_jobs;
+#if !defined(__STDC_NO_THREADS__)
+  /** 下一个要领取的任务 */
+  atomic_size_t next;
+#else
+  size_t next;
+#endif
+} DataflowQueue;
+
+/**
+ * @brief 不断领取任务并求解，直到全部领完
+ */
+static int
+dataflow_worker_run(void *arg)
+{
+  DataflowQueue *queue = (DataflowQueue *)arg;
+  while (true)
+  {
+#if !defined(__STDC_NO_THREADS__)
+    size_t index = atomic_fetch_add(&queue->next, 1);
+#else
+    size_t index = queue->next++;
+#endif
+    if (index >= queue->num_jobs)
+      return 0;
+    DataflowJob *job = &queue->jobs[index];
+    job->result = dataflow_solve(job->cfg, job->problem, job->arena);
+  }
+}
+
+void
+dataflow_solve_parallel(DataflowJob *jobs, size_t num_jobs, size_t num_threads)
+{
+  DataflowQueue queue = {.jobs = jobs, .num_jobs = num_jobs};
+#if defined(__STDC_NO_THREADS__)
+  num_threads = 1;
+#else
+  atomic_init(&queue.next, 0);
+#endif
+  if (num_threads > num_jobs)
+    num_threads = num_jobs;
+  if (num_threads <= 1)
+  {
+    dataflow_worker_run(&queue);
+    return;
+  }
+
+#if !defined(__STDC_NO_THREADS__)
+  /// 线程启动失败时，任务由已经启动的线程和调用线程分担
+  thrd_t *threads = (thrd_t *)malloc((num_threads - 1) * sizeof(thrd_t));
+  size_t started = 0;
+  if (threads)
+  {
+    while (started < num_threads - 1 && thrd_create(&threads[started], dataflow_worker_run, &queue) == thrd_success)
+      started++;
+  }
+  dataflow_worker_run(&queue);
+  for (size_t i = 0; i < started; i++)
+    thrd_join(threads[i], NULL);
+  free(threads);
+#endif
+}
+
+/*
+ * --- Bitset gen/kill 问题 ---
+ */
+
+static void *
+gen_kill_create(void *user_data, Bump *arena)
+{
+  DataflowGenKill *gk = (DataflowGenKill *)user_data;
+  return gk->intersect ? bitset_create_all(gk->num_bits, arena) : bitset_create(gk->num_bits, arena);
+}
+
+static void
+gen_kill_reset(void *user_data, const CFGNode *node, bool boundary, void *value)
+{
+  DataflowGenKill *gk = (DataflowGenKill *)user_data;
+  Bitset *bs = (Bitset *)value;
+  if (boundary && gk->boundary)
+    bitset_copy(bs, gk->boundary);
+  else if (gk->intersect && !boundary)
+    bitset_set_all(bs);
+  else
+    bitset_clear_all(bs);
+  if (gk->init)
+    bitset_union_with(bs, gk->init[node->id]);
+}
+
+static void
+gen_kill_meet(void *user_data, void *dest, const void *src)
+{
+  DataflowGenKill *gk = (DataflowGenKill *)user_data;
+  if (gk->intersect)
+    bitset_intersect_with((Bitset *)dest, (const Bitset *)src);
+  else
+    bitset_union_with((Bitset *)dest, (const Bitset *)src);
+}
+
+static bool
+gen_kill_transfer(void *user_data, const CFGNode *node, const void *input, void *output)
+{
+  DataflowGenKill *gk = (DataflowGenKill *)user_data;
+  const uint64_t *in = ((const Bitset *)input)->words;
+  const uint64_t *gen = gk->gen[node->id]->words;
+  const uint64_t *kill = gk->kill[node->id]->words;
+  Bitset *out = (Bitset *)output;
+  /// 按字计算 gen | (in & ~kill)，顺便比较，不需要临时集合
+  uint64_t changed = 0;
+  for (size_t i = 0; i < out->num_words; i++)
+  {
+    uint64_t word = gen[i] | (in[i] & ~kill[i]);
+    changed |= word ^ out->words[i];
+    out->words[i] = word;
+  }
+  return changed != 0;
+}
+
+DataflowProblem
+dataflow_gen_kill_problem(DataflowGenKill *gk, DataflowDirection direction)
+{
+  return (DataflowProblem){
+    .direction = direction,
+    .user_data = gk,
+    .create = gen_kill_create,
+    .reset = gen_kill_reset,
+    .meet = gen_kill_meet,
+    .transfer = gen_kill_transfer,
+  };
+}
@@ -16,18 +16,132 @@
 
 #include "analysis/dom_frontier.h"
 #include "analysis/cfg.h"
-#include "utils/bitset.h"
+#include "ir/function.h"
+#include "ir/module.h"
 #include "utils/bump.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool
+is_reachable(const DomTreeNode *n)
+{
+  return n->depth > 0;
+}
 
 /**
- * @brief 递归辅助函数，用于计算支配边界
+ * @brief [内部] 一遍 "runner" 扫描 (Cooper-Harvey-Kennedy, "A Simple, Fast Dominance Algorithm", Fig. 5)
  *
- * 这是一个自底向上 (post-order) 的支配树遍历。
- * 算法 (来自 "Engineering a Compiler", Fig. 10.12):
+ * for each block b:
+ *   for each predecessor p of b:
+ *     runner = p
+ *     while runner != idom(b):
+ *       DF(runner) = DF(runner) U {b}
+ *       runner = idom(runner)
  *
- * for each node n (in bottom-up dominator tree order):
- * DF(n) = {}
+ * 按 id 递增的顺序处理 b，所以每个集合天然是升序的。last[r] == b 表示 b 已经加进 DF(r)，
+ * 这时 r 往上直到 idom(b) 的链也都加过了，可以提前停下。
+ * fill 为 false 时只数个数 (counts)，为 true 时写入 frontiers[r].ids。
+ */
+static void
+runner_pass(DominanceFrontier *df, int *last, bool fill)
+{
+  DominatorTree *dt = df->dom_tree;
+  FunctionCFG *cfg = dt->cfg;
+  for (size_t i = 0; i < df->num_blocks; i++)
+    last[i] = -1;
+
+  for (int b = 0; b < (int)df->num_blocks; b++)
+  {
+    DomTreeNode *b_node = dt->nodes[b];
+    if (!is_reachable(b_node))
+      continue;
+    const CFGNode *node = &cfg->nodes[b];
+    for (int i = 0; i < node->num_preds; i++)
+    {
+      DomTreeNode *runner = dt->nodes[node->preds[i]];
+      if (!is_reachable(runner))
+        continue;
+      /// 根的 idom 是 NULL: 到达根之后 (根也算) 停下
+      while (runner && runner != b_node->idom && last[runner->cfg_node->id] != b)
+      {
+        DomFrontierSet *set = &df->frontiers[runner->cfg_node->id];
+        last[runner->cfg_node->id] = b;
+        if (fill)
+          set->ids[set->count] = b;
+        set->count++;
+        runner = runner->idom;
+      }
+    }
+  }
+}
+
+static DominanceFrontier *
+dom_frontier_compute_untimed(DominatorTree *dt, Bump *arena)
+{
+  FunctionCFG *cfg = dt->cfg;
+  size_t num_blocks = cfg->num_nodes;
+
+  DominanceFrontier *df = BUMP_ALLOC_ZEROED(arena, DominanceFrontier);
+  df->dom_tree = dt;
+  df->num_blocks = num_blocks;
+  df->capacity = num_blocks;
+  df->arena = arena;
+
+  df->frontiers = BUMP_ALLOC_SLICE_ZEROED(arena, DomFrontierSet, num_blocks);
+  df->mark = BUMP_ALLOC_SLICE_ZEROED(arena, bool, num_blocks);
+  df->buffer = BUMP_ALLOC_SLICE(arena, int, num_blocks);
+
+  /// 第一遍数出每个集合的大小，第二遍把所有集合写进同一个数组
+  runner_pass(df, df->buffer, false);
+  size_t total = 0;
+  for (size_t i = 0; i < num_blocks; i++)
+    total += (size_t)df->frontiers[i].count;
+
+  int *ids = BUMP_ALLOC_SLICE(arena, int, total > 0 ? total : 1);
+  size_t offset = 0;
+  for (size_t i = 0; i < num_blocks; i++)
+  {
+    DomFrontierSet *set = &df->frontiers[i];
+    set->ids = ids + offset;
+    set->capacity = set->count;
+    offset += (size_t)set->count;
+    set->count = 0;
+  }
+  runner_pass(df, df->buffer, true);
+
+  return df;
+}
+
+/**
+ * @brief 计算给定函数的支配边界。
+ */
+DominanceFrontier *
+ir_analysis_dom_frontier_compute(DominatorTree *dt, Bump *arena)
+{
+  IRFunction *func = dt->cfg->func;
+  (void)func;
+  INSTRUMENT_BEGIN(scope, "dom_frontier", func->parent ? func->parent->name : NULL, func->entry_address.name);
+  INSTRUMENT_TRACK_ARENA(scope, arena);
+  DominanceFrontier *df = dom_frontier_compute_untimed(dt, arena);
+  INSTRUMENT_END(scope);
+  return df;
+}
+
+static int
+compare_ids(const void *a, const void *b)
+{
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief [内部] 重算一个节点的支配边界 (它的所有子节点必须已经算完)
+ *
+ * 算法 (来自 "Engineering a Compiler", Fig. 10.12):
  *
  * // 1. DF_local: 贡献来自 CFG 后继
  * for each successor y of n:
@@ -36,96 +150,95 @@
  *
  * // 2. DF_up: 贡献来自支配树的子节点
  * for each child c of n (in dominator tree):
- * // (递归调用已在此之前完成)
  * for each w in DF(c):
  * if idom(w) != n:
  * DF(n) = DF(n) U {w}
  */
 static void
-compute_df_recursive(DomTreeNode *n, DominanceFrontier *df, Bitset *temp_set)
+recompute_df_node(DominanceFrontier *df, DomTreeNode *n)
 {
   DominatorTree *dt = df->dom_tree;
-  size_t num_blocks = df->num_blocks;
-
-  Bitset *df_n = df->frontiers[n->cfg_node->id];
+  int count = 0;
 
-  IDList *succ_list = &n->cfg_node->successors;
-  IDList *edge_node;
-  list_for_each(succ_list, edge_node)
+  for (int i = 0; i < n->cfg_node->num_succs; i++)
   {
-    CFGEdge *edge = list_entry(edge_node, CFGEdge, list_node);
-    CFGNode *y_cfg = edge->node;
-
-    DomTreeNode *y_dom_node = dt->nodes[y_cfg->id];
-    DomTreeNode *idom_y = y_dom_node->idom;
-
-    if (idom_y != n)
+    int y = n->cfg_node->succs[i];
+    if (dt->nodes[y]->idom != n && !df->mark[y])
     {
-
-      bitset_set(df_n, y_cfg->id);
+      df->mark[y] = true;
+      df->buffer[count++] = y;
     }
   }
 
-  IDList *child_list = &n->children;
   IDList *child_list_node;
-  list_for_each(child_list, child_list_node)
+  list_for_each(&n->children, child_list_node)
   {
-    DomTreeChild *child = list_entry(child_list_node, DomTreeChild, list_node);
-    DomTreeNode *c = child->node;
-
-    compute_df_recursive(c, df, temp_set);
-
-    Bitset *df_c = df->frontiers[c->cfg_node->id];
-
-    bitset_clear_all(temp_set);
-
-    for (size_t w_id = 0; w_id < num_blocks; w_id++)
+    DomTreeNode *c = list_entry(child_list_node, DomTreeChild, list_node)->node;
+    const DomFrontierSet *df_c = &df->frontiers[c->cfg_node->id];
+    for (int i = 0; i < df_c->count; i++)
     {
-      if (bitset_test(df_c, w_id))
+      int w = df_c->ids[i];
+      if (dt->nodes[w]->idom != n && !df->mark[w])
       {
-
-        DomTreeNode *w_dom_node = dt->nodes[w_id];
-        DomTreeNode *idom_w = w_dom_node->idom;
-
-        if (idom_w != n)
-        {
-
-          bitset_set(temp_set, w_id);
-        }
+        df->mark[w] = true;
+        df->buffer[count++] = w;
       }
     }
+  }
 
-    bitset_union(df_n, df_n, temp_set);
+  for (int i = 0; i < count; i++)
+    df->mark[df->buffer[i]] = false;
+  qsort(df->buffer, (size_t)count, sizeof(int), compare_ids);
+
+  DomFrontierSet *set = &df->frontiers[n->cfg_node->id];
+  if (count > set->capacity)
+  {
+    set->ids = BUMP_ALLOC_SLICE(df->arena, int, count);
+    set->capacity = count;
   }
+  if (count > 0)
+    memcpy(set->ids, df->buffer, (size_t)count * sizeof(int));
+  set->count = count;
 }
 
-/**
- * @brief 计算给定函数的支配边界。
- */
-DominanceFrontier *
-ir_analysis_dom_frontier_compute(DominatorTree *dt, Bump *arena)
+void
+ir_analysis_dom_frontier_refresh(DominanceFrontier *df, const bool *dirty)
 {
-  FunctionCFG *cfg = dt->cfg;
-  size_t num_blocks = cfg->num_nodes;
-
-  DominanceFrontier *df = BUMP_ALLOC_ZEROED(arena, DominanceFrontier);
-  df->dom_tree = dt;
-  df->num_blocks = num_blocks;
-  df->arena = arena;
-
-  df->frontiers = BUMP_ALLOC_SLICE_ZEROED(arena, Bitset *, num_blocks);
+  DominatorTree *dt = df->dom_tree;
 
-  for (size_t i = 0; i < num_blocks; i++)
+  for (size_t id = 0; id < df->num_blocks; id++)
   {
-
-    df->frontiers[i] = bitset_create(num_blocks, arena);
+    if (dirty[id])
+      df->frontiers[id].count = 0;
   }
 
-  Bitset *temp_set = bitset_create(num_blocks, arena);
+  /// 自底向上，只重算 dirty 的块；不 dirty 的子节点的边界没有变
+  for (int i = dt->num_reachable - 1; i >= 0; i--)
+  {
+    DomTreeNode *n = dt->dom_preorder[i];
+    if (dirty[n->cfg_node->id])
+      recompute_df_node(df, n);
+  }
+}
 
-  compute_df_recursive(dt->root, df, temp_set);
+void
+ir_analysis_dom_frontier_grow(DominanceFrontier *df, size_t num_blocks)
+{
+  if (num_blocks > df->capacity)
+  {
+    size_t capacity = df->capacity > 0 ? df->capacity * 2 : 8;
+    if (capacity < num_blocks)
+      capacity = num_blocks;
 
-  return df;
+    DomFrontierSet *frontiers = BUMP_ALLOC_SLICE_ZEROED(df->arena, DomFrontierSet, capacity);
+    if (df->num_blocks > 0)
+      memcpy(frontiers, df->frontiers, df->num_blocks * sizeof(DomFrontierSet));
+    df->frontiers = frontiers;
+    df->mark = BUMP_ALLOC_SLICE_ZEROED(df->arena, bool, capacity);
+    df->buffer = BUMP_ALLOC_SLICE(df->arena, int, capacity);
+    df->capacity = capacity;
+  }
+  df->num_blocks = num_blocks;
 }
 
 /**
@@ -142,18 +255,152 @@ ir_analysis_dom_frontier_destroy(DominanceFrontier *df)
 /**
  * @brief 获取指定基本块的支配边界集合。
  */
-Bitset *
+const DomFrontierSet *
 ir_analysis_dom_frontier_get(DominanceFrontier *df, IRBasicBlock *bb)
 {
-  DominatorTree *dt = df->dom_tree;
-  FunctionCFG *cfg = dt->cfg;
-
-  CFGNode *node = cfg_get_node(cfg, bb);
+  CFGNode *node = cfg_get_node(df->dom_tree->cfg, bb);
   if (!node)
+    return NULL;
+  return &df->frontiers[node->id];
+}
+
+bool
+ir_analysis_dom_frontier_contains(DominanceFrontier *df, IRBasicBlock *bb, IRBasicBlock *y)
+{
+  const DomFrontierSet *set = ir_analysis_dom_frontier_get(df, bb);
+  CFGNode *y_node = cfg_get_node(df->dom_tree->cfg, y);
+  if (!set || !y_node)
+    return false;
+
+  int lo = 0;
+  int hi = set->count;
+  while (lo < hi)
   {
+    int mid = lo + (hi - lo) / 2;
+    if (set->ids[mid] < y_node->id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < set->count && set->ids[lo] == y_node->id;
+}
 
-    return NULL;
+/*
+ * =================================================================
+ * --- 迭代支配边界 ---
+ * =================================================================
+ */
+
+bool
+ir_analysis_idf_init(IDFCalculator *calc, DominatorTree *dt, Bump *arena)
+{
+  int capacity = dt->cfg->num_nodes;
+  calc->dom_tree = dt;
+  calc->capacity = capacity;
+  calc->epoch = 0;
+  calc->is_def = BUMP_ALLOC_SLICE_ZEROED(arena, unsigned, capacity > 0 ? capacity : 1);
+  calc->in_idf = BUMP_ALLOC_SLICE_ZEROED(arena, unsigned, capacity > 0 ? capacity : 1);
+  calc->visited = BUMP_ALLOC_SLICE_ZEROED(arena, unsigned, capacity > 0 ? capacity : 1);
+  calc->heap = BUMP_ALLOC_SLICE(arena, DomTreeNode *, capacity > 0 ? capacity : 1);
+  calc->worklist = BUMP_ALLOC_SLICE(arena, DomTreeNode *, capacity > 0 ? capacity : 1);
+  return calc->is_def && calc->in_idf && calc->visited && calc->heap && calc->worklist;
+}
+
+/** @brief [内部] 按深度的最大堆: 入堆 */
+static void
+heap_push(DomTreeNode **heap, int *size, DomTreeNode *n)
+{
+  int pos = (*size)++;
+  while (pos > 0 && heap[(pos - 1) / 2]->depth < n->depth)
+  {
+    heap[pos] = heap[(pos - 1) / 2];
+    pos = (pos - 1) / 2;
   }
+  heap[pos] = n;
+}
 
-  return df->frontiers[node->id];
-}
\ No newline at end of file
+/** @brief [内部] 按深度的最大堆: 出堆 */
+static DomTreeNode *
+heap_pop(DomTreeNode **heap, int *size)
+{
+  DomTreeNode *top = heap[0];
+  DomTreeNode *last = heap[--(*size)];
+  int hole = 0;
+  while (true)
+  {
+    int child = 2 * hole + 1;
+    if (child >= *size)
+      break;
+    if (child + 1 < *size && heap[child + 1]->depth > heap[child]->depth)
+      child++;
+    if (heap[child]->depth <= last->depth)
+      break;
+    heap[hole] = heap[child];
+    hole = child;
+  }
+  if (*size > 0)
+    heap[hole] = last;
+  return top;
+}
+
+/**
+ * 最深的定义块 root 先出堆；从 root 沿支配树向下走 (不重复访问)，看每个块的 CFG 出边 x -> y：
+ * 深度不超过 root 的 y 是 J 边 (非支配树的边) 的目标，在 DF+ 中；y 不是定义块时也入堆。
+ * 支配树的边 x -> y 的深度是 x 的深度 + 1，一定比 root 深，所以自然被排除。
+ */
+size_t
+ir_analysis_idf_compute(IDFCalculator *calc, const int *def_blocks, size_t num_defs, int *out_blocks)
+{
+  DominatorTree *dt = calc->dom_tree;
+  unsigned epoch = ++calc->epoch;
+  int heap_size = 0;
+  size_t count = 0;
+
+  for (size_t i = 0; i < num_defs; i++)
+  {
+    DomTreeNode *n = dt->nodes[def_blocks[i]];
+    if (!is_reachable(n) || calc->is_def[def_blocks[i]] == epoch)
+      continue;
+    calc->is_def[def_blocks[i]] = epoch;
+    calc->visited[def_blocks[i]] = epoch;
+    heap_push(calc->heap, &heap_size, n);
+  }
+
+  while (heap_size > 0)
+  {
+    DomTreeNode *root = heap_pop(calc->heap, &heap_size);
+    int root_depth = root->depth;
+    int top = 0;
+    calc->worklist[top++] = root;
+    calc->visited[root->cfg_node->id] = epoch;
+
+    while (top > 0)
+    {
+      DomTreeNode *x = calc->worklist[--top];
+      const CFGNode *x_cfg = x->cfg_node;
+      for (int i = 0; i < x_cfg->num_succs; i++)
+      {
+        int y = x_cfg->succs[i];
+        DomTreeNode *y_node = dt->nodes[y];
+        if (y_node->depth > root_depth || calc->in_idf[y] == epoch)
+          continue;
+        calc->in_idf[y] = epoch;
+        out_blocks[count++] = y;
+        if (calc->is_def[y] != epoch)
+          heap_push(calc->heap, &heap_size, y_node);
+      }
+
+      IDList *iter;
+      list_for_each(&x->children, iter)
+      {
+        DomTreeNode *c = list_entry(iter, DomTreeChild, list_node)->node;
+        if (calc->visited[c->cfg_node->id] != epoch)
+        {
+          calc->visited[c->cfg_node->id] = epoch;
+          calc->worklist[top++] = c;
+        }
+      }
+    }
+  }
+  return count;
+}
@@ -16,9 +16,12 @@
 
 #include "analysis/dom_tree.h"
 #include "analysis/cfg.h"
+#include "ir/function.h"
+#include "ir/module.h"
 #include "ir/value.h"
 #include "utils/bump.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -42,50 +45,92 @@ get_dom_node(DominatorTree *tree, IRBasicBlock *bb)
   return tree->nodes[cfg_node->id];
 }
 
-static void
-lt_dfs(DominatorTree *tree, DomTreeNode *n, int *current_dfs_num)
+/**
+ * @brief 显式栈的一帧: 节点和下一条要看的 CFG 后继边
+ *
+ * 所有遍历都不递归：长链 CFG 的 DFS 深度等于块数，递归会耗尽 C 栈。
+ */
+typedef struct DomTreeFrame
 {
+  DomTreeNode *node;
+  /// 下一条要访问的后继边的下标
+  int next;
+} DomTreeFrame;
 
-  int n_num = *current_dfs_num;
-  *current_dfs_num = n_num + 1;
-
+/**
+ * @brief [辅助] 给 DFS 刚到达的节点编号
+ */
+static void
+lt_visit(DominatorTree *tree, DomTreeNode *n, int n_num)
+{
   assert(n_num <= tree->cfg->num_nodes && "DFS found more nodes than cfg->num_nodes!");
 
   n->dfs_num = n_num;
   n->semi_dom = n_num;
   n->label = n;
   tree->dfs_order[n_num] = n;
+}
+
+/**
+ * @brief 从入口做 DFS，按先序编号 (从 1 开始) 并记录 DFS 树的父节点
+ *
+ * 每一帧记住下一条后继边，访问顺序与递归的写法相同。
+ *
+ * @return int 到达的节点数
+ */
+static int
+lt_dfs(DominatorTree *tree)
+{
+  DomTreeFrame *stack = BUMP_ALLOC_SLICE(tree->arena, DomTreeFrame, tree->cfg->num_nodes);
+  int top = 0;
+  int dfs_num = 0;
 
-  IDList *iter;
-  list_for_each(&n->cfg_node->successors, iter)
+  lt_visit(tree, tree->root, ++dfs_num);
+  stack[top++] = (DomTreeFrame){tree->root, 0};
+  while (top > 0)
   {
-    CFGEdge *succ_edge = list_entry(iter, CFGEdge, list_node);
-    CFGNode *succ_cfg_node = succ_edge->node;
+    DomTreeFrame *frame = &stack[top - 1];
+    if (frame->next == frame->node->cfg_node->num_succs)
+    {
+      top--;
+      continue;
+    }
+    CFGNode *succ_cfg_node = cfg_succ(tree->cfg, frame->node->cfg_node, frame->next++);
 
     assert(succ_cfg_node->id >= 0 && succ_cfg_node->id < tree->cfg->num_nodes &&
            "CFG successor ID is out of bounds (negative or >= num_nodes)!");
 
     DomTreeNode *w = tree->nodes[succ_cfg_node->id];
-
     if (w->dfs_num == 0)
     {
-      w->parent = n;
-      lt_dfs(tree, w, current_dfs_num);
+      w->parent = frame->node;
+      lt_visit(tree, w, ++dfs_num);
+      stack[top++] = (DomTreeFrame){w, 0};
     }
   }
+  return dfs_num;
 }
 
+/**
+ * @brief 路径压缩: 让 n 到森林根的路径上的节点都直接指向根之下，并更新 label
+ *
+ * 先把路径收集到 path 中，再从靠近根的一端往回处理 (即递归写法的回溯顺序)。
+ */
 static void
-union_find_compress(DomTreeNode *n)
+union_find_compress(DomTreeNode *n, DomTreeNode **path)
 {
-  if (n->ancestor->ancestor != NULL)
+  int len = 0;
+  for (DomTreeNode *v = n; v->ancestor->ancestor != NULL; v = v->ancestor)
+    path[len++] = v;
+
+  while (len > 0)
   {
-    union_find_compress(n->ancestor);
-    if (n->ancestor->label->semi_dom < n->label->semi_dom)
+    DomTreeNode *v = path[--len];
+    if (v->ancestor->label->semi_dom < v->label->semi_dom)
     {
-      n->label = n->ancestor->label;
+      v->label = v->ancestor->label;
     }
-    n->ancestor = n->ancestor->ancestor;
+    v->ancestor = v->ancestor->ancestor;
   }
 }
 
@@ -93,7 +138,7 @@ union_find_compress(DomTreeNode *n)
  * @brief 查找从 n (不含) 到根的路径上 semi_dom 最小的节点
  */
 static DomTreeNode *
-union_find_eval(DomTreeNode *n)
+union_find_eval(DomTreeNode *n, DomTreeNode **path)
 {
   if (n->ancestor == NULL)
   {
@@ -101,7 +146,7 @@ union_find_eval(DomTreeNode *n)
   }
   else
   {
-    union_find_compress(n);
+    union_find_compress(n, path);
 
     return n->label;
   }
@@ -116,10 +161,19 @@ union_find_link(DomTreeNode *p, DomTreeNode *c)
   c->ancestor = p;
 }
 
+/**
+ * @brief 按 DFS 逆序计算半支配者，并隐式地求出立即支配者
+ *
+ * 处理完 n 并把它链接到 parent(n) 之后，bucket[parent(n)] 中的节点必须*立即*求值：
+ * 此时森林里恰好只有 DFS 序在 parent(n) 之后的节点，eval 才会返回正确的路径最小值。
+ * (推迟到所有节点都链接之后再处理 bucket，会在菱形链这样的 CFG 上得到错误的 idom。)
+ */
 static void
 lt_compute_semi_dominators(DominatorTree *tree)
 {
   int num_nodes = tree->cfg->num_nodes;
+  /// union_find_compress 的路径缓冲区 (路径不会比节点数长)
+  DomTreeNode **path = BUMP_ALLOC_SLICE(tree->arena, DomTreeNode *, num_nodes);
 
   for (int i = num_nodes; i >= 2; i--)
   {
@@ -127,12 +181,9 @@ lt_compute_semi_dominators(DominatorTree *tree)
     if (!n)
       continue;
 
-    IDList *iter;
-    list_for_each(&n->cfg_node->predecessors, iter)
+    for (int p = 0; p < n->cfg_node->num_preds; p++)
     {
-      CFGEdge *pred_edge = list_entry(iter, CFGEdge, list_node);
-      CFGNode *pred_cfg_node = pred_edge->node;
-      DomTreeNode *v = tree->nodes[pred_cfg_node->id];
+      DomTreeNode *v = tree->nodes[n->cfg_node->preds[p]];
       if (!v)
         continue;
 
@@ -147,7 +198,7 @@ lt_compute_semi_dominators(DominatorTree *tree)
       else
       {
 
-        v_prime = union_find_eval(v);
+        v_prime = union_find_eval(v, path);
       }
 
       if (v_prime->semi_dom < n->semi_dom)
@@ -161,73 +212,285 @@ lt_compute_semi_dominators(DominatorTree *tree)
     bucket_node->node = n;
     list_add_tail(&s->bucket, &bucket_node->list_node);
 
-    if (n->parent)
+    DomTreeNode *p = n->parent;
+    union_find_link(p, n);
+
+    /// 以 parent(n) 为半支配者的节点: idom 要么是 parent(n)，要么暂记为路径上的最小者 (第二步修正)
+    IDList *iter;
+    IDList *temp;
+    list_for_each_safe(&p->bucket, iter, temp)
     {
-      union_find_link(n->parent, n);
+      DomTreeNode *w = list_entry(iter, BucketNode, list_node)->node;
+      DomTreeNode *u = union_find_eval(w, path);
+      w->idom = (u->semi_dom < w->semi_dom) ? u : p;
     }
+    list_init(&p->bucket);
   }
 }
 
+/**
+ * @brief [辅助] 把 n 挂到它的 idom 的子节点链表末尾
+ */
+static void
+dom_tree_add_child(DominatorTree *tree, DomTreeNode *n)
+{
+  DomTreeChild *child_node = BUMP_ALLOC(tree->arena, DomTreeChild);
+  child_node->node = n;
+  n->child_link = child_node;
+  list_add_tail(&n->idom->children, &child_node->list_node);
+}
+
+/**
+ * @brief 第二步：按 DFS 顺序修正 idom (idom 暂记为 u 的节点取 idom(u))，并建立子节点链表
+ */
 static void
 lt_compute_idominators(DominatorTree *tree)
 {
   int num_nodes = tree->cfg->num_nodes;
 
+  tree->root->idom = NULL;
+
   for (int i = 2; i <= num_nodes; i++)
   {
     DomTreeNode *n = tree->dfs_order[i];
     if (!n)
       continue;
 
-    DomTreeNode *s = tree->dfs_order[n->semi_dom];
+    if (n->idom != tree->dfs_order[n->semi_dom])
+    {
 
-    IDList *iter, *temp;
-    list_for_each_safe(&s->bucket, iter, temp)
+      n->idom = n->idom->idom;
+    }
+
+    if (n->idom)
     {
-      BucketNode *bucket_node = list_entry(iter, BucketNode, list_node);
-      DomTreeNode *w = bucket_node->node;
+      dom_tree_add_child(tree, n);
+    }
+  }
+}
 
-      DomTreeNode *u = union_find_eval(w);
+/**
+ * @brief 第三步：在支配树上做 DFS，给每个节点先序/后序编号 (dominates 的区间判断)
+ *
+ * 不用递归也不用栈：沿 children 下降，沿 child_link 找下一个兄弟，沿 idom 回到父节点
+ * (深层嵌套的循环会产生几千层深的支配树)。
+ */
+static void
+dom_tree_number(DominatorTree *tree)
+{
+  if (!tree->dom_preorder)
+    tree->dom_preorder = BUMP_ALLOC_SLICE(tree->arena, DomTreeNode *, tree->capacity);
+
+  int pre = 0;
+  int post = 0;
+  DomTreeNode *n = tree->root;
+  n->depth = 1;
+  tree->dom_preorder[pre] = n;
+  n->dom_pre = ++pre;
+  for (;;)
+  {
+    if (!list_empty(&n->children))
+    {
+      DomTreeNode *child = list_entry(n->children.next, DomTreeChild, list_node)->node;
+      child->depth = n->depth + 1;
+      tree->dom_preorder[pre] = child;
+      child->dom_pre = ++pre;
+      n = child;
+      continue;
+    }
 
-      if (u->semi_dom < w->semi_dom)
+    /// 叶子: 编后序号，然后找下一个兄弟 (没有就回到父节点继续找)
+    for (;;)
+    {
+      n->dom_post = ++post;
+      if (n == tree->root)
       {
-
-        w->idom = u;
+        tree->num_reachable = pre;
+        return;
       }
-      else
+      DomTreeNode *parent = n->idom;
+      IDList *next = n->child_link->list_node.next;
+      if (next != &parent->children)
       {
-
-        w->idom = s;
+        DomTreeNode *sibling = list_entry(next, DomTreeChild, list_node)->node;
+        sibling->depth = parent->depth + 1;
+        tree->dom_preorder[pre] = sibling;
+        sibling->dom_pre = ++pre;
+        n = sibling;
+        break;
       }
+      n = parent;
     }
-    list_init(&s->bucket);
   }
+}
 
-  tree->root->idom = NULL;
+void
+dom_tree_renumber(DominatorTree *tree)
+{
+  dom_tree_number(tree);
+}
 
-  for (int i = 2; i <= num_nodes; i++)
+/*
+ * =================================================================
+ * --- Cooper-Harvey-Kennedy ---
+ * =================================================================
+ *
+ * "A Simple, Fast Dominance Algorithm": 按逆后序 (RPO) 编号可达的块，
+ * 前驱放在稠密的 CSR 数组中，然后反复执行
+ *   idom(b) = intersect(所有已处理的前驱 p)
+ * 直到不再变化。intersect 沿 idom 往上走，RPO 编号越小越靠近根。
+ * 可归约的 CFG 通常两遍就收敛。
+ */
+
+/**
+ * @brief 沿 idom 链找 a 和 b 的最近公共支配者 (RPO 编号)
+ */
+static int
+chk_intersect(const int *idom, int a, int b)
+{
+  while (a != b)
   {
-    DomTreeNode *n = tree->dfs_order[i];
-    if (!n)
+    while (a > b)
+      a = idom[a];
+    while (b > a)
+      b = idom[b];
+  }
+  return a;
+}
+
+/**
+ * @brief 用 Cooper-Harvey-Kennedy 算法求 idom，并建立子节点链表
+ *
+ * 可达的节点的 dfs_num 设为 RPO 编号 + 1 (dfs_order 按 RPO 排列)；
+ * Lengauer-Tarjan 专用的字段 (semi_dom, parent, ...) 不使用。
+ */
+static void
+chk_compute_idominators(DominatorTree *tree)
+{
+  int num_nodes = tree->cfg->num_nodes;
+  Bump *arena = tree->arena;
+
+  /// 1. 后序: 显式栈的 DFS (只用 CFG 的 id 数组)，节点出栈时编号；rpo_of[id] 为 -1 表示不可达
+  FunctionCFG *cfg = tree->cfg;
+  int *rpo_of = BUMP_ALLOC_SLICE(arena, int, num_nodes);
+  int *order = BUMP_ALLOC_SLICE(arena, int, num_nodes);
+  int *stack = BUMP_ALLOC_SLICE(arena, int, num_nodes);
+  int *next = BUMP_ALLOC_SLICE(arena, int, num_nodes);
+  for (int i = 0; i < num_nodes; i++)
+    rpo_of[i] = -1;
+
+  int num_post = 0;
+  int top = 0;
+  rpo_of[tree->root->cfg_node->id] = 0; /// 只作 "已访问" 标记，下面重新编号
+  stack[top] = tree->root->cfg_node->id;
+  next[top++] = 0;
+  while (top > 0)
+  {
+    const CFGNode *node = &cfg->nodes[stack[top - 1]];
+    if (next[top - 1] == node->num_succs)
+    {
+      order[num_post++] = node->id;
+      top--;
       continue;
+    }
+    int succ = node->succs[next[top - 1]++];
+    if (rpo_of[succ] < 0)
+    {
+      rpo_of[succ] = 0;
+      stack[top] = succ;
+      next[top++] = 0;
+    }
+  }
 
-    if (n->idom != tree->dfs_order[n->semi_dom])
+  /// 逆序: order[r] 是 RPO 编号为 r 的块
+  for (int lo = 0, hi = num_post - 1; lo < hi; lo++, hi--)
+  {
+    int tmp = order[lo];
+    order[lo] = order[hi];
+    order[hi] = tmp;
+  }
+  for (int r = 0; r < num_post; r++)
+    rpo_of[order[r]] = r;
+
+  /// 2. 前驱的 CSR 数组 (RPO 编号，只含可达的前驱)
+  int *pred_start = BUMP_ALLOC_SLICE(arena, int, num_post + 1);
+  int num_preds = 0;
+  for (int r = 0; r < num_post; r++)
+  {
+    pred_start[r] = num_preds;
+    const CFGNode *node = &cfg->nodes[order[r]];
+    for (int i = 0; i < node->num_preds; i++)
     {
+      if (rpo_of[node->preds[i]] >= 0)
+        num_preds++;
+    }
+  }
+  pred_start[num_post] = num_preds;
 
-      n->idom = n->idom->idom;
+  int *preds = BUMP_ALLOC_SLICE(arena, int, num_preds > 0 ? num_preds : 1);
+  for (int r = 0; r < num_post; r++)
+  {
+    int k = pred_start[r];
+    const CFGNode *node = &cfg->nodes[order[r]];
+    for (int i = 0; i < node->num_preds; i++)
+    {
+      int p = rpo_of[node->preds[i]];
+      if (p >= 0)
+        preds[k++] = p;
     }
+  }
 
-    if (n->idom)
+  /// 3. 迭代到不动点
+  int *idom = BUMP_ALLOC_SLICE(arena, int, num_post);
+  idom[0] = 0;
+  for (int r = 1; r < num_post; r++)
+    idom[r] = -1;
+
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (int r = 1; r < num_post; r++)
     {
-      DomTreeChild *child_node = BUMP_ALLOC(tree->arena, DomTreeChild);
-      child_node->node = n;
-      list_add_tail(&n->idom->children, &child_node->list_node);
+      int new_idom = -1;
+      for (int k = pred_start[r]; k < pred_start[r + 1]; k++)
+      {
+        int p = preds[k];
+        if (idom[p] < 0)
+          continue;
+        new_idom = new_idom < 0 ? p : chk_intersect(idom, p, new_idom);
+      }
+      if (idom[r] != new_idom)
+      {
+        idom[r] = new_idom;
+        changed = true;
+      }
+    }
+  }
+
+  /// 4. 写回节点，按 RPO 建立子节点链表
+  tree->root->idom = NULL;
+  for (int r = 0; r < num_post; r++)
+  {
+    DomTreeNode *n = tree->nodes[order[r]];
+    n->dfs_num = r + 1;
+    tree->dfs_order[r + 1] = n;
+    if (r > 0)
+    {
+      n->idom = tree->nodes[order[idom[r]]];
+      dom_tree_add_child(tree, n);
     }
   }
 }
 
 DominatorTree *
 dom_tree_build(FunctionCFG *cfg, Bump *arena)
+{
+  return dom_tree_build_with_algorithm(cfg, arena, DOM_TREE_LENGAUER_TARJAN);
+}
+
+static DominatorTree *
+dom_tree_build_untimed(FunctionCFG *cfg, Bump *arena, DomTreeAlgorithm algorithm)
 {
   if (!cfg || !cfg->entry_node)
   {
@@ -241,13 +504,16 @@ dom_tree_build(FunctionCFG *cfg, Bump *arena)
   tree->arena = arena;
 
   tree->nodes = BUMP_ALLOC_SLICE_ZEROED(arena, DomTreeNode *, num_nodes);
+  tree->capacity = num_nodes;
 
   tree->dfs_order = BUMP_ALLOC_SLICE_ZEROED(arena, DomTreeNode *, num_nodes + 1);
 
+  /// 所有节点放在一个连续的数组中
+  DomTreeNode *dom_nodes = BUMP_ALLOC_SLICE_ZEROED(arena, DomTreeNode, num_nodes);
   for (int i = 0; i < num_nodes; i++)
   {
     CFGNode *cfg_node = &cfg->nodes[i];
-    DomTreeNode *dom_node = BUMP_ALLOC_ZEROED(arena, DomTreeNode);
+    DomTreeNode *dom_node = &dom_nodes[i];
 
     dom_node->cfg_node = cfg_node;
     dom_node->dfs_num = 0;
@@ -261,19 +527,38 @@ dom_tree_build(FunctionCFG *cfg, Bump *arena)
 
   tree->root = tree->nodes[cfg->entry_node->id];
 
-  int dfs_counter = 1;
-  lt_dfs(tree, tree->root, &dfs_counter);
+  if (algorithm == DOM_TREE_COOPER_HARVEY_KENNEDY)
+  {
+    chk_compute_idominators(tree);
+  }
+  else
+  {
+    int visited_nodes = lt_dfs(tree);
+    assert(visited_nodes <= num_nodes && "DFS visited more nodes than cfg->num_nodes reported!");
+    (void)visited_nodes;
 
-  int visited_nodes = dfs_counter - 1;
-  assert(visited_nodes <= num_nodes && "DFS visited more nodes than cfg->num_nodes reported!");
+    lt_compute_semi_dominators(tree);
 
-  lt_compute_semi_dominators(tree);
+    lt_compute_idominators(tree);
+  }
 
-  lt_compute_idominators(tree);
+  dom_tree_number(tree);
 
   return tree;
 }
 
+DominatorTree *
+dom_tree_build_with_algorithm(FunctionCFG *cfg, Bump *arena, DomTreeAlgorithm algorithm)
+{
+  IRFunction *func = cfg ? cfg->func : NULL;
+  (void)func;
+  INSTRUMENT_BEGIN(scope, "dom_tree", func && func->parent ? func->parent->name : NULL,
+                   func ? func->entry_address.name : NULL);
+  DominatorTree *tree = dom_tree_build_untimed(cfg, arena, algorithm);
+  INSTRUMENT_END(scope);
+  return tree;
+}
+
 void
 dom_tree_destroy(DominatorTree *tree)
 {
@@ -309,17 +594,11 @@ dom_tree_dominates(DominatorTree *tree, IRBasicBlock *a, IRBasicBlock *b)
     return false;
   }
 
-  DomTreeNode *current = node_b->idom;
-  while (current)
-  {
-    if (current == node_a)
-    {
-      return true;
-    }
-    current = current->idom;
-  }
+  /// 不可达的 b 不被任何其他块支配 (它不在树中，编号为 0)
+  if (node_b->dom_pre == 0)
+    return false;
 
-  return false;
+  return node_a->dom_pre <= node_b->dom_pre && node_b->dom_post <= node_a->dom_post;
 }
 
 IRBasicBlock *
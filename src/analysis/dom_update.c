@@ -0,0 +1,768 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysis/dom_update.h"
+#include "utils/bump.h"
+#include "utils/id_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 一批更新共用的状态和临时数组 (下标都是 CFG 节点 id，容量随 CFG 增长)
+ */
+typedef struct DomUpdater
+{
+  DominatorTree *tree;
+  DominanceFrontier *df;
+  FunctionCFG *cfg;
+
+  int capacity;
+  /// 支配边界需要重算的块；这个集合在 (当前的) 支配树上始终向上封闭
+  bool *dirty;
+  /// 访问标记: mark[id] == 某个 epoch 表示本次遍历已经见过
+  unsigned *mark;
+  unsigned epoch;
+  /// 区域内的 RPO 编号
+  int *index;
+
+  /// 区域成员 / 受影响的节点
+  DomTreeNode **list;
+  /// 显式栈 (和 iters 配对使用时是 DFS 的帧)
+  DomTreeNode **stack;
+  int *iters;
+  /// 区域内按 RPO 排列的节点；插入时的按深度的最大堆
+  DomTreeNode **order;
+  DomTreeNode **heap;
+
+  /// 从新变得可达的区域出去的边 (插入不可达的目标时使用)
+  DomTreeNode **exits;
+  size_t num_exits;
+  size_t exits_capacity;
+
+  bool failed;
+} DomUpdater;
+
+static bool
+updater_reserve(DomUpdater *u, int capacity)
+{
+  if (capacity <= u->capacity)
+    return true;
+
+  bool *dirty = realloc(u->dirty, (size_t)capacity * sizeof(bool));
+  if (dirty)
+    u->dirty = dirty;
+  unsigned *mark = realloc(u->mark, (size_t)capacity * sizeof(unsigned));
+  if (mark)
+    u->mark = mark;
+  if (!dirty || !mark)
+    return false;
+  memset(u->dirty + u->capacity, 0, (size_t)(capacity - u->capacity) * sizeof(bool));
+  memset(u->mark + u->capacity, 0, (size_t)(capacity - u->capacity) * sizeof(unsigned));
+
+  free(u->index);
+  free(u->list);
+  free(u->stack);
+  free(u->iters);
+  free(u->order);
+  free(u->heap);
+  u->index = malloc((size_t)capacity * sizeof(int));
+  u->list = malloc((size_t)capacity * sizeof(DomTreeNode *));
+  u->stack = malloc((size_t)capacity * sizeof(DomTreeNode *));
+  u->iters = malloc((size_t)capacity * sizeof(int));
+  u->order = malloc((size_t)capacity * sizeof(DomTreeNode *));
+  u->heap = malloc((size_t)capacity * sizeof(DomTreeNode *));
+  u->capacity = capacity;
+  return u->index && u->list && u->stack && u->iters && u->order && u->heap;
+}
+
+static void
+updater_free(DomUpdater *u)
+{
+  free(u->dirty);
+  free(u->mark);
+  free(u->index);
+  free(u->list);
+  free(u->stack);
+  free(u->iters);
+  free(u->order);
+  free(u->heap);
+  free(u->exits);
+}
+
+static inline unsigned
+next_epoch(DomUpdater *u)
+{
+  return ++u->epoch;
+}
+
+static inline DomTreeNode *
+dom_node_of(DomUpdater *u, int id)
+{
+  return u->tree->nodes[id];
+}
+
+static inline bool
+is_reachable(DomTreeNode *n)
+{
+  return n->depth > 0;
+}
+
+/**
+ * @brief 把 n 和它所有 (当前的) 支配者标记为 dirty；遇到已经 dirty 的节点就停 (集合向上封闭)
+ */
+static void
+mark_chain(DomUpdater *u, DomTreeNode *n)
+{
+  for (; n && !u->dirty[n->cfg_node->id]; n = n->idom)
+    u->dirty[n->cfg_node->id] = true;
+}
+
+/**
+ * @brief 支配树上的最近公共祖先 (两者都必须可达)
+ */
+static DomTreeNode *
+nearest_common_dominator(DomTreeNode *a, DomTreeNode *b)
+{
+  while (a != b)
+  {
+    if (a->depth < b->depth)
+      b = b->idom;
+    else if (b->depth < a->depth)
+      a = a->idom;
+    else
+    {
+      a = a->idom;
+      b = b->idom;
+    }
+  }
+  return a;
+}
+
+/**
+ * @brief 把 n 挂到 parent 下面 (从原来的父节点的 children 中移走)；不更新深度
+ */
+static void
+set_idom(DomUpdater *u, DomTreeNode *n, DomTreeNode *parent)
+{
+  if (n->idom == parent)
+    return;
+
+  mark_chain(u, n);
+  if (n->child_link)
+  {
+    list_del(&n->child_link->list_node);
+  }
+  else
+  {
+    n->child_link = BUMP_ALLOC(u->tree->arena, DomTreeChild);
+    if (!n->child_link)
+    {
+      u->failed = true;
+      return;
+    }
+    n->child_link->node = n;
+  }
+  n->idom = parent;
+  list_add_tail(&parent->children, &n->child_link->list_node);
+  mark_chain(u, parent);
+}
+
+/**
+ * @brief 把 n 从树上摘下 (变得不可达)；它的子节点必须另行处理
+ */
+static void
+detach(DomUpdater *u, DomTreeNode *n)
+{
+  mark_chain(u, n);
+  if (n->child_link)
+    list_del(&n->child_link->list_node);
+  n->idom = NULL;
+  n->depth = 0;
+  n->dom_pre = 0;
+  n->dom_post = 0;
+}
+
+/**
+ * @brief 从 n 开始 (它的 idom 已经正确) 重新计算整棵子树的深度
+ */
+static void
+update_depths(DomUpdater *u, DomTreeNode *n)
+{
+  int top = 0;
+  n->depth = n->idom ? n->idom->depth + 1 : 1;
+  u->stack[top++] = n;
+  while (top > 0)
+  {
+    DomTreeNode *v = u->stack[--top];
+    IDList *iter;
+    list_for_each(&v->children, iter)
+    {
+      DomTreeNode *c = list_entry(iter, DomTreeChild, list_node)->node;
+      c->depth = v->depth + 1;
+      u->stack[top++] = c;
+    }
+  }
+}
+
+/**
+ * @brief 把支配树上以 root 为根的子树收集到 u->list，并用新的 epoch 标记
+ * @return 节点个数
+ */
+static int
+collect_subtree(DomUpdater *u, DomTreeNode *root, unsigned epoch)
+{
+  int count = 0;
+  int top = 0;
+  u->stack[top++] = root;
+  while (top > 0)
+  {
+    DomTreeNode *v = u->stack[--top];
+    u->mark[v->cfg_node->id] = epoch;
+    u->list[count++] = v;
+    IDList *iter;
+    list_for_each(&v->children, iter)
+    {
+      u->stack[top++] = list_entry(iter, DomTreeChild, list_node)->node;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 在区域 (u->list 中 mark == member 的节点) 内以 root 为根求支配树 (Cooper-Harvey-Kennedy)
+ *
+ * root 的 idom 不变。区域内从 root 走不到的成员变为不可达。
+ */
+static void
+recompute_region(DomUpdater *u, DomTreeNode *root, int num_members, unsigned member)
+{
+  unsigned visited = next_epoch(u);
+
+  /// 1. 区域内的 DFS，出栈时记后序
+  int num_post = 0;
+  int top = 0;
+  u->mark[root->cfg_node->id] = visited;
+  u->stack[top] = root;
+  u->iters[top++] = 0;
+  while (top > 0)
+  {
+    DomTreeNode *v = u->stack[top - 1];
+    if (u->iters[top - 1] == v->cfg_node->num_succs)
+    {
+      u->order[num_post++] = v;
+      top--;
+      continue;
+    }
+    int succ = v->cfg_node->succs[u->iters[top - 1]++];
+    if (u->mark[succ] == member)
+    {
+      u->mark[succ] = visited;
+      u->stack[top] = dom_node_of(u, succ);
+      u->iters[top++] = 0;
+    }
+  }
+
+  /// 逆序得到 RPO
+  for (int lo = 0, hi = num_post - 1; lo < hi; lo++, hi--)
+  {
+    DomTreeNode *tmp = u->order[lo];
+    u->order[lo] = u->order[hi];
+    u->order[hi] = tmp;
+  }
+  for (int r = 0; r < num_post; r++)
+    u->index[u->order[r]->cfg_node->id] = r;
+
+  /// 2. 在 RPO 编号上迭代 idom (前驱只看区域内访问到的节点)
+  int *idom = malloc((size_t)num_post * sizeof(int));
+  if (!idom)
+  {
+    u->failed = true;
+    return;
+  }
+  idom[0] = 0;
+  for (int r = 1; r < num_post; r++)
+    idom[r] = -1;
+
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (int r = 1; r < num_post; r++)
+    {
+      int new_idom = -1;
+      CFGNode *node = u->order[r]->cfg_node;
+      for (int i = 0; i < node->num_preds; i++)
+      {
+        int pred = node->preds[i];
+        if (u->mark[pred] != visited)
+          continue;
+        int p = u->index[pred];
+        if (idom[p] < 0)
+          continue;
+        if (new_idom < 0)
+        {
+          new_idom = p;
+          continue;
+        }
+        int a = p;
+        int b = new_idom;
+        while (a != b)
+        {
+          while (a > b)
+            a = idom[a];
+          while (b > a)
+            b = idom[b];
+        }
+        new_idom = a;
+      }
+      if (idom[r] != new_idom)
+      {
+        idom[r] = new_idom;
+        changed = true;
+      }
+    }
+  }
+
+  /// 3. 写回: 访问到的节点挂到新的 idom 下，没访问到的成员摘下
+  for (int r = 1; r < num_post; r++)
+    set_idom(u, u->order[r], u->order[idom[r]]);
+  free(idom);
+  for (int i = 0; i < num_members; i++)
+  {
+    DomTreeNode *n = u->list[i];
+    if (u->mark[n->cfg_node->id] == member)
+      detach(u, n);
+  }
+  update_depths(u, root);
+}
+
+/**
+ * @brief 重算支配树上以 r 为根的子树 (r 的 idom 不变)
+ */
+static void
+rebuild_subtree(DomUpdater *u, DomTreeNode *r)
+{
+  unsigned member = next_epoch(u);
+  int count = collect_subtree(u, r, member);
+  for (int i = 0; i < count; i++)
+    mark_chain(u, u->list[i]);
+  recompute_region(u, r, count, member);
+}
+
+/**
+ * @brief [插入] x 和 y 都可达: 按深度的搜索找出 idom 变为 NCA(x, y) 的节点
+ *
+ * 从 y 出发，按深度从大到小处理候选节点 (最大堆)。从当前节点 (深度 L) 能经过深度都大于
+ * L 的节点走到的、深度 <= L 且 > depth(NCA) + 1 的节点也受影响；深度更大的节点本身
+ * 不受影响，但要继续从它们往下找。
+ */
+static void
+insert_reachable(DomUpdater *u, DomTreeNode *x, DomTreeNode *y)
+{
+  DomTreeNode *nca = nearest_common_dominator(x, y);
+  if (nca == y || nca == y->idom)
+    return;
+
+  unsigned visited = next_epoch(u);
+  int nca_depth = nca->depth;
+  int num_affected = 0;
+  int heap_size = 0;
+
+  u->mark[y->cfg_node->id] = visited;
+  u->heap[heap_size++] = y;
+  while (heap_size > 0)
+  {
+    /// 弹出深度最大的节点
+    DomTreeNode *current = u->heap[0];
+    DomTreeNode *last = u->heap[--heap_size];
+    int hole = 0;
+    for (;;)
+    {
+      int child = 2 * hole + 1;
+      if (child >= heap_size)
+        break;
+      if (child + 1 < heap_size && u->heap[child + 1]->depth > u->heap[child]->depth)
+        child++;
+      if (u->heap[child]->depth <= last->depth)
+        break;
+      u->heap[hole] = u->heap[child];
+      hole = child;
+    }
+    if (heap_size > 0)
+      u->heap[hole] = last;
+
+    u->list[num_affected++] = current;
+    int level = current->depth;
+
+    int top = 0;
+    u->stack[top++] = current;
+    while (top > 0)
+    {
+      DomTreeNode *v = u->stack[--top];
+      for (int i = 0; i < v->cfg_node->num_succs; i++)
+      {
+        DomTreeNode *succ = dom_node_of(u, v->cfg_node->succs[i]);
+        unsigned *seen = &u->mark[succ->cfg_node->id];
+        if (succ->depth <= nca_depth + 1 || *seen == visited)
+          continue;
+        *seen = visited;
+        if (succ->depth > level)
+        {
+          u->stack[top++] = succ;
+          continue;
+        }
+        /// 入堆 (上浮)
+        int pos = heap_size++;
+        while (pos > 0 && u->heap[(pos - 1) / 2]->depth < succ->depth)
+        {
+          u->heap[pos] = u->heap[(pos - 1) / 2];
+          pos = (pos - 1) / 2;
+        }
+        u->heap[pos] = succ;
+      }
+    }
+  }
+
+  for (int i = 0; i < num_affected; i++)
+    set_idom(u, u->list[i], nca);
+  for (int i = 0; i < num_affected; i++)
+    update_depths(u, u->list[i]);
+}
+
+/**
+ * @brief [插入] x 可达而 y 不可达: 新变得可达的区域只能从 x -> y 进入
+ *
+ * 在区域内以 y 为根求支配树，再把从区域出去、指向原来可达的块的边逐条按插入处理。
+ */
+static void
+insert_unreachable(DomUpdater *u, DomTreeNode *x, DomTreeNode *y)
+{
+  unsigned member = next_epoch(u);
+  int count = 0;
+  int top = 0;
+  u->num_exits = 0;
+
+  u->mark[y->cfg_node->id] = member;
+  u->stack[top++] = y;
+  while (top > 0)
+  {
+    DomTreeNode *v = u->stack[--top];
+    u->list[count++] = v;
+    for (int i = 0; i < v->cfg_node->num_succs; i++)
+    {
+      DomTreeNode *succ = dom_node_of(u, v->cfg_node->succs[i]);
+      if (is_reachable(succ))
+      {
+        if (u->num_exits + 2 > u->exits_capacity)
+        {
+          size_t capacity = u->exits_capacity ? u->exits_capacity * 2 : 16;
+          DomTreeNode **exits = realloc(u->exits, capacity * sizeof(DomTreeNode *));
+          if (!exits)
+          {
+            u->failed = true;
+            return;
+          }
+          u->exits = exits;
+          u->exits_capacity = capacity;
+        }
+        u->exits[u->num_exits++] = v;
+        u->exits[u->num_exits++] = succ;
+      }
+      else if (u->mark[succ->cfg_node->id] != member)
+      {
+        u->mark[succ->cfg_node->id] = member;
+        u->stack[top++] = succ;
+      }
+    }
+  }
+
+  set_idom(u, y, x);
+  if (u->failed)
+    return;
+  recompute_region(u, y, count, member);
+
+  /// 区域的出边 (v, succ) 成对存放
+  for (size_t i = 0; i + 1 < u->num_exits && !u->failed; i += 2)
+    insert_reachable(u, u->exits[i], u->exits[i + 1]);
+}
+
+/**
+ * @brief y 除了来自它自己支配的块的边之外，是否还有别的可达前驱
+ */
+static bool
+has_proper_support(DomUpdater *u, DomTreeNode *y)
+{
+  for (int i = 0; i < y->cfg_node->num_preds; i++)
+  {
+    DomTreeNode *pred = dom_node_of(u, y->cfg_node->preds[i]);
+    if (is_reachable(pred) && nearest_common_dominator(y, pred) != y)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief [删除] y 变得不可达: 摘下它的整棵子树，再重算被影响到的最小子树
+ *
+ * 从子树出去的边指向的块 w 失去了一个前驱；它们的新 idom 都在 NCA(w, y) 的子树内，
+ * 所以重算其中最浅的那个 NCA 的子树。
+ */
+static void
+delete_unreachable(DomUpdater *u, DomTreeNode *y)
+{
+  unsigned member = next_epoch(u);
+  int count = collect_subtree(u, y, member);
+
+  DomTreeNode *min = y;
+  for (int i = 0; i < count; i++)
+  {
+    CFGNode *node = u->list[i]->cfg_node;
+    for (int k = 0; k < node->num_succs; k++)
+    {
+      DomTreeNode *succ = dom_node_of(u, node->succs[k]);
+      if (u->mark[succ->cfg_node->id] == member || !is_reachable(succ))
+        continue;
+      DomTreeNode *nca = nearest_common_dominator(succ, y);
+      if (nca != succ && nca->depth < min->depth)
+        min = nca;
+    }
+  }
+
+  /// 倒着摘 (子节点先于父节点)
+  for (int i = count - 1; i >= 0; i--)
+    detach(u, u->list[i]);
+
+  if (min != y)
+    rebuild_subtree(u, min);
+}
+
+static void
+delete_edge(DomUpdater *u, DomTreeNode *x, DomTreeNode *y)
+{
+  if (!is_reachable(x) || !is_reachable(y))
+    return;
+
+  DomTreeNode *nca = nearest_common_dominator(x, y);
+  if (nca == y)
+    return;
+
+  if (y->idom == x && !has_proper_support(u, y))
+    delete_unreachable(u, y);
+  else
+    rebuild_subtree(u, nca);
+}
+
+/**
+ * @brief 拆分: 新节点成为 block 唯一的子节点并接管 block 原来的所有子节点
+ *
+ * 支配边界: DF(new) = DF(block)，其余块的边界不变。
+ */
+static void
+split_block(DomUpdater *u, IRBasicBlock *block, IRBasicBlock *new_block)
+{
+  DominatorTree *tree = u->tree;
+  FunctionCFG *cfg = u->cfg;
+  CFGNode *old_nodes = cfg->nodes;
+  CFGNode *new_cfg_node = cfg_split_block(cfg, block, new_block);
+  if (!new_cfg_node)
+    return;
+
+  if (cfg->capacity > tree->capacity)
+  {
+    DomTreeNode **nodes = BUMP_ALLOC_SLICE(tree->arena, DomTreeNode *, cfg->capacity);
+    if (!nodes)
+    {
+      u->failed = true;
+      return;
+    }
+    memcpy(nodes, tree->nodes, (size_t)tree->capacity * sizeof(DomTreeNode *));
+    tree->nodes = nodes;
+    tree->capacity = cfg->capacity;
+    tree->dom_preorder = NULL;
+  }
+  /// CFG 扩容会搬动节点数组 (CFG 内部用 id 互相引用，只有这里的指针要跟着改)
+  if (cfg->nodes != old_nodes)
+  {
+    for (int i = 0; i < cfg->num_nodes - 1; i++)
+      tree->nodes[i]->cfg_node = &cfg->nodes[i];
+  }
+  if (!updater_reserve(u, cfg->capacity))
+  {
+    u->failed = true;
+    return;
+  }
+  if (u->df)
+    ir_analysis_dom_frontier_grow(u->df, (size_t)cfg->num_nodes);
+
+  DomTreeNode *nn = BUMP_ALLOC_ZEROED(tree->arena, DomTreeNode);
+  if (!nn)
+  {
+    u->failed = true;
+    return;
+  }
+  nn->cfg_node = new_cfg_node;
+  list_init(&nn->children);
+  list_init(&nn->bucket);
+  nn->label = nn;
+  tree->nodes[new_cfg_node->id] = nn;
+
+  DomTreeNode *bn = tree->nodes[cfg_get_node(cfg, block)->id];
+  if (!is_reachable(bn))
+    return;
+
+  nn->child_link = BUMP_ALLOC(tree->arena, DomTreeChild);
+  if (!nn->child_link)
+  {
+    u->failed = true;
+    return;
+  }
+  nn->child_link->node = nn;
+
+  /// 不用 set_idom: 除了 nn 自己，没有块的支配边界改变，不需要标记 dirty
+  list_splice_tail(&bn->children, &nn->children);
+  IDList *iter;
+  list_for_each(&nn->children, iter)
+  {
+    list_entry(iter, DomTreeChild, list_node)->node->idom = nn;
+  }
+  nn->idom = bn;
+  list_add_tail(&bn->children, &nn->child_link->list_node);
+  update_depths(u, nn);
+
+  /// bn 是 dirty 时它的边界之后会重算，nn 跟着重算 (集合仍向上封闭)
+  if (u->dirty[bn->cfg_node->id])
+    u->dirty[nn->cfg_node->id] = true;
+  else if (u->df)
+  {
+    /// 复制一份: 之后的重算会原地改写 DF(bn) 的数组
+    const DomFrontierSet *from = &u->df->frontiers[bn->cfg_node->id];
+    DomFrontierSet *to = &u->df->frontiers[nn->cfg_node->id];
+    if (from->count > 0)
+    {
+      to->ids = BUMP_ALLOC_SLICE(u->df->arena, int, from->count);
+      if (!to->ids)
+      {
+        u->failed = true;
+        return;
+      }
+      memcpy(to->ids, from->ids, (size_t)from->count * sizeof(int));
+    }
+    to->count = from->count;
+    to->capacity = from->count;
+  }
+}
+
+bool
+dom_tree_apply_updates(DominatorTree *tree, DominanceFrontier *df, const DomUpdate *updates, size_t num_updates)
+{
+  DomUpdater u = {.tree = tree, .df = df, .cfg = tree->cfg};
+  bool *skip = calloc(num_updates > 0 ? num_updates : 1, sizeof(bool));
+  if (!skip || !updater_reserve(&u, tree->capacity))
+  {
+    free(skip);
+    updater_free(&u);
+    return false;
+  }
+
+  for (size_t i = 0; i < num_updates && !u.failed; i++)
+  {
+    if (skip[i])
+      continue;
+    const DomUpdate *update = &updates[i];
+    if (update->kind == DOM_UPDATE_SPLIT_BLOCK)
+    {
+      split_block(&u, update->from, update->to);
+      continue;
+    }
+
+    if (!cfg_get_node(u.cfg, update->from) || !cfg_get_node(u.cfg, update->to))
+      continue;
+
+    /// 对 CFG 没有作用的更新直接跳过
+    bool insert = update->kind == DOM_UPDATE_INSERT_EDGE;
+    if (cfg_contains_edge(u.cfg, update->from, update->to) == insert)
+      continue;
+
+    /// 同一条边的下一次出现 (拆分是屏障) 是相反的操作时，两者相互抵消
+    bool cancelled = false;
+    for (size_t j = i + 1; j < num_updates; j++)
+    {
+      if (updates[j].kind == DOM_UPDATE_SPLIT_BLOCK)
+        break;
+      if (skip[j] || updates[j].from != update->from || updates[j].to != update->to)
+        continue;
+      if (updates[j].kind != update->kind)
+        cancelled = skip[j] = true;
+      break;
+    }
+    if (cancelled)
+      continue;
+
+    DomTreeNode *x = dom_node_of(&u, update->from->id);
+    DomTreeNode *y = dom_node_of(&u, update->to->id);
+    /// x 的出边变了: 即使没有 idom 改变，x 和它的支配者的边界也可能改变
+    if (is_reachable(x))
+      mark_chain(&u, x);
+    if (insert)
+    {
+      cfg_insert_edge(u.cfg, update->from, update->to);
+      if (!is_reachable(x))
+        continue;
+      if (is_reachable(y))
+        insert_reachable(&u, x, y);
+      else
+        insert_unreachable(&u, x, y);
+    }
+    else
+    {
+      cfg_remove_edge(u.cfg, update->from, update->to);
+      delete_edge(&u, x, y);
+    }
+  }
+
+  bool ok = !u.failed;
+  if (ok)
+  {
+    dom_tree_renumber(tree);
+    if (df)
+      ir_analysis_dom_frontier_refresh(df, u.dirty);
+  }
+  free(skip);
+  updater_free(&u);
+  return ok;
+}
+
+bool
+dom_tree_insert_edge(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *from, IRBasicBlock *to)
+{
+  DomUpdate update = {DOM_UPDATE_INSERT_EDGE, from, to};
+  return dom_tree_apply_updates(tree, df, &update, 1);
+}
+
+bool
+dom_tree_delete_edge(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *from, IRBasicBlock *to)
+{
+  DomUpdate update = {DOM_UPDATE_DELETE_EDGE, from, to};
+  return dom_tree_apply_updates(tree, df, &update, 1);
+}
+
+bool
+dom_tree_split_block(DominatorTree *tree, DominanceFrontier *df, IRBasicBlock *block, IRBasicBlock *new_block)
+{
+  DomUpdate update = {DOM_UPDATE_SPLIT_BLOCK, block, new_block};
+  return dom_tree_apply_updates(tree, df, &update, 1);
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/liveness.h"
+#include "analysis/dataflow.h"
+#include "ir/function.h"
+#include "utils/id_list.h"
+
+#include <stdint.h>
+
+/**
+ * @brief [内部] 值的定义块 (参数在入口块中定义)；不是指令结果或参数时返回 NULL
+ */
+static IRBasicBlock *
+def_block(const FunctionCFG *cfg, IRValueNode *value)
+{
+  if (value->kind == IR_KIND_INSTRUCTION)
+    return container_of(value, IRInstruction, result)->parent;
+  if (value->kind == IR_KIND_ARGUMENT)
+    return cfg->entry_node->block;
+  return NULL;
+}
+
+/**
+ * @brief [内部] inst 的第 k 个操作数是否是对跨块值的使用
+ *
+ * phi 的入边值总是算 (它在前驱的出口处被使用)；其他指令只算定义在别的块中的值。
+ */
+static bool
+is_cross_block_use(const FunctionCFG *cfg, IRInstruction *inst, IRValueNode *value)
+{
+  IRBasicBlock *def = def_block(cfg, value);
+  return def && (inst->opcode == IR_OP_PHI || def != inst->parent);
+}
+
+int
+liveness_value_index(const Liveness *lv, IRValueNode *value)
+{
+  uintptr_t slot = (uintptr_t)ptr_hashmap_get(lv->value_index, value);
+  return (int)slot - 1;
+}
+
+/**
+ * @brief [内部] 给跨块的值编号
+ *
+ * @param scratch 放候选数组的临时 Arena (每个使用最多一个候选)
+ */
+static void
+number_values(Liveness *lv, Bump *arena, Bump *scratch)
+{
+  FunctionCFG *cfg = lv->cfg;
+  size_t num_operands = 0;
+  for (int b = 0; b < cfg->num_nodes; b++)
+  {
+    IDList *iter;
+    list_for_each(&cfg->nodes[b].block->instructions, iter)
+    {
+      num_operands += list_entry(iter, IRInstruction, list_node)->num_operands;
+    }
+  }
+
+  IRValueNode **values = BUMP_ALLOC_SLICE(scratch, IRValueNode *, num_operands + 1);
+  int count = 0;
+  for (int b = 0; b < cfg->num_nodes; b++)
+  {
+    IDList *iter;
+    list_for_each(&cfg->nodes[b].block->instructions, iter)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      for (size_t k = 0; k < inst->num_operands; k++)
+      {
+        IRValueNode *value = ir_instruction_get_operand(inst, k);
+        if (!is_cross_block_use(cfg, inst, value) || liveness_value_index(lv, value) >= 0)
+          continue;
+        ptr_hashmap_put(lv->value_index, value, (void *)(uintptr_t)(count + 1));
+        values[count++] = value;
+      }
+    }
+  }
+
+  lv->num_values = count;
+  lv->values = BUMP_ALLOC_SLICE_COPY(arena, IRValueNode *, values, count > 0 ? count : 1);
+}
+
+Liveness *
+liveness_compute(FunctionCFG *cfg, Bump *arena)
+{
+  Liveness *lv = BUMP_ALLOC_ZEROED(arena, Liveness);
+  lv->cfg = cfg;
+  lv->value_index = ptr_hashmap_create(arena, 64);
+  int n = cfg->num_nodes;
+  if (n == 0)
+    return lv;
+
+  /// 中间数据 (use / def / phi 使用集合) 放在临时 Arena 中
+  Bump scratch;
+  bump_init(&scratch);
+  number_values(lv, arena, &scratch);
+  size_t num_bits = (size_t)lv->num_values;
+
+  Bitset **use = BUMP_ALLOC_SLICE(&scratch, Bitset *, n);
+  Bitset **def = BUMP_ALLOC_SLICE(&scratch, Bitset *, n);
+  Bitset **phi_uses = BUMP_ALLOC_SLICE(&scratch, Bitset *, n);
+  for (int b = 0; b < n; b++)
+  {
+    use[b] = bitset_create(num_bits, &scratch);
+    def[b] = bitset_create(num_bits, &scratch);
+    phi_uses[b] = bitset_create(num_bits, &scratch);
+  }
+
+  /// def: 每个跨块值只在它的定义块中
+  for (int i = 0; i < lv->num_values; i++)
+    bitset_set(def[def_block(cfg, lv->values[i])->id], (size_t)i);
+
+  /// use: 向上暴露的使用，即定义在别的块中的值 (块内的定义总是在使用之前)；
+  /// phi 的入边值记在对应的前驱上
+  for (int b = 0; b < n; b++)
+  {
+    IDList *iter;
+    list_for_each(&cfg->nodes[b].block->instructions, iter)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_PHI)
+      {
+        for (size_t k = 0; k + 1 < inst->num_operands; k += 2)
+        {
+          int index = liveness_value_index(lv, ir_instruction_get_operand(inst, k));
+          CFGNode *pred = cfg_get_node(cfg, (IRBasicBlock *)ir_instruction_get_operand(inst, k + 1));
+          if (index >= 0 && pred)
+            bitset_set(phi_uses[pred->id], (size_t)index);
+        }
+        continue;
+      }
+      for (size_t k = 0; k < inst->num_operands; k++)
+      {
+        IRValueNode *value = ir_instruction_get_operand(inst, k);
+        if (is_cross_block_use(cfg, inst, value))
+          bitset_set(use[b], (size_t)liveness_value_index(lv, value));
+      }
+    }
+  }
+
+  /// 后向的并集问题: phi 的使用是 meet 的起点，所以出现在前驱的出口而不是 phi 所在块的入口
+  DataflowGenKill gk = {.num_bits = num_bits, .gen = use, .kill = def, .init = phi_uses};
+  DataflowProblem problem = dataflow_gen_kill_problem(&gk, DATAFLOW_BACKWARD);
+  DataflowResult *result = dataflow_solve(cfg, &problem, arena);
+  lv->live_in = BUMP_ALLOC_SLICE(arena, Bitset *, n);
+  lv->live_out = BUMP_ALLOC_SLICE(arena, Bitset *, n);
+  for (int b = 0; b < n; b++)
+  {
+    lv->live_in[b] = (Bitset *)result->in[b];
+    lv->live_out[b] = (Bitset *)result->out[b];
+  }
+  lv->num_block_visits = result->num_visits;
+
+  bump_destroy(&scratch);
+  return lv;
+}
+
+const Bitset *
+liveness_live_in(const Liveness *lv, IRBasicBlock *bb)
+{
+  CFGNode *node = cfg_get_node(lv->cfg, bb);
+  return node ? lv->live_in[node->id] : NULL;
+}
+
+const Bitset *
+liveness_live_out(const Liveness *lv, IRBasicBlock *bb)
+{
+  CFGNode *node = cfg_get_node(lv->cfg, bb);
+  return node ? lv->live_out[node->id] : NULL;
+}
+
+bool
+liveness_is_live_in(const Liveness *lv, IRBasicBlock *bb, IRValueNode *value)
+{
+  const Bitset *set = liveness_live_in(lv, bb);
+  int index = liveness_value_index(lv, value);
+  return set && index >= 0 && bitset_test(set, (size_t)index);
+}
+
+bool
+liveness_is_live_out(const Liveness *lv, IRBasicBlock *bb, IRValueNode *value)
+{
+  const Bitset *set = liveness_live_out(lv, bb);
+  int index = liveness_value_index(lv, value);
+  return set && index >= 0 && bitset_test(set, (size_t)index);
+}
+
+bool
+liveness_is_live_after(const Liveness *lv, IRValueNode *value, IRInstruction *inst)
+{
+  IRBasicBlock *bb = inst->parent;
+  bool live = liveness_is_live_out(lv, bb, value);
+  /// 从终结指令往回走到 inst: 遇到定义变为不活跃，遇到 (非 phi 的) 使用变为活跃
+  for (IDList *iter = bb->instructions.prev; iter != &inst->list_node; iter = iter->prev)
+  {
+    IRInstruction *later = list_entry(iter, IRInstruction, list_node);
+    if (&later->result == value)
+    {
+      live = false;
+      continue;
+    }
+    if (later->opcode == IR_OP_PHI)
+      continue;
+    for (size_t k = 0; k < later->num_operands && !live; k++)
+      live = ir_instruction_get_operand(later, k) == value;
+  }
+  return live;
+}
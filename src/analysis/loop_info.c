@@ -0,0 +1,322 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/loop_info.h"
+
+#include <stddef.h>
+
+static inline bool
+is_reachable(const DomTreeNode *n)
+{
+  return n->depth > 0;
+}
+
+/** @brief [内部] a 是否支配 b (两者都可达) */
+static inline bool
+dominates(const DomTreeNode *a, const DomTreeNode *b)
+{
+  return a->dom_pre <= b->dom_pre && b->dom_post <= a->dom_post;
+}
+
+/** @brief [内部] loop 是否包含 id 为 block 的块 */
+static inline bool
+contains_id(const LoopInfo *li, const IRLoop *loop, int block)
+{
+  const IRLoop *inner = li->block_loop[block];
+  return inner && loop->pre <= inner->pre && inner->post <= loop->post;
+}
+
+/**
+ * @brief [内部] 把 id 为 block 的块的可达前驱压入 worklist
+ */
+static int
+push_preds(const DominatorTree *dt, int block, int *worklist, int top)
+{
+  const CFGNode *node = &dt->cfg->nodes[block];
+  for (int i = 0; i < node->num_preds; i++)
+  {
+    if (is_reachable(dt->nodes[node->preds[i]]))
+      worklist[top++] = node->preds[i];
+  }
+  return top;
+}
+
+/**
+ * @brief [内部] 找出所有循环和每个块的最内层循环，只设置 header、latches 和 parent
+ *
+ * header 按支配树先序倒着处理 (被支配的块在支配者之前)，所以内层循环先于外层循环被发现。
+ * 从 latch 沿前驱往回走: 还没有循环的块归入当前循环；已经属于某个 (内层) 循环的块，
+ * 找到它目前最外层的循环，挂到当前循环下面，再从那个循环的 header 的前驱继续。
+ *
+ * @return 发现的循环数 (found 中按发现的顺序，即内层在前)
+ */
+static int
+discover_loops(LoopInfo *li, Bump *arena, IRLoop **found, int *worklist)
+{
+  DominatorTree *dt = li->dom_tree;
+  FunctionCFG *cfg = li->cfg;
+  int num_found = 0;
+
+  for (int i = dt->num_reachable - 1; i >= 0; i--)
+  {
+    DomTreeNode *h = dt->dom_preorder[i];
+    int header = h->cfg_node->id;
+    const CFGNode *node = &cfg->nodes[header];
+
+    int top = 0;
+    for (int k = 0; k < node->num_preds; k++)
+    {
+      DomTreeNode *p = dt->nodes[node->preds[k]];
+      if (is_reachable(p) && dominates(h, p))
+        worklist[top++] = node->preds[k];
+    }
+    if (top == 0)
+      continue;
+
+    IRLoop *loop = BUMP_ALLOC_ZEROED(arena, IRLoop);
+    loop->header = node->block;
+    loop->num_latches = top;
+    loop->latches = BUMP_ALLOC_SLICE_COPY(arena, int, worklist, top);
+    found[num_found++] = loop;
+    li->block_loop[header] = loop;
+
+    while (top > 0)
+    {
+      int block = worklist[--top];
+      IRLoop *sub = li->block_loop[block];
+      if (!sub)
+      {
+        li->block_loop[block] = loop;
+        top = push_preds(dt, block, worklist, top);
+        continue;
+      }
+      while (sub->parent)
+        sub = sub->parent;
+      if (sub == loop)
+        continue;
+      /// 内层循环整个并入: 它的块都已经归属，从它的 header 的前驱继续 (回边的源会在上面被跳过)
+      sub->parent = loop;
+      top = push_preds(dt, sub->header->id, worklist, top);
+    }
+  }
+  return num_found;
+}
+
+/**
+ * @brief [内部] 建立嵌套森林: subloops / top_level，先序的 loops 数组，depth 和 pre/post 编号
+ */
+static void
+build_forest(LoopInfo *li, Bump *arena, IRLoop **found, int num_found, Bump *scratch)
+{
+  /// found 倒过来就是 header 的支配树先序，子循环和最外层循环都按这个顺序排列
+  for (int i = 0; i < num_found; i++)
+  {
+    if (found[i]->parent)
+      found[i]->parent->num_subloops++;
+    else
+      li->num_top_level++;
+  }
+  for (int i = 0; i < num_found; i++)
+  {
+    IRLoop *loop = found[i];
+    if (loop->num_subloops > 0)
+      loop->subloops = BUMP_ALLOC_SLICE(arena, IRLoop *, loop->num_subloops);
+    loop->num_subloops = 0;
+  }
+  li->top_level = BUMP_ALLOC_SLICE(arena, IRLoop *, li->num_top_level > 0 ? li->num_top_level : 1);
+  li->num_top_level = 0;
+  for (int i = num_found - 1; i >= 0; i--)
+  {
+    IRLoop *loop = found[i];
+    if (loop->parent)
+      loop->parent->subloops[loop->parent->num_subloops++] = loop;
+    else
+      li->top_level[li->num_top_level++] = loop;
+  }
+
+  /// 显式栈上的 DFS: stack 存循环，next 存下一个要访问的子循环下标
+  IRLoop **stack = BUMP_ALLOC_SLICE(scratch, IRLoop *, num_found + 1);
+  int *next = BUMP_ALLOC_SLICE(scratch, int, num_found + 1);
+  li->loops = BUMP_ALLOC_SLICE(arena, IRLoop *, num_found > 0 ? num_found : 1);
+  li->num_loops = 0;
+  int counter = 0;
+  for (int t = 0; t < li->num_top_level; t++)
+  {
+    int top = 0;
+    IRLoop *root = li->top_level[t];
+    root->depth = 1;
+    root->pre = ++counter;
+    li->loops[li->num_loops++] = root;
+    stack[top] = root;
+    next[top++] = 0;
+    while (top > 0)
+    {
+      IRLoop *loop = stack[top - 1];
+      if (next[top - 1] < loop->num_subloops)
+      {
+        IRLoop *child = loop->subloops[next[top - 1]++];
+        child->depth = loop->depth + 1;
+        child->pre = ++counter;
+        li->loops[li->num_loops++] = child;
+        stack[top] = child;
+        next[top++] = 0;
+      }
+      else
+      {
+        loop->post = ++counter;
+        top--;
+      }
+    }
+  }
+}
+
+/**
+ * @brief [内部] 填入每个循环的块、出口和前置块
+ */
+static void
+fill_loop_blocks(LoopInfo *li, Bump *arena, int *buffer, int *stamp)
+{
+  DominatorTree *dt = li->dom_tree;
+  FunctionCFG *cfg = li->cfg;
+
+  /// 按支配树先序把块加进它所在的每一层循环: 先数，再填
+  for (int i = 0; i < dt->num_reachable; i++)
+  {
+    int block = dt->dom_preorder[i]->cfg_node->id;
+    for (IRLoop *loop = li->block_loop[block]; loop; loop = loop->parent)
+      loop->num_blocks++;
+  }
+  for (int l = 0; l < li->num_loops; l++)
+  {
+    IRLoop *loop = li->loops[l];
+    loop->blocks = BUMP_ALLOC_SLICE(arena, int, loop->num_blocks);
+    loop->num_blocks = 0;
+  }
+  for (int i = 0; i < dt->num_reachable; i++)
+  {
+    int block = dt->dom_preorder[i]->cfg_node->id;
+    for (IRLoop *loop = li->block_loop[block]; loop; loop = loop->parent)
+      loop->blocks[loop->num_blocks++] = block;
+  }
+
+  for (int i = 0; i < cfg->num_nodes; i++)
+    stamp[i] = -1;
+  for (int l = 0; l < li->num_loops; l++)
+  {
+    IRLoop *loop = li->loops[l];
+    int count = 0;
+    for (int i = 0; i < loop->num_blocks; i++)
+    {
+      const CFGNode *node = &cfg->nodes[loop->blocks[i]];
+      for (int k = 0; k < node->num_succs; k++)
+      {
+        int succ = node->succs[k];
+        if (stamp[succ] != l && !contains_id(li, loop, succ))
+        {
+          stamp[succ] = l;
+          buffer[count++] = succ;
+        }
+      }
+    }
+    loop->num_exits = count;
+    loop->exits = count > 0 ? BUMP_ALLOC_SLICE_COPY(arena, int, buffer, count) : NULL;
+
+    /// 前置块: header 在循环外的前驱 (包括不可达的) 只有一个，而且它只有这一个后继
+    const CFGNode *header = &cfg->nodes[loop->header->id];
+    int outside = -1;
+    int num_outside = 0;
+    for (int k = 0; k < header->num_preds; k++)
+    {
+      if (!contains_id(li, loop, header->preds[k]))
+      {
+        outside = header->preds[k];
+        num_outside++;
+      }
+    }
+    if (num_outside == 1 && cfg->nodes[outside].num_succs == 1)
+      loop->preheader = cfg->nodes[outside].block;
+  }
+}
+
+LoopInfo *
+loop_info_compute(DominatorTree *dt, Bump *arena)
+{
+  FunctionCFG *cfg = dt->cfg;
+  int n = cfg->num_nodes;
+
+  LoopInfo *li = BUMP_ALLOC_ZEROED(arena, LoopInfo);
+  li->cfg = cfg;
+  li->dom_tree = dt;
+  li->num_blocks = n;
+  li->block_loop = BUMP_ALLOC_SLICE_ZEROED(arena, IRLoop *, n > 0 ? n : 1);
+
+  /// 临时数据放在单独的 Arena 中，返回前释放
+  Bump scratch;
+  bump_init(&scratch);
+  int num_edges = 0;
+  for (int i = 0; i < n; i++)
+    num_edges += cfg->nodes[i].num_succs;
+  /// 一个块可能被它的多个后继各压入一次，所以 worklist 按边数分配
+  int *worklist = BUMP_ALLOC_SLICE(&scratch, int, num_edges + n + 1);
+  IRLoop **found = BUMP_ALLOC_SLICE(&scratch, IRLoop *, n + 1);
+
+  int num_found = discover_loops(li, arena, found, worklist);
+
+  build_forest(li, arena, found, num_found, &scratch);
+  fill_loop_blocks(li, arena, worklist, BUMP_ALLOC_SLICE(&scratch, int, n + 1));
+
+  bump_destroy(&scratch);
+  return li;
+}
+
+/** @brief [内部] bb 在 li 中的 id，不在时为 -1 */
+static int
+block_id(LoopInfo *li, IRBasicBlock *bb)
+{
+  CFGNode *node = cfg_get_node(li->cfg, bb);
+  if (!node || node->id >= li->num_blocks)
+    return -1;
+  return node->id;
+}
+
+IRLoop *
+loop_info_get_loop(LoopInfo *li, IRBasicBlock *bb)
+{
+  int id = block_id(li, bb);
+  return id < 0 ? NULL : li->block_loop[id];
+}
+
+int
+loop_info_get_depth(LoopInfo *li, IRBasicBlock *bb)
+{
+  IRLoop *loop = loop_info_get_loop(li, bb);
+  return loop ? loop->depth : 0;
+}
+
+bool
+loop_info_is_header(LoopInfo *li, IRBasicBlock *bb)
+{
+  IRLoop *loop = loop_info_get_loop(li, bb);
+  return loop && loop->header == bb;
+}
+
+bool
+loop_info_contains(LoopInfo *li, const IRLoop *loop, IRBasicBlock *bb)
+{
+  int id = block_id(li, bb);
+  return id >= 0 && contains_id(li, loop, id);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/post_dom_tree.h"
+
+PostDominatorTree *
+post_dom_tree_build(FunctionCFG *cfg, Bump *arena)
+{
+  return post_dom_tree_build_with_algorithm(cfg, arena, DOM_TREE_LENGAUER_TARJAN);
+}
+
+PostDominatorTree *
+post_dom_tree_build_with_algorithm(FunctionCFG *cfg, Bump *arena, DomTreeAlgorithm algorithm)
+{
+  if (!cfg || cfg->num_nodes == 0)
+    return NULL;
+
+  PostDominatorTree *pdt = BUMP_ALLOC_ZEROED(arena, PostDominatorTree);
+  pdt->cfg = cfg;
+  pdt->reverse_cfg = cfg_build_reverse(cfg, arena);
+  pdt->virtual_exit = pdt->reverse_cfg->entry_node;
+  pdt->tree = dom_tree_build_with_algorithm(pdt->reverse_cfg, arena, algorithm);
+  return pdt;
+}
+
+void
+post_dom_tree_destroy(PostDominatorTree *pdt)
+{
+  if (!pdt)
+    return;
+  dom_tree_destroy(pdt->tree);
+  cfg_destroy(pdt->reverse_cfg);
+}
+
+bool
+post_dom_tree_postdominates(PostDominatorTree *pdt, IRBasicBlock *a, IRBasicBlock *b)
+{
+  return dom_tree_dominates(pdt->tree, a, b);
+}
+
+IRBasicBlock *
+post_dom_tree_get_ipdom(PostDominatorTree *pdt, IRBasicBlock *b)
+{
+  /// 虚拟出口的 block 是 NULL，所以直接后支配者是虚拟出口时自然返回 NULL
+  return dom_tree_get_idom(pdt->tree, b);
+}
+
+DominanceFrontier *
+post_dom_frontier_compute(PostDominatorTree *pdt, Bump *arena)
+{
+  return ir_analysis_dom_frontier_compute(pdt->tree, arena);
+}
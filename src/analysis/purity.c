@@ -0,0 +1,109 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/purity.h"
+#include "ir/basicblock.h"
+#include "ir/instruction.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+/**
+ * @brief 地址是否一定指向本函数 alloca 出来的内存
+ *
+ * 只认 alloca 本身和以它为基址的 gep 链；来自 phi / select / load / inttoptr
+ * 的地址保守地视为非局部。
+ */
+static bool
+is_local_address(IRValueNode *addr)
+{
+  while (addr->kind == IR_KIND_INSTRUCTION)
+  {
+    IRInstruction *inst = container_of(addr, IRInstruction, result);
+    if (inst->opcode == IR_OP_ALLOCA)
+      return true;
+    if (inst->opcode != IR_OP_GEP)
+      return false;
+    addr = ir_instruction_get_operand(inst, 0);
+  }
+  return false;
+}
+
+/**
+ * @brief 沿调用图深度优先地检查 func 及其可达的被调者
+ *
+ * visited 中的函数 (包括仍在检查中的调用者) 视为纯: 根函数的结果是它可达的
+ * 所有函数的局部检查结果之和，所以递归调用不影响正确性。
+ */
+static bool
+check_function(IRFunction *func, PtrHashMap *visited)
+{
+  /// 还没物化的函数体未知，保守地视为不纯
+  if (func->is_declaration || !ir_function_is_materialized(func))
+    return false;
+  if (ptr_hashmap_contains(visited, func))
+    return true;
+  if (!ptr_hashmap_put(visited, func, func))
+    return false;
+
+  IDList *bb_it;
+  list_for_each(&func->basic_blocks, bb_it)
+  {
+    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+    IDList *inst_it;
+    list_for_each(&bb->instructions, inst_it)
+    {
+      IRInstruction *inst = list_entry(inst_it, IRInstruction, list_node);
+      switch (inst->opcode)
+      {
+      case IR_OP_LOAD:
+        if (!is_local_address(ir_instruction_get_operand(inst, 0)))
+          return false;
+        break;
+      case IR_OP_STORE:
+        if (!is_local_address(ir_instruction_get_operand(inst, 1)))
+          return false;
+        break;
+      case IR_OP_CALL: {
+        /// 只跟踪直接调用；通过函数指针的间接调用无法确定被调者
+        IRValueNode *callee = ir_instruction_get_operand(inst, 0);
+        if (callee->kind != IR_KIND_FUNCTION)
+          return false;
+        if (!check_function(container_of(callee, IRFunction, entry_address), visited))
+          return false;
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool
+purity_is_pure_function(IRFunction *func)
+{
+  Bump *arena = bump_new();
+  if (!arena)
+    return false;
+  PtrHashMap *visited = ptr_hashmap_create(arena, 16);
+  bool pure = visited && check_function(func, visited);
+  bump_free(arena);
+  return pure;
+}
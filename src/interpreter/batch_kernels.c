@@ -0,0 +1,242 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/batch_kernels.h"
+#include "utils/cpu_features.h"
+
+#include <assert.h>
+#include <math.h>
+
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
+/*
+ * 每个内核都先在循环外选定运算，再对所有 lane 执行同一个无分支的循环体:
+ * 计算新值，然后按掩码与旧值做位运算混合 (而不是条件写，后者会阻止向量化)。
+ */
+
+/** @brief 按掩码混合: mask 为 1 时取 value，否则保留 old */
+#define BATCH_BLEND(old, value, m) (((value) & (0 - (uint64_t)(m))) | ((old) & ((uint64_t)(m) - 1)))
+
+/**
+ * @brief 对每个 lane 计算 expr (u64)，按 dst_mask 位宽符号扩展后按掩码写入 dst
+ * (用 xor / sub 做符号扩展: AVX2 没有 64 位的算术右移)
+ */
+#define BATCH_INT_MAP(expr)                                                                                            \
+  for (size_t i = 0; i < INTERP_BATCH_WIDTH; i++)                                                                      \
+  {                                                                                                                    \
+    uint64_t r_ = (expr);                                                                                              \
+    r_ = ((r_ & dst_mask) ^ sign_bit) - sign_bit;                                                                      \
+    dst[i] = BATCH_BLEND(dst[i], r_, mask[i]);                                                                         \
+  }
+
+/** @brief 对每个 lane 计算 expr (u64)，按掩码写入 dst */
+#define BATCH_U64_MAP(expr)                                                                                            \
+  for (size_t i = 0; i < INTERP_BATCH_WIDTH; i++)                                                                      \
+  {                                                                                                                    \
+    uint64_t r_ = (expr);                                                                                              \
+    dst[i] = BATCH_BLEND(dst[i], r_, mask[i]);                                                                         \
+  }
+
+/** @brief 对每个 lane 计算 expr (double)，按掩码写入 dst (f32 与 f64 各一个循环，循环内不判断精度) */
+#define BATCH_F64_MAP(expr)                                                                                            \
+  if (is_f32)                                                                                                          \
+  {                                                                                                                    \
+    for (size_t i = 0; i < INTERP_BATCH_WIDTH; i++)                                                                    \
+    {                                                                                                                  \
+      double r_ = (double)(float)(expr);                                                                               \
+      dst[i] = BATCH_BLEND(dst[i], batch_lane_from_f64(r_), mask[i]);                                                  \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  else                                                                                                                 \
+  {                                                                                                                    \
+    for (size_t i = 0; i < INTERP_BATCH_WIDTH; i++)                                                                    \
+    {                                                                                                                  \
+      double r_ = (expr);                                                                                              \
+      dst[i] = BATCH_BLEND(dst[i], batch_lane_from_f64(r_), mask[i]);                                                  \
+    }                                                                                                                  \
+  }
+
+/** @brief 对每个 lane 计算浮点谓词 expr (x_ / y_ 为两个操作数)，按掩码写入 dst */
+#define BATCH_FCMP_MAP(expr)                                                                                           \
+  for (size_t i = 0; i < INTERP_BATCH_WIDTH; i++)                                                                      \
+  {                                                                                                                    \
+    double x_ = batch_lane_as_f64(lhs[i]);                                                                             \
+    double y_ = batch_lane_as_f64(rhs[i]);                                                                             \
+    uint64_t uno_ = (uint64_t)isunordered(x_, y_);                                                                     \
+    uint64_t r_ = (expr);                                                                                              \
+    dst[i] = BATCH_BLEND(dst[i], r_, mask[i]);                                                                         \
+  }
+
+/**
+ * @brief 位宽为 bits 的无符号掩码
+ */
+static inline uint64_t
+width_mask(unsigned bits)
+{
+  return (bits >= 64) ? UINT64_MAX : ((UINT64_C(1) << bits) - 1);
+}
+
+/**
+ * @brief 算术右移 (同理用逻辑右移实现: 负数先取反，移位后再取反回来)
+ */
+static inline uint64_t
+ashr_u64(uint64_t x, uint64_t amt)
+{
+  uint64_t sign = 0 - (x >> 63);
+  return ((x ^ sign) >> amt) ^ sign;
+}
+
+/*
+ * --- 各指令集的实现 ---
+ *
+ * 同一份函数体 (batch_kernels.inc) 按不同的 target 属性编译多次，运行时按 cpu_features() 选用。
+ */
+
+/// 基线实现: 按编译器的默认指令集向量化 (x86-64 为 SSE2，AArch64 为 NEON)
+#define BATCH_KERNEL_NAME(name) batch_##name##_generic
+#define BATCH_KERNEL_TARGET
+#include "batch_kernels.inc"
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BATCH_KERNELS_X86 1
+
+#define BATCH_KERNEL_NAME(name) batch_##name##_avx2
+#define BATCH_KERNEL_TARGET __attribute__((target("avx2")))
+#include "batch_kernels.inc"
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+
+#define BATCH_KERNEL_NAME(name) batch_##name##_avx512
+#define BATCH_KERNEL_TARGET __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq")))
+#include "batch_kernels.inc"
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+#endif
+
+#define BATCH_KERNEL_TABLE(suffix)                                                                                     \
+  {                                                                                                                    \
+    .name = #suffix,                                                                                                   \
+    .int_binary = batch_int_binary_##suffix,                                                                           \
+    .float_binary = batch_float_binary_##suffix,                                                                       \
+    .icmp = batch_icmp_##suffix,                                                                                       \
+    .fcmp = batch_fcmp_##suffix,                                                                                       \
+    .select = batch_select_##suffix,                                                                                   \
+    .int_cast = batch_int_cast_##suffix,                                                                               \
+    .float_cast = batch_float_cast_##suffix,                                                                           \
+    .copy = batch_copy_##suffix,                                                                                       \
+  }
+
+static const BatchKernelTable GENERIC_KERNELS = BATCH_KERNEL_TABLE(generic);
+#ifdef BATCH_KERNELS_X86
+static const BatchKernelTable AVX2_KERNELS = BATCH_KERNEL_TABLE(avx2);
+static const BatchKernelTable AVX512_KERNELS = BATCH_KERNEL_TABLE(avx512);
+#endif
+
+const BatchKernelTable *
+batch_kernels_for(CpuFeatures features)
+{
+#ifdef BATCH_KERNELS_X86
+  if (features & CPU_FEATURE_AVX512)
+    return &AVX512_KERNELS;
+  if (features & CPU_FEATURE_AVX2)
+    return &AVX2_KERNELS;
+#else
+  (void)features;
+#endif
+  return &GENERIC_KERNELS;
+}
+
+#if !defined(__STDC_NO_ATOMICS__)
+static _Atomic(const BatchKernelTable *) SELECTED_KERNELS = NULL;
+#else
+static const BatchKernelTable *SELECTED_KERNELS = NULL;
+#endif
+
+const BatchKernelTable *
+batch_kernels(void)
+{
+  /// 第一次调用时选定；并发的第一次调用会选出同一张表
+  const BatchKernelTable *table = SELECTED_KERNELS;
+  if (!table)
+  {
+    table = batch_kernels_for(cpu_features());
+    SELECTED_KERNELS = table;
+  }
+  return table;
+}
+
+/*
+ * --- 公共入口: 转发到选定的实现 ---
+ */
+
+void
+batch_kernel_int_binary(IROpcode opcode, unsigned bits, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                        const uint8_t *mask)
+{
+  batch_kernels()->int_binary(opcode, bits, dst, lhs, rhs, mask);
+}
+
+bool
+batch_kernel_float_binary(IROpcode opcode, bool is_f32, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                          const uint8_t *mask)
+{
+  return batch_kernels()->float_binary(opcode, is_f32, dst, lhs, rhs, mask);
+}
+
+void
+batch_kernel_icmp(IRICmpPredicate pred, unsigned bits, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                  const uint8_t *mask)
+{
+  batch_kernels()->icmp(pred, bits, dst, lhs, rhs, mask);
+}
+
+void
+batch_kernel_fcmp(IRFCmpPredicate pred, BatchLane *dst, const BatchLane *lhs, const BatchLane *rhs,
+                  const uint8_t *mask)
+{
+  batch_kernels()->fcmp(pred, dst, lhs, rhs, mask);
+}
+
+void
+batch_kernel_select(BatchLane *dst, const BatchLane *cond, const BatchLane *on_true, const BatchLane *on_false,
+                    const uint8_t *mask)
+{
+  batch_kernels()->select(dst, cond, on_true, on_false, mask);
+}
+
+void
+batch_kernel_int_cast(IROpcode opcode, unsigned src_bits, unsigned dst_bits, BatchLane *dst, const BatchLane *src,
+                      const uint8_t *mask)
+{
+  batch_kernels()->int_cast(opcode, src_bits, dst_bits, dst, src, mask);
+}
+
+void
+batch_kernel_float_cast(IROpcode opcode, unsigned src_bits, bool dst_is_f32, BatchLane *dst, const BatchLane *src,
+                        const uint8_t *mask)
+{
+  batch_kernels()->float_cast(opcode, src_bits, dst_is_f32, dst, src, mask);
+}
+
+void
+batch_kernel_copy(BatchLane *dst, const BatchLane *src, const uint8_t *mask)
+{
+  batch_kernels()->copy(dst, src, mask);
+}
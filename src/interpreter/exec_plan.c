@@ -0,0 +1,585 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/exec_plan.h"
+
+#include "ir/basicblock.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/type.h"
+#include "ir/use.h"
+#include "ir/value.h"
+
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * =================================================================
+ * --- 内部辅助函数 ---
+ * =================================================================
+ */
+
+/// 哈希表中的值存储为 (index + 1)，这样 NULL 依然表示 "未找到"
+#define INDEX_TO_PTR(idx) ((void *)(uintptr_t)((idx) + 1))
+#define PTR_TO_INDEX(ptr) ((uint32_t)((uintptr_t)(ptr) - 1))
+
+/**
+ * @brief 降级过程中的临时状态
+ */
+typedef struct PlanBuilder
+{
+  ExecPlan *plan;
+  /** Map<IRValueNode*, slot + 1> (参数 / 指令 / 外部值) */
+  PtrHashMap *slot_map;
+  /** Map<IRValueNode* (label_address), block_index + 1> */
+  PtrHashMap *block_map;
+  /** 外部槽位的容量 (上界 = 操作数总数) */
+  uint32_t externs_capacity;
+} PlanBuilder;
+
+static bool
+is_terminator(uint32_t opcode)
+{
+  return opcode == IR_OP_RET || opcode == IR_OP_BR || opcode == IR_OP_COND_BR || opcode == IR_OP_SWITCH;
+}
+
+/**
+ * @brief 指令是否可以在批量模式中执行 (没有内存访问、没有调用)
+ */
+static bool
+is_batchable_opcode(IROpcode opcode)
+{
+  switch (opcode)
+  {
+  case IR_OP_ALLOCA:
+  case IR_OP_LOAD:
+  case IR_OP_STORE:
+  case IR_OP_CALL:
+    return false;
+  default:
+    return true;
+  }
+}
+
+/**
+ * @brief 将一个操作数解析为槽位编号或基本块编号
+ */
+static uint32_t
+resolve_operand(PlanBuilder *pb, IRValueNode *val)
+{
+  if (val->kind == IR_KIND_BASIC_BLOCK)
+  {
+    void *idx = ptr_hashmap_get(pb->block_map, val);
+    assert(idx && "ExecPlan: Branch target is not a block of this function");
+    return PTR_TO_INDEX(idx);
+  }
+
+  void *slot = ptr_hashmap_get(pb->slot_map, val);
+  if (slot)
+  {
+    return PTR_TO_INDEX(slot);
+  }
+
+  /// 常量 / 全局变量 / 函数地址: 第一次遇到时分配一个外部槽位
+  assert((val->kind == IR_KIND_CONSTANT || val->kind == IR_KIND_GLOBAL || val->kind == IR_KIND_FUNCTION) &&
+         "ExecPlan: Use of a value not defined in this function");
+
+  ExecPlan *plan = pb->plan;
+  assert(plan->num_externs < pb->externs_capacity);
+
+  ExecSlot new_slot = plan->num_slots++;
+  ExecExternSlot *ext = &plan->externs[plan->num_externs++];
+  ext->slot = new_slot;
+  ext->value = val;
+
+  ptr_hashmap_put(pb->slot_map, val, INDEX_TO_PTR(new_slot));
+  return new_slot;
+}
+
+/**
+ * @brief 降级一条指令到 plan->insts[inst_idx]
+ */
+static void
+lower_instruction(PlanBuilder *pb, IRInstruction *inst, uint32_t inst_idx, uint32_t **operand_pool)
+{
+  ExecInst *ei = &pb->plan->insts[inst_idx];
+  ei->opcode = inst->opcode;
+  ei->ir = inst;
+
+  void *slot = ptr_hashmap_get(pb->slot_map, &inst->result);
+  ei->result = slot ? PTR_TO_INDEX(slot) : EXEC_INVALID_INDEX;
+
+  ei->num_operands = (uint32_t)ir_instruction_get_num_operands(inst);
+  ei->operands = *operand_pool;
+  *operand_pool += ei->num_operands;
+
+  for (uint32_t i = 0; i < ei->num_operands; i++)
+  {
+    ei->operands[i] = resolve_operand(pb, ir_instruction_get_operand(inst, i));
+  }
+}
+
+/**
+ * @brief 标记块中紧跟着 'ret' 其结果的 'call' 为尾调用
+ *
+ * (调用者保证所在函数没有 'alloca')
+ */
+static void
+mark_tail_calls(ExecPlan *plan, ExecBlock *eb)
+{
+  uint32_t end = eb->first_inst + eb->num_insts;
+  for (uint32_t i = eb->first_inst + eb->num_phis; i + 1 < end; i++)
+  {
+    ExecInst *call = &plan->insts[i];
+    ExecInst *ret = &plan->insts[i + 1];
+    if (call->opcode != IR_OP_CALL || ret->opcode != IR_OP_RET)
+      continue;
+
+    bool returns_result = (ret->num_operands == 1 && ret->operands[0] == call->result);
+    bool returns_void = (ret->num_operands == 0 && call->result == EXEC_INVALID_INDEX);
+    if (returns_result || returns_void)
+      call->flags |= EXEC_INST_TAIL_CALL;
+  }
+}
+
+/**
+ * @brief 值是否只有唯一一个使用者
+ */
+static bool
+has_single_use(IRValueNode *val)
+{
+  return !list_empty(&val->uses) && val->uses.next->next == &val->uses;
+}
+
+static bool
+is_fusable_binary(uint32_t opcode)
+{
+  return (opcode >= IR_OP_ADD && opcode <= IR_OP_XOR);
+}
+
+/**
+ * @brief 尝试以 plan->insts[k] 开头融合一个超级指令
+ *
+ * @param end 当前块的指令末尾 (不含)
+ * @return 被融合的指令数 (0 表示没有融合)
+ */
+static uint32_t
+try_fuse(ExecPlan *plan, uint32_t k, uint32_t end)
+{
+  ExecInst *a = &plan->insts[k];
+  ExecInst *b = (k + 1 < end) ? &plan->insts[k + 1] : NULL;
+  ExecInst *c = (k + 2 < end) ? &plan->insts[k + 2] : NULL;
+  if (!b)
+    return 0;
+
+  /// load %p -> binop (%v, x) -> store (%r, %q)
+  if (c && a->opcode == IR_OP_LOAD && is_fusable_binary(b->opcode) && c->opcode == IR_OP_STORE &&
+      (b->operands[0] == a->result || b->operands[1] == a->result) && c->operands[0] == b->result &&
+      has_single_use(&a->ir->result) && has_single_use(&b->ir->result))
+  {
+    a->opcode = EXEC_OP_LOAD_BINOP_STORE;
+    return 3;
+  }
+
+  /// gep -> load
+  if (a->opcode == IR_OP_GEP && b->opcode == IR_OP_LOAD && b->operands[0] == a->result &&
+      has_single_use(&a->ir->result))
+  {
+    a->opcode = EXEC_OP_GEP_LOAD;
+    return 2;
+  }
+
+  /// icmp -> cond_br
+  if (a->opcode == IR_OP_ICMP && b->opcode == IR_OP_COND_BR && b->operands[0] == a->result &&
+      has_single_use(&a->ir->result))
+  {
+    a->opcode = EXEC_OP_ICMP_BR;
+    return 2;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 在一个块内贪心地融合超级指令 (PHI 之后，从前往后)
+ */
+static void
+fuse_block(ExecPlan *plan, ExecBlock *eb)
+{
+  uint32_t end = eb->first_inst + eb->num_insts;
+  uint32_t k = eb->first_inst + eb->num_phis;
+  while (k < end)
+  {
+    uint32_t span = try_fuse(plan, k, end);
+    if (span == 0)
+    {
+      k++;
+      continue;
+    }
+    plan->fusion_counts[plan->insts[k].opcode - EXEC_OP_FIRST_FUSED]++;
+    k += span;
+  }
+}
+
+/** @brief 一条特化规则: (IR opcode, 静态类型) -> 特化的操作码 */
+typedef struct TypedOpRule
+{
+  uint32_t ir_opcode;
+  IRTypeKind type;
+  uint32_t exec_opcode;
+} TypedOpRule;
+
+#define EXEC_TYPED_OP_RULE(name, ir_op, ty) {ir_op, ty, EXEC_OP_##name},
+static const TypedOpRule TYPED_OP_RULES[] = {EXEC_TYPED_OPS(EXEC_TYPED_OP_RULE)};
+#undef EXEC_TYPED_OP_RULE
+
+/**
+ * @brief 超级指令 (组首) 覆盖的指令数
+ */
+static uint32_t
+fused_span(uint32_t opcode)
+{
+  return (opcode == EXEC_OP_LOAD_BINOP_STORE) ? 3 : 2;
+}
+
+/**
+ * @brief 把块中没有被融合的常见运算替换为按静态类型特化的指令
+ */
+static void
+specialize_block(ExecPlan *plan, ExecBlock *eb)
+{
+  uint32_t end = eb->first_inst + eb->num_insts;
+  uint32_t k = eb->first_inst + eb->num_phis;
+  while (k < end)
+  {
+    ExecInst *ei = &plan->insts[k];
+    if (ei->opcode >= EXEC_OP_FIRST_FUSED)
+    {
+      k += fused_span(ei->opcode);
+      continue;
+    }
+
+    IRValueNode *typed_value = (ei->opcode == IR_OP_ICMP) ? ir_instruction_get_operand(ei->ir, 0) : &ei->ir->result;
+    IRTypeKind type = typed_value->type ? typed_value->type->kind : IR_TYPE_VOID;
+    for (size_t r = 0; r < sizeof(TYPED_OP_RULES) / sizeof(TYPED_OP_RULES[0]); r++)
+    {
+      if (TYPED_OP_RULES[r].ir_opcode == ei->opcode && TYPED_OP_RULES[r].type == type)
+      {
+        ei->opcode = TYPED_OP_RULES[r].exec_opcode;
+        break;
+      }
+    }
+    k++;
+  }
+}
+
+/**
+ * @brief 终结指令的第 i 个操作数是否是跳转目标 (标签)
+ */
+static bool
+is_label_operand(ExecInst *ei, uint32_t i)
+{
+  return ir_instruction_get_operand(ei->ir, i)->kind == IR_KIND_BASIC_BLOCK;
+}
+
+/**
+ * @brief 将边 (pred -> target) 上目标块 PHI 的并行复制顺序化，追加到 plan->copies
+ *
+ * 反复发出 "目的槽位不再被任何待处理复制读取" 的复制；
+ * 只剩下环时，先把其中一个目的槽位的旧值存入 copy_temp_slot 再继续。
+ *
+ * @param pending 临时缓冲 (容量 >= 目标块的 PHI 数)
+ * @return 如果某个 PHI 没有来自 pred 的入边值，返回 false
+ */
+static bool
+sequentialize_edge_copies(ExecPlan *plan, uint32_t pred, ExecEdge *edge, ExecCopy *pending)
+{
+  ExecBlock *target = &plan->blocks[edge->target];
+  uint32_t num_pending = 0;
+
+  for (uint32_t p = 0; p < target->num_phis; p++)
+  {
+    ExecInst *phi = &plan->insts[target->first_inst + p];
+    ExecSlot src = EXEC_INVALID_INDEX;
+    for (uint32_t i = 0; i + 1 < phi->num_operands; i += 2)
+    {
+      if (phi->operands[i + 1] == pred)
+      {
+        src = phi->operands[i];
+        break;
+      }
+    }
+    if (src == EXEC_INVALID_INDEX)
+      return false;
+
+    /// 自复制 (e.g., 循环中不变的 PHI) 可以直接丢弃
+    if (src != phi->result)
+    {
+      pending[num_pending].src = src;
+      pending[num_pending].dst = phi->result;
+      num_pending++;
+    }
+  }
+
+  edge->first_copy = plan->num_copies;
+  while (num_pending > 0)
+  {
+    /// 找一个目的槽位不再被其他复制读取的复制
+    uint32_t ready = num_pending;
+    for (uint32_t i = 0; i < num_pending && ready == num_pending; i++)
+    {
+      bool dst_is_read = false;
+      for (uint32_t j = 0; j < num_pending; j++)
+      {
+        if (j != i && pending[j].src == pending[i].dst)
+        {
+          dst_is_read = true;
+          break;
+        }
+      }
+      if (!dst_is_read)
+        ready = i;
+    }
+
+    if (ready == num_pending)
+    {
+      /// 只剩下环: 保存 pending[0].dst 的旧值，并让读取它的复制改读临时槽位
+      ExecSlot saved = pending[0].dst;
+      plan->copies[plan->num_copies++] = (ExecCopy){.src = saved, .dst = plan->copy_temp_slot};
+      for (uint32_t j = 1; j < num_pending; j++)
+      {
+        if (pending[j].src == saved)
+          pending[j].src = plan->copy_temp_slot;
+      }
+      ready = 0;
+    }
+
+    plan->copies[plan->num_copies++] = pending[ready];
+    pending[ready] = pending[--num_pending];
+  }
+  edge->num_copies = plan->num_copies - edge->first_copy;
+  return true;
+}
+
+/**
+ * @brief 为所有终结指令的跳转目标构建 ExecEdge，并把标签操作数改写为边编号
+ */
+static bool
+build_edges(ExecPlan *plan, Bump *arena, Bump *scratch)
+{
+  /// 统计边数和复制数的上界 (每个 PHI 一次复制，每个环最多再多一次)
+  uint32_t max_edges = 0;
+  uint32_t max_copies = 0;
+  uint32_t max_phis = 0;
+  for (uint32_t b = 0; b < plan->num_blocks; b++)
+  {
+    ExecBlock *eb = &plan->blocks[b];
+    ExecInst *term = &plan->insts[eb->first_inst + eb->num_insts - 1];
+    if (eb->num_phis > max_phis)
+      max_phis = eb->num_phis;
+    for (uint32_t i = 0; i < term->num_operands; i++)
+    {
+      if (is_label_operand(term, i))
+      {
+        max_edges++;
+        max_copies += 2 * plan->blocks[term->operands[i]].num_phis;
+      }
+    }
+  }
+
+  plan->edges = BUMP_ALLOC_SLICE(arena, ExecEdge, max_edges);
+  plan->copies = BUMP_ALLOC_SLICE(arena, ExecCopy, max_copies);
+  ExecCopy *pending = BUMP_ALLOC_SLICE(scratch, ExecCopy, max_phis);
+  if ((max_edges && !plan->edges) || (max_copies && !plan->copies) || (max_phis && !pending))
+    return false;
+
+  for (uint32_t b = 0; b < plan->num_blocks; b++)
+  {
+    ExecBlock *eb = &plan->blocks[b];
+    ExecInst *term = &plan->insts[eb->first_inst + eb->num_insts - 1];
+    for (uint32_t i = 0; i < term->num_operands; i++)
+    {
+      if (!is_label_operand(term, i))
+        continue;
+
+      ExecEdge *edge = &plan->edges[plan->num_edges];
+      edge->target = term->operands[i];
+      if (!sequentialize_edge_copies(plan, b, edge, pending))
+        return false;
+      term->operands[i] = plan->num_edges++;
+    }
+  }
+  return true;
+}
+
+/*
+ * =================================================================
+ * --- 公共 API ---
+ * =================================================================
+ */
+
+ExecPlan *
+exec_plan_build(IRFunction *func, Bump *arena, bool enable_fusion)
+{
+  assert(func != NULL && arena != NULL);
+  if (func->is_declaration || list_empty(&func->basic_blocks))
+    return NULL;
+
+  ExecPlan *plan = BUMP_ALLOC_ZEROED(arena, ExecPlan);
+  if (!plan)
+    return NULL;
+  plan->func = func;
+
+  /// 临时映射只在降级期间需要，放在独立的竞技场中
+  Bump scratch;
+  bump_init(&scratch);
+
+  PlanBuilder pb;
+  pb.plan = plan;
+  pb.slot_map = ptr_hashmap_create(&scratch, 64);
+  pb.block_map = ptr_hashmap_create(&scratch, 16);
+  if (!pb.slot_map || !pb.block_map)
+  {
+    bump_destroy(&scratch);
+    return NULL;
+  }
+
+  /// --- Pass 1: 编号 (参数 -> 指令结果)，并统计数量 ---
+  IDList *arg_it;
+  list_for_each(&func->arguments, arg_it)
+  {
+    IRArgument *arg = list_entry(arg_it, IRArgument, list_node);
+    ptr_hashmap_put(pb.slot_map, &arg->value, INDEX_TO_PTR(plan->num_slots));
+    plan->num_slots++;
+    plan->num_args++;
+  }
+
+  uint32_t total_operands = 0;
+  bool has_alloca = false;
+  bool has_phi = false;
+  bool batchable = true;
+  IDList *bb_it;
+  list_for_each(&func->basic_blocks, bb_it)
+  {
+    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+    ptr_hashmap_put(pb.block_map, &bb->label_address, INDEX_TO_PTR(plan->num_blocks));
+    plan->num_blocks++;
+
+    IDList *inst_it;
+    list_for_each(&bb->instructions, inst_it)
+    {
+      IRInstruction *inst = list_entry(inst_it, IRInstruction, list_node);
+      if (inst->result.type->kind != IR_TYPE_VOID)
+      {
+        ptr_hashmap_put(pb.slot_map, &inst->result, INDEX_TO_PTR(plan->num_slots));
+        plan->num_slots++;
+      }
+      total_operands += (uint32_t)ir_instruction_get_num_operands(inst);
+      if (inst->opcode == IR_OP_ALLOCA)
+        has_alloca = true;
+      if (inst->opcode == IR_OP_PHI)
+        has_phi = true;
+      if (inst->opcode == IR_OP_SWITCH)
+        plan->num_switches++;
+      if (!is_batchable_opcode(inst->opcode))
+        batchable = false;
+      plan->num_insts++;
+    }
+  }
+
+  /// 并行复制打破环时需要一个临时槽位 (位于外部槽位之前)
+  plan->copy_temp_slot = has_phi ? plan->num_slots++ : EXEC_INVALID_INDEX;
+  plan->batchable = batchable;
+
+  plan->blocks = BUMP_ALLOC_SLICE_ZEROED(arena, ExecBlock, plan->num_blocks);
+  plan->insts = BUMP_ALLOC_SLICE_ZEROED(arena, ExecInst, plan->num_insts);
+  uint32_t *operand_pool = BUMP_ALLOC_SLICE(arena, uint32_t, total_operands);
+  plan->externs = BUMP_ALLOC_SLICE(arena, ExecExternSlot, total_operands);
+  plan->switches = BUMP_ALLOC_SLICE_ZEROED(arena, ExecSwitch, plan->num_switches);
+  pb.externs_capacity = total_operands;
+  plan->first_extern_slot = plan->num_slots;
+  if (!plan->blocks || !plan->insts || !operand_pool || !plan->externs || (plan->num_switches && !plan->switches))
+  {
+    bump_destroy(&scratch);
+    return NULL;
+  }
+
+  /// --- Pass 2: 平铺指令并解析操作数 ---
+  uint32_t switch_idx = 0;
+  /// 每个块先放 PHI，再放其余指令，以便在块入口一次性并行求值所有 PHI
+  uint32_t block_idx = 0;
+  uint32_t inst_idx = 0;
+  list_for_each(&func->basic_blocks, bb_it)
+  {
+    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+    ExecBlock *eb = &plan->blocks[block_idx++];
+    eb->ir = bb;
+    eb->first_inst = inst_idx;
+
+    IDList *inst_it;
+    list_for_each(&bb->instructions, inst_it)
+    {
+      IRInstruction *inst = list_entry(inst_it, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_PHI)
+      {
+        lower_instruction(&pb, inst, inst_idx++, &operand_pool);
+        eb->num_phis++;
+      }
+    }
+    list_for_each(&bb->instructions, inst_it)
+    {
+      IRInstruction *inst = list_entry(inst_it, IRInstruction, list_node);
+      if (inst->opcode != IR_OP_PHI)
+      {
+        if (inst->opcode == IR_OP_SWITCH)
+          plan->insts[inst_idx].aux = switch_idx++;
+        lower_instruction(&pb, inst, inst_idx++, &operand_pool);
+      }
+    }
+
+    eb->num_insts = inst_idx - eb->first_inst;
+
+    /// 执行循环依赖每个块都以终结指令结束 (否则会 "掉进" 下一个块)
+    if (eb->num_insts == eb->num_phis || !is_terminator(plan->insts[inst_idx - 1].opcode))
+    {
+      bump_destroy(&scratch);
+      return NULL;
+    }
+
+    if (!has_alloca)
+      mark_tail_calls(plan, eb);
+    if (enable_fusion)
+      fuse_block(plan, eb);
+    specialize_block(plan, eb);
+  }
+
+  /// --- Pass 3: 为每个跳转目标构建 CFG 边及其并行复制 ---
+  bool edges_ok = build_edges(plan, arena, &scratch);
+  bump_destroy(&scratch);
+  if (!edges_ok)
+    return NULL;
+
+  plan->const_pool = BUMP_ALLOC_SLICE_ZEROED(arena, RuntimeValue, plan->num_externs);
+  if (!plan->const_pool)
+    return NULL;
+
+  return plan;
+}
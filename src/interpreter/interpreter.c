@@ -15,12 +15,18 @@
  */
 
 #include "interpreter/interpreter.h"
+#include "interpreter/batch_kernels.h"
+#include "interpreter/exec_plan.h"
+#include "interpreter/jit.h"
+
+#include "analysis/purity.h"
 
 #include "ir/basicblock.h"
 #include "ir/constant.h"
 #include "ir/function.h"
 #include "ir/global.h"
 #include "ir/instruction.h"
+#include "ir/module.h"
 #include "ir/type.h"
 #include "ir/use.h"
 #include "ir/value.h"
@@ -29,16 +35,25 @@
 #include "utils/data_layout.h"
 #include "utils/hashmap.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
+#include "utils/xxhash.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
-#define INTERP_STACK_SIZE (1024 * 1024)
+/// 解释器栈的总大小 (所有帧共享)
+#define INTERP_STACK_SIZE (8 * 1024 * 1024)
 
 /*
  * =================================================================
@@ -47,35 +62,35 @@
  */
 
 /**
- * @brief 获取指令的操作数数量
+ * @brief profiling 使用的周期计数器 (x86: TSC；其他平台: 纳秒)
  */
-static inline int
-get_operand_count(IRInstruction *inst)
+static inline uint64_t
+read_cycle_counter(void)
 {
-  int count = 0;
-  IDList *iter_node;
-  list_for_each(&inst->operands, iter_node)
-  {
-    count++;
-  }
-  return count;
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
 }
 
-static IRValueNode *
-get_operand_node(IRInstruction *inst, int index)
+/// 已降级指令的第 i 个操作数所在的槽位
+#define OPERAND(ctx, ei, i) (&(ctx)->slots[(ei)->operands[(i)]])
+/// 已降级指令的结果槽位
+#define RESULT(ctx, ei) (&(ctx)->slots[(ei)->result])
+
+/**
+ * @brief 获取指令第一个操作数的 IR 值 (O(1)，仅用于读取静态类型)
+ */
+static inline IRValueNode *
+get_first_operand_node(IRInstruction *inst)
 {
-  IDList *head = &inst->operands;
-  IDList *iter = head->next;
-  while (index > 0 && iter != head)
-  {
-    iter = iter->next;
-    index--;
-  }
-  if (iter == head)
-    return NULL;
-  IRUse *use = list_entry(iter, IRUse, user_node);
-  return use->value;
+  assert(ir_instruction_get_num_operands(inst) > 0);
+  return ir_instruction_get_operand(inst, 0);
 }
+
 static RuntimeValueKind
 ir_to_runtime_kind(IRTypeKind kind)
 {
@@ -102,11 +117,14 @@ ir_to_runtime_kind(IRTypeKind kind)
   }
 }
 
-static RuntimeValue *
-eval_constant(ExecutionContext *ctx, IRConstant *constant)
+/**
+ * @brief 将一个 IR 常量物化到 rt_val 中
+ */
+static void
+eval_constant(IRConstant *constant, RuntimeValue *rt_val)
 {
   IRValueNode *val_node = &constant->value;
-  RuntimeValue *rt_val = BUMP_ALLOC_ZEROED(ctx->interp->arena, RuntimeValue);
+  memset(rt_val, 0, sizeof(RuntimeValue));
   switch (constant->const_kind)
   {
   case CONST_KIND_UNDEF:
@@ -150,30 +168,142 @@ eval_constant(ExecutionContext *ctx, IRConstant *constant)
     }
     break;
   }
-  ptr_hashmap_put(ctx->frame, val_node, rt_val);
-  return rt_val;
 }
 
-static RuntimeValue *
-get_value(ExecutionContext *ctx, IRValueNode *val_node)
+/**
+ * @brief 全局变量内容的快照 (见 interpreter_snapshot_globals)
+ */
+struct GlobalSnapshot
+{
+  IRModule *module;
+  size_t size;
+  uint8_t data[];
+};
+
+/**
+ * @brief 把全局变量的初始值写入它在镜像中的位置 (镜像已清零)
+ */
+static void
+write_global_initializer(IRGlobalVariable *g, uint8_t *dest, size_t size)
+{
+  if (!g->initializer)
+    return;
+  RuntimeValue init_val;
+  eval_constant(container_of(g->initializer, IRConstant, value), &init_val);
+  memcpy(dest, &init_val.as, (size < sizeof(init_val.as)) ? size : sizeof(init_val.as));
+}
+
+/**
+ * @brief 为模块中所有尚未放置的全局变量构建一个镜像
+ *
+ * 第一遍按类型的大小与对齐计算每个全局变量的偏移，第二遍一次分配整个镜像、
+ * 写入初始值并登记地址。
+ */
+static bool
+load_module_globals(Interpreter *interp, IRModule *mod)
 {
-  RuntimeValue *rt_val = ptr_hashmap_get(ctx->frame, val_node);
-  if (rt_val)
+  size_t count = 0;
+  size_t size = 0;
+  size_t align = 1;
+  IDList *it;
+  list_for_each(&mod->globals, it)
+  {
+    IRGlobalVariable *g = list_entry(it, IRGlobalVariable, list_node);
+    if (ptr_hashmap_contains(interp->global_storage, &g->value))
+      continue;
+    BumpLayout layout = datalayout_get_type_layout(interp->data_layout, g->allocated_type);
+    size = (size + layout.align - 1) & ~(layout.align - 1);
+    size += layout.size;
+    if (layout.align > align)
+      align = layout.align;
+    count++;
+  }
+  if (count == 0)
+    return true;
+  if (size == 0)
+    size = 1;
+
+  GlobalImage *image = BUMP_ALLOC_ZEROED(interp->arena, GlobalImage);
+  uint8_t *memory = bump_alloc_layout(interp->arena, (BumpLayout){.size = size, .align = align});
+  uint8_t *initial = bump_alloc_layout(interp->arena, (BumpLayout){.size = size, .align = 1});
+  if (!image || !memory || !initial)
+    return false;
+  memset(memory, 0, size);
+
+  size_t offset = 0;
+  list_for_each(&mod->globals, it)
   {
-    return rt_val;
+    IRGlobalVariable *g = list_entry(it, IRGlobalVariable, list_node);
+    if (ptr_hashmap_contains(interp->global_storage, &g->value))
+      continue;
+    BumpLayout layout = datalayout_get_type_layout(interp->data_layout, g->allocated_type);
+    offset = (offset + layout.align - 1) & ~(layout.align - 1);
+    write_global_initializer(g, memory + offset, layout.size);
+    if (!ptr_hashmap_put(interp->global_storage, &g->value, memory + offset))
+      return false;
+    offset += layout.size;
   }
-  if (val_node->kind == IR_KIND_CONSTANT)
+  memcpy(initial, memory, size);
+
+  image->module = mod;
+  image->memory = memory;
+  image->initial = initial;
+  image->size = size;
+
+  GlobalImage **tail = &interp->global_images;
+  while (*tail)
+    tail = &(*tail)->next;
+  *tail = image;
+  return true;
+}
+
+/**
+ * @brief 获取全局变量的宿主内存地址 (第一次用到所属模块时为它构建镜像)
+ */
+static void *
+get_global_address(Interpreter *interp, IRGlobalVariable *g)
+{
+  void *address = ptr_hashmap_get(interp->global_storage, &g->value);
+  if (address == NULL)
   {
-    IRConstant *constant = container_of(val_node, IRConstant, value);
-    return eval_constant(ctx, constant);
+    assert(g->parent && "Global variable has no parent module");
+    bool loaded = load_module_globals(interp, g->parent);
+    assert(loaded && "OOM Allocating global variables");
+    (void)loaded;
+    address = ptr_hashmap_get(interp->global_storage, &g->value);
   }
-  assert(false && "Interpreter Error: Use of undefined value");
-  return NULL;
+  return address;
 }
+
+/**
+ * @brief 求值计划的常量池 (常量 / 全局变量 / 函数地址)，每个计划只执行一次
+ */
 static void
-set_value(ExecutionContext *ctx, IRValueNode *val_node, RuntimeValue *rt_val)
+build_const_pool(Interpreter *interp, ExecPlan *plan)
 {
-  ptr_hashmap_put(ctx->frame, val_node, rt_val);
+  for (uint32_t i = 0; i < plan->num_externs; i++)
+  {
+    ExecExternSlot *ext = &plan->externs[i];
+    RuntimeValue *slot = &plan->const_pool[i];
+    assert(ext->slot == plan->first_extern_slot + i && "Extern slots must be contiguous");
+
+    switch (ext->value->kind)
+    {
+    case IR_KIND_CONSTANT:
+      eval_constant(container_of(ext->value, IRConstant, value), slot);
+      break;
+    case IR_KIND_GLOBAL:
+      slot->kind = RUNTIME_VAL_PTR;
+      slot->as.val_ptr = get_global_address(interp, container_of(ext->value, IRGlobalVariable, value));
+      break;
+    case IR_KIND_FUNCTION:
+      slot->kind = RUNTIME_VAL_PTR;
+      slot->as.val_ptr = (void *)container_of(ext->value, IRFunction, entry_address);
+      break;
+    default:
+      assert(false && "Invalid extern slot kind");
+    }
+  }
 }
 
 /*
@@ -186,17 +316,15 @@ set_value(ExecutionContext *ctx, IRValueNode *val_node, RuntimeValue *rt_val)
  * @brief 执行 'select' 指令
  */
 static ExecutionResultKind
-execute_op_select(ExecutionContext *ctx, IRInstruction *inst)
+execute_op_select(ExecutionContext *ctx, ExecInst *ei)
 {
-  RuntimeValue *rt_cond = get_value(ctx, get_operand_node(inst, 0));
-  RuntimeValue *rt_true_val = get_value(ctx, get_operand_node(inst, 1));
-  RuntimeValue *rt_false_val = get_value(ctx, get_operand_node(inst, 2));
+  RuntimeValue *rt_cond = OPERAND(ctx, ei, 0);
+  RuntimeValue *rt_true_val = OPERAND(ctx, ei, 1);
+  RuntimeValue *rt_false_val = OPERAND(ctx, ei, 2);
 
   assert(rt_cond->kind == RUNTIME_VAL_I1 && "Select condition must be i1");
 
-  RuntimeValue *rt_res = (rt_cond->as.val_i1) ? rt_true_val : rt_false_val;
-
-  set_value(ctx, &inst->result, rt_res);
+  *RESULT(ctx, ei) = (rt_cond->as.val_i1) ? *rt_true_val : *rt_false_val;
   return EXEC_OK;
 }
 
@@ -204,13 +332,12 @@ execute_op_select(ExecutionContext *ctx, IRInstruction *inst)
  * @brief 执行整数/位运算
  */
 static ExecutionResultKind
-execute_op_int_binary(ExecutionContext *ctx, IRInstruction *inst)
+eval_int_binary(ExecutionContext *ctx, IRInstruction *inst, RuntimeValue *rt_lhs, RuntimeValue *rt_rhs,
+                RuntimeValue *rt_res)
 {
-  RuntimeValue *rt_lhs = get_value(ctx, get_operand_node(inst, 0));
-  RuntimeValue *rt_rhs = get_value(ctx, get_operand_node(inst, 1));
-  RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
 
   rt_res->kind = rt_lhs->kind;
+  rt_res->as.val_i64 = 0;
 
   switch (rt_lhs->kind)
   {
@@ -639,7 +766,6 @@ execute_op_int_binary(ExecutionContext *ctx, IRInstruction *inst)
     assert(false && "Invalid type for integer/bitwise operation");
   }
 
-  set_value(ctx, &inst->result, rt_res);
   return EXEC_OK;
 }
 
@@ -647,13 +773,12 @@ execute_op_int_binary(ExecutionContext *ctx, IRInstruction *inst)
  * @brief [!!] (已实现) 执行浮点二元运算
  */
 static ExecutionResultKind
-execute_op_float_binary(ExecutionContext *ctx, IRInstruction *inst)
+eval_float_binary(ExecutionContext *ctx, IRInstruction *inst, RuntimeValue *rt_lhs, RuntimeValue *rt_rhs,
+                  RuntimeValue *rt_res)
 {
-  RuntimeValue *rt_lhs = get_value(ctx, get_operand_node(inst, 0));
-  RuntimeValue *rt_rhs = get_value(ctx, get_operand_node(inst, 1));
-  RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
 
   rt_res->kind = rt_lhs->kind;
+  rt_res->as.val_i64 = 0;
 
   switch (rt_lhs->kind)
   {
@@ -701,7 +826,6 @@ execute_op_float_binary(ExecutionContext *ctx, IRInstruction *inst)
     assert(false && "Invalid type for float operation");
   }
 
-  set_value(ctx, &inst->result, rt_res);
   return EXEC_OK;
 }
 
@@ -709,13 +833,11 @@ execute_op_float_binary(ExecutionContext *ctx, IRInstruction *inst)
  * @brief [!!] (新增) 执行比较运算
  */
 static ExecutionResultKind
-execute_op_compare(ExecutionContext *ctx, IRInstruction *inst)
+eval_compare(IRInstruction *inst, RuntimeValue *rt_lhs, RuntimeValue *rt_rhs, RuntimeValue *rt_res)
 {
-  RuntimeValue *rt_lhs = get_value(ctx, get_operand_node(inst, 0));
-  RuntimeValue *rt_rhs = get_value(ctx, get_operand_node(inst, 1));
-  RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
 
   rt_res->kind = RUNTIME_VAL_I1;
+  rt_res->as.val_i64 = 0;
 
   switch (inst->opcode)
   {
@@ -868,21 +990,18 @@ execute_op_compare(ExecutionContext *ctx, IRInstruction *inst)
     assert(false && "unreachable");
   }
 
-  set_value(ctx, &inst->result, rt_res);
   return EXEC_OK;
 }
 
 /**
- * @brief 执行类型转换
+ * @brief 类型转换: 把 rt_in 转换成 inst 的结果类型，写入 rt_res
  */
-static ExecutionResultKind
-execute_op_cast(ExecutionContext *ctx, IRInstruction *inst)
+static void
+eval_cast(const DataLayout *dl, IRInstruction *inst, RuntimeValue *rt_in, RuntimeValue *rt_res)
 {
-  RuntimeValue *rt_in = get_value(ctx, get_operand_node(inst, 0));
-  RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
-
   IRType *dest_type = inst->result.type;
   rt_res->kind = ir_to_runtime_kind(dest_type->kind);
+  rt_res->as.val_i64 = 0;
 
   RuntimeValueKind src_kind = rt_in->kind;
 
@@ -925,8 +1044,7 @@ execute_op_cast(ExecutionContext *ctx, IRInstruction *inst)
     break;
   case RUNTIME_VAL_UNDEF:
     rt_res->kind = RUNTIME_VAL_UNDEF;
-    set_value(ctx, &inst->result, rt_res);
-    return EXEC_OK;
+    return;
   }
 
   switch (inst->opcode)
@@ -1044,17 +1162,24 @@ execute_op_cast(ExecutionContext *ctx, IRInstruction *inst)
 
   case IR_OP_BITCAST:
 
-    assert(datalayout_get_type_size(ctx->interp->data_layout, get_operand_node(inst, 0)->type) ==
-             datalayout_get_type_size(ctx->interp->data_layout, dest_type) &&
+    assert(datalayout_get_type_size(dl, get_first_operand_node(inst)->type) ==
+             datalayout_get_type_size(dl, dest_type) &&
            "Bitcast size mismatch");
-    memcpy(&rt_res->as, &rt_in->as, datalayout_get_type_size(ctx->interp->data_layout, dest_type));
+    memcpy(&rt_res->as, &rt_in->as, datalayout_get_type_size(dl, dest_type));
     break;
 
   default:
     assert(false && "unreachable");
   }
+}
 
-  set_value(ctx, &inst->result, rt_res);
+/**
+ * @brief 执行类型转换 (读写帧槽位)
+ */
+static ExecutionResultKind
+execute_op_cast(ExecutionContext *ctx, ExecInst *ei)
+{
+  eval_cast(ctx->interp->data_layout, ei->ir, OPERAND(ctx, ei, 0), RESULT(ctx, ei));
   return EXEC_OK;
 }
 
@@ -1088,513 +1213,3071 @@ get_int_value_as_i64(RuntimeValue *rt_val)
   }
 }
 
-static ExecutionResultKind
-execute_basic_block(ExecutionContext *ctx, IRBasicBlock *bb, IRBasicBlock *prev_bb, RuntimeValue *result_out,
-                    IRBasicBlock **next_bb_out)
+/**
+ * @brief 执行 'load': 从 rt_ptr 读取 load 的结果类型到 rt_res
+ */
+static inline void
+eval_load(ExecutionContext *ctx, ExecInst *load, RuntimeValue *rt_ptr, RuntimeValue *rt_res)
 {
-  /// 默认情况下，我们不知道下一块是什么
-  *next_bb_out = NULL;
-  IDList *inst_node;
-  list_for_each(&bb->instructions, inst_node)
-  {
-    IRInstruction *inst = list_entry(inst_node, IRInstruction, list_node);
-
-    switch (inst->opcode)
-    {
-
-    case IR_OP_RET: {
-      IRValueNode *node_lhs = get_operand_node(inst, 0);
-      if (node_lhs)
-      {
-        RuntimeValue *rt_val = get_value(ctx, node_lhs);
-        memcpy(result_out, rt_val, sizeof(RuntimeValue));
-      }
-      else
-      {
-        result_out->kind = RUNTIME_VAL_UNDEF;
-      }
-      *next_bb_out = NULL; /// 信号：停止执行
-      return EXEC_OK;
-    }
-    case IR_OP_BR: {
-      IRValueNode *node_lhs = get_operand_node(inst, 0);
-      *next_bb_out = container_of(node_lhs, IRBasicBlock, label_address);
-      return EXEC_OK;
-    }
-    case IR_OP_COND_BR: {
-      RuntimeValue *rt_val = get_value(ctx, get_operand_node(inst, 0));
-      assert(rt_val->kind == RUNTIME_VAL_I1);
-      IRValueNode *node_lhs = get_operand_node(inst, (rt_val->as.val_i1) ? 1 : 2);
-      *next_bb_out = container_of(node_lhs, IRBasicBlock, label_address);
-      return EXEC_OK;
-    }
-    case IR_OP_SWITCH: {
-
-      RuntimeValue *rt_cond = get_value(ctx, get_operand_node(inst, 0));
-      int64_t cond_val = get_int_value_as_i64(rt_cond);
-
-      IRValueNode *dest_node = NULL;
-
-      int op_count = get_operand_count(inst);
-      for (int i = 2; i < op_count; i += 2)
-      {
-        IRValueNode *case_val_node = get_operand_node(inst, i);
-
-        IRConstant *case_const = container_of(case_val_node, IRConstant, value);
-
-        if (case_const->data.int_val == cond_val)
-        {
-          dest_node = get_operand_node(inst, i + 1);
-          break;
-        }
-      }
-
-      if (dest_node == NULL)
-      {
-        dest_node = get_operand_node(inst, 1);
-      }
-
-      *next_bb_out = container_of(dest_node, IRBasicBlock, label_address);
-      return EXEC_OK;
-    }
-
-    case IR_OP_ALLOCA: {
-      IRType *pointee_type = inst->result.type->as.pointee_type;
-      BumpLayout layout = datalayout_get_type_layout(ctx->interp->data_layout, pointee_type);
+  assert(rt_ptr->kind == RUNTIME_VAL_PTR);
+  IRType *load_type = load->ir->result.type;
 
-      void *host_ptr = bump_alloc(&ctx->stack_arena, layout.size, layout.align);
-
-      if (host_ptr == NULL)
-      {
+  rt_res->kind = ir_to_runtime_kind(load_type->kind);
+  rt_res->as.val_i64 = 0;
 
-        ctx->error_message = "Runtime Error: Stack overflow";
-        return EXEC_ERR_STACK_OVERFLOW;
-      }
+  memcpy(&rt_res->as, rt_ptr->as.val_ptr, datalayout_get_type_size(ctx->interp->data_layout, load_type));
+}
 
-      RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
-      rt_res->kind = RUNTIME_VAL_PTR;
-      rt_res->as.val_ptr = host_ptr;
-      set_value(ctx, &inst->result, rt_res);
+/**
+ * @brief 执行 'store': 把 rt_val 写入 rt_ptr (大小由被存储值的静态类型决定)
+ */
+static inline void
+eval_store(ExecutionContext *ctx, ExecInst *store, RuntimeValue *rt_val, RuntimeValue *rt_ptr)
+{
+  assert(rt_ptr->kind == RUNTIME_VAL_PTR);
+  memcpy(rt_ptr->as.val_ptr, &rt_val->as,
+         datalayout_get_type_size(ctx->interp->data_layout, get_first_operand_node(store->ir)->type));
+}
 
-      break;
-    }
-    case IR_OP_STORE: {
-      RuntimeValue *rt_val = get_value(ctx, get_operand_node(inst, 0));
-      RuntimeValue *rt_ptr = get_value(ctx, get_operand_node(inst, 1));
-      assert(rt_ptr->kind == RUNTIME_VAL_PTR);
+/**
+ * @brief 执行 'gep': 计算地址到 rt_res
+ *
+ * 计划中预先解析过的 gep 只需加上常量偏移和每个变量下标的乘积；
+ * 未能解析的 (OOM) 沿着源类型逐个下标计算。
+ */
+static void
+eval_gep(ExecutionContext *ctx, ExecInst *ei, RuntimeValue *rt_res)
+{
+  RuntimeValue *rt_base_ptr = OPERAND(ctx, ei, 0);
+  assert(rt_base_ptr->kind == RUNTIME_VAL_PTR);
 
-      memcpy(rt_ptr->as.val_ptr, &rt_val->as,
-             datalayout_get_type_size(ctx->interp->data_layout, get_operand_node(inst, 0)->type));
-      break;
-    }
-    case IR_OP_LOAD: {
-      RuntimeValue *rt_ptr = get_value(ctx, get_operand_node(inst, 0));
-      assert(rt_ptr->kind == RUNTIME_VAL_PTR);
-      RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
-      rt_res->kind = ir_to_runtime_kind(inst->result.type->kind);
+  char *current_ptr = (char *)rt_base_ptr->as.val_ptr;
 
-      memcpy(&rt_res->as, rt_ptr->as.val_ptr, datalayout_get_type_size(ctx->interp->data_layout, inst->result.type));
-      set_value(ctx, &inst->result, rt_res);
-      break;
+  if (ei->aux != EXEC_INVALID_INDEX)
+  {
+    const ExecGep *gep = &ctx->plan->geps[ei->aux];
+    current_ptr += gep->offset;
+    for (uint32_t i = 0; i < gep->num_terms; i++)
+    {
+      int64_t idx_val = get_int_value_as_i64(OPERAND(ctx, ei, gep->terms[i].operand));
+      current_ptr += (uint64_t)idx_val * gep->terms[i].scale;
     }
-    case IR_OP_GEP: {
-      RuntimeValue *rt_base_ptr = get_value(ctx, get_operand_node(inst, 0));
-      assert(rt_base_ptr->kind == RUNTIME_VAL_PTR);
-
-      char *current_ptr = (char *)rt_base_ptr->as.val_ptr;
-
-      IRType *current_type = inst->as.gep.source_type;
-
-      int op_count = get_operand_count(inst);
-      for (int i = 1; i < op_count; i++)
-      {
-        RuntimeValue *rt_idx = get_value(ctx, get_operand_node(inst, i));
-        int64_t idx_val = get_int_value_as_i64(rt_idx);
-
-        if (i == 1)
-        {
-
-          size_t elem_size = datalayout_get_type_size(ctx->interp->data_layout, current_type);
-          current_ptr += (idx_val * elem_size);
-        }
-        else if (current_type->kind == IR_TYPE_ARRAY)
-        {
-
-          current_type = current_type->as.array.element_type;
-          size_t elem_size = datalayout_get_type_size(ctx->interp->data_layout, current_type);
-          current_ptr += (idx_val * elem_size);
-        }
-        else if (current_type->kind == IR_TYPE_STRUCT)
-        {
-
-          assert(idx_val >= 0 && (size_t)idx_val < current_type->as.aggregate.member_count);
+    rt_res->kind = RUNTIME_VAL_PTR;
+    rt_res->as.val_ptr = (void *)current_ptr;
+    return;
+  }
 
-          size_t offset = datalayout_get_struct_member_offset(ctx->interp->data_layout, current_type, (size_t)idx_val);
-          current_ptr += offset;
-          current_type = current_type->as.aggregate.member_types[idx_val];
-        }
-        else
-        {
+  IRType *current_type = ei->ir->as.gep.source_type;
 
-          assert(false && "GEP is trying to index into a non-aggregate type");
-        }
-      }
+  for (uint32_t i = 1; i < ei->num_operands; i++)
+  {
+    int64_t idx_val = get_int_value_as_i64(OPERAND(ctx, ei, i));
 
-      RuntimeValue *rt_res = BUMP_ALLOC_ZEROED(&ctx->value_arena, RuntimeValue);
-      rt_res->kind = RUNTIME_VAL_PTR;
-      rt_res->as.val_ptr = (void *)current_ptr;
-      set_value(ctx, &inst->result, rt_res);
-      break;
+    if (i == 1)
+    {
+      size_t elem_size = datalayout_get_type_size(ctx->interp->data_layout, current_type);
+      current_ptr += (idx_val * elem_size);
     }
-
-    case IR_OP_ADD:
-    case IR_OP_SUB:
-    case IR_OP_MUL:
-    case IR_OP_UDIV:
-    case IR_OP_SDIV:
-    case IR_OP_UREM:
-    case IR_OP_SREM:
-    case IR_OP_SHL:
-    case IR_OP_LSHR:
-    case IR_OP_ASHR:
-    case IR_OP_AND:
-    case IR_OP_OR:
-    case IR_OP_XOR: {
-      ExecutionResultKind op_res = execute_op_int_binary(ctx, inst);
-      if (op_res != EXEC_OK)
-        return op_res;
-      break;
+    else if (current_type->kind == IR_TYPE_ARRAY)
+    {
+      current_type = current_type->as.array.element_type;
+      size_t elem_size = datalayout_get_type_size(ctx->interp->data_layout, current_type);
+      current_ptr += (idx_val * elem_size);
     }
-    case IR_OP_FADD:
-    case IR_OP_FSUB:
-    case IR_OP_FMUL:
-    case IR_OP_FDIV: {
+    else if (current_type->kind == IR_TYPE_STRUCT)
+    {
+      assert(idx_val >= 0 && (size_t)idx_val < current_type->as.aggregate.member_count);
 
-      ExecutionResultKind op_res = execute_op_float_binary(ctx, inst);
-      if (op_res != EXEC_OK)
-        return op_res;
-      break;
-    }
-    case IR_OP_ICMP:
-    case IR_OP_FCMP:
-      execute_op_compare(ctx, inst);
-      break;
-    case IR_OP_TRUNC:
-    case IR_OP_ZEXT:
-    case IR_OP_SEXT:
-    case IR_OP_FPTRUNC:
-    case IR_OP_FPEXT:
-    case IR_OP_FPTOUI:
-    case IR_OP_FPTOSI:
-    case IR_OP_UITOFP:
-    case IR_OP_SITOFP:
-    case IR_OP_PTRTOINT:
-    case IR_OP_INTTOPTR:
-    case IR_OP_BITCAST:
-      execute_op_cast(ctx, inst);
-      break;
-
-    case IR_OP_PHI: {
-      RuntimeValue *rt_val = NULL;
-      for (int i = 0; get_operand_node(inst, i) != NULL; i += 2)
-      {
-        IRValueNode *bb_in_node = get_operand_node(inst, i + 1);
-        IRBasicBlock *bb_in = container_of(bb_in_node, IRBasicBlock, label_address);
-        if (bb_in == prev_bb)
-        {
-          IRValueNode *val_in_node = get_operand_node(inst, i);
-          rt_val = get_value(ctx, val_in_node);
-          break;
-        }
-      }
-      assert(rt_val && "PHI node missing incoming value for predecessor block");
-      set_value(ctx, &inst->result, rt_val);
-      break;
+      size_t offset = datalayout_get_struct_member_offset(ctx->interp->data_layout, current_type, (size_t)idx_val);
+      current_ptr += offset;
+      current_type = current_type->as.aggregate.member_types[idx_val];
     }
-    case IR_OP_SELECT: {
-      ExecutionResultKind op_res = execute_op_select(ctx, inst);
-      if (op_res != EXEC_OK)
-        return op_res;
-      break;
+    else
+    {
+      assert(false && "GEP is trying to index into a non-aggregate type");
     }
-    case IR_OP_CALL: {
-
-      int op_count = get_operand_count(inst);
-      size_t num_args = (op_count > 0) ? (op_count - 1) : 0;
-
-      IRValueNode *callee_node = get_operand_node(inst, 0);
-      IRFunction *func_to_call = NULL;
-
-      if (callee_node->kind == IR_KIND_FUNCTION)
-      {
-        func_to_call = container_of(callee_node, IRFunction, entry_address);
-      }
-      else
-      {
-        RuntimeValue *rt_callee = get_value(ctx, callee_node);
-        assert(rt_callee->kind == RUNTIME_VAL_PTR && "Indirect callee must be a pointer");
-        func_to_call = (IRFunction *)rt_callee->as.val_ptr;
-      }
-
-      assert(func_to_call && func_to_call->parent != NULL && "Invalid function pointer");
-
-      RuntimeValue **call_args = BUMP_ALLOC_SLICE(&ctx->value_arena, RuntimeValue *, num_args);
-      for (size_t i = 0; i < num_args; i++)
-      {
-        call_args[i] = get_value(ctx, get_operand_node(inst, i + 1));
-      }
-
-      RuntimeValue call_result;
-
-      if (func_to_call->is_declaration)
-      {
-
-        const char *name = func_to_call->entry_address.name;
-
-        CalicoHostFunction c_func =
-          (CalicoHostFunction)str_hashmap_get(ctx->interp->external_function_map, name, strlen(name));
-
-        if (c_func == NULL)
-        {
+  }
 
-          ctx->error_message = "Runtime Error: Call to unlinked external function";
-          return EXEC_ERR_INVALID_PTR;
-        }
+  rt_res->kind = RUNTIME_VAL_PTR;
+  rt_res->as.val_ptr = (void *)current_ptr;
+}
 
-        ExecutionResultKind ffi_result = c_func(ctx, call_args, num_args, &call_result);
+/**
+ * @brief 沿一条 CFG 边跳转时执行其 (已顺序化的) PHI 并行复制
+ */
+static inline void
+execute_edge_copies(ExecutionContext *ctx, const ExecEdge *edge)
+{
+  const ExecCopy *copies = &ctx->plan->copies[edge->first_copy];
+  for (uint32_t i = 0; i < edge->num_copies; i++)
+  {
+    ctx->slots[copies[i].dst] = ctx->slots[copies[i].src];
+  }
+}
 
-        if (ffi_result != EXEC_OK)
-        {
+/**
+ * @brief 求 'switch' 的目标边 (按计划中预先选好的策略查找)
+ */
+static inline uint32_t
+lookup_switch_edge(ExecutionContext *ctx, ExecInst *ei)
+{
+  int64_t cond_val = get_int_value_as_i64(OPERAND(ctx, ei, 0));
+  const ExecSwitch *sw = &ctx->plan->switches[ei->aux];
 
-          return ffi_result;
-        }
-      }
+  switch (sw->kind)
+  {
+  case EXEC_SWITCH_TABLE: {
+    uint64_t index = (uint64_t)cond_val - (uint64_t)sw->min_value;
+    return (index < sw->table_size) ? sw->table[index] : sw->default_edge;
+  }
+  case EXEC_SWITCH_SORTED: {
+    uint32_t lo = 0;
+    uint32_t hi = sw->num_keys;
+    while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (sw->keys[mid] < cond_val)
+        lo = mid + 1;
       else
-      {
+        hi = mid;
+    }
+    return (lo < sw->num_keys && sw->keys[lo] == cond_val) ? sw->key_edges[lo] : sw->default_edge;
+  }
+  case EXEC_SWITCH_LINEAR:
+  default:
+    break;
+  }
 
-        bool success = interpreter_run_function(ctx->interp, func_to_call, call_args, num_args, &call_result);
+  for (uint32_t i = 2; i + 1 < ei->num_operands; i += 2)
+  {
+    if (get_int_value_as_i64(OPERAND(ctx, ei, i)) == cond_val)
+      return ei->operands[i + 1];
+  }
+  return sw->default_edge;
+}
 
-        if (!success)
-        {
+/**
+ * @brief 执行整数/位运算指令 (读写帧槽位)
+ */
+static inline ExecutionResultKind
+execute_op_int_binary(ExecutionContext *ctx, ExecInst *ei)
+{
+  return eval_int_binary(ctx, ei->ir, OPERAND(ctx, ei, 0), OPERAND(ctx, ei, 1), RESULT(ctx, ei));
+}
 
-          return EXEC_ERR_INVALID_PTR;
-        }
-      }
+/**
+ * @brief 执行浮点二元运算指令 (读写帧槽位)
+ */
+static inline ExecutionResultKind
+execute_op_float_binary(ExecutionContext *ctx, ExecInst *ei)
+{
+  return eval_float_binary(ctx, ei->ir, OPERAND(ctx, ei, 0), OPERAND(ctx, ei, 1), RESULT(ctx, ei));
+}
 
-      if (inst->result.type->kind != IR_TYPE_VOID)
-      {
-        RuntimeValue *rt_res = BUMP_ALLOC(&ctx->value_arena, RuntimeValue);
-        memcpy(rt_res, &call_result, sizeof(RuntimeValue));
-        set_value(ctx, &inst->result, rt_res);
-      }
-      break;
-    }
+/**
+ * @brief 执行比较指令 (读写帧槽位)
+ */
+static inline ExecutionResultKind
+execute_op_compare(ExecutionContext *ctx, ExecInst *ei)
+{
+  return eval_compare(ei->ir, OPERAND(ctx, ei, 0), OPERAND(ctx, ei, 1), RESULT(ctx, ei));
+}
 
-    default:
-      /// (如果 default 被触发，意味着指令列表为空)
-      /// 这不应该发生，因为 Verifier 会确保块有终结者
-      break;
-    }
+/**
+ * @brief 在标量帧 (ctx->slots) 上执行一条无副作用的指令
+ */
+static ExecutionResultKind
+execute_scalar_inst(ExecutionContext *ctx, ExecInst *ei)
+{
+  switch (ei->ir->opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_UDIV:
+  case IR_OP_SDIV:
+  case IR_OP_UREM:
+  case IR_OP_SREM:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+    return execute_op_int_binary(ctx, ei);
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+    return execute_op_float_binary(ctx, ei);
+  case IR_OP_ICMP:
+  case IR_OP_FCMP:
+    return execute_op_compare(ctx, ei);
+  case IR_OP_SELECT:
+    return execute_op_select(ctx, ei);
+  case IR_OP_GEP:
+    eval_gep(ctx, ei, RESULT(ctx, ei));
+    return EXEC_OK;
+  default:
+    assert(ei->ir->opcode >= IR_OP_TRUNC && ei->ir->opcode <= IR_OP_BITCAST && "Instruction not supported in batch");
+    return execute_op_cast(ctx, ei);
   }
-  /// 如果循环正常结束，意味着我们执行完了所有指令
-  /// 但没有遇到任何一个 "终结者" (RET, BR, ...)，
-  /// 这是一个格式错误的 BasicBlock。
-  ctx->error_message = "Interpreter Error: Basic block missing terminator";
-  return EXEC_ERR_INVALID_PTR;
 }
 
 /*
  * =================================================================
- * --- 公共 API (Public API) ---
+ * --- 常量折叠 (与执行共用求值函数) ---
  * =================================================================
  */
 
 /**
- * @brief 创建一个新的解释器实例。
- * (来自你的 stub)
+ * @brief 把求值结果转换回 IR 常量 (指针和 undef 没有对应的常量，返回 NULL)
  */
-Interpreter *
-interpreter_create(DataLayout *data_layout)
+static IRValueNode *
+runtime_value_to_constant(IRContext *ctx, const RuntimeValue *rt_val)
 {
-  Interpreter *interp = (Interpreter *)malloc(sizeof(Interpreter));
-  if (!interp)
+  switch (rt_val->kind)
+  {
+  case RUNTIME_VAL_I1:
+    return ir_constant_get_i1(ctx, rt_val->as.val_i1);
+  case RUNTIME_VAL_I8:
+    return ir_constant_get_i8(ctx, rt_val->as.val_i8);
+  case RUNTIME_VAL_I16:
+    return ir_constant_get_i16(ctx, rt_val->as.val_i16);
+  case RUNTIME_VAL_I32:
+    return ir_constant_get_i32(ctx, rt_val->as.val_i32);
+  case RUNTIME_VAL_I64:
+    return ir_constant_get_i64(ctx, rt_val->as.val_i64);
+  case RUNTIME_VAL_F32:
+    return ir_constant_get_f32(ctx, rt_val->as.val_f32);
+  case RUNTIME_VAL_F64:
+    return ir_constant_get_f64(ctx, rt_val->as.val_f64);
+  default:
+    return NULL;
+  }
+}
+
+IRValueNode *
+interpreter_fold_instruction(IRContext *ctx, const DataLayout *dl, IRInstruction *inst, IRConstant *const *operands)
+{
+  RuntimeValue values[3];
+  size_t num_operands = ir_instruction_get_num_operands(inst);
+  if (num_operands > 3)
+    return NULL;
+  for (size_t i = 0; i < num_operands; i++)
+  {
+    if (operands[i]->const_kind == CONST_KIND_UNDEF)
+      return NULL;
+    eval_constant(operands[i], &values[i]);
+  }
+
+  /// 只有出错时才写 error_message，不需要真正的执行上下文
+  ExecutionContext scratch = {0};
+  RuntimeValue result = {0};
+  switch (inst->opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_UDIV:
+  case IR_OP_SDIV:
+  case IR_OP_UREM:
+  case IR_OP_SREM:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+    if (eval_int_binary(&scratch, inst, &values[0], &values[1], &result) != EXEC_OK)
+      return NULL;
+    break;
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+    if (eval_float_binary(&scratch, inst, &values[0], &values[1], &result) != EXEC_OK)
+      return NULL;
+    break;
+  case IR_OP_ICMP:
+  case IR_OP_FCMP:
+    eval_compare(inst, &values[0], &values[1], &result);
+    break;
+  case IR_OP_SELECT:
+    result = values[0].as.val_i1 ? values[1] : values[2];
+    break;
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+  case IR_OP_FPTRUNC:
+  case IR_OP_FPEXT:
+  case IR_OP_FPTOUI:
+  case IR_OP_FPTOSI:
+  case IR_OP_UITOFP:
+  case IR_OP_SITOFP:
+  case IR_OP_BITCAST:
+    if (inst->result.type->kind == IR_TYPE_PTR || ir_instruction_get_operand(inst, 0)->type->kind == IR_TYPE_PTR)
+      return NULL;
+    eval_cast(dl, inst, &values[0], &result);
+    break;
+  default:
+    return NULL;
+  }
+  return runtime_value_to_constant(ctx, &result);
+}
+
+/*
+ * =================================================================
+ * --- 解释器栈与调用帧 (Interpreter Stack & Frames) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 解释器栈上的一个调用帧
+ *
+ * 栈布局 (向高地址增长):
+ * [ExecFrame][slots: num_slots][alloca 区: plan->alloca_size][下一个帧 ...]
+ */
+struct ExecFrame
+{
+  /** 调用者的帧 (本次 interpreter_run_function 的根帧为 NULL) */
+  ExecFrame *caller;
+  ExecPlan *plan;
+  RuntimeValue *slots;
+  /** 本帧的 alloca 区 (每条 alloca 占据其中固定的一段) */
+  char *allocas;
+  /** 压入此帧之前的栈顶 (InterpreterStack::top)，返回时回退到这里 */
+  size_t watermark;
+  /** 调用者中的 'call' 指令 (根帧为 NULL)，返回后从它的下一条继续 */
+  ExecInst *call_site;
+};
+
+/**
+ * @brief 分配一个 size 字节的空解释器栈 (OOM 时返回 false)
+ */
+static bool
+stack_init(InterpreterStack *stack, size_t size)
+{
+  stack->base = (char *)malloc(size);
+  stack->size = stack->base ? size : 0;
+  stack->top = 0;
+  return stack->base != NULL;
+}
+
+/**
+ * @brief 从解释器栈顶分配一块内存 (栈溢出时返回 NULL)
+ */
+static void *
+stack_alloc(InterpreterStack *stack, size_t size, size_t align)
+{
+  uintptr_t base = (uintptr_t)stack->base;
+  uintptr_t start = (base + stack->top + (align - 1)) & ~(uintptr_t)(align - 1);
+  size_t offset = start - base;
+
+  if (offset > stack->size || size > stack->size - offset)
+    return NULL;
+
+  stack->top = offset + size;
+  return (void *)start;
+}
+
+/**
+ * @brief 执行 'alloca': 返回它在当前帧 alloca 区内的固定位置 (见 build_frame_layout)
+ *
+ * 同一条 alloca 每次执行都得到同一块内存 (类似 C 中块作用域的局部变量)，
+ * 因此循环中的 alloca 不会让栈无限增长。
+ */
+static ExecutionResultKind
+execute_op_alloca(ExecutionContext *ctx, ExecInst *ei)
+{
+  RuntimeValue *rt_res = RESULT(ctx, ei);
+  rt_res->kind = RUNTIME_VAL_PTR;
+  rt_res->as.val_ptr = ctx->frame->allocas + ei->aux;
+  return EXEC_OK;
+}
+
+/**
+ * @brief 让 ctx 的缓存字段 (plan / slots) 指向 frame
+ */
+static inline void
+activate_frame(ExecutionContext *ctx, ExecFrame *frame)
+{
+  ctx->frame = frame;
+  if (frame)
+  {
+    ctx->plan = frame->plan;
+    ctx->slots = frame->slots;
+  }
+}
+
+/**
+ * @brief (profiling) 把自上次记账以来的周期数记到当前函数上
+ *
+ * 在切换当前帧之前调用，因此每个函数只累计它自身的时间。
+ */
+static inline void
+profile_charge(ExecutionContext *ctx)
+{
+  if (ctx->plan && ctx->plan->profile)
+  {
+    uint64_t now = read_cycle_counter();
+    ctx->plan->profile->self_cycles += now - ctx->profile_stamp;
+    ctx->profile_stamp = now;
+  }
+}
+
+/**
+ * @brief 在栈顶压入 plan 的新帧 (槽位未初始化)，并设为当前帧
+ */
+static ExecutionResultKind
+push_frame(ExecutionContext *ctx, ExecPlan *plan, ExecFrame *caller, ExecInst *call_site)
+{
+  InterpreterStack *stack = ctx->stack;
+  size_t watermark = stack->top;
+
+  ExecFrame *frame = stack_alloc(stack, sizeof(ExecFrame), _Alignof(ExecFrame));
+  RuntimeValue *regs =
+    frame ? stack_alloc(stack, sizeof(RuntimeValue) * plan->num_slots, _Alignof(RuntimeValue)) : NULL;
+  char *allocas = regs ? stack_alloc(stack, plan->alloca_size, plan->alloca_align) : NULL;
+  if (!allocas)
+  {
+    stack->top = watermark;
+    ctx->error_message = "Runtime Error: Stack overflow";
+    return EXEC_ERR_STACK_OVERFLOW;
+  }
+
+  frame->caller = caller;
+  frame->plan = plan;
+  frame->slots = regs;
+  frame->allocas = allocas;
+  frame->watermark = watermark;
+  frame->call_site = call_site;
+
+  profile_charge(ctx);
+  activate_frame(ctx, frame);
+  if (plan->profile)
+    plan->profile->calls++;
+  return EXEC_OK;
+}
+
+/**
+ * @brief 弹出当前帧 (释放它及其之上所有的栈内存)
+ */
+static inline void
+pop_frame(ExecutionContext *ctx)
+{
+  ExecFrame *frame = ctx->frame;
+  ctx->stack->top = frame->watermark;
+  profile_charge(ctx);
+  activate_frame(ctx, frame->caller);
+}
+
+/**
+ * @brief 初始化新帧: 参数已在 [0, num_args)，清零指令结果槽位并复制常量池
+ */
+static void
+init_frame_slots(ExecutionContext *ctx)
+{
+  ExecPlan *plan = ctx->plan;
+  memset(&ctx->slots[plan->num_args], 0, sizeof(RuntimeValue) * (plan->first_extern_slot - plan->num_args));
+  memcpy(&ctx->slots[plan->first_extern_slot], plan->const_pool, sizeof(RuntimeValue) * plan->num_externs);
+}
+
+static ExecPlan *get_exec_plan(Interpreter *interp, IRFunction *func);
+
+/**
+ * @brief 获取 'call' 指令的被调函数 (直接调用的被调者也是一个外部槽位)
+ */
+static inline IRFunction *
+get_callee(ExecutionContext *ctx, ExecInst *ei)
+{
+  RuntimeValue *rt_callee = OPERAND(ctx, ei, 0);
+  assert(rt_callee->kind == RUNTIME_VAL_PTR && "Indirect callee must be a pointer");
+  IRFunction *func_to_call = (IRFunction *)rt_callee->as.val_ptr;
+
+  assert(func_to_call && func_to_call->parent != NULL && "Invalid function pointer");
+  return func_to_call;
+}
+
+/**
+ * @brief 类型化宿主函数的一个参数或返回值 (按 CalicoHostType 解释)
+ */
+typedef union HostScalar
+{
+  int64_t i;
+  double f;
+} HostScalar;
+
+/**
+ * @brief 按某个固定签名调用类型化宿主函数的桩 (注册时按签名选定，调用点不再分派)
+ */
+typedef HostScalar (*TypedHostInvoker)(CalicoTypedHostFunction fn, const HostScalar *a);
+
+/// 各参数个数对应的 C 形参列表与实参列表
+#define TYPED_HOST_PARAMS_0(P) void
+#define TYPED_HOST_PARAMS_1(P) P
+#define TYPED_HOST_PARAMS_2(P) P, P
+#define TYPED_HOST_PARAMS_3(P) P, P, P
+#define TYPED_HOST_PARAMS_4(P) P, P, P, P
+#define TYPED_HOST_ARGS_0(f)
+#define TYPED_HOST_ARGS_1(f) a[0].f
+#define TYPED_HOST_ARGS_2(f) a[0].f, a[1].f
+#define TYPED_HOST_ARGS_3(f) a[0].f, a[1].f, a[2].f
+#define TYPED_HOST_ARGS_4(f) a[0].f, a[1].f, a[2].f, a[3].f
+
+/// 定义返回 R (存入 HostScalar::rf)、n 个 P 参数 (取自 HostScalar::pf) 的调用桩
+#define DEFINE_TYPED_HOST_INVOKER(name, n, R, rf, P, pf)                                                               \
+  static HostScalar name(CalicoTypedHostFunction fn, const HostScalar *a)                                              \
+  {                                                                                                                    \
+    (void)a;                                                                                                           \
+    HostScalar r;                                                                                                      \
+    r.i = 0;                                                                                                           \
+    r.rf = ((R(*)(TYPED_HOST_PARAMS_##n(P)))fn)(TYPED_HOST_ARGS_##n(pf));                                              \
+    return r;                                                                                                          \
+  }
+
+#define DEFINE_TYPED_HOST_VOID_INVOKER(name, n, P, pf)                                                                 \
+  static HostScalar name(CalicoTypedHostFunction fn, const HostScalar *a)                                              \
+  {                                                                                                                    \
+    (void)a;                                                                                                           \
+    HostScalar r;                                                                                                      \
+    r.i = 0;                                                                                                           \
+    ((void (*)(TYPED_HOST_PARAMS_##n(P)))fn)(TYPED_HOST_ARGS_##n(pf));                                                 \
+    return r;                                                                                                          \
+  }
+
+/// 对每个参数个数 (0 .. CALICO_TYPED_HOST_MAX_PARAMS) 展开 X(n, ...)
+#define TYPED_HOST_FOR_EACH_ARITY(X, ...)                                                                              \
+  X(0, __VA_ARGS__) X(1, __VA_ARGS__) X(2, __VA_ARGS__) X(3, __VA_ARGS__) X(4, __VA_ARGS__)
+
+#define TYPED_HOST_DEFINE_ALL(n, _)                                                                                    \
+  DEFINE_TYPED_HOST_VOID_INVOKER(typed_host_void_i64_##n, n, int64_t, i)                                               \
+  DEFINE_TYPED_HOST_VOID_INVOKER(typed_host_void_f64_##n, n, double, f)                                                \
+  DEFINE_TYPED_HOST_INVOKER(typed_host_i64_i64_##n, n, int64_t, i, int64_t, i)                                         \
+  DEFINE_TYPED_HOST_INVOKER(typed_host_i64_f64_##n, n, int64_t, i, double, f)                                          \
+  DEFINE_TYPED_HOST_INVOKER(typed_host_f64_i64_##n, n, double, f, int64_t, i)                                          \
+  DEFINE_TYPED_HOST_INVOKER(typed_host_f64_f64_##n, n, double, f, double, f)
+
+TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_DEFINE_ALL, _)
+
+#define TYPED_HOST_TABLE_ENTRY(n, prefix) prefix##_##n,
+
+/**
+ * @brief 调用桩表: [返回类型][参数类型 (0 = I64, 1 = F64)][参数个数]
+ */
+static const TypedHostInvoker TYPED_HOST_INVOKERS[3][2][CALICO_TYPED_HOST_MAX_PARAMS + 1] = {
+  [CALICO_HOST_VOID] = {{TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_void_i64)},
+                        {TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_void_f64)}},
+  [CALICO_HOST_I64] = {{TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_i64_i64)},
+                       {TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_i64_f64)}},
+  [CALICO_HOST_F64] = {{TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_f64_i64)},
+                       {TYPED_HOST_FOR_EACH_ARITY(TYPED_HOST_TABLE_ENTRY, typed_host_f64_f64)}},
+};
+
+static_assert(CALICO_TYPED_HOST_MAX_PARAMS == 4, "TYPED_HOST_FOR_EACH_ARITY handles up to 4 parameters");
+
+#undef TYPED_HOST_PARAMS_0
+#undef TYPED_HOST_PARAMS_1
+#undef TYPED_HOST_PARAMS_2
+#undef TYPED_HOST_PARAMS_3
+#undef TYPED_HOST_PARAMS_4
+#undef TYPED_HOST_ARGS_0
+#undef TYPED_HOST_ARGS_1
+#undef TYPED_HOST_ARGS_2
+#undef TYPED_HOST_ARGS_3
+#undef TYPED_HOST_ARGS_4
+#undef DEFINE_TYPED_HOST_INVOKER
+#undef DEFINE_TYPED_HOST_VOID_INVOKER
+#undef TYPED_HOST_FOR_EACH_ARITY
+#undef TYPED_HOST_DEFINE_ALL
+#undef TYPED_HOST_TABLE_ENTRY
+
+/**
+ * @brief 一个外部函数名的链接结果
+ *
+ * 分配在 interp->arena 中，地址在解释器的生命周期内不变: 计划把直接调用外部声明的
+ * 'call' 解析到它上面，之后注册同名函数会原地更新，所以调用点不需要再按名字查找。
+ */
+struct HostBinding
+{
+  /** 装箱调用约定的宿主函数 (与 typed 都为 NULL 表示尚未注册) */
+  CalicoHostFunction boxed;
+  /** 类型化宿主函数 (见 interpreter_register_typed_function) */
+  CalicoTypedHostFunction typed;
+  /** 按 typed 的签名选定的调用桩 */
+  TypedHostInvoker invoke;
+  CalicoHostType ret_type;
+  CalicoHostType param_type;
+  uint32_t num_params;
+};
+
+typedef struct HostBinding HostBinding;
+
+/// 装箱调用的参数个数不超过这个值时，参数指针数组放在宿主 C 栈上
+#define HOST_CALL_LOCAL_ARGS 8
+
+/**
+ * @brief 查找外部函数名的链接结果 (create 为 true 时为未注册的名字创建一个空的占位)
+ */
+static HostBinding *
+get_host_binding(Interpreter *interp, const char *name, bool create)
+{
+  size_t len = strlen(name);
+  HostBinding *binding = str_hashmap_get(interp->external_function_map, name, len);
+  if (binding || !create)
+    return binding;
+
+  binding = BUMP_ALLOC_ZEROED(interp->arena, HostBinding);
+  if (binding && !str_hashmap_put(interp->external_function_map, name, len, binding))
+    return NULL;
+  return binding;
+}
+
+/**
+ * @brief 把 IR 参数转换为类型化宿主函数的 int64_t 参数 (不是整数或指针时返回 false)
+ */
+static inline bool
+host_arg_to_i64(RuntimeValue *rt_val, int64_t *out)
+{
+  switch (rt_val->kind)
+  {
+  case RUNTIME_VAL_PTR:
+    *out = (int64_t)(intptr_t)rt_val->as.val_ptr;
+    return true;
+  case RUNTIME_VAL_I1:
+  case RUNTIME_VAL_I8:
+  case RUNTIME_VAL_I16:
+  case RUNTIME_VAL_I32:
+  case RUNTIME_VAL_I64:
+    *out = get_int_value_as_i64(rt_val);
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief 把 IR 参数转换为类型化宿主函数的 double 参数 (不是浮点数时返回 false)
+ */
+static inline bool
+host_arg_to_f64(RuntimeValue *rt_val, double *out)
+{
+  if (rt_val->kind == RUNTIME_VAL_F64)
+    *out = rt_val->as.val_f64;
+  else if (rt_val->kind == RUNTIME_VAL_F32)
+    *out = (double)rt_val->as.val_f32;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * @brief 调用类型化宿主函数: 参数拆箱后直接按 C ABI 传递，返回值按 'call' 的结果类型装箱
+ */
+static ExecutionResultKind
+execute_typed_host_call(ExecutionContext *ctx, ExecInst *ei, const HostBinding *binding)
+{
+  uint32_t num_args = (ei->num_operands > 0) ? (ei->num_operands - 1) : 0;
+  if (num_args != binding->num_params)
+  {
+    ctx->error_message = "Runtime Error: Typed host function called with the wrong number of arguments";
+    return EXEC_ERR_INVALID_PTR;
+  }
+
+  HostScalar args[CALICO_TYPED_HOST_MAX_PARAMS];
+  bool float_params = (binding->param_type == CALICO_HOST_F64);
+  for (uint32_t i = 0; i < num_args; i++)
+  {
+    RuntimeValue *arg = OPERAND(ctx, ei, i + 1);
+    /// 参数类型与签名完全一致是最常见的情况，不经过转换函数
+    if (!float_params && arg->kind == RUNTIME_VAL_I64)
+      args[i].i = arg->as.val_i64;
+    else if (float_params && arg->kind == RUNTIME_VAL_F64)
+      args[i].f = arg->as.val_f64;
+    else if (!(float_params ? host_arg_to_f64(arg, &args[i].f) : host_arg_to_i64(arg, &args[i].i)))
+    {
+      ctx->error_message = "Runtime Error: Argument type does not match the typed host function";
+      return EXEC_ERR_INVALID_PTR;
+    }
+  }
+
+  HostScalar ret = binding->invoke(binding->typed, args);
+
+  if (ei->result == EXEC_INVALID_INDEX)
+    return EXEC_OK;
+
+  RuntimeValue *rt_res = RESULT(ctx, ei);
+  rt_res->kind = ir_to_runtime_kind(ei->ir->result.type->kind);
+  rt_res->as.val_i64 = 0;
+  bool int_result = (binding->ret_type == CALICO_HOST_I64);
+  switch (rt_res->kind)
+  {
+  case RUNTIME_VAL_I1:
+    rt_res->as.val_i1 = (ret.i & 1) != 0;
+    break;
+  case RUNTIME_VAL_I8:
+    rt_res->as.val_i8 = (int8_t)ret.i;
+    break;
+  case RUNTIME_VAL_I16:
+    rt_res->as.val_i16 = (int16_t)ret.i;
+    break;
+  case RUNTIME_VAL_I32:
+    rt_res->as.val_i32 = (int32_t)ret.i;
+    break;
+  case RUNTIME_VAL_I64:
+    rt_res->as.val_i64 = ret.i;
+    break;
+  case RUNTIME_VAL_PTR:
+    rt_res->as.val_ptr = (void *)(intptr_t)ret.i;
+    break;
+  case RUNTIME_VAL_F32:
+    rt_res->as.val_f32 = (float)ret.f;
+    int_result = !int_result;
+    break;
+  case RUNTIME_VAL_F64:
+    rt_res->as.val_f64 = ret.f;
+    int_result = !int_result;
+    break;
+  case RUNTIME_VAL_UNDEF:
+    int_result = false;
+    break;
+  }
+  if (!int_result)
+  {
+    ctx->error_message = "Runtime Error: Return type does not match the typed host function";
+    return EXEC_ERR_INVALID_PTR;
+  }
+  return EXEC_OK;
+}
+
+/**
+ * @brief 执行对外部声明的 'call' (调用链接的宿主函数)
+ */
+static ExecutionResultKind
+execute_op_ffi_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *func_to_call)
+{
+  /// 直接调用在构建计划时已经解析；只有通过函数指针的间接调用才按名字查找
+  const HostBinding *binding = (ei->aux != EXEC_INVALID_INDEX)
+                                 ? ctx->plan->host_calls[ei->aux]
+                                 : get_host_binding(ctx->interp, func_to_call->entry_address.name, false);
+
+  if (binding == NULL || (binding->boxed == NULL && binding->typed == NULL))
+  {
+    ctx->error_message = "Runtime Error: Call to unlinked external function";
+    return EXEC_ERR_INVALID_PTR;
+  }
+  if (binding->typed)
+    return execute_typed_host_call(ctx, ei, binding);
+
+  /// 参数指针数组: 参数少时放在宿主 C 栈上，否则临时放在解释器栈顶 (调用结束后立即释放)
+  size_t num_args = (ei->num_operands > 0) ? (ei->num_operands - 1) : 0;
+  size_t watermark = ctx->stack->top;
+  RuntimeValue *local_args[HOST_CALL_LOCAL_ARGS];
+  RuntimeValue **call_args = local_args;
+  if (num_args > HOST_CALL_LOCAL_ARGS)
+  {
+    call_args = stack_alloc(ctx->stack, sizeof(RuntimeValue *) * num_args, _Alignof(RuntimeValue *));
+    if (!call_args)
+    {
+      ctx->error_message = "Runtime Error: Stack overflow";
+      return EXEC_ERR_STACK_OVERFLOW;
+    }
+  }
+  for (size_t i = 0; i < num_args; i++)
+  {
+    call_args[i] = OPERAND(ctx, ei, i + 1);
+  }
+
+  /// 宿主函数通常只写入窄类型的字段，先清零使结果的高位确定
+  RuntimeValue call_result;
+  call_result.kind = RUNTIME_VAL_UNDEF;
+  call_result.as.val_i64 = 0;
+  ExecutionResultKind ffi_result = binding->boxed(ctx, call_args, num_args, &call_result);
+  ctx->stack->top = watermark;
+
+  if (ffi_result != EXEC_OK)
+  {
+    return ffi_result;
+  }
+
+  if (ei->result != EXEC_INVALID_INDEX)
+  {
+    *RESULT(ctx, ei) = call_result;
+  }
+  return EXEC_OK;
+}
+
+/**
+ * @brief 执行对 IR 函数的 'call': 压入被调者的帧 (不递归宿主 C 栈)
+ *
+ * 成功后 ctx 的当前帧就是被调者，执行循环应从其入口块继续。
+ */
+static ExecutionResultKind
+enter_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *func_to_call)
+{
+  ExecPlan *callee_plan = get_exec_plan(ctx->interp, func_to_call);
+  if (!callee_plan)
+  {
+    ctx->error_message = "Interpreter Error: Cannot build execution plan for callee";
+    return EXEC_ERR_INVALID_PTR;
+  }
+  assert(ei->num_operands - 1 >= callee_plan->num_args && "Interpreter: Mismatched argument count");
+
+  RuntimeValue *caller_slots = ctx->slots;
+  ExecutionResultKind status = push_frame(ctx, callee_plan, ctx->frame, ei);
+  if (status != EXEC_OK)
+    return status;
+
+  for (uint32_t i = 0; i < callee_plan->num_args; i++)
+  {
+    ctx->slots[i] = caller_slots[ei->operands[i + 1]];
+  }
+  init_frame_slots(ctx);
+  return EXEC_OK;
+}
+
+/**
+ * @brief 执行尾调用: 用被调者的帧替换当前帧
+ *
+ * 被调者返回时直接回到当前帧的调用者，所以无限尾递归只占用常数栈空间。
+ */
+static ExecutionResultKind
+enter_tail_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *func_to_call)
+{
+  ExecPlan *callee_plan = get_exec_plan(ctx->interp, func_to_call);
+  if (!callee_plan)
+  {
+    ctx->error_message = "Interpreter Error: Cannot build execution plan for callee";
+    return EXEC_ERR_INVALID_PTR;
+  }
+  assert(ei->num_operands - 1 >= callee_plan->num_args && "Interpreter: Mismatched argument count");
+
+  InterpreterStack *stack = ctx->stack;
+  uint32_t num_args = callee_plan->num_args;
+
+  /// 1. 先把实参收集到栈顶 (当前帧之上)，因为新帧会覆盖当前帧
+  RuntimeValue *staged = stack_alloc(stack, sizeof(RuntimeValue) * num_args, _Alignof(RuntimeValue));
+  if (!staged)
+  {
+    ctx->error_message = "Runtime Error: Stack overflow";
+    return EXEC_ERR_STACK_OVERFLOW;
+  }
+  for (uint32_t i = 0; i < num_args; i++)
+  {
+    staged[i] = *OPERAND(ctx, ei, i + 1);
+  }
+
+  /// 2. 弹出当前帧，在同一位置压入被调者的帧
+  ExecFrame *frame = ctx->frame;
+  ExecFrame *caller = frame->caller;
+  ExecInst *call_site = frame->call_site;
+  stack->top = frame->watermark;
+
+  ExecutionResultKind status = push_frame(ctx, callee_plan, caller, call_site);
+  if (status != EXEC_OK)
+    return status;
+
+  /// 3. 新帧的寄存器堆总是位于 staged 之下，memmove 可以正确处理重叠
+  memmove(ctx->slots, staged, sizeof(RuntimeValue) * num_args);
+  init_frame_slots(ctx);
+  return EXEC_OK;
+}
+
+/*
+ * =================================================================
+ * --- 基线 JIT 接入 (JIT Tier) ---
+ * =================================================================
+ *
+ * 机器码与解释器共用同一种帧: 解释器压入并初始化帧，然后调用机器码入口；
+ * 机器码中没有模板的指令回调 jit_execute_inst。机器码里的 'call' 以嵌套方式
+ * 执行被调者 (被调者返回后辅助函数才返回)，因此会递归宿主 C 栈，
+ * 嵌套深度超过 INTERP_JIT_MAX_DEPTH 后改为解释执行 (不再递归)。
+ */
+
+/// 机器码在宿主 C 栈上最多嵌套的层数
+#define INTERP_JIT_MAX_DEPTH 256
+
+static ExecutionResultKind run_plan(ExecutionContext *ctx, RuntimeValue *result_out);
+static JitEntry get_jit_entry(Interpreter *interp, ExecPlan *plan);
+static bool try_memo_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *callee, ExecutionResultKind *status_out);
+
+/**
+ * @brief 在当前帧 (已初始化) 上执行机器码
+ */
+static ExecutionResultKind
+run_native(ExecutionContext *ctx, JitEntry entry, RuntimeValue *result_out)
+{
+  ctx->native_depth++;
+  ExecutionResultKind status = entry(ctx, ctx->slots, result_out);
+  ctx->native_depth--;
+  return status;
+}
+
+/**
+ * @brief 以嵌套方式执行对 IR 函数的 'call' (被调者返回后才返回)
+ *
+ * 有 entry 时执行被调者的机器码，否则在新帧上运行解释器: 新帧没有 call_site，
+ * 所以它的 'ret' 会弹出帧并回到这里，而不是继续执行调用者。
+ */
+static ExecutionResultKind
+execute_nested_call(ExecutionContext *ctx, ExecInst *ei, ExecPlan *callee_plan, JitEntry entry)
+{
+  assert(ei->num_operands - 1 >= callee_plan->num_args && "Interpreter: Mismatched argument count");
+
+  RuntimeValue *caller_slots = ctx->slots;
+  ExecutionResultKind status = push_frame(ctx, callee_plan, ctx->frame, NULL);
+  if (status != EXEC_OK)
+    return status;
+
+  for (uint32_t i = 0; i < callee_plan->num_args; i++)
+  {
+    ctx->slots[i] = caller_slots[ei->operands[i + 1]];
+  }
+  init_frame_slots(ctx);
+
+  RuntimeValue ret_val;
+  if (entry)
+  {
+    status = run_native(ctx, entry, &ret_val);
+    if (status != EXEC_OK)
+      return status;
+    pop_frame(ctx);
+  }
+  else
+  {
+    status = run_plan(ctx, &ret_val);
+    if (status != EXEC_OK)
+      return status;
+  }
+
+  if (ei->result != EXEC_INVALID_INDEX)
+  {
+    caller_slots[ei->result] = ret_val;
+  }
+  return EXEC_OK;
+}
+
+/**
+ * @brief (解释器的 'call') 被调者已被编译时，以嵌套方式执行它的机器码
+ *
+ * @return 调用已执行 (结果状态在 status_out) 时返回 true；
+ * 应当照常解释执行 (JIT 关闭、被调者还不够热、嵌套过深) 时返回 false
+ */
+static bool
+try_native_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *callee, ExecutionResultKind *status_out)
+{
+  if (!ctx->interp->enable_jit || ctx->native_depth >= INTERP_JIT_MAX_DEPTH)
+    return false;
+
+  ExecPlan *callee_plan = get_exec_plan(ctx->interp, callee);
+  JitEntry entry = callee_plan ? get_jit_entry(ctx->interp, callee_plan) : NULL;
+  if (!entry)
+    return false;
+
+  *status_out = execute_nested_call(ctx, ei, callee_plan, entry);
+  return true;
+}
+
+/**
+ * @brief (机器码的 'call') FFI 直接调用，IR 函数以嵌套方式执行
+ */
+static ExecutionResultKind
+jit_execute_call(ExecutionContext *ctx, ExecInst *ei)
+{
+  IRFunction *callee = get_callee(ctx, ei);
+  if (callee->is_declaration)
+    return execute_op_ffi_call(ctx, ei, callee);
+
+  ExecutionResultKind status;
+  if (ctx->memoize && try_memo_call(ctx, ei, callee, &status))
+    return status;
+
+  ExecPlan *callee_plan = get_exec_plan(ctx->interp, callee);
+  if (!callee_plan)
+  {
+    ctx->error_message = "Interpreter Error: Cannot build execution plan for callee";
+    return EXEC_ERR_INVALID_PTR;
+  }
+  JitEntry entry = (ctx->native_depth < INTERP_JIT_MAX_DEPTH) ? get_jit_entry(ctx->interp, callee_plan) : NULL;
+  return execute_nested_call(ctx, ei, callee_plan, entry);
+}
+
+/**
+ * @brief 机器码中没有模板的指令 (JitHelpers::execute)
+ */
+static ExecutionResultKind
+jit_execute_inst(ExecutionContext *ctx, ExecInst *ei)
+{
+  switch (ei->ir->opcode)
+  {
+  case IR_OP_ALLOCA:
+    return execute_op_alloca(ctx, ei);
+  case IR_OP_LOAD:
+    eval_load(ctx, ei, OPERAND(ctx, ei, 0), RESULT(ctx, ei));
+    return EXEC_OK;
+  case IR_OP_STORE:
+    eval_store(ctx, ei, OPERAND(ctx, ei, 0), OPERAND(ctx, ei, 1));
+    return EXEC_OK;
+  case IR_OP_CALL:
+    return jit_execute_call(ctx, ei);
+  default:
+    return execute_scalar_inst(ctx, ei);
+  }
+}
+
+/**
+ * @brief 编译一个计划 (失败时标记，不再重试)
+ */
+static void
+jit_compile_plan(Interpreter *interp, ExecPlan *plan)
+{
+  static const JitHelpers helpers = {
+    .execute = jit_execute_inst,
+    .switch_edge = lookup_switch_edge,
+  };
+
+  JitCode *code = jit_compile(plan, interp->data_layout, &helpers);
+  if (!code)
+  {
+    plan->jit_failed = true;
+    return;
+  }
+  code->next = interp->jit_code;
+  interp->jit_code = code;
+  plan->jit_code = code;
+}
+
+/**
+ * @brief 计划的机器码入口 (计数调用次数，达到阈值时编译)；应当解释执行时返回 NULL
+ */
+static JitEntry
+get_jit_entry(Interpreter *interp, ExecPlan *plan)
+{
+  if (!interp->enable_jit)
+    return NULL;
+  if (plan->jit_code)
+    return plan->jit_code->entry;
+
+  /// 封存后计划只读 (计数与编译都会写它)；profile 计数器只由解释器维护
+  if (interp->sealed || plan->jit_failed || plan->profile)
+    return NULL;
+  if (plan->jit_calls < interp->jit_threshold)
+  {
+    plan->jit_calls++;
+    return NULL;
+  }
+
+  jit_compile_plan(interp, plan);
+  return plan->jit_code ? plan->jit_code->entry : NULL;
+}
+
+/**
+ * @brief 释放解释器持有的所有机器码
+ */
+static void
+free_jit_code(Interpreter *interp)
+{
+  JitCode *code = interp->jit_code;
+  while (code)
+  {
+    JitCode *next = code->next;
+    jit_code_free(code);
+    code = next;
+  }
+  interp->jit_code = NULL;
+}
+
+/*
+ * =================================================================
+ * --- 纯函数备忘 (Memoization) ---
+ * =================================================================
+ *
+ * 备忘表是一个固定大小的 MEMO_WAYS 路组相联表: 键是 (函数, 每个参数的 kind 与规范化的位)，
+ * 用 XXH3 散列后选中一组，组内按最近使用排序，插入满的组时替换最久未用的一项。
+ * 未命中的嵌套调用在宿主 C 栈上执行 (与机器码的嵌套调用相同)，返回后再写入结果。
+ */
+
+/// 每组的项数
+#define MEMO_WAYS 4
+
+/// 未命中的备忘调用在宿主 C 栈上最多嵌套的层数
+#define INTERP_MEMO_MAX_DEPTH 256
+
+/// 键的最大长度 (以 uint64_t 计): 函数地址 + 每个参数的 (kind, 位)
+#define MEMO_KEY_MAX (1 + 2 * INTERP_MEMO_MAX_ARGS)
+
+typedef struct MemoEntry
+{
+  uint64_t hash;
+  /** 键的长度 (0 表示空项) */
+  uint32_t key_len;
+  uint64_t key[MEMO_KEY_MAX];
+  RuntimeValue result;
+} MemoEntry;
+
+struct MemoTable
+{
+  MemoEntry *entries;
+  size_t num_sets;
+  size_t count;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+typedef struct MemoTable MemoTable;
+
+/**
+ * @brief 备忘键的构建状态
+ */
+typedef struct MemoKey
+{
+  uint64_t words[MEMO_KEY_MAX];
+  uint32_t len;
+} MemoKey;
+
+static inline void
+memo_key_init(MemoKey *key, IRFunction *func)
+{
+  key->words[0] = (uint64_t)(uintptr_t)func;
+  key->len = 1;
+}
+
+/**
+ * @brief 向键追加一个参数: 只取 kind 对应的有效位，窄类型未写入的高位不影响命中
+ */
+static inline void
+memo_key_push(MemoKey *key, RuntimeValue *arg)
+{
+  uint64_t bits = 0;
+  switch (arg->kind)
+  {
+  case RUNTIME_VAL_I1:
+  case RUNTIME_VAL_I8:
+  case RUNTIME_VAL_I16:
+  case RUNTIME_VAL_I32:
+  case RUNTIME_VAL_I64:
+    bits = (uint64_t)get_int_value_as_i64(arg);
+    break;
+  case RUNTIME_VAL_F32:
+    memcpy(&bits, &arg->as.val_f32, sizeof(float));
+    break;
+  case RUNTIME_VAL_F64:
+    memcpy(&bits, &arg->as.val_f64, sizeof(double));
+    break;
+  case RUNTIME_VAL_PTR:
+    bits = (uint64_t)(uintptr_t)arg->as.val_ptr;
+    break;
+  case RUNTIME_VAL_UNDEF:
+    break;
+  }
+  key->words[key->len++] = (uint64_t)arg->kind;
+  key->words[key->len++] = bits;
+}
+
+static inline uint64_t
+memo_key_hash(const MemoKey *key)
+{
+  return XXH3_64bits(key->words, key->len * sizeof(uint64_t));
+}
+
+/**
+ * @brief 查询备忘表 (命中时把该项移到组首)
+ */
+static bool
+memo_lookup(MemoTable *memo, const MemoKey *key, uint64_t hash, RuntimeValue *result_out)
+{
+  MemoEntry *set = &memo->entries[(hash & (memo->num_sets - 1)) * MEMO_WAYS];
+  for (uint32_t way = 0; way < MEMO_WAYS; way++)
+  {
+    MemoEntry *entry = &set[way];
+    if (entry->key_len == 0)
+      break;
+    if (entry->hash != hash || entry->key_len != key->len ||
+        memcmp(entry->key, key->words, key->len * sizeof(uint64_t)) != 0)
+      continue;
+
+    *result_out = entry->result;
+    if (way > 0)
+    {
+      MemoEntry hit = *entry;
+      memmove(&set[1], &set[0], way * sizeof(MemoEntry));
+      set[0] = hit;
+    }
+    memo->hits++;
+    return true;
+  }
+  memo->misses++;
+  return false;
+}
+
+/**
+ * @brief 把结果插入组首 (组满时替换最久未用的一项)
+ */
+static void
+memo_insert(MemoTable *memo, const MemoKey *key, uint64_t hash, const RuntimeValue *result)
+{
+  MemoEntry *set = &memo->entries[(hash & (memo->num_sets - 1)) * MEMO_WAYS];
+  if (set[MEMO_WAYS - 1].key_len != 0)
+    memo->evictions++;
+  else
+    memo->count++;
+  memmove(&set[1], &set[0], (MEMO_WAYS - 1) * sizeof(MemoEntry));
+
+  set[0].hash = hash;
+  set[0].key_len = key->len;
+  memcpy(set[0].key, key->words, key->len * sizeof(uint64_t));
+  set[0].result = *result;
+}
+
+static void
+memo_clear_entries(MemoTable *memo)
+{
+  memset(memo->entries, 0, memo->num_sets * MEMO_WAYS * sizeof(MemoEntry));
+  memo->count = 0;
+}
+
+static void
+free_memo_table(MemoTable *memo)
+{
+  if (!memo)
+    return;
+  free(memo->entries);
+  free(memo);
+}
+
+/**
+ * @brief 函数能否被备忘: 纯函数、返回整数或浮点数、参数不超过 INTERP_MEMO_MAX_ARGS 个
+ */
+static bool
+is_memoizable(IRFunction *func, const ExecPlan *plan)
+{
+  if (plan->num_args > INTERP_MEMO_MAX_ARGS)
+    return false;
+  RuntimeValueKind ret_kind = ir_to_runtime_kind(func->return_type->kind);
+  if (ret_kind == RUNTIME_VAL_UNDEF || ret_kind == RUNTIME_VAL_PTR)
+    return false;
+  return purity_is_pure_function(func);
+}
+
+/**
+ * @brief (解释器与机器码的 'call') 被调者可以备忘时，查询备忘表或嵌套执行后写入结果
+ *
+ * @return 调用已处理 (结果状态在 status_out) 时返回 true；应当照常执行时返回 false
+ */
+static bool
+try_memo_call(ExecutionContext *ctx, ExecInst *ei, IRFunction *callee, ExecutionResultKind *status_out)
+{
+  if (ei->result == EXEC_INVALID_INDEX || ctx->memo_depth >= INTERP_MEMO_MAX_DEPTH)
+    return false;
+  ExecPlan *callee_plan = get_exec_plan(ctx->interp, callee);
+  if (!callee_plan || !callee_plan->memoizable)
+    return false;
+
+  MemoTable *memo = ctx->interp->memo;
+  RuntimeValue *caller_slots = ctx->slots;
+  MemoKey key;
+  memo_key_init(&key, callee);
+  for (uint32_t i = 0; i < callee_plan->num_args; i++)
+  {
+    memo_key_push(&key, &caller_slots[ei->operands[i + 1]]);
+  }
+  uint64_t hash = memo_key_hash(&key);
+  if (memo_lookup(memo, &key, hash, &caller_slots[ei->result]))
+  {
+    *status_out = EXEC_OK;
+    return true;
+  }
+
+  JitEntry entry = (ctx->interp->enable_jit && ctx->native_depth < INTERP_JIT_MAX_DEPTH)
+                     ? get_jit_entry(ctx->interp, callee_plan)
+                     : NULL;
+  ctx->memo_depth++;
+  *status_out = execute_nested_call(ctx, ei, callee_plan, entry);
+  ctx->memo_depth--;
+  if (*status_out == EXEC_OK)
+    memo_insert(memo, &key, hash, &caller_slots[ei->result]);
+  return true;
+}
+
+/*
+ * =================================================================
+ * --- 分派引擎 (Dispatch Engines) ---
+ * =================================================================
+ */
+
+/// 可移植的 switch 分派引擎 (总是可用)
+#define EXEC_LOOP_NAME run_plan_switch
+#define EXEC_LOOP_THREADED 0
+#define EXEC_LOOP_BUDGETED 0
+#include "exec_loop.inc"
+#undef EXEC_LOOP_NAME
+#undef EXEC_LOOP_THREADED
+#undef EXEC_LOOP_BUDGETED
+
+/// 带指令预算、可以挂起的版本 (可恢复执行使用)
+#define EXEC_LOOP_NAME run_plan_switch_budgeted
+#define EXEC_LOOP_THREADED 0
+#define EXEC_LOOP_BUDGETED 1
+#include "exec_loop.inc"
+#undef EXEC_LOOP_NAME
+#undef EXEC_LOOP_THREADED
+#undef EXEC_LOOP_BUDGETED
+
+#if CALICO_HAS_THREADED_ENGINE
+/// 直接线程化引擎 (GCC/Clang 的 '&&label' computed goto)
+#define EXEC_LOOP_NAME run_plan_threaded
+#define EXEC_LOOP_THREADED 1
+#define EXEC_LOOP_BUDGETED 0
+#include "exec_loop.inc"
+#undef EXEC_LOOP_NAME
+#undef EXEC_LOOP_THREADED
+#undef EXEC_LOOP_BUDGETED
+
+#define EXEC_LOOP_NAME run_plan_threaded_budgeted
+#define EXEC_LOOP_THREADED 1
+#define EXEC_LOOP_BUDGETED 1
+#include "exec_loop.inc"
+#undef EXEC_LOOP_NAME
+#undef EXEC_LOOP_THREADED
+#undef EXEC_LOOP_BUDGETED
+#endif
+
+/**
+ * @brief 用解释器选择的引擎执行 ctx->plan
+ */
+static ExecutionResultKind
+run_plan(ExecutionContext *ctx, RuntimeValue *result_out)
+{
+#if CALICO_HAS_THREADED_ENGINE
+  if (ctx->interp->engine == INTERP_ENGINE_THREADED)
+  {
+    return run_plan_threaded(ctx, result_out);
+  }
+#endif
+  return run_plan_switch(ctx, result_out);
+}
+
+/**
+ * @brief 在 ctx->budget 的预算内，从 ctx->resume_block 继续执行当前帧 (预算用完时返回 EXEC_RUNNING)
+ */
+static ExecutionResultKind
+run_plan_budgeted(ExecutionContext *ctx, RuntimeValue *result_out)
+{
+#if CALICO_HAS_THREADED_ENGINE
+  if (ctx->interp->engine == INTERP_ENGINE_THREADED)
+  {
+    return run_plan_threaded_budgeted(ctx, result_out);
+  }
+#endif
+  return run_plan_switch_budgeted(ctx, result_out);
+}
+
+/*
+ * =================================================================
+ * --- 公共 API (Public API) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 创建一个新的解释器实例。
+ * (来自你的 stub)
+ */
+Interpreter *
+interpreter_create(DataLayout *data_layout)
+{
+  Interpreter *interp = (Interpreter *)malloc(sizeof(Interpreter));
+  if (!interp)
+    return NULL;
+
+  interp->arena = bump_new();
+  if (!interp->arena)
+  {
+    free(interp);
+    return NULL;
+  }
+
+  interp->global_storage = ptr_hashmap_create(interp->arena, 64);
+  if (!interp->global_storage)
+  {
+    bump_free(interp->arena);
+    free(interp);
+    return NULL;
+  }
+
+  interp->external_function_map = str_hashmap_create(interp->arena, 64);
+  if (!interp->external_function_map)
+  {
+    bump_free(interp->arena);
+    free(interp);
+    return NULL;
+  }
+
+  /// 存储对 DataLayout 的 *借用*
+  interp->data_layout = data_layout;
+
+  interp->engine = CALICO_HAS_THREADED_ENGINE ? INTERP_ENGINE_THREADED : INTERP_ENGINE_SWITCH;
+  interp->enable_fusion = true;
+  interp->enable_profiling = false;
+  interp->enable_jit = false;
+  interp->jit_threshold = INTERP_JIT_DEFAULT_THRESHOLD;
+  interp->jit_code = NULL;
+  interp->memo = NULL;
+  interp->global_images = NULL;
+
+  interp->plan_arena = bump_new();
+  if (!interp->plan_arena)
+  {
+    bump_free(interp->arena);
+    free(interp);
+    return NULL;
+  }
+
+  interp->plan_cache = ptr_hashmap_create(interp->plan_arena, 64);
+  if (!interp->plan_cache)
+  {
+    bump_free(interp->plan_arena);
+    bump_free(interp->arena);
+    free(interp);
+    return NULL;
+  }
+
+  if (!stack_init(&interp->stack, INTERP_STACK_SIZE))
+  {
+    bump_free(interp->plan_arena);
+    bump_free(interp->arena);
+    free(interp);
+    return NULL;
+  }
+  interp->sealed = false;
+
+  return interp;
+}
+
+/**
+ * @brief 销毁解释器实例并释放其所有内存。
+ * (来自你的 stub)
+ */
+void
+interpreter_destroy(Interpreter *interp)
+{
+  if (!interp)
+    return;
+  free(interp->stack.base);
+  free_jit_code(interp);
+  free_memo_table(interp->memo);
+  bump_free(interp->plan_arena);
+  bump_free(interp->arena);
+  free(interp);
+}
+
+/**
+ * @brief [FFI] 注册一个宿主 C 函数，使其可在 IR 中被调用
+ * (来自 interpreter.h 的 API 实现)
+ */
+void
+interpreter_register_external_function(Interpreter *interp, const char *name, CalicoHostFunction fn_ptr)
+{
+  assert(interp != NULL && "Interpreter is NULL");
+  assert(name != NULL && "Function name is NULL");
+  assert(fn_ptr != NULL && "Function pointer is NULL");
+
+  /// 原地更新链接结果: 已经解析到它的调用点立即生效
+  HostBinding *binding = get_host_binding(interp, name, true);
+  if (!binding)
+    return;
+  binding->boxed = fn_ptr;
+  binding->typed = NULL;
+}
+
+bool
+interpreter_register_typed_function(Interpreter *interp, const char *name, CalicoTypedHostFunction fn_ptr,
+                                    CalicoHostType ret_type, CalicoHostType param_type, size_t num_params)
+{
+  assert(interp != NULL && "Interpreter is NULL");
+  assert(name != NULL && "Function name is NULL");
+  assert(fn_ptr != NULL && "Function pointer is NULL");
+
+  if (num_params > CALICO_TYPED_HOST_MAX_PARAMS || (num_params > 0 && param_type == CALICO_HOST_VOID) ||
+      (unsigned)ret_type > CALICO_HOST_F64)
+    return false;
+
+  HostBinding *binding = get_host_binding(interp, name, true);
+  if (!binding)
+    return false;
+  binding->boxed = NULL;
+  binding->typed = fn_ptr;
+  binding->ret_type = ret_type;
+  binding->param_type = (num_params > 0) ? param_type : CALICO_HOST_I64;
+  binding->num_params = (uint32_t)num_params;
+  binding->invoke = TYPED_HOST_INVOKERS[ret_type][binding->param_type == CALICO_HOST_F64][num_params];
+  return true;
+}
+
+bool
+interpreter_link_module(Interpreter *interp, IRModule *mod)
+{
+  assert(interp != NULL && mod != NULL);
+  bool all_linked = true;
+
+  IDList *it;
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *f = list_entry(it, IRFunction, list_node);
+    if (!f->is_declaration)
+      continue;
+    HostBinding *binding = get_host_binding(interp, f->entry_address.name, !interp->sealed);
+    if (!binding || (!binding->boxed && !binding->typed))
+      all_linked = false;
+  }
+  return all_linked;
+}
+
+bool
+interpreter_set_engine(Interpreter *interp, InterpreterEngine engine)
+{
+  assert(interp != NULL);
+  if (engine == INTERP_ENGINE_THREADED && !CALICO_HAS_THREADED_ENGINE)
+    return false;
+  interp->engine = engine;
+  return true;
+}
+
+void
+interpreter_set_fusion(Interpreter *interp, bool enabled)
+{
+  assert(interp != NULL);
+  if (interp->enable_fusion == enabled)
+    return;
+  interp->enable_fusion = enabled;
+  interpreter_invalidate_all(interp);
+}
+
+static_assert((int)INTERP_FUSION_KIND_COUNT == (int)EXEC_NUM_FUSED_OPS,
+              "InterpreterFusionKind must mirror the fused ExecOpcodes");
+
+size_t
+interpreter_get_fusion_count(Interpreter *interp, InterpreterFusionKind kind)
+{
+  assert(interp != NULL && kind < INTERP_FUSION_KIND_COUNT);
+  size_t total = 0;
+  PtrHashMapIter iter = ptr_hashmap_iter(interp->plan_cache);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&iter, &entry))
+  {
+    ExecPlan *plan = (ExecPlan *)entry.value;
+    total += plan->fusion_counts[kind];
+  }
+  return total;
+}
+
+void
+interpreter_dump_fusion_stats(Interpreter *interp, FILE *stream)
+{
+  static const char *const names[INTERP_FUSION_KIND_COUNT] = {
+    [INTERP_FUSION_ICMP_BR] = "icmp + cond_br",
+    [INTERP_FUSION_GEP_LOAD] = "gep + load",
+    [INTERP_FUSION_LOAD_BINOP_STORE] = "load + binop + store",
+  };
+
+  fprintf(stream, "--- Superinstruction fusion (%zu cached plans) ---\n", ptr_hashmap_size(interp->plan_cache));
+  for (int kind = 0; kind < INTERP_FUSION_KIND_COUNT; kind++)
+  {
+    fprintf(stream, "  %-22s %zu\n", names[kind], interpreter_get_fusion_count(interp, (InterpreterFusionKind)kind));
+  }
+}
+
+bool
+interpreter_set_jit(Interpreter *interp, bool enabled)
+{
+  assert(interp != NULL);
+  if (enabled && !CALICO_HAS_JIT)
+    return false;
+  interp->enable_jit = enabled;
+  return true;
+}
+
+void
+interpreter_set_jit_threshold(Interpreter *interp, uint32_t calls)
+{
+  assert(interp != NULL);
+  interp->jit_threshold = calls;
+}
+
+bool
+interpreter_is_jit_compiled(Interpreter *interp, IRFunction *func)
+{
+  assert(interp != NULL && func != NULL);
+  ExecPlan *plan = ptr_hashmap_get(interp->plan_cache, func);
+  return plan && plan->jit_code;
+}
+
+void
+interpreter_set_profiling(Interpreter *interp, bool enabled)
+{
+  assert(interp != NULL);
+  if (interp->enable_profiling == enabled)
+    return;
+  interp->enable_profiling = enabled;
+  interpreter_invalidate_all(interp);
+}
+
+bool
+interpreter_set_memoization(Interpreter *interp, bool enabled, size_t capacity)
+{
+  assert(interp != NULL);
+  free_memo_table(interp->memo);
+  interp->memo = NULL;
+  interpreter_invalidate_all(interp);
+  if (!enabled)
+    return true;
+
+  if (capacity == 0)
+    capacity = INTERP_MEMO_DEFAULT_CAPACITY;
+  size_t num_sets = 1;
+  while (num_sets * MEMO_WAYS < capacity)
+    num_sets <<= 1;
+
+  MemoTable *memo = (MemoTable *)calloc(1, sizeof(MemoTable));
+  MemoEntry *entries = memo ? (MemoEntry *)calloc(num_sets * MEMO_WAYS, sizeof(MemoEntry)) : NULL;
+  if (!entries)
+  {
+    free(memo);
+    return false;
+  }
+  memo->entries = entries;
+  memo->num_sets = num_sets;
+  interp->memo = memo;
+  return true;
+}
+
+void
+interpreter_get_memo_stats(Interpreter *interp, InterpreterMemoStats *stats_out)
+{
+  assert(interp != NULL && stats_out != NULL);
+  MemoTable *memo = interp->memo;
+  memset(stats_out, 0, sizeof(*stats_out));
+  if (!memo)
+    return;
+  stats_out->hits = memo->hits;
+  stats_out->misses = memo->misses;
+  stats_out->evictions = memo->evictions;
+  stats_out->entries = memo->count;
+  stats_out->capacity = memo->num_sets * MEMO_WAYS;
+}
+
+void
+interpreter_clear_memo(Interpreter *interp)
+{
+  assert(interp != NULL);
+  MemoTable *memo = interp->memo;
+  if (!memo)
+    return;
+  memo_clear_entries(memo);
+  memo->hits = 0;
+  memo->misses = 0;
+  memo->evictions = 0;
+}
+
+void
+interpreter_reset_profile(Interpreter *interp)
+{
+  assert(interp != NULL);
+  PtrHashMapIter iter = ptr_hashmap_iter(interp->plan_cache);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&iter, &entry))
+  {
+    ExecPlan *plan = (ExecPlan *)entry.value;
+    if (!plan->profile)
+      continue;
+    plan->profile->calls = 0;
+    plan->profile->self_cycles = 0;
+    memset(plan->profile->block_entries, 0, sizeof(uint64_t) * plan->num_blocks);
+  }
+}
+
+/**
+ * @brief 获取函数当前缓存计划的 profile (没有则返回 NULL)
+ */
+static ExecProfile *
+get_cached_profile(Interpreter *interp, IRFunction *func, ExecPlan **plan_out)
+{
+  ExecPlan *plan = ptr_hashmap_get(interp->plan_cache, func);
+  if (plan_out)
+    *plan_out = plan;
+  return plan ? plan->profile : NULL;
+}
+
+uint64_t
+interpreter_profile_get_calls(Interpreter *interp, IRFunction *func)
+{
+  assert(interp != NULL && func != NULL);
+  ExecProfile *profile = get_cached_profile(interp, func, NULL);
+  return profile ? profile->calls : 0;
+}
+
+uint64_t
+interpreter_profile_get_cycles(Interpreter *interp, IRFunction *func)
+{
+  assert(interp != NULL && func != NULL);
+  ExecProfile *profile = get_cached_profile(interp, func, NULL);
+  return profile ? profile->self_cycles : 0;
+}
+
+uint64_t
+interpreter_profile_get_block_entries(Interpreter *interp, IRBasicBlock *bb)
+{
+  assert(interp != NULL && bb != NULL);
+  ExecPlan *plan;
+  ExecProfile *profile = get_cached_profile(interp, bb->parent, &plan);
+  if (!profile)
+    return 0;
+  for (uint32_t i = 0; i < plan->num_blocks; i++)
+  {
+    if (plan->blocks[i].ir == bb)
+      return profile->block_entries[i];
+  }
+  return 0;
+}
+
+/**
+ * @brief 由块进入次数推导每种 IROpcode 的执行次数 (counts 的大小为 IR_OP_CALL + 1)
+ */
+static void
+collect_opcode_counts(Interpreter *interp, uint64_t *counts)
+{
+  memset(counts, 0, sizeof(uint64_t) * (IR_OP_CALL + 1));
+  PtrHashMapIter iter = ptr_hashmap_iter(interp->plan_cache);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&iter, &entry))
+  {
+    ExecPlan *plan = (ExecPlan *)entry.value;
+    if (!plan->profile)
+      continue;
+    for (uint32_t b = 0; b < plan->num_blocks; b++)
+    {
+      uint64_t entries = plan->profile->block_entries[b];
+      if (entries == 0)
+        continue;
+      const ExecBlock *block = &plan->blocks[b];
+      for (uint32_t i = 0; i < block->num_insts; i++)
+      {
+        /// 超级指令也按组内原始指令计数
+        counts[plan->insts[block->first_inst + i].ir->opcode] += entries;
+      }
+    }
+  }
+}
+
+uint64_t
+interpreter_profile_get_opcode_count(Interpreter *interp, IROpcode opcode)
+{
+  assert(interp != NULL && opcode <= IR_OP_CALL);
+  uint64_t counts[IR_OP_CALL + 1];
+  collect_opcode_counts(interp, counts);
+  return counts[opcode];
+}
+
+/** @brief interpreter_dump_profile 的注解状态 */
+typedef struct ProfileAnnotation
+{
+  Interpreter *interp;
+  uint64_t total_cycles;
+} ProfileAnnotation;
+
+static void
+annotate_profiled_function(void *user_data, IRFunction *func, IRPrinter *p)
+{
+  ProfileAnnotation *pa = user_data;
+  ExecProfile *profile = get_cached_profile(pa->interp, func, NULL);
+  if (!profile)
+    return;
+  double share = pa->total_cycles ? 100.0 * (double)profile->self_cycles / (double)pa->total_cycles : 0.0;
+  ir_printf(p, "; calls: %" PRIu64 ", self cycles: %" PRIu64 " (%.1f%%)\n", profile->calls, profile->self_cycles,
+            share);
+}
+
+static void
+annotate_profiled_block(void *user_data, IRBasicBlock *bb, IRPrinter *p)
+{
+  ProfileAnnotation *pa = user_data;
+  if (!get_cached_profile(pa->interp, bb->parent, NULL))
+    return;
+  ir_printf(p, "  ; entries: %" PRIu64, interpreter_profile_get_block_entries(pa->interp, bb));
+}
+
+void
+interpreter_dump_profile(Interpreter *interp, IRModule *mod, IRPrinter *p)
+{
+  static const char *const names[IR_OP_CALL + 1] = {
+    [IR_OP_RET] = "ret",           [IR_OP_BR] = "br",           [IR_OP_COND_BR] = "cond_br",
+    [IR_OP_SWITCH] = "switch",     [IR_OP_ADD] = "add",         [IR_OP_SUB] = "sub",
+    [IR_OP_MUL] = "mul",           [IR_OP_UDIV] = "udiv",       [IR_OP_SDIV] = "sdiv",
+    [IR_OP_UREM] = "urem",         [IR_OP_SREM] = "srem",       [IR_OP_FADD] = "fadd",
+    [IR_OP_FSUB] = "fsub",         [IR_OP_FMUL] = "fmul",       [IR_OP_FDIV] = "fdiv",
+    [IR_OP_SHL] = "shl",           [IR_OP_LSHR] = "lshr",       [IR_OP_ASHR] = "ashr",
+    [IR_OP_AND] = "and",           [IR_OP_OR] = "or",           [IR_OP_XOR] = "xor",
+    [IR_OP_ALLOCA] = "alloc",      [IR_OP_LOAD] = "load",       [IR_OP_STORE] = "store",
+    [IR_OP_GEP] = "gep",           [IR_OP_ICMP] = "icmp",       [IR_OP_FCMP] = "fcmp",
+    [IR_OP_TRUNC] = "trunc",       [IR_OP_ZEXT] = "zext",       [IR_OP_SEXT] = "sext",
+    [IR_OP_FPTRUNC] = "fptrunc",   [IR_OP_FPEXT] = "fpext",     [IR_OP_FPTOUI] = "fptoui",
+    [IR_OP_FPTOSI] = "fptosi",     [IR_OP_UITOFP] = "uitofp",   [IR_OP_SITOFP] = "sitofp",
+    [IR_OP_PTRTOINT] = "ptrtoint", [IR_OP_INTTOPTR] = "inttoptr", [IR_OP_BITCAST] = "bitcast",
+    [IR_OP_SELECT] = "select",     [IR_OP_PHI] = "phi",         [IR_OP_CALL] = "call",
+  };
+  assert(interp != NULL && mod != NULL && p != NULL);
+
+  ProfileAnnotation pa = {.interp = interp, .total_cycles = 0};
+  PtrHashMapIter iter = ptr_hashmap_iter(interp->plan_cache);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&iter, &entry))
+  {
+    ExecPlan *plan = (ExecPlan *)entry.value;
+    if (plan->profile)
+      pa.total_cycles += plan->profile->self_cycles;
+  }
+
+  uint64_t counts[IR_OP_CALL + 1];
+  collect_opcode_counts(interp, counts);
+  uint64_t total = 0;
+  for (int op = 0; op <= IR_OP_CALL; op++)
+    total += counts[op];
+
+  ir_printf(p, "; --- Interpreter profile: %" PRIu64 " instructions, %" PRIu64 " cycles ---\n", total,
+            pa.total_cycles);
+  for (int op = 0; op <= IR_OP_CALL; op++)
+  {
+    if (counts[op] != 0)
+      ir_printf(p, ";   %-10s %12" PRIu64 "\n", names[op], counts[op]);
+  }
+  ir_print_str(p, "\n");
+
+  const IRPrinterAnnotator annotator = {
+    .user_data = &pa,
+    .annotate_function = annotate_profiled_function,
+    .annotate_block = annotate_profiled_block,
+  };
+  const IRPrinterAnnotator *saved = p->annotator;
+  ir_printer_set_annotator(p, &annotator);
+  ir_module_dump_internal(mod, p);
+  ir_printer_set_annotator(p, saved);
+}
+
+void
+interpreter_invalidate_function(Interpreter *interp, IRFunction *func)
+{
+  assert(interp != NULL && func != NULL);
+  /// 旧计划的内存留在 plan_arena 中，直到 interpreter_invalidate_all() 或销毁
+  ptr_hashmap_remove(interp->plan_cache, func);
+  if (interp->memo)
+    memo_clear_entries(interp->memo);
+  interp->sealed = false;
+}
+
+void
+interpreter_invalidate_all(Interpreter *interp)
+{
+  assert(interp != NULL);
+  free_jit_code(interp);
+  bump_reset(interp->plan_arena);
+  interp->plan_cache = ptr_hashmap_create(interp->plan_arena, 64);
+  assert(interp->plan_cache && "OOM re-creating plan cache");
+  if (interp->memo)
+    memo_clear_entries(interp->memo);
+  interp->sealed = false;
+}
+
+/** @brief 排序 switch case 时使用的 (值, 原始顺序, 目标边) 三元组 */
+typedef struct SwitchCaseKey
+{
+  int64_t value;
+  uint32_t order;
+  uint32_t edge;
+} SwitchCaseKey;
+
+static int
+compare_switch_case_key(const void *a, const void *b)
+{
+  const SwitchCaseKey *ka = a;
+  const SwitchCaseKey *kb = b;
+  if (ka->value != kb->value)
+    return (ka->value < kb->value) ? -1 : 1;
+  /// 同值的 case 保持原顺序 (线性扫描时第一个匹配者获胜)
+  return (ka->order < kb->order) ? -1 : (ka->order > kb->order);
+}
+
+/**
+ * @brief 为计划中的每条 'switch' 选择查找策略并构建查找结构，每个计划只执行一次
+ *
+ * case 值从常量池读取 (与运行时比较使用同一套语义)。
+ * - case 数 < EXEC_SWITCH_LINEAR_MAX: 线性比较
+ * - 值域 <= 2 * case 数 且 <= EXEC_SWITCH_TABLE_MAX: 跳转表
+ * - 其余: 有序数组 + 二分查找
+ * 任何一步 OOM 时退回线性比较 (结果仍然正确)。
+ */
+static void
+build_switch_tables(Interpreter *interp, ExecPlan *plan)
+{
+  Bump *arena = interp->plan_arena;
+  uint32_t switch_idx = 0;
+
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_SWITCH)
+      continue;
+
+    assert(ei->aux == switch_idx && "Switch numbering out of sync");
+    ExecSwitch *sw = &plan->switches[switch_idx++];
+    sw->kind = EXEC_SWITCH_LINEAR;
+    sw->default_edge = ei->operands[1];
+
+    uint32_t num_cases = (ei->num_operands - 2) / 2;
+    if (num_cases < EXEC_SWITCH_LINEAR_MAX)
+      continue;
+
+    SwitchCaseKey *keys = BUMP_ALLOC_SLICE(arena, SwitchCaseKey, num_cases);
+    if (!keys)
+      continue;
+    bool all_constant = true;
+    for (uint32_t c = 0; c < num_cases; c++)
+    {
+      ExecSlot case_slot = ei->operands[2 + 2 * c];
+      if (case_slot < plan->first_extern_slot)
+      {
+        /// case 值不是常量 (verifier 不允许，这里只做保守处理)
+        all_constant = false;
+        break;
+      }
+      keys[c].value = get_int_value_as_i64(&plan->const_pool[case_slot - plan->first_extern_slot]);
+      keys[c].order = c;
+      keys[c].edge = ei->operands[3 + 2 * c];
+    }
+    if (!all_constant)
+      continue;
+    qsort(keys, num_cases, sizeof(SwitchCaseKey), compare_switch_case_key);
+
+    /// 去重 (保留每个值第一次出现的 case)
+    uint32_t num_unique = 0;
+    for (uint32_t c = 0; c < num_cases; c++)
+    {
+      if (num_unique == 0 || keys[num_unique - 1].value != keys[c].value)
+        keys[num_unique++] = keys[c];
+    }
+
+    uint64_t range = (uint64_t)keys[num_unique - 1].value - (uint64_t)keys[0].value + 1;
+    if (range != 0 && range <= EXEC_SWITCH_TABLE_MAX && range <= 2 * (uint64_t)num_unique)
+    {
+      uint32_t *table = BUMP_ALLOC_SLICE(arena, uint32_t, range);
+      if (!table)
+        continue;
+      for (uint64_t v = 0; v < range; v++)
+        table[v] = sw->default_edge;
+      for (uint32_t c = 0; c < num_unique; c++)
+        table[(uint64_t)keys[c].value - (uint64_t)keys[0].value] = keys[c].edge;
+
+      sw->kind = EXEC_SWITCH_TABLE;
+      sw->min_value = keys[0].value;
+      sw->table_size = (uint32_t)range;
+      sw->table = table;
+      continue;
+    }
+
+    int64_t *sorted = BUMP_ALLOC_SLICE(arena, int64_t, num_unique);
+    uint32_t *edges = BUMP_ALLOC_SLICE(arena, uint32_t, num_unique);
+    if (!sorted || !edges)
+      continue;
+    for (uint32_t c = 0; c < num_unique; c++)
+    {
+      sorted[c] = keys[c].value;
+      edges[c] = keys[c].edge;
+    }
+
+    sw->kind = EXEC_SWITCH_SORTED;
+    sw->num_keys = num_unique;
+    sw->keys = sorted;
+    sw->key_edges = edges;
+  }
+}
+
+/**
+ * @brief 把计划中直接调用外部声明的 'call' 解析到链接结果 (ExecInst::aux 为 host_calls 的下标)
+ *
+ * OOM 时这些调用退回按名字查找 (结果仍然正确)。
+ */
+static void
+build_host_calls(Interpreter *interp, ExecPlan *plan)
+{
+  uint32_t num_host_calls = 0;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_CALL)
+      continue;
+
+    ei->aux = EXEC_INVALID_INDEX;
+    ExecSlot callee_slot = ei->operands[0];
+    if (callee_slot < plan->first_extern_slot)
+      continue;
+    IRValueNode *callee = plan->externs[callee_slot - plan->first_extern_slot].value;
+    if (callee->kind == IR_KIND_FUNCTION && container_of(callee, IRFunction, entry_address)->is_declaration)
+      num_host_calls++;
+  }
+  if (num_host_calls == 0)
+    return;
+
+  HostBinding **host_calls = BUMP_ALLOC_SLICE(interp->plan_arena, HostBinding *, num_host_calls);
+  if (!host_calls)
+    return;
+
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_CALL || ei->operands[0] < plan->first_extern_slot)
+      continue;
+    IRValueNode *callee = plan->externs[ei->operands[0] - plan->first_extern_slot].value;
+    if (callee->kind != IR_KIND_FUNCTION)
+      continue;
+    IRFunction *func = container_of(callee, IRFunction, entry_address);
+    if (!func->is_declaration)
+      continue;
+
+    HostBinding *binding = get_host_binding(interp, func->entry_address.name, true);
+    if (!binding)
+      continue;
+    ei->aux = plan->num_host_calls;
+    host_calls[plan->num_host_calls++] = binding;
+  }
+  plan->host_calls = host_calls;
+}
+
+/**
+ * @brief 把计划中的每条 'gep' 解析成 常量偏移 + 变量下标 * 元素大小 (ExecInst::aux 为 geps 的下标)
+ *
+ * 常量下标从常量池读取 (与运行时使用同一套语义)，连同结构体成员偏移一起按 DataLayout 折叠，
+ * 偏移按 64 位回绕累加 (与逐个下标计算的结果相同)。
+ * OOM 或下标不符合源类型的 gep 保持 EXEC_INVALID_INDEX，执行时逐个下标计算。
+ */
+static void
+build_gep_offsets(Interpreter *interp, ExecPlan *plan)
+{
+  uint32_t num_geps = 0;
+  uint32_t num_operands = 0;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_GEP)
+      continue;
+    ei->aux = EXEC_INVALID_INDEX;
+    num_geps++;
+    num_operands += ei->num_operands - 1;
+  }
+  if (num_geps == 0)
+    return;
+
+  ExecGep *geps = BUMP_ALLOC_SLICE(interp->plan_arena, ExecGep, num_geps);
+  ExecGepTerm *terms = BUMP_ALLOC_SLICE(interp->plan_arena, ExecGepTerm, num_operands);
+  if (!geps || (num_operands && !terms))
+    return;
+
+  const DataLayout *dl = interp->data_layout;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_GEP)
+      continue;
+
+    ExecGep *gep = &geps[plan->num_geps];
+    gep->terms = terms;
+    gep->num_terms = 0;
+    uint64_t offset = 0;
+    bool ok = true;
+    IRType *current_type = ei->ir->as.gep.source_type;
+    for (uint32_t op = 1; op < ei->num_operands && ok; op++)
+    {
+      /// undef 之类的非整数常量留到执行时处理 (与逐个下标计算时的行为相同)
+      ExecSlot slot = ei->operands[op];
+      RuntimeValue *rt_const = NULL;
+      if (slot >= plan->first_extern_slot)
+        rt_const = &plan->const_pool[slot - plan->first_extern_slot];
+      bool is_const = rt_const && rt_const->kind >= RUNTIME_VAL_I1 && rt_const->kind <= RUNTIME_VAL_I64;
+      int64_t idx = is_const ? get_int_value_as_i64(rt_const) : 0;
+
+      if (op > 1 && current_type->kind == IR_TYPE_STRUCT)
+      {
+        ok = is_const && idx >= 0 && (size_t)idx < current_type->as.aggregate.member_count;
+        if (ok)
+        {
+          offset += datalayout_get_struct_member_offset(dl, current_type, (size_t)idx);
+          current_type = current_type->as.aggregate.member_types[idx];
+        }
+        continue;
+      }
+      if (op > 1)
+      {
+        ok = current_type->kind == IR_TYPE_ARRAY;
+        if (!ok)
+          continue;
+        current_type = current_type->as.array.element_type;
+      }
+
+      uint64_t scale = datalayout_get_type_size(dl, current_type);
+      if (is_const)
+        offset += (uint64_t)idx * scale;
+      else
+        gep->terms[gep->num_terms++] = (ExecGepTerm){op, scale};
+    }
+    if (!ok)
+      continue;
+
+    gep->offset = (int64_t)offset;
+    terms += gep->num_terms;
+    ei->aux = plan->num_geps++;
+  }
+  plan->geps = geps;
+}
+
+/**
+ * @brief 为计划中的每个 'alloca' 在帧内分配固定位置 (ExecInst::aux 为它在 alloca 区内的偏移)
+ *
+ * alloca 区随帧一起压入 / 弹出，因此循环中反复执行的 alloca 复用同一块内存，
+ * 帧的大小只取决于函数本身，而不是执行了多少条指令。
+ *
+ * 按对齐从大到小依次摆放 (同一对齐内保持 IR 顺序)。类型的大小总是其对齐的倍数，
+ * 所以每一段的起点都已满足下一段的对齐，alloca 之间没有填充。
+ */
+static void
+build_frame_layout(Interpreter *interp, ExecPlan *plan)
+{
+  size_t align = 1;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->opcode != IR_OP_ALLOCA)
+      continue;
+    size_t inst_align = datalayout_get_type_align(interp->data_layout, ei->ir->result.type->as.pointee_type);
+    if (inst_align > align)
+      align = inst_align;
+  }
+
+  size_t size = 0;
+  for (size_t class_align = align; class_align >= 1; class_align >>= 1)
+  {
+    for (uint32_t i = 0; i < plan->num_insts; i++)
+    {
+      ExecInst *ei = &plan->insts[i];
+      if (ei->opcode != IR_OP_ALLOCA)
+        continue;
+
+      BumpLayout layout = datalayout_get_type_layout(interp->data_layout, ei->ir->result.type->as.pointee_type);
+      if (layout.align != class_align)
+        continue;
+      size_t offset = (size + (layout.align - 1)) & ~(layout.align - 1);
+      if (offset > UINT32_MAX || layout.size > SIZE_MAX - offset)
+      {
+        /// 无法表示的帧: 压入时报告栈溢出
+        plan->alloca_size = SIZE_MAX;
+        plan->alloca_align = 1;
+        return;
+      }
+      ei->aux = (uint32_t)offset;
+      size = offset + layout.size;
+    }
+  }
+  plan->alloca_size = size;
+  plan->alloca_align = align;
+}
+
+/**
+ * @brief 获取函数的执行计划 (首次调用时降级并缓存)
+ */
+static ExecPlan *
+get_exec_plan(Interpreter *interp, IRFunction *func)
+{
+  ExecPlan *plan = ptr_hashmap_get(interp->plan_cache, func);
+  if (plan || interp->sealed)
+  {
+    /// 封存后计划缓存只读 (其他线程可能正在查找)，未准备的函数直接失败
+    return plan;
+  }
+
+  /// 延迟加载的函数体在第一次需要执行计划时构建
+  if (!ir_function_materialize(func))
+    return NULL;
+
+  plan = exec_plan_build(func, interp->plan_arena, interp->enable_fusion);
+  if (plan)
+  {
+    build_const_pool(interp, plan);
+    build_switch_tables(interp, plan);
+    build_host_calls(interp, plan);
+    build_gep_offsets(interp, plan);
+    build_frame_layout(interp, plan);
+    plan->memoizable = interp->memo && is_memoizable(func, plan);
+    if (interp->enable_profiling)
+    {
+      /// OOM 时该函数只是不被 profile
+      plan->profile = BUMP_ALLOC_ZEROED(interp->plan_arena, ExecProfile);
+      uint64_t *entries =
+        plan->profile ? BUMP_ALLOC_SLICE_ZEROED(interp->plan_arena, uint64_t, plan->num_blocks) : NULL;
+      if (entries)
+        plan->profile->block_entries = entries;
+      else
+        plan->profile = NULL;
+    }
+    ptr_hashmap_put(interp->plan_cache, func, plan);
+  }
+  return plan;
+}
+
+/**
+ * @brief 在指定的解释器栈上运行一个 IR 函数
+ */
+static bool
+run_function_on_stack(Interpreter *interp, InterpreterStack *stack, IRFunction *func, RuntimeValue **args,
+                      size_t num_args, RuntimeValue *result_out)
+{
+  assert(interp && func && result_out && "Invalid arguments for interpreter");
+  assert(interp->data_layout != NULL && "Interpreter is missing its DataLayout");
+
+  /// 获取 (缓存的) 槽位化执行计划
+  ExecPlan *plan = get_exec_plan(interp, func);
+  if (!plan)
+    return false;
+
+  ExecutionContext ctx;
+  ctx.interp = interp;
+  ctx.frame = NULL;
+  ctx.plan = NULL;
+  ctx.slots = NULL;
+  ctx.stack = stack;
+  ctx.error_message = NULL;
+  ctx.profile_stamp = plan->profile ? read_cycle_counter() : 0;
+  ctx.native_depth = 0;
+  ctx.memoize = (interp->memo != NULL && stack == &interp->stack);
+  ctx.memo_depth = 0;
+  ctx.budget = 0;
+  ctx.resume_block = 0;
+
+  /// 本次运行的所有帧都压在当前栈顶之上 (FFI 回调重入时也是如此)
+  size_t base_watermark = stack->top;
+
+  if (push_frame(&ctx, plan, NULL, NULL) != EXEC_OK)
+    return false;
+
+  /// 参数占据槽位 [0, num_args)
+  assert(num_args >= plan->num_args && "Interpreter: Mismatched argument count");
+  for (uint32_t i = 0; i < plan->num_args; i++)
+  {
+    ctx.slots[i] = *args[i];
+  }
+
+  /// 可备忘的函数先查备忘表 (命中时不执行函数体)
+  MemoKey memo_key;
+  uint64_t memo_hash = 0;
+  bool memoize = ctx.memoize && plan->memoizable;
+  if (memoize)
+  {
+    memo_key_init(&memo_key, func);
+    for (uint32_t i = 0; i < plan->num_args; i++)
+    {
+      memo_key_push(&memo_key, &ctx.slots[i]);
+    }
+    memo_hash = memo_key_hash(&memo_key);
+    if (memo_lookup(interp->memo, &memo_key, memo_hash, result_out))
+    {
+      stack->top = base_watermark;
+      return true;
+    }
+  }
+  init_frame_slots(&ctx);
+
+  JitEntry entry = get_jit_entry(interp, plan);
+  ExecutionResultKind status = entry ? run_native(&ctx, entry, result_out) : run_plan(&ctx, result_out);
+  if (status != EXEC_OK)
+  {
+    /// 出错时没有经过 'ret'，把最后一段时间记到出错的函数上
+    profile_charge(&ctx);
+  }
+  else if (memoize)
+  {
+    memo_insert(interp->memo, &memo_key, memo_hash, result_out);
+  }
+
+  /// 无论成功与否，一次性释放本次运行压入的所有帧
+  stack->top = base_watermark;
+
+  return status == EXEC_OK;
+}
+
+/**
+ * @brief (已重构) 运行 (解释) 一个 IR 函数。
+ */
+bool
+interpreter_run_function(Interpreter *interp, IRFunction *func, RuntimeValue **args, size_t num_args,
+                         RuntimeValue *result_out)
+{
+  assert(interp != NULL);
+  INSTRUMENT_BEGIN(scope, "interpret", func->parent ? func->parent->name : NULL, func->entry_address.name);
+  bool ok = run_function_on_stack(interp, &interp->stack, func, args, num_args, result_out);
+  INSTRUMENT_END(scope);
+  return ok;
+}
+
+bool
+interpreter_prepare_module(Interpreter *interp, IRModule *mod)
+{
+  assert(interp != NULL && mod != NULL);
+  interp->sealed = false;
+
+  /// 1. 全局变量: 构建模块的全局镜像 (之后 global_storage 只读)
+  IDList *it;
+  if (!load_module_globals(interp, mod))
+    return false;
+
+  /// 2. 执行计划: 为每个已定义的函数构建 (声明走 FFI，不需要计划)
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *f = list_entry(it, IRFunction, list_node);
+    if (f->is_declaration)
+      continue;
+    ExecPlan *plan = get_exec_plan(interp, f);
+    if (!plan)
+      return false;
+
+    /// 封存后不再计数，开启 JIT 时直接编译所有函数 (失败的函数解释执行)
+    if (interp->enable_jit && !plan->profile && !plan->jit_code && !plan->jit_failed)
+      jit_compile_plan(interp, plan);
+  }
+
+  interp->sealed = true;
+  return true;
+}
+
+bool
+interpreter_load_globals(Interpreter *interp, IRModule *mod)
+{
+  assert(interp != NULL && mod != NULL);
+  return load_module_globals(interp, mod);
+}
+
+bool
+interpreter_reset_globals(Interpreter *interp, IRModule *mod)
+{
+  assert(interp != NULL && mod != NULL);
+  if (!load_module_globals(interp, mod))
+    return false;
+  for (GlobalImage *image = interp->global_images; image; image = image->next)
+  {
+    if (image->module == mod)
+      memcpy(image->memory, image->initial, image->size);
+  }
+  return true;
+}
+
+GlobalSnapshot *
+interpreter_snapshot_globals(Interpreter *interp, IRModule *mod)
+{
+  assert(interp != NULL && mod != NULL);
+  if (!load_module_globals(interp, mod))
+    return NULL;
+
+  size_t size = 0;
+  for (GlobalImage *image = interp->global_images; image; image = image->next)
+  {
+    if (image->module == mod)
+      size += image->size;
+  }
+
+  GlobalSnapshot *snapshot = (GlobalSnapshot *)malloc(sizeof(GlobalSnapshot) + size);
+  if (!snapshot)
+    return NULL;
+  snapshot->module = mod;
+  snapshot->size = size;
+
+  size_t offset = 0;
+  for (GlobalImage *image = interp->global_images; image; image = image->next)
+  {
+    if (image->module != mod)
+      continue;
+    memcpy(snapshot->data + offset, image->memory, image->size);
+    offset += image->size;
+  }
+  return snapshot;
+}
+
+void
+interpreter_restore_globals(Interpreter *interp, const GlobalSnapshot *snapshot)
+{
+  assert(interp != NULL && snapshot != NULL);
+
+  /// 镜像只会追加，快照之后新增的镜像不在快照里，保持原样
+  size_t offset = 0;
+  for (GlobalImage *image = interp->global_images; image && offset < snapshot->size; image = image->next)
+  {
+    if (image->module != snapshot->module)
+      continue;
+    memcpy(image->memory, snapshot->data + offset, image->size);
+    offset += image->size;
+  }
+}
+
+void
+interpreter_snapshot_destroy(GlobalSnapshot *snapshot)
+{
+  free(snapshot);
+}
+
+InterpreterWorker *
+interpreter_worker_create(Interpreter *interp)
+{
+  assert(interp != NULL);
+  InterpreterWorker *worker = (InterpreterWorker *)malloc(sizeof(InterpreterWorker));
+  if (!worker)
+    return NULL;
+
+  worker->interp = interp;
+  if (!stack_init(&worker->stack, INTERP_STACK_SIZE))
+  {
+    free(worker);
+    return NULL;
+  }
+  return worker;
+}
+
+void
+interpreter_worker_destroy(InterpreterWorker *worker)
+{
+  if (!worker)
+    return;
+  free(worker->stack.base);
+  free(worker);
+}
+
+bool
+interpreter_worker_run_function(InterpreterWorker *worker, IRFunction *func, RuntimeValue **args, size_t num_args,
+                                RuntimeValue *result_out)
+{
+  assert(worker != NULL);
+  return run_function_on_stack(worker->interp, &worker->stack, func, args, num_args, result_out);
+}
+
+/*
+ * =================================================================
+ * --- 可恢复执行 (Resumable Execution) ---
+ * =================================================================
+ *
+ * 执行在自己的解释器栈上压入根帧，然后由带预算的分派循环推进。
+ * 预算用完时循环停在某个块的入口 (入边的 PHI 复制已经完成)，
+ * 所以挂起状态只有 ctx 的当前帧与 ctx->resume_block，其余都在栈上。
+ */
+
+InterpreterExecution *
+interpreter_execution_start(Interpreter *interp, IRFunction *func, RuntimeValue **args, size_t num_args,
+                            size_t stack_size)
+{
+  assert(interp && func && "Invalid arguments for interpreter");
+
+  ExecPlan *plan = get_exec_plan(interp, func);
+  if (!plan)
     return NULL;
+  assert(num_args >= plan->num_args && "Interpreter: Mismatched argument count");
 
-  interp->arena = bump_new();
-  if (!interp->arena)
+  InterpreterExecution *exec = (InterpreterExecution *)malloc(sizeof(InterpreterExecution));
+  if (!exec)
+    return NULL;
+  if (!stack_init(&exec->stack, stack_size ? stack_size : INTERP_EXECUTION_DEFAULT_STACK_SIZE))
   {
-    free(interp);
+    free(exec);
     return NULL;
   }
 
-  interp->global_storage = ptr_hashmap_create(interp->arena, 64);
-  if (!interp->global_storage)
+  exec->interp = interp;
+  exec->status = EXEC_RUNNING;
+  exec->result.kind = RUNTIME_VAL_UNDEF;
+  exec->result.as.val_i64 = 0;
+  exec->instructions = 0;
+  exec->user_data = NULL;
+  exec->next = NULL;
+
+  ExecutionContext *ctx = &exec->ctx;
+  ctx->interp = interp;
+  ctx->frame = NULL;
+  ctx->plan = NULL;
+  ctx->slots = NULL;
+  ctx->stack = &exec->stack;
+  ctx->error_message = NULL;
+  ctx->profile_stamp = 0;
+  ctx->native_depth = 0;
+  ctx->memoize = false;
+  ctx->memo_depth = 0;
+  ctx->budget = 0;
+  ctx->resume_block = 0;
+
+  if (push_frame(ctx, plan, NULL, NULL) != EXEC_OK)
   {
-    bump_free(interp->arena);
-    free(interp);
+    interpreter_execution_destroy(exec);
     return NULL;
   }
+  for (uint32_t i = 0; i < plan->num_args; i++)
+  {
+    ctx->slots[i] = *args[i];
+  }
+  init_frame_slots(ctx);
+  return exec;
+}
 
-  interp->external_function_map = str_hashmap_create(interp->arena, 64);
-  if (!interp->external_function_map)
+ExecutionResultKind
+interpreter_execution_step(InterpreterExecution *exec, uint64_t budget)
+{
+  assert(exec != NULL);
+  if (exec->status != EXEC_RUNNING)
+    return exec->status;
+
+  ExecutionContext *ctx = &exec->ctx;
+  ctx->budget = budget;
+  /// 挂起期间的时间不记到任何函数上
+  ctx->profile_stamp = ctx->plan->profile ? read_cycle_counter() : 0;
+
+  ExecutionResultKind status = run_plan_budgeted(ctx, &exec->result);
+  exec->instructions += budget - ctx->budget;
+  if (status == EXEC_RUNNING)
   {
-    bump_free(interp->arena);
-    free(interp);
-    return NULL;
+    profile_charge(ctx);
+    return status;
   }
 
-  /// 存储对 DataLayout 的 *借用*
-  interp->data_layout = data_layout;
+  if (status != EXEC_OK)
+  {
+    profile_charge(ctx);
+  }
+  /// 执行结束: 一次性释放所有帧
+  exec->stack.top = 0;
+  exec->status = status;
+  return status;
+}
 
-  return interp;
+void
+interpreter_execution_destroy(InterpreterExecution *exec)
+{
+  if (!exec)
+    return;
+  free(exec->stack.base);
+  free(exec);
 }
 
+/*
+ * =================================================================
+ * --- 批量执行 (Batch Execution) ---
+ * =================================================================
+ *
+ * 一组最多 INTERP_BATCH_WIDTH 个 lane 以锁步方式执行同一个计划:
+ * 每个槽位是一列 BatchLane (见 batch_kernels.h)，每个基本块有一个
+ * "等待进入" 的 lane 掩码。每一步取编号最小的非空块，把它的掩码作为
+ * 活跃掩码执行块内的指令，终结指令再把活跃 lane 按目标边分组，
+ * 在各自的掩码下执行边上的 PHI 复制并加入目标块的等待掩码。
+ * 每个 lane 走的路径与单独执行时完全相同，只是被合并成了整列的运算。
+ */
+
+/** @brief 槽位 slot 的 lane 列 */
+#define BATCH_COLUMN(bs, slot) (&(bs)->columns[(size_t)(slot) * INTERP_BATCH_WIDTH])
+
 /**
- * @brief 销毁解释器实例并释放其所有内存。
- * (来自你的 stub)
+ * @brief 一组 lane 的批量执行状态 (所有数组都分配在解释器栈上)
  */
-void
-interpreter_destroy(Interpreter *interp)
+typedef struct BatchState
 {
-  if (!interp)
-    return;
-  bump_free(interp->arena);
-  free(interp);
+  /** ctx->slots 指向 scratch (逐 lane 执行的指令在这里读写) */
+  ExecutionContext *ctx;
+  ExecPlan *plan;
+  /** [num_slots][INTERP_BATCH_WIDTH] */
+  BatchLane *columns;
+  /** [num_blocks][INTERP_BATCH_WIDTH] 等待进入每个块的 lane */
+  uint8_t *pending;
+  /** [num_blocks] 每个块等待的 lane 数 */
+  uint32_t *pending_count;
+  /** 一个标量帧 (外部槽位已从常量池初始化) */
+  RuntimeValue *scratch;
+  /** [INTERP_BATCH_WIDTH] 当前块的活跃掩码 */
+  uint8_t *active;
+  /** [INTERP_BATCH_WIDTH] 终结指令分组时的临时掩码 */
+  uint8_t *edge_mask;
+  /** [INTERP_BATCH_WIDTH] switch 中每个 lane 的目标边 */
+  uint32_t *lane_edge;
+} BatchState;
+
+/**
+ * @brief 把一个运行时值转换为 lane 的规范表示
+ */
+static inline BatchLane
+batch_lane_from_value(const RuntimeValue *v)
+{
+  switch (v->kind)
+  {
+  case RUNTIME_VAL_I1:
+    return v->as.val_i1;
+  case RUNTIME_VAL_I8:
+    return (uint64_t)(int64_t)v->as.val_i8;
+  case RUNTIME_VAL_I16:
+    return (uint64_t)(int64_t)v->as.val_i16;
+  case RUNTIME_VAL_I32:
+    return (uint64_t)(int64_t)v->as.val_i32;
+  case RUNTIME_VAL_I64:
+    return (uint64_t)v->as.val_i64;
+  case RUNTIME_VAL_F32:
+    return batch_lane_from_f64((double)v->as.val_f32);
+  case RUNTIME_VAL_F64:
+    return batch_lane_from_f64(v->as.val_f64);
+  case RUNTIME_VAL_PTR:
+    return (uintptr_t)v->as.val_ptr;
+  case RUNTIME_VAL_UNDEF:
+  default:
+    return 0;
+  }
 }
 
 /**
- * @brief [FFI] 注册一个宿主 C 函数，使其可在 IR 中被调用
- * (来自 interpreter.h 的 API 实现)
+ * @brief 把 lane 的规范表示转换回 kind 类型的运行时值
  */
-void
-interpreter_register_external_function(Interpreter *interp, const char *name, CalicoHostFunction fn_ptr)
+static inline void
+batch_lane_to_value(BatchLane lane, RuntimeValueKind kind, RuntimeValue *out)
 {
-  assert(interp != NULL && "Interpreter is NULL");
-  assert(name != NULL && "Function name is NULL");
-  assert(fn_ptr != NULL && "Function pointer is NULL");
+  out->kind = kind;
+  out->as.val_i64 = 0;
+  switch (kind)
+  {
+  case RUNTIME_VAL_I1:
+    out->as.val_i1 = (bool)(lane & 1);
+    break;
+  case RUNTIME_VAL_I8:
+    out->as.val_i8 = (int8_t)lane;
+    break;
+  case RUNTIME_VAL_I16:
+    out->as.val_i16 = (int16_t)lane;
+    break;
+  case RUNTIME_VAL_I32:
+    out->as.val_i32 = (int32_t)lane;
+    break;
+  case RUNTIME_VAL_I64:
+    out->as.val_i64 = (int64_t)lane;
+    break;
+  case RUNTIME_VAL_F32:
+    out->as.val_f32 = (float)batch_lane_as_f64(lane);
+    break;
+  case RUNTIME_VAL_F64:
+    out->as.val_f64 = batch_lane_as_f64(lane);
+    break;
+  case RUNTIME_VAL_PTR:
+    out->as.val_ptr = (void *)(uintptr_t)lane;
+    break;
+  case RUNTIME_VAL_UNDEF:
+    break;
+  }
+}
 
-  str_hashmap_put(interp->external_function_map, name, strlen(name), (void *)fn_ptr);
+/**
+ * @brief 整数 / 指针类型的位宽 (其他类型为 0)
+ */
+static unsigned
+batch_type_bits(IRType *type)
+{
+  switch (type->kind)
+  {
+  case IR_TYPE_I1:
+    return 1;
+  case IR_TYPE_I8:
+    return 8;
+  case IR_TYPE_I16:
+    return 16;
+  case IR_TYPE_I32:
+    return 32;
+  case IR_TYPE_I64:
+  case IR_TYPE_PTR:
+    return 64;
+  default:
+    return 0;
+  }
 }
 
 /**
- * @brief (已重构) 运行 (解释) 一个 IR 函数。
+ * @brief 第 i 个操作数的 IR 类型
  */
-bool
-interpreter_run_function(Interpreter *interp, IRFunction *func, RuntimeValue **args, size_t num_args,
-                         RuntimeValue *result_out)
+static inline IRType *
+batch_operand_type(ExecInst *ei, uint32_t i)
 {
-  assert(interp && func && result_out && "Invalid arguments for interpreter");
-  assert(interp->data_layout != NULL && "Interpreter is missing its DataLayout");
+  return ir_instruction_get_operand(ei->ir, i)->type;
+}
 
-  ExecutionContext ctx;
-  ctx.interp = interp;
+/**
+ * @brief 逐 lane 执行一条指令: 把操作数 lane 装入标量帧，调用标量实现，再写回结果列
+ */
+static ExecutionResultKind
+batch_execute_per_lane(BatchState *bs, ExecInst *ei, const uint8_t *mask)
+{
+  ExecutionContext *ctx = bs->ctx;
+  BatchLane *dst = BATCH_COLUMN(bs, ei->result);
+
+  for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
+  {
+    if (!mask[l])
+      continue;
+
+    for (uint32_t j = 0; j < ei->num_operands; j++)
+    {
+      ExecSlot slot = ei->operands[j];
+      batch_lane_to_value(BATCH_COLUMN(bs, slot)[l], ir_to_runtime_kind(batch_operand_type(ei, j)->kind),
+                          &bs->scratch[slot]);
+    }
+
+    ExecutionResultKind status = execute_scalar_inst(ctx, ei);
+    if (status != EXEC_OK)
+      return status;
+
+    dst[l] = batch_lane_from_value(RESULT(ctx, ei));
+  }
+  return EXEC_OK;
+}
 
-  bump_init(&ctx.value_arena);
-  bump_init(&ctx.stack_arena);
-  bump_set_allocation_limit(&ctx.stack_arena, INTERP_STACK_SIZE);
+/**
+ * @brief 在活跃掩码下执行一条非终结指令 (有向量内核时对整列执行，否则逐 lane)
+ */
+static ExecutionResultKind
+batch_execute_inst(BatchState *bs, ExecInst *ei, const uint8_t *mask)
+{
+  IRInstruction *inst = ei->ir;
 
-  ctx.frame = ptr_hashmap_create(&ctx.value_arena, 64);
-  if (!ctx.frame)
+  switch (inst->opcode)
   {
-    bump_destroy(&ctx.value_arena);
-    bump_destroy(&ctx.stack_arena);
-    return false;
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR: {
+    unsigned bits = batch_type_bits(inst->result.type);
+    if (bits < 8)
+      break; /// i1 运算逐 lane 执行
+    batch_kernel_int_binary(inst->opcode, bits, BATCH_COLUMN(bs, ei->result), BATCH_COLUMN(bs, ei->operands[0]),
+                            BATCH_COLUMN(bs, ei->operands[1]), mask);
+    return EXEC_OK;
+  }
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+    if (!batch_kernel_float_binary(inst->opcode, inst->result.type->kind == IR_TYPE_F32, BATCH_COLUMN(bs, ei->result),
+                                   BATCH_COLUMN(bs, ei->operands[0]), BATCH_COLUMN(bs, ei->operands[1]), mask))
+    {
+      bs->ctx->error_message = "Runtime Error: Float division by zero";
+      return EXEC_ERR_DIV_BY_ZERO_F;
+    }
+    return EXEC_OK;
+  case IR_OP_ICMP: {
+    unsigned bits = batch_type_bits(batch_operand_type(ei, 0));
+    batch_kernel_icmp(inst->as.icmp.predicate, bits, BATCH_COLUMN(bs, ei->result), BATCH_COLUMN(bs, ei->operands[0]),
+                      BATCH_COLUMN(bs, ei->operands[1]), mask);
+    return EXEC_OK;
+  }
+  case IR_OP_FCMP:
+    batch_kernel_fcmp(inst->as.fcmp.predicate, BATCH_COLUMN(bs, ei->result), BATCH_COLUMN(bs, ei->operands[0]),
+                      BATCH_COLUMN(bs, ei->operands[1]), mask);
+    return EXEC_OK;
+  case IR_OP_SELECT:
+    batch_kernel_select(BATCH_COLUMN(bs, ei->result), BATCH_COLUMN(bs, ei->operands[0]),
+                        BATCH_COLUMN(bs, ei->operands[1]), BATCH_COLUMN(bs, ei->operands[2]), mask);
+    return EXEC_OK;
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT: {
+    unsigned src_bits = batch_type_bits(batch_operand_type(ei, 0));
+    unsigned dst_bits = batch_type_bits(inst->result.type);
+    if (dst_bits < 8)
+      break; /// 截断到 i1 逐 lane 执行
+    batch_kernel_int_cast(inst->opcode, src_bits, dst_bits, BATCH_COLUMN(bs, ei->result),
+                          BATCH_COLUMN(bs, ei->operands[0]), mask);
+    return EXEC_OK;
+  }
+  case IR_OP_SITOFP:
+  case IR_OP_UITOFP:
+  case IR_OP_FPEXT:
+  case IR_OP_FPTRUNC:
+    batch_kernel_float_cast(inst->opcode, batch_type_bits(batch_operand_type(ei, 0)),
+                            inst->result.type->kind == IR_TYPE_F32, BATCH_COLUMN(bs, ei->result),
+                            BATCH_COLUMN(bs, ei->operands[0]), mask);
+    return EXEC_OK;
+  default:
+    break;
   }
 
-  size_t arg_idx = 0;
-  IDList *arg_node;
-  list_for_each(&func->arguments, arg_node)
+  return batch_execute_per_lane(bs, ei, mask);
+}
+
+/**
+ * @brief 让 mask 中的 lane 沿边 edge_index 跳转 (mask 中至少有一个 lane)
+ */
+static void
+batch_take_edge(BatchState *bs, uint32_t edge_index, const uint8_t *mask)
+{
+  const ExecEdge *edge = &bs->plan->edges[edge_index];
+  const ExecCopy *copies = &bs->plan->copies[edge->first_copy];
+  for (uint32_t i = 0; i < edge->num_copies; i++)
   {
-    assert(arg_idx < num_args && "Interpreter: Mismatched argument count");
-    IRArgument *arg = list_entry(arg_node, IRArgument, list_node);
-    set_value(&ctx, &arg->value, args[arg_idx]);
-    arg_idx++;
+    batch_kernel_copy(BATCH_COLUMN(bs, copies[i].dst), BATCH_COLUMN(bs, copies[i].src), mask);
   }
 
-  IRModule *mod = func->parent;
-  if (mod)
+  uint8_t *pending = &bs->pending[(size_t)edge->target * INTERP_BATCH_WIDTH];
+  uint32_t count = 0;
+  for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
   {
+    pending[l] |= mask[l];
+    count += mask[l];
+  }
+  bs->pending_count[edge->target] += count;
+}
 
-    IDList *func_it;
-    list_for_each(&mod->functions, func_it)
+/**
+ * @brief 在活跃掩码下执行终结指令
+ *
+ * @param results_out 本组第一个 lane 的结果位置
+ */
+static void
+batch_execute_terminator(BatchState *bs, ExecInst *ei, const uint8_t *mask, RuntimeValue *results_out)
+{
+  switch (ei->ir->opcode)
+  {
+  case IR_OP_RET: {
+    /// 'ret void' 的结果为 UNDEF (与标量执行一致)
+    RuntimeValueKind kind = RUNTIME_VAL_UNDEF;
+    const BatchLane *col = NULL;
+    if (ei->num_operands > 0)
     {
-      IRFunction *f = list_entry(func_it, IRFunction, list_node);
-
-      RuntimeValue *rt_func_ptr = BUMP_ALLOC_ZEROED(ctx.interp->arena, RuntimeValue);
-      rt_func_ptr->kind = RUNTIME_VAL_PTR;
-      rt_func_ptr->as.val_ptr = (void *)f;
-      set_value(&ctx, &f->entry_address, rt_func_ptr);
+      kind = ir_to_runtime_kind(batch_operand_type(ei, 0)->kind);
+      col = BATCH_COLUMN(bs, ei->operands[0]);
+    }
+    for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
+    {
+      if (!mask[l])
+        continue;
+      batch_lane_to_value(col ? col[l] : 0, kind, &results_out[l]);
     }
+    break;
+  }
+  case IR_OP_BR:
+    batch_take_edge(bs, ei->operands[0], mask);
+    break;
+  case IR_OP_COND_BR: {
+    const BatchLane *cond = BATCH_COLUMN(bs, ei->operands[0]);
+    uint32_t num_true = 0;
+    for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
+    {
+      bs->edge_mask[l] = (uint8_t)(mask[l] && (cond[l] & 1));
+      num_true += bs->edge_mask[l];
+    }
+    if (num_true > 0)
+      batch_take_edge(bs, ei->operands[1], bs->edge_mask);
 
-    IDList *global_it;
-    list_for_each(&mod->globals, global_it)
+    uint32_t num_false = 0;
+    for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
+    {
+      bs->edge_mask[l] = (uint8_t)(mask[l] && !(cond[l] & 1));
+      num_false += bs->edge_mask[l];
+    }
+    if (num_false > 0)
+      batch_take_edge(bs, ei->operands[2], bs->edge_mask);
+    break;
+  }
+  case IR_OP_SWITCH: {
+    /// 每个 lane 单独查找目标边 (case 值在标量帧的外部槽位中)，再按边分组
+    const BatchLane *cond = BATCH_COLUMN(bs, ei->operands[0]);
+    RuntimeValueKind kind = ir_to_runtime_kind(batch_operand_type(ei, 0)->kind);
+    for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
     {
-      IRGlobalVariable *g = list_entry(global_it, IRGlobalVariable, list_node);
-      IRValueNode *global_val_node = &g->value;
+      if (!mask[l])
+        continue;
+      batch_lane_to_value(cond[l], kind, &bs->scratch[ei->operands[0]]);
+      bs->lane_edge[l] = lookup_switch_edge(bs->ctx, ei);
+    }
 
-      RuntimeValue *rt_ptr = ptr_hashmap_get(interp->global_storage, global_val_node);
+    for (size_t first = 0; first < INTERP_BATCH_WIDTH; first++)
+    {
+      if (!mask[first] || bs->lane_edge[first] == EXEC_INVALID_INDEX)
+        continue;
 
-      if (rt_ptr == NULL)
+      uint32_t edge = bs->lane_edge[first];
+      for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
       {
+        bs->edge_mask[l] = (uint8_t)(mask[l] && bs->lane_edge[l] == edge);
+        if (bs->edge_mask[l])
+          bs->lane_edge[l] = EXEC_INVALID_INDEX;
+      }
+      batch_take_edge(bs, edge, bs->edge_mask);
+    }
+    break;
+  }
+  default:
+    assert(false && "unreachable");
+  }
+}
 
-        BumpLayout layout = datalayout_get_type_layout(interp->data_layout, g->allocated_type);
-
-        void *host_global_ptr = bump_alloc_layout(ctx.interp->arena, layout);
-        assert(host_global_ptr && "OOM Allocating global variable");
-
-        memset(host_global_ptr, 0, layout.size);
-
-        if (g->initializer)
-        {
+/**
+ * @brief 执行一组 lane [first_lane, first_lane + num_lanes)
+ */
+static ExecutionResultKind
+batch_run_group(BatchState *bs, RuntimeValue *const *arg_columns, size_t first_lane, size_t num_lanes,
+                RuntimeValue *results_out)
+{
+  ExecPlan *plan = bs->plan;
 
-          IRConstant *init_const = container_of(g->initializer, IRConstant, value);
+  /// 参数列来自调用者；指令结果列清零；外部槽位把常量池广播到整列
+  memset(bs->columns, 0, sizeof(BatchLane) * INTERP_BATCH_WIDTH * plan->num_slots);
+  for (uint32_t a = 0; a < plan->num_args; a++)
+  {
+    BatchLane *col = BATCH_COLUMN(bs, a);
+    for (size_t l = 0; l < num_lanes; l++)
+    {
+      col[l] = batch_lane_from_value(&arg_columns[a][first_lane + l]);
+    }
+  }
+  for (uint32_t e = 0; e < plan->num_externs; e++)
+  {
+    BatchLane value = batch_lane_from_value(&plan->const_pool[e]);
+    BatchLane *col = BATCH_COLUMN(bs, plan->first_extern_slot + e);
+    for (size_t l = 0; l < INTERP_BATCH_WIDTH; l++)
+    {
+      col[l] = value;
+    }
+  }
 
-          RuntimeValue *init_val = eval_constant(&ctx, init_const);
-          memcpy(host_global_ptr, &init_val->as, layout.size);
-        }
+  memset(bs->pending, 0, (size_t)INTERP_BATCH_WIDTH * plan->num_blocks);
+  memset(bs->pending_count, 0, sizeof(uint32_t) * plan->num_blocks);
+  memset(bs->pending, 1, num_lanes);
+  bs->pending_count[0] = (uint32_t)num_lanes;
 
-        rt_ptr = BUMP_ALLOC_ZEROED(interp->arena, RuntimeValue);
-        rt_ptr->kind = RUNTIME_VAL_PTR;
-        rt_ptr->as.val_ptr = host_global_ptr;
+  for (;;)
+  {
+    uint32_t b = 0;
+    while (b < plan->num_blocks && bs->pending_count[b] == 0)
+      b++;
+    if (b == plan->num_blocks)
+      return EXEC_OK;
 
-        ptr_hashmap_put(interp->global_storage, global_val_node, rt_ptr);
-      }
+    /// 把等待掩码移出 (块内的跳转可能让 lane 重新进入本块)
+    uint8_t *pending = &bs->pending[(size_t)b * INTERP_BATCH_WIDTH];
+    memcpy(bs->active, pending, INTERP_BATCH_WIDTH);
+    memset(pending, 0, INTERP_BATCH_WIDTH);
+    bs->pending_count[b] = 0;
 
-      set_value(&ctx, global_val_node, rt_ptr);
+    const ExecBlock *eb = &plan->blocks[b];
+    uint32_t end = eb->first_inst + eb->num_insts - 1;
+    for (uint32_t k = eb->first_inst + eb->num_phis; k < end; k++)
+    {
+      ExecutionResultKind status = batch_execute_inst(bs, &plan->insts[k], bs->active);
+      if (status != EXEC_OK)
+        return status;
     }
+    batch_execute_terminator(bs, &plan->insts[end], bs->active, &results_out[first_lane]);
   }
+}
+
+/**
+ * @brief 在指定的解释器栈上批量运行一个 IR 函数
+ */
+static bool
+run_batch_on_stack(Interpreter *interp, InterpreterStack *stack, IRFunction *func, RuntimeValue *const *arg_columns,
+                   size_t num_args, size_t num_lanes, RuntimeValue *results_out)
+{
+  assert(interp && func && (results_out || num_lanes == 0) && "Invalid arguments for interpreter");
 
-  IRBasicBlock *entry_bb = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
-  IRBasicBlock *prev_block = NULL;
-  IRBasicBlock *current_block = entry_bb;
-  IRBasicBlock *next_block = NULL;
+  ExecPlan *plan = get_exec_plan(interp, func);
+  if (!plan)
+    return false;
+  assert(num_args >= plan->num_args && "Interpreter: Mismatched argument count");
 
-  ctx.error_message = NULL;
+  size_t base_watermark = stack->top;
+  size_t num_cells = (size_t)INTERP_BATCH_WIDTH * plan->num_slots;
 
-  while (current_block)
+  ExecutionContext ctx;
+  ctx.interp = interp;
+  ctx.frame = NULL;
+  ctx.plan = plan;
+  ctx.slots = NULL;
+  ctx.stack = stack;
+  ctx.error_message = NULL;
+  ctx.profile_stamp = 0;
+  ctx.native_depth = 0;
+  ctx.memoize = false;
+  ctx.memo_depth = 0;
+  ctx.budget = 0;
+  ctx.resume_block = 0;
+
+  BatchState bs;
+  bs.ctx = &ctx;
+  bs.plan = plan;
+  bs.columns = NULL;
+  if (plan->batchable)
   {
+    bs.columns = stack_alloc(stack, sizeof(BatchLane) * num_cells, _Alignof(BatchLane));
+    bs.pending = stack_alloc(stack, (size_t)INTERP_BATCH_WIDTH * plan->num_blocks, 1);
+    bs.pending_count = stack_alloc(stack, sizeof(uint32_t) * plan->num_blocks, _Alignof(uint32_t));
+    bs.scratch = stack_alloc(stack, sizeof(RuntimeValue) * plan->num_slots, _Alignof(RuntimeValue));
+    bs.active = stack_alloc(stack, INTERP_BATCH_WIDTH, 1);
+    bs.edge_mask = stack_alloc(stack, INTERP_BATCH_WIDTH, 1);
+    bs.lane_edge = stack_alloc(stack, sizeof(uint32_t) * INTERP_BATCH_WIDTH, _Alignof(uint32_t));
+    if (!bs.columns || !bs.pending || !bs.pending_count || !bs.scratch || !bs.active || !bs.edge_mask || !bs.lane_edge)
+    {
+      /// 列存储放不进解释器栈: 退化为逐 lane 执行
+      stack->top = base_watermark;
+      bs.columns = NULL;
+    }
+  }
 
-    ExecutionResultKind bb_result = execute_basic_block(&ctx, current_block, prev_block, result_out, &next_block);
+  bool ok = true;
+  if (bs.columns)
+  {
+    ctx.slots = bs.scratch;
+    memset(bs.scratch, 0, sizeof(RuntimeValue) * plan->num_slots);
+    memcpy(&bs.scratch[plan->first_extern_slot], plan->const_pool, sizeof(RuntimeValue) * plan->num_externs);
 
-    if (bb_result != EXEC_OK)
+    for (size_t first = 0; ok && first < num_lanes; first += INTERP_BATCH_WIDTH)
     {
-
-      bump_destroy(&ctx.value_arena);
-      bump_destroy(&ctx.stack_arena);
-      return false;
+      size_t count = num_lanes - first < INTERP_BATCH_WIDTH ? num_lanes - first : INTERP_BATCH_WIDTH;
+      ok = batch_run_group(&bs, arg_columns, first, count, results_out) == EXEC_OK;
     }
-
-    if (next_block == NULL)
+  }
+  else
+  {
+    size_t args_size = sizeof(RuntimeValue *) * (num_args ? num_args : 1);
+    RuntimeValue **args = stack_alloc(stack, args_size, _Alignof(RuntimeValue *));
+    ok = args != NULL;
+    for (size_t l = 0; ok && l < num_lanes; l++)
     {
-      break;
+      for (size_t a = 0; a < num_args; a++)
+      {
+        args[a] = &arg_columns[a][l];
+      }
+      ok = run_function_on_stack(interp, stack, func, args, num_args, &results_out[l]);
     }
-
-    prev_block = current_block;
-    current_block = next_block;
   }
 
-  bump_destroy(&ctx.value_arena);
-  bump_destroy(&ctx.stack_arena);
+  stack->top = base_watermark;
+  return ok;
+}
+
+bool
+interpreter_run_function_batch(Interpreter *interp, IRFunction *func, RuntimeValue *const *arg_columns,
+                               size_t num_args, size_t num_lanes, RuntimeValue *results_out)
+{
+  assert(interp != NULL);
+  return run_batch_on_stack(interp, &interp->stack, func, arg_columns, num_args, num_lanes, results_out);
+}
 
-  return true;
-}
\ No newline at end of file
+bool
+interpreter_worker_run_function_batch(InterpreterWorker *worker, IRFunction *func, RuntimeValue *const *arg_columns,
+                                      size_t num_args, size_t num_lanes, RuntimeValue *results_out)
+{
+  assert(worker != NULL);
+  return run_batch_on_stack(worker->interp, &worker->stack, func, arg_columns, num_args, num_lanes, results_out);
+}
@@ -0,0 +1,976 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/jit.h"
+
+#if CALICO_HAS_JIT
+
+#include "ir/instruction.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static_assert(sizeof(RuntimeValue) == 16 && offsetof(RuntimeValue, as) == 8,
+              "JIT templates assume a 16-byte RuntimeValue with the payload at offset 8");
+static_assert(sizeof(RuntimeValueKind) == 4, "JIT templates store the kind as a 32-bit immediate");
+
+/// 槽位的 kind 字段 / 载荷相对 rbx 的偏移
+#define SLOT_KIND_DISP(slot) ((int32_t)((slot) * sizeof(RuntimeValue)))
+#define SLOT_PAYLOAD_DISP(slot) ((int32_t)((slot) * sizeof(RuntimeValue) + offsetof(RuntimeValue, as)))
+
+/// 槽位偏移必须能放进 disp32
+#define JIT_MAX_SLOTS (INT32_MAX / sizeof(RuntimeValue) - 1)
+
+/// 模板只使用这三个易失寄存器 (不需要 REX.R / REX.B)
+enum
+{
+  JIT_RAX = 0,
+  JIT_RCX = 1,
+  JIT_RDX = 2,
+};
+
+/// x86 条件码 (jcc / setcc 的低 4 位)；cc ^ 1 为相反条件
+enum
+{
+  JIT_CC_B = 0x2,
+  JIT_CC_AE = 0x3,
+  JIT_CC_E = 0x4,
+  JIT_CC_NE = 0x5,
+  JIT_CC_BE = 0x6,
+  JIT_CC_A = 0x7,
+  JIT_CC_L = 0xC,
+  JIT_CC_GE = 0xD,
+  JIT_CC_LE = 0xE,
+  JIT_CC_G = 0xF,
+};
+
+/// 公共尾声 (恢复寄存器并返回 eax) 的标签编号
+#define JIT_EXIT_LABEL UINT32_MAX
+
+/**
+ * @brief 一个待回填的 rel32 (跳转到某个基本块或公共尾声)
+ */
+typedef struct JitFixup
+{
+  size_t at;
+  uint32_t target;
+} JitFixup;
+
+/**
+ * @brief 编译一个计划时的状态 (代码先写入竞技场，最后复制到可执行页)
+ */
+typedef struct JitCompiler
+{
+  Bump *arena;
+  const ExecPlan *plan;
+  const DataLayout *dl;
+  const JitHelpers *helpers;
+
+  uint8_t *code;
+  size_t len;
+  size_t capacity;
+
+  JitFixup *fixups;
+  size_t num_fixups;
+  size_t fixup_capacity;
+
+  size_t *block_offsets;
+  /** 正在翻译的块之后紧接着的块 (块末尾跳到它时可以省略 jmp) */
+  uint32_t next_block;
+  size_t exit_offset;
+  bool failed;
+} JitCompiler;
+
+/*
+ * =================================================================
+ * --- 编码辅助 (Encoding Helpers) ---
+ * =================================================================
+ */
+
+static void
+emit_bytes(JitCompiler *jc, const uint8_t *bytes, size_t n)
+{
+  if (jc->failed)
+    return;
+  if (jc->len + n > jc->capacity)
+  {
+    size_t new_capacity = jc->capacity * 2;
+    while (new_capacity < jc->len + n)
+      new_capacity *= 2;
+    uint8_t *grown = BUMP_REALLOC_SLICE(jc->arena, uint8_t, jc->code, jc->capacity, new_capacity);
+    if (!grown)
+    {
+      jc->failed = true;
+      return;
+    }
+    jc->code = grown;
+    jc->capacity = new_capacity;
+  }
+  memcpy(jc->code + jc->len, bytes, n);
+  jc->len += n;
+}
+
+/// 依次写入若干字节
+#define EMIT(jc, ...) emit_bytes((jc), (const uint8_t[]){__VA_ARGS__}, sizeof((const uint8_t[]){__VA_ARGS__}))
+
+static void
+emit_u32(JitCompiler *jc, uint32_t value)
+{
+  uint8_t bytes[4];
+  memcpy(bytes, &value, sizeof(bytes));
+  emit_bytes(jc, bytes, sizeof(bytes));
+}
+
+static void
+emit_u64(JitCompiler *jc, uint64_t value)
+{
+  uint8_t bytes[8];
+  memcpy(bytes, &value, sizeof(bytes));
+  emit_bytes(jc, bytes, sizeof(bytes));
+}
+
+/**
+ * @brief ModRM + disp32，内存操作数为 [rbx + disp]
+ */
+static void
+emit_slot_modrm(JitCompiler *jc, int reg, int32_t disp)
+{
+  EMIT(jc, (uint8_t)(0x80 | ((reg & 7) << 3) | 3));
+  emit_u32(jc, (uint32_t)disp);
+}
+
+/**
+ * @brief 写入 rel32 占位并记录回填 (target 为块编号或 JIT_EXIT_LABEL)
+ */
+static void
+emit_label_rel32(JitCompiler *jc, uint32_t target)
+{
+  if (jc->num_fixups == jc->fixup_capacity)
+  {
+    size_t new_capacity = jc->fixup_capacity * 2;
+    JitFixup *grown = BUMP_REALLOC_SLICE(jc->arena, JitFixup, jc->fixups, jc->fixup_capacity, new_capacity);
+    if (!grown)
+    {
+      jc->failed = true;
+      return;
+    }
+    jc->fixups = grown;
+    jc->fixup_capacity = new_capacity;
+  }
+  jc->fixups[jc->num_fixups++] = (JitFixup){.at = jc->len, .target = target};
+  emit_u32(jc, 0);
+}
+
+static void
+emit_jmp(JitCompiler *jc, uint32_t target)
+{
+  EMIT(jc, 0xE9);
+  emit_label_rel32(jc, target);
+}
+
+static void
+emit_jcc(JitCompiler *jc, uint8_t cc, uint32_t target)
+{
+  EMIT(jc, 0x0F, (uint8_t)(0x80 | cc));
+  emit_label_rel32(jc, target);
+}
+
+/**
+ * @brief 块内的前向条件跳转 (返回 rel32 的位置，稍后用 patch_here 回填)
+ */
+static size_t
+emit_forward_jcc(JitCompiler *jc, uint8_t cc)
+{
+  EMIT(jc, 0x0F, (uint8_t)(0x80 | cc));
+  size_t at = jc->len;
+  emit_u32(jc, 0);
+  return at;
+}
+
+static void
+patch_here(JitCompiler *jc, size_t at)
+{
+  if (jc->failed)
+    return;
+  uint32_t rel = (uint32_t)(jc->len - (at + 4));
+  memcpy(jc->code + at, &rel, sizeof(rel));
+}
+
+/*
+ * =================================================================
+ * --- 槽位访问模板 (Slot Templates) ---
+ * =================================================================
+ */
+
+/**
+ * @brief reg = 槽位载荷的低 width 位 (sign: 符号扩展；否则零扩展)
+ *
+ * width 为 1 / 8 / 16 / 32 / 64。i1 总是零扩展 (解释器把 i1 当作 0 / 1)。
+ */
+static void
+emit_load_payload(JitCompiler *jc, int reg, ExecSlot slot, unsigned width, bool sign)
+{
+  switch (width)
+  {
+  case 64:
+    EMIT(jc, 0x48, 0x8B); /// mov r64, m64
+    break;
+  case 32:
+    if (sign)
+      EMIT(jc, 0x48, 0x63); /// movsxd r64, m32
+    else
+      EMIT(jc, 0x8B); /// mov r32, m32
+    break;
+  case 16:
+    if (sign)
+      EMIT(jc, 0x48, 0x0F, 0xBF); /// movsx r64, m16
+    else
+      EMIT(jc, 0x0F, 0xB7); /// movzx r32, m16
+    break;
+  default:
+    if (sign && width == 8)
+      EMIT(jc, 0x48, 0x0F, 0xBE); /// movsx r64, m8
+    else
+      EMIT(jc, 0x0F, 0xB6); /// movzx r32, m8
+    break;
+  }
+  emit_slot_modrm(jc, reg, SLOT_PAYLOAD_DISP(slot));
+}
+
+/**
+ * @brief 把 rax 的低 width 位零扩展后写入结果槽位，并设置它的 kind
+ *
+ * 与解释器一致: 先清零整个载荷再写入窄值。
+ */
+static void
+emit_store_result(JitCompiler *jc, ExecSlot slot, unsigned width, RuntimeValueKind kind)
+{
+  switch (width)
+  {
+  case 1:
+    EMIT(jc, 0x83, 0xE0, 0x01); /// and eax, 1
+    break;
+  case 8:
+    EMIT(jc, 0x0F, 0xB6, 0xC0); /// movzx eax, al
+    break;
+  case 16:
+    EMIT(jc, 0x0F, 0xB7, 0xC0); /// movzx eax, ax
+    break;
+  case 32:
+    EMIT(jc, 0x89, 0xC0); /// mov eax, eax
+    break;
+  default:
+    break;
+  }
+  EMIT(jc, 0x48, 0x89); /// mov m64, rax
+  emit_slot_modrm(jc, JIT_RAX, SLOT_PAYLOAD_DISP(slot));
+  EMIT(jc, 0xC7); /// mov m32, imm32
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(slot));
+  emit_u32(jc, (uint32_t)kind);
+}
+
+/**
+ * @brief 整个槽位 (kind + 载荷) 的复制: dst = src
+ */
+static void
+emit_copy_slot(JitCompiler *jc, ExecSlot dst, ExecSlot src)
+{
+  EMIT(jc, 0x0F, 0x10); /// movups xmm0, [src]
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(src));
+  EMIT(jc, 0x0F, 0x11); /// movups [dst], xmm0
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(dst));
+}
+
+/**
+ * @brief 比较 i1 槽位是否为真 (之后 NE 表示真)
+ */
+static void
+emit_test_bool(JitCompiler *jc, ExecSlot slot)
+{
+  EMIT(jc, 0x80); /// cmp m8, 0
+  emit_slot_modrm(jc, 7, SLOT_PAYLOAD_DISP(slot));
+  EMIT(jc, 0x00);
+}
+
+/**
+ * @brief 调用 fn(ctx, ei) (返回值在 eax)
+ */
+static void
+emit_helper_call(JitCompiler *jc, uintptr_t fn, const ExecInst *ei)
+{
+  EMIT(jc, 0x4C, 0x89, 0xE7); /// mov rdi, r12
+  EMIT(jc, 0x48, 0xBE);       /// mov rsi, imm64
+  emit_u64(jc, (uint64_t)(uintptr_t)ei);
+  EMIT(jc, 0x48, 0xB8); /// mov rax, imm64
+  emit_u64(jc, (uint64_t)fn);
+  EMIT(jc, 0xFF, 0xD0); /// call rax
+}
+
+/*
+ * =================================================================
+ * --- 类型辅助 (Type Helpers) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 整数 (或指针) 类型的位宽；不是可内联的标量整数时返回 0
+ */
+static unsigned
+jit_int_width(const JitCompiler *jc, IRType *type)
+{
+  switch (type->kind)
+  {
+  case IR_TYPE_I1:
+    return 1;
+  case IR_TYPE_I8:
+    return 8;
+  case IR_TYPE_I16:
+    return 16;
+  case IR_TYPE_I32:
+    return 32;
+  case IR_TYPE_I64:
+    return 64;
+  case IR_TYPE_PTR:
+    return (datalayout_get_pointer_size(jc->dl) == 8) ? 64 : 0;
+  default:
+    return 0;
+  }
+}
+
+static RuntimeValueKind
+jit_runtime_kind(IRType *type)
+{
+  switch (type->kind)
+  {
+  case IR_TYPE_I1:
+    return RUNTIME_VAL_I1;
+  case IR_TYPE_I8:
+    return RUNTIME_VAL_I8;
+  case IR_TYPE_I16:
+    return RUNTIME_VAL_I16;
+  case IR_TYPE_I32:
+    return RUNTIME_VAL_I32;
+  case IR_TYPE_I64:
+    return RUNTIME_VAL_I64;
+  case IR_TYPE_F32:
+    return RUNTIME_VAL_F32;
+  case IR_TYPE_F64:
+    return RUNTIME_VAL_F64;
+  case IR_TYPE_PTR:
+    return RUNTIME_VAL_PTR;
+  default:
+    return RUNTIME_VAL_UNDEF;
+  }
+}
+
+static inline IRType *
+operand_type(const ExecInst *ei, uint32_t i)
+{
+  return ir_instruction_get_operand(ei->ir, i)->type;
+}
+
+/*
+ * =================================================================
+ * --- 指令模板 (Instruction Templates) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 没有模板的指令: 调用解释器的辅助函数，出错时直接返回其状态
+ */
+static void
+emit_generic(JitCompiler *jc, const ExecInst *ei)
+{
+  emit_helper_call(jc, (uintptr_t)jc->helpers->execute, ei);
+  EMIT(jc, 0x85, 0xC0); /// test eax, eax
+  emit_jcc(jc, JIT_CC_NE, JIT_EXIT_LABEL);
+}
+
+/**
+ * @brief 沿一条边跳转: PHI 复制 + jmp 目标块
+ *
+ * @param at_block_end 这是块的最后一段代码 (目标是下一个块时直接落入)
+ */
+static void
+emit_take_edge(JitCompiler *jc, uint32_t edge_index, bool at_block_end)
+{
+  const ExecEdge *edge = &jc->plan->edges[edge_index];
+  const ExecCopy *copies = &jc->plan->copies[edge->first_copy];
+  for (uint32_t i = 0; i < edge->num_copies; i++)
+  {
+    emit_copy_slot(jc, copies[i].dst, copies[i].src);
+  }
+  if (!at_block_end || edge->target != jc->next_block)
+    emit_jmp(jc, edge->target);
+}
+
+/**
+ * @brief 条件分支 (标志位已设置好，cc 成立时走 true_edge)
+ */
+static void
+emit_branch_on(JitCompiler *jc, uint8_t cc, uint32_t true_edge, uint32_t false_edge)
+{
+  const ExecEdge *t = &jc->plan->edges[true_edge];
+  if (t->num_copies == 0)
+  {
+    emit_jcc(jc, cc, t->target);
+    emit_take_edge(jc, false_edge, true);
+    return;
+  }
+
+  size_t to_false = emit_forward_jcc(jc, cc ^ 1);
+  emit_take_edge(jc, true_edge, false);
+  patch_here(jc, to_false);
+  emit_take_edge(jc, false_edge, true);
+}
+
+/**
+ * @brief icmp 的比较部分 (cmp rax, rcx)；返回谓词对应的条件码，不支持的类型返回 0
+ */
+static uint8_t
+emit_icmp_flags(JitCompiler *jc, const ExecInst *ei)
+{
+  unsigned width = jit_int_width(jc, operand_type(ei, 0));
+  if (width == 0)
+    return 0;
+
+  static const uint8_t cc_table[] = {
+    [IR_ICMP_EQ] = JIT_CC_E,   [IR_ICMP_NE] = JIT_CC_NE,  [IR_ICMP_UGT] = JIT_CC_A, [IR_ICMP_UGE] = JIT_CC_AE,
+    [IR_ICMP_ULT] = JIT_CC_B,  [IR_ICMP_ULE] = JIT_CC_BE, [IR_ICMP_SGT] = JIT_CC_G, [IR_ICMP_SGE] = JIT_CC_GE,
+    [IR_ICMP_SLT] = JIT_CC_L,  [IR_ICMP_SLE] = JIT_CC_LE,
+  };
+  IRICmpPredicate pred = ei->ir->as.icmp.predicate;
+  bool sign = (pred >= IR_ICMP_SGT);
+
+  emit_load_payload(jc, JIT_RAX, ei->operands[0], width, sign);
+  emit_load_payload(jc, JIT_RCX, ei->operands[1], width, sign);
+  EMIT(jc, 0x48, 0x39, 0xC8); /// cmp rax, rcx
+  return cc_table[pred];
+}
+
+static bool
+emit_int_binary(JitCompiler *jc, const ExecInst *ei)
+{
+  IRType *type = ei->ir->result.type;
+  unsigned width = jit_int_width(jc, type);
+  if (width == 0 || type->kind == IR_TYPE_PTR)
+    return false;
+
+  uint32_t opcode = ei->ir->opcode;
+  emit_load_payload(jc, JIT_RAX, ei->operands[0], width, opcode == IR_OP_ASHR);
+  emit_load_payload(jc, JIT_RCX, ei->operands[1], width, false);
+
+  switch (opcode)
+  {
+  case IR_OP_ADD:
+    EMIT(jc, 0x48, 0x01, 0xC8); /// add rax, rcx
+    break;
+  case IR_OP_SUB:
+    EMIT(jc, 0x48, 0x29, 0xC8); /// sub rax, rcx
+    break;
+  case IR_OP_MUL:
+    EMIT(jc, 0x48, 0x0F, 0xAF, 0xC1); /// imul rax, rcx
+    break;
+  case IR_OP_AND:
+    EMIT(jc, 0x48, 0x21, 0xC8); /// and rax, rcx
+    break;
+  case IR_OP_OR:
+    EMIT(jc, 0x48, 0x09, 0xC8); /// or rax, rcx
+    break;
+  case IR_OP_XOR:
+    EMIT(jc, 0x48, 0x31, 0xC8); /// xor rax, rcx
+    break;
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR: {
+    /// 与解释器一致: 移位量对位宽取模 (64 位时 x86 自己会对 63 取模)
+    if (width < 64)
+      EMIT(jc, 0x83, 0xE1, (uint8_t)(width - 1)); /// and ecx, width - 1
+    uint8_t ext = (opcode == IR_OP_SHL) ? 0xE0 : (opcode == IR_OP_LSHR) ? 0xE8 : 0xF8;
+    EMIT(jc, 0x48, 0xD3, ext); /// shl / shr / sar rax, cl
+    break;
+  }
+  default:
+    return false;
+  }
+
+  emit_store_result(jc, ei->result, width, jit_runtime_kind(type));
+  return true;
+}
+
+static bool
+emit_float_binary(JitCompiler *jc, const ExecInst *ei)
+{
+  IRType *type = ei->ir->result.type;
+  uint32_t opcode = ei->ir->opcode;
+  if ((type->kind != IR_TYPE_F32 && type->kind != IR_TYPE_F64) || opcode == IR_OP_FDIV)
+    return false;
+
+  /// 与解释器一致: f32 先提升为 f64 计算，再舍入回 f32
+  bool is_f32 = (type->kind == IR_TYPE_F32);
+  for (int reg = 0; reg < 2; reg++)
+  {
+    if (is_f32)
+      EMIT(jc, 0xF3, 0x0F, 0x5A); /// cvtss2sd xmm, m32
+    else
+      EMIT(jc, 0xF2, 0x0F, 0x10); /// movsd xmm, m64
+    emit_slot_modrm(jc, reg, SLOT_PAYLOAD_DISP(ei->operands[reg]));
+  }
+
+  uint8_t op = (opcode == IR_OP_FADD) ? 0x58 : (opcode == IR_OP_FSUB) ? 0x5C : 0x59;
+  EMIT(jc, 0xF2, 0x0F, op, 0xC1); /// addsd / subsd / mulsd xmm0, xmm1
+
+  if (is_f32)
+  {
+    EMIT(jc, 0xF2, 0x0F, 0x5A, 0xC0); /// cvtsd2ss xmm0, xmm0
+    EMIT(jc, 0x66, 0x0F, 0x7E, 0xC0); /// movd eax, xmm0
+  }
+  else
+  {
+    EMIT(jc, 0x66, 0x48, 0x0F, 0x7E, 0xC0); /// movq rax, xmm0
+  }
+  emit_store_result(jc, ei->result, 64, is_f32 ? RUNTIME_VAL_F32 : RUNTIME_VAL_F64);
+  return true;
+}
+
+static bool
+emit_int_cast(JitCompiler *jc, const ExecInst *ei)
+{
+  IRType *src_type = operand_type(ei, 0);
+  IRType *dst_type = ei->ir->result.type;
+  unsigned src_width = jit_int_width(jc, src_type);
+  unsigned dst_width = jit_int_width(jc, dst_type);
+  if (src_width == 0 || dst_width == 0 || src_type->kind == IR_TYPE_PTR || dst_type->kind == IR_TYPE_PTR)
+    return false;
+
+  emit_load_payload(jc, JIT_RAX, ei->operands[0], src_width, ei->ir->opcode == IR_OP_SEXT);
+  emit_store_result(jc, ei->result, dst_width, jit_runtime_kind(dst_type));
+  return true;
+}
+
+/**
+ * @brief 标量 load / store 的字节数 (1 / 2 / 4 / 8)；其他类型返回 0
+ */
+static size_t
+jit_scalar_size(const JitCompiler *jc, IRType *type)
+{
+  if (jit_runtime_kind(type) == RUNTIME_VAL_UNDEF)
+    return 0;
+  size_t size = datalayout_get_type_size(jc->dl, type);
+  return (size == 1 || size == 2 || size == 4 || size == 8) ? size : 0;
+}
+
+static bool
+emit_load(JitCompiler *jc, const ExecInst *ei)
+{
+  IRType *type = ei->ir->result.type;
+  size_t size = jit_scalar_size(jc, type);
+  if (size == 0)
+    return false;
+
+  emit_load_payload(jc, JIT_RAX, ei->operands[0], 64, false);
+  /// 与 memcpy 进清零的载荷一致: 零扩展载入
+  switch (size)
+  {
+  case 1:
+    EMIT(jc, 0x0F, 0xB6, 0x00); /// movzx eax, byte [rax]
+    break;
+  case 2:
+    EMIT(jc, 0x0F, 0xB7, 0x00); /// movzx eax, word [rax]
+    break;
+  case 4:
+    EMIT(jc, 0x8B, 0x00); /// mov eax, [rax]
+    break;
+  default:
+    EMIT(jc, 0x48, 0x8B, 0x00); /// mov rax, [rax]
+    break;
+  }
+  emit_store_result(jc, ei->result, 64, jit_runtime_kind(type));
+  return true;
+}
+
+static bool
+emit_store(JitCompiler *jc, const ExecInst *ei)
+{
+  size_t size = jit_scalar_size(jc, operand_type(ei, 0));
+  if (size == 0)
+    return false;
+
+  emit_load_payload(jc, JIT_RAX, ei->operands[1], 64, false);
+  emit_load_payload(jc, JIT_RCX, ei->operands[0], 64, false);
+  switch (size)
+  {
+  case 1:
+    EMIT(jc, 0x88, 0x08); /// mov [rax], cl
+    break;
+  case 2:
+    EMIT(jc, 0x66, 0x89, 0x08); /// mov [rax], cx
+    break;
+  case 4:
+    EMIT(jc, 0x89, 0x08); /// mov [rax], ecx
+    break;
+  default:
+    EMIT(jc, 0x48, 0x89, 0x08); /// mov [rax], rcx
+    break;
+  }
+  return true;
+}
+
+/**
+ * @brief gep: 使用构建计划时解析好的地址 (ExecGep)，常量偏移一次加上，变量下标用 imul 累加
+ *
+ * 没有解析结果的 gep (OOM 或下标不符合源类型) 交给辅助函数逐个下标计算。
+ */
+static bool
+emit_gep(JitCompiler *jc, const ExecInst *ei)
+{
+  if (jit_int_width(jc, ei->ir->result.type) != 64 || ei->aux == EXEC_INVALID_INDEX)
+    return false;
+
+  /// 先检查所有变量下标，避免生成一半再退回辅助函数
+  const ExecGep *gep = &jc->plan->geps[ei->aux];
+  for (uint32_t i = 0; i < gep->num_terms; i++)
+  {
+    if (jit_int_width(jc, operand_type(ei, gep->terms[i].operand)) == 0)
+      return false;
+  }
+
+  emit_load_payload(jc, JIT_RAX, ei->operands[0], 64, false);
+
+  for (uint32_t i = 0; i < gep->num_terms; i++)
+  {
+    uint32_t op = gep->terms[i].operand;
+    uint64_t scale = gep->terms[i].scale;
+    emit_load_payload(jc, JIT_RCX, ei->operands[op], jit_int_width(jc, operand_type(ei, op)), true);
+    if (scale <= INT32_MAX)
+    {
+      EMIT(jc, 0x48, 0x69, 0xC9); /// imul rcx, rcx, imm32
+      emit_u32(jc, (uint32_t)scale);
+    }
+    else
+    {
+      EMIT(jc, 0x48, 0xBA); /// mov rdx, imm64
+      emit_u64(jc, scale);
+      EMIT(jc, 0x48, 0x0F, 0xAF, 0xCA); /// imul rcx, rdx
+    }
+    EMIT(jc, 0x48, 0x01, 0xC8); /// add rax, rcx
+  }
+
+  uint64_t offset = (uint64_t)gep->offset;
+  if (offset != 0)
+  {
+    if ((int64_t)offset >= INT32_MIN && (int64_t)offset <= INT32_MAX)
+    {
+      EMIT(jc, 0x48, 0x05); /// add rax, imm32
+      emit_u32(jc, (uint32_t)offset);
+    }
+    else
+    {
+      EMIT(jc, 0x48, 0xB9); /// mov rcx, imm64
+      emit_u64(jc, offset);
+      EMIT(jc, 0x48, 0x01, 0xC8); /// add rax, rcx
+    }
+  }
+  emit_store_result(jc, ei->result, 64, RUNTIME_VAL_PTR);
+  return true;
+}
+
+static void
+emit_select(JitCompiler *jc, const ExecInst *ei)
+{
+  emit_test_bool(jc, ei->operands[0]);
+  EMIT(jc, 0x0F, 0x10); /// movups xmm0, [false]
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(ei->operands[2]));
+  size_t skip = emit_forward_jcc(jc, JIT_CC_E);
+  EMIT(jc, 0x0F, 0x10); /// movups xmm0, [true]
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(ei->operands[1]));
+  patch_here(jc, skip);
+  EMIT(jc, 0x0F, 0x11); /// movups [result], xmm0
+  emit_slot_modrm(jc, 0, SLOT_KIND_DISP(ei->result));
+}
+
+static void
+emit_ret(JitCompiler *jc, const ExecInst *ei)
+{
+  if (ei->num_operands > 0)
+  {
+    EMIT(jc, 0x0F, 0x10); /// movups xmm0, [slot]
+    emit_slot_modrm(jc, 0, SLOT_KIND_DISP(ei->operands[0]));
+    EMIT(jc, 0x41, 0x0F, 0x11, 0x45, 0x00); /// movups [r13], xmm0
+  }
+  else
+  {
+    EMIT(jc, 0x41, 0xC7, 0x45, 0x00); /// mov dword [r13], RUNTIME_VAL_UNDEF
+    emit_u32(jc, RUNTIME_VAL_UNDEF);
+    EMIT(jc, 0x49, 0xC7, 0x45, 0x08); /// mov qword [r13 + 8], 0
+    emit_u32(jc, 0);
+  }
+  EMIT(jc, 0x31, 0xC0); /// xor eax, eax
+  emit_jmp(jc, JIT_EXIT_LABEL);
+}
+
+/**
+ * @brief switch: 辅助函数求出目标边，再逐条比较边编号
+ */
+static void
+emit_switch(JitCompiler *jc, const ExecInst *ei)
+{
+  const ExecSwitch *sw = &jc->plan->switches[ei->aux];
+  emit_helper_call(jc, (uintptr_t)jc->helpers->switch_edge, ei);
+
+  for (uint32_t i = 2; i + 1 < ei->num_operands; i += 2)
+  {
+    uint32_t edge_index = ei->operands[i + 1];
+    if (edge_index == sw->default_edge)
+      continue;
+
+    const ExecEdge *edge = &jc->plan->edges[edge_index];
+    EMIT(jc, 0x3D); /// cmp eax, imm32
+    emit_u32(jc, edge_index);
+    if (edge->num_copies == 0)
+    {
+      emit_jcc(jc, JIT_CC_E, edge->target);
+      continue;
+    }
+    size_t skip = emit_forward_jcc(jc, JIT_CC_NE);
+    emit_take_edge(jc, edge_index, false);
+    patch_here(jc, skip);
+  }
+  emit_take_edge(jc, sw->default_edge, true);
+}
+
+/**
+ * @brief 翻译 insts[k] (返回本次消耗的指令数)
+ */
+static uint32_t
+emit_inst(JitCompiler *jc, uint32_t k)
+{
+  const ExecInst *ei = &jc->plan->insts[k];
+
+  /// icmp + cond_br: 直接用标志位分支，不写比较结果
+  if (ei->opcode == EXEC_OP_ICMP_BR)
+  {
+    uint8_t cc = emit_icmp_flags(jc, ei);
+    if (cc != 0)
+    {
+      const ExecInst *br = ei + 1;
+      emit_branch_on(jc, cc, br->operands[1], br->operands[2]);
+      return 2;
+    }
+  }
+
+  /// 其余超级指令按组内的原始指令逐条翻译 (每条都有自己的操作数和结果槽位)
+  bool done = false;
+  switch (ei->ir->opcode)
+  {
+  case IR_OP_RET:
+    emit_ret(jc, ei);
+    return 1;
+  case IR_OP_BR:
+    emit_take_edge(jc, ei->operands[0], true);
+    return 1;
+  case IR_OP_COND_BR:
+    emit_test_bool(jc, ei->operands[0]);
+    emit_branch_on(jc, JIT_CC_NE, ei->operands[1], ei->operands[2]);
+    return 1;
+  case IR_OP_SWITCH:
+    emit_switch(jc, ei);
+    return 1;
+
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+    done = emit_int_binary(jc, ei);
+    break;
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+    done = emit_float_binary(jc, ei);
+    break;
+  case IR_OP_ICMP: {
+    uint8_t cc = emit_icmp_flags(jc, ei);
+    if (cc != 0)
+    {
+      EMIT(jc, 0x0F, (uint8_t)(0x90 | cc), 0xC0); /// setcc al
+      EMIT(jc, 0x0F, 0xB6, 0xC0);                 /// movzx eax, al
+      emit_store_result(jc, ei->result, 64, RUNTIME_VAL_I1);
+      done = true;
+    }
+    break;
+  }
+  case IR_OP_SELECT:
+    emit_select(jc, ei);
+    done = true;
+    break;
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+    done = emit_int_cast(jc, ei);
+    break;
+  case IR_OP_LOAD:
+    done = emit_load(jc, ei);
+    break;
+  case IR_OP_STORE:
+    done = emit_store(jc, ei);
+    break;
+  case IR_OP_GEP:
+    done = emit_gep(jc, ei);
+    break;
+  default:
+    break;
+  }
+
+  if (!done)
+    emit_generic(jc, ei);
+  return 1;
+}
+
+/*
+ * =================================================================
+ * --- 公共 API ---
+ * =================================================================
+ */
+
+JitCode *
+jit_compile(const ExecPlan *plan, const DataLayout *dl, const JitHelpers *helpers)
+{
+  assert(plan != NULL && dl != NULL && helpers != NULL);
+  if (plan->num_slots > JIT_MAX_SLOTS)
+    return NULL;
+
+  Bump scratch;
+  bump_init(&scratch);
+
+  JitCompiler jc = {
+    .arena = &scratch,
+    .plan = plan,
+    .dl = dl,
+    .helpers = helpers,
+    .capacity = 256 + (size_t)plan->num_insts * 32,
+    .fixup_capacity = 16 + (size_t)plan->num_edges * 2,
+  };
+  jc.code = BUMP_ALLOC_SLICE(&scratch, uint8_t, jc.capacity);
+  jc.fixups = BUMP_ALLOC_SLICE(&scratch, JitFixup, jc.fixup_capacity);
+  jc.block_offsets = BUMP_ALLOC_SLICE(&scratch, size_t, plan->num_blocks);
+  jc.failed = !jc.code || !jc.fixups || !jc.block_offsets;
+
+  /// 序言: 保存被调者保存寄存器 (三次 push 之后 rsp 恰好 16 字节对齐)
+  EMIT(&jc, 0x53);             /// push rbx
+  EMIT(&jc, 0x41, 0x54);       /// push r12
+  EMIT(&jc, 0x41, 0x55);       /// push r13
+  EMIT(&jc, 0x48, 0x89, 0xF3); /// mov rbx, rsi
+  EMIT(&jc, 0x49, 0x89, 0xFC); /// mov r12, rdi
+  EMIT(&jc, 0x49, 0x89, 0xD5); /// mov r13, rdx
+
+  /// 入口块总是 0 号块，按块编号顺序排布代码
+  for (uint32_t b = 0; b < plan->num_blocks && !jc.failed; b++)
+  {
+    const ExecBlock *block = &plan->blocks[b];
+    jc.block_offsets[b] = jc.len;
+    jc.next_block = b + 1;
+    uint32_t end = block->first_inst + block->num_insts;
+    for (uint32_t k = block->first_inst + block->num_phis; k < end;)
+    {
+      k += emit_inst(&jc, k);
+    }
+  }
+
+  jc.exit_offset = jc.len;
+  EMIT(&jc, 0x41, 0x5D); /// pop r13
+  EMIT(&jc, 0x41, 0x5C); /// pop r12
+  EMIT(&jc, 0x5B);       /// pop rbx
+  EMIT(&jc, 0xC3);       /// ret
+
+  JitCode *code = NULL;
+  if (!jc.failed)
+  {
+    for (size_t i = 0; i < jc.num_fixups; i++)
+    {
+      const JitFixup *fx = &jc.fixups[i];
+      size_t target = (fx->target == JIT_EXIT_LABEL) ? jc.exit_offset : jc.block_offsets[fx->target];
+      uint32_t rel = (uint32_t)(target - (fx->at + 4));
+      memcpy(jc.code + fx->at, &rel, sizeof(rel));
+    }
+
+    /// W^X: 在可写映射中写好代码，再改为只读可执行
+    void *memory = mmap(NULL, jc.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    code = (memory != MAP_FAILED) ? (JitCode *)malloc(sizeof(JitCode)) : NULL;
+    if (code)
+    {
+      memcpy(memory, jc.code, jc.len);
+      if (mprotect(memory, jc.len, PROT_READ | PROT_EXEC) == 0)
+      {
+        code->memory = memory;
+        code->size = jc.len;
+        code->next = NULL;
+        /// 对象指针到函数指针的转换 (POSIX 保证可用)
+        memcpy(&code->entry, &memory, sizeof(code->entry));
+      }
+      else
+      {
+        free(code);
+        code = NULL;
+      }
+    }
+    if (!code && memory != MAP_FAILED)
+      munmap(memory, jc.len);
+  }
+
+  bump_destroy(&scratch);
+  return code;
+}
+
+void
+jit_code_free(JitCode *code)
+{
+  if (!code)
+    return;
+  munmap(code->memory, code->size);
+  free(code);
+}
+
+#else /* !CALICO_HAS_JIT */
+
+JitCode *
+jit_compile(const ExecPlan *plan, const DataLayout *dl, const JitHelpers *helpers)
+{
+  (void)plan;
+  (void)dl;
+  (void)helpers;
+  return NULL;
+}
+
+void
+jit_code_free(JitCode *code)
+{
+  (void)code;
+}
+
+#endif /* CALICO_HAS_JIT */
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/scheduler.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if CALICO_HAS_SCHEDULER
+
+#include <threads.h>
+
+struct InterpreterScheduler
+{
+  Interpreter *interp;
+  uint64_t quantum;
+  InterpreterSchedulerCallback on_complete;
+  void *user_data;
+
+  /** 保护以下所有字段 */
+  mtx_t lock;
+  /** 队列变为非空或开始关闭时通知 */
+  cnd_t work_ready;
+  /** pending 降为 0 时通知 */
+  cnd_t all_done;
+
+  /** 就绪队列 (通过 InterpreterExecution::next 串起来的 FIFO) */
+  InterpreterExecution *head;
+  InterpreterExecution *tail;
+  /** 已提交但还没有结束的执行数 (包括正在被某个线程推进的) */
+  size_t pending;
+  bool shutting_down;
+
+  size_t num_threads;
+  thrd_t *threads;
+};
+
+/*
+ * =================================================================
+ * --- 就绪队列 (调用者持有 lock) ---
+ * =================================================================
+ */
+
+static void
+queue_push(InterpreterScheduler *sched, InterpreterExecution *exec)
+{
+  exec->next = NULL;
+  if (sched->tail)
+    sched->tail->next = exec;
+  else
+    sched->head = exec;
+  sched->tail = exec;
+}
+
+static InterpreterExecution *
+queue_pop(InterpreterScheduler *sched)
+{
+  InterpreterExecution *exec = sched->head;
+  sched->head = exec->next;
+  if (!sched->head)
+    sched->tail = NULL;
+  exec->next = NULL;
+  return exec;
+}
+
+/*
+ * =================================================================
+ * --- 工作线程 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 工作线程主循环: 取出一个执行，推进一个时间片，没结束就放回队尾
+ */
+static int
+scheduler_worker_main(void *opaque)
+{
+  InterpreterScheduler *sched = opaque;
+
+  mtx_lock(&sched->lock);
+  for (;;)
+  {
+    while (!sched->head && !sched->shutting_down)
+    {
+      cnd_wait(&sched->work_ready, &sched->lock);
+    }
+    if (sched->shutting_down)
+      break;
+
+    InterpreterExecution *exec = queue_pop(sched);
+    mtx_unlock(&sched->lock);
+
+    /// 推进期间不持有锁 (封存后的解释器可以被多个执行并发使用)
+    ExecutionResultKind status = interpreter_execution_step(exec, sched->quantum);
+    if (status != EXEC_RUNNING && sched->on_complete)
+    {
+      /// 回调之后不再访问 exec (回调可能已经销毁了它)
+      sched->on_complete(exec, sched->user_data);
+    }
+
+    mtx_lock(&sched->lock);
+    if (status == EXEC_RUNNING)
+    {
+      queue_push(sched, exec);
+    }
+    else if (--sched->pending == 0)
+    {
+      cnd_broadcast(&sched->all_done);
+    }
+  }
+  mtx_unlock(&sched->lock);
+  return 0;
+}
+
+/**
+ * @brief 通知并回收前 count 个工作线程
+ */
+static void
+scheduler_join_threads(InterpreterScheduler *sched, size_t count)
+{
+  mtx_lock(&sched->lock);
+  sched->shutting_down = true;
+  cnd_broadcast(&sched->work_ready);
+  mtx_unlock(&sched->lock);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    thrd_join(sched->threads[i], NULL);
+  }
+}
+
+/*
+ * =================================================================
+ * --- 公共 API (Public API) ---
+ * =================================================================
+ */
+
+InterpreterScheduler *
+interpreter_scheduler_create(Interpreter *interp, size_t num_threads, uint64_t quantum,
+                             InterpreterSchedulerCallback on_complete, void *user_data)
+{
+  assert(interp != NULL && num_threads > 0);
+
+  /// 未封存的解释器会在执行期间惰性修改计划缓存，不能被多个线程共享
+  if (!interp->sealed)
+    return NULL;
+
+  InterpreterScheduler *sched = (InterpreterScheduler *)calloc(1, sizeof(InterpreterScheduler));
+  if (!sched)
+    return NULL;
+  sched->threads = (thrd_t *)malloc(sizeof(thrd_t) * num_threads);
+  if (!sched->threads)
+  {
+    free(sched);
+    return NULL;
+  }
+
+  if (mtx_init(&sched->lock, mtx_plain) != thrd_success)
+  {
+    free(sched->threads);
+    free(sched);
+    return NULL;
+  }
+  if (cnd_init(&sched->work_ready) != thrd_success)
+  {
+    mtx_destroy(&sched->lock);
+    free(sched->threads);
+    free(sched);
+    return NULL;
+  }
+  if (cnd_init(&sched->all_done) != thrd_success)
+  {
+    cnd_destroy(&sched->work_ready);
+    mtx_destroy(&sched->lock);
+    free(sched->threads);
+    free(sched);
+    return NULL;
+  }
+
+  sched->interp = interp;
+  sched->quantum = quantum ? quantum : INTERP_SCHEDULER_DEFAULT_QUANTUM;
+  sched->on_complete = on_complete;
+  sched->user_data = user_data;
+  sched->num_threads = num_threads;
+
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    if (thrd_create(&sched->threads[i], scheduler_worker_main, sched) != thrd_success)
+    {
+      /// 回收已经启动的线程
+      sched->num_threads = i;
+      interpreter_scheduler_destroy(sched);
+      return NULL;
+    }
+  }
+  return sched;
+}
+
+void
+interpreter_scheduler_submit(InterpreterScheduler *sched, InterpreterExecution *exec)
+{
+  assert(sched != NULL && exec != NULL);
+  assert(exec->interp == sched->interp && "Scheduler: execution belongs to another interpreter");
+
+  mtx_lock(&sched->lock);
+  queue_push(sched, exec);
+  sched->pending++;
+  cnd_signal(&sched->work_ready);
+  mtx_unlock(&sched->lock);
+}
+
+void
+interpreter_scheduler_wait(InterpreterScheduler *sched)
+{
+  assert(sched != NULL);
+  mtx_lock(&sched->lock);
+  while (sched->pending > 0)
+  {
+    cnd_wait(&sched->all_done, &sched->lock);
+  }
+  mtx_unlock(&sched->lock);
+}
+
+void
+interpreter_scheduler_destroy(InterpreterScheduler *sched)
+{
+  if (!sched)
+    return;
+  scheduler_join_threads(sched, sched->num_threads);
+  cnd_destroy(&sched->all_done);
+  cnd_destroy(&sched->work_ready);
+  mtx_destroy(&sched->lock);
+  free(sched->threads);
+  free(sched);
+}
+
+#else /* !CALICO_HAS_SCHEDULER */
+
+InterpreterScheduler *
+interpreter_scheduler_create(Interpreter *interp, size_t num_threads, uint64_t quantum,
+                             InterpreterSchedulerCallback on_complete, void *user_data)
+{
+  (void)interp;
+  (void)num_threads;
+  (void)quantum;
+  (void)on_complete;
+  (void)user_data;
+  return NULL;
+}
+
+void
+interpreter_scheduler_submit(InterpreterScheduler *sched, InterpreterExecution *exec)
+{
+  (void)sched;
+  (void)exec;
+}
+
+void
+interpreter_scheduler_wait(InterpreterScheduler *sched)
+{
+  (void)sched;
+}
+
+void
+interpreter_scheduler_destroy(InterpreterScheduler *sched)
+{
+  (void)sched;
+}
+
+#endif /* CALICO_HAS_SCHEDULER */
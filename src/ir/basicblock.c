@@ -19,6 +19,7 @@
 #include "ir/function.h"
 #include "ir/instruction.h"
 #include "ir/printer.h"
+#include "ir/use.h"
 #include "utils/bump.h"
 #include "utils/id_list.h"
 
@@ -32,11 +33,12 @@ ir_basic_block_create(IRFunction *func, const char *name)
   assert(func != NULL && "Parent function cannot be NULL");
   IRContext *ctx = func->parent->context;
 
-  IRBasicBlock *bb = (IRBasicBlock *)BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRBasicBlock);
+  IRBasicBlock *bb = (IRBasicBlock *)BUMP_ALLOC_ZEROED(ir_function_body_arena(func), IRBasicBlock);
   if (!bb)
     return NULL;
 
   bb->parent = func;
+  bb->id = -1;
 
   list_init(&bb->list_node);
   list_init(&bb->instructions);
@@ -58,6 +60,83 @@ ir_function_append_basic_block(IRFunction *func, IRBasicBlock *bb)
   assert(bb->parent == func && "Block being added to the wrong function?");
 
   list_add_tail(&func->basic_blocks, &bb->list_node);
+  ir_function_mark_modified(func);
+}
+
+void
+ir_basic_block_erase_from_parent(IRBasicBlock *bb)
+{
+  assert(bb != NULL && bb->parent != NULL);
+
+  /// 逆序删除，块内的使用先于定义消失
+  while (!list_empty(&bb->instructions))
+  {
+    ir_instruction_erase_from_parent(list_entry(bb->instructions.prev, IRInstruction, list_node));
+  }
+  assert(list_empty(&bb->label_address.uses) && "Basic block is still referenced");
+
+  list_del(&bb->list_node);
+  bb->id = -1;
+  ir_function_mark_modified(bb->parent);
+}
+
+IRBasicBlock *
+ir_basic_block_split(IRBasicBlock *bb, IRInstruction *inst, const char *name)
+{
+  assert(bb != NULL && inst != NULL && inst->parent == bb);
+  assert(inst->opcode != IR_OP_PHI && "Cannot split a block in the middle of its phis");
+
+  IRBasicBlock *tail = ir_basic_block_create(bb->parent, name);
+  if (!tail)
+    return NULL;
+  list_add(&bb->list_node, &tail->list_node);
+  ir_function_mark_modified(bb->parent);
+
+  /// 搬过去的指令在新块中重新编号 (tail->order_valid 为 false)；bb 中剩下的顺序不变
+  IDList *iter = &inst->list_node;
+  while (iter != &bb->instructions)
+  {
+    IDList *next = iter->next;
+    list_del(iter);
+    list_add_tail(&tail->instructions, iter);
+    list_entry(iter, IRInstruction, list_node)->parent = tail;
+    iter = next;
+  }
+
+  /// 终结指令现在在 tail 中: 后继的 phi 的入边改为来自 tail
+  IDList *use_iter, *use_next;
+  list_for_each_safe(&bb->label_address.uses, use_iter, use_next)
+  {
+    IRUse *use = list_entry(use_iter, IRUse, value_node);
+    if (use->user->opcode == IR_OP_PHI)
+      ir_use_set_value(use, &tail->label_address);
+  }
+  return tail;
+}
+
+void
+ir_basic_block_instruction_inserted(IRBasicBlock *bb, IRInstruction *inst)
+{
+  ir_function_mark_modified(bb->parent);
+  if (!bb->order_valid)
+    return; /// 下一次查询时整块重新编号
+
+  IDList *prev = inst->list_node.prev;
+  IDList *next = inst->list_node.next;
+  uint64_t lo = (prev == &bb->instructions) ? 0 : list_entry(prev, IRInstruction, list_node)->order;
+  if (next == &bb->instructions)
+  {
+    /// 追加到块尾 (builder 的常见情况)：永远有空隙
+    inst->order = lo + IR_INSTRUCTION_ORDER_STEP;
+    return;
+  }
+  uint64_t hi = list_entry(next, IRInstruction, list_node)->order;
+  if (hi - lo < 2)
+  {
+    bb->order_valid = false;
+    return;
+  }
+  inst->order = lo + (hi - lo) / 2;
 }
 
 /**
@@ -76,7 +155,13 @@ ir_basic_block_dump(IRBasicBlock *bb, IRPrinter *p)
     return;
   }
 
-  ir_printf(p, "$%s:\n", bb->label_address.name);
+  ir_print_name(p, '$', bb->label_address.name);
+  ir_print_char(p, ':');
+  if (p->annotator && p->annotator->annotate_block)
+  {
+    p->annotator->annotate_block(p->annotator->user_data, bb, p);
+  }
+  ir_print_str(p, "\n");
 
   IDList *iter;
   list_for_each(&bb->instructions, iter)
@@ -0,0 +1,1743 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ir/binary.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/function.h"
+#include "ir/global.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/type.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "ir/verifier.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+#include "utils/mapped_file.h"
+#include "utils/string_buf.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+/// 文件头魔数
+static const char BINARY_MAGIC[4] = {'C', 'I', 'R', 'B'};
+
+/**
+ * @brief 操作数引用的种类 (编码在操作数的低 2 位)
+ */
+typedef enum
+{
+  /// 函数内的值：先是参数，然后是所有指令 (按布局顺序)
+  REF_LOCAL = 0,
+  /// 当前函数的基本块
+  REF_BLOCK = 1,
+  /// 常量池
+  REF_CONSTANT = 2,
+  /// 模块级的值：先是全局变量，然后是函数
+  REF_GLOBAL = 3,
+} BinaryRefTag;
+
+/**
+ * @brief [内部] 把 (index + 1) 装进哈希表的 value (NULL 表示 "不存在")
+ */
+static inline void *
+index_to_slot(size_t index)
+{
+  return (void *)(uintptr_t)(index + 1);
+}
+
+static inline bool
+type_is_integer(IRType *ty)
+{
+  return (ty->kind >= IR_TYPE_I1 && ty->kind <= IR_TYPE_I64);
+}
+
+static inline bool
+type_is_floating(IRType *ty)
+{
+  return (ty->kind == IR_TYPE_F32 || ty->kind == IR_TYPE_F64);
+}
+
+/*
+ * =================================================================
+ * --- 写出端 (Writer) ---
+ * =================================================================
+ */
+
+typedef struct
+{
+  IRModule *module;
+  /// 表、哈希表和各个段的缓冲区 (写完后整体释放)
+  Bump scratch;
+  /// 每个函数体的局部编号 (每个函数开始时重置)
+  Bump local_arena;
+
+  StringBuf strings;
+  StringBuf types;
+  StringBuf constants;
+  StringBuf body;
+  /// 当前函数体 (写完后带长度前缀追加到 body)
+  StringBuf function_body;
+  size_t num_strings;
+  size_t num_types;
+  size_t num_constants;
+
+  PtrHashMap *string_ids;
+  PtrHashMap *type_ids;
+  PtrHashMap *constant_ids;
+  PtrHashMap *global_ids;
+  PtrHashMap *local_ids;
+  PtrHashMap *block_ids;
+} BinaryWriter;
+
+static void
+emit_byte(StringBuf *buf, uint8_t byte)
+{
+  char c = (char)byte;
+  string_buf_append_bytes(buf, &c, 1);
+}
+
+static void
+emit_varint(StringBuf *buf, uint64_t value)
+{
+  char tmp[10];
+  size_t len = 0;
+  do
+  {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+    tmp[len++] = (char)byte;
+  } while (value);
+  string_buf_append_bytes(buf, tmp, len);
+}
+
+static void
+emit_svarint(StringBuf *buf, int64_t value)
+{
+  uint64_t bits = (uint64_t)value;
+  emit_varint(buf, (bits << 1) ^ (0 - (bits >> 63)));
+}
+
+static void
+emit_f64(StringBuf *buf, double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  char tmp[8];
+  for (size_t i = 0; i < 8; i++)
+  {
+    tmp[i] = (char)((bits >> (i * 8)) & 0xff);
+  }
+  string_buf_append_bytes(buf, tmp, sizeof(tmp));
+}
+
+/**
+ * @brief [内部] 字符串在字符串表中的下标 (名字都已被 intern，按指针去重)
+ */
+static size_t
+writer_string(BinaryWriter *w, const char *str)
+{
+  void *slot = ptr_hashmap_get(w->string_ids, (void *)str);
+  if (slot)
+    return (uintptr_t)slot - 1;
+
+  size_t len = strlen(str);
+  emit_varint(&w->strings, len);
+  string_buf_append_bytes(&w->strings, str, len);
+
+  ptr_hashmap_put(w->string_ids, (void *)str, index_to_slot(w->num_strings));
+  return w->num_strings++;
+}
+
+/**
+ * @brief [内部] 写出一个可选的名字 (0 表示没有名字，否则是下标 + 1)
+ */
+static void
+emit_opt_string(BinaryWriter *w, StringBuf *buf, const char *str)
+{
+  emit_varint(buf, str ? writer_string(w, str) + 1 : 0);
+}
+
+/**
+ * @brief [内部] 类型在类型表中的下标 (必要时先登记它引用的类型)
+ */
+static size_t
+writer_type(BinaryWriter *w, IRType *type)
+{
+  void *slot = ptr_hashmap_get(w->type_ids, type);
+  if (slot)
+    return (uintptr_t)slot - 1;
+
+  /// 先登记被引用的类型，保证读取时它们已经存在
+  switch (type->kind)
+  {
+  case IR_TYPE_PTR:
+    writer_type(w, type->as.pointee_type);
+    break;
+  case IR_TYPE_ARRAY:
+    writer_type(w, type->as.array.element_type);
+    break;
+  case IR_TYPE_STRUCT:
+    for (size_t i = 0; i < type->as.aggregate.member_count; i++)
+      writer_type(w, type->as.aggregate.member_types[i]);
+    break;
+  case IR_TYPE_FUNCTION:
+    writer_type(w, type->as.function.return_type);
+    for (size_t i = 0; i < type->as.function.param_count; i++)
+      writer_type(w, type->as.function.param_types[i]);
+    break;
+  default:
+    break;
+  }
+
+  StringBuf *buf = &w->types;
+  emit_byte(buf, (uint8_t)type->kind);
+  switch (type->kind)
+  {
+  case IR_TYPE_PTR:
+    emit_varint(buf, writer_type(w, type->as.pointee_type));
+    break;
+  case IR_TYPE_ARRAY:
+    emit_varint(buf, writer_type(w, type->as.array.element_type));
+    emit_varint(buf, type->as.array.element_count);
+    break;
+  case IR_TYPE_STRUCT:
+    emit_opt_string(w, buf, type->as.aggregate.name);
+    emit_varint(buf, type->as.aggregate.member_count);
+    for (size_t i = 0; i < type->as.aggregate.member_count; i++)
+      emit_varint(buf, writer_type(w, type->as.aggregate.member_types[i]));
+    break;
+  case IR_TYPE_FUNCTION:
+    emit_varint(buf, writer_type(w, type->as.function.return_type));
+    emit_byte(buf, type->as.function.is_variadic ? 1 : 0);
+    emit_varint(buf, type->as.function.param_count);
+    for (size_t i = 0; i < type->as.function.param_count; i++)
+      emit_varint(buf, writer_type(w, type->as.function.param_types[i]));
+    break;
+  default:
+    break;
+  }
+
+  ptr_hashmap_put(w->type_ids, type, index_to_slot(w->num_types));
+  return w->num_types++;
+}
+
+/**
+ * @brief [内部] 常量在常量池中的下标
+ */
+static size_t
+writer_constant(BinaryWriter *w, IRConstant *constant)
+{
+  void *slot = ptr_hashmap_get(w->constant_ids, constant);
+  if (slot)
+    return (uintptr_t)slot - 1;
+
+  size_t type_index = writer_type(w, constant->value.type);
+
+  StringBuf *buf = &w->constants;
+  emit_varint(buf, type_index);
+  emit_byte(buf, (uint8_t)constant->const_kind);
+  switch (constant->const_kind)
+  {
+  case CONST_KIND_INT:
+    emit_svarint(buf, constant->data.int_val);
+    break;
+  case CONST_KIND_FLOAT:
+    emit_f64(buf, constant->data.float_val);
+    break;
+  case CONST_KIND_UNDEF:
+    break;
+  }
+
+  ptr_hashmap_put(w->constant_ids, constant, index_to_slot(w->num_constants));
+  return w->num_constants++;
+}
+
+/**
+ * @brief [内部] 写出一个操作数引用
+ * @return false 如果操作数不属于这个模块 (或不属于当前函数)
+ */
+static bool
+writer_operand(BinaryWriter *w, IRValueNode *val)
+{
+  void *slot = NULL;
+  BinaryRefTag tag;
+
+  switch (val->kind)
+  {
+  case IR_KIND_ARGUMENT:
+  case IR_KIND_INSTRUCTION:
+    slot = ptr_hashmap_get(w->local_ids, val);
+    tag = REF_LOCAL;
+    break;
+  case IR_KIND_BASIC_BLOCK:
+    slot = ptr_hashmap_get(w->block_ids, val);
+    tag = REF_BLOCK;
+    break;
+  case IR_KIND_CONSTANT:
+    slot = index_to_slot(writer_constant(w, (IRConstant *)val));
+    tag = REF_CONSTANT;
+    break;
+  case IR_KIND_GLOBAL:
+  case IR_KIND_FUNCTION:
+    slot = ptr_hashmap_get(w->global_ids, val);
+    tag = REF_GLOBAL;
+    break;
+  default:
+    return false;
+  }
+
+  if (!slot)
+  {
+    fprintf(stderr, "Binary IR Error: operand '%s' is not part of module '%s'\n", val->name ? val->name : "<unnamed>",
+            w->module->name);
+    return false;
+  }
+
+  uint64_t index = (uintptr_t)slot - 1;
+  emit_varint(&w->function_body, (index << 2) | tag);
+  return true;
+}
+
+/**
+ * @brief [内部] 写出一个函数体
+ *
+ * 布局: block_count (name, inst_count)* inst_type* inst*
+ */
+static bool
+writer_function_body(BinaryWriter *w, IRFunction *func)
+{
+  StringBuf *buf = &w->function_body;
+  buf->len = 0;
+
+  bump_reset(&w->local_arena);
+  w->local_ids = ptr_hashmap_create(&w->local_arena, 64);
+  w->block_ids = ptr_hashmap_create(&w->local_arena, 16);
+  if (!w->local_ids || !w->block_ids)
+    return false;
+
+  size_t next_local = 0;
+  IDList *iter;
+  list_for_each(&func->arguments, iter)
+  {
+    IRArgument *arg = list_entry(iter, IRArgument, list_node);
+    ptr_hashmap_put(w->local_ids, &arg->value, index_to_slot(next_local++));
+  }
+
+  /// 第一遍：基本块和每块的指令数，同时给所有指令编号
+  size_t num_blocks = 0;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    num_blocks++;
+  }
+  emit_varint(buf, num_blocks);
+
+  size_t block_index = 0;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    ptr_hashmap_put(w->block_ids, &bb->label_address, index_to_slot(block_index++));
+
+    size_t num_insts = 0;
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      ptr_hashmap_put(w->local_ids, &inst->result, index_to_slot(next_local++));
+      num_insts++;
+    }
+
+    emit_varint(buf, writer_string(w, bb->label_address.name));
+    emit_varint(buf, num_insts);
+  }
+
+  /// 第二遍：所有指令的结果类型 (读取端用它们创建前向引用的占位符)
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      emit_varint(buf, writer_type(w, inst->result.type));
+    }
+  }
+
+  /// 第三遍：指令本身
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+
+      emit_byte(buf, (uint8_t)inst->opcode);
+      if (inst->result.type->kind != IR_TYPE_VOID)
+        emit_opt_string(w, buf, inst->result.name);
+
+      switch (inst->opcode)
+      {
+      case IR_OP_ICMP:
+        emit_byte(buf, (uint8_t)inst->as.icmp.predicate);
+        break;
+      case IR_OP_FCMP:
+        emit_byte(buf, (uint8_t)inst->as.fcmp.predicate);
+        break;
+      case IR_OP_GEP:
+        emit_varint(buf, writer_type(w, inst->as.gep.source_type));
+        emit_byte(buf, inst->as.gep.inbounds ? 1 : 0);
+        break;
+      default:
+        break;
+      }
+
+      size_t num_operands = ir_instruction_get_num_operands(inst);
+      emit_varint(buf, num_operands);
+      for (size_t i = 0; i < num_operands; i++)
+      {
+        if (!writer_operand(w, ir_instruction_get_operand(inst, i)))
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief [内部] 写出 module 段 (名字、全局变量、函数头、函数体)
+ */
+static bool
+writer_module(BinaryWriter *w)
+{
+  IRModule *mod = w->module;
+  StringBuf *buf = &w->body;
+
+  /// 和文本打印一样，上下文中所有命名结构体都随模块一起保存
+  StrHashMap *struct_cache = mod->context->named_struct_cache;
+  if (struct_cache)
+  {
+    StrHashMapIter it = str_hashmap_iter(struct_cache);
+    StrHashMapEntry entry;
+    while (str_hashmap_iter_next(&it, &entry))
+    {
+      writer_type(w, (IRType *)entry.value);
+    }
+  }
+
+  emit_varint(buf, writer_string(w, mod->name));
+
+  size_t num_globals = 0;
+  IDList *iter;
+  list_for_each(&mod->globals, iter)
+  {
+    IRGlobalVariable *global = list_entry(iter, IRGlobalVariable, list_node);
+    ptr_hashmap_put(w->global_ids, &global->value, index_to_slot(num_globals++));
+  }
+
+  size_t num_functions = 0;
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    ptr_hashmap_put(w->global_ids, &func->entry_address, index_to_slot(num_globals + num_functions++));
+  }
+
+  emit_varint(buf, num_globals);
+  list_for_each(&mod->globals, iter)
+  {
+    IRGlobalVariable *global = list_entry(iter, IRGlobalVariable, list_node);
+    emit_varint(buf, writer_string(w, global->value.name));
+    emit_varint(buf, writer_type(w, global->allocated_type));
+    emit_varint(buf, global->initializer ? writer_constant(w, (IRConstant *)global->initializer) + 1 : 0);
+  }
+
+  emit_varint(buf, num_functions);
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    emit_varint(buf, writer_string(w, func->entry_address.name));
+    emit_varint(buf, writer_type(w, func->return_type));
+    emit_byte(buf, func->function_type->as.function.is_variadic ? 1 : 0);
+    emit_byte(buf, func->is_declaration ? 1 : 0);
+
+    size_t num_args = 0;
+    IDList *arg_iter;
+    list_for_each(&func->arguments, arg_iter)
+    {
+      num_args++;
+    }
+    emit_varint(buf, num_args);
+    list_for_each(&func->arguments, arg_iter)
+    {
+      IRArgument *arg = list_entry(arg_iter, IRArgument, list_node);
+      emit_opt_string(w, buf, arg->value.name);
+      emit_varint(buf, writer_type(w, arg->value.type));
+    }
+  }
+
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (func->is_declaration)
+      continue;
+    if (!writer_function_body(w, func))
+      return false;
+    emit_varint(buf, w->function_body.len);
+    string_buf_append_bytes(buf, w->function_body.data, w->function_body.len);
+  }
+
+  return true;
+}
+
+const uint8_t *
+ir_binary_write_module(IRModule *mod, Bump *arena, size_t *out_size)
+{
+  assert(mod != NULL && arena != NULL && out_size != NULL);
+
+  BinaryWriter w = {.module = mod};
+  bump_init(&w.scratch);
+  bump_init(&w.local_arena);
+  string_buf_init(&w.strings, &w.scratch);
+  string_buf_init(&w.types, &w.scratch);
+  string_buf_init(&w.constants, &w.scratch);
+  string_buf_init(&w.body, &w.scratch);
+  string_buf_init(&w.function_body, &w.scratch);
+  w.string_ids = ptr_hashmap_create(&w.scratch, 64);
+  w.type_ids = ptr_hashmap_create(&w.scratch, 32);
+  w.constant_ids = ptr_hashmap_create(&w.scratch, 64);
+  w.global_ids = ptr_hashmap_create(&w.scratch, 32);
+
+  const uint8_t *result = NULL;
+  bool ok = w.string_ids && w.type_ids && w.constant_ids && w.global_ids && writer_module(&w);
+
+  if (ok)
+  {
+    StringBuf out;
+    string_buf_init(&out, arena);
+    string_buf_append_bytes(&out, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    emit_varint(&out, IR_BINARY_VERSION);
+    emit_varint(&out, w.num_strings);
+    string_buf_append_bytes(&out, w.strings.data, w.strings.len);
+    emit_varint(&out, w.num_types);
+    string_buf_append_bytes(&out, w.types.data, w.types.len);
+    emit_varint(&out, w.num_constants);
+    string_buf_append_bytes(&out, w.constants.data, w.constants.len);
+    string_buf_append_bytes(&out, w.body.data, w.body.len);
+
+    result = (const uint8_t *)out.data;
+    *out_size = out.len;
+  }
+
+  bump_destroy(&w.local_arena);
+  bump_destroy(&w.scratch);
+  return result;
+}
+
+bool
+ir_binary_write_module_file(IRModule *mod, FILE *stream)
+{
+  assert(stream != NULL);
+
+  Bump arena;
+  bump_init(&arena);
+
+  size_t size = 0;
+  const uint8_t *data = ir_binary_write_module(mod, &arena, &size);
+  bool ok = data && fwrite(data, 1, size, stream) == size;
+
+  bump_destroy(&arena);
+  return ok;
+}
+
+/*
+ * =================================================================
+ * --- 读取端 (Reader) ---
+ * =================================================================
+ */
+
+typedef struct
+{
+  IRContext *context;
+  const uint8_t *start;
+  const uint8_t *pos;
+  const uint8_t *end;
+  bool has_error;
+
+  /// 临时数据 (读完后整体释放)
+  Bump arena;
+  /// 各个表所在的 Arena：通常是 arena；延迟加载时是 IR Arena (物化函数体时还要用)
+  Bump *table_arena;
+  /// 每个函数体的局部表和前向引用占位符 (每个函数开始时重置)
+  Bump local_arena;
+
+  const char **strings;
+  size_t num_strings;
+  IRType **types;
+  size_t num_types;
+  IRValueNode **constants;
+  size_t num_constants;
+  /// 全局变量在前，函数在后 (与写出端的 REF_GLOBAL 编号一致)
+  IRValueNode **globals;
+  size_t num_globals;
+
+  IRModule *module;
+  IRBuilder *builder;
+} BinaryReader;
+
+/**
+ * @brief [内部] 当前函数体的解码状态
+ */
+typedef struct
+{
+  IRBasicBlock **blocks;
+  size_t num_blocks;
+  size_t num_args;
+  /// 参数 + 所有指令；尚未定义的位置为 NULL
+  IRValueNode **locals;
+  /// 前向引用的占位符 (与 locals 同下标)
+  IRValueNode **placeholders;
+  /// 每条指令的结果类型 (下标减去 num_args)
+  IRType **local_types;
+  size_t num_locals;
+} BodyState;
+
+static void
+reader_error(BinaryReader *r, const char *fmt, ...)
+{
+  /// 只报告第一个错误：之后的读取都基于已经失去同步的游标
+  if (r->has_error)
+    return;
+  r->has_error = true;
+
+  fprintf(stderr, "Binary IR Error (offset %zu): ", (size_t)(r->pos - r->start));
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+}
+
+static inline size_t
+reader_remaining(const BinaryReader *r)
+{
+  return (size_t)(r->end - r->pos);
+}
+
+static uint8_t
+read_byte(BinaryReader *r)
+{
+  if (r->has_error)
+    return 0;
+  if (r->pos >= r->end)
+  {
+    reader_error(r, "unexpected end of data");
+    return 0;
+  }
+  return *r->pos++;
+}
+
+static uint64_t
+read_varint(BinaryReader *r)
+{
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    uint8_t byte = read_byte(r);
+    if (r->has_error)
+      return 0;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  reader_error(r, "malformed varint");
+  return 0;
+}
+
+static int64_t
+read_svarint(BinaryReader *r)
+{
+  uint64_t bits = read_varint(r);
+  return (int64_t)((bits >> 1) ^ (0 - (bits & 1)));
+}
+
+static double
+read_f64(BinaryReader *r)
+{
+  if (r->has_error)
+    return 0.0;
+  if (reader_remaining(r) < 8)
+  {
+    reader_error(r, "unexpected end of data");
+    return 0.0;
+  }
+  uint64_t bits = 0;
+  for (size_t i = 0; i < 8; i++)
+  {
+    bits |= (uint64_t)r->pos[i] << (i * 8);
+  }
+  r->pos += 8;
+
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief [内部] 读取一个元素个数
+ *
+ * 每个元素至少占一个字节，所以个数不可能超过剩余字节数；
+ * 这保证了损坏的个数不会让读取端分配巨大的表。
+ */
+static size_t
+read_count(BinaryReader *r)
+{
+  uint64_t count = read_varint(r);
+  if (r->has_error)
+    return 0;
+  if (count > reader_remaining(r))
+  {
+    reader_error(r, "count %" PRIu64 " exceeds the remaining data", count);
+    return 0;
+  }
+  return (size_t)count;
+}
+
+static bool
+read_bool(BinaryReader *r)
+{
+  uint8_t byte = read_byte(r);
+  if (byte > 1)
+    reader_error(r, "invalid boolean %u", byte);
+  return byte == 1;
+}
+
+static const char *
+read_string(BinaryReader *r)
+{
+  uint64_t index = read_varint(r);
+  if (r->has_error)
+    return NULL;
+  if (index >= r->num_strings)
+  {
+    reader_error(r, "invalid string index %" PRIu64, index);
+    return NULL;
+  }
+  return r->strings[index];
+}
+
+static const char *
+read_opt_string(BinaryReader *r)
+{
+  uint64_t slot = read_varint(r);
+  if (r->has_error || slot == 0)
+    return NULL;
+  if (slot - 1 >= r->num_strings)
+  {
+    reader_error(r, "invalid string index %" PRIu64, slot - 1);
+    return NULL;
+  }
+  return r->strings[slot - 1];
+}
+
+static IRType *
+read_type(BinaryReader *r)
+{
+  uint64_t index = read_varint(r);
+  if (r->has_error)
+    return NULL;
+  if (index >= r->num_types)
+  {
+    reader_error(r, "invalid type index %" PRIu64, index);
+    return NULL;
+  }
+  return r->types[index];
+}
+
+/**
+ * @brief [内部] 值类型：可以被分配、存储或作为参数的类型
+ */
+static bool
+type_is_first_class(IRType *type)
+{
+  return type->kind != IR_TYPE_VOID && type->kind != IR_TYPE_LABEL && type->kind != IR_TYPE_FUNCTION;
+}
+
+static bool
+read_string_table(BinaryReader *r)
+{
+  size_t count = read_count(r);
+  r->strings = BUMP_ALLOC_SLICE(r->table_arena, const char *, count ? count : 1);
+  if (!r->strings)
+    return false;
+
+  for (size_t i = 0; i < count && !r->has_error; i++)
+  {
+    uint64_t len = read_varint(r);
+    if (len > reader_remaining(r))
+    {
+      reader_error(r, "string length %" PRIu64 " exceeds the remaining data", len);
+      break;
+    }
+    r->strings[i] = ir_context_intern_str_slice(r->context, (const char *)r->pos, (size_t)len);
+    r->pos += len;
+    r->num_strings = i + 1;
+  }
+  return !r->has_error;
+}
+
+/**
+ * @brief [内部] 读取 n 个成员/参数类型到 local_arena
+ */
+static IRType **
+read_type_list(BinaryReader *r, size_t count, bool first_class_only)
+{
+  IRType **list = BUMP_ALLOC_SLICE(&r->local_arena, IRType *, count ? count : 1);
+  if (!list)
+  {
+    reader_error(r, "out of memory");
+    return NULL;
+  }
+  for (size_t i = 0; i < count && !r->has_error; i++)
+  {
+    list[i] = read_type(r);
+    if (list[i] && first_class_only && !type_is_first_class(list[i]))
+      reader_error(r, "invalid member type");
+  }
+  return r->has_error ? NULL : list;
+}
+
+static IRType *
+read_struct_type(BinaryReader *r)
+{
+  const char *name = read_opt_string(r);
+  size_t count = read_count(r);
+  IRType **members = read_type_list(r, count, true);
+  if (!members)
+    return NULL;
+
+  if (!name)
+    return ir_type_get_anonymous_struct(r->context, members, count);
+
+  /// 上下文中已有同名结构体时，成员必须完全一致 (否则 ir_type_get_named_struct 会断言失败)
+  IRType *existing = (IRType *)str_hashmap_get(r->context->named_struct_cache, name, strlen(name));
+  if (existing)
+  {
+    bool same = existing->as.aggregate.member_count == count;
+    for (size_t i = 0; same && i < count; i++)
+      same = existing->as.aggregate.member_types[i] == members[i];
+    if (!same)
+    {
+      reader_error(r, "struct '%%%s' conflicts with an existing definition", name);
+      return NULL;
+    }
+    return existing;
+  }
+  return ir_type_get_named_struct(r->context, name, members, count);
+}
+
+static IRType *
+read_type_entry(BinaryReader *r)
+{
+  IRContext *ctx = r->context;
+  uint8_t kind = read_byte(r);
+  if (r->has_error)
+    return NULL;
+
+  switch ((IRTypeKind)kind)
+  {
+  case IR_TYPE_VOID:
+    return ir_type_get_void(ctx);
+  case IR_TYPE_I1:
+    return ir_type_get_i1(ctx);
+  case IR_TYPE_I8:
+    return ir_type_get_i8(ctx);
+  case IR_TYPE_I16:
+    return ir_type_get_i16(ctx);
+  case IR_TYPE_I32:
+    return ir_type_get_i32(ctx);
+  case IR_TYPE_I64:
+    return ir_type_get_i64(ctx);
+  case IR_TYPE_F32:
+    return ir_type_get_f32(ctx);
+  case IR_TYPE_F64:
+    return ir_type_get_f64(ctx);
+  case IR_TYPE_LABEL:
+    return ctx->type_label;
+  case IR_TYPE_PTR: {
+    IRType *pointee = read_type(r);
+    return pointee ? ir_type_get_ptr(ctx, pointee) : NULL;
+  }
+  case IR_TYPE_ARRAY: {
+    IRType *element = read_type(r);
+    uint64_t count = read_varint(r);
+    if (element && !type_is_first_class(element))
+      reader_error(r, "invalid array element type");
+    if (r->has_error)
+      return NULL;
+    return ir_type_get_array(ctx, element, (size_t)count);
+  }
+  case IR_TYPE_STRUCT:
+    return read_struct_type(r);
+  case IR_TYPE_FUNCTION: {
+    IRType *ret = read_type(r);
+    bool is_variadic = read_bool(r);
+    size_t count = read_count(r);
+    IRType **params = read_type_list(r, count, true);
+    if (!ret || !params)
+      return NULL;
+    return ir_type_get_function(ctx, ret, params, count, is_variadic);
+  }
+  }
+
+  reader_error(r, "invalid type kind %u", kind);
+  return NULL;
+}
+
+static bool
+read_type_table(BinaryReader *r)
+{
+  size_t count = read_count(r);
+  r->types = BUMP_ALLOC_SLICE(r->table_arena, IRType *, count ? count : 1);
+  if (!r->types)
+    return false;
+
+  /// 每个条目只能引用它之前的条目 (read_type 按 num_types 检查下标)
+  for (size_t i = 0; i < count && !r->has_error; i++)
+  {
+    bump_reset(&r->local_arena);
+    IRType *type = read_type_entry(r);
+    if (!type)
+    {
+      reader_error(r, "invalid type entry %zu", i);
+      break;
+    }
+    r->types[i] = type;
+    r->num_types = i + 1;
+  }
+  return !r->has_error;
+}
+
+static IRValueNode *
+read_constant_entry(BinaryReader *r)
+{
+  IRContext *ctx = r->context;
+  IRType *type = read_type(r);
+  uint8_t kind = read_byte(r);
+  if (r->has_error)
+    return NULL;
+
+  switch ((IRConstantKind)kind)
+  {
+  case CONST_KIND_UNDEF:
+    if (!type_is_first_class(type))
+      break;
+    return ir_constant_get_undef(ctx, type);
+  case CONST_KIND_INT: {
+    int64_t value = read_svarint(r);
+    switch (type->kind)
+    {
+    case IR_TYPE_I1:
+      return ir_constant_get_i1(ctx, value != 0);
+    case IR_TYPE_I8:
+      return ir_constant_get_i8(ctx, (int8_t)value);
+    case IR_TYPE_I16:
+      return ir_constant_get_i16(ctx, (int16_t)value);
+    case IR_TYPE_I32:
+      return ir_constant_get_i32(ctx, (int32_t)value);
+    case IR_TYPE_I64:
+      return ir_constant_get_i64(ctx, value);
+    default:
+      break;
+    }
+    break;
+  }
+  case CONST_KIND_FLOAT: {
+    double value = read_f64(r);
+    if (type->kind == IR_TYPE_F32)
+      return ir_constant_get_f32(ctx, (float)value);
+    if (type->kind == IR_TYPE_F64)
+      return ir_constant_get_f64(ctx, value);
+    break;
+  }
+  }
+
+  reader_error(r, "invalid constant (kind %u)", kind);
+  return NULL;
+}
+
+static bool
+read_constant_table(BinaryReader *r)
+{
+  size_t count = read_count(r);
+  r->constants = BUMP_ALLOC_SLICE(r->table_arena, IRValueNode *, count ? count : 1);
+  if (!r->constants)
+    return false;
+
+  for (size_t i = 0; i < count && !r->has_error; i++)
+  {
+    IRValueNode *constant = read_constant_entry(r);
+    if (!constant)
+    {
+      reader_error(r, "invalid constant entry %zu", i);
+      break;
+    }
+    r->constants[i] = constant;
+    r->num_constants = i + 1;
+  }
+  return !r->has_error;
+}
+
+/**
+ * @brief [内部] 解析一个操作数引用
+ *
+ * 引用尚未定义的局部值时返回一个占位符 (类型取自函数体开头的类型表)，
+ * 定义它的指令创建后再用 ir_value_replace_all_uses_with 替换。
+ */
+static IRValueNode *
+read_operand(BinaryReader *r, BodyState *s)
+{
+  uint64_t ref = read_varint(r);
+  if (r->has_error)
+    return NULL;
+
+  uint64_t index = ref >> 2;
+  switch ((BinaryRefTag)(ref & 3))
+  {
+  case REF_LOCAL:
+    if (index >= s->num_locals)
+      break;
+    if (s->locals[index])
+      return s->locals[index];
+    if (!s->placeholders[index])
+    {
+      IRValueNode *placeholder = BUMP_ALLOC_ZEROED(&r->local_arena, IRValueNode);
+      placeholder->kind = IR_KIND_ARGUMENT;
+      placeholder->type = s->local_types[index - s->num_args];
+      list_init(&placeholder->uses);
+      s->placeholders[index] = placeholder;
+    }
+    return s->placeholders[index];
+  case REF_BLOCK:
+    if (index >= s->num_blocks)
+      break;
+    return &s->blocks[index]->label_address;
+  case REF_CONSTANT:
+    if (index >= r->num_constants)
+      break;
+    return r->constants[index];
+  case REF_GLOBAL:
+    if (index >= r->num_globals)
+      break;
+    return r->globals[index];
+  }
+
+  reader_error(r, "invalid operand reference %" PRIu64, ref);
+  return NULL;
+}
+
+static inline bool
+is_block(IRValueNode *val)
+{
+  return val->kind == IR_KIND_BASIC_BLOCK;
+}
+
+/**
+ * @brief [内部] GEP 的索引必须能沿 source_type 走下去 (与 ir_builder_create_gep 的断言一致)
+ */
+static bool
+gep_indices_valid(IRType *source_type, IRValueNode **indices, size_t num_indices)
+{
+  IRType *current = source_type;
+  for (size_t i = 0; i < num_indices; i++)
+  {
+    if (!type_is_integer(indices[i]->type))
+      return false;
+    if (i == 0)
+      continue;
+
+    if (current->kind == IR_TYPE_ARRAY)
+    {
+      current = current->as.array.element_type;
+    }
+    else if (current->kind == IR_TYPE_STRUCT)
+    {
+      if (indices[i]->kind != IR_KIND_CONSTANT || ((IRConstant *)indices[i])->const_kind != CONST_KIND_INT)
+        return false;
+      uint64_t member = (uint64_t)((IRConstant *)indices[i])->data.int_val;
+      if (member >= current->as.aggregate.member_count)
+        return false;
+      current = current->as.aggregate.member_types[member];
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+typedef IRValueNode *(*BinaryOpBuilder)(IRBuilder *, IRValueNode *, IRValueNode *, const char *);
+typedef IRValueNode *(*CastOpBuilder)(IRBuilder *, IRValueNode *, IRType *, const char *);
+
+/// IR_OP_ADD ... IR_OP_XOR
+static const BinaryOpBuilder BINARY_OP_BUILDERS[] = {
+  ir_builder_create_add,  ir_builder_create_sub,  ir_builder_create_mul,  ir_builder_create_udiv,
+  ir_builder_create_sdiv, ir_builder_create_urem, ir_builder_create_srem, ir_builder_create_fadd,
+  ir_builder_create_fsub, ir_builder_create_fmul, ir_builder_create_fdiv, ir_builder_create_shl,
+  ir_builder_create_lshr, ir_builder_create_ashr, ir_builder_create_and,  ir_builder_create_or,
+  ir_builder_create_xor,
+};
+
+/// IR_OP_TRUNC ... IR_OP_BITCAST
+static const CastOpBuilder CAST_OP_BUILDERS[] = {
+  ir_builder_create_trunc,  ir_builder_create_zext,    ir_builder_create_sext,     ir_builder_create_fptrunc,
+  ir_builder_create_fpext,  ir_builder_create_fptoui,  ir_builder_create_fptosi,   ir_builder_create_uitofp,
+  ir_builder_create_sitofp, ir_builder_create_ptrtoint, ir_builder_create_inttoptr, ir_builder_create_bitcast,
+};
+
+static_assert(sizeof(BINARY_OP_BUILDERS) / sizeof(BINARY_OP_BUILDERS[0]) == IR_OP_XOR - IR_OP_ADD + 1,
+              "binary opcode table out of sync");
+static_assert(sizeof(CAST_OP_BUILDERS) / sizeof(CAST_OP_BUILDERS[0]) == IR_OP_BITCAST - IR_OP_TRUNC + 1,
+              "cast opcode table out of sync");
+
+/**
+ * @brief [内部] 用 IRBuilder 创建一条指令
+ *
+ * 所有 builder 会断言的条件都先在这里检查，损坏的输入只会得到 NULL。
+ */
+static IRValueNode *
+build_instruction(BinaryReader *r, IROpcode opcode, IRType *type, const char *name, uint8_t predicate,
+                  IRType *gep_source, bool inbounds, IRValueNode **ops, size_t n)
+{
+  IRBuilder *b = r->builder;
+  IRType *i1 = ir_type_get_i1(r->context);
+
+  if (opcode >= IR_OP_ADD && opcode <= IR_OP_XOR)
+  {
+    if (n != 2 || ops[0]->type != ops[1]->type)
+      return NULL;
+    return BINARY_OP_BUILDERS[opcode - IR_OP_ADD](b, ops[0], ops[1], name);
+  }
+  if (opcode >= IR_OP_TRUNC && opcode <= IR_OP_BITCAST)
+  {
+    if (n != 1 || !type_is_first_class(type))
+      return NULL;
+    return CAST_OP_BUILDERS[opcode - IR_OP_TRUNC](b, ops[0], type, name);
+  }
+
+  switch (opcode)
+  {
+  case IR_OP_RET:
+    if (n > 1)
+      return NULL;
+    return ir_builder_create_ret(b, n ? ops[0] : NULL);
+
+  case IR_OP_BR:
+    if (n != 1 || !is_block(ops[0]))
+      return NULL;
+    return ir_builder_create_br(b, ops[0]);
+
+  case IR_OP_COND_BR:
+    if (n != 3 || ops[0]->type != i1 || !is_block(ops[1]) || !is_block(ops[2]))
+      return NULL;
+    return ir_builder_create_cond_br(b, ops[0], ops[1], ops[2]);
+
+  case IR_OP_SWITCH: {
+    if (n < 2 || n % 2 != 0 || !type_is_integer(ops[0]->type) || !is_block(ops[1]))
+      return NULL;
+    for (size_t i = 2; i < n; i += 2)
+    {
+      if (ops[i]->kind != IR_KIND_CONSTANT || !is_block(ops[i + 1]))
+        return NULL;
+    }
+    IRValueNode *inst = ir_builder_create_switch(b, ops[0], ops[1]);
+    for (size_t i = 2; inst && i < n; i += 2)
+      ir_switch_add_case(inst, ops[i], ops[i + 1]);
+    return inst;
+  }
+
+  case IR_OP_ALLOCA:
+    if (n != 0 || type->kind != IR_TYPE_PTR)
+      return NULL;
+    return ir_builder_create_alloca(b, type->as.pointee_type, name);
+
+  case IR_OP_LOAD:
+    if (n != 1 || ops[0]->type->kind != IR_TYPE_PTR)
+      return NULL;
+    return ir_builder_create_load(b, ops[0], name);
+
+  case IR_OP_STORE:
+    if (n != 2 || ops[1]->type->kind != IR_TYPE_PTR)
+      return NULL;
+    return ir_builder_create_store(b, ops[0], ops[1]);
+
+  case IR_OP_GEP:
+    if (n < 1 || ops[0]->type->kind != IR_TYPE_PTR || !gep_indices_valid(gep_source, ops + 1, n - 1))
+      return NULL;
+    return ir_builder_create_gep(b, gep_source, ops[0], ops + 1, n - 1, inbounds, name);
+
+  case IR_OP_ICMP:
+    if (n != 2 || ops[0]->type != ops[1]->type || predicate > IR_ICMP_SLE)
+      return NULL;
+    return ir_builder_create_icmp(b, (IRICmpPredicate)predicate, ops[0], ops[1], name);
+
+  case IR_OP_FCMP:
+    if (n != 2 || ops[0]->type != ops[1]->type || !type_is_floating(ops[0]->type) || predicate > IR_FCMP_FALSE)
+      return NULL;
+    return ir_builder_create_fcmp(b, (IRFCmpPredicate)predicate, ops[0], ops[1], name);
+
+  case IR_OP_SELECT:
+    if (n != 3 || ops[0]->type != i1 || ops[1]->type != ops[2]->type || ops[1]->type->kind == IR_TYPE_VOID)
+      return NULL;
+    return ir_builder_create_select(b, ops[0], ops[1], ops[2], name);
+
+  case IR_OP_PHI: {
+    if (n % 2 != 0 || !type_is_first_class(type))
+      return NULL;
+    for (size_t i = 0; i < n; i += 2)
+    {
+      if (ops[i]->type != type || !is_block(ops[i + 1]))
+        return NULL;
+    }
+    IRValueNode *phi = ir_builder_create_phi(b, type, name);
+    if (!phi)
+      return NULL;
+
+    /// ir_builder_create_phi 插在块首；移到块尾以保持写出时的顺序
+    IRInstruction *inst = (IRInstruction *)phi;
+    list_del(&inst->list_node);
+    list_add_tail(&inst->parent->instructions, &inst->list_node);
+    ir_basic_block_instruction_inserted(inst->parent, inst);
+
+    for (size_t i = 0; i < n; i += 2)
+      ir_phi_add_incoming(phi, ops[i], (IRBasicBlock *)ops[i + 1]);
+    return phi;
+  }
+
+  case IR_OP_CALL: {
+    if (n < 1 || ops[0]->type->kind != IR_TYPE_PTR)
+      return NULL;
+    IRType *func_type = ops[0]->type->as.pointee_type;
+    if (func_type->kind != IR_TYPE_FUNCTION)
+      return NULL;
+    size_t num_args = n - 1;
+    size_t required = func_type->as.function.param_count;
+    if (func_type->as.function.is_variadic ? num_args < required : num_args != required)
+      return NULL;
+    return ir_builder_create_call(b, ops[0], ops + 1, num_args, name);
+  }
+
+  default:
+    return NULL;
+  }
+}
+
+static IRValueNode *
+read_instruction(BinaryReader *r, BodyState *s, IRType *type)
+{
+  uint8_t opcode = read_byte(r);
+  if (r->has_error)
+    return NULL;
+  if (opcode > IR_OP_CALL)
+  {
+    reader_error(r, "invalid opcode %u", opcode);
+    return NULL;
+  }
+
+  const char *name = type->kind != IR_TYPE_VOID ? read_opt_string(r) : NULL;
+
+  uint8_t predicate = 0;
+  IRType *gep_source = NULL;
+  bool inbounds = false;
+  if (opcode == IR_OP_ICMP || opcode == IR_OP_FCMP)
+  {
+    predicate = read_byte(r);
+  }
+  else if (opcode == IR_OP_GEP)
+  {
+    gep_source = read_type(r);
+    inbounds = read_bool(r);
+  }
+
+  size_t n = read_count(r);
+  if (r->has_error)
+    return NULL;
+
+  BumpMark mark = bump_mark(&r->arena);
+  IRValueNode **ops = BUMP_ALLOC_SLICE(&r->arena, IRValueNode *, n ? n : 1);
+  if (!ops)
+  {
+    reader_error(r, "out of memory");
+    return NULL;
+  }
+  for (size_t i = 0; i < n && !r->has_error; i++)
+    ops[i] = read_operand(r, s);
+
+  IRValueNode *result = NULL;
+  if (!r->has_error)
+  {
+    result = build_instruction(r, (IROpcode)opcode, type, name, predicate, gep_source, inbounds, ops, n);
+    if (!result)
+      reader_error(r, "invalid operands for opcode %u", opcode);
+    else if (result->type != type)
+    {
+      reader_error(r, "instruction type does not match the function's type table");
+      result = NULL;
+    }
+  }
+
+  bump_rewind(&r->arena, mark);
+  return result;
+}
+
+static bool
+read_function_body(BinaryReader *r, IRFunction *func)
+{
+  bump_reset(&r->local_arena);
+  BodyState s = {0};
+
+  IDList *iter;
+  list_for_each(&func->arguments, iter)
+  {
+    s.num_args++;
+  }
+
+  s.num_blocks = read_count(r);
+  s.blocks = BUMP_ALLOC_SLICE(&r->local_arena, IRBasicBlock *, s.num_blocks ? s.num_blocks : 1);
+  size_t *block_sizes = BUMP_ALLOC_SLICE(&r->local_arena, size_t, s.num_blocks ? s.num_blocks : 1);
+  if (!s.blocks || !block_sizes)
+  {
+    reader_error(r, "out of memory");
+    return false;
+  }
+
+  size_t num_insts = 0;
+  for (size_t i = 0; i < s.num_blocks && !r->has_error; i++)
+  {
+    const char *name = read_string(r);
+    block_sizes[i] = read_count(r);
+    if (r->has_error)
+      break;
+
+    /// 每条指令至少占一个字节，总数同样不能超过剩余字节数
+    num_insts += block_sizes[i];
+    if (num_insts > reader_remaining(r))
+    {
+      reader_error(r, "instruction count exceeds the remaining data");
+      break;
+    }
+
+    s.blocks[i] = ir_basic_block_create(func, name);
+    if (!s.blocks[i])
+    {
+      reader_error(r, "out of memory");
+      break;
+    }
+    ir_function_append_basic_block(func, s.blocks[i]);
+  }
+  if (r->has_error)
+    return false;
+
+  s.num_locals = s.num_args + num_insts;
+  s.locals = BUMP_ALLOC_SLICE_ZEROED(&r->local_arena, IRValueNode *, s.num_locals ? s.num_locals : 1);
+  s.placeholders = BUMP_ALLOC_SLICE_ZEROED(&r->local_arena, IRValueNode *, s.num_locals ? s.num_locals : 1);
+  s.local_types = BUMP_ALLOC_SLICE(&r->local_arena, IRType *, num_insts ? num_insts : 1);
+
+  size_t index = 0;
+  list_for_each(&func->arguments, iter)
+  {
+    IRArgument *arg = list_entry(iter, IRArgument, list_node);
+    s.locals[index++] = &arg->value;
+  }
+
+  for (size_t i = 0; i < num_insts && !r->has_error; i++)
+  {
+    s.local_types[i] = read_type(r);
+    if (s.local_types[i] && s.local_types[i]->kind == IR_TYPE_LABEL)
+      reader_error(r, "instruction cannot produce a label");
+  }
+
+  for (size_t b = 0; b < s.num_blocks && !r->has_error; b++)
+  {
+    ir_builder_set_insertion_point(r->builder, s.blocks[b]);
+    for (size_t i = 0; i < block_sizes[b] && !r->has_error; i++, index++)
+    {
+      IRValueNode *value = read_instruction(r, &s, s.local_types[index - s.num_args]);
+      if (!value)
+        return false;
+
+      s.locals[index] = value;
+      if (s.placeholders[index])
+        ir_value_replace_all_uses_with(s.placeholders[index], value);
+    }
+  }
+
+  return !r->has_error;
+}
+
+/**
+ * @brief [内部] 延迟加载时所有函数体共享的表 (分配在 IR Arena 上)
+ */
+typedef struct
+{
+  const uint8_t *start;
+  size_t size;
+  const char **strings;
+  size_t num_strings;
+  IRType **types;
+  size_t num_types;
+  IRValueNode **constants;
+  size_t num_constants;
+  IRValueNode **globals;
+  size_t num_globals;
+} LazyTables;
+
+/**
+ * @brief [内部] 一个尚未物化的函数体在数据中的位置
+ */
+typedef struct
+{
+  const LazyTables *tables;
+  size_t offset;
+  size_t len;
+} LazyBody;
+
+/**
+ * @brief [内部] 读取一个长度为 len 的函数体，它必须恰好用完这 len 个字节
+ */
+static bool
+read_body_slice(BinaryReader *r, IRFunction *func, size_t len)
+{
+  const uint8_t *end = r->end;
+  r->end = r->pos + len;
+  bool ok = read_function_body(r, func);
+  if (ok && r->pos != r->end)
+  {
+    reader_error(r, "%zu bytes of trailing data in the body of '@%s'", reader_remaining(r), func->entry_address.name);
+    ok = false;
+  }
+  r->end = end;
+  return ok;
+}
+
+/**
+ * @brief [内部] 物化一个延迟加载的函数体 (IRFunctionMaterializer)
+ */
+static bool
+materialize_lazy_body(IRFunction *func, void *data)
+{
+  const LazyBody *body = (const LazyBody *)data;
+  const LazyTables *t = body->tables;
+
+  BinaryReader r = {
+    .context = func->parent->context,
+    .start = t->start,
+    .pos = t->start + body->offset,
+    .end = t->start + t->size,
+    .strings = t->strings,
+    .num_strings = t->num_strings,
+    .types = t->types,
+    .num_types = t->num_types,
+    .constants = t->constants,
+    .num_constants = t->num_constants,
+    .globals = t->globals,
+    .num_globals = t->num_globals,
+    .module = func->parent,
+  };
+  bump_init(&r.arena);
+  bump_init(&r.local_arena);
+  r.table_arena = &r.arena;
+
+  r.builder = ir_builder_create(r.context);
+  bool ok = r.builder && read_body_slice(&r, func, body->len);
+  if (!ok && !r.has_error)
+    reader_error(&r, "out of memory");
+
+  ir_builder_destroy(r.builder);
+  bump_destroy(&r.local_arena);
+  bump_destroy(&r.arena);
+  return ok && ir_verify_function(func);
+}
+
+/**
+ * @brief [内部] 读取 module 段
+ *
+ * @param lazy 非 NULL 时只记录函数体的位置 (表指针在读完函数头后填入)
+ */
+static bool
+read_module_section(BinaryReader *r, LazyTables *lazy)
+{
+  IRContext *ctx = r->context;
+
+  const char *mod_name = read_string(r);
+  if (r->has_error)
+    return false;
+  r->module = ir_module_create(ctx, mod_name);
+  if (!r->module)
+  {
+    reader_error(r, "out of memory");
+    return false;
+  }
+
+  size_t num_globals = read_count(r);
+  r->globals = BUMP_ALLOC_SLICE(r->table_arena, IRValueNode *, num_globals ? num_globals : 1);
+  if (!r->globals)
+    return false;
+
+  for (size_t i = 0; i < num_globals && !r->has_error; i++)
+  {
+    const char *name = read_string(r);
+    IRType *allocated = read_type(r);
+    uint64_t init_slot = read_varint(r);
+    if (r->has_error)
+      break;
+
+    IRValueNode *init = NULL;
+    if (init_slot != 0)
+    {
+      if (init_slot - 1 >= r->num_constants)
+      {
+        reader_error(r, "invalid initializer index %" PRIu64, init_slot - 1);
+        break;
+      }
+      init = r->constants[init_slot - 1];
+    }
+    if (!type_is_first_class(allocated) || (init && init->type != allocated))
+    {
+      reader_error(r, "invalid global '@%s'", name);
+      break;
+    }
+
+    IRGlobalVariable *global = ir_global_variable_create(r->module, name, allocated, init);
+    if (!global)
+    {
+      reader_error(r, "out of memory");
+      break;
+    }
+    r->globals[i] = &global->value;
+  }
+  if (r->has_error)
+    return false;
+
+  size_t num_functions = read_count(r);
+  IRFunction **functions = BUMP_ALLOC_SLICE(&r->arena, IRFunction *, num_functions ? num_functions : 1);
+  IRValueNode **all_globals = BUMP_ALLOC_SLICE(r->table_arena, IRValueNode *, num_globals + num_functions + 1);
+  if (!functions || !all_globals)
+    return false;
+  memcpy(all_globals, r->globals, num_globals * sizeof(IRValueNode *));
+  r->globals = all_globals;
+  r->num_globals = num_globals;
+
+  for (size_t i = 0; i < num_functions && !r->has_error; i++)
+  {
+    const char *name = read_string(r);
+    IRType *ret = read_type(r);
+    bool is_variadic = read_bool(r);
+    bool is_declaration = read_bool(r);
+    size_t num_args = read_count(r);
+    if (r->has_error)
+      break;
+    if (ret->kind == IR_TYPE_LABEL || ret->kind == IR_TYPE_FUNCTION)
+    {
+      reader_error(r, "invalid return type for '@%s'", name);
+      break;
+    }
+
+    IRFunction *func = ir_function_create(r->module, name, ret);
+    if (!func)
+    {
+      reader_error(r, "out of memory");
+      break;
+    }
+    for (size_t a = 0; a < num_args && !r->has_error; a++)
+    {
+      const char *arg_name = read_opt_string(r);
+      IRType *arg_type = read_type(r);
+      if (r->has_error)
+        break;
+      if (!type_is_first_class(arg_type))
+      {
+        reader_error(r, "invalid argument type for '@%s'", name);
+        break;
+      }
+      if (!ir_argument_create(func, arg_type, arg_name))
+        reader_error(r, "out of memory");
+    }
+    if (r->has_error)
+      break;
+
+    ir_function_finalize_signature(func, is_variadic);
+    func->is_declaration = is_declaration;
+    functions[i] = func;
+    r->globals[r->num_globals++] = &func->entry_address;
+  }
+  if (r->has_error)
+    return false;
+
+  if (lazy)
+  {
+    lazy->strings = r->strings;
+    lazy->num_strings = r->num_strings;
+    lazy->types = r->types;
+    lazy->num_types = r->num_types;
+    lazy->constants = r->constants;
+    lazy->num_constants = r->num_constants;
+    lazy->globals = r->globals;
+    lazy->num_globals = r->num_globals;
+  }
+  else
+  {
+    r->builder = ir_builder_create(ctx);
+    if (!r->builder)
+    {
+      reader_error(r, "out of memory");
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < num_functions; i++)
+  {
+    if (functions[i]->is_declaration)
+      continue;
+
+    size_t len = read_count(r);
+    if (r->has_error)
+      return false;
+
+    if (lazy)
+    {
+      LazyBody *body = BUMP_ALLOC(r->table_arena, LazyBody);
+      if (!body)
+        return false;
+      body->tables = lazy;
+      body->offset = (size_t)(r->pos - r->start);
+      body->len = len;
+      functions[i]->materializer = materialize_lazy_body;
+      functions[i]->materializer_data = body;
+      r->pos += len;
+    }
+    else if (!read_body_slice(r, functions[i], len))
+      return false;
+  }
+
+  if (r->pos != r->end)
+  {
+    reader_error(r, "%zu bytes of trailing data", reader_remaining(r));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief [内部] 读取整个模块；lazy 为 true 时函数体留到第一次访问时再读
+ */
+static IRModule *
+read_module(IRContext *ctx, const void *data, size_t size, bool lazy)
+{
+  assert(ctx != NULL);
+  assert(data != NULL || size == 0);
+
+  BinaryReader r = {
+    .context = ctx,
+    .start = (const uint8_t *)data,
+    .pos = (const uint8_t *)data,
+    .end = (const uint8_t *)data + size,
+  };
+
+  if (size < sizeof(BINARY_MAGIC) || memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0)
+  {
+    reader_error(&r, "not a binary IR file (bad magic)");
+    return NULL;
+  }
+  r.pos += sizeof(BINARY_MAGIC);
+
+  uint64_t version = read_varint(&r);
+  if (r.has_error)
+    return NULL;
+  if (version != IR_BINARY_VERSION)
+  {
+    reader_error(&r, "unsupported version %" PRIu64 " (expected %d)", version, IR_BINARY_VERSION);
+    return NULL;
+  }
+
+  bump_init(&r.arena);
+  bump_init(&r.local_arena);
+  r.table_arena = lazy ? ir_context_ir_arena(ctx) : &r.arena;
+
+  LazyTables *tables = NULL;
+  if (lazy)
+  {
+    tables = BUMP_ALLOC(r.table_arena, LazyTables);
+    if (tables)
+      *tables = (LazyTables){.start = r.start, .size = size};
+  }
+
+  bool ok = (!lazy || tables) && read_string_table(&r) && read_type_table(&r) && read_constant_table(&r) &&
+            read_module_section(&r, tables);
+  if (!ok && !r.has_error)
+    reader_error(&r, "out of memory");
+
+  IRModule *mod = ok ? r.module : NULL;
+
+  ir_builder_destroy(r.builder);
+  bump_destroy(&r.local_arena);
+  bump_destroy(&r.arena);
+
+  /// 延迟加载时函数体在物化时逐个验证
+  if (mod && !lazy && !ir_verify_module(mod))
+  {
+    fprintf(stderr, "Binary IR Error: module '%s' failed verification\n", mod->name);
+    return NULL;
+  }
+  return mod;
+}
+
+IRModule *
+ir_binary_read_module(IRContext *ctx, const void *data, size_t size)
+{
+  return read_module(ctx, data, size, false);
+}
+
+IRModule *
+ir_binary_read_module_lazy(IRContext *ctx, const void *data, size_t size)
+{
+  return read_module(ctx, data, size, true);
+}
+
+IRModule *
+ir_binary_read_module_file(IRContext *ctx, const char *path)
+{
+  assert(path != NULL);
+
+  MappedFile file;
+  if (!mapped_file_open(&file, path))
+  {
+    fprintf(stderr, "Binary IR Error: Cannot read '%s'\n", path);
+    return NULL;
+  }
+
+  IRModule *mod = ir_binary_read_module(ctx, file.size ? file.data : "", file.size);
+  mapped_file_close(&file);
+  return mod;
+}
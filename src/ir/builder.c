@@ -60,6 +60,14 @@ ir_builder_set_insertion_point(IRBuilder *builder, IRBasicBlock *bb)
   builder->insertion_point = bb;
 }
 
+bool
+ir_builder_reserve(IRBuilder *builder, size_t num_instructions, size_t num_operands)
+{
+  assert(builder != NULL);
+  assert(builder->insertion_point != NULL && "Builder insertion point is not set");
+  return ir_function_reserve_body(builder->insertion_point->parent, num_instructions, num_operands);
+}
+
 /*
  * =================================================================
  * --- 内部辅助函数 ---
@@ -91,16 +99,18 @@ builder_get_next_reg_name(IRBuilder *builder)
  * @param builder Builder
  * @param opcode 指令码
  * @param type 指令*结果*的类型 (如果是 void, 使用 ctx->type_void)
+ * @param num_operands 操作数个数 (它们的 Use 记录与指令一起分配)
  * @return 指向新指令的指针
  */
 static IRInstruction *
-ir_instruction_create_internal(IRBuilder *builder, IROpcode opcode, IRType *type, const char *name_hint)
+ir_instruction_create_internal(IRBuilder *builder, IROpcode opcode, IRType *type, const char *name_hint,
+                               size_t num_operands)
 {
   assert(builder != NULL);
   assert(builder->insertion_point != NULL && "Builder insertion point is not set");
   IRContext *ctx = builder->context;
 
-  IRInstruction *inst = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRInstruction);
+  IRInstruction *inst = ir_function_alloc_instruction(builder->insertion_point->parent, num_operands);
   if (!inst)
     return NULL;
 
@@ -111,7 +121,6 @@ ir_instruction_create_internal(IRBuilder *builder, IROpcode opcode, IRType *type
   inst->opcode = opcode;
   inst->parent = builder->insertion_point;
   list_init(&inst->list_node);
-  list_init(&inst->operands);
 
   if (type->kind != IR_TYPE_VOID)
   {
@@ -132,6 +141,7 @@ ir_instruction_create_internal(IRBuilder *builder, IROpcode opcode, IRType *type
   }
 
   list_add_tail(&builder->insertion_point->instructions, &inst->list_node);
+  ir_basic_block_instruction_inserted(builder->insertion_point, inst);
 
   return inst;
 }
@@ -164,7 +174,7 @@ IRValueNode *
 ir_builder_create_ret(IRBuilder *builder, IRValueNode *val)
 {
   IRType *void_type = builder->context->type_void;
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_RET, void_type, NULL);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_RET, void_type, NULL, val ? 1 : 0);
 
   if (val)
   {
@@ -182,7 +192,7 @@ ir_builder_create_br(IRBuilder *builder, IRValueNode *target_bb)
   assert(target_bb->kind == IR_KIND_BASIC_BLOCK && "br target must be a Basic Block");
 
   IRType *void_type = builder->context->type_void;
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_BR, void_type, NULL);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_BR, void_type, NULL, 1);
 
   ir_use_create(builder->context, inst, target_bb);
 
@@ -201,7 +211,7 @@ ir_builder_create_cond_br(IRBuilder *builder, IRValueNode *cond, IRValueNode *tr
 
   IRType *void_type = builder->context->type_void;
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_COND_BR, void_type, NULL);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_COND_BR, void_type, NULL, 3);
 
   if (!inst)
     return NULL;
@@ -219,7 +229,7 @@ builder_create_binary_op(IRBuilder *builder, IROpcode op, IRValueNode *lhs, IRVa
   assert(lhs != NULL && rhs != NULL);
   assert(lhs->type == rhs->type && "Binary operands must have the same type");
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, op, lhs->type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, op, lhs->type, name_hint, 2);
 
   ir_use_create(builder->context, inst, lhs);
   ir_use_create(builder->context, inst, rhs);
@@ -237,7 +247,7 @@ builder_create_cast_op(IRBuilder *builder, IROpcode op, IRValueNode *val, IRType
   assert(val != NULL);
   assert(dest_type != NULL && "Cast destination type cannot be NULL");
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, op, dest_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, op, dest_type, name_hint, 1);
   if (!inst)
     return NULL;
 
@@ -358,7 +368,7 @@ ir_builder_create_icmp(IRBuilder *builder, IRICmpPredicate pred, IRValueNode *lh
 
   IRType *result_type = ir_type_get_i1(builder->context);
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_ICMP, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_ICMP, result_type, name_hint, 2);
 
   if (!inst)
     return NULL;
@@ -382,7 +392,7 @@ ir_builder_create_fcmp(IRBuilder *builder, IRFCmpPredicate pred, IRValueNode *lh
 
   IRType *result_type = ir_type_get_i1(builder->context);
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_FCMP, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_FCMP, result_type, name_hint, 2);
 
   if (!inst)
     return NULL;
@@ -410,7 +420,7 @@ ir_builder_create_select(IRBuilder *builder, IRValueNode *cond, IRValueNode *tru
 
   IRType *result_type = true_val->type;
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_SELECT, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_SELECT, result_type, name_hint, 3);
   if (!inst)
     return NULL;
 
@@ -429,7 +439,7 @@ ir_builder_create_alloca(IRBuilder *builder, IRType *allocated_type, const char
 
   IRType *ptr_type = ir_type_get_ptr(ctx, allocated_type);
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_ALLOCA, ptr_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_ALLOCA, ptr_type, name_hint, 0);
 
   return &inst->result;
 }
@@ -443,7 +453,7 @@ ir_builder_create_load(IRBuilder *builder, IRValueNode *ptr, const char *name_hi
   IRType *result_type = ptr->type->as.pointee_type;
   assert(result_type != NULL);
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_LOAD, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_LOAD, result_type, name_hint, 1);
   ir_use_create(builder->context, inst, ptr);
 
   return &inst->result;
@@ -457,7 +467,7 @@ ir_builder_create_store(IRBuilder *builder, IRValueNode *val, IRValueNode *ptr)
   assert(ptr->type->kind == IR_TYPE_PTR && "store target must be a pointer");
 
   IRType *void_type = builder->context->type_void;
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_STORE, void_type, NULL);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_STORE, void_type, NULL, 2);
 
   ir_use_create(builder->context, inst, val);
   ir_use_create(builder->context, inst, ptr);
@@ -474,7 +484,8 @@ ir_builder_create_phi(IRBuilder *builder, IRType *type, const char *name_hint)
 
   IRContext *ctx = builder->context;
 
-  IRInstruction *inst = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRInstruction);
+  /// 入边在之后逐个加入，Use 记录放在单独增长的数组中
+  IRInstruction *inst = ir_function_alloc_instruction(builder->insertion_point->parent, 0);
   if (!inst)
     return NULL;
 
@@ -485,7 +496,6 @@ ir_builder_create_phi(IRBuilder *builder, IRType *type, const char *name_hint)
   inst->opcode = IR_OP_PHI;
   inst->parent = builder->insertion_point;
   list_init(&inst->list_node);
-  list_init(&inst->operands);
 
   if (name_hint)
   {
@@ -497,6 +507,7 @@ ir_builder_create_phi(IRBuilder *builder, IRType *type, const char *name_hint)
   }
 
   list_add(&builder->insertion_point->instructions, &inst->list_node);
+  ir_basic_block_instruction_inserted(builder->insertion_point, inst);
 
   return &inst->result;
 }
@@ -519,6 +530,19 @@ ir_phi_add_incoming(IRValueNode *phi_node, IRValueNode *value, IRBasicBlock *inc
   ir_use_create(ctx, inst, &incoming_bb->label_address);
 }
 
+void
+ir_phi_remove_incoming(IRValueNode *phi_node, size_t index)
+{
+  assert(phi_node != NULL && phi_node->kind == IR_KIND_INSTRUCTION);
+  IRInstruction *inst = (IRInstruction *)phi_node;
+  assert(inst->opcode == IR_OP_PHI && "Value is not a PHI node");
+  assert(2 * index + 1 < inst->num_operands && "PHI incoming index out of range");
+
+  /// 先移除块再移除值，值的 Use 不会因为前面的移除而搬动
+  ir_use_unlink(&inst->operands[2 * index + 1]);
+  ir_use_unlink(&inst->operands[2 * index]);
+}
+
 /**
  * @brief [内部] GEP 辅助函数：从 IR_KIND_CONSTANT 中提取整数值。
  *
@@ -591,7 +615,7 @@ ir_builder_create_gep(IRBuilder *builder, IRType *source_type, IRValueNode *base
 
   IRType *result_type = ir_type_get_ptr(ctx, current_type);
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_GEP, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_GEP, result_type, name_hint, 1 + num_indices);
 
   if (!inst)
     return NULL;
@@ -635,7 +659,7 @@ ir_builder_create_call(IRBuilder *builder, IRValueNode *callee_func, IRValueNode
 
   assert(is_valid_arg_count && "call argument count mismatch");
 
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_CALL, result_type, name_hint);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_CALL, result_type, name_hint, 1 + num_args);
   if (!inst)
     return NULL;
 
@@ -730,7 +754,7 @@ ir_builder_create_switch(IRBuilder *builder, IRValueNode *cond, IRValueNode *def
   assert(ir_type_is_integer(cond->type) && "Switch condition must be an integer");
 
   IRType *void_type = builder->context->type_void;
-  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_SWITCH, void_type, NULL);
+  IRInstruction *inst = ir_instruction_create_internal(builder, IR_OP_SWITCH, void_type, NULL, 2);
   if (!inst)
     return NULL;
 
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/global.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*
+ * =================================================================
+ * --- 模块克隆 ---
+ * =================================================================
+ *
+ * 同一个 Context 中的克隆：类型、常量和驻留的名字都是唯一化的不可变对象，
+ * 直接共享；全局变量、函数、参数、基本块和指令逐个按结构体复制，
+ * 操作数通过重映射表 (旧 Value -> 新 Value) 指向克隆出的对象。
+ */
+
+/**
+ * @brief 克隆过程中的重映射表
+ */
+typedef struct CloneState
+{
+  IRContext *context;
+  Bump scratch;
+  /** 全局变量和函数: 整个模块共用 (复制到同一模块中时为 NULL) */
+  PtrHashMap *global_remap;
+  /** 参数、基本块和指令: 每个函数重建一次 */
+  Bump local_arena;
+  PtrHashMap *local_remap;
+} CloneState;
+
+/**
+ * @brief [内部] 查找操作数的克隆
+ *
+ * 常量 (以及不属于源模块的值) 不复制，原样返回。
+ */
+static IRValueNode *
+remap_value(CloneState *s, IRValueNode *old_val)
+{
+  IRValueNode *mapped = NULL;
+  switch (old_val->kind)
+  {
+  case IR_KIND_CONSTANT:
+    return old_val;
+  case IR_KIND_FUNCTION:
+  case IR_KIND_GLOBAL:
+    /// 复制到同一模块中时 (ir_function_clone_body_into) 全局符号不变
+    mapped = s->global_remap ? ptr_hashmap_get(s->global_remap, old_val) : NULL;
+    break;
+  case IR_KIND_ARGUMENT:
+  case IR_KIND_BASIC_BLOCK:
+  case IR_KIND_INSTRUCTION:
+    mapped = ptr_hashmap_get(s->local_remap, old_val);
+    break;
+  }
+  return mapped ? mapped : old_val;
+}
+
+/**
+ * @brief [内部] 复制全局变量 (初始值在所有全局都建立之后再重映射)
+ */
+static IRGlobalVariable *
+clone_global(CloneState *s, IRModule *dst, IRGlobalVariable *src)
+{
+  IRGlobalVariable *global = BUMP_ALLOC(ir_context_ir_arena(s->context), IRGlobalVariable);
+  if (!global)
+    return NULL;
+  *global = *src;
+  global->parent = dst;
+  list_init(&global->value.uses);
+  list_add_tail(&dst->globals, &global->list_node);
+
+  if (!ptr_hashmap_put(s->global_remap, &src->value, &global->value))
+    return NULL;
+  return global;
+}
+
+/**
+ * @brief [内部] 复制函数头和参数 (函数体由 clone_function_body 复制)
+ */
+static IRFunction *
+clone_function_header(CloneState *s, IRModule *dst, IRFunction *src)
+{
+  Bump *arena = ir_context_ir_arena(s->context);
+  IRFunction *func = BUMP_ALLOC(arena, IRFunction);
+  if (!func)
+    return NULL;
+  *func = *src;
+  func->parent = dst;
+  list_init(&func->entry_address.uses);
+  list_init(&func->arguments);
+  list_init(&func->basic_blocks);
+  func->materializer = NULL;
+  func->materializer_data = NULL;
+  func->body_arena = NULL;
+  list_add_tail(&dst->functions, &func->list_node);
+
+  /// 源函数有私有 Arena 时克隆也有 (ctx->private_function_arenas 时总会自动创建)
+  if (src->body_arena && !ir_function_use_private_arena(func))
+    return NULL;
+
+  if (!ptr_hashmap_put(s->global_remap, &src->entry_address, &func->entry_address))
+    return NULL;
+  return func;
+}
+
+/**
+ * @brief [内部] 复制 src 的所有基本块和指令，插入到 func 的块链表中 pos 之前
+ *
+ * 第一遍复制基本块和指令 (不含操作数) 并记录重映射；
+ * 第二遍同时遍历源和克隆，填写操作数 (phi 和分支可以引用后面的值)。
+ *
+ * @return 第一个复制出的块 (src 没有块或 OOM 时返回 NULL)
+ */
+static IRBasicBlock *
+clone_blocks(CloneState *s, IRFunction *src, IRFunction *func, IDList *pos)
+{
+  Bump *body_arena = ir_function_body_arena(func);
+  IRBasicBlock *first = NULL;
+  IDList *iter;
+  list_for_each(&src->basic_blocks, iter)
+  {
+    IRBasicBlock *src_bb = list_entry(iter, IRBasicBlock, list_node);
+    IRBasicBlock *bb = BUMP_ALLOC(body_arena, IRBasicBlock);
+    if (!bb)
+      return NULL;
+    *bb = *src_bb;
+    bb->parent = func;
+    list_init(&bb->label_address.uses);
+    list_init(&bb->instructions);
+    list_add_tail(pos, &bb->list_node);
+    if (!ptr_hashmap_put(s->local_remap, &src_bb->label_address, &bb->label_address))
+      return NULL;
+    if (!first)
+      first = bb;
+
+    IDList *inst_iter;
+    list_for_each(&src_bb->instructions, inst_iter)
+    {
+      IRInstruction *src_inst = list_entry(inst_iter, IRInstruction, list_node);
+      /// 所有操作数都放在指令之后 (与 builder 为定长指令分配的布局相同)
+      size_t num_operands = src_inst->num_operands;
+      IRInstruction *inst = (IRInstruction *)bump_alloc(
+        body_arena, sizeof(IRInstruction) + num_operands * sizeof(IRUse), _Alignof(IRInstruction));
+      if (!inst)
+        return NULL;
+      *inst = *src_inst;
+      inst->parent = bb;
+      inst->operands = num_operands > 0 ? (IRUse *)(inst + 1) : NULL;
+      inst->num_operands = 0;
+      inst->operand_capacity = num_operands;
+      list_init(&inst->result.uses);
+      list_add_tail(&bb->instructions, &inst->list_node);
+      if (!ptr_hashmap_put(s->local_remap, &src_inst->result, &inst->result))
+        return NULL;
+    }
+  }
+  if (!first)
+    return NULL;
+
+  /// 第二遍: 块和指令的顺序与源相同
+  IDList *dst_bb_iter = &first->list_node;
+  list_for_each(&src->basic_blocks, iter)
+  {
+    IRBasicBlock *src_bb = list_entry(iter, IRBasicBlock, list_node);
+    IRBasicBlock *bb = list_entry(dst_bb_iter, IRBasicBlock, list_node);
+    dst_bb_iter = dst_bb_iter->next;
+
+    IDList *dst_inst_iter = bb->instructions.next;
+    IDList *inst_iter;
+    list_for_each(&src_bb->instructions, inst_iter)
+    {
+      IRInstruction *src_inst = list_entry(inst_iter, IRInstruction, list_node);
+      IRInstruction *inst = list_entry(dst_inst_iter, IRInstruction, list_node);
+      dst_inst_iter = dst_inst_iter->next;
+
+      for (size_t i = 0; i < inst->operand_capacity; i++)
+      {
+        IRUse *use = &inst->operands[i];
+        use->value = remap_value(s, src_inst->operands[i].value);
+        use->user = inst;
+        list_add_tail(&use->value->uses, &use->value_node);
+      }
+      inst->num_operands = inst->operand_capacity;
+    }
+  }
+  return first;
+}
+
+/**
+ * @brief [内部] 复制函数体 (参数，然后是所有基本块)
+ */
+static bool
+clone_function_body(CloneState *s, IRFunction *src, IRFunction *func)
+{
+  bump_reset(&s->local_arena);
+  s->local_remap = ptr_hashmap_create(&s->local_arena, 64);
+  if (!s->local_remap)
+    return false;
+
+  Bump *ir_arena = ir_context_ir_arena(s->context);
+  IDList *iter;
+  list_for_each(&src->arguments, iter)
+  {
+    IRArgument *src_arg = list_entry(iter, IRArgument, list_node);
+    IRArgument *arg = BUMP_ALLOC(ir_arena, IRArgument);
+    if (!arg)
+      return false;
+    *arg = *src_arg;
+    arg->parent = func;
+    list_init(&arg->value.uses);
+    list_add_tail(&func->arguments, &arg->list_node);
+    if (!ptr_hashmap_put(s->local_remap, &src_arg->value, &arg->value))
+      return false;
+  }
+
+  return list_empty(&src->basic_blocks) || clone_blocks(s, src, func, &func->basic_blocks) != NULL;
+}
+
+IRBasicBlock *
+ir_function_clone_body_into(IRFunction *src, IRFunction *dst, IRBasicBlock *insert_before, PtrHashMap *remap)
+{
+  assert(src != NULL && dst != NULL && remap != NULL);
+  if (!ir_function_materialize(src))
+    return NULL;
+
+  CloneState s = {.context = dst->parent->context, .local_remap = remap};
+  IRBasicBlock *first = clone_blocks(&s, src, dst, insert_before ? &insert_before->list_node : &dst->basic_blocks);
+  if (!first)
+    return NULL;
+
+  /// 复制出的块是 dst 中新的块: 还没有 CFG 编号
+  for (IDList *iter = &first->list_node; iter != (insert_before ? &insert_before->list_node : &dst->basic_blocks);
+       iter = iter->next)
+    list_entry(iter, IRBasicBlock, list_node)->id = -1;
+  return first;
+}
+
+IRModule *
+ir_module_clone(IRModule *src, const char *name)
+{
+  assert(src != NULL);
+  IRContext *ctx = src->context;
+
+  /// 延迟加载的函数体先物化 (克隆不保留加载器的状态)
+  if (!ir_module_materialize_all(src))
+    return NULL;
+
+  IRModule *dst = ir_module_create(ctx, name ? name : src->name);
+  if (!dst)
+    return NULL;
+
+  CloneState s = {.context = ctx};
+  bump_init(&s.scratch);
+  bump_init(&s.local_arena);
+  s.global_remap = ptr_hashmap_create(&s.scratch, 64);
+  bool ok = s.global_remap != NULL;
+
+  /// 1. 所有全局变量和函数头 (函数体和初始值可以引用后面定义的全局符号)
+  IDList *iter;
+  list_for_each(&src->globals, iter)
+  {
+    if (ok)
+      ok = clone_global(&s, dst, list_entry(iter, IRGlobalVariable, list_node)) != NULL;
+  }
+  list_for_each(&src->functions, iter)
+  {
+    if (ok)
+      ok = clone_function_header(&s, dst, list_entry(iter, IRFunction, list_node)) != NULL;
+  }
+
+  /// 2. 全局变量的初始值 (常量原样共享)
+  if (ok)
+  {
+    list_for_each(&dst->globals, iter)
+    {
+      IRGlobalVariable *global = list_entry(iter, IRGlobalVariable, list_node);
+      if (global->initializer)
+        global->initializer = remap_value(&s, global->initializer);
+    }
+  }
+
+  /// 3. 函数体 (两个链表顺序相同)
+  IDList *dst_iter = dst->functions.next;
+  list_for_each(&src->functions, iter)
+  {
+    if (!ok)
+      break;
+    IRFunction *func = list_entry(dst_iter, IRFunction, list_node);
+    dst_iter = dst_iter->next;
+    ok = clone_function_body(&s, list_entry(iter, IRFunction, list_node), func);
+  }
+
+  bump_destroy(&s.local_arena);
+  bump_destroy(&s.scratch);
+  return ok ? dst : NULL;
+}
@@ -20,11 +20,53 @@
 #include "utils/bump.h"
 #include "utils/hashmap.h"
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+/** 下一个上下文的编号 (0 不使用) */
+static atomic_uint_least32_t NEXT_CONTEXT_ID = 1;
+#else
+static uint32_t NEXT_CONTEXT_ID = 1;
+#endif
+
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+
+struct IRContextLock
+{
+  /** 类型缓存和其他很少修改的状态 (可重入) */
+  mtx_t mutex;
+  /** constant_shards[i] 的锁 */
+  mtx_t constant_shards[IR_CONSTANT_CACHE_SHARDS];
+  /** 共享值 Use 链表的锁 (见 ir_context_use_lock_mask) */
+  mtx_t use_stripes[IR_USE_LOCK_STRIPES];
+};
+
+/** 当前线程正在使用的 worker (不是 worker 线程时为 NULL) */
+static _Thread_local IRContextWorker *current_worker = NULL;
+#endif
+
 #define INITIAL_CACHE_CAPACITY 64
 
+/** @brief 分配一个上下文编号 (回绕时跳过 0) */
+static uint32_t
+next_context_id(void)
+{
+  uint32_t id;
+  do
+  {
+#if !defined(__STDC_NO_ATOMICS__)
+    id = (uint32_t)atomic_fetch_add_explicit(&NEXT_CONTEXT_ID, 1, memory_order_relaxed);
+#else
+    id = NEXT_CONTEXT_ID++;
+#endif
+  } while (id == 0);
+  return id;
+}
+
 /*
  * =================================================================
  * --- 私有辅助函数 ---
@@ -158,7 +200,31 @@ ir_context_init_singleton_types(IRContext *ctx)
 }
 
 /**
- * @brief 初始化所有单例常量 (true, false)
+ * @brief [内部] 一次性创建 IR_SMALL_INT_MIN..max 的整数常量 (一个连续数组)
+ */
+static IRConstant *
+small_int_table_create(IRContext *ctx, IRType *type, int64_t max)
+{
+  size_t count = (size_t)(max - IR_SMALL_INT_MIN + 1);
+  IRConstant *table = BUMP_ALLOC_SLICE(&ctx->permanent_arena, IRConstant, count);
+  if (!table)
+    return NULL;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    IRConstant *konst = &table[i];
+    memset(konst, 0, sizeof(*konst));
+    konst->value.kind = IR_KIND_CONSTANT;
+    konst->value.type = type;
+    list_init(&konst->value.uses);
+    konst->const_kind = CONST_KIND_INT;
+    konst->data.int_val = IR_SMALL_INT_MIN + (int64_t)i;
+  }
+  return table;
+}
+
+/**
+ * @brief 初始化所有单例常量 (true, false, 小整数表)
  * @return true 成功, false OOM
  */
 static bool
@@ -173,6 +239,13 @@ ir_context_init_singleton_constants(IRContext *ctx)
   if (!ctx->const_i1_false)
     return false;
 
+  ctx->small_i8_constants = small_int_table_create(ctx, ctx->type_i8, INT8_MAX);
+  ctx->small_i16_constants = small_int_table_create(ctx, ctx->type_i16, IR_SMALL_INT_MAX);
+  ctx->small_i32_constants = small_int_table_create(ctx, ctx->type_i32, IR_SMALL_INT_MAX);
+  ctx->small_i64_constants = small_int_table_create(ctx, ctx->type_i64, IR_SMALL_INT_MAX);
+  if (!ctx->small_i8_constants || !ctx->small_i16_constants || !ctx->small_i32_constants || !ctx->small_i64_constants)
+    return false;
+
   return true;
 }
 
@@ -207,13 +280,6 @@ ir_context_init_caches(IRContext *ctx)
   if (!ctx->function_type_cache)
     return false;
 
-  CREATE_CACHE(i8_hashmap_create, i8_constant_cache);
-  CREATE_CACHE(i16_hashmap_create, i16_constant_cache);
-  CREATE_CACHE(i32_hashmap_create, i32_constant_cache);
-  CREATE_CACHE(i64_hashmap_create, i64_constant_cache);
-  CREATE_CACHE(f32_hashmap_create, f32_constant_cache);
-  CREATE_CACHE(f64_hashmap_create, f64_constant_cache);
-  CREATE_CACHE(ptr_hashmap_create, undef_constant_cache);
 
   CREATE_CACHE(str_hashmap_create, string_intern_cache);
 
@@ -221,6 +287,31 @@ ir_context_init_caches(IRContext *ctx)
   return true;
 }
 
+/**
+ * @brief [内部] 如果当前线程是 ctx 的 worker，返回它
+ */
+static inline IRContextWorker *
+current_worker_of(IRContext *ctx)
+{
+#if !defined(__STDC_NO_THREADS__)
+  if (ctx->lock && current_worker && current_worker->context == ctx)
+    return current_worker;
+#else
+  (void)ctx;
+#endif
+  return NULL;
+}
+
+/**
+ * @brief [内部] 释放常量缓存各分片的 Arena (表和其中的常量)
+ */
+static void
+destroy_constant_shards(IRContext *ctx)
+{
+  for (size_t i = 0; i < IR_CONSTANT_CACHE_SHARDS; i++)
+    bump_destroy(&ctx->constant_shards[i].arena);
+}
+
 /*
  * =================================================================
  * --- 公共 API: 生命周期 ---
@@ -237,10 +328,22 @@ ir_context_create(void)
 
   bump_init(&ctx->permanent_arena);
   bump_init(&ctx->ir_arena);
+  for (size_t i = 0; i < IR_CONSTANT_CACHE_SHARDS; i++)
+  {
+    bump_init(&ctx->constant_shards[i].arena);
+    memset(ctx->constant_shards[i].values, 0, sizeof(ctx->constant_shards[i].values));
+    ctx->constant_shards[i].undefs = NULL;
+  }
+  ctx->lock = NULL;
+  ctx->private_function_arenas = false;
+  list_init(&ctx->function_arenas);
+  ctx->verify_level = IR_VERIFY_FULL;
+  ctx->id = next_context_id();
 
   if (!ir_context_init_caches(ctx))
   {
 
+    destroy_constant_shards(ctx);
     bump_destroy(&ctx->permanent_arena);
     bump_destroy(&ctx->ir_arena);
     free(ctx);
@@ -250,6 +353,7 @@ ir_context_create(void)
   if (!ir_context_init_singleton_types(ctx))
   {
 
+    destroy_constant_shards(ctx);
     bump_destroy(&ctx->permanent_arena);
     bump_destroy(&ctx->ir_arena);
     free(ctx);
@@ -259,6 +363,7 @@ ir_context_create(void)
   if (!ir_context_init_singleton_constants(ctx))
   {
 
+    destroy_constant_shards(ctx);
     bump_destroy(&ctx->permanent_arena);
     bump_destroy(&ctx->ir_arena);
     free(ctx);
@@ -268,12 +373,29 @@ ir_context_create(void)
   return ctx;
 }
 
+/**
+ * @brief [内部] 释放所有函数的私有 Arena (IRFunctionArena 本身在 ir_arena 中)
+ */
+static void
+destroy_function_arenas(IRContext *ctx)
+{
+  IDList *iter;
+  list_for_each(&ctx->function_arenas, iter)
+  {
+    bump_destroy(&list_entry(iter, IRFunctionArena, list_node)->arena);
+  }
+  list_init(&ctx->function_arenas);
+}
+
 void
 ir_context_destroy(IRContext *ctx)
 {
   if (!ctx)
     return;
 
+  ir_context_end_concurrent(ctx);
+  destroy_function_arenas(ctx);
+  destroy_constant_shards(ctx);
   bump_destroy(&ctx->permanent_arena);
   bump_destroy(&ctx->ir_arena);
 
@@ -285,9 +407,25 @@ ir_context_reset_ir_arena(IRContext *ctx)
 {
   assert(ctx != NULL);
 
+  destroy_function_arenas(ctx);
   bump_reset(&ctx->ir_arena);
 }
 
+void
+ir_context_set_private_function_arenas(IRContext *ctx, bool enabled)
+{
+  assert(ctx != NULL);
+  ctx->private_function_arenas = enabled;
+}
+
+void
+ir_context_set_verify_level(IRContext *ctx, IRVerifyLevel level)
+{
+  assert(ctx != NULL);
+  assert(level == IR_VERIFY_STRUCTURAL || level == IR_VERIFY_FULL);
+  ctx->verify_level = level;
+}
+
 /*
  * =================================================================
  * --- 公共 API: 类型 (Types) ---
@@ -338,8 +476,8 @@ ir_type_get_f64(IRContext *ctx)
 /**
  * @brief 创建/获取一个指针类型 (唯一化)
  */
-IRType *
-ir_type_get_ptr(IRContext *ctx, IRType *pointee_type)
+static IRType *
+type_get_ptr_unlocked(IRContext *ctx, IRType *pointee_type)
 {
   assert(ctx != NULL);
   assert(pointee_type != NULL);
@@ -362,11 +500,20 @@ ir_type_get_ptr(IRContext *ctx, IRType *pointee_type)
   return new_ptr_type;
 }
 
+IRType *
+ir_type_get_ptr(IRContext *ctx, IRType *pointee_type)
+{
+  ir_context_lock(ctx);
+  IRType *result = type_get_ptr_unlocked(ctx, pointee_type);
+  ir_context_unlock(ctx);
+  return result;
+}
+
 /**
  * @brief 创建/获取一个数组类型 (唯一化)
  */
-IRType *
-ir_type_get_array(IRContext *ctx, IRType *element_type, size_t element_count)
+static IRType *
+type_get_array_unlocked(IRContext *ctx, IRType *element_type, size_t element_count)
 {
   assert(ctx != NULL);
   assert(element_type != NULL);
@@ -399,11 +546,20 @@ ir_type_get_array(IRContext *ctx, IRType *element_type, size_t element_count)
   return array_type;
 }
 
+IRType *
+ir_type_get_array(IRContext *ctx, IRType *element_type, size_t element_count)
+{
+  ir_context_lock(ctx);
+  IRType *result = type_get_array_unlocked(ctx, element_type, element_count);
+  ir_context_unlock(ctx);
+  return result;
+}
+
 /**
  * @brief 创建/获取一个 *匿名* 结构体 (按成员列表唯一化)
  */
-IRType *
-ir_type_get_anonymous_struct(IRContext *ctx, IRType **member_types, size_t member_count)
+static IRType *
+type_get_anonymous_struct_unlocked(IRContext *ctx, IRType **member_types, size_t member_count)
 {
   assert(ctx != NULL);
 
@@ -432,17 +588,27 @@ ir_type_get_anonymous_struct(IRContext *ctx, IRType **member_types, size_t membe
   return struct_type;
 }
 
+IRType *
+ir_type_get_anonymous_struct(IRContext *ctx, IRType **member_types, size_t member_count)
+{
+  ir_context_lock(ctx);
+  IRType *result = type_get_anonymous_struct_unlocked(ctx, member_types, member_count);
+  ir_context_unlock(ctx);
+  return result;
+}
+
 /**
  * @brief 创建/获取一个 *命名* 结构体 (按名字唯一化)
  */
-IRType *
-ir_type_get_named_struct(IRContext *ctx, const char *name, IRType **member_types, size_t member_count)
+static IRType *
+type_get_named_struct_unlocked(IRContext *ctx, const char *name, IRType **member_types, size_t member_count)
 {
   assert(ctx != NULL);
   assert(name != NULL && "Named struct must have a name");
 
   size_t name_len = strlen(name);
-  IRType *struct_type = (IRType *)str_hashmap_get(ctx->named_struct_cache, name, name_len);
+  uint64_t name_hash = str_hashmap_hash(name, name_len);
+  IRType *struct_type = (IRType *)str_hashmap_get_hashed(ctx->named_struct_cache, name, name_len, name_hash);
 
   if (struct_type)
   {
@@ -468,17 +634,28 @@ ir_type_get_named_struct(IRContext *ctx, const char *name, IRType **member_types
     return NULL;
 
   const char *interned_name = struct_type->as.aggregate.name;
-  str_hashmap_put_preallocated_key(ctx->named_struct_cache, interned_name, strlen(interned_name), (void *)struct_type);
+  str_hashmap_put_preallocated_key_hashed(ctx->named_struct_cache, interned_name, name_len, name_hash,
+                                          (void *)struct_type);
 
   return struct_type;
 }
 
+IRType *
+ir_type_get_named_struct(IRContext *ctx, const char *name, IRType **member_types, size_t member_count)
+{
+  ir_context_lock(ctx);
+  IRType *result = type_get_named_struct_unlocked(ctx, name, member_types, member_count);
+  ir_context_unlock(ctx);
+  return result;
+}
+
 /**
  * @brief [!!] 新增: 创建/获取一个函数类型 (唯一化)
  * (复制 ir_type_get_anonymous_struct 的逻辑)
  */
-IRType *
-ir_type_get_function(IRContext *ctx, IRType *return_type, IRType **param_types, size_t param_count, bool is_variadic)
+static IRType *
+type_get_function_unlocked(IRContext *ctx, IRType *return_type, IRType **param_types, size_t param_count,
+                           bool is_variadic)
 {
   assert(ctx != NULL);
   assert(return_type != NULL);
@@ -511,12 +688,99 @@ ir_type_get_function(IRContext *ctx, IRType *return_type, IRType **param_types,
   return func_type;
 }
 
+IRType *
+ir_type_get_function(IRContext *ctx, IRType *return_type, IRType **param_types, size_t param_count, bool is_variadic)
+{
+  ir_context_lock(ctx);
+  IRType *result = type_get_function_unlocked(ctx, return_type, param_types, param_count, is_variadic);
+  ir_context_unlock(ctx);
+  return result;
+}
+
 /*
  * =================================================================
  * --- 公共 API: 常量 (Constants) ---
  * =================================================================
  */
 
+/**
+ * @brief [内部] 选择分片 (乘法散列的高位；表内部的哈希另算，两者互不相关)
+ */
+static inline size_t
+constant_shard_index(uint64_t key, uint64_t salt)
+{
+  return (size_t)(((key ^ salt) * 0x9E3779B97F4A7C15ull) >> 32) % IR_CONSTANT_CACHE_SHARDS;
+}
+
+#if !defined(__STDC_NO_THREADS__)
+#define LOCK_SHARD(ctx, index)                                                                                         \
+  do                                                                                                                   \
+  {                                                                                                                    \
+    if ((ctx)->lock)                                                                                                   \
+      mtx_lock(&(ctx)->lock->constant_shards[index]);                                                                  \
+  } while (0)
+#define UNLOCK_SHARD(ctx, index)                                                                                       \
+  do                                                                                                                   \
+  {                                                                                                                    \
+    if ((ctx)->lock)                                                                                                   \
+      mtx_unlock(&(ctx)->lock->constant_shards[index]);                                                                \
+  } while (0)
+#else
+#define LOCK_SHARD(ctx, index) ((void)0)
+#define UNLOCK_SHARD(ctx, index) ((void)0)
+#endif
+
+/**
+ * @brief [内部] 在分片中分配一个常量 (调用者持有分片锁)
+ */
+static IRConstant *
+constant_alloc_in_shard(IRConstantShard *shard, IRType *type, IRConstantKind kind)
+{
+  IRConstant *konst = BUMP_ALLOC_ZEROED(&shard->arena, IRConstant);
+  if (!konst)
+    return NULL;
+  konst->value.kind = IR_KIND_CONSTANT;
+  konst->value.type = type;
+  list_init(&konst->value.uses);
+  konst->const_kind = kind;
+  return konst;
+}
+
+/**
+ * @brief [内部] 按位模式查找整数或浮点常量，没有则创建一个
+ *
+ * @param bits 整数的补码，或浮点数 (double) 的位模式
+ */
+static IRValueNode *
+constant_get_scalar(IRContext *ctx, IRConstantTable table, IRType *type, uint64_t bits)
+{
+  size_t index = constant_shard_index(bits, (uint64_t)table);
+  IRConstantShard *shard = &ctx->constant_shards[index];
+  LOCK_SHARD(ctx, index);
+
+  I64HashMap **map = &shard->values[table];
+  IRConstant *konst = *map ? (IRConstant *)i64_hashmap_get(*map, (int64_t)bits) : NULL;
+  if (!konst)
+  {
+    if (!*map)
+      *map = i64_hashmap_create(&shard->arena, INITIAL_CACHE_CAPACITY);
+    bool is_float = table == IR_CONSTANT_TABLE_F32 || table == IR_CONSTANT_TABLE_F64;
+    konst = *map ? constant_alloc_in_shard(shard, type, is_float ? CONST_KIND_FLOAT : CONST_KIND_INT) : NULL;
+    if (konst)
+    {
+      if (is_float)
+        memcpy(&konst->data.float_val, &bits, sizeof(bits));
+      else
+        konst->data.int_val = (int64_t)bits;
+      if (!i64_hashmap_put(*map, (int64_t)bits, konst))
+        konst = NULL;
+    }
+  }
+
+  UNLOCK_SHARD(ctx, index);
+  return konst ? &konst->value : NULL;
+}
+
 /**
  * @brief 获取一个 'undef' 常量 (唯一化)
  */
@@ -526,19 +790,22 @@ ir_constant_get_undef(IRContext *ctx, IRType *type)
   assert(ctx != NULL);
   assert(type != NULL);
 
-  void *cached = ptr_hashmap_get(ctx->undef_constant_cache, (void *)type);
-  if (cached)
+  size_t index = constant_shard_index((uint64_t)(uintptr_t)type, IR_CONSTANT_NUM_TABLES);
+  IRConstantShard *shard = &ctx->constant_shards[index];
+  LOCK_SHARD(ctx, index);
+
+  IRConstant *konst = shard->undefs ? (IRConstant *)ptr_hashmap_get(shard->undefs, type) : NULL;
+  if (!konst)
   {
-    return (IRValueNode *)cached;
+    if (!shard->undefs)
+      shard->undefs = ptr_hashmap_create(&shard->arena, INITIAL_CACHE_CAPACITY);
+    konst = shard->undefs ? constant_alloc_in_shard(shard, type, CONST_KIND_UNDEF) : NULL;
+    if (konst && !ptr_hashmap_put(shard->undefs, type, konst))
+      konst = NULL;
   }
 
-  IRValueNode *new_undef = ir_constant_create_undef(ctx, type);
-  if (!new_undef)
-    return NULL;
-
-  ptr_hashmap_put(ctx->undef_constant_cache, (void *)type, (void *)new_undef);
-
-  return new_undef;
+  UNLOCK_SHARD(ctx, index);
+  return konst ? &konst->value : NULL;
 }
 
 /**
@@ -551,53 +818,47 @@ ir_constant_get_i1(IRContext *ctx, bool value)
   return value ? ctx->const_i1_true : ctx->const_i1_false;
 }
 
-#define DEFINE_GET_INT_CONSTANT(BITS, C_TYPE, HASHMAP_TYPE, HASHMAP_FIELD, GET_FUNC)                                   \
+/**
+ * @brief 获取一个 i8 整数常量 (唯一化)
+ *
+ * 小整数表覆盖 i8 的整个取值范围，不需要哈希表和锁。
+ */
+IRValueNode *
+ir_constant_get_i8(IRContext *ctx, int8_t value)
+{
+  assert(ctx != NULL);
+  return &ctx->small_i8_constants[value - IR_SMALL_INT_MIN].value;
+}
+
+#define DEFINE_GET_INT_CONSTANT(BITS, C_TYPE, TABLE)                                                                   \
   IRValueNode *ir_constant_get_##BITS(IRContext *ctx, C_TYPE value)                                                    \
   {                                                                                                                    \
     assert(ctx != NULL);                                                                                               \
-    /* 1. 检查缓存 */                                                                                                  \
-    void *cached = GET_FUNC(ctx->HASHMAP_FIELD, value);                                                                \
-    if (cached)                                                                                                        \
-    {                                                                                                                  \
-      return (IRValueNode *)cached;                                                                                    \
-    }                                                                                                                  \
-    /* 2. 未命中？创建新常量 */                                                                                        \
-    /* (注意：我们将 C_TYPE 提升为 int64_t 传给构造函数) */                                                            \
-    IRValueNode *new_const = ir_constant_create_int(ctx, ctx->type_##BITS, (int64_t)value);                            \
-    if (!new_const)                                                                                                    \
-      return NULL; /* OOM */                                                                                           \
-    /* 3. 存入缓存 */                                                                                                  \
-    HASHMAP_TYPE##_put(ctx->HASHMAP_FIELD, value, (void *)new_const);                                                  \
-    return new_const;                                                                                                  \
-  }
-
-DEFINE_GET_INT_CONSTANT(i8, int8_t, i8_hashmap, i8_constant_cache, i8_hashmap_get)
-DEFINE_GET_INT_CONSTANT(i16, int16_t, i16_hashmap, i16_constant_cache, i16_hashmap_get)
-DEFINE_GET_INT_CONSTANT(i32, int32_t, i32_hashmap, i32_constant_cache, i32_hashmap_get)
-DEFINE_GET_INT_CONSTANT(i64, int64_t, i64_hashmap, i64_constant_cache, i64_hashmap_get)
-
-#define DEFINE_GET_FLOAT_CONSTANT(BITS, C_TYPE, HASHMAP_TYPE, HASHMAP_FIELD, GET_FUNC)                                 \
+    /* 1. 小整数直接查表 (表在创建上下文时就建好了，只读，不需要锁) */                                                 \
+    uint64_t index = (uint64_t)(int64_t)value - (uint64_t)IR_SMALL_INT_MIN;                                            \
+    if (index <= (uint64_t)(IR_SMALL_INT_MAX - IR_SMALL_INT_MIN))                                                      \
+      return &ctx->small_##BITS##_constants[index].value;                                                              \
+    /* 2. 其他值查分片的常量缓存 (注意：我们将 C_TYPE 提升为 int64_t) */                                               \
+    return constant_get_scalar(ctx, TABLE, ctx->type_##BITS, (uint64_t)(int64_t)value);                                \
+  }
+
+DEFINE_GET_INT_CONSTANT(i16, int16_t, IR_CONSTANT_TABLE_I16)
+DEFINE_GET_INT_CONSTANT(i32, int32_t, IR_CONSTANT_TABLE_I32)
+DEFINE_GET_INT_CONSTANT(i64, int64_t, IR_CONSTANT_TABLE_I64)
+
+#define DEFINE_GET_FLOAT_CONSTANT(BITS, C_TYPE, TABLE)                                                                 \
   IRValueNode *ir_constant_get_##BITS(IRContext *ctx, C_TYPE value)                                                    \
   {                                                                                                                    \
     assert(ctx != NULL);                                                                                               \
-    /* 1. 检查缓存 */                                                                                                  \
-    void *cached = GET_FUNC(ctx->HASHMAP_FIELD, value);                                                                \
-    if (cached)                                                                                                        \
-    {                                                                                                                  \
-      return (IRValueNode *)cached;                                                                                    \
-    }                                                                                                                  \
-    /* 2. 未命中？创建新常量 */                                                                                        \
-    /* (注意：我们将 C_TYPE 提升为 double 传给构造函数) */                                                             \
-    IRValueNode *new_const = ir_constant_create_float(ctx, ctx->type_##BITS, (double)value);                           \
-    if (!new_const)                                                                                                    \
-      return NULL; /* OOM */                                                                                           \
-    /* 3. 存入缓存 */                                                                                                  \
-    HASHMAP_TYPE##_put(ctx->HASHMAP_FIELD, value, (void *)new_const);                                                  \
-    return new_const;                                                                                                  \
-  }
-
-DEFINE_GET_FLOAT_CONSTANT(f32, float, f32_hashmap, f32_constant_cache, f32_hashmap_get)
-DEFINE_GET_FLOAT_CONSTANT(f64, double, f64_hashmap, f64_constant_cache, f64_hashmap_get)
+    /* (注意：我们将 C_TYPE 提升为 double，按它的位模式唯一化) */                                                      \
+    double promoted = (double)value;                                                                                   \
+    uint64_t bits;                                                                                                     \
+    memcpy(&bits, &promoted, sizeof(bits));                                                                            \
+    return constant_get_scalar(ctx, TABLE, ctx->type_##BITS, bits);                                                    \
+  }
+
+DEFINE_GET_FLOAT_CONSTANT(f32, float, IR_CONSTANT_TABLE_F32)
+DEFINE_GET_FLOAT_CONSTANT(f64, double, IR_CONSTANT_TABLE_F64)
 
 /*
  * =================================================================
@@ -610,25 +871,53 @@ DEFINE_GET_FLOAT_CONSTANT(f64, double, f64_hashmap, f64_constant_cache, f64_hash
  */
 const char *
 ir_context_intern_str_slice(IRContext *ctx, const char *str, size_t len)
+{
+  assert(str != NULL || len == 0);
+  return ir_context_intern_str_hashed(ctx, str, len, str_hashmap_hash(str, len));
+}
+
+/**
+ * @brief 用调用者算好的哈希唯一化一个字符串切片
+ */
+const char *
+ir_context_intern_str_hashed(IRContext *ctx, const char *str, size_t len, uint64_t hash)
 {
   assert(ctx != NULL);
   assert(str != NULL || len == 0);
 
-  void *cached = str_hashmap_get(ctx->string_intern_cache, str, len);
+  void *cached = str_hashmap_get_hashed(ctx->string_intern_cache, str, len, hash);
   if (cached)
   {
 
     return (const char *)cached;
   }
 
-  char *new_str = (char *)bump_alloc(&ctx->permanent_arena, len + 1, 1);
-  if (!new_str)
+  /// worker 线程: 共享表在并发期间只读，新字符串放进 worker 自己的表
+  StrHashMap *table = ctx->string_intern_cache;
+  Bump *arena = &ctx->permanent_arena;
+  IRContextWorker *worker = current_worker_of(ctx);
+  if (worker)
+  {
+    cached = str_hashmap_get_hashed(worker->strings, str, len, hash);
+    if (cached)
+      return (const char *)cached;
+    table = worker->strings;
+    arena = &worker->string_arena;
+  }
+
+  /// 头部 (哈希和长度) + 内容 + '\0'
+  IRInternedStrHeader *header =
+    (IRInternedStrHeader *)bump_alloc(arena, sizeof(IRInternedStrHeader) + len + 1, __alignof(IRInternedStrHeader));
+  if (!header)
     return NULL;
 
+  header->hash = hash;
+  header->len = len;
+  char *new_str = (char *)(header + 1);
   memcpy(new_str, str, len);
   new_str[len] = '\0';
 
-  bool put_ok = str_hashmap_put_preallocated_key(ctx->string_intern_cache, new_str, len, (void *)new_str);
+  bool put_ok = str_hashmap_put_preallocated_key_hashed(table, new_str, len, hash, (void *)new_str);
 
   if (!put_ok)
   {
@@ -649,3 +938,303 @@ ir_context_intern_str(IRContext *ctx, const char *str)
   size_t len = strlen(str);
   return ir_context_intern_str_slice(ctx, str, len);
 }
+
+/*
+ * =================================================================
+ * --- 公共 API: 内存统计 ---
+ * =================================================================
+ */
+
+static_assert(IR_CACHE_CONSTANTS_F64 - IR_CACHE_CONSTANTS_I16 == IR_CONSTANT_TABLE_F64,
+              "Constant caches must follow the order of IRConstantTable");
+
+static const char *const CACHE_NAMES[IR_CONTEXT_NUM_CACHES] = {
+  [IR_CACHE_POINTER_TYPES] = "types.pointer",    [IR_CACHE_ARRAY_TYPES] = "types.array",
+  [IR_CACHE_NAMED_STRUCTS] = "types.struct",     [IR_CACHE_ANON_STRUCTS] = "types.anon_struct",
+  [IR_CACHE_FUNCTION_TYPES] = "types.function",  [IR_CACHE_STRINGS] = "strings",
+  [IR_CACHE_CONSTANTS_I16] = "constants.i16",    [IR_CACHE_CONSTANTS_I32] = "constants.i32",
+  [IR_CACHE_CONSTANTS_I64] = "constants.i64",    [IR_CACHE_CONSTANTS_F32] = "constants.f32",
+  [IR_CACHE_CONSTANTS_F64] = "constants.f64",    [IR_CACHE_UNDEFS] = "constants.undef",
+};
+
+const char *
+ir_context_cache_name(IRContextCache cache)
+{
+  return cache < IR_CONTEXT_NUM_CACHES ? CACHE_NAMES[cache] : "unknown";
+}
+
+void
+ir_context_memory_report(const IRContext *ctx, IRContextMemoryReport *report)
+{
+  assert(ctx != NULL && report != NULL);
+  memset(report, 0, sizeof(*report));
+
+  report->permanent_arena = bump_get_usage(&ctx->permanent_arena);
+  report->ir_arena = bump_get_usage(&ctx->ir_arena);
+  IDList *it;
+  list_for_each(&ctx->function_arenas, it)
+  {
+    IRFunctionArena *fa = list_entry(it, IRFunctionArena, list_node);
+    bump_usage_add(&report->function_arenas, bump_get_usage(&fa->arena));
+    report->num_function_arenas++;
+  }
+
+  /// i8 覆盖整个取值范围，其他宽度覆盖 IR_SMALL_INT_MIN..IR_SMALL_INT_MAX
+  size_t small_range = (size_t)(IR_SMALL_INT_MAX - IR_SMALL_INT_MIN + 1);
+  report->small_int_bytes = (256 + 3 * small_range) * sizeof(IRConstant);
+
+  HashMapStats *caches = report->caches;
+  caches[IR_CACHE_POINTER_TYPES] = ptr_hashmap_stats(ctx->pointer_type_cache);
+  caches[IR_CACHE_ARRAY_TYPES] = ptr_hashmap_stats(ctx->array_type_cache);
+  caches[IR_CACHE_NAMED_STRUCTS] = str_hashmap_stats(ctx->named_struct_cache);
+  caches[IR_CACHE_ANON_STRUCTS] = generic_hashmap_stats(ctx->anon_struct_cache);
+  caches[IR_CACHE_FUNCTION_TYPES] = generic_hashmap_stats(ctx->function_type_cache);
+  caches[IR_CACHE_STRINGS] = str_hashmap_stats(ctx->string_intern_cache);
+
+  /// 常量表在第一次用到时才创建，没有创建的表不计入
+  for (size_t i = 0; i < IR_CONSTANT_CACHE_SHARDS; i++)
+  {
+    const IRConstantShard *shard = &ctx->constant_shards[i];
+    bump_usage_add(&report->constant_arenas, bump_get_usage(&shard->arena));
+    for (size_t t = 0; t < IR_CONSTANT_NUM_TABLES; t++)
+    {
+      if (shard->values[t])
+      {
+        HashMapStats stats = i64_hashmap_stats(shard->values[t]);
+        hashmap_stats_add(&caches[IR_CACHE_CONSTANTS_I16 + t], &stats);
+      }
+    }
+    if (shard->undefs)
+    {
+      HashMapStats stats = ptr_hashmap_stats(shard->undefs);
+      hashmap_stats_add(&caches[IR_CACHE_UNDEFS], &stats);
+    }
+  }
+}
+
+static void
+print_arena_usage(FILE *stream, const char *name, BumpUsage usage)
+{
+  double used_pct = usage.reserved_bytes ? 100.0 * (double)usage.used_bytes / (double)usage.reserved_bytes : 0.0;
+  fprintf(stream, "  %-18s %8zu %14zu %14zu %7.1f%%\n", name, usage.num_chunks, usage.used_bytes,
+          usage.reserved_bytes, used_pct);
+}
+
+void
+ir_context_print_memory_report(const IRContextMemoryReport *report, FILE *stream)
+{
+  BumpUsage total = report->permanent_arena;
+  bump_usage_add(&total, report->ir_arena);
+  bump_usage_add(&total, report->constant_arenas);
+  bump_usage_add(&total, report->function_arenas);
+
+  fprintf(stream, "Arenas:\n");
+  fprintf(stream, "  %-18s %8s %14s %14s %8s\n", "arena", "chunks", "used (bytes)", "reserved", "used%");
+  print_arena_usage(stream, "permanent", report->permanent_arena);
+  print_arena_usage(stream, "ir", report->ir_arena);
+  print_arena_usage(stream, "constants", report->constant_arenas);
+  char label[32];
+  snprintf(label, sizeof(label), "functions (%zu)", report->num_function_arenas);
+  print_arena_usage(stream, label, report->function_arenas);
+  print_arena_usage(stream, "total", total);
+  fprintf(stream, "  (small integer constant tables: %zu bytes of the permanent arena)\n", report->small_int_bytes);
+
+  fprintf(stream, "Caches:\n");
+  fprintf(stream, "  %-18s %10s %10s %6s %10s %14s\n", "cache", "entries", "buckets", "load", "tombstones",
+          "bytes");
+  for (int i = 0; i < IR_CONTEXT_NUM_CACHES; i++)
+  {
+    const HashMapStats *stats = &report->caches[i];
+    fprintf(stream, "  %-18s %10zu %10zu %6.2f %10zu %14zu\n", ir_context_cache_name((IRContextCache)i),
+            stats->num_entries, stats->num_buckets, hashmap_stats_load_factor(stats), stats->num_tombstones,
+            stats->bytes);
+  }
+}
+
+/*
+ * =================================================================
+ * --- 公共 API: 并发构建 (Concurrent Construction) ---
+ * =================================================================
+ */
+
+#if !defined(__STDC_NO_THREADS__)
+/**
+ * @brief [内部] 销毁锁 (只销毁已经初始化的前 shards 个分片锁和前 stripes 条 Use 锁)
+ */
+static void
+destroy_lock(struct IRContextLock *lock, size_t shards, size_t stripes)
+{
+  for (size_t i = 0; i < shards; i++)
+    mtx_destroy(&lock->constant_shards[i]);
+  for (size_t i = 0; i < stripes; i++)
+    mtx_destroy(&lock->use_stripes[i]);
+  mtx_destroy(&lock->mutex);
+  free(lock);
+}
+#endif
+
+bool
+ir_context_begin_concurrent(IRContext *ctx)
+{
+  assert(ctx != NULL && ctx->lock == NULL);
+#if !defined(__STDC_NO_THREADS__)
+  struct IRContextLock *lock = (struct IRContextLock *)malloc(sizeof(struct IRContextLock));
+  if (!lock)
+    return false;
+  if (mtx_init(&lock->mutex, mtx_plain | mtx_recursive) != thrd_success)
+  {
+    free(lock);
+    return false;
+  }
+  size_t shards = 0;
+  while (shards < IR_CONSTANT_CACHE_SHARDS && mtx_init(&lock->constant_shards[shards], mtx_plain) == thrd_success)
+    shards++;
+  size_t stripes = 0;
+  while (shards == IR_CONSTANT_CACHE_SHARDS && stripes < IR_USE_LOCK_STRIPES &&
+         mtx_init(&lock->use_stripes[stripes], mtx_plain) == thrd_success)
+    stripes++;
+  if (stripes < IR_USE_LOCK_STRIPES)
+  {
+    destroy_lock(lock, shards, stripes);
+    return false;
+  }
+  ctx->lock = lock;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+ir_context_end_concurrent(IRContext *ctx)
+{
+  assert(ctx != NULL);
+#if !defined(__STDC_NO_THREADS__)
+  if (ctx->lock)
+  {
+    destroy_lock(ctx->lock, IR_CONSTANT_CACHE_SHARDS, IR_USE_LOCK_STRIPES);
+    ctx->lock = NULL;
+  }
+#endif
+}
+
+bool
+ir_context_enter_worker(IRContext *ctx, IRContextWorker *worker)
+{
+  assert(ctx != NULL && ctx->lock != NULL && worker != NULL);
+  worker->context = ctx;
+  bump_init(&worker->ir_arena);
+  bump_init(&worker->string_arena);
+  worker->strings = str_hashmap_create(&worker->string_arena, INITIAL_CACHE_CAPACITY);
+  if (!worker->strings)
+  {
+    bump_destroy(&worker->string_arena);
+    return false;
+  }
+#if !defined(__STDC_NO_THREADS__)
+  current_worker = worker;
+#endif
+  return true;
+}
+
+void
+ir_context_leave_worker(IRContextWorker *worker)
+{
+  assert(worker != NULL);
+#if !defined(__STDC_NO_THREADS__)
+  if (current_worker == worker)
+    current_worker = NULL;
+#endif
+}
+
+void
+ir_context_adopt_worker(IRContext *ctx, IRContextWorker *worker)
+{
+  assert(ctx != NULL && worker != NULL && worker->context == ctx);
+
+  /// 之前的 worker 可能已经驻留了同样的字符串；那时 IR 中会有内容相同的两个副本，
+  /// 之后的驻留总是返回先并入的那个。
+  StrHashMapIter it = str_hashmap_iter(worker->strings);
+  StrHashMapEntry entry;
+  while (str_hashmap_iter_next(&it, &entry))
+  {
+    if (!str_hashmap_contains_hashed(ctx->string_intern_cache, entry.key_body, entry.key_len, entry.key_hash))
+      str_hashmap_put_preallocated_key_hashed(ctx->string_intern_cache, entry.key_body, entry.key_len, entry.key_hash,
+                                              entry.value);
+  }
+  worker->strings = NULL;
+
+  bump_adopt(&ctx->permanent_arena, &worker->string_arena);
+  bump_adopt(&ctx->ir_arena, &worker->ir_arena);
+}
+
+Bump *
+ir_context_ir_arena(IRContext *ctx)
+{
+  IRContextWorker *worker = current_worker_of(ctx);
+  return worker ? &worker->ir_arena : &ctx->ir_arena;
+}
+
+void
+ir_context_lock(IRContext *ctx)
+{
+#if !defined(__STDC_NO_THREADS__)
+  if (ctx->lock)
+    mtx_lock(&ctx->lock->mutex);
+#else
+  (void)ctx;
+#endif
+}
+
+void
+ir_context_unlock(IRContext *ctx)
+{
+#if !defined(__STDC_NO_THREADS__)
+  if (ctx->lock)
+    mtx_unlock(&ctx->lock->mutex);
+#else
+  (void)ctx;
+#endif
+}
+
+uint64_t
+ir_context_use_lock_mask(IRContext *ctx, const IRValueNode *value)
+{
+  if (!ctx->lock)
+    return 0;
+  if (value->kind != IR_KIND_CONSTANT && value->kind != IR_KIND_GLOBAL && value->kind != IR_KIND_FUNCTION)
+    return 0;
+  /// 值按地址散列到一条锁上 (同一个 Value 总是同一条)
+  uint64_t hash = (uint64_t)(uintptr_t)value * 0x9E3779B97F4A7C15ull;
+  return (uint64_t)1 << (hash >> 58);
+}
+
+void
+ir_context_lock_uses(IRContext *ctx, uint64_t mask)
+{
+#if !defined(__STDC_NO_THREADS__)
+  while (mask != 0)
+  {
+    mtx_lock(&ctx->lock->use_stripes[__builtin_ctzll(mask)]);
+    mask &= mask - 1;
+  }
+#else
+  (void)ctx;
+  (void)mask;
+#endif
+}
+
+void
+ir_context_unlock_uses(IRContext *ctx, uint64_t mask)
+{
+#if !defined(__STDC_NO_THREADS__)
+  while (mask != 0)
+  {
+    mtx_unlock(&ctx->lock->use_stripes[__builtin_ctzll(mask)]);
+    mask &= mask - 1;
+  }
+#else
+  (void)ctx;
+  (void)mask;
+#endif
+}
@@ -17,9 +17,11 @@
 #include "ir/function.h"
 #include "ir/basicblock.h"
 #include "ir/context.h"
+#include "ir/instruction.h"
 #include "ir/module.h"
 #include "ir/printer.h"
 #include "ir/type.h"
+#include "ir/use.h"
 #include "ir/value.h"
 #include "utils/bump.h"
 
@@ -37,7 +39,7 @@ ir_argument_create(IRFunction *func, IRType *type, const char *name)
   assert(func != NULL && "Parent function cannot be NULL");
   IRContext *ctx = func->parent->context;
 
-  IRArgument *arg = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRArgument);
+  IRArgument *arg = BUMP_ALLOC_ZEROED(ir_context_ir_arena(ctx), IRArgument);
   if (!arg)
     return NULL;
 
@@ -72,7 +74,7 @@ ir_function_create(IRModule *mod, const char *name, IRType *ret_type)
 {
   assert(mod != NULL && ret_type != NULL);
   IRContext *ctx = mod->context;
-  IRFunction *func = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRFunction);
+  IRFunction *func = BUMP_ALLOC_ZEROED(ir_context_ir_arena(ctx), IRFunction);
   if (!func)
     return NULL;
 
@@ -91,6 +93,9 @@ ir_function_create(IRModule *mod, const char *name, IRType *ret_type)
   func->entry_address.type = NULL;
   func->is_declaration = false;
   func->c_host_func_ptr = NULL;
+  func->materializer = NULL;
+  func->materializer_data = NULL;
+  func->body_arena = NULL;
 
   list_add_tail(&mod->functions, &func->list_node);
   return func;
@@ -133,6 +138,143 @@ ir_function_finalize_signature(IRFunction *func, bool is_variadic)
   func->entry_address.type = ir_type_get_ptr(ctx, func_type);
 }
 
+bool
+ir_function_is_materialized(const IRFunction *func)
+{
+  assert(func != NULL);
+  return func->materializer == NULL;
+}
+
+bool
+ir_function_materialize(IRFunction *func)
+{
+  assert(func != NULL);
+  IRFunctionMaterializer materializer = func->materializer;
+  if (!materializer)
+    return true;
+
+  /// 先清除: 构建过程中 (例如验证函数体时) 的访问不会重入
+  func->materializer = NULL;
+  if (materializer(func, func->materializer_data))
+  {
+    func->materializer_data = NULL;
+    return true;
+  }
+
+  ir_function_clear_body(func);
+  func->materializer = materializer;
+  return false;
+}
+
+void
+ir_function_clear_body(IRFunction *func)
+{
+  assert(func != NULL);
+
+  IDList *bb_it;
+  list_for_each(&func->basic_blocks, bb_it)
+  {
+    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+    IDList *inst_it;
+    list_for_each(&bb->instructions, inst_it)
+    {
+      IRInstruction *inst = list_entry(inst_it, IRInstruction, list_node);
+      while (inst->num_operands > 0)
+      {
+        ir_use_unlink(&inst->operands[inst->num_operands - 1]);
+      }
+    }
+  }
+
+  list_init(&func->basic_blocks);
+  ir_function_mark_modified(func);
+  func->reserved_begin = NULL;
+  func->reserved_end = NULL;
+  if (func->body_arena)
+    bump_reset(&func->body_arena->arena);
+}
+
+/**
+ * @brief [内部] 创建并登记函数的私有 Arena
+ */
+static IRFunctionArena *
+function_arena_create(IRFunction *func)
+{
+  IRContext *ctx = func->parent->context;
+  IRFunctionArena *fa = BUMP_ALLOC(ir_context_ir_arena(ctx), IRFunctionArena);
+  if (!fa)
+    return NULL;
+  bump_init(&fa->arena);
+
+  /// 并行解析时多个 worker 可能同时登记
+  ir_context_lock(ctx);
+  list_add_tail(&ctx->function_arenas, &fa->list_node);
+  ir_context_unlock(ctx);
+
+  func->body_arena = fa;
+  return fa;
+}
+
+bool
+ir_function_use_private_arena(IRFunction *func)
+{
+  assert(func != NULL);
+  assert(list_empty(&func->basic_blocks) && "Function body already allocated in the context arena");
+  return func->body_arena != NULL || function_arena_create(func) != NULL;
+}
+
+Bump *
+ir_function_body_arena(IRFunction *func)
+{
+  IRContext *ctx = func->parent->context;
+  if (!func->body_arena && ctx->private_function_arenas)
+    function_arena_create(func);
+  return func->body_arena ? &func->body_arena->arena : ir_context_ir_arena(ctx);
+}
+
+static_assert(sizeof(IRUse) % _Alignof(IRInstruction) == 0, "Instructions carved from a reservation must stay aligned");
+
+bool
+ir_function_reserve_body(IRFunction *func, size_t num_instructions, size_t num_operands)
+{
+  assert(func != NULL);
+
+  /// sizeof(IRInstruction) 和 sizeof(IRUse) 都是对齐的倍数，按条切分时不会留下空隙
+  size_t size = num_instructions * sizeof(IRInstruction) + num_operands * sizeof(IRUse);
+  char *block = (char *)bump_alloc(ir_function_body_arena(func), size, _Alignof(IRInstruction));
+  if (!block)
+    return false;
+  func->reserved_begin = block;
+  func->reserved_end = block + size;
+  return true;
+}
+
+IRInstruction *
+ir_function_alloc_instruction(IRFunction *func, size_t num_operands)
+{
+  size_t size = sizeof(IRInstruction) + num_operands * sizeof(IRUse);
+  IRInstruction *inst;
+  if (func->reserved_begin && (size_t)(func->reserved_end - func->reserved_begin) >= size)
+  {
+    inst = (IRInstruction *)func->reserved_begin;
+    func->reserved_begin += size;
+  }
+  else
+  {
+    inst = (IRInstruction *)bump_alloc(ir_function_body_arena(func), size, _Alignof(IRInstruction));
+    if (!inst)
+      return NULL;
+  }
+  /// 在用到时才清零 (预留时整块清零会在写入前就把缓存冲掉)
+  memset(inst, 0, size);
+  if (num_operands > 0)
+  {
+    inst->operands = (IRUse *)(inst + 1);
+    inst->operand_capacity = num_operands;
+  }
+  return inst;
+}
+
 /**
  * @brief ir_function_dump
  */
@@ -146,6 +288,13 @@ ir_function_dump(IRFunction *func, IRPrinter *p)
     return;
   }
 
+  ir_function_materialize(func);
+
+  if (p->annotator && p->annotator->annotate_function)
+  {
+    p->annotator->annotate_function(p->annotator->user_data, func, p);
+  }
+
   ir_print_str(p, func->is_declaration ? "declare " : "define ");
 
   ir_type_dump(func->return_type, p);
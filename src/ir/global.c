@@ -43,7 +43,7 @@ ir_global_variable_create(IRModule *mod, const char *name, IRType *allocated_typ
 
   assert(initializer == NULL || initializer->type == allocated_type);
 
-  IRGlobalVariable *global = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRGlobalVariable);
+  IRGlobalVariable *global = BUMP_ALLOC_ZEROED(ir_context_ir_arena(ctx), IRGlobalVariable);
   if (!global)
     return NULL;
 
@@ -101,25 +101,36 @@ ir_fcmp_predicate_to_string(IRFCmpPredicate pred)
   }
 }
 
+size_t
+ir_instruction_get_num_operands(const IRInstruction *inst)
+{
+  assert(inst != NULL);
+  return inst->num_operands;
+}
+
+IRUse *
+ir_instruction_get_operand_use(const IRInstruction *inst, size_t index)
+{
+  assert(inst != NULL);
+  if (index >= inst->num_operands)
+    return NULL;
+  return &inst->operands[index];
+}
+
+IRValueNode *
+ir_instruction_get_operand(const IRInstruction *inst, size_t index)
+{
+  IRUse *use = ir_instruction_get_operand_use(inst, index);
+  return use ? use->value : NULL;
+}
+
 /**
  * @brief (内部) 获取第 N 个操作数
  */
-static IRValueNode *
+static inline IRValueNode *
 get_operand(IRInstruction *inst, int index)
 {
-  IDList *head = &inst->operands;
-  IDList *iter = head->next;
-  while (index > 0 && iter != head)
-  {
-    iter = iter->next;
-    index--;
-  }
-
-  if (iter == head)
-    return NULL;
-
-  IRUse *use = list_entry(iter, IRUse, user_node);
-  return use->value;
+  return ir_instruction_get_operand(inst, (size_t)index);
 }
 
 /**
@@ -179,14 +190,39 @@ ir_instruction_erase_from_parent(IRInstruction *inst)
   }
   assert(list_empty(&inst->result.uses) && "Instruction result still in use!");
 
-  IDList *iter, *temp;
-  list_for_each_safe(&inst->operands, iter, temp)
+  /// 逆序解开，使操作数索引的移除是 O(1)
+  while (inst->num_operands > 0)
   {
-    IRUse *use = list_entry(iter, IRUse, user_node);
-    ir_use_unlink(use);
+    ir_use_unlink(&inst->operands[inst->num_operands - 1]);
   }
 
   list_del(&inst->list_node);
+  ir_function_mark_modified(inst->parent->parent);
+}
+
+/**
+ * @brief [内部] 按链表顺序给块内所有指令重新编号
+ */
+static void
+renumber_block(IRBasicBlock *bb)
+{
+  uint64_t order = 0;
+  IDList *iter;
+  list_for_each(&bb->instructions, iter)
+  {
+    order += IR_INSTRUCTION_ORDER_STEP;
+    list_entry(iter, IRInstruction, list_node)->order = order;
+  }
+  bb->order_valid = true;
+}
+
+bool
+ir_instruction_comes_before(IRInstruction *a, IRInstruction *b)
+{
+  assert(a->parent == b->parent && "Instructions are in different blocks");
+  if (!a->parent->order_valid)
+    renumber_block(a->parent);
+  return a->order < b->order;
 }
 
 /**
@@ -384,7 +420,9 @@ ir_instruction_dump(IRInstruction *inst, IRPrinter *p)
     op1 = get_operand(inst, 0);
     op2 = get_operand(inst, 1);
     assert(op1 && op2 && "icmp needs two operands");
-    ir_printf(p, "icmp %s ", ir_icmp_predicate_to_string(inst->as.icmp.predicate));
+    ir_print_str(p, "icmp ");
+    ir_print_str(p, ir_icmp_predicate_to_string(inst->as.icmp.predicate));
+    ir_print_char(p, ' ');
     ir_value_dump_with_type(op1, p);
     ir_print_str(p, ", ");
     ir_value_dump_with_type(op2, p);
@@ -394,7 +432,9 @@ ir_instruction_dump(IRInstruction *inst, IRPrinter *p)
     op1 = get_operand(inst, 0);
     op2 = get_operand(inst, 1);
     assert(op1 && op2 && "fcmp needs two operands");
-    ir_printf(p, "fcmp %s ", ir_fcmp_predicate_to_string(inst->as.fcmp.predicate));
+    ir_print_str(p, "fcmp ");
+    ir_print_str(p, ir_fcmp_predicate_to_string(inst->as.fcmp.predicate));
+    ir_print_char(p, ' ');
     ir_value_dump_with_type(op1, p);
     ir_print_str(p, ", ");
     ir_value_dump_with_type(op2, p);
@@ -21,6 +21,7 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -36,16 +37,17 @@ is_ident_continue(char c)
   return isalnum(c) || c == '_' || c == '.';
 }
 
+/// 源码不一定以 '\0' 结尾 (例如映射的文件)，越过 buffer_end 时一律读作 '\0'
 static char
 current_char(Lexer *l)
 {
-  return *l->ptr;
+  return l->ptr < l->buffer_end ? *l->ptr : '\0';
 }
 
 static char
 advance(Lexer *l)
 {
-  char c = *l->ptr;
+  char c = current_char(l);
   if (c != '\0')
   {
     l->ptr++;
@@ -56,253 +58,164 @@ advance(Lexer *l)
 static char
 peek_char(Lexer *l)
 {
-  if (*l->ptr == '\0')
+  if (current_char(l) == '\0')
   {
     return '\0';
   }
-  return *(l->ptr + 1);
+  return l->ptr + 1 < l->buffer_end ? *(l->ptr + 1) : '\0';
 }
 
-static void
-skip_comment(Lexer *l)
+/*
+ * =================================================================
+ * --- 批量扫描 (Block Scanning) ---
+ * =================================================================
+ *
+ * 空白、标识符的后续字符和换行一次按 LEX_BLOCK (16) 字节分类 (SSE2 是 x86-64 的基线)，
+ * 得到每类字符的位掩码；不足一个块的尾部 (以及没有 SSE2 的平台) 逐字节处理。
+ * 所有加载都不越过 buffer_end。
+ *
+ * 这里不经 cpu_features() 选用更宽的实现: 标识符和空白通常只有几个字节，
+ * 每次扫描多一次间接调用比 32 字节的块省下的更多。
+ */
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define LEX_BLOCK 16
+typedef __m128i LexVec;
+#define LEX_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define LEX_SPLAT(c) _mm_set1_epi8((char)(c))
+#define LEX_MASK(v) ((uint32_t)_mm_movemask_epi8(v))
+#define LEX_EQ(v, c) _mm_cmpeq_epi8((v), LEX_SPLAT(c))
+#define LEX_GT(a, b) _mm_cmpgt_epi8((a), (b))
+#define LEX_OR(a, b) _mm_or_si128((a), (b))
+#define LEX_AND(a, b) _mm_and_si128((a), (b))
+#endif
+
+#ifdef LEX_BLOCK
+/** @brief 块内所有字节都命中时的掩码 */
+#define LEX_FULL ((uint32_t)(((uint64_t)1 << LEX_BLOCK) - 1))
+
+/// lo <= c <= hi (有符号比较: >= 0x80 的字节是负数，不会落在 ASCII 区间内)
+#define LEX_IN_RANGE(v, lo, hi) LEX_AND(LEX_GT((v), LEX_SPLAT((lo) - 1)), LEX_GT(LEX_SPLAT((hi) + 1), (v)))
+
+/** @brief 块中是标识符后续字符 ([A-Za-z0-9_.]) 的字节 */
+static inline uint32_t
+lex_ident_mask(LexVec v)
+{
+  LexVec lower = LEX_OR(v, LEX_SPLAT(0x20));
+  LexVec alpha = LEX_IN_RANGE(lower, 'a', 'z');
+  LexVec digit = LEX_IN_RANGE(v, '0', '9');
+  return LEX_MASK(LEX_OR(LEX_OR(alpha, digit), LEX_OR(LEX_EQ(v, '_'), LEX_EQ(v, '.'))));
+}
+#endif
+
+/**
+ * @brief 返回从 p 开始的第一个不是标识符后续字符的位置
+ */
+static const char *
+scan_ident_continue(const char *p, const char *end)
 {
-  while (current_char(l) != '\n' && current_char(l) != '\0')
+#ifdef LEX_BLOCK
+  while (end - p >= LEX_BLOCK)
   {
-    advance(l);
+    uint32_t stop = ~lex_ident_mask(LEX_LOAD(p)) & LEX_FULL;
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += LEX_BLOCK;
   }
+#endif
+  while (p < end && is_ident_continue(*p))
+    p++;
+  return p;
 }
 
+/**
+ * @brief 跳过一段连续的空格 / 制表符 / 回车 / 换行，并更新行号与行首
+ */
 static void
-skip_whitespace(Lexer *l)
+skip_blanks(Lexer *l)
 {
-  while (true)
+  const char *p = l->ptr;
+#ifdef LEX_BLOCK
+  while (l->buffer_end - p >= LEX_BLOCK)
   {
-    char c = current_char(l);
-    switch (c)
+    LexVec v = LEX_LOAD(p);
+    uint32_t newlines = LEX_MASK(LEX_EQ(v, '\n'));
+    uint32_t blanks = newlines | LEX_MASK(LEX_OR(LEX_OR(LEX_EQ(v, ' '), LEX_EQ(v, '\t')), LEX_EQ(v, '\r')));
+    uint32_t stop = ~blanks & LEX_FULL;
+    /// 第一个非空白字节之前的换行属于这段空白
+    uint32_t run = stop ? (stop & (0 - stop)) - 1 : LEX_FULL;
+    uint32_t run_newlines = newlines & run;
+    if (run_newlines)
+    {
+      l->line += __builtin_popcount(run_newlines);
+      l->line_start = p + (31 - __builtin_clz(run_newlines)) + 1;
+    }
+    if (stop)
+    {
+      l->ptr = p + __builtin_ctz(stop);
+      return;
+    }
+    p += LEX_BLOCK;
+  }
+#endif
+  for (; p < l->buffer_end; p++)
+  {
+    char c = *p;
+    if (c == '\n')
     {
-    case ' ':
-    case '\t':
-    case '\r':
-      advance(l);
-      break;
-    case '\n':
-      advance(l);
       l->line++;
-      l->line_start = l->ptr;
-      break;
-    case ';':
-      skip_comment(l);
+      l->line_start = p + 1;
+    }
+    else if (c != ' ' && c != '\t' && c != '\r')
+    {
       break;
-    default:
-      return;
     }
   }
+  l->ptr = p;
+}
+
+static void
+skip_comment(Lexer *l)
+{
+  /// 注释延伸到行尾 (换行本身留给 skip_blanks 计数)
+  const char *newline = memchr(l->ptr, '\n', (size_t)(l->buffer_end - l->ptr));
+  l->ptr = newline ? newline : l->buffer_end;
 }
 
+static void
+skip_whitespace(Lexer *l)
+{
+  while (true)
+  {
+    skip_blanks(l);
+    if (current_char(l) != ';')
+      return;
+    skip_comment(l);
+  }
+}
+
+#include "lexer_keywords.inc"
+
 /**
- * @brief 检查一个标识符是否为关键字
+ * @brief 检查一个标识符切片是否为关键字
  *
- * (这是一个简单的实现；更快的实现会使用 gperf)
+ * 使用 scripts/gen_keywords.py 生成的完美哈希表: 一次哈希定位唯一的候选，
+ * 再按长度 + memcmp 比较，因此切片不需要以 '\0' 结尾。
  */
 static TokenType
-lookup_keyword(const char *ident)
+lookup_keyword(const char *start, size_t len)
 {
+  if (len > KEYWORD_MAX_LEN)
+    return TK_IDENT;
 
-  switch (ident[0])
-  {
-  case 'a':
-    if (strcmp(ident, "add") == 0)
-      return TK_KW_ADD;
-    if (strcmp(ident, "alloc") == 0)
-      return TK_KW_ALLOCA;
-    if (strcmp(ident, "and") == 0)
-      return TK_KW_AND;
-    if (strcmp(ident, "ashr") == 0)
-      return TK_KW_ASHR;
-    break;
-  case 'b':
-    if (strcmp(ident, "br") == 0)
-      return TK_KW_BR;
-    if (strcmp(ident, "bitcast") == 0)
-      return TK_KW_BITCAST;
-    break;
-  case 'c':
-    if (strcmp(ident, "call") == 0)
-      return TK_KW_CALL;
-
-    break;
-  case 'd':
-    if (strcmp(ident, "define") == 0)
-      return TK_KW_DEFINE;
-    if (strcmp(ident, "default") == 0)
-      return TK_KW_DEFAULT;
-    if (strcmp(ident, "declare") == 0)
-      return TK_KW_DECLARE;
-    break;
-  case 'e':
-    if (strcmp(ident, "eq") == 0)
-      return TK_KW_EQ;
-    break;
-  case 'f':
-    if (strcmp(ident, "fadd") == 0)
-      return TK_KW_FADD;
-    if (strcmp(ident, "fsub") == 0)
-      return TK_KW_FSUB;
-    if (strcmp(ident, "fmul") == 0)
-      return TK_KW_FMUL;
-    if (strcmp(ident, "fdiv") == 0)
-      return TK_KW_FDIV;
-    if (strcmp(ident, "fcmp") == 0)
-      return TK_KW_FCMP;
-    if (strcmp(ident, "false") == 0)
-      return TK_KW_FALSE;
-    if (strcmp(ident, "fptrunc") == 0)
-      return TK_KW_FPTRUNC;
-    if (strcmp(ident, "fpext") == 0)
-      return TK_KW_FPEXT;
-    if (strcmp(ident, "fptoui") == 0)
-      return TK_KW_FPTOUI;
-    if (strcmp(ident, "fptosi") == 0)
-      return TK_KW_FPTOSI;
-    break;
-  case 'g':
-    if (strcmp(ident, "global") == 0)
-      return TK_KW_GLOBAL;
-    if (strcmp(ident, "gep") == 0)
-      return TK_KW_GEP;
-    break;
-  case 'i':
-    if (strcmp(ident, "icmp") == 0)
-      return TK_KW_ICMP;
-    if (strcmp(ident, "inbounds") == 0)
-      return TK_KW_INBOUNDS;
-    if (strcmp(ident, "inttoptr") == 0)
-      return TK_KW_INTTOPTR;
-    break;
-  case 'l':
-    if (strcmp(ident, "load") == 0)
-      return TK_KW_LOAD;
-    if (strcmp(ident, "lshr") == 0)
-      return TK_KW_LSHR;
-    break;
-  case 'm':
-    if (strcmp(ident, "module") == 0)
-      return TK_KW_MODULE;
-    if (strcmp(ident, "mul") == 0)
-      return TK_KW_MUL;
-    break;
-  case 'n':
-    if (strcmp(ident, "ne") == 0)
-      return TK_KW_NE;
-    if (strcmp(ident, "null") == 0)
-      return TK_KW_NULL;
-    break;
-  case 'o':
-    if (strcmp(ident, "or") == 0)
-      return TK_KW_OR;
-    if (strcmp(ident, "oeq") == 0)
-      return TK_KW_OEQ;
-    if (strcmp(ident, "ogt") == 0)
-      return TK_KW_OGT;
-    if (strcmp(ident, "oge") == 0)
-      return TK_KW_OGE;
-    if (strcmp(ident, "olt") == 0)
-      return TK_KW_OLT;
-    if (strcmp(ident, "ole") == 0)
-      return TK_KW_OLE;
-    if (strcmp(ident, "one") == 0)
-      return TK_KW_ONE;
-    if (strcmp(ident, "ord") == 0)
-      return TK_KW_ORD;
-    break;
-  case 'p':
-    if (strcmp(ident, "phi") == 0)
-      return TK_KW_PHI;
-    if (strcmp(ident, "ptrtoint") == 0)
-      return TK_KW_PTRTOINT;
-    break;
-  case 'r':
-    if (strcmp(ident, "ret") == 0)
-      return TK_KW_RET;
-    break;
-  case 's':
-    if (strcmp(ident, "select") == 0)
-      return TK_KW_SELECT;
-    if (strcmp(ident, "sub") == 0)
-      return TK_KW_SUB;
-    if (strcmp(ident, "sdiv") == 0)
-      return TK_KW_SDIV;
-    if (strcmp(ident, "srem") == 0)
-      return TK_KW_SREM;
-    if (strcmp(ident, "shl") == 0)
-      return TK_KW_SHL;
-    if (strcmp(ident, "store") == 0)
-      return TK_KW_STORE;
-    if (strcmp(ident, "switch") == 0)
-      return TK_KW_SWITCH;
-    if (strcmp(ident, "sext") == 0)
-      return TK_KW_SEXT;
-    if (strcmp(ident, "sitofp") == 0)
-      return TK_KW_SITOFP;
-    if (strcmp(ident, "sgt") == 0)
-      return TK_KW_SGT;
-    if (strcmp(ident, "sge") == 0)
-      return TK_KW_SGE;
-    if (strcmp(ident, "slt") == 0)
-      return TK_KW_SLT;
-    if (strcmp(ident, "sle") == 0)
-      return TK_KW_SLE;
-    break;
-  case 't':
-    if (strcmp(ident, "type") == 0)
-      return TK_KW_TYPE;
-    if (strcmp(ident, "trunc") == 0)
-      return TK_KW_TRUNC;
-    if (strcmp(ident, "to") == 0)
-      return TK_KW_TO;
-    if (strcmp(ident, "true") == 0)
-      return TK_KW_TRUE;
-    break;
-  case 'u':
-    if (strcmp(ident, "udiv") == 0)
-      return TK_KW_UDIV;
-    if (strcmp(ident, "urem") == 0)
-      return TK_KW_UREM;
-    if (strcmp(ident, "uitofp") == 0)
-      return TK_KW_UITOFP;
-    if (strcmp(ident, "ugt") == 0)
-      return TK_KW_UGT;
-    if (strcmp(ident, "uge") == 0)
-      return TK_KW_UGE;
-    if (strcmp(ident, "ult") == 0)
-      return TK_KW_ULT;
-    if (strcmp(ident, "ule") == 0)
-      return TK_KW_ULE;
-    if (strcmp(ident, "ueq") == 0)
-      return TK_KW_UEQ;
-    if (strcmp(ident, "une") == 0)
-      return TK_KW_UNE;
-    if (strcmp(ident, "uno") == 0)
-      return TK_KW_UNO;
-    if (strcmp(ident, "undef") == 0)
-      return TK_KW_UNDEF;
-    break;
-  case 'v':
-    if (strcmp(ident, "void") == 0)
-      return TK_KW_VOID;
-    break;
-  case 'x':
-    if (strcmp(ident, "xor") == 0)
-      return TK_KW_XOR;
-    break;
-  case 'z':
-    if (strcmp(ident, "zext") == 0)
-      return TK_KW_ZEXT;
-    if (strcmp(ident, "zeroinitializer") == 0)
-      return TK_KW_ZEROINITIALIZER;
-    break;
-  }
+  uint8_t slot = KEYWORD_SLOTS[keyword_hash(start, len)];
+  if (slot == 0)
+    return TK_IDENT;
 
+  const KeywordEntry *kw = &KEYWORD_ENTRIES[slot - 1];
+  if (kw->len == len && memcmp(kw->name, start, len) == 0)
+    return kw->type;
   return TK_IDENT;
 }
 
@@ -316,21 +229,17 @@ parse_ident(Lexer *l, Token *out_token)
 {
   const char *start = l->ptr;
 
-  advance(l);
-
-  while (is_ident_continue(current_char(l)))
-  {
-    advance(l);
-  }
+  l->ptr = scan_ident_continue(start + 1, l->buffer_end);
   size_t len = l->ptr - start;
 
-  const char *interned_ident = ir_context_intern_str_slice(l->context, start, len);
-
-  out_token->type = lookup_keyword(interned_ident);
+  /// 先在源码切片上查关键字，只有真正的标识符才需要驻留
+  out_token->type = lookup_keyword(start, len);
 
   if (out_token->type == TK_IDENT)
   {
-    out_token->as.ident_val = interned_ident;
+    out_token->ident_hash = str_hashmap_hash(start, len);
+    out_token->as.ident_val = ir_context_intern_str_hashed(l->context, start, len, out_token->ident_hash);
+    out_token->ident_len = len;
   }
   else
   {
@@ -340,9 +249,9 @@ parse_ident(Lexer *l, Token *out_token)
 }
 
 /**
- * @brief [内部] 解析 TK_GLOBAL_IDENT 或 TK_LOCAL_IDENT
+ * @brief [内部] 解析 TK_GLOBAL_IDENT、TK_LOCAL_IDENT 或 TK_LABEL_IDENT
  * @param l Lexer
- * @param type (TK_GLOBAL_IDENT 或 TK_LOCAL_IDENT)
+ * @param type (TK_GLOBAL_IDENT、TK_LOCAL_IDENT 或 TK_LABEL_IDENT)
  * @param out_token [输出] 存储结果的 Token
  */
 static void
@@ -357,14 +266,18 @@ parse_global_or_local(Lexer *l, TokenType type, Token *out_token)
     return;
   }
 
-  while (is_ident_continue(current_char(l)))
-  {
-    advance(l);
-  }
+  l->ptr = scan_ident_continue(start, l->buffer_end);
   size_t len = l->ptr - start;
 
   out_token->type = type;
-  out_token->as.ident_val = ir_context_intern_str_slice(l->context, start, len);
+  out_token->ident_len = len;
+  /// 哈希只算这一次: 驻留、解析器的符号表查找都复用它
+  out_token->ident_hash = str_hashmap_hash(start, len);
+  /// 局部名和标签只在所在函数内有意义：留作源码切片，由解析器决定是否驻留
+  if (type == TK_GLOBAL_IDENT)
+    out_token->as.ident_val = ir_context_intern_str_hashed(l->context, start, len, out_token->ident_hash);
+  else
+    out_token->as.ident_val = start;
 }
 
 /**
@@ -445,8 +358,9 @@ parse_string(Lexer *l, Token *out_token)
   advance(l);
 
   out_token->type = TK_STRING_LITERAL;
-
-  out_token->as.ident_val = ir_context_intern_str_slice(l->context, start, len);
+  out_token->ident_len = len;
+  out_token->ident_hash = str_hashmap_hash(start, len);
+  out_token->as.ident_val = ir_context_intern_str_hashed(l->context, start, len, out_token->ident_hash);
 }
 
 /**
@@ -540,7 +454,7 @@ lexer_scan_token(Lexer *l, Token *out_token)
       parse_ident(l, out_token);
     }
 
-    else if (isdigit(c) || (c == '-' && isdigit(peek_char(l))))
+    else if (isdigit(c) || (c == '-' && isdigit(current_char(l))))
     {
 
       l->ptr--;
@@ -560,10 +474,21 @@ lexer_scan_token(Lexer *l, Token *out_token)
  */
 void
 ir_lexer_init(Lexer *lexer, const char *buffer, IRContext *ctx)
+{
+  assert(buffer);
+  ir_lexer_init_slice(lexer, buffer, strlen(buffer), ctx);
+}
+
+/**
+ * @brief 在长度为 len 的源码切片上初始化 Lexer (切片不需要以 '\0' 结尾)
+ */
+void
+ir_lexer_init_slice(Lexer *lexer, const char *buffer, size_t len, IRContext *ctx)
 {
   assert(lexer && buffer && ctx);
   lexer->context = ctx;
   lexer->buffer_start = buffer;
+  lexer->buffer_end = buffer + len;
   lexer->ptr = buffer;
   lexer->line = 1;
   lexer->line_start = buffer;
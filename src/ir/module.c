@@ -23,11 +23,17 @@
 #include "utils/bump.h"
 #include "utils/hashmap.h"
 #include "utils/string_buf.h"
+#include "utils/string_rope.h"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
 /**
  * @brief 创建一个新模块 (Module)
  */
@@ -36,7 +42,7 @@ ir_module_create(IRContext *ctx, const char *name)
 {
   assert(ctx != NULL && "IRContext cannot be NULL");
 
-  IRModule *mod = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRModule);
+  IRModule *mod = BUMP_ALLOC_ZEROED(ir_context_ir_arena(ctx), IRModule);
   if (!mod)
   {
     return NULL;
@@ -57,18 +63,28 @@ ir_module_create(IRContext *ctx, const char *name)
   return mod;
 }
 
-/**
- * @brief [内部机制] 核心 dump 函数
- */
-void
-ir_module_dump_internal(IRModule *mod, IRPrinter *p)
+bool
+ir_module_materialize_all(IRModule *mod)
 {
-  if (!mod)
+  assert(mod != NULL);
+
+  bool ok = true;
+  IDList *iter;
+  list_for_each(&mod->functions, iter)
   {
-    ir_print_str(p, "; <null module>\n");
-    return;
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (!ir_function_materialize(func))
+      ok = false;
   }
+  return ok;
+}
 
+/**
+ * @brief [内部] 打印模块名、命名结构体和全局变量 (函数之前的部分)
+ */
+static void
+module_dump_header(IRModule *mod, IRPrinter *p)
+{
   ir_printf(p, "module = \"%s\"\n", mod->name);
   ir_print_str(p, "\n");
 
@@ -84,7 +100,8 @@ ir_module_dump_internal(IRModule *mod, IRPrinter *p)
 
       if (type->kind == IR_TYPE_STRUCT && type->as.aggregate.name)
       {
-        ir_printf(p, "%%%s = type ", type->as.aggregate.name);
+        ir_print_name(p, '%', type->as.aggregate.name);
+        ir_print_str(p, " = type ");
         ir_print_str(p, "{ ");
 
         for (size_t i = 0; i < type->as.aggregate.member_count; i++)
@@ -111,6 +128,21 @@ ir_module_dump_internal(IRModule *mod, IRPrinter *p)
   {
     ir_print_str(p, "\n");
   }
+}
+
+/**
+ * @brief [内部机制] 核心 dump 函数
+ */
+void
+ir_module_dump_internal(IRModule *mod, IRPrinter *p)
+{
+  if (!mod)
+  {
+    ir_print_str(p, "; <null module>\n");
+    return;
+  }
+
+  module_dump_header(mod, p);
 
   IDList *iter_func;
   list_for_each(&mod->functions, iter_func)
@@ -120,6 +152,178 @@ ir_module_dump_internal(IRModule *mod, IRPrinter *p)
   }
 }
 
+/*
+ * --- 并行打印 ---
+ */
+
+/** @brief 一个函数打印出的文本 */
+typedef struct FunctionText
+{
+  const char *data;
+  size_t len;
+} FunctionText;
+
+/** @brief 所有 worker 共享的任务 */
+typedef struct DumpJob
+{
+  IRFunction **functions;
+  FunctionText *texts;
+  size_t num_functions;
+  const IRPrinterAnnotator *annotator;
+#if !defined(__STDC_NO_THREADS__)
+  /** 下一个要领取的函数 */
+  atomic_size_t next;
+#else
+  size_t next;
+#endif
+} DumpJob;
+
+/** @brief 一个 worker 的私有状态: 它打印的文本都放在自己的 arena 中 (BumpGroup 的一员) */
+typedef struct DumpWorker
+{
+  DumpJob *job;
+  Bump *arena;
+} DumpWorker;
+
+/**
+ * @brief 不断领取函数并打印到 worker 自己的 StringBuf 中，直到全部领完
+ */
+static int
+dump_worker_run(void *arg)
+{
+  DumpWorker *w = (DumpWorker *)arg;
+  DumpJob *job = w->job;
+  while (true)
+  {
+#if !defined(__STDC_NO_THREADS__)
+    size_t index = atomic_fetch_add(&job->next, 1);
+#else
+    size_t index = job->next++;
+#endif
+    if (index >= job->num_functions)
+      return 0;
+
+    StringBuf buf;
+    string_buf_init(&buf, w->arena);
+    IRPrinter printer;
+    ir_printer_init_string_buf(&printer, &buf);
+    ir_printer_set_annotator(&printer, job->annotator);
+    ir_function_dump(job->functions[index], &printer);
+    job->texts[index].data = string_buf_get(&buf);
+    job->texts[index].len = buf.len;
+  }
+}
+
+#if !defined(__STDC_NO_THREADS__)
+/**
+ * @brief 在 workers[1..] 各自的线程和调用线程 (workers[0]) 上打印函数
+ *
+ * 线程启动失败时剩下的 worker 不参与，函数由已经启动的 worker 分担。
+ */
+static void
+dump_run_threads(DumpWorker *workers, size_t num_workers)
+{
+  thrd_t *threads = (thrd_t *)malloc((num_workers - 1) * sizeof(thrd_t));
+  size_t started = 0;
+  if (threads)
+  {
+    while (started < num_workers - 1 &&
+           thrd_create(&threads[started], dump_worker_run, &workers[started + 1]) == thrd_success)
+    {
+      started++;
+    }
+  }
+
+  dump_worker_run(&workers[0]);
+
+  for (size_t i = 0; i < started; i++)
+  {
+    thrd_join(threads[i], NULL);
+  }
+  free(threads);
+}
+#endif
+
+void
+ir_module_dump_internal_parallel(IRModule *mod, IRPrinter *p, size_t num_threads)
+{
+#if defined(__STDC_NO_THREADS__)
+  num_threads = 1;
+#endif
+  size_t num_functions = 0;
+  IDList *iter;
+  if (mod)
+  {
+    list_for_each(&mod->functions, iter)
+    {
+      num_functions++;
+    }
+  }
+  if (num_threads > num_functions)
+    num_threads = num_functions;
+  if (num_threads <= 1)
+  {
+    ir_module_dump_internal(mod, p);
+    return;
+  }
+
+  /// 物化会修改 Context，所以必须在启动线程之前完成 (失败的函数照常打印)
+  ir_module_materialize_all(mod);
+
+  IRFunction **functions = (IRFunction **)malloc(num_functions * sizeof(IRFunction *));
+  FunctionText *texts = (FunctionText *)calloc(num_functions, sizeof(FunctionText));
+  DumpWorker *workers = (DumpWorker *)calloc(num_threads, sizeof(DumpWorker));
+  /// 文本在所有 worker 结束之后才拼接，所以 Arena 组不需要父 Arena
+  BumpGroup arenas;
+  if (!functions || !texts || !workers || !bump_group_init(&arenas, NULL, num_threads))
+  {
+    free(workers);
+    free(texts);
+    free(functions);
+    ir_module_dump_internal(mod, p);
+    return;
+  }
+
+  size_t index = 0;
+  list_for_each(&mod->functions, iter)
+  {
+    functions[index++] = list_entry(iter, IRFunction, list_node);
+  }
+
+  DumpJob job;
+  job.functions = functions;
+  job.texts = texts;
+  job.num_functions = num_functions;
+  job.annotator = p->annotator;
+#if !defined(__STDC_NO_THREADS__)
+  atomic_init(&job.next, 0);
+#else
+  job.next = 0;
+#endif
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    workers[i].job = &job;
+    workers[i].arena = bump_group_local(&arenas, i);
+  }
+
+#if !defined(__STDC_NO_THREADS__)
+  dump_run_threads(workers, num_threads);
+#else
+  dump_worker_run(&workers[0]);
+#endif
+
+  module_dump_header(mod, p);
+  for (size_t i = 0; i < num_functions; i++)
+  {
+    ir_print_mem(p, texts[i].data, texts[i].len);
+  }
+
+  bump_group_finish(&arenas);
+  free(workers);
+  free(texts);
+  free(functions);
+}
+
 /*
  * --- [!!] 新的公共 API 实现 [!!] ---
  */
@@ -131,24 +335,78 @@ void
 ir_module_dump_to_file(IRModule *mod, FILE *stream)
 {
   IRPrinter p;
-  ir_printer_init_file(&p, stream);
+  ir_printer_init_file_buffered(&p, stream);
   ir_module_dump_internal(mod, &p);
+  ir_printer_destroy(&p);
 }
 
 /**
- * @brief [策略 2] 打印到 StringBuf*
+ * @brief [内部] 在临时 Arena 上打印到 StringRope，再按准确的长度展平到 arena
+ *
+ * arena 中只留下最终的字符串 (StringBuf 每次增长留下的旧副本和 chunk 都随临时 Arena 释放)。
+ */
+static const char *
+module_dump_flattened(IRModule *mod, Bump *arena, size_t num_threads)
+{
+  Bump scratch;
+  bump_init(&scratch);
+  StringRope rope;
+  string_rope_init(&rope, &scratch);
+  ir_module_dump_to_rope_parallel(mod, &rope, num_threads);
+
+  const char *text = string_rope_failed(&rope) ? NULL : string_rope_flatten(&rope, arena);
+  bump_destroy(&scratch);
+  return text;
+}
+
+/**
+ * @brief [策略 2] 打印到字符串
  */
 const char *
 ir_module_dump_to_string(IRModule *mod, Bump *arena)
 {
+  return module_dump_flattened(mod, arena, 1);
+}
 
-  StringBuf buf;
-  string_buf_init(&buf, arena);
+/**
+ * @brief [策略 4] 打印到 StringRope*
+ */
+void
+ir_module_dump_to_rope(IRModule *mod, StringRope *rope)
+{
+  IRPrinter p;
+  ir_printer_init_string_rope(&p, rope);
+  ir_module_dump_internal(mod, &p);
+}
 
+/**
+ * @brief [策略 1] 并行打印到 FILE*
+ */
+void
+ir_module_dump_to_file_parallel(IRModule *mod, FILE *stream, size_t num_threads)
+{
   IRPrinter p;
-  ir_printer_init_string_buf(&p, &buf);
+  ir_printer_init_file_buffered(&p, stream);
+  ir_module_dump_internal_parallel(mod, &p, num_threads);
+  ir_printer_destroy(&p);
+}
 
-  ir_module_dump_internal(mod, &p);
+/**
+ * @brief [策略 2] 并行打印到字符串
+ */
+const char *
+ir_module_dump_to_string_parallel(IRModule *mod, Bump *arena, size_t num_threads)
+{
+  return module_dump_flattened(mod, arena, num_threads);
+}
 
-  return string_buf_get(&buf);
-}
\ No newline at end of file
+/**
+ * @brief [策略 4] 并行打印到 StringRope*
+ */
+void
+ir_module_dump_to_rope_parallel(IRModule *mod, StringRope *rope, size_t num_threads)
+{
+  IRPrinter p;
+  ir_printer_init_string_rope(&p, rope);
+  ir_module_dump_internal_parallel(mod, &p, num_threads);
+}
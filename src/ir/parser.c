@@ -27,24 +27,34 @@
 #include "ir/lexer.h"
 #include "ir/module.h"
 #include "ir/type.h"
+#include "ir/use.h"
 #include "ir/value.h"
 #include "ir/verifier.h"
 #include "utils/bump.h"
 #include "utils/hashmap.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
+#include "utils/mapped_file.h"
+#include "utils/small_vec.h"
 #include "utils/temp_vec.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
 static const char *token_type_to_string(TokenType type);
 static void parser_error_at(Parser *p, const Token *tok, const char *format, ...);
 static void parser_error(Parser *p, const char *message);
-static void print_parse_error(Parser *p, const char *source_buffer);
+static void print_parse_error(Parser *p, const char *source, size_t source_len, size_t first_line);
 static const Token *current_token(Parser *p);
 static void advance(Parser *p);
 static bool match(Parser *p, TokenType type);
@@ -52,6 +62,11 @@ static bool expect(Parser *p, TokenType type);
 static bool expect_ident(Parser *p, const char *ident_str);
 static IRValueNode *parser_find_value(Parser *p, Token *tok);
 static void parser_record_value(Parser *p, Token *tok, IRValueNode *val);
+
+/// 参数 / 成员类型和操作数列表: 几乎都只有几个元素，放在栈上，超出时才用 temp_arena
+SMALL_VEC_DEFINE(TypeVec, type_vec, IRType *, 8)
+SMALL_VEC_DEFINE(ValueVec, value_vec, IRValueNode *, 8)
+
 /*
  * =================================================================
  * --- 调试辅助 (Debug Helpers) ---
@@ -312,18 +327,21 @@ parser_error(Parser *p, const char *message)
  * @brief 在解析失败后，打印详细的诊断信息
  *
  * @param p 解析失败的 Parser
- * @param source_buffer 完整的源文件 C 字符串
+ * @param source 完整的源码 (不一定以 '\0' 结尾)
+ * @param source_len 源码长度
+ * @param first_line source 第一行在整个输入中的行号 (流式解析时大于 1)
  */
 static void
-print_parse_error(Parser *p, const char *source_buffer)
+print_parse_error(Parser *p, const char *source, size_t source_len, size_t first_line)
 {
   if (!p->has_error)
     return;
 
-  const char *line_start = source_buffer;
+  const char *source_end = source + source_len;
+  const char *line_start = source;
   for (size_t i = 1; i < p->error.line; ++i)
   {
-    line_start = strchr(line_start, '\n');
+    line_start = memchr(line_start, '\n', (size_t)(source_end - line_start));
     if (!line_start)
     {
 
@@ -333,19 +351,20 @@ print_parse_error(Parser *p, const char *source_buffer)
     line_start++;
   }
 
-  const char *line_end = strchr(line_start, '\n');
+  const char *line_end = memchr(line_start, '\n', (size_t)(source_end - line_start));
   if (!line_end)
   {
-    line_end = line_start + strlen(line_start);
+    line_end = source_end;
   }
 
   int line_len = (int)(line_end - line_start);
+  size_t line = p->error.line + first_line - 1;
 
   fprintf(stderr, "\n--- Parse Error ---\n");
-  fprintf(stderr, "Error: %zu:%zu: %s\n", p->error.line, p->error.column, p->error.message);
+  fprintf(stderr, "Error: %zu:%zu: %s\n", line, p->error.column, p->error.message);
 
   fprintf(stderr, "  |\n");
-  fprintf(stderr, "%zu | %.*s\n", p->error.line, line_len, line_start);
+  fprintf(stderr, "%zu | %.*s\n", line, line_len, line_start);
   fprintf(stderr, "  | ");
 
   for (size_t i = 0; i < p->error.column - 1; ++i)
@@ -451,6 +470,19 @@ expect_ident(Parser *p, const char *ident_str)
   return false;
 }
 
+/**
+ * @brief 标识符 Token 的驻留名字
+ *
+ * 局部名和标签是源码切片 (见 Token)，只在需要长期保存时 (定义值、创建基本块) 才驻留。
+ */
+static const char *
+token_name(Parser *p, const Token *tok)
+{
+  if (tok->type == TK_LOCAL_IDENT || tok->type == TK_LABEL_IDENT)
+    return ir_context_intern_str_hashed(p->context, tok->as.ident_val, tok->ident_len, tok->ident_hash);
+  return tok->as.ident_val;
+}
+
 /**
  * @brief 在符号表 (全局或局部) 中查找一个值。
  *
@@ -463,24 +495,24 @@ parser_find_value(Parser *p, Token *tok)
 {
   assert(tok->type == TK_GLOBAL_IDENT || tok->type == TK_LOCAL_IDENT);
 
-  const char *name = tok->as.ident_val;
   void *val_ptr = NULL;
 
   if (tok->type == TK_GLOBAL_IDENT)
   {
-    val_ptr = ptr_hashmap_get(p->global_value_map, (void *)name);
+    val_ptr = ptr_hashmap_get(p->global_value_map, (void *)tok->as.ident_val);
   }
   else
   {
     if (p->local_value_map)
     {
-      val_ptr = ptr_hashmap_get(p->local_value_map, (void *)name);
+      val_ptr = str_hashmap_get_hashed(p->local_value_map, tok->as.ident_val, tok->ident_len, tok->ident_hash);
     }
   }
 
   if (val_ptr == NULL)
   {
-    parser_error_at(p, tok, "Use of undefined value '%c%s'", (tok->type == TK_GLOBAL_IDENT) ? '@' : '%', name);
+    parser_error_at(p, tok, "Use of undefined value '%c%.*s'", (tok->type == TK_GLOBAL_IDENT) ? '@' : '%',
+                    (int)tok->ident_len, tok->as.ident_val);
   }
   return (IRValueNode *)val_ptr;
 }
@@ -496,27 +528,42 @@ static void
 parser_record_value(Parser *p, Token *tok, IRValueNode *val)
 {
   assert(tok->type == TK_GLOBAL_IDENT || tok->type == TK_LOCAL_IDENT);
-  const char *name = tok->as.ident_val;
-  PtrHashMap *map = (tok->type == TK_GLOBAL_IDENT) ? p->global_value_map : p->local_value_map;
+  bool is_global = (tok->type == TK_GLOBAL_IDENT);
+  char sigil = is_global ? '@' : '%';
+  int len = (int)tok->ident_len;
 
-  if (map == NULL)
+  if (!is_global && p->local_value_map == NULL)
   {
-    parser_error_at(p, tok, "Attempted to define a local value '%%%s' outside a function", name);
+    parser_error_at(p, tok, "Attempted to define a local value '%%%.*s' outside a function", len, tok->as.ident_val);
     return;
   }
 
-  if (ptr_hashmap_contains(map, (void *)name))
+  bool exists = is_global ? ptr_hashmap_contains(p->global_value_map, (void *)tok->as.ident_val)
+                          : str_hashmap_contains_hashed(p->local_value_map, tok->as.ident_val, tok->ident_len,
+                                                        tok->ident_hash);
+  if (exists)
   {
-    parser_error_at(p, tok, "Redefinition of value '%c%s'", (tok->type == TK_GLOBAL_IDENT) ? '@' : '%', name);
+    parser_error_at(p, tok, "Redefinition of value '%c%.*s'", sigil, len, tok->as.ident_val);
     return;
   }
 
-  ir_value_set_name(val, name);
+  const char *name = token_name(p, tok);
+  if (!name)
+  {
+    parser_error_at(p, tok, "OOM interning name '%c%.*s'", sigil, len, tok->as.ident_val);
+    return;
+  }
+  /// Builder 通常已经用同一个名字创建了值
+  if (val->name != name)
+    ir_value_set_name(val, name);
 
-  if (!ptr_hashmap_put(map, (void *)name, (void *)val))
+  /// 驻留的名字比局部表活得久，可以直接作为键 (不必复制到 local_arena)
+  bool ok = is_global ? ptr_hashmap_put(p->global_value_map, (void *)name, (void *)val)
+                      : str_hashmap_put_preallocated_key_hashed(p->local_value_map, name, tok->ident_len,
+                                                                tok->ident_hash, (void *)val);
+  if (!ok)
   {
-    parser_error_at(p, tok, "Failed to record value '%c%s' (HashMap OOM)", (tok->type == TK_GLOBAL_IDENT) ? '@' : '%',
-                    name);
+    parser_error_at(p, tok, "Failed to record value '%c%.*s' (HashMap OOM)", sigil, len, tok->as.ident_val);
   }
 }
 
@@ -563,8 +610,11 @@ parser_init(Parser *p, Lexer *lexer, IRContext *ctx, IRModule *mod, IRBuilder *b
   p->builder = b;
   p->current_function = NULL;
   p->has_error = false;
+  p->on_function = NULL;
+  p->on_function_data = NULL;
 
   bump_init(&p->temp_arena);
+  bump_init(&p->local_arena);
 
   p->global_value_map = ptr_hashmap_create(&ctx->ir_arena, 64);
   if (!p->global_value_map)
@@ -573,6 +623,7 @@ parser_init(Parser *p, Lexer *lexer, IRContext *ctx, IRModule *mod, IRBuilder *b
   }
 
   p->local_value_map = NULL;
+  p->local_map_cache = NULL;
 
   return true;
 }
@@ -585,6 +636,7 @@ parser_destroy(Parser *p)
 {
 
   bump_destroy(&p->temp_arena);
+  bump_destroy(&p->local_arena);
 
   p->lexer = NULL;
   p->context = NULL;
@@ -592,6 +644,7 @@ parser_destroy(Parser *p)
   p->builder = NULL;
   p->global_value_map = NULL;
   p->local_value_map = NULL;
+  p->local_map_cache = NULL;
 }
 
 /*
@@ -603,6 +656,9 @@ parser_destroy(Parser *p)
 static void parse_module_body(Parser *p);
 static void parse_top_level_element(Parser *p);
 static void parse_function_definition(Parser *p);
+static IRFunction *parse_function_header(Parser *p);
+static void parse_function_body(Parser *p);
+static void discard_function_body(Parser *p, IRFunction *func);
 static void parse_function_declaration(Parser *p);
 static void parse_global_variable(Parser *p);
 static void parse_basic_block(Parser *p);
@@ -703,36 +759,85 @@ parse_top_level_element(Parser *p)
  */
 static void
 parse_function_definition(Parser *p)
+{
+  IRFunction *func = parse_function_header(p);
+  if (!func)
+    return;
+
+  p->body_mark = bump_mark(&p->context->ir_arena);
+  parse_function_body(p);
+
+  if (p->on_function && !p->has_error && p->on_function(func, p->on_function_data) == IR_STREAM_DISCARD)
+  {
+    discard_function_body(p, func);
+  }
+}
+
+/** @brief 桶数不超过它的局部符号表在下一个函数中清空复用 (清空只需清零这么多控制字节) */
+#define LOCAL_MAP_REUSE_BUCKETS (16 * 1024)
+
+/**
+ * @brief 为新函数准备一个空的 local_value_map
+ *
+ * 直接清空上一个函数的表: 不分配内存，也不必在大函数中从 64 个桶重新一路扩容。
+ * 上一个函数让它增长得过大时才重置 local_arena (连同扩容留下的旧桶数组) 并重新创建。
+ *
+ * @return bool OOM 时返回 false
+ */
+static bool
+parser_begin_local_scope(Parser *p)
+{
+  if (p->local_map_cache && str_hashmap_stats(p->local_map_cache).num_buckets <= LOCAL_MAP_REUSE_BUCKETS)
+  {
+    str_hashmap_clear(p->local_map_cache);
+  }
+  else
+  {
+    bump_reset(&p->local_arena);
+    p->local_map_cache = str_hashmap_create(&p->local_arena, 64);
+  }
+  p->local_value_map = p->local_map_cache;
+  return p->local_value_map != NULL;
+}
+
+/**
+ * @brief 解析函数定义的头部 (到函数体的 '{' 之前)
+ *
+ * 创建函数和参数，参数记录在新的 local_value_map 中。
+ *
+ * @param p Parser (当前 token 是 'define')
+ * @return IRFunction* 新函数 (当前 token 是 '{')；出错时返回 NULL
+ */
+static IRFunction *
+parse_function_header(Parser *p)
 {
   advance(p);
 
   IRType *ret_type = parse_type(p);
   if (!ret_type)
-    return;
+    return NULL;
 
   Token name_tok = *current_token(p);
   if (!expect(p, TK_GLOBAL_IDENT))
-    return;
+    return NULL;
 
   IRFunction *func = ir_function_create(p->module, name_tok.as.ident_val, ret_type);
   if (!func)
   {
     parser_error_at(p, &name_tok, "OOM creating function '@%s'", name_tok.as.ident_val);
-    return;
+    return NULL;
   }
   parser_record_value(p, &name_tok, &func->entry_address);
 
   p->current_function = func;
-  bump_reset(&p->temp_arena);
-  p->local_value_map = ptr_hashmap_create(&p->temp_arena, 64);
-  if (!p->local_value_map)
+  if (!parser_begin_local_scope(p))
   {
     parser_error_at(p, &name_tok, "OOM creating local value map for function '@%s'", name_tok.as.ident_val);
-    return;
+    return NULL;
   }
 
   if (!expect(p, TK_LPAREN))
-    return;
+    return NULL;
 
   bool is_variadic = false;
   if (current_token(p)->type != TK_RPAREN)
@@ -743,31 +848,32 @@ parse_function_definition(Parser *p)
       {
         is_variadic = true;
         if (!expect(p, TK_RPAREN))
-          return;
+          return NULL;
         break;
       }
 
       Token arg_name_tok = *current_token(p);
       if (!expect(p, TK_LOCAL_IDENT))
-        return;
+        return NULL;
       if (!expect(p, TK_COLON))
-        return;
+        return NULL;
       IRType *arg_type = parse_type(p);
       if (!arg_type)
-        return;
+        return NULL;
 
-      IRArgument *arg = ir_argument_create(func, arg_type, arg_name_tok.as.ident_val);
+      IRArgument *arg = ir_argument_create(func, arg_type, token_name(p, &arg_name_tok));
       if (!arg)
       {
-        parser_error_at(p, &arg_name_tok, "OOM creating argument '%%%s'", arg_name_tok.as.ident_val);
-        return;
+        parser_error_at(p, &arg_name_tok, "OOM creating argument '%%%.*s'", (int)arg_name_tok.ident_len,
+                        arg_name_tok.as.ident_val);
+        return NULL;
       }
       parser_record_value(p, &arg_name_tok, &arg->value);
 
       if (match(p, TK_RPAREN))
         break;
       if (!expect(p, TK_COMMA))
-        return;
+        return NULL;
     }
   }
   else
@@ -777,6 +883,18 @@ parse_function_definition(Parser *p)
 
   ir_function_finalize_signature(func, is_variadic);
   func->is_declaration = false;
+  return func;
+}
+
+/**
+ * @brief 解析函数体 `{ basic_block* }`
+ *
+ * @param p Parser (当前 token 是 '{'，current_function 和 local_value_map 已经就绪)
+ */
+static void
+parse_function_body(Parser *p)
+{
+  assert(p->current_function != NULL && p->local_value_map != NULL);
 
   if (!expect(p, TK_LBRACE))
     return;
@@ -800,7 +918,20 @@ parse_function_definition(Parser *p)
 
   p->current_function = NULL;
   p->local_value_map = NULL;
-  bump_reset(&p->temp_arena);
+}
+
+/**
+ * @brief 丢弃刚解析完的函数体，把函数变回声明
+ *
+ * 函数体是 ir_arena 中最后分配的内容 (从 body_mark 开始)，
+ * 先解开它对外部值 (参数、全局、函数、常量) 的 Use，再回退 Arena。
+ */
+static void
+discard_function_body(Parser *p, IRFunction *func)
+{
+  ir_function_clear_body(func);
+  func->is_declaration = true;
+  bump_rewind(&p->context->ir_arena, p->body_mark);
 }
 
 /**
@@ -817,8 +948,8 @@ parse_function_type(Parser *p, IRType *ret_type)
     return NULL;
 
   bump_reset(&p->temp_arena);
-  TempVec params;
-  temp_vec_init(&params, &p->temp_arena);
+  TypeVec params;
+  type_vec_init(&params, &p->temp_arena);
   bool is_variadic = false;
 
   if (current_token(p)->type != TK_RPAREN)
@@ -838,7 +969,7 @@ parse_function_type(Parser *p, IRType *ret_type)
       if (!param_type)
         return NULL;
 
-      if (!temp_vec_push(&params, (void *)param_type))
+      if (!type_vec_push(&params, param_type))
       {
         parser_error(p, "OOM parsing function parameters");
         return NULL;
@@ -855,15 +986,10 @@ parse_function_type(Parser *p, IRType *ret_type)
     advance(p);
   }
 
-  IRType **permanent_params = BUMP_ALLOC_SLICE_COPY(&p->context->permanent_arena, IRType *,
-                                                    (IRType **)temp_vec_data(&params), temp_vec_len(&params));
-  if (temp_vec_len(&params) > 0 && !permanent_params)
-  {
-    parser_error(p, "OOM copying function parameters");
-    return NULL;
-  }
-
-  return ir_type_get_function(p->context, ret_type, permanent_params, temp_vec_len(&params), is_variadic);
+  /// 函数体中也会出现函数类型 (可能在并行解析的工作线程上)：
+  /// 不在共享的 permanent_arena 上复制参数，ir_type_get_function 新建类型时自己会复制
+  return ir_type_get_function(p->context, ret_type, type_vec_data(&params), type_vec_len(&params),
+                              is_variadic);
 }
 
 /**
@@ -923,7 +1049,7 @@ parse_function_declaration(Parser *p)
         arg_type = parse_type(p);
         if (!arg_type)
           return;
-        arg_name = arg_name_tok.as.ident_val;
+        arg_name = token_name(p, &arg_name_tok);
       }
       else
       {
@@ -971,7 +1097,7 @@ parse_type_definition(Parser *p)
   Token name_tok = *current_token(p);
   if (!expect(p, TK_LOCAL_IDENT))
     return;
-  const char *name = name_tok.as.ident_val;
+  const char *name = token_name(p, &name_tok);
 
   if (!expect(p, TK_EQ))
     return;
@@ -983,8 +1109,8 @@ parse_type_definition(Parser *p)
     return;
 
   bump_reset(&p->temp_arena);
-  TempVec members;
-  temp_vec_init(&members, &p->temp_arena);
+  TypeVec members;
+  type_vec_init(&members, &p->temp_arena);
 
   if (current_token(p)->type == TK_RBRACE)
   {
@@ -998,7 +1124,7 @@ parse_type_definition(Parser *p)
       IRType *member_type = parse_type(p);
       if (!member_type)
         return;
-      if (!temp_vec_push(&members, (void *)member_type))
+      if (!type_vec_push(&members, member_type))
       {
         parser_error(p, "OOM parsing struct members");
         return;
@@ -1012,14 +1138,14 @@ parse_type_definition(Parser *p)
   }
 
   IRType **permanent_members = BUMP_ALLOC_SLICE_COPY(&p->context->permanent_arena, IRType *,
-                                                     (IRType **)temp_vec_data(&members), temp_vec_len(&members));
-  if (temp_vec_len(&members) > 0 && !permanent_members)
+                                                     type_vec_data(&members), type_vec_len(&members));
+  if (type_vec_len(&members) > 0 && !permanent_members)
   {
     parser_error(p, "OOM in permanent_arena copying struct members");
     return;
   }
 
-  IRType *named_struct = ir_type_get_named_struct(p->context, name, permanent_members, temp_vec_len(&members));
+  IRType *named_struct = ir_type_get_named_struct(p->context, name, permanent_members, type_vec_len(&members));
 
   if (named_struct == NULL)
   {
@@ -1127,35 +1253,38 @@ parse_basic_block(Parser *p)
   if (!expect(p, TK_COLON))
     return;
 
-  const char *name = name_tok.as.ident_val;
+  int name_len = (int)name_tok.ident_len;
 
   IRBasicBlock *bb = NULL;
-  IRValueNode *existing_val = (IRValueNode *)ptr_hashmap_get(p->local_value_map, (void *)name);
+  IRValueNode *existing_val = (IRValueNode *)str_hashmap_get_hashed(p->local_value_map, name_tok.as.ident_val,
+                                                                    name_tok.ident_len, name_tok.ident_hash);
 
   if (existing_val)
   {
     if (existing_val->kind != IR_KIND_BASIC_BLOCK)
     {
-      parser_error_at(p, &name_tok, "Label '$%s' conflicts with an existing value", name_tok.as.ident_val);
+      parser_error_at(p, &name_tok, "Label '$%.*s' conflicts with an existing value", name_len, name_tok.as.ident_val);
       return;
     }
     bb = container_of(existing_val, IRBasicBlock, label_address);
     if (bb->list_node.next != &bb->list_node)
     {
-      parser_error_at(p, &name_tok, "Redefinition of basic block label '$%s'", name);
+      parser_error_at(p, &name_tok, "Redefinition of basic block label '$%.*s'", name_len, name_tok.as.ident_val);
       return;
     }
   }
   else
   {
-    bb = ir_basic_block_create(p->current_function, name);
+    const char *name = token_name(p, &name_tok);
+    bb = name ? ir_basic_block_create(p->current_function, name) : NULL;
     if (!bb)
     {
-      parser_error_at(p, &name_tok, "OOM creating basic block '$%s'", name_tok.as.ident_val);
+      parser_error_at(p, &name_tok, "OOM creating basic block '$%.*s'", name_len, name_tok.as.ident_val);
       return;
     }
 
-    ptr_hashmap_put(p->local_value_map, (void *)name, (void *)&bb->label_address);
+    str_hashmap_put_preallocated_key_hashed(p->local_value_map, name, name_tok.ident_len, name_tok.ident_hash,
+                                            (void *)&bb->label_address);
   }
 
   ir_function_append_basic_block(p->current_function, bb);
@@ -1242,8 +1371,8 @@ parse_instruction(Parser *p, bool *out_is_terminator)
     if (instr_val->type != result_type)
     {
 
-      parser_error_at(p, &result_tok, "Instruction result type does not match type annotation for '%%%s'",
-                      result_tok.as.ident_val);
+      parser_error_at(p, &result_tok, "Instruction result type does not match type annotation for '%%%.*s'",
+                      (int)result_tok.ident_len, result_tok.as.ident_val);
       return NULL;
     }
 
@@ -1263,8 +1392,8 @@ parse_instruction(Parser *p, bool *out_is_terminator)
 
   else if (has_result && instr_val && instr_val->type->kind == IR_TYPE_VOID)
   {
-    parser_error_at(p, &result_tok, "Cannot assign result of 'void' instruction to variable '%%%s'",
-                    result_tok.as.ident_val);
+    parser_error_at(p, &result_tok, "Cannot assign result of 'void' instruction to variable '%%%.*s'",
+                    (int)result_tok.ident_len, result_tok.as.ident_val);
     return NULL;
   }
 
@@ -1396,7 +1525,7 @@ parse_operation(Parser *p, Token *result_token, IRType *result_type, bool *out_i
   Token opcode_tok = *current_token(p);
   advance(p);
 
-  const char *name_hint = result_token ? result_token->as.ident_val : NULL;
+  const char *name_hint = result_token ? token_name(p, result_token) : NULL;
 
   switch (opcode_tok.type)
   {
@@ -1856,8 +1985,8 @@ parse_instr_gep(Parser *p, const char *name_hint, IRType *result_type)
   IRType *source_type = base_ptr->type->as.pointee_type;
 
   bump_reset(&p->temp_arena);
-  TempVec indices;
-  temp_vec_init(&indices, &p->temp_arena);
+  ValueVec indices;
+  value_vec_init(&indices, &p->temp_arena);
 
   while (match(p, TK_COMMA))
   {
@@ -1874,21 +2003,21 @@ parse_instr_gep(Parser *p, const char *name_hint, IRType *result_type)
       parser_error(p, "GEP indices must be integer types");
       return NULL;
     }
-    if (!temp_vec_push(&indices, (void *)idx_val))
+    if (!value_vec_push(&indices, idx_val))
     {
       parser_error(p, "OOM for GEP indices");
       return NULL;
     }
   }
 
-  if (temp_vec_len(&indices) == 0)
+  if (value_vec_len(&indices) == 0)
   {
     parser_error(p, "gep must have at least one index operand");
     return NULL;
   }
 
-  return ir_builder_create_gep(p->builder, source_type, base_ptr, (IRValueNode **)temp_vec_data(&indices),
-                               temp_vec_len(&indices), inbounds, name_hint);
+  return ir_builder_create_gep(p->builder, source_type, base_ptr, value_vec_data(&indices),
+                               value_vec_len(&indices), inbounds, name_hint);
 }
 
 static IRValueNode *
@@ -1969,7 +2098,7 @@ parse_instr_phi(Parser *p, Token *result_token, IRType *result_type)
     parser_error(p, "phi instruction must produce a result");
     return NULL;
   }
-  const char *name_hint = result_token ? result_token->as.ident_val : NULL;
+  const char *name_hint = result_token ? token_name(p, result_token) : NULL;
 
   IRValueNode *phi_node = ir_builder_create_phi(p->builder, result_type, name_hint);
   if (!phi_node)
@@ -2074,8 +2203,8 @@ parse_instr_call(Parser *p, const char *name_hint, IRType *result_type)
     return NULL;
 
   bump_reset(&p->temp_arena);
-  TempVec arg_values;
-  temp_vec_init(&arg_values, &p->temp_arena);
+  ValueVec arg_values;
+  value_vec_init(&arg_values, &p->temp_arena);
 
   bool is_variadic = func_type->as.function.is_variadic;
   size_t expected_count = func_type->as.function.param_count;
@@ -2090,20 +2219,20 @@ parse_instr_call(Parser *p, const char *name_hint, IRType *result_type)
         return NULL;
       IRType *arg_type = arg_val->type;
 
-      if (!is_variadic && temp_vec_len(&arg_values) >= expected_count)
+      if (!is_variadic && value_vec_len(&arg_values) >= expected_count)
       {
         parser_error(p, "Too many arguments");
         return NULL;
       }
-      if (temp_vec_len(&arg_values) < expected_count)
+      if (value_vec_len(&arg_values) < expected_count)
       {
-        if (arg_type != func_type->as.function.param_types[temp_vec_len(&arg_values)])
+        if (arg_type != func_type->as.function.param_types[value_vec_len(&arg_values)])
         {
           parser_error(p, "Argument type mismatch in call");
           return NULL;
         }
       }
-      if (!temp_vec_push(&arg_values, (void *)arg_val))
+      if (!value_vec_push(&arg_values, arg_val))
       {
         parser_error(p, "OOM parsing call arguments");
         return NULL;
@@ -2120,23 +2249,23 @@ parse_instr_call(Parser *p, const char *name_hint, IRType *result_type)
     advance(p);
   }
 
-  if (temp_vec_len(&arg_values) < expected_count)
+  if (value_vec_len(&arg_values) < expected_count)
   {
     if (is_variadic)
     {
       parser_error_at(p, &callee_tok, "Too few arguments for variadic call: expected at least %zu, got %zu",
-                      expected_count, temp_vec_len(&arg_values));
+                      expected_count, value_vec_len(&arg_values));
     }
     else
     {
       parser_error_at(p, &callee_tok, "Too few arguments for call: expected %zu, got %zu", expected_count,
-                      temp_vec_len(&arg_values));
+                      value_vec_len(&arg_values));
     }
     return NULL;
   }
 
-  return ir_builder_create_call(p->builder, callee_val, (IRValueNode **)temp_vec_data(&arg_values),
-                                temp_vec_len(&arg_values), name_hint);
+  return ir_builder_create_call(p->builder, callee_val, value_vec_data(&arg_values),
+                                value_vec_len(&arg_values), name_hint);
 }
 
 /**
@@ -2204,18 +2333,19 @@ static IRType *
 parse_array_type(Parser *p)
 {
 
+  /// 必须在 expect() 之前读取: 前进之后 lexer 会复用当前 Token 的存储
   const Token *count_tok = current_token(p);
-  if (!expect(p, TK_INTEGER_LITERAL))
+  int64_t count_val = count_tok->as.int_val;
+  if (count_tok->type == TK_INTEGER_LITERAL && count_val < 0)
   {
+    parser_error_at(p, count_tok, "Array size cannot be negative (got %" PRId64 ")", count_val);
     return NULL;
   }
-  size_t count = (size_t)count_tok->as.int_val;
-
-  if (count_tok->as.int_val < 0)
+  if (!expect(p, TK_INTEGER_LITERAL))
   {
-    parser_error_at(p, count_tok, "Array size cannot be negative (got %" PRId64 ")", count_tok->as.int_val);
     return NULL;
   }
+  size_t count = (size_t)count_val;
 
   if (!expect_ident(p, "x"))
   {
@@ -2247,8 +2377,8 @@ parse_struct_type(Parser *p)
 {
 
   bump_reset(&p->temp_arena);
-  TempVec members;
-  temp_vec_init(&members, &p->temp_arena);
+  TypeVec members;
+  type_vec_init(&members, &p->temp_arena);
 
   if (current_token(p)->type == TK_RBRACE)
   {
@@ -2264,7 +2394,7 @@ parse_struct_type(Parser *p)
     {
       return NULL;
     }
-    if (!temp_vec_push(&members, (void *)member_type))
+    if (!type_vec_push(&members, member_type))
     {
       parser_error(p, "OOM parsing anonymous struct members");
       return NULL;
@@ -2281,15 +2411,8 @@ parse_struct_type(Parser *p)
     }
   }
 
-  IRType **permanent_members = BUMP_ALLOC_SLICE_COPY(&p->context->permanent_arena, IRType *,
-                                                     (IRType **)temp_vec_data(&members), temp_vec_len(&members));
-  if (temp_vec_len(&members) > 0 && !permanent_members)
-  {
-    parser_error(p, "OOM in permanent_arena copying struct members");
-    return NULL;
-  }
-
-  return ir_type_get_anonymous_struct(p->context, permanent_members, temp_vec_len(&members));
+  /// 同 parse_function_type: 新建类型时会复制成员列表
+  return ir_type_get_anonymous_struct(p->context, type_vec_data(&members), type_vec_len(&members));
 }
 
 /**
@@ -2381,16 +2504,15 @@ parse_type(Parser *p)
     Token name_tok = *current_token(p);
     advance(p);
 
-    const char *name = name_tok.as.ident_val;
-
-    size_t name_len = strlen(name);
-
-    IRType *found_type = (IRType *)str_hashmap_get(p->context->named_struct_cache, name, name_len);
+    /// 命名结构体缓存以字符串切片为键，直接用源码切片查找
+    IRType *found_type = (IRType *)str_hashmap_get_hashed(p->context->named_struct_cache, name_tok.as.ident_val,
+                                                          name_tok.ident_len, name_tok.ident_hash);
 
     if (found_type == NULL)
     {
 
-      parser_error_at(p, &name_tok, "Use of undefined named type '%%%s'", name_tok.as.ident_val);
+      parser_error_at(p, &name_tok, "Use of undefined named type '%%%.*s'", (int)name_tok.ident_len,
+                      name_tok.as.ident_val);
       return NULL;
     }
     base_type = found_type;
@@ -2512,19 +2634,26 @@ parse_operand(Parser *p)
 
   if (val_tok.type == TK_LABEL_IDENT)
   {
-    const char *label_name = val_tok.as.ident_val;
-    IRValueNode *val = (IRValueNode *)ptr_hashmap_get(p->local_value_map, (void *)label_name);
+    IRValueNode *val = (IRValueNode *)str_hashmap_get_hashed(p->local_value_map, val_tok.as.ident_val,
+                                                             val_tok.ident_len, val_tok.ident_hash);
     if (!val)
     {
-
-      IRBasicBlock *fwd_bb = ir_basic_block_create(p->current_function, label_name);
+      /// 前向引用: 先创建基本块，定义标签时再挂到函数上
+      const char *label_name = token_name(p, &val_tok);
+      IRBasicBlock *fwd_bb = label_name ? ir_basic_block_create(p->current_function, label_name) : NULL;
+      if (!fwd_bb)
+      {
+        parser_error_at(p, &val_tok, "OOM creating basic block '$%.*s'", (int)val_tok.ident_len, val_tok.as.ident_val);
+        return NULL;
+      }
       val = (IRValueNode *)&fwd_bb->label_address;
-      ptr_hashmap_put(p->local_value_map, (void *)label_name, (void *)val);
+      str_hashmap_put_preallocated_key_hashed(p->local_value_map, label_name, val_tok.ident_len, val_tok.ident_hash,
+                                              (void *)val);
     }
     if (val->kind != IR_KIND_BASIC_BLOCK)
     {
-      parser_error_at(p, &val_tok, "Expected a basic block label ($name), but '$%s' is not a label",
-                      val_tok.as.ident_val);
+      parser_error_at(p, &val_tok, "Expected a basic block label ($name), but '$%.*s' is not a label",
+                      (int)val_tok.ident_len, val_tok.as.ident_val);
       return NULL;
     }
     return val;
@@ -2568,105 +2697,1074 @@ parse_operand(Parser *p)
 
 /*
  * =================================================================
- * --- 公共 API (Public API) ---
+ * --- 流式输入 (Streaming Input) ---
  * =================================================================
  */
 
+#define STREAM_INITIAL_CAPACITY (64 * 1024)
+/// 判断一行是否以顶层关键字开头时最多需要看的字节数 ("declare" + 一个分隔符)
+#define STREAM_LOOKAHEAD 8
+
 /**
- * @brief 解析一个完整的 IR 模块 (主入口点)
+ * @brief 流式解析的输入缓冲区
+ *
+ * data[0, len) 是已经读入、还没有解析的源码，总是从一个顶层元素 (或它前面的空白和注释) 开始。
+ * 扫描状态 (scan_*) 在多次读入之间保留，每个字节只扫描一次。
  */
-IRModule *
-ir_parse_module(IRContext *ctx, const char *source_buffer)
+typedef struct StreamSource
 {
-  assert(ctx && source_buffer);
+  IRStreamReader read;
+  void *read_data;
+  char *data;
+  size_t len;
+  size_t capacity;
+  bool eof;
+  /** data[0] 所在的行号 */
+  size_t line;
+
+  size_t scan_pos;
+  /** data[0, scan_pos) 中的换行数 */
+  size_t scan_lines;
+  int scan_depth;
+  bool scan_in_string;
+  bool scan_in_comment;
+  /** 本行在 scan_pos 之前只有空白 */
+  bool scan_at_line_start;
+  /** 当前块中已经出现过 token */
+  bool scan_seen_token;
+} StreamSource;
 
-  Lexer lexer;
-  ir_lexer_init(&lexer, source_buffer, ctx);
+static void
+stream_reset_scan(StreamSource *src)
+{
+  src->scan_pos = 0;
+  src->scan_lines = 0;
+  src->scan_depth = 0;
+  src->scan_in_string = false;
+  src->scan_in_comment = false;
+  src->scan_at_line_start = true;
+  src->scan_seen_token = false;
+}
 
-  IRBuilder *builder = ir_builder_create(ctx);
-  if (!builder)
+/**
+ * @brief 再读入一段输入 (缓冲区满时扩容)
+ * @return bool OOM 时返回 false
+ */
+static bool
+stream_fill(StreamSource *src)
+{
+  if (src->len == src->capacity)
   {
-    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
-    return NULL;
+    size_t new_capacity = src->capacity ? src->capacity * 2 : STREAM_INITIAL_CAPACITY;
+    char *data = realloc(src->data, new_capacity);
+    if (!data)
+      return false;
+    src->data = data;
+    src->capacity = new_capacity;
   }
 
-  const char *module_name = "parsed_module";
-  const Token *first_tok = ir_lexer_current_token(&lexer);
+  size_t n = src->read(src->read_data, src->data + src->len, src->capacity - src->len);
+  if (n == 0)
+    src->eof = true;
+  src->len += n;
+  return true;
+}
 
-  if (first_tok->type == TK_KW_MODULE)
-  {
-    ir_lexer_next(&lexer);
+/**
+ * @brief s 是否以顶层元素的开头 (`define`, `declare`, `module`, `@name`, `%name`) 开始
+ */
+static bool
+stream_starts_top_level(const char *s, size_t n)
+{
+  if (s[0] == '@' || s[0] == '%')
+    return true;
 
-    const Token *eq_tok = ir_lexer_current_token(&lexer);
-    if (eq_tok->type != TK_EQ)
+  static const char *const KEYWORDS[] = {"define", "declare", "module"};
+  for (size_t k = 0; k < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); k++)
+  {
+    size_t kw_len = strlen(KEYWORDS[k]);
+    if (n >= kw_len && memcmp(s, KEYWORDS[k], kw_len) == 0)
     {
-
-      fprintf(stderr, "Parse Error (%zu:%zu): Expected '=' after 'module', but got %s\n", eq_tok->line, eq_tok->column,
-              token_type_to_string(eq_tok->type));
-      ir_builder_destroy(builder);
-      return NULL;
+      char next = n > kw_len ? s[kw_len] : ' ';
+      if (!isalnum((unsigned char)next) && next != '_' && next != '.')
+        return true;
     }
-    ir_lexer_next(&lexer);
+  }
+  return false;
+}
 
-    const Token *name_tok = ir_lexer_current_token(&lexer);
-    if (name_tok->type != TK_STRING_LITERAL)
+/**
+ * @brief 找到缓冲区开头由完整顶层元素组成的一块
+ *
+ * 块在下一个顶层元素开始的那一行之前结束：该行位于所有括号之外，
+ * 第一个 token 是顶层关键字。必要时继续读入。
+ *
+ * @return size_t 块的长度；输入已经全部解析时返回 0；OOM 时返回 SIZE_MAX
+ */
+static size_t
+stream_next_chunk(StreamSource *src)
+{
+  while (true)
+  {
+    while (src->scan_pos < src->len)
     {
+      size_t i = src->scan_pos;
+      char c = src->data[i];
 
-      fprintf(stderr, "Parse Error (%zu:%zu): Expected string literal (e.g., \"foo.c\") after 'module =', but got %s\n",
-              name_tok->line, name_tok->column, token_type_to_string(name_tok->type));
-      ir_builder_destroy(builder);
-      return NULL;
+      if (src->scan_at_line_start && src->scan_depth == 0 && !src->scan_in_string && !src->scan_in_comment &&
+          c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ';')
+      {
+        if (src->len - i < STREAM_LOOKAHEAD && !src->eof)
+          break;
+        if (src->scan_seen_token && stream_starts_top_level(src->data + i, src->len - i))
+          return i;
+      }
+
+      src->scan_pos++;
+      if (c == '\n')
+        src->scan_lines++;
+
+      if (src->scan_in_comment)
+      {
+        if (c == '\n')
+        {
+          src->scan_in_comment = false;
+          src->scan_at_line_start = true;
+        }
+        continue;
+      }
+      if (src->scan_in_string)
+      {
+        if (c == '"')
+          src->scan_in_string = false;
+        continue;
+      }
+
+      switch (c)
+      {
+      case '\n':
+        src->scan_at_line_start = true;
+        continue;
+      case ' ':
+      case '\t':
+      case '\r':
+        continue;
+      case ';':
+        src->scan_in_comment = true;
+        continue;
+      case '"':
+        src->scan_in_string = true;
+        break;
+      case '{':
+      case '[':
+      case '(':
+        src->scan_depth++;
+        break;
+      case '}':
+      case ']':
+      case ')':
+        if (src->scan_depth > 0)
+          src->scan_depth--;
+        break;
+      default:
+        break;
+      }
+      src->scan_at_line_start = false;
+      src->scan_seen_token = true;
     }
 
-    module_name = name_tok->as.ident_val;
-    ir_lexer_next(&lexer);
+    if (src->scan_pos == src->len && src->eof)
+      return src->len;
+    if (!stream_fill(src))
+      return SIZE_MAX;
   }
+}
 
-  IRModule *module = ir_module_create(ctx, module_name);
-  if (!module)
-  {
-    ir_builder_destroy(builder);
-    fprintf(stderr, "Fatal: Failed to create IRModule\n");
-    return NULL;
-  }
+/**
+ * @brief 丢弃已经解析的前 n 个字节 (n 是 stream_next_chunk 的返回值)
+ */
+static void
+stream_consume(StreamSource *src, size_t n)
+{
+  memmove(src->data, src->data + n, src->len - n);
+  src->len -= n;
+  src->line += src->scan_lines;
+  stream_reset_scan(src);
+}
 
-  Parser parser;
-  if (!parser_init(&parser, &lexer, ctx, module, builder))
-  {
-    ir_builder_destroy(builder);
-    fprintf(stderr, "Fatal: Failed to init Parser (OOM)\n");
+/**
+ * @brief 跳过已经解析的前 n 个字节 (源码由调用者持有时使用，不移动数据)
+ */
+static void
+stream_advance(StreamSource *src, size_t n)
+{
+  src->data += n;
+  src->len -= n;
+  src->line += src->scan_lines;
+  stream_reset_scan(src);
+}
 
-    return NULL;
-  }
+static size_t
+stream_read_file(void *reader_data, char *buffer, size_t capacity)
+{
+  return fread(buffer, 1, capacity, (FILE *)reader_data);
+}
 
-  parse_module_body(&parser);
+/*
+ * =================================================================
+ * --- 并行解析 (Parallel Parsing) 与延迟解析 (Lazy Parsing) ---
+ * =================================================================
+ *
+ * 第一阶段在调用线程上按顶层边界 (与流式解析相同) 切分源码，依次解析类型定义、
+ * 全局变量、声明和每个 define 的函数头；函数体留给第二阶段。
+ * 并行解析时，第二阶段由若干 worker 解析函数体。函数体之间只通过 global_value_map
+ * (此时只读) 和 Context (见 ir_context_begin_concurrent) 共享状态，
+ * 每个 worker 有自己的 Builder、local_value_map 和 Arena。
+ * 延迟解析时，每个函数体在第一次被访问时才解析 (见 ir_function_materialize)。
+ */
 
-  bool success = !parser.has_error;
+/** @brief 一个待解析的函数体 */
+typedef struct DeferredBody
+{
+  IRFunction *func;
+  /** 模块的全局符号表 (第一阶段结束后只读) */
+  PtrHashMap *global_value_map;
+  /** 函数定义所在的顶层块 */
+  const char *source;
+  size_t len;
+  /** source[0] 所在的行号 */
+  size_t line;
+  /** 函数体的 '{' 在块中的位置 */
+  size_t brace_line;
+  size_t brace_column;
+} DeferredBody;
 
-  if (!success)
-  {
+/**
+ * @brief 初始化一个只解析函数体的 Parser
+ *
+ * 它共享第一阶段的全局符号表，有自己的 Builder 和 Arena
+ * (用 parser_destroy_body_only 释放；Builder 创建失败时 p->builder 为 NULL)。
+ */
+static void
+parser_init_body_only(Parser *p, IRContext *ctx, IRModule *mod, PtrHashMap *global_value_map)
+{
+  p->lexer = NULL;
+  p->context = ctx;
+  p->module = mod;
+  p->builder = ir_builder_create(ctx);
+  p->current_function = NULL;
+  p->has_error = false;
+  p->on_function = NULL;
+  p->on_function_data = NULL;
+  bump_init(&p->temp_arena);
+  bump_init(&p->local_arena);
+  p->global_value_map = global_value_map;
+  p->local_value_map = NULL;
+  p->local_map_cache = NULL;
+}
 
-    print_parse_error(&parser, source_buffer);
-  }
+static void
+parser_destroy_body_only(Parser *p)
+{
+  ir_builder_destroy(p->builder);
+  parser_destroy(p);
+}
 
-  parser_destroy(&parser);
-  ir_builder_destroy(builder);
+/**
+ * @brief 解析一个函数体
+ *
+ * 重新扫描函数所在的块，跳过第一阶段已经解析过的函数头，
+ * 用函数的参数重建 local_value_map。
+ */
+static void
+parse_deferred_body(Parser *p, const DeferredBody *body)
+{
+  Lexer lexer;
+  ir_lexer_init_slice(&lexer, body->source, body->len, p->context);
+  p->lexer = &lexer;
 
-  if (success)
+  while (current_token(p)->type != TK_EOF &&
+         (current_token(p)->line != body->brace_line || current_token(p)->column != body->brace_column))
   {
+    advance(p);
+  }
 
-    if (!ir_verify_module(module))
-    {
-
-      fprintf(stderr, "Parser Error: Generated IR failed verification.\n");
+  IRFunction *func = body->func;
+  p->current_function = func;
+  if (!parser_begin_local_scope(p))
+  {
+    parser_error(p, "OOM creating local value map");
+    return;
+  }
 
-      return NULL;
+  IDList *it;
+  list_for_each(&func->arguments, it)
+  {
+    IRArgument *arg = list_entry(it, IRArgument, list_node);
+    /// 参数名是驻留的: 长度和哈希直接从驻留头部取
+    const char *name = arg->value.name;
+    if (!str_hashmap_put_preallocated_key_hashed(p->local_value_map, name, ir_interned_str_len(name),
+                                                 ir_interned_str_hash(name), (void *)&arg->value))
+    {
+      parser_error(p, "OOM recording function arguments");
+      return;
     }
-    return module;
   }
-  else
-  {
 
-    return NULL;
+  parse_function_body(p);
+
+  if (!p->has_error && current_token(p)->type != TK_EOF)
+  {
+    parser_error(p, "Expected the next top-level element to start on a new line");
   }
-}
\ No newline at end of file
+}
+
+/** @brief 所有 worker 共享的任务 */
+typedef struct ParallelJob
+{
+  DeferredBody **bodies;
+  size_t num_bodies;
+#if !defined(__STDC_NO_THREADS__)
+  /** 下一个要领取的函数体 */
+  atomic_size_t next;
+  /** 出错的函数体中最小的下标 (没有错误时为 SIZE_MAX)；更靠后的函数体不再解析 */
+  atomic_size_t first_error;
+  atomic_bool out_of_memory;
+#else
+  size_t next;
+  size_t first_error;
+  bool out_of_memory;
+#endif
+} ParallelJob;
+
+/** @brief 一个 worker 的私有状态 */
+typedef struct ParallelWorker
+{
+  ParallelJob *job;
+  /** 与主 Parser 共享 global_value_map，其余状态独立 */
+  Parser parser;
+  IRContextWorker context_worker;
+  /** 是否作为 Context 的 worker 运行过 (需要 adopt) */
+  bool entered;
+  /** 该 worker 解析失败的函数体下标 (SIZE_MAX 表示没有失败) */
+  size_t error_body;
+} ParallelWorker;
+
+static bool
+parallel_worker_init(ParallelWorker *w, ParallelJob *job, const Parser *shared)
+{
+  w->job = job;
+  parser_init_body_only(&w->parser, shared->context, shared->module, shared->global_value_map);
+  w->entered = false;
+  w->error_body = SIZE_MAX;
+  return w->parser.builder != NULL;
+}
+
+static void
+parallel_worker_destroy(ParallelWorker *w)
+{
+  parser_destroy_body_only(&w->parser);
+}
+
+/**
+ * @brief 记录一个出错的函数体 (保留最小的下标)
+ */
+static void
+parallel_record_error(ParallelJob *job, size_t index)
+{
+#if !defined(__STDC_NO_THREADS__)
+  size_t current = atomic_load(&job->first_error);
+  while (index < current && !atomic_compare_exchange_weak(&job->first_error, &current, index))
+  {
+  }
+#else
+  if (index < job->first_error)
+    job->first_error = index;
+#endif
+}
+
+/**
+ * @brief 不断领取并解析函数体，直到全部领完或自己出错
+ *
+ * 下标按顺序领取，所以第一个出错的函数体之前的函数体总会被解析，
+ * 报告的错误与顺序解析时相同。
+ */
+static void
+parallel_worker_run(ParallelWorker *w)
+{
+  ParallelJob *job = w->job;
+  while (true)
+  {
+#if !defined(__STDC_NO_THREADS__)
+    size_t index = atomic_fetch_add(&job->next, 1);
+    size_t first_error = atomic_load(&job->first_error);
+#else
+    size_t index = job->next++;
+    size_t first_error = job->first_error;
+#endif
+    if (index >= job->num_bodies || index > first_error)
+      return;
+
+    parse_deferred_body(&w->parser, job->bodies[index]);
+    if (w->parser.has_error)
+    {
+      w->error_body = index;
+      parallel_record_error(job, index);
+      return;
+    }
+  }
+}
+
+#if !defined(__STDC_NO_THREADS__)
+static int
+parallel_worker_main(void *arg)
+{
+  ParallelWorker *w = (ParallelWorker *)arg;
+  if (!ir_context_enter_worker(w->parser.context, &w->context_worker))
+  {
+    atomic_store(&w->job->out_of_memory, true);
+    parallel_record_error(w->job, 0);
+    return 0;
+  }
+  w->entered = true;
+  parallel_worker_run(w);
+  ir_context_leave_worker(&w->context_worker);
+  return 0;
+}
+
+/**
+ * @brief 在 workers[1..] 各自的线程和调用线程 (workers[0]) 上解析函数体
+ *
+ * 线程启动失败时剩下的 worker 不参与，函数体由已经启动的 worker 分担。
+ */
+static void
+parallel_run_threads(IRContext *ctx, ParallelWorker *workers, size_t num_workers)
+{
+  thrd_t *threads = (thrd_t *)malloc((num_workers - 1) * sizeof(thrd_t));
+  size_t started = 0;
+  if (threads)
+  {
+    while (started < num_workers - 1 &&
+           thrd_create(&threads[started], parallel_worker_main, &workers[started + 1]) == thrd_success)
+    {
+      started++;
+    }
+  }
+
+  parallel_worker_main(&workers[0]);
+
+  for (size_t i = 0; i < started; i++)
+  {
+    thrd_join(threads[i], NULL);
+  }
+  free(threads);
+
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    if (workers[i].entered)
+      ir_context_adopt_worker(ctx, &workers[i].context_worker);
+  }
+}
+#endif
+
+/**
+ * @brief 第二阶段: 用至多 num_threads 个 worker (包括调用线程) 解析所有函数体
+ *
+ * @param shared 完成了第一阶段的 Parser
+ * @return bool 所有函数体都解析成功时返回 true (否则已经打印错误)
+ */
+static bool
+parse_deferred_bodies(Parser *shared, DeferredBody **bodies, size_t num_bodies, size_t num_threads)
+{
+  if (num_bodies == 0)
+    return true;
+  if (num_threads > num_bodies)
+    num_threads = num_bodies;
+  if (num_threads == 0)
+    num_threads = 1;
+
+  ParallelJob job;
+  job.bodies = bodies;
+  job.num_bodies = num_bodies;
+#if !defined(__STDC_NO_THREADS__)
+  atomic_init(&job.next, 0);
+  atomic_init(&job.first_error, SIZE_MAX);
+  atomic_init(&job.out_of_memory, false);
+#else
+  job.next = 0;
+  job.first_error = SIZE_MAX;
+  job.out_of_memory = false;
+#endif
+
+  ParallelWorker *workers = (ParallelWorker *)calloc(num_threads, sizeof(ParallelWorker));
+  size_t num_workers = 0;
+  while (workers && num_workers < num_threads && parallel_worker_init(&workers[num_workers], &job, shared))
+  {
+    num_workers++;
+  }
+  if (num_workers == 0)
+  {
+    free(workers);
+    fprintf(stderr, "Fatal: Failed to init Parser (OOM)\n");
+    return false;
+  }
+
+#if !defined(__STDC_NO_THREADS__)
+  IRContext *ctx = shared->context;
+  if (num_workers > 1 && ir_context_begin_concurrent(ctx))
+  {
+    parallel_run_threads(ctx, workers, num_workers);
+    ir_context_end_concurrent(ctx);
+  }
+  else
+#endif
+  {
+    parallel_worker_run(&workers[0]);
+  }
+
+#if !defined(__STDC_NO_THREADS__)
+  size_t first_error = atomic_load(&job.first_error);
+  bool out_of_memory = atomic_load(&job.out_of_memory);
+#else
+  size_t first_error = job.first_error;
+  bool out_of_memory = job.out_of_memory;
+#endif
+
+  if (out_of_memory)
+  {
+    fprintf(stderr, "Fatal: Out of memory while parsing function bodies\n");
+  }
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    if (!out_of_memory && first_error != SIZE_MAX && workers[i].error_body == first_error)
+    {
+      const DeferredBody *body = bodies[first_error];
+      print_parse_error(&workers[i].parser, body->source, body->len, body->line);
+    }
+    parallel_worker_destroy(&workers[i]);
+  }
+  free(workers);
+
+  return first_error == SIZE_MAX;
+}
+
+/*
+ * =================================================================
+ * --- 公共 API (Public API) ---
+ * =================================================================
+ */
+
+/**
+ * @brief 解析可选的模块头 `module = "name"`
+ *
+ * @param lexer 位于输入开头的 Lexer
+ * @param out_name [in/out] 有模块头时写入模块名，否则保持不变
+ * @param first_line 输入第一行的行号 (用于错误信息)
+ * @return bool 模块头格式错误时打印错误并返回 false
+ */
+static bool
+parse_module_header(Lexer *lexer, const char **out_name, size_t first_line)
+{
+  if (ir_lexer_current_token(lexer)->type != TK_KW_MODULE)
+    return true;
+  ir_lexer_next(lexer);
+
+  const Token *eq_tok = ir_lexer_current_token(lexer);
+  if (eq_tok->type != TK_EQ)
+  {
+
+    fprintf(stderr, "Parse Error (%zu:%zu): Expected '=' after 'module', but got %s\n", eq_tok->line + first_line - 1,
+            eq_tok->column, token_type_to_string(eq_tok->type));
+    return false;
+  }
+  ir_lexer_next(lexer);
+
+  const Token *name_tok = ir_lexer_current_token(lexer);
+  if (name_tok->type != TK_STRING_LITERAL)
+  {
+
+    fprintf(stderr, "Parse Error (%zu:%zu): Expected string literal (e.g., \"foo.c\") after 'module =', but got %s\n",
+            name_tok->line + first_line - 1, name_tok->column, token_type_to_string(name_tok->type));
+    return false;
+  }
+
+  *out_name = name_tok->as.ident_val;
+  ir_lexer_next(lexer);
+  return true;
+}
+
+/**
+ * @brief 解析长度为 source_len 的源码 (不需要以 '\0' 结尾；名字都会被驻留，不引用源码)
+ */
+static IRModule *
+parse_module_source(IRContext *ctx, const char *source_buffer, size_t source_len)
+{
+  Lexer lexer;
+  ir_lexer_init_slice(&lexer, source_buffer, source_len, ctx);
+
+  IRBuilder *builder = ir_builder_create(ctx);
+  if (!builder)
+  {
+    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
+    return NULL;
+  }
+
+  const char *module_name = "parsed_module";
+  if (!parse_module_header(&lexer, &module_name, 1))
+  {
+    ir_builder_destroy(builder);
+    return NULL;
+  }
+
+  IRModule *module = ir_module_create(ctx, module_name);
+  if (!module)
+  {
+    ir_builder_destroy(builder);
+    fprintf(stderr, "Fatal: Failed to create IRModule\n");
+    return NULL;
+  }
+
+  INSTRUMENT_BEGIN(parse_scope, "parse", module->name, NULL);
+  INSTRUMENT_TRACK_ARENA(parse_scope, &ctx->ir_arena);
+  INSTRUMENT_TRACK_ARENA(parse_scope, &ctx->permanent_arena);
+
+  Parser parser;
+  if (!parser_init(&parser, &lexer, ctx, module, builder))
+  {
+    INSTRUMENT_END(parse_scope);
+    ir_builder_destroy(builder);
+    fprintf(stderr, "Fatal: Failed to init Parser (OOM)\n");
+
+    return NULL;
+  }
+
+  parse_module_body(&parser);
+
+  bool success = !parser.has_error;
+
+  if (!success)
+  {
+
+    print_parse_error(&parser, source_buffer, source_len, 1);
+  }
+
+  parser_destroy(&parser);
+  ir_builder_destroy(builder);
+  INSTRUMENT_END(parse_scope);
+
+  if (success)
+  {
+
+    if (!ir_verify_module(module))
+    {
+
+      fprintf(stderr, "Parser Error: Generated IR failed verification.\n");
+
+      return NULL;
+    }
+    return module;
+  }
+  else
+  {
+
+    return NULL;
+  }
+}
+
+/**
+ * @brief 第一阶段: 解析顶层元素和函数头，为每个 define 记录函数体的位置 (见 "并行解析")
+ *
+ * @param parser [out] 成功时已初始化 (由调用者 parser_destroy)
+ * @param record_arena 分配 DeferredBody 记录的 Arena
+ * @param bodies [out] DeferredBody* 的列表 (按源码顺序)
+ * @return IRModule* 出错时打印错误并返回 NULL (此时 parser 已被销毁)
+ */
+static IRModule *
+parse_module_headers(IRContext *ctx, const char *source_buffer, size_t source_len, IRBuilder *builder, Parser *parser,
+                     Bump *record_arena, TempVec *bodies)
+{
+  /// 源码只被读取: eof 已经置位，stream_next_chunk 不会调用 stream_fill
+  StreamSource src = {0};
+  src.data = source_buffer ? (char *)source_buffer : "";
+  src.len = source_len;
+  src.eof = true;
+  src.line = 1;
+  stream_reset_scan(&src);
+
+  IRModule *module = NULL;
+  bool parser_ready = false;
+  bool success = true;
+
+  while (true)
+  {
+    size_t chunk_len = stream_next_chunk(&src);
+
+    Lexer lexer;
+    ir_lexer_init_slice(&lexer, src.data, chunk_len, ctx);
+
+    if (!parser_ready)
+    {
+      const char *module_name = "parsed_module";
+      if (!parse_module_header(&lexer, &module_name, src.line))
+      {
+        success = false;
+        break;
+      }
+      module = ir_module_create(ctx, module_name);
+      if (!module || !parser_init(parser, &lexer, ctx, module, builder))
+      {
+        fprintf(stderr, "Fatal: Failed to init Parser (OOM)\n");
+        success = false;
+        break;
+      }
+      parser_ready = true;
+    }
+
+    parser->lexer = &lexer;
+    while (!parser->has_error && current_token(parser)->type != TK_EOF)
+    {
+      if (current_token(parser)->type != TK_KW_DEFINE)
+      {
+        parse_top_level_element(parser);
+        continue;
+      }
+
+      IRFunction *func = parse_function_header(parser);
+      if (!func)
+        break;
+      const Token *brace = current_token(parser);
+      if (brace->type != TK_LBRACE)
+      {
+        expect(parser, TK_LBRACE);
+        break;
+      }
+
+      DeferredBody *body = BUMP_ALLOC(record_arena, DeferredBody);
+      if (!body || !temp_vec_push(bodies, body))
+      {
+        parser_error(parser, "OOM recording function body");
+        break;
+      }
+      body->func = func;
+      body->global_value_map = parser->global_value_map;
+      body->source = src.data;
+      body->len = chunk_len;
+      body->line = src.line;
+      body->brace_line = brace->line;
+      body->brace_column = brace->column;
+
+      parser->current_function = NULL;
+      parser->local_value_map = NULL;
+      /// 块的剩余部分是函数体，留给第二阶段
+      break;
+    }
+    parser->lexer = NULL;
+
+    if (parser->has_error)
+    {
+      print_parse_error(parser, src.data, chunk_len, src.line);
+      success = false;
+      break;
+    }
+
+    if (chunk_len == 0)
+      break;
+    stream_advance(&src, chunk_len);
+  }
+
+  if (success)
+    return module;
+  if (parser_ready)
+    parser_destroy(parser);
+  return NULL;
+}
+
+/**
+ * @brief 两阶段解析长度为 source_len 的源码 (见 "并行解析")
+ */
+static IRModule *
+parse_module_source_parallel(IRContext *ctx, const char *source_buffer, size_t source_len, size_t num_threads)
+{
+  IRBuilder *builder = ir_builder_create(ctx);
+  if (!builder)
+  {
+    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
+    return NULL;
+  }
+
+  /// 模块在解析头部时才创建；工作线程分配在各自的 Arena 中，只统计上下文的共享 Arena
+  INSTRUMENT_BEGIN(parse_scope, "parse", NULL, NULL);
+  INSTRUMENT_TRACK_ARENA(parse_scope, &ctx->ir_arena);
+  INSTRUMENT_TRACK_ARENA(parse_scope, &ctx->permanent_arena);
+
+  Bump body_arena;
+  bump_init(&body_arena);
+  TempVec bodies;
+  temp_vec_init(&bodies, &body_arena);
+
+  Parser parser;
+  IRModule *module = parse_module_headers(ctx, source_buffer, source_len, builder, &parser, &body_arena, &bodies);
+  bool success = module != NULL;
+
+  if (success)
+  {
+    INSTRUMENT_SET_MODULE(parse_scope, module->name);
+    success = parse_deferred_bodies(&parser, (DeferredBody **)temp_vec_data(&bodies), temp_vec_len(&bodies),
+                                    num_threads);
+    parser_destroy(&parser);
+  }
+
+  ir_builder_destroy(builder);
+  bump_destroy(&body_arena);
+  INSTRUMENT_END(parse_scope);
+
+  if (!success)
+    return NULL;
+  /// 函数体已经分给 num_threads 个线程解析，验证也一样
+  if (!ir_verify_module_parallel(module, num_threads))
+  {
+    fprintf(stderr, "Parser Error: Generated IR failed verification.\n");
+    return NULL;
+  }
+  return module;
+}
+
+/**
+ * @brief 物化一个延迟解析的函数体 (IRFunctionMaterializer)
+ */
+static bool
+materialize_deferred_body(IRFunction *func, void *data)
+{
+  const DeferredBody *body = (const DeferredBody *)data;
+  Parser parser;
+  parser_init_body_only(&parser, func->parent->context, func->parent, body->global_value_map);
+  if (!parser.builder)
+  {
+    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
+    parser_destroy(&parser);
+    return false;
+  }
+
+  parse_deferred_body(&parser, body);
+  bool success = !parser.has_error;
+  if (!success)
+    print_parse_error(&parser, body->source, body->len, body->line);
+  parser_destroy_body_only(&parser);
+
+  return success && ir_verify_function(func);
+}
+
+/**
+ * @brief 只解析函数头，函数体在第一次访问时解析 (见 "延迟解析")
+ */
+static IRModule *
+parse_module_source_lazy(IRContext *ctx, const char *source_buffer, size_t source_len)
+{
+  IRBuilder *builder = ir_builder_create(ctx);
+  if (!builder)
+  {
+    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
+    return NULL;
+  }
+
+  Bump list_arena;
+  bump_init(&list_arena);
+  TempVec bodies;
+  temp_vec_init(&bodies, &list_arena);
+
+  /// 函数体记录要活得和模块一样久
+  Parser parser;
+  IRModule *module =
+    parse_module_headers(ctx, source_buffer, source_len, builder, &parser, ir_context_ir_arena(ctx), &bodies);
+
+  if (module)
+  {
+    DeferredBody **records = (DeferredBody **)temp_vec_data(&bodies);
+    for (size_t i = 0; i < temp_vec_len(&bodies); i++)
+    {
+      records[i]->func->materializer = materialize_deferred_body;
+      records[i]->func->materializer_data = records[i];
+    }
+    parser_destroy(&parser);
+  }
+
+  ir_builder_destroy(builder);
+  bump_destroy(&list_arena);
+  return module;
+}
+
+/**
+ * @brief 解析一个完整的 IR 模块 (主入口点)
+ */
+IRModule *
+ir_parse_module(IRContext *ctx, const char *source_buffer)
+{
+  assert(ctx && source_buffer);
+  return parse_module_source(ctx, source_buffer, strlen(source_buffer));
+}
+
+/**
+ * @brief 解析一个 .cir 文件 (映射后直接在映射上扫描)
+ */
+IRModule *
+ir_parse_module_file(IRContext *ctx, const char *path)
+{
+  assert(ctx && path);
+
+  MappedFile file;
+  if (!mapped_file_open(&file, path))
+  {
+    fprintf(stderr, "Parse Error: Cannot read '%s'\n", path);
+    return NULL;
+  }
+
+  IRModule *module = parse_module_source(ctx, file.data, file.size);
+  mapped_file_close(&file);
+  return module;
+}
+
+/**
+ * @brief 并行解析一个完整的 IR 模块
+ */
+IRModule *
+ir_parse_module_parallel(IRContext *ctx, const char *source_buffer, size_t num_threads)
+{
+  assert(ctx && source_buffer);
+  return parse_module_source_parallel(ctx, source_buffer, strlen(source_buffer), num_threads);
+}
+
+/**
+ * @brief 并行解析一个 .cir 文件
+ */
+IRModule *
+ir_parse_module_file_parallel(IRContext *ctx, const char *path, size_t num_threads)
+{
+  assert(ctx && path);
+
+  MappedFile file;
+  if (!mapped_file_open(&file, path))
+  {
+    fprintf(stderr, "Parse Error: Cannot read '%s'\n", path);
+    return NULL;
+  }
+
+  IRModule *module = parse_module_source_parallel(ctx, file.data, file.size, num_threads);
+  mapped_file_close(&file);
+  return module;
+}
+
+/**
+ * @brief 延迟解析一个模块 (函数体在第一次访问时解析)
+ */
+IRModule *
+ir_parse_module_lazy(IRContext *ctx, const char *source_buffer)
+{
+  assert(ctx && source_buffer);
+  return parse_module_source_lazy(ctx, source_buffer, strlen(source_buffer));
+}
+
+/**
+ * @brief 流式解析一个模块 (逐块词法/语法分析，函数解析完即交给回调)
+ */
+IRModule *
+ir_parse_module_stream(IRContext *ctx, IRStreamReader reader, void *reader_data,
+                       IRStreamFunctionCallback on_function, void *user_data)
+{
+  assert(ctx && reader);
+
+  IRBuilder *builder = ir_builder_create(ctx);
+  if (!builder)
+  {
+    fprintf(stderr, "Fatal: Failed to create IRBuilder\n");
+    return NULL;
+  }
+
+  StreamSource src = {0};
+  src.read = reader;
+  src.read_data = reader_data;
+  src.line = 1;
+  stream_reset_scan(&src);
+
+  IRModule *module = NULL;
+  Parser parser;
+  bool parser_ready = false;
+  bool success = true;
+
+  while (true)
+  {
+    size_t chunk_len = stream_next_chunk(&src);
+    if (chunk_len == SIZE_MAX)
+    {
+      fprintf(stderr, "Fatal: Out of memory while reading the input stream\n");
+      success = false;
+      break;
+    }
+
+    Lexer lexer;
+    ir_lexer_init_slice(&lexer, src.data ? src.data : "", chunk_len, ctx);
+
+    if (!parser_ready)
+    {
+      const char *module_name = "parsed_module";
+      if (!parse_module_header(&lexer, &module_name, src.line))
+      {
+        success = false;
+        break;
+      }
+      module = ir_module_create(ctx, module_name);
+      if (!module || !parser_init(&parser, &lexer, ctx, module, builder))
+      {
+        fprintf(stderr, "Fatal: Failed to init Parser (OOM)\n");
+        success = false;
+        break;
+      }
+      parser.on_function = on_function;
+      parser.on_function_data = user_data;
+      parser_ready = true;
+    }
+
+    parser.lexer = &lexer;
+    parse_module_body(&parser);
+    if (parser.has_error)
+    {
+      print_parse_error(&parser, src.data, chunk_len, src.line);
+      success = false;
+      break;
+    }
+
+    if (chunk_len == 0)
+      break;
+    stream_consume(&src, chunk_len);
+  }
+
+  if (parser_ready)
+    parser_destroy(&parser);
+  ir_builder_destroy(builder);
+  free(src.data);
+
+  if (!success)
+    return NULL;
+  if (!ir_verify_module(module))
+  {
+    fprintf(stderr, "Parser Error: Generated IR failed verification.\n");
+    return NULL;
+  }
+  return module;
+}
+
+/**
+ * @brief 从 FILE* 流式解析模块
+ */
+IRModule *
+ir_parse_module_stream_file(IRContext *ctx, FILE *stream, IRStreamFunctionCallback on_function, void *user_data)
+{
+  assert(ctx && stream);
+
+  IRModule *module = ir_parse_module_stream(ctx, stream_read_file, stream, on_function, user_data);
+  if (ferror(stream))
+  {
+    fprintf(stderr, "Parse Error: Failed to read the input stream\n");
+    return NULL;
+  }
+  return module;
+}
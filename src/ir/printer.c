@@ -15,7 +15,11 @@
  */
 
 #include "ir/printer.h"
+#include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * --- 机制 1: FILE* 实现 ---
@@ -30,6 +34,11 @@ ir_printer_file_append_vfmt(void *target, const char *fmt, va_list args)
 {
   vfprintf((FILE *)target, fmt, args);
 }
+static void
+ir_printer_file_append_mem(void *target, const char *data, size_t len)
+{
+  fwrite(data, 1, len, (FILE *)target);
+}
 
 /*
  * --- 机制 2: StringBuf* 实现 ---
@@ -45,6 +54,105 @@ ir_printer_string_buf_append_vfmt(void *target, const char *fmt, va_list args)
 
   string_buf_vappend_fmt((StringBuf *)target, fmt, args);
 }
+static void
+ir_printer_string_buf_append_mem(void *target, const char *data, size_t len)
+{
+  string_buf_append_bytes((StringBuf *)target, data, len);
+}
+
+/*
+ * --- 机制 3: 缓冲的 FILE* 实现 ---
+ */
+
+/** @brief 缓冲策略的目标: 底层文件 + 还没写出的输出 */
+typedef struct FileBuffer
+{
+  FILE *file;
+  size_t len;
+  char data[];
+} FileBuffer;
+
+static void
+ir_printer_buffered_flush(void *target)
+{
+  FileBuffer *buf = (FileBuffer *)target;
+  if (buf->len > 0)
+  {
+    fwrite(buf->data, 1, buf->len, buf->file);
+    buf->len = 0;
+  }
+}
+static void
+ir_printer_buffered_destroy(void *target)
+{
+  ir_printer_buffered_flush(target);
+  free(target);
+}
+static void
+ir_printer_buffered_append_mem(void *target, const char *data, size_t len)
+{
+  FileBuffer *buf = (FileBuffer *)target;
+  if (len > IR_PRINTER_BUFFER_SIZE - buf->len)
+  {
+    ir_printer_buffered_flush(buf);
+    /// 比整个缓冲区还大的片段直接写出
+    if (len >= IR_PRINTER_BUFFER_SIZE)
+    {
+      fwrite(data, 1, len, buf->file);
+      return;
+    }
+  }
+  memcpy(buf->data + buf->len, data, len);
+  buf->len += len;
+}
+static void
+ir_printer_buffered_append_str(void *target, const char *str)
+{
+  ir_printer_buffered_append_mem(target, str, strlen(str));
+}
+static void
+ir_printer_buffered_append_vfmt(void *target, const char *fmt, va_list args)
+{
+  FileBuffer *buf = (FileBuffer *)target;
+  va_list retry;
+  va_copy(retry, args);
+
+  /// 先直接格式化到缓冲区的空闲部分 (vsnprintf 的 '\0' 不计入 len)
+  size_t space = IR_PRINTER_BUFFER_SIZE - buf->len;
+  int n = vsnprintf(buf->data + buf->len, space, fmt, args);
+  if (n >= 0 && (size_t)n < space)
+  {
+    buf->len += (size_t)n;
+  }
+  else if (n >= 0)
+  {
+    ir_printer_buffered_flush(buf);
+    if ((size_t)n < IR_PRINTER_BUFFER_SIZE)
+      buf->len = (size_t)vsnprintf(buf->data, IR_PRINTER_BUFFER_SIZE, fmt, retry);
+    else
+      vfprintf(buf->file, fmt, retry);
+  }
+  va_end(retry);
+}
+
+/*
+ * --- 机制 4: StringRope* 实现 ---
+ */
+static void
+ir_printer_string_rope_append_str(void *target, const char *str)
+{
+  string_rope_append_str((StringRope *)target, str);
+}
+static void
+ir_printer_string_rope_append_vfmt(void *target, const char *fmt, va_list args)
+{
+  string_rope_vappend_fmt((StringRope *)target, fmt, args);
+}
+static void
+ir_printer_string_rope_append_mem(void *target, const char *data, size_t len)
+{
+  string_rope_append_bytes((StringRope *)target, data, len);
+}
 
 /*
  * --- 公共策略 API ---
@@ -56,6 +164,10 @@ ir_printer_init_file(IRPrinter *p, FILE *f)
   p->target = f;
   p->append_str_func = ir_printer_file_append_str;
   p->append_vfmt_func = ir_printer_file_append_vfmt;
+  p->append_mem_func = ir_printer_file_append_mem;
+  p->flush_func = NULL;
+  p->destroy_func = NULL;
+  p->annotator = NULL;
 }
 
 void
@@ -64,6 +176,66 @@ ir_printer_init_string_buf(IRPrinter *p, StringBuf *buf)
   p->target = buf;
   p->append_str_func = ir_printer_string_buf_append_str;
   p->append_vfmt_func = ir_printer_string_buf_append_vfmt;
+  p->append_mem_func = ir_printer_string_buf_append_mem;
+  p->flush_func = NULL;
+  p->destroy_func = NULL;
+  p->annotator = NULL;
+}
+
+void
+ir_printer_init_file_buffered(IRPrinter *p, FILE *f)
+{
+  FileBuffer *buf = (FileBuffer *)malloc(sizeof(FileBuffer) + IR_PRINTER_BUFFER_SIZE);
+  if (!buf)
+  {
+    ir_printer_init_file(p, f);
+    return;
+  }
+  buf->file = f;
+  buf->len = 0;
+
+  p->target = buf;
+  p->append_str_func = ir_printer_buffered_append_str;
+  p->append_vfmt_func = ir_printer_buffered_append_vfmt;
+  p->append_mem_func = ir_printer_buffered_append_mem;
+  p->flush_func = ir_printer_buffered_flush;
+  p->destroy_func = ir_printer_buffered_destroy;
+  p->annotator = NULL;
+}
+
+void
+ir_printer_init_string_rope(IRPrinter *p, StringRope *rope)
+{
+  p->target = rope;
+  p->append_str_func = ir_printer_string_rope_append_str;
+  p->append_vfmt_func = ir_printer_string_rope_append_vfmt;
+  p->append_mem_func = ir_printer_string_rope_append_mem;
+  p->flush_func = NULL;
+  p->destroy_func = NULL;
+  p->annotator = NULL;
+}
+
+void
+ir_printer_flush(IRPrinter *p)
+{
+  if (p->flush_func)
+    p->flush_func(p->target);
+}
+
+void
+ir_printer_destroy(IRPrinter *p)
+{
+  if (p->destroy_func)
+    p->destroy_func(p->target);
+  p->target = NULL;
+  p->flush_func = NULL;
+  p->destroy_func = NULL;
+}
+
+void
+ir_printer_set_annotator(IRPrinter *p, const IRPrinterAnnotator *annotator)
+{
+  p->annotator = annotator;
 }
 
 /*
@@ -83,4 +255,127 @@ ir_printf(IRPrinter *p, const char *fmt, ...)
   va_start(args, fmt);
   p->append_vfmt_func(p->target, fmt, args);
   va_end(args);
-}
\ No newline at end of file
+}
+
+/*
+ * --- 快速路径 ---
+ */
+
+void
+ir_print_mem(IRPrinter *p, const char *data, size_t len)
+{
+  p->append_mem_func(p->target, data, len);
+}
+
+void
+ir_print_char(IRPrinter *p, char c)
+{
+  p->append_mem_func(p->target, &c, 1);
+}
+
+void
+ir_print_uint(IRPrinter *p, uint64_t value)
+{
+  /// 从后往前写数字 (UINT64_MAX 有 20 位)
+  char digits[20];
+  char *end = digits + sizeof(digits);
+  char *q = end;
+  do
+  {
+    *--q = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  p->append_mem_func(p->target, q, (size_t)(end - q));
+}
+
+void
+ir_print_int(IRPrinter *p, int64_t value)
+{
+  if (value < 0)
+  {
+    ir_print_char(p, '-');
+    /// 先转成无符号再取负，INT64_MIN 也不会溢出
+    ir_print_uint(p, 0 - (uint64_t)value);
+    return;
+  }
+  ir_print_uint(p, (uint64_t)value);
+}
+
+void
+ir_print_float(IRPrinter *p, double value)
+{
+  if (isnan(value))
+  {
+    ir_print_mem(p, "nan", 3);
+    return;
+  }
+  if (isinf(value))
+  {
+    ir_print_str(p, value < 0 ? "-inf" : "inf");
+    return;
+  }
+
+  /// 找到能还原 value 的最少有效数字: "%.*e" 给出 d.ddd 和十进制指数
+  char sci[32];
+  for (int precision = 0; precision < 17; precision++)
+  {
+    snprintf(sci, sizeof(sci), "%.*e", precision, value);
+    if (strtod(sci, NULL) == value)
+      break;
+  }
+
+  /// 拆出符号、有效数字 (去掉小数点和末尾的 0) 与指数
+  const char *s = sci;
+  bool negative = *s == '-';
+  if (negative)
+    s++;
+  char digits[20];
+  size_t num_digits = 0;
+  for (; *s != 'e'; s++)
+  {
+    if (*s != '.')
+      digits[num_digits++] = *s;
+  }
+  int exponent = atoi(s + 1);
+  while (num_digits > 1 && digits[num_digits - 1] == '0')
+    num_digits--;
+
+  /// 按 .cir 字面量的写法展开成定点数: 整数部分 '.' 小数部分 (两边至少一位)
+  char out[400];
+  size_t len = 0;
+  if (negative)
+    out[len++] = '-';
+  if (exponent < 0)
+  {
+    out[len++] = '0';
+    out[len++] = '.';
+    for (int i = -1; i > exponent; i--)
+      out[len++] = '0';
+    memcpy(out + len, digits, num_digits);
+    len += num_digits;
+  }
+  else
+  {
+    size_t int_digits = (size_t)exponent + 1;
+    for (size_t i = 0; i < int_digits; i++)
+      out[len++] = i < num_digits ? digits[i] : '0';
+    out[len++] = '.';
+    if (num_digits > int_digits)
+    {
+      memcpy(out + len, digits + int_digits, num_digits - int_digits);
+      len += num_digits - int_digits;
+    }
+    else
+    {
+      out[len++] = '0';
+    }
+  }
+  p->append_mem_func(p->target, out, len);
+}
+
+void
+ir_print_name(IRPrinter *p, char sigil, const char *name)
+{
+  p->append_mem_func(p->target, &sigil, 1);
+  p->append_str_func(p->target, name);
+}
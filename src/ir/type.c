@@ -38,6 +38,7 @@ ir_type_create_primitive(IRContext *ctx, IRTypeKind kind)
   }
 
   type->kind = kind;
+  type->context_id = ctx->id;
   type->as.pointee_type = NULL;
   return type;
 }
@@ -58,6 +59,7 @@ ir_type_create_ptr(IRContext *ctx, IRType *pointee_type)
   }
 
   type->kind = IR_TYPE_PTR;
+  type->context_id = ctx->id;
   type->as.pointee_type = pointee_type;
   return type;
 }
@@ -76,6 +78,7 @@ ir_type_create_array(IRContext *ctx, IRType *element_type, size_t element_count)
     return NULL;
 
   type->kind = IR_TYPE_ARRAY;
+  type->context_id = ctx->id;
   type->as.array.element_type = element_type;
   type->as.array.element_count = element_count;
 
@@ -96,6 +99,7 @@ ir_type_create_struct(IRContext *ctx, IRType **member_types, size_t member_count
     return NULL;
 
   type->kind = IR_TYPE_STRUCT;
+  type->context_id = ctx->id;
 
   if (member_count > 0)
   {
@@ -139,6 +143,7 @@ ir_type_create_function(IRContext *ctx, IRType *return_type, IRType **param_type
     return NULL;
 
   type->kind = IR_TYPE_FUNCTION;
+  type->context_id = ctx->id;
 
   type->as.function.return_type = return_type;
   type->as.function.is_variadic = is_variadic;
@@ -225,7 +230,7 @@ ir_type_dump(IRType *type, IRPrinter *p)
   case IR_TYPE_ARRAY:
 
     ir_print_str(p, "[");
-    ir_printf(p, "%zu", type->as.array.element_count);
+    ir_print_uint(p, type->as.array.element_count);
     ir_print_str(p, " x ");
     ir_type_dump(type->as.array.element_type, p);
     ir_print_str(p, "]");
@@ -235,8 +240,7 @@ ir_type_dump(IRType *type, IRPrinter *p)
 
     if (type->as.aggregate.name)
     {
-      ir_print_str(p, "%");
-      ir_print_str(p, type->as.aggregate.name);
+      ir_print_name(p, '%', type->as.aggregate.name);
       break;
     }
 
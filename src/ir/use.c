@@ -15,15 +15,92 @@
  */
 
 #include "ir/use.h"
+#include "ir/basicblock.h"
 #include "ir/context.h"
+#include "ir/function.h"
 #include "ir/instruction.h"
+#include "ir/module.h"
 #include "ir/value.h"
 #include "utils/bump.h"
 
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
 /**
- * @brief [内部] 创建一个 Use 边 (在 Arena 中)
+ * @brief [内部] 如果 node 在 [old_base, old_base + count) 的某个 Use 记录中，返回它在 new_base 中的对应位置
+ */
+static IDList *
+relocated_node(IDList *node, IRUse *old_base, IRUse *new_base, size_t count)
+{
+  uintptr_t addr = (uintptr_t)node;
+  uintptr_t begin = (uintptr_t)old_base;
+  uintptr_t end = (uintptr_t)(old_base + count);
+  if (addr < begin || addr >= end)
+    return NULL;
+  return (IDList *)((uintptr_t)new_base + (addr - begin));
+}
+
+/**
+ * @brief [内部] count 个 Use 记录从 old_base 搬到 new_base 之后，修复 Value->uses 链表
+ *
+ * 同一个 Value 的多个 Use 可能在数组中相邻 (e.g., add %x, %x)：
+ * 指向被搬动区间内的指针按偏移换算，指向区间外的邻居 (包括链表头) 改为指回新位置。
+ */
+static void
+uses_relocated(IRUse *old_base, IRUse *new_base, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    IDList *node = &new_base[i].value_node;
+
+    IDList *prev = relocated_node(node->prev, old_base, new_base, count);
+    if (prev)
+      node->prev = prev;
+    else
+      node->prev->next = node;
+
+    IDList *next = relocated_node(node->next, old_base, new_base, count);
+    if (next)
+      node->next = next;
+    else
+      node->next->prev = node;
+  }
+}
+
+/**
+ * @brief [内部] 修改 uses[0..count) 所在的 Use 链表需要的锁 (见 ir_context_use_lock_mask)
+ */
+static uint64_t
+uses_lock_mask(IRContext *ctx, const IRUse *uses, size_t count)
+{
+  uint64_t mask = 0;
+  for (size_t i = 0; i < count; i++)
+    mask |= ir_context_use_lock_mask(ctx, uses[i].value);
+  return mask;
+}
+
+/**
+ * @brief [内部] User 所在的 Context
+ */
+static inline IRContext *
+user_context(const IRInstruction *user)
+{
+  return user->parent->parent->parent->context;
+}
+
+/**
+ * @brief [内部] 操作数变了: 使用方所在的函数需要重新验证
+ */
+static void
+user_modified(IRInstruction *user)
+{
+  if (user->parent && user->parent->parent)
+    ir_function_mark_modified(user->parent->parent);
+}
+
+/**
+ * @brief [内部] 为 User 追加一个操作数
  */
 IRUse *
 ir_use_create(IRContext *ctx, IRInstruction *user, IRValueNode *value)
@@ -32,29 +109,71 @@ ir_use_create(IRContext *ctx, IRInstruction *user, IRValueNode *value)
   assert(user != NULL);
   assert(value != NULL);
 
-  IRUse *use = BUMP_ALLOC_ZEROED(&ctx->ir_arena, IRUse);
-  if (!use)
-    return NULL;
+  /// 常量、全局变量和函数可能同时被其他线程上的函数体使用 (见 ir_context_begin_concurrent)，
+  /// 它们的 uses 链表由对应的锁保护
 
+  /// 容量按 2 倍增长；搬动会改写其他 Value 的 uses 链表，所以复制和修复都在锁内完成
+  if (user->num_operands == user->operand_capacity)
+  {
+    size_t new_capacity = user->operand_capacity ? user->operand_capacity * 2 : 4;
+    IRUse *new_operands = BUMP_ALLOC_SLICE(ir_function_body_arena(user->parent->parent), IRUse, new_capacity);
+    if (!new_operands)
+      return NULL;
+    if (user->num_operands > 0)
+    {
+      uint64_t mask = uses_lock_mask(ctx, user->operands, user->num_operands);
+      ir_context_lock_uses(ctx, mask);
+      memcpy(new_operands, user->operands, user->num_operands * sizeof(IRUse));
+      uses_relocated(user->operands, new_operands, user->num_operands);
+      ir_context_unlock_uses(ctx, mask);
+    }
+    user->operands = new_operands;
+    user->operand_capacity = new_capacity;
+  }
+
+  IRUse *use = &user->operands[user->num_operands++];
   use->value = value;
   use->user = user;
+  ir_function_mark_modified(user->parent->parent);
 
-  list_add_tail(&user->operands, &use->user_node);
-
+  uint64_t mask = ir_context_use_lock_mask(ctx, value);
+  ir_context_lock_uses(ctx, mask);
   list_add_tail(&value->uses, &use->value_node);
+  ir_context_unlock_uses(ctx, mask);
 
   return use;
 }
 
 /**
- * @brief [内部] 将 Use 边从两个链表中完全解开
+ * @brief [内部] 从 User 中移除一个操作数
  */
 void
 ir_use_unlink(IRUse *use)
 {
   assert(use != NULL);
-  list_del(&use->user_node);
+
+  IRInstruction *user = use->user;
+  size_t index = (size_t)(use - user->operands);
+  assert(index < user->num_operands && "Use does not belong to its user");
+
+  /// 被移除的 Use 和后面要前移的记录所在的链表都会被改写
+  IRContext *ctx = user_context(user);
+  size_t tail = user->num_operands - index - 1;
+  uint64_t mask = uses_lock_mask(ctx, use, tail + 1);
+  ir_context_lock_uses(ctx, mask);
+
   list_del(&use->value_node);
+
+  /// 后面的记录前移一位 (保持顺序)
+  if (tail > 0)
+  {
+    memmove(use, use + 1, tail * sizeof(IRUse));
+    uses_relocated(use + 1, use, tail);
+  }
+  user->num_operands--;
+
+  ir_context_unlock_uses(ctx, mask);
+  user_modified(user);
 }
 
 /**
@@ -66,9 +185,16 @@ ir_use_set_value(IRUse *use, IRValueNode *new_val)
   assert(use != NULL);
   assert(new_val != NULL);
 
+  IRContext *ctx = user_context(use->user);
+  uint64_t mask = ir_context_use_lock_mask(ctx, use->value) | ir_context_use_lock_mask(ctx, new_val);
+  ir_context_lock_uses(ctx, mask);
+
   list_del(&use->value_node);
 
   use->value = new_val;
 
   list_add_tail(&new_val->uses, &use->value_node);
+
+  ir_context_unlock_uses(ctx, mask);
+  user_modified(use->user);
 }
\ No newline at end of file
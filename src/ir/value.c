@@ -15,12 +15,17 @@
  */
 
 #include "ir/value.h"
+#include "ir/basicblock.h"
 #include "ir/constant.h"
+#include "ir/context.h"
 #include "ir/function.h"
 #include "ir/global.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
 #include "ir/printer.h"
 #include "ir/type.h"
 #include "ir/use.h"
+#include "utils/hashmap.h"
 #include "utils/id_list.h"
 
 #include <assert.h>
@@ -92,7 +97,11 @@ ir_constant_dump_value(IRConstant *konst, IRPrinter *p)
 {
   if (konst->const_kind == CONST_KIND_INT)
   {
-    ir_printf(p, "%d", konst->data.int_val);
+    ir_print_int(p, konst->data.int_val);
+  }
+  else if (konst->const_kind == CONST_KIND_FLOAT)
+  {
+    ir_print_float(p, konst->data.float_val);
   }
   else if (konst->const_kind == CONST_KIND_UNDEF)
   {
@@ -123,15 +132,15 @@ ir_value_dump_name(IRValueNode *val, IRPrinter *p)
   switch (val->kind)
   {
   case IR_KIND_BASIC_BLOCK:
-    ir_printf(p, "$%s", val->name);
+    ir_print_name(p, '$', val->name);
     break;
   case IR_KIND_FUNCTION:
   case IR_KIND_GLOBAL:
-    ir_printf(p, "@%s", val->name);
+    ir_print_name(p, '@', val->name);
     break;
   case IR_KIND_ARGUMENT:
   case IR_KIND_INSTRUCTION:
-    ir_printf(p, "%%%s", val->name);
+    ir_print_name(p, '%', val->name);
     break;
   default:
     ir_printf(p, "<??_KIND_%d>", val->kind);
@@ -219,19 +228,66 @@ ir_value_replace_all_uses_with(IRValueNode *old_val, IRValueNode *new_val)
   assert(old_val != NULL);
   assert(new_val != NULL);
 
-  if (old_val == new_val)
+  if (old_val == new_val || list_empty(&old_val->uses))
   {
     return;
   }
 
-  IDList *iter, *temp;
-  list_for_each_safe(&old_val->uses, iter, temp)
-  {
+  /// 并发构建时共享值 (例如 erase 时换上的 undef) 的链表需要加锁
+  IRContext *ctx = list_entry(old_val->uses.next, IRUse, value_node)->user->parent->parent->parent->context;
+  uint64_t mask = ir_context_use_lock_mask(ctx, old_val) | ir_context_use_lock_mask(ctx, new_val);
+  ir_context_lock_uses(ctx, mask);
 
+  /// 只改写每个 Use 指向的 Value，链表整体一次接到 new_val 的 uses 尾部；使用方所在的函数需要重新验证
+  IDList *iter;
+  list_for_each(&old_val->uses, iter)
+  {
     IRUse *use = list_entry(iter, IRUse, value_node);
-
-    ir_use_set_value(use, new_val);
+    use->value = new_val;
+    ir_function_mark_modified(use->user->parent->parent);
   }
+  list_splice_tail(&old_val->uses, &new_val->uses);
+
+  ir_context_unlock_uses(ctx, mask);
 
   assert(list_empty(&old_val->uses));
+}
+
+/**
+ * @brief [内部] 沿替换链找到最终的 Value，并把链上的每一项直接指向它 (路径压缩)
+ */
+static IRValueNode *
+resolve_replacement(PtrHashMap *replacements, IRValueNode *val)
+{
+  IRValueNode *root = val;
+  IRValueNode *next;
+  while ((next = ptr_hashmap_get(replacements, root)) != NULL)
+  {
+    assert(next != val && "Cycle in the replacement map");
+    root = next;
+  }
+
+  /// 更新已有的 Key 不会触发扩容，所以在遍历 replacements 时也是安全的
+  while ((next = ptr_hashmap_get(replacements, val)) != NULL && next != root)
+  {
+    ptr_hashmap_put(replacements, val, root);
+    val = next;
+  }
+  return root;
+}
+
+void
+ir_value_replace_all_uses_with_map(PtrHashMap *replacements)
+{
+  assert(replacements != NULL);
+
+  PtrHashMapIter it = ptr_hashmap_iter(replacements);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&it, &entry))
+  {
+    IRValueNode *new_val = resolve_replacement(replacements, (IRValueNode *)entry.value);
+    if (new_val != entry.value)
+      ptr_hashmap_put(replacements, entry.key, new_val);
+    ir_value_replace_all_uses_with((IRValueNode *)entry.key, new_val);
+  }
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #include "ir/verifier.h"
 
+#include "analysis/analysis_manager.h"
 #include "analysis/cfg.h"
 #include "analysis/dom_tree.h"
 #include "ir/basicblock.h"
@@ -31,10 +32,18 @@
 #include "ir/value.h"
 #include "utils/bump.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
+#include "utils/string_buf.h"
 
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#include <threads.h>
+#endif
 
 /*
  * =================================================================
@@ -47,8 +56,16 @@ typedef struct
   IRFunction *current_function;
   IRBasicBlock *current_block;
   bool has_error;
+  IRVerifyLevel level;
+  /** 只在 IR_VERIFY_FULL 时构建 */
   DominatorTree *dom_tree;
-  Bump analysis_arena;
+  FunctionCFG *cfg;
+  /** 检查 phi 用的标记 (按块 id，每个 phi 用一个新的 stamp): bb 的前驱、已经见过的入边 */
+  int *pred_mark;
+  int *phi_seen;
+  int phi_stamp;
+  /** 分析用的临时数据 (调用者的 scratch Arena，验证完一个函数后回退) */
+  Bump *scratch;
   IRPrinter *p;
 } VerifierContext;
 
@@ -131,6 +148,19 @@ verify_error_impl(VerifierContext *vctx, IRValueNode *obj, const char *file, int
     }                                                                                                                  \
   } while (0)
 
+/**
+ * @brief 同 VERIFY_ASSERT，但失败时跳到 label 而不是直接返回 (用于需要统一清理的调用方)
+ */
+#define VERIFY_ASSERT_OR_GOTO(label, condition, vctx, obj, ...)                                                        \
+  do                                                                                                                   \
+  {                                                                                                                    \
+    if (!(condition))                                                                                                  \
+    {                                                                                                                  \
+      verify_error_impl((vctx), (IRValueNode *)(obj), __FILE__, __LINE__, __VA_ARGS__);                                \
+      goto label;                                                                                                      \
+    }                                                                                                                  \
+  } while (0)
+
 /*
  * =================================================================
  * --- 内部辅助函数 (基于 id_list.h) ---
@@ -143,13 +173,7 @@ verify_error_impl(VerifierContext *vctx, IRValueNode *obj, const char *file, int
 static inline int
 get_operand_count(IRInstruction *inst)
 {
-  int count = 0;
-  IDList *iter_node;
-  list_for_each(&inst->operands, iter_node)
-  {
-    count++;
-  }
-  return count;
+  return (int)ir_instruction_get_num_operands(inst);
 }
 
 /**
@@ -161,18 +185,7 @@ get_operand_count(IRInstruction *inst)
 static inline IRValueNode *
 get_operand(IRInstruction *inst, int index)
 {
-  int i = 0;
-  IDList *iter_node;
-  list_for_each(&inst->operands, iter_node)
-  {
-    if (i == index)
-    {
-      IRUse *use = list_entry(iter_node, IRUse, user_node);
-      return use->value;
-    }
-    i++;
-  }
-  return NULL;
+  return ir_instruction_get_operand(inst, (size_t)index);
 }
 
 /*
@@ -229,71 +242,6 @@ ir_is_terminator(IROpcode op)
   }
 }
 
-/**
- * @brief [内部] 检查一个终结者指令是否将 `target_bb` 作为其跳转目标之一。
- *
- * @param term 终结者指令 (必须是 IR_OP_BR 或 IR_OP_COND_BR)
- * @param target_bb 我们正在寻找的目标基本块
- * @return true 如果 'term' 跳转到 'target_bb', 否则 false
- */
-static bool
-is_terminator_predecessor(IRInstruction *term, IRBasicBlock *target_bb)
-{
-  IRValueNode *target_val = &target_bb->label_address;
-
-  switch (term->opcode)
-  {
-  case IR_OP_BR:
-    return (get_operand(term, 0) == target_val);
-
-  case IR_OP_COND_BR:
-    return (get_operand(term, 1) == target_val || get_operand(term, 2) == target_val);
-
-  case IR_OP_SWITCH: {
-    /// 检查 default (op 1)
-    if (get_operand(term, 1) == target_val)
-    {
-      return true;
-    }
-    /// 检查 cases (op 3, 5, 7...)
-    int op_count = get_operand_count(term);
-    for (int i = 3; i < op_count; i += 2)
-    {
-      if (get_operand(term, i) == target_val)
-      {
-        return true;
-      }
-    }
-    return false;
-  }
-  default:
-    return false;
-  }
-}
-
-/**
- * @brief [内部] 检查 'pred_bb' 是否在 'phi_inst' 的传入块列表中。
- *
- * @param phi_inst PHI 指令
- * @param pred_bb 我们要查找的前驱基本块
- * @return true 如果在列表中找到, 否则 false
- */
-static bool
-find_in_phi(IRInstruction *phi_inst, IRBasicBlock *pred_bb)
-{
-  IRValueNode *pred_val = &pred_bb->label_address;
-  int count = get_operand_count(phi_inst);
-
-  for (int i = 1; i < count; i += 2)
-  {
-    if (get_operand(phi_inst, i) == pred_val)
-    {
-      return true;
-    }
-  }
-  return false;
-}
-
 /*
  * =================================================================
  * --- 验证辅助函数  ---
@@ -588,7 +536,6 @@ verify_op_phi(VerifierContext *vctx, IRInstruction *inst)
   VERIFY_ASSERT(op_count > 0, vctx, value, "'phi' node cannot be empty.");
   VERIFY_ASSERT(op_count % 2 == 0, vctx, value, "'phi' node must have an even number of operands ([val, bb] pairs).");
 
-  int phi_entry_count = op_count / 2;
   for (int i = 0; i < op_count; i += 2)
   {
     IRValueNode *val = get_operand(inst, i);
@@ -596,36 +543,43 @@ verify_op_phi(VerifierContext *vctx, IRInstruction *inst)
     VERIFY_ASSERT(val->type == result_type, vctx, val, "PHI incoming value type mismatch.");
     VERIFY_ASSERT(incoming_bb_val->kind == IR_KIND_BASIC_BLOCK, vctx, incoming_bb_val,
                   "PHI incoming block must be a Basic Block.");
-    for (int j = i + 2; j < op_count; j += 2)
-    {
-      IRValueNode *other_bb_val = get_operand(inst, j);
-      VERIFY_ASSERT(incoming_bb_val != other_bb_val, vctx, &inst->result,
-                    "PHI node contains duplicate entry for the same incoming block.");
-    }
+    IRBasicBlock *incoming = container_of(incoming_bb_val, IRBasicBlock, label_address);
+    VERIFY_ASSERT(incoming->parent == func, vctx, incoming_bb_val,
+                  "PHI incoming block is not a block of this function.");
+  }
+  if (vctx->level < IR_VERIFY_FULL)
+  {
+    return true;
   }
 
-  int actual_pred_count = 0;
-  IDList *all_blocks_iter;
-  list_for_each(&func->basic_blocks, all_blocks_iter)
+  /// 先给 bb 的前驱 (CFG 中已去重，自环也算) 打上本 phi 的标记，再逐个核对入边: O(入边数 + 前驱数)
+  const FunctionCFG *cfg = vctx->cfg;
+  const CFGNode *node = &cfg->nodes[bb->id];
+  int stamp = ++vctx->phi_stamp;
+  for (int k = 0; k < node->num_preds; k++)
   {
-    IRBasicBlock *potential_pred = list_entry(all_blocks_iter, IRBasicBlock, list_node);
-    if (potential_pred == bb)
-      continue;
-    if (list_empty(&potential_pred->instructions))
-      continue;
-    IRInstruction *term = list_entry(potential_pred->instructions.prev, IRInstruction, list_node);
-    if (is_terminator_predecessor(term, bb))
-    {
-      actual_pred_count++;
-      bool found_in_phi = find_in_phi(inst, potential_pred);
-      VERIFY_ASSERT(found_in_phi, vctx, &inst->result, "PHI node is missing an entry for predecessor block '%s'.",
-                    potential_pred->label_address.name);
-    }
+    vctx->pred_mark[node->preds[k]] = stamp;
+  }
+
+  for (int i = 1; i < op_count; i += 2)
+  {
+    IRValueNode *incoming_bb_val = get_operand(inst, i);
+    IRBasicBlock *incoming = container_of(incoming_bb_val, IRBasicBlock, label_address);
+    VERIFY_ASSERT(incoming->id >= 0 && incoming->id < cfg->num_nodes && cfg->nodes[incoming->id].block == incoming,
+                  vctx, incoming_bb_val, "PHI incoming block is not a block of this function.");
+    VERIFY_ASSERT(vctx->phi_seen[incoming->id] != stamp, vctx, &inst->result,
+                  "PHI node contains duplicate entry for the same incoming block.");
+    vctx->phi_seen[incoming->id] = stamp;
+    VERIFY_ASSERT(vctx->pred_mark[incoming->id] == stamp, vctx, &inst->result,
+                  "PHI node has an entry for block '%s', which is not a predecessor.", incoming->label_address.name);
   }
 
-  VERIFY_ASSERT(phi_entry_count == actual_pred_count, vctx, &inst->result,
-                "PHI node has incorrect number of entries. Found %d, but expected %d (actual predecessors).",
-                phi_entry_count, actual_pred_count);
+  for (int k = 0; k < node->num_preds; k++)
+  {
+    const CFGNode *pred = &cfg->nodes[node->preds[k]];
+    VERIFY_ASSERT(vctx->phi_seen[pred->id] == stamp, vctx, &inst->result,
+                  "PHI node is missing an entry for predecessor block '%s'.", pred->block->label_address.name);
+  }
   return true;
 }
 
@@ -722,11 +676,10 @@ verify_instruction(VerifierContext *vctx, IRInstruction *inst)
   IRType *result_type = value->type;
   VERIFY_ASSERT(result_type != NULL, vctx, value, "Instruction result has NULL type.");
 
-  /// --- 2. SSA 支配规则检查 ---
-  IDList *iter_node;
-  list_for_each(&inst->operands, iter_node)
+  /// --- 2. SSA 支配规则检查 (结构级别只检查操作数本身) ---
+  for (size_t op_index = 0; op_index < inst->num_operands; op_index++)
   {
-    IRUse *use = list_entry(iter_node, IRUse, user_node);
+    IRUse *use = &inst->operands[op_index];
     VERIFY_ASSERT(use->user == inst, vctx, value, "Inconsistent Use-Def chain: use->user points to wrong instruction.");
     VERIFY_ASSERT(use->value != NULL, vctx, value, "Instruction has a NULL operand (use->value is NULL).");
     VERIFY_ASSERT(use->value->type != NULL, vctx, use->value, "Instruction operand has NULL type.");
@@ -735,29 +688,22 @@ verify_instruction(VerifierContext *vctx, IRInstruction *inst)
     {
       continue; /// 常量、参数、BB 等不需要支配检查
     }
-    if (inst->opcode == IR_OP_PHI)
+
+    IRInstruction *def_inst = container_of(use->value, IRInstruction, result);
+    IRBasicBlock *def_bb = def_inst->parent;
+    VERIFY_ASSERT(def_bb != NULL && def_bb->parent == func, vctx, &inst->result,
+                  "Instruction operand is not an instruction of this function.");
+
+    if (inst->opcode == IR_OP_PHI || vctx->level < IR_VERIFY_FULL)
     {
       continue; /// PHI 节点有特殊的 SSA 规则 (由 PHI 验证器自己处理)
     }
 
-    IRInstruction *def_inst = container_of(use->value, IRInstruction, result);
-    IRBasicBlock *def_bb = def_inst->parent;
     IRBasicBlock *use_bb = inst->parent;
 
     if (def_bb == use_bb)
     {
-      bool def_found_before_use = false;
-      IDList *prev_node = inst->list_node.prev;
-      while (prev_node != &use_bb->instructions)
-      {
-        if (prev_node == &def_inst->list_node)
-        {
-          def_found_before_use = true;
-          break;
-        }
-        prev_node = prev_node->prev;
-      }
-      VERIFY_ASSERT(def_found_before_use, vctx, &inst->result,
+      VERIFY_ASSERT(ir_instruction_comes_before(def_inst, inst), vctx, &inst->result,
                     "SSA Violation: Instruction operand is used *before* it is defined in the same basic block.");
     }
     else
@@ -899,37 +845,51 @@ verify_basic_block(VerifierContext *vctx, IRBasicBlock *bb)
  * =================================================================
  */
 
-bool
-ir_verify_function(IRFunction *func)
+/**
+ * @brief 按 level 验证一个函数，错误信息写到 p；am 不是 NULL 时 CFG 和支配树取自 (并留在) 它的缓存中
+ *
+ * 临时数据分配在 scratch 上，由调用方 (verify_function) 回退。
+ */
+static bool
+verify_function_body(IRFunction *func, IRAnalysisManager *am, IRPrinter *p, IRVerifyLevel level, Bump *scratch)
 {
-  IRPrinter p;
-  ir_printer_init_file(&p, stderr);
+  /// 延迟加载的函数体在物化时已经通过验证
+  if (func && !ir_function_is_materialized(func))
+    return ir_function_materialize(func);
+
   VerifierContext vctx = {0};
-  vctx.p = &p;
+  vctx.p = p;
+  vctx.level = level;
 
   VERIFY_ASSERT(func != NULL, &vctx, NULL, "Function is NULL.");
   VERIFY_ASSERT(func->parent != NULL, &vctx, &func->entry_address, "Function has no parent Module.");
   VERIFY_ASSERT(func->return_type != NULL, &vctx, &func->entry_address, "Function has NULL return type.");
 
   vctx.current_function = func;
+  /// 中途失败时保持 IR_VERIFY_NONE；通过时记录两次验证中较高的级别 (函数没有被修改过)
+  IRVerifyLevel previous_level = func->verified_level;
+  func->verified_level = IR_VERIFY_NONE;
+  IRVerifyLevel passed_level = previous_level > level ? previous_level : level;
 
-  bump_init(&vctx.analysis_arena);
+  vctx.scratch = scratch;
   FunctionCFG *cfg = NULL;
   DominatorTree *doms = NULL;
+  bool ok = false;
 
+  /// 从这里开始所有失败都经过 done: 释放自己构建的分析
   IDList *arg_it;
   list_for_each(&func->arguments, arg_it)
   {
     IRArgument *arg = list_entry(arg_it, IRArgument, list_node);
-    VERIFY_ASSERT(arg->parent == func, &vctx, &arg->value, "Argument's parent pointer is incorrect.");
-    VERIFY_ASSERT(arg->value.type != NULL, &vctx, &arg->value, "Argument has NULL type.");
-    VERIFY_ASSERT(arg->value.type->kind != IR_TYPE_VOID, &vctx, &arg->value,
-                  "Function argument cannot have void type.");
+    VERIFY_ASSERT_OR_GOTO(done, arg->parent == func, &vctx, &arg->value, "Argument's parent pointer is incorrect.");
+    VERIFY_ASSERT_OR_GOTO(done, arg->value.type != NULL, &vctx, &arg->value, "Argument has NULL type.");
+    VERIFY_ASSERT_OR_GOTO(done, arg->value.type->kind != IR_TYPE_VOID, &vctx, &arg->value,
+                          "Function argument cannot have void type.");
 
     if (!func->is_declaration)
     {
-      VERIFY_ASSERT(arg->value.name != NULL, &vctx, &arg->value,
-                    "Argument in a function *definition* must have a name.");
+      VERIFY_ASSERT_OR_GOTO(done, arg->value.name != NULL, &vctx, &arg->value,
+                            "Argument in a function *definition* must have a name.");
     }
   }
 
@@ -938,71 +898,155 @@ ir_verify_function(IRFunction *func)
   if (func->is_declaration)
   {
 
-    VERIFY_ASSERT(!has_blocks, &vctx, &func->entry_address, "'declare' function '@%s' cannot have basic blocks.",
-                  func->entry_address.name);
-
-    bump_destroy(&vctx.analysis_arena);
-    return !vctx.has_error;
+    VERIFY_ASSERT_OR_GOTO(done, !has_blocks, &vctx, &func->entry_address,
+                          "'declare' function '@%s' cannot have basic blocks.", func->entry_address.name);
   }
   else
   {
 
-    VERIFY_ASSERT(has_blocks, &vctx, &func->entry_address,
-                  "'define' function '@%s' must have at least one basic block.", func->entry_address.name);
-
-    cfg = cfg_build(func, &vctx.analysis_arena);
-    doms = dom_tree_build(cfg, &vctx.analysis_arena);
-    vctx.dom_tree = doms;
-  }
-
-  IDList *bb_it;
-  list_for_each(&func->basic_blocks, bb_it)
-  {
-    IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
-    VERIFY_ASSERT(bb->parent == func, &vctx, &bb->label_address, "BasicBlock's parent pointer is incorrect.");
+    VERIFY_ASSERT_OR_GOTO(done, has_blocks, &vctx, &func->entry_address,
+                          "'define' function '@%s' must have at least one basic block.", func->entry_address.name);
 
-    if (!verify_basic_block(&vctx, bb))
+    /// 结构检查不需要任何分析
+    if (level >= IR_VERIFY_FULL)
     {
+      if (am)
+      {
+        vctx.cfg = ir_analysis_get_cfg(am, func);
+        vctx.dom_tree = ir_analysis_get_dom_tree(am, func);
+      }
+      else
+      {
+        cfg = cfg_build(func, scratch);
+        doms = cfg ? dom_tree_build(cfg, scratch) : NULL;
+        vctx.cfg = cfg;
+        vctx.dom_tree = doms;
+      }
+      size_t num_nodes = vctx.cfg ? (size_t)vctx.cfg->num_nodes : 0;
+      vctx.pred_mark = BUMP_ALLOC_SLICE_ZEROED(scratch, int, num_nodes + 1);
+      vctx.phi_seen = BUMP_ALLOC_SLICE_ZEROED(scratch, int, num_nodes + 1);
+      VERIFY_ASSERT_OR_GOTO(done, vctx.cfg && vctx.dom_tree && vctx.pred_mark && vctx.phi_seen, &vctx,
+                            &func->entry_address, "Out of memory while building the CFG of '@%s'.",
+                            func->entry_address.name);
+    }
 
-      if (doms)
-        dom_tree_destroy(doms);
-      if (cfg)
-        cfg_destroy(cfg);
-      bump_destroy(&vctx.analysis_arena);
-      return false;
+    IDList *bb_it;
+    list_for_each(&func->basic_blocks, bb_it)
+    {
+      IRBasicBlock *bb = list_entry(bb_it, IRBasicBlock, list_node);
+      VERIFY_ASSERT_OR_GOTO(done, bb->parent == func, &vctx, &bb->label_address,
+                            "BasicBlock's parent pointer is incorrect.");
+      if (!verify_basic_block(&vctx, bb))
+        goto done;
     }
   }
 
+  ok = !vctx.has_error;
+
+done:
   if (doms)
     dom_tree_destroy(doms);
   if (cfg)
     cfg_destroy(cfg);
-  bump_destroy(&vctx.analysis_arena);
 
-  return !vctx.has_error;
+  if (ok)
+    func->verified_level = passed_level;
+  return ok;
+}
+
+/**
+ * @brief verify_function_body 加上 "verify" 阶段的计时 (见 utils/instrument.h)
+ *
+ * 返回前把 scratch 回退到进入时的位置，所以验证整个模块时所有函数共用同一段内存，
+ * 峰值只取决于最大的函数。回退放在作用域结束之后，记录的分配量是这个函数让 scratch 增长到的峰值。
+ */
+static bool
+verify_function(IRFunction *func, IRAnalysisManager *am, IRPrinter *p, IRVerifyLevel level, Bump *scratch)
+{
+  BumpMark scratch_mark = bump_mark(scratch);
+  INSTRUMENT_BEGIN(scope, "verify", func && func->parent ? func->parent->name : NULL,
+                   func ? func->entry_address.name : NULL);
+  INSTRUMENT_TRACK_ARENA(scope, scratch);
+  bool ok = verify_function_body(func, am, p, level, scratch);
+  INSTRUMENT_END(scope);
+  bump_rewind(scratch, scratch_mark);
+  return ok;
+}
+
+/**
+ * @brief 模块所在 Context 的验证级别 (还没有 Context 时按完整检查)
+ */
+static IRVerifyLevel
+module_level(const IRModule *mod)
+{
+  return mod && mod->context ? mod->context->verify_level : IR_VERIFY_FULL;
+}
+
+static IRVerifyLevel
+function_level(const IRFunction *func)
+{
+  return func ? module_level(func->parent) : IR_VERIFY_FULL;
 }
 
 bool
-ir_verify_module(IRModule *mod)
+ir_verify_function(IRFunction *func)
+{
+  IRPrinter p;
+  ir_printer_init_file(&p, stderr);
+  Bump scratch;
+  bump_init(&scratch);
+  bool ok = verify_function(func, NULL, &p, function_level(func), &scratch);
+  bump_destroy(&scratch);
+  return ok;
+}
+
+bool
+ir_verify_function_with_analyses(IRFunction *func, IRAnalysisManager *am)
 {
+  IRPrinter p;
+  ir_printer_init_file(&p, stderr);
+  Bump scratch;
+  bump_init(&scratch);
+  bool ok = verify_function(func, am, &p, function_level(func), &scratch);
+  bump_destroy(&scratch);
+  return ok;
+}
 
+bool
+ir_verify_function_level(IRFunction *func, IRVerifyLevel level)
+{
   IRPrinter p;
   ir_printer_init_file(&p, stderr);
+  Bump scratch;
+  bump_init(&scratch);
+  bool ok = verify_function(func, NULL, &p, level, &scratch);
+  bump_destroy(&scratch);
+  return ok;
+}
 
-  VerifierContext vctx = {0};
-  vctx.p = &p;
+bool
+ir_function_is_verified(const IRFunction *func)
+{
+  return func->verified_level >= function_level(func);
+}
 
-  VERIFY_ASSERT(mod != NULL, &vctx, NULL, "Module is NULL.");
-  VERIFY_ASSERT(mod->context != NULL, &vctx, NULL, "Module has no Context.");
+/**
+ * @brief 验证模块本身、全局变量和每个函数的 parent 指针 (不进入函数体)
+ */
+static bool
+verify_module_shell(VerifierContext *vctx, IRModule *mod)
+{
+  VERIFY_ASSERT(mod != NULL, vctx, NULL, "Module is NULL.");
+  VERIFY_ASSERT(mod->context != NULL, vctx, NULL, "Module has no Context.");
 
   IDList *global_it;
   list_for_each(&mod->globals, global_it)
   {
     IRGlobalVariable *global = list_entry(global_it, IRGlobalVariable, list_node);
 
-    VERIFY_ASSERT(global->parent == mod, &vctx, &global->value, "Global's parent pointer is incorrect.");
-    VERIFY_ASSERT(global->allocated_type != NULL, &vctx, &global->value, "Global has NULL allocated_type.");
-    VERIFY_ASSERT(global->value.type->kind == IR_TYPE_PTR, &vctx, &global->value,
+    VERIFY_ASSERT(global->parent == mod, vctx, &global->value, "Global's parent pointer is incorrect.");
+    VERIFY_ASSERT(global->allocated_type != NULL, vctx, &global->value, "Global has NULL allocated_type.");
+    VERIFY_ASSERT(global->value.type->kind == IR_TYPE_PTR, vctx, &global->value,
                   "Global's value must be a pointer type.");
 
     if (global->initializer)
@@ -1011,9 +1055,9 @@ ir_verify_module(IRModule *mod)
       bool is_valid_initializer = (global->initializer->kind == IR_KIND_CONSTANT) ||
                                   (global->initializer->kind == IR_KIND_FUNCTION) ||
                                   (global->initializer->kind == IR_KIND_GLOBAL);
-      VERIFY_ASSERT(is_valid_initializer, &vctx, global->initializer,
+      VERIFY_ASSERT(is_valid_initializer, vctx, global->initializer,
                     "Global initializer must be a constant, function, or another global.");
-      VERIFY_ASSERT(global->initializer->type == global->allocated_type, &vctx, global->initializer,
+      VERIFY_ASSERT(global->initializer->type == global->allocated_type, vctx, global->initializer,
                     "Global initializer type mismatch allocated_type.");
     }
   }
@@ -1022,14 +1066,255 @@ ir_verify_module(IRModule *mod)
   list_for_each(&mod->functions, func_it)
   {
     IRFunction *func = list_entry(func_it, IRFunction, list_node);
-    VERIFY_ASSERT(func->parent == mod, &vctx, &func->entry_address, "Function's parent pointer is incorrect.");
+    VERIFY_ASSERT(func->parent == mod, vctx, &func->entry_address, "Function's parent pointer is incorrect.");
+  }
+  return !vctx->has_error;
+}
 
-    if (!ir_verify_function(func))
+/**
+ * @brief 按 level 验证模块；incremental 时跳过上次 (以不低于 level 的级别) 通过验证之后没有被修改的函数
+ */
+static bool
+verify_module(IRModule *mod, IRAnalysisManager *am, bool incremental, IRVerifyLevel level)
+{
+  IRPrinter p;
+  ir_printer_init_file(&p, stderr);
+
+  VerifierContext vctx = {0};
+  vctx.p = &p;
+  if (!verify_module_shell(&vctx, mod))
+    return false;
+
+  Bump scratch;
+  bump_init(&scratch);
+  bool ok = true;
+  IDList *func_it;
+  list_for_each(&mod->functions, func_it)
+  {
+    IRFunction *func = list_entry(func_it, IRFunction, list_node);
+    if (incremental && func->verified_level >= level)
+      continue;
+    if (!verify_function(func, am, &p, level, &scratch))
     {
+      ok = false;
+      break;
+    }
+  }
+  bump_destroy(&scratch);
+  return ok;
+}
 
-      return false;
+bool
+ir_verify_module(IRModule *mod)
+{
+  return verify_module(mod, NULL, false, module_level(mod));
+}
+
+bool
+ir_verify_module_with_analyses(IRModule *mod, IRAnalysisManager *am)
+{
+  return verify_module(mod, am, false, module_level(mod));
+}
+
+bool
+ir_verify_module_level(IRModule *mod, IRVerifyLevel level)
+{
+  return verify_module(mod, NULL, false, level);
+}
+
+bool
+ir_verify_module_incremental(IRModule *mod)
+{
+  return verify_module(mod, NULL, true, module_level(mod));
+}
+
+bool
+ir_verify_module_incremental_with_analyses(IRModule *mod, IRAnalysisManager *am)
+{
+  return verify_module(mod, am, true, module_level(mod));
+}
+
+/*
+ * =================================================================
+ * --- 并行验证 ---
+ * =================================================================
+ */
+
+#if !defined(__STDC_NO_THREADS__)
+static bool
+verify_functions_serial(IRFunction **funcs, size_t num_funcs, IRVerifyLevel level)
+{
+  IRPrinter p;
+  ir_printer_init_file(&p, stderr);
+  Bump scratch;
+  bump_init(&scratch);
+  bool ok = true;
+  for (size_t i = 0; i < num_funcs && ok; i++)
+  {
+    ok = verify_function(funcs[i], NULL, &p, level, &scratch);
+  }
+  bump_destroy(&scratch);
+  return ok;
+}
+
+/** @brief 所有 worker 共享的任务: 按模块中的顺序领取函数 */
+typedef struct VerifyJob
+{
+  IRFunction **funcs;
+  size_t num_funcs;
+  IRVerifyLevel level;
+  /** 下一个要领取的函数 */
+  atomic_size_t next;
+  /** 已知失败的函数中最小的下标 (没有时为 num_funcs)；比它大的函数不必再验证 */
+  atomic_size_t first_failed;
+} VerifyJob;
+
+/** @brief 一个 worker 的私有状态 */
+typedef struct VerifyWorker
+{
+  VerifyJob *job;
+  /** 诊断信息的 Arena (BumpGroup 的一员) */
+  Bump *arena;
+  /** 本 worker 失败的函数 (没有时为 num_funcs) 和它的诊断信息 */
+  size_t failed_index;
+  StringBuf diagnostics;
+} VerifyWorker;
+
+static int
+verify_worker_main(void *arg)
+{
+  VerifyWorker *w = (VerifyWorker *)arg;
+  VerifyJob *job = w->job;
+  /// 诊断信息要活到汇报时，临时数据另用一个每个函数都会回退的 Arena
+  Bump scratch;
+  bump_init(&scratch);
+  while (true)
+  {
+    /// 每个 worker 领到的下标递增，所以一旦超过已知的失败就可以停下
+    size_t index = atomic_fetch_add(&job->next, 1);
+    if (index >= job->num_funcs || index > atomic_load(&job->first_failed))
+      break;
+
+    StringBuf buf;
+    string_buf_init(&buf, w->arena);
+    IRPrinter p;
+    ir_printer_init_string_buf(&p, &buf);
+    if (verify_function(job->funcs[index], NULL, &p, job->level, &scratch))
+      continue;
+
+    w->failed_index = index;
+    w->diagnostics = buf;
+    size_t current = atomic_load(&job->first_failed);
+    while (index < current && !atomic_compare_exchange_weak(&job->first_failed, &current, index))
+    {
+    }
+    break;
+  }
+  bump_destroy(&scratch);
+  return 0;
+}
+
+/**
+ * @brief 在 num_workers 个线程 (其中一个是调用线程) 上验证 funcs，只打印第一个失败函数的诊断信息
+ */
+static bool
+verify_functions_parallel(IRFunction **funcs, size_t num_funcs, size_t num_workers, IRVerifyLevel level)
+{
+  VerifyJob job = {.funcs = funcs, .num_funcs = num_funcs, .level = level};
+  atomic_init(&job.next, 0);
+  atomic_init(&job.first_failed, num_funcs);
+
+  VerifyWorker *workers = (VerifyWorker *)calloc(num_workers, sizeof(VerifyWorker));
+  thrd_t *threads = (thrd_t *)malloc((num_workers - 1) * sizeof(thrd_t));
+  BumpGroup arenas;
+  if (!workers || !threads || !bump_group_init(&arenas, NULL, num_workers))
+  {
+    free(workers);
+    free(threads);
+    return verify_functions_serial(funcs, num_funcs, level);
+  }
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    workers[i].job = &job;
+    workers[i].failed_index = num_funcs;
+    workers[i].arena = bump_group_local(&arenas, i);
+  }
+
+  /// 线程启动失败时函数由已经启动的 worker 和调用线程分担
+  size_t started = 0;
+  while (started < num_workers - 1 &&
+         thrd_create(&threads[started], verify_worker_main, &workers[started + 1]) == thrd_success)
+  {
+    started++;
+  }
+  verify_worker_main(&workers[0]);
+  for (size_t i = 0; i < started; i++)
+  {
+    thrd_join(threads[i], NULL);
+  }
+
+  /// 与串行验证一样，只报告模块中第一个出错的函数
+  size_t first_failed = atomic_load(&job.first_failed);
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    if (workers[i].failed_index == first_failed && first_failed < num_funcs)
+    {
+      fwrite(workers[i].diagnostics.data, 1, workers[i].diagnostics.len, stderr);
     }
   }
+  bump_group_finish(&arenas);
+  free(threads);
+  free(workers);
+  return first_failed == num_funcs;
+}
+#endif
+
+bool
+ir_verify_module_parallel(IRModule *mod, size_t num_threads)
+{
+#if !defined(__STDC_NO_THREADS__)
+  if (num_threads <= 1 || !mod)
+    return verify_module(mod, NULL, false, module_level(mod));
 
-  return !vctx.has_error;
-}
\ No newline at end of file
+  IRPrinter p;
+  ir_printer_init_file(&p, stderr);
+  VerifierContext vctx = {0};
+  vctx.p = &p;
+  if (!verify_module_shell(&vctx, mod))
+    return false;
+
+  size_t num_funcs = 0;
+  IDList *func_it;
+  list_for_each(&mod->functions, func_it)
+  {
+    num_funcs++;
+  }
+  IRFunction **funcs = (IRFunction **)malloc((num_funcs + 1) * sizeof(IRFunction *));
+  if (!funcs)
+    return verify_module(mod, NULL, false, module_level(mod));
+
+  /// 物化会向上下文分配，必须在调用线程上先做完；物化失败的函数之前的函数仍然要验证
+  size_t count = 0;
+  bool materialized = true;
+  list_for_each(&mod->functions, func_it)
+  {
+    IRFunction *func = list_entry(func_it, IRFunction, list_node);
+    if (!ir_function_is_materialized(func) && !ir_function_materialize(func))
+    {
+      materialized = false;
+      break;
+    }
+    funcs[count++] = func;
+  }
+
+  size_t num_workers = num_threads < count ? num_threads : count;
+  IRVerifyLevel level = module_level(mod);
+  bool ok = num_workers > 1 ? verify_functions_parallel(funcs, count, num_workers, level)
+                            : verify_functions_serial(funcs, count, level);
+  free(funcs);
+  return ok && materialized;
+#else
+  (void)num_threads;
+  return verify_module(mod, NULL, false, module_level(mod));
+#endif
+}
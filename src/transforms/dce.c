@@ -0,0 +1,148 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/dce.h"
+
+#include "analysis/analysis_manager.h"
+#include "ir/basicblock.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 无论结果是否被使用都必须保留的指令 (标记的起点)
+ */
+static bool
+is_root(const IRInstruction *inst)
+{
+  switch (inst->opcode)
+  {
+  case IR_OP_RET:
+  case IR_OP_BR:
+  case IR_OP_COND_BR:
+  case IR_OP_SWITCH:
+  case IR_OP_STORE:
+  case IR_OP_CALL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief 把 inst 标记为活的；第一次标记时放进工作表
+ */
+static void
+mark_live(PtrHashMap *live, IRInstruction **worklist, size_t *num_work, IRInstruction *inst)
+{
+  if (ptr_hashmap_contains(live, inst))
+    return;
+  ptr_hashmap_put(live, inst, inst);
+  worklist[(*num_work)++] = inst;
+}
+
+bool
+ir_transform_dce_run(IRFunction *func)
+{
+  if (!func)
+    return false;
+
+  Bump scratch;
+  bump_init(&scratch);
+
+  size_t num_insts = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      num_insts++;
+    }
+  }
+
+  PtrHashMap *live = ptr_hashmap_create(&scratch, num_insts);
+  IRInstruction **worklist = BUMP_ALLOC_SLICE(&scratch, IRInstruction *, num_insts + 1);
+  if (!live || !worklist)
+  {
+    bump_destroy(&scratch);
+    return false;
+  }
+
+  /// 1. 从根出发，沿操作数把定义它们的指令标记为活的
+  size_t num_work = 0;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (is_root(inst))
+        mark_live(live, worklist, &num_work, inst);
+    }
+  }
+  while (num_work > 0)
+  {
+    IRInstruction *inst = worklist[--num_work];
+    for (size_t i = 0; i < inst->num_operands; i++)
+    {
+      IRValueNode *operand = inst->operands[i].value;
+      if (operand->kind == IR_KIND_INSTRUCTION)
+        mark_live(live, worklist, &num_work, container_of(operand, IRInstruction, result));
+    }
+  }
+
+  /// 2. 删除没有标记的指令。从块尾往前删，使用者通常先于定义被删除；
+  /// 死环中剩下的 Use 由 ir_instruction_erase_from_parent 换成 undef (它们随后也会被删除)
+  bool changed = false;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *iter = bb->instructions.prev;
+    while (iter != &bb->instructions)
+    {
+      IDList *prev = iter->prev;
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      if (!ptr_hashmap_contains(live, inst))
+      {
+        ir_instruction_erase_from_parent(inst);
+        changed = true;
+      }
+      iter = prev;
+    }
+  }
+
+  bump_destroy(&scratch);
+  return changed;
+}
+
+bool
+ir_transform_dce_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  bool changed = ir_transform_dce_run(func);
+  if (changed)
+    ir_analysis_invalidate(am, func, IR_TRANSFORM_DCE_PRESERVES);
+  return changed;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/gvn.h"
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#define XXH_INLINE_ALL
+#include "utils/xxhash.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 参与编号的指令: 结果只取决于操作数和指令本身的属性，没有副作用，也不读内存
+ */
+static bool
+is_numberable(const IRInstruction *inst)
+{
+  switch (inst->opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_UDIV:
+  case IR_OP_SDIV:
+  case IR_OP_UREM:
+  case IR_OP_SREM:
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+  case IR_OP_GEP:
+  case IR_OP_ICMP:
+  case IR_OP_FCMP:
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+  case IR_OP_FPTRUNC:
+  case IR_OP_FPEXT:
+  case IR_OP_FPTOUI:
+  case IR_OP_FPTOSI:
+  case IR_OP_UITOFP:
+  case IR_OP_SITOFP:
+  case IR_OP_PTRTOINT:
+  case IR_OP_INTTOPTR:
+  case IR_OP_BITCAST:
+  case IR_OP_SELECT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief 交换两个操作数不改变结果的指令
+ */
+static bool
+is_commutative(const IRInstruction *inst)
+{
+  switch (inst->opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_MUL:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+  case IR_OP_FADD:
+  case IR_OP_FMUL:
+    return true;
+  case IR_OP_ICMP:
+    return inst->as.icmp.predicate == IR_ICMP_EQ || inst->as.icmp.predicate == IR_ICMP_NE;
+  case IR_OP_FCMP:
+    switch (inst->as.fcmp.predicate)
+    {
+    case IR_FCMP_OEQ:
+    case IR_FCMP_ONE:
+    case IR_FCMP_UEQ:
+    case IR_FCMP_UNE:
+    case IR_FCMP_ORD:
+    case IR_FCMP_UNO:
+      return true;
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+/** @brief 指令本身的属性 (比较谓词、gep 的源类型和 inbounds)，操作数相同时它们也必须相同 */
+static uint64_t
+instruction_attributes(const IRInstruction *inst)
+{
+  switch (inst->opcode)
+  {
+  case IR_OP_ICMP:
+    return (uint64_t)inst->as.icmp.predicate;
+  case IR_OP_FCMP:
+    return (uint64_t)inst->as.fcmp.predicate;
+  case IR_OP_GEP:
+    return (uint64_t)(uintptr_t)inst->as.gep.source_type ^ (uint64_t)inst->as.gep.inbounds;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief GenericHashMap 的哈希函数: key 是指令本身 (表达式就是它的操作码、类型、属性和操作数)
+ *
+ * 可交换的指令按地址排序两个操作数，使 a + b 与 b + a 得到同一个哈希值。
+ */
+static uint64_t
+expression_hash(const void *key)
+{
+  const IRInstruction *inst = key;
+  uint64_t header[3] = {(uint64_t)inst->opcode, (uint64_t)(uintptr_t)inst->result.type, instruction_attributes(inst)};
+  uint64_t hash = XXH3_64bits(header, sizeof(header));
+
+  if (inst->num_operands == 2 && is_commutative(inst))
+  {
+    uintptr_t a = (uintptr_t)inst->operands[0].value;
+    uintptr_t b = (uintptr_t)inst->operands[1].value;
+    uintptr_t pair[2] = {a < b ? a : b, a < b ? b : a};
+    return XXH3_64bits_withSeed(pair, sizeof(pair), hash);
+  }
+  for (size_t i = 0; i < inst->num_operands; i++)
+    hash = XXH3_64bits_withSeed(&inst->operands[i].value, sizeof(IRValueNode *), hash);
+  return hash;
+}
+
+static bool
+expression_equal(const void *key1, const void *key2)
+{
+  const IRInstruction *a = key1;
+  const IRInstruction *b = key2;
+  if (a->opcode != b->opcode || a->result.type != b->result.type || a->num_operands != b->num_operands ||
+      instruction_attributes(a) != instruction_attributes(b))
+    return false;
+  if (a->opcode == IR_OP_GEP && (a->as.gep.source_type != b->as.gep.source_type ||
+                                 a->as.gep.inbounds != b->as.gep.inbounds))
+    return false;
+
+  bool same = true;
+  for (size_t i = 0; i < a->num_operands && same; i++)
+    same = a->operands[i].value == b->operands[i].value;
+  if (!same && a->num_operands == 2 && is_commutative(a))
+    same = a->operands[0].value == b->operands[1].value && a->operands[1].value == b->operands[0].value;
+  return same;
+}
+
+/**
+ * @brief 编号一个块: 已经有支配它的等价指令 (leader) 的指令被替换并删除，其余的成为 leader
+ *
+ * 新的 leader 记在 scope 中，离开这个块的支配子树时从表中移除。
+ */
+static bool
+number_block(GenericHashMap *leaders, IRBasicBlock *bb, IRInstruction **scope, size_t *scope_len)
+{
+  bool changed = false;
+  IDList *iter, *next;
+  list_for_each_safe(&bb->instructions, iter, next)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    if (!is_numberable(inst))
+      continue;
+
+    IRInstruction *leader = generic_hashmap_get(leaders, inst);
+    if (leader)
+    {
+      ir_value_replace_all_uses_with(&inst->result, &leader->result);
+      ir_instruction_erase_from_parent(inst);
+      changed = true;
+    }
+    else if (generic_hashmap_put(leaders, inst, inst))
+    {
+      scope[(*scope_len)++] = inst;
+    }
+  }
+  return changed;
+}
+
+bool
+ir_transform_gvn_run(IRFunction *func, DominatorTree *dt)
+{
+  if (!func || !dt || dt->num_reachable == 0)
+    return false;
+
+  Bump scratch;
+  bump_init(&scratch);
+
+  size_t num_insts = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      num_insts++;
+    }
+  }
+
+  GenericHashMap *leaders = generic_hashmap_create(&scratch, num_insts, expression_hash, expression_equal);
+  /// scope 是按支配树先序排列的 leader；marks[k] 是 open[k] 的 leader 在 scope 中开始的位置
+  IRInstruction **scope = BUMP_ALLOC_SLICE(&scratch, IRInstruction *, num_insts + 1);
+  DomTreeNode **open = BUMP_ALLOC_SLICE(&scratch, DomTreeNode *, dt->num_reachable);
+  size_t *marks = BUMP_ALLOC_SLICE(&scratch, size_t, dt->num_reachable);
+  if (!leaders || !scope || !open || !marks)
+  {
+    bump_destroy(&scratch);
+    return false;
+  }
+
+  /// 与 mem2reg 的重命名相同: 显式栈上是当前块在支配树上的祖先链，弹出祖先时撤销它的 leader
+  bool changed = false;
+  size_t scope_len = 0;
+  int top = 0;
+  for (int i = 0; i < dt->num_reachable; i++)
+  {
+    DomTreeNode *node = dt->dom_preorder[i];
+    while (top > 0 && open[top - 1]->dom_post < node->dom_post)
+    {
+      top--;
+      while (scope_len > marks[top])
+        generic_hashmap_remove(leaders, scope[--scope_len]);
+    }
+    open[top] = node;
+    marks[top++] = scope_len;
+    if (number_block(leaders, node->cfg_node->block, scope, &scope_len))
+      changed = true;
+  }
+
+  bump_destroy(&scratch);
+  return changed;
+}
+
+bool
+ir_transform_gvn_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  DominatorTree *dt = ir_analysis_get_dom_tree(am, func);
+  if (!dt)
+    return false;
+
+  bool changed = ir_transform_gvn_run(func, dt);
+  if (changed)
+    ir_analysis_invalidate(am, func, IR_TRANSFORM_GVN_PRESERVES);
+  return changed;
+}
@@ -0,0 +1,490 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/inline.h"
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void
+ir_inline_params_init(IRInlineParams *params)
+{
+  params->max_callee_insts = 32;
+  params->hot_max_callee_insts = 256;
+  params->hot_call_threshold = 1000;
+  params->max_caller_insts = 20000;
+  params->profile = NULL;
+}
+
+/*
+ * =================================================================
+ * --- 内联一个调用点 ---
+ * =================================================================
+ */
+
+/** @brief 直接调用的被调者 (间接调用时返回 NULL) */
+static IRFunction *
+direct_callee(IRInstruction *call)
+{
+  IRValueNode *callee = ir_instruction_get_operand(call, 0);
+  return callee->kind == IR_KIND_FUNCTION ? container_of(callee, IRFunction, entry_address) : NULL;
+}
+
+static size_t
+count_instructions(IRFunction *func)
+{
+  size_t count = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 调用点能否内联 (不考虑代价)
+ */
+static bool
+can_inline(IRInstruction *call, IRFunction *callee)
+{
+  if (!callee || callee->is_declaration || callee == call->parent->parent || !ir_function_materialize(callee))
+    return false;
+  if (list_empty(&callee->basic_blocks) || callee->function_type->as.function.is_variadic)
+    return false;
+
+  size_t num_args = 0;
+  IDList *iter;
+  list_for_each(&callee->arguments, iter)
+  {
+    num_args++;
+  }
+  if (num_args != call->num_operands - 1)
+    return false;
+
+  /// 入口块有前驱时，跳到它的 br 不能与调用处的入口区分开
+  IRBasicBlock *entry = list_entry(callee->basic_blocks.next, IRBasicBlock, list_node);
+  return list_empty(&entry->label_address.uses);
+}
+
+/** @brief 给复制出的值加上 ".i<tag>" 后缀 (没有名字的值保持没有名字) */
+static void
+add_name_suffix(IRValueNode *value, size_t tag)
+{
+  if (!value->name)
+    return;
+  char buffer[128];
+  int len = snprintf(buffer, sizeof(buffer), "%s.i%zu", value->name, tag);
+  if (len < 0)
+    return;
+  if ((size_t)len < sizeof(buffer))
+  {
+    ir_value_set_name(value, buffer);
+    return;
+  }
+  char *long_name = malloc((size_t)len + 1);
+  if (!long_name)
+    return;
+  snprintf(long_name, (size_t)len + 1, "%s.i%zu", value->name, tag);
+  ir_value_set_name(value, long_name);
+  free(long_name);
+}
+
+bool
+ir_transform_inline_call(IRInstruction *call)
+{
+  assert(call != NULL && call->opcode == IR_OP_CALL);
+  IRFunction *callee = direct_callee(call);
+  if (!can_inline(call, callee))
+    return false;
+
+  IRBasicBlock *bb = call->parent;
+  IRFunction *caller = bb->parent;
+  IRContext *ctx = caller->parent->context;
+
+  /// 后缀用调用者当前的块数: 每次内联至少新增一个块，同一个调用者中不会重复
+  size_t tag = 0;
+  IDList *iter;
+  list_for_each(&caller->basic_blocks, iter)
+  {
+    tag++;
+  }
+
+  Bump scratch;
+  bump_init(&scratch);
+  PtrHashMap *remap = ptr_hashmap_create(&scratch, 64);
+  bool ok = remap != NULL;
+  size_t arg_index = 1;
+  list_for_each(&callee->arguments, iter)
+  {
+    IRArgument *arg = list_entry(iter, IRArgument, list_node);
+    if (ok)
+      ok = ptr_hashmap_put(remap, &arg->value, ir_instruction_get_operand(call, arg_index++));
+  }
+
+  /// 1. 在调用之后分开；复制出的函数体放在两半之间
+  IRInstruction *after_call = list_entry(call->list_node.next, IRInstruction, list_node);
+  IRBasicBlock *tail = NULL;
+  if (ok)
+  {
+    char name[128];
+    snprintf(name, sizeof(name), "%s.exit.i%zu", callee->entry_address.name, tag);
+    tail = ir_basic_block_split(bb, after_call, name);
+  }
+  IRBasicBlock *entry = tail ? ir_function_clone_body_into(callee, caller, tail, remap) : NULL;
+  bump_destroy(&scratch);
+  if (!entry)
+  {
+    /// 块 (和复制到一半的指令) 留在 Arena 中；能走到这里只可能是 OOM
+    if (tail)
+    {
+      while (!list_empty(&tail->instructions))
+      {
+        IDList *node = tail->instructions.next;
+        list_del(node);
+        list_add_tail(&bb->instructions, node);
+        list_entry(node, IRInstruction, list_node)->parent = bb;
+      }
+      IDList *use_iter, *use_next;
+      list_for_each_safe(&tail->label_address.uses, use_iter, use_next)
+      {
+        ir_use_set_value(list_entry(use_iter, IRUse, value_node), &bb->label_address);
+      }
+      while (tail->list_node.prev != &bb->list_node)
+      {
+        IRBasicBlock *partial = list_entry(tail->list_node.prev, IRBasicBlock, list_node);
+        ir_basic_block_erase_from_parent(partial);
+      }
+      list_del(&tail->list_node);
+    }
+    return false;
+  }
+
+  /// 2. 改名，并数一数 ret (它总是所在块的终结指令)
+  IRBasicBlock *caller_entry = list_entry(caller->basic_blocks.next, IRBasicBlock, list_node);
+  size_t num_rets = 0;
+  for (iter = &entry->list_node; iter != &tail->list_node; iter = iter->next)
+  {
+    IRBasicBlock *cloned = list_entry(iter, IRBasicBlock, list_node);
+    add_name_suffix(&cloned->label_address, tag);
+    IDList *inst_iter;
+    list_for_each(&cloned->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      add_name_suffix(&inst->result, tag);
+      if (inst->opcode == IR_OP_RET)
+        num_rets++;
+    }
+  }
+
+  /// 3. ret 换成跳到后半块的 br；多个 ret 的返回值在后半块开头用 phi 合并
+  IRBuilder *builder = ir_builder_create(ctx);
+  bool returns_value = call->result.type->kind != IR_TYPE_VOID;
+  IRValueNode *result = NULL;
+  if (returns_value && num_rets > 1)
+  {
+    ir_builder_set_insertion_point(builder, tail);
+    result = ir_builder_create_phi(builder, call->result.type, call->result.name);
+    IRInstruction *phi = container_of(result, IRInstruction, result);
+    list_del(&phi->list_node);
+    list_add(&tail->instructions, &phi->list_node);
+    tail->order_valid = false;
+  }
+  for (iter = &entry->list_node; iter != &tail->list_node; iter = iter->next)
+  {
+    IRBasicBlock *cloned = list_entry(iter, IRBasicBlock, list_node);
+    IRInstruction *ret = list_entry(cloned->instructions.prev, IRInstruction, list_node);
+    if (list_empty(&cloned->instructions) || ret->opcode != IR_OP_RET)
+      continue;
+    if (returns_value && num_rets == 1)
+      result = ir_instruction_get_operand(ret, 0);
+    else if (returns_value)
+      ir_phi_add_incoming(result, ir_instruction_get_operand(ret, 0), cloned);
+    ir_instruction_erase_from_parent(ret);
+    ir_builder_set_insertion_point(builder, cloned);
+    ir_builder_create_br(builder, &tail->label_address);
+  }
+
+  /// 没有 ret (被调者不返回) 时后半块不可达，调用的结果换成 undef
+  if (returns_value)
+    ir_value_replace_all_uses_with(&call->result, result ? result : ir_constant_get_undef(ctx, call->result.type));
+  ir_instruction_erase_from_parent(call);
+  ir_builder_set_insertion_point(builder, bb);
+  ir_builder_create_br(builder, &entry->label_address);
+  ir_builder_destroy(builder);
+
+  /// 4. 被调者入口块的 alloca 移到调用者的入口块开头
+  if (entry != caller_entry)
+  {
+    IDList *inst_iter, *inst_next;
+    list_for_each_safe(&entry->instructions, inst_iter, inst_next)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode != IR_OP_ALLOCA)
+        continue;
+      list_del(&inst->list_node);
+      list_add(&caller_entry->instructions, &inst->list_node);
+      inst->parent = caller_entry;
+      caller_entry->order_valid = false;
+    }
+  }
+  return true;
+}
+
+/*
+ * =================================================================
+ * --- 模块 pass ---
+ * =================================================================
+ */
+
+/**
+ * @brief 调用图中的一个函数
+ */
+typedef struct
+{
+  IRFunction *func;
+  /** 直接调用的有函数体的函数 (在 nodes 中的下标，可能重复) */
+  size_t *callees;
+  size_t num_callees;
+  /** 当前的指令数 */
+  size_t size;
+  /** 深度优先搜索: 0 未访问，1 在栈上，2 已完成 */
+  int state;
+} CallGraphNode;
+
+/**
+ * @brief 内联一个函数中 (运行前已有的) 所有合适的调用点
+ */
+static bool
+inline_calls_in(CallGraphNode *node, CallGraphNode *nodes, PtrHashMap *index, const IRInlineParams *params,
+                Bump *arena)
+{
+  /// 先收集调用点: 内联会改动块链表
+  size_t num_calls = 0;
+  IDList *bb_iter;
+  list_for_each(&node->func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      if (list_entry(inst_iter, IRInstruction, list_node)->opcode == IR_OP_CALL)
+        num_calls++;
+    }
+  }
+  if (num_calls == 0)
+    return false;
+  IRInstruction **calls = BUMP_ALLOC_SLICE(arena, IRInstruction *, num_calls);
+  if (!calls)
+    return false;
+  num_calls = 0;
+  list_for_each(&node->func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_CALL)
+        calls[num_calls++] = inst;
+    }
+  }
+
+  bool changed = false;
+  for (size_t i = 0; i < num_calls; i++)
+  {
+    IRFunction *callee = direct_callee(calls[i]);
+    uintptr_t slot = callee ? (uintptr_t)ptr_hashmap_get(index, callee) : 0;
+    if (slot == 0)
+      continue;
+    CallGraphNode *target = &nodes[slot - 1];
+
+    size_t limit = params->max_callee_insts;
+    if (params->profile && interpreter_profile_get_calls(params->profile, callee) >= params->hot_call_threshold)
+      limit = params->hot_max_callee_insts;
+    if (target->size > limit || node->size + target->size > params->max_caller_insts)
+      continue;
+
+    if (ir_transform_inline_call(calls[i]))
+    {
+      /// 去掉了 call，多了一个 br 和每个 ret 换成的 br (数量不变)
+      node->size += target->size;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+ * @brief 建立调用图 (只包括有函数体的函数)
+ */
+static CallGraphNode *
+build_call_graph(IRModule *mod, Bump *arena, PtrHashMap **out_index, size_t *out_num_nodes)
+{
+  size_t num_nodes = 0;
+  IDList *iter;
+  list_for_each(&mod->functions, iter)
+  {
+    if (!list_entry(iter, IRFunction, list_node)->is_declaration)
+      num_nodes++;
+  }
+  CallGraphNode *nodes = BUMP_ALLOC_SLICE_ZEROED(arena, CallGraphNode, num_nodes + 1);
+  PtrHashMap *index = ptr_hashmap_create(arena, num_nodes + 1);
+  if (!nodes || !index)
+    return NULL;
+
+  size_t n = 0;
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (func->is_declaration)
+      continue;
+    nodes[n].func = func;
+    if (!ptr_hashmap_put(index, func, (void *)(uintptr_t)(n + 1)))
+      return NULL;
+    n++;
+  }
+
+  for (size_t i = 0; i < num_nodes; i++)
+  {
+    IRFunction *func = nodes[i].func;
+    size_t num_calls = 0;
+    nodes[i].size = count_instructions(func);
+    IDList *bb_iter;
+    list_for_each(&func->basic_blocks, bb_iter)
+    {
+      IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+      IDList *inst_iter;
+      list_for_each(&bb->instructions, inst_iter)
+      {
+        if (list_entry(inst_iter, IRInstruction, list_node)->opcode == IR_OP_CALL)
+          num_calls++;
+      }
+    }
+    nodes[i].callees = BUMP_ALLOC_SLICE(arena, size_t, num_calls + 1);
+    if (!nodes[i].callees)
+      return NULL;
+    list_for_each(&func->basic_blocks, bb_iter)
+    {
+      IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+      IDList *inst_iter;
+      list_for_each(&bb->instructions, inst_iter)
+      {
+        IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+        IRFunction *callee = inst->opcode == IR_OP_CALL ? direct_callee(inst) : NULL;
+        uintptr_t slot = callee ? (uintptr_t)ptr_hashmap_get(index, callee) : 0;
+        if (slot != 0)
+          nodes[i].callees[nodes[i].num_callees++] = slot - 1;
+      }
+    }
+  }
+
+  *out_index = index;
+  *out_num_nodes = num_nodes;
+  return nodes;
+}
+
+bool
+ir_transform_inline_run(IRModule *mod, const IRInlineParams *params)
+{
+  IRInlineParams defaults;
+  if (!params)
+  {
+    ir_inline_params_init(&defaults);
+    params = &defaults;
+  }
+  if (!ir_module_materialize_all(mod))
+    return false;
+
+  Bump arena;
+  bump_init(&arena);
+  PtrHashMap *index = NULL;
+  size_t num_nodes = 0;
+  CallGraphNode *nodes = build_call_graph(mod, &arena, &index, &num_nodes);
+  /// 显式栈上的深度优先搜索: 一个函数的所有被调者完成之后 (后序) 才处理它；
+  /// 回边 (递归) 指向栈上的函数，直接跳过
+  size_t *stack = nodes ? BUMP_ALLOC_SLICE(&arena, size_t, num_nodes + 1) : NULL;
+  size_t *next_callee = nodes ? BUMP_ALLOC_SLICE_ZEROED(&arena, size_t, num_nodes + 1) : NULL;
+  if (!stack || !next_callee)
+  {
+    bump_destroy(&arena);
+    return false;
+  }
+
+  bool changed = false;
+  for (size_t root = 0; root < num_nodes; root++)
+  {
+    if (nodes[root].state != 0)
+      continue;
+    size_t top = 0;
+    stack[top++] = root;
+    nodes[root].state = 1;
+    while (top > 0)
+    {
+      CallGraphNode *node = &nodes[stack[top - 1]];
+      size_t *next = &next_callee[stack[top - 1]];
+      if (*next < node->num_callees)
+      {
+        size_t callee = node->callees[(*next)++];
+        if (nodes[callee].state == 0)
+        {
+          nodes[callee].state = 1;
+          stack[top++] = callee;
+        }
+        continue;
+      }
+      top--;
+      node->state = 2;
+      if (inline_calls_in(node, nodes, index, params, &arena))
+        changed = true;
+    }
+  }
+
+  bump_destroy(&arena);
+  return changed;
+}
+
+bool
+ir_transform_inline_run_with_analyses(IRModule *mod, IRAnalysisManager *am)
+{
+  if (!ir_transform_inline_run(mod, NULL))
+    return false;
+  ir_analysis_invalidate_module(am, mod, IR_PRESERVE_NONE);
+  return true;
+}
@@ -0,0 +1,774 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/instcombine.h"
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/type.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+#include "utils/small_vec.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// 工作表: 小函数完全放在内联存储里，大函数溢出到 scratch
+SMALL_VEC_DEFINE(InstVec, inst_vec, IRInstruction *, 64)
+
+typedef struct
+{
+  IRContext *ctx;
+  DataLayout *dl;
+  IRBuilder *builder;
+  /** 正在改写的指令 (新建的指令插在它前面) */
+  IRInstruction *inst;
+  InstVec worklist;
+  /** 已经删除的指令 (工作表中可能还有它们) */
+  PtrHashMap *erased;
+} Combiner;
+
+/**
+ * @brief 一条改写规则
+ * @return NULL 表示不适用；&inst->result 表示原地修改了 inst；其他值替换 inst 的所有使用
+ */
+typedef IRValueNode *(*CombineRule)(Combiner *c, IRInstruction *inst);
+
+/*
+ * =================================================================
+ * --- 辅助函数 ---
+ * =================================================================
+ */
+
+static unsigned
+int_bits(const IRType *type)
+{
+  switch (type->kind)
+  {
+  case IR_TYPE_I1:
+    return 1;
+  case IR_TYPE_I8:
+    return 8;
+  case IR_TYPE_I16:
+    return 16;
+  case IR_TYPE_I32:
+    return 32;
+  case IR_TYPE_I64:
+    return 64;
+  default:
+    return 0;
+  }
+}
+
+static uint64_t
+low_mask(unsigned bits)
+{
+  return bits >= 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1;
+}
+
+static bool
+is_int_constant(IRValueNode *value, int64_t *out)
+{
+  if (value->kind != IR_KIND_CONSTANT || ((IRConstant *)value)->const_kind != CONST_KIND_INT)
+    return false;
+  *out = ((IRConstant *)value)->data.int_val;
+  return true;
+}
+
+/** @brief value 是整数常量，并且在它的位宽内等于 expected */
+static bool
+is_int_value(IRValueNode *value, int64_t expected)
+{
+  int64_t v;
+  uint64_t mask = low_mask(int_bits(value->type));
+  return is_int_constant(value, &v) && ((uint64_t)v & mask) == ((uint64_t)expected & mask);
+}
+
+/** @brief value 是 2^k 的整数常量 (按无符号数看) 时写入 k */
+static bool
+is_power_of_two(IRValueNode *value, unsigned *out_k)
+{
+  int64_t v;
+  if (!is_int_constant(value, &v))
+    return false;
+  uint64_t u = (uint64_t)v & low_mask(int_bits(value->type));
+  if (u == 0 || (u & (u - 1)) != 0)
+    return false;
+  unsigned k = 0;
+  while ((u >> k) != 1)
+    k++;
+  *out_k = k;
+  return true;
+}
+
+static bool
+is_float_value(IRValueNode *value, double expected)
+{
+  if (value->kind != IR_KIND_CONSTANT || ((IRConstant *)value)->const_kind != CONST_KIND_FLOAT)
+    return false;
+  double v = ((IRConstant *)value)->data.float_val;
+  return v == expected && signbit(v) == signbit(expected);
+}
+
+static IRValueNode *
+int_constant(Combiner *c, IRType *type, int64_t value)
+{
+  switch (type->kind)
+  {
+  case IR_TYPE_I1:
+    return ir_constant_get_i1(c->ctx, (value & 1) != 0);
+  case IR_TYPE_I8:
+    return ir_constant_get_i8(c->ctx, (int8_t)value);
+  case IR_TYPE_I16:
+    return ir_constant_get_i16(c->ctx, (int16_t)value);
+  case IR_TYPE_I32:
+    return ir_constant_get_i32(c->ctx, (int32_t)value);
+  default:
+    return ir_constant_get_i64(c->ctx, value);
+  }
+}
+
+static IRInstruction *
+as_instruction(IRValueNode *value, IROpcode opcode)
+{
+  if (value->kind != IR_KIND_INSTRUCTION)
+    return NULL;
+  IRInstruction *inst = container_of(value, IRInstruction, result);
+  return inst->opcode == opcode ? inst : NULL;
+}
+
+/**
+ * @brief 把构建器刚追加到块尾的指令移到 c->inst 之前，并放进工作表
+ */
+static IRValueNode *
+place(Combiner *c, IRValueNode *created)
+{
+  IRInstruction *inst = container_of(created, IRInstruction, result);
+  list_del(&inst->list_node);
+  list_add_tail(&c->inst->list_node, &inst->list_node);
+  inst->parent->order_valid = false;
+  inst_vec_push(&c->worklist, inst);
+  return created;
+}
+
+/** @brief 新建的指令用被改写的指令的名字 (suffix 非 NULL 时加上后缀) */
+static const char *
+new_name(Combiner *c, const char *suffix, char *buf, size_t size)
+{
+  if (!suffix)
+    return c->inst->result.name;
+  snprintf(buf, size, "%s.%s", c->inst->result.name, suffix);
+  return buf;
+}
+
+static IRValueNode *
+emit_binary(Combiner *c, IROpcode opcode, IRValueNode *lhs, IRValueNode *rhs, const char *suffix)
+{
+  char buf[128];
+  const char *name = new_name(c, suffix, buf, sizeof(buf));
+  IRValueNode *result;
+  switch (opcode)
+  {
+  case IR_OP_ADD:
+    result = ir_builder_create_add(c->builder, lhs, rhs, name);
+    break;
+  case IR_OP_SUB:
+    result = ir_builder_create_sub(c->builder, lhs, rhs, name);
+    break;
+  case IR_OP_SHL:
+    result = ir_builder_create_shl(c->builder, lhs, rhs, name);
+    break;
+  case IR_OP_LSHR:
+    result = ir_builder_create_lshr(c->builder, lhs, rhs, name);
+    break;
+  case IR_OP_ASHR:
+    result = ir_builder_create_ashr(c->builder, lhs, rhs, name);
+    break;
+  case IR_OP_AND:
+    result = ir_builder_create_and(c->builder, lhs, rhs, name);
+    break;
+  default:
+    return NULL;
+  }
+  return result ? place(c, result) : NULL;
+}
+
+static IRValueNode *
+emit_cast(Combiner *c, IROpcode opcode, IRValueNode *value, IRType *dest)
+{
+  const char *name = c->inst->result.name;
+  IRValueNode *result;
+  switch (opcode)
+  {
+  case IR_OP_TRUNC:
+    result = ir_builder_create_trunc(c->builder, value, dest, name);
+    break;
+  case IR_OP_ZEXT:
+    result = ir_builder_create_zext(c->builder, value, dest, name);
+    break;
+  case IR_OP_SEXT:
+    result = ir_builder_create_sext(c->builder, value, dest, name);
+    break;
+  case IR_OP_BITCAST:
+    result = ir_builder_create_bitcast(c->builder, value, dest, name);
+    break;
+  default:
+    return NULL;
+  }
+  return result ? place(c, result) : NULL;
+}
+
+/** @brief 原地交换 inst 的两个操作数 */
+static void
+swap_operands(IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  ir_use_set_value(&inst->operands[0], rhs);
+  ir_use_set_value(&inst->operands[1], lhs);
+}
+
+/*
+ * =================================================================
+ * --- 规则 ---
+ * =================================================================
+ */
+
+/** @brief 操作数都是常量时求值 */
+static IRValueNode *
+rule_fold_constants(Combiner *c, IRInstruction *inst)
+{
+  IRConstant *operands[2];
+  if (inst->num_operands > 2)
+    return NULL;
+  for (size_t i = 0; i < inst->num_operands; i++)
+  {
+    IRValueNode *operand = ir_instruction_get_operand(inst, i);
+    if (operand->kind != IR_KIND_CONSTANT)
+      return NULL;
+    operands[i] = (IRConstant *)operand;
+  }
+  return interpreter_fold_instruction(c->ctx, c->dl, inst, operands);
+}
+
+/** @brief 可交换运算: 常量放到右边 */
+static IRValueNode *
+rule_commute_constant(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  if (ir_instruction_get_operand(inst, 0)->kind != IR_KIND_CONSTANT ||
+      ir_instruction_get_operand(inst, 1)->kind == IR_KIND_CONSTANT)
+    return NULL;
+  swap_operands(inst);
+  return &inst->result;
+}
+
+/** @brief x + 0 */
+static IRValueNode *
+rule_add(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  return is_int_value(ir_instruction_get_operand(inst, 1), 0) ? lhs : NULL;
+}
+
+/** @brief x - 0、x - x、x - C => x + (-C) */
+static IRValueNode *
+rule_sub(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  int64_t value;
+  if (lhs == rhs)
+    return int_constant(c, inst->result.type, 0);
+  if (!is_int_constant(rhs, &value))
+    return NULL;
+  if (is_int_value(rhs, 0))
+    return lhs;
+  return emit_binary(c, IR_OP_ADD, lhs, int_constant(c, inst->result.type, (int64_t)(0 - (uint64_t)value)), NULL);
+}
+
+/** @brief x * 0、x * 1、x * -1 => 0 - x、x * 2^k => x << k */
+static IRValueNode *
+rule_mul(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  IRType *type = inst->result.type;
+  unsigned k;
+  if (is_int_value(rhs, 0))
+    return rhs;
+  if (is_int_value(rhs, 1))
+    return lhs;
+  if (is_int_value(rhs, -1))
+    return emit_binary(c, IR_OP_SUB, int_constant(c, type, 0), lhs, NULL);
+  if (is_power_of_two(rhs, &k))
+    return emit_binary(c, IR_OP_SHL, lhs, int_constant(c, type, k), NULL);
+  return NULL;
+}
+
+/** @brief x /u 1、x /u 2^k => x >>u k */
+static IRValueNode *
+rule_udiv(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  unsigned k;
+  if (is_int_value(rhs, 1))
+    return lhs;
+  if (is_power_of_two(rhs, &k))
+    return emit_binary(c, IR_OP_LSHR, lhs, int_constant(c, inst->result.type, k), NULL);
+  return NULL;
+}
+
+/** @brief x %u 1 => 0、x %u 2^k => x & (2^k - 1) */
+static IRValueNode *
+rule_urem(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  IRType *type = inst->result.type;
+  unsigned k;
+  if (is_int_value(rhs, 1))
+    return int_constant(c, type, 0);
+  if (is_power_of_two(rhs, &k))
+    return emit_binary(c, IR_OP_AND, lhs, int_constant(c, type, (int64_t)low_mask(k)), NULL);
+  return NULL;
+}
+
+/**
+ * @brief 有符号除以 2^k (0 < k < 位宽 - 1) 的向零取整: 负数先加上 2^k - 1
+ *
+ * bias = (x >>s (n-1)) >>u (n-k) 在 x 为负时是 2^k - 1，否则是 0。
+ * @return x + bias
+ */
+static IRValueNode *
+emit_signed_bias(Combiner *c, IRValueNode *x, unsigned k)
+{
+  IRType *type = x->type;
+  unsigned bits = int_bits(type);
+  IRValueNode *sign = emit_binary(c, IR_OP_ASHR, x, int_constant(c, type, bits - 1), "sign");
+  IRValueNode *bias = sign ? emit_binary(c, IR_OP_LSHR, sign, int_constant(c, type, bits - k), "bias") : NULL;
+  return bias ? emit_binary(c, IR_OP_ADD, x, bias, "adj") : NULL;
+}
+
+/** @brief 除数是 2^k 并且作为有符号数是正数 */
+static bool
+is_signed_power_of_two(IRValueNode *rhs, unsigned *out_k)
+{
+  unsigned k;
+  if (!is_power_of_two(rhs, &k) || k == 0 || k + 1 >= int_bits(rhs->type))
+    return false;
+  *out_k = k;
+  return true;
+}
+
+/** @brief x /s 1、x /s 2^k => (x + bias) >>s k */
+static IRValueNode *
+rule_sdiv(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  unsigned k;
+  if (is_int_value(rhs, 1))
+    return lhs;
+  if (!is_signed_power_of_two(rhs, &k))
+    return NULL;
+  IRValueNode *adjusted = emit_signed_bias(c, lhs, k);
+  return adjusted ? emit_binary(c, IR_OP_ASHR, adjusted, int_constant(c, inst->result.type, k), NULL) : NULL;
+}
+
+/** @brief x %s 1 => 0、x %s 2^k => x - ((x + bias) & -2^k) */
+static IRValueNode *
+rule_srem(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  IRType *type = inst->result.type;
+  unsigned k;
+  if (is_int_value(rhs, 1))
+    return int_constant(c, type, 0);
+  if (!is_signed_power_of_two(rhs, &k))
+    return NULL;
+  IRValueNode *adjusted = emit_signed_bias(c, lhs, k);
+  IRValueNode *rounded =
+      adjusted ? emit_binary(c, IR_OP_AND, adjusted, int_constant(c, type, -((int64_t)1 << k)), "round") : NULL;
+  return rounded ? emit_binary(c, IR_OP_SUB, lhs, rounded, NULL) : NULL;
+}
+
+/** @brief x << 0、x >> 0 */
+static IRValueNode *
+rule_shift(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  return is_int_value(ir_instruction_get_operand(inst, 1), 0) ? ir_instruction_get_operand(inst, 0) : NULL;
+}
+
+/** @brief x & 0、x & -1、x & x */
+static IRValueNode *
+rule_and(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  if (is_int_value(rhs, 0))
+    return rhs;
+  if (is_int_value(rhs, -1) || lhs == rhs)
+    return lhs;
+  return NULL;
+}
+
+/** @brief x | 0、x | -1、x | x */
+static IRValueNode *
+rule_or(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  if (is_int_value(rhs, 0) || lhs == rhs)
+    return lhs;
+  if (is_int_value(rhs, -1))
+    return rhs;
+  return NULL;
+}
+
+/** @brief x ^ 0、x ^ x */
+static IRValueNode *
+rule_xor(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  if (is_int_value(rhs, 0))
+    return lhs;
+  if (lhs == rhs)
+    return int_constant(c, inst->result.type, 0);
+  return NULL;
+}
+
+/** @brief fadd x, -0.0、fsub x, 0.0、fmul x, 1.0、fdiv x, 1.0 (对所有 x 都精确成立) */
+static IRValueNode *
+rule_float_identity(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  bool identity = false;
+  switch (inst->opcode)
+  {
+  case IR_OP_FADD:
+    identity = is_float_value(rhs, -0.0);
+    break;
+  case IR_OP_FSUB:
+    identity = is_float_value(rhs, 0.0);
+    break;
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+    identity = is_float_value(rhs, 1.0);
+    break;
+  default:
+    break;
+  }
+  return identity ? ir_instruction_get_operand(inst, 0) : NULL;
+}
+
+static IRICmpPredicate
+swapped_predicate(IRICmpPredicate pred)
+{
+  switch (pred)
+  {
+  case IR_ICMP_UGT:
+    return IR_ICMP_ULT;
+  case IR_ICMP_UGE:
+    return IR_ICMP_ULE;
+  case IR_ICMP_ULT:
+    return IR_ICMP_UGT;
+  case IR_ICMP_ULE:
+    return IR_ICMP_UGE;
+  case IR_ICMP_SGT:
+    return IR_ICMP_SLT;
+  case IR_ICMP_SGE:
+    return IR_ICMP_SLE;
+  case IR_ICMP_SLT:
+    return IR_ICMP_SGT;
+  case IR_ICMP_SLE:
+    return IR_ICMP_SGE;
+  default:
+    return pred;
+  }
+}
+
+/** @brief icmp C, x => icmp swapped x, C；icmp x, x 是常量 */
+static IRValueNode *
+rule_icmp(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *lhs = ir_instruction_get_operand(inst, 0);
+  IRValueNode *rhs = ir_instruction_get_operand(inst, 1);
+  IRICmpPredicate pred = inst->as.icmp.predicate;
+  if (lhs == rhs)
+  {
+    bool reflexive = pred == IR_ICMP_EQ || pred == IR_ICMP_UGE || pred == IR_ICMP_ULE || pred == IR_ICMP_SGE ||
+                     pred == IR_ICMP_SLE;
+    return ir_constant_get_i1(c->ctx, reflexive);
+  }
+  if (lhs->kind == IR_KIND_CONSTANT && rhs->kind != IR_KIND_CONSTANT)
+  {
+    swap_operands(inst);
+    inst->as.icmp.predicate = swapped_predicate(pred);
+    return &inst->result;
+  }
+  return NULL;
+}
+
+/** @brief trunc(trunc x)、trunc(zext/sext x) */
+static IRValueNode *
+rule_trunc(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *operand = ir_instruction_get_operand(inst, 0);
+  IRType *dest = inst->result.type;
+  IRInstruction *inner = as_instruction(operand, IR_OP_TRUNC);
+  if (inner)
+    return emit_cast(c, IR_OP_TRUNC, ir_instruction_get_operand(inner, 0), dest);
+
+  inner = as_instruction(operand, IR_OP_ZEXT);
+  if (!inner)
+    inner = as_instruction(operand, IR_OP_SEXT);
+  if (!inner)
+    return NULL;
+  IRValueNode *source = ir_instruction_get_operand(inner, 0);
+  unsigned source_bits = int_bits(source->type);
+  unsigned dest_bits = int_bits(dest);
+  if (source_bits == dest_bits)
+    return source;
+  if (source_bits < dest_bits)
+    return emit_cast(c, inner->opcode, source, dest);
+  return emit_cast(c, IR_OP_TRUNC, source, dest);
+}
+
+/** @brief zext(zext x) */
+static IRValueNode *
+rule_zext(Combiner *c, IRInstruction *inst)
+{
+  IRInstruction *inner = as_instruction(ir_instruction_get_operand(inst, 0), IR_OP_ZEXT);
+  return inner ? emit_cast(c, IR_OP_ZEXT, ir_instruction_get_operand(inner, 0), inst->result.type) : NULL;
+}
+
+/** @brief sext(sext x)、sext(zext x) => zext x (zext 的结果最高位是 0) */
+static IRValueNode *
+rule_sext(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *operand = ir_instruction_get_operand(inst, 0);
+  IRInstruction *inner = as_instruction(operand, IR_OP_SEXT);
+  if (!inner)
+    inner = as_instruction(operand, IR_OP_ZEXT);
+  return inner ? emit_cast(c, inner->opcode, ir_instruction_get_operand(inner, 0), inst->result.type) : NULL;
+}
+
+/** @brief bitcast 到同一类型、bitcast(bitcast x) */
+static IRValueNode *
+rule_bitcast(Combiner *c, IRInstruction *inst)
+{
+  IRValueNode *operand = ir_instruction_get_operand(inst, 0);
+  IRType *dest = inst->result.type;
+  if (operand->type == dest)
+    return operand;
+  IRInstruction *inner = as_instruction(operand, IR_OP_BITCAST);
+  if (!inner)
+    return NULL;
+  IRValueNode *source = ir_instruction_get_operand(inner, 0);
+  return source->type == dest ? source : emit_cast(c, IR_OP_BITCAST, source, dest);
+}
+
+/** @brief select 的条件是常量或两个值相同 */
+static IRValueNode *
+rule_select(Combiner *c, IRInstruction *inst)
+{
+  (void)c;
+  IRValueNode *cond = ir_instruction_get_operand(inst, 0);
+  IRValueNode *true_value = ir_instruction_get_operand(inst, 1);
+  IRValueNode *false_value = ir_instruction_get_operand(inst, 2);
+  int64_t value;
+  if (true_value == false_value)
+    return true_value;
+  if (is_int_constant(cond, &value))
+    return value != 0 ? true_value : false_value;
+  return NULL;
+}
+
+/*
+ * =================================================================
+ * --- 规则表 ---
+ * =================================================================
+ */
+
+/// 每个操作码的规则按顺序尝试 (以 NULL 结尾)；常量折叠总在最前面
+static const CombineRule ADD_RULES[] = {rule_fold_constants, rule_commute_constant, rule_add, NULL};
+static const CombineRule SUB_RULES[] = {rule_fold_constants, rule_sub, NULL};
+static const CombineRule MUL_RULES[] = {rule_fold_constants, rule_commute_constant, rule_mul, NULL};
+static const CombineRule UDIV_RULES[] = {rule_fold_constants, rule_udiv, NULL};
+static const CombineRule SDIV_RULES[] = {rule_fold_constants, rule_sdiv, NULL};
+static const CombineRule UREM_RULES[] = {rule_fold_constants, rule_urem, NULL};
+static const CombineRule SREM_RULES[] = {rule_fold_constants, rule_srem, NULL};
+static const CombineRule FLOAT_RULES[] = {rule_fold_constants, rule_float_identity, NULL};
+static const CombineRule SHIFT_RULES[] = {rule_fold_constants, rule_shift, NULL};
+static const CombineRule AND_RULES[] = {rule_fold_constants, rule_commute_constant, rule_and, NULL};
+static const CombineRule OR_RULES[] = {rule_fold_constants, rule_commute_constant, rule_or, NULL};
+static const CombineRule XOR_RULES[] = {rule_fold_constants, rule_commute_constant, rule_xor, NULL};
+static const CombineRule ICMP_RULES[] = {rule_fold_constants, rule_icmp, NULL};
+static const CombineRule FOLD_RULES[] = {rule_fold_constants, NULL};
+static const CombineRule TRUNC_RULES[] = {rule_fold_constants, rule_trunc, NULL};
+static const CombineRule ZEXT_RULES[] = {rule_fold_constants, rule_zext, NULL};
+static const CombineRule SEXT_RULES[] = {rule_fold_constants, rule_sext, NULL};
+static const CombineRule BITCAST_RULES[] = {rule_fold_constants, rule_bitcast, NULL};
+static const CombineRule SELECT_RULES[] = {rule_select, NULL};
+
+/// 终结指令、内存操作、phi 和 call 没有规则
+static const CombineRule *const RULES[IR_OP_CALL + 1] = {
+    [IR_OP_ADD] = ADD_RULES,         [IR_OP_SUB] = SUB_RULES,         [IR_OP_MUL] = MUL_RULES,
+    [IR_OP_UDIV] = UDIV_RULES,       [IR_OP_SDIV] = SDIV_RULES,       [IR_OP_UREM] = UREM_RULES,
+    [IR_OP_SREM] = SREM_RULES,       [IR_OP_FADD] = FLOAT_RULES,      [IR_OP_FSUB] = FLOAT_RULES,
+    [IR_OP_FMUL] = FLOAT_RULES,      [IR_OP_FDIV] = FLOAT_RULES,      [IR_OP_SHL] = SHIFT_RULES,
+    [IR_OP_LSHR] = SHIFT_RULES,      [IR_OP_ASHR] = SHIFT_RULES,      [IR_OP_AND] = AND_RULES,
+    [IR_OP_OR] = OR_RULES,           [IR_OP_XOR] = XOR_RULES,         [IR_OP_ICMP] = ICMP_RULES,
+    [IR_OP_FCMP] = FOLD_RULES,       [IR_OP_TRUNC] = TRUNC_RULES,     [IR_OP_ZEXT] = ZEXT_RULES,
+    [IR_OP_SEXT] = SEXT_RULES,       [IR_OP_FPTRUNC] = FOLD_RULES,    [IR_OP_FPEXT] = FOLD_RULES,
+    [IR_OP_FPTOUI] = FOLD_RULES,     [IR_OP_FPTOSI] = FOLD_RULES,     [IR_OP_UITOFP] = FOLD_RULES,
+    [IR_OP_SITOFP] = FOLD_RULES,     [IR_OP_BITCAST] = BITCAST_RULES, [IR_OP_SELECT] = SELECT_RULES,
+};
+
+/*
+ * =================================================================
+ * --- 驱动 ---
+ * =================================================================
+ */
+
+/** @brief 删除一条指令；它的操作数可能随之没有使用者，放回工作表 */
+static void
+erase(Combiner *c, IRInstruction *inst)
+{
+  for (size_t i = 0; i < inst->num_operands; i++)
+  {
+    IRValueNode *operand = ir_instruction_get_operand(inst, i);
+    if (operand->kind == IR_KIND_INSTRUCTION)
+      inst_vec_push(&c->worklist, container_of(operand, IRInstruction, result));
+  }
+  ir_instruction_erase_from_parent(inst);
+  ptr_hashmap_put(c->erased, inst, inst);
+}
+
+/**
+ * @brief 对一条指令按顺序尝试它的规则
+ * @return 是否修改了 IR
+ */
+static bool
+combine_instruction(Combiner *c, IRInstruction *inst)
+{
+  const CombineRule *rules = RULES[inst->opcode];
+  if (!rules)
+    return false;
+
+  /// 没有使用者的指令直接删除 (有规则的操作码都没有副作用)
+  if (list_empty(&inst->result.uses))
+  {
+    erase(c, inst);
+    return true;
+  }
+
+  c->inst = inst;
+  ir_builder_set_insertion_point(c->builder, inst->parent);
+  for (; *rules; rules++)
+  {
+    IRValueNode *replacement = (*rules)(c, inst);
+    if (!replacement)
+      continue;
+    if (replacement == &inst->result)
+    {
+      /// 原地修改之后再试一遍其余的规则
+      inst_vec_push(&c->worklist, inst);
+      return true;
+    }
+
+    /// 使用者可能因此可以继续化简
+    IDList *iter;
+    list_for_each(&inst->result.uses, iter)
+    {
+      inst_vec_push(&c->worklist, list_entry(iter, IRUse, value_node)->user);
+    }
+    ir_value_replace_all_uses_with(&inst->result, replacement);
+    erase(c, inst);
+    return true;
+  }
+  return false;
+}
+
+bool
+ir_transform_instcombine_run(IRFunction *func)
+{
+  if (!func || list_empty(&func->basic_blocks))
+    return false;
+
+  Bump scratch;
+  bump_init(&scratch);
+  Combiner c = {
+      .ctx = func->parent->context,
+      .dl = datalayout_create_host(),
+      .builder = ir_builder_create(func->parent->context),
+      .erased = ptr_hashmap_create(&scratch, 64),
+  };
+  inst_vec_init(&c.worklist, &scratch);
+
+  /// 倒序放入，弹出的顺序就是程序顺序
+  for (IDList *bb_iter = func->basic_blocks.prev; bb_iter != &func->basic_blocks; bb_iter = bb_iter->prev)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    for (IDList *inst_iter = bb->instructions.prev; inst_iter != &bb->instructions; inst_iter = inst_iter->prev)
+    {
+      inst_vec_push(&c.worklist, list_entry(inst_iter, IRInstruction, list_node));
+    }
+  }
+
+  bool changed = false;
+  while (inst_vec_len(&c.worklist) > 0)
+  {
+    IRInstruction *inst = inst_vec_pop(&c.worklist);
+    if (!ptr_hashmap_contains(c.erased, inst) && combine_instruction(&c, inst))
+      changed = true;
+  }
+
+  ir_builder_destroy(c.builder);
+  datalayout_destroy(c.dl);
+  bump_destroy(&scratch);
+  return changed;
+}
+
+bool
+ir_transform_instcombine_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  bool changed = ir_transform_instcombine_run(func);
+  if (changed)
+    ir_analysis_invalidate(am, func, IR_TRANSFORM_INSTCOMBINE_PRESERVES);
+  return changed;
+}
@@ -0,0 +1,472 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/licm.h"
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "analysis/dom_tree.h"
+#include "analysis/loop_info.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/id_list.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * =================================================================
+ * --- 前置块 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 给没有前置块的循环创建一个
+ *
+ * 新块插在 header 之前 (header 是入口块时它成为新的入口)。header 在循环外的前驱的终结指令改为跳到新块；
+ * header 的每个 phi 中来自这些前驱的入边: 只有一条时改为来自新块，多条时在新块中用一个新 phi 合并。
+ *
+ * @return 创建了前置块时返回 true (li 以及它的 CFG 和支配树随之失效)
+ */
+static bool
+insert_preheader(LoopInfo *li, IRLoop *loop, IRBuilder *builder)
+{
+  IRBasicBlock *header = loop->header;
+  IRFunction *func = header->parent;
+  char name[128];
+  snprintf(name, sizeof(name), "%s.preheader", header->label_address.name);
+  IRBasicBlock *preheader = ir_basic_block_create(func, name);
+  if (!preheader)
+    return false;
+  list_add_tail(&header->list_node, &preheader->list_node);
+
+  /// 1. 循环外的前驱改为跳到前置块
+  IDList *iter, *next;
+  list_for_each_safe(&header->label_address.uses, iter, next)
+  {
+    IRUse *use = list_entry(iter, IRUse, value_node);
+    IROpcode op = use->user->opcode;
+    bool is_branch = op == IR_OP_BR || op == IR_OP_COND_BR || op == IR_OP_SWITCH;
+    if (is_branch && !loop_info_contains(li, loop, use->user->parent))
+      ir_use_set_value(use, &preheader->label_address);
+  }
+
+  /// 2. phi 中来自循环外的入边移到前置块
+  ir_builder_set_insertion_point(builder, preheader);
+  list_for_each(&header->instructions, iter)
+  {
+    IRInstruction *phi = list_entry(iter, IRInstruction, list_node);
+    if (phi->opcode != IR_OP_PHI)
+      break;
+
+    size_t num_outside = 0;
+    size_t last_outside = 0;
+    for (size_t i = 0; i + 1 < phi->num_operands; i += 2)
+    {
+      IRBasicBlock *pred = container_of(ir_instruction_get_operand(phi, i + 1), IRBasicBlock, label_address);
+      if (!loop_info_contains(li, loop, pred))
+      {
+        num_outside++;
+        last_outside = i;
+      }
+    }
+    if (num_outside == 1)
+    {
+      ir_use_set_value(ir_instruction_get_operand_use(phi, last_outside + 1), &preheader->label_address);
+      continue;
+    }
+    if (num_outside == 0)
+      continue;
+
+    /// 构建器的匿名编号会和函数中已有的名字冲突，新 phi 沿用原来的名字加后缀
+    char phi_name[128];
+    snprintf(phi_name, sizeof(phi_name), "%s.ph", phi->result.name);
+    IRValueNode *merged = ir_builder_create_phi(builder, phi->result.type, phi_name);
+    for (size_t i = phi->num_operands / 2; i-- > 0;)
+    {
+      IRValueNode *block_value = ir_instruction_get_operand(phi, 2 * i + 1);
+      IRBasicBlock *pred = container_of(block_value, IRBasicBlock, label_address);
+      if (loop_info_contains(li, loop, pred))
+        continue;
+      ir_phi_add_incoming(merged, ir_instruction_get_operand(phi, 2 * i), pred);
+      ir_phi_remove_incoming(&phi->result, i);
+    }
+    ir_phi_add_incoming(&phi->result, merged, preheader);
+  }
+  ir_builder_create_br(builder, &header->label_address);
+  return true;
+}
+
+/**
+ * @brief 给所有没有前置块的循环创建前置块
+ * @return 是否创建了前置块 (此时 li 已失效)
+ */
+static bool
+insert_preheaders(LoopInfo *li, IRContext *ctx)
+{
+  IRBuilder *builder = ir_builder_create(ctx);
+  bool changed = false;
+  for (int i = 0; i < li->num_loops; i++)
+  {
+    if (!li->loops[i]->preheader && insert_preheader(li, li->loops[i], builder))
+      changed = true;
+  }
+  ir_builder_destroy(builder);
+  return changed;
+}
+
+/*
+ * =================================================================
+ * --- 外提 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 提前执行也不会出错、没有副作用、也不读内存的指令
+ */
+static bool
+is_speculatable(IRInstruction *inst)
+{
+  switch (inst->opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+  case IR_OP_GEP:
+  case IR_OP_ICMP:
+  case IR_OP_FCMP:
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+  case IR_OP_FPTRUNC:
+  case IR_OP_FPEXT:
+  case IR_OP_FPTOUI:
+  case IR_OP_FPTOSI:
+  case IR_OP_UITOFP:
+  case IR_OP_SITOFP:
+  case IR_OP_PTRTOINT:
+  case IR_OP_INTTOPTR:
+  case IR_OP_BITCAST:
+  case IR_OP_SELECT:
+    return true;
+  case IR_OP_UDIV:
+  case IR_OP_UREM:
+  case IR_OP_SDIV:
+  case IR_OP_SREM: {
+    /// 除数是非零常量时不会出错 (有符号除法还要排除 INT_MIN / -1 溢出)
+    IRValueNode *divisor = ir_instruction_get_operand(inst, 1);
+    if (divisor->kind != IR_KIND_CONSTANT || ((IRConstant *)divisor)->const_kind != CONST_KIND_INT)
+      return false;
+    int64_t value = ((IRConstant *)divisor)->data.int_val;
+    bool is_signed = inst->opcode == IR_OP_SDIV || inst->opcode == IR_OP_SREM;
+    return value != 0 && !(is_signed && value == -1);
+  }
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief 指针指向的对象: 去掉 gep 之后的 alloca 或全局变量；不能确定时返回 NULL
+ */
+static IRValueNode *
+underlying_object(IRValueNode *ptr)
+{
+  while (ptr->kind == IR_KIND_INSTRUCTION)
+  {
+    IRInstruction *inst = container_of(ptr, IRInstruction, result);
+    if (inst->opcode == IR_OP_ALLOCA)
+      return ptr;
+    if (inst->opcode != IR_OP_GEP)
+      return NULL;
+    ptr = ir_instruction_get_operand(inst, 0);
+  }
+  return ptr->kind == IR_KIND_GLOBAL ? ptr : NULL;
+}
+
+/**
+ * @brief 一个循环的内存访问摘要 (判断 load 能否外提)
+ */
+typedef struct
+{
+  bool has_call;
+  /** 循环中 store 写的对象 (有不能确定的对象时 unknown_store 为 true) */
+  IRValueNode **stored_objects;
+  size_t num_stored;
+  bool unknown_store;
+  /** 离开循环的块 (循环中有后继在循环外的块) */
+  IRBasicBlock **exiting;
+  size_t num_exiting;
+} LoopSummary;
+
+static bool
+summarize_loop(LoopInfo *li, IRLoop *loop, Bump *arena, LoopSummary *out)
+{
+  *out = (LoopSummary){0};
+  FunctionCFG *cfg = li->cfg;
+  size_t num_stores = 0;
+  for (int b = 0; b < loop->num_blocks; b++)
+  {
+    IDList *iter;
+    list_for_each(&cfg->nodes[loop->blocks[b]].block->instructions, iter)
+    {
+      IROpcode op = list_entry(iter, IRInstruction, list_node)->opcode;
+      if (op == IR_OP_STORE)
+        num_stores++;
+      else if (op == IR_OP_CALL)
+        out->has_call = true;
+    }
+  }
+
+  out->stored_objects = BUMP_ALLOC_SLICE(arena, IRValueNode *, num_stores + 1);
+  out->exiting = BUMP_ALLOC_SLICE(arena, IRBasicBlock *, (size_t)loop->num_blocks);
+  if (!out->stored_objects || !out->exiting)
+    return false;
+
+  for (int b = 0; b < loop->num_blocks; b++)
+  {
+    CFGNode *node = &cfg->nodes[loop->blocks[b]];
+    IDList *iter;
+    list_for_each(&node->block->instructions, iter)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      if (inst->opcode != IR_OP_STORE)
+        continue;
+      IRValueNode *object = underlying_object(ir_instruction_get_operand(inst, 1));
+      if (object)
+        out->stored_objects[out->num_stored++] = object;
+      else
+        out->unknown_store = true;
+    }
+    for (int s = 0; s < node->num_succs; s++)
+    {
+      if (!loop_info_contains(li, loop, cfg_succ(cfg, node, s)->block))
+      {
+        out->exiting[out->num_exiting++] = node->block;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief load 能否外提 (它的地址已经确认是循环不变量)
+ */
+static bool
+is_invariant_load(LoopInfo *li, const LoopSummary *summary, IRInstruction *load)
+{
+  if (summary->has_call || summary->unknown_store)
+    return false;
+  IRValueNode *object = underlying_object(ir_instruction_get_operand(load, 0));
+  if (!object)
+    return false;
+  for (size_t i = 0; i < summary->num_stored; i++)
+  {
+    if (summary->stored_objects[i] == object)
+      return false;
+  }
+  /// 进入循环就一定会执行: 支配每个离开循环的块
+  for (size_t i = 0; i < summary->num_exiting; i++)
+  {
+    if (!dom_tree_dominates(li->dom_tree, load->parent, summary->exiting[i]))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 所有操作数都在循环外定义 (或是常量、参数、全局符号)
+ */
+static bool
+operands_invariant(LoopInfo *li, IRLoop *loop, IRInstruction *inst)
+{
+  for (size_t i = 0; i < inst->num_operands; i++)
+  {
+    IRValueNode *operand = inst->operands[i].value;
+    if (operand->kind == IR_KIND_INSTRUCTION &&
+        loop_info_contains(li, loop, container_of(operand, IRInstruction, result)->parent))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 外提一个循环中的不变量 (按支配树先序访问块，操作数先于使用者被外提)
+ */
+static bool
+hoist_loop(LoopInfo *li, IRLoop *loop, Bump *arena)
+{
+  IRBasicBlock *preheader = loop->preheader;
+  assert(preheader && "Preheaders must be inserted before hoisting");
+  IRInstruction *term = list_entry(preheader->instructions.prev, IRInstruction, list_node);
+
+  LoopSummary summary;
+  bool summarized = false;
+  bool changed = false;
+  for (int b = 0; b < loop->num_blocks; b++)
+  {
+    IRBasicBlock *bb = li->cfg->nodes[loop->blocks[b]].block;
+    IDList *iter, *next;
+    list_for_each_safe(&bb->instructions, iter, next)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      bool hoistable = false;
+      if (inst->opcode == IR_OP_LOAD)
+      {
+        if (!operands_invariant(li, loop, inst))
+          continue;
+        if (!summarized)
+        {
+          summarized = true;
+          if (!summarize_loop(li, loop, arena, &summary))
+            summary = (LoopSummary){.has_call = true};
+        }
+        hoistable = is_invariant_load(li, &summary, inst);
+      }
+      else
+      {
+        hoistable = is_speculatable(inst) && operands_invariant(li, loop, inst);
+      }
+      if (!hoistable)
+        continue;
+
+      /// 移到前置块的终结指令之前
+      list_del(&inst->list_node);
+      list_add_tail(&term->list_node, &inst->list_node);
+      inst->parent = preheader;
+      ir_basic_block_instruction_inserted(preheader, inst);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+ * @brief 由内向外外提所有循环 (所有循环都已经有前置块)
+ */
+static bool
+hoist_all(LoopInfo *li)
+{
+  Bump scratch;
+  bump_init(&scratch);
+  bool changed = false;
+  /// loops 按先序排列 (外层在前)，倒过来就是内层先于外层
+  for (int i = li->num_loops - 1; i >= 0; i--)
+  {
+    if (hoist_loop(li, li->loops[i], &scratch))
+      changed = true;
+  }
+  bump_destroy(&scratch);
+  return changed;
+}
+
+static bool
+all_have_preheaders(const LoopInfo *li)
+{
+  for (int i = 0; i < li->num_loops; i++)
+  {
+    if (!li->loops[i]->preheader)
+      return false;
+  }
+  return true;
+}
+
+bool
+ir_transform_licm_run(IRFunction *func, bool *out_cfg_changed)
+{
+  if (out_cfg_changed)
+    *out_cfg_changed = false;
+  if (!func || list_empty(&func->basic_blocks))
+    return false;
+
+  IRContext *ctx = func->parent->context;
+  bool cfg_changed = false;
+  bool changed = false;
+  /// 创建前置块之后重新计算一次 (新块要出现在外层循环的块中)
+  for (int round = 0; round < 2; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *dt = cfg ? dom_tree_build(cfg, &arena) : NULL;
+    LoopInfo *li = dt ? loop_info_compute(dt, &arena) : NULL;
+    bool done = true;
+    if (li && !all_have_preheaders(li))
+    {
+      cfg_changed = insert_preheaders(li, ctx);
+      done = false;
+    }
+    else if (li)
+    {
+      changed = hoist_all(li);
+    }
+    if (dt)
+      dom_tree_destroy(dt);
+    if (cfg)
+      cfg_destroy(cfg);
+    bump_destroy(&arena);
+    if (done)
+      break;
+  }
+
+  if (out_cfg_changed)
+    *out_cfg_changed = cfg_changed;
+  return changed || cfg_changed;
+}
+
+bool
+ir_transform_licm_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  LoopInfo *li = ir_analysis_get_loops(am, func);
+  if (!li)
+    return false;
+
+  bool cfg_changed = false;
+  if (!all_have_preheaders(li))
+  {
+    cfg_changed = insert_preheaders(li, func->parent->context);
+    ir_analysis_invalidate(am, func, IR_PRESERVE_NONE);
+    li = ir_analysis_get_loops(am, func);
+    if (!li)
+      return cfg_changed;
+  }
+
+  bool changed = hoist_all(li);
+  if (changed && !cfg_changed)
+    ir_analysis_invalidate(am, func, IR_PRESERVE_CFG_ANALYSES);
+  else if (changed)
+    ir_analysis_invalidate(am, func, IR_PRESERVE_NONE);
+  return changed || cfg_changed;
+}
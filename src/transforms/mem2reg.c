@@ -16,6 +16,7 @@
 
 #include "transforms/mem2reg.h"
 
+#include "analysis/analysis_manager.h"
 #include "analysis/cfg.h"
 #include "analysis/dom_frontier.h"
 #include "analysis/dom_tree.h"
@@ -23,68 +24,94 @@
 #include "ir/context.h"
 #include "ir/function.h"
 #include "ir/instruction.h"
+#include "ir/module.h"
 #include "ir/type.h"
 #include "ir/use.h"
 #include "ir/value.h"
-#include "utils/bitset.h"
 #include "utils/bump.h"
-#include "utils/hashmap.h"
 #include "utils/id_list.h"
+#include "utils/instrument.h"
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * @brief 存储 mem2reg pass 期间所需的所有上下文。
+ * @brief 存储单个 alloca 的所有分析信息。
  */
 typedef struct
 {
-  IRFunction *func;
-  DominatorTree *dt;
-  DominanceFrontier *df;
-  IRContext *ctx;
-  Bump *arena;
-  IRBuilder *builder;
+  IRInstruction *alloca_inst;
+  IRType *allocated_type;
 
-  size_t num_blocks;
-} Mem2RegContext;
+  /** 存储此 alloca 的块的 id (可能重复) */
+  int *def_blocks;
+  size_t num_defs;
+  /** 需要插入 PHI 节点的块的 id */
+  int *phi_blocks;
+  size_t num_phis;
+} AllocaInfo;
 
 /**
- * @brief 存储单个 alloca 的所有分析信息。
+ * @brief 插入到某个块中的一个 phi 和它对应的 alloca 编号
  */
 typedef struct
 {
-  IRInstruction *alloca_inst;
-  IRType *allocated_type;
-
-  /** 存储此 alloca 的块的集合 (Bitset) */
-  Bitset *def_blocks;
-  /** 需要插入 PHI 节点的块的集合 (Bitset) */
-  Bitset *phi_blocks;
-
-  IDList list_node;
-} AllocaInfo;
+  IRInstruction *phi;
+  uint32_t alloca_index;
+} BlockPhi;
 
 /**
- * @brief 重命名栈上的一个节点。
- * (这是一个简单的侵入式链表，用作栈)
+ * @brief 重命名时的一次入栈: 恢复时把 alloca 的当前值改回 prev
  */
-typedef struct RenameStackNode
+typedef struct
 {
-  IRValueNode *value;
-  struct RenameStackNode *prev;
-} RenameStackNode;
+  uint32_t alloca_index;
+  IRValueNode *prev;
+} RenameUndo;
 
 /**
- * @brief 重命名阶段的完整状态。
+ * @brief 存储 mem2reg pass 期间所需的所有上下文。
  */
 typedef struct
 {
+  IRFunction *func;
+  DominatorTree *dt;
+  IRContext *ctx;
   Bump *arena;
-  /** 映射: AllocaInst* -> RenameStackNode* (指向栈顶) */
-  PtrHashMap *alloca_to_stack_top;
-} RenameState;
+  IRBuilder *builder;
+
+  size_t num_blocks;
+  /** 可提升的 alloca，按稠密编号 (alloca_inst->as.alloca.pass_index) 排列 */
+  AllocaInfo *allocas;
+  size_t num_allocas;
+  /** 计算每个 alloca 的迭代支配边界 (所有 alloca 共用临时数组) */
+  IDFCalculator idf;
+  /** ir_analysis_idf_compute 的输出缓冲区 (num_blocks 个) */
+  int *idf_blocks;
+
+  IRMem2RegPhiPlacement placement;
+  /**
+   * 活跃性的按块标记 (num_blocks 个，初始为 0): 处理编号为 a 的 alloca 时，stamp = a + 1。
+   * def_mark[b] == stamp 表示 b 中有 store；live_mark[b] == stamp 表示变量在 b 的入口活跃，
+   * live_mark[b] == -stamp 表示 b 已检查过、其中的 load 都在某个 store 之后
+   */
+  int *def_mark;
+  int *live_mark;
+  /** 向前驱传播入口活跃性的工作表 (num_blocks 个) */
+  int *worklist;
+
+  /** 每个块 (按 id) 中插入的 phi: block_phis[block_phi_start[id] .. block_phi_start[id + 1]) */
+  BlockPhi *block_phis;
+  size_t *block_phi_start;
+
+  /** 重命名: 每个 alloca 当前的值 (栈顶)，和离开支配子树时用来恢复栈顶的撤销日志 */
+  IRValueNode **current;
+  RenameUndo *undo;
+  size_t undo_len;
+} Mem2RegContext;
 
 /**
  * @brief 检查 alloca 是否只被 load/store 使用。
@@ -113,8 +140,7 @@ is_promotable(IRInstruction *alloca_inst)
     if (user_inst->opcode == IR_OP_STORE)
     {
 
-      IRUse *val_use = list_entry(user_inst->operands.next, IRUse, user_node);
-      IRUse *ptr_use = list_entry(val_use->user_node.next, IRUse, user_node);
+      IRUse *ptr_use = ir_instruction_get_operand_use(user_inst, 1);
 
       if (ptr_use->value == alloca_val)
       {
@@ -130,10 +156,10 @@ is_promotable(IRInstruction *alloca_inst)
 }
 
 /**
- * @brief 收集所有可提升的 alloca，并找到它们的 'def_blocks' (store)
+ * @brief 收集所有可提升的 alloca 并给它们稠密编号，同时找到它们的 'def_blocks' (store)
  */
 static void
-find_promotable_allocas(Mem2RegContext *ctx, IDList *promotable_allocas)
+find_promotable_allocas(Mem2RegContext *ctx)
 {
 
   if (list_empty(&ctx->func->basic_blocks))
@@ -142,7 +168,15 @@ find_promotable_allocas(Mem2RegContext *ctx, IDList *promotable_allocas)
   }
   IRBasicBlock *entry_bb = list_entry(ctx->func->basic_blocks.next, IRBasicBlock, list_node);
 
+  size_t max_allocas = 0;
   IDList *inst_node;
+  list_for_each(&entry_bb->instructions, inst_node)
+  {
+    if (list_entry(inst_node, IRInstruction, list_node)->opcode == IR_OP_ALLOCA)
+      max_allocas++;
+  }
+  ctx->allocas = BUMP_ALLOC_SLICE(ctx->arena, AllocaInfo, max_allocas > 0 ? max_allocas : 1);
+
   list_for_each(&entry_bb->instructions, inst_node)
   {
     IRInstruction *inst = list_entry(inst_node, IRInstruction, list_node);
@@ -167,312 +201,363 @@ find_promotable_allocas(Mem2RegContext *ctx, IDList *promotable_allocas)
       continue;
     }
 
-    AllocaInfo *info = BUMP_ALLOC_ZEROED(ctx->arena, AllocaInfo);
-    info->alloca_inst = inst;
-    info->allocated_type = pointee_type;
-    info->def_blocks = bitset_create(ctx->num_blocks, ctx->arena);
-    info->phi_blocks = bitset_create(ctx->num_blocks, ctx->arena);
+    inst->as.alloca.pass_index = (uint32_t)ctx->num_allocas;
+    AllocaInfo *info = &ctx->allocas[ctx->num_allocas++];
+    *info = (AllocaInfo){.alloca_inst = inst, .allocated_type = pointee_type};
 
+    size_t num_stores = 0;
     IDList *use_node;
     list_for_each(&inst->result.uses, use_node)
+    {
+      if (list_entry(use_node, IRUse, value_node)->user->opcode == IR_OP_STORE)
+        num_stores++;
+    }
+    info->def_blocks = BUMP_ALLOC_SLICE(ctx->arena, int, num_stores > 0 ? num_stores : 1);
+    list_for_each(&inst->result.uses, use_node)
     {
       IRUse *use = list_entry(use_node, IRUse, value_node);
       if (use->user->opcode == IR_OP_STORE)
       {
 
         CFGNode *node = cfg_get_node(ctx->dt->cfg, use->user->parent);
-        bitset_set(info->def_blocks, node->id);
+        info->def_blocks[info->num_defs++] = node->id;
       }
     }
-
-    list_add_tail(promotable_allocas, &info->list_node);
   }
 }
 
-static void
-compute_phi_placement(Mem2RegContext *ctx, AllocaInfo *info)
+/**
+ * @brief 指针是被提升的 alloca 时返回它的编号，否则返回 -1
+ *
+ * pass_index 只在这次运行中赋值，所以要核对编号对应的 alloca 就是它本身。
+ */
+static int64_t
+promoted_alloca_index(Mem2RegContext *ctx, IRValueNode *ptr)
 {
+  if (ptr->kind != IR_KIND_INSTRUCTION)
+    return -1;
+  IRInstruction *inst = container_of(ptr, IRInstruction, result);
+  if (inst->opcode != IR_OP_ALLOCA)
+    return -1;
+  uint32_t index = inst->as.alloca.pass_index;
+  return index < ctx->num_allocas && ctx->allocas[index].alloca_inst == inst ? (int64_t)index : -1;
+}
 
-  size_t *worklist_stack = BUMP_ALLOC_SLICE(ctx->arena, size_t, ctx->num_blocks);
-  size_t worklist_count = 0;
+/**
+ * @brief 块中第一次访问 alloca 的指令是不是 load (也就是 load 向上暴露，变量在入口活跃)
+ */
+static bool
+first_access_is_load(IRBasicBlock *bb, IRValueNode *alloca_val)
+{
+  IDList *iter;
+  list_for_each(&bb->instructions, iter)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    if (inst->opcode == IR_OP_LOAD && ir_instruction_get_operand(inst, 0) == alloca_val)
+      return true;
+    if (inst->opcode == IR_OP_STORE && ir_instruction_get_operand(inst, 1) == alloca_val)
+      return false;
+  }
+  return false;
+}
 
-  for (size_t b_id = 0; b_id < ctx->num_blocks; b_id++)
+/**
+ * @brief 标记 alloca 入口活跃的块 (live_mark[b] == stamp)
+ *
+ * 从有向上暴露的 load 的块出发，沿前驱向上传播，遇到有 store 的块就停下。
+ * 只访问变量活跃的块，所以开销与活跃区域成正比，而不是与函数大小成正比。
+ *
+ * @return 是否有块在入口活跃 (半剪枝只需要这个)
+ */
+static bool
+compute_live_in_blocks(Mem2RegContext *ctx, AllocaInfo *info, int stamp)
+{
+  FunctionCFG *cfg = ctx->dt->cfg;
+  for (size_t i = 0; i < info->num_defs; i++)
+    ctx->def_mark[info->def_blocks[i]] = stamp;
+
+  int num_work = 0;
+  IDList *use_node;
+  list_for_each(&info->alloca_inst->result.uses, use_node)
   {
-    if (bitset_test(info->def_blocks, b_id))
+    IRInstruction *user = list_entry(use_node, IRUse, value_node)->user;
+    if (user->opcode != IR_OP_LOAD)
+      continue;
+    int id = cfg_get_node(cfg, user->parent)->id;
+    if (ctx->live_mark[id] == stamp || ctx->live_mark[id] == -stamp)
+      continue;
+    if (ctx->def_mark[id] == stamp && !first_access_is_load(user->parent, &info->alloca_inst->result))
     {
-      worklist_stack[worklist_count++] = b_id;
+      ctx->live_mark[id] = -stamp;
+      continue;
     }
+    ctx->live_mark[id] = stamp;
+    ctx->worklist[num_work++] = id;
   }
+  bool any_live = num_work > 0;
 
-  while (worklist_count > 0)
+  while (num_work > 0)
   {
-    size_t b_id = worklist_stack[--worklist_count];
-    CFGNode *b_node = &ctx->dt->cfg->nodes[b_id];
-
-    Bitset *df_b = ir_analysis_dom_frontier_get(ctx->df, b_node->block);
-    if (!df_b)
-      continue;
-
-    for (size_t d_id = 0; d_id < ctx->num_blocks; d_id++)
+    CFGNode *node = &cfg->nodes[ctx->worklist[--num_work]];
+    for (int k = 0; k < node->num_preds; k++)
     {
-      if (bitset_test(df_b, d_id))
-      {
-
-        if (!bitset_test(info->phi_blocks, d_id))
-        {
-
-          bitset_set(info->phi_blocks, d_id);
-          worklist_stack[worklist_count++] = d_id;
-        }
-      }
+      int pred = node->preds[k];
+      /// 有 store 的前驱只有在自己的 load 向上暴露时才活跃，上面已经处理过
+      if (ctx->live_mark[pred] == stamp || ctx->def_mark[pred] == stamp)
+        continue;
+      ctx->live_mark[pred] = stamp;
+      ctx->worklist[num_work++] = pred;
     }
   }
+  return any_live;
 }
 
 /**
- * @brief 在所有标记的块中插入空的 PHI 节点
- * @return 一个 Map (AllocaInst* -> Map<IRBasicBlock*, PHIInst*>)
- * (我们用一个 PtrHashMap<PHIInst*, AllocaInst*> 来反向映射)
+ * @brief phi 放在定义块集合的迭代支配边界上 (按 ctx->placement 去掉变量已经死了的块)
  */
-static PtrHashMap *
-insert_phi_nodes(Mem2RegContext *ctx, IDList *promotable_allocas)
+static void
+compute_phi_placement(Mem2RegContext *ctx, AllocaInfo *info, int stamp)
 {
+  info->num_phis = ir_analysis_idf_compute(&ctx->idf, info->def_blocks, info->num_defs, ctx->idf_blocks);
+  if (ctx->placement != IR_MEM2REG_MINIMAL && info->num_phis > 0)
+  {
+    bool any_live = compute_live_in_blocks(ctx, info, stamp);
+    size_t kept = 0;
+    for (size_t i = 0; i < info->num_phis; i++)
+    {
+      int id = ctx->idf_blocks[i];
+      bool live = ctx->placement == IR_MEM2REG_PRUNED ? ctx->live_mark[id] == stamp : any_live;
+      if (live)
+        ctx->idf_blocks[kept++] = id;
+    }
+    info->num_phis = kept;
+  }
+  info->phi_blocks = BUMP_ALLOC_SLICE(ctx->arena, int, info->num_phis > 0 ? info->num_phis : 1);
+  memcpy(info->phi_blocks, ctx->idf_blocks, info->num_phis * sizeof(int));
+}
 
-  PtrHashMap *phi_to_alloca_map = ptr_hashmap_create(ctx->arena, 16);
-
-  IDList *info_node;
-  list_for_each(promotable_allocas, info_node)
+/**
+ * @brief 在所有标记的块中插入空的 PHI 节点，并按块记录每个 phi 属于哪个 alloca
+ */
+static void
+insert_phi_nodes(Mem2RegContext *ctx)
+{
+  size_t *start = BUMP_ALLOC_SLICE_ZEROED(ctx->arena, size_t, ctx->num_blocks + 1);
+  size_t total = 0;
+  for (size_t a = 0; a < ctx->num_allocas; a++)
   {
-    AllocaInfo *info = list_entry(info_node, AllocaInfo, list_node);
+    for (size_t i = 0; i < ctx->allocas[a].num_phis; i++)
+      start[ctx->allocas[a].phi_blocks[i] + 1]++;
+    total += ctx->allocas[a].num_phis;
+  }
+  for (size_t id = 0; id < ctx->num_blocks; id++)
+    start[id + 1] += start[id];
 
-    for (size_t b_id = 0; b_id < ctx->num_blocks; b_id++)
+  BlockPhi *phis = BUMP_ALLOC_SLICE(ctx->arena, BlockPhi, total > 0 ? total : 1);
+  size_t *fill = BUMP_ALLOC_SLICE_COPY(ctx->arena, size_t, start, ctx->num_blocks + 1);
+  for (size_t a = 0; a < ctx->num_allocas; a++)
+  {
+    AllocaInfo *info = &ctx->allocas[a];
+    for (size_t i = 0; i < info->num_phis; i++)
     {
-      if (bitset_test(info->phi_blocks, b_id))
-      {
-        IRBasicBlock *bb = ctx->dt->cfg->nodes[b_id].block;
+      int id = info->phi_blocks[i];
+      IRBasicBlock *bb = ctx->dt->cfg->nodes[id].block;
 
-        ir_builder_set_insertion_point(ctx->builder, bb);
+      ir_builder_set_insertion_point(ctx->builder, bb);
 
-        IRValueNode *phi_val = ir_builder_create_phi(ctx->builder, info->allocated_type, NULL);
-        IRInstruction *phi_inst = container_of(phi_val, IRInstruction, result);
-
-        ptr_hashmap_put(phi_to_alloca_map, phi_inst, info->alloca_inst);
-      }
+      IRValueNode *phi_val = ir_builder_create_phi(ctx->builder, info->allocated_type, NULL);
+      phis[fill[id]++] = (BlockPhi){container_of(phi_val, IRInstruction, result), (uint32_t)a};
     }
   }
-  return phi_to_alloca_map;
+  ctx->block_phis = phis;
+  ctx->block_phi_start = start;
 }
 
 static void
-push_stack(RenameState *state, IRInstruction *alloca, IRValueNode *value)
+push_value(Mem2RegContext *ctx, uint32_t alloca_index, IRValueNode *value)
 {
-  RenameStackNode *old_top = ptr_hashmap_get(state->alloca_to_stack_top, alloca);
-  RenameStackNode *new_top = BUMP_ALLOC(state->arena, RenameStackNode);
-  new_top->value = value;
-  new_top->prev = old_top;
-  ptr_hashmap_put(state->alloca_to_stack_top, alloca, new_top);
+  ctx->undo[ctx->undo_len++] = (RenameUndo){alloca_index, ctx->current[alloca_index]};
+  ctx->current[alloca_index] = value;
 }
 
+/**
+ * @brief 撤销 mark 之后的入栈 (离开一棵支配子树)
+ */
 static void
-pop_stack(RenameState *state, IRInstruction *alloca)
+pop_values(Mem2RegContext *ctx, size_t mark)
 {
-  RenameStackNode *top = ptr_hashmap_get(state->alloca_to_stack_top, alloca);
-  assert(top && "Popping an empty stack!");
-  ptr_hashmap_put(state->alloca_to_stack_top, alloca, top->prev);
-}
-
-static IRValueNode *
-get_stack_top(RenameState *state, IRInstruction *alloca)
-{
-  RenameStackNode *top = ptr_hashmap_get(state->alloca_to_stack_top, alloca);
-  assert(top && "Getting from an empty stack!");
-  return top->value;
+  while (ctx->undo_len > mark)
+  {
+    RenameUndo *undo = &ctx->undo[--ctx->undo_len];
+    ctx->current[undo->alloca_index] = undo->prev;
+  }
 }
 
 /**
- * @brief 递归重命名
- * @param node 当前的支配树节点
+ * @brief 重命名一个块: phi 和 store 更新当前值，load 被当前值替换；再填后继中 phi 的入边
+ *
+ * load 立即被替换并删除: 它支配的 store 稍后才被处理，读到的已经是替换后的值，
+ * 所以压栈的值里不会有被提升的 load。
  */
 static void
-rename_recursive(Mem2RegContext *ctx, DomTreeNode *node, RenameState *state, PtrHashMap *phi_to_alloca_map)
+rename_block(Mem2RegContext *ctx, CFGNode *cfg_node)
 {
-  IRBasicBlock *bb = node->cfg_node->block;
-
-  IRInstruction *pushed_allocas[64];
-  size_t pushed_count = 0;
-
-  IRInstruction *to_delete[256];
-  size_t delete_count = 0;
+  IRBasicBlock *bb = cfg_node->block;
+  for (size_t i = ctx->block_phi_start[cfg_node->id]; i < ctx->block_phi_start[cfg_node->id + 1]; i++)
+    push_value(ctx, ctx->block_phis[i].alloca_index, &ctx->block_phis[i].phi->result);
 
   IDList *inst_node, *tmp_node;
   list_for_each_safe(&bb->instructions, inst_node, tmp_node)
   {
     IRInstruction *inst = list_entry(inst_node, IRInstruction, list_node);
 
-    if (inst->opcode == IR_OP_PHI)
-    {
-
-      IRInstruction *alloca = ptr_hashmap_get(phi_to_alloca_map, inst);
-      if (alloca)
-      {
-
-        push_stack(state, alloca, &inst->result);
-        pushed_allocas[pushed_count++] = alloca;
-        assert(pushed_count < 64 && "Rename stack overflow");
-      }
-    }
-    else if (inst->opcode == IR_OP_LOAD)
+    if (inst->opcode == IR_OP_LOAD)
     {
-
-      IRUse *ptr_use = list_entry(inst->operands.next, IRUse, user_node);
-      IRValueNode *ptr_val = ptr_use->value;
-
-      if (ptr_val->kind == IR_KIND_INSTRUCTION)
+      int64_t index = promoted_alloca_index(ctx, ir_instruction_get_operand(inst, 0));
+      if (index >= 0)
       {
-        IRInstruction *alloca = container_of(ptr_val, IRInstruction, result);
-        if (ptr_hashmap_contains(state->alloca_to_stack_top, alloca))
-        {
-
-          IRValueNode *live_val = get_stack_top(state, alloca);
-          ir_value_replace_all_uses_with(&inst->result, live_val);
-
-          to_delete[delete_count++] = inst;
-          assert(delete_count < 256 && "Delete list overflow");
-        }
+        ir_value_replace_all_uses_with(&inst->result, ctx->current[index]);
+        ir_instruction_erase_from_parent(inst);
       }
     }
     else if (inst->opcode == IR_OP_STORE)
     {
-
-      IRUse *val_use = list_entry(inst->operands.next, IRUse, user_node);
-      IRUse *ptr_use = list_entry(val_use->user_node.next, IRUse, user_node);
-      IRValueNode *ptr_val = ptr_use->value;
-
-      if (ptr_val->kind == IR_KIND_INSTRUCTION)
+      int64_t index = promoted_alloca_index(ctx, ir_instruction_get_operand(inst, 1));
+      if (index >= 0)
       {
-        IRInstruction *alloca = container_of(ptr_val, IRInstruction, result);
-        if (ptr_hashmap_contains(state->alloca_to_stack_top, alloca))
-        {
-
-          IRValueNode *stored_val = val_use->value;
-          push_stack(state, alloca, stored_val);
-          pushed_allocas[pushed_count++] = alloca;
-          assert(pushed_count < 64 && "Rename stack overflow");
-
-          to_delete[delete_count++] = inst;
-          assert(delete_count < 256 && "Delete list overflow");
-        }
+        push_value(ctx, (uint32_t)index, ir_instruction_get_operand(inst, 0));
+        ir_instruction_erase_from_parent(inst);
       }
     }
   }
 
-  IDList *succ_edge_node;
-  list_for_each(&node->cfg_node->successors, succ_edge_node)
+  for (int i = 0; i < cfg_node->num_succs; i++)
   {
-    CFGEdge *edge = list_entry(succ_edge_node, CFGEdge, list_node);
-    IRBasicBlock *succ_bb = edge->node->block;
-
-    IDList *succ_inst_node;
-    list_for_each(&succ_bb->instructions, succ_inst_node)
+    int succ = cfg_node->succs[i];
+    for (size_t k = ctx->block_phi_start[succ]; k < ctx->block_phi_start[succ + 1]; k++)
     {
-      IRInstruction *succ_phi = list_entry(succ_inst_node, IRInstruction, list_node);
-      if (succ_phi->opcode != IR_OP_PHI)
-      {
-        break;
-      }
-
-      IRInstruction *alloca = ptr_hashmap_get(phi_to_alloca_map, succ_phi);
-      if (alloca)
-      {
-
-        IRValueNode *outgoing_val = get_stack_top(state, alloca);
-
-        ir_phi_add_incoming(&succ_phi->result, outgoing_val, bb);
-      }
+      BlockPhi *phi = &ctx->block_phis[k];
+      ir_phi_add_incoming(&phi->phi->result, ctx->current[phi->alloca_index], bb);
     }
   }
+}
 
-  IDList *child_node;
-  list_for_each(&node->children, child_node)
-  {
-    DomTreeChild *child = list_entry(child_node, DomTreeChild, list_node);
-    rename_recursive(ctx, child->node, state, phi_to_alloca_map);
-  }
-
-  for (size_t i = 0; i < pushed_count; i++)
-  {
-    pop_stack(state, pushed_allocas[i]);
-  }
-
-  for (size_t i = 0; i < delete_count; i++)
+/**
+ * @brief 按支配树先序重命名 (显式栈，不递归)
+ *
+ * open 中是当前节点在支配树上的祖先链；进入一个节点前，先弹出不支配它的祖先并撤销它们的入栈。
+ */
+static void
+rename_all(Mem2RegContext *ctx)
+{
+  DominatorTree *dt = ctx->dt;
+  DomTreeNode **open = BUMP_ALLOC_SLICE(ctx->arena, DomTreeNode *, dt->num_reachable > 0 ? dt->num_reachable : 1);
+  size_t *marks = BUMP_ALLOC_SLICE(ctx->arena, size_t, dt->num_reachable > 0 ? dt->num_reachable : 1);
+  int top = 0;
+  for (int i = 0; i < dt->num_reachable; i++)
   {
-    IRInstruction *inst = to_delete[i];
-    list_del(&inst->list_node);
-    ir_instruction_erase_from_parent(inst);
+    DomTreeNode *node = dt->dom_preorder[i];
+    while (top > 0 && open[top - 1]->dom_post < node->dom_post)
+    {
+      top--;
+      pop_values(ctx, marks[top]);
+    }
+    open[top] = node;
+    marks[top++] = ctx->undo_len;
+    rename_block(ctx, node->cfg_node);
   }
 }
 
 bool
 ir_transform_mem2reg_run(IRFunction *func, DominatorTree *dt, DominanceFrontier *df)
 {
+  /// phi 的位置由 IDFCalculator 直接从支配树求出，不再需要完整的支配边界
+  (void)df;
+  return ir_transform_mem2reg_run_with_placement(func, dt, IR_MEM2REG_PRUNED);
+}
 
+static bool
+mem2reg_run_untimed(IRFunction *func, DominatorTree *dt, IRMem2RegPhiPlacement placement)
+{
   IRContext *ctx = func->parent->context;
+  /// 分析数据和重命名栈只在这次运行中使用 (新建的 phi 由 builder 分配在函数体的 Arena 中)
+  Bump scratch;
+  bump_init(&scratch);
   Mem2RegContext m2r_ctx = {
     .func = func,
     .dt = dt,
-    .df = df,
     .ctx = ctx,
-    .arena = &ctx->ir_arena,
+    .arena = &scratch,
     .builder = ir_builder_create(ctx),
     .num_blocks = dt->cfg->num_nodes,
+    .placement = placement,
   };
 
-  IDList promotable_allocas;
-  list_init(&promotable_allocas);
-
-  find_promotable_allocas(&m2r_ctx, &promotable_allocas);
+  find_promotable_allocas(&m2r_ctx);
 
-  if (list_empty(&promotable_allocas))
+  if (m2r_ctx.num_allocas == 0)
   {
     ir_builder_destroy(m2r_ctx.builder);
+    bump_destroy(&scratch);
     return false;
   }
 
-  IDList *info_node;
-  list_for_each(&promotable_allocas, info_node)
+  m2r_ctx.idf_blocks = BUMP_ALLOC_SLICE(&scratch, int, m2r_ctx.num_blocks);
+  m2r_ctx.def_mark = BUMP_ALLOC_SLICE_ZEROED(&scratch, int, m2r_ctx.num_blocks);
+  m2r_ctx.live_mark = BUMP_ALLOC_SLICE_ZEROED(&scratch, int, m2r_ctx.num_blocks);
+  m2r_ctx.worklist = BUMP_ALLOC_SLICE(&scratch, int, m2r_ctx.num_blocks);
+  if (!m2r_ctx.idf_blocks || !ir_analysis_idf_init(&m2r_ctx.idf, dt, &scratch))
   {
-    AllocaInfo *info = list_entry(info_node, AllocaInfo, list_node);
-    compute_phi_placement(&m2r_ctx, info);
+    ir_builder_destroy(m2r_ctx.builder);
+    bump_destroy(&scratch);
+    return false;
   }
 
-  PtrHashMap *phi_to_alloca_map = insert_phi_nodes(&m2r_ctx, &promotable_allocas);
-
-  RenameState rename_state = {
-    .arena = m2r_ctx.arena,
-    .alloca_to_stack_top = ptr_hashmap_create(m2r_ctx.arena, 16),
-  };
-
-  list_for_each(&promotable_allocas, info_node)
+  /// 每次入栈来自一个 phi 或一个 store，撤销日志的长度不超过它们的总数
+  size_t max_pushes = 0;
+  for (size_t a = 0; a < m2r_ctx.num_allocas; a++)
   {
-    AllocaInfo *info = list_entry(info_node, AllocaInfo, list_node);
-    IRValueNode *undef = ir_constant_get_undef(ctx, info->allocated_type);
-
-    push_stack(&rename_state, info->alloca_inst, undef);
+    compute_phi_placement(&m2r_ctx, &m2r_ctx.allocas[a], (int)a + 1);
+    max_pushes += m2r_ctx.allocas[a].num_phis + m2r_ctx.allocas[a].num_defs;
   }
 
-  rename_recursive(&m2r_ctx, dt->root, &rename_state, phi_to_alloca_map);
+  insert_phi_nodes(&m2r_ctx);
 
-  IDList *tmp_node;
-  list_for_each_safe(&promotable_allocas, info_node, tmp_node)
-  {
-    AllocaInfo *info = list_entry(info_node, AllocaInfo, list_node);
-    IRInstruction *alloca_inst = info->alloca_inst;
+  m2r_ctx.current = BUMP_ALLOC_SLICE(&scratch, IRValueNode *, m2r_ctx.num_allocas);
+  m2r_ctx.undo = BUMP_ALLOC_SLICE(&scratch, RenameUndo, max_pushes > 0 ? max_pushes : 1);
+  for (size_t a = 0; a < m2r_ctx.num_allocas; a++)
+    m2r_ctx.current[a] = ir_constant_get_undef(ctx, m2r_ctx.allocas[a].allocated_type);
 
-    list_del(&alloca_inst->list_node);
-    ir_instruction_erase_from_parent(alloca_inst);
-  }
+  rename_all(&m2r_ctx);
+
+  for (size_t a = 0; a < m2r_ctx.num_allocas; a++)
+    ir_instruction_erase_from_parent(m2r_ctx.allocas[a].alloca_inst);
 
   ir_builder_destroy(m2r_ctx.builder);
+  bump_destroy(&scratch);
 
   return true;
-}
\ No newline at end of file
+}
+
+bool
+ir_transform_mem2reg_run_with_placement(IRFunction *func, DominatorTree *dt, IRMem2RegPhiPlacement placement)
+{
+  INSTRUMENT_BEGIN(scope, "mem2reg", func->parent->name, func->entry_address.name);
+  INSTRUMENT_TRACK_ARENA(scope, ir_function_body_arena(func));
+  bool changed = mem2reg_run_untimed(func, dt, placement);
+  INSTRUMENT_END(scope);
+  return changed;
+}
+
+bool
+ir_transform_mem2reg_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  DominatorTree *dt = ir_analysis_get_dom_tree(am, func);
+  if (!dt)
+    return false;
+
+  bool changed = ir_transform_mem2reg_run(func, dt, NULL);
+  if (changed)
+    ir_analysis_invalidate(am, func, IR_TRANSFORM_MEM2REG_PRESERVES);
+  return changed;
+}
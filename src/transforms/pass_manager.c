@@ -0,0 +1,439 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/pass_manager.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/verifier.h"
+#include "utils/id_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
+/** @brief 流水线中的一个 Pass (function_pass 和 module_pass 恰好一个非 NULL) */
+typedef struct PipelinePass
+{
+  const char *name;
+  IRFunctionPassFn function_pass;
+  IRModulePassFn module_pass;
+} PipelinePass;
+
+struct IRPassPipeline
+{
+  PipelinePass *passes;
+  size_t num_passes;
+  size_t capacity;
+  size_t num_threads;
+  bool verify_each;
+};
+
+IRPassPipeline *
+ir_pass_pipeline_create(void)
+{
+  IRPassPipeline *pipeline = (IRPassPipeline *)calloc(1, sizeof(IRPassPipeline));
+  if (pipeline)
+    pipeline->num_threads = 1;
+  return pipeline;
+}
+
+void
+ir_pass_pipeline_destroy(IRPassPipeline *pipeline)
+{
+  if (!pipeline)
+    return;
+  free(pipeline->passes);
+  free(pipeline);
+}
+
+static bool
+pipeline_push(IRPassPipeline *pipeline, PipelinePass pass)
+{
+  if (pipeline->num_passes == pipeline->capacity)
+  {
+    size_t capacity = pipeline->capacity ? pipeline->capacity * 2 : 8;
+    PipelinePass *passes = (PipelinePass *)realloc(pipeline->passes, capacity * sizeof(PipelinePass));
+    if (!passes)
+      return false;
+    pipeline->passes = passes;
+    pipeline->capacity = capacity;
+  }
+  pipeline->passes[pipeline->num_passes++] = pass;
+  return true;
+}
+
+bool
+ir_pass_pipeline_add_function_pass(IRPassPipeline *pipeline, const char *name, IRFunctionPassFn run)
+{
+  return pipeline_push(pipeline, (PipelinePass){.name = name, .function_pass = run, .module_pass = NULL});
+}
+
+bool
+ir_pass_pipeline_add_module_pass(IRPassPipeline *pipeline, const char *name, IRModulePassFn run)
+{
+  return pipeline_push(pipeline, (PipelinePass){.name = name, .function_pass = NULL, .module_pass = run});
+}
+
+void
+ir_pass_pipeline_set_num_threads(IRPassPipeline *pipeline, size_t num_threads)
+{
+  pipeline->num_threads = num_threads;
+}
+
+void
+ir_pass_pipeline_set_verify_each(IRPassPipeline *pipeline, bool verify_each)
+{
+  pipeline->verify_each = verify_each;
+}
+
+/*
+ * =================================================================
+ * --- 函数 Pass 组 ---
+ * =================================================================
+ */
+
+/** @brief 一个要处理的函数和它的大小 (指令数，决定领取顺序) */
+typedef struct GroupItem
+{
+  IRFunction *func;
+  size_t size;
+  bool changed;
+} GroupItem;
+
+/** @brief 所有 worker 共享的任务: 对每个函数依次运行 passes[0..num_passes) */
+typedef struct GroupJob
+{
+  IRContext *context;
+  const PipelinePass *passes;
+  size_t num_passes;
+  bool verify_each;
+  GroupItem *items;
+  size_t num_items;
+#if !defined(__STDC_NO_THREADS__)
+  /** 下一个要领取的函数 */
+  atomic_size_t next;
+  /** 有函数验证失败 (之后不再领取新的函数) */
+  atomic_bool failed;
+#else
+  size_t next;
+  bool failed;
+#endif
+} GroupJob;
+
+/** @brief 一个 worker 的私有状态 */
+typedef struct GroupWorker
+{
+  GroupJob *job;
+  /** worker 自己的分析管理器 (单线程运行时是调用者的 am) */
+  IRAnalysisManager *am;
+  /** 处理完一个函数后是否丢掉它的分析缓存 (并行时为 true，让内存只取决于最大的函数) */
+  bool forget;
+#if !defined(__STDC_NO_THREADS__)
+  IRContextWorker context_worker;
+  bool entered;
+#endif
+} GroupWorker;
+
+/**
+ * @brief 对一个函数运行整组 Pass
+ * @return bool 验证失败时返回 false (已打印错误)
+ */
+static bool
+run_function_passes(const GroupJob *job, GroupItem *item, IRAnalysisManager *am)
+{
+  for (size_t i = 0; i < job->num_passes; i++)
+  {
+    const PipelinePass *pass = &job->passes[i];
+    /// 报告了修改的 Pass 可能直接改写了指令字段，所以总是重新验证；没有修改过的函数跳过
+    if (pass->function_pass(item->func, am))
+    {
+      item->changed = true;
+      ir_function_mark_modified(item->func);
+    }
+    if (job->verify_each && !ir_function_is_verified(item->func) && !ir_verify_function_with_analyses(item->func, am))
+    {
+      fprintf(stderr, "Verification failed after pass '%s' on function '@%s'\n", pass->name,
+              item->func->entry_address.name);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 不断领取函数并运行整组 Pass，直到全部领完或有函数验证失败
+ */
+static void
+group_worker_run(GroupWorker *w)
+{
+  GroupJob *job = w->job;
+  while (true)
+  {
+#if !defined(__STDC_NO_THREADS__)
+    if (atomic_load(&job->failed))
+      return;
+    size_t index = atomic_fetch_add(&job->next, 1);
+#else
+    if (job->failed)
+      return;
+    size_t index = job->next++;
+#endif
+    if (index >= job->num_items)
+      return;
+
+    GroupItem *item = &job->items[index];
+    bool ok = run_function_passes(job, item, w->am);
+    if (w->forget)
+      ir_analysis_forget(w->am, item->func);
+    if (!ok)
+    {
+#if !defined(__STDC_NO_THREADS__)
+      atomic_store(&job->failed, true);
+#else
+      job->failed = true;
+#endif
+    }
+  }
+}
+
+#if !defined(__STDC_NO_THREADS__)
+static int
+group_worker_main(void *arg)
+{
+  GroupWorker *w = (GroupWorker *)arg;
+  /// 进入失败 (OOM) 的 worker 不领取函数，剩下的函数由其他 worker 或之后的调用线程处理
+  if (!ir_context_enter_worker(w->job->context, &w->context_worker))
+    return 0;
+  w->entered = true;
+  group_worker_run(w);
+  ir_context_leave_worker(&w->context_worker);
+  return 0;
+}
+
+/**
+ * @brief 在 workers[1..] 各自的线程和调用线程 (workers[0]) 上处理函数，之后并入各 worker 的 Arena
+ *
+ * 线程启动失败时剩下的 worker 不参与，函数由已经启动的 worker 分担。
+ */
+static void
+group_run_threads(IRContext *ctx, GroupWorker *workers, size_t num_workers)
+{
+  thrd_t *threads = (thrd_t *)malloc((num_workers - 1) * sizeof(thrd_t));
+  size_t started = 0;
+  if (threads)
+  {
+    while (started < num_workers - 1 &&
+           thrd_create(&threads[started], group_worker_main, &workers[started + 1]) == thrd_success)
+    {
+      started++;
+    }
+  }
+
+  group_worker_main(&workers[0]);
+
+  for (size_t i = 0; i < started; i++)
+  {
+    thrd_join(threads[i], NULL);
+  }
+  free(threads);
+
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    if (workers[i].entered)
+      ir_context_adopt_worker(ctx, &workers[i].context_worker);
+  }
+}
+#endif
+
+/** @brief qsort 比较函数: 大的函数在前 */
+static int
+compare_items_by_size(const void *a, const void *b)
+{
+  size_t sa = ((const GroupItem *)a)->size;
+  size_t sb = ((const GroupItem *)b)->size;
+  return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+static size_t
+count_instructions(IRFunction *func)
+{
+  size_t count = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 对模块中每个有函数体的函数运行 passes[0..num_passes)
+ *
+ * @return bool 验证失败或 OOM 时返回 false
+ */
+static bool
+run_function_group(const IRPassPipeline *pipeline, const PipelinePass *passes, size_t num_passes, IRModule *mod,
+                   IRAnalysisManager *am, bool *changed)
+{
+  size_t num_items = 0;
+  IDList *iter;
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (!list_empty(&func->basic_blocks))
+      num_items++;
+  }
+  if (num_items == 0)
+    return true;
+
+  GroupItem *items = (GroupItem *)malloc(num_items * sizeof(GroupItem));
+  if (!items)
+  {
+    fprintf(stderr, "Fatal: Out of memory while running function passes\n");
+    return false;
+  }
+  size_t index = 0;
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (!list_empty(&func->basic_blocks))
+      items[index++] = (GroupItem){.func = func, .size = count_instructions(func), .changed = false};
+  }
+
+  GroupJob job;
+  job.context = mod->context;
+  job.passes = passes;
+  job.num_passes = num_passes;
+  job.verify_each = pipeline->verify_each;
+  job.items = items;
+  job.num_items = num_items;
+#if !defined(__STDC_NO_THREADS__)
+  atomic_init(&job.next, 0);
+  atomic_init(&job.failed, false);
+#else
+  job.next = 0;
+  job.failed = false;
+#endif
+
+  size_t num_threads = pipeline->num_threads;
+#if defined(__STDC_NO_THREADS__)
+  num_threads = 1;
+#endif
+  if (num_threads > num_items)
+    num_threads = num_items;
+
+  bool parallel = false;
+  GroupWorker *workers = NULL;
+  size_t num_workers = 0;
+#if !defined(__STDC_NO_THREADS__)
+  if (num_threads > 1)
+  {
+    /// 最大的函数最先领取，它和其余的函数同时进行
+    qsort(items, num_items, sizeof(GroupItem), compare_items_by_size);
+    workers = (GroupWorker *)calloc(num_threads, sizeof(GroupWorker));
+    while (workers && num_workers < num_threads && (workers[num_workers].am = ir_analysis_manager_create()))
+    {
+      workers[num_workers].job = &job;
+      workers[num_workers].forget = true;
+      num_workers++;
+    }
+    if (num_workers > 1 && ir_context_begin_concurrent(mod->context))
+    {
+      parallel = true;
+      group_run_threads(mod->context, workers, num_workers);
+      ir_context_end_concurrent(mod->context);
+    }
+  }
+#endif
+
+  /// 单线程，或者并行时还有没领取的函数 (worker 进入失败)：在调用线程上用调用者的 am 处理
+  GroupWorker self = {.job = &job, .am = am, .forget = false};
+  group_worker_run(&self);
+
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    ir_analysis_manager_destroy(workers[i].am);
+  }
+  free(workers);
+
+  for (size_t i = 0; i < num_items; i++)
+  {
+    if (!items[i].changed)
+      continue;
+    *changed = true;
+    /// worker 的管理器已经记录了失效，调用者的 am 中这个函数的旧缓存需要在这里丢掉
+    if (parallel)
+      ir_analysis_invalidate(am, items[i].func, IR_PRESERVE_NONE);
+  }
+  free(items);
+
+#if !defined(__STDC_NO_THREADS__)
+  return !atomic_load(&job.failed);
+#else
+  return !job.failed;
+#endif
+}
+
+/*
+ * =================================================================
+ * --- 公共 API ---
+ * =================================================================
+ */
+
+bool
+ir_pass_pipeline_run(IRPassPipeline *pipeline, IRModule *mod, IRAnalysisManager *am, bool *out_changed)
+{
+  bool changed = false;
+  /// 物化会修改 Context，必须在启动 worker 之前完成
+  bool ok = ir_module_materialize_all(mod);
+
+  size_t i = 0;
+  while (ok && i < pipeline->num_passes)
+  {
+    const PipelinePass *pass = &pipeline->passes[i];
+    if (pass->module_pass)
+    {
+      if (pass->module_pass(mod, am))
+        changed = true;
+      if (pipeline->verify_each && !ir_verify_module_incremental_with_analyses(mod, am))
+      {
+        fprintf(stderr, "Verification failed after pass '%s'\n", pass->name);
+        ok = false;
+      }
+      i++;
+      continue;
+    }
+
+    size_t end = i;
+    while (end < pipeline->num_passes && pipeline->passes[end].function_pass)
+      end++;
+    ok = run_function_group(pipeline, &pipeline->passes[i], end - i, mod, am, &changed);
+    i = end;
+  }
+
+  if (out_changed)
+    *out_changed = changed;
+  return ok;
+}
@@ -0,0 +1,647 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/sccp.h"
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief 格 (lattice) 上的状态: 未知 (还没有算出，乐观地当作任何值) > 常量 > 过定义 (不是常量)
+ */
+typedef enum
+{
+  LATTICE_UNKNOWN,
+  LATTICE_CONSTANT,
+  LATTICE_OVERDEFINED,
+} LatticeState;
+
+typedef struct
+{
+  LatticeState state;
+  /** LATTICE_CONSTANT 时的常量 (常量是唯一化的，相同的值就是同一个指针) */
+  IRValueNode *constant;
+} LatticeValue;
+
+/**
+ * @brief SCCP 运行期间的所有状态
+ */
+typedef struct
+{
+  IRFunction *func;
+  FunctionCFG *cfg;
+  IRContext *ctx;
+  DataLayout *dl;
+  Bump *arena;
+
+  /** 有结果的指令的稠密编号: insts[i] 的格值是 lattice[i] */
+  IRInstruction **insts;
+  LatticeValue *lattice;
+  size_t num_insts;
+  /** 指令结果 -> 编号 + 1 */
+  PtrHashMap *value_index;
+
+  /** 按块 id: 块是否可能执行 */
+  bool *block_executable;
+  /** 边 (节点 i 的第 k 个后继) 是否可能执行: edge_executable[succ_start[i] + k] */
+  int *succ_start;
+  bool *edge_executable;
+
+  /** 新变成可执行、还没有访问的块 (每个块只进一次) */
+  int *block_worklist;
+  int num_block_work;
+  /** 格值下降过、用户需要重新计算的指令编号 (每条指令至多下降两次) */
+  size_t *value_worklist;
+  size_t num_value_work;
+} SCCPContext;
+
+/*
+ * =================================================================
+ * --- 格值 ---
+ * =================================================================
+ */
+
+static int64_t
+instruction_index(SCCPContext *sc, IRValueNode *value)
+{
+  uintptr_t slot = (uintptr_t)ptr_hashmap_get(sc->value_index, value);
+  return slot ? (int64_t)slot - 1 : -1;
+}
+
+/**
+ * @brief 操作数的格值: 常量 (undef 除外) 是常量，参数、全局变量等是过定义
+ */
+static LatticeValue
+operand_value(SCCPContext *sc, IRValueNode *value)
+{
+  if (value->kind == IR_KIND_CONSTANT)
+  {
+    if (((IRConstant *)value)->const_kind == CONST_KIND_UNDEF)
+      return (LatticeValue){LATTICE_OVERDEFINED, NULL};
+    return (LatticeValue){LATTICE_CONSTANT, value};
+  }
+  if (value->kind == IR_KIND_INSTRUCTION)
+  {
+    int64_t index = instruction_index(sc, value);
+    if (index >= 0)
+      return sc->lattice[index];
+  }
+  return (LatticeValue){LATTICE_OVERDEFINED, NULL};
+}
+
+/** @brief 格上的交 (meet) */
+static LatticeValue
+lattice_meet(LatticeValue a, LatticeValue b)
+{
+  if (a.state == LATTICE_UNKNOWN)
+    return b;
+  if (b.state == LATTICE_UNKNOWN)
+    return a;
+  if (a.state == LATTICE_CONSTANT && b.state == LATTICE_CONSTANT && a.constant == b.constant)
+    return a;
+  return (LatticeValue){LATTICE_OVERDEFINED, NULL};
+}
+
+/*
+ * =================================================================
+ * --- 求解 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 把指令的格值降到 value；变化时把它放进工作表
+ */
+static void
+set_lattice(SCCPContext *sc, size_t index, LatticeValue value)
+{
+  LatticeValue *old = &sc->lattice[index];
+  if (old->state == value.state && old->constant == value.constant)
+    return;
+  if (old->state == LATTICE_CONSTANT && value.state == LATTICE_CONSTANT)
+    value = (LatticeValue){LATTICE_OVERDEFINED, NULL};
+  /// 格值只会下降 (单调)，过定义之后不再变化
+  assert(old->state != LATTICE_OVERDEFINED && value.state >= old->state);
+  *old = value;
+  sc->value_worklist[sc->num_value_work++] = index;
+}
+
+static bool
+edge_is_executable(SCCPContext *sc, int from, int to)
+{
+  const CFGNode *node = &sc->cfg->nodes[from];
+  for (int k = 0; k < node->num_succs; k++)
+  {
+    if (node->succs[k] == to)
+      return sc->edge_executable[sc->succ_start[from] + k];
+  }
+  return false;
+}
+
+static void visit_phi(SCCPContext *sc, IRInstruction *phi);
+
+/**
+ * @brief 标记边 from -> to 可能执行
+ *
+ * to 第一次变成可执行时进入块工作表；已经可执行时只需要重新计算它的 phi (多了一条入边)。
+ */
+static void
+mark_edge(SCCPContext *sc, IRBasicBlock *from, IRBasicBlock *to)
+{
+  const CFGNode *node = &sc->cfg->nodes[from->id];
+  for (int k = 0; k < node->num_succs; k++)
+  {
+    if (node->succs[k] != to->id)
+      continue;
+    bool *edge = &sc->edge_executable[sc->succ_start[from->id] + k];
+    if (*edge)
+      return;
+    *edge = true;
+    break;
+  }
+
+  if (!sc->block_executable[to->id])
+  {
+    sc->block_executable[to->id] = true;
+    sc->block_worklist[sc->num_block_work++] = to->id;
+    return;
+  }
+  IDList *iter;
+  list_for_each(&to->instructions, iter)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    if (inst->opcode != IR_OP_PHI)
+      break;
+    visit_phi(sc, inst);
+  }
+}
+
+static IRBasicBlock *
+operand_block(IRInstruction *inst, size_t index)
+{
+  return container_of(ir_instruction_get_operand(inst, index), IRBasicBlock, label_address);
+}
+
+/**
+ * @brief switch 的条件是常量 cond 时跳转的目标 (与解释器一样按整数值比较)
+ */
+static IRBasicBlock *
+switch_target(IRInstruction *inst, IRValueNode *cond)
+{
+  int64_t value = ((IRConstant *)cond)->data.int_val;
+  for (size_t i = 2; i + 1 < inst->num_operands; i += 2)
+  {
+    if (((IRConstant *)ir_instruction_get_operand(inst, i))->data.int_val == value)
+      return operand_block(inst, i + 1);
+  }
+  return operand_block(inst, 1);
+}
+
+static void
+visit_terminator(SCCPContext *sc, IRInstruction *inst)
+{
+  IRBasicBlock *bb = inst->parent;
+  switch (inst->opcode)
+  {
+  case IR_OP_BR:
+    mark_edge(sc, bb, operand_block(inst, 0));
+    break;
+  case IR_OP_COND_BR: {
+    LatticeValue cond = operand_value(sc, ir_instruction_get_operand(inst, 0));
+    if (cond.state == LATTICE_CONSTANT)
+    {
+      bool taken = ((IRConstant *)cond.constant)->data.int_val != 0;
+      mark_edge(sc, bb, operand_block(inst, taken ? 1 : 2));
+    }
+    else if (cond.state == LATTICE_OVERDEFINED)
+    {
+      mark_edge(sc, bb, operand_block(inst, 1));
+      mark_edge(sc, bb, operand_block(inst, 2));
+    }
+    break;
+  }
+  case IR_OP_SWITCH: {
+    LatticeValue cond = operand_value(sc, ir_instruction_get_operand(inst, 0));
+    if (cond.state == LATTICE_CONSTANT)
+    {
+      mark_edge(sc, bb, switch_target(inst, cond.constant));
+    }
+    else if (cond.state == LATTICE_OVERDEFINED)
+    {
+      for (size_t i = 1; i < inst->num_operands; i += 2)
+        mark_edge(sc, bb, operand_block(inst, i));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void
+visit_phi(SCCPContext *sc, IRInstruction *phi)
+{
+  int64_t index = instruction_index(sc, &phi->result);
+  if (index < 0 || sc->lattice[index].state == LATTICE_OVERDEFINED)
+    return;
+
+  LatticeValue result = {LATTICE_UNKNOWN, NULL};
+  int to = phi->parent->id;
+  for (size_t i = 0; i + 1 < phi->num_operands; i += 2)
+  {
+    if (!edge_is_executable(sc, operand_block(phi, i + 1)->id, to))
+      continue;
+    result = lattice_meet(result, operand_value(sc, ir_instruction_get_operand(phi, i)));
+    if (result.state == LATTICE_OVERDEFINED)
+      break;
+  }
+  set_lattice(sc, (size_t)index, result);
+}
+
+/** @brief 能由 interpreter_fold_instruction 折叠的操作码 (select 单独处理) */
+static bool
+is_foldable(IROpcode opcode)
+{
+  switch (opcode)
+  {
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+  case IR_OP_UDIV:
+  case IR_OP_SDIV:
+  case IR_OP_UREM:
+  case IR_OP_SREM:
+  case IR_OP_FADD:
+  case IR_OP_FSUB:
+  case IR_OP_FMUL:
+  case IR_OP_FDIV:
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+  case IR_OP_AND:
+  case IR_OP_OR:
+  case IR_OP_XOR:
+  case IR_OP_ICMP:
+  case IR_OP_FCMP:
+  case IR_OP_TRUNC:
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+  case IR_OP_FPTRUNC:
+  case IR_OP_FPEXT:
+  case IR_OP_FPTOUI:
+  case IR_OP_FPTOSI:
+  case IR_OP_UITOFP:
+  case IR_OP_SITOFP:
+  case IR_OP_BITCAST:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief 重新计算一条指令 (所在的块必须可执行)
+ */
+static void
+visit_instruction(SCCPContext *sc, IRInstruction *inst)
+{
+  if (inst->opcode == IR_OP_PHI)
+  {
+    visit_phi(sc, inst);
+    return;
+  }
+  if (inst->opcode == IR_OP_BR || inst->opcode == IR_OP_COND_BR || inst->opcode == IR_OP_SWITCH)
+  {
+    visit_terminator(sc, inst);
+    return;
+  }
+
+  int64_t index = instruction_index(sc, &inst->result);
+  if (index < 0 || sc->lattice[index].state == LATTICE_OVERDEFINED)
+    return;
+
+  if (inst->opcode == IR_OP_SELECT)
+  {
+    LatticeValue cond = operand_value(sc, ir_instruction_get_operand(inst, 0));
+    LatticeValue result = {LATTICE_UNKNOWN, NULL};
+    if (cond.state == LATTICE_CONSTANT)
+    {
+      bool taken = ((IRConstant *)cond.constant)->data.int_val != 0;
+      result = operand_value(sc, ir_instruction_get_operand(inst, taken ? 1 : 2));
+    }
+    else if (cond.state == LATTICE_OVERDEFINED)
+    {
+      result = lattice_meet(operand_value(sc, ir_instruction_get_operand(inst, 1)),
+                            operand_value(sc, ir_instruction_get_operand(inst, 2)));
+    }
+    set_lattice(sc, (size_t)index, result);
+    return;
+  }
+
+  if (!is_foldable(inst->opcode))
+  {
+    set_lattice(sc, (size_t)index, (LatticeValue){LATTICE_OVERDEFINED, NULL});
+    return;
+  }
+
+  IRConstant *operands[2];
+  bool unknown = false;
+  assert(inst->num_operands <= 2);
+  for (size_t i = 0; i < inst->num_operands; i++)
+  {
+    LatticeValue value = operand_value(sc, ir_instruction_get_operand(inst, i));
+    if (value.state == LATTICE_OVERDEFINED)
+    {
+      set_lattice(sc, (size_t)index, value);
+      return;
+    }
+    if (value.state == LATTICE_UNKNOWN)
+      unknown = true;
+    else
+      operands[i] = (IRConstant *)value.constant;
+  }
+  if (unknown)
+    return;
+
+  IRValueNode *folded = interpreter_fold_instruction(sc->ctx, sc->dl, inst, operands);
+  set_lattice(sc, (size_t)index,
+              folded ? (LatticeValue){LATTICE_CONSTANT, folded} : (LatticeValue){LATTICE_OVERDEFINED, NULL});
+}
+
+static void
+solve(SCCPContext *sc)
+{
+  IRBasicBlock *entry = sc->cfg->entry_node->block;
+  sc->block_executable[entry->id] = true;
+  sc->block_worklist[sc->num_block_work++] = entry->id;
+
+  while (sc->num_block_work > 0 || sc->num_value_work > 0)
+  {
+    while (sc->num_value_work > 0)
+    {
+      IRInstruction *def = sc->insts[sc->value_worklist[--sc->num_value_work]];
+      IDList *iter;
+      list_for_each(&def->result.uses, iter)
+      {
+        IRInstruction *user = list_entry(iter, IRUse, value_node)->user;
+        if (user->parent->id >= 0 && sc->block_executable[user->parent->id])
+          visit_instruction(sc, user);
+      }
+    }
+    if (sc->num_block_work > 0)
+    {
+      IRBasicBlock *bb = sc->cfg->nodes[sc->block_worklist[--sc->num_block_work]].block;
+      IDList *iter;
+      list_for_each(&bb->instructions, iter)
+      {
+        visit_instruction(sc, list_entry(iter, IRInstruction, list_node));
+      }
+    }
+  }
+}
+
+/*
+ * =================================================================
+ * --- 改写 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 把只剩一条可执行出边的 cond_br / switch 换成 br
+ * @return 改写了终结指令时返回 true
+ */
+static bool
+simplify_terminator(SCCPContext *sc, IRBuilder *builder, IRBasicBlock *bb)
+{
+  IRInstruction *term = list_entry(bb->instructions.prev, IRInstruction, list_node);
+  if (term->opcode != IR_OP_COND_BR && term->opcode != IR_OP_SWITCH)
+    return false;
+
+  const CFGNode *node = &sc->cfg->nodes[bb->id];
+  int live = -1;
+  for (int k = 0; k < node->num_succs; k++)
+  {
+    if (!sc->edge_executable[sc->succ_start[bb->id] + k])
+      continue;
+    if (live >= 0)
+      return false;
+    live = node->succs[k];
+  }
+  assert(live >= 0 && "Executable block without an executable successor edge");
+
+  ir_instruction_erase_from_parent(term);
+  ir_builder_set_insertion_point(builder, bb);
+  ir_builder_create_br(builder, &sc->cfg->nodes[live].block->label_address);
+  return true;
+}
+
+/**
+ * @brief 删除 phi 中来自不可执行边的入边
+ */
+static void
+prune_phi_incoming(SCCPContext *sc, IRBasicBlock *bb)
+{
+  IDList *iter;
+  list_for_each(&bb->instructions, iter)
+  {
+    IRInstruction *phi = list_entry(iter, IRInstruction, list_node);
+    if (phi->opcode != IR_OP_PHI)
+      break;
+    for (size_t i = phi->num_operands / 2; i-- > 0;)
+    {
+      IRBasicBlock *pred = operand_block(phi, 2 * i + 1);
+      if (!edge_is_executable(sc, pred->id, bb->id))
+        ir_phi_remove_incoming(&phi->result, i);
+    }
+  }
+}
+
+/**
+ * @brief 替换常量、改写分支、删除不可达的块
+ * @return IR 是否被修改 (*cfg_changed 记录控制流是否被修改)
+ */
+static bool
+rewrite(SCCPContext *sc, bool *cfg_changed)
+{
+  bool changed = false;
+
+  /// 1. 结果是常量的指令 (只有纯运算和 phi 会是常量) 换成常量
+  for (size_t i = 0; i < sc->num_insts; i++)
+  {
+    IRInstruction *inst = sc->insts[i];
+    if (sc->lattice[i].state != LATTICE_CONSTANT || !sc->block_executable[inst->parent->id])
+      continue;
+    ir_value_replace_all_uses_with(&inst->result, sc->lattice[i].constant);
+    ir_instruction_erase_from_parent(inst);
+    changed = true;
+  }
+
+  /// 2. 可执行的块: 只剩一条可执行出边的分支改成 br，phi 去掉不可执行的入边
+  IRBuilder *builder = ir_builder_create(sc->ctx);
+  int num_nodes = sc->cfg->num_nodes;
+  for (int id = 0; id < num_nodes; id++)
+  {
+    if (sc->block_executable[id] && simplify_terminator(sc, builder, sc->cfg->nodes[id].block))
+      *cfg_changed = true;
+  }
+  ir_builder_destroy(builder);
+  for (int id = 0; id < num_nodes; id++)
+  {
+    if (sc->block_executable[id])
+      prune_phi_incoming(sc, sc->cfg->nodes[id].block);
+  }
+
+  /// 3. 不可执行的块: 先删掉所有引用其他块的指令 (终结指令和 phi)，再删除块本身
+  for (int id = 0; id < num_nodes; id++)
+  {
+    if (sc->block_executable[id])
+      continue;
+    IRBasicBlock *bb = sc->cfg->nodes[id].block;
+    IDList *iter, *next;
+    list_for_each_safe(&bb->instructions, iter, next)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      IROpcode op = inst->opcode;
+      if (op == IR_OP_PHI || op == IR_OP_BR || op == IR_OP_COND_BR || op == IR_OP_SWITCH)
+        ir_instruction_erase_from_parent(inst);
+    }
+  }
+  for (int id = 0; id < num_nodes; id++)
+  {
+    if (sc->block_executable[id])
+      continue;
+    ir_basic_block_erase_from_parent(sc->cfg->nodes[id].block);
+    *cfg_changed = true;
+  }
+
+  return changed || *cfg_changed;
+}
+
+/*
+ * =================================================================
+ * --- 公共 API ---
+ * =================================================================
+ */
+
+bool
+ir_transform_sccp_run(IRFunction *func, FunctionCFG *cfg, bool *out_cfg_changed)
+{
+  bool cfg_changed = false;
+  if (out_cfg_changed)
+    *out_cfg_changed = false;
+  if (!func || !cfg || !cfg->entry_node)
+    return false;
+
+  Bump arena;
+  bump_init(&arena);
+  SCCPContext sc = {0};
+  sc.func = func;
+  sc.cfg = cfg;
+  sc.ctx = func->parent->context;
+  sc.arena = &arena;
+  sc.dl = datalayout_create_host();
+
+  /// 给每条有结果的指令编号
+  size_t num_insts = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      if (list_entry(inst_iter, IRInstruction, list_node)->result.type->kind != IR_TYPE_VOID)
+        num_insts++;
+    }
+  }
+  sc.insts = BUMP_ALLOC_SLICE(&arena, IRInstruction *, num_insts + 1);
+  sc.lattice = BUMP_ALLOC_SLICE_ZEROED(&arena, LatticeValue, num_insts + 1);
+  sc.value_worklist = BUMP_ALLOC_SLICE(&arena, size_t, 2 * num_insts + 1);
+  sc.value_index = ptr_hashmap_create(&arena, num_insts + 1);
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->result.type->kind == IR_TYPE_VOID)
+        continue;
+      sc.insts[sc.num_insts] = inst;
+      ptr_hashmap_put(sc.value_index, &inst->result, (void *)(uintptr_t)(sc.num_insts + 1));
+      sc.num_insts++;
+    }
+  }
+
+  int num_nodes = cfg->num_nodes;
+  sc.block_executable = BUMP_ALLOC_SLICE_ZEROED(&arena, bool, num_nodes);
+  sc.block_worklist = BUMP_ALLOC_SLICE(&arena, int, num_nodes);
+  sc.succ_start = BUMP_ALLOC_SLICE(&arena, int, num_nodes + 1);
+  int num_edges = 0;
+  for (int id = 0; id < num_nodes; id++)
+  {
+    sc.succ_start[id] = num_edges;
+    num_edges += cfg->nodes[id].num_succs;
+  }
+  sc.succ_start[num_nodes] = num_edges;
+  sc.edge_executable = BUMP_ALLOC_SLICE_ZEROED(&arena, bool, num_edges + 1);
+
+  bool changed = false;
+  if (sc.dl && sc.insts && sc.lattice && sc.value_worklist && sc.value_index && sc.block_executable &&
+      sc.block_worklist && sc.succ_start && sc.edge_executable)
+  {
+    solve(&sc);
+    changed = rewrite(&sc, &cfg_changed);
+  }
+
+  datalayout_destroy(sc.dl);
+  bump_destroy(&arena);
+  if (out_cfg_changed)
+    *out_cfg_changed = cfg_changed;
+  return changed;
+}
+
+bool
+ir_transform_sccp_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  FunctionCFG *cfg = ir_analysis_get_cfg(am, func);
+  if (!cfg)
+    return false;
+
+  bool cfg_changed = false;
+  bool changed = ir_transform_sccp_run(func, cfg, &cfg_changed);
+  if (changed)
+    ir_analysis_invalidate(am, func, cfg_changed ? IR_PRESERVE_NONE : IR_PRESERVE_CFG_ANALYSES);
+  return changed;
+}
@@ -0,0 +1,464 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transforms/simplify_cfg.h"
+
+#include "analysis/analysis_manager.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/use.h"
+#include "ir/value.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * =================================================================
+ * --- 辅助函数 ---
+ * =================================================================
+ */
+
+static bool
+is_terminator(const IRInstruction *inst)
+{
+  return inst->opcode == IR_OP_RET || inst->opcode == IR_OP_BR || inst->opcode == IR_OP_COND_BR ||
+         inst->opcode == IR_OP_SWITCH;
+}
+
+/** @brief 块的终结指令 (块为空或还没有终结指令时返回 NULL) */
+static IRInstruction *
+get_terminator(IRBasicBlock *bb)
+{
+  if (list_empty(&bb->instructions))
+    return NULL;
+  IRInstruction *last = list_entry(bb->instructions.prev, IRInstruction, list_node);
+  return is_terminator(last) ? last : NULL;
+}
+
+static IRBasicBlock *
+operand_block(IRInstruction *inst, size_t index)
+{
+  return container_of(ir_instruction_get_operand(inst, index), IRBasicBlock, label_address);
+}
+
+/** @brief 终结指令的操作数 index 是否是跳转目标 */
+static bool
+is_target_operand(IRInstruction *term, size_t index)
+{
+  switch (term->opcode)
+  {
+  case IR_OP_BR:
+    return true;
+  case IR_OP_COND_BR:
+    return index > 0;
+  case IR_OP_SWITCH:
+    return index % 2 == 1;
+  default:
+    return false;
+  }
+}
+
+/** @brief from 的终结指令是否跳到 to */
+static bool
+branches_to(IRBasicBlock *from, IRBasicBlock *to)
+{
+  IRInstruction *term = get_terminator(from);
+  if (!term)
+    return false;
+  for (size_t i = 0; i < term->num_operands; i++)
+  {
+    if (is_target_operand(term, i) && operand_block(term, i) == to)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief 收集跳到 bb 的终结指令 (每个前驱一条，一个 switch 多次跳到 bb 只算一次)
+ * @return 前驱的个数；out_terms 为 NULL 时只计数
+ */
+static size_t
+collect_predecessors(IRBasicBlock *bb, IRInstruction **out_terms)
+{
+  size_t count = 0;
+  IDList *iter;
+  list_for_each(&bb->label_address.uses, iter)
+  {
+    IRInstruction *user = list_entry(iter, IRUse, value_node)->user;
+    if (!is_terminator(user))
+      continue;
+    /// 同一条终结指令的 Use 不一定相邻，向前找一遍
+    bool seen = false;
+    for (IDList *prev = bb->label_address.uses.next; prev != iter && !seen; prev = prev->next)
+      seen = list_entry(prev, IRUse, value_node)->user == user;
+    if (seen)
+      continue;
+    if (out_terms)
+      out_terms[count] = user;
+    count++;
+  }
+  return count;
+}
+
+/** @brief phi 中来自 pred 的入边的值 (没有时返回 NULL) */
+static IRValueNode *
+phi_incoming_for(IRInstruction *phi, IRBasicBlock *pred)
+{
+  for (size_t i = 0; i + 1 < phi->num_operands; i += 2)
+  {
+    if (operand_block(phi, i + 1) == pred)
+      return ir_instruction_get_operand(phi, i);
+  }
+  return NULL;
+}
+
+/** @brief 删除 bb 的所有 phi 中来自 pred 的入边 */
+static void
+remove_phi_entries(IRBasicBlock *bb, IRBasicBlock *pred)
+{
+  IDList *iter;
+  list_for_each(&bb->instructions, iter)
+  {
+    IRInstruction *phi = list_entry(iter, IRInstruction, list_node);
+    if (phi->opcode != IR_OP_PHI)
+      break;
+    for (size_t i = phi->num_operands / 2; i-- > 0;)
+    {
+      if (operand_block(phi, 2 * i + 1) == pred)
+        ir_phi_remove_incoming(&phi->result, i);
+    }
+  }
+}
+
+/** @brief 把 bb 的终结指令换成 br target */
+static void
+replace_with_br(IRBuilder *builder, IRBasicBlock *bb, IRBasicBlock *target)
+{
+  ir_instruction_erase_from_parent(get_terminator(bb));
+  ir_builder_set_insertion_point(builder, bb);
+  ir_builder_create_br(builder, &target->label_address);
+}
+
+/*
+ * =================================================================
+ * --- 改写 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 条件是常量或所有目标相同的 cond_br / switch 改成 br
+ */
+static bool
+fold_branch(IRBuilder *builder, IRBasicBlock *bb)
+{
+  IRInstruction *term = get_terminator(bb);
+  if (!term || (term->opcode != IR_OP_COND_BR && term->opcode != IR_OP_SWITCH))
+    return false;
+
+  IRValueNode *cond = ir_instruction_get_operand(term, 0);
+  bool constant = cond->kind == IR_KIND_CONSTANT && ((IRConstant *)cond)->const_kind == CONST_KIND_INT;
+  IRBasicBlock *target = NULL;
+  if (term->opcode == IR_OP_COND_BR)
+  {
+    if (constant)
+      target = operand_block(term, ((IRConstant *)cond)->data.int_val != 0 ? 1 : 2);
+    else if (operand_block(term, 1) == operand_block(term, 2))
+      target = operand_block(term, 1);
+  }
+  else if (constant)
+  {
+    /// 与解释器一样按整数值比较，没有匹配的 case 时跳到 default
+    int64_t value = ((IRConstant *)cond)->data.int_val;
+    target = operand_block(term, 1);
+    for (size_t i = 2; i + 1 < term->num_operands; i += 2)
+    {
+      if (((IRConstant *)ir_instruction_get_operand(term, i))->data.int_val == value)
+      {
+        target = operand_block(term, i + 1);
+        break;
+      }
+    }
+  }
+  else
+  {
+    target = operand_block(term, 1);
+    for (size_t i = 3; i < term->num_operands; i += 2)
+    {
+      if (operand_block(term, i) != target)
+        return false;
+    }
+  }
+  if (!target)
+    return false;
+
+  /// 不再跳到的后继删掉来自 bb 的入边 (每个后继只删一次)
+  for (size_t i = 0; i < term->num_operands; i++)
+  {
+    if (!is_target_operand(term, i))
+      continue;
+    IRBasicBlock *succ = operand_block(term, i);
+    bool first = true;
+    for (size_t j = 0; j < i; j++)
+    {
+      if (is_target_operand(term, j) && operand_block(term, j) == succ)
+        first = false;
+    }
+    if (first && succ != target)
+      remove_phi_entries(succ, bb);
+  }
+  replace_with_br(builder, bb, target);
+  return true;
+}
+
+/**
+ * @brief 删除从入口不可达的块
+ */
+static bool
+remove_unreachable(IRFunction *func, Bump *arena)
+{
+  size_t num_blocks = 0;
+  IDList *iter, *next;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    num_blocks++;
+  }
+
+  PtrHashMap *reachable = ptr_hashmap_create(arena, num_blocks);
+  IRBasicBlock **stack = BUMP_ALLOC_SLICE(arena, IRBasicBlock *, num_blocks);
+  if (!reachable || !stack)
+    return false;
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  size_t top = 0;
+  stack[top++] = entry;
+  ptr_hashmap_put(reachable, entry, entry);
+  while (top > 0)
+  {
+    IRInstruction *term = get_terminator(stack[--top]);
+    if (!term)
+      continue;
+    for (size_t i = 0; i < term->num_operands; i++)
+    {
+      if (!is_target_operand(term, i))
+        continue;
+      IRBasicBlock *succ = operand_block(term, i);
+      if (!ptr_hashmap_contains(reachable, succ))
+      {
+        ptr_hashmap_put(reachable, succ, succ);
+        stack[top++] = succ;
+      }
+    }
+  }
+
+  /// 先删掉不可达块中引用其他块的指令 (终结指令和 phi) 以及可达块的 phi 中来自它们的入边，再删除块本身
+  bool changed = false;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    if (ptr_hashmap_contains(reachable, bb))
+      continue;
+    IRInstruction *term = get_terminator(bb);
+    for (size_t i = 0; term && i < term->num_operands; i++)
+    {
+      if (is_target_operand(term, i) && ptr_hashmap_contains(reachable, operand_block(term, i)))
+        remove_phi_entries(operand_block(term, i), bb);
+    }
+    IDList *inst_iter, *inst_next;
+    list_for_each_safe(&bb->instructions, inst_iter, inst_next)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_PHI || is_terminator(inst))
+        ir_instruction_erase_from_parent(inst);
+    }
+    changed = true;
+  }
+  list_for_each_safe(&func->basic_blocks, iter, next)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    if (!ptr_hashmap_contains(reachable, bb))
+      ir_basic_block_erase_from_parent(bb);
+  }
+  return changed;
+}
+
+/**
+ * @brief bb 只有一个前驱、而且前驱只跳到 bb 时把 bb 并入前驱
+ */
+static bool
+merge_into_predecessor(IRBasicBlock *bb)
+{
+  IRInstruction *pred_term;
+  if (collect_predecessors(bb, NULL) != 1)
+    return false;
+  collect_predecessors(bb, &pred_term);
+  IRBasicBlock *pred = pred_term->parent;
+  IRInstruction *term = get_terminator(bb);
+  /// bb 跳回 pred 时合并会形成自环，不合并
+  if (pred == bb || pred_term->opcode != IR_OP_BR || !term || branches_to(bb, pred))
+    return false;
+
+  /// phi 只有来自 pred 的一条入边，直接换成入边的值
+  IDList *iter, *next;
+  list_for_each_safe(&bb->instructions, iter, next)
+  {
+    IRInstruction *phi = list_entry(iter, IRInstruction, list_node);
+    if (phi->opcode != IR_OP_PHI)
+      break;
+    ir_value_replace_all_uses_with(&phi->result, ir_instruction_get_operand(phi, 0));
+    ir_instruction_erase_from_parent(phi);
+  }
+
+  ir_instruction_erase_from_parent(pred_term);
+  list_for_each_safe(&bb->instructions, iter, next)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    list_del(&inst->list_node);
+    list_add_tail(&pred->instructions, &inst->list_node);
+    inst->parent = pred;
+  }
+  pred->order_valid = false;
+
+  /// 剩下的 Use 只有 bb 的后继中的 phi
+  ir_value_replace_all_uses_with(&bb->label_address, &pred->label_address);
+  ir_basic_block_erase_from_parent(bb);
+  return true;
+}
+
+/**
+ * @brief 只含 "br target" 的块: 前驱直接跳到 target
+ */
+static bool
+thread_empty_block(IRBasicBlock *bb, Bump *arena)
+{
+  if (bb->instructions.next != bb->instructions.prev)
+    return false;
+  IRInstruction *term = get_terminator(bb);
+  if (!term || term->opcode != IR_OP_BR)
+    return false;
+  IRBasicBlock *target = operand_block(term, 0);
+  if (target == bb)
+    return false;
+
+  size_t n = collect_predecessors(bb, NULL);
+  IRInstruction **pred_terms = BUMP_ALLOC_SLICE(arena, IRInstruction *, n + 1);
+  if (!pred_terms || n == 0)
+    return false;
+  collect_predecessors(bb, pred_terms);
+
+  bool changed = false;
+  bool all_threaded = true;
+  for (size_t p = 0; p < n; p++)
+  {
+    IRBasicBlock *pred = pred_terms[p]->parent;
+    /// pred 本身就是 target 时会形成自环；pred 已经跳到 target 时两条路径的 phi 值必须相同
+    bool already = branches_to(pred, target);
+    bool ok = pred != target;
+    IDList *phi_iter;
+    list_for_each(&target->instructions, phi_iter)
+    {
+      IRInstruction *phi = list_entry(phi_iter, IRInstruction, list_node);
+      if (phi->opcode != IR_OP_PHI || !ok)
+        break;
+      if (already && phi_incoming_for(phi, pred) != phi_incoming_for(phi, bb))
+        ok = false;
+    }
+    if (!ok)
+    {
+      all_threaded = false;
+      continue;
+    }
+
+    list_for_each(&target->instructions, phi_iter)
+    {
+      IRInstruction *phi = list_entry(phi_iter, IRInstruction, list_node);
+      if (phi->opcode != IR_OP_PHI)
+        break;
+      if (!already)
+        ir_phi_add_incoming(&phi->result, phi_incoming_for(phi, bb), pred);
+    }
+    for (size_t i = 0; i < pred_terms[p]->num_operands; i++)
+    {
+      if (is_target_operand(pred_terms[p], i) && operand_block(pred_terms[p], i) == bb)
+        ir_use_set_value(&pred_terms[p]->operands[i], &target->label_address);
+    }
+    changed = true;
+  }
+
+  if (all_threaded)
+  {
+    remove_phi_entries(target, bb);
+    ir_basic_block_erase_from_parent(bb);
+  }
+  return changed;
+}
+
+/*
+ * =================================================================
+ * --- 公共 API ---
+ * =================================================================
+ */
+
+bool
+ir_transform_simplify_cfg_run(IRFunction *func)
+{
+  if (!func || list_empty(&func->basic_blocks))
+    return false;
+
+  IRBuilder *builder = ir_builder_create(func->parent->context);
+  Bump scratch;
+  bump_init(&scratch);
+  bool changed = false;
+  bool progress = true;
+  while (progress)
+  {
+    progress = false;
+    IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+    IDList *iter, *next;
+    list_for_each(&func->basic_blocks, iter)
+    {
+      if (fold_branch(builder, list_entry(iter, IRBasicBlock, list_node)))
+        progress = true;
+    }
+    if (remove_unreachable(func, &scratch))
+      progress = true;
+    list_for_each_safe(&func->basic_blocks, iter, next)
+    {
+      IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+      if (bb != entry && (merge_into_predecessor(bb) || thread_empty_block(bb, &scratch)))
+        progress = true;
+    }
+    bump_reset(&scratch);
+    changed = changed || progress;
+  }
+  bump_destroy(&scratch);
+  ir_builder_destroy(builder);
+  return changed;
+}
+
+bool
+ir_transform_simplify_cfg_run_with_analyses(IRFunction *func, IRAnalysisManager *am)
+{
+  bool changed = ir_transform_simplify_cfg_run(func);
+  if (changed)
+    ir_analysis_invalidate(am, func, IR_PRESERVE_NONE);
+  return changed;
+}
@@ -15,10 +15,15 @@
  */
 
 #include "utils/bitset.h"
+#include "utils/cpu_features.h"
 #include <assert.h>
 #include <stddef.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
 #define BITSET_NUM_WORDS(num_bits) (((num_bits) + 63) / 64)
 
 #define BITSET_WORD_INDEX(bit) ((bit) / 64)
@@ -27,6 +32,146 @@
 
 #define BITSET_WORD_MASK(bit) ((uint64_t)1 << BITSET_BIT_INDEX(bit))
 
+#if defined(__GNUC__)
+#define BITSET_POPCOUNT64(word) __builtin_popcountll(word)
+#define BITSET_CTZ64(word) ((size_t)__builtin_ctzll(word))
+#else
+static inline int
+bitset_popcount64_portable(uint64_t word)
+{
+  word = word - ((word >> 1) & 0x5555555555555555ull);
+  word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return (int)((word * 0x0101010101010101ull) >> 56);
+}
+#define BITSET_POPCOUNT64(word) bitset_popcount64_portable(word)
+/// word & -word 只留下最低的 1，它的下标就是 ctz
+#define BITSET_CTZ64(word) ((size_t)bitset_popcount64_portable(((word) & (0 - (word))) - 1))
+#endif
+
+/** @brief 最后一个字中有效位的掩码 */
+static inline uint64_t
+bitset_tail_mask(size_t num_bits)
+{
+  size_t remaining_bits = num_bits % 64;
+  return remaining_bits == 0 ? (uint64_t)-1 : ((uint64_t)1 << remaining_bits) - 1;
+}
+
+/*
+ * --- 按字批量运算的各指令集实现 ---
+ *
+ * 同一份函数体 (bitset_kernels.inc) 按不同的 target 属性编译多次，运行时按 cpu_features() 选用。
+ * 数据流分析里的大多数集合只有几个字，间接调用不划算: 字数少于 BITSET_DISPATCH_MIN_WORDS 时
+ * 直接调用 (内联的) 基线实现。
+ */
+
+#define BITSET_DISPATCH_MIN_WORDS 16
+
+/// 基线实现: 按编译器的默认指令集向量化 (x86-64 为 SSE2，AArch64 为 NEON)
+#define BITSET_KERNEL_NAME(name) bitset_##name##_generic
+#define BITSET_KERNEL_TARGET
+#include "bitset_kernels.inc"
+#undef BITSET_KERNEL_NAME
+#undef BITSET_KERNEL_TARGET
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITSET_KERNELS_X86 1
+
+/// 基线 x86-64 没有 popcnt 指令；支持 AVX2 的 CPU 都有
+#define BITSET_KERNEL_NAME(name) bitset_##name##_avx2
+#define BITSET_KERNEL_TARGET __attribute__((target("avx2,popcnt")))
+#include "bitset_kernels.inc"
+#undef BITSET_KERNEL_NAME
+#undef BITSET_KERNEL_TARGET
+
+#define BITSET_KERNEL_NAME(name) bitset_##name##_avx512
+#define BITSET_KERNEL_TARGET __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,popcnt")))
+#include "bitset_kernels.inc"
+#undef BITSET_KERNEL_NAME
+#undef BITSET_KERNEL_TARGET
+#endif
+
+/** @brief 同一指令集的一组按字运算 */
+typedef struct BitsetKernelTable
+{
+  bool (*and_words)(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words);
+  bool (*or_words)(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words);
+  bool (*andnot_words)(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words);
+  size_t (*count_words)(const uint64_t *words, size_t num_words);
+} BitsetKernelTable;
+
+#define BITSET_KERNEL_TABLE(suffix)                                                                                    \
+  {                                                                                                                    \
+    .and_words = bitset_and_##suffix,                                                                                  \
+    .or_words = bitset_or_##suffix,                                                                                    \
+    .andnot_words = bitset_andnot_##suffix,                                                                            \
+    .count_words = bitset_count_##suffix,                                                                              \
+  }
+
+static const BitsetKernelTable GENERIC_KERNELS = BITSET_KERNEL_TABLE(generic);
+#ifdef BITSET_KERNELS_X86
+static const BitsetKernelTable AVX2_KERNELS = BITSET_KERNEL_TABLE(avx2);
+static const BitsetKernelTable AVX512_KERNELS = BITSET_KERNEL_TABLE(avx512);
+#endif
+
+#if !defined(__STDC_NO_ATOMICS__)
+static _Atomic(const BitsetKernelTable *) SELECTED_KERNELS = NULL;
+#else
+static const BitsetKernelTable *SELECTED_KERNELS = NULL;
+#endif
+
+static const BitsetKernelTable *
+bitset_kernels(void)
+{
+  /// 第一次调用时选定；并发的第一次调用会选出同一张表
+  const BitsetKernelTable *table = SELECTED_KERNELS;
+  if (!table)
+  {
+    table = &GENERIC_KERNELS;
+#ifdef BITSET_KERNELS_X86
+    CpuFeatures features = cpu_features();
+    if (features & CPU_FEATURE_AVX512)
+      table = &AVX512_KERNELS;
+    else if (features & CPU_FEATURE_AVX2)
+      table = &AVX2_KERNELS;
+#endif
+    SELECTED_KERNELS = table;
+  }
+  return table;
+}
+
+static inline bool
+bitset_and_words(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words)
+{
+  if (num_words < BITSET_DISPATCH_MIN_WORDS)
+    return bitset_and_generic(dst, a, b, num_words);
+  return bitset_kernels()->and_words(dst, a, b, num_words);
+}
+
+static inline bool
+bitset_or_words(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words)
+{
+  if (num_words < BITSET_DISPATCH_MIN_WORDS)
+    return bitset_or_generic(dst, a, b, num_words);
+  return bitset_kernels()->or_words(dst, a, b, num_words);
+}
+
+static inline bool
+bitset_andnot_words(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t num_words)
+{
+  if (num_words < BITSET_DISPATCH_MIN_WORDS)
+    return bitset_andnot_generic(dst, a, b, num_words);
+  return bitset_kernels()->andnot_words(dst, a, b, num_words);
+}
+
+static inline size_t
+bitset_count_words(const uint64_t *words, size_t num_words)
+{
+  if (num_words < BITSET_DISPATCH_MIN_WORDS)
+    return bitset_count_generic(words, num_words);
+  return bitset_kernels()->count_words(words, num_words);
+}
+
 Bitset *
 bitset_create(size_t num_bits, Bump *arena)
 {
@@ -153,30 +298,53 @@ void
 bitset_intersect(Bitset *dest, const Bitset *src1, const Bitset *src2)
 {
   assert(dest->num_bits == src1->num_bits && src1->num_bits == src2->num_bits && "Bitset op size mismatch");
-  for (size_t i = 0; i < dest->num_words; i++)
-  {
-    dest->words[i] = src1->words[i] & src2->words[i];
-  }
+  bitset_and_words(dest->words, src1->words, src2->words, dest->num_words);
 }
 
 void
 bitset_union(Bitset *dest, const Bitset *src1, const Bitset *src2)
 {
   assert(dest->num_bits == src1->num_bits && src1->num_bits == src2->num_bits && "Bitset op size mismatch");
-  for (size_t i = 0; i < dest->num_words; i++)
-  {
-    dest->words[i] = src1->words[i] | src2->words[i];
-  }
+  bitset_or_words(dest->words, src1->words, src2->words, dest->num_words);
 }
 
 void
 bitset_difference(Bitset *dest, const Bitset *src1, const Bitset *src2)
 {
   assert(dest->num_bits == src1->num_bits && src1->num_bits == src2->num_bits && "Bitset op size mismatch");
-  for (size_t i = 0; i < dest->num_words; i++)
-  {
-    dest->words[i] = src1->words[i] & (~src2->words[i]);
-  }
+  bitset_andnot_words(dest->words, src1->words, src2->words, dest->num_words);
+}
+
+bool
+bitset_union_with(Bitset *dest, const Bitset *src)
+{
+  assert(dest->num_bits == src->num_bits && "Bitset op size mismatch");
+  return bitset_or_words(dest->words, dest->words, src->words, dest->num_words);
+}
+
+bool
+bitset_intersect_with(Bitset *dest, const Bitset *src)
+{
+  assert(dest->num_bits == src->num_bits && "Bitset op size mismatch");
+  return bitset_and_words(dest->words, dest->words, src->words, dest->num_words);
+}
+
+bool
+bitset_difference_with(Bitset *dest, const Bitset *src)
+{
+  assert(dest->num_bits == src->num_bits && "Bitset op size mismatch");
+  return bitset_andnot_words(dest->words, dest->words, src->words, dest->num_words);
+}
+
+size_t
+bitset_count(const Bitset *bs)
+{
+  if (bs->num_words == 0)
+    return 0;
+  /// 最后一个字只数有效位 (与 bitset_count_slow 一致)
+  size_t last = bs->num_words - 1;
+  return bitset_count_words(bs->words, last) +
+         (size_t)BITSET_POPCOUNT64(bs->words[last] & bitset_tail_mask(bs->num_bits));
 }
 
 size_t
@@ -211,4 +379,293 @@ bitset_count_slow(const Bitset *bs)
   }
 
   return count;
-}
\ No newline at end of file
+}
+
+/** @brief 从第 word_index 个字 (已去掉 from 之前的位) 开始找第一个 1 */
+static size_t
+bitset_scan_words(const uint64_t *words, size_t num_words, size_t num_bits, size_t word_index, uint64_t word)
+{
+  for (;;)
+  {
+    if (word_index == num_words - 1)
+      word &= bitset_tail_mask(num_bits);
+    if (word != 0)
+      return word_index * 64 + BITSET_CTZ64(word);
+    if (++word_index == num_words)
+      return num_bits;
+    word = words[word_index];
+  }
+}
+
+size_t
+bitset_find_next(const Bitset *bs, size_t from)
+{
+  if (from >= bs->num_bits)
+    return bs->num_bits;
+  size_t word_index = BITSET_WORD_INDEX(from);
+  uint64_t word = bs->words[word_index] & ((uint64_t)-1 << BITSET_BIT_INDEX(from));
+  return bitset_scan_words(bs->words, bs->num_words, bs->num_bits, word_index, word);
+}
+
+/*
+ * =================================================================
+ * --- 稀疏 / 稠密混合位集 ---
+ * =================================================================
+ */
+
+SparseBitset *
+sparse_bitset_create(size_t num_bits, Bump *arena)
+{
+  SparseBitset *sbs = BUMP_ALLOC_ZEROED(arena, SparseBitset);
+  sbs->num_bits = num_bits;
+  sbs->arena = arena;
+  if (BITSET_NUM_WORDS(num_bits) <= SPARSE_BITSET_MIN_SPARSE_WORDS)
+    sbs->dense = bitset_create(num_bits, arena);
+  return sbs;
+}
+
+bool
+sparse_bitset_is_dense(const SparseBitset *sbs)
+{
+  return sbs->dense != NULL;
+}
+
+/**
+ * @brief 二分查找字下标 id
+ *
+ * @return 找到时为它的位置；否则为应当插入的位置
+ */
+static size_t
+sparse_lower_bound(const SparseBitset *sbs, size_t id)
+{
+  size_t lo = 0;
+  size_t hi = sbs->num_words;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (sbs->word_ids[mid] < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/** @brief 转换为稠密形式 (稀疏数组留在 Arena 中，不再使用) */
+static void
+sparse_densify(SparseBitset *sbs)
+{
+  Bitset *dense = bitset_create(sbs->num_bits, sbs->arena);
+  for (size_t i = 0; i < sbs->num_words; i++)
+    dense->words[sbs->word_ids[i]] = sbs->words[i];
+  sbs->dense = dense;
+  sbs->num_words = 0;
+}
+
+/** @brief 稀疏形式还划算吗 (非 0 字的比例不超过 1 / SPARSE_BITSET_DENSE_RATIO) */
+static bool
+sparse_fits(const SparseBitset *sbs, size_t num_sparse_words)
+{
+  return num_sparse_words * SPARSE_BITSET_DENSE_RATIO <= BITSET_NUM_WORDS(sbs->num_bits);
+}
+
+/** @brief 保证稀疏数组至少能放 needed 个字 (容量翻倍；旧数组留在 Arena 中) */
+static void
+sparse_reserve(SparseBitset *sbs, size_t needed)
+{
+  if (needed <= sbs->capacity)
+    return;
+  size_t capacity = sbs->capacity ? sbs->capacity * 2 : 4;
+  while (capacity < needed)
+    capacity *= 2;
+  size_t *ids = BUMP_ALLOC_SLICE(sbs->arena, size_t, capacity);
+  uint64_t *words = BUMP_ALLOC_SLICE(sbs->arena, uint64_t, capacity);
+  if (sbs->num_words > 0)
+  {
+    memcpy(ids, sbs->word_ids, sbs->num_words * sizeof(size_t));
+    memcpy(words, sbs->words, sbs->num_words * sizeof(uint64_t));
+  }
+  sbs->word_ids = ids;
+  sbs->words = words;
+  sbs->capacity = capacity;
+}
+
+void
+sparse_bitset_set(SparseBitset *sbs, size_t bit)
+{
+  assert(bit < sbs->num_bits && "Bitset index out of bounds");
+  if (sbs->dense)
+  {
+    bitset_set(sbs->dense, bit);
+    return;
+  }
+
+  size_t id = BITSET_WORD_INDEX(bit);
+  size_t pos = sparse_lower_bound(sbs, id);
+  if (pos < sbs->num_words && sbs->word_ids[pos] == id)
+  {
+    sbs->words[pos] |= BITSET_WORD_MASK(bit);
+    return;
+  }
+
+  if (!sparse_fits(sbs, sbs->num_words + 1))
+  {
+    sparse_densify(sbs);
+    bitset_set(sbs->dense, bit);
+    return;
+  }
+  sparse_reserve(sbs, sbs->num_words + 1);
+  size_t tail = sbs->num_words - pos;
+  memmove(sbs->word_ids + pos + 1, sbs->word_ids + pos, tail * sizeof(size_t));
+  memmove(sbs->words + pos + 1, sbs->words + pos, tail * sizeof(uint64_t));
+  sbs->word_ids[pos] = id;
+  sbs->words[pos] = BITSET_WORD_MASK(bit);
+  sbs->num_words++;
+}
+
+void
+sparse_bitset_clear(SparseBitset *sbs, size_t bit)
+{
+  assert(bit < sbs->num_bits && "Bitset index out of bounds");
+  if (sbs->dense)
+  {
+    bitset_clear(sbs->dense, bit);
+    return;
+  }
+
+  size_t id = BITSET_WORD_INDEX(bit);
+  size_t pos = sparse_lower_bound(sbs, id);
+  if (pos == sbs->num_words || sbs->word_ids[pos] != id)
+    return;
+  sbs->words[pos] &= ~BITSET_WORD_MASK(bit);
+  /// 稀疏数组只保存非 0 的字
+  if (sbs->words[pos] == 0)
+  {
+    size_t tail = sbs->num_words - pos - 1;
+    memmove(sbs->word_ids + pos, sbs->word_ids + pos + 1, tail * sizeof(size_t));
+    memmove(sbs->words + pos, sbs->words + pos + 1, tail * sizeof(uint64_t));
+    sbs->num_words--;
+  }
+}
+
+bool
+sparse_bitset_test(const SparseBitset *sbs, size_t bit)
+{
+  assert(bit < sbs->num_bits && "Bitset index out of bounds");
+  if (sbs->dense)
+    return bitset_test(sbs->dense, bit);
+  size_t id = BITSET_WORD_INDEX(bit);
+  size_t pos = sparse_lower_bound(sbs, id);
+  return pos < sbs->num_words && sbs->word_ids[pos] == id && (sbs->words[pos] & BITSET_WORD_MASK(bit)) != 0;
+}
+
+size_t
+sparse_bitset_count(const SparseBitset *sbs)
+{
+  if (sbs->dense)
+    return bitset_count(sbs->dense);
+  return bitset_count_words(sbs->words, sbs->num_words);
+}
+
+bool
+sparse_bitset_union_with(SparseBitset *dest, const SparseBitset *src)
+{
+  assert(dest->num_bits == src->num_bits && "Bitset op size mismatch");
+  if (!dest->dense && src->dense)
+    sparse_densify(dest);
+
+  if (dest->dense)
+  {
+    if (src->dense)
+      return bitset_union_with(dest->dense, src->dense);
+    uint64_t changed = 0;
+    for (size_t i = 0; i < src->num_words; i++)
+    {
+      uint64_t *word = &dest->dense->words[src->word_ids[i]];
+      changed |= src->words[i] & ~*word;
+      *word |= src->words[i];
+    }
+    return changed != 0;
+  }
+
+  /// 两边都稀疏: 先数出并集的字数，决定结果用哪种形式
+  size_t merged = 0;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < dest->num_words || j < src->num_words)
+  {
+    if (j == src->num_words || (i < dest->num_words && dest->word_ids[i] < src->word_ids[j]))
+      i++;
+    else if (i == dest->num_words || src->word_ids[j] < dest->word_ids[i])
+      j++;
+    else
+      i++, j++;
+    merged++;
+  }
+  if (!sparse_fits(dest, merged))
+  {
+    sparse_densify(dest);
+    return sparse_bitset_union_with(dest, src);
+  }
+
+  /// 从后往前原地归并 (与有序数组的归并相同)，同时记录是否有新的位
+  sparse_reserve(dest, merged);
+  uint64_t changed = 0;
+  size_t out = merged;
+  i = dest->num_words;
+  j = src->num_words;
+  while (j > 0)
+  {
+    out--;
+    if (i > 0 && dest->word_ids[i - 1] > src->word_ids[j - 1])
+    {
+      i--;
+      dest->word_ids[out] = dest->word_ids[i];
+      dest->words[out] = dest->words[i];
+    }
+    else if (i > 0 && dest->word_ids[i - 1] == src->word_ids[j - 1])
+    {
+      i--;
+      j--;
+      changed |= src->words[j] & ~dest->words[i];
+      dest->word_ids[out] = dest->word_ids[i];
+      dest->words[out] = dest->words[i] | src->words[j];
+    }
+    else
+    {
+      j--;
+      changed |= src->words[j];
+      dest->word_ids[out] = src->word_ids[j];
+      dest->words[out] = src->words[j];
+    }
+  }
+  dest->num_words = merged;
+  return changed != 0;
+}
+
+size_t
+sparse_bitset_find_next(const SparseBitset *sbs, size_t from)
+{
+  if (sbs->dense)
+    return bitset_find_next(sbs->dense, from);
+  if (from >= sbs->num_bits)
+    return sbs->num_bits;
+
+  size_t id = BITSET_WORD_INDEX(from);
+  size_t pos = sparse_lower_bound(sbs, id);
+  if (pos == sbs->num_words)
+    return sbs->num_bits;
+  uint64_t word = sbs->words[pos];
+  if (sbs->word_ids[pos] == id)
+  {
+    word &= (uint64_t)-1 << BITSET_BIT_INDEX(from);
+    if (word == 0)
+    {
+      /// 下一个非 0 字一定有 1
+      if (++pos == sbs->num_words)
+        return sbs->num_bits;
+      word = sbs->words[pos];
+    }
+  }
+  return sbs->word_ids[pos] * 64 + BITSET_CTZ64(word);
+}
@@ -28,6 +28,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+#if !defined(__STDC_NO_THREADS__)
+#include <stdatomic.h>
+#endif
+
 /*
  * --- 用于调试的宏 ---
  */
@@ -138,6 +145,203 @@ chunk_is_empty(ChunkFooter *footer)
   return footer == get_empty_chunk();
 }
 
+/*
+ * --- Chunk 的来源: 系统分配器、mmap 与进程级缓存 ---
+ *
+ * 释放的 Chunk (bump_destroy / bump_reset / bump_rewind) 先放进进程级缓存，
+ * 新建 Chunk 时优先复用，省掉反复的 malloc/free 和重新触碰页面的缺页。
+ * 缓存按 chunk_size 的 log2 分桶 (同一桶内大小相差不到两倍)，总量超过上限时直接还给系统。
+ */
+
+#define CHUNK_CACHE_BUCKETS (sizeof(size_t) * 8)
+
+/// AddressSanitizer 下默认不缓存，否则它查不出 Arena 销毁之后的误用
+#if defined(__SANITIZE_ADDRESS__)
+#define DEFAULT_CHUNK_CACHE_LIMIT 0
+#else
+#define DEFAULT_CHUNK_CACHE_LIMIT ((size_t)64 << 20)
+#endif
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+typedef struct ChunkCache
+{
+  /// 每个桶是一个经由 footer->prev 串起来的链表
+  ChunkFooter *buckets[CHUNK_CACHE_BUCKETS];
+  size_t cached_bytes;
+  size_t limit;
+} ChunkCache;
+
+static ChunkCache CHUNK_CACHE = {.limit = DEFAULT_CHUNK_CACHE_LIMIT};
+
+/// 0 表示不用 mmap + 大页；并行的 Arena 会同时新建 Chunk，所以和缓存一样只在 CHUNK_CACHE_LOCK 下读写
+static size_t HUGE_PAGE_THRESHOLD = 0;
+
+#if !defined(__STDC_NO_THREADS__)
+static atomic_flag CHUNK_CACHE_LOCK = ATOMIC_FLAG_INIT;
+
+static void
+chunk_cache_lock(void)
+{
+  while (atomic_flag_test_and_set_explicit(&CHUNK_CACHE_LOCK, memory_order_acquire))
+  {
+  }
+}
+
+static void
+chunk_cache_unlock(void)
+{
+  atomic_flag_clear_explicit(&CHUNK_CACHE_LOCK, memory_order_release);
+}
+#else
+static void
+chunk_cache_lock(void)
+{
+}
+
+static void
+chunk_cache_unlock(void)
+{
+}
+#endif
+
+static size_t
+log2_floor(size_t n)
+{
+  return sizeof(size_t) * 8 - 1 - (size_t)__builtin_clzll((unsigned long long)n);
+}
+
+/**
+ * @brief 向系统要一块 Chunk 内存
+ *
+ * 不小于 HUGE_PAGE_THRESHOLD 的 Chunk 用匿名 mmap 分配 (大小向上取整到 2 MiB)，
+ * 并建议内核用透明大页，减少超大 Arena 的缺页和 TLB 未命中。
+ * @param size [in,out] 请求的大小；mmap 时改成实际映射的大小
+ */
+static unsigned char *
+system_alloc_chunk(size_t *size, size_t align, bool *mapped)
+{
+  *mapped = false;
+#if !defined(_WIN32)
+  chunk_cache_lock();
+  size_t threshold = HUGE_PAGE_THRESHOLD;
+  chunk_cache_unlock();
+  if (threshold != 0 && *size >= threshold && align <= HUGE_PAGE_SIZE)
+  {
+    size_t length = round_up_to(*size, HUGE_PAGE_SIZE);
+    if (length >= *size)
+    {
+      void *data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (data != MAP_FAILED)
+      {
+#if defined(MADV_HUGEPAGE)
+        madvise(data, length, MADV_HUGEPAGE);
+#endif
+        *size = length;
+        *mapped = true;
+        return (unsigned char *)data;
+      }
+    }
+  }
+#endif
+  return (unsigned char *)aligned_malloc_internal(align, *size);
+}
+
+static void
+system_free_chunk(ChunkFooter *footer)
+{
+#if !defined(_WIN32)
+  if (footer->mapped)
+  {
+    munmap(footer->data, footer->chunk_size);
+    return;
+  }
+#endif
+  aligned_free_internal(footer->data);
+}
+
+/**
+ * @brief 从缓存里取一个能装下 size 字节、按 align 对齐的 Chunk
+ *
+ * 只接受不超过 2 * size 的 Chunk，免得一个小 Arena 占住一大块缓存。
+ */
+static ChunkFooter *
+chunk_cache_take(size_t size, size_t align)
+{
+  size_t bucket = log2_floor(size);
+  ChunkFooter *found = NULL;
+  chunk_cache_lock();
+  for (size_t b = bucket; b <= bucket + 1 && b < CHUNK_CACHE_BUCKETS && !found; b++)
+  {
+    for (ChunkFooter **link = &CHUNK_CACHE.buckets[b]; *link; link = &(*link)->prev)
+    {
+      ChunkFooter *chunk = *link;
+      if (chunk->chunk_size >= size && chunk->chunk_size / 2 <= size && (uintptr_t)chunk->data % align == 0)
+      {
+        *link = chunk->prev;
+        CHUNK_CACHE.cached_bytes -= chunk->chunk_size;
+        found = chunk;
+        break;
+      }
+    }
+  }
+  chunk_cache_unlock();
+  return found;
+}
+
+/// 已经超过上限的部分从缓存里摘下来，由调用者在锁外释放
+static ChunkFooter *
+chunk_cache_evict_locked(void)
+{
+  ChunkFooter *evicted = NULL;
+  for (size_t b = CHUNK_CACHE_BUCKETS; b-- > 0 && CHUNK_CACHE.cached_bytes > CHUNK_CACHE.limit;)
+  {
+    while (CHUNK_CACHE.buckets[b] && CHUNK_CACHE.cached_bytes > CHUNK_CACHE.limit)
+    {
+      ChunkFooter *chunk = CHUNK_CACHE.buckets[b];
+      CHUNK_CACHE.buckets[b] = chunk->prev;
+      CHUNK_CACHE.cached_bytes -= chunk->chunk_size;
+      chunk->prev = evicted;
+      evicted = chunk;
+    }
+  }
+  return evicted;
+}
+
+static void
+free_evicted_chunks(ChunkFooter *evicted)
+{
+  while (evicted)
+  {
+    ChunkFooter *next = evicted->prev;
+    system_free_chunk(evicted);
+    evicted = next;
+  }
+}
+
+/**
+ * @brief 释放一个 Chunk: 放得进缓存就缓存，否则还给系统
+ */
+static void
+release_chunk(ChunkFooter *footer)
+{
+  size_t size = footer->chunk_size;
+  bool cached = false;
+  chunk_cache_lock();
+  /// 单个 Chunk 最多占上限的四分之一，避免一个巨型 Chunk 挤掉其余所有缓存
+  if (size <= CHUNK_CACHE.limit / 4 && CHUNK_CACHE.cached_bytes + size <= CHUNK_CACHE.limit)
+  {
+    size_t bucket = log2_floor(size);
+    footer->prev = CHUNK_CACHE.buckets[bucket];
+    CHUNK_CACHE.buckets[bucket] = footer;
+    CHUNK_CACHE.cached_bytes += size;
+    cached = true;
+  }
+  chunk_cache_unlock();
+  if (!cached)
+    system_free_chunk(footer);
+}
+
 /*
  * --- 内部 Chunk 管理 ---
  */
@@ -149,11 +353,16 @@ dealloc_chunk_list(ChunkFooter *footer)
   {
     ChunkFooter *prev = footer->prev;
 
-    aligned_free_internal(footer->data);
+    release_chunk(footer);
     footer = prev;
   }
 }
 
+/**
+ * @brief 新建一个 Chunk (Footer 总在 Chunk 的末尾，复用的 Chunk 可能比请求的大)
+ *
+ * 有分配上限的 Arena 不用缓存，免得拿到的大 Chunk 越过上限。
+ */
 static ChunkFooter *
 new_chunk(Bump *bump, size_t new_size_without_footer, size_t align, ChunkFooter *prev)
 {
@@ -170,17 +379,31 @@ new_chunk(Bump *bump, size_t new_size_without_footer, size_t align, ChunkFooter
   if (alloc_size == 0)
     return NULL;
 
-  unsigned char *data = (unsigned char *)aligned_malloc_internal(align, alloc_size);
-  if (!data)
-    return NULL;
+  unsigned char *data;
+  bool mapped;
+  ChunkFooter *cached = bump->allocation_limit == SIZE_MAX ? chunk_cache_take(alloc_size, align) : NULL;
+  if (cached)
+  {
+    data = cached->data;
+    alloc_size = cached->chunk_size;
+    mapped = cached->mapped;
+  }
+  else
+  {
+    data = system_alloc_chunk(&alloc_size, align, &mapped);
+    if (!data)
+      return NULL;
+  }
 
-  ChunkFooter *footer_ptr = (ChunkFooter *)(data + new_size_without_footer);
+  size_t usable_size = alloc_size - FOOTER_SIZE;
+  ChunkFooter *footer_ptr = (ChunkFooter *)(data + usable_size);
 
   footer_ptr->data = data;
   footer_ptr->chunk_size = alloc_size;
   footer_ptr->prev = prev;
+  footer_ptr->mapped = mapped;
 
-  footer_ptr->allocated_bytes = prev->allocated_bytes + new_size_without_footer;
+  footer_ptr->allocated_bytes = prev->allocated_bytes + usable_size;
 
   uintptr_t ptr_start = (uintptr_t)footer_ptr;
   footer_ptr->ptr = (unsigned char *)round_down_to(ptr_start, bump->min_align);
@@ -435,6 +658,146 @@ bump_reset(Bump *bump)
   current_footer->allocated_bytes = usable_size;
 }
 
+BumpMark
+bump_mark(Bump *bump)
+{
+  BumpMark mark = {bump->current_chunk_footer, bump->current_chunk_footer->ptr};
+  return mark;
+}
+
+void
+bump_rewind(Bump *bump, BumpMark mark)
+{
+  ChunkFooter *footer = bump->current_chunk_footer;
+  while (footer != mark.chunk)
+  {
+    assert(!chunk_is_empty(footer) && "BumpMark does not belong to this arena");
+    ChunkFooter *prev = footer->prev;
+    release_chunk(footer);
+    footer = prev;
+  }
+
+  bump->current_chunk_footer = footer;
+  if (!chunk_is_empty(footer))
+  {
+    footer->ptr = mark.ptr;
+  }
+}
+
+void
+bump_adopt(Bump *dst, Bump *src)
+{
+  ChunkFooter *newest = src->current_chunk_footer;
+  if (chunk_is_empty(newest))
+    return;
+
+  ChunkFooter *oldest = newest;
+  while (!chunk_is_empty(oldest->prev))
+    oldest = oldest->prev;
+
+  ChunkFooter *current = dst->current_chunk_footer;
+  if (chunk_is_empty(current))
+  {
+    dst->current_chunk_footer = newest;
+  }
+  else
+  {
+    /// 插到 dst 当前 Chunk 之后 (更旧的位置)，dst 继续在当前 Chunk 上分配
+    oldest->prev = current->prev;
+    current->prev = newest;
+    current->allocated_bytes += newest->allocated_bytes;
+  }
+
+  src->current_chunk_footer = get_empty_chunk();
+}
+
+bool
+bump_group_init(BumpGroup *group, Bump *parent, size_t num_locals)
+{
+  assert(group != NULL);
+  group->parent = parent;
+  group->num_locals = 0;
+  group->locals = NULL;
+  if (num_locals == 0)
+    return true;
+
+  Bump *locals = (Bump *)malloc(num_locals * sizeof(Bump));
+  if (!locals)
+    return false;
+  size_t min_align = parent ? parent->min_align : 1;
+  for (size_t i = 0; i < num_locals; i++)
+  {
+    bump_init_with_min_align(&locals[i], min_align);
+  }
+  group->locals = locals;
+  group->num_locals = num_locals;
+  return true;
+}
+
+Bump *
+bump_group_local(BumpGroup *group, size_t index)
+{
+  assert(index < group->num_locals);
+  return &group->locals[index];
+}
+
+void
+bump_group_finish(BumpGroup *group)
+{
+  for (size_t i = 0; i < group->num_locals; i++)
+  {
+    if (group->parent)
+      bump_adopt(group->parent, &group->locals[i]);
+    bump_destroy(&group->locals[i]);
+  }
+  free(group->locals);
+  group->locals = NULL;
+  group->num_locals = 0;
+}
+
+/*
+ * --- Chunk 缓存与大页 ---
+ */
+
+void
+bump_set_chunk_cache_limit(size_t limit)
+{
+  chunk_cache_lock();
+  CHUNK_CACHE.limit = limit;
+  ChunkFooter *evicted = chunk_cache_evict_locked();
+  chunk_cache_unlock();
+  free_evicted_chunks(evicted);
+}
+
+void
+bump_trim_chunk_cache(void)
+{
+  chunk_cache_lock();
+  size_t limit = CHUNK_CACHE.limit;
+  CHUNK_CACHE.limit = 0;
+  ChunkFooter *evicted = chunk_cache_evict_locked();
+  CHUNK_CACHE.limit = limit;
+  chunk_cache_unlock();
+  free_evicted_chunks(evicted);
+}
+
+size_t
+bump_chunk_cache_bytes(void)
+{
+  chunk_cache_lock();
+  size_t bytes = CHUNK_CACHE.cached_bytes;
+  chunk_cache_unlock();
+  return bytes;
+}
+
+void
+bump_set_huge_page_threshold(size_t threshold)
+{
+  chunk_cache_lock();
+  HUGE_PAGE_THRESHOLD = threshold;
+  chunk_cache_unlock();
+}
+
 /*
  * --- 分配 API ---
  */
@@ -550,4 +913,18 @@ size_t
 bump_get_allocated_bytes(Bump *bump)
 {
   return bump->current_chunk_footer->allocated_bytes;
-}
\ No newline at end of file
+}
+
+BumpUsage
+bump_get_usage(const Bump *bump)
+{
+  BumpUsage usage = {0};
+  /// 链表以空的哨兵 Chunk 结尾 (chunk_size 为 0)
+  for (const ChunkFooter *chunk = bump->current_chunk_footer; chunk->chunk_size != 0; chunk = chunk->prev)
+  {
+    usage.num_chunks++;
+    usage.reserved_bytes += (size_t)((const unsigned char *)chunk - chunk->data);
+    usage.used_bytes += (size_t)((const unsigned char *)chunk - chunk->ptr);
+  }
+  return usage;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/cpu_features.h"
+
+#include <stdio.h>
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#endif
+
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
+/// 缓存的检测结果: 最高位表示已经检测过
+#define CPU_FEATURES_KNOWN (1u << 31)
+
+#if !defined(__STDC_NO_ATOMICS__)
+static _Atomic(CpuFeatures) CACHED_FEATURES = 0;
+static _Atomic(CpuFeatures) ALLOWED_FEATURES = ~(CpuFeatures)0;
+#define LOAD(v) atomic_load_explicit(&(v), memory_order_relaxed)
+#define STORE(v, x) atomic_store_explicit(&(v), (x), memory_order_relaxed)
+#else
+static CpuFeatures CACHED_FEATURES = 0;
+static CpuFeatures ALLOWED_FEATURES = ~(CpuFeatures)0;
+#define LOAD(v) (v)
+#define STORE(v, x) ((v) = (x))
+#endif
+
+CpuFeatures
+cpu_features_detect(void)
+{
+  CpuFeatures features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    features |= CPU_FEATURE_SSE2;
+  /// __builtin_cpu_supports 同时检查了 OS 是否启用了 YMM / ZMM 状态 (XGETBV)
+  if (__builtin_cpu_supports("avx2"))
+    features |= CPU_FEATURE_AVX2;
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512dq"))
+    features |= CPU_FEATURE_AVX512;
+#elif defined(__aarch64__)
+  /// AArch64 的 Advanced SIMD 是必备的
+  features |= CPU_FEATURE_NEON;
+#elif defined(__linux__) && defined(__arm__) && defined(HWCAP_NEON)
+  if (getauxval(AT_HWCAP) & HWCAP_NEON)
+    features |= CPU_FEATURE_NEON;
+#endif
+  return features;
+}
+
+CpuFeatures
+cpu_features(void)
+{
+  /// 多个线程同时第一次调用时各自检测一次，结果相同
+  CpuFeatures cached = LOAD(CACHED_FEATURES);
+  if (!(cached & CPU_FEATURES_KNOWN))
+  {
+    cached = (cpu_features_detect() & LOAD(ALLOWED_FEATURES)) | CPU_FEATURES_KNOWN;
+    STORE(CACHED_FEATURES, cached);
+  }
+  return cached & ~CPU_FEATURES_KNOWN;
+}
+
+void
+cpu_features_restrict(CpuFeatures allowed)
+{
+  STORE(ALLOWED_FEATURES, allowed);
+  STORE(CACHED_FEATURES, 0);
+}
+
+const char *
+cpu_features_describe(CpuFeatures features, char *buf, size_t size)
+{
+  static const struct
+  {
+    CpuFeature feature;
+    const char *name;
+  } NAMES[] = {
+    {CPU_FEATURE_SSE2, "sse2"},
+    {CPU_FEATURE_AVX2, "avx2"},
+    {CPU_FEATURE_AVX512, "avx512"},
+    {CPU_FEATURE_NEON, "neon"},
+  };
+
+  if (size == 0)
+    return buf;
+  buf[0] = '\0';
+  size_t len = 0;
+  for (size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++)
+  {
+    if (!(features & NAMES[i].feature))
+      continue;
+    int n = snprintf(buf + len, size - len, "%s%s", len ? " " : "", NAMES[i].name);
+    if (n < 0 || (size_t)n >= size - len)
+      break;
+    len += (size_t)n;
+  }
+  if (len == 0)
+    snprintf(buf, size, "scalar");
+  return buf;
+}
@@ -21,6 +21,22 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define LAYOUT_ATOMIC(T) _Atomic(T)
+#define LAYOUT_LOAD(ptr) atomic_load_explicit((ptr), memory_order_acquire)
+#define LAYOUT_STORE(ptr, value) atomic_store_explicit((ptr), (value), memory_order_release)
+#else
+#define LAYOUT_ATOMIC(T) T
+#define LAYOUT_LOAD(ptr) (*(ptr))
+#define LAYOUT_STORE(ptr, value) (*(ptr) = (value))
+#endif
+
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#endif
 
 /// 辅助宏，用于将 value 向上对齐到 align 的倍数
 /// align 必须是 2 的幂
@@ -72,6 +88,185 @@ is_primitive_type(IRTypeKind kind)
   }
 }
 
+/*
+ * =================================================================
+ * --- 聚合类型布局缓存 ---
+ * =================================================================
+ *
+ * 开放寻址的表，槽位是指向不可变条目的原子指针: 查询不加锁，只做 acquire 读；
+ * 填充在互斥锁下进行，条目写好之后才 release 发布。表满一半时换成两倍大的新表，
+ * 旧表留在 Arena 中 (可能还有读者在用)，clear / destroy 时才一起释放。
+ *
+ * 键是 (类型地址, 类型所属上下文的编号)。上下文销毁后它的地址可能被新上下文的类型复用，
+ * 编号不会复用，所以旧条目不会被命中 (它们只占空间，直到 clear / destroy)。
+ */
+
+/** @brief 一个结构体或数组类型的布局 (发布后不再修改) */
+typedef struct LayoutCacheEntry
+{
+  const IRType *type;
+  uint32_t context_id;
+  BumpLayout layout;
+  /** 结构体: 每个成员的偏移量 (member_count 个)；数组没有 */
+  size_t offsets[];
+} LayoutCacheEntry;
+
+typedef struct LayoutCacheTable
+{
+  size_t mask;
+  LAYOUT_ATOMIC(LayoutCacheEntry *) slots[];
+} LayoutCacheTable;
+
+struct DataLayoutCache
+{
+  LAYOUT_ATOMIC(LayoutCacheTable *) table;
+  /** 已发布的条目数 (只在锁内访问) */
+  size_t count;
+  /** 条目和表 (包括被换下来的旧表) */
+  Bump arena;
+#if !defined(__STDC_NO_THREADS__)
+  mtx_t mutex;
+#endif
+};
+
+#define LAYOUT_CACHE_INITIAL_SLOTS 64
+
+static size_t
+layout_cache_slot(const IRType *type, size_t mask)
+{
+  /// 类型分配在 Arena 中，低几位总是 0
+  uint64_t h = ((uint64_t)(uintptr_t)type >> 4) ^ ((uint64_t)type->context_id << 40);
+  h *= 0x9E3779B97F4A7C15ull;
+  return (size_t)(h >> 32) & mask;
+}
+
+static LayoutCacheTable *
+layout_cache_new_table(DataLayoutCache *cache, size_t num_slots)
+{
+  LayoutCacheTable *table = (LayoutCacheTable *)bump_alloc(
+      &cache->arena, sizeof(LayoutCacheTable) + num_slots * sizeof(table->slots[0]), _Alignof(LayoutCacheTable));
+  if (!table)
+    return NULL;
+  table->mask = num_slots - 1;
+  for (size_t i = 0; i < num_slots; i++)
+    LAYOUT_STORE(&table->slots[i], NULL);
+  return table;
+}
+
+static DataLayoutCache *
+layout_cache_create(void)
+{
+  DataLayoutCache *cache = (DataLayoutCache *)malloc(sizeof(DataLayoutCache));
+  if (!cache)
+    return NULL;
+  bump_init(&cache->arena);
+  cache->count = 0;
+  LayoutCacheTable *table = layout_cache_new_table(cache, LAYOUT_CACHE_INITIAL_SLOTS);
+#if !defined(__STDC_NO_THREADS__)
+  if (table && mtx_init(&cache->mutex, mtx_plain) != thrd_success)
+    table = NULL;
+#endif
+  if (!table)
+  {
+    bump_destroy(&cache->arena);
+    free(cache);
+    return NULL;
+  }
+  LAYOUT_STORE(&cache->table, table);
+  return cache;
+}
+
+static void
+layout_cache_destroy(DataLayoutCache *cache)
+{
+  if (!cache)
+    return;
+#if !defined(__STDC_NO_THREADS__)
+  mtx_destroy(&cache->mutex);
+#endif
+  bump_destroy(&cache->arena);
+  free(cache);
+}
+
+/** @brief 不加锁的查询；没有时返回 NULL */
+static const LayoutCacheEntry *
+layout_cache_find(const DataLayoutCache *cache, const IRType *type)
+{
+  const LayoutCacheTable *table = LAYOUT_LOAD(&cache->table);
+  for (size_t i = layout_cache_slot(type, table->mask);; i = (i + 1) & table->mask)
+  {
+    const LayoutCacheEntry *entry = LAYOUT_LOAD(&table->slots[i]);
+    if (!entry || (entry->type == type && entry->context_id == type->context_id))
+      return entry;
+  }
+}
+
+/** @brief [锁内] 把条目放进 table 的空槽 (调用方保证 table 还有空位) */
+static void
+layout_cache_place(LayoutCacheTable *table, LayoutCacheEntry *entry)
+{
+  size_t i = layout_cache_slot(entry->type, table->mask);
+  while (LAYOUT_LOAD(&table->slots[i]))
+    i = (i + 1) & table->mask;
+  LAYOUT_STORE(&table->slots[i], entry);
+}
+
+/**
+ * @brief 发布一个算好的布局
+ *
+ * 另一个线程可能已经发布了同一个类型: 那时返回已有的条目 (内容相同)。
+ * @return 缓存中的条目；分配失败时返回 NULL
+ */
+static const LayoutCacheEntry *
+layout_cache_publish(DataLayoutCache *cache, const IRType *type, BumpLayout layout, const size_t *offsets,
+                     size_t num_offsets)
+{
+#if !defined(__STDC_NO_THREADS__)
+  mtx_lock(&cache->mutex);
+#endif
+  const LayoutCacheEntry *result = layout_cache_find(cache, type);
+  if (!result)
+  {
+    LayoutCacheTable *table = LAYOUT_LOAD(&cache->table);
+    if ((cache->count + 1) * 2 > table->mask + 1)
+    {
+      LayoutCacheTable *bigger = layout_cache_new_table(cache, (table->mask + 1) * 2);
+      if (bigger)
+      {
+        for (size_t i = 0; i <= table->mask; i++)
+        {
+          LayoutCacheEntry *old = LAYOUT_LOAD(&table->slots[i]);
+          if (old)
+            layout_cache_place(bigger, old);
+        }
+        LAYOUT_STORE(&cache->table, bigger);
+        table = bigger;
+      }
+    }
+
+    LayoutCacheEntry *entry = NULL;
+    /// 换表失败时旧表仍然至少有一半是空的，但不再继续填充
+    if ((cache->count + 1) * 2 <= table->mask + 1)
+      entry = (LayoutCacheEntry *)bump_alloc(&cache->arena, sizeof(LayoutCacheEntry) + num_offsets * sizeof(size_t),
+                                             _Alignof(LayoutCacheEntry));
+    if (entry)
+    {
+      entry->type = type;
+      entry->context_id = type->context_id;
+      entry->layout = layout;
+      if (num_offsets > 0)
+        memcpy(entry->offsets, offsets, num_offsets * sizeof(size_t));
+      layout_cache_place(table, entry);
+      cache->count++;
+      result = entry;
+    }
+  }
+#if !defined(__STDC_NO_THREADS__)
+  mtx_unlock(&cache->mutex);
+#endif
+  return result;
+}
+
 /*
  * --- 生命周期 ---
  */
@@ -97,6 +292,7 @@ datalayout_create_host(void)
   dl->ptr_layout = (TypeLayoutInfo){.size_in_bytes = sizeof(void *), .abi_align_in_bytes = _Alignof(void *)};
 
   dl->aggregate_preferred_align_in_bytes = 0;
+  dl->cache = layout_cache_create();
 
   return dl;
 }
@@ -104,13 +300,95 @@ datalayout_create_host(void)
 void
 datalayout_destroy(DataLayout *dl)
 {
+  if (!dl)
+    return;
+  layout_cache_destroy(dl->cache);
   free(dl);
 }
 
+void
+datalayout_clear_cache(DataLayout *dl)
+{
+  layout_cache_destroy(dl->cache);
+  dl->cache = layout_cache_create();
+}
+
 /*
  * --- 核心 API ---
  */
 
+/**
+ * @brief 计算结构体的布局，offsets (可为 NULL) 接收每个成员的偏移量
+ */
+static BumpLayout
+compute_struct_layout(const DataLayout *dl, IRType *type, size_t *offsets)
+{
+  size_t total_size = 0;
+  size_t max_align = 1;
+
+  for (size_t i = 0; i < type->as.aggregate.member_count; i++)
+  {
+    BumpLayout member_layout = datalayout_get_type_layout(dl, type->as.aggregate.member_types[i]);
+
+    total_size = ALIGN_UP(total_size, member_layout.align);
+    if (offsets)
+      offsets[i] = total_size;
+
+    total_size += member_layout.size;
+
+    if (member_layout.align > max_align)
+    {
+      max_align = member_layout.align;
+    }
+  }
+
+  if (dl->aggregate_preferred_align_in_bytes > 0)
+  {
+    if (dl->aggregate_preferred_align_in_bytes > max_align)
+    {
+      max_align = dl->aggregate_preferred_align_in_bytes;
+    }
+  }
+
+  total_size = ALIGN_UP(total_size, max_align);
+
+  return (BumpLayout){.size = total_size, .align = max_align};
+}
+
+/**
+ * @brief 查询 (必要时计算并缓存) 聚合类型的布局
+ *
+ * @return 缓存条目；缓存不可用时返回 NULL (调用方自己计算)
+ */
+static const LayoutCacheEntry *
+get_aggregate_entry(const DataLayout *dl, IRType *type)
+{
+  if (!dl->cache)
+    return NULL;
+  const LayoutCacheEntry *entry = layout_cache_find(dl->cache, type);
+  if (entry)
+    return entry;
+
+  if (type->kind == IR_TYPE_ARRAY)
+  {
+    BumpLayout elem_layout = datalayout_get_type_layout(dl, type->as.array.element_type);
+    BumpLayout layout = {.size = elem_layout.size * type->as.array.element_count, .align = elem_layout.align};
+    return layout_cache_publish(dl->cache, type, layout, NULL, 0);
+  }
+
+  /// 成员多于 16 个的结构体在堆上放临时的偏移数组
+  size_t count = type->as.aggregate.member_count;
+  size_t stack_offsets[16];
+  size_t *offsets = count <= 16 ? stack_offsets : (size_t *)malloc(count * sizeof(size_t));
+  if (!offsets)
+    return NULL;
+  BumpLayout layout = compute_struct_layout(dl, type, offsets);
+  entry = layout_cache_publish(dl->cache, type, layout, offsets, count);
+  if (offsets != stack_offsets)
+    free(offsets);
+  return entry;
+}
+
 BumpLayout
 datalayout_get_type_layout(const DataLayout *dl, IRType *type)
 {
@@ -124,6 +402,9 @@ datalayout_get_type_layout(const DataLayout *dl, IRType *type)
   switch (type->kind)
   {
   case IR_TYPE_ARRAY: {
+    const LayoutCacheEntry *entry = get_aggregate_entry(dl, type);
+    if (entry)
+      return entry->layout;
 
     BumpLayout elem_layout = datalayout_get_type_layout(dl, type->as.array.element_type);
 
@@ -131,34 +412,10 @@ datalayout_get_type_layout(const DataLayout *dl, IRType *type)
   }
 
   case IR_TYPE_STRUCT: {
-    size_t total_size = 0;
-    size_t max_align = 1;
-
-    for (size_t i = 0; i < type->as.aggregate.member_count; i++)
-    {
-      BumpLayout member_layout = datalayout_get_type_layout(dl, type->as.aggregate.member_types[i]);
-
-      total_size = ALIGN_UP(total_size, member_layout.align);
-
-      total_size += member_layout.size;
-
-      if (member_layout.align > max_align)
-      {
-        max_align = member_layout.align;
-      }
-    }
-
-    if (dl->aggregate_preferred_align_in_bytes > 0)
-    {
-      if (dl->aggregate_preferred_align_in_bytes > max_align)
-      {
-        max_align = dl->aggregate_preferred_align_in_bytes;
-      }
-    }
-
-    total_size = ALIGN_UP(total_size, max_align);
-
-    return (BumpLayout){.size = total_size, .align = max_align};
+    const LayoutCacheEntry *entry = get_aggregate_entry(dl, type);
+    if (entry)
+      return entry->layout;
+    return compute_struct_layout(dl, type, NULL);
   }
 
   default:
@@ -180,16 +437,25 @@ datalayout_get_type_align(const DataLayout *dl, IRType *type)
   return datalayout_get_type_layout(dl, type).align;
 }
 
-/**
- * @brief [!!] (已改进) 获取结构体成员的偏移量。
- * (此逻辑现在与您在 interpreter.c 中已验证的旧逻辑相匹配)
- */
+const size_t *
+datalayout_get_struct_member_offsets(const DataLayout *dl, IRType *struct_type)
+{
+  assert(struct_type->kind == IR_TYPE_STRUCT && "Type is not a struct");
+  const LayoutCacheEntry *entry = get_aggregate_entry(dl, struct_type);
+  return entry ? entry->offsets : NULL;
+}
+
 size_t
 datalayout_get_struct_member_offset(const DataLayout *dl, IRType *struct_type, size_t member_index)
 {
   assert(struct_type->kind == IR_TYPE_STRUCT && "Type is not a struct");
   assert(member_index < struct_type->as.aggregate.member_count && "Member index out of bounds");
 
+  const size_t *offsets = datalayout_get_struct_member_offsets(dl, struct_type);
+  if (offsets)
+    return offsets[member_index];
+
+  /// 没有缓存时逐个成员累加
   size_t current_offset = 0;
 
   for (size_t i = 0; i < member_index; i++)
@@ -132,13 +132,8 @@ generic_hashmap_remove(GenericHashMap *map, const void *key)
   GenericHashMapBucket *bucket;
   if (generic_hashmap_find_bucket(map, key, &bucket))
   {
-
-    size_t bucket_idx = (size_t)(bucket - map->buckets);
-    map->states[bucket_idx] = BUCKET_TOMBSTONE;
-
     bucket->value = NULL;
-    map->num_entries--;
-    map->num_tombstones++;
+    generic_hashmap_erase_bucket(map, bucket);
     return true;
   }
   return false;
@@ -148,7 +143,8 @@ bool
 generic_hashmap_put(GenericHashMap *map, const void *key, void *value)
 {
   GenericHashMapBucket *bucket;
-  bool found = generic_hashmap_find_bucket(map, key, &bucket);
+  uint8_t tag;
+  bool found = generic_hashmap_find_slot(map, key, &bucket, &tag);
 
   if (found)
   {
@@ -167,7 +163,7 @@ generic_hashmap_put(GenericHashMap *map, const void *key, void *value)
       return false;
     }
 
-    found = generic_hashmap_find_bucket(map, key, &bucket);
+    found = generic_hashmap_find_slot(map, key, &bucket, &tag);
     assert(!found && "Key should not exist after grow");
     assert(bucket != NULL);
   }
@@ -181,7 +177,7 @@ generic_hashmap_put(GenericHashMap *map, const void *key, void *value)
 
   bucket->key = key;
   bucket->value = value;
-  map->states[bucket_idx] = BUCKET_FILLED;
+  map->states[bucket_idx] = tag;
   map->num_entries++;
 
   return true;
@@ -200,6 +196,29 @@ generic_hashmap_size(const GenericHashMap *map)
   return map->num_entries;
 }
 
+HashMapStats
+generic_hashmap_stats(const GenericHashMap *map)
+{
+  return (HashMapStats){
+    .num_entries = map->num_entries,
+    .num_buckets = map->num_buckets,
+    .num_tombstones = map->num_tombstones,
+    .bytes = sizeof(*map) + map->num_buckets * (sizeof(GenericHashMapBucket) + sizeof(uint8_t)),
+  };
+}
+
+void
+generic_hashmap_clear(GenericHashMap *map)
+{
+  generic_hashmap_reset(map);
+}
+
+bool
+generic_hashmap_reserve(GenericHashMap *map, size_t num_entries)
+{
+  return generic_hashmap_ensure_capacity(map, num_entries);
+}
+
 /*
  * ========================================
  * --- 5. 迭代器 API 实现 ---
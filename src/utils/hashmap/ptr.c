@@ -133,13 +133,8 @@ ptr_hashmap_remove(PtrHashMap *map, void *key)
   PtrHashMapBucket *bucket;
   if (ptr_hashmap_find_bucket(map, key, &bucket))
   {
-
-    size_t bucket_idx = (size_t)(bucket - map->buckets);
-    map->states[bucket_idx] = BUCKET_TOMBSTONE;
-
     bucket->value = NULL;
-    map->num_entries--;
-    map->num_tombstones++;
+    ptr_hashmap_erase_bucket(map, bucket);
     return true;
   }
   return false;
@@ -149,7 +144,8 @@ bool
 ptr_hashmap_put(PtrHashMap *map, void *key, void *value)
 {
   PtrHashMapBucket *bucket;
-  bool found = ptr_hashmap_find_bucket(map, key, &bucket);
+  uint8_t tag;
+  bool found = ptr_hashmap_find_slot(map, key, &bucket, &tag);
 
   if (found)
   {
@@ -168,7 +164,7 @@ ptr_hashmap_put(PtrHashMap *map, void *key, void *value)
       return false;
     }
 
-    found = ptr_hashmap_find_bucket(map, key, &bucket);
+    found = ptr_hashmap_find_slot(map, key, &bucket, &tag);
     assert(!found && "Key should not exist after grow");
     assert(bucket != NULL);
   }
@@ -182,7 +178,7 @@ ptr_hashmap_put(PtrHashMap *map, void *key, void *value)
 
   bucket->key = key;
   bucket->value = value;
-  map->states[bucket_idx] = BUCKET_FILLED;
+  map->states[bucket_idx] = tag;
   map->num_entries++;
 
   return true;
@@ -201,6 +197,29 @@ ptr_hashmap_size(const PtrHashMap *map)
   return map->num_entries;
 }
 
+HashMapStats
+ptr_hashmap_stats(const PtrHashMap *map)
+{
+  return (HashMapStats){
+    .num_entries = map->num_entries,
+    .num_buckets = map->num_buckets,
+    .num_tombstones = map->num_tombstones,
+    .bytes = sizeof(*map) + map->num_buckets * (sizeof(PtrHashMapBucket) + sizeof(uint8_t)),
+  };
+}
+
+void
+ptr_hashmap_clear(PtrHashMap *map)
+{
+  ptr_hashmap_reset(map);
+}
+
+bool
+ptr_hashmap_reserve(PtrHashMap *map, size_t num_entries)
+{
+  return ptr_hashmap_ensure_capacity(map, num_entries);
+}
+
 /*
  * ========================================
  * --- 5. 迭代器 API 实现 ---
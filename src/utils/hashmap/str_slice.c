@@ -31,10 +31,12 @@
  * ========================================
  */
 
+/** Key 连同它的哈希一起保存: 扩容时不用重新哈希，探测时先比较哈希 */
 typedef struct
 {
   const char *body;
   size_t len;
+  uint64_t hash;
 } StrSlice;
 
 typedef struct
@@ -62,7 +64,7 @@ struct StrHashMap
 static inline bool
 str_hashmap_key_is_equal(StrSlice k1, StrSlice k2)
 {
-  if (k1.len != k2.len)
+  if (k1.hash != k2.hash || k1.len != k2.len)
     return false;
   if (k1.body == k2.body)
     return true;
@@ -73,7 +75,7 @@ str_hashmap_key_is_equal(StrSlice k1, StrSlice k2)
 static inline uint64_t
 str_hashmap_get_hash(StrSlice key)
 {
-  return XXH3_64bits(key.body, key.len);
+  return key.hash;
 }
 
 /*
@@ -126,11 +128,22 @@ str_hashmap_create(Bump *arena, size_t initial_capacity)
   return map;
 }
 
+uint64_t
+str_hashmap_hash(const char *key_body, size_t key_len)
+{
+  return XXH3_64bits(key_body, key_len);
+}
+
 void *
 str_hashmap_get(const StrHashMap *map, const char *key_body, size_t key_len)
 {
+  return str_hashmap_get_hashed(map, key_body, key_len, str_hashmap_hash(key_body, key_len));
+}
 
-  StrSlice key_to_find = {.body = key_body, .len = key_len};
+void *
+str_hashmap_get_hashed(const StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash)
+{
+  StrSlice key_to_find = {.body = key_body, .len = key_len, .hash = hash};
   StrHashMapBucket *bucket;
 
   if (str_hashmap_find_bucket(map, key_to_find, &bucket))
@@ -143,7 +156,13 @@ str_hashmap_get(const StrHashMap *map, const char *key_body, size_t key_len)
 bool
 str_hashmap_contains(const StrHashMap *map, const char *key_body, size_t key_len)
 {
-  StrSlice key_to_find = {.body = key_body, .len = key_len};
+  return str_hashmap_contains_hashed(map, key_body, key_len, str_hashmap_hash(key_body, key_len));
+}
+
+bool
+str_hashmap_contains_hashed(const StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash)
+{
+  StrSlice key_to_find = {.body = key_body, .len = key_len, .hash = hash};
   StrHashMapBucket *bucket;
   return str_hashmap_find_bucket(map, key_to_find, &bucket);
 }
@@ -151,18 +170,13 @@ str_hashmap_contains(const StrHashMap *map, const char *key_body, size_t key_len
 bool
 str_hashmap_remove(StrHashMap *map, const char *key_body, size_t key_len)
 {
-  StrSlice key_to_find = {.body = key_body, .len = key_len};
+  StrSlice key_to_find = {.body = key_body, .len = key_len, .hash = str_hashmap_hash(key_body, key_len)};
   StrHashMapBucket *bucket;
 
   if (str_hashmap_find_bucket(map, key_to_find, &bucket))
   {
-
-    size_t bucket_idx = (size_t)(bucket - map->buckets);
-    map->states[bucket_idx] = BUCKET_TOMBSTONE;
-
     bucket->value = NULL;
-    map->num_entries--;
-    map->num_tombstones++;
+    str_hashmap_erase_bucket(map, bucket);
     return true;
   }
   return false;
@@ -171,10 +185,11 @@ str_hashmap_remove(StrHashMap *map, const char *key_body, size_t key_len)
 bool
 str_hashmap_put(StrHashMap *map, const char *key_body, size_t key_len, void *value)
 {
-  StrSlice key_to_find = {.body = key_body, .len = key_len};
+  StrSlice key_to_find = {.body = key_body, .len = key_len, .hash = str_hashmap_hash(key_body, key_len)};
   StrHashMapBucket *bucket;
+  uint8_t tag;
 
-  bool found = str_hashmap_find_bucket(map, key_to_find, &bucket);
+  bool found = str_hashmap_find_slot(map, key_to_find, &bucket, &tag);
 
   if (found)
   {
@@ -191,7 +206,7 @@ str_hashmap_put(StrHashMap *map, const char *key_body, size_t key_len, void *val
     {
       return false;
     }
-    found = str_hashmap_find_bucket(map, key_to_find, &bucket);
+    found = str_hashmap_find_slot(map, key_to_find, &bucket, &tag);
     assert(!found && "Key should not exist after grow");
     assert(bucket != NULL);
   }
@@ -209,10 +224,10 @@ str_hashmap_put(StrHashMap *map, const char *key_body, size_t key_len, void *val
     return false;
   }
 
+  bucket->key = key_to_find;
   bucket->key.body = new_key_body;
-  bucket->key.len = key_len;
   bucket->value = value;
-  map->states[bucket_idx] = BUCKET_FILLED;
+  map->states[bucket_idx] = tag;
   map->num_entries++;
 
   return true;
@@ -221,10 +236,18 @@ str_hashmap_put(StrHashMap *map, const char *key_body, size_t key_len, void *val
 bool
 str_hashmap_put_preallocated_key(StrHashMap *map, const char *key_body, size_t key_len, void *value)
 {
-  StrSlice key_to_find = {.body = key_body, .len = key_len};
+  return str_hashmap_put_preallocated_key_hashed(map, key_body, key_len, str_hashmap_hash(key_body, key_len), value);
+}
+
+bool
+str_hashmap_put_preallocated_key_hashed(StrHashMap *map, const char *key_body, size_t key_len, uint64_t hash,
+                                        void *value)
+{
+  StrSlice key_to_find = {.body = key_body, .len = key_len, .hash = hash};
   StrHashMapBucket *bucket;
+  uint8_t tag;
 
-  bool found = str_hashmap_find_bucket(map, key_to_find, &bucket);
+  bool found = str_hashmap_find_slot(map, key_to_find, &bucket, &tag);
 
   if (found)
   {
@@ -241,7 +264,7 @@ str_hashmap_put_preallocated_key(StrHashMap *map, const char *key_body, size_t k
     {
       return false;
     }
-    found = str_hashmap_find_bucket(map, key_to_find, &bucket);
+    found = str_hashmap_find_slot(map, key_to_find, &bucket, &tag);
     assert(!found && "Key should not exist after grow");
     assert(bucket != NULL);
   }
@@ -253,10 +276,9 @@ str_hashmap_put_preallocated_key(StrHashMap *map, const char *key_body, size_t k
     map->num_tombstones--;
   }
 
-  bucket->key.body = key_body;
-  bucket->key.len = key_len;
+  bucket->key = key_to_find;
   bucket->value = value;
-  map->states[bucket_idx] = BUCKET_FILLED;
+  map->states[bucket_idx] = tag;
   map->num_entries++;
 
   return true;
@@ -268,6 +290,29 @@ str_hashmap_size(const StrHashMap *map)
   return map->num_entries;
 }
 
+HashMapStats
+str_hashmap_stats(const StrHashMap *map)
+{
+  return (HashMapStats){
+    .num_entries = map->num_entries,
+    .num_buckets = map->num_buckets,
+    .num_tombstones = map->num_tombstones,
+    .bytes = sizeof(*map) + map->num_buckets * (sizeof(StrHashMapBucket) + sizeof(uint8_t)),
+  };
+}
+
+void
+str_hashmap_clear(StrHashMap *map)
+{
+  str_hashmap_reset(map);
+}
+
+bool
+str_hashmap_reserve(StrHashMap *map, size_t num_entries)
+{
+  return str_hashmap_ensure_capacity(map, num_entries);
+}
+
 /*
  * ========================================
  * --- 5. 迭代器 API 实现 ---
@@ -290,6 +335,7 @@ str_hashmap_size(const StrHashMap *map)
   {                                                                                                                    \
     (entry_out)->key_body = (bucket)->key.body;                                                                        \
     (entry_out)->key_len = (bucket)->key.len;                                                                          \
+    (entry_out)->key_hash = (bucket)->key.hash;                                                                        \
     (entry_out)->value = (bucket)->value;                                                                              \
   } while (0)
 
@@ -0,0 +1,465 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/instrument.h"
+#include "utils/hashmap/generic.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define XXH_INLINE_ALL
+#include "utils/xxhash.h"
+
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define INSTRUMENT_ATOMIC(T) _Atomic(T)
+#define INSTRUMENT_LOAD(ptr) atomic_load_explicit((ptr), memory_order_acquire)
+#define INSTRUMENT_STORE(ptr, value) atomic_store_explicit((ptr), (value), memory_order_release)
+#else
+#define INSTRUMENT_ATOMIC(T) T
+#define INSTRUMENT_LOAD(ptr) (*(ptr))
+#define INSTRUMENT_STORE(ptr, value) (*(ptr) = (value))
+#endif
+
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#endif
+
+/** @brief 一条记录及其在会话中的位置 */
+typedef struct RecordNode
+{
+  InstrumentRecord record;
+  /** 第一次出现的序号 (报告中的稳定排序) */
+  size_t seq;
+  /** true 表示这是 (阶段, 模块) 的汇总，function 总是 NULL */
+  bool is_total;
+} RecordNode;
+
+struct Instrumentation
+{
+  /** 记录、键字符串与哈希表的存储 */
+  Bump arena;
+  /** RecordNode* -> RecordNode* (键就是值本身) */
+  GenericHashMap *map;
+  /** 按 (阶段, 模块, 函数) 的记录 */
+  InstrumentRecord *records;
+  InstrumentRecord **records_tail;
+  /** 按 (阶段, 模块) 的汇总 (跨函数求和) */
+  InstrumentRecord *totals;
+  InstrumentRecord **totals_tail;
+  size_t count;
+#if !defined(__STDC_NO_THREADS__)
+  mtx_t mutex;
+#endif
+};
+
+/// 正在收集的会话 (没有时为 NULL)
+static INSTRUMENT_ATOMIC(Instrumentation *) active_session = NULL;
+
+/// 当前线程上最内层的作用域 (用于计算 self 时间)
+static _Thread_local InstrumentScope *current_scope = NULL;
+
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+#if defined(TIME_MONOTONIC)
+  timespec_get(&ts, TIME_MONOTONIC);
+#else
+  timespec_get(&ts, TIME_UTC);
+#endif
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * --- 记录表 ---
+ */
+
+static uint64_t
+hash_name(const char *name, uint64_t seed)
+{
+  /// NULL 与 "" 是不同的键
+  if (!name)
+    return XXH3_64bits_withSeed(&seed, sizeof(seed), 0x9e3779b97f4a7c15ull);
+  return XXH3_64bits_withSeed(name, strlen(name), seed);
+}
+
+static uint64_t
+record_hash(const void *key)
+{
+  const RecordNode *node = (const RecordNode *)key;
+  uint64_t hash = hash_name(node->record.stage, node->is_total);
+  hash = hash_name(node->record.module, hash);
+  return hash_name(node->record.function, hash);
+}
+
+static bool
+name_equal(const char *a, const char *b)
+{
+  if (!a || !b)
+    return a == b;
+  return strcmp(a, b) == 0;
+}
+
+static bool
+record_equal(const void *key1, const void *key2)
+{
+  const RecordNode *a = (const RecordNode *)key1;
+  const RecordNode *b = (const RecordNode *)key2;
+  return a->is_total == b->is_total && name_equal(a->record.stage, b->record.stage) &&
+         name_equal(a->record.module, b->record.module) && name_equal(a->record.function, b->record.function);
+}
+
+/** @brief 在会话 Arena 中复制键字符串 (NULL 保持为 NULL) */
+static const char *
+copy_name(Instrumentation *session, const char *name)
+{
+  return name ? bump_alloc_str(&session->arena, name) : NULL;
+}
+
+/**
+ * @brief [锁内] 查找或创建一条记录
+ * @return OOM 时返回 NULL
+ */
+static InstrumentRecord *
+record_get(Instrumentation *session, const char *stage, const char *module, const char *function, bool is_total)
+{
+  RecordNode key = {.record = {.stage = stage, .module = module, .function = function}, .is_total = is_total};
+  RecordNode *node = (RecordNode *)generic_hashmap_get(session->map, &key);
+  if (node)
+    return &node->record;
+
+  node = BUMP_ALLOC_ZEROED(&session->arena, RecordNode);
+  if (!node)
+    return NULL;
+  node->record.stage = copy_name(session, stage);
+  node->record.module = copy_name(session, module);
+  node->record.function = copy_name(session, function);
+  if ((stage && !node->record.stage) || (module && !node->record.module) || (function && !node->record.function))
+    return NULL;
+  node->seq = session->count++;
+  node->is_total = is_total;
+  if (!generic_hashmap_put(session->map, node, node))
+    return NULL;
+
+  InstrumentRecord ***tail = is_total ? &session->totals_tail : &session->records_tail;
+  **tail = &node->record;
+  *tail = &node->record.next;
+  return &node->record;
+}
+
+static void
+record_add(InstrumentRecord *record, uint64_t total_ns, uint64_t self_ns, int64_t bytes)
+{
+  record->count++;
+  record->total_ns += total_ns;
+  record->self_ns += self_ns;
+  record->bytes += bytes;
+}
+
+/** @brief 建立空的记录表 (Arena 已经初始化或重置) */
+static bool
+session_init_table(Instrumentation *session)
+{
+  session->map = generic_hashmap_create(&session->arena, 64, record_hash, record_equal);
+  session->records = NULL;
+  session->records_tail = &session->records;
+  session->totals = NULL;
+  session->totals_tail = &session->totals;
+  session->count = 0;
+  return session->map != NULL;
+}
+
+/*
+ * --- 会话 ---
+ */
+
+Instrumentation *
+instrument_create(void)
+{
+  Instrumentation *session = (Instrumentation *)malloc(sizeof(Instrumentation));
+  if (!session)
+    return NULL;
+  bump_init(&session->arena);
+  bool ok = session_init_table(session);
+#if !defined(__STDC_NO_THREADS__)
+  if (ok && mtx_init(&session->mutex, mtx_plain) != thrd_success)
+    ok = false;
+#endif
+  if (!ok)
+  {
+    bump_destroy(&session->arena);
+    free(session);
+    return NULL;
+  }
+  return session;
+}
+
+void
+instrument_destroy(Instrumentation *session)
+{
+  if (!session)
+    return;
+  if (INSTRUMENT_LOAD(&active_session) == session)
+    instrument_stop();
+#if !defined(__STDC_NO_THREADS__)
+  mtx_destroy(&session->mutex);
+#endif
+  bump_destroy(&session->arena);
+  free(session);
+}
+
+void
+instrument_start(Instrumentation *session)
+{
+  INSTRUMENT_STORE(&active_session, session);
+}
+
+void
+instrument_stop(void)
+{
+  INSTRUMENT_STORE(&active_session, NULL);
+}
+
+void
+instrument_reset(Instrumentation *session)
+{
+  bump_reset(&session->arena);
+  /// 只有在 OOM 时才会失败；之后的记录会被丢弃
+  session_init_table(session);
+}
+
+const InstrumentRecord *
+instrument_next_record(const Instrumentation *session, const InstrumentRecord *record)
+{
+  return record ? record->next : session->records;
+}
+
+const InstrumentRecord *
+instrument_find(const Instrumentation *session, const char *stage, const char *module, const char *function)
+{
+  if (!session->map)
+    return NULL;
+  RecordNode key = {.record = {.stage = stage, .module = module, .function = function}, .is_total = false};
+  RecordNode *node = (RecordNode *)generic_hashmap_get(session->map, &key);
+  return node ? &node->record : NULL;
+}
+
+/*
+ * --- 作用域 ---
+ */
+
+void
+instrument_begin(InstrumentScope *scope, const char *stage, const char *module, const char *function)
+{
+  scope->session = INSTRUMENT_LOAD(&active_session);
+  if (!scope->session)
+    return;
+  scope->parent = current_scope;
+  scope->stage = stage;
+  scope->module = module;
+  scope->function = function;
+  scope->child_ns = 0;
+  scope->num_arenas = 0;
+  current_scope = scope;
+  scope->start_ns = now_ns();
+}
+
+void
+instrument_track_arena(InstrumentScope *scope, Bump *arena)
+{
+  if (!scope->session || scope->num_arenas == INSTRUMENT_MAX_ARENAS)
+    return;
+  scope->arenas[scope->num_arenas] = arena;
+  scope->arena_bytes[scope->num_arenas] = bump_get_allocated_bytes(arena);
+  scope->num_arenas++;
+}
+
+void
+instrument_end(InstrumentScope *scope)
+{
+  Instrumentation *session = scope->session;
+  if (!session)
+    return;
+  uint64_t elapsed = now_ns() - scope->start_ns;
+  uint64_t self = elapsed > scope->child_ns ? elapsed - scope->child_ns : 0;
+  int64_t bytes = 0;
+  for (size_t i = 0; i < scope->num_arenas; i++)
+    bytes += (int64_t)bump_get_allocated_bytes(scope->arenas[i]) - (int64_t)scope->arena_bytes[i];
+
+  current_scope = scope->parent;
+  if (scope->parent)
+    scope->parent->child_ns += elapsed;
+
+#if !defined(__STDC_NO_THREADS__)
+  mtx_lock(&session->mutex);
+#endif
+  if (session->map)
+  {
+    InstrumentRecord *record = record_get(session, scope->stage, scope->module, scope->function, false);
+    if (record)
+      record_add(record, elapsed, self, bytes);
+    InstrumentRecord *total = record_get(session, scope->stage, scope->module, NULL, true);
+    if (total)
+      record_add(total, elapsed, self, bytes);
+  }
+#if !defined(__STDC_NO_THREADS__)
+  mtx_unlock(&session->mutex);
+#endif
+}
+
+/*
+ * --- 报告 ---
+ */
+
+/** @brief 报告中模块的显示名 */
+static const char *
+module_label(const char *module)
+{
+  return module ? module : "<no module>";
+}
+
+static void
+print_row(FILE *stream, const InstrumentRecord *record, const char *indent)
+{
+  fprintf(stream, "%s%12.3f %12.3f %8llu %14lld  %s\n", indent, (double)record->total_ns / 1e6,
+          (double)record->self_ns / 1e6, (unsigned long long)record->count, (long long)record->bytes, record->stage);
+}
+
+static int
+compare_by_function(const void *a, const void *b)
+{
+  const RecordNode *x = *(const RecordNode *const *)a;
+  const RecordNode *y = *(const RecordNode *const *)b;
+  int order = strcmp(x->record.function, y->record.function);
+  if (order != 0)
+    return order;
+  return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+/** @brief 打印一个模块中按函数分组的记录 (按函数名排序，组内按出现顺序) */
+static void
+print_functions(const Instrumentation *session, FILE *stream, const char *module)
+{
+  size_t count = 0;
+  for (const InstrumentRecord *r = session->records; r; r = r->next)
+    count += r->function && name_equal(r->module, module);
+  if (count == 0)
+    return;
+  const RecordNode **nodes = (const RecordNode **)malloc(count * sizeof(*nodes));
+  if (!nodes)
+    return;
+  size_t n = 0;
+  for (const InstrumentRecord *r = session->records; r; r = r->next)
+  {
+    if (r->function && name_equal(r->module, module))
+      nodes[n++] = (const RecordNode *)r;
+  }
+  qsort(nodes, n, sizeof(*nodes), compare_by_function);
+
+  const char *function = NULL;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (!function || strcmp(function, nodes[i]->record.function) != 0)
+    {
+      function = nodes[i]->record.function;
+      fprintf(stream, "  @%s\n", function);
+    }
+    print_row(stream, &nodes[i]->record, "    ");
+  }
+  free(nodes);
+}
+
+void
+instrument_print(const Instrumentation *session, FILE *stream)
+{
+  fprintf(stream, "===------------------------------------------------------------===\n");
+  fprintf(stream, "                      Stage timing report\n");
+  fprintf(stream, "===------------------------------------------------------------===\n");
+  fprintf(stream, "      Total (ms)    Self (ms)    Count    Alloc (bytes)  Stage\n");
+
+  /// 汇总按模块第一次出现的顺序打印；每个模块只在它的第一条汇总处打印一次
+  for (const InstrumentRecord *first = session->totals; first; first = first->next)
+  {
+    bool seen = false;
+    for (const InstrumentRecord *r = session->totals; r != first; r = r->next)
+      seen |= name_equal(r->module, first->module);
+    if (seen)
+      continue;
+
+    fprintf(stream, "module '%s'\n", module_label(first->module));
+    for (const InstrumentRecord *r = first; r; r = r->next)
+    {
+      if (name_equal(r->module, first->module))
+        print_row(stream, r, "  ");
+    }
+    print_functions(session, stream, first->module);
+  }
+}
+
+static void
+print_json_string(FILE *stream, const char *str)
+{
+  if (!str)
+  {
+    fputs("null", stream);
+    return;
+  }
+  fputc('"', stream);
+  for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+  {
+    if (*p == '"' || *p == '\\')
+      fprintf(stream, "\\%c", *p);
+    else if (*p < 0x20)
+      fprintf(stream, "\\u%04x", *p);
+    else
+      fputc(*p, stream);
+  }
+  fputc('"', stream);
+}
+
+static void
+print_json_records(FILE *stream, const InstrumentRecord *records, bool with_function)
+{
+  for (const InstrumentRecord *r = records; r; r = r->next)
+  {
+    fputs("    {\"stage\": ", stream);
+    print_json_string(stream, r->stage);
+    fputs(", \"module\": ", stream);
+    print_json_string(stream, r->module);
+    if (with_function)
+    {
+      fputs(", \"function\": ", stream);
+      print_json_string(stream, r->function);
+    }
+    fprintf(stream, ", \"count\": %llu, \"total_ns\": %llu, \"self_ns\": %llu, \"bytes\": %lld}%s\n",
+            (unsigned long long)r->count, (unsigned long long)r->total_ns, (unsigned long long)r->self_ns,
+            (long long)r->bytes, r->next ? "," : "");
+  }
+}
+
+void
+instrument_print_json(const Instrumentation *session, FILE *stream)
+{
+  fputs("{\n  \"records\": [\n", stream);
+  print_json_records(stream, session->records, true);
+  fputs("  ],\n  \"modules\": [\n", stream);
+  print_json_records(stream, session->totals, false);
+  fputs("  ]\n}\n", stream);
+}
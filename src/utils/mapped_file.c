@@ -0,0 +1,119 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/mapped_file.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#define MAPPED_FILE_HAS_MMAP 0
+#else
+#define MAPPED_FILE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 退回路径: 把整个文件读进堆内存
+ */
+static bool
+read_whole_file(MappedFile *file, const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+
+  bool ok = false;
+  char *buf = NULL;
+  long len = -1;
+  if (fseek(f, 0, SEEK_END) == 0 && (len = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+  {
+    /// 至少分配 1 字节，使空文件也有一个合法的 data 指针
+    buf = malloc((size_t)len + 1);
+    ok = buf && fread(buf, 1, (size_t)len, f) == (size_t)len;
+  }
+  fclose(f);
+
+  if (!ok)
+  {
+    free(buf);
+    return false;
+  }
+  file->data = buf;
+  file->size = (size_t)len;
+  file->mapped = false;
+  return true;
+}
+
+bool
+mapped_file_open(MappedFile *file, const char *path)
+{
+  assert(file && path);
+  file->data = NULL;
+  file->size = 0;
+  file->mapped = false;
+
+#if MAPPED_FILE_HAS_MMAP
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+  {
+    /// 不是普通文件 (例如管道) 或是空文件 (长度为 0 的映射不合法)
+    close(fd);
+    return read_whole_file(file, path);
+  }
+
+  void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return read_whole_file(file, path);
+
+  /// 解析器只顺序扫描一遍: 提示内核积极预读、尽早回收已读过的页
+  posix_madvise(addr, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+  file->data = addr;
+  file->size = (size_t)st.st_size;
+  file->mapped = true;
+  return true;
+#else
+  return read_whole_file(file, path);
+#endif
+}
+
+void
+mapped_file_close(MappedFile *file)
+{
+  if (!file || !file->data)
+    return;
+
+#if MAPPED_FILE_HAS_MMAP
+  if (file->mapped)
+    munmap((void *)file->data, file->size);
+  else
+    free((void *)file->data);
+#else
+  free((void *)file->data);
+#endif
+  file->data = NULL;
+  file->size = 0;
+  file->mapped = false;
+}
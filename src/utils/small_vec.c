@@ -0,0 +1,46 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/small_vec.h"
+#include <string.h>
+
+bool
+small_vec_grow(Bump *arena, void **data, size_t *capacity, const void *inline_data, size_t len, size_t needed,
+               size_t elem_size, size_t align)
+{
+  size_t new_cap = *capacity * 2;
+  if (new_cap < needed)
+    new_cap = needed;
+
+  void *new_data;
+  if (*data == inline_data)
+  {
+    /// 第一次溢出: 内联存储不在 Arena 上，不能交给 bump_realloc
+    new_data = bump_alloc(arena, new_cap * elem_size, align);
+    if (new_data && len > 0)
+      memcpy(new_data, inline_data, len * elem_size);
+  }
+  else
+  {
+    new_data = bump_realloc(arena, *data, len * elem_size, new_cap * elem_size, align);
+  }
+  if (!new_data)
+    return false;
+
+  *data = new_data;
+  *capacity = new_cap;
+  return true;
+}
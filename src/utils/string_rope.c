@@ -0,0 +1,252 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/string_rope.h"
+#include <stdalign.h>
+#include <string.h>
+
+#if STRING_ROPE_HAS_IOVEC
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 内部辅助函数：在链表末尾接一个至少能放下 min_capacity 字节的新 chunk
+ *
+ * @return StringRopeChunk* 新的 tail；OOM 时返回 NULL (并标记 failed)
+ */
+static StringRopeChunk *
+string_rope_new_chunk(StringRope *rope, size_t min_capacity)
+{
+  size_t capacity = rope->next_capacity;
+  if (capacity < min_capacity)
+    capacity = min_capacity;
+
+  StringRopeChunk *chunk = (StringRopeChunk *)bump_alloc(rope->arena, sizeof(StringRopeChunk) + capacity,
+                                                         alignof(StringRopeChunk));
+  if (chunk == NULL)
+  {
+    rope->failed = true;
+    return NULL;
+  }
+  chunk->next = NULL;
+  chunk->len = 0;
+  chunk->capacity = capacity;
+
+  if (rope->tail)
+    rope->tail->next = chunk;
+  else
+    rope->head = chunk;
+  rope->tail = chunk;
+  rope->num_chunks++;
+
+  if (rope->next_capacity < STRING_ROPE_MAX_CHUNK)
+    rope->next_capacity *= 2;
+  return chunk;
+}
+
+void
+string_rope_init(StringRope *rope, Bump *arena)
+{
+  rope->arena = arena;
+  rope->head = NULL;
+  rope->tail = NULL;
+  rope->len = 0;
+  rope->num_chunks = 0;
+  rope->next_capacity = STRING_ROPE_MIN_CHUNK;
+  rope->failed = false;
+}
+
+void
+string_rope_destroy(StringRope *rope)
+{
+  (void)rope;
+}
+
+void
+string_rope_append_bytes(StringRope *rope, const char *data, size_t len)
+{
+  if (len == 0 || rope->failed)
+    return;
+
+  /// 先填满当前 chunk，剩下的部分放进一个新 chunk (新 chunk 至少放得下剩下的全部)
+  StringRopeChunk *chunk = rope->tail;
+  if (chunk)
+  {
+    size_t n = chunk->capacity - chunk->len;
+    if (n > len)
+      n = len;
+    memcpy(chunk->data + chunk->len, data, n);
+    chunk->len += n;
+    rope->len += n;
+    data += n;
+    len -= n;
+  }
+  if (len == 0)
+    return;
+
+  chunk = string_rope_new_chunk(rope, len);
+  if (chunk == NULL)
+    return;
+  memcpy(chunk->data, data, len);
+  chunk->len = len;
+  rope->len += len;
+}
+
+void
+string_rope_append_str(StringRope *rope, const char *str)
+{
+  string_rope_append_bytes(rope, str, strlen(str));
+}
+
+void
+string_rope_vappend_fmt(StringRope *rope, const char *fmt, va_list args)
+{
+  if (rope->failed)
+    return;
+
+  va_list args_copy;
+  va_copy(args_copy, args);
+
+  /// vsnprintf 还要写一个 '\0'：它落在 chunk 的空闲部分，不计入 len
+  StringRopeChunk *chunk = rope->tail;
+  size_t space = chunk ? chunk->capacity - chunk->len : 0;
+  int n = vsnprintf(chunk ? chunk->data + chunk->len : NULL, space, fmt, args);
+  if (n < 0)
+  {
+    va_end(args_copy);
+    return;
+  }
+
+  if ((size_t)n >= space)
+  {
+    chunk = string_rope_new_chunk(rope, (size_t)n + 1);
+    if (chunk == NULL)
+    {
+      va_end(args_copy);
+      return;
+    }
+    vsnprintf(chunk->data, chunk->capacity, fmt, args_copy);
+  }
+  va_end(args_copy);
+
+  chunk->len += (size_t)n;
+  rope->len += (size_t)n;
+}
+
+void
+string_rope_append_fmt(StringRope *rope, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  string_rope_vappend_fmt(rope, fmt, args);
+  va_end(args);
+}
+
+char *
+string_rope_flatten(const StringRope *rope, Bump *arena)
+{
+  char *out = BUMP_ALLOC_SLICE(arena, char, rope->len + 1);
+  if (out == NULL)
+    return NULL;
+
+  size_t offset = 0;
+  for (const StringRopeChunk *chunk = rope->head; chunk; chunk = chunk->next)
+  {
+    memcpy(out + offset, chunk->data, chunk->len);
+    offset += chunk->len;
+  }
+  out[offset] = '\0';
+  return out;
+}
+
+bool
+string_rope_write(const StringRope *rope, FILE *stream)
+{
+  for (const StringRopeChunk *chunk = rope->head; chunk; chunk = chunk->next)
+  {
+    if (fwrite(chunk->data, 1, chunk->len, stream) != chunk->len)
+      return false;
+  }
+  return true;
+}
+
+#if STRING_ROPE_HAS_IOVEC
+
+size_t
+string_rope_iovec(const StringRope *rope, StringRopeChunk **cursor, struct iovec *iov, size_t max_iov)
+{
+  (void)rope;
+  size_t n = 0;
+  StringRopeChunk *chunk = *cursor;
+  for (; chunk && n < max_iov; chunk = chunk->next)
+  {
+    /// 只有 vappend_fmt 换 chunk 时会留下空的 chunk
+    if (chunk->len == 0)
+      continue;
+    iov[n].iov_base = chunk->data;
+    iov[n].iov_len = chunk->len;
+    n++;
+  }
+  *cursor = chunk;
+  return n;
+}
+
+/** @brief 一次 writev 最多提交的 iovec 个数 */
+#if defined(IOV_MAX) && IOV_MAX < 64
+#define STRING_ROPE_WRITEV_BATCH IOV_MAX
+#else
+#define STRING_ROPE_WRITEV_BATCH 64
+#endif
+
+bool
+string_rope_writev(const StringRope *rope, int fd)
+{
+  StringRopeChunk *cursor = rope->head;
+  struct iovec iov[STRING_ROPE_WRITEV_BATCH];
+  size_t n;
+  while ((n = string_rope_iovec(rope, &cursor, iov, STRING_ROPE_WRITEV_BATCH)) > 0)
+  {
+    struct iovec *pending = iov;
+    while (n > 0)
+    {
+      ssize_t written = writev(fd, pending, (int)n);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+
+      /// 部分写入: 跳过已经写完的 iovec，调整第一个没写完的
+      size_t left = (size_t)written;
+      while (n > 0 && left >= pending->iov_len)
+      {
+        left -= pending->iov_len;
+        pending++;
+        n--;
+      }
+      if (n > 0)
+      {
+        pending->iov_base = (char *)pending->iov_base + left;
+        pending->iov_len -= left;
+      }
+    }
+  }
+  return true;
+}
+
+#endif
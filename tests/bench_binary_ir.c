@@ -0,0 +1,208 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ir/binary.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "utils/bump.h"
+#include "utils/string_buf.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 二进制 IR 与文本 IR 的保存/加载基准测试 ---
+ * =================================================================
+ *
+ * 生成一个有 BENCH_FUNCTIONS 个函数的模块，分别比较：
+ * - 保存: ir_module_dump_to_string vs ir_binary_write_module
+ * - 加载: ir_parse_module vs ir_binary_read_module
+ * - 延迟加载: ir_parse_module_lazy vs ir_binary_read_module_lazy (只加载函数头，再物化一个函数)
+ * 每项取 BENCH_ROUNDS 轮中的最好成绩。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  BENCH_FUNCTIONS = 2000,
+  BENCH_ROUNDS = 5,
+};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief 生成基准模块的文本：每个函数有一个循环、一次调用和若干算术指令
+ */
+static const char *
+generate_source(Bump *arena)
+{
+  StringBuf buf;
+  string_buf_init(&buf, arena);
+  string_buf_append_str(&buf, "module = \"bench_binary_ir\"\n\n");
+  string_buf_append_str(&buf, "@g_seed: <i32> = global 17: i32\n\n");
+  string_buf_append_str(&buf, "declare i32 @external(%x: i32)\n");
+
+  for (int i = 0; i < BENCH_FUNCTIONS; i++)
+  {
+    string_buf_append_fmt(&buf,
+                          "define i32 @f%d(%%n: i32, %%k: i32) {\n"
+                          "$entry:\n"
+                          "  %%acc_ptr: <i32> = alloc i32\n"
+                          "  %%seed: i32 = load @g_seed: <i32>\n"
+                          "  store %%seed: i32, %%acc_ptr: <i32>\n"
+                          "  br $loop\n"
+                          "$loop:\n"
+                          "  %%acc: i32 = load %%acc_ptr: <i32>\n"
+                          "  %%t: i32 = mul %%acc: i32, %d: i32\n"
+                          "  %%x: i32 = xor %%t: i32, %%k: i32\n"
+                          "  %%y: i32 = call <i32 (i32)> @external(%%x: i32)\n"
+                          "  %%z: i32 = add %%y: i32, -%d: i32\n"
+                          "  store %%z: i32, %%acc_ptr: <i32>\n"
+                          "  %%cmp: i1 = icmp slt %%z: i32, %%n: i32\n"
+                          "  br %%cmp: i1, $loop, $exit\n"
+                          "$exit:\n"
+                          "  %%f: f64 = sitofp %%z: i32 to f64\n"
+                          "  %%g: f64 = fmul %%f: f64, 1.5: f64\n"
+                          "  %%r: i32 = fptosi %%g: f64 to i32\n"
+                          "  ret %%r: i32\n"
+                          "}\n",
+                          i, i % 97 + 3, i % 13);
+  }
+  return string_buf_get(&buf);
+}
+
+static IRFunction *
+last_function(IRModule *mod)
+{
+  return list_entry(mod->functions.prev, IRFunction, list_node);
+}
+
+int
+main(void)
+{
+  Bump arena;
+  bump_init(&arena);
+
+  const char *source = generate_source(&arena);
+  size_t source_size = strlen(source);
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, source);
+  if (!mod)
+  {
+    fprintf(stderr, "Failed to parse the generated module\n");
+    ir_context_destroy(ctx);
+    bump_destroy(&arena);
+    return 1;
+  }
+
+  double best_dump = 1e300, best_write = 1e300, best_parse = 1e300, best_read = 1e300;
+  double best_lazy_parse = 1e300, best_lazy_read = 1e300;
+  size_t binary_size = 0;
+  int status = 0;
+
+  for (int round = 0; round < BENCH_ROUNDS && status == 0; round++)
+  {
+    Bump scratch;
+    bump_init(&scratch);
+
+    double start = now_ns();
+    const char *text = ir_module_dump_to_string(mod, &scratch);
+    double t_dump = now_ns() - start;
+
+    start = now_ns();
+    const uint8_t *data = ir_binary_write_module(mod, &scratch, &binary_size);
+    double t_write = now_ns() - start;
+
+    /// 每轮加载到新的上下文，避免常量/类型缓存已经预热
+    IRContext *text_ctx = ir_context_create();
+    start = now_ns();
+    IRModule *parsed = ir_parse_module(text_ctx, source);
+    double t_parse = now_ns() - start;
+
+    IRContext *binary_ctx = ir_context_create();
+    start = now_ns();
+    IRModule *decoded = data ? ir_binary_read_module(binary_ctx, data, binary_size) : NULL;
+    double t_read = now_ns() - start;
+
+    if (!parsed || !decoded || strcmp(ir_module_dump_to_string(decoded, &scratch), text) != 0)
+    {
+      fprintf(stderr, "Round %d: the binary round-trip does not match the text round-trip\n", round);
+      status = 1;
+    }
+
+    /// 延迟加载只为用到的函数付费：这里物化最后一个函数
+    IRContext *lazy_text_ctx = ir_context_create();
+    start = now_ns();
+    IRModule *lazy_parsed = ir_parse_module_lazy(lazy_text_ctx, source);
+    bool lazy_text_ok = lazy_parsed && ir_function_materialize(last_function(lazy_parsed));
+    double t_lazy_parse = now_ns() - start;
+
+    IRContext *lazy_binary_ctx = ir_context_create();
+    start = now_ns();
+    IRModule *lazy_decoded = data ? ir_binary_read_module_lazy(lazy_binary_ctx, data, binary_size) : NULL;
+    bool lazy_binary_ok = lazy_decoded && ir_function_materialize(last_function(lazy_decoded));
+    double t_lazy_read = now_ns() - start;
+
+    if (!lazy_text_ok || !lazy_binary_ok)
+    {
+      fprintf(stderr, "Round %d: lazy loading failed\n", round);
+      status = 1;
+    }
+
+    best_dump = t_dump < best_dump ? t_dump : best_dump;
+    best_write = t_write < best_write ? t_write : best_write;
+    best_parse = t_parse < best_parse ? t_parse : best_parse;
+    best_read = t_read < best_read ? t_read : best_read;
+    best_lazy_parse = t_lazy_parse < best_lazy_parse ? t_lazy_parse : best_lazy_parse;
+    best_lazy_read = t_lazy_read < best_lazy_read ? t_lazy_read : best_lazy_read;
+
+    ir_context_destroy(lazy_binary_ctx);
+    ir_context_destroy(lazy_text_ctx);
+    ir_context_destroy(binary_ctx);
+    ir_context_destroy(text_ctx);
+    bump_destroy(&scratch);
+  }
+
+  if (status == 0)
+  {
+    printf("Binary IR vs text IR (%d functions, best of %d rounds)\n", BENCH_FUNCTIONS, BENCH_ROUNDS);
+    printf("%-8s %14s %14s %10s\n", "", "text", "binary", "speedup");
+    printf("%-8s %13zuB %13zuB %9.2fx\n", "size", source_size, binary_size, (double)source_size / binary_size);
+    printf("%-8s %12.2fms %12.2fms %9.2fx\n", "save", best_dump / 1e6, best_write / 1e6, best_dump / best_write);
+    printf("%-8s %12.2fms %12.2fms %9.2fx\n", "load", best_parse / 1e6, best_read / 1e6, best_parse / best_read);
+    printf("%-8s %12.2fms %12.2fms %9.2fx\n", "lazy", best_lazy_parse / 1e6, best_lazy_read / 1e6,
+           best_lazy_parse / best_lazy_read);
+  }
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+  return status;
+}
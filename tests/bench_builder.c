@@ -0,0 +1,150 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/type.h"
+#include "utils/bump.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- Builder 指令构建基准测试 ---
+ * =================================================================
+ *
+ * 在一个函数中用 IRBuilder 生成 BENCH_INSTS 条指令 (每 BENCH_BLOCK_INSTS 条换一个
+ * 基本块；add / mul / icmp / select / load / store 轮流)，测量每条指令的耗时 (ns/inst)：
+ * - one by one:       逐条分配 (默认)，由 Builder 生成临时名
+ * - reserved:         每个基本块开始时用 ir_builder_reserve 预留整块的指令和操作数
+ * - named one by one: 逐条分配，每条指令都给出同一个 name_hint (不生成临时名)
+ * - named reserved:   预留 + name_hint (只剩分配和链接的开销)
+ * 每项在全新的上下文上运行，取 BENCH_ROUNDS 轮中的最好成绩；同时报告函数体 Arena 的容量。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  BENCH_INSTS = 1000000,
+  BENCH_BLOCK_INSTS = 64,
+  BENCH_ROUNDS = 5,
+};
+
+typedef enum
+{
+  CASE_ONE_BY_ONE,
+  CASE_RESERVED,
+  CASE_NAMED_ONE_BY_ONE,
+  CASE_NAMED_RESERVED,
+  NUM_CASES
+} BenchCase;
+
+static const char *const CASE_NAMES[NUM_CASES] = {"one by one", "reserved", "named one by one",
+                                                      "named reserved"};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief 在全新的上下文上运行一项，返回耗时 (ns)
+ */
+static double
+run_case(BenchCase which, size_t *out_arena_bytes)
+{
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "bench");
+  IRType *i64 = ir_type_get_i64(ctx);
+  IRFunction *func = ir_function_create(mod, "f", i64);
+  IRArgument *a = ir_argument_create(func, i64, "a");
+  ir_function_finalize_signature(func, false);
+  IRBuilder *b = ir_builder_create(ctx);
+
+  double start = now_ns();
+  IRBasicBlock *bb = ir_basic_block_create(func, "entry");
+  ir_function_append_basic_block(func, bb);
+  ir_builder_set_insertion_point(b, bb);
+
+  bool named = which == CASE_NAMED_ONE_BY_ONE || which == CASE_NAMED_RESERVED;
+  bool reserved = which == CASE_RESERVED || which == CASE_NAMED_RESERVED;
+  const char *hint = named ? "v" : NULL;
+  IRValueNode *slot = ir_builder_create_alloca(b, i64, hint);
+  IRValueNode *acc = &a->value;
+  IRValueNode *one = ir_constant_get_i64(ctx, 1);
+
+  /// 每 6 条指令一轮: add、mul、icmp、select、store、load (共 12 个操作数)，每块最后一条 br
+  if (reserved)
+    ir_builder_reserve(b, BENCH_BLOCK_INSTS + 8, BENCH_BLOCK_INSTS * 2 + 16);
+
+  for (int i = 0; i < BENCH_INSTS; i += 6)
+  {
+    if (i % BENCH_BLOCK_INSTS < 6 && i > 0)
+    {
+      IRBasicBlock *next = ir_basic_block_create(func, "b");
+      ir_function_append_basic_block(func, next);
+      ir_builder_create_br(b, &next->label_address);
+      ir_builder_set_insertion_point(b, next);
+      if (reserved)
+        ir_builder_reserve(b, BENCH_BLOCK_INSTS + 8, BENCH_BLOCK_INSTS * 2 + 16);
+    }
+    IRValueNode *sum = ir_builder_create_add(b, acc, one, hint);
+    IRValueNode *prod = ir_builder_create_mul(b, sum, acc, hint);
+    IRValueNode *cmp = ir_builder_create_icmp(b, IR_ICMP_SLT, prod, sum, hint);
+    IRValueNode *sel = ir_builder_create_select(b, cmp, prod, sum, hint);
+    ir_builder_create_store(b, sel, slot);
+    acc = ir_builder_create_load(b, slot, hint);
+  }
+  ir_builder_create_ret(b, acc);
+  double ns = now_ns() - start;
+
+  *out_arena_bytes = bump_get_allocated_bytes(ir_function_body_arena(func));
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+  return ns;
+}
+
+int
+main(void)
+{
+  printf("Builder instruction creation (%d instructions, best of %d rounds)\n", BENCH_INSTS, BENCH_ROUNDS);
+  for (int which = 0; which < NUM_CASES; which++)
+  {
+    double best = 1e300;
+    size_t arena_bytes = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+      double ns = run_case((BenchCase)which, &arena_bytes);
+      if (ns < best)
+        best = ns;
+    }
+    printf("  %-18s %8.2f ns/inst %10.1fMB arena\n", CASE_NAMES[which], best / BENCH_INSTS,
+           (double)arena_bytes / (1024.0 * 1024.0));
+  }
+  return 0;
+}
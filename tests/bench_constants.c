@@ -0,0 +1,144 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ir/constant.h"
+#include "ir/context.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 常量创建基准测试 ---
+ * =================================================================
+ *
+ * 测量 ir_constant_get_* 每次调用的耗时 (ns/op)：
+ * - small i32 / small i64: IR_SMALL_INT_MIN..IR_SMALL_INT_MAX 之间的值 (小整数表)
+ * - i8:                    整个 i8 取值范围
+ * - cached i32:            表外、已经在哈希表里的值
+ * - fresh i64:             每次都是新值 (哈希表未命中 + 创建)
+ * - cached f64:            已经在哈希表里的浮点值
+ * 每项在全新的上下文上运行 BENCH_OPS 次调用，取 BENCH_ROUNDS 轮中的最好成绩。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  BENCH_OPS = 4000000,
+  BENCH_ROUNDS = 5,
+  /** cached 两项反复使用的不同值的个数 */
+  BENCH_DISTINCT = 4096,
+};
+
+typedef enum
+{
+  CASE_SMALL_I32,
+  CASE_SMALL_I64,
+  CASE_I8,
+  CASE_CACHED_I32,
+  CASE_FRESH_I64,
+  CASE_CACHED_F64,
+  NUM_CASES
+} BenchCase;
+
+static const char *const CASE_NAMES[NUM_CASES] = {"small i32", "small i64", "i8", "cached i32",
+                                                  "fresh i64", "cached f64"};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief 在全新的上下文上运行一项，返回耗时 (ns)
+ */
+static double
+run_case(BenchCase which, uintptr_t *sink)
+{
+  IRContext *ctx = ir_context_create();
+  const int64_t span = IR_SMALL_INT_MAX - IR_SMALL_INT_MIN + 1;
+
+  /// cached 两项先把值放进哈希表，计时只包括命中
+  if (which == CASE_CACHED_I32)
+    for (int i = 0; i < BENCH_DISTINCT; i++)
+      ir_constant_get_i32(ctx, 100000 + i);
+  if (which == CASE_CACHED_F64)
+    for (int i = 0; i < BENCH_DISTINCT; i++)
+      ir_constant_get_f64(ctx, 0.5 + i);
+
+  uintptr_t acc = 0;
+  double start = now_ns();
+  for (int i = 0; i < BENCH_OPS; i++)
+  {
+    IRValueNode *k = NULL;
+    switch (which)
+    {
+    case CASE_SMALL_I32:
+      k = ir_constant_get_i32(ctx, (int32_t)(IR_SMALL_INT_MIN + i % span));
+      break;
+    case CASE_SMALL_I64:
+      k = ir_constant_get_i64(ctx, IR_SMALL_INT_MIN + i % span);
+      break;
+    case CASE_I8:
+      k = ir_constant_get_i8(ctx, (int8_t)i);
+      break;
+    case CASE_CACHED_I32:
+      k = ir_constant_get_i32(ctx, 100000 + i % BENCH_DISTINCT);
+      break;
+    case CASE_FRESH_I64:
+      k = ir_constant_get_i64(ctx, (int64_t)1 << 40 | i);
+      break;
+    case CASE_CACHED_F64:
+      k = ir_constant_get_f64(ctx, 0.5 + i % BENCH_DISTINCT);
+      break;
+    default:
+      break;
+    }
+    acc += (uintptr_t)k;
+  }
+  double ns = now_ns() - start;
+
+  *sink += acc;
+  ir_context_destroy(ctx);
+  return ns;
+}
+
+int
+main(void)
+{
+  uintptr_t sink = 0;
+  printf("Constant creation (%d calls, best of %d rounds)\n", BENCH_OPS, BENCH_ROUNDS);
+  for (int which = 0; which < NUM_CASES; which++)
+  {
+    double best = 1e300;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+      double ns = run_case((BenchCase)which, &sink);
+      if (ns < best)
+        best = ns;
+    }
+    printf("  %-12s %8.2f ns/op\n", CASE_NAMES[which], best / BENCH_OPS);
+  }
+  /// 防止编译器把调用优化掉
+  return sink == 1 ? 2 : 0;
+}
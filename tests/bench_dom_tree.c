@@ -0,0 +1,400 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "analysis/dom_update.h"
+#include "analysis/loop_info.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/type.h"
+#include "utils/bump.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 支配树构建基准测试 ---
+ * =================================================================
+ *
+ * 对比 Lengauer-Tarjan 与 Cooper-Harvey-Kennedy 在几种 CFG 形状上的构建耗时
+ * (ns/block，只计 dom_tree_build_with_algorithm，CFG 事先建好)：
+ * - small random:  SMALL_FUNCS 个 SMALL_BLOCKS 块的小函数，分支目标随机 (可能不可归约)
+ * - huge diamonds: 一个由 HUGE_DIAMONDS 个菱形串起来的函数 (支配树很深)
+ * - huge loops:    一个 HUGE_BLOCKS 块的函数，分支大多向前，偶尔跳回前面 (嵌套的循环)
+ * 每项取 BENCH_ROUNDS 轮中的最好成绩。
+ *
+ * 接着在两个大函数上测量支配边界 (ns/block 和 Arena 占用) 与迭代支配边界:
+ * 对 IDF_QUERIES 组随机的定义块 (每组 4 个) 调用 ir_analysis_idf_compute (us/query)。
+ * 以及循环嵌套森林 loop_info_compute 的耗时 (ns/block)、循环数和最大嵌套深度。
+ *
+ * 最后对比 CFG 修改之后的两种做法 (ns/update): 用 analysis/dom_update.h 增量更新支配树，
+ * 还是每次都重新 dom_tree_build。在 UPDATE_BLOCKS 块的 "loops" 形状上交替插入和删除
+ * UPDATE_EDITS 条随机的局部边 (目标在源的前后 8 个块之内)。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  SMALL_FUNCS = 20000,
+  SMALL_BLOCKS = 16,
+  HUGE_DIAMONDS = 100000,
+  HUGE_BLOCKS = 300000,
+  UPDATE_BLOCKS = 20000,
+  UPDATE_EDITS = 200,
+  IDF_QUERIES = 200,
+  BENCH_ROUNDS = 5,
+};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t
+next_random(uint32_t *seed)
+{
+  *seed = *seed * 1664525u + 1013904223u;
+  return *seed >> 8;
+}
+
+/**
+ * @brief 创建一个带 i1 参数的空函数和 num_blocks 个基本块
+ */
+static IRFunction *
+create_blocks(IRModule *mod, IRBasicBlock **blocks, int num_blocks, IRValueNode **out_cond)
+{
+  IRContext *ctx = mod->context;
+  IRFunction *func = ir_function_create(mod, "f", ir_type_get_void(ctx));
+  *out_cond = &ir_argument_create(func, ir_type_get_i1(ctx), "c")->value;
+  ir_function_finalize_signature(func, false);
+  for (int i = 0; i < num_blocks; i++)
+  {
+    blocks[i] = ir_basic_block_create(func, "b");
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+  return func;
+}
+
+/** @brief 小函数: 每个块以 ret、br 或条件 br 结束，目标在整个函数中随机 */
+static IRFunction *
+build_small_random(IRModule *mod, IRBuilder *b, uint32_t *seed)
+{
+  IRBasicBlock *blocks[SMALL_BLOCKS];
+  IRValueNode *cond;
+  IRFunction *func = create_blocks(mod, blocks, SMALL_BLOCKS, &cond);
+  for (int i = 0; i < SMALL_BLOCKS; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    uint32_t r = next_random(seed);
+    IRBasicBlock *t = blocks[(r >> 4) % SMALL_BLOCKS];
+    IRBasicBlock *f = blocks[(r >> 12) % SMALL_BLOCKS];
+    if (r % 8 == 0)
+      ir_builder_create_ret(b, NULL);
+    else if (r % 8 < 4)
+      ir_builder_create_br(b, &t->label_address);
+    else
+      ir_builder_create_cond_br(b, cond, &t->label_address, &f->label_address);
+  }
+  return func;
+}
+
+/** @brief head[i] -> (left[i] | right[i]) -> head[i + 1] */
+static IRFunction *
+build_huge_diamonds(IRModule *mod, IRBuilder *b, IRBasicBlock **blocks)
+{
+  int num_blocks = 3 * HUGE_DIAMONDS + 1;
+  IRValueNode *cond;
+  IRFunction *func = create_blocks(mod, blocks, num_blocks, &cond);
+  for (int i = 0; i < HUGE_DIAMONDS; i++)
+  {
+    IRBasicBlock *head = blocks[3 * i];
+    IRBasicBlock *left = blocks[3 * i + 1];
+    IRBasicBlock *right = blocks[3 * i + 2];
+    IRBasicBlock *next = blocks[3 * i + 3];
+    ir_builder_set_insertion_point(b, head);
+    ir_builder_create_cond_br(b, cond, &left->label_address, &right->label_address);
+    ir_builder_set_insertion_point(b, left);
+    ir_builder_create_br(b, &next->label_address);
+    ir_builder_set_insertion_point(b, right);
+    ir_builder_create_br(b, &next->label_address);
+  }
+  ir_builder_set_insertion_point(b, blocks[num_blocks - 1]);
+  ir_builder_create_ret(b, NULL);
+  return func;
+}
+
+/**
+ * @brief 对一个 CFG 做 UPDATE_EDITS 次修改 (插入随机的边，下一次再删掉它)，返回 ns/update
+ */
+static double
+bench_updates(IRFunction *func, IRBasicBlock **blocks, int num_blocks, bool incremental)
+{
+  double best = 1e300;
+  for (int round = 0; round < BENCH_ROUNDS; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+    uint32_t seed = 7;
+
+    double start = now_ns();
+    for (int i = 0; i < UPDATE_EDITS; i += 2)
+    {
+      uint32_t r = next_random(&seed);
+      /// 变换通常只改局部的控制流: 目标在源附近
+      int from_index = (int)(r % (uint32_t)(num_blocks - 16)) + 8;
+      IRBasicBlock *from = blocks[from_index];
+      IRBasicBlock *to = blocks[from_index - 8 + (int)((r >> 20) % 17)];
+      for (int step = 0; step < 2; step++)
+      {
+        if (incremental)
+        {
+          if (step == 0)
+            dom_tree_insert_edge(tree, NULL, from, to);
+          else
+            dom_tree_delete_edge(tree, NULL, from, to);
+        }
+        else
+        {
+          if (step == 0)
+            cfg_insert_edge(cfg, from, to);
+          else
+            cfg_remove_edge(cfg, from, to);
+          Bump scratch;
+          bump_init(&scratch);
+          dom_tree_build(cfg, &scratch);
+          bump_destroy(&scratch);
+        }
+      }
+    }
+    double ns = now_ns() - start;
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+    if (ns < best)
+      best = ns;
+  }
+  return best / UPDATE_EDITS;
+}
+
+/** @brief 每个块条件跳到后面 1..8 个块之一，或 (1/8 的概率) 跳回前面 1..64 个块之一 */
+static IRFunction *
+build_huge_loops(IRModule *mod, IRBuilder *b, IRBasicBlock **blocks, int num_blocks, uint32_t *seed)
+{
+  IRValueNode *cond;
+  IRFunction *func = create_blocks(mod, blocks, num_blocks, &cond);
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    if (i == num_blocks - 1)
+    {
+      ir_builder_create_ret(b, NULL);
+      continue;
+    }
+    uint32_t r = next_random(seed);
+    IRBasicBlock *fallthrough = blocks[i + 1];
+    int target = (r % 8 == 0) ? i - 1 - (int)((r >> 3) % 64) : i + 1 + (int)((r >> 3) % 8);
+    if (target < 0)
+      target = 0;
+    if (target >= num_blocks)
+      target = num_blocks - 1;
+    ir_builder_create_cond_br(b, cond, &blocks[target]->label_address, &fallthrough->label_address);
+  }
+  return func;
+}
+
+/**
+ * @brief 对一组 CFG 测量一种算法，返回最好一轮的 ns/block
+ */
+static double
+bench_algorithm(FunctionCFG **cfgs, size_t num_cfgs, DomTreeAlgorithm algorithm)
+{
+  size_t total_blocks = 0;
+  for (size_t i = 0; i < num_cfgs; i++)
+    total_blocks += (size_t)cfgs[i]->num_nodes;
+
+  double best = 1e300;
+  for (int round = 0; round < BENCH_ROUNDS; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    double start = now_ns();
+    for (size_t i = 0; i < num_cfgs; i++)
+    {
+      DominatorTree *tree = dom_tree_build_with_algorithm(cfgs[i], &arena, algorithm);
+      dom_tree_destroy(tree);
+    }
+    double ns = now_ns() - start;
+    bump_destroy(&arena);
+    if (ns < best)
+      best = ns;
+  }
+  return best / (double)total_blocks;
+}
+
+static void
+report(const char *shape, FunctionCFG **cfgs, size_t num_cfgs)
+{
+  double lt = bench_algorithm(cfgs, num_cfgs, DOM_TREE_LENGAUER_TARJAN);
+  double chk = bench_algorithm(cfgs, num_cfgs, DOM_TREE_COOPER_HARVEY_KENNEDY);
+  printf("  %-14s %10.2f ns/block (Lengauer-Tarjan) %10.2f ns/block (Cooper-Harvey-Kennedy)\n", shape, lt, chk);
+}
+
+/**
+ * @brief arena 实际分配出去的字节数 (各 chunk 尾部到 ptr 之间)
+ */
+static size_t
+arena_used_bytes(Bump *arena)
+{
+  size_t used = 0;
+  /// 链表以一个空的哨兵 chunk 结尾 (chunk_size 为 0)
+  for (ChunkFooter *chunk = arena->current_chunk_footer; chunk->chunk_size != 0; chunk = chunk->prev)
+    used += (size_t)((unsigned char *)chunk - chunk->ptr);
+  return used;
+}
+
+/**
+ * @brief 测量支配边界的构建 (支配边界单独放在一个 arena 中) 和 IDF 查询
+ */
+static void
+report_frontier(const char *shape, FunctionCFG *cfg, uint32_t *seed)
+{
+  double best = 1e300;
+  size_t bytes = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++)
+  {
+    Bump arena, df_arena;
+    bump_init(&arena);
+    bump_init(&df_arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+    double start = now_ns();
+    ir_analysis_dom_frontier_compute(tree, &df_arena);
+    double ns = now_ns() - start;
+    bytes = arena_used_bytes(&df_arena);
+    bump_destroy(&df_arena);
+    bump_destroy(&arena);
+    if (ns < best)
+      best = ns;
+  }
+
+  Bump arena;
+  bump_init(&arena);
+  DominatorTree *tree = dom_tree_build(cfg, &arena);
+  IDFCalculator calc;
+  int *out = BUMP_ALLOC_SLICE(&arena, int, (size_t)cfg->num_nodes);
+  double idf_ns = 0;
+  if (out && ir_analysis_idf_init(&calc, tree, &arena))
+  {
+    double start = now_ns();
+    for (int q = 0; q < IDF_QUERIES; q++)
+    {
+      int defs[4];
+      for (int k = 0; k < 4; k++)
+        defs[k] = (int)(next_random(seed) % (uint32_t)cfg->num_nodes);
+      ir_analysis_idf_compute(&calc, defs, 4, out);
+    }
+    idf_ns = (now_ns() - start) / IDF_QUERIES;
+  }
+  bump_destroy(&arena);
+
+  printf("  %-14s %10.2f ns/block (frontier) %10.1f MB arena %10.2f us/query (IDF)\n", shape,
+         best / (double)cfg->num_nodes, (double)bytes / (1024.0 * 1024.0), idf_ns / 1e3);
+}
+
+/**
+ * @brief 测量循环嵌套森林的构建
+ */
+static void
+report_loops(const char *shape, FunctionCFG *cfg)
+{
+  double best = 1e300;
+  int num_loops = 0;
+  int max_depth = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+    double start = now_ns();
+    LoopInfo *li = loop_info_compute(tree, &arena);
+    double ns = now_ns() - start;
+    num_loops = li->num_loops;
+    for (int i = 0; i < li->num_loops; i++)
+    {
+      if (li->loops[i]->depth > max_depth)
+        max_depth = li->loops[i]->depth;
+    }
+    bump_destroy(&arena);
+    if (ns < best)
+      best = ns;
+  }
+  printf("  %-14s %10.2f ns/block (loop info) %8d loops %8d max depth\n", shape, best / (double)cfg->num_nodes,
+         num_loops, max_depth);
+}
+
+int
+main(void)
+{
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "bench");
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 2025;
+  Bump cfg_arena;
+  bump_init(&cfg_arena);
+
+  printf("Dominator tree construction (best of %d rounds)\n", BENCH_ROUNDS);
+
+  static FunctionCFG *small[SMALL_FUNCS];
+  for (int i = 0; i < SMALL_FUNCS; i++)
+    small[i] = cfg_build(build_small_random(mod, b, &seed), &cfg_arena);
+  report("small random", small, SMALL_FUNCS);
+
+  static IRBasicBlock *blocks[HUGE_BLOCKS > 3 * HUGE_DIAMONDS + 1 ? HUGE_BLOCKS : 3 * HUGE_DIAMONDS + 1];
+  FunctionCFG *diamonds = cfg_build(build_huge_diamonds(mod, b, blocks), &cfg_arena);
+  report("huge diamonds", &diamonds, 1);
+
+  FunctionCFG *loops = cfg_build(build_huge_loops(mod, b, blocks, HUGE_BLOCKS, &seed), &cfg_arena);
+  report("huge loops", &loops, 1);
+
+  printf("Dominance frontiers, iterated frontiers and loops (best of %d rounds)\n", BENCH_ROUNDS);
+  report_frontier("huge diamonds", diamonds, &seed);
+  report_frontier("huge loops", loops, &seed);
+  report_loops("huge diamonds", diamonds);
+  report_loops("huge loops", loops);
+
+  IRFunction *func = build_huge_loops(mod, b, blocks, UPDATE_BLOCKS, &seed);
+  printf("CFG edits on %d blocks (%d edits)\n", UPDATE_BLOCKS, UPDATE_EDITS);
+  printf("  %-14s %10.2f us/update\n", "incremental", bench_updates(func, blocks, UPDATE_BLOCKS, true) / 1e3);
+  printf("  %-14s %10.2f us/update\n", "rebuild", bench_updates(func, blocks, UPDATE_BLOCKS, false) / 1e3);
+
+  bump_destroy(&cfg_arena);
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+  return 0;
+}
@@ -0,0 +1,479 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/interpreter.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "utils/data_layout.h"
+#include "utils/id_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 解释器分派引擎基准测试 ---
+ * =================================================================
+ *
+ * 在同一份 IR 上分别用 switch 引擎和直接线程化引擎运行，
+ * 比较每次调用的耗时。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+static const char *BENCH_SOURCE = "module = \"bench_interpreter\"\n"
+                                  "\n"
+                                  "define i32 @loop_sum(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %i_ptr: <i32> = alloc i32\n"
+                                  "  %acc_ptr: <i32> = alloc i32\n"
+                                  "  store 0: i32, %i_ptr: <i32>\n"
+                                  "  store 0: i32, %acc_ptr: <i32>\n"
+                                  "  br $loop\n"
+                                  "$loop:\n"
+                                  "  %i: i32 = load %i_ptr: <i32>\n"
+                                  "  %acc: i32 = load %acc_ptr: <i32>\n"
+                                  "  %t: i32 = mul %i: i32, 3: i32\n"
+                                  "  %x: i32 = xor %t: i32, %acc: i32\n"
+                                  "  %acc_next: i32 = add %x: i32, 1: i32\n"
+                                  "  store %acc_next: i32, %acc_ptr: <i32>\n"
+                                  "  %i_next: i32 = add %i: i32, 1: i32\n"
+                                  "  store %i_next: i32, %i_ptr: <i32>\n"
+                                  "  %cmp: i1 = icmp slt %i_next: i32, %n: i32\n"
+                                  "  br %cmp: i1, $loop, $exit\n"
+                                  "$exit:\n"
+                                  "  ret %acc_next: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "define i32 @fib(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %cmp: i1 = icmp slt %n: i32, 2: i32\n"
+                                  "  br %cmp: i1, $base, $rec\n"
+                                  "$base:\n"
+                                  "  ret %n: i32\n"
+                                  "$rec:\n"
+                                  "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                  "  %f1: i32 = call <i32 (i32)> @fib(%n1: i32)\n"
+                                  "  %n2: i32 = sub %n: i32, 2: i32\n"
+                                  "  %f2: i32 = call <i32 (i32)> @fib(%n2: i32)\n"
+                                  "  %r: i32 = add %f1: i32, %f2: i32\n"
+                                  "  ret %r: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "define i32 @ack(%m: i32, %n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %m_zero: i1 = icmp eq %m: i32, 0: i32\n"
+                                  "  br %m_zero: i1, $m0, $check_n\n"
+                                  "$m0:\n"
+                                  "  %n_inc: i32 = add %n: i32, 1: i32\n"
+                                  "  ret %n_inc: i32\n"
+                                  "$check_n:\n"
+                                  "  %m1: i32 = sub %m: i32, 1: i32\n"
+                                  "  %n_zero: i1 = icmp eq %n: i32, 0: i32\n"
+                                  "  br %n_zero: i1, $n0, $rec\n"
+                                  "$n0:\n"
+                                  "  %a0: i32 = call <i32 (i32, i32)> @ack(%m1: i32, 1: i32)\n"
+                                  "  ret %a0: i32\n"
+                                  "$rec:\n"
+                                  "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                  "  %inner: i32 = call <i32 (i32, i32)> @ack(%m: i32, %n1: i32)\n"
+                                  "  %a1: i32 = call <i32 (i32, i32)> @ack(%m1: i32, %inner: i32)\n"
+                                  "  ret %a1: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "define i32 @ack2(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %r: i32 = call <i32 (i32, i32)> @ack(2: i32, %n: i32)\n"
+                                  "  ret %r: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "define i32 @hash(%x: i32) {\n"
+                                  "$entry:\n"
+                                  "  %a: i32 = mul %x: i32, 73244475: i32\n"
+                                  "  %b: i32 = lshr %a: i32, 16: i32\n"
+                                  "  %c: i32 = xor %a: i32, %b: i32\n"
+                                  "  %d: i32 = mul %c: i32, 73244475: i32\n"
+                                  "  %e: i32 = lshr %d: i32, 16: i32\n"
+                                  "  %f: i32 = xor %d: i32, %e: i32\n"
+                                  "  %g: i32 = and %f: i32, 1023: i32\n"
+                                  "  %small: i1 = icmp ult %g: i32, 512: i32\n"
+                                  "  br %small: i1, $low, $high\n"
+                                  "$low:\n"
+                                  "  ret %g: i32\n"
+                                  "$high:\n"
+                                  "  %h: i32 = sub %f: i32, %g: i32\n"
+                                  "  ret %h: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "declare i64 @host_mix(i64, i64)\n"
+                                  "\n"
+                                  "define i32 @ffi_loop(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %i_ptr: <i32> = alloc i32\n"
+                                  "  %acc_ptr: <i64> = alloc i64\n"
+                                  "  store 0: i32, %i_ptr: <i32>\n"
+                                  "  store 1: i64, %acc_ptr: <i64>\n"
+                                  "  br $loop\n"
+                                  "$loop:\n"
+                                  "  %i: i32 = load %i_ptr: <i32>\n"
+                                  "  %acc: i64 = load %acc_ptr: <i64>\n"
+                                  "  %wide: i64 = sext %i: i32 to i64\n"
+                                  "  %mixed: i64 = call <i64 (i64, i64)> @host_mix(%acc: i64, %wide: i64)\n"
+                                  "  store %mixed: i64, %acc_ptr: <i64>\n"
+                                  "  %i_next: i32 = add %i: i32, 1: i32\n"
+                                  "  store %i_next: i32, %i_ptr: <i32>\n"
+                                  "  %cmp: i1 = icmp slt %i_next: i32, %n: i32\n"
+                                  "  br %cmp: i1, $loop, $exit\n"
+                                  "$exit:\n"
+                                  "  %r: i32 = trunc %mixed: i64 to i32\n"
+                                  "  ret %r: i32\n"
+                                  "}\n";
+
+typedef struct BenchCase
+{
+  const char *func_name;
+  int32_t arg;
+  int iterations;
+} BenchCase;
+
+static const BenchCase BENCH_CASES[] = {
+  {"loop_sum", 100000, 20},
+  {"fib", 20, 5},
+  {"ack2", 200, 5},
+};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static IRFunction *
+find_function(IRModule *mod, const char *name)
+{
+  IDList *it;
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *f = list_entry(it, IRFunction, list_node);
+    if (strcmp(f->entry_address.name, name) == 0)
+      return f;
+  }
+  return NULL;
+}
+
+/** @brief 批量基准: 每次调用的 lane 数与重复次数 */
+#define BENCH_BATCH_LANES 4096
+#define BENCH_BATCH_ITERATIONS 20
+
+/**
+ * @brief 用指定引擎运行一个基准用例，返回平均每次调用的纳秒数 (失败返回 -1)
+ */
+static double
+run_case(Interpreter *interp, InterpreterEngine engine, IRFunction *func, const BenchCase *bc, int32_t *result_out)
+{
+  if (!interpreter_set_engine(interp, engine))
+    return -1.0;
+
+  RuntimeValue rt_arg;
+  rt_arg.kind = RUNTIME_VAL_I32;
+  rt_arg.as.val_i32 = bc->arg;
+  RuntimeValue *args[] = {&rt_arg};
+  RuntimeValue result;
+
+  /// 预热 (同时构建并缓存执行计划)
+  if (!interpreter_run_function(interp, func, args, 1, &result))
+    return -1.0;
+
+  double start = now_ns();
+  for (int i = 0; i < bc->iterations; i++)
+  {
+    if (!interpreter_run_function(interp, func, args, 1, &result))
+      return -1.0;
+  }
+  double elapsed = now_ns() - start;
+
+  *result_out = result.as.val_i32;
+  return elapsed / bc->iterations;
+}
+
+/**
+ * @brief 比较逐个调用与批量调用同一个函数 (结果不一致时返回 false)
+ */
+static bool
+run_batch_bench(Interpreter *interp, IRFunction *func)
+{
+  static RuntimeValue inputs[BENCH_BATCH_LANES];
+  static RuntimeValue scalar_results[BENCH_BATCH_LANES];
+  static RuntimeValue batch_results[BENCH_BATCH_LANES];
+  for (int l = 0; l < BENCH_BATCH_LANES; l++)
+  {
+    inputs[l].kind = RUNTIME_VAL_I32;
+    inputs[l].as.val_i32 = l * 7919;
+  }
+  RuntimeValue *columns[] = {inputs};
+
+  double start = now_ns();
+  for (int it = 0; it < BENCH_BATCH_ITERATIONS; it++)
+  {
+    for (int l = 0; l < BENCH_BATCH_LANES; l++)
+    {
+      RuntimeValue *args[] = {&inputs[l]};
+      if (!interpreter_run_function(interp, func, args, 1, &scalar_results[l]))
+        return false;
+    }
+  }
+  double ns_scalar = (now_ns() - start) / ((double)BENCH_BATCH_ITERATIONS * BENCH_BATCH_LANES);
+
+  start = now_ns();
+  for (int it = 0; it < BENCH_BATCH_ITERATIONS; it++)
+  {
+    if (!interpreter_run_function_batch(interp, func, columns, 1, BENCH_BATCH_LANES, batch_results))
+      return false;
+  }
+  double ns_batch = (now_ns() - start) / ((double)BENCH_BATCH_ITERATIONS * BENCH_BATCH_LANES);
+
+  for (int l = 0; l < BENCH_BATCH_LANES; l++)
+  {
+    if (scalar_results[l].as.val_i32 != batch_results[l].as.val_i32)
+    {
+      fprintf(stderr, "'@%s': batch result differs on lane %d.\n", func->entry_address.name, l);
+      return false;
+    }
+  }
+
+  printf("\n%-12s %16s %18s %10s\n", "workload", "scalar (ns/lane)", "batch (ns/lane)", "speedup");
+  printf("%-12s %16.1f %18.1f %9.2fx\n", func->entry_address.name, ns_scalar, ns_batch, ns_scalar / ns_batch);
+  return true;
+}
+
+/**
+ * @brief 对比解释执行与 JIT 编译后运行同一组用例 (结果不一致时返回 false)
+ */
+static bool
+run_jit_bench(Interpreter *interp, IRModule *mod)
+{
+  if (!interpreter_set_jit(interp, true))
+  {
+    printf("\n(JIT not available on this platform)\n");
+    return true;
+  }
+  interpreter_set_jit_threshold(interp, 0);
+
+  bool ok = true;
+  InterpreterEngine engine = CALICO_HAS_THREADED_ENGINE ? INTERP_ENGINE_THREADED : INTERP_ENGINE_SWITCH;
+  printf("\n%-12s %16s %18s %10s\n", "workload", "interp (ns/call)", "jit (ns/call)", "speedup");
+  for (size_t i = 0; i < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); i++)
+  {
+    const BenchCase *bc = &BENCH_CASES[i];
+    IRFunction *func = find_function(mod, bc->func_name);
+    if (func == NULL)
+      continue;
+
+    int32_t res_interp = 0;
+    int32_t res_jit = 0;
+    interpreter_set_jit(interp, false);
+    double ns_interp = run_case(interp, engine, func, bc, &res_interp);
+    interpreter_set_jit(interp, true);
+    /// 预热调用会编译被调用到的所有函数
+    double ns_jit = run_case(interp, engine, func, bc, &res_jit);
+
+    if (ns_interp < 0 || ns_jit < 0 || res_interp != res_jit)
+    {
+      fprintf(stderr, "'@%s': JIT run failed or disagrees (%d vs %d).\n", bc->func_name, res_interp, res_jit);
+      ok = false;
+      continue;
+    }
+    printf("%-12s %16.0f %18.0f %9.2fx\n", bc->func_name, ns_interp, ns_jit, ns_interp / ns_jit);
+  }
+
+  interpreter_set_jit(interp, false);
+  return ok;
+}
+
+/// 基准中调用的宿主函数: 装箱 (CalicoHostFunction) 与类型化两种形式
+static int64_t
+host_mix(int64_t acc, int64_t i)
+{
+  return acc * 31 + (i ^ (acc >> 7));
+}
+
+static ExecutionResultKind
+host_mix_boxed(ExecutionContext *ctx, RuntimeValue **args, size_t num_args, RuntimeValue *result_out)
+{
+  (void)ctx;
+  (void)num_args;
+  result_out->kind = RUNTIME_VAL_I64;
+  result_out->as.val_i64 = host_mix(args[0]->as.val_i64, args[1]->as.val_i64);
+  return EXEC_OK;
+}
+
+/**
+ * @brief 比较内层循环调用装箱宿主函数与类型化宿主函数 (结果不一致时返回 false)
+ */
+static bool
+run_ffi_bench(Interpreter *interp, IRModule *mod)
+{
+  IRFunction *func = find_function(mod, "ffi_loop");
+  if (func == NULL)
+    return false;
+
+  const BenchCase bc = {"ffi_loop", 100000, 20};
+  InterpreterEngine engine = CALICO_HAS_THREADED_ENGINE ? INTERP_ENGINE_THREADED : INTERP_ENGINE_SWITCH;
+  int32_t res_boxed = 0;
+  int32_t res_typed = 0;
+
+  interpreter_register_external_function(interp, "host_mix", host_mix_boxed);
+  double ns_boxed = run_case(interp, engine, func, &bc, &res_boxed);
+  if (!interpreter_register_typed_function(interp, "host_mix", (CalicoTypedHostFunction)host_mix, CALICO_HOST_I64,
+                                           CALICO_HOST_I64, 2))
+    return false;
+  double ns_typed = run_case(interp, engine, func, &bc, &res_typed);
+
+  if (ns_boxed < 0 || ns_typed < 0 || res_boxed != res_typed)
+  {
+    fprintf(stderr, "'@ffi_loop': FFI run failed or disagrees (%d vs %d).\n", res_boxed, res_typed);
+    return false;
+  }
+  printf("\n%-12s %16s %18s %10s\n", "workload", "boxed (ns/call)", "typed (ns/call)", "speedup");
+  printf("%-12s %16.0f %18.0f %9.2fx\n", bc.func_name, ns_boxed, ns_typed, ns_boxed / ns_typed);
+  return true;
+}
+
+/**
+ * @brief 比较关闭 / 开启纯函数备忘时重复调用同一组用例 (结果不一致时返回 false)
+ */
+static bool
+run_memo_bench(Interpreter *interp, IRModule *mod)
+{
+  InterpreterEngine engine = CALICO_HAS_THREADED_ENGINE ? INTERP_ENGINE_THREADED : INTERP_ENGINE_SWITCH;
+  printf("\n%-12s %16s %18s %10s\n", "workload", "plain (ns/call)", "memo (ns/call)", "speedup");
+
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); i++)
+  {
+    const BenchCase *bc = &BENCH_CASES[i];
+    IRFunction *func = find_function(mod, bc->func_name);
+    if (func == NULL)
+      return false;
+
+    int32_t res_plain = 0;
+    int32_t res_memo = 0;
+    double ns_plain = run_case(interp, engine, func, bc, &res_plain);
+    if (!interpreter_set_memoization(interp, true, 0))
+      return false;
+    double ns_memo = run_case(interp, engine, func, bc, &res_memo);
+    interpreter_set_memoization(interp, false, 0);
+
+    if (ns_plain < 0 || ns_memo < 0 || res_plain != res_memo)
+    {
+      fprintf(stderr, "'@%s': memoized run failed or disagrees (%d vs %d).\n", bc->func_name, res_plain, res_memo);
+      ok = false;
+      continue;
+    }
+    printf("%-12s %16.0f %18.0f %9.2fx\n", bc->func_name, ns_plain, ns_memo, ns_plain / ns_memo);
+  }
+  return ok;
+}
+
+int
+main(void)
+{
+  IRContext *ctx = ir_context_create();
+  DataLayout *dl = datalayout_create_host();
+  Interpreter *interp = interpreter_create(dl);
+  int status = 0;
+
+  IRModule *mod = ir_parse_module(ctx, BENCH_SOURCE);
+  if (mod == NULL)
+  {
+    fprintf(stderr, "Failed to parse benchmark IR.\n");
+    status = 1;
+    goto cleanup;
+  }
+
+  printf("%-12s %16s %18s %10s\n", "workload", "switch (ns/call)", "threaded (ns/call)", "speedup");
+
+  for (size_t i = 0; i < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); i++)
+  {
+    const BenchCase *bc = &BENCH_CASES[i];
+    IRFunction *func = find_function(mod, bc->func_name);
+    if (func == NULL)
+    {
+      fprintf(stderr, "Missing benchmark function '@%s'.\n", bc->func_name);
+      status = 1;
+      continue;
+    }
+
+    int32_t res_switch = 0;
+    int32_t res_threaded = 0;
+    double ns_switch = run_case(interp, INTERP_ENGINE_SWITCH, func, bc, &res_switch);
+    double ns_threaded = run_case(interp, INTERP_ENGINE_THREADED, func, bc, &res_threaded);
+
+    if (ns_switch < 0)
+    {
+      fprintf(stderr, "'@%s' failed on the switch engine.\n", bc->func_name);
+      status = 1;
+      continue;
+    }
+
+    if (ns_threaded < 0)
+    {
+      printf("%-12s %16.0f %18s %10s\n", bc->func_name, ns_switch, "n/a", "-");
+      continue;
+    }
+
+    if (res_switch != res_threaded)
+    {
+      fprintf(stderr, "'@%s': engines disagree (%d vs %d).\n", bc->func_name, res_switch, res_threaded);
+      status = 1;
+    }
+
+    printf("%-12s %16.0f %18.0f %9.2fx\n", bc->func_name, ns_switch, ns_threaded, ns_switch / ns_threaded);
+  }
+
+  /// 批量模式: 同一个函数在 BENCH_BATCH_LANES 组输入上运行，对比逐个调用
+  IRFunction *hash = find_function(mod, "hash");
+  if (hash != NULL && !run_batch_bench(interp, hash))
+    status = 1;
+
+  /// FFI: 内层循环中的宿主函数调用 (装箱 vs 类型化)
+  if (!run_ffi_bench(interp, mod))
+    status = 1;
+
+  /// 纯函数备忘: 重复调用时直接返回缓存的结果
+  if (!run_memo_bench(interp, mod))
+    status = 1;
+
+  /// 基线 JIT: 同一组用例编译为机器码后运行
+  if (!run_jit_bench(interp, mod))
+    status = 1;
+
+  printf("\n");
+  interpreter_dump_fusion_stats(interp, stdout);
+
+cleanup:
+  interpreter_destroy(interp);
+  datalayout_destroy(dl);
+  ir_context_destroy(ctx);
+  return status;
+}
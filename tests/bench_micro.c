@@ -0,0 +1,842 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/type.h"
+#include "transforms/mem2reg.h"
+#include "utils/bitset.h"
+#include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/xxhash.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 核心工具与分析的微基准 ---
+ * =================================================================
+ *
+ * 每一项都报告 ns/op 的最好值和中位数 (--rounds 轮，默认 BENCH_ROUNDS，另有一轮不计入的预热)：
+ * - bump.*:      bump_alloc 的各种大小与对齐 (每轮一个新的 Arena)
+ * - hashmap.*:   ptr / str / generic 哈希表的 put、get (命中 / 未命中)、迭代和 remove，
+ *                桶数固定为 HASHMAP_BUCKETS，按 @0.25 / @0.50 / @0.69 三种负载因子填入条目
+ * - bitset.*:    union_with / intersect_with / difference_with / count 和 bitset_for_each
+ * - cfg.* / dom_tree.* / dom_frontier.*: 在三种 CFG 形状上 (ns/block)
+ *                chain (直线)、diamonds (串联的菱形)、loops (LOOP_DEPTH 层嵌套的循环，重复 LOOP_NESTS 次)
+ * - mem2reg.*:   MEM2REG_SLOTS 个 alloca，在 MEM2REG_DIAMONDS 个菱形中读写 (ns/block；每轮重建函数，不计时)
+ *
+ * 输入都由固定的种子生成，所以每次运行的工作量相同；中位数比最好值更不容易受偶然的抖动影响。
+ * --json 写出机器可读的结果 (make run_bench_micro 写到 build/bench_micro.json)，
+ * 用于在提交之间比较；--filter 只运行名字包含给定子串的项。
+ *
+ * 用法: bench_micro [--rounds N] [--filter <子串>] [--json <输出文件>]
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  BENCH_ROUNDS = 7,
+  MAX_ROUNDS = 64,
+  MAX_RESULTS = 128,
+  BUMP_BYTES_PER_ROUND = 32 << 20,
+  BUMP_MAX_ALLOCS = 1 << 20,
+  HASHMAP_BUCKETS = 1 << 16,
+  /// 0.75 * HASHMAP_BUCKETS 以下的任何值都不会触发扩容
+  HASHMAP_CAPACITY = 45000,
+  BITSET_WORK_BITS = 1 << 24,
+  CHAIN_BLOCKS = 100000,
+  DIAMONDS = 33333,
+  LOOP_DEPTH = 32,
+  LOOP_NESTS = 1024,
+  MEM2REG_SLOTS = 16,
+  MEM2REG_DIAMONDS = 2000,
+};
+
+/** @brief 一项的结果 */
+typedef struct BenchResult
+{
+  char name[64];
+  double best_ns;
+  double median_ns;
+  /** 每轮的操作数 (ns/op 的分母) */
+  size_t ops;
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static size_t num_results = 0;
+static int rounds = BENCH_ROUNDS;
+static const char *filter = NULL;
+
+/// 防止被测的结果被优化掉
+static volatile uint64_t sink;
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+#if defined(TIME_MONOTONIC)
+  timespec_get(&ts, TIME_MONOTONIC);
+#else
+  timespec_get(&ts, TIME_UTC);
+#endif
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t
+next_random(uint32_t *seed)
+{
+  *seed = *seed * 1664525u + 1013904223u;
+  return *seed >> 8;
+}
+
+static bool
+selected(const char *name)
+{
+  return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static int
+compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief 记录并打印一项: samples 是每轮的总耗时 (ns)，第 0 轮是预热
+ */
+static void
+report(const char *name, double *samples, size_t ops)
+{
+  qsort(samples + 1, (size_t)rounds, sizeof(double), compare_double);
+  double best = samples[1] / (double)ops;
+  double median = samples[1 + rounds / 2] / (double)ops;
+  printf("  %-40s %12.2f %12.2f %12zu\n", name, best, median, ops);
+
+  if (num_results < MAX_RESULTS)
+  {
+    BenchResult *r = &results[num_results++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->best_ns = best;
+    r->median_ns = median;
+    r->ops = ops;
+  }
+}
+
+/*
+ * --- bump_alloc ---
+ */
+
+static void
+bench_bump(size_t size, size_t align)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "bump.alloc.size=%zu.align=%zu", size, align);
+  if (!selected(name))
+    return;
+
+  size_t count = BUMP_BYTES_PER_ROUND / size;
+  if (count > BUMP_MAX_ALLOCS)
+    count = BUMP_MAX_ALLOCS;
+
+  double samples[MAX_ROUNDS + 1];
+  for (int round = 0; round <= rounds; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    uintptr_t acc = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < count; i++)
+      acc ^= (uintptr_t)bump_alloc(&arena, size, align);
+    samples[round] = now_ns() - start;
+    sink += acc;
+    bump_destroy(&arena);
+  }
+  report(name, samples, count);
+}
+
+/*
+ * --- 哈希表 ---
+ *
+ * 每种表实现同一组操作 (MapOps)，由 bench_hashmap 统一计时。
+ */
+
+typedef struct Pair
+{
+  uint64_t a;
+  uint64_t b;
+} Pair;
+
+static uint64_t
+pair_hash(const void *key)
+{
+  return XXH3_64bits(key, sizeof(Pair));
+}
+
+static bool
+pair_equal(const void *k1, const void *k2)
+{
+  const Pair *x = (const Pair *)k1;
+  const Pair *y = (const Pair *)k2;
+  return x->a == y->a && x->b == y->b;
+}
+
+/** @brief 基准的输入: count 个存在的 Key 和 count 个不存在的 Key */
+typedef struct MapKeys
+{
+  size_t count;
+  void **ptrs;
+  void **missing_ptrs;
+  char (*strs)[16];
+  char (*missing_strs)[16];
+  Pair *pairs;
+  Pair *missing_pairs;
+} MapKeys;
+
+typedef enum
+{
+  MAP_PTR,
+  MAP_STR,
+  MAP_GENERIC,
+  NUM_MAP_KINDS
+} MapKind;
+
+static const char *const MAP_NAMES[NUM_MAP_KINDS] = {"ptr", "str", "generic"};
+
+typedef enum
+{
+  OP_PUT,
+  OP_GET_HIT,
+  OP_GET_MISS,
+  OP_ITERATE,
+  OP_REMOVE,
+  NUM_MAP_OPS
+} MapOp;
+
+static const char *const OP_NAMES[NUM_MAP_OPS] = {"put", "get_hit", "get_miss", "iterate", "remove"};
+
+static void *
+map_create(MapKind kind, Bump *arena)
+{
+  switch (kind)
+  {
+  case MAP_PTR:
+    return ptr_hashmap_create(arena, HASHMAP_CAPACITY);
+  case MAP_STR:
+    return str_hashmap_create(arena, HASHMAP_CAPACITY);
+  default:
+    return generic_hashmap_create(arena, HASHMAP_CAPACITY, pair_hash, pair_equal);
+  }
+}
+
+/**
+ * @brief 对 map 执行一种操作 n 次 (迭代: 走遍整个表)，返回结果的校验和
+ */
+static uint64_t
+map_run(MapKind kind, void *map, MapOp op, const MapKeys *keys, size_t n)
+{
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n && op != OP_ITERATE; i++)
+  {
+    void *value = (void *)(uintptr_t)(i + 1);
+    switch (kind)
+    {
+    case MAP_PTR:
+      if (op == OP_PUT)
+        acc += ptr_hashmap_put(map, keys->ptrs[i], value);
+      else if (op == OP_REMOVE)
+        acc += ptr_hashmap_remove(map, keys->ptrs[i]);
+      else
+        acc += (uintptr_t)ptr_hashmap_get(map, op == OP_GET_HIT ? keys->ptrs[i] : keys->missing_ptrs[i]);
+      break;
+    case MAP_STR:
+    {
+      const char *key = op == OP_GET_MISS ? keys->missing_strs[i] : keys->strs[i];
+      size_t len = strlen(key);
+      if (op == OP_PUT)
+        acc += str_hashmap_put(map, key, len, value);
+      else if (op == OP_REMOVE)
+        acc += str_hashmap_remove(map, key, len);
+      else
+        acc += (uintptr_t)str_hashmap_get(map, key, len);
+      break;
+    }
+    default:
+      if (op == OP_PUT)
+        acc += generic_hashmap_put(map, &keys->pairs[i], value);
+      else if (op == OP_REMOVE)
+        acc += generic_hashmap_remove(map, &keys->pairs[i]);
+      else
+        acc += (uintptr_t)generic_hashmap_get(map, op == OP_GET_HIT ? &keys->pairs[i] : &keys->missing_pairs[i]);
+      break;
+    }
+  }
+
+  if (op == OP_ITERATE)
+  {
+    if (kind == MAP_PTR)
+    {
+      PtrHashMapIter it = ptr_hashmap_iter(map);
+      PtrHashMapEntry entry;
+      while (ptr_hashmap_iter_next(&it, &entry))
+        acc += (uintptr_t)entry.value;
+    }
+    else if (kind == MAP_STR)
+    {
+      StrHashMapIter it = str_hashmap_iter(map);
+      StrHashMapEntry entry;
+      while (str_hashmap_iter_next(&it, &entry))
+        acc += (uintptr_t)entry.value;
+    }
+    else
+    {
+      GenericHashMapIter it = generic_hashmap_iter(map);
+      GenericHashMapEntry entry;
+      while (generic_hashmap_iter_next(&it, &entry))
+        acc += (uintptr_t)entry.value;
+    }
+  }
+  return acc;
+}
+
+/**
+ * @brief 负载因子为 load 时测量一种表的所有操作 (每轮一个新表：put、查询、迭代、remove 依次进行)
+ */
+static void
+bench_hashmap(MapKind kind, double load, const MapKeys *keys)
+{
+  size_t n = (size_t)(load * HASHMAP_BUCKETS);
+  if (n > HASHMAP_CAPACITY)
+    n = HASHMAP_CAPACITY;
+
+  char names[NUM_MAP_OPS][64];
+  bool any = false;
+  for (int op = 0; op < NUM_MAP_OPS; op++)
+  {
+    snprintf(names[op], sizeof(names[op]), "hashmap.%s.%s@%.2f", MAP_NAMES[kind], OP_NAMES[op],
+             (double)n / HASHMAP_BUCKETS);
+    any |= selected(names[op]);
+  }
+  if (!any)
+    return;
+
+  double samples[NUM_MAP_OPS][MAX_ROUNDS + 1];
+  for (int round = 0; round <= rounds; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    void *map = map_create(kind, &arena);
+    for (int op = 0; op < NUM_MAP_OPS; op++)
+    {
+      double start = now_ns();
+      sink += map_run(kind, map, (MapOp)op, keys, n);
+      samples[op][round] = now_ns() - start;
+    }
+    bump_destroy(&arena);
+  }
+  for (int op = 0; op < NUM_MAP_OPS; op++)
+  {
+    if (selected(names[op]))
+      report(names[op], samples[op], n);
+  }
+}
+
+/** @brief 生成 HASHMAP_CAPACITY 组 Key (指针是数组元素的地址，字符串和 Pair 由固定种子生成) */
+static bool
+map_keys_init(MapKeys *keys, Bump *arena)
+{
+  size_t n = HASHMAP_CAPACITY;
+  keys->count = n;
+  uint64_t *slots = BUMP_ALLOC_SLICE(arena, uint64_t, 2 * n);
+  keys->ptrs = BUMP_ALLOC_SLICE(arena, void *, n);
+  keys->missing_ptrs = BUMP_ALLOC_SLICE(arena, void *, n);
+  keys->strs = bump_alloc(arena, n * sizeof(*keys->strs), 1);
+  keys->missing_strs = bump_alloc(arena, n * sizeof(*keys->missing_strs), 1);
+  keys->pairs = BUMP_ALLOC_SLICE(arena, Pair, n);
+  keys->missing_pairs = BUMP_ALLOC_SLICE(arena, Pair, n);
+  if (!slots || !keys->ptrs || !keys->missing_ptrs || !keys->strs || !keys->missing_strs || !keys->pairs ||
+      !keys->missing_pairs)
+    return false;
+
+  uint32_t seed = 42;
+  for (size_t i = 0; i < n; i++)
+  {
+    keys->ptrs[i] = &slots[i];
+    keys->missing_ptrs[i] = &slots[n + i];
+    /// 不同的前缀保证命中与未命中的集合不相交
+    snprintf(keys->strs[i], sizeof(keys->strs[i]), "k%08x", next_random(&seed) ^ (uint32_t)i << 8);
+    snprintf(keys->missing_strs[i], sizeof(keys->missing_strs[i]), "m%08x", next_random(&seed));
+    keys->pairs[i] = (Pair){next_random(&seed), 2 * i};
+    keys->missing_pairs[i] = (Pair){next_random(&seed), 2 * i + 1};
+  }
+  return true;
+}
+
+/*
+ * --- Bitset ---
+ */
+
+typedef enum
+{
+  BITSET_UNION,
+  BITSET_INTERSECT,
+  BITSET_DIFFERENCE,
+  BITSET_COUNT,
+  BITSET_FOR_EACH_SPARSE,
+  BITSET_FOR_EACH_DENSE,
+  NUM_BITSET_OPS
+} BitsetOp;
+
+static const char *const BITSET_OP_NAMES[NUM_BITSET_OPS] = {
+  "union_with", "intersect_with", "difference_with", "count", "for_each.sparse", "for_each.dense",
+};
+
+static void
+bench_bitset(BitsetOp op, size_t num_bits)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "bitset.%s.bits=%zu", BITSET_OP_NAMES[op], num_bits);
+  if (!selected(name))
+    return;
+
+  Bump arena;
+  bump_init(&arena);
+  Bitset *dest = bitset_create(num_bits, &arena);
+  Bitset *src = bitset_create(num_bits, &arena);
+  Bitset *sparse = bitset_create(num_bits, &arena);
+  uint32_t seed = 7;
+  for (size_t i = 0; i < num_bits; i++)
+  {
+    uint32_t r = next_random(&seed);
+    if (r & 1)
+      bitset_set(dest, i);
+    if (r & 2)
+      bitset_set(src, i);
+    if (r % 64 == 0)
+      bitset_set(sparse, i);
+  }
+
+  /// 每轮处理 BITSET_WORK_BITS 位，与集合的大小无关
+  size_t reps = BITSET_WORK_BITS / num_bits;
+  double samples[MAX_ROUNDS + 1];
+  for (int round = 0; round <= rounds; round++)
+  {
+    uint64_t acc = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < reps; i++)
+    {
+      switch (op)
+      {
+      case BITSET_UNION:
+        acc += bitset_union_with(dest, src);
+        break;
+      case BITSET_INTERSECT:
+        acc += bitset_intersect_with(dest, src);
+        break;
+      case BITSET_DIFFERENCE:
+        acc += bitset_difference_with(dest, src);
+        break;
+      case BITSET_COUNT:
+        acc += bitset_count(src);
+        break;
+      case BITSET_FOR_EACH_SPARSE:
+        bitset_for_each(sparse, bit) acc += bit;
+        break;
+      default:
+        bitset_for_each(src, bit) acc += bit;
+        break;
+      }
+    }
+    samples[round] = now_ns() - start;
+    sink += acc;
+  }
+  bump_destroy(&arena);
+  report(name, samples, reps);
+}
+
+/*
+ * --- CFG 形状 ---
+ */
+
+typedef enum
+{
+  SHAPE_CHAIN,
+  SHAPE_DIAMONDS,
+  SHAPE_LOOPS,
+  NUM_SHAPES
+} Shape;
+
+static const char *const SHAPE_NAMES[NUM_SHAPES] = {"chain", "diamonds", "loops"};
+
+/** @brief 一个 void (i1) 函数，按顺序追加 num_blocks 个空块 */
+static IRFunction *
+create_function(IRModule *mod, IRBasicBlock **blocks, int num_blocks, IRValueNode **out_cond)
+{
+  IRContext *ctx = mod->context;
+  IRFunction *func = ir_function_create(mod, "f", ir_type_get_void(ctx));
+  *out_cond = &ir_argument_create(func, ir_type_get_i1(ctx), "c")->value;
+  ir_function_finalize_signature(func, false);
+  for (int i = 0; i < num_blocks; i++)
+  {
+    blocks[i] = ir_basic_block_create(func, "b");
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+  return func;
+}
+
+static int
+shape_num_blocks(Shape shape)
+{
+  switch (shape)
+  {
+  case SHAPE_CHAIN:
+    return CHAIN_BLOCKS;
+  case SHAPE_DIAMONDS:
+    return 3 * DIAMONDS + 1;
+  default:
+    /// 每层一个头和一个出口，外加最内层的循环体；最后一个块返回
+    return LOOP_NESTS * (2 * LOOP_DEPTH + 1) + 1;
+  }
+}
+
+/**
+ * @brief 构建一种形状的函数
+ *
+ * loops: 每个循环嵌套是 h[0..D-1]、body、x[0..D-1]:
+ *   h[i] -> h[i+1] (最内层 -> body) | x[i]，body -> h[D-1]，x[i] -> h[i-1] (最外层 -> 下一个嵌套)
+ */
+static IRFunction *
+build_shape(IRModule *mod, IRBuilder *b, Shape shape)
+{
+  int num_blocks = shape_num_blocks(shape);
+  IRBasicBlock **blocks = malloc((size_t)num_blocks * sizeof(IRBasicBlock *));
+  if (!blocks)
+    return NULL;
+  IRValueNode *cond;
+  IRFunction *func = create_function(mod, blocks, num_blocks, &cond);
+
+  if (shape == SHAPE_CHAIN)
+  {
+    for (int i = 0; i + 1 < num_blocks; i++)
+    {
+      ir_builder_set_insertion_point(b, blocks[i]);
+      ir_builder_create_br(b, &blocks[i + 1]->label_address);
+    }
+  }
+  else if (shape == SHAPE_DIAMONDS)
+  {
+    for (int i = 0; i < DIAMONDS; i++)
+    {
+      IRBasicBlock **d = blocks + 3 * i;
+      ir_builder_set_insertion_point(b, d[0]);
+      ir_builder_create_cond_br(b, cond, &d[1]->label_address, &d[2]->label_address);
+      ir_builder_set_insertion_point(b, d[1]);
+      ir_builder_create_br(b, &d[3]->label_address);
+      ir_builder_set_insertion_point(b, d[2]);
+      ir_builder_create_br(b, &d[3]->label_address);
+    }
+  }
+  else
+  {
+    for (int n = 0; n < LOOP_NESTS; n++)
+    {
+      IRBasicBlock **h = blocks + n * (2 * LOOP_DEPTH + 1);
+      IRBasicBlock *body = h[LOOP_DEPTH];
+      IRBasicBlock **x = h + LOOP_DEPTH + 1;
+      /// 最后一个嵌套的出口跳到返回块
+      IRBasicBlock *next = blocks[(n + 1) * (2 * LOOP_DEPTH + 1)];
+      for (int i = 0; i < LOOP_DEPTH; i++)
+      {
+        ir_builder_set_insertion_point(b, h[i]);
+        IRBasicBlock *inner = i + 1 < LOOP_DEPTH ? h[i + 1] : body;
+        ir_builder_create_cond_br(b, cond, &inner->label_address, &x[i]->label_address);
+        ir_builder_set_insertion_point(b, x[i]);
+        ir_builder_create_br(b, i > 0 ? &h[i - 1]->label_address : &next->label_address);
+      }
+      ir_builder_set_insertion_point(b, body);
+      ir_builder_create_br(b, &h[LOOP_DEPTH - 1]->label_address);
+    }
+  }
+  ir_builder_set_insertion_point(b, blocks[num_blocks - 1]);
+  ir_builder_create_ret(b, NULL);
+  free(blocks);
+  return func;
+}
+
+typedef enum
+{
+  ANALYSIS_CFG,
+  ANALYSIS_DOM_TREE,
+  ANALYSIS_DOM_FRONTIER,
+  NUM_ANALYSES
+} Analysis;
+
+static const char *const ANALYSIS_NAMES[NUM_ANALYSES] = {"cfg_build", "dom_tree_build", "dom_frontier"};
+
+/**
+ * @brief 测量一种分析 (ns/block)；它依赖的分析在计时之外构建
+ */
+static void
+bench_analysis(Analysis analysis, Shape shape, IRFunction *func)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "%s.%s", ANALYSIS_NAMES[analysis], SHAPE_NAMES[shape]);
+  if (!selected(name))
+    return;
+
+  double samples[MAX_ROUNDS + 1];
+  for (int round = 0; round <= rounds; round++)
+  {
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = NULL;
+    DominatorTree *tree = NULL;
+    double start = now_ns();
+    if (analysis == ANALYSIS_CFG)
+    {
+      cfg = cfg_build(func, &arena);
+      samples[round] = now_ns() - start;
+    }
+    else
+    {
+      cfg = cfg_build(func, &arena);
+      if (analysis == ANALYSIS_DOM_FRONTIER)
+        tree = dom_tree_build(cfg, &arena);
+      start = now_ns();
+      if (analysis == ANALYSIS_DOM_TREE)
+        tree = dom_tree_build(cfg, &arena);
+      else
+        ir_analysis_dom_frontier_destroy(ir_analysis_dom_frontier_compute(tree, &arena));
+      samples[round] = now_ns() - start;
+    }
+    if (tree)
+      dom_tree_destroy(tree);
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  report(name, samples, (size_t)shape_num_blocks(shape));
+}
+
+/*
+ * --- mem2reg ---
+ */
+
+/**
+ * @brief i32 (i1 %c, i32 %x): MEM2REG_SLOTS 个 alloca，每个菱形在一边 store 常量、另一边 load 再 store，
+ * 最后把所有槽位加起来返回
+ */
+static IRFunction *
+build_mem2reg_function(IRModule *mod, IRBuilder *b)
+{
+  IRContext *ctx = mod->context;
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRFunction *func = ir_function_create(mod, "m", i32);
+  IRValueNode *cond = &ir_argument_create(func, ir_type_get_i1(ctx), "c")->value;
+  IRValueNode *x = &ir_argument_create(func, i32, "x")->value;
+  ir_function_finalize_signature(func, false);
+
+  int num_blocks = 3 * MEM2REG_DIAMONDS + 1;
+  IRBasicBlock **blocks = malloc((size_t)num_blocks * sizeof(IRBasicBlock *));
+  if (!blocks)
+    return NULL;
+  for (int i = 0; i < num_blocks; i++)
+  {
+    blocks[i] = ir_basic_block_create(func, "b");
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  IRValueNode *slots[MEM2REG_SLOTS];
+  ir_builder_set_insertion_point(b, blocks[0]);
+  for (int s = 0; s < MEM2REG_SLOTS; s++)
+  {
+    slots[s] = ir_builder_create_alloca(b, i32, "slot");
+    ir_builder_create_store(b, x, slots[s]);
+  }
+
+  for (int i = 0; i < MEM2REG_DIAMONDS; i++)
+  {
+    IRBasicBlock **d = blocks + 3 * i;
+    IRValueNode *slot = slots[i % MEM2REG_SLOTS];
+    ir_builder_set_insertion_point(b, d[0]);
+    ir_builder_create_cond_br(b, cond, &d[1]->label_address, &d[2]->label_address);
+    ir_builder_set_insertion_point(b, d[1]);
+    ir_builder_create_store(b, ir_constant_get_i32(ctx, i), slot);
+    ir_builder_create_br(b, &d[3]->label_address);
+    ir_builder_set_insertion_point(b, d[2]);
+    IRValueNode *v = ir_builder_create_load(b, slots[(i + 1) % MEM2REG_SLOTS], "v");
+    ir_builder_create_store(b, ir_builder_create_add(b, v, x, "w"), slot);
+    ir_builder_create_br(b, &d[3]->label_address);
+  }
+
+  ir_builder_set_insertion_point(b, blocks[num_blocks - 1]);
+  IRValueNode *sum = x;
+  for (int s = 0; s < MEM2REG_SLOTS; s++)
+    sum = ir_builder_create_add(b, sum, ir_builder_create_load(b, slots[s], "l"), "sum");
+  ir_builder_create_ret(b, sum);
+  free(blocks);
+  return func;
+}
+
+static void
+bench_mem2reg(void)
+{
+  const char *name = "mem2reg.diamonds";
+  if (!selected(name))
+    return;
+
+  double samples[MAX_ROUNDS + 1];
+  for (int round = 0; round <= rounds; round++)
+  {
+    /// mem2reg 会改写函数，每轮在新的上下文中重建
+    IRContext *ctx = ir_context_create();
+    IRModule *mod = ir_module_create(ctx, "bench");
+    IRBuilder *b = ir_builder_create(ctx);
+    IRFunction *func = build_mem2reg_function(mod, b);
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+
+    double start = now_ns();
+    sink += ir_transform_mem2reg_run(func, tree, NULL);
+    samples[round] = now_ns() - start;
+
+    dom_tree_destroy(tree);
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+    ir_builder_destroy(b);
+    ir_context_destroy(ctx);
+  }
+  report(name, samples, 3 * MEM2REG_DIAMONDS + 1);
+}
+
+/*
+ * --- 入口 ---
+ */
+
+static bool
+write_json(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (f == NULL)
+    return false;
+  fprintf(f, "{\n  \"rounds\": %d,\n  \"benchmarks\": [\n", rounds);
+  for (size_t i = 0; i < num_results; i++)
+  {
+    const BenchResult *r = &results[i];
+    fprintf(f, "    {\"name\": \"%s\", \"ns_per_op_best\": %.3f, \"ns_per_op_median\": %.3f, \"ops\": %zu}%s\n",
+            r->name, r->best_ns, r->median_ns, r->ops, i + 1 < num_results ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  const char *json_path = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+      rounds = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+      filter = argv[++i];
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      json_path = argv[++i];
+    else
+      rounds = 0;
+  }
+  if (rounds < 1 || rounds > MAX_ROUNDS)
+  {
+    fprintf(stderr, "usage: %s [--rounds 1..%d] [--filter <substring>] [--json <output file>]\n", argv[0],
+            MAX_ROUNDS);
+    return 2;
+  }
+
+  printf("Microbenchmarks (%d rounds after one warm-up)\n", rounds);
+  printf("  %-40s %12s %12s %12s\n", "benchmark", "best ns/op", "median ns/op", "ops/round");
+
+  static const size_t BUMP_SIZES[] = {8, 24, 64, 512, 4096};
+  static const size_t BUMP_ALIGNS[] = {1, 8, 16, 64};
+  for (size_t s = 0; s < sizeof(BUMP_SIZES) / sizeof(BUMP_SIZES[0]); s++)
+  {
+    for (size_t a = 0; a < sizeof(BUMP_ALIGNS) / sizeof(BUMP_ALIGNS[0]); a++)
+      bench_bump(BUMP_SIZES[s], BUMP_ALIGNS[a]);
+  }
+
+  Bump key_arena;
+  bump_init(&key_arena);
+  MapKeys keys;
+  if (!map_keys_init(&keys, &key_arena))
+  {
+    fprintf(stderr, "Out of memory while generating hashmap keys.\n");
+    return 1;
+  }
+  static const double LOADS[] = {0.25, 0.50, 0.69};
+  for (int kind = 0; kind < NUM_MAP_KINDS; kind++)
+  {
+    for (size_t l = 0; l < sizeof(LOADS) / sizeof(LOADS[0]); l++)
+      bench_hashmap((MapKind)kind, LOADS[l], &keys);
+  }
+  bump_destroy(&key_arena);
+
+  for (int op = 0; op < NUM_BITSET_OPS; op++)
+  {
+    bench_bitset((BitsetOp)op, 1024);
+    bench_bitset((BitsetOp)op, 1 << 16);
+  }
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "bench");
+  IRBuilder *b = ir_builder_create(ctx);
+  for (int shape = 0; shape < NUM_SHAPES; shape++)
+  {
+    IRFunction *func = build_shape(mod, b, (Shape)shape);
+    if (!func)
+      return 1;
+    for (int analysis = 0; analysis < NUM_ANALYSES; analysis++)
+      bench_analysis((Analysis)analysis, (Shape)shape, func);
+  }
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  bench_mem2reg();
+
+  if (json_path != NULL)
+  {
+    if (!write_json(json_path))
+    {
+      fprintf(stderr, "Cannot write '%s'.\n", json_path);
+      return 1;
+    }
+    printf("\nResults written to %s\n", json_path);
+  }
+  return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ir/context.h"
+#include "ir/lexer.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "utils/bump.h"
+#include "utils/mapped_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 词法分析 / 解析吞吐量基准测试 ---
+ * =================================================================
+ *
+ * 对每个输入的 .cir 文件分别测量：
+ * - lex:    只运行词法分析器，直到 TK_EOF
+ * - parse:  ir_parse_module (它在返回前已经运行一次验证器)
+ * - +verify: ir_parse_module 之后再调用一次 ir_verify_module
+ *            (与 parse 的差就是一次单独验证的开销)
+ * - clone:  解析之后 ir_module_clone 的耗时 (不含解析；Arena 包括源和克隆)
+ * 报告吞吐量 (MB/s，取 --rounds 轮中的最好成绩) 和上下文 Arena 的分配：
+ * chunk 数 (即 malloc 次数)、chunk 的总容量与实际分配出去的字节数。
+ *
+ * 输入由 scripts/gen_cir_module.py 生成 (make run_bench_parser 会自动生成
+ * build/bench_inputs/ 下的各种形状)。
+ *
+ * 用法: bench_parser [--rounds N] <file.cir>...
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/** @brief 上下文 Arena 的占用 */
+typedef struct ArenaStats
+{
+  size_t chunks;
+  /** chunk 的总容量 */
+  size_t bytes;
+  /** 实际分配出去的字节 (chunk 尾部到 ptr 之间) */
+  size_t used;
+} ArenaStats;
+
+static void
+arena_stats_add(ArenaStats *stats, Bump *arena)
+{
+  /// 链表以一个空的哨兵 chunk 结尾 (chunk_size 为 0，prev 指向自己)
+  for (ChunkFooter *chunk = arena->current_chunk_footer; chunk->chunk_size != 0; chunk = chunk->prev)
+  {
+    stats->chunks++;
+    stats->used += (size_t)((unsigned char *)chunk - chunk->ptr);
+  }
+  stats->bytes += bump_get_allocated_bytes(arena);
+}
+
+static ArenaStats
+context_arena_stats(IRContext *ctx)
+{
+  ArenaStats stats = {0};
+  arena_stats_add(&stats, &ctx->permanent_arena);
+  arena_stats_add(&stats, &ctx->ir_arena);
+  for (size_t i = 0; i < IR_CONSTANT_CACHE_SHARDS; i++)
+    arena_stats_add(&stats, &ctx->constant_shards[i].arena);
+  return stats;
+}
+
+/** @brief 一个阶段的测量结果 */
+typedef struct PhaseResult
+{
+  double best_ns;
+  ArenaStats arena;
+} PhaseResult;
+
+typedef enum
+{
+  PHASE_LEX,
+  PHASE_PARSE,
+  PHASE_PARSE_VERIFY,
+  PHASE_CLONE,
+  NUM_PHASES
+} Phase;
+
+static const char *const PHASE_NAMES[NUM_PHASES] = {"lex", "parse", "+verify", "clone"};
+
+/**
+ * @brief 在全新的上下文上运行一个阶段
+ *
+ * @return bool 词法错误、解析或验证失败时返回 false
+ */
+static bool
+run_phase(Phase phase, const char *source, size_t len, double *out_ns, ArenaStats *out_arena, size_t *out_tokens)
+{
+  IRContext *ctx = ir_context_create();
+  bool ok = true;
+
+  IRModule *src = NULL;
+  if (phase == PHASE_CLONE)
+  {
+    src = ir_parse_module(ctx, source);
+    if (!src)
+    {
+      ir_context_destroy(ctx);
+      return false;
+    }
+  }
+
+  double start = now_ns();
+  if (phase == PHASE_LEX)
+  {
+    Lexer lexer;
+    ir_lexer_init_slice(&lexer, source, len, ctx);
+    size_t tokens = 0;
+    TokenType type;
+    while ((type = ir_lexer_current_token(&lexer)->type) != TK_EOF)
+    {
+      if (type == TK_ILLEGAL)
+      {
+        ok = false;
+        break;
+      }
+      tokens++;
+      ir_lexer_next(&lexer);
+    }
+    *out_tokens = tokens;
+  }
+  else if (phase == PHASE_CLONE)
+  {
+    ok = ir_module_clone(src, NULL) != NULL;
+  }
+  else
+  {
+    IRModule *mod = ir_parse_module(ctx, source);
+    ok = mod != NULL;
+    if (ok && phase == PHASE_PARSE_VERIFY)
+      ok = ir_verify_module(mod);
+  }
+  *out_ns = now_ns() - start;
+
+  *out_arena = context_arena_stats(ctx);
+  ir_context_destroy(ctx);
+  return ok;
+}
+
+/**
+ * @brief 测量一个文件的所有阶段并打印一行结果
+ */
+static bool
+bench_file(const char *path, int rounds)
+{
+  MappedFile file;
+  if (!mapped_file_open(&file, path))
+  {
+    fprintf(stderr, "Cannot read '%s'\n", path);
+    return false;
+  }
+
+  /// ir_parse_module 需要 '\0' 结尾的字符串
+  char *source = malloc(file.size + 1);
+  if (!source)
+  {
+    mapped_file_close(&file);
+    return false;
+  }
+  memcpy(source, file.data, file.size);
+  source[file.size] = '\0';
+  size_t len = file.size;
+  mapped_file_close(&file);
+
+  PhaseResult results[NUM_PHASES];
+  size_t tokens = 0;
+  bool ok = true;
+  for (int phase = 0; phase < NUM_PHASES && ok; phase++)
+  {
+    results[phase].best_ns = 1e300;
+    for (int round = 0; round < rounds && ok; round++)
+    {
+      double ns = 0;
+      ok = run_phase((Phase)phase, source, len, &ns, &results[phase].arena, &tokens);
+      if (ns < results[phase].best_ns)
+        results[phase].best_ns = ns;
+    }
+    if (!ok)
+      fprintf(stderr, "'%s': phase '%s' failed\n", path, PHASE_NAMES[phase]);
+  }
+
+  if (ok)
+  {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    double mb = (double)len / (1024.0 * 1024.0);
+    printf("%-14s %8.2fMB %9zu tokens\n", name, mb, tokens);
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+      const PhaseResult *r = &results[phase];
+      printf("  %-10s %10.2fms %10.1fMB/s %8zu chunks %10.1fMB arena %10.1fMB used\n", PHASE_NAMES[phase],
+             r->best_ns / 1e6, mb / (r->best_ns / 1e9), r->arena.chunks, (double)r->arena.bytes / (1024.0 * 1024.0),
+             (double)r->arena.used / (1024.0 * 1024.0));
+    }
+  }
+
+  free(source);
+  return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+  int rounds = 3;
+  int first_file = 1;
+  if (argc > 2 && strcmp(argv[1], "--rounds") == 0)
+  {
+    rounds = atoi(argv[2]);
+    first_file = 3;
+  }
+  if (first_file >= argc || rounds < 1)
+  {
+    fprintf(stderr, "Usage: %s [--rounds N] <file.cir>...\n"
+                    "  (generate inputs with scripts/gen_cir_module.py, or run 'make run_bench_parser')\n",
+            argv[0]);
+    return 1;
+  }
+
+  printf("Parser throughput (best of %d rounds)\n", rounds);
+  int status = 0;
+  for (int i = first_file; i < argc; i++)
+  {
+    if (!bench_file(argv[i], rounds))
+      status = 1;
+  }
+  return status;
+}
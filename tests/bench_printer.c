@@ -0,0 +1,189 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ir/context.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/printer.h"
+#include "utils/bump.h"
+#include "utils/string_buf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- IR 打印基准测试 ---
+ * =================================================================
+ *
+ * 生成一个有 BENCH_FUNCTIONS 个函数的模块，比较三种打印目标：
+ * - file:     ir_printer_init_file (每个片段一次 stdio 调用)
+ * - buffered: ir_printer_init_file_buffered (ir_module_dump_to_file 使用的策略)
+ * - string:   ir_module_dump_to_string
+ * - parallel: ir_module_dump_to_file_parallel (BENCH_THREADS 个线程)
+ * 文件输出写入 tmpfile()。每项取 BENCH_ROUNDS 轮中的最好成绩。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+enum
+{
+  BENCH_FUNCTIONS = 4000,
+  BENCH_ROUNDS = 5,
+  BENCH_THREADS = 4,
+};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief 生成基准模块的文本：每个函数有整数、浮点常量、比较、phi 和调用
+ */
+static const char *
+generate_source(Bump *arena)
+{
+  StringBuf buf;
+  string_buf_init(&buf, arena);
+  string_buf_append_str(&buf, "module = \"bench_printer\"\n\n");
+  string_buf_append_str(&buf, "declare i64 @external(%x: i64)\n");
+
+  for (int i = 0; i < BENCH_FUNCTIONS; i++)
+  {
+    string_buf_append_fmt(&buf,
+                          "define f64 @function_%d(%%value: i64, %%scale: f64) {\n"
+                          "$entry:\n"
+                          "  %%doubled: i64 = mul %%value: i64, %d: i64\n"
+                          "  %%called: i64 = call <i64 (i64)> @external(%%doubled: i64)\n"
+                          "  %%is_big: i1 = icmp sgt %%called: i64, 1000000: i64\n"
+                          "  br %%is_big: i1, $big, $small\n"
+                          "$big:\n"
+                          "  %%big_f: f64 = sitofp %%called: i64 to f64\n"
+                          "  %%big_r: f64 = fmul %%big_f: f64, 0.125: f64\n"
+                          "  br $merge\n"
+                          "$small:\n"
+                          "  %%small_r: f64 = fadd %%scale: f64, -%d.5: f64\n"
+                          "  br $merge\n"
+                          "$merge:\n"
+                          "  %%result: f64 = phi [ %%big_r: f64, $big ], [ %%small_r: f64, $small ]\n"
+                          "  ret %%result: f64\n"
+                          "}\n",
+                          i, i % 97 + 3, i % 13);
+  }
+  return string_buf_get(&buf);
+}
+
+int
+main(void)
+{
+  Bump arena;
+  bump_init(&arena);
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, generate_source(&arena));
+  if (!mod)
+  {
+    fprintf(stderr, "Failed to parse the generated module\n");
+    ir_context_destroy(ctx);
+    bump_destroy(&arena);
+    return 1;
+  }
+
+  double best_file = 1e300, best_buffered = 1e300, best_string = 1e300, best_parallel = 1e300;
+  size_t size = 0;
+  int status = 0;
+
+  for (int round = 0; round < BENCH_ROUNDS && status == 0; round++)
+  {
+    FILE *plain_out = tmpfile();
+    FILE *buffered_out = tmpfile();
+    FILE *parallel_out = tmpfile();
+    if (!plain_out || !buffered_out || !parallel_out)
+    {
+      fprintf(stderr, "tmpfile() failed\n");
+      FILE *opened[] = {plain_out, buffered_out, parallel_out};
+      for (size_t i = 0; i < 3; i++)
+      {
+        if (opened[i])
+          fclose(opened[i]);
+      }
+      status = 1;
+      break;
+    }
+
+    IRPrinter p;
+    double start = now_ns();
+    ir_printer_init_file(&p, plain_out);
+    ir_module_dump_internal(mod, &p);
+    fflush(plain_out);
+    double t_file = now_ns() - start;
+
+    start = now_ns();
+    ir_module_dump_to_file(mod, buffered_out);
+    fflush(buffered_out);
+    double t_buffered = now_ns() - start;
+
+    start = now_ns();
+    ir_module_dump_to_file_parallel(mod, parallel_out, BENCH_THREADS);
+    fflush(parallel_out);
+    double t_parallel = now_ns() - start;
+
+    Bump scratch;
+    bump_init(&scratch);
+    start = now_ns();
+    const char *text = ir_module_dump_to_string(mod, &scratch);
+    double t_string = now_ns() - start;
+
+    size = strlen(text);
+    if ((size_t)ftell(plain_out) != size || (size_t)ftell(buffered_out) != size || (size_t)ftell(parallel_out) != size)
+    {
+      fprintf(stderr, "Round %d: the outputs have different sizes\n", round);
+      status = 1;
+    }
+
+    best_file = t_file < best_file ? t_file : best_file;
+    best_buffered = t_buffered < best_buffered ? t_buffered : best_buffered;
+    best_string = t_string < best_string ? t_string : best_string;
+    best_parallel = t_parallel < best_parallel ? t_parallel : best_parallel;
+
+    bump_destroy(&scratch);
+    fclose(parallel_out);
+    fclose(buffered_out);
+    fclose(plain_out);
+  }
+
+  if (status == 0)
+  {
+    double mb = (double)size / (1024.0 * 1024.0);
+    printf("IR printing (%d functions, %.2fMB, best of %d rounds)\n", BENCH_FUNCTIONS, mb, BENCH_ROUNDS);
+    printf("  %-10s %10.2fms %10.1fMB/s\n", "file", best_file / 1e6, mb / (best_file / 1e9));
+    printf("  %-10s %10.2fms %10.1fMB/s %8.2fx\n", "buffered", best_buffered / 1e6, mb / (best_buffered / 1e9),
+           best_file / best_buffered);
+    printf("  %-10s %10.2fms %10.1fMB/s\n", "string", best_string / 1e6, mb / (best_string / 1e9));
+    printf("  %-10s %10.2fms %10.1fMB/s %8.2fx (%d threads)\n", "parallel", best_parallel / 1e6,
+           mb / (best_parallel / 1e9), best_file / best_parallel, BENCH_THREADS);
+  }
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+  return status;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/interpreter.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+#include "utils/id_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * =================================================================
+ * --- 解释器工作负载基准测试 ---
+ * =================================================================
+ *
+ * 从 tests/workloads/ 读取一组 .cir 工作负载，每个都在全新的
+ * IRContext + Interpreter 上运行，报告:
+ * - 每次调用的耗时 (ns/call)
+ * - 每次调用执行的 IR 指令数，以及每秒执行的指令数
+ * - 竞技场占用的字节数 (IR + 执行计划；竞技场只增不减，即峰值)
+ *
+ * 用法: bench_workloads [--dir <工作负载目录>] [--json <输出文件>]
+ * 指定 --json 时额外写出机器可读的结果 (make bench 写到 build/bench_workloads.json)，
+ * 以便在版本之间比较、发现性能回退。
+ *
+ * (注意: 默认的 CFLAGS 是 -O0；测量性能时请用优化构建，例如
+ * make bench CFLAGS_BASE="-std=c23 -O2 -MMD -MP")
+ */
+
+#define WORKLOAD_DEFAULT_DIR "tests/workloads"
+
+typedef struct Workload
+{
+  const char *file;
+  const char *func_name;
+  int32_t arg;
+  int iterations;
+} Workload;
+
+static const Workload WORKLOADS[] = {
+  {"fib.cir", "fib", 22, 5},
+  {"nested_loops.cir", "nested_loops", 300, 10},
+  {"array_sum.cir", "array_sum", 100, 10},
+  {"state_machine.cir", "state_machine", 100000, 10},
+  {"float_kernel.cir", "float_kernel", 100000, 10},
+  {"ffi_loop.cir", "ffi_loop", 100000, 10},
+};
+
+#define NUM_WORKLOADS (sizeof(WORKLOADS) / sizeof(WORKLOADS[0]))
+
+/** @brief 一个工作负载的测量结果 */
+typedef struct WorkloadResult
+{
+  int32_t result;
+  double ns_per_call;
+  uint64_t instructions_per_call;
+  size_t arena_bytes;
+} WorkloadResult;
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static IRFunction *
+find_function(IRModule *mod, const char *name)
+{
+  IDList *it;
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *f = list_entry(it, IRFunction, list_node);
+    if (strcmp(f->entry_address.name, name) == 0)
+      return f;
+  }
+  return NULL;
+}
+
+/// ffi_loop.cir 调用的宿主函数 (以类型化 FFI 注册)
+static int64_t
+host_mix(int64_t acc, int64_t i)
+{
+  return acc * 31 + (i ^ (acc >> 7));
+}
+
+/**
+ * @brief 把整个文件读进一个以 '\0' 结尾的缓冲区 (调用者 free；失败返回 NULL)
+ */
+static char *
+read_file(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+    return NULL;
+
+  char *buf = NULL;
+  if (fseek(f, 0, SEEK_END) == 0)
+  {
+    long len = ftell(f);
+    if (len >= 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+      buf = malloc((size_t)len + 1);
+      if (buf != NULL && fread(buf, 1, (size_t)len, f) == (size_t)len)
+      {
+        buf[len] = '\0';
+      }
+      else
+      {
+        free(buf);
+        buf = NULL;
+      }
+    }
+  }
+  fclose(f);
+  return buf;
+}
+
+/**
+ * @brief 用 profiling 运行一次，统计每次调用执行的 IR 指令数
+ */
+static bool
+count_instructions(Interpreter *interp, IRFunction *func, RuntimeValue **args, uint64_t *count_out)
+{
+  interpreter_set_profiling(interp, true);
+  interpreter_reset_profile(interp);
+
+  RuntimeValue result;
+  bool ok = interpreter_run_function(interp, func, args, 1, &result);
+
+  uint64_t total = 0;
+  for (int op = 0; op <= IR_OP_CALL; op++)
+    total += interpreter_profile_get_opcode_count(interp, (IROpcode)op);
+  interpreter_set_profiling(interp, false);
+
+  *count_out = total;
+  return ok;
+}
+
+/**
+ * @brief 在全新的上下文与解释器上运行一个工作负载 (失败时打印原因并返回 false)
+ */
+static bool
+run_workload(const char *dir, const Workload *w, WorkloadResult *out)
+{
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", dir, w->file);
+  char *source = read_file(path);
+  if (source == NULL)
+  {
+    fprintf(stderr, "Cannot read workload '%s'.\n", path);
+    return false;
+  }
+
+  IRContext *ctx = ir_context_create();
+  DataLayout *dl = datalayout_create_host();
+  Interpreter *interp = interpreter_create(dl);
+  bool ok = false;
+
+  IRModule *mod = ir_parse_module(ctx, source);
+  IRFunction *func = mod ? find_function(mod, w->func_name) : NULL;
+  if (func == NULL)
+  {
+    fprintf(stderr, "'%s': parse failed or '@%s' is missing.\n", path, w->func_name);
+    goto cleanup;
+  }
+  interpreter_register_typed_function(interp, "host_mix", (CalicoTypedHostFunction)host_mix, CALICO_HOST_I64,
+                                      CALICO_HOST_I64, 2);
+
+  RuntimeValue rt_arg;
+  rt_arg.kind = RUNTIME_VAL_I32;
+  rt_arg.as.val_i32 = w->arg;
+  RuntimeValue *args[] = {&rt_arg};
+  RuntimeValue result;
+
+  if (!count_instructions(interp, func, args, &out->instructions_per_call))
+  {
+    fprintf(stderr, "'@%s' failed.\n", w->func_name);
+    goto cleanup;
+  }
+
+  /// 预热 (关闭 profiling 后重新构建执行计划)
+  if (!interpreter_run_function(interp, func, args, 1, &result))
+  {
+    fprintf(stderr, "'@%s' failed.\n", w->func_name);
+    goto cleanup;
+  }
+
+  double start = now_ns();
+  for (int i = 0; i < w->iterations; i++)
+  {
+    if (!interpreter_run_function(interp, func, args, 1, &result))
+      goto cleanup;
+  }
+  out->ns_per_call = (now_ns() - start) / w->iterations;
+  out->result = result.as.val_i32;
+  out->arena_bytes = bump_get_allocated_bytes(&ctx->permanent_arena) + bump_get_allocated_bytes(&ctx->ir_arena) +
+                     bump_get_allocated_bytes(interp->plan_arena);
+  ok = true;
+
+cleanup:
+  interpreter_destroy(interp);
+  datalayout_destroy(dl);
+  ir_context_destroy(ctx);
+  free(source);
+  return ok;
+}
+
+/**
+ * @brief 把所有结果写成 JSON (失败的工作负载记为 "ok": false)
+ */
+static bool
+write_json(const char *path, const WorkloadResult *results, const bool *ok)
+{
+  FILE *f = fopen(path, "w");
+  if (f == NULL)
+    return false;
+
+  fprintf(f, "{\n  \"engine\": \"%s\",\n  \"workloads\": [\n", CALICO_HAS_THREADED_ENGINE ? "threaded" : "switch");
+  for (size_t i = 0; i < NUM_WORKLOADS; i++)
+  {
+    const Workload *w = &WORKLOADS[i];
+    const WorkloadResult *r = &results[i];
+    fprintf(f, "    {\"name\": \"%s\", \"arg\": %d, \"iterations\": %d, \"ok\": %s", w->func_name, w->arg,
+            w->iterations, ok[i] ? "true" : "false");
+    if (ok[i])
+    {
+      fprintf(f,
+              ", \"result\": %d, \"ns_per_call\": %.0f, \"instructions_per_call\": %llu, "
+              "\"instructions_per_sec\": %.0f, \"arena_bytes\": %zu",
+              r->result, r->ns_per_call, (unsigned long long)r->instructions_per_call,
+              r->instructions_per_call / (r->ns_per_call * 1e-9), r->arena_bytes);
+    }
+    fprintf(f, "}%s\n", i + 1 < NUM_WORKLOADS ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  const char *dir = WORKLOAD_DEFAULT_DIR;
+  const char *json_path = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+      dir = argv[++i];
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      json_path = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--dir <workload dir>] [--json <output file>]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  WorkloadResult results[NUM_WORKLOADS] = {0};
+  bool ok[NUM_WORKLOADS] = {0};
+  int status = 0;
+
+  printf("%-14s %12s %14s %14s %12s %12s\n", "workload", "result", "ns/call", "instr/call", "Minstr/s", "arena (KiB)");
+  for (size_t i = 0; i < NUM_WORKLOADS; i++)
+  {
+    const Workload *w = &WORKLOADS[i];
+    ok[i] = run_workload(dir, w, &results[i]);
+    if (!ok[i])
+    {
+      status = 1;
+      printf("%-14s %12s\n", w->func_name, "FAILED");
+      continue;
+    }
+    const WorkloadResult *r = &results[i];
+    printf("%-14s %12d %14.0f %14llu %12.1f %12.1f\n", w->func_name, r->result, r->ns_per_call,
+           (unsigned long long)r->instructions_per_call, r->instructions_per_call / (r->ns_per_call * 1e-3),
+           r->arena_bytes / 1024.0);
+  }
+
+  if (json_path != NULL)
+  {
+    if (write_json(json_path, results, ok))
+    {
+      printf("\nResults written to %s\n", json_path);
+    }
+    else
+    {
+      fprintf(stderr, "Cannot write '%s'.\n", json_path);
+      status = 1;
+    }
+  }
+  return status;
+}
@@ -27,8 +27,14 @@
  *
  * test_ir_printer.c 验证 build_golden_ir() == get_golden_ir_text()。
  * test_ir_parser.c 验证 parse(get_golden_ir_text()) == get_golden_ir_text()。
+ *
+ * 另外还有各个测试共用的辅助函数 (见文件末尾):
+ * find_function() / find_block() 按名字查找函数 / 基本块，count_blocks() 统计块数；run_i32() 用解释器运行一个 i32 (i32) 函数，
+ * count_opcode() / count_opcode_in_block() / count_opcode_in_module() 统计函数 / 某个块 / 整个模块中
+ * 某种指令的条数。
  */
 
+#include "interpreter/interpreter.h"
 #include "ir/basicblock.h"
 #include "ir/builder.h"
 #include "ir/constant.h"
@@ -38,6 +44,9 @@
 #include "ir/module.h"
 #include "ir/type.h"
 #include "ir/value.h"
+#include "utils/data_layout.h"
+
+#include <string.h>
 
 /**
  * @brief [来源 1] 黄金 IR 字符串
@@ -145,3 +154,146 @@ build_golden_ir(IRContext *ctx, IRBuilder *builder)
 
   return mod;
 }
+
+/*
+ * =================================================================
+ * --- 测试共用的辅助函数 ---
+ * =================================================================
+ */
+
+/**
+ * @brief 按名字查找模块中的函数
+ *
+ * @return IRFunction* 没有找到时返回 NULL
+ */
+static __attribute__((unused)) IRFunction *
+find_function(IRModule *mod, const char *name)
+{
+  IDList *iter;
+  list_for_each(&mod->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    if (strcmp(func->entry_address.name, name) == 0)
+      return func;
+  }
+  return NULL;
+}
+
+/**
+ * @brief 按标签名查找函数中的基本块
+ *
+ * @return IRBasicBlock* 没有找到时返回 NULL
+ */
+static __attribute__((unused)) IRBasicBlock *
+find_block(IRFunction *func, const char *name)
+{
+  IDList *iter;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    if (strcmp(bb->label_address.name, name) == 0)
+      return bb;
+  }
+  return NULL;
+}
+
+/**
+ * @brief 函数中基本块的个数
+ */
+static __attribute__((unused)) size_t
+count_blocks(IRFunction *func)
+{
+  size_t count = 0;
+  IDList *iter;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief 用解释器运行 func(n)，返回 i32 结果
+ *
+ * @param interp 要使用的解释器；为 NULL 时临时创建一个 (按宿主 DataLayout)
+ * @return bool 执行失败或结果不是 i32 时返回 false
+ */
+static __attribute__((unused)) bool
+run_i32(Interpreter *interp, IRFunction *func, int32_t n, int32_t *out)
+{
+  DataLayout *dl = NULL;
+  Interpreter *own = NULL;
+  if (!interp)
+  {
+    dl = datalayout_create_host();
+    interp = own = interpreter_create(dl);
+  }
+  RuntimeValue arg = {.kind = RUNTIME_VAL_I32};
+  arg.as.val_i32 = n;
+  RuntimeValue *args[] = {&arg};
+  RuntimeValue result;
+  bool ok = interpreter_run_function(interp, func, args, 1, &result) && result.kind == RUNTIME_VAL_I32;
+  if (ok)
+    *out = result.as.val_i32;
+  if (own)
+  {
+    interpreter_destroy(own);
+    datalayout_destroy(dl);
+  }
+  return ok;
+}
+
+/**
+ * @brief 统计函数中 opcode 的指令数
+ */
+static __attribute__((unused)) size_t
+count_opcode(IRFunction *func, IROpcode opcode)
+{
+  size_t count = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      if (list_entry(inst_iter, IRInstruction, list_node)->opcode == opcode)
+        count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 统计函数中标签为 label 的块里 opcode 的指令数 (没有这个块时为 0)
+ */
+static __attribute__((unused)) size_t
+count_opcode_in_block(IRFunction *func, const char *label, IROpcode opcode)
+{
+  IRBasicBlock *bb = find_block(func, label);
+  if (!bb)
+    return 0;
+  size_t count = 0;
+  IDList *iter;
+  list_for_each(&bb->instructions, iter)
+  {
+    if (list_entry(iter, IRInstruction, list_node)->opcode == opcode)
+      count++;
+  }
+  return count;
+}
+
+/**
+ * @brief 统计模块中所有函数里 opcode 的指令数
+ */
+static __attribute__((unused)) size_t
+count_opcode_in_module(IRModule *mod, IROpcode opcode)
+{
+  size_t count = 0;
+  IDList *func_iter;
+  list_for_each(&mod->functions, func_iter)
+  {
+    count += count_opcode(list_entry(func_iter, IRFunction, list_node), opcode);
+  }
+  return count;
+}
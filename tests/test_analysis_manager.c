@@ -0,0 +1,175 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "analysis/analysis_manager.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+
+#include "test_utils.h"
+
+static const char LOOP_SOURCE[] = "define i32 @sum(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %acc: <i32> = alloc i32\n"
+                                  "  store 0: i32, %acc: <i32>\n"
+                                  "  br $loop\n"
+                                  "$loop:\n"
+                                  "  %a: i32 = load %acc: <i32>\n"
+                                  "  %c: i1 = icmp slt %a: i32, %n: i32\n"
+                                  "  br %c: i1, $body, $exit\n"
+                                  "$body:\n"
+                                  "  %a2: i32 = add %a: i32, 1: i32\n"
+                                  "  store %a2: i32, %acc: <i32>\n"
+                                  "  br $loop\n"
+                                  "$exit:\n"
+                                  "  ret %a: i32\n"
+                                  "}\n"
+                                  "\n"
+                                  "declare i32 @ext(i32)\n";
+
+/**
+ * @brief 结果被缓存；失效按保留的集合和依赖关系传递
+ */
+int
+test_analysis_manager_cache()
+{
+  SUITE_START("Analysis Manager: Cache and Invalidation");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, LOOP_SOURCE);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the module");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRFunction *decl = list_entry(mod->functions.next->next, IRFunction, list_node);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(am != NULL, "Creating the manager should succeed");
+
+  /// 支配边界把它依赖的支配树和 CFG 一起算出来
+  DominanceFrontier *df = ir_analysis_get_dom_frontier(am, func);
+  SUITE_ASSERT(df != NULL, "The loop function should have a dominance frontier");
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_CFG), "The CFG should be cached with the frontier");
+  SUITE_ASSERT(ir_analysis_get_dom_tree(am, func) == df->dom_tree, "The frontier should use the cached tree");
+  SUITE_ASSERT(ir_analysis_get_cfg(am, func) == df->dom_tree->cfg, "The tree should use the cached CFG");
+  SUITE_ASSERT(ir_analysis_get_dom_frontier(am, func) == df, "A second request should hit the cache");
+  for (int kind = 0; kind <= IR_ANALYSIS_DOM_FRONTIER; kind++)
+    SUITE_ASSERT(ir_analysis_num_computed(am, (IRAnalysisKind)kind) == 1, "Analysis %d computed more than once",
+                 kind);
+
+  /// 后支配边界复用同一个 CFG
+  DominanceFrontier *pdf = ir_analysis_get_post_dom_frontier(am, func);
+  PostDominatorTree *pdt = ir_analysis_get_post_dom_tree(am, func);
+  SUITE_ASSERT(pdf != NULL && pdt != NULL, "The loop function should have a post-dominator tree");
+  SUITE_ASSERT(pdf->dom_tree == pdt->tree, "The post-dominance frontier should use the cached tree");
+  SUITE_ASSERT(pdt->cfg == ir_analysis_get_cfg(am, func), "The post-dominator tree should use the cached CFG");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_CFG) == 1, "The CFG should be shared");
+
+  /// 只保留 CFG: 支配树和边界失效，CFG 不重算
+  ir_analysis_invalidate(am, func, IR_ANALYSIS_BIT(IR_ANALYSIS_CFG));
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_CFG), "The preserved CFG should stay cached");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE), "The dominator tree should be dropped");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_FRONTIER), "The frontier should be dropped");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_POST_DOM_TREE),
+               "The post-dominator tree should be dropped");
+  SUITE_ASSERT(ir_analysis_get_dom_frontier(am, func) != NULL, "The frontier should be recomputed");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_CFG) == 1, "The CFG should not be recomputed");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_DOM_TREE) == 2, "The tree should be recomputed once");
+
+  /// 保留支配树但不保留 CFG: 支配树依赖 CFG，仍然失效
+  ir_analysis_invalidate(am, func, IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_TREE) | IR_ANALYSIS_BIT(IR_ANALYSIS_DOM_FRONTIER));
+  for (int kind = 0; kind < IR_ANALYSIS_COUNT; kind++)
+    SUITE_ASSERT(!ir_analysis_is_cached(am, func, (IRAnalysisKind)kind),
+                 "Analysis %d depends on the CFG and should be dropped", kind);
+
+  ir_analysis_get_dom_tree(am, func);
+  ir_analysis_invalidate(am, func, IR_PRESERVE_ALL);
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE), "IR_PRESERVE_ALL keeps everything");
+
+  /// 声明没有分析结果，也不会反复尝试
+  SUITE_ASSERT(ir_analysis_get_dom_tree(am, decl) == NULL, "A declaration has no dominator tree");
+  SUITE_ASSERT(ir_analysis_is_cached(am, decl, IR_ANALYSIS_DOM_TREE), "The empty result should be cached");
+
+  ir_analysis_forget(am, func);
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_CFG), "Forgetting a function drops its cache");
+  SUITE_ASSERT(ir_analysis_get_cfg(am, func) != NULL, "A forgotten function can be analyzed again");
+
+  ir_analysis_manager_destroy(am);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 验证器和 mem2reg 共用缓存；mem2reg 保留控制流分析
+ */
+int
+test_analysis_manager_pipeline()
+{
+  SUITE_START("Analysis Manager: Verifier and Mem2Reg");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, LOOP_SOURCE);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the module");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_verify_module_with_analyses(mod, am), "The module should verify");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_DOM_TREE) == 1, "The verifier should cache the tree");
+
+  SUITE_ASSERT(ir_analysis_get_liveness(am, func) != NULL, "The loop function should have liveness");
+
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote %%acc");
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE), "mem2reg preserves the tree");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_LIVENESS),
+               "mem2reg changes instructions, so liveness should be dropped");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_DOM_FRONTIER) == 0, "mem2reg should not need the frontier");
+
+  SUITE_ASSERT(ir_verify_function_with_analyses(func, am), "The promoted function should verify");
+  SUITE_ASSERT(ir_verify_function(func), "The promoted function should verify without the cache");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_CFG) == 1, "The whole pipeline should build one CFG");
+  SUITE_ASSERT(ir_analysis_num_computed(am, IR_ANALYSIS_DOM_TREE) == 1, "The whole pipeline should build one tree");
+
+  SUITE_ASSERT(!ir_transform_mem2reg_run_with_analyses(func, am), "A second mem2reg has nothing to promote");
+
+  ir_analysis_manager_destroy(am);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Analysis Manager";
+  __calir_total_suites_run++;
+  if (test_analysis_manager_cache() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_analysis_manager_pipeline() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -252,6 +252,230 @@ test_count_slow(Bump *arena)
   SUITE_END();
 }
 
+/** @brief [辅助] xorshift64，测试输入只需要可重复 */
+static uint64_t
+next_random(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+int
+test_count_iterate(Bump *arena)
+{
+  SUITE_START("Bitset: count / find_next / for_each");
+
+  Bitset *empty = bitset_create(0, arena);
+  SUITE_ASSERT(bitset_count(empty) == 0, "Empty (0 bits) count should be 0");
+  SUITE_ASSERT(bitset_find_next(empty, 0) == 0, "find_next on 0 bits should return num_bits");
+
+  Bitset *bs = bitset_create(150, arena);
+  SUITE_ASSERT(bitset_find_next(bs, 0) == 150, "find_next on an empty set should return num_bits");
+  const size_t bits[] = {0, 1, 63, 64, 100, 127, 128, 149};
+  for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+    bitset_set(bs, bits[i]);
+  SUITE_ASSERT(bitset_count(bs) == 8, "Count should be 8, got %zu", bitset_count(bs));
+  SUITE_ASSERT(bitset_find_next(bs, 2) == 63, "find_next(2) should be 63");
+  SUITE_ASSERT(bitset_find_next(bs, 65) == 100, "find_next(65) should be 100");
+  SUITE_ASSERT(bitset_find_next(bs, 149) == 149, "find_next(149) should be 149");
+  SUITE_ASSERT(bitset_find_next(bs, 150) == 150, "find_next past the end should return num_bits");
+
+  size_t seen = 0;
+  bitset_for_each(bs, bit)
+  {
+    SUITE_ASSERT(seen < 8 && bit == bits[seen], "Iteration #%zu should visit %zu, got %zu", seen, bits[seen], bit);
+    seen++;
+  }
+  SUITE_ASSERT(seen == 8, "Iteration should visit 8 bits, visited %zu", seen);
+
+  /// 全集的尾部字只有有效位会被数到 / 遍历到
+  Bitset *all = bitset_create_all(100, arena);
+  SUITE_ASSERT(bitset_count(all) == 100, "Count all (100) should be 100, got %zu", bitset_count(all));
+  seen = 0;
+  bitset_for_each(all, bit)
+  {
+    (void)bit;
+    seen++;
+  }
+  SUITE_ASSERT(seen == 100, "Iterating all (100) should visit 100 bits, visited %zu", seen);
+
+  /// 大集合 (走按 CPU 选择的实现) 与 count_slow 一致
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  Bitset *big = bitset_create(10007, arena);
+  for (size_t i = 0; i < 3000; i++)
+    bitset_set(big, next_random(&seed) % 10007);
+  SUITE_ASSERT(bitset_count(big) == bitset_count_slow(big), "count (%zu) should match count_slow (%zu)",
+               bitset_count(big), bitset_count_slow(big));
+  size_t iterated = 0;
+  size_t prev = 0;
+  bool ordered = true;
+  bitset_for_each(big, bit)
+  {
+    ordered &= iterated == 0 || bit > prev;
+    ordered &= bitset_test(big, bit);
+    prev = bit;
+    iterated++;
+  }
+  SUITE_ASSERT(ordered, "Iteration should visit set bits in ascending order");
+  SUITE_ASSERT(iterated == bitset_count(big), "Iteration visited %zu bits, count is %zu", iterated, bitset_count(big));
+
+  SUITE_END();
+}
+
+int
+test_with_ops(Bump *arena)
+{
+  SUITE_START("Bitset: in-place ops with change reporting");
+
+  /// 小集合 (内联的基线实现) 与大集合 (按 CPU 选择的实现) 都要覆盖
+  const size_t sizes[] = {100, 64 * 16 + 5, 5000};
+  uint64_t seed = 12345;
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    size_t n = sizes[s];
+    Bitset *a = bitset_create(n, arena);
+    Bitset *b = bitset_create(n, arena);
+    Bitset *expected = bitset_create(n, arena);
+    for (size_t i = 0; i < n / 3; i++)
+    {
+      bitset_set(a, next_random(&seed) % n);
+      bitset_set(b, next_random(&seed) % n);
+    }
+
+    bitset_union(expected, a, b);
+    Bitset *dest = bitset_create(n, arena);
+    bitset_copy(dest, a);
+    SUITE_ASSERT(bitset_union_with(dest, b), "[%zu] union_with should report a change", n);
+    SUITE_ASSERT(bitset_equals(dest, expected), "[%zu] union_with result mismatch", n);
+    SUITE_ASSERT(!bitset_union_with(dest, b), "[%zu] Repeated union_with should report no change", n);
+    SUITE_ASSERT(!bitset_union_with(dest, a), "[%zu] union_with a subset should report no change", n);
+
+    bitset_intersect(expected, a, b);
+    bitset_copy(dest, a);
+    SUITE_ASSERT(bitset_intersect_with(dest, b), "[%zu] intersect_with should report a change", n);
+    SUITE_ASSERT(bitset_equals(dest, expected), "[%zu] intersect_with result mismatch", n);
+    SUITE_ASSERT(!bitset_intersect_with(dest, a), "[%zu] intersect_with a superset should report no change", n);
+
+    bitset_difference(expected, a, b);
+    bitset_copy(dest, a);
+    SUITE_ASSERT(bitset_difference_with(dest, b), "[%zu] difference_with should report a change", n);
+    SUITE_ASSERT(bitset_equals(dest, expected), "[%zu] difference_with result mismatch", n);
+    SUITE_ASSERT(!bitset_difference_with(dest, b), "[%zu] Repeated difference_with should report no change", n);
+
+    /// 逐位核对三地址的运算
+    bitset_union(expected, a, b);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+      ok &= bitset_test(expected, i) == (bitset_test(a, i) || bitset_test(b, i));
+    SUITE_ASSERT(ok, "[%zu] union does not match the per-bit reference", n);
+  }
+
+  SUITE_END();
+}
+
+int
+test_sparse(Bump *arena)
+{
+  SUITE_START("Bitset: sparse / dense hybrid");
+
+  /// 很小的集合直接是稠密的
+  SparseBitset *tiny = sparse_bitset_create(100, arena);
+  SUITE_ASSERT(sparse_bitset_is_dense(tiny), "A 100-bit hybrid set should start dense");
+  sparse_bitset_set(tiny, 42);
+  SUITE_ASSERT(sparse_bitset_test(tiny, 42) && sparse_bitset_count(tiny) == 1, "Dense set/test/count failed");
+
+  const size_t n = 1000000;
+  SparseBitset *sbs = sparse_bitset_create(n, arena);
+  SUITE_ASSERT(!sparse_bitset_is_dense(sbs), "A 1M-bit hybrid set should start sparse");
+  SUITE_ASSERT(sparse_bitset_find_next(sbs, 0) == n, "find_next on an empty set should return num_bits");
+
+  const size_t bits[] = {999999, 5, 70000, 6, 128, 500000};
+  for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+    sparse_bitset_set(sbs, bits[i]);
+  sparse_bitset_set(sbs, 5);
+  SUITE_ASSERT(sparse_bitset_count(sbs) == 6, "Count should be 6, got %zu", sparse_bitset_count(sbs));
+  SUITE_ASSERT(sbs->num_words == 5, "Bits 5 and 6 share a word: 5 sparse words expected, got %zu", sbs->num_words);
+  SUITE_ASSERT(sparse_bitset_test(sbs, 70000) && !sparse_bitset_test(sbs, 70001), "Sparse test failed");
+
+  const size_t sorted[] = {5, 6, 128, 70000, 500000, 999999};
+  size_t seen = 0;
+  sparse_bitset_for_each(sbs, bit)
+  {
+    SUITE_ASSERT(seen < 6 && bit == sorted[seen], "Sparse iteration #%zu should visit %zu, got %zu", seen,
+                 sorted[seen], bit);
+    seen++;
+  }
+  SUITE_ASSERT(seen == 6, "Sparse iteration should visit 6 bits, visited %zu", seen);
+  SUITE_ASSERT(sparse_bitset_find_next(sbs, 7) == 128, "find_next(7) should be 128");
+
+  sparse_bitset_clear(sbs, 128);
+  sparse_bitset_clear(sbs, 5);
+  sparse_bitset_clear(sbs, 12345);
+  SUITE_ASSERT(sbs->num_words == 4, "Clearing the only bit of a word should drop it, got %zu words", sbs->num_words);
+  SUITE_ASSERT(sparse_bitset_find_next(sbs, 7) == 70000, "find_next(7) after clear should be 70000");
+
+  /// 稀疏 ∪ 稀疏: 归并，报告是否改变
+  SparseBitset *other = sparse_bitset_create(n, arena);
+  sparse_bitset_set(other, 6);
+  sparse_bitset_set(other, 300);
+  sparse_bitset_set(other, 999998);
+  SUITE_ASSERT(sparse_bitset_union_with(sbs, other), "Sparse union should report a change");
+  SUITE_ASSERT(!sparse_bitset_union_with(sbs, other), "Repeated sparse union should report no change");
+  SUITE_ASSERT(sparse_bitset_count(sbs) == 6, "Count after union should be 6, got %zu", sparse_bitset_count(sbs));
+  SUITE_ASSERT(!sparse_bitset_is_dense(sbs), "A few words should stay sparse");
+
+  /// 与随机的参考集合对照，直到转为稠密
+  Bitset *reference = bitset_create(n, arena);
+  for (size_t i = 0; i < sizeof(sorted) / sizeof(sorted[0]); i++)
+  {
+    if (sparse_bitset_test(sbs, sorted[i]))
+      bitset_set(reference, sorted[i]);
+  }
+  bitset_set(reference, 300);
+  bitset_set(reference, 999998);
+  uint64_t seed = 777;
+  SparseBitset *random = sparse_bitset_create(n, arena);
+  for (size_t i = 0; i < 2000; i++)
+  {
+    size_t bit = next_random(&seed) % n;
+    sparse_bitset_set(random, bit);
+    bitset_set(reference, bit);
+  }
+  SUITE_ASSERT(sparse_bitset_union_with(sbs, random), "Union with random bits should report a change");
+  SUITE_ASSERT(sparse_bitset_count(sbs) == bitset_count(reference), "Count %zu should match the reference %zu",
+               sparse_bitset_count(sbs), bitset_count(reference));
+  bool same = true;
+  size_t next = bitset_find_next(reference, 0);
+  sparse_bitset_for_each(sbs, bit)
+  {
+    same &= bit == next;
+    next = bitset_find_next(reference, next + 1);
+  }
+  SUITE_ASSERT(same && next == n, "Sparse iteration should match the reference set");
+
+  /// 非 0 的字超过 1/4 后转为稠密，内容不变
+  SparseBitset *filling = sparse_bitset_create(64 * 64, arena);
+  for (size_t w = 0; w < 64; w++)
+    sparse_bitset_set(filling, w * 64 + (w % 64));
+  SUITE_ASSERT(sparse_bitset_is_dense(filling), "A set with every word non-zero should become dense");
+  SUITE_ASSERT(sparse_bitset_count(filling) == 64, "Densified count should be 64, got %zu",
+               sparse_bitset_count(filling));
+  SUITE_ASSERT(sparse_bitset_test(filling, 0) && sparse_bitset_test(filling, 63 * 64 + 63),
+               "Densified set lost bits");
+
+  /// 稀疏 ∪ 稠密: dest 转为稠密
+  SparseBitset *sparse_dest = sparse_bitset_create(64 * 64, arena);
+  sparse_bitset_set(sparse_dest, 1);
+  SUITE_ASSERT(sparse_bitset_union_with(sparse_dest, filling), "Sparse ∪ dense should report a change");
+  SUITE_ASSERT(sparse_bitset_is_dense(sparse_dest) && sparse_bitset_count(sparse_dest) == 65,
+               "Sparse ∪ dense should give a dense set of 65 bits");
+
+  SUITE_END();
+}
+
 int
 main()
 {
@@ -297,6 +521,24 @@ main()
     __calir_total_suites_failed++;
   }
 
+  __calir_total_suites_run++;
+  if (test_count_iterate(&arena) != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_with_ops(&arena) != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_sparse(&arena) != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
   bump_destroy(&arena);
 
   TEST_SUMMARY();
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/bump.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#include "test_utils.h"
+
+/// 测试里用的缓存上限 (AddressSanitizer 构建默认关闭缓存，所以每个套件都显式设置)
+#define TEST_CACHE_LIMIT ((size_t)64 << 20)
+
+#define MIB ((size_t)1 << 20)
+
+/** @brief 新建一个 Arena 并分配 size 字节，返回它当前的 Chunk */
+static ChunkFooter *
+arena_with(Bump *bump, size_t size, size_t align)
+{
+  bump_init(bump);
+  if (!bump_alloc(bump, size, align))
+    return NULL;
+  return bump->current_chunk_footer;
+}
+
+/** @brief 清空缓存，从已知状态开始 */
+static void
+fresh_cache(void)
+{
+  bump_set_chunk_cache_limit(TEST_CACHE_LIMIT);
+  bump_trim_chunk_cache();
+}
+
+int
+test_reuse_after_destroy_and_reset(void)
+{
+  SUITE_START("Bump: chunks are reused after destroy and reset");
+  fresh_cache();
+
+  Bump a;
+  ChunkFooter *chunk = arena_with(&a, 100, 8);
+  SUITE_ASSERT(chunk != NULL, "Allocation should succeed");
+  unsigned char *data = chunk->data;
+  size_t size = chunk->chunk_size;
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "Nothing should be cached before a destroy");
+
+  bump_destroy(&a);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == size, "Destroy should cache the chunk (%zu bytes), cache holds %zu", size,
+               bump_chunk_cache_bytes());
+
+  Bump b;
+  chunk = arena_with(&b, 100, 8);
+  SUITE_ASSERT(chunk->data == data, "A new arena should reuse the cached chunk");
+  SUITE_ASSERT(chunk->chunk_size == size && !chunk->mapped, "The reused chunk should keep its size and flags");
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "Taking the chunk should empty the cache");
+
+  /// 第二个 Chunk 装不进第一个，reset 之后只保留最新的那个，第一个进入缓存
+  SUITE_ASSERT(bump_alloc(&b, 4096, 8) != NULL, "Allocation should succeed");
+  SUITE_ASSERT(b.current_chunk_footer->data != data, "A 4 KiB allocation should need a second chunk");
+  bump_reset(&b);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == size, "Reset should cache the older chunk, cache holds %zu",
+               bump_chunk_cache_bytes());
+
+  Bump c;
+  chunk = arena_with(&c, 100, 8);
+  SUITE_ASSERT(chunk->data == data, "The chunk released by reset should be reused");
+
+  bump_destroy(&b);
+  bump_destroy(&c);
+  bump_trim_chunk_cache();
+  SUITE_END();
+}
+
+int
+test_size_cap_and_alignment(void)
+{
+  SUITE_START("Bump: cached chunks must fit the size cap and alignment");
+  fresh_cache();
+
+  /// 10000 字节的 Chunk 和 4 KiB 的请求在相邻的桶里，但大于请求的两倍
+  Bump big;
+  ChunkFooter *chunk = arena_with(&big, 10000, 8);
+  unsigned char *big_data = chunk->data;
+  size_t big_size = chunk->chunk_size;
+  bump_destroy(&big);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == big_size, "The 10000-byte chunk should be cached");
+
+  Bump small;
+  chunk = arena_with(&small, 100, 8);
+  SUITE_ASSERT(chunk->data != big_data, "A chunk more than twice the request should not be reused");
+  SUITE_ASSERT(bump_chunk_cache_bytes() == big_size, "The oversized chunk should stay cached");
+  bump_destroy(&small);
+  bump_trim_chunk_cache();
+
+  chunk = arena_with(&big, 10000, 8);
+  big_data = chunk->data;
+  bump_destroy(&big);
+  Bump medium;
+  chunk = arena_with(&medium, 6000, 8);
+  SUITE_ASSERT(chunk->data == big_data, "A chunk within twice the request should be reused");
+  bump_destroy(&medium);
+  bump_trim_chunk_cache();
+
+  /// 用恰好比缓存的 Chunk 起始地址更严格的对齐去请求
+  Bump a;
+  chunk = arena_with(&a, 100, 8);
+  unsigned char *data = chunk->data;
+  size_t size = chunk->chunk_size;
+  size_t align = ((uintptr_t)data & -(uintptr_t)data) * 2;
+  bump_destroy(&a);
+
+  Bump aligned;
+  chunk = arena_with(&aligned, 100, align);
+  SUITE_ASSERT(chunk->data != data, "A chunk not aligned to %zu should not be reused", align);
+  SUITE_ASSERT((uintptr_t)chunk->data % align == 0, "The new chunk should be aligned to %zu", align);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == size, "The misaligned chunk should stay cached");
+
+  Bump plain;
+  chunk = arena_with(&plain, 100, 8);
+  SUITE_ASSERT(chunk->data == data, "The same chunk should be reused by a request it is aligned for");
+
+  bump_destroy(&aligned);
+  bump_destroy(&plain);
+  bump_trim_chunk_cache();
+  SUITE_END();
+}
+
+int
+test_eviction_and_trim(void)
+{
+  SUITE_START("Bump: eviction, per-chunk cap and trim");
+  fresh_cache();
+
+  Bump a, b;
+  size_t size_a = arena_with(&a, 100, 8)->chunk_size;
+  size_t size_b = arena_with(&b, 6000, 8)->chunk_size;
+  bump_destroy(&a);
+  bump_destroy(&b);
+  size_t total = size_a + size_b;
+  SUITE_ASSERT(bump_chunk_cache_bytes() == total, "Both chunks should be cached, cache holds %zu",
+               bump_chunk_cache_bytes());
+
+  /// 降低上限会立即淘汰，直到总量不超过新的上限
+  size_t lowered = total - 1;
+  bump_set_chunk_cache_limit(lowered);
+  size_t left = bump_chunk_cache_bytes();
+  SUITE_ASSERT(left <= lowered && left > 0, "Lowering the limit to %zu should evict one chunk, cache holds %zu",
+               lowered, left);
+
+  /// 提高上限不会淘汰；trim 清空缓存但保留上限
+  bump_set_chunk_cache_limit(TEST_CACHE_LIMIT);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == left, "Raising the limit should not evict");
+  bump_trim_chunk_cache();
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "Trim should empty the cache");
+  arena_with(&a, 100, 8);
+  bump_destroy(&a);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == size_a, "Trim should keep the limit, so chunks are cached again");
+  bump_trim_chunk_cache();
+
+  /// 超过上限四分之一的 Chunk 直接还给系统
+  bump_set_chunk_cache_limit(4 * size_a);
+  arena_with(&b, 6000, 8);
+  bump_destroy(&b);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "A chunk over a quarter of the limit should not be cached");
+
+  /// 上限 0 关闭缓存
+  bump_set_chunk_cache_limit(0);
+  arena_with(&a, 100, 8);
+  bump_destroy(&a);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "A zero limit should disable the cache");
+
+  bump_set_chunk_cache_limit(TEST_CACHE_LIMIT);
+  SUITE_END();
+}
+
+int
+test_limited_arena_skips_cache(void)
+{
+  SUITE_START("Bump: arenas with an allocation limit skip the cache");
+  fresh_cache();
+
+  Bump a;
+  ChunkFooter *chunk = arena_with(&a, 100, 8);
+  unsigned char *data = chunk->data;
+  size_t size = chunk->chunk_size;
+  bump_destroy(&a);
+
+  Bump limited;
+  bump_init(&limited);
+  bump_set_allocation_limit(&limited, MIB);
+  SUITE_ASSERT(bump_alloc(&limited, 100, 8) != NULL, "Allocation under the limit should succeed");
+  SUITE_ASSERT(limited.current_chunk_footer->data != data, "A limited arena should not take a cached chunk");
+  SUITE_ASSERT(bump_chunk_cache_bytes() == size, "The cached chunk should stay cached");
+
+  bump_destroy(&limited);
+  bump_trim_chunk_cache();
+  SUITE_END();
+}
+
+int
+test_huge_page_chunks(void)
+{
+  SUITE_START("Bump: mmap chunks above the huge page threshold");
+  fresh_cache();
+  bump_set_huge_page_threshold(MIB);
+
+  Bump small;
+  ChunkFooter *chunk = arena_with(&small, 100, 8);
+  SUITE_ASSERT(!chunk->mapped, "Chunks below the threshold should come from malloc");
+  bump_destroy(&small);
+  bump_trim_chunk_cache();
+
+  Bump huge;
+  chunk = arena_with(&huge, 3 * MIB / 2, 8);
+  SUITE_ASSERT(chunk != NULL, "Allocation above the threshold should succeed");
+  SUITE_ASSERT(chunk->mapped, "Chunks above the threshold should be mmapped");
+  SUITE_ASSERT(chunk->chunk_size == 2 * MIB, "The mapping should be rounded up to 2 MiB, got %zu", chunk->chunk_size);
+  unsigned char *data = chunk->data;
+
+  /// 缓存的映射保留 mapped 标志，复用之后仍然用 munmap 释放
+  bump_destroy(&huge);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 2 * MIB, "The mapped chunk should be cached");
+  Bump again;
+  chunk = arena_with(&again, 3 * MIB / 2, 8);
+  SUITE_ASSERT(chunk->data == data && chunk->mapped, "The reused mapping should keep its mapped flag");
+  bump_destroy(&again);
+  bump_trim_chunk_cache();
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "Trim should unmap the cached mapping");
+
+  /// 不缓存时直接 munmap
+  bump_set_chunk_cache_limit(0);
+  chunk = arena_with(&huge, 3 * MIB / 2, 8);
+  SUITE_ASSERT(chunk->mapped, "Chunks above the threshold should be mmapped");
+  bump_destroy(&huge);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "With the cache off the mapping should be unmapped directly");
+
+  bump_set_huge_page_threshold(0);
+  chunk = arena_with(&huge, 3 * MIB / 2, 8);
+  SUITE_ASSERT(!chunk->mapped, "A zero threshold should turn mmap off");
+  bump_destroy(&huge);
+  SUITE_ASSERT(bump_chunk_cache_bytes() == 0, "The malloc chunk should not be cached either");
+
+  bump_set_chunk_cache_limit(TEST_CACHE_LIMIT);
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Bump";
+
+  __calir_total_suites_run++;
+  if (test_reuse_after_destroy_and_reset() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_size_cap_and_alignment() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_eviction_and_trim() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_limited_arena_skips_cache() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_huge_page_chunks() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  TEST_SUMMARY();
+}
@@ -0,0 +1,573 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/global.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+#include "ir/use.h"
+#include "ir/verifier.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+#include "utils/id_list.h"
+
+#include "test_utils.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif
+
+/*
+ * =================================================================
+ * --- IRContext: 常量分片缓存与并发构建 ---
+ * =================================================================
+ */
+
+enum
+{
+  NUM_THREADS = 4,
+  FUNCS_PER_THREAD = 3,
+  NUM_FUNCS = NUM_THREADS * FUNCS_PER_THREAD,
+  CHAIN_LENGTH = 300,
+  /** 链上轮流使用的大常量个数 (不在小整数表中，走分片缓存) */
+  NUM_BIG_CONSTANTS = 32,
+  BIG_CONSTANT_BASE = 100000,
+};
+
+/**
+ * @brief [辅助] 数一个值的 Use 个数
+ */
+static size_t
+count_uses(IRValueNode *value)
+{
+  size_t n = 0;
+  IDList *iter;
+  list_for_each(&value->uses, iter)
+  {
+    n++;
+  }
+  return n;
+}
+
+/**
+ * @brief 分片缓存中的常量按类型和位模式唯一化
+ */
+int
+test_constant_shards()
+{
+  SUITE_START("IRContext: Constant Shards");
+
+  IRContext *ctx = ir_context_create();
+
+  /// 大量不同的值分布到各个分片，再取一次得到同一个对象
+  IRValueNode *firsts[2000];
+  for (int i = 0; i < 2000; i++)
+    firsts[i] = ir_constant_get_i64(ctx, (int64_t)i * 7919 + 5000);
+  for (int i = 0; i < 2000; i++)
+  {
+    IRValueNode *again = ir_constant_get_i64(ctx, (int64_t)i * 7919 + 5000);
+    SUITE_ASSERT(again == firsts[i], "i64 %d should be unique", i * 7919 + 5000);
+    SUITE_ASSERT(((IRConstant *)again)->data.int_val == (int64_t)i * 7919 + 5000, "i64 %d has the wrong value", i);
+  }
+  size_t used_shards = 0;
+  for (size_t i = 0; i < IR_CONSTANT_CACHE_SHARDS; i++)
+  {
+    I64HashMap *table = ctx->constant_shards[i].values[IR_CONSTANT_TABLE_I64];
+    used_shards += table && i64_hashmap_size(table) > 0;
+  }
+  SUITE_ASSERT(used_shards == IR_CONSTANT_CACHE_SHARDS, "Only %zu shards were used", used_shards);
+
+  /// 同一个值、不同类型是不同的常量
+  SUITE_ASSERT(ir_constant_get_i32(ctx, 40000) != ir_constant_get_i64(ctx, 40000), "i32 and i64 must differ");
+  SUITE_ASSERT(ir_constant_get_i16(ctx, 4000) != ir_constant_get_i32(ctx, 4000), "i16 and i32 must differ");
+  SUITE_ASSERT(ir_constant_get_f32(ctx, 1.5f) != ir_constant_get_f64(ctx, 1.5), "f32 and f64 must differ");
+
+  /// 浮点数按位模式比较
+  SUITE_ASSERT(ir_constant_get_f64(ctx, 0.0) != ir_constant_get_f64(ctx, -0.0), "0.0 and -0.0 must differ");
+  SUITE_ASSERT(ir_constant_get_f64(ctx, NAN) == ir_constant_get_f64(ctx, NAN), "NaN should be unique");
+  SUITE_ASSERT(ir_constant_get_f32(ctx, 2.25f) == ir_constant_get_f32(ctx, 2.25f), "f32 should be unique");
+
+  /// undef 按类型唯一化，并且不和整数 0 混淆
+  IRValueNode *undef = ir_constant_get_undef(ctx, ir_type_get_i64(ctx));
+  SUITE_ASSERT(undef == ir_constant_get_undef(ctx, ir_type_get_i64(ctx)), "undef should be unique");
+  SUITE_ASSERT(undef != ir_constant_get_undef(ctx, ir_type_get_i32(ctx)), "undef i32 and i64 must differ");
+  SUITE_ASSERT(((IRConstant *)undef)->const_kind == CONST_KIND_UNDEF, "undef has the wrong kind");
+
+  /// 常量在 reset 之后仍然有效
+  ir_context_reset_ir_arena(ctx);
+  SUITE_ASSERT(ir_constant_get_i64(ctx, 5000) == firsts[0], "Constants should survive an IR arena reset");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+#ifndef __STDC_NO_THREADS__
+/** @brief test_concurrent_build 中每个线程的输入 */
+typedef struct BuildJob
+{
+  IRContext *ctx;
+  IRContextWorker worker;
+  IRFunction *funcs[FUNCS_PER_THREAD];
+  IRValueNode *global;
+  IRValueNode *callee;
+  bool ok;
+} BuildJob;
+
+/**
+ * @brief [辅助] 构建一条 add 链 (每一步先加一个大常量、再加一个小常量)，
+ * 然后删掉奇数步的第二个 add (它们的使用换成 undef)
+ */
+static bool
+build_and_transform(BuildJob *job, IRBuilder *b, IRFunction *func)
+{
+  IRContext *ctx = job->ctx;
+  IRBasicBlock *entry = ir_basic_block_create(func, "entry");
+  if (!entry)
+    return false;
+  ir_function_append_basic_block(func, entry);
+  ir_builder_set_insertion_point(b, entry);
+
+  IRValueNode *v = &list_entry(func->arguments.next, IRArgument, list_node)->value;
+  IRValueNode *chain[CHAIN_LENGTH];
+  for (int i = 0; i < CHAIN_LENGTH; i++)
+  {
+    IRValueNode *big = ir_constant_get_i32(ctx, BIG_CONSTANT_BASE + i % NUM_BIG_CONSTANTS);
+    v = ir_builder_create_add(b, v, big, NULL);
+    v = ir_builder_create_add(b, v, ir_constant_get_i32(ctx, i % 10), NULL);
+    chain[i] = v;
+  }
+  IRValueNode *loaded = ir_builder_create_load(b, job->global, NULL);
+  /// 5 个实参 + callee: 操作数数组扩容时搬动共享值的 Use
+  IRValueNode *args[] = {v, loaded, ir_constant_get_i32(ctx, BIG_CONSTANT_BASE),
+                         ir_constant_get_i32(ctx, BIG_CONSTANT_BASE + 1), ir_constant_get_i32(ctx, 3)};
+  IRValueNode *call = ir_builder_create_call(b, job->callee, args, 5, NULL);
+  ir_builder_create_ret(b, call);
+
+  for (int i = 1; i < CHAIN_LENGTH; i += 2)
+    ir_instruction_erase_from_parent(container_of(chain[i], IRInstruction, result));
+  return true;
+}
+
+static int
+run_build_job(void *opaque)
+{
+  BuildJob *job = opaque;
+  job->ok = ir_context_enter_worker(job->ctx, &job->worker);
+  if (!job->ok)
+    return 0;
+  IRBuilder *b = ir_builder_create(job->ctx);
+  for (int i = 0; i < FUNCS_PER_THREAD && job->ok; i++)
+    job->ok = b && build_and_transform(job, b, job->funcs[i]);
+  ir_builder_destroy(b);
+  ir_context_leave_worker(&job->worker);
+  return 0;
+}
+#endif
+
+/**
+ * @brief 多个线程同时构建并变换同一个模块中的不同函数
+ *
+ * 之后每个共享常量的 Use 链表必须与所有指令的操作数完全一致。
+ */
+int
+test_concurrent_build()
+{
+  SUITE_START("IRContext: Concurrent Build");
+
+#ifndef __STDC_NO_THREADS__
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "@g: <i32> = global 5: i32\n"
+                                       "declare i32 @ext(%a: i32, %b: i32, %c: i32, %d: i32, %e: i32)\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse module header");
+  IRValueNode *global = &list_entry(mod->globals.next, IRGlobalVariable, list_node)->value;
+  IRValueNode *callee = &list_entry(mod->functions.next, IRFunction, list_node)->entry_address;
+
+  /// 函数头在主线程上创建 (模块的函数链表不是线程安全的)
+  BuildJob jobs[NUM_THREADS];
+  IRType *i32 = ir_type_get_i32(ctx);
+  for (int t = 0; t < NUM_THREADS; t++)
+  {
+    jobs[t] = (BuildJob){.ctx = ctx, .global = global, .callee = callee, .ok = false};
+    for (int i = 0; i < FUNCS_PER_THREAD; i++)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "chain_%d_%d", t, i);
+      IRFunction *func = ir_function_create(mod, name, i32);
+      ir_argument_create(func, i32, "x");
+      ir_function_finalize_signature(func, false);
+      jobs[t].funcs[i] = func;
+    }
+  }
+
+  SUITE_ASSERT(ir_context_begin_concurrent(ctx), "Failed to enter concurrent mode");
+  thrd_t threads[NUM_THREADS];
+  for (int t = 0; t < NUM_THREADS; t++)
+    SUITE_ASSERT(thrd_create(&threads[t], run_build_job, &jobs[t]) == thrd_success, "Failed to start thread %d", t);
+  for (int t = 0; t < NUM_THREADS; t++)
+  {
+    thrd_join(threads[t], NULL);
+    SUITE_ASSERT(jobs[t].ok, "Thread %d failed to build its functions", t);
+    ir_context_adopt_worker(ctx, &jobs[t].worker);
+  }
+  ir_context_end_concurrent(ctx);
+
+  SUITE_ASSERT(ir_verify_module(mod), "The concurrently built module should verify");
+
+  /// 每个大常量: 链上每一步的第一个 add 中各一次 (被删掉的是第二个)，call 中 BASE 和 BASE+1 各一次
+  for (int k = 0; k < NUM_BIG_CONSTANTS; k++)
+  {
+    size_t per_func = 0;
+    for (int i = 0; i < CHAIN_LENGTH; i++)
+      per_func += i % NUM_BIG_CONSTANTS == k;
+    per_func += k < 2;
+    IRValueNode *big = ir_constant_get_i32(ctx, BIG_CONSTANT_BASE + k);
+    SUITE_ASSERT(count_uses(big) == per_func * NUM_FUNCS, "Constant %d has %zu uses, expected %zu",
+                 BIG_CONSTANT_BASE + k, count_uses(big), per_func * NUM_FUNCS);
+
+    IDList *iter;
+    list_for_each(&big->uses, iter)
+    {
+      IRUse *use = list_entry(iter, IRUse, value_node);
+      SUITE_ASSERT(use->value == big, "A use of constant %d points elsewhere", BIG_CONSTANT_BASE + k);
+    }
+  }
+  SUITE_ASSERT(count_uses(global) == NUM_FUNCS, "@g has %zu uses", count_uses(global));
+  SUITE_ASSERT(count_uses(callee) == NUM_FUNCS, "@ext has %zu uses", count_uses(callee));
+  size_t undef_uses = count_uses(ir_constant_get_undef(ctx, i32));
+  SUITE_ASSERT(undef_uses == (size_t)NUM_FUNCS * (CHAIN_LENGTH / 2), "undef has %zu uses", undef_uses);
+
+  ir_context_destroy(ctx);
+#endif
+
+  SUITE_END();
+}
+
+#define LAYOUT_TYPES 64
+
+typedef struct LayoutJob
+{
+  const DataLayout *dl;
+  IRType **types;
+  size_t sizes[LAYOUT_TYPES];
+  size_t last_offsets[LAYOUT_TYPES];
+} LayoutJob;
+
+#ifndef __STDC_NO_THREADS__
+static int
+run_layout_job(void *arg)
+{
+  LayoutJob *job = (LayoutJob *)arg;
+  for (int round = 0; round < 50; round++)
+  {
+    for (size_t i = 0; i < LAYOUT_TYPES; i++)
+    {
+      IRType *type = job->types[i];
+      job->sizes[i] = datalayout_get_type_size(job->dl, type);
+      job->last_offsets[i] = datalayout_get_struct_member_offset(job->dl, type, type->as.aggregate.member_count - 1);
+    }
+  }
+  return 0;
+}
+#endif
+
+/**
+ * @brief DataLayout 的布局缓存: 结果与不带缓存的计算相同，可以并发填充
+ */
+int
+test_data_layout_cache()
+{
+  SUITE_START("IRContext: DataLayout Cache");
+
+  IRContext *ctx = ir_context_create();
+  DataLayout *dl = datalayout_create_host();
+  IRType *i8 = ir_type_get_i8(ctx);
+  IRType *i16 = ir_type_get_i16(ctx);
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRType *i64 = ir_type_get_i64(ctx);
+
+  /// struct Outer { i8; i64; i16; [3 x { i32, i8 }] }
+  IRType *inner_members[] = {i32, i8};
+  IRType *inner = ir_type_get_anonymous_struct(ctx, inner_members, 2);
+  IRType *array = ir_type_get_array(ctx, inner, 3);
+  IRType *outer_members[] = {i8, i64, i16, array};
+  IRType *outer = ir_type_get_anonymous_struct(ctx, outer_members, 4);
+
+  SUITE_ASSERT(datalayout_get_type_size(dl, inner) == 8, "{i32, i8} should be 8 bytes");
+  SUITE_ASSERT(datalayout_get_type_size(dl, array) == 24, "[3 x {i32, i8}] should be 24 bytes");
+  SUITE_ASSERT(datalayout_get_type_size(dl, outer) == 48, "Outer should be 48 bytes, got %zu",
+               datalayout_get_type_size(dl, outer));
+  SUITE_ASSERT(datalayout_get_type_align(dl, outer) == 8, "Outer should be 8-aligned");
+  const size_t expected_offsets[] = {0, 8, 16, 20};
+  const size_t *offsets = datalayout_get_struct_member_offsets(dl, outer);
+  SUITE_ASSERT(offsets != NULL, "Offsets array should be cached");
+  for (size_t i = 0; i < 4; i++)
+  {
+    SUITE_ASSERT(offsets[i] == expected_offsets[i], "Member %zu offset should be %zu, got %zu", i,
+                 expected_offsets[i], offsets[i]);
+    SUITE_ASSERT(datalayout_get_struct_member_offset(dl, outer, i) == expected_offsets[i],
+                 "Member %zu offset lookup mismatch", i);
+  }
+  SUITE_ASSERT(datalayout_get_struct_member_offsets(dl, outer) == offsets, "Repeated lookups should hit the cache");
+
+  /// 成员很多的结构体 (偏移数组不在栈上算) 与不带缓存的计算一致
+  IRType *wide_members[40];
+  for (size_t i = 0; i < 40; i++)
+    wide_members[i] = (i % 3 == 0) ? i8 : (i % 3 == 1) ? i64 : inner;
+  IRType *wide = ir_type_get_anonymous_struct(ctx, wide_members, 40);
+  DataLayout *uncached = datalayout_create_host();
+  datalayout_clear_cache(uncached);
+  DataLayoutCache *saved = uncached->cache;
+  uncached->cache = NULL;
+  SUITE_ASSERT(datalayout_get_struct_member_offsets(uncached, wide) == NULL, "No cache means no offsets array");
+  bool same = datalayout_get_type_size(dl, wide) == datalayout_get_type_size(uncached, wide);
+  for (size_t i = 0; i < 40; i++)
+    same &= datalayout_get_struct_member_offset(dl, wide, i) == datalayout_get_struct_member_offset(uncached, wide, i);
+  SUITE_ASSERT(same, "Cached and uncached layouts of a 40-member struct differ");
+  uncached->cache = saved;
+  datalayout_destroy(uncached);
+
+  /// 修改规则后清空缓存
+  dl->aggregate_preferred_align_in_bytes = 16;
+  datalayout_clear_cache(dl);
+  SUITE_ASSERT(datalayout_get_type_size(dl, inner) == 16, "After clearing, {i32, i8} should use the new 16 alignment");
+  dl->aggregate_preferred_align_in_bytes = 0;
+  datalayout_clear_cache(dl);
+
+  /// 多个线程同时填充同一个缓存 (会多次换表)
+  IRType *types[LAYOUT_TYPES];
+  for (size_t i = 0; i < LAYOUT_TYPES; i++)
+  {
+    IRType *members[] = {i8, ir_type_get_array(ctx, i16, i + 1), i64};
+    types[i] = ir_type_get_anonymous_struct(ctx, members, 3);
+  }
+#ifndef __STDC_NO_THREADS__
+  LayoutJob jobs[NUM_THREADS];
+  thrd_t threads[NUM_THREADS];
+  for (int t = 0; t < NUM_THREADS; t++)
+  {
+    jobs[t] = (LayoutJob){.dl = dl, .types = types};
+    SUITE_ASSERT(thrd_create(&threads[t], run_layout_job, &jobs[t]) == thrd_success, "Failed to start thread %d", t);
+  }
+  for (int t = 0; t < NUM_THREADS; t++)
+    thrd_join(threads[t], NULL);
+  for (size_t i = 0; i < LAYOUT_TYPES; i++)
+  {
+    /// { i8, [i+1 x i16], i64 }: 数组从 2 开始，i64 对齐到 8
+    size_t last = (2 + 2 * (i + 1) + 7) & ~(size_t)7;
+    for (int t = 0; t < NUM_THREADS; t++)
+    {
+      SUITE_ASSERT(jobs[t].last_offsets[i] == last && jobs[t].sizes[i] == last + 8,
+                   "Thread %d: type %zu has offset %zu / size %zu, expected %zu / %zu", t, i, jobs[t].last_offsets[i],
+                   jobs[t].sizes[i], last, last + 8);
+    }
+  }
+#endif
+
+  datalayout_destroy(dl);
+  ir_context_destroy(ctx);
+  SUITE_END();
+}
+
+/**
+ * @brief 同一个 DataLayout 先后用于两个 IRContext: 第二个 Context 复用了第一个的地址，也不能拿到旧的布局
+ */
+int
+test_data_layout_context_reuse()
+{
+  SUITE_START("IRContext: DataLayout Reused Across Contexts");
+
+  /// 打开 Chunk 缓存 (AddressSanitizer 构建默认关闭)，让第二个 Context 拿回第一个 Context 的内存
+  bump_set_chunk_cache_limit((size_t)64 << 20);
+  bump_trim_chunk_cache();
+  DataLayout *dl = datalayout_create_host();
+
+  IRContext *first = ir_context_create();
+  IRType *small_members[] = {ir_type_get_i8(first)};
+  IRType *small = ir_type_get_anonymous_struct(first, small_members, 1);
+  SUITE_ASSERT(datalayout_get_type_size(dl, small) == 1, "{i8} should be 1 byte");
+  uintptr_t small_address = (uintptr_t)small;
+  ir_context_destroy(first);
+
+  IRContext *second = ir_context_create();
+  IRType *i64 = ir_type_get_i64(second);
+  IRType *large_members[] = {i64, i64, i64};
+  IRType *large = ir_type_get_anonymous_struct(second, large_members, 3);
+  SUITE_ASSERT((uintptr_t)large == small_address, "The second context should reuse the address of {i8}");
+  SUITE_ASSERT(datalayout_get_type_size(dl, large) == 24, "{i64, i64, i64} should be 24 bytes, got %zu",
+               datalayout_get_type_size(dl, large));
+  SUITE_ASSERT(datalayout_get_type_align(dl, large) == 8, "{i64, i64, i64} should be 8-aligned");
+  SUITE_ASSERT(datalayout_get_struct_member_offset(dl, large, 2) == 16, "Member 2 should be at offset 16");
+
+  ir_context_destroy(second);
+  datalayout_destroy(dl);
+  bump_trim_chunk_cache();
+  SUITE_END();
+}
+
+/**
+ * @brief 驻留字符串: 头部保存长度和哈希，哈希版本与普通版本返回同一个指针
+ */
+int
+test_interned_strings()
+{
+  SUITE_START("IRContext: Interned Strings");
+
+  IRContext *ctx = ir_context_create();
+
+  const char *hello = ir_context_intern_str(ctx, "hello");
+  SUITE_ASSERT(ir_interned_str_len(hello) == 5, "Interned length should be 5");
+  SUITE_ASSERT(ir_interned_str_hash(hello) == str_hashmap_hash("hello", 5), "Interned hash should match");
+  SUITE_ASSERT(ir_context_intern_str_slice(ctx, "hello world", 5) == hello, "A slice should intern to 'hello'");
+  SUITE_ASSERT(ir_context_intern_str_hashed(ctx, "hello", 5, str_hashmap_hash("hello", 5)) == hello,
+               "The hashed variant should find the same string");
+
+  const char *empty = ir_context_intern_str(ctx, "");
+  SUITE_ASSERT(ir_interned_str_len(empty) == 0 && empty[0] == '\0', "Empty string should intern with length 0");
+
+  /// 解析器定义的名字也带头部 (参数、局部值、标签)
+  IRModule *mod = ir_parse_module(ctx, "define i32 @f(%arg: i32) {\n"
+                                       "$entry:\n"
+                                       "  %sum: i32 = add %arg: i32, 1: i32\n"
+                                       "  ret %sum: i32\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Module should parse");
+  const char *sum = ir_context_intern_str(ctx, "sum");
+  SUITE_ASSERT(ir_interned_str_len(sum) == 3, "'sum' should have length 3");
+  SUITE_ASSERT(ir_interned_str_hash(sum) == str_hashmap_hash("sum", 3), "'sum' should keep its hash");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+test_memory_report()
+{
+  SUITE_START("IRContext: memory report");
+
+  IRContext *ctx = ir_context_create();
+  IRContextMemoryReport before;
+  ir_context_memory_report(ctx, &before);
+  SUITE_ASSERT(before.permanent_arena.num_chunks > 0, "Singleton types live in the permanent arena");
+  SUITE_ASSERT(before.small_int_bytes > 0, "Small integer tables are preallocated");
+
+  for (int32_t i = 0; i < 100; i++)
+    ir_constant_get_i32(ctx, 100000 + i);
+  for (int i = 0; i < 3; i++)
+    ir_constant_get_f64(ctx, 0.5 + i);
+  ir_type_get_ptr(ctx, ir_type_get_i32(ctx));
+  ir_type_get_ptr(ctx, ir_type_get_i64(ctx));
+  char name[32];
+  for (int i = 0; i < 50; i++)
+  {
+    snprintf(name, sizeof(name), "report_name_%d", i);
+    ir_context_intern_str(ctx, name);
+  }
+
+  IRContextMemoryReport after;
+  ir_context_memory_report(ctx, &after);
+  const HashMapStats *i32 = &after.caches[IR_CACHE_CONSTANTS_I32];
+  SUITE_ASSERT(i32->num_entries == 100, "Expected 100 i32 constants, got %zu", i32->num_entries);
+  SUITE_ASSERT(i32->num_buckets >= i32->num_entries && i32->bytes > 0, "Bucket counts should cover the entries");
+  SUITE_ASSERT(after.caches[IR_CACHE_CONSTANTS_F64].num_entries == 3, "Expected 3 f64 constants");
+  SUITE_ASSERT(after.caches[IR_CACHE_CONSTANTS_I64].num_entries == 0, "No i64 constants were created");
+  SUITE_ASSERT(after.caches[IR_CACHE_POINTER_TYPES].num_entries ==
+                   before.caches[IR_CACHE_POINTER_TYPES].num_entries + 2,
+               "Expected two new pointer types");
+  SUITE_ASSERT(after.caches[IR_CACHE_STRINGS].num_entries == before.caches[IR_CACHE_STRINGS].num_entries + 50,
+               "Expected 50 new interned strings");
+  for (int i = 0; i < IR_CONTEXT_NUM_CACHES; i++)
+  {
+    SUITE_ASSERT(hashmap_stats_load_factor(&after.caches[i]) <= 0.75, "Cache '%s' is over its maximum load",
+                 ir_context_cache_name((IRContextCache)i));
+  }
+
+  BumpUsage arenas[] = {after.permanent_arena, after.ir_arena, after.constant_arenas, after.function_arenas};
+  for (size_t i = 0; i < sizeof(arenas) / sizeof(arenas[0]); i++)
+    SUITE_ASSERT(arenas[i].used_bytes <= arenas[i].reserved_bytes, "Arena %zu uses more than it reserved", i);
+  SUITE_ASSERT(after.constant_arenas.used_bytes > before.constant_arenas.used_bytes,
+               "Constants should be allocated in the shard arenas");
+
+  FILE *out = tmpfile();
+  SUITE_ASSERT(out != NULL, "tmpfile failed");
+  ir_context_print_memory_report(&after, out);
+  long len = ftell(out);
+  rewind(out);
+  char text[4096];
+  size_t n = fread(text, 1, sizeof(text) - 1, out);
+  text[n] = '\0';
+  fclose(out);
+  SUITE_ASSERT(len > 0 && strstr(text, "constants.i32") && strstr(text, "permanent"),
+               "Report is missing sections:\n%s", text);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "IRContext";
+  __calir_total_suites_run++;
+  if (test_interned_strings() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_constant_shards() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_concurrent_build() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_data_layout_cache() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_data_layout_context_reuse() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_memory_report() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "analysis/cfg.h"
+#include "analysis/dataflow.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/type.h"
+
+#include "test_utils.h"
+#include "utils/bitset.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_BLOCKS = 40,
+  NUM_FUNCTIONS = 64
+};
+
+/**
+ * @brief [内部] 用 builder 构建一个随机 CFG: 每个块以 ret、br 或条件 br 结束 (可能有不可达的块)
+ */
+static IRFunction *
+build_random_cfg(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRFunction *func = ir_function_create(mod, "random_cfg", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "b%d", i);
+    blocks[i] = ir_basic_block_create(func, name);
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    *seed = *seed * 1664525u + 1013904223u;
+    uint32_t r = *seed >> 8;
+    IRBasicBlock *t = blocks[(r >> 4) % num_blocks];
+    IRBasicBlock *f = blocks[(r >> 12) % num_blocks];
+    switch (r % 8)
+    {
+    case 0:
+      ir_builder_create_ret(b, NULL);
+      break;
+    case 1:
+    case 2:
+      ir_builder_create_br(b, &t->label_address);
+      break;
+    default:
+      ir_builder_create_cond_br(b, &cond->value, &t->label_address, &f->label_address);
+      break;
+    }
+  }
+  return func;
+}
+
+/**
+ * @brief [内部] 每个块 gen 自己的位、不 kill 任何位的 gen/kill 集合
+ */
+static void
+self_gen_sets(FunctionCFG *cfg, DataflowGenKill *gk, bool intersect, Bump *arena)
+{
+  int n = cfg->num_nodes;
+  gk->num_bits = (size_t)n;
+  gk->gen = BUMP_ALLOC_SLICE(arena, Bitset *, n);
+  gk->kill = BUMP_ALLOC_SLICE(arena, Bitset *, n);
+  gk->init = NULL;
+  gk->boundary = NULL;
+  gk->intersect = intersect;
+  for (int id = 0; id < n; id++)
+  {
+    gk->gen[id] = bitset_create((size_t)n, arena);
+    gk->kill[id] = bitset_create((size_t)n, arena);
+    bitset_set(gk->gen[id], (size_t)id);
+  }
+}
+
+/**
+ * @brief [内部] 沿后继从 start 能否到达 target (start 自己算到达)
+ */
+static bool
+reaches(FunctionCFG *cfg, int start, int target)
+{
+  bool seen[MAX_BLOCKS] = {0};
+  int stack[MAX_BLOCKS];
+  int top = 0;
+  stack[top++] = start;
+  seen[start] = true;
+  while (top > 0)
+  {
+    int id = stack[--top];
+    if (id == target)
+      return true;
+    for (int i = 0; i < cfg->nodes[id].num_succs; i++)
+    {
+      int succ = cfg->nodes[id].succs[i];
+      if (!seen[succ])
+      {
+        seen[succ] = true;
+        stack[top++] = succ;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 前向交集问题 (支配者集合) 与支配树一致；后向并集问题 (能到达的块) 与 DFS 一致
+ */
+int
+test_dataflow_gen_kill()
+{
+  SUITE_START("Dataflow: Gen/Kill Problems");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 2024;
+
+  size_t wrong_dominators = 0;
+  size_t wrong_reach = 0;
+  size_t visits = 0;
+  size_t blocks = 0;
+  for (int round = 0; round < 200; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "dataflow");
+    int num_blocks = 1 + round % (MAX_BLOCKS - 1);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *dt = dom_tree_build(cfg, &arena);
+
+    /// Dom(B) = {B} ∪ (∩ Dom(P))，入口的边界值为空集
+    DataflowGenKill dom;
+    self_gen_sets(cfg, &dom, true, &arena);
+    DataflowProblem dom_problem = dataflow_gen_kill_problem(&dom, DATAFLOW_FORWARD);
+    DataflowResult *dom_result = dataflow_solve(cfg, &dom_problem, &arena);
+    visits += dom_result->num_visits;
+    blocks += (size_t)num_blocks;
+
+    /// Reach(B) = {B} ∪ (∪ Reach(S))
+    DataflowGenKill reach;
+    self_gen_sets(cfg, &reach, false, &arena);
+    DataflowProblem reach_problem = dataflow_gen_kill_problem(&reach, DATAFLOW_BACKWARD);
+    DataflowResult *reach_result = dataflow_solve(cfg, &reach_problem, &arena);
+
+    for (int x = 0; x < num_blocks; x++)
+    {
+      IRBasicBlock *xb = cfg->nodes[x].block;
+      bool reachable = dom_tree_dominates(dt, cfg->entry_node->block, xb);
+      for (int y = 0; y < num_blocks; y++)
+      {
+        const Bitset *dom_out = dom_result->out[x];
+        if (reachable && bitset_test(dom_out, (size_t)y) != dom_tree_dominates(dt, cfg->nodes[y].block, xb))
+          wrong_dominators++;
+        if (bitset_test(reach_result->in[x], (size_t)y) != reaches(cfg, x, y))
+          wrong_reach++;
+      }
+    }
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+
+  SUITE_ASSERT(wrong_dominators == 0, "%zu dominator bits disagree with the dominator tree", wrong_dominators);
+  SUITE_ASSERT(wrong_reach == 0, "%zu reachability bits disagree with DFS", wrong_reach);
+  SUITE_ASSERT(visits < 4 * blocks, "The RPO worklist should converge in a few passes (%zu visits for %zu blocks)",
+               visits, blocks);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/*
+ * --- 自定义格: 从入口出发的最短距离 (INT_MAX 为 top，meet 取最小值) ---
+ */
+
+static void *
+distance_create(void *user_data, Bump *arena)
+{
+  (void)user_data;
+  int *value = BUMP_ALLOC(arena, int);
+  *value = INT_MAX;
+  return value;
+}
+
+static void
+distance_reset(void *user_data, const CFGNode *node, bool boundary, void *value)
+{
+  (void)user_data;
+  (void)node;
+  *(int *)value = boundary ? 0 : INT_MAX;
+}
+
+static void
+distance_meet(void *user_data, void *dest, const void *src)
+{
+  (void)user_data;
+  int *d = (int *)dest;
+  int s = *(const int *)src;
+  if (s < *d)
+    *d = s;
+}
+
+static bool
+distance_transfer(void *user_data, const CFGNode *node, const void *input, void *output)
+{
+  (void)user_data;
+  (void)node;
+  int in = *(const int *)input;
+  int out = in == INT_MAX ? INT_MAX : in + 1;
+  bool changed = out != *(int *)output;
+  *(int *)output = out;
+  return changed;
+}
+
+static const DataflowProblem DISTANCE_PROBLEM = {
+  .direction = DATAFLOW_FORWARD,
+  .user_data = NULL,
+  .create = distance_create,
+  .reset = distance_reset,
+  .meet = distance_meet,
+  .transfer = distance_transfer,
+};
+
+/**
+ * @brief 非 Bitset 的格: 入口距离与 BFS 一致
+ */
+int
+test_dataflow_custom_lattice()
+{
+  SUITE_START("Dataflow: Custom Lattice");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 99;
+
+  size_t wrong = 0;
+  for (int round = 0; round < 200; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "distance");
+    int num_blocks = 1 + round % (MAX_BLOCKS - 1);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DataflowResult *result = dataflow_solve(cfg, &DISTANCE_PROBLEM, &arena);
+
+    int dist[MAX_BLOCKS];
+    int queue[MAX_BLOCKS];
+    int head = 0;
+    int tail = 0;
+    for (int i = 0; i < num_blocks; i++)
+      dist[i] = INT_MAX;
+    dist[cfg->entry_node->id] = 0;
+    queue[tail++] = cfg->entry_node->id;
+    while (head < tail)
+    {
+      const CFGNode *node = &cfg->nodes[queue[head++]];
+      for (int k = 0; k < node->num_succs; k++)
+      {
+        int succ = node->succs[k];
+        if (dist[succ] == INT_MAX)
+        {
+          dist[succ] = dist[node->id] + 1;
+          queue[tail++] = succ;
+        }
+      }
+    }
+
+    for (int i = 0; i < num_blocks; i++)
+    {
+      if (*(int *)result->in[i] != dist[i])
+        wrong++;
+    }
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  SUITE_ASSERT(wrong == 0, "%zu block distances disagree with BFS", wrong);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 并行求解多个函数与逐个求解的结果相同
+ */
+int
+test_dataflow_parallel()
+{
+  SUITE_START("Dataflow: Parallel Solving");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  IRModule *mod = ir_module_create(ctx, "parallel");
+  uint32_t seed = 5;
+
+  static FunctionCFG *cfgs[NUM_FUNCTIONS];
+  static DataflowGenKill sets[NUM_FUNCTIONS];
+  static DataflowProblem problems[NUM_FUNCTIONS];
+  static Bump arenas[NUM_FUNCTIONS];
+  static DataflowJob jobs[NUM_FUNCTIONS];
+  Bump shared;
+  bump_init(&shared);
+  for (int i = 0; i < NUM_FUNCTIONS; i++)
+  {
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, 2 + i % (MAX_BLOCKS - 2));
+    cfgs[i] = cfg_build(func, &shared);
+    self_gen_sets(cfgs[i], &sets[i], i % 2 == 0, &shared);
+    problems[i] = dataflow_gen_kill_problem(&sets[i], i % 2 == 0 ? DATAFLOW_FORWARD : DATAFLOW_BACKWARD);
+    bump_init(&arenas[i]);
+    jobs[i] = (DataflowJob){.cfg = cfgs[i], .problem = &problems[i], .arena = &arenas[i], .result = NULL};
+  }
+
+  dataflow_solve_parallel(jobs, NUM_FUNCTIONS, 4);
+
+  size_t wrong = 0;
+  for (int i = 0; i < NUM_FUNCTIONS; i++)
+  {
+    SUITE_ASSERT(jobs[i].result != NULL, "Job %d was not solved", i);
+    DataflowResult *expected = dataflow_solve(cfgs[i], &problems[i], &shared);
+    for (int id = 0; id < cfgs[i]->num_nodes; id++)
+    {
+      if (!bitset_equals(expected->in[id], jobs[i].result->in[id]) ||
+          !bitset_equals(expected->out[id], jobs[i].result->out[id]))
+        wrong++;
+    }
+    cfg_destroy(cfgs[i]);
+    bump_destroy(&arenas[i]);
+  }
+  SUITE_ASSERT(wrong == 0, "%zu blocks differ between parallel and sequential solving", wrong);
+
+  bump_destroy(&shared);
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Dataflow";
+  __calir_total_suites_run++;
+  if (test_dataflow_gen_kill() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dataflow_custom_lattice() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dataflow_parallel() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -0,0 +1,567 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+
+#include "test_utils.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_BLOCKS = 48
+};
+
+/**
+ * @brief [内部] 朴素的支配关系: 从入口出发、不经过 a 时到达不了 b，则 a 支配 b
+ */
+static bool
+reaches_avoiding(FunctionCFG *cfg, int avoid, int target)
+{
+  bool seen[MAX_BLOCKS] = {0};
+  int stack[MAX_BLOCKS];
+  int top = 0;
+  if (cfg->entry_node->id == avoid)
+    return false;
+  stack[top++] = cfg->entry_node->id;
+  seen[cfg->entry_node->id] = true;
+  while (top > 0)
+  {
+    int id = stack[--top];
+    if (id == target)
+      return true;
+    for (int i = 0; i < cfg->nodes[id].num_succs; i++)
+    {
+      int succ = cfg->nodes[id].succs[i];
+      if (succ != avoid && !seen[succ])
+      {
+        seen[succ] = true;
+        stack[top++] = succ;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 用 builder 构建一个随机 CFG: 每个块以 ret、br 或条件 br 结束
+ */
+static IRFunction *
+build_random_cfg(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRFunction *func = ir_function_create(mod, "random_cfg", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "b%d", i);
+    blocks[i] = ir_basic_block_create(func, name);
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    *seed = *seed * 1664525u + 1013904223u;
+    uint32_t r = *seed >> 8;
+    IRBasicBlock *t = blocks[(r >> 4) % num_blocks];
+    IRBasicBlock *f = blocks[(r >> 12) % num_blocks];
+    switch (r % 8)
+    {
+    case 0:
+      ir_builder_create_ret(b, NULL);
+      break;
+    case 1:
+    case 2:
+    case 3:
+      ir_builder_create_br(b, &t->label_address);
+      break;
+    default:
+      ir_builder_create_cond_br(b, &cond->value, &t->label_address, &f->label_address);
+      break;
+    }
+  }
+  return func;
+}
+
+/**
+ * @brief [内部] 朴素的支配边界: b 支配 y 的某个前驱且不严格支配 y
+ */
+static bool
+in_frontier_naive(DominatorTree *tree, FunctionCFG *cfg, int b, int y)
+{
+  IRBasicBlock *bb = cfg->nodes[b].block;
+  IRBasicBlock *yb = cfg->nodes[y].block;
+  if (b != y && dom_tree_dominates(tree, bb, yb))
+    return false;
+  for (int i = 0; i < cfg->nodes[y].num_preds; i++)
+  {
+    CFGNode *pred = cfg_pred(cfg, &cfg->nodes[y], i);
+    if (dom_tree_dominates(tree, bb, pred->block))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 用支配边界集合朴素地迭代出 DF+(defs)，与 IDFCalculator 比较
+ *
+ * @return 两者不一致的块数
+ */
+static size_t
+idf_mismatches(DominanceFrontier *df, IDFCalculator *calc, FunctionCFG *cfg, const int *defs, size_t num_defs)
+{
+  bool expected[MAX_BLOCKS] = {0};
+  bool queued[MAX_BLOCKS] = {0};
+  int worklist[MAX_BLOCKS];
+  int top = 0;
+  for (size_t i = 0; i < num_defs; i++)
+  {
+    if (!queued[defs[i]])
+    {
+      queued[defs[i]] = true;
+      worklist[top++] = defs[i];
+    }
+  }
+  while (top > 0)
+  {
+    const DomFrontierSet *set = &df->frontiers[worklist[--top]];
+    for (int i = 0; i < set->count; i++)
+    {
+      int y = set->ids[i];
+      expected[y] = true;
+      if (!queued[y])
+      {
+        queued[y] = true;
+        worklist[top++] = y;
+      }
+    }
+  }
+
+  int out[MAX_BLOCKS];
+  size_t count = ir_analysis_idf_compute(calc, defs, num_defs, out);
+  bool actual[MAX_BLOCKS] = {0};
+  size_t wrong = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (actual[out[i]])
+      wrong++;
+    actual[out[i]] = true;
+  }
+  for (int i = 0; i < cfg->num_nodes; i++)
+  {
+    if (actual[i] != expected[i])
+      wrong++;
+  }
+  return wrong;
+}
+
+/**
+ * @brief 随机 CFG: 两种算法的支配树与朴素定义逐对一致，支配边界与定义一致，
+ * IDFCalculator 与迭代支配边界一致
+ */
+int
+test_dom_tree_random()
+{
+  SUITE_START("Dominator Tree: Random CFGs");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 12345;
+
+  size_t mismatches = 0;
+  size_t idom_mismatches = 0;
+  size_t df_mismatches = 0;
+  size_t unsorted = 0;
+  size_t idf_wrong = 0;
+  for (int round = 0; round < 400; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "dom");
+    int num_blocks = 2 + round % (MAX_BLOCKS - 2);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+    DominatorTree *chk = dom_tree_build_with_algorithm(cfg, &arena, DOM_TREE_COOPER_HARVEY_KENNEDY);
+    DominanceFrontier *df = ir_analysis_dom_frontier_compute(tree, &arena);
+
+    for (int bi = 0; bi < num_blocks; bi++)
+    {
+      if (!reaches_avoiding(cfg, -1, bi))
+        continue;
+      IRBasicBlock *block = cfg->nodes[bi].block;
+      if (dom_tree_get_idom(tree, block) != dom_tree_get_idom(chk, block))
+        idom_mismatches++;
+      for (int ai = 0; ai < num_blocks; ai++)
+      {
+        bool expected = (ai == bi) || !reaches_avoiding(cfg, ai, bi);
+        if (dom_tree_dominates(tree, cfg->nodes[ai].block, block) != expected)
+          mismatches++;
+        if (dom_tree_dominates(chk, cfg->nodes[ai].block, block) != expected)
+          mismatches++;
+      }
+      for (int yi = 0; yi < num_blocks; yi++)
+      {
+        if (!reaches_avoiding(cfg, -1, yi))
+          continue;
+        bool expected = in_frontier_naive(tree, cfg, bi, yi);
+        if (ir_analysis_dom_frontier_contains(df, block, cfg->nodes[yi].block) != expected)
+          df_mismatches++;
+      }
+      const DomFrontierSet *set = ir_analysis_dom_frontier_get(df, block);
+      for (int k = 1; k < set->count; k++)
+      {
+        if (set->ids[k - 1] >= set->ids[k])
+          unsorted++;
+      }
+    }
+
+    /// 每个 CFG 上试几组随机的定义块 (可以重复，也可以包含不可达的块)
+    IDFCalculator calc;
+    SUITE_ASSERT(ir_analysis_idf_init(&calc, tree, &arena), "IDF calculator should initialize");
+    for (int trial = 0; trial < 8; trial++)
+    {
+      int defs[MAX_BLOCKS];
+      seed = seed * 1664525u + 1013904223u;
+      size_t num_defs = 1 + (seed >> 8) % 4;
+      for (size_t k = 0; k < num_defs; k++)
+      {
+        seed = seed * 1664525u + 1013904223u;
+        defs[k] = (int)((seed >> 8) % (uint32_t)num_blocks);
+      }
+      idf_wrong += idf_mismatches(df, &calc, cfg, defs, num_defs);
+    }
+
+    dom_tree_destroy(tree);
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  SUITE_ASSERT(mismatches == 0, "%zu dominance queries disagree with the definition", mismatches);
+  SUITE_ASSERT(idom_mismatches == 0, "%zu idoms differ between Lengauer-Tarjan and Cooper-Harvey-Kennedy",
+               idom_mismatches);
+  SUITE_ASSERT(df_mismatches == 0, "%zu dominance frontier bits disagree with the definition", df_mismatches);
+  SUITE_ASSERT(unsorted == 0, "%zu frontier sets are not sorted by block id", unsorted);
+  SUITE_ASSERT(idf_wrong == 0, "%zu blocks differ between the IDF calculator and the iterated frontier", idf_wrong);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 菱形链: 每个汇合块支配下一个菱形 (曾经被错误地拒绝)
+ */
+int
+test_dom_tree_diamond_chain()
+{
+  SUITE_START("Dominator Tree: Diamond Chain");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @chain(%a: i32, %b: i32) {\n"
+                             "$entry:\n"
+                             "  br $d0\n"
+                             "$d0:\n"
+                             "  %c0: i1 = icmp sgt %a: i32, %b: i32\n"
+                             "  br %c0: i1, $l0, $r0\n"
+                             "$l0:\n"
+                             "  %x0: i32 = add %a: i32, 1: i32\n"
+                             "  br $m0\n"
+                             "$r0:\n"
+                             "  %y0: i32 = sub %a: i32, 1: i32\n"
+                             "  br $m0\n"
+                             "$m0:\n"
+                             "  %p0: i32 = phi [ %x0: i32, $l0 ], [ %y0: i32, $r0 ]\n"
+                             "  br $d1\n"
+                             "$d1:\n"
+                             "  %c1: i1 = icmp sgt %p0: i32, %b: i32\n"
+                             "  br %c1: i1, $l1, $r1\n"
+                             "$l1:\n"
+                             "  %x1: i32 = add %p0: i32, 1: i32\n"
+                             "  br $m1\n"
+                             "$r1:\n"
+                             "  %y1: i32 = sub %p0: i32, 1: i32\n"
+                             "  br $m1\n"
+                             "$m1:\n"
+                             "  %p1: i32 = phi [ %x1: i32, $l1 ], [ %y1: i32, $r1 ]\n"
+                             "  ret %p1: i32\n"
+                             "}\n";
+  SUITE_ASSERT(ir_parse_module(ctx, text) != NULL, "A chain of diamonds should pass verification");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 几千层深的支配树 (一长串菱形): 区间编号给出正确的支配关系
+ */
+int
+test_dom_tree_deep()
+{
+  SUITE_START("Dominator Tree: Deep Tree");
+
+  enum
+  {
+    DEPTH = 3000
+  };
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "deep");
+  IRBuilder *b = ir_builder_create(ctx);
+  IRFunction *func = ir_function_create(mod, "deep", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  /// head[i] -> (left[i] | right[i]) -> head[i + 1]
+  static IRBasicBlock *heads[DEPTH + 1], *lefts[DEPTH], *rights[DEPTH];
+  for (int i = 0; i <= DEPTH; i++)
+  {
+    heads[i] = ir_basic_block_create(func, "h");
+    ir_function_append_basic_block(func, heads[i]);
+    if (i == DEPTH)
+      break;
+    lefts[i] = ir_basic_block_create(func, "l");
+    ir_function_append_basic_block(func, lefts[i]);
+    rights[i] = ir_basic_block_create(func, "r");
+    ir_function_append_basic_block(func, rights[i]);
+  }
+  for (int i = 0; i < DEPTH; i++)
+  {
+    ir_builder_set_insertion_point(b, heads[i]);
+    ir_builder_create_cond_br(b, &cond->value, &lefts[i]->label_address, &rights[i]->label_address);
+    ir_builder_set_insertion_point(b, lefts[i]);
+    ir_builder_create_br(b, &heads[i + 1]->label_address);
+    ir_builder_set_insertion_point(b, rights[i]);
+    ir_builder_create_br(b, &heads[i + 1]->label_address);
+  }
+  ir_builder_set_insertion_point(b, heads[DEPTH]);
+  ir_builder_create_ret(b, NULL);
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  DominatorTree *tree = dom_tree_build(cfg, &arena);
+
+  size_t wrong = 0;
+  for (int i = 0; i < DEPTH; i += 7)
+  {
+    for (int j = 0; j < DEPTH; j += 13)
+    {
+      /// 汇合块支配后面的所有块；分支块只支配自己
+      if (dom_tree_dominates(tree, heads[i], heads[j]) != (i <= j))
+        wrong++;
+      if (dom_tree_dominates(tree, heads[i], lefts[j]) != (i <= j))
+        wrong++;
+      if (dom_tree_dominates(tree, lefts[i], heads[j]))
+        wrong++;
+      if (dom_tree_dominates(tree, lefts[i], rights[j]))
+        wrong++;
+      if (dom_tree_dominates(tree, lefts[i], lefts[j]) != (i == j))
+        wrong++;
+    }
+  }
+  SUITE_ASSERT(wrong == 0, "%zu dominance queries on the deep tree are wrong", wrong);
+  SUITE_ASSERT(dom_tree_get_idom(tree, heads[DEPTH]) == heads[DEPTH - 1], "idom of the last head is wrong");
+
+  dom_tree_destroy(tree);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 几十万个块的直线链: 两种算法都不能用递归 (会耗尽 C 栈)
+ */
+int
+test_dom_tree_long_chain()
+{
+  SUITE_START("Dominator Tree: Long Chain");
+
+  enum
+  {
+    LENGTH = 200000
+  };
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "chain");
+  IRBuilder *b = ir_builder_create(ctx);
+  IRFunction *func = ir_function_create(mod, "chain", ir_type_get_void(ctx));
+  ir_function_finalize_signature(func, false);
+
+  static IRBasicBlock *blocks[LENGTH];
+  for (int i = 0; i < LENGTH; i++)
+  {
+    blocks[i] = ir_basic_block_create(func, "c");
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+  for (int i = 0; i < LENGTH; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    if (i + 1 < LENGTH)
+      ir_builder_create_br(b, &blocks[i + 1]->label_address);
+    else
+      ir_builder_create_ret(b, NULL);
+  }
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+
+  const DomTreeAlgorithm algorithms[] = {DOM_TREE_LENGAUER_TARJAN, DOM_TREE_COOPER_HARVEY_KENNEDY};
+  for (size_t k = 0; k < sizeof(algorithms) / sizeof(algorithms[0]); k++)
+  {
+    DominatorTree *tree = dom_tree_build_with_algorithm(cfg, &arena, algorithms[k]);
+    SUITE_ASSERT(tree != NULL, "Building the dominator tree of a long chain should succeed");
+
+    size_t wrong = 0;
+    for (int i = 1; i < LENGTH; i += 997)
+    {
+      if (dom_tree_get_idom(tree, blocks[i]) != blocks[i - 1])
+        wrong++;
+    }
+    SUITE_ASSERT(wrong == 0, "%zu idoms on the chain are wrong (algorithm %zu)", wrong, k);
+    SUITE_ASSERT(dom_tree_dominates(tree, blocks[0], blocks[LENGTH - 1]), "Entry should dominate the last block");
+    SUITE_ASSERT(!dom_tree_dominates(tree, blocks[LENGTH - 1], blocks[0]), "The last block does not dominate entry");
+    dom_tree_destroy(tree);
+  }
+
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief CFG 的布局: 块按函数顺序编号，后继/前驱是连续的 id 数组，switch 的重复目标只算一条边
+ */
+int
+test_cfg_layout()
+{
+  SUITE_START("CFG: Layout");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @sw(%x: i32) {\n"
+                             "$entry:\n"
+                             "  switch %x: i32, default $a [\n"
+                             "    1: i32, $b\n"
+                             "    2: i32, $a\n"
+                             "    3: i32, $b\n"
+                             "  ]\n"
+                             "$a:\n"
+                             "  br $c\n"
+                             "$b:\n"
+                             "  br $c\n"
+                             "$c:\n"
+                             "  ret %x: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The switch module should parse");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  SUITE_ASSERT(cfg->num_nodes == 4, "Expected 4 nodes, got %d", cfg->num_nodes);
+
+  int id = 0;
+  IDList *iter;
+  list_for_each(&func->basic_blocks, iter)
+  {
+    IRBasicBlock *bb = list_entry(iter, IRBasicBlock, list_node);
+    SUITE_ASSERT(bb->id == id && cfg_get_node(cfg, bb) == &cfg->nodes[id], "Block %d has the wrong id", id);
+    id++;
+  }
+
+  CFGNode *entry = cfg->entry_node;
+  SUITE_ASSERT(entry->num_succs == 2, "Duplicate switch targets should be one edge each, got %d", entry->num_succs);
+  SUITE_ASSERT(entry->succs[0] == 1 && entry->succs[1] == 2, "Successors should follow the operand order");
+  SUITE_ASSERT(cfg->nodes[1].succs == entry->succs + 2 && cfg->nodes[2].succs == entry->succs + 3,
+               "Successor ids should be contiguous");
+
+  CFGNode *merge = &cfg->nodes[3];
+  SUITE_ASSERT(merge->num_preds == 2 && cfg_pred(cfg, merge, 0)->id == 1 && cfg_pred(cfg, merge, 1)->id == 2,
+               "Predecessors should be ordered by source id");
+
+  /// 构建之后新建的块不在 CFG 中
+  IRBasicBlock *fresh = ir_basic_block_create(func, "fresh");
+  SUITE_ASSERT(cfg_get_node(cfg, fresh) == NULL, "A block created after the build is not in the CFG");
+
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Dominator Tree";
+  __calir_total_suites_run++;
+  if (test_cfg_layout() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dom_tree_random() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dom_tree_diamond_chain() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dom_tree_deep() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dom_tree_long_chain() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
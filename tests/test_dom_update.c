@@ -0,0 +1,292 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "analysis/dom_update.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/type.h"
+
+#include "test_utils.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_INITIAL_BLOCKS = 32,
+  MAX_BLOCKS = 256
+};
+
+static uint32_t
+next_random(uint32_t *seed)
+{
+  *seed = *seed * 1664525u + 1013904223u;
+  return *seed >> 8;
+}
+
+/**
+ * @brief [内部] 用 builder 构建一个随机 CFG: 每个块以 ret、br 或条件 br 结束
+ */
+static IRFunction *
+build_random_cfg(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRFunction *func = ir_function_create(mod, "random_cfg", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_INITIAL_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    blocks[i] = ir_basic_block_create(func, "b");
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    uint32_t r = next_random(seed);
+    IRBasicBlock *t = blocks[(r >> 4) % num_blocks];
+    IRBasicBlock *f = blocks[(r >> 12) % num_blocks];
+    if (r % 8 == 0)
+      ir_builder_create_ret(b, NULL);
+    else if (r % 8 < 3)
+      ir_builder_create_br(b, &t->label_address);
+    else
+      ir_builder_create_cond_br(b, &cond->value, &t->label_address, &f->label_address);
+  }
+  return func;
+}
+
+/**
+ * @brief [内部] 增量更新后的树和边界与在同一个 CFG 上从头构建的结果逐项比较
+ * @return 不一致的项数
+ */
+static size_t
+compare_with_rebuild(DominatorTree *tree, DominanceFrontier *df)
+{
+  FunctionCFG *cfg = tree->cfg;
+  Bump arena;
+  bump_init(&arena);
+  DominatorTree *ref = dom_tree_build(cfg, &arena);
+  DominanceFrontier *ref_df = ir_analysis_dom_frontier_compute(ref, &arena);
+
+  size_t wrong = 0;
+  if (tree->num_reachable != ref->num_reachable)
+    wrong++;
+  for (int i = 0; i < cfg->num_nodes; i++)
+  {
+    IRBasicBlock *bb = cfg->nodes[i].block;
+    if (dom_tree_get_idom(tree, bb) != dom_tree_get_idom(ref, bb))
+      wrong++;
+    if (tree->nodes[i]->depth != ref->nodes[i]->depth)
+      wrong++;
+    for (int j = 0; j < cfg->num_nodes; j++)
+    {
+      IRBasicBlock *other = cfg->nodes[j].block;
+      if (dom_tree_dominates(tree, bb, other) != dom_tree_dominates(ref, bb, other))
+        wrong++;
+    }
+    const DomFrontierSet *got = &df->frontiers[i];
+    const DomFrontierSet *want = &ref_df->frontiers[i];
+    if (got->count != want->count ||
+        (want->count > 0 && memcmp(got->ids, want->ids, (size_t)want->count * sizeof(int)) != 0))
+      wrong++;
+  }
+  bump_destroy(&arena);
+  return wrong;
+}
+
+/**
+ * @brief 随机的插入 / 删除 / 拆分批次: 每批之后与从头构建的结果一致
+ */
+int
+test_dom_update_random()
+{
+  SUITE_START("Dominator Update: Random Batches");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 4242;
+
+  size_t wrong = 0;
+  size_t failed = 0;
+  for (int round = 0; round < 200; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "upd");
+    int num_blocks = 2 + round % (MAX_INITIAL_BLOCKS - 2);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *tree = dom_tree_build(cfg, &arena);
+    DominanceFrontier *df = ir_analysis_dom_frontier_compute(tree, &arena);
+
+    for (int batch = 0; batch < 24; batch++)
+    {
+      DomUpdate updates[4];
+      size_t num_updates = 1 + next_random(&seed) % 4;
+      for (size_t k = 0; k < num_updates; k++)
+      {
+        uint32_t r = next_random(&seed);
+        IRBasicBlock *from = cfg->nodes[(r >> 4) % (uint32_t)cfg->num_nodes].block;
+        IRBasicBlock *to = cfg->nodes[(r >> 14) % (uint32_t)cfg->num_nodes].block;
+        if (r % 8 == 0 && cfg->num_nodes + 4 < MAX_BLOCKS)
+        {
+          IRBasicBlock *split = ir_basic_block_create(func, "s");
+          ir_function_append_basic_block(func, split);
+          updates[k] = (DomUpdate){DOM_UPDATE_SPLIT_BLOCK, from, split};
+        }
+        else if (r % 8 < 4)
+        {
+          updates[k] = (DomUpdate){DOM_UPDATE_INSERT_EDGE, from, to};
+        }
+        else
+        {
+          /// 删除: 多半选一条已有的边
+          CFGNode *node = cfg_get_node(cfg, from);
+          if (node->num_succs > 0 && r % 2 == 0)
+            to = cfg_succ(cfg, node, 0)->block;
+          updates[k] = (DomUpdate){DOM_UPDATE_DELETE_EDGE, from, to};
+        }
+      }
+      if (!dom_tree_apply_updates(tree, df, updates, num_updates))
+        failed++;
+      wrong += compare_with_rebuild(tree, df);
+    }
+
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  SUITE_ASSERT(failed == 0, "%zu batches failed", failed);
+  SUITE_ASSERT(wrong == 0, "%zu results differ from a rebuild after incremental updates", wrong);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 手工的例子: 删除唯一入边让子图不可达，再插回来；拆分后新块接管子节点
+ */
+int
+test_dom_update_basic()
+{
+  SUITE_START("Dominator Update: Basic Edits");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "basic");
+  IRBuilder *b = ir_builder_create(ctx);
+  IRFunction *func = ir_function_create(mod, "f", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  /// entry -> (a | b) -> join -> exit
+  IRBasicBlock *entry = ir_basic_block_create(func, "entry");
+  IRBasicBlock *a = ir_basic_block_create(func, "a");
+  IRBasicBlock *bb = ir_basic_block_create(func, "b");
+  IRBasicBlock *join = ir_basic_block_create(func, "join");
+  IRBasicBlock *exit = ir_basic_block_create(func, "exit");
+  IRBasicBlock *blocks[] = {entry, a, bb, join, exit};
+  for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+    ir_function_append_basic_block(func, blocks[i]);
+  ir_builder_set_insertion_point(b, entry);
+  ir_builder_create_cond_br(b, &cond->value, &a->label_address, &bb->label_address);
+  ir_builder_set_insertion_point(b, a);
+  ir_builder_create_br(b, &join->label_address);
+  ir_builder_set_insertion_point(b, bb);
+  ir_builder_create_br(b, &join->label_address);
+  ir_builder_set_insertion_point(b, join);
+  ir_builder_create_br(b, &exit->label_address);
+  ir_builder_set_insertion_point(b, exit);
+  ir_builder_create_ret(b, NULL);
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  DominatorTree *tree = dom_tree_build(cfg, &arena);
+  DominanceFrontier *df = ir_analysis_dom_frontier_compute(tree, &arena);
+
+  SUITE_ASSERT(dom_tree_get_idom(tree, join) == entry, "idom(join) starts as entry");
+  SUITE_ASSERT(ir_analysis_dom_frontier_contains(df, a, join), "join is in DF(a)");
+
+  /// 删除 entry -> b: a 支配 join，DF(a) 变空，b 不可达
+  SUITE_ASSERT(dom_tree_delete_edge(tree, df, entry, bb), "delete should succeed");
+  SUITE_ASSERT(dom_tree_get_idom(tree, join) == a, "idom(join) becomes a");
+  SUITE_ASSERT(dom_tree_dominates(tree, a, exit), "a dominates exit");
+  SUITE_ASSERT(!dom_tree_dominates(tree, entry, bb), "b is unreachable");
+  SUITE_ASSERT(!ir_analysis_dom_frontier_contains(df, a, join), "DF(a) loses join");
+  SUITE_ASSERT(compare_with_rebuild(tree, df) == 0, "delete matches a rebuild");
+
+  /// 插回来: b 重新可达，恢复原状
+  SUITE_ASSERT(dom_tree_insert_edge(tree, df, entry, bb), "insert should succeed");
+  SUITE_ASSERT(dom_tree_get_idom(tree, join) == entry, "idom(join) is entry again");
+  SUITE_ASSERT(dom_tree_get_idom(tree, bb) == entry, "idom(b) is entry");
+  SUITE_ASSERT(compare_with_rebuild(tree, df) == 0, "insert matches a rebuild");
+
+  /// 拆分 join: tail 接管 exit
+  IRBasicBlock *tail = ir_basic_block_create(func, "tail");
+  ir_function_append_basic_block(func, tail);
+  SUITE_ASSERT(dom_tree_split_block(tree, df, join, tail), "split should succeed");
+  SUITE_ASSERT(dom_tree_get_idom(tree, tail) == join, "idom(tail) is join");
+  SUITE_ASSERT(dom_tree_get_idom(tree, exit) == tail, "idom(exit) is tail");
+  SUITE_ASSERT(cfg_contains_edge(cfg, join, tail) && cfg_contains_edge(cfg, tail, exit), "CFG edges were moved");
+  SUITE_ASSERT(!cfg_contains_edge(cfg, join, exit), "join no longer branches to exit");
+  SUITE_ASSERT(compare_with_rebuild(tree, df) == 0, "split matches a rebuild");
+
+  /// 一批中相互抵消的更新
+  DomUpdate updates[] = {
+      {DOM_UPDATE_INSERT_EDGE, a, exit},
+      {DOM_UPDATE_DELETE_EDGE, a, exit},
+  };
+  SUITE_ASSERT(dom_tree_apply_updates(tree, df, updates, 2), "batch should succeed");
+  SUITE_ASSERT(!cfg_contains_edge(cfg, a, exit), "the cancelled pair leaves no edge");
+  SUITE_ASSERT(compare_with_rebuild(tree, df) == 0, "cancelled batch matches a rebuild");
+
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Dominator Update";
+  __calir_total_suites_run++;
+  if (test_dom_update_basic() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_dom_update_random() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
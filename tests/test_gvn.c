@@ -0,0 +1,163 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/gvn.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief 支配关系: 入口块中的表达式替换被支配块中的相同表达式；兄弟块之间不替换
+ */
+int
+test_gvn_dominance()
+{
+  SUITE_START("GVN: Dominance");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = add %n: i32, 3: i32\n"
+                             "  %b: i32 = add 3: i32, %n: i32\n"
+                             "  %c: i1 = icmp slt %a: i32, %b: i32\n"
+                             "  %c2: i1 = icmp sgt %a: i32, %b: i32\n"
+                             "  %z: i32 = zext %c2: i1 to i32\n"
+                             "  br %c: i1, $then, $else\n"
+                             "$then:\n"
+                             "  %t: i32 = mul %n: i32, %n: i32\n"
+                             "  %t2: i32 = add %n: i32, 3: i32\n"
+                             "  br $merge\n"
+                             "$else:\n"
+                             "  %e: i32 = mul %n: i32, %n: i32\n"
+                             "  br $merge\n"
+                             "$merge:\n"
+                             "  %p: i32 = phi [ %t: i32, $then ], [ %e: i32, $else ]\n"
+                             "  %m: i32 = mul %n: i32, %n: i32\n"
+                             "  %s: i32 = sub %p: i32, %m: i32\n"
+                             "  %s2: i32 = add %s: i32, %z: i32\n"
+                             "  ret %s2: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the GVN snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 6, &before) && before == 0, "Expected 0 before GVN, got %d", before);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_gvn_run_with_analyses(func, am), "GVN should change the function");
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE), "GVN should preserve the dominator tree");
+  SUITE_ASSERT(!ir_transform_gvn_run_with_analyses(func, am), "A second run should change nothing");
+  ir_analysis_manager_destroy(am);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after GVN");
+  /// %b 和 %t2 换成 %a (加法可交换)；$then 和 $else 中的 mul 互不支配，$merge 中的 mul 也不被它们支配
+  SUITE_ASSERT(count_opcode(func, IR_OP_ADD) == 2, "Expected %%a and %%s2, got %zu adds",
+               count_opcode(func, IR_OP_ADD));
+  SUITE_ASSERT(count_opcode(func, IR_OP_MUL) == 3, "Muls in sibling blocks must stay, got %zu",
+               count_opcode(func, IR_OP_MUL));
+  SUITE_ASSERT(count_opcode(func, IR_OP_ICMP) == 2, "Compares with different predicates must stay");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 6, &after) && after == before, "Expected %d after GVN, got %d", before, after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 属性不同的 gep、类型不同的转换不会被合并；完全相同的会
+ */
+int
+test_gvn_attributes()
+{
+  SUITE_START("GVN: Attributes");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %arr: <[4 x i32]> = alloc [4 x i32]\n"
+                             "  %p1: <i32> = gep %arr: <[4 x i32]>, 0: i32, 1: i32\n"
+                             "  %p2: <i32> = gep inbounds %arr: <[4 x i32]>, 0: i32, 1: i32\n"
+                             "  %p3: <i32> = gep %arr: <[4 x i32]>, 0: i32, 1: i32\n"
+                             "  store %n: i32, %p1: <i32>\n"
+                             "  %x: i32 = load %p2: <i32>\n"
+                             "  %y: i32 = load %p3: <i32>\n"
+                             "  %w: i64 = sext %x: i32 to i64\n"
+                             "  %v: i64 = zext %x: i32 to i64\n"
+                             "  %w2: i64 = sext %y: i32 to i64\n"
+                             "  %s: i64 = add %w: i64, %v: i64\n"
+                             "  %s2: i64 = add %s: i64, %w2: i64\n"
+                             "  %r: i32 = trunc %s2: i64 to i32\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the GVN snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &before) && before == 15, "Expected 15 before GVN, got %d", before);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_gvn_run_with_analyses(func, am), "GVN should merge %%p3 into %%p1");
+  ir_analysis_manager_destroy(am);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after GVN");
+  SUITE_ASSERT(count_opcode(func, IR_OP_GEP) == 2, "Only the inbounds gep should stay separate");
+  SUITE_ASSERT(count_opcode(func, IR_OP_LOAD) == 2, "Loads are not numbered");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SEXT) == 2, "sext of different loads must stay");
+  SUITE_ASSERT(count_opcode(func, IR_OP_ZEXT) == 1, "zext differs from sext");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &after) && after == before, "Expected %d after GVN, got %d", before, after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "GVN";
+  __calir_total_suites_run++;
+  if (test_gvn_dominance() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_gvn_attributes() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
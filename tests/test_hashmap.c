@@ -170,6 +170,31 @@ test_str_hashmap()
   SUITE_ASSERT(str_hashmap_get(map, "hello", 5) == NULL, "str map get('hello') should be NULL after remove");
   SUITE_ASSERT(str_hashmap_contains(map, "world", 5) == true, "str map should still contain 'world'");
 
+  /// *_hashed 系列与普通接口查到同一个条目；扩容时用保存的哈希重新放置
+  uint64_t world_hash = str_hashmap_hash("world", 5);
+  SUITE_ASSERT(str_hashmap_get_hashed(map, "world", 5, world_hash) == &v2, "hashed get('world') failed");
+  SUITE_ASSERT(str_hashmap_contains_hashed(map, "world", 5, world_hash), "hashed contains('world') failed");
+
+  static char keys[200][8];
+  for (int i = 0; i < 200; i++)
+  {
+    int len = snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+    str_hashmap_put_preallocated_key_hashed(map, keys[i], (size_t)len, str_hashmap_hash(keys[i], (size_t)len), &v1);
+  }
+  SUITE_ASSERT(str_hashmap_size(map) == 202, "str map size should be 202 after growing");
+  SUITE_ASSERT(str_hashmap_get(map, "k123", 4) == &v1, "str map get('k123') failed after growing");
+  SUITE_ASSERT(str_hashmap_get(map, "world", 5) == &v2, "str map get('world') failed after growing");
+
+  StrHashMapIter it = str_hashmap_iter(map);
+  StrHashMapEntry entry;
+  size_t bad_hashes = 0;
+  while (str_hashmap_iter_next(&it, &entry))
+  {
+    if (entry.key_hash != str_hashmap_hash(entry.key_body, entry.key_len))
+      bad_hashes++;
+  }
+  SUITE_ASSERT(bad_hashes == 0, "%zu iterator entries report a wrong key_hash", bad_hashes);
+
   SUITE_END();
 }
 
@@ -295,6 +320,191 @@ test_generic_hashmap()
   SUITE_END();
 }
 
+/** @brief 故意很差的哈希: 只有 4 种取值，所有 Key 挤在少数几组里，tag 也全部相同 */
+static uint64_t
+weak_int_hash(const void *key)
+{
+  return (uint64_t)(*(const int *)key & 3);
+}
+
+static bool
+int_key_equal(const void *a, const void *b)
+{
+  return *(const int *)a == *(const int *)b;
+}
+
+/**
+ * @brief 测试分组探测: 跨越多个组的探测链、墓碑复用和大量未命中的查找
+ */
+int
+test_group_probing()
+{
+  SUITE_START("HashMap Core: Group Probing");
+
+  enum
+  {
+    N = 5000
+  };
+  static int keys[N];
+  PtrHashMap *map = ptr_hashmap_create(&global_arena, 0);
+  SUITE_ASSERT(map != NULL, "ptr_hashmap_create failed");
+  for (int i = 0; i < N; i++)
+  {
+    keys[i] = i;
+    SUITE_ASSERT(ptr_hashmap_put(map, &keys[i], &keys[i]), "put %d failed", i);
+  }
+  /// 删一半再插回去: 新条目应该复用墓碑，所有 Key 仍然能找到
+  for (int i = 0; i < N; i += 2)
+    SUITE_ASSERT(ptr_hashmap_remove(map, &keys[i]), "remove %d failed", i);
+  SUITE_ASSERT(ptr_hashmap_size(map) == N / 2, "size should be %d after removals", N / 2);
+  for (int i = 0; i < N; i++)
+  {
+    bool present = i % 2 == 1;
+    SUITE_ASSERT(ptr_hashmap_contains(map, &keys[i]) == present, "contains(%d) should be %d", i, present);
+  }
+  for (int i = 0; i < N; i += 2)
+    ptr_hashmap_put(map, &keys[i], &keys[i]);
+  SUITE_ASSERT(ptr_hashmap_size(map) == N, "size should be %d after reinsertion", N);
+  for (int i = 0; i < N; i++)
+    SUITE_ASSERT(ptr_hashmap_get(map, &keys[i]) == &keys[i], "get(%d) failed after reinsertion", i);
+  int missing = -1;
+  SUITE_ASSERT(ptr_hashmap_get(map, &missing) == NULL, "lookup of an absent key should miss");
+
+  size_t iterated = 0;
+  PtrHashMapIter iter = ptr_hashmap_iter(map);
+  PtrHashMapEntry entry;
+  while (ptr_hashmap_iter_next(&iter, &entry))
+  {
+    SUITE_ASSERT(entry.key == entry.value, "iterator returned a mismatched entry");
+    iterated++;
+  }
+  SUITE_ASSERT(iterated == N, "iterator visited %zu entries, expected %d", iterated, N);
+
+  GenericHashMap *weak = generic_hashmap_create(&global_arena, 0, weak_int_hash, int_key_equal);
+  SUITE_ASSERT(weak != NULL, "generic_hashmap_create failed");
+  for (int i = 0; i < 300; i++)
+    generic_hashmap_put(weak, &keys[i], &keys[i]);
+  for (int i = 0; i < 300; i += 3)
+    generic_hashmap_remove(weak, &keys[i]);
+  for (int i = 0; i < 300; i++)
+  {
+    void *expected = i % 3 == 0 ? NULL : &keys[i];
+    SUITE_ASSERT(generic_hashmap_get(weak, &keys[i]) == expected, "weak-hash get(%d) failed", i);
+  }
+  SUITE_ASSERT(generic_hashmap_size(weak) == 200, "weak-hash map size should be 200");
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试删除不留墓碑 (组内还有空槽时)，以及 clear / reserve 复用桶数组
+ */
+int
+test_erase_clear_reserve()
+{
+  SUITE_START("HashMap Core: Erase, Clear and Reserve");
+
+  /// 1. 作用域式的反复插入 / 删除 (像 GVN 的 leader 表): 大多数删除直接变回空槽，表不会因墓碑而加倍
+  I64HashMap *scoped = i64_hashmap_create(&global_arena, 100);
+  SUITE_ASSERT(scoped != NULL, "i64_hashmap_create failed");
+  size_t scoped_buckets = i64_hashmap_stats(scoped).num_buckets;
+  static int payload;
+  for (int round = 0; round < 1000; round++)
+  {
+    for (int64_t k = 0; k < 100; k++)
+      SUITE_ASSERT(i64_hashmap_put(scoped, round * 100 + k, &payload), "put failed in round %d", round);
+    for (int64_t k = 99; k >= 0; k--)
+      SUITE_ASSERT(i64_hashmap_remove(scoped, round * 100 + k), "remove failed in round %d", round);
+  }
+  HashMapStats st = i64_hashmap_stats(scoped);
+  SUITE_ASSERT(st.num_entries == 0 && st.num_tombstones < scoped_buckets / 4, "scoped removals left %zu tombstones",
+               st.num_tombstones);
+  SUITE_ASSERT(st.num_buckets == scoped_buckets, "scoped map was rebuilt (%zu -> %zu buckets)", scoped_buckets,
+               st.num_buckets);
+
+  /// 小表 (逐个槽位探测) 删空时一并清掉墓碑
+  PtrHashMap *small = ptr_hashmap_create(&global_arena, 2);
+  int a = 1, b = 2;
+  ptr_hashmap_put(small, &a, &a);
+  ptr_hashmap_put(small, &b, &b);
+  ptr_hashmap_remove(small, &a);
+  SUITE_ASSERT(ptr_hashmap_get(small, &b) == &b, "small map lost a key after removal");
+  ptr_hashmap_remove(small, &b);
+  SUITE_ASSERT(ptr_hashmap_stats(small).num_tombstones == 0, "emptied small map kept its tombstones");
+
+  /// 2. 从满的组中删除仍然留下墓碑，并且不会截断其他 Key 的探测链
+  enum
+  {
+    N = 200
+  };
+  static int keys[N];
+  GenericHashMap *weak = generic_hashmap_create(&global_arena, 0, weak_int_hash, int_key_equal);
+  for (int i = 0; i < N; i++)
+  {
+    keys[i] = i;
+    generic_hashmap_put(weak, &keys[i], &keys[i]);
+  }
+  for (int i = 0; i < N; i += 2)
+    generic_hashmap_remove(weak, &keys[i]);
+  SUITE_ASSERT(generic_hashmap_stats(weak).num_tombstones > 0, "removals from full groups need tombstones");
+  for (int i = 0; i < N; i++)
+  {
+    void *expected = i % 2 == 0 ? NULL : &keys[i];
+    SUITE_ASSERT(generic_hashmap_get(weak, &keys[i]) == expected, "weak-hash get(%d) failed", i);
+  }
+
+  /// 3. reserve 重新哈希时清掉墓碑；已经够用时什么也不做
+  size_t weak_buckets = generic_hashmap_stats(weak).num_buckets;
+  SUITE_ASSERT(generic_hashmap_reserve(weak, N / 2), "reserve failed");
+  SUITE_ASSERT(generic_hashmap_stats(weak).num_buckets == weak_buckets, "reserve within capacity should do nothing");
+  SUITE_ASSERT(generic_hashmap_reserve(weak, 4 * N), "reserve failed");
+  st = generic_hashmap_stats(weak);
+  SUITE_ASSERT(st.num_tombstones == 0 && st.num_entries == N / 2, "reserve should drop tombstones");
+  SUITE_ASSERT(st.num_buckets * 3 > 4 * N * 4, "reserve(%d) left only %zu buckets", 4 * N, st.num_buckets);
+  for (int i = 1; i < N; i += 2)
+    SUITE_ASSERT(generic_hashmap_get(weak, &keys[i]) == &keys[i], "get(%d) failed after reserve", i);
+
+  I64HashMap *reserved = i64_hashmap_create(&global_arena, 0);
+  SUITE_ASSERT(i64_hashmap_reserve(reserved, 5000), "reserve(5000) failed");
+  size_t reserved_buckets = i64_hashmap_stats(reserved).num_buckets;
+  SUITE_ASSERT(i64_hashmap_reserve(reserved, 10), "reserve(10) failed");
+  for (int64_t k = 0; k < 5000; k++)
+    i64_hashmap_put(reserved, k, &payload);
+  SUITE_ASSERT(i64_hashmap_stats(reserved).num_buckets == reserved_buckets, "reserved map grew during insertion");
+
+  /// 4. clear 保留桶数组: 重新填满同样多的条目不需要扩容
+  StrHashMap *names = str_hashmap_create(&global_arena, 0);
+  char name[16];
+  for (int i = 0; i < 1000; i++)
+  {
+    int len = snprintf(name, sizeof(name), "v%d", i);
+    str_hashmap_put(names, name, (size_t)len, &payload);
+  }
+  size_t names_buckets = str_hashmap_stats(names).num_buckets;
+  str_hashmap_clear(names);
+  SUITE_ASSERT(str_hashmap_size(names) == 0, "size should be 0 after clear");
+  SUITE_ASSERT(!str_hashmap_contains(names, "v7", 2), "cleared map still contains a key");
+  StrHashMapIter it = str_hashmap_iter(names);
+  StrHashMapEntry entry;
+  SUITE_ASSERT(!str_hashmap_iter_next(&it, &entry), "iterator over a cleared map should be empty");
+  for (int i = 0; i < 1000; i++)
+  {
+    int len = snprintf(name, sizeof(name), "w%d", i);
+    str_hashmap_put(names, name, (size_t)len, &payload);
+  }
+  st = str_hashmap_stats(names);
+  SUITE_ASSERT(st.num_entries == 1000 && st.num_buckets == names_buckets, "refilling a cleared map should not grow");
+  SUITE_ASSERT(str_hashmap_get(names, "w999", 4) == &payload, "get after refill failed");
+
+  F64HashMap *floats = f64_hashmap_create(&global_arena, 4);
+  f64_hashmap_put(floats, 1.5, &payload);
+  f64_hashmap_clear(floats);
+  SUITE_ASSERT(f64_hashmap_size(floats) == 0 && !f64_hashmap_contains(floats, 1.5), "f64 clear failed");
+  SUITE_ASSERT(f64_hashmap_reserve(floats, 64) && f64_hashmap_stats(floats).num_buckets >= 64, "f64 reserve failed");
+
+  SUITE_END();
+}
+
 int
 main(void)
 {
@@ -335,6 +545,18 @@ main(void)
     __calir_total_suites_failed++;
   }
 
+  __calir_total_suites_run++;
+  if (test_group_probing() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_erase_clear_reserve() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
   bump_destroy(&global_arena);
 
   TEST_SUMMARY();
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/inline.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief [辅助] 打印模块再解析一遍: 内联出的名字必须仍然唯一
+ */
+static bool
+round_trips(IRModule *mod)
+{
+  Bump arena;
+  bump_init(&arena);
+  const char *text = ir_module_dump_to_string(mod, &arena);
+  IRContext *ctx = ir_context_create();
+  bool ok = text && ir_parse_module(ctx, text) != NULL;
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+  return ok;
+}
+
+/**
+ * @brief 多个 ret 的被调者: 返回值在后半块用 phi 合并；alloca 移到调用者的入口块；递归调用不内联
+ */
+int
+test_inline_call_site()
+{
+  SUITE_START("Inline: Call Site");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @abs(%x: i32) {\n"
+                             "$entry:\n"
+                             "  %tmp: <i32> = alloc i32\n"
+                             "  store %x: i32, %tmp: <i32>\n"
+                             "  %c: i1 = icmp slt %x: i32, 0: i32\n"
+                             "  br %c: i1, $neg, $pos\n"
+                             "$neg:\n"
+                             "  %v: i32 = load %tmp: <i32>\n"
+                             "  %n: i32 = sub 0: i32, %v: i32\n"
+                             "  ret %n: i32\n"
+                             "$pos:\n"
+                             "  ret %x: i32\n"
+                             "}\n"
+                             "define i32 @rec(%x: i32) {\n"
+                             "$entry:\n"
+                             "  %c: i1 = icmp sle %x: i32, 0: i32\n"
+                             "  br %c: i1, $done, $more\n"
+                             "$done:\n"
+                             "  ret 0: i32\n"
+                             "$more:\n"
+                             "  %x1: i32 = sub %x: i32, 1: i32\n"
+                             "  %r: i32 = call <i32 (i32)> @rec(%x1: i32)\n"
+                             "  %r1: i32 = add %r: i32, 1: i32\n"
+                             "  ret %r1: i32\n"
+                             "}\n"
+                             "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  %s.slot: <i32> = alloc i32\n"
+                             "  %m: i32 = sub 0: i32, %n: i32\n"
+                             "  store %m: i32, %i.slot: <i32>\n"
+                             "  store 0: i32, %s.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %c: i1 = icmp sle %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %a: i32 = call <i32 (i32)> @abs(%i: i32)\n"
+                             "  %s: i32 = load %s.slot: <i32>\n"
+                             "  %s2: i32 = add %s: i32, %a: i32\n"
+                             "  store %s2: i32, %s.slot: <i32>\n"
+                             "  %i2: i32 = add %i: i32, 1: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  %r: i32 = call <i32 (i32)> @rec(%n: i32)\n"
+                             "  %s3: i32 = load %s.slot: <i32>\n"
+                             "  %res: i32 = add %s3: i32, %r: i32\n"
+                             "  ret %res: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the inline snippet");
+  IRFunction *rec = find_function(mod, "rec");
+  IRFunction *f = find_function(mod, "f");
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, f, 3, &before) && before == 15, "Expected 15 before inlining, got %d", before);
+
+  IRInstruction *calls[2];
+  size_t num_calls = 0;
+  IDList *bb_iter;
+  list_for_each(&f->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_CALL)
+        calls[num_calls++] = inst;
+    }
+  }
+  SUITE_ASSERT(num_calls == 2, "Expected two calls in @f");
+
+  SUITE_ASSERT(ir_transform_inline_call(calls[0]), "The call to @abs should be inlined");
+  SUITE_ASSERT(ir_transform_inline_call(calls[1]), "The call to @rec from @f should be inlined");
+  SUITE_ASSERT(ir_verify_function(f), "@f should verify after inlining");
+
+  size_t rec_calls = 0;
+  list_for_each(&rec->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode == IR_OP_CALL)
+      {
+        rec_calls++;
+        SUITE_ASSERT(!ir_transform_inline_call(inst), "A recursive call must not be inlined into itself");
+      }
+    }
+  }
+  SUITE_ASSERT(rec_calls == 1, "@rec should keep its call");
+
+  SUITE_ASSERT(count_opcode(f, IR_OP_CALL) == 1, "Only the copy of the recursive call should remain in @f");
+  SUITE_ASSERT(count_opcode(f, IR_OP_PHI) == 2, "Both inlined bodies have two returns, got %zu phis",
+               count_opcode(f, IR_OP_PHI));
+  SUITE_ASSERT(count_opcode(f, IR_OP_RET) == 1, "Inlined returns should become branches");
+
+  IRBasicBlock *f_entry = list_entry(f->basic_blocks.next, IRBasicBlock, list_node);
+  size_t entry_allocas = 0;
+  IDList *inst_iter;
+  list_for_each(&f_entry->instructions, inst_iter)
+  {
+    if (list_entry(inst_iter, IRInstruction, list_node)->opcode == IR_OP_ALLOCA)
+      entry_allocas++;
+  }
+  SUITE_ASSERT(entry_allocas == 3, "The callee's alloca should move to the caller's entry, got %zu", entry_allocas);
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, f, 3, &after) && after == before, "Expected %d after inlining, got %d", before, after);
+  SUITE_ASSERT(round_trips(mod), "The inlined module should print and parse again");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 模块 pass: 自底向上内联小函数；大函数只有在 profile 中足够热时才内联
+ */
+int
+test_inline_cost_model()
+{
+  SUITE_START("Inline: Cost Model");
+
+  /// @big 有 40 多条指令 (超过默认的 32)
+  char text[8192];
+  size_t len = 0;
+  len += (size_t)snprintf(text + len, sizeof(text) - len,
+                          "define i32 @sq(%%x: i32) {\n$entry:\n  %%r: i32 = mul %%x: i32, %%x: i32\n"
+                          "  ret %%r: i32\n}\n"
+                          "define i32 @sq_plus(%%x: i32) {\n$entry:\n"
+                          "  %%s: i32 = call <i32 (i32)> @sq(%%x: i32)\n"
+                          "  %%r: i32 = add %%s: i32, 1: i32\n  ret %%r: i32\n}\n"
+                          "define i32 @big(%%x: i32) {\n$entry:\n  %%v0: i32 = add %%x: i32, 0: i32\n");
+  for (int i = 1; i <= 40; i++)
+    len += (size_t)snprintf(text + len, sizeof(text) - len, "  %%v%d: i32 = add %%v%d: i32, %d: i32\n", i, i - 1,
+                            i);
+  len += (size_t)snprintf(text + len, sizeof(text) - len,
+                          "  ret %%v40: i32\n}\n"
+                          "define i32 @f(%%n: i32) {\n$entry:\n"
+                          "  %%a: i32 = call <i32 (i32)> @sq_plus(%%n: i32)\n"
+                          "  %%b: i32 = call <i32 (i32)> @big(%%a: i32)\n"
+                          "  ret %%b: i32\n}\n");
+
+  for (int hot = 0; hot < 2; hot++)
+  {
+    IRContext *ctx = ir_context_create();
+    IRModule *mod = ir_parse_module(ctx, text);
+    SUITE_ASSERT(mod != NULL, "Failed to parse the inline snippet");
+    IRFunction *f = find_function(mod, "f");
+
+    DataLayout *dl = datalayout_create_host();
+    Interpreter *interp = interpreter_create(dl);
+    interpreter_set_profiling(interp, true);
+    int32_t before = 0;
+    for (int i = 0; i < 20; i++)
+      SUITE_ASSERT(run_i32(interp, f, i, &before), "@f should run");
+    SUITE_ASSERT(before == 19 * 19 + 1 + 820, "Expected %d before inlining, got %d", 19 * 19 + 1 + 820, before);
+
+    IRInlineParams params;
+    ir_inline_params_init(&params);
+    params.hot_call_threshold = 10;
+    params.profile = hot ? interp : NULL;
+
+    SUITE_ASSERT(ir_transform_inline_run(mod, &params), "Inlining should change the module");
+    SUITE_ASSERT(ir_verify_module(mod), "Module should verify after inlining");
+
+    SUITE_ASSERT(count_opcode(find_function(mod, "sq_plus"), IR_OP_CALL) == 0, "@sq should be inlined into @sq_plus");
+    size_t expected_calls = hot ? 0 : 1;
+    SUITE_ASSERT(count_opcode(f, IR_OP_CALL) == expected_calls, "Expected %zu calls in @f (hot = %d), got %zu",
+                 expected_calls, hot, count_opcode(f, IR_OP_CALL));
+    SUITE_ASSERT(count_opcode(f, IR_OP_MUL) == 1, "@sq should reach @f through @sq_plus");
+
+    int32_t after = 0;
+    SUITE_ASSERT(run_i32(NULL, f, 19, &after) && after == before, "Expected %d after inlining, got %d", before,
+                 after);
+    SUITE_ASSERT(round_trips(mod), "The inlined module should print and parse again");
+
+    interpreter_destroy(interp);
+    datalayout_destroy(dl);
+    ir_context_destroy(ctx);
+  }
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Inline";
+  __calir_total_suites_run++;
+  if (test_inline_call_site() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_inline_cost_model() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
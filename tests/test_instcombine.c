@@ -0,0 +1,297 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/gvn.h"
+#include "transforms/instcombine.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/data_layout.h"
+
+/** @brief [辅助] 函数中的指令总数 */
+static size_t
+count_instructions(IRFunction *func)
+{
+  size_t count = 0;
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IDList *inst_iter;
+    list_for_each(&list_entry(bb_iter, IRBasicBlock, list_node)->instructions, inst_iter)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+/** @brief [辅助] 函数中第一条 opcode 指令 */
+static IRInstruction *
+find_opcode(IRFunction *func, IROpcode opcode)
+{
+  IDList *bb_iter;
+  list_for_each(&func->basic_blocks, bb_iter)
+  {
+    IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+    IDList *inst_iter;
+    list_for_each(&bb->instructions, inst_iter)
+    {
+      IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+      if (inst->opcode == opcode)
+        return inst;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief 恒等式和连续的类型转换都化简掉，函数只剩 ret
+ */
+int
+test_instcombine_identities()
+{
+  SUITE_START("InstCombine: Identities");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = add 0: i32, %n: i32\n"
+                             "  %b: i32 = mul %a: i32, 1: i32\n"
+                             "  %c: i32 = sub %b: i32, 0: i32\n"
+                             "  %d: i32 = and %c: i32, -1: i32\n"
+                             "  %e: i32 = or %d: i32, 0: i32\n"
+                             "  %x: i32 = xor %e: i32, %e: i32\n"
+                             "  %f: i32 = or %e: i32, %x: i32\n"
+                             "  %g: i32 = shl %f: i32, 0: i32\n"
+                             "  %h: i32 = udiv %g: i32, 1: i32\n"
+                             "  %w: i64 = zext %h: i32 to i64\n"
+                             "  %t: i32 = trunc %w: i64 to i32\n"
+                             "  %s1: i16 = trunc %t: i32 to i16\n"
+                             "  %s2: i64 = sext %s1: i16 to i64\n"
+                             "  %s3: i16 = trunc %s2: i64 to i16\n"
+                             "  %s4: i32 = sext %s3: i16 to i32\n"
+                             "  %k: i32 = mul 6: i32, 7: i32\n"
+                             "  %z: i32 = sub %k: i32, 42: i32\n"
+                             "  %eq: i1 = icmp sle %t: i32, %t: i32\n"
+                             "  %sel: i32 = select %eq: i1, %t: i32, %s4: i32\n"
+                             "  %r: i32 = add %sel: i32, %z: i32\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the InstCombine snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t inputs[] = {0, 5, -7, 123456, INT32_MIN};
+  int32_t before[5];
+  for (int i = 0; i < 5; i++)
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &before[i]), "Running before InstCombine failed");
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_analysis_get_dom_tree(am, func) != NULL, "Dominator tree should build");
+  SUITE_ASSERT(ir_transform_instcombine_run_with_analyses(func, am), "InstCombine should change the function");
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE), "InstCombine should preserve the dominator tree");
+  SUITE_ASSERT(!ir_transform_instcombine_run_with_analyses(func, am), "A second run should change nothing");
+  ir_analysis_manager_destroy(am);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after InstCombine");
+  SUITE_ASSERT(count_instructions(func) == 1, "Only 'ret %%n' should remain, got %zu instructions",
+               count_instructions(func));
+  IRInstruction *ret = find_opcode(func, IR_OP_RET);
+  SUITE_ASSERT(ret && ir_instruction_get_operand(ret, 0)->kind == IR_KIND_ARGUMENT, "The function should return %%n");
+
+  for (int i = 0; i < 5; i++)
+  {
+    int32_t after = 0;
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &after) && after == before[i], "f(%d): expected %d, got %d", inputs[i],
+                 before[i], after);
+  }
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 乘除 2 的幂换成移位，有符号除法和取余对负数也向零取整
+ */
+int
+test_instcombine_strength_reduction()
+{
+  SUITE_START("InstCombine: Strength Reduction");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %m: i32 = mul %n: i32, 8: i32\n"
+                             "  %m2: i32 = mul %n: i32, -1: i32\n"
+                             "  %ud: i32 = udiv %n: i32, 16: i32\n"
+                             "  %ur: i32 = urem %n: i32, 32: i32\n"
+                             "  %sd: i32 = sdiv %n: i32, 4: i32\n"
+                             "  %sr: i32 = srem %n: i32, 8: i32\n"
+                             "  %big: i32 = sdiv %n: i32, -2147483648: i32\n"
+                             "  %odd: i32 = udiv %n: i32, 10: i32\n"
+                             "  %a1: i32 = xor %m: i32, %m2: i32\n"
+                             "  %a2: i32 = xor %a1: i32, %ud: i32\n"
+                             "  %a3: i32 = mul %a2: i32, 31: i32\n"
+                             "  %a4: i32 = xor %a3: i32, %ur: i32\n"
+                             "  %a5: i32 = mul %a4: i32, 31: i32\n"
+                             "  %a6: i32 = xor %a5: i32, %sd: i32\n"
+                             "  %a7: i32 = mul %a6: i32, 31: i32\n"
+                             "  %a8: i32 = xor %a7: i32, %sr: i32\n"
+                             "  %a9: i32 = xor %a8: i32, %big: i32\n"
+                             "  %a10: i32 = xor %a9: i32, %odd: i32\n"
+                             "  ret %a10: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the InstCombine snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t inputs[] = {0, 1, -1, 7, -7, 8, -8, 9, -9, 1000, -1001, INT32_MAX, INT32_MIN, INT32_MIN + 1};
+  enum
+  {
+    NUM_INPUTS = sizeof(inputs) / sizeof(inputs[0])
+  };
+  int32_t before[NUM_INPUTS];
+  for (int i = 0; i < NUM_INPUTS; i++)
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &before[i]), "Running before InstCombine failed");
+
+  SUITE_ASSERT(ir_transform_instcombine_run(func), "InstCombine should change the function");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after InstCombine");
+  /// 剩下的 sdiv 是除以 INT_MIN (不是正的 2 的幂)，udiv 是除以 10
+  SUITE_ASSERT(count_opcode(func, IR_OP_SDIV) == 1, "Only the division by INT_MIN should stay signed");
+  SUITE_ASSERT(count_opcode(func, IR_OP_UDIV) == 1, "Only the division by 10 should stay");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SREM) == 0 && count_opcode(func, IR_OP_UREM) == 0,
+               "Remainders by powers of two should be gone");
+  SUITE_ASSERT(count_opcode(func, IR_OP_MUL) == 3, "Only the multiplications by 31 should stay, got %zu",
+               count_opcode(func, IR_OP_MUL));
+  SUITE_ASSERT(count_opcode(func, IR_OP_SHL) == 1 && count_opcode(func, IR_OP_LSHR) >= 1,
+               "Expected shl for the mul and lshr for the udiv");
+
+  for (int i = 0; i < NUM_INPUTS; i++)
+  {
+    int32_t after = 0;
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &after) && after == before[i], "f(%d): expected %d, got %d", inputs[i],
+                 before[i], after);
+  }
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 常量换到右边 (icmp 同时交换谓词)，之后 GVN 能认出相同的比较
+ */
+int
+test_instcombine_canonical_order()
+{
+  SUITE_START("InstCombine: Canonical Order");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = add %n: i32, 9: i32\n"
+                             "  %c1: i1 = icmp slt %a: i32, 5: i32\n"
+                             "  %c2: i1 = icmp sgt 5: i32, %a: i32\n"
+                             "  %s: i32 = sub %n: i32, 4: i32\n"
+                             "  %s2: i32 = add -4: i32, %n: i32\n"
+                             "  %x1: i32 = zext %c1: i1 to i32\n"
+                             "  %x2: i32 = zext %c2: i1 to i32\n"
+                             "  %r1: i32 = add %x1: i32, %x2: i32\n"
+                             "  %r2: i32 = mul %s: i32, %s2: i32\n"
+                             "  %r: i32 = add %r1: i32, %r2: i32\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the InstCombine snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t inputs[] = {-10, -4, 0, 3};
+  int32_t before[4];
+  for (int i = 0; i < 4; i++)
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &before[i]), "Running before InstCombine failed");
+
+  SUITE_ASSERT(ir_transform_instcombine_run(func), "InstCombine should change the function");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SUB) == 0, "sub %%n, 4 should become add %%n, -4");
+  IDList *iter;
+  list_for_each(&list_entry(func->basic_blocks.next, IRBasicBlock, list_node)->instructions, iter)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    if (inst->opcode != IR_OP_ICMP && inst->opcode != IR_OP_ADD)
+      continue;
+    SUITE_ASSERT(ir_instruction_get_operand(inst, 0)->kind != IR_KIND_CONSTANT,
+                 "Constants should be on the right of %%%s", inst->result.name);
+    if (inst->opcode == IR_OP_ICMP)
+      SUITE_ASSERT(inst->as.icmp.predicate == IR_ICMP_SLT, "icmp sgt 5, %%a should become icmp slt %%a, 5");
+  }
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_gvn_run_with_analyses(func, am), "GVN should merge the canonical duplicates");
+  ir_analysis_manager_destroy(am);
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after GVN");
+  SUITE_ASSERT(count_opcode(func, IR_OP_ICMP) == 1, "The two compares should merge, got %zu",
+               count_opcode(func, IR_OP_ICMP));
+  SUITE_ASSERT(count_opcode(func, IR_OP_ZEXT) == 1, "The two zexts should merge");
+
+  for (int i = 0; i < 4; i++)
+  {
+    int32_t after = 0;
+    SUITE_ASSERT(run_i32(NULL, func, inputs[i], &after) && after == before[i], "f(%d): expected %d, got %d", inputs[i],
+                 before[i], after);
+  }
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "InstCombine";
+  __calir_total_suites_run++;
+  if (test_instcombine_identities() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_instcombine_strength_reduction() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_instcombine_canonical_order() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -23,10 +23,20 @@
  * Builder 和 Verifier 正确地端到端处理。
  */
 
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/constant.h"
 #include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
 #include "ir/module.h"
 #include "ir/parser.h"
+#include "ir/type.h"
+#include "ir/use.h"
+#include "ir/verifier.h"
 #include "utils/bump.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -297,9 +307,407 @@ test_compare_and_terminator_ops()
   SUITE_END();
 }
 
+/**
+ * @brief [内部] use 是否在 use->value 的 uses 链表中，并且链表的前后指针一致
+ */
+static bool
+use_is_linked(IRUse *use)
+{
+  bool found = false;
+  IDList *iter;
+  list_for_each(&use->value->uses, iter)
+  {
+    if (iter->next->prev != iter || iter->prev->next != iter)
+      return false;
+    if (list_entry(iter, IRUse, value_node) == use)
+      found = true;
+  }
+  return found;
+}
+
+/**
+ * @brief [内部] value 的 uses 链表长度
+ */
+static size_t
+count_uses(IRValueNode *value)
+{
+  size_t count = 0;
+  IDList *iter;
+  list_for_each(&value->uses, iter)
+  {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief 测试操作数数组: switch 增长之后，每个 Use 仍链在它的 Value 的 uses 链表中
+ */
+int
+test_operand_index()
+{
+  SUITE_START("IR: Operand Index");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "define void @test(%a: i32) {\n"
+                                       "$entry:\n"
+                                       "  switch %a: i32, default $l_end [\n"
+                                       "    10: i32, $l_case1\n"
+                                       "    20: i32, $l_end\n"
+                                       "    30: i32, $l_case1\n"
+                                       "  ]\n"
+                                       "$l_case1:\n"
+                                       "  br $l_end\n"
+                                       "$l_end:\n"
+                                       "  ret void\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse operand index snippet");
+
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRArgument *arg = list_entry(func->arguments.next, IRArgument, list_node);
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  IRInstruction *sw = list_entry(entry->instructions.next, IRInstruction, list_node);
+
+  /// switch %a, default, 3 x (val, bb) => 8 个操作数 (超过初始容量 4)
+  SUITE_ASSERT(sw->opcode == IR_OP_SWITCH, "Expected a switch instruction");
+  SUITE_ASSERT(ir_instruction_get_num_operands(sw) == 8, "Expected 8 operands, got %zu",
+               ir_instruction_get_num_operands(sw));
+  SUITE_ASSERT(ir_instruction_get_operand(sw, 0) == &arg->value, "Operand 0 should be %%a");
+  SUITE_ASSERT(ir_instruction_get_operand(sw, 8) == NULL, "Out-of-range operand should be NULL");
+
+  for (size_t i = 0; i < ir_instruction_get_num_operands(sw); i++)
+  {
+    IRUse *use = ir_instruction_get_operand_use(sw, i);
+    SUITE_ASSERT(use->user == sw, "Operand %zu has the wrong user", i);
+    SUITE_ASSERT(use_is_linked(use), "Operand %zu is not in its value's use list", i);
+  }
+
+  /// 擦除后所有操作数都应被解开
+  ir_instruction_erase_from_parent(sw);
+  SUITE_ASSERT(ir_instruction_get_num_operands(sw) == 0, "Erased instruction should have no operands");
+  SUITE_ASSERT(list_empty(&arg->value.uses), "%%a should have no remaining uses");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试操作数数组的搬动: 同一个 Value 的相邻 Use 在增长和中间移除之后仍然正确链接
+ */
+int
+test_operand_relocation()
+{
+  SUITE_START("IR: Operand Relocation");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "define i32 @test(%a: i32) {\n"
+                                       "$entry:\n"
+                                       "  %x: i32 = add %a: i32, %a: i32\n"
+                                       "  br $exit\n"
+                                       "$exit:\n"
+                                       "  ret %x: i32\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse operand relocation snippet");
+
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRArgument *arg = list_entry(func->arguments.next, IRArgument, list_node);
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  IRBasicBlock *exit_bb = list_entry(entry->list_node.next, IRBasicBlock, list_node);
+  IRInstruction *add = list_entry(entry->instructions.next, IRInstruction, list_node);
+
+  /// 1. 固定操作数的指令: Use 记录紧跟在指令之后
+  SUITE_ASSERT(ir_instruction_get_operand_use(add, 0) == (IRUse *)(add + 1), "add operands should be inline");
+  SUITE_ASSERT(count_uses(&arg->value) == 2, "%%a should have 2 uses");
+
+  /// 2. phi 的入边全部使用 %a 和 $entry: 多次增长，每次都搬动相邻的同值 Use
+  IRBuilder *builder = ir_builder_create(ctx);
+  ir_builder_set_insertion_point(builder, exit_bb);
+  IRValueNode *phi = ir_builder_create_phi(builder, ir_type_get_i32(ctx), "p");
+  IRInstruction *phi_inst = (IRInstruction *)phi;
+  for (int i = 0; i < 10; i++)
+  {
+    ir_phi_add_incoming(phi, &arg->value, entry);
+  }
+  SUITE_ASSERT(ir_instruction_get_num_operands(phi_inst) == 20, "phi should have 20 operands");
+  SUITE_ASSERT(count_uses(&arg->value) == 12, "%%a should have 12 uses, got %zu", count_uses(&arg->value));
+  SUITE_ASSERT(count_uses(&entry->label_address) == 10, "$entry should have 10 uses from the phi");
+  for (size_t i = 0; i < 20; i++)
+  {
+    SUITE_ASSERT(use_is_linked(ir_instruction_get_operand_use(phi_inst, i)), "phi operand %zu is not linked", i);
+  }
+
+  /// 3. 移除中间的操作数: 后面的 Use 前移，链表仍然一致
+  ir_use_unlink(ir_instruction_get_operand_use(phi_inst, 2));
+  SUITE_ASSERT(ir_instruction_get_num_operands(phi_inst) == 19, "phi should have 19 operands");
+  SUITE_ASSERT(count_uses(&arg->value) == 11, "%%a should have 11 uses after the unlink");
+  for (size_t i = 0; i < 19; i++)
+  {
+    IRUse *use = ir_instruction_get_operand_use(phi_inst, i);
+    SUITE_ASSERT(use_is_linked(use), "phi operand %zu is not linked after the unlink", i);
+    /// 原来偶数下标是 %a，奇数下标是 $entry；下标 2 之后的操作数前移了一位
+    size_t original = i < 2 ? i : i + 1;
+    IRValueNode *expected = original % 2 == 0 ? &arg->value : &entry->label_address;
+    SUITE_ASSERT(use->value == expected, "phi operand %zu has the wrong value after the unlink", i);
+  }
+
+  /// 4. 擦除 phi 之后只剩 add 的两个 Use
+  ir_instruction_erase_from_parent(phi_inst);
+  SUITE_ASSERT(count_uses(&arg->value) == 2, "%%a should have 2 uses after erasing the phi");
+  SUITE_ASSERT(list_empty(&entry->label_address.uses), "$entry should have no uses after erasing the phi");
+
+  ir_builder_destroy(builder);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
 /**
  * @brief 主测试运行器
  */
+/**
+ * @brief [辅助] 块内每一对指令: comes_before 与链表中的位置一致
+ */
+static size_t
+count_order_mismatches(IRBasicBlock *bb)
+{
+  size_t mismatches = 0;
+  size_t i = 0;
+  IDList *a_iter;
+  list_for_each(&bb->instructions, a_iter)
+  {
+    size_t j = 0;
+    IDList *b_iter;
+    list_for_each(&bb->instructions, b_iter)
+    {
+      IRInstruction *a = list_entry(a_iter, IRInstruction, list_node);
+      IRInstruction *b = list_entry(b_iter, IRInstruction, list_node);
+      if (ir_instruction_comes_before(a, b) != (i < j))
+        mismatches++;
+      j++;
+    }
+    i++;
+  }
+  return mismatches;
+}
+
+/**
+ * @brief 测试块内顺序号: 追加、在块首反复插入 (用完间隔) 和删除之后仍然正确
+ */
+int
+test_instruction_order()
+{
+  SUITE_START("IR: Instruction Order");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "define i32 @test(%a: i32) {\n"
+                                       "$entry:\n"
+                                       "  %x: i32 = add %a: i32, 1: i32\n"
+                                       "  %y: i32 = mul %x: i32, %a: i32\n"
+                                       "  br $exit\n"
+                                       "$exit:\n"
+                                       "  ret %y: i32\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse instruction order snippet");
+
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRArgument *arg = list_entry(func->arguments.next, IRArgument, list_node);
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  IRBasicBlock *exit_bb = list_entry(entry->list_node.next, IRBasicBlock, list_node);
+  SUITE_ASSERT(count_order_mismatches(entry) == 0, "Parsed block is out of order");
+
+  /// phi 插在块首: 每次把第一个间隔减半，几次之后必须重新编号
+  IRBuilder *b = ir_builder_create(ctx);
+  ir_builder_set_insertion_point(b, exit_bb);
+  IRInstruction *phis[24];
+  for (int i = 0; i < 24; i++)
+  {
+    phis[i] = (IRInstruction *)ir_builder_create_phi(b, ir_type_get_i32(ctx), NULL);
+    ir_phi_add_incoming(&phis[i]->result, &arg->value, entry);
+    SUITE_ASSERT(count_order_mismatches(exit_bb) == 0, "Block is out of order after %d phis", i + 1);
+  }
+  /// 追加到块尾
+  for (int i = 0; i < 8; i++)
+    ir_builder_create_add(b, &arg->value, &arg->value, NULL);
+  SUITE_ASSERT(count_order_mismatches(exit_bb) == 0, "Block is out of order after appending");
+
+  /// 删除不影响剩下的顺序
+  for (int i = 0; i < 24; i += 3)
+    ir_instruction_erase_from_parent(phis[i]);
+  SUITE_ASSERT(count_order_mismatches(exit_bb) == 0, "Block is out of order after erasing");
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试批量替换: 替换链按最终值解析，每个被替换的值不再有 Use
+ */
+int
+test_replace_all_uses_with_map()
+{
+  SUITE_START("IR: Replace All Uses With Map");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "define i32 @test(%a: i32, %b: i32) {\n"
+                                       "$entry:\n"
+                                       "  %x: i32 = add %a: i32, %b: i32\n"
+                                       "  %y: i32 = mul %x: i32, %x: i32\n"
+                                       "  %z: i32 = sub %y: i32, %x: i32\n"
+                                       "  ret %z: i32\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse replace-all-uses snippet");
+
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRArgument *b = list_entry(func->arguments.next->next, IRArgument, list_node);
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  IRInstruction *x = list_entry(entry->instructions.next, IRInstruction, list_node);
+  IRInstruction *y = list_entry(x->list_node.next, IRInstruction, list_node);
+  IRInstruction *z = list_entry(y->list_node.next, IRInstruction, list_node);
+
+  /// y -> x -> %b: y 的使用也应该落到 %b 上
+  Bump arena;
+  bump_init(&arena);
+  PtrHashMap *map = ptr_hashmap_create(&arena, 4);
+  ptr_hashmap_put(map, &y->result, &x->result);
+  ptr_hashmap_put(map, &x->result, &b->value);
+  ir_value_replace_all_uses_with_map(map);
+
+  SUITE_ASSERT(list_empty(&x->result.uses), "%%x should have no uses");
+  SUITE_ASSERT(list_empty(&y->result.uses), "%%y should have no uses");
+  SUITE_ASSERT(ir_instruction_get_operand(z, 0) == &b->value, "%%z operand 0 should be %%b");
+  SUITE_ASSERT(ir_instruction_get_operand(z, 1) == &b->value, "%%z operand 1 should be %%b");
+  SUITE_ASSERT(ir_instruction_get_operand(y, 0) == &b->value, "%%y operand 0 should be %%b");
+  SUITE_ASSERT(count_uses(&b->value) == 5, "%%b should have 5 uses, got %zu", count_uses(&b->value));
+  SUITE_ASSERT(ptr_hashmap_get(map, &y->result) == &b->value, "The chain should be compressed");
+  for (size_t i = 0; i < ir_instruction_get_num_operands(z); i++)
+    SUITE_ASSERT(use_is_linked(ir_instruction_get_operand_use(z, i)), "%%z operand %zu is not linked", i);
+
+  bump_destroy(&arena);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试整数常量的唯一化: 小整数表与哈希表的边界两侧、不同宽度互不混淆
+ */
+int
+test_constant_uniqueness()
+{
+  SUITE_START("IR: Constant Uniqueness");
+
+  IRContext *ctx = ir_context_create();
+
+  const int64_t probes[] = {INT64_MIN, -129, IR_SMALL_INT_MIN, -1, 0, 1, IR_SMALL_INT_MAX, IR_SMALL_INT_MAX + 1,
+                            40000,     INT64_MAX};
+  for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+  {
+    int64_t v = probes[i];
+    IRValueNode *a = ir_constant_get_i64(ctx, v);
+    SUITE_ASSERT(a == ir_constant_get_i64(ctx, v), "i64 %lld should be unique", (long long)v);
+    SUITE_ASSERT(((IRConstant *)a)->data.int_val == v, "i64 %lld has the wrong value", (long long)v);
+    SUITE_ASSERT(a->type == ir_type_get_i64(ctx), "i64 %lld has the wrong type", (long long)v);
+
+    int32_t v32 = (int32_t)v;
+    IRValueNode *b = ir_constant_get_i32(ctx, v32);
+    SUITE_ASSERT(b == ir_constant_get_i32(ctx, v32), "i32 %d should be unique", v32);
+    SUITE_ASSERT(((IRConstant *)b)->data.int_val == v32, "i32 %d has the wrong value", v32);
+    SUITE_ASSERT(b->type == ir_type_get_i32(ctx), "i32 %d has the wrong type", v32);
+    SUITE_ASSERT(a != b, "i32 and i64 constants must be distinct");
+
+    int16_t v16 = (int16_t)v;
+    IRValueNode *c = ir_constant_get_i16(ctx, v16);
+    SUITE_ASSERT(c == ir_constant_get_i16(ctx, v16), "i16 %d should be unique", v16);
+    SUITE_ASSERT(((IRConstant *)c)->data.int_val == v16, "i16 %d has the wrong value", v16);
+  }
+
+  for (int v = INT8_MIN; v <= INT8_MAX; v++)
+  {
+    IRValueNode *k = ir_constant_get_i8(ctx, (int8_t)v);
+    SUITE_ASSERT(k == ir_constant_get_i8(ctx, (int8_t)v), "i8 %d should be unique", v);
+    SUITE_ASSERT(((IRConstant *)k)->data.int_val == v, "i8 %d has the wrong value", v);
+    SUITE_ASSERT(k->type == ir_type_get_i8(ctx), "i8 %d has the wrong type", v);
+  }
+
+  /// 解析器和 builder 拿到的是同一个常量
+  IRModule *mod = ir_parse_module(ctx, "define i32 @k(%a: i32) {\n"
+                                       "$entry:\n"
+                                       "  %x: i32 = add %a: i32, 7: i32\n"
+                                       "  %y: i32 = add %x: i32, 5000: i32\n"
+                                       "  ret %y: i32\n"
+                                       "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse constant snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRBasicBlock *entry = list_entry(func->basic_blocks.next, IRBasicBlock, list_node);
+  IRInstruction *x = list_entry(entry->instructions.next, IRInstruction, list_node);
+  IRInstruction *y = list_entry(x->list_node.next, IRInstruction, list_node);
+  SUITE_ASSERT(ir_instruction_get_operand(x, 1) == ir_constant_get_i32(ctx, 7), "7 should be the table constant");
+  SUITE_ASSERT(ir_instruction_get_operand(y, 1) == ir_constant_get_i32(ctx, 5000), "5000 should be cached");
+  SUITE_ASSERT(count_uses(ir_constant_get_i32(ctx, 7)) == 1, "The table constant should record its use");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试 ir_builder_reserve: 指令从预留中依次切出，用完或放弃后照常分配
+ */
+int
+test_builder_reserve()
+{
+  SUITE_START("IR: Builder Reserve");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "reserve");
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRFunction *func = ir_function_create(mod, "f", i32);
+  IRArgument *arg = ir_argument_create(func, i32, "a");
+  ir_function_finalize_signature(func, false);
+  IRBasicBlock *entry = ir_basic_block_create(func, "entry");
+  ir_function_append_basic_block(func, entry);
+
+  IRBuilder *b = ir_builder_create(ctx);
+  ir_builder_set_insertion_point(b, entry);
+  SUITE_ASSERT(ir_builder_reserve(b, 4, 8), "Reserving should succeed");
+  char *begin = func->reserved_begin;
+
+  /// 4 条二元指令正好用完预留，彼此相邻
+  IRValueNode *acc = &arg->value;
+  IRInstruction *insts[4];
+  for (int i = 0; i < 4; i++)
+  {
+    acc = ir_builder_create_add(b, acc, ir_constant_get_i32(ctx, i), NULL);
+    insts[i] = (IRInstruction *)acc;
+  }
+  SUITE_ASSERT((char *)insts[0] == begin, "The first instruction should start the reservation");
+  for (int i = 1; i < 4; i++)
+    SUITE_ASSERT((char *)insts[i] == (char *)insts[i - 1] + sizeof(IRInstruction) + 2 * sizeof(IRUse),
+                 "Instruction %d should follow the previous one", i);
+  SUITE_ASSERT(func->reserved_begin == func->reserved_end, "The reservation should be used up");
+
+  /// 用完之后逐条分配
+  IRValueNode *extra = ir_builder_create_mul(b, acc, acc, NULL);
+  SUITE_ASSERT(extra != NULL && ((IRInstruction *)extra)->num_operands == 2, "Allocation after the reservation failed");
+  ir_builder_create_ret(b, extra);
+  SUITE_ASSERT(ir_verify_function(func), "Function built from a reservation should verify");
+  SUITE_ASSERT(insts[3]->operands[0].value == &insts[2]->result, "Operands should point to the previous add");
+
+  /// 清空函数体会放弃预留
+  ir_builder_reserve(b, 16, 32);
+  ir_function_clear_body(func);
+  SUITE_ASSERT(func->reserved_begin == NULL && func->reserved_end == NULL,
+               "Clearing the body should drop the reservation");
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
 int
 main()
 {
@@ -328,5 +736,41 @@ main()
   {
     __calir_total_suites_failed++;
   }
+
+  __calir_total_suites_run++;
+  if (test_operand_index() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_operand_relocation() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_instruction_order() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_replace_all_uses_with_map() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_constant_uniqueness() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_builder_reserve() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
   TEST_SUMMARY();
 }
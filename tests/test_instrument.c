@@ -0,0 +1,202 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analysis/analysis_manager.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "transforms/mem2reg.h"
+#include "utils/bump.h"
+#include "utils/instrument.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_utils.h"
+
+static const char *const SOURCE = "module = \"timed\"\n"
+                                  "define i32 @twice(%x: i32) {\n"
+                                  "$entry:\n"
+                                  "  %slot: <i32> = alloc i32\n"
+                                  "  store %x: i32, %slot: <i32>\n"
+                                  "  %v: i32 = load %slot: <i32>\n"
+                                  "  %r: i32 = add %v: i32, %v: i32\n"
+                                  "  ret %r: i32\n"
+                                  "}\n"
+                                  "define i32 @one() {\n"
+                                  "$entry:\n"
+                                  "  ret 1: i32\n"
+                                  "}\n";
+
+/** @brief 把 print 的输出读回到一个 malloc 的字符串 */
+static char *
+capture(const Instrumentation *session, void (*print)(const Instrumentation *, FILE *))
+{
+  FILE *f = tmpfile();
+  if (!f)
+    return NULL;
+  print(session, f);
+  long len = ftell(f);
+  rewind(f);
+  char *text = (char *)malloc((size_t)len + 1);
+  if (text)
+    text[fread(text, 1, (size_t)len, f)] = '\0';
+  fclose(f);
+  return text;
+}
+
+int
+test_pipeline_stages(void)
+{
+  SUITE_START("Instrument: pipeline stages");
+
+  Instrumentation *session = instrument_create();
+  SUITE_ASSERT(session != NULL, "instrument_create failed");
+  instrument_start(session);
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, SOURCE);
+  SUITE_ASSERT(mod != NULL, "Parsing failed");
+
+  IRFunction *twice = NULL;
+  IDList *it;
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *func = list_entry(it, IRFunction, list_node);
+    if (strcmp(func->entry_address.name, "twice") == 0)
+      twice = func;
+  }
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(twice, am), "mem2reg should promote the alloca");
+  ir_analysis_manager_destroy(am);
+  instrument_stop();
+
+  const InstrumentRecord *parse = instrument_find(session, "parse", "timed", NULL);
+  SUITE_ASSERT(parse && parse->count == 1, "Expected one module-level parse record");
+
+  const char *functions[] = {"twice", "one"};
+  for (size_t i = 0; i < 2; i++)
+  {
+    const InstrumentRecord *verify = instrument_find(session, "verify", "timed", functions[i]);
+    SUITE_ASSERT(verify && verify->count >= 1, "Missing verify record for @%s", functions[i]);
+    SUITE_ASSERT(verify->self_ns <= verify->total_ns, "Self time must not exceed total time");
+    /// scratch 在作用域结束之后才回退，所以记录的是验证期间的增长而不是 0
+    SUITE_ASSERT(verify->bytes > 0, "The verify record for @%s should count its scratch memory, got %lld",
+                 functions[i], (long long)verify->bytes);
+    const InstrumentRecord *cfg = instrument_find(session, "cfg", "timed", functions[i]);
+    SUITE_ASSERT(cfg && cfg->count >= 1, "Missing cfg record for @%s", functions[i]);
+    const InstrumentRecord *doms = instrument_find(session, "dom_tree", "timed", functions[i]);
+    SUITE_ASSERT(doms && doms->count >= 1, "Missing dom_tree record for @%s", functions[i]);
+  }
+  const InstrumentRecord *mem2reg = instrument_find(session, "mem2reg", "timed", "twice");
+  SUITE_ASSERT(mem2reg && mem2reg->count == 1, "Expected one mem2reg record for @twice");
+  SUITE_ASSERT(instrument_find(session, "mem2reg", "timed", "one") == NULL, "@one never ran mem2reg");
+
+  /// 停止之后不再记录
+  IRModule *again = ir_parse_module(ctx, SOURCE);
+  SUITE_ASSERT(again != NULL, "Second parse failed");
+  SUITE_ASSERT(instrument_find(session, "parse", "timed", NULL)->count == 1, "Stopped sessions must not record");
+
+  char *text = capture(session, instrument_print);
+  SUITE_ASSERT(text != NULL, "Could not capture the text report");
+  SUITE_ASSERT(strstr(text, "module 'timed'") && strstr(text, "@twice") && strstr(text, "mem2reg"),
+               "Text report is missing entries:\n%s", text);
+  free(text);
+
+  char *json = capture(session, instrument_print_json);
+  SUITE_ASSERT(json != NULL, "Could not capture the JSON report");
+  SUITE_ASSERT(strstr(json, "\"stage\": \"parse\", \"module\": \"timed\", \"function\": null"),
+               "JSON report is missing the parse record:\n%s", json);
+  SUITE_ASSERT(strstr(json, "\"modules\""), "JSON report is missing the module totals");
+  free(json);
+
+  instrument_reset(session);
+  SUITE_ASSERT(instrument_next_record(session, NULL) == NULL, "Reset should drop all records");
+
+  ir_context_destroy(ctx);
+  instrument_destroy(session);
+
+  SUITE_END();
+}
+
+int
+test_nested_scopes(void)
+{
+  SUITE_START("Instrument: nested scopes and arena deltas");
+
+  Instrumentation *session = instrument_create();
+  instrument_start(session);
+
+  Bump arena;
+  bump_init(&arena);
+  for (int round = 0; round < 3; round++)
+  {
+    INSTRUMENT_BEGIN(outer, "outer", "m", "f");
+    INSTRUMENT_TRACK_ARENA(outer, &arena);
+    {
+      INSTRUMENT_BEGIN(inner, "inner", "m", "f");
+      volatile uint64_t sink = 0;
+      for (int i = 0; i < 100000; i++)
+        sink = sink + (uint64_t)i;
+      INSTRUMENT_END(inner);
+    }
+    bump_alloc(&arena, 1 << 16, 8);
+    INSTRUMENT_END(outer);
+  }
+  bump_destroy(&arena);
+  instrument_stop();
+
+  const InstrumentRecord *outer = instrument_find(session, "outer", "m", "f");
+  const InstrumentRecord *inner = instrument_find(session, "inner", "m", "f");
+  SUITE_ASSERT(outer && inner, "Both scopes should be recorded");
+  SUITE_ASSERT(outer->count == 3 && inner->count == 3, "Each scope ran three times");
+  SUITE_ASSERT(outer->total_ns >= inner->total_ns, "The outer scope includes the inner one");
+  SUITE_ASSERT(outer->self_ns + inner->total_ns <= outer->total_ns + 3,
+               "The outer self time should exclude the inner scope");
+  SUITE_ASSERT(inner->self_ns == inner->total_ns, "A leaf scope's self time is its total time");
+  SUITE_ASSERT(outer->bytes >= 3 << 16, "Expected at least 192KiB of tracked allocations, got %lld",
+               (long long)outer->bytes);
+  SUITE_ASSERT(inner->bytes == 0, "The inner scope tracks no arena");
+
+  /// 记录按第一次出现的顺序遍历 (inner 先结束)
+  const InstrumentRecord *first = instrument_next_record(session, NULL);
+  SUITE_ASSERT(first == inner && instrument_next_record(session, first) == outer, "Unexpected record order");
+
+  instrument_destroy(session);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Instrument";
+
+  __calir_total_suites_run++;
+  if (test_pipeline_stages() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_nested_scopes() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  TEST_SUMMARY();
+}
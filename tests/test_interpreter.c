@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include "analysis/purity.h"
+#include "interpreter/batch_kernels.h"
+#include "interpreter/exec_plan.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/scheduler.h"
 #include "ir_test_helpers.h"
 #include "test_utils.h"
 
@@ -23,15 +27,25 @@
 #include "ir/constant.h"
 #include "ir/context.h"
 #include "ir/function.h"
+#include "ir/global.h"
 #include "ir/instruction.h"
 #include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/printer.h"
 #include "ir/type.h"
 #include "ir/value.h"
+#include "utils/bump.h"
 #include "utils/data_layout.h"
+#include "utils/string_buf.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef __STDC_NO_THREADS__
+#include <stdatomic.h>
+#include <threads.h>
+#endif
 
 /**
  * @brief 封装测试所需的所有核心对象
@@ -191,81 +205,2627 @@ test_branch_phi_ops()
   SUITE_END();
 }
 
+/**
+ * @brief 测试循环中 PHI 的并行语义 (swap)
+ */
+int
+test_loop_phi_swap()
+{
+  SUITE_START("Interpreter: Loop & Parallel PHI");
+  TestEnv *env = setup_test_env();
+  IRType *ty_i32 = ir_type_get_i32(env->ctx);
+  IRValueNode *const_0 = ir_constant_get_i32(env->ctx, 0);
+  IRValueNode *const_1 = ir_constant_get_i32(env->ctx, 1);
+  IRValueNode *const_2 = ir_constant_get_i32(env->ctx, 2);
+
+  /// a = 1, b = 2; for (i = 0; i < n; i++) { (a, b) = (b, a) } return a
+  IRFunction *func = ir_function_create(env->mod, "test_swap", ty_i32);
+  IRValueNode *arg_n = &ir_argument_create(func, ty_i32, "n")->value;
+  ir_function_finalize_signature(func, false);
+  IRBasicBlock *bb_entry = ir_basic_block_create(func, "entry");
+  IRBasicBlock *bb_loop = ir_basic_block_create(func, "loop");
+  IRBasicBlock *bb_exit = ir_basic_block_create(func, "exit");
+  ir_function_append_basic_block(func, bb_entry);
+  ir_function_append_basic_block(func, bb_loop);
+  ir_function_append_basic_block(func, bb_exit);
+
+  ir_builder_set_insertion_point(env->b, bb_entry);
+  ir_builder_create_br(env->b, &bb_loop->label_address);
+
+  ir_builder_set_insertion_point(env->b, bb_loop);
+  IRValueNode *phi_i = ir_builder_create_phi(env->b, ty_i32, "i");
+  IRValueNode *phi_a = ir_builder_create_phi(env->b, ty_i32, "a");
+  IRValueNode *phi_b = ir_builder_create_phi(env->b, ty_i32, "b");
+  IRValueNode *i_next = ir_builder_create_add(env->b, phi_i, const_1, "i.next");
+  IRValueNode *cmp = ir_builder_create_icmp(env->b, IR_ICMP_SLT, i_next, arg_n, "cmp");
+  ir_builder_create_cond_br(env->b, cmp, &bb_loop->label_address, &bb_exit->label_address);
+
+  ir_phi_add_incoming(phi_i, const_0, bb_entry);
+  ir_phi_add_incoming(phi_i, i_next, bb_loop);
+  ir_phi_add_incoming(phi_a, const_1, bb_entry);
+  ir_phi_add_incoming(phi_a, phi_b, bb_loop);
+  ir_phi_add_incoming(phi_b, const_2, bb_entry);
+  ir_phi_add_incoming(phi_b, phi_a, bb_loop);
+
+  ir_builder_set_insertion_point(env->b, bb_exit);
+  ir_builder_create_ret(env->b, phi_a);
+
+  /// a = 1, b = 2, c = 3; for (i = 0; i < n; i++) { (a, b, c) = (b, c, a) } return a * 100 + b * 10 + c
+  /// (三个 PHI 组成一个环，需要经由临时槽位打破)
+  IRValueNode *const_3 = ir_constant_get_i32(env->ctx, 3);
+  IRFunction *rot_func = ir_function_create(env->mod, "test_rotate", ty_i32);
+  IRValueNode *rot_n = &ir_argument_create(rot_func, ty_i32, "n")->value;
+  ir_function_finalize_signature(rot_func, false);
+  IRBasicBlock *rot_entry = ir_basic_block_create(rot_func, "entry");
+  IRBasicBlock *rot_loop = ir_basic_block_create(rot_func, "loop");
+  IRBasicBlock *rot_exit = ir_basic_block_create(rot_func, "exit");
+  ir_function_append_basic_block(rot_func, rot_entry);
+  ir_function_append_basic_block(rot_func, rot_loop);
+  ir_function_append_basic_block(rot_func, rot_exit);
+
+  ir_builder_set_insertion_point(env->b, rot_entry);
+  ir_builder_create_br(env->b, &rot_loop->label_address);
+
+  ir_builder_set_insertion_point(env->b, rot_loop);
+  IRValueNode *rot_i = ir_builder_create_phi(env->b, ty_i32, "i");
+  IRValueNode *rot_a = ir_builder_create_phi(env->b, ty_i32, "a");
+  IRValueNode *rot_b = ir_builder_create_phi(env->b, ty_i32, "b");
+  IRValueNode *rot_c = ir_builder_create_phi(env->b, ty_i32, "c");
+  IRValueNode *rot_i_next = ir_builder_create_add(env->b, rot_i, const_1, "i.next");
+  IRValueNode *rot_cmp = ir_builder_create_icmp(env->b, IR_ICMP_SLT, rot_i_next, rot_n, "cmp");
+  ir_builder_create_cond_br(env->b, rot_cmp, &rot_loop->label_address, &rot_exit->label_address);
+
+  ir_phi_add_incoming(rot_i, const_0, rot_entry);
+  ir_phi_add_incoming(rot_i, rot_i_next, rot_loop);
+  ir_phi_add_incoming(rot_a, const_1, rot_entry);
+  ir_phi_add_incoming(rot_a, rot_b, rot_loop);
+  ir_phi_add_incoming(rot_b, const_2, rot_entry);
+  ir_phi_add_incoming(rot_b, rot_c, rot_loop);
+  ir_phi_add_incoming(rot_c, const_3, rot_entry);
+  ir_phi_add_incoming(rot_c, rot_a, rot_loop);
+
+  ir_builder_set_insertion_point(env->b, rot_exit);
+  IRValueNode *rot_a100 = ir_builder_create_mul(env->b, rot_a, ir_constant_get_i32(env->ctx, 100), "a100");
+  IRValueNode *rot_b10 = ir_builder_create_mul(env->b, rot_b, ir_constant_get_i32(env->ctx, 10), "b10");
+  IRValueNode *rot_sum = ir_builder_create_add(env->b, rot_a100, rot_b10, "ab");
+  ir_builder_create_ret(env->b, ir_builder_create_add(env->b, rot_sum, rot_c, "abc"));
+
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  RuntimeValue *args[] = {&rt_n};
+  RuntimeValue result;
+
+  /// 两个分派引擎必须给出相同的结果
+  InterpreterEngine engines[] = {INTERP_ENGINE_SWITCH, INTERP_ENGINE_THREADED};
+  for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+  {
+    if (!interpreter_set_engine(env->interp, engines[e]))
+      continue;
+
+    rt_n.as.val_i32 = 2;
+    bool success_2 = interpreter_run_function(env->interp, func, args, 1, &result);
+    SUITE_ASSERT(success_2, "Interpreter failed (n = 2, engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 2); /// 交换一次
+
+    rt_n.as.val_i32 = 3;
+    bool success_3 = interpreter_run_function(env->interp, func, args, 1, &result);
+    SUITE_ASSERT(success_3, "Interpreter failed (n = 3, engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 1); /// 交换两次 (顺序求值 PHI 会得到 2)
+
+    rt_n.as.val_i32 = 3;
+    bool success_rot = interpreter_run_function(env->interp, rot_func, args, 1, &result);
+    SUITE_ASSERT(success_rot, "Interpreter failed (rotate, n = 3, engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 312); /// 轮转两次: (1, 2, 3) -> (2, 3, 1) -> (3, 1, 2)
+  }
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 测试执行计划缓存与失效
+ */
+int
+test_plan_cache_invalidation()
+{
+  SUITE_START("Interpreter: Plan Cache & Invalidation");
+  TestEnv *env = setup_test_env();
+  IRType *ty_i32 = ir_type_get_i32(env->ctx);
+  IRValueNode *const_1 = ir_constant_get_i32(env->ctx, 1);
+  IRValueNode *const_5 = ir_constant_get_i32(env->ctx, 5);
+
+  /// ret (%a + 1)
+  IRFunction *func = ir_function_create(env->mod, "test_cached", ty_i32);
+  IRValueNode *arg_a = &ir_argument_create(func, ty_i32, "a")->value;
+  ir_function_finalize_signature(func, false);
+  IRBasicBlock *bb = ir_basic_block_create(func, "entry");
+  ir_function_append_basic_block(func, bb);
+  ir_builder_set_insertion_point(env->b, bb);
+  IRValueNode *res = ir_builder_create_add(env->b, arg_a, const_1, "res");
+  ir_builder_create_ret(env->b, res);
+
+  RuntimeValue rt_a;
+  rt_a.kind = RUNTIME_VAL_I32;
+  rt_a.as.val_i32 = 10;
+  RuntimeValue *args[] = {&rt_a};
+  RuntimeValue result;
+
+  /// 多次运行复用同一个缓存的计划
+  for (int i = 0; i < 3; i++)
+  {
+    bool success = interpreter_run_function(env->interp, func, args, 1, &result);
+    SUITE_ASSERT(success, "Interpreter failed (cached run %d)", i);
+    ASSERT_I32_RESULT(result, 11);
+  }
+  SUITE_ASSERT(ptr_hashmap_size(env->interp->plan_cache) == 1, "Expected exactly one cached plan");
+
+  /// 修改 IR: ret (%a + 5)，然后使计划失效
+  ir_value_replace_all_uses_with(const_1, const_5);
+  interpreter_invalidate_function(env->interp, func);
+  SUITE_ASSERT(ptr_hashmap_size(env->interp->plan_cache) == 0, "Plan was not removed from cache");
+
+  bool success = interpreter_run_function(env->interp, func, args, 1, &result);
+  SUITE_ASSERT(success, "Interpreter failed (after invalidate_function)");
+  ASSERT_I32_RESULT(result, 15);
+
+  interpreter_invalidate_all(env->interp);
+  SUITE_ASSERT(ptr_hashmap_size(env->interp->plan_cache) == 0, "invalidate_all did not clear the cache");
+
+  success = interpreter_run_function(env->interp, func, args, 1, &result);
+  SUITE_ASSERT(success, "Interpreter failed (after invalidate_all)");
+  ASSERT_I32_RESULT(result, 15);
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
 static ExecutionResultKind
 my_c_add_wrapper(ExecutionContext *ctx, RuntimeValue **args, size_t num_args, RuntimeValue *result_out)
 {
 
-  if (num_args != 2 || args[0]->kind != RUNTIME_VAL_I32 || args[1]->kind != RUNTIME_VAL_I32)
+  if (num_args != 2 || args[0]->kind != RUNTIME_VAL_I32 || args[1]->kind != RUNTIME_VAL_I32)
+  {
+    if (ctx)
+      ctx->error_message = "FFI Error: my_c_add expects 2 i32 args";
+    return EXEC_ERR_INVALID_PTR;
+  }
+
+  int32_t a = args[0]->as.val_i32;
+  int32_t b = args[1]->as.val_i32;
+
+  result_out->kind = RUNTIME_VAL_I32;
+  result_out->as.val_i32 = a + b;
+  return EXEC_OK;
+}
+
+/**
+ * @brief 测试 FFI 调用和运行时错误
+ */
+int
+test_ffi_and_errors()
+{
+  SUITE_START("Interpreter: FFI & Errors");
+  TestEnv *env = setup_test_env();
+  IRType *ty_i32 = ir_type_get_i32(env->ctx);
+
+  interpreter_register_external_function(env->interp, "my_c_add", my_c_add_wrapper);
+
+  IRFunction *func_decl = ir_function_create(env->mod, "my_c_add", ty_i32);
+  ir_argument_create(func_decl, ty_i32, "a");
+  ir_argument_create(func_decl, ty_i32, "b");
+  ir_function_finalize_signature(func_decl, false);
+  func_decl->is_declaration = true;
+
+  IRFunction *func_ffi = ir_function_create(env->mod, "test_ffi", ty_i32);
+  IRValueNode *arg_x = &ir_argument_create(func_ffi, ty_i32, "x")->value;
+  IRValueNode *arg_y = &ir_argument_create(func_ffi, ty_i32, "y")->value;
+  ir_function_finalize_signature(func_ffi, false);
+  IRBasicBlock *bb_ffi = ir_basic_block_create(func_ffi, "entry");
+  ir_function_append_basic_block(func_ffi, bb_ffi);
+  ir_builder_set_insertion_point(env->b, bb_ffi);
+  IRValueNode *call_args[] = {arg_x, arg_y};
+  IRValueNode *call_res = ir_builder_create_call(env->b, &func_decl->entry_address, call_args, 2, "res");
+  ir_builder_create_ret(env->b, call_res);
+
+  RuntimeValue rt_x;
+  rt_x.kind = RUNTIME_VAL_I32;
+  rt_x.as.val_i32 = 70;
+  RuntimeValue rt_y;
+  rt_y.kind = RUNTIME_VAL_I32;
+  rt_y.as.val_i32 = 7;
+  RuntimeValue *ffi_args[] = {&rt_x, &rt_y};
+  RuntimeValue ffi_result;
+  bool ffi_success = interpreter_run_function(env->interp, func_ffi, ffi_args, 2, &ffi_result);
+  SUITE_ASSERT(ffi_success, "Interpreter failed to run @test_ffi");
+  ASSERT_I32_RESULT(ffi_result, 77); /// 70 + 7 = 77
+
+  IRFunction *func_unlinked_decl = ir_function_create(env->mod, "unlinked_fn", ty_i32);
+  ir_function_finalize_signature(func_unlinked_decl, false);
+  func_unlinked_decl->is_declaration = true;
+
+  IRFunction *func_unlinked = ir_function_create(env->mod, "test_unlinked", ty_i32);
+  ir_function_finalize_signature(func_unlinked, false);
+  IRBasicBlock *bb_unlinked = ir_basic_block_create(func_unlinked, "entry");
+  ir_function_append_basic_block(func_unlinked, bb_unlinked);
+  ir_builder_set_insertion_point(env->b, bb_unlinked);
+  ir_builder_create_call(env->b, &func_unlinked_decl->entry_address, NULL, 0, "res");
+  ir_builder_create_ret(env->b, NULL);
+
+  RuntimeValue err_result;
+  bool err_success = interpreter_run_function(env->interp, func_unlinked, NULL, 0, &err_result);
+  SUITE_ASSERT(!err_success, "Interpreter should have failed on unlinked FFI call");
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 测试显式帧栈: 深递归、尾调用 和 栈溢出
+ */
+int
+test_call_stack()
+{
+  SUITE_START("Interpreter: Call Stack & Tail Calls");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"call_stack\"\n"
+                                            "\n"
+                                            "define i32 @count(%n: i32, %acc: i32) {\n"
+                                            "$entry:\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %acc: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %acc1: i32 = add %acc: i32, 1: i32\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @count(%n1: i32, %acc1: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @depth(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret 0: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %r: i32 = call <i32 (i32)> @depth(%n1: i32)\n"
+                                            "  %s: i32 = add %r: i32, 1: i32\n"
+                                            "  ret %s: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @forever(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = call <i32 (i32)> @forever(%n: i32)\n"
+                                            "  %s: i32 = add %r: i32, 1: i32\n"
+                                            "  ret %s: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse call stack IR");
+
+  IRFunction *count_func = find_function(mod, "count");
+  IRFunction *depth_func = find_function(mod, "depth");
+  IRFunction *forever_func = find_function(mod, "forever");
+  SUITE_ASSERT(count_func && depth_func && forever_func, "Failed to find call stack test functions");
+
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  RuntimeValue rt_zero;
+  rt_zero.kind = RUNTIME_VAL_I32;
+  rt_zero.as.val_i32 = 0;
+  RuntimeValue *args_count[] = {&rt_n, &rt_zero};
+  RuntimeValue *args_one[] = {&rt_n};
+  RuntimeValue result;
+
+  InterpreterEngine engines[] = {INTERP_ENGINE_SWITCH, INTERP_ENGINE_THREADED};
+  for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+  {
+    if (!interpreter_set_engine(env->interp, engines[e]))
+      continue;
+
+    /// 1. 尾递归复用同一个帧: 一百万层也只占用常数栈空间
+    rt_n.as.val_i32 = 1000000;
+    bool success = interpreter_run_function(env->interp, count_func, args_count, 2, &result);
+    SUITE_ASSERT(success, "Tail-recursive @count failed (engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 1000000);
+
+    /// 2. 非尾递归: 每层一个帧，且不消耗宿主 C 栈
+    rt_n.as.val_i32 = 10000;
+    success = interpreter_run_function(env->interp, depth_func, args_one, 1, &result);
+    SUITE_ASSERT(success, "Recursive @depth failed (engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 10000);
+
+    /// 3. 无限递归必须报告栈溢出，而不是让宿主崩溃
+    rt_n.as.val_i32 = 0;
+    success = interpreter_run_function(env->interp, forever_func, args_one, 1, &result);
+    SUITE_ASSERT(!success, "Unbounded recursion should fail with a stack overflow (engine %d)", engines[e]);
+    SUITE_ASSERT(env->interp->stack.top == 0, "Interpreter stack was not unwound after an error");
+  }
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 测试超级指令融合: 结果与未融合时完全相同，并且统计计数正确
+ */
+int
+test_superinstructions()
+{
+  SUITE_START("Interpreter: Superinstructions");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"fusion\"\n"
+                                            "\n"
+                                            "define i32 @sum_array(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %arr: <[4 x i32]> = alloc [4 x i32]\n"
+                                            "  %acc: <i32> = alloc i32\n"
+                                            "  %i_ptr: <i32> = alloc i32\n"
+                                            "  store 0: i32, %acc: <i32>\n"
+                                            "  store 0: i32, %i_ptr: <i32>\n"
+                                            "  %p0: <i32> = gep %arr: <[4 x i32]>, 0: i32, 0: i32\n"
+                                            "  store 10: i32, %p0: <i32>\n"
+                                            "  %p1: <i32> = gep %arr: <[4 x i32]>, 0: i32, 1: i32\n"
+                                            "  store 20: i32, %p1: <i32>\n"
+                                            "  %p2: <i32> = gep %arr: <[4 x i32]>, 0: i32, 2: i32\n"
+                                            "  store 30: i32, %p2: <i32>\n"
+                                            "  %p3: <i32> = gep %arr: <[4 x i32]>, 0: i32, 3: i32\n"
+                                            "  store 40: i32, %p3: <i32>\n"
+                                            "  br $loop\n"
+                                            "$loop:\n"
+                                            "  %i: i32 = load %i_ptr: <i32>\n"
+                                            "  %e_ptr: <i32> = gep %arr: <[4 x i32]>, 0: i32, %i: i32\n"
+                                            "  %e: i32 = load %e_ptr: <i32>\n"
+                                            "  %a: i32 = load %acc: <i32>\n"
+                                            "  %a2: i32 = add %a: i32, %e: i32\n"
+                                            "  store %a2: i32, %acc: <i32>\n"
+                                            "  %i2: i32 = add %i: i32, 1: i32\n"
+                                            "  store %i2: i32, %i_ptr: <i32>\n"
+                                            "  %c: i1 = icmp slt %i2: i32, %n: i32\n"
+                                            "  br %c: i1, $loop, $exit\n"
+                                            "$exit:\n"
+                                            "  %r: i32 = load %acc: <i32>\n"
+                                            "  ret %r: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse fusion IR");
+  IRFunction *func = find_function(mod, "sum_array");
+  SUITE_ASSERT(func != NULL, "Failed to find @sum_array");
+
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  rt_n.as.val_i32 = 4;
+  RuntimeValue *args[] = {&rt_n};
+  RuntimeValue result;
+
+  InterpreterEngine engines[] = {INTERP_ENGINE_SWITCH, INTERP_ENGINE_THREADED};
+  for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+  {
+    if (!interpreter_set_engine(env->interp, engines[e]))
+      continue;
+
+    /// 1. 关闭融合 (基准)
+    interpreter_set_fusion(env->interp, false);
+    bool success = interpreter_run_function(env->interp, func, args, 1, &result);
+    SUITE_ASSERT(success, "Unfused run failed (engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 100);
+    SUITE_ASSERT(interpreter_get_fusion_count(env->interp, INTERP_FUSION_ICMP_BR) == 0,
+                 "No fusion should happen when it is disabled");
+
+    /// 2. 开启融合: 结果相同，每种模式在循环体中各出现一次
+    interpreter_set_fusion(env->interp, true);
+    success = interpreter_run_function(env->interp, func, args, 1, &result);
+    SUITE_ASSERT(success, "Fused run failed (engine %d)", engines[e]);
+    ASSERT_I32_RESULT(result, 100);
+    SUITE_ASSERT(interpreter_get_fusion_count(env->interp, INTERP_FUSION_ICMP_BR) == 1, "Expected 1 icmp+br fusion");
+    SUITE_ASSERT(interpreter_get_fusion_count(env->interp, INTERP_FUSION_GEP_LOAD) == 1, "Expected 1 gep+load fusion");
+    SUITE_ASSERT(interpreter_get_fusion_count(env->interp, INTERP_FUSION_LOAD_BINOP_STORE) == 1,
+                 "Expected 1 load+binop+store fusion");
+  }
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 生成一个有 num_cases 个 case 的 switch 函数:
+ * case (i * stride + base) 跳到返回 i 的块，default 返回 -1
+ */
+static void
+format_switch_function(char *buf, size_t cap, const char *name, int num_cases, int stride, int base)
+{
+  size_t len = (size_t)snprintf(buf, cap,
+                                "define i32 @%s(%%x: i32) {\n"
+                                "$entry:\n"
+                                "  switch %%x: i32, default $other [\n",
+                                name);
+  for (int i = 0; i < num_cases; i++)
+    len += (size_t)snprintf(buf + len, cap - len, "    %d: i32, $case%d\n", i * stride + base, i);
+  len += (size_t)snprintf(buf + len, cap - len, "  ]\n");
+  for (int i = 0; i < num_cases; i++)
+    len += (size_t)snprintf(buf + len, cap - len, "$case%d:\n  ret %d: i32\n", i, i);
+  snprintf(buf + len, cap - len, "$other:\n  ret -1: i32\n}\n\n");
+}
+
+/**
+ * @brief 测试 switch 的三种查找策略 (线性 / 跳转表 / 二分查找) 结果一致
+ */
+int
+test_switch_lowering()
+{
+  SUITE_START("Interpreter: Switch Lowering");
+  TestEnv *env = setup_test_env();
+
+  /// 1. 线性 (3 个 case)、稠密 (-4..11，跳转表)、稀疏 (步长 1000，二分查找)
+  static char source[16384];
+  size_t len = (size_t)snprintf(source, sizeof(source), "module = \"switches\"\n\n");
+  format_switch_function(source + len, sizeof(source) - len, "few", 3, 1, 0);
+  len = strlen(source);
+  format_switch_function(source + len, sizeof(source) - len, "dense", 16, 1, -4);
+  len = strlen(source);
+  format_switch_function(source + len, sizeof(source) - len, "sparse", 16, 1000, -5000);
+
+  IRModule *mod = ir_parse_module(env->ctx, source);
+  SUITE_ASSERT(mod != NULL, "Failed to parse switch IR");
+
+  typedef struct SwitchCase
+  {
+    const char *func_name;
+    int32_t input;
+    int32_t expected;
+  } SwitchCase;
+  static const SwitchCase cases[] = {
+    {"few", 0, 0},         {"few", 2, 2},           {"few", 3, -1},          {"few", -1, -1},
+    {"dense", -4, 0},      {"dense", 0, 4},         {"dense", 11, 15},       {"dense", -5, -1},
+    {"dense", 12, -1},     {"dense", INT32_MIN, -1}, {"sparse", -5000, 0},   {"sparse", 0, 5},
+    {"sparse", 10000, 15}, {"sparse", 1, -1},        {"sparse", -5001, -1},  {"sparse", INT32_MAX, -1},
+  };
+
+  InterpreterEngine engines[] = {INTERP_ENGINE_SWITCH, INTERP_ENGINE_THREADED};
+  for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+  {
+    if (!interpreter_set_engine(env->interp, engines[e]))
+      continue;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+      IRFunction *func = find_function(mod, cases[i].func_name);
+      SUITE_ASSERT(func != NULL, "Failed to find @%s", cases[i].func_name);
+
+      RuntimeValue rt_x;
+      rt_x.kind = RUNTIME_VAL_I32;
+      rt_x.as.val_i32 = cases[i].input;
+      RuntimeValue *args[] = {&rt_x};
+      RuntimeValue result;
+
+      bool success = interpreter_run_function(env->interp, func, args, 1, &result);
+      SUITE_ASSERT(success, "@%s(%d) failed (engine %d)", cases[i].func_name, cases[i].input, engines[e]);
+      ASSERT_I32_RESULT(result, cases[i].expected);
+    }
+  }
+
+  /// 2. 循环中的 switch: case 块使用入口块定义的值 (CFG 必须包含 switch 的边，否则验证失败)
+  IRModule *loop_mod = ir_parse_module(env->ctx, "module = \"switch_loop\"\n"
+                                                 "\n"
+                                                 "define i32 @count_odd(%n: i32) {\n"
+                                                 "$entry:\n"
+                                                 "  %i_ptr: <i32> = alloc i32\n"
+                                                 "  %acc_ptr: <i32> = alloc i32\n"
+                                                 "  store 0: i32, %i_ptr: <i32>\n"
+                                                 "  store 0: i32, %acc_ptr: <i32>\n"
+                                                 "  br $loop\n"
+                                                 "$loop:\n"
+                                                 "  %i: i32 = load %i_ptr: <i32>\n"
+                                                 "  %bit: i32 = and %i: i32, 1: i32\n"
+                                                 "  switch %bit: i32, default $latch [\n"
+                                                 "    1: i32, $odd\n"
+                                                 "  ]\n"
+                                                 "$odd:\n"
+                                                 "  %acc: i32 = load %acc_ptr: <i32>\n"
+                                                 "  %acc_next: i32 = add %acc: i32, 1: i32\n"
+                                                 "  store %acc_next: i32, %acc_ptr: <i32>\n"
+                                                 "  br $latch\n"
+                                                 "$latch:\n"
+                                                 "  %i_next: i32 = add %i: i32, 1: i32\n"
+                                                 "  store %i_next: i32, %i_ptr: <i32>\n"
+                                                 "  %cmp: i1 = icmp slt %i_next: i32, %n: i32\n"
+                                                 "  br %cmp: i1, $loop, $exit\n"
+                                                 "$exit:\n"
+                                                 "  %r: i32 = load %acc_ptr: <i32>\n"
+                                                 "  ret %r: i32\n"
+                                                 "}\n");
+  SUITE_ASSERT(loop_mod != NULL, "Failed to parse a switch inside a loop");
+
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  rt_n.as.val_i32 = 11;
+  RuntimeValue *loop_args[] = {&rt_n};
+  RuntimeValue loop_result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(loop_mod, "count_odd"), loop_args, 1, &loop_result),
+               "@count_odd failed");
+  ASSERT_I32_RESULT(loop_result, 5);
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 测试 profiling: 调用次数 / 块进入次数 / opcode 次数，以及带注解的 IR 输出
+ */
+int
+test_profiler()
+{
+  SUITE_START("Interpreter: Profiler");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"profile\"\n"
+                                            "\n"
+                                            "define i32 @square(%x: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = mul %x: i32, %x: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @sum_squares(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %i_ptr: <i32> = alloc i32\n"
+                                            "  %acc: <i32> = alloc i32\n"
+                                            "  store 0: i32, %i_ptr: <i32>\n"
+                                            "  store 0: i32, %acc: <i32>\n"
+                                            "  br $loop\n"
+                                            "$loop:\n"
+                                            "  %i: i32 = load %i_ptr: <i32>\n"
+                                            "  %sq: i32 = call <i32 (i32)> @square(%i: i32)\n"
+                                            "  %a: i32 = load %acc: <i32>\n"
+                                            "  %a2: i32 = add %a: i32, %sq: i32\n"
+                                            "  store %a2: i32, %acc: <i32>\n"
+                                            "  %i2: i32 = add %i: i32, 1: i32\n"
+                                            "  store %i2: i32, %i_ptr: <i32>\n"
+                                            "  %c: i1 = icmp slt %i2: i32, %n: i32\n"
+                                            "  br %c: i1, $loop, $exit\n"
+                                            "$exit:\n"
+                                            "  %r: i32 = load %acc: <i32>\n"
+                                            "  ret %r: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse profile IR");
+  IRFunction *square = find_function(mod, "square");
+  IRFunction *sum_squares = find_function(mod, "sum_squares");
+  SUITE_ASSERT(square && sum_squares, "Failed to find profiled functions");
+
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  rt_n.as.val_i32 = 10;
+  RuntimeValue *args[] = {&rt_n};
+  RuntimeValue result;
+
+  /// 1. 默认关闭: 不收集任何数据
+  bool success = interpreter_run_function(env->interp, sum_squares, args, 1, &result);
+  SUITE_ASSERT(success, "Unprofiled run failed");
+  SUITE_ASSERT(interpreter_profile_get_calls(env->interp, sum_squares) == 0, "Profiling should be off by default");
+
+  /// 2. 开启后运行两次
+  interpreter_set_profiling(env->interp, true);
+  for (int run = 0; run < 2; run++)
+  {
+    success = interpreter_run_function(env->interp, sum_squares, args, 1, &result);
+    SUITE_ASSERT(success, "Profiled run failed");
+    ASSERT_I32_RESULT(result, 285);
+  }
+
+  IRBasicBlock *loop_bb = list_entry(sum_squares->basic_blocks.next->next, IRBasicBlock, list_node);
+  SUITE_ASSERT(interpreter_profile_get_calls(env->interp, sum_squares) == 2, "Expected 2 calls to @sum_squares");
+  SUITE_ASSERT(interpreter_profile_get_calls(env->interp, square) == 20, "Expected 20 calls to @square");
+  SUITE_ASSERT(interpreter_profile_get_block_entries(env->interp, loop_bb) == 20, "Expected 20 entries of $loop");
+  SUITE_ASSERT(interpreter_profile_get_opcode_count(env->interp, IR_OP_MUL) == 20, "Expected 20 'mul'");
+  SUITE_ASSERT(interpreter_profile_get_opcode_count(env->interp, IR_OP_CALL) == 20, "Expected 20 'call'");
+  SUITE_ASSERT(interpreter_profile_get_opcode_count(env->interp, IR_OP_RET) == 22, "Expected 22 'ret'");
+  SUITE_ASSERT(interpreter_profile_get_cycles(env->interp, sum_squares) > 0, "Expected cycles for @sum_squares");
+
+  /// 3. 带注解的输出仍然是合法的 .cir
+  Bump *arena = bump_new();
+  StringBuf buf;
+  string_buf_init(&buf, arena);
+  IRPrinter p;
+  ir_printer_init_string_buf(&p, &buf);
+  interpreter_dump_profile(env->interp, mod, &p);
+  const char *dump = string_buf_get(&buf);
+  SUITE_ASSERT(strstr(dump, "; calls: 20,") != NULL, "Dump is missing the @square call count");
+  SUITE_ASSERT(strstr(dump, "$loop:  ; entries: 20\n") != NULL, "Dump is missing the $loop entry count");
+  SUITE_ASSERT(strstr(dump, ";   mul ") != NULL, "Dump is missing the opcode table");
+  SUITE_ASSERT(ir_parse_module(env->ctx, dump) != NULL, "Annotated dump should still parse");
+  bump_free(arena);
+
+  /// 4. 清零
+  interpreter_reset_profile(env->interp);
+  SUITE_ASSERT(interpreter_profile_get_calls(env->interp, square) == 0, "Reset should clear call counts");
+  SUITE_ASSERT(interpreter_profile_get_opcode_count(env->interp, IR_OP_MUL) == 0, "Reset should clear block entries");
+
+  interpreter_set_profiling(env->interp, false);
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+#ifndef __STDC_NO_THREADS__
+/** @brief test_concurrent_workers 中每个线程的输入 / 输出 */
+typedef struct WorkerJob
+{
+  InterpreterWorker *worker;
+  IRFunction *func;
+  int32_t arg;
+  int iterations;
+  int32_t expected;
+  int failures;
+} WorkerJob;
+
+static int
+run_worker_job(void *opaque)
+{
+  WorkerJob *job = opaque;
+  RuntimeValue rt_arg;
+  rt_arg.kind = RUNTIME_VAL_I32;
+  rt_arg.as.val_i32 = job->arg;
+  RuntimeValue *args[] = {&rt_arg};
+  for (int i = 0; i < job->iterations; i++)
+  {
+    RuntimeValue result;
+    if (!interpreter_worker_run_function(job->worker, job->func, args, 1, &result) ||
+        result.as.val_i32 != job->expected)
+    {
+      job->failures++;
+    }
+  }
+  return 0;
+}
+#endif
+
+/**
+ * @brief 测试封存后的解释器被多个工作线程并发使用
+ */
+int
+test_concurrent_workers()
+{
+  SUITE_START("Interpreter: Concurrent Workers");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"workers\"\n"
+                                            "\n"
+                                            "@g_base: <i32> = global 7: i32\n"
+                                            "\n"
+                                            "define i32 @fib(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %cmp: i1 = icmp slt %n: i32, 2: i32\n"
+                                            "  br %cmp: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %n: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %f1: i32 = call <i32 (i32)> @fib(%n1: i32)\n"
+                                            "  %n2: i32 = sub %n: i32, 2: i32\n"
+                                            "  %f2: i32 = call <i32 (i32)> @fib(%n2: i32)\n"
+                                            "  %r: i32 = add %f1: i32, %f2: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @fib_plus_base(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %buf: <[4 x i32]> = alloc [4 x i32]\n"
+                                            "  %f: i32 = call <i32 (i32)> @fib(%n: i32)\n"
+                                            "  %b: i32 = load @g_base: <i32>\n"
+                                            "  %slot: <i32> = gep %buf: <[4 x i32]>, 0: i32, 1: i32\n"
+                                            "  store %f: i32, %slot: <i32>\n"
+                                            "  %v: i32 = load %slot: <i32>\n"
+                                            "  %r: i32 = add %v: i32, %b: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse worker IR");
+  IRFunction *func = find_function(mod, "fib_plus_base");
+  SUITE_ASSERT(func != NULL, "Failed to find @fib_plus_base");
+
+  /// 1. 准备并封存
+  SUITE_ASSERT(interpreter_prepare_module(env->interp, mod), "Failed to prepare module");
+  SUITE_ASSERT(env->interp->sealed, "Interpreter should be sealed after prepare");
+
+  /// 2. 封存后，未准备过的函数直接失败 (不会惰性修改计划缓存)
+  IRModule *other = ir_parse_module(env->ctx, "define i32 @other(%x: i32) {\n"
+                                              "$entry:\n"
+                                              "  ret %x: i32\n"
+                                              "}\n");
+  SUITE_ASSERT(other != NULL, "Failed to parse second module");
+  RuntimeValue rt_x;
+  rt_x.kind = RUNTIME_VAL_I32;
+  rt_x.as.val_i32 = 15;
+  RuntimeValue *args[] = {&rt_x};
+  RuntimeValue result;
+  SUITE_ASSERT(!interpreter_run_function(env->interp, find_function(other, "other"), args, 1, &result),
+               "Unprepared function must not run on a sealed interpreter");
+
+#ifndef __STDC_NO_THREADS__
+  /// 3. 4 个线程、各自的工作者，并发运行同一个函数 (fib(15) + 7 = 617)
+  enum
+  {
+    NUM_WORKERS = 4
+  };
+  thrd_t threads[NUM_WORKERS];
+  WorkerJob jobs[NUM_WORKERS];
+  for (int i = 0; i < NUM_WORKERS; i++)
+  {
+    jobs[i] = (WorkerJob){.worker = interpreter_worker_create(env->interp),
+                          .func = func,
+                          .arg = 15,
+                          .iterations = 20,
+                          .expected = 617,
+                          .failures = 0};
+    SUITE_ASSERT(jobs[i].worker != NULL, "Failed to create worker %d", i);
+    SUITE_ASSERT(thrd_create(&threads[i], run_worker_job, &jobs[i]) == thrd_success, "Failed to start thread %d", i);
+  }
+  for (int i = 0; i < NUM_WORKERS; i++)
+  {
+    thrd_join(threads[i], NULL);
+    SUITE_ASSERT(jobs[i].failures == 0, "Worker %d had %d failed runs", i, jobs[i].failures);
+    SUITE_ASSERT(jobs[i].worker->stack.top == 0, "Worker %d stack was not unwound", i);
+    interpreter_worker_destroy(jobs[i].worker);
+  }
+#endif
+
+  /// 4. 默认栈仍然可用；修改设置会解除封存
+  bool success = interpreter_run_function(env->interp, func, args, 1, &result);
+  SUITE_ASSERT(success, "Default-stack run failed on a sealed interpreter");
+  ASSERT_I32_RESULT(result, 617);
+  interpreter_set_fusion(env->interp, false);
+  SUITE_ASSERT(!env->interp->sealed, "Changing settings should unseal the interpreter");
+  interpreter_set_fusion(env->interp, true);
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief [Helper] 构建 @collatz(n: i32) -> i32:
+ * 数 Collatz 步数 (每个 lane 的循环次数不同)，退出时再经过一串整数转换与除法
+ */
+static IRFunction *
+build_collatz_function(TestEnv *env)
+{
+  IRType *ty_i32 = ir_type_get_i32(env->ctx);
+  IRValueNode *const_0 = ir_constant_get_i32(env->ctx, 0);
+  IRValueNode *const_1 = ir_constant_get_i32(env->ctx, 1);
+
+  IRFunction *func = ir_function_create(env->mod, "collatz", ty_i32);
+  IRValueNode *arg_n = &ir_argument_create(func, ty_i32, "n")->value;
+  ir_function_finalize_signature(func, false);
+  IRBasicBlock *bb_entry = ir_basic_block_create(func, "entry");
+  IRBasicBlock *bb_loop = ir_basic_block_create(func, "loop");
+  IRBasicBlock *bb_body = ir_basic_block_create(func, "body");
+  IRBasicBlock *bb_exit = ir_basic_block_create(func, "exit");
+  ir_function_append_basic_block(func, bb_entry);
+  ir_function_append_basic_block(func, bb_loop);
+  ir_function_append_basic_block(func, bb_body);
+  ir_function_append_basic_block(func, bb_exit);
+
+  ir_builder_set_insertion_point(env->b, bb_entry);
+  ir_builder_create_br(env->b, &bb_loop->label_address);
+
+  ir_builder_set_insertion_point(env->b, bb_loop);
+  IRValueNode *phi_v = ir_builder_create_phi(env->b, ty_i32, "v");
+  IRValueNode *phi_c = ir_builder_create_phi(env->b, ty_i32, "c");
+  IRValueNode *done = ir_builder_create_icmp(env->b, IR_ICMP_SLE, phi_v, const_1, "done");
+  ir_builder_create_cond_br(env->b, done, &bb_exit->label_address, &bb_body->label_address);
+
+  /// v = (v & 1) ? 3 * v + 1 : v >> 1
+  ir_builder_set_insertion_point(env->b, bb_body);
+  IRValueNode *odd = ir_builder_create_and(env->b, phi_v, const_1, "odd");
+  IRValueNode *is_odd = ir_builder_create_icmp(env->b, IR_ICMP_NE, odd, const_0, "is_odd");
+  IRValueNode *half = ir_builder_create_ashr(env->b, phi_v, const_1, "half");
+  IRValueNode *triple = ir_builder_create_mul(env->b, phi_v, ir_constant_get_i32(env->ctx, 3), "triple");
+  IRValueNode *up = ir_builder_create_add(env->b, triple, const_1, "up");
+  IRValueNode *v_next = ir_builder_create_select(env->b, is_odd, up, half, "v.next");
+  IRValueNode *c_next = ir_builder_create_add(env->b, phi_c, const_1, "c.next");
+  ir_builder_create_br(env->b, &bb_loop->label_address);
+
+  ir_phi_add_incoming(phi_v, arg_n, bb_entry);
+  ir_phi_add_incoming(phi_v, v_next, bb_body);
+  ir_phi_add_incoming(phi_c, const_0, bb_entry);
+  ir_phi_add_incoming(phi_c, c_next, bb_body);
+
+  /// ((trunc_i16(sext_i64(c) * 1000003) zext i32) + c / 3 (逐 lane 执行) ) ^ n
+  ir_builder_set_insertion_point(env->b, bb_exit);
+  IRValueNode *wide = ir_builder_create_sext(env->b, phi_c, ir_type_get_i64(env->ctx), "wide");
+  IRValueNode *scaled = ir_builder_create_mul(env->b, wide, ir_constant_get_i64(env->ctx, 1000003), "scaled");
+  IRValueNode *narrow = ir_builder_create_trunc(env->b, scaled, ir_type_get_i16(env->ctx), "narrow");
+  IRValueNode *back = ir_builder_create_zext(env->b, narrow, ty_i32, "back");
+  IRValueNode *third = ir_builder_create_sdiv(env->b, phi_c, ir_constant_get_i32(env->ctx, 3), "third");
+  IRValueNode *sum = ir_builder_create_add(env->b, back, third, "sum");
+  ir_builder_create_ret(env->b, ir_builder_create_xor(env->b, sum, arg_n, "mixed"));
+  return func;
+}
+
+/**
+ * @brief 测试批量执行: 每个 lane 的结果必须与单独调用 interpreter_run_function 相同
+ */
+int
+test_batch_execution()
+{
+  SUITE_START("Interpreter: Batch Execution");
+  TestEnv *env = setup_test_env();
+
+  IRFunction *collatz = build_collatz_function(env);
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"batch\"\n"
+                                            "\n"
+                                            "define f64 @shade(%x: f64, %k: i32) {\n"
+                                            "$entry:\n"
+                                            "  %kk: i32 = and %k: i32, 3: i32\n"
+                                            "  switch %kk: i32, default $other [\n"
+                                            "    0: i32, $square\n"
+                                            "    1: i32, $round\n"
+                                            "  ]\n"
+                                            "$square:\n"
+                                            "  %sq: f64 = fmul %x: f64, %x: f64\n"
+                                            "  ret %sq: f64\n"
+                                            "$round:\n"
+                                            "  %xf: f32 = fptrunc %x: f64 to f32\n"
+                                            "  %dbl: f32 = fadd %xf: f32, %xf: f32\n"
+                                            "  %ext: f64 = fpext %dbl: f32 to f64\n"
+                                            "  ret %ext: f64\n"
+                                            "$other:\n"
+                                            "  %kf: f64 = sitofp %k: i32 to f64\n"
+                                            "  %lt: i1 = fcmp olt %x: f64, %kf: f64\n"
+                                            "  %pick: f64 = select %lt: i1, %kf: f64, %x: f64\n"
+                                            "  %q: f64 = fdiv %pick: f64, %kf: f64\n"
+                                            "  ret %q: f64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @inc(%a: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = add %a: i32, 1: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @twice_inc(%a: i32) {\n"
+                                            "$entry:\n"
+                                            "  %b: i32 = call <i32 (i32)> @inc(%a: i32)\n"
+                                            "  %c: i32 = call <i32 (i32)> @inc(%b: i32)\n"
+                                            "  ret %c: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @divide(%a: i32, %b: i32) {\n"
+                                            "$entry:\n"
+                                            "  %q: i32 = sdiv %a: i32, %b: i32\n"
+                                            "  ret %q: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse batch IR");
+
+  /// 3 组 lane (最后一组不满)
+  enum
+  {
+    NUM_LANES = 2 * INTERP_BATCH_WIDTH + 44
+  };
+  static RuntimeValue col_int[NUM_LANES];
+  static RuntimeValue col_f64[NUM_LANES];
+  static RuntimeValue col_div[NUM_LANES];
+  static RuntimeValue results[NUM_LANES];
+  for (int l = 0; l < NUM_LANES; l++)
+  {
+    col_int[l].kind = RUNTIME_VAL_I32;
+    col_int[l].as.val_i32 = (l * 37) % 1000 - 20;
+    col_f64[l].kind = RUNTIME_VAL_F64;
+    col_f64[l].as.val_f64 = (l - 150) * 0.37;
+    col_div[l].kind = RUNTIME_VAL_I32;
+    col_div[l].as.val_i32 = (l % 5) + 1;
+  }
+
+  /// 1. 有循环和分化的控制流 (@collatz)、switch 与浮点 (@shade)、含调用的函数 (@twice_inc，逐 lane 退化)
+  typedef struct BatchCase
+  {
+    IRFunction *func;
+    RuntimeValue *columns[2];
+    size_t num_args;
+  } BatchCase;
+  BatchCase cases[] = {
+    {collatz, {col_int, NULL}, 1},
+    {find_function(mod, "shade"), {col_f64, col_int}, 2},
+    {find_function(mod, "twice_inc"), {col_int, NULL}, 1},
+  };
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+  {
+    SUITE_ASSERT(cases[c].func != NULL, "Failed to find batch case %zu", c);
+    bool success = interpreter_run_function_batch(env->interp, cases[c].func, cases[c].columns, cases[c].num_args,
+                                                  NUM_LANES, results);
+    SUITE_ASSERT(success, "Batch run of '@%s' failed", cases[c].func->entry_address.name);
+
+    for (int l = 0; l < NUM_LANES; l++)
+    {
+      RuntimeValue *args[2] = {&cases[c].columns[0][l], cases[c].columns[1] ? &cases[c].columns[1][l] : NULL};
+      RuntimeValue expected;
+      SUITE_ASSERT(interpreter_run_function(env->interp, cases[c].func, args, cases[c].num_args, &expected),
+                   "Scalar run of '@%s' failed on lane %d", cases[c].func->entry_address.name, l);
+      SUITE_ASSERT(results[l].kind == expected.kind, "'@%s' lane %d: kind mismatch", cases[c].func->entry_address.name,
+                   l);
+      SUITE_ASSERT(memcmp(&results[l].as, &expected.as, sizeof(expected.as)) == 0, "'@%s' lane %d: value mismatch",
+                   cases[c].func->entry_address.name, l);
+    }
+  }
+
+  /// 2. 某个 lane 发生运行时错误时整个批量调用失败
+  IRFunction *divide = find_function(mod, "divide");
+  RuntimeValue *div_columns[] = {col_int, col_div};
+  SUITE_ASSERT(interpreter_run_function_batch(env->interp, divide, div_columns, 2, NUM_LANES, results),
+               "Batch division without zero divisors should succeed");
+  col_div[NUM_LANES - 1].as.val_i32 = 0;
+  SUITE_ASSERT(!interpreter_run_function_batch(env->interp, divide, div_columns, 2, NUM_LANES, results),
+               "Batch division by zero should fail");
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/** @brief [辅助] 把 64 位随机数截到 bits 位再符号扩展 (批量 lane 的规范形式) */
+static BatchLane
+canonical_lane(uint64_t raw, unsigned bits)
+{
+  if (bits >= 64)
+    return raw;
+  unsigned shift = 64 - bits;
+  return (BatchLane)((int64_t)(raw << shift) >> shift);
+}
+
+/** @brief [辅助] xorshift64，测试输入只需要可重复 */
+static uint64_t
+next_random(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/**
+ * @brief 测试批量内核的分发: 当前 CPU 能用的每一种实现都必须与基线实现逐位相同
+ */
+int
+test_batch_kernel_dispatch()
+{
+  SUITE_START("Interpreter: Batch Kernel Dispatch");
+
+  CpuFeatures detected = cpu_features_detect();
+  SUITE_ASSERT((cpu_features() & ~detected) == 0, "Cached features must be a subset of the detected ones");
+  char names[64];
+  SUITE_ASSERT(strcmp(cpu_features_describe(0, names, sizeof(names)), "scalar") == 0, "Empty set is 'scalar'");
+  cpu_features_describe(detected, names, sizeof(names));
+  printf("    (CPU features: %s, batch kernels: %s)\n", names, batch_kernels()->name);
+
+  const BatchKernelTable *generic = batch_kernels_for(0);
+  SUITE_ASSERT(strcmp(generic->name, "generic") == 0, "No features should select the generic kernels");
+  SUITE_ASSERT(batch_kernels() == batch_kernels_for(cpu_features()), "Process kernels must follow cpu_features()");
+
+  enum
+  {
+    N = INTERP_BATCH_WIDTH
+  };
+  static BatchLane lhs[N], rhs[N], cond[N], expected[N], actual[N];
+  static uint8_t mask[N];
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+  const CpuFeatures candidates[] = {CPU_FEATURE_AVX2, CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512};
+  for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++)
+  {
+    const BatchKernelTable *table = batch_kernels_for(detected & candidates[c]);
+    if (table == generic)
+      continue;
+
+    for (size_t l = 0; l < N; l++)
+    {
+      mask[l] = (uint8_t)(next_random(&seed) & 1);
+      cond[l] = next_random(&seed) & 1;
+    }
+
+    /// 1. 整数运算 / 比较 / 转换，各种位宽
+    static const unsigned WIDTHS[] = {8, 16, 32, 64};
+    static const IROpcode INT_OPS[] = {IR_OP_ADD, IR_OP_SUB, IR_OP_MUL, IR_OP_AND, IR_OP_OR,
+                                       IR_OP_XOR, IR_OP_SHL, IR_OP_LSHR, IR_OP_ASHR};
+    for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++)
+    {
+      unsigned bits = WIDTHS[w];
+      for (size_t l = 0; l < N; l++)
+        lhs[l] = canonical_lane(next_random(&seed), bits);
+
+      for (size_t o = 0; o < sizeof(INT_OPS) / sizeof(INT_OPS[0]); o++)
+      {
+        bool is_shift = INT_OPS[o] == IR_OP_SHL || INT_OPS[o] == IR_OP_LSHR || INT_OPS[o] == IR_OP_ASHR;
+        for (size_t l = 0; l < N; l++)
+          rhs[l] = is_shift ? next_random(&seed) % bits : canonical_lane(next_random(&seed), bits);
+        for (size_t l = 0; l < N; l++)
+          expected[l] = actual[l] = l;
+        generic->int_binary(INT_OPS[o], bits, expected, lhs, rhs, mask);
+        table->int_binary(INT_OPS[o], bits, actual, lhs, rhs, mask);
+        SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s int_binary %d/i%u differs from generic",
+                     table->name, (int)INT_OPS[o], bits);
+      }
+
+      for (int pred = IR_ICMP_EQ; pred <= IR_ICMP_SLE; pred++)
+      {
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+        generic->icmp((IRICmpPredicate)pred, bits, expected, lhs, rhs, mask);
+        table->icmp((IRICmpPredicate)pred, bits, actual, lhs, rhs, mask);
+        SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s icmp %d/i%u differs from generic",
+                     table->name, pred, bits);
+      }
+
+      static const IROpcode CASTS[] = {IR_OP_TRUNC, IR_OP_ZEXT, IR_OP_SEXT};
+      for (size_t k = 0; k < sizeof(CASTS) / sizeof(CASTS[0]); k++)
+      {
+        unsigned dst_bits = CASTS[k] == IR_OP_TRUNC ? 8 : 64;
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+        generic->int_cast(CASTS[k], bits, dst_bits, expected, lhs, mask);
+        table->int_cast(CASTS[k], bits, dst_bits, actual, lhs, mask);
+        SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s int_cast %d/i%u differs from generic",
+                     table->name, (int)CASTS[k], bits);
+      }
+
+      for (int is_f32 = 0; is_f32 <= 1; is_f32++)
+      {
+        for (IROpcode op = IR_OP_UITOFP; op <= IR_OP_SITOFP; op++)
+        {
+          memset(expected, 0, sizeof(expected));
+          memset(actual, 0, sizeof(actual));
+          generic->float_cast(op, bits, is_f32, expected, lhs, mask);
+          table->float_cast(op, bits, is_f32, actual, lhs, mask);
+          SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s float_cast %d/i%u differs from generic",
+                       table->name, (int)op, bits);
+        }
+      }
+    }
+
+    /// 2. 浮点运算 / 比较 (除数不为 0，包含 NaN 以覆盖无序比较)
+    for (size_t l = 0; l < N; l++)
+    {
+      lhs[l] = batch_lane_from_f64((double)(int64_t)next_random(&seed) / 1e9);
+      rhs[l] = batch_lane_from_f64((double)(int32_t)(next_random(&seed) | 1) / 7.0);
+    }
+    lhs[3] = batch_lane_from_f64(NAN);
+    for (IROpcode op = IR_OP_FADD; op <= IR_OP_FDIV; op++)
+    {
+      for (int is_f32 = 0; is_f32 <= 1; is_f32++)
+      {
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+        bool ok_generic = generic->float_binary(op, is_f32, expected, lhs, rhs, mask);
+        bool ok = table->float_binary(op, is_f32, actual, lhs, rhs, mask);
+        SUITE_ASSERT(ok_generic && ok, "%s float_binary %d should succeed", table->name, (int)op);
+        SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s float_binary %d differs from generic",
+                     table->name, (int)op);
+      }
+    }
+    for (int pred = IR_FCMP_OEQ; pred <= IR_FCMP_FALSE; pred++)
+    {
+      memset(expected, 0, sizeof(expected));
+      memset(actual, 0, sizeof(actual));
+      generic->fcmp((IRFCmpPredicate)pred, expected, lhs, rhs, mask);
+      table->fcmp((IRFCmpPredicate)pred, actual, lhs, rhs, mask);
+      SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s fcmp %d differs from generic", table->name,
+                   pred);
+    }
+
+    /// 3. fdiv 遇到活跃 lane 除以 0 时两种实现都要报告失败
+    rhs[N - 1] = batch_lane_from_f64(0.0);
+    mask[N - 1] = 1;
+    SUITE_ASSERT(!generic->float_binary(IR_OP_FDIV, false, expected, lhs, rhs, mask) &&
+                     !table->float_binary(IR_OP_FDIV, false, actual, lhs, rhs, mask),
+                 "%s fdiv by zero should fail", table->name);
+
+    /// 4. select / copy
+    for (size_t l = 0; l < N; l++)
+      expected[l] = actual[l] = l;
+    generic->select(expected, cond, lhs, rhs, mask);
+    table->select(actual, cond, lhs, rhs, mask);
+    SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s select differs from generic", table->name);
+    generic->copy(expected, rhs, mask);
+    table->copy(actual, rhs, mask);
+    SUITE_ASSERT(memcmp(expected, actual, sizeof(actual)) == 0, "%s copy differs from generic", table->name);
+  }
+
+  SUITE_END();
+}
+
+/**
+ * @brief 测试基线 JIT: 编译后的结果 (包括错误) 必须与解释执行完全相同
+ */
+int
+test_jit_tier()
+{
+  SUITE_START("Interpreter: Baseline JIT");
+  TestEnv *env = setup_test_env();
+
+  if (!interpreter_set_jit(env->interp, true))
+  {
+    printf("  (JIT not available on this platform, skipped)\n");
+    teardown_test_env(env);
+    SUITE_END();
+  }
+  interpreter_set_jit_threshold(env->interp, 0);
+
+  Interpreter *ref = interpreter_create(env->dl);
+  interpreter_register_external_function(env->interp, "my_c_add", my_c_add_wrapper);
+  interpreter_register_external_function(ref, "my_c_add", my_c_add_wrapper);
+
+  IRFunction *collatz = build_collatz_function(env);
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"jit\"\n"
+                                            "\n"
+                                            "%rec = type { i8, i64, [4 x i16] }\n"
+                                            "\n"
+                                            "declare i32 @my_c_add(i32, i32)\n"
+                                            "\n"
+                                            "define i64 @mix(%a: i32, %b: i64) {\n"
+                                            "$entry:\n"
+                                            "  %buf: <%rec> = alloc %rec\n"
+                                            "  %tag: <i8> = gep %buf: <%rec>, 0: i32, 0: i32\n"
+                                            "  %t8: i8 = trunc %a: i32 to i8\n"
+                                            "  store %t8: i8, %tag: <i8>\n"
+                                            "  %wide: <i64> = gep %buf: <%rec>, 0: i32, 1: i32\n"
+                                            "  store %b: i64, %wide: <i64>\n"
+                                            "  %k: i32 = and %a: i32, 3: i32\n"
+                                            "  %slot: <i16> = gep %buf: <%rec>, 0: i32, 2: i32, %k: i32\n"
+                                            "  %h: i16 = trunc %b: i64 to i16\n"
+                                            "  store %h: i16, %slot: <i16>\n"
+                                            "  %t: i8 = load %tag: <i8>\n"
+                                            "  %sh: i8 = ashr %t: i8, 3: i8\n"
+                                            "  %s2: i8 = shl %t: i8, %t8: i8\n"
+                                            "  %lz: i8 = lshr %t: i8, 1: i8\n"
+                                            "  %x1: i8 = xor %s2: i8, %lz: i8\n"
+                                            "  %x2: i8 = or %x1: i8, %sh: i8\n"
+                                            "  %e1: i64 = sext %x2: i8 to i64\n"
+                                            "  %hv: i16 = load %slot: <i16>\n"
+                                            "  %e2: i64 = zext %hv: i16 to i64\n"
+                                            "  %w: i64 = load %wide: <i64>\n"
+                                            "  %m: i64 = mul %w: i64, %e2: i64\n"
+                                            "  %s: i64 = sub %m: i64, %e1: i64\n"
+                                            "  %u: i1 = icmp ult %a: i32, 100: i32\n"
+                                            "  %sl: i64 = select %u: i1, %s: i64, %w: i64\n"
+                                            "  %d: i64 = udiv %sl: i64, 7: i64\n"
+                                            "  %r: i64 = add %d: i64, %sl: i64\n"
+                                            "  ret %r: i64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define f64 @shade(%x: f64, %k: i32) {\n"
+                                            "$entry:\n"
+                                            "  %kk: i32 = and %k: i32, 3: i32\n"
+                                            "  switch %kk: i32, default $other [\n"
+                                            "    0: i32, $square\n"
+                                            "    1: i32, $round\n"
+                                            "  ]\n"
+                                            "$square:\n"
+                                            "  %sq: f64 = fmul %x: f64, %x: f64\n"
+                                            "  %sb: f64 = fsub %sq: f64, %x: f64\n"
+                                            "  ret %sb: f64\n"
+                                            "$round:\n"
+                                            "  %xf: f32 = fptrunc %x: f64 to f32\n"
+                                            "  %dbl: f32 = fadd %xf: f32, %xf: f32\n"
+                                            "  %ext: f64 = fpext %dbl: f32 to f64\n"
+                                            "  ret %ext: f64\n"
+                                            "$other:\n"
+                                            "  %kf: f64 = sitofp %k: i32 to f64\n"
+                                            "  %lt: i1 = fcmp olt %x: f64, %kf: f64\n"
+                                            "  %pick: f64 = select %lt: i1, %kf: f64, %x: f64\n"
+                                            "  %q: f64 = fdiv %pick: f64, %kf: f64\n"
+                                            "  ret %q: f64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @fib(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %small: i1 = icmp slt %n: i32, 2: i32\n"
+                                            "  br %small: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %n: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %n2: i32 = sub %n: i32, 2: i32\n"
+                                            "  %f1: i32 = call <i32 (i32)> @fib(%n1: i32)\n"
+                                            "  %f2: i32 = call <i32 (i32)> @fib(%n2: i32)\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @my_c_add(%f1: i32, %f2: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @count(%n: i32, %acc: i32) {\n"
+                                            "$entry:\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %acc: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %acc1: i32 = add %acc: i32, 1: i32\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @count(%n1: i32, %acc1: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @depth(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret 0: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %r: i32 = call <i32 (i32)> @depth(%n1: i32)\n"
+                                            "  %s: i32 = add %r: i32, 1: i32\n"
+                                            "  ret %s: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @divide(%a: i32, %b: i32) {\n"
+                                            "$entry:\n"
+                                            "  %q: i32 = sdiv %a: i32, %b: i32\n"
+                                            "  ret %q: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse JIT IR");
+
+  /// 1. 每个函数在多组输入上与 (未开启 JIT 的) 解释器逐位比较
+  typedef struct JitCase
+  {
+    IRFunction *func;
+    RuntimeValueKind arg_kinds[2];
+    size_t num_args;
+    /// 第 i 组输入的 i32 参数为 int_base + i * int_step
+    int32_t int_base;
+    int32_t int_step;
+  } JitCase;
+  JitCase cases[] = {
+    {collatz, {RUNTIME_VAL_I32}, 1, 1, 7},
+    {find_function(mod, "mix"), {RUNTIME_VAL_I32, RUNTIME_VAL_I64}, 2, -200, 13},
+    {find_function(mod, "shade"), {RUNTIME_VAL_F64, RUNTIME_VAL_I32}, 2, -3, 1},
+    {find_function(mod, "fib"), {RUNTIME_VAL_I32}, 1, 0, 1},
+  };
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+  {
+    IRFunction *func = cases[c].func;
+    SUITE_ASSERT(func != NULL, "Failed to find JIT case %zu", c);
+    for (int i = 0; i < 24; i++)
+    {
+      RuntimeValue arg_vals[2];
+      RuntimeValue *args[2] = {&arg_vals[0], &arg_vals[1]};
+      for (size_t a = 0; a < cases[c].num_args; a++)
+      {
+        arg_vals[a].kind = cases[c].arg_kinds[a];
+        arg_vals[a].as.val_i64 = 0;
+        if (cases[c].arg_kinds[a] == RUNTIME_VAL_F64)
+          arg_vals[a].as.val_f64 = (i - 20) * 0.73;
+        else if (cases[c].arg_kinds[a] == RUNTIME_VAL_I64)
+          arg_vals[a].as.val_i64 = (int64_t)(i - 17) * 0x12345679LL;
+        else
+          arg_vals[a].as.val_i32 = cases[c].int_base + i * cases[c].int_step;
+      }
+
+      RuntimeValue jit_result;
+      RuntimeValue expected;
+      SUITE_ASSERT(interpreter_run_function(env->interp, func, args, cases[c].num_args, &jit_result),
+                   "JIT run of '@%s' failed on input %d", func->entry_address.name, i);
+      SUITE_ASSERT(interpreter_run_function(ref, func, args, cases[c].num_args, &expected),
+                   "Reference run of '@%s' failed on input %d", func->entry_address.name, i);
+      SUITE_ASSERT(jit_result.kind == expected.kind, "'@%s' input %d: kind mismatch", func->entry_address.name, i);
+      SUITE_ASSERT(memcmp(&jit_result.as, &expected.as, sizeof(expected.as)) == 0, "'@%s' input %d: value mismatch",
+                   func->entry_address.name, i);
+    }
+    SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, func), "'@%s' should have been compiled",
+                 func->entry_address.name);
+  }
+
+  /// 2. 深递归超过机器码的嵌套上限后回到解释执行；尾递归仍然只占用常数栈空间
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  rt_n.as.val_i32 = 20000;
+  RuntimeValue rt_zero;
+  rt_zero.kind = RUNTIME_VAL_I32;
+  rt_zero.as.val_i32 = 0;
+  RuntimeValue *args_one[] = {&rt_n};
+  RuntimeValue *args_count[] = {&rt_n, &rt_zero};
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(mod, "depth"), args_one, 1, &result),
+               "Deep recursion under the JIT failed");
+  ASSERT_I32_RESULT(result, 20000);
+  rt_n.as.val_i32 = 1000000;
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(mod, "count"), args_count, 2, &result),
+               "Tail recursion under the JIT failed");
+  ASSERT_I32_RESULT(result, 1000000);
+
+  /// 3. 运行时错误从机器码中传出，并且解释器栈被完全回退
+  IRFunction *divide = find_function(mod, "divide");
+  RuntimeValue rt_a;
+  rt_a.kind = RUNTIME_VAL_I32;
+  rt_a.as.val_i32 = 42;
+  RuntimeValue *div_args[] = {&rt_a, &rt_zero};
+  SUITE_ASSERT(!interpreter_run_function(env->interp, divide, div_args, 2, &result),
+               "JIT division by zero should fail");
+  SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, divide), "@divide should have been compiled");
+  SUITE_ASSERT(env->interp->stack.top == 0, "Interpreter stack was not unwound after a JIT error");
+
+  /// 4. 阈值: 前 N 次调用解释执行，之后编译
+  interpreter_invalidate_all(env->interp);
+  interpreter_set_jit_threshold(env->interp, 2);
+  rt_a.as.val_i32 = 5;
+  RuntimeValue rt_b;
+  rt_b.kind = RUNTIME_VAL_I32;
+  rt_b.as.val_i32 = 3;
+  RuntimeValue *two_args[] = {&rt_a, &rt_b};
+  for (int i = 0; i < 3; i++)
+  {
+    SUITE_ASSERT(!interpreter_is_jit_compiled(env->interp, divide),
+                 "@divide compiled before reaching the threshold");
+    SUITE_ASSERT(interpreter_run_function(env->interp, divide, two_args, 2, &result), "@divide failed");
+    ASSERT_I32_RESULT(result, 1);
+  }
+  SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, divide), "@divide should be compiled after the threshold");
+
+  /// 5. 开启 profiling 时不编译 (profile 计数器必须准确)
+  interpreter_set_profiling(env->interp, true);
+  interpreter_set_jit_threshold(env->interp, 0);
+  SUITE_ASSERT(interpreter_run_function(env->interp, divide, two_args, 2, &result),
+               "@divide failed while profiling");
+  SUITE_ASSERT(!interpreter_is_jit_compiled(env->interp, divide), "Nothing should be compiled while profiling");
+  SUITE_ASSERT(interpreter_profile_get_calls(env->interp, divide) == 1, "Profiled call count is wrong");
+
+  interpreter_destroy(ref);
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+#if CALICO_HAS_SCHEDULER
+/**
+ * @brief [Helper] 调度器回调: 按结束顺序记录每个执行 (user_data 是 SchedulerLog)
+ */
+typedef struct SchedulerLog
+{
+  InterpreterExecution **order;
+  size_t count;
+} SchedulerLog;
+
+static void
+record_completion(InterpreterExecution *exec, void *user_data)
+{
+  SchedulerLog *log = user_data;
+  log->order[log->count++] = exec;
+}
+
+/**
+ * @brief [Helper] 调度器回调: 只计数 (user_data 是 atomic_size_t，回调在多个工作线程上运行)
+ */
+static void
+count_completion(InterpreterExecution *exec, void *user_data)
+{
+  (void)exec;
+  atomic_fetch_add_explicit((atomic_size_t *)user_data, 1, memory_order_relaxed);
+}
+#endif
+
+/**
+ * @brief [Helper] 以 budget 为单位把执行推进到结束，返回最终状态 (*steps_out 为 step 的次数)
+ */
+static ExecutionResultKind
+run_to_completion(InterpreterExecution *exec, uint64_t budget, int *steps_out)
+{
+  ExecutionResultKind status;
+  int steps = 0;
+  do
+  {
+    status = interpreter_execution_step(exec, budget);
+    steps++;
+  } while (status == EXEC_RUNNING);
+  *steps_out = steps;
+  return status;
+}
+
+/**
+ * @brief 测试可恢复执行 (按指令预算挂起 / 继续) 与协作式调度器
+ */
+int
+test_resumable_execution()
+{
+  SUITE_START("Interpreter: Resumable Execution");
+  TestEnv *env = setup_test_env();
+
+  IRFunction *collatz = build_collatz_function(env);
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"resumable\"\n"
+                                            "\n"
+                                            "define i32 @fib(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %small: i1 = icmp slt %n: i32, 2: i32\n"
+                                            "  br %small: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %n: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %n2: i32 = sub %n: i32, 2: i32\n"
+                                            "  %f1: i32 = call <i32 (i32)> @fib(%n1: i32)\n"
+                                            "  %f2: i32 = call <i32 (i32)> @fib(%n2: i32)\n"
+                                            "  %r: i32 = add %f1: i32, %f2: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @count(%n: i32, %acc: i32) {\n"
+                                            "$entry:\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %acc: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %acc1: i32 = add %acc: i32, 1: i32\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @count(%n1: i32, %acc1: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @divide(%a: i32, %b: i32) {\n"
+                                            "$entry:\n"
+                                            "  %q: i32 = sdiv %a: i32, %b: i32\n"
+                                            "  ret %q: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse resumable IR");
+  IRFunction *fib = find_function(mod, "fib");
+  IRFunction *count = find_function(mod, "count");
+  IRFunction *divide = find_function(mod, "divide");
+
+  RuntimeValue rt_a;
+  rt_a.kind = RUNTIME_VAL_I32;
+  rt_a.as.val_i32 = 27;
+  RuntimeValue rt_b;
+  rt_b.kind = RUNTIME_VAL_I32;
+  rt_b.as.val_i32 = 0;
+  RuntimeValue *args_one[] = {&rt_a};
+  RuntimeValue *args_two[] = {&rt_a, &rt_b};
+  RuntimeValue expected;
+  int steps;
+
+  /// 1. 循环: 小预算下多次挂起，结果与一次性运行相同
+  SUITE_ASSERT(interpreter_run_function(env->interp, collatz, args_one, 1, &expected), "Reference @collatz failed");
+  InterpreterExecution *exec = interpreter_execution_start(env->interp, collatz, args_one, 1, 0);
+  SUITE_ASSERT(exec != NULL, "Failed to start @collatz");
+  SUITE_ASSERT(exec->status == EXEC_RUNNING, "A new execution should be running");
+  SUITE_ASSERT(run_to_completion(exec, 5, &steps) == EXEC_OK, "@collatz execution failed");
+  SUITE_ASSERT(steps > 100, "@collatz(27) should suspend many times with a budget of 5 (got %d steps)", steps);
+  ASSERT_I32_RESULT(exec->result, expected.as.val_i32);
+  SUITE_ASSERT(exec->instructions > 0 && exec->instructions <= (uint64_t)steps * 5, "Consumed budget is wrong");
+  SUITE_ASSERT(exec->stack.top == 0, "Finished execution did not release its frames");
+  SUITE_ASSERT(interpreter_execution_step(exec, 5) == EXEC_OK, "A finished execution should keep its status");
+  interpreter_execution_destroy(exec);
+
+  /// 2. 递归调用: 在任意深度的帧中挂起
+  rt_a.as.val_i32 = 15;
+  exec = interpreter_execution_start(env->interp, fib, args_one, 1, 0);
+  SUITE_ASSERT(exec != NULL, "Failed to start @fib");
+  SUITE_ASSERT(run_to_completion(exec, 7, &steps) == EXEC_OK, "@fib execution failed");
+  SUITE_ASSERT(steps > 1000, "@fib(15) should suspend inside nested calls (got %d steps)", steps);
+  ASSERT_I32_RESULT(exec->result, 610);
+  interpreter_execution_destroy(exec);
+
+  /// 3. 尾递归在挂起之间仍然只占用常数栈空间 (小栈也足够)
+  rt_a.as.val_i32 = 100000;
+  exec = interpreter_execution_start(env->interp, count, args_two, 2, 4096);
+  SUITE_ASSERT(exec != NULL, "Failed to start @count");
+  SUITE_ASSERT(run_to_completion(exec, 1000, &steps) == EXEC_OK, "@count execution failed: %s",
+               exec->ctx.error_message ? exec->ctx.error_message : "(no message)");
+  ASSERT_I32_RESULT(exec->result, 100000);
+  interpreter_execution_destroy(exec);
+
+  /// 4. 运行时错误结束执行，之后一直返回同一个状态
+  rt_a.as.val_i32 = 42;
+  exec = interpreter_execution_start(env->interp, divide, args_two, 2, 0);
+  SUITE_ASSERT(exec != NULL, "Failed to start @divide");
+  SUITE_ASSERT(interpreter_execution_step(exec, 100) == EXEC_ERR_DIV_BY_ZERO_S, "Division by zero should fail");
+  SUITE_ASSERT(exec->ctx.error_message != NULL, "Error message was not set");
+  SUITE_ASSERT(interpreter_execution_step(exec, 100) == EXEC_ERR_DIV_BY_ZERO_S, "Error status should stick");
+  SUITE_ASSERT(exec->stack.top == 0, "Failed execution did not release its frames");
+  interpreter_execution_destroy(exec);
+
+  /// 5. 已被 JIT 编译的函数在可恢复执行中仍然解释执行 (可以挂起)
+  if (interpreter_set_jit(env->interp, true))
+  {
+    interpreter_set_jit_threshold(env->interp, 0);
+    rt_a.as.val_i32 = 10;
+    SUITE_ASSERT(interpreter_run_function(env->interp, fib, args_one, 1, &expected), "JIT @fib failed");
+    SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, fib), "@fib should have been compiled");
+    exec = interpreter_execution_start(env->interp, fib, args_one, 1, 0);
+    SUITE_ASSERT(exec != NULL, "Failed to start compiled @fib");
+    SUITE_ASSERT(run_to_completion(exec, 8, &steps) == EXEC_OK, "Compiled @fib execution failed");
+    SUITE_ASSERT(steps > 10, "Compiled @fib should still suspend (got %d steps)", steps);
+    ASSERT_I32_RESULT(exec->result, 55);
+    interpreter_execution_destroy(exec);
+    interpreter_set_jit(env->interp, false);
+  }
+
+#if CALICO_HAS_SCHEDULER
+  /// 6. 调度器只接受封存的解释器
+  SUITE_ASSERT(interpreter_scheduler_create(env->interp, 1, 0, NULL, NULL) == NULL,
+               "Scheduler must reject an unsealed interpreter");
+  SUITE_ASSERT(interpreter_prepare_module(env->interp, mod), "Failed to prepare module");
+  SUITE_ASSERT(interpreter_prepare_module(env->interp, env->mod), "Failed to prepare builder module");
+
+  /// 7. 单线程轮转: 先提交的长任务不会挡住之后的短任务
+  enum
+  {
+    NUM_SHORT = 20,
+    NUM_TENANTS = 1000,
+  };
+  InterpreterExecution *order[NUM_SHORT + 1];
+  SchedulerLog log = {.order = order, .count = 0};
+  InterpreterScheduler *sched = interpreter_scheduler_create(env->interp, 1, 50, record_completion, &log);
+  SUITE_ASSERT(sched != NULL, "Failed to create scheduler");
+
+  rt_a.as.val_i32 = 1000000;
+  InterpreterExecution *long_exec = interpreter_execution_start(env->interp, count, args_two, 2, 0);
+  SUITE_ASSERT(long_exec != NULL, "Failed to start the long execution");
+  interpreter_scheduler_submit(sched, long_exec);
+  rt_a.as.val_i32 = 5;
+  InterpreterExecution *shorts[NUM_SHORT];
+  for (int i = 0; i < NUM_SHORT; i++)
+  {
+    shorts[i] = interpreter_execution_start(env->interp, fib, args_one, 1, 0);
+    SUITE_ASSERT(shorts[i] != NULL, "Failed to start short execution %d", i);
+    interpreter_scheduler_submit(sched, shorts[i]);
+  }
+  interpreter_scheduler_wait(sched);
+  interpreter_scheduler_destroy(sched);
+
+  SUITE_ASSERT(log.count == NUM_SHORT + 1, "Expected %d completions, got %zu", NUM_SHORT + 1, log.count);
+  SUITE_ASSERT(order[NUM_SHORT] == long_exec, "The long execution should finish last");
+  ASSERT_I32_RESULT(long_exec->result, 1000000);
+  interpreter_execution_destroy(long_exec);
+  for (int i = 0; i < NUM_SHORT; i++)
+  {
+    ASSERT_I32_RESULT(shorts[i]->result, 5);
+    interpreter_execution_destroy(shorts[i]);
+  }
+
+  /// 8. 4 个工作线程推进 1000 个执行，结果与一次性运行相同
+  atomic_size_t completed = 0;
+  sched = interpreter_scheduler_create(env->interp, 4, 16, count_completion, &completed);
+  SUITE_ASSERT(sched != NULL, "Failed to create the thread pool");
+  InterpreterExecution **tenants = malloc(sizeof(InterpreterExecution *) * NUM_TENANTS);
+  int32_t expected_results[NUM_TENANTS];
+  for (int i = 0; i < NUM_TENANTS; i++)
+  {
+    IRFunction *func = (i % 2) ? fib : collatz;
+    rt_a.as.val_i32 = (i % 2) ? i % 16 : 1 + i;
+    SUITE_ASSERT(interpreter_run_function(env->interp, func, args_one, 1, &expected), "Reference run %d failed", i);
+    expected_results[i] = expected.as.val_i32;
+    tenants[i] = interpreter_execution_start(env->interp, func, args_one, 1, 0);
+    SUITE_ASSERT(tenants[i] != NULL, "Failed to start tenant %d", i);
+    interpreter_scheduler_submit(sched, tenants[i]);
+  }
+  interpreter_scheduler_wait(sched);
+  SUITE_ASSERT(atomic_load(&completed) == NUM_TENANTS, "Expected %d completions, got %zu", NUM_TENANTS,
+               atomic_load(&completed));
+  for (int i = 0; i < NUM_TENANTS; i++)
+  {
+    SUITE_ASSERT(tenants[i]->status == EXEC_OK && tenants[i]->result.as.val_i32 == expected_results[i],
+                 "Tenant %d: expected %d, got %d", i, expected_results[i], tenants[i]->result.as.val_i32);
+    interpreter_execution_destroy(tenants[i]);
+  }
+  free(tenants);
+  interpreter_scheduler_destroy(sched);
+#endif
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/// 类型化宿主函数 (按值传递，不装箱)
+static int64_t
+typed_madd(int64_t a, int64_t b, int64_t c)
+{
+  return a * b + c;
+}
+
+static double
+typed_hypot2(double x, double y)
+{
+  return x * x + y * y;
+}
+
+static int64_t
+typed_read_i32(int64_t addr)
+{
+  return *(const int32_t *)(intptr_t)addr;
+}
+
+static int64_t g_typed_ticks;
+
+static void
+typed_tick(int64_t amount)
+{
+  g_typed_ticks += amount;
+}
+
+static int64_t
+typed_constant_sub(int64_t a, int64_t b)
+{
+  return a - b;
+}
+
+/**
+ * @brief 测试链接时解析的 FFI: 类型化宿主函数、模块链接与重新注册
+ */
+int
+test_linked_ffi()
+{
+  SUITE_START("Interpreter: Linked & Typed FFI");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"ffi\"\n"
+                                            "\n"
+                                            "@g_cell: <i32> = global -17: i32\n"
+                                            "\n"
+                                            "declare i64 @madd(i64, i64, i64)\n"
+                                            "declare f64 @hypot2(f64, f64)\n"
+                                            "declare i64 @read_i32(<i32>)\n"
+                                            "declare i32 @my_c_add(i32, i32)\n"
+                                            "\n"
+                                            "define i32 @kernel(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %a: i64 = sext %n: i32 to i64\n"
+                                            "  %m: i64 = call <i64 (i64, i64, i64)> @madd(%a: i64, 6: i64, -4: i64)\n"
+                                            "  %x: f32 = sitofp %n: i32 to f32\n"
+                                            "  %xd: f64 = fpext %x: f32 to f64\n"
+                                            "  %h: f64 = call <f64 (f64, f64)> @hypot2(%xd: f64, 0.5: f64)\n"
+                                            "  %hi: i64 = fptosi %h: f64 to i64\n"
+                                            "  %c: i64 = call <i64 (<i32>)> @read_i32(@g_cell: <i32>)\n"
+                                            "  %s1: i64 = add %m: i64, %hi: i64\n"
+                                            "  %s2: i64 = add %s1: i64, %c: i64\n"
+                                            "  %t: i32 = trunc %s2: i64 to i32\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @my_c_add(%t: i32, 1000: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @narrow(%a: i32, %b: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = call <i32 (i32, i32)> @my_c_add(%a: i32, %b: i32)\n"
+                                            "  ret %r: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse FFI IR");
+  IRFunction *kernel = find_function(mod, "kernel");
+  IRFunction *narrow = find_function(mod, "narrow");
+
+  /// 1. 链接: 缺少任何一个宿主函数时报告失败
+  SUITE_ASSERT(!interpreter_link_module(env->interp, mod), "Module with unregistered externs should not link");
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "madd", (CalicoTypedHostFunction)typed_madd,
+                                                   CALICO_HOST_I64, CALICO_HOST_I64, 3),
+               "Failed to register @madd");
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "hypot2", (CalicoTypedHostFunction)typed_hypot2,
+                                                   CALICO_HOST_F64, CALICO_HOST_F64, 2),
+               "Failed to register @hypot2");
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "read_i32", (CalicoTypedHostFunction)typed_read_i32,
+                                                   CALICO_HOST_I64, CALICO_HOST_I64, 1),
+               "Failed to register @read_i32");
+  SUITE_ASSERT(!interpreter_register_typed_function(env->interp, "too_many", (CalicoTypedHostFunction)typed_madd,
+                                                    CALICO_HOST_I64, CALICO_HOST_I64, CALICO_TYPED_HOST_MAX_PARAMS + 1),
+               "Signatures with too many parameters must be rejected");
+  SUITE_ASSERT(!interpreter_link_module(env->interp, mod), "@my_c_add is still unregistered");
+  interpreter_register_external_function(env->interp, "my_c_add", my_c_add_wrapper);
+  SUITE_ASSERT(interpreter_link_module(env->interp, mod), "Fully registered module should link");
+
+  /// 2. 类型化与装箱的宿主函数混合调用: 7*6-4 + (49+0.25) + (-17) + 1000 = 1070
+  RuntimeValue rt_a;
+  rt_a.kind = RUNTIME_VAL_I32;
+  rt_a.as.val_i32 = 7;
+  RuntimeValue rt_b;
+  rt_b.kind = RUNTIME_VAL_I32;
+  rt_b.as.val_i32 = 5;
+  RuntimeValue *args_one[] = {&rt_a};
+  RuntimeValue *args_two[] = {&rt_a, &rt_b};
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, kernel, args_one, 1, &result), "@kernel failed");
+  ASSERT_I32_RESULT(result, 1070);
+
+  /// 3. 计划已经构建后重新注册: 调用点立即使用新的函数 (装箱 -> 类型化)
+  SUITE_ASSERT(interpreter_run_function(env->interp, narrow, args_two, 2, &result), "@narrow failed");
+  ASSERT_I32_RESULT(result, 12);
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "my_c_add",
+                                                   (CalicoTypedHostFunction)typed_constant_sub, CALICO_HOST_I64,
+                                                   CALICO_HOST_I64, 2),
+               "Failed to re-register @my_c_add");
+  SUITE_ASSERT(interpreter_run_function(env->interp, narrow, args_two, 2, &result), "Re-registered @narrow failed");
+  ASSERT_I32_RESULT(result, 2);
+
+  /// 4. 签名与 IR 声明不符时返回运行时错误
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "my_c_add", (CalicoTypedHostFunction)typed_hypot2,
+                                                   CALICO_HOST_F64, CALICO_HOST_F64, 2),
+               "Failed to re-register @my_c_add as f64");
+  SUITE_ASSERT(!interpreter_run_function(env->interp, narrow, args_two, 2, &result),
+               "Integer arguments must not be passed to an f64 host function");
+  interpreter_register_external_function(env->interp, "my_c_add", my_c_add_wrapper);
+  SUITE_ASSERT(interpreter_run_function(env->interp, narrow, args_two, 2, &result), "Boxed @narrow failed");
+  ASSERT_I32_RESULT(result, 12);
+
+  /// 5. 没有返回值的类型化函数 (void 调用)
+  IRType *ty_i64 = ir_type_get_i64(env->ctx);
+  IRFunction *tick_decl = ir_function_create(env->mod, "tick", ir_type_get_void(env->ctx));
+  ir_argument_create(tick_decl, ty_i64, "n");
+  ir_function_finalize_signature(tick_decl, false);
+  tick_decl->is_declaration = true;
+
+  IRFunction *tick_twice = ir_function_create(env->mod, "tick_twice", ty_i64);
+  IRValueNode *arg_n = &ir_argument_create(tick_twice, ty_i64, "n")->value;
+  ir_function_finalize_signature(tick_twice, false);
+  IRBasicBlock *bb = ir_basic_block_create(tick_twice, "entry");
+  ir_function_append_basic_block(tick_twice, bb);
+  ir_builder_set_insertion_point(env->b, bb);
+  IRValueNode *tick_args[] = {arg_n};
+  ir_builder_create_call(env->b, &tick_decl->entry_address, tick_args, 1, NULL);
+  ir_builder_create_call(env->b, &tick_decl->entry_address, tick_args, 1, NULL);
+  ir_builder_create_ret(env->b, arg_n);
+
+  SUITE_ASSERT(interpreter_register_typed_function(env->interp, "tick", (CalicoTypedHostFunction)typed_tick,
+                                                   CALICO_HOST_VOID, CALICO_HOST_I64, 1),
+               "Failed to register @tick");
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I64;
+  rt_n.as.val_i64 = 21;
+  RuntimeValue *tick_run_args[] = {&rt_n};
+  g_typed_ticks = 0;
+  SUITE_ASSERT(interpreter_run_function(env->interp, tick_twice, tick_run_args, 1, &result), "@tick_twice failed");
+  SUITE_ASSERT(result.kind == RUNTIME_VAL_I64 && result.as.val_i64 == 21, "@tick_twice returned the wrong value");
+  SUITE_ASSERT(g_typed_ticks == 42, "Expected 42 ticks, got %lld", (long long)g_typed_ticks);
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 在模块中按名字查找全局变量
+ */
+static IRGlobalVariable *
+find_global(IRModule *mod, const char *name)
+{
+  IDList *it;
+  list_for_each(&mod->globals, it)
+  {
+    IRGlobalVariable *g = list_entry(it, IRGlobalVariable, list_node);
+    if (strcmp(g->value.name, name) == 0)
+      return g;
+  }
+  return NULL;
+}
+
+/**
+ * @brief 测试模块的全局镜像、快照与恢复
+ */
+int
+test_global_image()
+{
+  SUITE_START("Interpreter: Global Image & Snapshots");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"globals\"\n"
+                                            "\n"
+                                            "@g_flag: <i8> = global 1: i8\n"
+                                            "@g_count: <i64> = global 5: i64\n"
+                                            "@g_small: <i32> = global 3: i32\n"
+                                            "@g_scale: <f64> = global 2.5: f64\n"
+                                            "\n"
+                                            "define i64 @bump() {\n"
+                                            "$entry:\n"
+                                            "  %c: i64 = load @g_count: <i64>\n"
+                                            "  %n: i64 = add %c: i64, 1: i64\n"
+                                            "  store %n: i64, @g_count: <i64>\n"
+                                            "  %s: i32 = load @g_small: <i32>\n"
+                                            "  %s2: i32 = mul %s: i32, 2: i32\n"
+                                            "  store %s2: i32, @g_small: <i32>\n"
+                                            "  ret %n: i64\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse globals IR");
+  IRFunction *bump = find_function(mod, "bump");
+  SUITE_ASSERT(bump != NULL, "Failed to find @bump");
+
+  /// 1. 装载: 所有全局变量位于同一个镜像中，按各自的对齐排列并带有初始值
+  SUITE_ASSERT(interpreter_load_globals(env->interp, mod), "Failed to load globals");
+  GlobalImage *image = env->interp->global_images;
+  SUITE_ASSERT(image != NULL && image->next == NULL, "Expected exactly one global image");
+  SUITE_ASSERT(image->module == mod, "Image belongs to the wrong module");
+
+  const char *names[] = {"g_flag", "g_count", "g_small", "g_scale"};
+  const size_t aligns[] = {1, 8, 4, 8};
+  uint8_t *addrs[4];
+  for (int i = 0; i < 4; i++)
   {
-    if (ctx)
-      ctx->error_message = "FFI Error: my_c_add expects 2 i32 args";
-    return EXEC_ERR_INVALID_PTR;
+    IRGlobalVariable *g = find_global(mod, names[i]);
+    SUITE_ASSERT(g != NULL, "Failed to find @%s", names[i]);
+    addrs[i] = ptr_hashmap_get(env->interp->global_storage, &g->value);
+    SUITE_ASSERT(addrs[i] >= image->memory && addrs[i] < image->memory + image->size, "@%s is outside the image",
+                 names[i]);
+    SUITE_ASSERT(((uintptr_t)addrs[i] % aligns[i]) == 0, "@%s is misaligned", names[i]);
   }
+  SUITE_ASSERT(image->size <= 32, "Image should be packed, got %zu bytes", image->size);
+  SUITE_ASSERT(*(int8_t *)addrs[0] == 1, "@g_flag initial value");
+  SUITE_ASSERT(*(int64_t *)addrs[1] == 5, "@g_count initial value");
+  SUITE_ASSERT(*(int32_t *)addrs[2] == 3, "@g_small initial value");
+  SUITE_ASSERT(*(double *)addrs[3] == 2.5, "@g_scale initial value");
 
-  int32_t a = args[0]->as.val_i32;
-  int32_t b = args[1]->as.val_i32;
+  /// 2. 运行修改全局变量，状态在调用之间保留
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump failed");
+  SUITE_ASSERT(result.as.val_i64 == 6, "First @bump should return 6");
+  SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump failed");
+  SUITE_ASSERT(result.as.val_i64 == 7, "Second @bump should return 7");
 
-  result_out->kind = RUNTIME_VAL_I32;
-  result_out->as.val_i32 = a + b;
-  return EXEC_OK;
+  /// 3. 快照后可以多次恢复到同一状态
+  GlobalSnapshot *snapshot = interpreter_snapshot_globals(env->interp, mod);
+  SUITE_ASSERT(snapshot != NULL, "Failed to snapshot globals");
+  for (int round = 0; round < 3; round++)
+  {
+    SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump failed");
+    SUITE_ASSERT(result.as.val_i64 == 8, "Round %d: @bump after restore should return 8", round);
+    SUITE_ASSERT(*(int32_t *)addrs[2] == 24, "Round %d: @g_small should be 24", round);
+    interpreter_restore_globals(env->interp, snapshot);
+    SUITE_ASSERT(*(int64_t *)addrs[1] == 7, "Round %d: @g_count should be restored to 7", round);
+  }
+  interpreter_snapshot_destroy(snapshot);
+
+  /// 4. 重置为初始值 (丢弃计划不影响全局镜像)
+  interpreter_invalidate_all(env->interp);
+  SUITE_ASSERT(env->interp->global_images == image, "Invalidating plans must keep the global images");
+  SUITE_ASSERT(interpreter_reset_globals(env->interp, mod), "Failed to reset globals");
+  SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump failed");
+  SUITE_ASSERT(result.as.val_i64 == 6, "@bump after reset should return 6");
+  SUITE_ASSERT(*(double *)addrs[3] == 2.5, "@g_scale should be untouched");
+
+  /// 5. 未显式装载的模块在第一次运行时整体装载
+  IRModule *lazy = ir_parse_module(env->ctx, "module = \"lazy\"\n"
+                                             "\n"
+                                             "@g_a: <i32> = global 40: i32\n"
+                                             "@g_b: <i32> = global 2: i32\n"
+                                             "\n"
+                                             "define i32 @read_a() {\n"
+                                             "$entry:\n"
+                                             "  %a: i32 = load @g_a: <i32>\n"
+                                             "  ret %a: i32\n"
+                                             "}\n");
+  SUITE_ASSERT(lazy != NULL, "Failed to parse lazy IR");
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(lazy, "read_a"), NULL, 0, &result),
+               "@read_a failed");
+  ASSERT_I32_RESULT(result, 40);
+  SUITE_ASSERT(image->next != NULL && image->next->module == lazy, "Lazy module should get its own image");
+  IRGlobalVariable *g_b = find_global(lazy, "g_b");
+  uint8_t *b_addr = ptr_hashmap_get(env->interp->global_storage, &g_b->value);
+  SUITE_ASSERT(b_addr >= image->next->memory && b_addr < image->next->memory + image->next->size,
+               "Unreferenced @g_b should be placed with @g_a");
+  SUITE_ASSERT(*(int32_t *)b_addr == 2, "@g_b initial value");
+
+  teardown_test_env(env);
+  SUITE_END();
 }
 
 /**
- * @brief 测试 FFI 调用和运行时错误
+ * @brief 测试纯函数分析与备忘表
  */
 int
-test_ffi_and_errors()
+test_memoization()
 {
-  SUITE_START("Interpreter: FFI & Errors");
+  SUITE_START("Interpreter: Pure Function Memoization");
   TestEnv *env = setup_test_env();
-  IRType *ty_i32 = ir_type_get_i32(env->ctx);
 
-  interpreter_register_external_function(env->interp, "my_c_add", my_c_add_wrapper);
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"memo\"\n"
+                                            "\n"
+                                            "@g_counter: <i32> = global 0: i32\n"
+                                            "\n"
+                                            "declare i64 @host_fn(i64)\n"
+                                            "\n"
+                                            "define i64 @fib(%n: i64) {\n"
+                                            "$entry:\n"
+                                            "  %c: i1 = icmp slt %n: i64, 2: i64\n"
+                                            "  br %c: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret %n: i64\n"
+                                            "$rec:\n"
+                                            "  %n1: i64 = sub %n: i64, 1: i64\n"
+                                            "  %f1: i64 = call <i64 (i64)> @fib(%n1: i64)\n"
+                                            "  %n2: i64 = sub %n: i64, 2: i64\n"
+                                            "  %f2: i64 = call <i64 (i64)> @fib(%n2: i64)\n"
+                                            "  %r: i64 = add %f1: i64, %f2: i64\n"
+                                            "  ret %r: i64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @sq(%x: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = mul %x: i32, %x: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @local_mem(%x: i32) {\n"
+                                            "$entry:\n"
+                                            "  %buf: <[2 x i32]> = alloc [2 x i32]\n"
+                                            "  %slot: <i32> = gep %buf: <[2 x i32]>, 0: i32, 1: i32\n"
+                                            "  store %x: i32, %slot: <i32>\n"
+                                            "  %v: i32 = load %slot: <i32>\n"
+                                            "  %r: i32 = add %v: i32, 1: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @quot(%a: i32, %b: i32) {\n"
+                                            "$entry:\n"
+                                            "  %r: i32 = sdiv %a: i32, %b: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @bump_counter() {\n"
+                                            "$entry:\n"
+                                            "  %c: i32 = load @g_counter: <i32>\n"
+                                            "  %n: i32 = add %c: i32, 1: i32\n"
+                                            "  store %n: i32, @g_counter: <i32>\n"
+                                            "  ret %n: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @read_counter() {\n"
+                                            "$entry:\n"
+                                            "  %c: i32 = load @g_counter: <i32>\n"
+                                            "  ret %c: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @read_ptr(%p: <i32>) {\n"
+                                            "$entry:\n"
+                                            "  %v: i32 = load %p: <i32>\n"
+                                            "  ret %v: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @calls_impure(%x: i32) {\n"
+                                            "$entry:\n"
+                                            "  %c: i32 = call <i32 ()> @read_counter()\n"
+                                            "  %r: i32 = add %c: i32, %x: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i64 @calls_host(%x: i64) {\n"
+                                            "$entry:\n"
+                                            "  %r: i64 = call <i64 (i64)> @host_fn(%x: i64)\n"
+                                            "  ret %r: i64\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse memo IR");
 
-  IRFunction *func_decl = ir_function_create(env->mod, "my_c_add", ty_i32);
-  ir_argument_create(func_decl, ty_i32, "a");
-  ir_argument_create(func_decl, ty_i32, "b");
-  ir_function_finalize_signature(func_decl, false);
-  func_decl->is_declaration = true;
+  /// 1. 纯函数分析
+  SUITE_ASSERT(purity_is_pure_function(find_function(mod, "fib")), "@fib (recursive) should be pure");
+  SUITE_ASSERT(purity_is_pure_function(find_function(mod, "sq")), "@sq should be pure");
+  SUITE_ASSERT(purity_is_pure_function(find_function(mod, "local_mem")), "@local_mem only touches its alloca");
+  SUITE_ASSERT(purity_is_pure_function(find_function(mod, "quot")), "@quot should be pure");
+  SUITE_ASSERT(!purity_is_pure_function(find_function(mod, "bump_counter")), "@bump_counter stores a global");
+  SUITE_ASSERT(!purity_is_pure_function(find_function(mod, "read_counter")), "@read_counter loads a global");
+  SUITE_ASSERT(!purity_is_pure_function(find_function(mod, "read_ptr")), "@read_ptr loads through an argument");
+  SUITE_ASSERT(!purity_is_pure_function(find_function(mod, "calls_impure")), "@calls_impure calls an impure fn");
+  SUITE_ASSERT(!purity_is_pure_function(find_function(mod, "calls_host")), "@calls_host calls a declaration");
 
-  IRFunction *func_ffi = ir_function_create(env->mod, "test_ffi", ty_i32);
-  IRValueNode *arg_x = &ir_argument_create(func_ffi, ty_i32, "x")->value;
-  IRValueNode *arg_y = &ir_argument_create(func_ffi, ty_i32, "y")->value;
-  ir_function_finalize_signature(func_ffi, false);
-  IRBasicBlock *bb_ffi = ir_basic_block_create(func_ffi, "entry");
-  ir_function_append_basic_block(func_ffi, bb_ffi);
-  ir_builder_set_insertion_point(env->b, bb_ffi);
-  IRValueNode *call_args[] = {arg_x, arg_y};
-  IRValueNode *call_res = ir_builder_create_call(env->b, &func_decl->entry_address, call_args, 2, "res");
-  ir_builder_create_ret(env->b, call_res);
+  InterpreterMemoStats stats;
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.capacity == 0 && stats.hits == 0, "Memoization should start disabled");
+  SUITE_ASSERT(interpreter_set_memoization(env->interp, true, 0), "Failed to enable memoization");
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.capacity == INTERP_MEMO_DEFAULT_CAPACITY, "Unexpected default capacity %zu", stats.capacity);
+
+  /// 2. 递归的 @fib(60): 不备忘时需要约 10^12 次调用，备忘后每个 n 只执行一次
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I64;
+  rt_n.as.val_i64 = 60;
+  RuntimeValue *fib_args[] = {&rt_n};
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(mod, "fib"), fib_args, 1, &result), "@fib failed");
+  SUITE_ASSERT(result.kind == RUNTIME_VAL_I64 && result.as.val_i64 == 1548008755920LL, "@fib(60) = %lld",
+               (long long)result.as.val_i64);
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.misses == 61, "Expected one miss per n in [0, 60], got %llu", (unsigned long long)stats.misses);
+  SUITE_ASSERT(stats.hits == 58, "Expected 58 hits, got %llu", (unsigned long long)stats.hits);
+  SUITE_ASSERT(stats.entries == 61, "Expected 61 cached results, got %zu", stats.entries);
 
+  /// 3. 顶层调用命中；窄类型参数未写入的高位不影响命中
   RuntimeValue rt_x;
   rt_x.kind = RUNTIME_VAL_I32;
-  rt_x.as.val_i32 = 70;
-  RuntimeValue rt_y;
-  rt_y.kind = RUNTIME_VAL_I32;
-  rt_y.as.val_i32 = 7;
-  RuntimeValue *ffi_args[] = {&rt_x, &rt_y};
-  RuntimeValue ffi_result;
-  bool ffi_success = interpreter_run_function(env->interp, func_ffi, ffi_args, 2, &ffi_result);
-  SUITE_ASSERT(ffi_success, "Interpreter failed to run @test_ffi");
-  ASSERT_I32_RESULT(ffi_result, 77); /// 70 + 7 = 77
+  rt_x.as.val_i64 = 0x5a5a5a5a00000000LL;
+  rt_x.as.val_i32 = 9;
+  RuntimeValue *sq_args[] = {&rt_x};
+  IRFunction *sq = find_function(mod, "sq");
+  SUITE_ASSERT(interpreter_run_function(env->interp, sq, sq_args, 1, &result), "@sq failed");
+  ASSERT_I32_RESULT(result, 81);
+  rt_x.as.val_i64 = 0;
+  rt_x.as.val_i32 = 9;
+  uint64_t hits_before = stats.hits;
+  SUITE_ASSERT(interpreter_run_function(env->interp, sq, sq_args, 1, &result), "@sq failed");
+  ASSERT_I32_RESULT(result, 81);
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.hits == hits_before + 1, "Second @sq(9) should hit");
 
-  IRFunction *func_unlinked_decl = ir_function_create(env->mod, "unlinked_fn", ty_i32);
-  ir_function_finalize_signature(func_unlinked_decl, false);
-  func_unlinked_decl->is_declaration = true;
+  /// 4. 有副作用的函数不被备忘
+  IRFunction *bump = find_function(mod, "bump_counter");
+  SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump_counter failed");
+  ASSERT_I32_RESULT(result, 1);
+  SUITE_ASSERT(interpreter_run_function(env->interp, bump, NULL, 0, &result), "@bump_counter failed");
+  ASSERT_I32_RESULT(result, 2);
 
-  IRFunction *func_unlinked = ir_function_create(env->mod, "test_unlinked", ty_i32);
-  ir_function_finalize_signature(func_unlinked, false);
-  IRBasicBlock *bb_unlinked = ir_basic_block_create(func_unlinked, "entry");
-  ir_function_append_basic_block(func_unlinked, bb_unlinked);
-  ir_builder_set_insertion_point(env->b, bb_unlinked);
-  ir_builder_create_call(env->b, &func_unlinked_decl->entry_address, NULL, 0, "res");
-  ir_builder_create_ret(env->b, NULL);
+  /// 5. 出错的调用不缓存
+  RuntimeValue rt_a, rt_b;
+  rt_a.kind = RUNTIME_VAL_I32;
+  rt_a.as.val_i32 = 10;
+  rt_b.kind = RUNTIME_VAL_I32;
+  rt_b.as.val_i32 = 0;
+  RuntimeValue *quot_args[] = {&rt_a, &rt_b};
+  IRFunction *quot = find_function(mod, "quot");
+  size_t entries_before = stats.entries;
+  SUITE_ASSERT(!interpreter_run_function(env->interp, quot, quot_args, 2, &result), "10 / 0 should fail");
+  SUITE_ASSERT(!interpreter_run_function(env->interp, quot, quot_args, 2, &result), "10 / 0 should still fail");
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.entries == entries_before, "Failed calls must not be cached");
 
-  RuntimeValue err_result;
-  bool err_success = interpreter_run_function(env->interp, func_unlinked, NULL, 0, &err_result);
-  SUITE_ASSERT(!err_success, "Interpreter should have failed on unlinked FFI call");
+  /// 6. 容量有界: 8 项的表在 100 个不同参数下最多保留 8 个结果
+  SUITE_ASSERT(interpreter_set_memoization(env->interp, true, 8), "Failed to resize the memo table");
+  for (int i = 0; i < 100; i++)
+  {
+    rt_x.as.val_i32 = i;
+    SUITE_ASSERT(interpreter_run_function(env->interp, sq, sq_args, 1, &result), "@sq(%d) failed", i);
+    ASSERT_I32_RESULT(result, i * i);
+  }
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.capacity == 8 && stats.entries <= 8, "Table grew past its capacity (%zu)", stats.entries);
+  SUITE_ASSERT(stats.misses == 100 && stats.evictions == 100 - stats.entries, "Unexpected misses / evictions");
+
+#if CALICO_HAS_JIT
+  /// 机器码中的 'call' 同样经过备忘表
+  SUITE_ASSERT(interpreter_set_jit(env->interp, true), "Failed to enable JIT");
+  interpreter_set_jit_threshold(env->interp, 1);
+  rt_n.as.val_i64 = 70;
+  SUITE_ASSERT(interpreter_run_function(env->interp, find_function(mod, "fib"), fib_args, 1, &result),
+               "@fib (JIT) failed");
+  SUITE_ASSERT(result.as.val_i64 == 190392490709135LL, "@fib(70) = %lld", (long long)result.as.val_i64);
+  SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, find_function(mod, "fib")), "@fib should be compiled");
+  interpreter_set_jit(env->interp, false);
+#endif
+
+  /// 7. 使计划失效会丢弃缓存的结果；clear 同时清零统计
+  interpreter_invalidate_function(env->interp, sq);
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.entries == 0 && stats.misses > 0, "Invalidation should drop entries but keep stats");
+  interpreter_clear_memo(env->interp);
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.hits == 0 && stats.misses == 0 && stats.evictions == 0, "Clear should reset stats");
+
+  SUITE_ASSERT(interpreter_set_memoization(env->interp, false, 0), "Failed to disable memoization");
+  interpreter_get_memo_stats(env->interp, &stats);
+  SUITE_ASSERT(stats.capacity == 0, "Disabled memoization should report no capacity");
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 按位宽 (32 / 64) 计算整数二元运算的期望结果 (补码回绕，移位量按位宽取模)
+ */
+static int64_t
+reference_int_binary(const char *op, int bits, int64_t a, int64_t b)
+{
+  uint64_t mask = (bits == 32) ? 0xffffffffu : UINT64_MAX;
+  uint64_t ua = (uint64_t)a & mask;
+  uint64_t ub = (uint64_t)b & mask;
+  unsigned amt = (unsigned)(ub & (uint64_t)(bits - 1));
+  uint64_t r = 0;
+  if (strcmp(op, "add") == 0)
+    r = ua + ub;
+  else if (strcmp(op, "sub") == 0)
+    r = ua - ub;
+  else if (strcmp(op, "mul") == 0)
+    r = ua * ub;
+  else if (strcmp(op, "shl") == 0)
+    r = ua << amt;
+  else if (strcmp(op, "lshr") == 0)
+    r = ua >> amt;
+  else if (strcmp(op, "ashr") == 0)
+    r = (bits == 32) ? (uint64_t)(int64_t)((int32_t)ua >> amt) : (uint64_t)((int64_t)ua >> amt);
+  else if (strcmp(op, "and") == 0)
+    r = ua & ub;
+  else if (strcmp(op, "or") == 0)
+    r = ua | ub;
+  else
+    r = ua ^ ub;
+  r &= mask;
+  return (bits == 32) ? (int64_t)(int32_t)(uint32_t)r : (int64_t)r;
+}
+
+/**
+ * @brief 测试降级时按静态类型特化的指令 (选择与边界语义)
+ */
+int
+test_typed_opcodes()
+{
+  SUITE_START("Interpreter: Type-Specialized Opcodes");
+  TestEnv *env = setup_test_env();
+
+  static const char *const INT_OPS[] = {"add", "sub", "mul", "shl", "lshr", "ashr", "and", "or", "xor"};
+  static const char *const PREDS[] = {"eq", "ne", "ugt", "uge", "ult", "ule", "sgt", "sge", "slt", "sle"};
+  static const char *const FLOAT_OPS[] = {"fadd", "fsub", "fmul", "fdiv"};
+  enum
+  {
+    NUM_INT_OPS = sizeof(INT_OPS) / sizeof(INT_OPS[0]),
+    NUM_PREDS = sizeof(PREDS) / sizeof(PREDS[0]),
+    NUM_FLOAT_OPS = sizeof(FLOAT_OPS) / sizeof(FLOAT_OPS[0]),
+  };
+
+  /// 每个 (运算, 类型) 一个函数: %r = op %a, %b; ret %r
+  static char src[32768];
+  size_t len = 0;
+  for (int t = 0; t < 2; t++)
+  {
+    const char *ty = t ? "i64" : "i32";
+    for (int o = 0; o < NUM_INT_OPS; o++)
+      len += (size_t)snprintf(src + len, sizeof(src) - len,
+                              "define %s @%s_%s(%%a: %s, %%b: %s) {\n$entry:\n  %%r: %s = %s %%a: %s, %%b: %s\n"
+                              "  ret %%r: %s\n}\n\n",
+                              ty, INT_OPS[o], ty, ty, ty, ty, INT_OPS[o], ty, ty, ty);
+    for (int p = 0; p < NUM_PREDS; p++)
+      len += (size_t)snprintf(src + len, sizeof(src) - len,
+                              "define i1 @icmp_%s_%s(%%a: %s, %%b: %s) {\n$entry:\n"
+                              "  %%r: i1 = icmp %s %%a: %s, %%b: %s\n"
+                              "  ret %%r: i1\n}\n\n",
+                              PREDS[p], ty, ty, ty, PREDS[p], ty, ty);
+  }
+  for (int o = 0; o < NUM_FLOAT_OPS; o++)
+    len += (size_t)snprintf(src + len, sizeof(src) - len,
+                            "define f64 @%s_f64(%%a: f64, %%b: f64) {\n$entry:\n  %%r: f64 = %s %%a: f64, %%b: f64\n"
+                            "  ret %%r: f64\n}\n\n",
+                            FLOAT_OPS[o], FLOAT_OPS[o]);
+  SUITE_ASSERT(len < sizeof(src), "IR source buffer too small");
+
+  IRModule *mod = ir_parse_module(env->ctx, src);
+  SUITE_ASSERT(mod != NULL, "Failed to parse typed-op IR");
+
+  /// 1. 降级时选中特化的操作码
+  Bump *arena = bump_new();
+  static const uint32_t EXPECTED_I32[NUM_INT_OPS] = {EXEC_OP_ADD_I32, EXEC_OP_SUB_I32,  EXEC_OP_MUL_I32,
+                                                     EXEC_OP_SHL_I32, EXEC_OP_LSHR_I32, EXEC_OP_ASHR_I32,
+                                                     EXEC_OP_AND_I32, EXEC_OP_OR_I32,   EXEC_OP_XOR_I32};
+  char name[64];
+  for (int t = 0; t < 2; t++)
+  {
+    const char *ty = t ? "i64" : "i32";
+    for (int o = 0; o < NUM_INT_OPS; o++)
+    {
+      snprintf(name, sizeof(name), "%s_%s", INT_OPS[o], ty);
+      ExecPlan *plan = exec_plan_build(find_function(mod, name), arena, true);
+      SUITE_ASSERT(plan != NULL, "Failed to lower @%s", name);
+      /// 每种运算的 I64 变体紧跟在 I32 变体之后
+      SUITE_ASSERT(plan->insts[0].opcode == EXPECTED_I32[o] + (uint32_t)t, "@%s was not specialized", name);
+    }
+    snprintf(name, sizeof(name), "icmp_slt_%s", ty);
+    ExecPlan *cmp_plan = exec_plan_build(find_function(mod, name), arena, true);
+    SUITE_ASSERT(cmp_plan && cmp_plan->insts[0].opcode == (t ? EXEC_OP_ICMP_I64 : EXEC_OP_ICMP_I32),
+                 "@%s was not specialized", name);
+  }
+  ExecPlan *fadd_plan = exec_plan_build(find_function(mod, "fadd_f64"), arena, true);
+  SUITE_ASSERT(fadd_plan && fadd_plan->insts[0].opcode == EXEC_OP_FADD_F64, "@fadd_f64 was not specialized");
+  bump_free(arena);
+
+  /// 2. 边界语义与通用路径一致 (回绕、超过位宽的移位、负数的逻辑 / 算术右移)
+  static const int64_t VALUES[] = {0, 1, -1, 7, 33, 65, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN, 0x123456789abcLL};
+  enum
+  {
+    NUM_VALUES = sizeof(VALUES) / sizeof(VALUES[0])
+  };
+  RuntimeValue rt_a, rt_b, result;
+  RuntimeValue *args[] = {&rt_a, &rt_b};
+  int mismatches = 0;
+  for (int e = 0; e < 2; e++)
+  {
+    if (!interpreter_set_engine(env->interp, e ? INTERP_ENGINE_THREADED : INTERP_ENGINE_SWITCH))
+      continue;
+    for (int t = 0; t < 2; t++)
+    {
+      int bits = t ? 64 : 32;
+      const char *ty = t ? "i64" : "i32";
+      for (int i = 0; i < NUM_VALUES; i++)
+      {
+        for (int j = 0; j < NUM_VALUES; j++)
+        {
+          rt_a.kind = rt_b.kind = t ? RUNTIME_VAL_I64 : RUNTIME_VAL_I32;
+          rt_a.as.val_i64 = rt_b.as.val_i64 = 0;
+          if (t)
+          {
+            rt_a.as.val_i64 = VALUES[i];
+            rt_b.as.val_i64 = VALUES[j];
+          }
+          else
+          {
+            rt_a.as.val_i32 = (int32_t)VALUES[i];
+            rt_b.as.val_i32 = (int32_t)VALUES[j];
+          }
+          int64_t a = t ? rt_a.as.val_i64 : rt_a.as.val_i32;
+          int64_t b = t ? rt_b.as.val_i64 : rt_b.as.val_i32;
+
+          for (int o = 0; o < NUM_INT_OPS; o++)
+          {
+            snprintf(name, sizeof(name), "%s_%s", INT_OPS[o], ty);
+            if (!interpreter_run_function(env->interp, find_function(mod, name), args, 2, &result))
+            {
+              mismatches++;
+              continue;
+            }
+            int64_t got = t ? result.as.val_i64 : result.as.val_i32;
+            if (result.kind != rt_a.kind || got != reference_int_binary(INT_OPS[o], bits, a, b))
+              mismatches++;
+          }
+
+          uint64_t ua = t ? (uint64_t)a : (uint32_t)a;
+          uint64_t ub = t ? (uint64_t)b : (uint32_t)b;
+          const bool expected_cmp[NUM_PREDS] = {a == b, a != b, ua > ub, ua >= ub, ua < ub,
+                                                ua <= ub, a > b,  a >= b, a < b,   a <= b};
+          for (int p = 0; p < NUM_PREDS; p++)
+          {
+            snprintf(name, sizeof(name), "icmp_%s_%s", PREDS[p], ty);
+            if (!interpreter_run_function(env->interp, find_function(mod, name), args, 2, &result) ||
+                result.kind != RUNTIME_VAL_I1 || result.as.val_i1 != expected_cmp[p])
+              mismatches++;
+          }
+        }
+      }
+    }
+  }
+  SUITE_ASSERT(mismatches == 0, "%d integer results differ from the reference", mismatches);
+
+  rt_a.kind = rt_b.kind = RUNTIME_VAL_F64;
+  rt_a.as.val_f64 = 7.5;
+  rt_b.as.val_f64 = -2.0;
+  const double expected_f64[NUM_FLOAT_OPS] = {5.5, 9.5, -15.0, -3.75};
+  for (int o = 0; o < NUM_FLOAT_OPS; o++)
+  {
+    snprintf(name, sizeof(name), "%s_f64", FLOAT_OPS[o]);
+    SUITE_ASSERT(interpreter_run_function(env->interp, find_function(mod, name), args, 2, &result), "@%s failed",
+                 name);
+    SUITE_ASSERT(result.kind == RUNTIME_VAL_F64 && result.as.val_f64 == expected_f64[o], "@%s = %f", name,
+                 result.as.val_f64);
+  }
+  rt_b.as.val_f64 = 0.0;
+  SUITE_ASSERT(!interpreter_run_function(env->interp, find_function(mod, "fdiv_f64"), args, 2, &result),
+               "f64 division by zero should fail");
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 测试帧内存有界: 长循环 (含调用) 只占用固定大小的帧，alloca 位于帧内固定的位置
+ */
+int
+test_bounded_frame_memory()
+{
+  SUITE_START("Interpreter: Bounded Frame Memory");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"frames\"\n"
+                                            "\n"
+                                            "define i64 @scratch(%x: i64) {\n"
+                                            "$entry:\n"
+                                            "  %buf: <[4 x i64]> = alloc [4 x i64]\n"
+                                            "  %slot: <i64> = gep %buf: <[4 x i64]>, 0: i32, 3: i32\n"
+                                            "  store %x: i64, %slot: <i64>\n"
+                                            "  %v: i64 = load %slot: <i64>\n"
+                                            "  ret %v: i64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i64 @loop_alloca(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %i_ptr: <i32> = alloc i32\n"
+                                            "  %acc_ptr: <i64> = alloc i64\n"
+                                            "  %other: <i64> = alloc i64\n"
+                                            "  store 0: i32, %i_ptr: <i32>\n"
+                                            "  store 0: i64, %acc_ptr: <i64>\n"
+                                            "  br $loop\n"
+                                            "$loop:\n"
+                                            "  %i: i32 = load %i_ptr: <i32>\n"
+                                            "  %wide: i64 = sext %i: i32 to i64\n"
+                                            "  %v: i64 = call <i64 (i64)> @scratch(%wide: i64)\n"
+                                            "  store 1: i64, %other: <i64>\n"
+                                            "  %w: i64 = load %other: <i64>\n"
+                                            "  %vw: i64 = add %v: i64, %w: i64\n"
+                                            "  %acc: i64 = load %acc_ptr: <i64>\n"
+                                            "  %acc_next: i64 = add %acc: i64, %vw: i64\n"
+                                            "  store %acc_next: i64, %acc_ptr: <i64>\n"
+                                            "  %i_next: i32 = add %i: i32, 1: i32\n"
+                                            "  store %i_next: i32, %i_ptr: <i32>\n"
+                                            "  %cmp: i1 = icmp slt %i_next: i32, %n: i32\n"
+                                            "  br %cmp: i1, $loop, $exit\n"
+                                            "$exit:\n"
+                                            "  %r: i64 = load %acc_ptr: <i64>\n"
+                                            "  ret %r: i64\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i32 @depth(%n: i32) {\n"
+                                            "$entry:\n"
+                                            "  %local: <i32> = alloc i32\n"
+                                            "  store %n: i32, %local: <i32>\n"
+                                            "  %done: i1 = icmp eq %n: i32, 0: i32\n"
+                                            "  br %done: i1, $base, $rec\n"
+                                            "$base:\n"
+                                            "  ret 0: i32\n"
+                                            "$rec:\n"
+                                            "  %n1: i32 = sub %n: i32, 1: i32\n"
+                                            "  %inner: i32 = call <i32 (i32)> @depth(%n1: i32)\n"
+                                            "  %mine: i32 = load %local: <i32>\n"
+                                            "  %r: i32 = add %inner: i32, %mine: i32\n"
+                                            "  ret %r: i32\n"
+                                            "}\n"
+                                            "\n"
+                                            "define i64 @mixed(%x: i64) {\n"
+                                            "$entry:\n"
+                                            "  %a: <i8> = alloc i8\n"
+                                            "  %b: <i64> = alloc i64\n"
+                                            "  %c: <i8> = alloc i8\n"
+                                            "  %d: <i32> = alloc i32\n"
+                                            "  %e: <i16> = alloc i16\n"
+                                            "  %f: <i64> = alloc i64\n"
+                                            "  store 1: i8, %a: <i8>\n"
+                                            "  store %x: i64, %b: <i64>\n"
+                                            "  store 3: i8, %c: <i8>\n"
+                                            "  store 40: i32, %d: <i32>\n"
+                                            "  store 500: i16, %e: <i16>\n"
+                                            "  store 6000: i64, %f: <i64>\n"
+                                            "  %va: i8 = load %a: <i8>\n"
+                                            "  %vc: i8 = load %c: <i8>\n"
+                                            "  %vd: i32 = load %d: <i32>\n"
+                                            "  %ve: i16 = load %e: <i16>\n"
+                                            "  %wa: i64 = zext %va: i8 to i64\n"
+                                            "  %wc: i64 = zext %vc: i8 to i64\n"
+                                            "  %wd: i64 = zext %vd: i32 to i64\n"
+                                            "  %we: i64 = zext %ve: i16 to i64\n"
+                                            "  %vb: i64 = load %b: <i64>\n"
+                                            "  %vf: i64 = load %f: <i64>\n"
+                                            "  %s1: i64 = add %wa: i64, %vb: i64\n"
+                                            "  %s2: i64 = add %s1: i64, %wc: i64\n"
+                                            "  %s3: i64 = add %s2: i64, %wd: i64\n"
+                                            "  %s4: i64 = add %s3: i64, %we: i64\n"
+                                            "  %s5: i64 = add %s4: i64, %vf: i64\n"
+                                            "  ret %s5: i64\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse frame IR");
+  IRFunction *loop_alloca = find_function(mod, "loop_alloca");
+  IRFunction *depth = find_function(mod, "depth");
+
+  /// 1. 10^6 次迭代，每次调用一个带 alloca 的函数: 在 4 KiB 的栈上也不会溢出
+  RuntimeValue rt_n;
+  rt_n.kind = RUNTIME_VAL_I32;
+  rt_n.as.val_i32 = 1000000;
+  RuntimeValue *args[] = {&rt_n};
+  InterpreterExecution *exec = interpreter_execution_start(env->interp, loop_alloca, args, 1, 4096);
+  SUITE_ASSERT(exec != NULL, "Failed to start the execution");
+  ExecutionResultKind status = interpreter_execution_step(exec, UINT64_MAX);
+  SUITE_ASSERT(status == EXEC_OK, "Loop with alloca failed (status %d: %s)", status,
+               exec->ctx.error_message ? exec->ctx.error_message : "");
+  SUITE_ASSERT(exec->result.kind == RUNTIME_VAL_I64, "Wrong result kind");
+  SUITE_ASSERT(exec->result.as.val_i64 == 999999LL * 1000000 / 2 + 1000000, "Wrong sum %lld",
+               (long long)exec->result.as.val_i64);
+  interpreter_execution_destroy(exec);
+
+  /// 2. 同一帧中的不同 alloca 不重叠，递归的每一层有自己的 alloca 区
+  RuntimeValue result;
+  rt_n.as.val_i32 = 100;
+  SUITE_ASSERT(interpreter_run_function(env->interp, loop_alloca, args, 1, &result), "@loop_alloca(100) failed");
+  SUITE_ASSERT(result.as.val_i64 == 99 * 100 / 2 + 100, "Allocas in one frame overlap (%lld)",
+               (long long)result.as.val_i64);
+  SUITE_ASSERT(interpreter_run_function(env->interp, depth, args, 1, &result), "@depth(100) failed");
+  ASSERT_I32_RESULT(result, 100 * 101 / 2);
+
+  /// 3. 关闭融合后结果相同
+  interpreter_set_fusion(env->interp, false);
+  SUITE_ASSERT(interpreter_run_function(env->interp, loop_alloca, args, 1, &result), "@loop_alloca failed (no fusion)");
+  SUITE_ASSERT(result.as.val_i64 == 99 * 100 / 2 + 100, "Wrong result without fusion");
+
+  /// 4. 不同对齐的 alloca 按对齐从大到小摆放: 各自对齐、互不重叠，且 alloca 区没有填充
+  IRFunction *mixed = find_function(mod, "mixed");
+  RuntimeValue rt_x;
+  rt_x.kind = RUNTIME_VAL_I64;
+  rt_x.as.val_i64 = 20;
+  RuntimeValue *mixed_args[] = {&rt_x};
+  SUITE_ASSERT(interpreter_run_function(env->interp, mixed, mixed_args, 1, &result), "@mixed failed");
+  SUITE_ASSERT(result.kind == RUNTIME_VAL_I64 && result.as.val_i64 == 6564, "Mixed allocas overlap (%lld)",
+               (long long)result.as.val_i64);
+  ExecPlan *plan = ptr_hashmap_get(env->interp->plan_cache, mixed);
+  SUITE_ASSERT(plan != NULL, "@mixed has no plan");
+  SUITE_ASSERT(plan->alloca_size == 8 + 8 + 4 + 2 + 1 + 1, "Frame has padding (%zu bytes)", plan->alloca_size);
+  SUITE_ASSERT(plan->alloca_align == 8, "Wrong frame alignment %zu", plan->alloca_align);
+  uint64_t used = 0;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_ALLOCA)
+      continue;
+    size_t size = datalayout_get_type_size(env->dl, ei->ir->result.type->as.pointee_type);
+    SUITE_ASSERT(ei->aux % size == 0, "Alloca at offset %u is misaligned", ei->aux);
+    uint64_t bits = ((1ULL << size) - 1) << ei->aux;
+    SUITE_ASSERT((used & bits) == 0, "Alloca at offset %u overlaps another", ei->aux);
+    used |= bits;
+  }
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief 帧布局: alloca 的固定位置按对齐从大到小摆放，检查每个 alloca 的偏移和帧大小
+ */
+int
+test_packed_frame_layout()
+{
+  SUITE_START("Interpreter: Packed Frame Layout");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"packed\"\n"
+                                            "\n"
+                                            "%small = type { i32, i8 }\n"
+                                            "%big = type { i64, i8 }\n"
+                                            "\n"
+                                            "define i64 @locals(%x: i64) {\n"
+                                            "$entry:\n"
+                                            "  %a: <i8> = alloc i8\n"
+                                            "  %s: <%small> = alloc %small\n"
+                                            "  %b: <i64> = alloc i64\n"
+                                            "  %c: <i32> = alloc i32\n"
+                                            "  %arr: <[3 x i16]> = alloc [3 x i16]\n"
+                                            "  %d: <i8> = alloc i8\n"
+                                            "  %t: <%big> = alloc %big\n"
+                                            "  %s1: <i8> = gep %s: <%small>, 0: i32, 1: i32\n"
+                                            "  %t1: <i8> = gep %t: <%big>, 0: i32, 1: i32\n"
+                                            "  %arr2: <i16> = gep %arr: <[3 x i16]>, 0: i32, 2: i32\n"
+                                            "  store 1: i8, %a: <i8>\n"
+                                            "  store 2: i8, %s1: <i8>\n"
+                                            "  store %x: i64, %b: <i64>\n"
+                                            "  store 40: i32, %c: <i32>\n"
+                                            "  store 500: i16, %arr2: <i16>\n"
+                                            "  store 6: i8, %d: <i8>\n"
+                                            "  store 70: i8, %t1: <i8>\n"
+                                            "  %va: i8 = load %a: <i8>\n"
+                                            "  %vs: i8 = load %s1: <i8>\n"
+                                            "  %vb: i64 = load %b: <i64>\n"
+                                            "  %vc: i32 = load %c: <i32>\n"
+                                            "  %varr: i16 = load %arr2: <i16>\n"
+                                            "  %vd: i8 = load %d: <i8>\n"
+                                            "  %vt: i8 = load %t1: <i8>\n"
+                                            "  %wa: i64 = zext %va: i8 to i64\n"
+                                            "  %ws: i64 = zext %vs: i8 to i64\n"
+                                            "  %wc: i64 = zext %vc: i32 to i64\n"
+                                            "  %warr: i64 = zext %varr: i16 to i64\n"
+                                            "  %wd: i64 = zext %vd: i8 to i64\n"
+                                            "  %wt: i64 = zext %vt: i8 to i64\n"
+                                            "  %r1: i64 = add %wa: i64, %ws: i64\n"
+                                            "  %r2: i64 = add %r1: i64, %vb: i64\n"
+                                            "  %r3: i64 = add %r2: i64, %wc: i64\n"
+                                            "  %r4: i64 = add %r3: i64, %warr: i64\n"
+                                            "  %r5: i64 = add %r4: i64, %wd: i64\n"
+                                            "  %r6: i64 = add %r5: i64, %wt: i64\n"
+                                            "  ret %r6: i64\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse frame IR");
+  IRFunction *locals = find_function(mod, "locals");
+
+  RuntimeValue rt_x = {.kind = RUNTIME_VAL_I64, .as.val_i64 = 10000};
+  RuntimeValue *args[] = {&rt_x};
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(env->interp, locals, args, 1, &result), "@locals failed");
+  SUITE_ASSERT(result.kind == RUNTIME_VAL_I64 && result.as.val_i64 == 10619, "Frame slots overlap (%lld)",
+               (long long)result.as.val_i64);
+
+  /// 对齐 8: %b, %t；对齐 4: %s, %c；对齐 2: %arr；对齐 1: %a, %d (同一对齐内保持 IR 顺序)
+  static const struct
+  {
+    const char *name;
+    uint32_t offset;
+  } expected[] = {{"b", 0}, {"t", 8}, {"s", 24}, {"c", 32}, {"arr", 36}, {"a", 42}, {"d", 43}};
+  const size_t num_expected = sizeof(expected) / sizeof(expected[0]);
+  ExecPlan *plan = ptr_hashmap_get(env->interp->plan_cache, locals);
+  SUITE_ASSERT(plan != NULL, "@locals has no plan");
+  size_t num_allocas = 0;
+  for (uint32_t i = 0; i < plan->num_insts; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_ALLOCA)
+      continue;
+    num_allocas++;
+    const char *name = ei->ir->result.name;
+    size_t k = 0;
+    while (k < num_expected && strcmp(expected[k].name, name) != 0)
+      k++;
+    SUITE_ASSERT(k < num_expected, "Unexpected alloca %%%s", name);
+    SUITE_ASSERT(ei->aux == expected[k].offset, "%%%s should be at offset %u, got %u", name, expected[k].offset,
+                 ei->aux);
+  }
+  SUITE_ASSERT(num_allocas == num_expected, "Expected %zu allocas, found %zu", num_expected, num_allocas);
+  /// 按 IR 顺序摆放需要 56 字节 (%s、%b、%t 之前各有填充)
+  SUITE_ASSERT(plan->alloca_size == 44, "The packed frame should be 44 bytes, got %zu", plan->alloca_size);
+  SUITE_ASSERT(plan->alloca_align == 8, "Wrong frame alignment %zu", plan->alloca_align);
+
+  teardown_test_env(env);
+  SUITE_END();
+}
+
+/**
+ * @brief gep 在构建计划时解析为 常量偏移 + 变量下标 * 元素大小 (结构体数组、混合下标、负下标)
+ */
+int
+test_gep_offsets()
+{
+  SUITE_START("Interpreter: Resolved GEP Offsets");
+  TestEnv *env = setup_test_env();
+
+  IRModule *mod = ir_parse_module(env->ctx, "module = \"gep\"\n"
+                                            "\n"
+                                            "%pt = type { i8, f64, [3 x i32] }\n"
+                                            "\n"
+                                            "define i32 @aos(%i: i32, %j: i32) {\n"
+                                            "$entry:\n"
+                                            "  %buf: <[8 x %pt]> = alloc [8 x %pt]\n"
+                                            "  %c: <i32> = gep %buf: <[8 x %pt]>, 0: i32, 5: i32, 2: i32, 1: i32\n"
+                                            "  store 7: i32, %c: <i32>\n"
+                                            "  %m: <i32> = gep %buf: <[8 x %pt]>, 0: i32, %i: i32, 2: i32, %j: i32\n"
+                                            "  store 100: i32, %m: <i32>\n"
+                                            "  %row: <%pt> = gep %buf: <[8 x %pt]>, 0: i32, 6: i32\n"
+                                            "  %prev: <%pt> = gep %row: <%pt>, -1: i32\n"
+                                            "  %a: i32 = load %c: <i32>\n"
+                                            "  %back: <i32> = gep %prev: <%pt>, 0: i32, 2: i32, 1: i32\n"
+                                            "  %b: i32 = load %back: <i32>\n"
+                                            "  %s: i32 = add %a: i32, %b: i32\n"
+                                            "  ret %s: i32\n"
+                                            "}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse GEP IR");
+  IRFunction *aos = find_function(mod, "aos");
+
+  RuntimeValue rt_i = {.kind = RUNTIME_VAL_I32};
+  RuntimeValue rt_j = {.kind = RUNTIME_VAL_I32};
+  RuntimeValue *args[] = {&rt_i, &rt_j};
+  RuntimeValue result;
+  for (int fusion = 1; fusion >= 0; fusion--)
+  {
+    interpreter_set_fusion(env->interp, fusion != 0);
+    /// 1. 变量下标指向常量下标的同一个元素: 两次 load 都读到 100
+    rt_i.as.val_i32 = 5;
+    rt_j.as.val_i32 = 1;
+    SUITE_ASSERT(interpreter_run_function(env->interp, aos, args, 2, &result), "@aos(5, 1) failed");
+    ASSERT_I32_RESULT(result, 200);
+    /// 2. 指向别处: 常量下标和负下标读到 7
+    rt_i.as.val_i32 = 2;
+    rt_j.as.val_i32 = 0;
+    SUITE_ASSERT(interpreter_run_function(env->interp, aos, args, 2, &result), "@aos(2, 0) failed");
+    ASSERT_I32_RESULT(result, 14);
+  }
+
+  /// 3. 计划中的每条 gep 都已解析: 常量下标只剩偏移，变量下标各是一项
+  ExecPlan *plan = ptr_hashmap_get(env->interp->plan_cache, aos);
+  SUITE_ASSERT(plan != NULL && plan->num_geps == 5, "Expected 5 resolved geps");
+  IRType *pt = NULL;
+  const ExecGep *geps[5];
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < plan->num_insts && n < 5; i++)
+  {
+    ExecInst *ei = &plan->insts[i];
+    if (ei->ir->opcode != IR_OP_GEP)
+      continue;
+    SUITE_ASSERT(ei->aux != EXEC_INVALID_INDEX, "gep #%u was not resolved", n);
+    geps[n++] = &plan->geps[ei->aux];
+    if (!pt)
+      pt = ei->ir->as.gep.source_type->as.array.element_type;
+  }
+  size_t pt_size = datalayout_get_type_size(env->dl, pt);
+  size_t field = datalayout_get_struct_member_offset(env->dl, pt, 2);
+  SUITE_ASSERT(geps[0]->num_terms == 0 && geps[0]->offset == (int64_t)(5 * pt_size + field + 4),
+               "Constant gep should fold to one offset");
+  SUITE_ASSERT(geps[1]->num_terms == 2 && geps[1]->offset == (int64_t)field, "Mixed gep should keep two terms");
+  SUITE_ASSERT(geps[1]->terms[0].scale == pt_size && geps[1]->terms[1].scale == 4, "Wrong scales for mixed gep");
+  SUITE_ASSERT(geps[3]->num_terms == 0 && geps[3]->offset == -(int64_t)pt_size, "Negative index should fold");
+
+  /// 4. JIT 直接使用同一份解析结果
+  if (interpreter_set_jit(env->interp, true))
+  {
+    interpreter_set_jit_threshold(env->interp, 0);
+    rt_i.as.val_i32 = 5;
+    rt_j.as.val_i32 = 1;
+    SUITE_ASSERT(interpreter_run_function(env->interp, aos, args, 2, &result), "JIT @aos(5, 1) failed");
+    ASSERT_I32_RESULT(result, 200);
+    SUITE_ASSERT(interpreter_is_jit_compiled(env->interp, aos), "@aos should have been compiled");
+    rt_i.as.val_i32 = 2;
+    rt_j.as.val_i32 = 0;
+    SUITE_ASSERT(interpreter_run_function(env->interp, aos, args, 2, &result), "JIT @aos(2, 0) failed");
+    ASSERT_I32_RESULT(result, 14);
+  }
 
   teardown_test_env(env);
   SUITE_END();
@@ -353,12 +2913,120 @@ main()
     __calir_total_suites_failed++;
   }
 
+  __calir_total_suites_run++;
+  if (test_loop_phi_swap() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_plan_cache_invalidation() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
   __calir_total_suites_run++;
   if (test_ffi_and_errors() != 0)
   {
     __calir_total_suites_failed++;
   }
 
+  __calir_total_suites_run++;
+  if (test_call_stack() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_superinstructions() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_switch_lowering() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_profiler() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_concurrent_workers() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_batch_execution() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_batch_kernel_dispatch() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_jit_tier() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_resumable_execution() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_linked_ffi() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_global_image() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_memoization() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_typed_opcodes() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_bounded_frame_memory() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_packed_frame_layout() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_gep_offsets() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
   __calir_total_suites_run++;
   if (test_golden_ir_execution() != 0)
   {
@@ -0,0 +1,429 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir/binary.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+
+/// 覆盖全局变量、switch、浮点、类型转换和 select
+static const char *MIXED_IR_TEXT = "module = \"mixed\"\n"
+                                   "\n"
+                                   "@g_count: <i32> = global -7: i32\n"
+                                   "@g_scale: <f64> = global 2.5: f64\n"
+                                   "@g_table: <[4 x i32]> = global zeroinitializer\n"
+                                   "\n"
+                                   "define f64 @shade(%x: f64, %k: i32) {\n"
+                                   "$entry:\n"
+                                   "  %kk: i32 = and %k: i32, 3: i32\n"
+                                   "  switch %kk: i32, default $other [\n"
+                                   "    0: i32, $square\n"
+                                   "    1: i32, $round\n"
+                                   "  ]\n"
+                                   "$square:\n"
+                                   "  %scale: f64 = load @g_scale: <f64>\n"
+                                   "  %sq: f64 = fmul %x: f64, %scale: f64\n"
+                                   "  ret %sq: f64\n"
+                                   "$round:\n"
+                                   "  %xf: f32 = fptrunc %x: f64 to f32\n"
+                                   "  %ext: f64 = fpext %xf: f32 to f64\n"
+                                   "  ret %ext: f64\n"
+                                   "$other:\n"
+                                   "  %cnt: i32 = load @g_count: <i32>\n"
+                                   "  %slot: <i32> = gep inbounds @g_table: <[4 x i32]>, 0: i32, %kk: i32\n"
+                                   "  store %cnt: i32, %slot: <i32>\n"
+                                   "  %kf: f64 = sitofp %k: i32 to f64\n"
+                                   "  %lt: i1 = fcmp olt %x: f64, %kf: f64\n"
+                                   "  %pick: f64 = select %lt: i1, %kf: f64, %x: f64\n"
+                                   "  ret %pick: f64\n"
+                                   "}\n";
+
+/**
+ * @brief [内部] 用 builder 构建一个循环：phi 的入边引用后面才定义的值
+ * (文本格式不支持前向引用，二进制格式必须支持)
+ */
+static IRModule *
+build_loop_module(IRContext *ctx)
+{
+  IRModule *mod = ir_module_create(ctx, "loop");
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRFunction *func = ir_function_create(mod, "sum", i32);
+  IRArgument *n = ir_argument_create(func, i32, "n");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *entry = ir_basic_block_create(func, "entry");
+  IRBasicBlock *header = ir_basic_block_create(func, "header");
+  IRBasicBlock *body = ir_basic_block_create(func, "body");
+  IRBasicBlock *exit = ir_basic_block_create(func, "exit");
+  ir_function_append_basic_block(func, entry);
+  ir_function_append_basic_block(func, header);
+  ir_function_append_basic_block(func, body);
+  ir_function_append_basic_block(func, exit);
+
+  IRBuilder *b = ir_builder_create(ctx);
+  ir_builder_set_insertion_point(b, entry);
+  ir_builder_create_br(b, &header->label_address);
+
+  ir_builder_set_insertion_point(b, header);
+  IRValueNode *acc = ir_builder_create_phi(b, i32, "acc");
+  IRValueNode *i = ir_builder_create_phi(b, i32, "i");
+  IRValueNode *done = ir_builder_create_icmp(b, IR_ICMP_SGE, i, &n->value, "done");
+  ir_builder_create_cond_br(b, done, &exit->label_address, &body->label_address);
+
+  ir_builder_set_insertion_point(b, body);
+  IRValueNode *acc2 = ir_builder_create_add(b, acc, i, "acc2");
+  IRValueNode *next = ir_builder_create_add(b, i, ir_constant_get_i32(ctx, 1), "next");
+  ir_builder_create_br(b, &header->label_address);
+
+  ir_phi_add_incoming(i, ir_constant_get_i32(ctx, 0), entry);
+  ir_phi_add_incoming(i, next, body);
+  ir_phi_add_incoming(acc, ir_constant_get_i32(ctx, 0), entry);
+  ir_phi_add_incoming(acc, acc2, body);
+
+  ir_builder_set_insertion_point(b, exit);
+  ir_builder_create_ret(b, acc);
+  ir_builder_destroy(b);
+
+  return mod;
+}
+
+/**
+ * @brief [内部] 编码 -> 在新的上下文中解码 -> 打印，与原模块的打印结果比较
+ */
+static bool
+binary_round_trip_matches(IRModule *mod, Bump *arena)
+{
+  size_t size = 0;
+  const uint8_t *data = ir_binary_write_module(mod, arena, &size);
+  if (!data)
+    return false;
+
+  const char *expected = ir_module_dump_to_string(mod, arena);
+
+  IRContext *fresh = ir_context_create();
+  IRModule *decoded = ir_binary_read_module(fresh, data, size);
+  bool same = decoded && strcmp(ir_module_dump_to_string(decoded, arena), expected) == 0;
+  if (decoded && !same)
+  {
+    printf("--- Expected ---\n%s\n--- Decoded ---\n%s\n", expected, ir_module_dump_to_string(decoded, arena));
+  }
+  ir_context_destroy(fresh);
+  return same;
+}
+
+/**
+ * @brief 黄金 IR 和混合 IR 的往返都必须逐字节保持打印结果
+ */
+int
+test_binary_round_trip()
+{
+  SUITE_START("Binary IR: Round-Trip");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  IRModule *golden = ir_parse_module(ctx, get_golden_ir_text());
+  SUITE_ASSERT(golden != NULL, "Failed to parse the golden IR");
+  if (golden)
+  {
+    SUITE_ASSERT(binary_round_trip_matches(golden, &arena), "Golden IR did not survive the binary round-trip");
+
+    /// 同一个上下文里解码：已有的同名结构体必须被复用
+    size_t size = 0;
+    const uint8_t *data = ir_binary_write_module(golden, &arena, &size);
+    IRModule *again = data ? ir_binary_read_module(ctx, data, size) : NULL;
+    SUITE_ASSERT(again != NULL, "Decoding into the source context failed");
+    if (again)
+    {
+      SUITE_ASSERT(strcmp(ir_module_dump_to_string(again, &arena), get_golden_ir_text()) == 0,
+                   "Decoding into the source context changed the module");
+    }
+  }
+
+  IRModule *mixed = ir_parse_module(ctx, MIXED_IR_TEXT);
+  SUITE_ASSERT(mixed != NULL, "Failed to parse the mixed IR");
+  if (mixed)
+  {
+    SUITE_ASSERT(binary_round_trip_matches(mixed, &arena), "Mixed IR did not survive the binary round-trip");
+  }
+
+  SUITE_ASSERT(binary_round_trip_matches(build_loop_module(ctx), &arena),
+               "Forward references did not survive the binary round-trip");
+
+  /// 通过 builder 构建的模块 (未命名的指令使用自动编号的名字)
+  IRBuilder *builder = ir_builder_create(ctx);
+  IRModule *built = build_golden_ir(ctx, builder);
+  SUITE_ASSERT(built != NULL && binary_round_trip_matches(built, &arena),
+               "Builder-made module did not survive the binary round-trip");
+  ir_builder_destroy(builder);
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 文件接口：写出到临时文件再映射读回
+ */
+int
+test_binary_file()
+{
+  SUITE_START("Binary IR: Files");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  IRModule *mod = ir_parse_module(ctx, MIXED_IR_TEXT);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the mixed IR");
+
+  char path[] = "build/test_ir_binary.cirb";
+  FILE *out = fopen(path, "wb");
+  SUITE_ASSERT(out != NULL, "Cannot create '%s'", path);
+  if (out && mod)
+  {
+    SUITE_ASSERT(ir_binary_write_module_file(mod, out), "ir_binary_write_module_file() failed");
+    fclose(out);
+
+    IRContext *fresh = ir_context_create();
+    IRModule *loaded = ir_binary_read_module_file(fresh, path);
+    SUITE_ASSERT(loaded != NULL, "ir_binary_read_module_file() failed");
+    if (loaded)
+    {
+      SUITE_ASSERT(strcmp(ir_module_dump_to_string(loaded, &arena), ir_module_dump_to_string(mod, &arena)) == 0,
+                   "The module loaded from disk differs from the original");
+    }
+    ir_context_destroy(fresh);
+    remove(path);
+  }
+  else if (out)
+  {
+    fclose(out);
+  }
+
+  SUITE_ASSERT(ir_binary_read_module_file(ctx, "/nonexistent/dir/missing.cirb") == NULL,
+               "A missing file should return NULL");
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 损坏的输入：截断、错误的魔数/版本、逐字节翻转都不能崩溃；
+ * 引用了其他模块的值的模块不能被编码
+ */
+int
+test_binary_malformed()
+{
+  SUITE_START("Binary IR: Malformed Input");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  IRModule *mod = ir_parse_module(ctx, MIXED_IR_TEXT);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the mixed IR");
+
+  size_t size = 0;
+  const uint8_t *data = mod ? ir_binary_write_module(mod, &arena, &size) : NULL;
+  SUITE_ASSERT(data != NULL, "Encoding the mixed IR failed");
+
+  if (data)
+  {
+    printf("  (Truncating a %zu-byte encoding at every length...)\n", size);
+    size_t accepted = 0;
+    for (size_t len = 0; len < size; len++)
+    {
+      if (ir_binary_read_module(ctx, data, len) != NULL)
+        accepted++;
+    }
+    SUITE_ASSERT(accepted == 0, "%zu truncated inputs were accepted", accepted);
+
+    uint8_t *copy = malloc(size);
+    memcpy(copy, data, size);
+
+    copy[0] = 'X';
+    SUITE_ASSERT(ir_binary_read_module(ctx, copy, size) == NULL, "A bad magic should be rejected");
+    copy[0] = data[0];
+
+    copy[4] = IR_BINARY_VERSION + 1;
+    SUITE_ASSERT(ir_binary_read_module(ctx, copy, size) == NULL, "A newer version should be rejected");
+    copy[4] = data[4];
+
+    /// 翻转每个字节：结果可能碰巧仍然合法，但绝不能崩溃或触发断言
+    printf("  (Flipping every byte of the encoding...)\n");
+    for (size_t i = 0; i < size; i++)
+    {
+      copy[i] ^= 0xff;
+      ir_binary_read_module(ctx, copy, size);
+      copy[i] = data[i];
+    }
+    free(copy);
+  }
+
+  /// 调用了另一个模块中的函数：无法用下标引用，编码必须失败
+  IRModule *other = ir_parse_module(ctx, "module = \"other\"\n"
+                                         "\n"
+                                         "define i32 @callee() {\n"
+                                         "$entry:\n"
+                                         "  ret 1: i32\n"
+                                         "}\n");
+  SUITE_ASSERT(other != NULL, "Failed to parse the helper module");
+  if (other)
+  {
+    IRFunction *callee = list_entry(other->functions.next, IRFunction, list_node);
+    IRModule *caller_mod = ir_module_create(ctx, "caller");
+    IRFunction *caller = ir_function_create(caller_mod, "caller", ir_type_get_i32(ctx));
+    ir_function_finalize_signature(caller, false);
+    IRBasicBlock *entry = ir_basic_block_create(caller, "entry");
+    ir_function_append_basic_block(caller, entry);
+
+    IRBuilder *builder = ir_builder_create(ctx);
+    ir_builder_set_insertion_point(builder, entry);
+    IRValueNode *res = ir_builder_create_call(builder, &callee->entry_address, NULL, 0, "res");
+    ir_builder_create_ret(builder, res);
+    ir_builder_destroy(builder);
+
+    size_t foreign_size = 0;
+    SUITE_ASSERT(ir_binary_write_module(caller_mod, &arena, &foreign_size) == NULL,
+                 "A call into another module should fail to encode");
+  }
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 延迟加载：函数体在物化时才解码，结果与立即加载相同；损坏的函数体在物化时报告
+ */
+int
+test_binary_lazy()
+{
+  SUITE_START("Binary IR: Lazy Loading");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  IRModule *mod = ir_parse_module(ctx, get_golden_ir_text());
+  SUITE_ASSERT(mod != NULL, "Failed to parse the golden IR");
+
+  size_t size = 0;
+  const uint8_t *data = mod ? ir_binary_write_module(mod, &arena, &size) : NULL;
+  SUITE_ASSERT(data != NULL, "Encoding the golden IR failed");
+
+  if (data)
+  {
+    IRContext *fresh = ir_context_create();
+    IRModule *lazy = ir_binary_read_module_lazy(fresh, data, size);
+    SUITE_ASSERT(lazy != NULL, "ir_binary_read_module_lazy() failed");
+    if (lazy)
+    {
+      size_t deferred = 0;
+      IDList *iter;
+      list_for_each(&lazy->functions, iter)
+      {
+        IRFunction *func = list_entry(iter, IRFunction, list_node);
+        if (!ir_function_is_materialized(func))
+          deferred++;
+        SUITE_ASSERT(list_empty(&func->basic_blocks), "@%s should have no blocks before materialization",
+                     func->entry_address.name);
+      }
+      SUITE_ASSERT(deferred > 0, "Lazy loading should defer the function bodies");
+      SUITE_ASSERT(ir_module_materialize_all(lazy), "Materializing the lazy module failed");
+      SUITE_ASSERT(strcmp(ir_module_dump_to_string(lazy, &arena), get_golden_ir_text()) == 0,
+                   "The lazily loaded module differs from the original");
+    }
+    ir_context_destroy(fresh);
+
+    /// 截断和逐字节翻转：加载或物化都可能失败，但绝不能崩溃或触发断言
+    printf("  (Truncating and flipping a %zu-byte encoding with lazy loading...)\n", size);
+    uint8_t *copy = malloc(size);
+    memcpy(copy, data, size);
+    size_t accepted = 0;
+    for (size_t len = 0; len < size; len++)
+    {
+      IRModule *partial = ir_binary_read_module_lazy(ctx, copy, len);
+      if (partial && ir_module_materialize_all(partial))
+        accepted++;
+    }
+    SUITE_ASSERT(accepted == 0, "%zu truncated inputs were accepted", accepted);
+
+    for (size_t i = 0; i < size; i++)
+    {
+      copy[i] ^= 0xff;
+      IRModule *flipped = ir_binary_read_module_lazy(ctx, copy, size);
+      if (flipped)
+        ir_module_materialize_all(flipped);
+      copy[i] = data[i];
+    }
+    free(copy);
+  }
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Binary IR";
+  __calir_total_suites_run++;
+  if (test_binary_round_trip() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_binary_file() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_binary_malformed() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_binary_lazy() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
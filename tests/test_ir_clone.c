@@ -0,0 +1,208 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/global.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/use.h"
+#include "ir/verifier.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief [辅助] 操作数是否属于模块 mod (常量不属于任何模块，总是 true)
+ */
+static bool
+value_belongs_to(IRValueNode *val, IRModule *mod)
+{
+  switch (val->kind)
+  {
+  case IR_KIND_CONSTANT:
+    return true;
+  case IR_KIND_FUNCTION:
+    return container_of(val, IRFunction, entry_address)->parent == mod;
+  case IR_KIND_GLOBAL:
+    return container_of(val, IRGlobalVariable, value)->parent == mod;
+  case IR_KIND_ARGUMENT:
+    return container_of(val, IRArgument, value)->parent->parent == mod;
+  case IR_KIND_BASIC_BLOCK:
+    return container_of(val, IRBasicBlock, label_address)->parent->parent == mod;
+  case IR_KIND_INSTRUCTION:
+    return container_of(val, IRInstruction, result)->parent->parent->parent == mod;
+  }
+  return false;
+}
+
+/**
+ * @brief [辅助] 统计 mod 中指向模块外 (或没有正确链接) 的操作数
+ */
+static size_t
+count_foreign_operands(IRModule *mod)
+{
+  size_t foreign = 0;
+  IDList *func_iter;
+  list_for_each(&mod->functions, func_iter)
+  {
+    IRFunction *func = list_entry(func_iter, IRFunction, list_node);
+    IDList *bb_iter;
+    list_for_each(&func->basic_blocks, bb_iter)
+    {
+      IRBasicBlock *bb = list_entry(bb_iter, IRBasicBlock, list_node);
+      IDList *inst_iter;
+      list_for_each(&bb->instructions, inst_iter)
+      {
+        IRInstruction *inst = list_entry(inst_iter, IRInstruction, list_node);
+        for (size_t i = 0; i < inst->num_operands; i++)
+        {
+          IRUse *use = &inst->operands[i];
+          if (use->user != inst || !value_belongs_to(use->value, mod))
+            foreign++;
+        }
+      }
+    }
+  }
+  return foreign;
+}
+
+/**
+ * @brief golden IR: 克隆的打印结果与源相同，所有操作数都指向克隆，修改克隆不影响源
+ */
+int
+test_clone_golden()
+{
+  SUITE_START("IR Clone: Golden");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+  const char *golden_text = get_golden_ir_text();
+  IRModule *src = ir_parse_module(ctx, golden_text);
+  SUITE_ASSERT(src != NULL, "Failed to parse the golden IR");
+
+  IRModule *clone = ir_module_clone(src, NULL);
+  SUITE_ASSERT(clone != NULL && clone != src, "Cloning the golden IR failed");
+  const char *dumped = ir_module_dump_to_string(clone, &arena);
+  SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "The clone prints differently from the source");
+  SUITE_ASSERT(ir_verify_module(clone), "The clone should verify");
+  SUITE_ASSERT(count_foreign_operands(clone) == 0, "The clone has operands outside the clone");
+  SUITE_ASSERT(count_foreign_operands(src) == 0, "The source has operands outside the source");
+
+  /// 清空克隆的每个函数体: 源不变
+  IDList *iter;
+  list_for_each(&clone->functions, iter)
+  {
+    ir_function_clear_body(list_entry(iter, IRFunction, list_node));
+  }
+  dumped = ir_module_dump_to_string(src, &arena);
+  SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "Changing the clone changed the source");
+  SUITE_ASSERT(ir_verify_module(src), "The source should still verify");
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 克隆可以运行 (调用、phi、全局变量)，延迟加载的源会先被物化
+ */
+int
+test_clone_execute()
+{
+  SUITE_START("IR Clone: Execute");
+
+  static const char text[] = "@counter: <i32> = global 5: i32\n"
+                             "define i32 @twice(%x: i32) {\n"
+                             "$entry:\n"
+                             "  %y: i32 = add %x: i32, %x: i32\n"
+                             "  ret %y: i32\n"
+                             "}\n"
+                             "define i32 @main() {\n"
+                             "$entry:\n"
+                             "  %c: i32 = load @counter: <i32>\n"
+                             "  %p: i1 = icmp sgt %c: i32, 3: i32\n"
+                             "  br %p: i1, $big, $small\n"
+                             "$big:\n"
+                             "  %t: i32 = call <i32 (i32)> @twice(%c: i32)\n"
+                             "  br $done\n"
+                             "$small:\n"
+                             "  br $done\n"
+                             "$done:\n"
+                             "  %r: i32 = phi [ %t: i32, $big ], [ %c: i32, $small ]\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+
+  IRContext *ctx = ir_context_create();
+  IRModule *src = ir_parse_module_lazy(ctx, text);
+  SUITE_ASSERT(src != NULL, "Failed to load the execute snippet");
+  IRModule *clone = ir_module_clone(src, "copy");
+  SUITE_ASSERT(clone != NULL, "Cloning a lazily loaded module failed");
+  SUITE_ASSERT(strcmp(clone->name, "copy") == 0, "The clone should take the new name");
+  SUITE_ASSERT(count_foreign_operands(clone) == 0, "The clone has operands outside the clone");
+
+  IRFunction *main_fn = NULL;
+  IDList *iter;
+  list_for_each(&clone->functions, iter)
+  {
+    IRFunction *func = list_entry(iter, IRFunction, list_node);
+    SUITE_ASSERT(ir_function_is_materialized(func), "@%s should be materialized", func->entry_address.name);
+    if (strcmp(func->entry_address.name, "main") == 0)
+      main_fn = func;
+  }
+  SUITE_ASSERT(main_fn != NULL, "The clone should have @main");
+
+  DataLayout *dl = datalayout_create_host();
+  Interpreter *interp = interpreter_create(dl);
+  RuntimeValue result;
+  SUITE_ASSERT(interpreter_run_function(interp, main_fn, NULL, 0, &result), "Running the cloned @main failed");
+  SUITE_ASSERT(result.kind == RUNTIME_VAL_I32 && result.as.val_i32 == 10, "The cloned @main should return 10");
+  interpreter_destroy(interp);
+  datalayout_destroy(dl);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "IR Clone";
+  __calir_total_suites_run++;
+  if (test_clone_golden() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_clone_execute() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
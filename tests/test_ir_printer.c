@@ -17,9 +17,22 @@
 #include "ir/builder.h"
 #include "ir/context.h"
 #include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/printer.h"
 #include "ir_test_helpers.h"
 #include "test_utils.h"
 #include "utils/bump.h"
+#include "utils/string_buf.h"
+#include "utils/string_rope.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if STRING_ROPE_HAS_IOVEC
+#include <sys/uio.h>
+#endif
 
 /**
  * @brief 自动化测试：
@@ -59,6 +72,356 @@ test_print_golden_ir()
   SUITE_END();
 }
 
+/**
+ * @brief [内部] 用快速路径打印到一个新的 StringBuf 并返回结果
+ */
+static const char *
+print_to_string(Bump *arena, void (*print)(IRPrinter *p))
+{
+  StringBuf buf;
+  string_buf_init(&buf, arena);
+  IRPrinter p;
+  ir_printer_init_string_buf(&p, &buf);
+  print(&p);
+  return string_buf_get(&buf);
+}
+
+static void
+print_ints(IRPrinter *p)
+{
+  ir_print_int(p, 0);
+  ir_print_char(p, ' ');
+  ir_print_int(p, -42);
+  ir_print_char(p, ' ');
+  ir_print_int(p, INT64_MIN);
+  ir_print_char(p, ' ');
+  ir_print_int(p, INT64_MAX);
+  ir_print_char(p, ' ');
+  ir_print_uint(p, UINT64_MAX);
+  ir_print_char(p, ' ');
+  ir_print_name(p, '%', "x");
+  ir_print_mem(p, "abc", 2);
+}
+
+static void
+print_floats(IRPrinter *p)
+{
+  static const double values[] = {1.5, -0.5, 0.1, 3.0, 0.0, 1e20, 1.25e-5, -123456.789};
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    if (i > 0)
+      ir_print_char(p, ' ');
+    ir_print_float(p, values[i]);
+  }
+}
+
+/**
+ * @brief 快速路径的整数、浮点数与名字输出与 printf 的写法一致
+ */
+int
+test_print_fast_paths()
+{
+  SUITE_START("IR Printer: Fast Paths");
+
+  Bump arena;
+  bump_init(&arena);
+
+  const char *ints = print_to_string(&arena, print_ints);
+  const char *expected_ints = "0 -42 -9223372036854775808 9223372036854775807 18446744073709551615 %xab";
+  SUITE_ASSERT(strcmp(ints, expected_ints) == 0, "Expected '%s', got '%s'", expected_ints, ints);
+
+  /// 浮点数总是 [-]数字.数字 的写法 (没有指数)，并且是最短的精确形式
+  const char *floats = print_to_string(&arena, print_floats);
+  const char *expected_floats = "1.5 -0.5 0.1 3.0 0.0 100000000000000000000.0 0.0000125 -123456.789";
+  SUITE_ASSERT(strcmp(floats, expected_floats) == 0, "Expected '%s', got '%s'", expected_floats, floats);
+
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 浮点常量与超出 32 位的整数常量被完整打印，并且能被重新解析
+ */
+int
+test_print_constants_roundtrip()
+{
+  SUITE_START("IR Printer: Constant Round-trip");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  static const char text[] = "module = \"consts\"\n"
+                             "\n"
+                             "define f64 @f(%x: f64, %n: i64) {\n"
+                             "$entry:\n"
+                             "  %a: f64 = fadd %x: f64, 1.5: f64\n"
+                             "  %b: f64 = fmul %a: f64, -0.25: f64\n"
+                             "  %m: i64 = add %n: i64, 9000000000: i64\n"
+                             "  %k: i64 = sub %m: i64, -5000000000: i64\n"
+                             "  ret %b: f64\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the constants module");
+  const char *dumped = ir_module_dump_to_string(mod, &arena);
+  SUITE_ASSERT(strcmp(dumped, text) == 0, "Expected:\n%s\nGot:\n%s", text, dumped);
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief [内部] 读回一个临时文件的全部内容 (放在 arena 中，以 '\0' 结尾)
+ */
+static const char *
+read_back(FILE *f, Bump *arena, size_t *out_len)
+{
+  long size = ftell(f);
+  rewind(f);
+  char *data = BUMP_ALLOC_SLICE(arena, char, (size_t)size + 1);
+  size_t n = fread(data, 1, (size_t)size, f);
+  data[n] = '\0';
+  *out_len = n;
+  return data;
+}
+
+/**
+ * @brief 缓冲文件策略: 输出与 StringBuf 策略逐字节相同 (包括超过缓冲区大小的模块和片段)
+ */
+int
+test_print_buffered_file()
+{
+  SUITE_START("IR Printer: Buffered File");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+  IRBuilder *builder = ir_builder_create(ctx);
+
+  /// 1. golden IR: ir_module_dump_to_file 走缓冲策略
+  IRModule *mod = build_golden_ir(ctx, builder);
+  const char *expected = ir_module_dump_to_string(mod, &arena);
+  FILE *f = tmpfile();
+  SUITE_ASSERT(f != NULL, "tmpfile() failed");
+  ir_module_dump_to_file(mod, f);
+  size_t len = 0;
+  const char *written = read_back(f, &arena, &len);
+  SUITE_ASSERT(strcmp(written, expected) == 0, "Buffered dump differs from the string dump");
+  fclose(f);
+
+  /// 2. 混合快速路径、格式化和一个比缓冲区还大的片段，跨越多次写出
+  size_t big_len = IR_PRINTER_BUFFER_SIZE + 1000;
+  char *big = BUMP_ALLOC_SLICE(&arena, char, big_len + 1);
+  memset(big, 'x', big_len);
+  big[big_len] = '\0';
+
+  StringBuf reference;
+  string_buf_init(&reference, &arena);
+  IRPrinter ref_printer;
+  ir_printer_init_string_buf(&ref_printer, &reference);
+
+  f = tmpfile();
+  SUITE_ASSERT(f != NULL, "tmpfile() failed");
+  IRPrinter buffered;
+  ir_printer_init_file_buffered(&buffered, f);
+
+  IRPrinter *printers[] = {&ref_printer, &buffered};
+  for (size_t i = 0; i < 2; i++)
+  {
+    IRPrinter *p = printers[i];
+    for (int round = 0; round < 20000; round++)
+    {
+      ir_print_name(p, '%', "value");
+      ir_print_int(p, round);
+      ir_printf(p, " = %s %d, ", "add", round * 7);
+    }
+    ir_print_str(p, big);
+    ir_printf(p, "%s|%s", big, "tail");
+    ir_print_float(p, 2.5);
+  }
+  ir_printer_destroy(&buffered);
+
+  const char *ref_text = string_buf_get(&reference);
+  written = read_back(f, &arena, &len);
+  SUITE_ASSERT(len == strlen(ref_text), "Buffered output has %zu bytes, expected %zu", len, strlen(ref_text));
+  SUITE_ASSERT(memcmp(written, ref_text, len) == 0, "Buffered output differs from the reference");
+  fclose(f);
+
+  ir_builder_destroy(builder);
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 并行打印与顺序打印逐字节相同 (包括延迟加载的模块和不同的线程数)
+ */
+int
+test_print_parallel()
+{
+  SUITE_START("IR Printer: Parallel Dump");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+  IRBuilder *builder = ir_builder_create(ctx);
+
+  /// 1. golden IR
+  IRModule *golden = build_golden_ir(ctx, builder);
+  const char *golden_text = ir_module_dump_to_string(golden, &arena);
+  for (size_t threads = 0; threads <= 8; threads++)
+  {
+    const char *parallel = ir_module_dump_to_string_parallel(golden, &arena, threads);
+    SUITE_ASSERT(strcmp(parallel, golden_text) == 0, "Parallel dump with %zu threads differs", threads);
+  }
+
+  /// 2. 许多函数的模块，延迟加载 (并行打印前要先物化)
+  StringBuf source;
+  string_buf_init(&source, &arena);
+  string_buf_append_str(&source, "module = \"many\"\n\n");
+  for (int i = 0; i < 300; i++)
+  {
+    string_buf_append_fmt(&source,
+                          "define i64 @f%d(%%x: i64) {\n"
+                          "$entry:\n"
+                          "  %%y: i64 = mul %%x: i64, %d: i64\n"
+                          "  %%z: f64 = sitofp %%y: i64 to f64\n"
+                          "  %%w: f64 = fadd %%z: f64, 0.%d: f64\n"
+                          "  %%r: i64 = fptosi %%w: f64 to i64\n"
+                          "  ret %%r: i64\n"
+                          "}\n",
+                          i, i * 1000003, i + 1);
+  }
+  const char *source_text = string_buf_get(&source);
+
+  IRContext *eager_ctx = ir_context_create();
+  IRModule *eager = ir_parse_module(eager_ctx, source_text);
+  SUITE_ASSERT(eager != NULL, "Failed to parse the many-function module");
+  const char *expected = ir_module_dump_to_string(eager, &arena);
+
+  IRContext *lazy_ctx = ir_context_create();
+  IRModule *lazy = ir_parse_module_lazy(lazy_ctx, source_text);
+  SUITE_ASSERT(lazy != NULL, "Failed to lazily load the many-function module");
+  const char *parallel = ir_module_dump_to_string_parallel(lazy, &arena, 4);
+  SUITE_ASSERT(strcmp(parallel, expected) == 0, "Parallel dump of a lazy module differs");
+
+  /// 3. 文件策略
+  FILE *f = tmpfile();
+  SUITE_ASSERT(f != NULL, "tmpfile() failed");
+  ir_module_dump_to_file_parallel(eager, f, 3);
+  size_t len = 0;
+  const char *written = read_back(f, &arena, &len);
+  SUITE_ASSERT(strcmp(written, expected) == 0, "Parallel file dump differs");
+  fclose(f);
+
+  ir_context_destroy(lazy_ctx);
+  ir_context_destroy(eager_ctx);
+  ir_builder_destroy(builder);
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief StringRope: 追加跨越 chunk 边界、已写入的文本不移动，展平 / 写出 / iovec 与 StringBuf 策略逐字节相同
+ */
+int
+test_print_rope()
+{
+  SUITE_START("IR Printer: Rope");
+
+  Bump arena;
+  bump_init(&arena);
+
+  /// 1. 跨越 chunk 边界的追加、比 chunk 还大的片段、放不进剩余空间的格式化结果
+  StringRope rope;
+  string_rope_init(&rope, &arena);
+  StringBuf reference;
+  string_buf_init(&reference, &arena);
+  for (int i = 0; i < 2000; i++)
+  {
+    string_rope_append_fmt(&rope, "line %d: %s\n", i, i % 7 == 0 ? "seven" : "x");
+    string_buf_append_fmt(&reference, "line %d: %s\n", i, i % 7 == 0 ? "seven" : "x");
+  }
+  const char *first = rope.head->data;
+  size_t big_len = 3 * STRING_ROPE_MAX_CHUNK;
+  char *big = (char *)malloc(big_len);
+  SUITE_ASSERT(big != NULL, "malloc failed");
+  for (size_t i = 0; i < big_len; i++)
+    big[i] = (char)('a' + i % 26);
+  string_rope_append_bytes(&rope, big, big_len);
+  string_buf_append_bytes(&reference, big, big_len);
+  string_rope_append_str(&rope, "tail");
+  string_buf_append_str(&reference, "tail");
+  free(big);
+
+  SUITE_ASSERT(!string_rope_failed(&rope), "Appends should not fail");
+  SUITE_ASSERT(string_rope_len(&rope) == reference.len, "Length should be %zu, got %zu", reference.len,
+               string_rope_len(&rope));
+  SUITE_ASSERT(rope.num_chunks > 2, "Output should span several chunks, got %zu", rope.num_chunks);
+  SUITE_ASSERT(rope.head->data == first, "Earlier chunks should never move");
+  const char *flat = string_rope_flatten(&rope, &arena);
+  SUITE_ASSERT(flat != NULL && strcmp(flat, string_buf_get(&reference)) == 0, "Flattened text should match");
+
+#if STRING_ROPE_HAS_IOVEC
+  /// 2. iovec 按批填写，拼起来就是整个文本
+  StringRopeChunk *cursor = rope.head;
+  struct iovec iov[3];
+  size_t n, offset = 0;
+  bool same = true;
+  while ((n = string_rope_iovec(&rope, &cursor, iov, 3)) > 0)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      same &= memcmp(iov[i].iov_base, flat + offset, iov[i].iov_len) == 0;
+      offset += iov[i].iov_len;
+    }
+  }
+  SUITE_ASSERT(same && offset == rope.len, "iovecs should cover the text in order");
+#endif
+
+  /// 3. 模块: rope 策略 (顺序与并行) 与 StringBuf 策略逐字节相同
+  IRContext *ctx = ir_context_create();
+  IRBuilder *builder = ir_builder_create(ctx);
+  IRModule *mod = build_golden_ir(ctx, builder);
+  StringBuf buf;
+  string_buf_init(&buf, &arena);
+  IRPrinter p;
+  ir_printer_init_string_buf(&p, &buf);
+  ir_module_dump_internal(mod, &p);
+  const char *expected = string_buf_get(&buf);
+
+  StringRope module_rope;
+  string_rope_init(&module_rope, &arena);
+  ir_module_dump_to_rope(mod, &module_rope);
+  SUITE_ASSERT(strcmp(string_rope_flatten(&module_rope, &arena), expected) == 0, "Rope dump differs");
+  StringRope parallel_rope;
+  string_rope_init(&parallel_rope, &arena);
+  ir_module_dump_to_rope_parallel(mod, &parallel_rope, 3);
+  SUITE_ASSERT(strcmp(string_rope_flatten(&parallel_rope, &arena), expected) == 0, "Parallel rope dump differs");
+  SUITE_ASSERT(strcmp(ir_module_dump_to_string(mod, &arena), expected) == 0, "ir_module_dump_to_string differs");
+
+  /// 4. 直接写到文件
+  FILE *f = tmpfile();
+  SUITE_ASSERT(f != NULL, "tmpfile() failed");
+  SUITE_ASSERT(string_rope_write(&module_rope, f), "string_rope_write failed");
+  size_t len = 0;
+  const char *written = read_back(f, &arena, &len);
+  SUITE_ASSERT(len == module_rope.len && strcmp(written, expected) == 0, "Written rope differs");
+  fclose(f);
+
+  ir_builder_destroy(builder);
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
 int
 main()
 {
@@ -68,5 +431,35 @@ main()
   {
     __calir_total_suites_failed++;
   }
+
+  __calir_total_suites_run++;
+  if (test_print_fast_paths() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_print_constants_roundtrip() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_print_buffered_file() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_print_parallel() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_print_rope() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
   TEST_SUMMARY();
-}
\ No newline at end of file
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/licm.h"
+#include "transforms/mem2reg.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief [辅助] 用 mem2reg 生成循环中的 phi (解析器不支持前向引用)
+ */
+static bool
+promote(IRFunction *func)
+{
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  bool changed = ir_transform_mem2reg_run_with_analyses(func, am);
+  ir_analysis_manager_destroy(am);
+  return changed;
+}
+
+/**
+ * @brief 纯运算移到已有的前置块；除数不是非零常量的除法留在循环中
+ */
+int
+test_licm_hoist()
+{
+  SUITE_START("LICM: Hoist");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  %s.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  store 0: i32, %s.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %k: i32 = mul %n: i32, 3: i32\n"
+                             "  %k2: i32 = sdiv %k: i32, 4: i32\n"
+                             "  %d: i32 = sdiv %k: i32, %n: i32\n"
+                             "  %m: i32 = sdiv %k: i32, -1: i32\n"
+                             "  %s: i32 = load %s.slot: <i32>\n"
+                             "  %s1: i32 = add %s: i32, %k2: i32\n"
+                             "  %s2: i32 = add %s1: i32, %d: i32\n"
+                             "  %s3: i32 = add %s2: i32, %m: i32\n"
+                             "  store %s3: i32, %s.slot: <i32>\n"
+                             "  %i2: i32 = add %i: i32, 1: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  %r: i32 = load %s.slot: <i32>\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the LICM snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  SUITE_ASSERT(promote(func), "mem2reg should promote the slots");
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &before) && before == 5 * (3 + 3 - 15),
+               "Expected -45 before LICM, got %d", before);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_licm_run_with_analyses(func, am), "LICM should hoist %%k and %%k2");
+  SUITE_ASSERT(ir_analysis_is_cached(am, func, IR_ANALYSIS_DOM_TREE),
+               "Hoisting into an existing preheader should preserve the dominator tree");
+  SUITE_ASSERT(!ir_transform_licm_run_with_analyses(func, am), "A second run should change nothing");
+  ir_analysis_manager_destroy(am);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after LICM");
+  SUITE_ASSERT(count_opcode_in_block(func, "entry", IR_OP_MUL) == 1, "%%k should move to the entry block");
+  SUITE_ASSERT(count_opcode_in_block(func, "entry", IR_OP_SDIV) == 1, "Only %%k2 should move to the entry block");
+  SUITE_ASSERT(count_opcode_in_block(func, "body", IR_OP_SDIV) == 2, "Division by %%n or -1 must stay in the loop");
+  SUITE_ASSERT(count_opcode_in_block(func, "body", IR_OP_ADD) == 4, "The accumulator adds are not invariant");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &after) && after == before, "Expected %d after LICM, got %d", before, after);
+  /// 循环一次也不执行时，外提的 sdiv %k2 也不能出错
+  SUITE_ASSERT(run_i32(NULL, func, 0, &after) && after == 0, "Expected 0 for n = 0, got %d", after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief header 有两个循环外的前驱时创建前置块；内层循环的不变量一直移到外层循环之外
+ */
+int
+test_licm_preheader_nested()
+{
+  SUITE_START("LICM: Preheader And Nested Loops");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  %j.slot: <i32> = alloc i32\n"
+                             "  %s.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %s.slot: <i32>\n"
+                             "  %neg: i1 = icmp slt %n: i32, 0: i32\n"
+                             "  br %neg: i1, $a, $b\n"
+                             "$a:\n"
+                             "  store 1: i32, %i.slot: <i32>\n"
+                             "  br $outer\n"
+                             "$b:\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  br $outer\n"
+                             "$outer:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  store 0: i32, %j.slot: <i32>\n"
+                             "  br %c: i1, $inner, $exit\n"
+                             "$inner:\n"
+                             "  %j: i32 = load %j.slot: <i32>\n"
+                             "  %cj: i1 = icmp slt %j: i32, %i: i32\n"
+                             "  br %cj: i1, $inner.body, $outer.latch\n"
+                             "$inner.body:\n"
+                             "  %t: i32 = mul %n: i32, %n: i32\n"
+                             "  %u: i32 = add %i: i32, 7: i32\n"
+                             "  %v: i32 = add %t: i32, %u: i32\n"
+                             "  %s: i32 = load %s.slot: <i32>\n"
+                             "  %s2: i32 = add %s: i32, %v: i32\n"
+                             "  store %s2: i32, %s.slot: <i32>\n"
+                             "  %j2: i32 = add %j: i32, 1: i32\n"
+                             "  store %j2: i32, %j.slot: <i32>\n"
+                             "  br $inner\n"
+                             "$outer.latch:\n"
+                             "  %i2: i32 = add %i: i32, 1: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $outer\n"
+                             "$exit:\n"
+                             "  %r: i32 = load %s.slot: <i32>\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the LICM snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  SUITE_ASSERT(promote(func), "mem2reg should promote the slots");
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 4, &before), "Running before LICM failed");
+
+  bool cfg_changed = false;
+  SUITE_ASSERT(ir_transform_licm_run(func, &cfg_changed), "LICM should change the function");
+  SUITE_ASSERT(cfg_changed, "$outer and $inner need preheaders");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after LICM");
+
+  /// %t 两层循环都不变，移到外层的前置块；%u 只在内层不变，移到内层的前置块
+  SUITE_ASSERT(count_opcode_in_block(func, "outer.preheader", IR_OP_MUL) == 1, "%%t should leave both loops");
+  SUITE_ASSERT(count_opcode_in_block(func, "outer.preheader", IR_OP_PHI) == 2,
+               "The incoming values of %%i and of the sum from $a and $b should merge in the new preheader");
+  SUITE_ASSERT(count_opcode_in_block(func, "inner.preheader", IR_OP_ADD) == 2,
+               "%%u and %%v should move to the inner preheader, got %zu",
+               count_opcode_in_block(func, "inner.preheader", IR_OP_ADD));
+  SUITE_ASSERT(count_opcode_in_block(func, "inner.body", IR_OP_MUL) == 0, "No mul should stay in the inner loop");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 4, &after) && after == before, "Expected %d after LICM, got %d", before, after);
+  SUITE_ASSERT(run_i32(NULL, func, -3, &after) && after == 0, "Expected 0 for n = -3, got %d", after);
+
+  SUITE_ASSERT(!ir_transform_licm_run(func, &cfg_changed), "A second run should change nothing");
+  SUITE_ASSERT(!cfg_changed, "No preheader is missing any more");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief load 只在循环中没有调用、没有写同一个对象、并且每次进入循环都会执行时外提
+ */
+int
+test_licm_loads()
+{
+  SUITE_START("LICM: Loads");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "@g: <i32> = global 3: i32\n"
+                             "@h: <i32> = global 5: i32\n"
+                             "\n"
+                             "define i32 @id(%x: i32) {\n"
+                             "$entry:\n"
+                             "  ret %x: i32\n"
+                             "}\n"
+                             "\n"
+                             "define i32 @plain(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %g: i32 = load @g: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %h: i32 = load @h: <i32>\n"
+                             "  store %g: i32, @h: <i32>\n"
+                             "  %i2: i32 = add %i: i32, %h: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  ret %i: i32\n"
+                             "}\n"
+                             "\n"
+                             "define i32 @calls(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %g: i32 = load @g: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %k: i32 = call <i32 (i32)> @id(%g: i32)\n"
+                             "  %i2: i32 = add %i: i32, %k: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  ret %i: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the LICM snippet");
+  IRFunction *plain = find_function(mod, "plain");
+  IRFunction *calls = find_function(mod, "calls");
+  SUITE_ASSERT(plain && calls && promote(plain) && promote(calls), "mem2reg should promote the counters");
+
+  int32_t before_plain = 0;
+  int32_t before_calls = 0;
+  SUITE_ASSERT(run_i32(NULL, plain, 10, &before_plain) && before_plain == 11, "Expected 11, got %d", before_plain);
+  SUITE_ASSERT(run_i32(NULL, calls, 10, &before_calls) && before_calls == 12, "Expected 12, got %d", before_calls);
+
+  /// @plain: @g 在 header 中读且循环只写 @h，可以外提；@h 被写，而且 $body 不支配离开循环的 $loop
+  SUITE_ASSERT(ir_transform_licm_run(plain, NULL), "LICM should hoist the load of @g");
+  SUITE_ASSERT(ir_verify_function(plain), "@plain should verify after LICM");
+  SUITE_ASSERT(count_opcode_in_block(plain, "entry", IR_OP_LOAD) == 1, "The load of @g should move to the entry block");
+  SUITE_ASSERT(count_opcode_in_block(plain, "body", IR_OP_LOAD) == 1, "The load of @h must stay in the loop");
+
+  /// @calls: 被调用的函数可能写任何全局变量
+  SUITE_ASSERT(!ir_transform_licm_run(calls, NULL), "No load may leave a loop with a call");
+  SUITE_ASSERT(count_opcode_in_block(calls, "loop", IR_OP_LOAD) == 1, "The load of @g must stay in the loop");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, plain, 10, &after) && after == before_plain, "@plain changed: %d", after);
+  SUITE_ASSERT(run_i32(NULL, calls, 10, &after) && after == before_calls, "@calls changed: %d", after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "LICM";
+  __calir_total_suites_run++;
+  if (test_licm_hoist() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_licm_preheader_nested() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_licm_loads() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -0,0 +1,410 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "analysis/liveness.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_BLOCKS = 32,
+  NUM_SLOTS = 3
+};
+
+static const char LOOP_SOURCE[] = "define i32 @sum(%n: i32) {\n"
+                                  "$entry:\n"
+                                  "  %acc: <i32> = alloc i32\n"
+                                  "  store 0: i32, %acc: <i32>\n"
+                                  "  br $loop\n"
+                                  "$loop:\n"
+                                  "  %a: i32 = load %acc: <i32>\n"
+                                  "  %c: i1 = icmp slt %a: i32, %n: i32\n"
+                                  "  br %c: i1, $body, $exit\n"
+                                  "$body:\n"
+                                  "  %a2: i32 = add %a: i32, 1: i32\n"
+                                  "  store %a2: i32, %acc: <i32>\n"
+                                  "  br $loop\n"
+                                  "$exit:\n"
+                                  "  ret %a: i32\n"
+                                  "}\n";
+
+/**
+ * @brief [内部] 块的第 index 条指令
+ */
+static IRInstruction *
+nth_instruction(IRBasicBlock *bb, int index)
+{
+  IDList *iter = bb->instructions.next;
+  for (int i = 0; i < index; i++)
+    iter = iter->next;
+  return list_entry(iter, IRInstruction, list_node);
+}
+
+/**
+ * @brief mem2reg 之后的计数循环: phi 的结果、phi 的入边和循环里的使用
+ */
+int
+test_liveness_loop()
+{
+  SUITE_START("Liveness: Counting Loop");
+
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, LOOP_SOURCE);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the module");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote %%acc");
+
+  Liveness *lv = ir_analysis_get_liveness(am, func);
+  SUITE_ASSERT(lv != NULL, "The function should have liveness");
+
+  IRBasicBlock *entry = find_block(func, "entry");
+  IRBasicBlock *loop = find_block(func, "loop");
+  IRBasicBlock *body = find_block(func, "body");
+  IRBasicBlock *exit = find_block(func, "exit");
+  IRValueNode *n = &list_entry(func->arguments.next, IRArgument, list_node)->value;
+  IRInstruction *phi = nth_instruction(loop, 0);
+  IRInstruction *cmp = nth_instruction(loop, 1);
+  IRInstruction *add = nth_instruction(body, 0);
+  SUITE_ASSERT(phi->opcode == IR_OP_PHI, "mem2reg should put a phi at the top of the loop");
+
+  /// %n、phi 和 %a2 跨块；%c 只在循环头中使用
+  SUITE_ASSERT(lv->num_values == 3, "Expected 3 cross-block values, got %d", lv->num_values);
+  SUITE_ASSERT(liveness_value_index(lv, &cmp->result) == -1, "%%c is only used in its own block");
+
+  /// phi 的结果在循环头中定义；%a2 只在 body 的出口活跃 (作为 phi 的入边)
+  SUITE_ASSERT(bitset_count_slow(liveness_live_in(lv, loop)) == 1 && liveness_is_live_in(lv, loop, n),
+               "Only %%n should be live into the loop header");
+  SUITE_ASSERT(!liveness_is_live_in(lv, loop, &phi->result), "A phi result is not live into its block");
+  SUITE_ASSERT(liveness_is_live_out(lv, loop, &phi->result) && liveness_is_live_out(lv, loop, n),
+               "The phi and %%n should be live out of the header");
+  SUITE_ASSERT(liveness_is_live_in(lv, body, &phi->result) && liveness_is_live_in(lv, body, n),
+               "The phi and %%n should be live into the body");
+  SUITE_ASSERT(liveness_is_live_out(lv, body, &add->result) && !liveness_is_live_in(lv, loop, &add->result),
+               "%%a2 should be live out of the body but not into the header");
+  SUITE_ASSERT(liveness_is_live_in(lv, exit, &phi->result) && !liveness_is_live_in(lv, exit, n),
+               "Only the phi should be live into the exit");
+  SUITE_ASSERT(bitset_count_slow(liveness_live_out(lv, exit)) == 0, "Nothing is live out of the exit");
+  SUITE_ASSERT(bitset_count_slow(liveness_live_out(lv, entry)) == 1 && liveness_is_live_out(lv, entry, n),
+               "Only %%n should be live out of the entry");
+
+  /// 指令之后的活跃性: %c 活到 br；%n 在出口块中不活跃
+  SUITE_ASSERT(liveness_is_live_after(lv, &cmp->result, cmp), "%%c is used by the branch");
+  SUITE_ASSERT(!liveness_is_live_after(lv, &cmp->result, nth_instruction(loop, 2)), "%%c dies at the branch");
+  SUITE_ASSERT(liveness_is_live_after(lv, &phi->result, cmp), "The phi is live out of the header");
+  SUITE_ASSERT(liveness_is_live_after(lv, &add->result, add), "%%a2 feeds the phi");
+  SUITE_ASSERT(!liveness_is_live_after(lv, n, nth_instruction(exit, 0)), "%%n is dead in the exit");
+
+  ir_analysis_manager_destroy(am);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief [内部] 随机的可达 CFG: 块 i 总是能到 i + 1；每个块读写几个栈槽，
+ * 再由 mem2reg 变成带 phi 的 SSA
+ */
+static IRFunction *
+build_random_function(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRFunction *func = ir_function_create(mod, "random_live", i32);
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  IRArgument *x = ir_argument_create(func, i32, "x");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "b%d", i);
+    blocks[i] = ir_basic_block_create(func, name);
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  ir_builder_set_insertion_point(b, blocks[0]);
+  IRValueNode *slots[NUM_SLOTS];
+  for (int s = 0; s < NUM_SLOTS; s++)
+  {
+    slots[s] = ir_builder_create_alloca(b, i32, "slot");
+    ir_builder_create_store(b, &x->value, slots[s]);
+  }
+  IRValueNode *base = ir_builder_create_add(b, &x->value, ir_constant_get_i32(ctx, 1), "base");
+
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    *seed = *seed * 1664525u + 1013904223u;
+    uint32_t r = *seed >> 8;
+    IRValueNode *v = ir_builder_create_load(b, slots[r % NUM_SLOTS], "v");
+    if (r & 16)
+      v = ir_builder_create_add(b, v, base, "w");
+    if (r & 32)
+      v = ir_builder_create_add(b, v, &x->value, "w");
+    ir_builder_create_store(b, v, slots[(r >> 6) % NUM_SLOTS]);
+
+    if (i == num_blocks - 1)
+    {
+      ir_builder_create_ret(b, ir_builder_create_load(b, slots[0], "result"));
+      continue;
+    }
+    IRBasicBlock *next = blocks[i + 1];
+    /// 入口块不能有前驱；两条边指向同一个块或者自环时只用无条件跳转 (验证器不接受自环上的 phi)
+    IRBasicBlock *other = blocks[1 + (r >> 10) % (num_blocks - 1)];
+    if (r % 4 == 0 || other == next || other == blocks[i])
+      ir_builder_create_br(b, &next->label_address);
+    else
+      ir_builder_create_cond_br(b, &cond->value, &next->label_address, &other->label_address);
+  }
+  return func;
+}
+
+/**
+ * @brief [内部] inst 是否以非 phi 的方式使用 value
+ */
+static bool
+uses_value(IRInstruction *inst, IRValueNode *value)
+{
+  if (inst->opcode == IR_OP_PHI)
+    return false;
+  for (size_t k = 0; k < inst->num_operands; k++)
+  {
+    if (ir_instruction_get_operand(inst, k) == value)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 块 to 中是否有 phi 把 value 作为来自 from 的入边
+ */
+static bool
+phi_uses_on_edge(IRBasicBlock *from, IRBasicBlock *to, IRValueNode *value)
+{
+  IDList *iter;
+  list_for_each(&to->instructions, iter)
+  {
+    IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+    if (inst->opcode != IR_OP_PHI)
+      break;
+    for (size_t k = 0; k + 1 < inst->num_operands; k += 2)
+    {
+      if (ir_instruction_get_operand(inst, k) == value &&
+          ir_instruction_get_operand(inst, k + 1) == &from->label_address)
+        return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 按定义搜索路径: 从 start 的入口出发、不经过定义块 def，能否到达 value 的一个使用
+ */
+static bool
+naive_live_in(FunctionCFG *cfg, int start, int def, IRValueNode *value)
+{
+  bool seen[MAX_BLOCKS] = {0};
+  int stack[MAX_BLOCKS];
+  int top = 0;
+  if (start == def)
+    return false;
+  stack[top++] = start;
+  seen[start] = true;
+  while (top > 0)
+  {
+    const CFGNode *node = &cfg->nodes[stack[--top]];
+    IDList *iter;
+    list_for_each(&node->block->instructions, iter)
+    {
+      if (uses_value(list_entry(iter, IRInstruction, list_node), value))
+        return true;
+    }
+    for (int k = 0; k < node->num_succs; k++)
+    {
+      int succ = node->succs[k];
+      if (phi_uses_on_edge(node->block, cfg->nodes[succ].block, value))
+        return true;
+      if (succ != def && !seen[succ])
+      {
+        seen[succ] = true;
+        stack[top++] = succ;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] value 是否在块 id 的出口活跃 (按定义)
+ */
+static bool
+naive_live_out(FunctionCFG *cfg, int id, int def, IRValueNode *value)
+{
+  const CFGNode *node = &cfg->nodes[id];
+  for (int k = 0; k < node->num_succs; k++)
+  {
+    int succ = node->succs[k];
+    if (phi_uses_on_edge(node->block, cfg->nodes[succ].block, value) || naive_live_in(cfg, succ, def, value))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 对一个值检查每个块的入口 / 出口和每条指令之后的活跃性
+ * @return 不一致的次数
+ */
+static size_t
+check_value(Liveness *lv, IRValueNode *value, IRBasicBlock *def_bb)
+{
+  FunctionCFG *cfg = lv->cfg;
+  int def = cfg_get_node(cfg, def_bb)->id;
+  size_t mismatches = 0;
+  for (int id = 0; id < cfg->num_nodes; id++)
+  {
+    IRBasicBlock *bb = cfg->nodes[id].block;
+    bool live_out = naive_live_out(cfg, id, def, value);
+    if (liveness_is_live_in(lv, bb, value) != naive_live_in(cfg, id, def, value))
+      mismatches++;
+    if (liveness_is_live_out(lv, bb, value) != live_out)
+      mismatches++;
+
+    /// 指令之后: 块内后面的非 phi 使用，否则 (后面没有定义时) 看出口
+    IDList *iter;
+    list_for_each(&bb->instructions, iter)
+    {
+      IRInstruction *inst = list_entry(iter, IRInstruction, list_node);
+      bool expected = live_out;
+      for (IDList *later = iter->next; later != &bb->instructions; later = later->next)
+      {
+        IRInstruction *next = list_entry(later, IRInstruction, list_node);
+        if (uses_value(next, value))
+        {
+          expected = true;
+          break;
+        }
+        if (&next->result == value)
+        {
+          expected = false;
+          break;
+        }
+      }
+      if (liveness_is_live_after(lv, value, inst) != expected)
+        mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * @brief 随机 CFG 上 mem2reg 之后的 SSA: 与按路径搜索的定义逐个值、逐个块比较
+ */
+int
+test_liveness_random()
+{
+  SUITE_START("Liveness: Random CFGs");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 4242;
+
+  size_t mismatches = 0;
+  size_t num_values = 0;
+  size_t num_visits = 0;
+  size_t num_blocks_total = 0;
+  for (int round = 0; round < 200; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "liveness");
+    int num_blocks = 2 + round % (MAX_BLOCKS - 2);
+    IRFunction *func = build_random_function(ctx, mod, b, &seed, num_blocks);
+    IRAnalysisManager *am = ir_analysis_manager_create();
+    SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote the slots");
+    SUITE_ASSERT(ir_verify_function(func), "The promoted function should verify");
+
+    Liveness *lv = ir_analysis_get_liveness(am, func);
+    num_values += (size_t)lv->num_values;
+    num_visits += lv->num_block_visits;
+    num_blocks_total += (size_t)num_blocks;
+
+    IRBasicBlock *entry = lv->cfg->entry_node->block;
+    IDList *iter;
+    list_for_each(&func->arguments, iter)
+    {
+      mismatches += check_value(lv, &list_entry(iter, IRArgument, list_node)->value, entry);
+    }
+    for (int id = 0; id < lv->cfg->num_nodes; id++)
+    {
+      IRBasicBlock *bb = lv->cfg->nodes[id].block;
+      IDList *inst_iter;
+      list_for_each(&bb->instructions, inst_iter)
+      {
+        mismatches += check_value(lv, &list_entry(inst_iter, IRInstruction, list_node)->result, bb);
+      }
+    }
+
+    ir_analysis_manager_destroy(am);
+  }
+
+  SUITE_ASSERT(mismatches == 0, "Liveness disagreed with path search %zu times", mismatches);
+  SUITE_ASSERT(num_values > 0, "The random functions should have cross-block values");
+  SUITE_ASSERT(num_visits < 4 * num_blocks_total,
+               "The worklist should converge in a few passes (%zu visits for %zu blocks)", num_visits,
+               num_blocks_total);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Liveness";
+  __calir_total_suites_run++;
+  if (test_liveness_loop() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_liveness_random() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
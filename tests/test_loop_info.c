@@ -0,0 +1,377 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "analysis/dom_tree.h"
+#include "analysis/loop_info.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_BLOCKS = 48
+};
+
+/**
+ * @brief [内部] ids 中是否有 id
+ */
+static bool
+has_id(const int *ids, int count, int id)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (ids[i] == id)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief 两层嵌套循环: header、块、latch、出口、前置块和深度
+ */
+int
+test_loop_info_nested()
+{
+  SUITE_START("Loop Info: Nested Loops");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define void @nest(%c: i1, %d: i1) {\n"
+                             "$entry:\n"
+                             "  br $outer\n"
+                             "$outer:\n"
+                             "  br %c: i1, $inner, $exit\n"
+                             "$inner:\n"
+                             "  br %d: i1, $body, $latch\n"
+                             "$body:\n"
+                             "  br $inner\n"
+                             "$latch:\n"
+                             "  br $outer\n"
+                             "$exit:\n"
+                             "  ret void\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The module should parse");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRBasicBlock *entry = find_block(func, "entry");
+  IRBasicBlock *outer_header = find_block(func, "outer");
+  IRBasicBlock *inner_header = find_block(func, "inner");
+  IRBasicBlock *body = find_block(func, "body");
+  IRBasicBlock *latch = find_block(func, "latch");
+  IRBasicBlock *exit = find_block(func, "exit");
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  LoopInfo *li = ir_analysis_get_loops(am, func);
+  SUITE_ASSERT(li != NULL, "The loop info should be computed");
+  SUITE_ASSERT(li->num_loops == 2 && li->num_top_level == 1, "Expected one loop nested in another");
+
+  IRLoop *outer = li->top_level[0];
+  SUITE_ASSERT(outer->header == outer_header && outer->depth == 1 && outer->parent == NULL, "Wrong outer loop");
+  SUITE_ASSERT(outer->num_blocks == 4 && outer->blocks[0] == outer_header->id, "The outer loop has 4 blocks");
+  SUITE_ASSERT(outer->num_latches == 1 && outer->latches[0] == latch->id, "The outer latch is $latch");
+  SUITE_ASSERT(outer->num_exits == 1 && outer->exits[0] == exit->id, "The outer loop exits to $exit");
+  SUITE_ASSERT(outer->preheader == entry, "The outer preheader is $entry");
+  SUITE_ASSERT(outer->num_subloops == 1, "The outer loop has one subloop");
+
+  IRLoop *inner = outer->subloops[0];
+  SUITE_ASSERT(li->loops[0] == outer && li->loops[1] == inner, "Loops are listed outer first");
+  SUITE_ASSERT(inner->header == inner_header && inner->depth == 2 && inner->parent == outer, "Wrong inner loop");
+  SUITE_ASSERT(inner->num_blocks == 2 && has_id(inner->blocks, 2, body->id), "The inner loop is {inner, body}");
+  SUITE_ASSERT(inner->num_latches == 1 && inner->latches[0] == body->id, "The inner latch is $body");
+  SUITE_ASSERT(inner->num_exits == 1 && inner->exits[0] == latch->id, "The inner loop exits to $latch");
+  SUITE_ASSERT(inner->preheader == NULL, "$outer also branches to $exit, so it is not a preheader");
+
+  SUITE_ASSERT(loop_info_get_loop(li, body) == inner, "$body is innermost in the inner loop");
+  SUITE_ASSERT(loop_info_get_loop(li, latch) == outer, "$latch is innermost in the outer loop");
+  SUITE_ASSERT(loop_info_get_loop(li, entry) == NULL && loop_info_get_loop(li, exit) == NULL,
+               "$entry and $exit are not in loops");
+  SUITE_ASSERT(loop_info_get_depth(li, body) == 2 && loop_info_get_depth(li, latch) == 1 &&
+                   loop_info_get_depth(li, exit) == 0,
+               "Wrong nesting depths");
+  SUITE_ASSERT(loop_info_is_header(li, inner_header) && !loop_info_is_header(li, body), "Wrong headers");
+  SUITE_ASSERT(loop_info_contains(li, outer, body), "The outer loop contains the inner body");
+  SUITE_ASSERT(!loop_info_contains(li, inner, latch), "The inner loop does not contain $latch");
+
+  ir_analysis_manager_destroy(am);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 自环是循环；有两个入口的环 (不可归约) 不是自然循环
+ */
+int
+test_loop_info_irreducible()
+{
+  SUITE_START("Loop Info: Self Loops and Irreducible Cycles");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define void @irr(%c: i1) {\n"
+                             "$entry:\n"
+                             "  br %c: i1, $a, $b\n"
+                             "$a:\n"
+                             "  br %c: i1, $b, $spin\n"
+                             "$b:\n"
+                             "  br $a\n"
+                             "$spin:\n"
+                             "  br %c: i1, $spin, $done\n"
+                             "$done:\n"
+                             "  ret void\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The module should parse");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRBasicBlock *a = find_block(func, "a");
+  IRBasicBlock *spin = find_block(func, "spin");
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  DominatorTree *dt = dom_tree_build(cfg, &arena);
+  LoopInfo *li = loop_info_compute(dt, &arena);
+  SUITE_ASSERT(li->num_loops == 1, "Only the self loop is natural, got %d loops", li->num_loops);
+  IRLoop *loop = loop_info_get_loop(li, spin);
+  SUITE_ASSERT(loop && loop->header == spin && loop->num_blocks == 1, "$spin is a one-block loop");
+  SUITE_ASSERT(loop->num_latches == 1 && loop->latches[0] == spin->id, "$spin is its own latch");
+  SUITE_ASSERT(loop->preheader == NULL, "$a has two successors, so there is no preheader");
+  SUITE_ASSERT(loop_info_get_loop(li, a) == NULL, "The irreducible cycle is not a loop");
+
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief [内部] 用 builder 构建一个随机 CFG: 每个块以 ret、br 或条件 br 结束
+ */
+static IRFunction *
+build_random_cfg(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRFunction *func = ir_function_create(mod, "random_cfg", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "b%d", i);
+    blocks[i] = ir_basic_block_create(func, name);
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    *seed = *seed * 1664525u + 1013904223u;
+    uint32_t r = *seed >> 8;
+    IRBasicBlock *t = blocks[(r >> 4) % num_blocks];
+    IRBasicBlock *f = blocks[(r >> 12) % num_blocks];
+    switch (r % 8)
+    {
+    case 0:
+      ir_builder_create_ret(b, NULL);
+      break;
+    case 1:
+    case 2:
+      ir_builder_create_br(b, &t->label_address);
+      break;
+    default:
+      ir_builder_create_cond_br(b, &cond->value, &t->label_address, &f->label_address);
+      break;
+    }
+  }
+  return func;
+}
+
+/**
+ * @brief [内部] 从 start 出发、不经过 avoid，沿后继能否到达 target
+ */
+static bool
+reaches_avoiding(FunctionCFG *cfg, int start, int avoid, int target)
+{
+  bool seen[MAX_BLOCKS] = {0};
+  int stack[MAX_BLOCKS];
+  int top = 0;
+  if (start == avoid)
+    return false;
+  stack[top++] = start;
+  seen[start] = true;
+  while (top > 0)
+  {
+    int id = stack[--top];
+    if (id == target)
+      return true;
+    for (int i = 0; i < cfg->nodes[id].num_succs; i++)
+    {
+      int succ = cfg->nodes[id].succs[i];
+      if (succ != avoid && !seen[succ])
+      {
+        seen[succ] = true;
+        stack[top++] = succ;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 随机 CFG: 每个循环的块、latch 和出口与自然循环的定义一致，
+ * 每个块的最内层循环是包含它的最深的循环
+ */
+int
+test_loop_info_random()
+{
+  SUITE_START("Loop Info: Random CFGs");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 777;
+
+  size_t wrong_headers = 0;
+  size_t wrong_blocks = 0;
+  size_t wrong_edges = 0;
+  size_t wrong_innermost = 0;
+  size_t num_loops = 0;
+  for (int round = 0; round < 300; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "loops");
+    int num_blocks = 2 + round % (MAX_BLOCKS - 2);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *dt = dom_tree_build(cfg, &arena);
+    LoopInfo *li = loop_info_compute(dt, &arena);
+    num_loops += (size_t)li->num_loops;
+
+    for (int h = 0; h < num_blocks; h++)
+    {
+      IRBasicBlock *hb = cfg->nodes[h].block;
+      bool reachable = dom_tree_dominates(dt, cfg->entry_node->block, hb);
+      /// 回边: 可达的前驱，且被 h 支配
+      bool is_header = false;
+      for (int k = 0; k < cfg->nodes[h].num_preds; k++)
+      {
+        IRBasicBlock *pb = cfg_pred(cfg, &cfg->nodes[h], k)->block;
+        if (reachable && dom_tree_dominates(dt, cfg->entry_node->block, pb) && dom_tree_dominates(dt, hb, pb))
+          is_header = true;
+      }
+      if (loop_info_is_header(li, hb) != is_header)
+        wrong_headers++;
+      if (!is_header)
+        continue;
+
+      IRLoop *loop = loop_info_get_loop(li, hb);
+      for (int x = 0; x < num_blocks; x++)
+      {
+        IRBasicBlock *xb = cfg->nodes[x].block;
+        /// x 在循环中: h 支配 x，且 x 不经过 h 就能到达一个 latch
+        bool expected = x == h;
+        for (int k = 0; k < loop->num_latches && !expected; k++)
+          expected = dom_tree_dominates(dt, hb, xb) && reaches_avoiding(cfg, x, h, loop->latches[k]);
+        if (loop_info_contains(li, loop, xb) != expected || has_id(loop->blocks, loop->num_blocks, x) != expected)
+          wrong_blocks++;
+        if (expected)
+        {
+          for (int k = 0; k < cfg->nodes[x].num_succs; k++)
+          {
+            int succ = cfg->nodes[x].succs[k];
+            bool succ_inside = loop_info_contains(li, loop, cfg->nodes[succ].block);
+            if (succ_inside == has_id(loop->exits, loop->num_exits, succ))
+              wrong_edges++;
+            if (succ == h && !has_id(loop->latches, loop->num_latches, x))
+              wrong_edges++;
+          }
+        }
+      }
+    }
+
+    /// 最内层循环: 包含 x 的循环中 depth 最大的那个
+    for (int x = 0; x < num_blocks; x++)
+    {
+      IRBasicBlock *xb = cfg->nodes[x].block;
+      IRLoop *deepest = NULL;
+      for (int l = 0; l < li->num_loops; l++)
+      {
+        IRLoop *loop = li->loops[l];
+        if (has_id(loop->blocks, loop->num_blocks, x) && (!deepest || loop->depth > deepest->depth))
+          deepest = loop;
+        if (loop->parent && loop->depth != loop->parent->depth + 1)
+          wrong_innermost++;
+      }
+      if (loop_info_get_loop(li, xb) != deepest)
+        wrong_innermost++;
+    }
+
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  SUITE_ASSERT(num_loops > 0, "The random CFGs should contain loops");
+  SUITE_ASSERT(wrong_headers == 0, "%zu blocks have the wrong header flag", wrong_headers);
+  SUITE_ASSERT(wrong_blocks == 0, "%zu loop memberships disagree with the definition", wrong_blocks);
+  SUITE_ASSERT(wrong_edges == 0, "%zu latches or exits are wrong", wrong_edges);
+  SUITE_ASSERT(wrong_innermost == 0, "%zu blocks have the wrong innermost loop", wrong_innermost);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Loop Info";
+  __calir_total_suites_run++;
+  if (test_loop_info_nested() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_loop_info_irreducible() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_loop_info_random() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  TEST_SUMMARY();
+}
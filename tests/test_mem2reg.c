@@ -0,0 +1,266 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief 循环 + load 的结果被 store 回另一个 alloca (被替换的 load 链)：
+ * 提升之后没有内存操作，结果与提升前相同
+ */
+int
+test_mem2reg_loop()
+{
+  SUITE_START("Mem2Reg: Loop");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @sum(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %acc: <i32> = alloc i32\n"
+                             "  %i: <i32> = alloc i32\n"
+                             "  store 0: i32, %acc: <i32>\n"
+                             "  store 0: i32, %i: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %iv: i32 = load %i: <i32>\n"
+                             "  %c: i1 = icmp slt %iv: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %a: i32 = load %acc: <i32>\n"
+                             "  %a2: i32 = add %a: i32, %iv: i32\n"
+                             "  store %a2: i32, %acc: <i32>\n"
+                             "  %iv2: i32 = load %i: <i32>\n"
+                             "  %i2: i32 = add %iv2: i32, 1: i32\n"
+                             "  store %i2: i32, %i: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  %t: i32 = load %acc: <i32>\n"
+                             "  store %t: i32, %i: <i32>\n"
+                             "  %r: i32 = load %i: <i32>\n"
+                             "  %r2: i32 = add %r: i32, %t: i32\n"
+                             "  ret %r2: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the mem2reg snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 10, &before) && before == 90, "Expected 90 before mem2reg, got %d", before);
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  DominatorTree *dt = dom_tree_build(cfg, &arena);
+  DominanceFrontier *df = ir_analysis_dom_frontier_compute(dt, &arena);
+  SUITE_ASSERT(ir_transform_mem2reg_run(func, dt, df), "mem2reg should change the function");
+  ir_analysis_dom_frontier_destroy(df);
+  dom_tree_destroy(dt);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after mem2reg");
+  SUITE_ASSERT(count_opcode(func, IR_OP_ALLOCA) == 0, "All allocas should be promoted");
+  SUITE_ASSERT(count_opcode(func, IR_OP_LOAD) == 0, "All loads should be removed");
+  SUITE_ASSERT(count_opcode(func, IR_OP_STORE) == 0, "All stores should be removed");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 10, &after) && after == before, "Expected %d after mem2reg, got %d", before, after);
+  SUITE_ASSERT(run_i32(NULL, func, 0, &after) && after == 0, "Expected 0 for n = 0, got %d", after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 三种 phi 放置方式: %t 在任何块的入口都不活跃，%k 在 $merge 活跃、在 $done 不活跃
+ */
+int
+test_mem2reg_phi_placement()
+{
+  SUITE_START("Mem2Reg: Phi Placement");
+
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %t: <i32> = alloc i32\n"
+                             "  %k: <i32> = alloc i32\n"
+                             "  store 0: i32, %k: <i32>\n"
+                             "  %c: i1 = icmp slt %n: i32, 10: i32\n"
+                             "  br %c: i1, $a, $b\n"
+                             "$a:\n"
+                             "  store %n: i32, %t: <i32>\n"
+                             "  %x: i32 = load %t: <i32>\n"
+                             "  store %x: i32, %k: <i32>\n"
+                             "  br $merge\n"
+                             "$b:\n"
+                             "  store 1: i32, %t: <i32>\n"
+                             "  %y: i32 = load %t: <i32>\n"
+                             "  br $merge\n"
+                             "$merge:\n"
+                             "  %r: i32 = load %k: <i32>\n"
+                             "  store %r: i32, %k: <i32>\n"
+                             "  br %c: i1, $p, $q\n"
+                             "$p:\n"
+                             "  store 5: i32, %k: <i32>\n"
+                             "  br $done\n"
+                             "$q:\n"
+                             "  br $done\n"
+                             "$done:\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  static const IRMem2RegPhiPlacement placements[] = {IR_MEM2REG_MINIMAL, IR_MEM2REG_SEMI_PRUNED, IR_MEM2REG_PRUNED};
+  /// 最小: %t 在 $merge，%k 在 $merge 和 $done；半剪枝: 去掉从不活跃的 %t；剪枝: 再去掉 $done 的 %k
+  static const size_t expected_phis[] = {3, 2, 1};
+
+  for (size_t i = 0; i < sizeof(placements) / sizeof(placements[0]); i++)
+  {
+    IRContext *ctx = ir_context_create();
+    IRModule *mod = ir_parse_module(ctx, text);
+    SUITE_ASSERT(mod != NULL, "Failed to parse the placement snippet");
+    IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    DominatorTree *dt = dom_tree_build(cfg, &arena);
+    bool changed = ir_transform_mem2reg_run_with_placement(func, dt, placements[i]);
+    SUITE_ASSERT(changed, "mem2reg should change the function");
+    dom_tree_destroy(dt);
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+
+    size_t phis = count_opcode(func, IR_OP_PHI);
+    SUITE_ASSERT(phis == expected_phis[i], "Placement %zu: expected %zu phis, got %zu", i, expected_phis[i], phis);
+    SUITE_ASSERT(ir_verify_function(func), "Placement %zu: function should verify", i);
+    int32_t result = 0;
+    SUITE_ASSERT(run_i32(NULL, func, 3, &result) && result == 3, "Placement %zu: expected 3, got %d", i, result);
+    SUITE_ASSERT(run_i32(NULL, func, 20, &result) && result == 0, "Placement %zu: expected 0, got %d", i, result);
+    ir_context_destroy(ctx);
+  }
+
+  SUITE_END();
+}
+
+/**
+ * @brief 10 万个块的链 (支配树同样深)：重命名不递归，不会耗尽调用栈
+ */
+int
+test_mem2reg_deep_dom_tree()
+{
+  SUITE_START("Mem2Reg: Deep Dominator Tree");
+
+  enum
+  {
+    NUM_BLOCKS = 100000
+  };
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_module_create(ctx, "deep");
+  IRBuilder *b = ir_builder_create(ctx);
+  IRType *i32 = ir_type_get_i32(ctx);
+  IRFunction *func = ir_function_create(mod, "chain", i32);
+  IRArgument *n = ir_argument_create(func, i32, "n");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *entry = ir_basic_block_create(func, "entry");
+  ir_function_append_basic_block(func, entry);
+  ir_builder_set_insertion_point(b, entry);
+  IRValueNode *slot = ir_builder_create_alloca(b, i32, "slot");
+  ir_builder_create_store(b, &n->value, slot);
+
+  /// 每个块把 slot 加一，然后跳到下一个块
+  IRBasicBlock *prev = entry;
+  for (int i = 0; i < NUM_BLOCKS; i++)
+  {
+    IRBasicBlock *bb = ir_basic_block_create(func, "step");
+    ir_function_append_basic_block(func, bb);
+    ir_builder_set_insertion_point(b, prev);
+    ir_builder_create_br(b, &bb->label_address);
+    ir_builder_set_insertion_point(b, bb);
+    IRValueNode *v = ir_builder_create_load(b, slot, "v");
+    ir_builder_create_store(b, ir_builder_create_add(b, v, ir_constant_get_i32(ctx, 1), "w"), slot);
+    prev = bb;
+  }
+  ir_builder_set_insertion_point(b, prev);
+  ir_builder_create_ret(b, ir_builder_create_load(b, slot, "r"));
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  DominatorTree *dt = dom_tree_build(cfg, &arena);
+  SUITE_ASSERT(ir_transform_mem2reg_run(func, dt, NULL), "mem2reg should change the function");
+  dom_tree_destroy(dt);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+
+  SUITE_ASSERT(count_opcode(func, IR_OP_LOAD) == 0 && count_opcode(func, IR_OP_STORE) == 0,
+               "All loads and stores should be removed");
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 0, "A chain of blocks needs no phi");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after mem2reg");
+
+  int32_t result = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &result) && result == 5 + NUM_BLOCKS, "Expected %d, got %d", 5 + NUM_BLOCKS,
+               result);
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Mem2Reg";
+  __calir_total_suites_run++;
+  if (test_mem2reg_loop() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_mem2reg_phi_placement() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_mem2reg_deep_dom_tree() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -16,17 +16,26 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
 #include "ir/context.h"
 #include "ir/function.h"
+#include "ir/lexer.h"
 #include "ir/module.h"
 #include "ir/parser.h"
 #include "ir/type.h"
+#include "ir/verifier.h"
 
 #include "ir_test_helpers.h"
 #include "test_utils.h"
 #include "utils/bump.h"
+#include "utils/data_layout.h"
+#include "utils/hashmap.h"
+#include "utils/id_list.h"
 
 /**
  * @brief 自动化测试：
@@ -65,6 +74,653 @@ test_parser_roundtrip()
     }
   }
 
+  /// 局部名在源码切片上查找：只被使用 (从未定义) 的名字不会驻留到上下文中
+  static const char undefined_use[] = "define i32 @f(%a: i32) {\n$entry:\n"
+                                      "  %s: i32 = add %a: i32, %never_defined_local: i32\n  ret %s: i32\n}\n";
+  SUITE_ASSERT(ir_parse_module(ctx, undefined_use) == NULL, "Use of an undefined local should fail to parse");
+  SUITE_ASSERT(!str_hashmap_contains(ctx->string_intern_cache, "never_defined_local", strlen("never_defined_local")),
+               "An undefined local name should not be interned");
+  SUITE_ASSERT(str_hashmap_contains(ctx->string_intern_cache, "a", 1), "Defined local names should be interned");
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 关键字识别: 每个关键字得到自己的 token，前缀 / 加长 / 大小写不同的拼写仍是标识符
+ */
+int
+test_lexer_keywords()
+{
+  SUITE_START("IR Lexer: Keyword Lookup");
+
+  IRContext *ctx = ir_context_create();
+
+  typedef struct ExpectedToken
+  {
+    const char *text;
+    TokenType type;
+  } ExpectedToken;
+  static const ExpectedToken expected[] = {
+    {"module", TK_KW_MODULE},
+    {"define", TK_KW_DEFINE},
+    {"declare", TK_KW_DECLARE},
+    {"default", TK_KW_DEFAULT},
+    {"alloc", TK_KW_ALLOCA},
+    {"br", TK_KW_BR},
+    {"fptoui", TK_KW_FPTOUI},
+    {"fptosi", TK_KW_FPTOSI},
+    {"uitofp", TK_KW_UITOFP},
+    {"sitofp", TK_KW_SITOFP},
+    {"zeroinitializer", TK_KW_ZEROINITIALIZER},
+    {"to", TK_KW_TO},
+    {"true", TK_KW_TRUE},
+    {"false", TK_KW_FALSE},
+    {"ule", TK_KW_ULE},
+    {"une", TK_KW_UNE},
+    {"uno", TK_KW_UNO},
+    {"ord", TK_KW_ORD},
+    {"a", TK_IDENT},
+    {"ad", TK_IDENT},
+    {"adds", TK_IDENT},
+    {"Add", TK_IDENT},
+    {"alloca", TK_IDENT},
+    {"b", TK_IDENT},
+    {"i32", TK_IDENT},
+    {"zeroinitializers", TK_IDENT},
+    {"a_very_long_identifier_name", TK_IDENT},
+  };
+  enum
+  {
+    NUM_EXPECTED = sizeof(expected) / sizeof(expected[0])
+  };
+
+  char source[1024];
+  size_t len = 0;
+  for (int i = 0; i < NUM_EXPECTED; i++)
+    len += (size_t)snprintf(source + len, sizeof(source) - len, "%s ", expected[i].text);
+
+  Lexer lexer;
+  ir_lexer_init(&lexer, source, ctx);
+  for (int i = 0; i < NUM_EXPECTED; i++)
+  {
+    const Token *tok = ir_lexer_current_token(&lexer);
+    SUITE_ASSERT(tok->type == expected[i].type, "'%s' lexed as %d, expected %d", expected[i].text, tok->type,
+                 expected[i].type);
+    if (expected[i].type == TK_IDENT)
+    {
+      SUITE_ASSERT(tok->as.ident_val != NULL && strcmp(tok->as.ident_val, expected[i].text) == 0,
+                   "Identifier '%s' has the wrong text", expected[i].text);
+    }
+    ir_lexer_next(&lexer);
+  }
+  SUITE_ASSERT(ir_lexer_current_token(&lexer)->type == TK_EOF, "Expected EOF after the last token");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 批量扫描: 跨越多个块的标识符与空白、任意位置的换行和注释，行号 / 列号与逐字节扫描一致
+ */
+int
+test_lexer_positions()
+{
+  SUITE_START("IR Lexer: Line & Column Tracking");
+
+  IRContext *ctx = ir_context_create();
+
+  /// 标识符长度与空白长度遍历 0..79，覆盖块内、块边界和跨块的所有情况
+  static char source[65536];
+  enum
+  {
+    MAX_TOKENS = 400
+  };
+  size_t expected_line[MAX_TOKENS];
+  size_t expected_column[MAX_TOKENS];
+  size_t expected_len[MAX_TOKENS];
+  size_t expected_offset[MAX_TOKENS];
+  int num_tokens = 0;
+
+  size_t len = 0;
+  size_t line = 1;
+  size_t line_start = 0;
+  for (int i = 0; i < MAX_TOKENS && len + 256 < sizeof(source); i++)
+  {
+    int blank = (i * 7) % 80;
+    for (int b = 0; b < blank; b++)
+    {
+      char c = " \t\r \n"[(i + b) % 5];
+      source[len++] = c;
+      if (c == '\n')
+      {
+        line++;
+        line_start = len;
+      }
+    }
+    if (i % 9 == 4)
+    {
+      len += (size_t)snprintf(source + len, sizeof(source) - len, "; comment %d with %% and @ signs\n", i);
+      line++;
+      line_start = len;
+    }
+    source[len++] = ' ';
+
+    int ident = 1 + (i * 13) % 79;
+    expected_line[num_tokens] = line;
+    expected_column[num_tokens] = len - line_start + 1;
+    source[len++] = '%';
+    expected_offset[num_tokens] = len;
+    for (int k = 0; k < ident; k++)
+      source[len++] = "abcXYZ_09.q"[(i + k) % 11];
+    expected_len[num_tokens] = (size_t)ident;
+    num_tokens++;
+  }
+  source[len] = '\0';
+
+  Lexer lexer;
+  ir_lexer_init(&lexer, source, ctx);
+  for (int i = 0; i < num_tokens; i++)
+  {
+    const Token *tok = ir_lexer_current_token(&lexer);
+    SUITE_ASSERT(tok->type == TK_LOCAL_IDENT, "Token %d: wrong type %d", i, tok->type);
+    SUITE_ASSERT(tok->line == expected_line[i] && tok->column == expected_column[i],
+                 "Token %d: at %zu:%zu, expected %zu:%zu", i, tok->line, tok->column, expected_line[i],
+                 expected_column[i]);
+    SUITE_ASSERT(tok->ident_len == expected_len[i], "Token %d: length %zu, expected %zu", i, tok->ident_len,
+                 expected_len[i]);
+    SUITE_ASSERT(tok->as.ident_val == source + expected_offset[i],
+                 "Token %d: local identifiers should point into the source", i);
+    ir_lexer_next(&lexer);
+  }
+  SUITE_ASSERT(ir_lexer_current_token(&lexer)->type == TK_EOF, "Expected EOF after the last token");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 把 text 的前 len 字节写入临时目录下的 name (返回完整路径；失败返回 NULL)
+ */
+static const char *
+write_temp_file(const char *name, const char *text, size_t len)
+{
+  static char path[512];
+  const char *dir = getenv("TMPDIR");
+  snprintf(path, sizeof(path), "%s/%s", (dir && dir[0]) ? dir : "/tmp", name);
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return NULL;
+  bool ok = fwrite(text, 1, len, f) == len;
+  ok = (fclose(f) == 0) && ok;
+  return ok ? path : NULL;
+}
+
+/**
+ * @brief 从文件解析: 与从字符串解析结果相同，文件末尾没有 '\0' 也不会越界读取
+ */
+int
+test_parse_module_file()
+{
+  SUITE_START("IR Parser: Parse From File");
+
+  Bump arena;
+  bump_init(&arena);
+  IRContext *ctx = ir_context_create();
+
+  /// 1. golden IR 经文件解析后打印结果不变
+  const char *golden_text = get_golden_ir_text();
+  const char *path = write_temp_file("calir_test_golden.cir", golden_text, strlen(golden_text));
+  SUITE_ASSERT(path != NULL, "Failed to write the golden IR file");
+  IRModule *mod = ir_parse_module_file(ctx, path);
+  SUITE_ASSERT(mod != NULL, "ir_parse_module_file() failed on the golden IR");
+  const char *dumped = ir_module_dump_to_string(mod, &arena);
+  SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "File round-trip differs from the golden IR");
+  remove(path);
+
+  /// 2. 文件恰好占满整页，最后一个 token 紧贴文件末尾 (映射之后没有 '\0' 可读)
+  static char page_text[8192];
+  const char *body = "module = \"edge\"\n"
+                     "\n"
+                     "define i32 @last(%x: i32) {\n"
+                     "$entry:\n"
+                     "  ret %x: i32\n"
+                     "}\n";
+  size_t body_len = strlen(body);
+  memcpy(page_text, body, body_len);
+  page_text[body_len] = ';';
+  memset(page_text + body_len + 1, 'c', sizeof(page_text) - body_len - 3);
+  page_text[sizeof(page_text) - 2] = '\n';
+  page_text[sizeof(page_text) - 1] = ';';
+  path = write_temp_file("calir_test_page.cir", page_text, sizeof(page_text));
+  SUITE_ASSERT(path != NULL, "Failed to write the page-sized file");
+  mod = ir_parse_module_file(ctx, path);
+  SUITE_ASSERT(mod != NULL, "Failed to parse a file ending in a comment at a page boundary");
+  remove(path);
+
+  /// 最后一个字节就是 '}' (没有换行)
+  static const char tail_text[] = "module = \"tail\"\n"
+                                  "\n"
+                                  "define void @tail() {\n"
+                                  "$entry:\n"
+                                  "  ret void\n"
+                                  "}";
+  path = write_temp_file("calir_test_tail.cir", tail_text, sizeof(tail_text) - 1);
+  SUITE_ASSERT(path != NULL, "Failed to write the tail file");
+  mod = ir_parse_module_file(ctx, path);
+  SUITE_ASSERT(mod != NULL, "Failed to parse a file whose last byte ends a token");
+  remove(path);
+
+  /// 3. 空文件得到空模块，不存在的文件返回 NULL
+  path = write_temp_file("calir_test_empty.cir", "", 0);
+  SUITE_ASSERT(path != NULL, "Failed to write the empty file");
+  SUITE_ASSERT(ir_parse_module_file(ctx, path) != NULL, "Failed to parse an empty file");
+  remove(path);
+  SUITE_ASSERT(ir_parse_module_file(ctx, "/nonexistent/dir/missing.cir") == NULL, "Missing file should fail");
+
+  ir_context_destroy(ctx);
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/** @brief 每次最多交出 step 字节的字符串输入 (用来制造任意的分块边界) */
+typedef struct
+{
+  const char *text;
+  size_t len;
+  size_t pos;
+  size_t step;
+} ChunkedReader;
+
+static size_t
+chunked_read(void *reader_data, char *buffer, size_t capacity)
+{
+  ChunkedReader *r = reader_data;
+  size_t n = r->len - r->pos;
+  if (n > r->step)
+    n = r->step;
+  if (n > capacity)
+    n = capacity;
+  memcpy(buffer, r->text + r->pos, n);
+  r->pos += n;
+  return n;
+}
+
+/** @brief 记录回调次数；只保留名为 keep_name 的函数 (为 NULL 时全部保留) */
+typedef struct
+{
+  int calls;
+  const char *keep_name;
+} StreamCounter;
+
+static IRStreamAction
+count_functions(IRFunction *func, void *user_data)
+{
+  StreamCounter *counter = user_data;
+  counter->calls++;
+  if (counter->keep_name == NULL || strcmp(func->entry_address.name, counter->keep_name) == 0)
+    return IR_STREAM_KEEP;
+  return IR_STREAM_DISCARD;
+}
+
+/** @brief 生成 num_funcs 个函数，每个都调用前一个；最后是调用最后一个函数的 @main */
+static char *
+make_chain_module(int num_funcs, size_t *out_len)
+{
+  size_t cap = (size_t)num_funcs * 512 + 512;
+  char *text = malloc(cap);
+  size_t len = (size_t)snprintf(text, cap, "module = \"chain\"\n\n; header comment\n"
+                                           "define i32 @f0(%%x: i32) {\n$entry:\n  ret %%x: i32\n}\n");
+  for (int k = 1; k < num_funcs; k++)
+  {
+    len += (size_t)snprintf(text + len, cap - len,
+                            "\n; function %d\n"
+                            "define i32 @f%d(%%x: i32) {\n"
+                            "$entry:\n"
+                            "  %%a: i32 = add %%x: i32, %d: i32\n"
+                            "  %%b: i32 = mul %%a: i32, 3: i32\n"
+                            "  %%c: i1 = icmp sgt %%b: i32, 100: i32\n"
+                            "  br %%c: i1, $big, $small\n"
+                            "$big:\n"
+                            "  %%d: i32 = call <i32 (i32)> @f%d(%%b: i32)\n"
+                            "  br $done\n"
+                            "$small:\n"
+                            "  br $done\n"
+                            "$done:\n"
+                            "  %%r: i32 = phi [ %%d: i32, $big ], [ %%b: i32, $small ]\n"
+                            "  ret %%r: i32\n"
+                            "}\n",
+                            k, k, k, k - 1);
+  }
+  len += (size_t)snprintf(text + len, cap - len,
+                          "define i32 @main() {\n$entry:\n"
+                          "  %%r: i32 = call <i32 (i32)> @f%d(1: i32)\n  ret %%r: i32\n}",
+                          num_funcs - 1);
+  *out_len = len;
+  return text;
+}
+
+/**
+ * @brief 流式解析: 分块边界任意，函数逐个交给回调，被丢弃的函数体占用的内存会被回收
+ */
+int
+test_parse_module_stream()
+{
+  SUITE_START("IR Parser: Streaming");
+
+  Bump arena;
+  bump_init(&arena);
+
+  /// 1. golden IR 以 7 字节一块送入，结果与一次性解析相同
+  IRContext *ctx = ir_context_create();
+  const char *golden_text = get_golden_ir_text();
+  ChunkedReader reader = {golden_text, strlen(golden_text), 0, 7};
+  StreamCounter counter = {0, NULL};
+  IRModule *mod = ir_parse_module_stream(ctx, chunked_read, &reader, count_functions, &counter);
+  SUITE_ASSERT(mod != NULL, "Streaming parse of the golden IR failed");
+  SUITE_ASSERT(counter.calls == 1, "Expected one callback (one define), got %d", counter.calls);
+  const char *dumped = ir_module_dump_to_string(mod, &arena);
+  SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "Streamed golden IR differs from the original");
+  ir_context_destroy(ctx);
+
+  /// 2. 全部保留 vs 只保留 @main: 丢弃后 ir_arena 只剩函数头
+  enum
+  {
+    NUM_FUNCS = 2000
+  };
+  size_t chain_len = 0;
+  char *chain = make_chain_module(NUM_FUNCS, &chain_len);
+
+  ctx = ir_context_create();
+  reader = (ChunkedReader){chain, chain_len, 0, 4096};
+  counter = (StreamCounter){0, NULL};
+  mod = ir_parse_module_stream(ctx, chunked_read, &reader, count_functions, &counter);
+  SUITE_ASSERT(mod != NULL, "Streaming parse (keep all) failed");
+  SUITE_ASSERT(counter.calls == NUM_FUNCS + 1, "Expected %d callbacks, got %d", NUM_FUNCS + 1, counter.calls);
+  size_t keep_all_bytes = bump_get_allocated_bytes(&ctx->ir_arena);
+  ir_context_destroy(ctx);
+
+  ctx = ir_context_create();
+  reader = (ChunkedReader){chain, chain_len, 0, 1000};
+  counter = (StreamCounter){0, "main"};
+  mod = ir_parse_module_stream(ctx, chunked_read, &reader, count_functions, &counter);
+  SUITE_ASSERT(mod != NULL, "Streaming parse (discard) failed");
+  SUITE_ASSERT(counter.calls == NUM_FUNCS + 1, "Expected %d callbacks, got %d", NUM_FUNCS + 1, counter.calls);
+  size_t discard_bytes = bump_get_allocated_bytes(&ctx->ir_arena);
+  SUITE_ASSERT(discard_bytes * 4 < keep_all_bytes, "Discarding bodies should reclaim memory (%zu vs %zu bytes)",
+               discard_bytes, keep_all_bytes);
+
+  int bodies = 0;
+  int declarations = 0;
+  IDList *it;
+  list_for_each(&mod->functions, it)
+  {
+    IRFunction *func = list_entry(it, IRFunction, list_node);
+    if (func->is_declaration)
+      declarations++;
+    else
+      bodies++;
+  }
+  SUITE_ASSERT(bodies == 1 && declarations == NUM_FUNCS, "Expected 1 body and %d declarations, got %d and %d",
+               NUM_FUNCS, bodies, declarations);
+  ir_context_destroy(ctx);
+  free(chain);
+
+  /// 3. 后面的函数中的语法错误使整个解析失败
+  ctx = ir_context_create();
+  static const char bad_text[] = "define void @ok() {\n$entry:\n  ret void\n}\n"
+                                 "define void @bad() {\n$entry:\n  ret oops\n}\n";
+  reader = (ChunkedReader){bad_text, sizeof(bad_text) - 1, 0, 16};
+  counter = (StreamCounter){0, NULL};
+  SUITE_ASSERT(ir_parse_module_stream(ctx, chunked_read, &reader, count_functions, &counter) == NULL,
+               "A syntax error should fail the streaming parse");
+  SUITE_ASSERT(counter.calls == 1, "Only @ok should reach the callback, got %d", counter.calls);
+  ir_context_destroy(ctx);
+
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 并行解析: 结果与顺序解析相同，函数体可以前向引用，错误使解析失败
+ */
+int
+test_parse_module_parallel()
+{
+  SUITE_START("IR Parser: Parallel");
+
+  Bump arena;
+  bump_init(&arena);
+
+  /// 1. golden IR 往返
+  IRContext *ctx = ir_context_create();
+  const char *golden_text = get_golden_ir_text();
+  IRModule *mod = ir_parse_module_parallel(ctx, golden_text, 4);
+  SUITE_ASSERT(mod != NULL, "Parallel parse of the golden IR failed");
+  const char *dumped = ir_module_dump_to_string(mod, &arena);
+  SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "Parallel golden IR differs from the original");
+  ir_context_destroy(ctx);
+
+  /// 2. 多个函数共享常量和被调用者: 8 线程的结果与顺序解析逐字相同
+  enum
+  {
+    NUM_FUNCS = 2000
+  };
+  size_t chain_len = 0;
+  char *chain = make_chain_module(NUM_FUNCS, &chain_len);
+
+  ctx = ir_context_create();
+  mod = ir_parse_module(ctx, chain);
+  SUITE_ASSERT(mod != NULL, "Sequential parse of the chain module failed");
+  const char *expected = ir_module_dump_to_string(mod, &arena);
+  ir_context_destroy(ctx);
+
+  ctx = ir_context_create();
+  mod = ir_parse_module_parallel(ctx, chain, 8);
+  SUITE_ASSERT(mod != NULL, "Parallel parse of the chain module failed");
+  dumped = ir_module_dump_to_string(mod, &arena);
+  SUITE_ASSERT(expected && dumped && strcmp(dumped, expected) == 0, "Parallel parse differs from sequential parse");
+  SUITE_ASSERT(ctx->lock == NULL, "Context should leave concurrent mode after parsing");
+  SUITE_ASSERT(ir_context_intern_str(ctx, "f1999") == ir_context_intern_str(ctx, "f1999"),
+               "Interning should still be unique after parsing");
+  ir_context_destroy(ctx);
+  free(chain);
+
+  /// 3. 函数体可以调用后面定义的函数
+  ctx = ir_context_create();
+  static const char forward_text[] = "define i32 @main() {\n$entry:\n"
+                                     "  %r: i32 = call <i32 ()> @later()\n  ret %r: i32\n}\n"
+                                     "define i32 @later() {\n$entry:\n  ret 7: i32\n}\n";
+  SUITE_ASSERT(ir_parse_module_parallel(ctx, forward_text, 2) != NULL, "Forward call should parse in parallel mode");
+  ir_context_destroy(ctx);
+
+  /// 4. 某个函数体中的语法错误使整个解析失败
+  ctx = ir_context_create();
+  static const char bad_text[] = "define void @ok() {\n$entry:\n  ret void\n}\n"
+                                 "define void @bad() {\n$entry:\n  ret oops\n}\n"
+                                 "define void @ok2() {\n$entry:\n  ret void\n}\n";
+  SUITE_ASSERT(ir_parse_module_parallel(ctx, bad_text, 3) == NULL, "A syntax error should fail the parallel parse");
+  ir_context_destroy(ctx);
+
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 延迟解析: 函数体在物化、验证或执行时才解析，结果与立即解析相同
+ */
+int
+test_parse_module_lazy()
+{
+  SUITE_START("IR Parser: Lazy");
+
+  Bump arena;
+  bump_init(&arena);
+
+  /// 1. golden IR: 加载后所有定义都未物化，全部物化后往返不变
+  IRContext *ctx = ir_context_create();
+  const char *golden_text = get_golden_ir_text();
+  IRModule *mod = ir_parse_module_lazy(ctx, golden_text);
+  SUITE_ASSERT(mod != NULL, "Lazy parse of the golden IR failed");
+  if (mod)
+  {
+    size_t deferred = 0;
+    IDList *iter;
+    list_for_each(&mod->functions, iter)
+    {
+      IRFunction *func = list_entry(iter, IRFunction, list_node);
+      if (!func->is_declaration && !ir_function_is_materialized(func))
+        deferred++;
+      SUITE_ASSERT(func->is_declaration || list_empty(&func->basic_blocks),
+                   "@%s should have no blocks before materialization", func->entry_address.name);
+    }
+    SUITE_ASSERT(deferred > 0, "Lazy parse should defer the function bodies");
+    SUITE_ASSERT(ir_module_materialize_all(mod), "Materializing the golden IR failed");
+    const char *dumped = ir_module_dump_to_string(mod, &arena);
+    SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "Lazy golden IR differs from the original");
+  }
+  ir_context_destroy(ctx);
+
+  /// 2. 只有被用到的函数体才被解析: 验证和解释器都会触发物化
+  ctx = ir_context_create();
+  static const char forward_text[] = "define i32 @main() {\n$entry:\n"
+                                     "  %r: i32 = call <i32 ()> @later()\n  ret %r: i32\n}\n"
+                                     "define i32 @later() {\n$entry:\n  ret 7: i32\n}\n"
+                                     "define i32 @unused() {\n$entry:\n  ret 0: i32\n}\n";
+  mod = ir_parse_module_lazy(ctx, forward_text);
+  SUITE_ASSERT(mod != NULL, "Lazy parse with a forward call failed");
+  if (mod)
+  {
+    IRFunction *main_fn = find_function(mod, "main");
+    IRFunction *later = find_function(mod, "later");
+    IRFunction *unused = find_function(mod, "unused");
+    SUITE_ASSERT(ir_verify_function(main_fn), "Verifying @main should materialize it");
+    SUITE_ASSERT(ir_function_is_materialized(main_fn), "@main should be materialized after verification");
+    SUITE_ASSERT(!ir_function_is_materialized(later), "@later should not be touched by verifying @main");
+
+    DataLayout *dl = datalayout_create_host();
+    Interpreter *interp = interpreter_create(dl);
+    RuntimeValue result;
+    SUITE_ASSERT(interpreter_run_function(interp, main_fn, NULL, 0, &result), "Running @main failed");
+    SUITE_ASSERT(result.kind == RUNTIME_VAL_I32 && result.as.val_i32 == 7, "@main should return 7");
+    SUITE_ASSERT(ir_function_is_materialized(later), "Calling @later should materialize it");
+    SUITE_ASSERT(!ir_function_is_materialized(unused), "@unused should never be parsed");
+    interpreter_destroy(interp);
+    datalayout_destroy(dl);
+  }
+  ir_context_destroy(ctx);
+
+  /// 3. 函数体中的错误在物化时报告，该函数保持未物化，其他函数不受影响
+  ctx = ir_context_create();
+  static const char bad_text[] = "define void @ok() {\n$entry:\n  ret void\n}\n"
+                                 "define void @bad() {\n$entry:\n  ret oops\n}\n"
+                                 "define void @ok2() {\n$entry:\n  ret void\n}\n";
+  mod = ir_parse_module_lazy(ctx, bad_text);
+  SUITE_ASSERT(mod != NULL, "Lazy parse should not look inside the function bodies");
+  if (mod)
+  {
+    IRFunction *bad = find_function(mod, "bad");
+    SUITE_ASSERT(ir_function_materialize(find_function(mod, "ok")), "@ok should materialize");
+    SUITE_ASSERT(!ir_function_materialize(bad), "@bad should fail to materialize");
+    SUITE_ASSERT(!ir_function_is_materialized(bad) && list_empty(&bad->basic_blocks),
+                 "A failed materialization should leave @bad unmaterialized and empty");
+    SUITE_ASSERT(!ir_module_materialize_all(mod), "Materializing the whole module should fail");
+    SUITE_ASSERT(ir_function_is_materialized(find_function(mod, "ok2")), "@ok2 should still materialize");
+  }
+  ir_context_destroy(ctx);
+
+  /// 4. 函数头中的错误使加载失败
+  ctx = ir_context_create();
+  SUITE_ASSERT(ir_parse_module_lazy(ctx, "define void @f(%a: bogus) {\n$entry:\n  ret void\n}\n") == NULL,
+               "A bad signature should fail the lazy parse");
+  ir_context_destroy(ctx);
+
+  bump_destroy(&arena);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 函数私有 Arena: 解析结果不变；反复重建一个函数体不会让 Context 的 Arena 增长
+ */
+int
+test_function_private_arenas()
+{
+  SUITE_START("IR: Function Private Arenas");
+
+  Bump arena;
+  bump_init(&arena);
+
+  /// 1. 串行和并行解析 golden IR，往返不变
+  const char *golden_text = get_golden_ir_text();
+  for (size_t threads = 1; threads <= 4; threads += 3)
+  {
+    IRContext *ctx = ir_context_create();
+    ir_context_set_private_function_arenas(ctx, true);
+    IRModule *mod = ir_parse_module_parallel(ctx, golden_text, threads);
+    SUITE_ASSERT(mod != NULL, "Parse with private arenas failed (%zu threads)", threads);
+    if (mod)
+    {
+      IDList *iter;
+      list_for_each(&mod->functions, iter)
+      {
+        IRFunction *func = list_entry(iter, IRFunction, list_node);
+        SUITE_ASSERT(func->is_declaration || func->body_arena != NULL, "@%s should have a private arena",
+                     func->entry_address.name);
+      }
+      const char *dumped = ir_module_dump_to_string(mod, &arena);
+      SUITE_ASSERT(dumped && strcmp(dumped, golden_text) == 0, "Golden IR differs with private arenas");
+    }
+    ir_context_destroy(ctx);
+  }
+
+  /// 2. 反复替换 @f 的函数体 (@main 对 @f 的调用保持有效)
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, "define i32 @f(%a: i32) {\n$entry:\n  ret %a: i32\n}\n"
+                                       "define i32 @main() {\n$entry:\n"
+                                       "  %r: i32 = call <i32 (i32)> @f(1: i32)\n  ret %r: i32\n}\n");
+  SUITE_ASSERT(mod != NULL, "Failed to parse the rebuild snippet");
+  IRFunction *f = find_function(mod, "f");
+  IRArgument *arg = list_entry(f->arguments.next, IRArgument, list_node);
+  IRBuilder *b = ir_builder_create(ctx);
+
+  ir_function_clear_body(f);
+  SUITE_ASSERT(ir_function_use_private_arena(f), "Failed to give @f a private arena");
+
+  size_t ctx_bytes = 0;
+  size_t body_bytes = 0;
+  for (int round = 0; round < 200; round++)
+  {
+    ir_function_clear_body(f);
+    IRBasicBlock *bb = ir_basic_block_create(f, "entry");
+    ir_function_append_basic_block(f, bb);
+    ir_builder_set_insertion_point(b, bb);
+    b->next_temp_reg_id = 0;
+    IRValueNode *v = &arg->value;
+    for (int k = 0; k < 100; k++)
+      v = ir_builder_create_add(b, v, ir_constant_get_i32(ctx, k), NULL);
+    ir_builder_create_ret(b, v);
+    SUITE_ASSERT(ir_verify_function(f), "Rebuilt @f failed verification (round %d)", round);
+
+    /// bump_reset 只保留最后一个 Chunk: 前几轮 Chunk 长到能装下整个函数体，之后不再变化
+    if (round == 3)
+    {
+      ctx_bytes = bump_get_allocated_bytes(&ctx->ir_arena);
+      body_bytes = bump_get_allocated_bytes(&f->body_arena->arena);
+    }
+  }
+  SUITE_ASSERT(bump_get_allocated_bytes(&ctx->ir_arena) == ctx_bytes, "The context arena grew while rebuilding @f");
+  SUITE_ASSERT(bump_get_allocated_bytes(&f->body_arena->arena) == body_bytes, "@f's arena grew while rebuilding");
+  SUITE_ASSERT(ir_verify_module(mod), "The module should still verify after rebuilding @f");
+
+  ir_builder_destroy(b);
   ir_context_destroy(ctx);
   bump_destroy(&arena);
 
@@ -80,5 +736,47 @@ main()
   {
     __calir_total_suites_failed++;
   }
+
+  __calir_total_suites_run++;
+  if (test_lexer_keywords() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_lexer_positions() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_parse_module_file() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_parse_module_stream() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_parse_module_parallel() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_parse_module_lazy() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_function_private_arenas() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
   TEST_SUMMARY();
 }
\ No newline at end of file
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "transforms/mem2reg.h"
+#include "transforms/pass_manager.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief [辅助] 生成 num_functions 个求和循环 @f0 .. @fN (变量都是 alloca；@fk 的循环体有 k % 7 + 1 次加法)
+ *
+ * @fk(n) = (k % 7 + 1) * (0 + 1 + ... + n-1)
+ */
+static char *
+make_source(int num_functions)
+{
+  size_t capacity = (size_t)num_functions * 2048 + 64;
+  char *text = (char *)malloc(capacity);
+  size_t len = 0;
+  for (int k = 0; k < num_functions; k++)
+  {
+    len += (size_t)snprintf(text + len, capacity - len,
+                            "define i32 @f%d(%%n: i32) {\n"
+                            "$entry:\n"
+                            "  %%acc: <i32> = alloc i32\n"
+                            "  %%i: <i32> = alloc i32\n"
+                            "  store 0: i32, %%acc: <i32>\n"
+                            "  store 0: i32, %%i: <i32>\n"
+                            "  br $loop\n"
+                            "$loop:\n"
+                            "  %%iv: i32 = load %%i: <i32>\n"
+                            "  %%c: i1 = icmp slt %%iv: i32, %%n: i32\n"
+                            "  br %%c: i1, $body, $exit\n"
+                            "$body:\n",
+                            k);
+    for (int j = 0; j < k % 7 + 1; j++)
+    {
+      len += (size_t)snprintf(text + len, capacity - len,
+                              "  %%a%d: i32 = load %%acc: <i32>\n"
+                              "  %%b%d: i32 = add %%a%d: i32, %%iv: i32\n"
+                              "  store %%b%d: i32, %%acc: <i32>\n",
+                              j, j, j, j);
+    }
+    len += (size_t)snprintf(text + len, capacity - len,
+                            "  %%iv2: i32 = add %%iv: i32, 1: i32\n"
+                            "  store %%iv2: i32, %%i: <i32>\n"
+                            "  br $loop\n"
+                            "$exit:\n"
+                            "  %%r: i32 = load %%acc: <i32>\n"
+                            "  ret %%r: i32\n"
+                            "}\n\n");
+  }
+  return text;
+}
+
+/*
+ * --- 记录调用的测试 Pass ---
+ */
+
+static atomic_size_t g_function_pass_calls;
+static size_t g_calls_seen_by_module_pass;
+static size_t g_module_pass_calls;
+
+static bool
+counting_function_pass(IRFunction *func, IRAnalysisManager *am)
+{
+  (void)func;
+  (void)am;
+  atomic_fetch_add(&g_function_pass_calls, 1);
+  return false;
+}
+
+static bool
+counting_module_pass(IRModule *mod, IRAnalysisManager *am)
+{
+  (void)mod;
+  (void)am;
+  g_module_pass_calls++;
+  g_calls_seen_by_module_pass = atomic_load(&g_function_pass_calls);
+  return false;
+}
+
+/** @brief 删掉最后一个基本块的终结指令 (之后验证一定失败) */
+static bool
+breaking_function_pass(IRFunction *func, IRAnalysisManager *am)
+{
+  IRBasicBlock *last = list_entry(func->basic_blocks.prev, IRBasicBlock, list_node);
+  ir_instruction_erase_from_parent(list_entry(last->instructions.prev, IRInstruction, list_node));
+  ir_analysis_invalidate(am, func, IR_PRESERVE_NONE);
+  return true;
+}
+
+static void
+reset_counters(void)
+{
+  atomic_store(&g_function_pass_calls, 0);
+  g_calls_seen_by_module_pass = 0;
+  g_module_pass_calls = 0;
+}
+
+/**
+ * @brief 单线程: mem2reg + 验证，模块 Pass 在前一组函数 Pass 全部完成之后运行
+ */
+int
+test_pipeline_sequential()
+{
+  SUITE_START("Pass Pipeline: Sequential");
+
+  IRContext *ctx = ir_context_create();
+  char *text = make_source(5);
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the generated module");
+
+  IRPassPipeline *pipeline = ir_pass_pipeline_create();
+  SUITE_ASSERT(pipeline != NULL, "Failed to create the pipeline");
+  ir_pass_pipeline_set_verify_each(pipeline, true);
+  ir_pass_pipeline_add_function_pass(pipeline, "mem2reg", ir_transform_mem2reg_run_with_analyses);
+  ir_pass_pipeline_add_function_pass(pipeline, "count", counting_function_pass);
+  ir_pass_pipeline_add_module_pass(pipeline, "module-count", counting_module_pass);
+
+  reset_counters();
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  bool changed = false;
+  SUITE_ASSERT(ir_pass_pipeline_run(pipeline, mod, am, &changed), "Pipeline should succeed");
+  SUITE_ASSERT(changed, "mem2reg should report a change");
+  SUITE_ASSERT(atomic_load(&g_function_pass_calls) == 5, "Function pass ran %zu times, expected 5",
+               atomic_load(&g_function_pass_calls));
+  SUITE_ASSERT(g_module_pass_calls == 1, "Module pass ran %zu times", g_module_pass_calls);
+  SUITE_ASSERT(g_calls_seen_by_module_pass == 5, "Module pass ran before the function group finished");
+  SUITE_ASSERT(count_opcode_in_module(mod, IR_OP_ALLOCA) == 0 && count_opcode_in_module(mod, IR_OP_LOAD) == 0,
+               "All allocas should be promoted");
+  /// 单线程时函数 Pass 使用调用者的 am，mem2reg 保留 CFG 分析，验证器的支配树留在缓存中
+  IRFunction *f0 = list_entry(mod->functions.next, IRFunction, list_node);
+  SUITE_ASSERT(ir_analysis_is_cached(am, f0, IR_ANALYSIS_DOM_TREE), "Dominator tree should stay cached in am");
+
+  /// 没有变化时 out_changed 为 false
+  ir_pass_pipeline_destroy(pipeline);
+  pipeline = ir_pass_pipeline_create();
+  ir_pass_pipeline_add_function_pass(pipeline, "mem2reg", ir_transform_mem2reg_run_with_analyses);
+  SUITE_ASSERT(ir_pass_pipeline_run(pipeline, mod, am, &changed), "Second run should succeed");
+  SUITE_ASSERT(!changed, "Nothing is left to promote");
+
+  IDList *iter;
+  int k = 0;
+  list_for_each(&mod->functions, iter)
+  {
+    int32_t result = 0;
+    SUITE_ASSERT(run_i32(NULL, list_entry(iter, IRFunction, list_node), 10, &result), "f%d failed to run", k);
+    SUITE_ASSERT(result == (k % 7 + 1) * 45, "f%d(10) = %d", k, result);
+    k++;
+  }
+
+  ir_analysis_manager_destroy(am);
+  ir_pass_pipeline_destroy(pipeline);
+  free(text);
+  ir_context_destroy(ctx);
+  SUITE_END();
+}
+
+/**
+ * @brief 并行: 输出与单线程逐字节相同，每个函数恰好被处理一次
+ */
+int
+test_pipeline_parallel()
+{
+  SUITE_START("Pass Pipeline: Parallel");
+
+  const int num_functions = 200;
+  IRContext *ctx = ir_context_create();
+  char *text = make_source(num_functions);
+  IRModule *seq = ir_parse_module(ctx, text);
+  IRModule *par = ir_parse_module(ctx, text);
+  SUITE_ASSERT(seq != NULL && par != NULL, "Failed to parse the generated module");
+
+  IRPassPipeline *pipeline = ir_pass_pipeline_create();
+  ir_pass_pipeline_set_verify_each(pipeline, true);
+  ir_pass_pipeline_add_function_pass(pipeline, "mem2reg", ir_transform_mem2reg_run_with_analyses);
+  ir_pass_pipeline_add_function_pass(pipeline, "count", counting_function_pass);
+  ir_pass_pipeline_add_module_pass(pipeline, "module-count", counting_module_pass);
+  ir_pass_pipeline_add_function_pass(pipeline, "count-again", counting_function_pass);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  reset_counters();
+  SUITE_ASSERT(ir_pass_pipeline_run(pipeline, seq, am, NULL), "Sequential run should succeed");
+
+  /// 先在 am 中缓存一个旧的支配树：并行运行之后它必须失效。
+  /// 模块 Pass 没有修改任何函数，而函数在各自的 Pass 之后已经通过验证，所以之后的增量验证不再计算支配树
+  IRFunction *first = list_entry(par->functions.next, IRFunction, list_node);
+  SUITE_ASSERT(ir_analysis_get_dom_tree(am, first) != NULL, "Failed to cache a dominator tree");
+  size_t computed_before = ir_analysis_num_computed(am, IR_ANALYSIS_DOM_TREE);
+
+  reset_counters();
+  ir_pass_pipeline_set_num_threads(pipeline, 8);
+  bool changed = false;
+  SUITE_ASSERT(ir_pass_pipeline_run(pipeline, par, am, &changed), "Parallel run should succeed");
+  SUITE_ASSERT(changed, "mem2reg should report a change");
+  SUITE_ASSERT(atomic_load(&g_function_pass_calls) == 2 * (size_t)num_functions, "Function passes ran %zu times",
+               atomic_load(&g_function_pass_calls));
+  SUITE_ASSERT(g_calls_seen_by_module_pass == (size_t)num_functions,
+               "Module pass saw %zu calls, expected the whole first group", g_calls_seen_by_module_pass);
+  size_t recomputed = ir_analysis_num_computed(am, IR_ANALYSIS_DOM_TREE) - computed_before;
+  SUITE_ASSERT(!ir_analysis_is_cached(am, first, IR_ANALYSIS_DOM_TREE), "The stale dominator tree should be dropped");
+  SUITE_ASSERT(recomputed == 0, "%zu dominator trees recomputed for unchanged functions", recomputed);
+
+  Bump arena;
+  bump_init(&arena);
+  const char *seq_text = ir_module_dump_to_string(seq, &arena);
+  const char *par_text = ir_module_dump_to_string(par, &arena);
+  SUITE_ASSERT(strcmp(seq_text, par_text) == 0, "Parallel output differs from the sequential output");
+  bump_destroy(&arena);
+
+  int32_t result = 0;
+  IRFunction *last = list_entry(par->functions.prev, IRFunction, list_node);
+  SUITE_ASSERT(run_i32(NULL, last, 100, &result), "Failed to run the last function");
+  SUITE_ASSERT(result == ((num_functions - 1) % 7 + 1) * 4950, "Wrong result %d", result);
+
+  ir_analysis_manager_destroy(am);
+  ir_pass_pipeline_destroy(pipeline);
+  free(text);
+  ir_context_destroy(ctx);
+  SUITE_END();
+}
+
+/**
+ * @brief 验证失败: run 返回 false，之后的 Pass 不再运行
+ */
+int
+test_pipeline_verify_failure()
+{
+  SUITE_START("Pass Pipeline: Verification Failure");
+
+  IRContext *ctx = ir_context_create();
+  char *text = make_source(3);
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the generated module");
+
+  IRPassPipeline *pipeline = ir_pass_pipeline_create();
+  ir_pass_pipeline_add_function_pass(pipeline, "break", breaking_function_pass);
+  ir_pass_pipeline_add_function_pass(pipeline, "count", counting_function_pass);
+  ir_pass_pipeline_add_module_pass(pipeline, "module-count", counting_module_pass);
+
+  /// 不验证时流水线照常跑完
+  reset_counters();
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_pass_pipeline_run(pipeline, mod, am, NULL), "Without verification the run should succeed");
+  SUITE_ASSERT(g_module_pass_calls == 1, "Module pass should run");
+
+  reset_counters();
+  ir_pass_pipeline_set_verify_each(pipeline, true);
+  fprintf(stderr, "--- (expected verifier errors below) ---\n");
+  SUITE_ASSERT(!ir_pass_pipeline_run(pipeline, mod, am, NULL), "Broken IR should fail verification");
+  SUITE_ASSERT(atomic_load(&g_function_pass_calls) == 0, "No pass should run after the failing one");
+  SUITE_ASSERT(g_module_pass_calls == 0, "The module pass should not run after a failure");
+
+  ir_analysis_manager_destroy(am);
+  ir_pass_pipeline_destroy(pipeline);
+  free(text);
+  ir_context_destroy(ctx);
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Pass Pipeline";
+
+  __calir_total_suites_run++;
+  if (test_pipeline_sequential() != 0)
+    __calir_total_suites_failed++;
+
+  __calir_total_suites_run++;
+  if (test_pipeline_parallel() != 0)
+    __calir_total_suites_failed++;
+
+  __calir_total_suites_run++;
+  if (test_pipeline_verify_failure() != 0)
+    __calir_total_suites_failed++;
+
+  TEST_SUMMARY();
+}
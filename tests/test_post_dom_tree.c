@@ -0,0 +1,372 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/cfg.h"
+#include "analysis/dom_frontier.h"
+#include "analysis/dom_tree.h"
+#include "analysis/post_dom_tree.h"
+#include "ir/basicblock.h"
+#include "ir/builder.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/type.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+
+enum
+{
+  MAX_BLOCKS = 48
+};
+
+/**
+ * @brief 两个 ret: 汇合到虚拟出口；后支配边界就是控制依赖
+ */
+int
+test_post_dom_tree_basic()
+{
+  SUITE_START("Post-Dominator Tree: Multiple Returns");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%c: i1, %d: i1) {\n"
+                             "$entry:\n"
+                             "  br %c: i1, $then, $else\n"
+                             "$then:\n"
+                             "  br %d: i1, $early, $join\n"
+                             "$early:\n"
+                             "  ret 0: i32\n"
+                             "$else:\n"
+                             "  br $join\n"
+                             "$join:\n"
+                             "  ret 1: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The module should parse");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRBasicBlock *entry = find_block(func, "entry");
+  IRBasicBlock *then = find_block(func, "then");
+  IRBasicBlock *early = find_block(func, "early");
+  IRBasicBlock *else_ = find_block(func, "else");
+  IRBasicBlock *join = find_block(func, "join");
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  PostDominatorTree *pdt = post_dom_tree_build(cfg, &arena);
+  SUITE_ASSERT(pdt != NULL, "The post-dominator tree should build");
+  SUITE_ASSERT(pdt->virtual_exit->id == cfg->num_nodes && pdt->virtual_exit->block == NULL,
+               "The virtual exit should be the extra node");
+  SUITE_ASSERT(pdt->virtual_exit->num_succs == 2, "Both returns should hang off the virtual exit");
+  SUITE_ASSERT(pdt->tree->num_reachable == cfg->num_nodes + 1, "Every block should be in the tree");
+
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, else_) == join, "ipdom(else) is join");
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, then) == NULL, "then reaches two returns");
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, entry) == NULL, "entry reaches two returns");
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, join) == NULL, "A return is post-dominated by the virtual exit");
+  SUITE_ASSERT(post_dom_tree_postdominates(pdt, join, else_), "join post-dominates else");
+  SUITE_ASSERT(!post_dom_tree_postdominates(pdt, join, then), "join does not post-dominate then");
+  SUITE_ASSERT(!post_dom_tree_postdominates(pdt, join, entry), "join does not post-dominate entry");
+  SUITE_ASSERT(post_dom_tree_postdominates(pdt, then, then), "Post-dominance is reflexive");
+
+  /// join 控制依赖于 entry 和 then 的分支；early 只依赖 then；else 只依赖 entry
+  DominanceFrontier *pdf = post_dom_frontier_compute(pdt, &arena);
+  const DomFrontierSet *join_set = ir_analysis_dom_frontier_get(pdf, join);
+  SUITE_ASSERT(join_set->count == 2 && ir_analysis_dom_frontier_contains(pdf, join, entry) &&
+                   ir_analysis_dom_frontier_contains(pdf, join, then),
+               "PDF(join) should be {entry, then}");
+  const DomFrontierSet *early_set = ir_analysis_dom_frontier_get(pdf, early);
+  SUITE_ASSERT(early_set->count == 1 && early_set->ids[0] == then->id, "PDF(early) should be {then}");
+  const DomFrontierSet *else_set = ir_analysis_dom_frontier_get(pdf, else_);
+  SUITE_ASSERT(else_set->count == 1 && else_set->ids[0] == entry->id, "PDF(else) should be {entry}");
+  SUITE_ASSERT(ir_analysis_dom_frontier_get(pdf, entry)->count == 0, "entry is not control dependent");
+
+  post_dom_tree_destroy(pdt);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 无限循环: 到不了出口的块也挂在虚拟出口下面
+ */
+int
+test_post_dom_tree_infinite_loop()
+{
+  SUITE_START("Post-Dominator Tree: Infinite Loop");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define void @g(%c: i1) {\n"
+                             "$entry:\n"
+                             "  br %c: i1, $head, $exit\n"
+                             "$head:\n"
+                             "  br $body\n"
+                             "$body:\n"
+                             "  br $head\n"
+                             "$exit:\n"
+                             "  ret void\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The module should parse");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+  IRBasicBlock *entry = find_block(func, "entry");
+  IRBasicBlock *head = find_block(func, "head");
+  IRBasicBlock *body = find_block(func, "body");
+  IRBasicBlock *exit = find_block(func, "exit");
+
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  PostDominatorTree *pdt = post_dom_tree_build(cfg, &arena);
+  SUITE_ASSERT(pdt->tree->num_reachable == cfg->num_nodes + 1, "The loop should be in the tree");
+  SUITE_ASSERT(pdt->virtual_exit->num_succs == 2, "The virtual exit should point at the return and the loop");
+
+  /// 循环中 id 最大的块 (body) 被当作出口
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, body) == NULL, "body is the loop's stand-in exit");
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, head) == body, "ipdom(head) is body");
+  SUITE_ASSERT(post_dom_tree_get_ipdom(pdt, entry) == NULL, "entry reaches the return and the loop");
+  SUITE_ASSERT(!post_dom_tree_postdominates(pdt, exit, entry), "exit does not post-dominate entry");
+
+  post_dom_tree_destroy(pdt);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief [内部] 在 cfg 中从 start 出发、不经过 avoid 能否到达 target
+ */
+static bool
+reaches_avoiding(FunctionCFG *cfg, int start, int avoid, int target)
+{
+  bool seen[MAX_BLOCKS + 1] = {0};
+  int stack[MAX_BLOCKS + 1];
+  int top = 0;
+  if (start == avoid)
+    return false;
+  stack[top++] = start;
+  seen[start] = true;
+  while (top > 0)
+  {
+    int id = stack[--top];
+    if (id == target)
+      return true;
+    for (int i = 0; i < cfg->nodes[id].num_succs; i++)
+    {
+      int succ = cfg->nodes[id].succs[i];
+      if (succ != avoid && !seen[succ])
+      {
+        seen[succ] = true;
+        stack[top++] = succ;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 从 start 出发、不经过 avoid 能否到达一个 ret
+ */
+static bool
+reaches_return_avoiding(FunctionCFG *cfg, int start, int avoid)
+{
+  for (int i = 0; i < cfg->num_nodes; i++)
+  {
+    if (cfg->nodes[i].num_succs == 0 && reaches_avoiding(cfg, start, avoid, i))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief [内部] 用 builder 构建一个随机 CFG: 每个块以 ret、br 或条件 br 结束
+ */
+static IRFunction *
+build_random_cfg(IRContext *ctx, IRModule *mod, IRBuilder *b, uint32_t *seed, int num_blocks)
+{
+  IRFunction *func = ir_function_create(mod, "random_cfg", ir_type_get_void(ctx));
+  IRArgument *cond = ir_argument_create(func, ir_type_get_i1(ctx), "c");
+  ir_function_finalize_signature(func, false);
+
+  IRBasicBlock *blocks[MAX_BLOCKS];
+  for (int i = 0; i < num_blocks; i++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "b%d", i);
+    blocks[i] = ir_basic_block_create(func, name);
+    ir_function_append_basic_block(func, blocks[i]);
+  }
+
+  for (int i = 0; i < num_blocks; i++)
+  {
+    ir_builder_set_insertion_point(b, blocks[i]);
+    *seed = *seed * 1664525u + 1013904223u;
+    uint32_t r = *seed >> 8;
+    IRBasicBlock *t = blocks[(r >> 4) % num_blocks];
+    IRBasicBlock *f = blocks[(r >> 12) % num_blocks];
+    switch (r % 8)
+    {
+    case 0:
+      ir_builder_create_ret(b, NULL);
+      break;
+    case 1:
+    case 2:
+      ir_builder_create_br(b, &t->label_address);
+      break;
+    default:
+      ir_builder_create_cond_br(b, &cond->value, &t->label_address, &f->label_address);
+      break;
+    }
+  }
+  return func;
+}
+
+/**
+ * @brief 随机 CFG: 反向 CFG 是正向的转置；两种算法一致；
+ * 所有块都能到达 ret 时，后支配关系与朴素定义逐对一致
+ */
+int
+test_post_dom_tree_random()
+{
+  SUITE_START("Post-Dominator Tree: Random CFGs");
+
+  IRContext *ctx = ir_context_create();
+  IRBuilder *b = ir_builder_create(ctx);
+  uint32_t seed = 4242;
+
+  size_t bad_edges = 0;
+  size_t mismatches = 0;
+  size_t naive_mismatches = 0;
+  size_t pdf_mismatches = 0;
+  size_t checked = 0;
+  for (int round = 0; round < 300; round++)
+  {
+    IRModule *mod = ir_module_create(ctx, "pdom");
+    int num_blocks = 2 + round % (MAX_BLOCKS - 2);
+    IRFunction *func = build_random_cfg(ctx, mod, b, &seed, num_blocks);
+
+    Bump arena;
+    bump_init(&arena);
+    FunctionCFG *cfg = cfg_build(func, &arena);
+    PostDominatorTree *pdt = post_dom_tree_build(cfg, &arena);
+    PostDominatorTree *chk = post_dom_tree_build_with_algorithm(cfg, &arena, DOM_TREE_COOPER_HARVEY_KENNEDY);
+    DominanceFrontier *pdf = post_dom_frontier_compute(pdt, &arena);
+    FunctionCFG *rev = pdt->reverse_cfg;
+
+    bool all_reach_return = true;
+    for (int i = 0; i < num_blocks; i++)
+    {
+      const CFGNode *fwd = &cfg->nodes[i];
+      const CFGNode *node = &rev->nodes[i];
+      bool is_exit = false;
+      for (int k = 0; k < node->num_preds; k++)
+        is_exit |= node->preds[k] == pdt->virtual_exit->id;
+      if (node->num_succs != fwd->num_preds || node->num_preds != fwd->num_succs + (is_exit ? 1 : 0))
+        bad_edges++;
+      if (fwd->num_succs == 0 && !is_exit)
+        bad_edges++;
+      if (!reaches_return_avoiding(cfg, i, -1))
+        all_reach_return = false;
+    }
+    if (pdt->tree->num_reachable != num_blocks + 1)
+      bad_edges++;
+
+    for (int bi = 0; bi < num_blocks; bi++)
+    {
+      IRBasicBlock *block = cfg->nodes[bi].block;
+      if (post_dom_tree_get_ipdom(pdt, block) != post_dom_tree_get_ipdom(chk, block))
+        mismatches++;
+      for (int ai = 0; ai < num_blocks; ai++)
+      {
+        IRBasicBlock *a = cfg->nodes[ai].block;
+        bool actual = post_dom_tree_postdominates(pdt, a, block);
+        /// 反向 CFG 上的朴素定义: 从虚拟出口出发不经过 a 到不了 b
+        bool expected = ai == bi || !reaches_avoiding(rev, pdt->virtual_exit->id, ai, bi);
+        if (actual != expected)
+          mismatches++;
+        if (all_reach_return && actual != (ai == bi || !reaches_return_avoiding(cfg, bi, ai)))
+          naive_mismatches++;
+      }
+      /// y 在 PDF(b) 中: b 后支配 y 的某个后继，且不严格后支配 y
+      for (int yi = 0; yi < num_blocks; yi++)
+      {
+        IRBasicBlock *y = cfg->nodes[yi].block;
+        bool expected = false;
+        for (int k = 0; k < cfg->nodes[yi].num_succs; k++)
+          expected |= post_dom_tree_postdominates(pdt, block, cfg_succ(cfg, &cfg->nodes[yi], k)->block);
+        if (bi != yi && post_dom_tree_postdominates(pdt, block, y))
+          expected = false;
+        if (ir_analysis_dom_frontier_contains(pdf, block, y) != expected)
+          pdf_mismatches++;
+      }
+    }
+    if (all_reach_return)
+      checked++;
+
+    post_dom_tree_destroy(chk);
+    post_dom_tree_destroy(pdt);
+    cfg_destroy(cfg);
+    bump_destroy(&arena);
+  }
+  SUITE_ASSERT(bad_edges == 0, "%zu reverse CFG nodes are not the transpose of the forward CFG", bad_edges);
+  SUITE_ASSERT(mismatches == 0, "%zu post-dominance queries disagree with the reverse CFG", mismatches);
+  SUITE_ASSERT(naive_mismatches == 0, "%zu post-dominance queries disagree with the path definition",
+               naive_mismatches);
+  SUITE_ASSERT(pdf_mismatches == 0, "%zu post-dominance frontier bits disagree with the definition", pdf_mismatches);
+  SUITE_ASSERT(checked > 0, "Some random CFGs should have no infinite loops");
+
+  ir_builder_destroy(b);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Post-Dominator Tree";
+  __calir_total_suites_run++;
+  if (test_post_dom_tree_basic() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_post_dom_tree_infinite_loop() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_post_dom_tree_random() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  TEST_SUMMARY();
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "analysis/cfg.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+#include "transforms/sccp.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/bump.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief [辅助] 在新的 CFG 上运行 SCCP
+ */
+static bool
+run_sccp(IRFunction *func, bool *out_cfg_changed)
+{
+  Bump arena;
+  bump_init(&arena);
+  FunctionCFG *cfg = cfg_build(func, &arena);
+  bool changed = ir_transform_sccp_run(func, cfg, out_cfg_changed);
+  cfg_destroy(cfg);
+  bump_destroy(&arena);
+  return changed;
+}
+
+/**
+ * @brief 条件是常量的分支: 不走的一侧被删除，汇合处的 phi 只剩一条入边并折叠成常量
+ */
+int
+test_sccp_constant_branch()
+{
+  SUITE_START("SCCP: Constant Branch");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = add 3: i32, 4: i32\n"
+                             "  %c: i1 = icmp slt %a: i32, 10: i32\n"
+                             "  br %c: i1, $then, $else\n"
+                             "$then:\n"
+                             "  %t: i32 = mul %a: i32, 2: i32\n"
+                             "  br $merge\n"
+                             "$else:\n"
+                             "  %e: i32 = add %n: i32, 1: i32\n"
+                             "  br $merge\n"
+                             "$merge:\n"
+                             "  %p: i32 = phi [ %t: i32, $then ], [ %e: i32, $else ]\n"
+                             "  %r: i32 = add %p: i32, %n: i32\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SCCP snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &before) && before == 19, "Expected 19 before SCCP, got %d", before);
+
+  bool cfg_changed = false;
+  SUITE_ASSERT(run_sccp(func, &cfg_changed), "SCCP should change the function");
+  SUITE_ASSERT(cfg_changed, "Folding the branch should change the CFG");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after SCCP");
+
+  SUITE_ASSERT(count_opcode(func, IR_OP_COND_BR) == 0, "The constant branch should become a br");
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 0, "The phi should fold to a constant");
+  SUITE_ASSERT(count_opcode(func, IR_OP_ICMP) == 0, "The compare should fold to a constant");
+  SUITE_ASSERT(count_opcode(func, IR_OP_MUL) == 0, "The multiply should fold to a constant");
+  SUITE_ASSERT(count_opcode(func, IR_OP_ADD) == 1, "Only the add of the argument should remain");
+
+  size_t num_blocks = count_blocks(func);
+  SUITE_ASSERT(num_blocks == 3, "$else should be removed, %zu blocks remain", num_blocks);
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 5, &after) && after == before, "Expected %d after SCCP, got %d", before, after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 循环中的 phi: x 在每次迭代都是 1 (乐观假设在回边上成立)，计数器 i 不是常量
+ */
+int
+test_sccp_loop_phi()
+{
+  SUITE_START("SCCP: Loop Phi");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  %x.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  store 1: i32, %x.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %x: i32 = load %x.slot: <i32>\n"
+                             "  %x2: i32 = mul %x: i32, 1: i32\n"
+                             "  store %x2: i32, %x.slot: <i32>\n"
+                             "  %i2: i32 = add %i: i32, %x2: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  %xe: i32 = load %x.slot: <i32>\n"
+                             "  %r: i32 = add %i: i32, %xe: i32\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SCCP snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  /// 解析器不支持前向引用，循环中的 phi 由 mem2reg 生成
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote the slots");
+  ir_analysis_manager_destroy(am);
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 2, "mem2reg should place two loop phis");
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 7, &before) && before == 8, "Expected 8 before SCCP, got %d", before);
+
+  bool cfg_changed = true;
+  SUITE_ASSERT(run_sccp(func, &cfg_changed), "SCCP should change the function");
+  SUITE_ASSERT(!cfg_changed, "Both loop edges stay executable");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after SCCP");
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 1, "Only the counter phi should remain");
+  SUITE_ASSERT(count_opcode(func, IR_OP_MUL) == 0, "%%x2 should fold to 1");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 7, &after) && after == before, "Expected %d after SCCP, got %d", before, after);
+  SUITE_ASSERT(run_i32(NULL, func, 0, &after) && after == 1, "Expected 1 for n = 0, got %d", after);
+
+  SUITE_ASSERT(!run_sccp(func, NULL), "A second run should change nothing");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 解释器会报错的运算 (除以零) 不折叠；switch 按常量条件只保留一个目标
+ */
+int
+test_sccp_traps_and_switch()
+{
+  SUITE_START("SCCP: Traps and Switch");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %k: i32 = sub 7: i32, 5: i32\n"
+                             "  switch %k: i32, default $default [\n"
+                             "    1: i32, $one\n"
+                             "    2: i32, $two\n"
+                             "  ]\n"
+                             "$one:\n"
+                             "  br $merge\n"
+                             "$two:\n"
+                             "  %z: i32 = sub %k: i32, 2: i32\n"
+                             "  %q: i32 = sdiv %n: i32, %z: i32\n"
+                             "  %d: i32 = sdiv 1: i32, %z: i32\n"
+                             "  br $merge\n"
+                             "$default:\n"
+                             "  br $merge\n"
+                             "$merge:\n"
+                             "  %p: i32 = phi [ 10: i32, $one ], [ %d: i32, $two ], [ 30: i32, $default ]\n"
+                             "  ret %p: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SCCP snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  bool cfg_changed = false;
+  SUITE_ASSERT(run_sccp(func, &cfg_changed), "SCCP should change the function");
+  SUITE_ASSERT(cfg_changed, "Folding the switch should change the CFG");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after SCCP");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SWITCH) == 0, "The constant switch should become a br");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SDIV) == 2, "Divisions by zero must not be folded");
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 1, "A phi fed by a trapping division stays");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SUB) == 0, "%%k and %%z should fold");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 通过分析管理器运行: 只替换常量时保留 CFG 分析，改变控制流时全部失效
+ */
+int
+test_sccp_with_analyses()
+{
+  SUITE_START("SCCP: Analysis Manager");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @consts(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = shl 1: i32, 4: i32\n"
+                             "  %r: i32 = add %a: i32, %n: i32\n"
+                             "  ret %r: i32\n"
+                             "}\n"
+                             "define i32 @branch(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %c: i1 = icmp eq 1: i32, 2: i32\n"
+                             "  br %c: i1, $dead, $live\n"
+                             "$dead:\n"
+                             "  ret 0: i32\n"
+                             "$live:\n"
+                             "  ret %n: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SCCP snippet");
+  IRFunction *consts = list_entry(mod->functions.next, IRFunction, list_node);
+  IRFunction *branch = list_entry(mod->functions.next->next, IRFunction, list_node);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_analysis_get_cfg(am, consts) && ir_analysis_get_cfg(am, branch), "CFGs should be computed");
+
+  SUITE_ASSERT(ir_transform_sccp_run_with_analyses(consts, am), "SCCP should fold the shift");
+  SUITE_ASSERT(ir_analysis_is_cached(am, consts, IR_ANALYSIS_CFG), "Replacing constants preserves the CFG");
+
+  SUITE_ASSERT(ir_transform_sccp_run_with_analyses(branch, am), "SCCP should fold the branch");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, branch, IR_ANALYSIS_CFG), "Removing a block invalidates the CFG");
+  SUITE_ASSERT(ir_verify_function(branch), "Function should verify after SCCP");
+
+  int32_t result = 0;
+  SUITE_ASSERT(run_i32(NULL, consts, 2, &result) && result == 18, "Expected 18, got %d", result);
+  SUITE_ASSERT(run_i32(NULL, branch, 9, &result) && result == 9, "Expected 9, got %d", result);
+
+  ir_analysis_manager_destroy(am);
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "SCCP";
+  __calir_total_suites_run++;
+  if (test_sccp_constant_branch() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_sccp_loop_phi() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_sccp_traps_and_switch() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_sccp_with_analyses() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "interpreter/interpreter.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+#include "transforms/simplify_cfg.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+#include "utils/data_layout.h"
+
+/**
+ * @brief 常量条件的 cond_br 和 switch 变成 br，不可达的块被删除，剩下的直线链合并成一个块
+ */
+int
+test_simplify_cfg_constant_branches()
+{
+  SUITE_START("SimplifyCFG: Constant Branches");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %a: i32 = add %n: i32, 1: i32\n"
+                             "  br 1: i1, $then, $else\n"
+                             "$then:\n"
+                             "  %t: i32 = mul %a: i32, 2: i32\n"
+                             "  br $merge\n"
+                             "$else:\n"
+                             "  %e: i32 = sub %a: i32, 2: i32\n"
+                             "  br $merge\n"
+                             "$merge:\n"
+                             "  %p: i32 = phi [ %t: i32, $then ], [ %e: i32, $else ]\n"
+                             "  switch 3: i32, default $d [\n"
+                             "    1: i32, $c1\n"
+                             "    3: i32, $c3\n"
+                             "  ]\n"
+                             "$c1:\n"
+                             "  br $out\n"
+                             "$c3:\n"
+                             "  %x: i32 = add %p: i32, 10: i32\n"
+                             "  br $out\n"
+                             "$d:\n"
+                             "  br $out\n"
+                             "$out:\n"
+                             "  %r: i32 = phi [ 0: i32, $c1 ], [ %x: i32, $c3 ], [ %p: i32, $d ]\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SimplifyCFG snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 4, &before) && before == 20, "Expected 20 before SimplifyCFG, got %d", before);
+
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_analysis_get_cfg(am, func) != NULL, "CFG should build");
+  SUITE_ASSERT(ir_transform_simplify_cfg_run_with_analyses(func, am), "SimplifyCFG should change the function");
+  SUITE_ASSERT(!ir_analysis_is_cached(am, func, IR_ANALYSIS_CFG), "Changing the CFG must invalidate it");
+  ir_analysis_manager_destroy(am);
+
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after SimplifyCFG");
+  SUITE_ASSERT(count_blocks(func) == 1, "Everything should merge into the entry block, got %zu blocks",
+               count_blocks(func));
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 0, "Single-entry phis should be replaced");
+  SUITE_ASSERT(count_opcode(func, IR_OP_SUB) == 0, "The unreachable $else should be gone");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 4, &after) && after == before,
+               "Expected %d after SimplifyCFG, got %d", before, after);
+  SUITE_ASSERT(!ir_transform_simplify_cfg_run(func), "A second run should change nothing");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 前驱穿过空块直接跳到目标；会让 phi 出现矛盾的入边的前驱不穿过
+ */
+int
+test_simplify_cfg_threading()
+{
+  SUITE_START("SimplifyCFG: Jump Threading");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @thread(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %c: i1 = icmp slt %n: i32, 0: i32\n"
+                             "  br %c: i1, $fwd, $b\n"
+                             "$fwd:\n"
+                             "  br $fwd2\n"
+                             "$fwd2:\n"
+                             "  br $join\n"
+                             "$b:\n"
+                             "  %x: i32 = add %n: i32, 5: i32\n"
+                             "  %c2: i1 = icmp sgt %x: i32, 100: i32\n"
+                             "  br %c2: i1, $fwd2, $join\n"
+                             "$join:\n"
+                             "  %p: i32 = phi [ 1: i32, $fwd2 ], [ %x: i32, $b ]\n"
+                             "  ret %p: i32\n"
+                             "}\n"
+                             "\n"
+                             "define i32 @conflict(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %c: i1 = icmp slt %n: i32, 0: i32\n"
+                             "  br %c: i1, $fwd, $join\n"
+                             "$fwd:\n"
+                             "  br $join\n"
+                             "$join:\n"
+                             "  %p: i32 = phi [ 1: i32, $fwd ], [ 2: i32, $entry ]\n"
+                             "  ret %p: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SimplifyCFG snippet");
+  IRFunction *thread = list_entry(mod->functions.next, IRFunction, list_node);
+  IRFunction *conflict = list_entry(mod->functions.next->next, IRFunction, list_node);
+
+  int32_t inputs[] = {-3, 7, 200};
+  int32_t before[3];
+  for (int i = 0; i < 3; i++)
+    SUITE_ASSERT(run_i32(NULL, thread, inputs[i], &before[i]), "Running @thread before SimplifyCFG failed");
+
+  SUITE_ASSERT(ir_transform_simplify_cfg_run(thread), "SimplifyCFG should thread through $fwd and $fwd2");
+  SUITE_ASSERT(ir_verify_function(thread), "@thread should verify after SimplifyCFG");
+  /// $entry 穿过 $fwd 和 $fwd2 直接跳到 $join；$b 已经跳到 $join 而且给 %p 的值不同，仍然经过 $fwd2
+  SUITE_ASSERT(!find_block(thread, "fwd"), "$fwd should be gone");
+  SUITE_ASSERT(find_block(thread, "fwd2") != NULL, "$fwd2 is still needed by $b");
+  SUITE_ASSERT(count_blocks(thread) == 4, "Expected 4 blocks, got %zu", count_blocks(thread));
+  for (int i = 0; i < 3; i++)
+  {
+    int32_t after = 0;
+    SUITE_ASSERT(run_i32(NULL, thread, inputs[i], &after) && after == before[i], "@thread(%d): expected %d, got %d",
+                 inputs[i], before[i], after);
+  }
+
+  /// $entry 已经跳到 $join，而 $fwd 和 $entry 给 %p 的值不同
+  SUITE_ASSERT(!ir_transform_simplify_cfg_run(conflict), "@conflict must not change");
+  SUITE_ASSERT(find_block(conflict, "fwd") != NULL, "$fwd must stay");
+  SUITE_ASSERT(ir_verify_function(conflict), "@conflict should still verify");
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 循环中空的 latch 被穿过，header 的 phi 改为来自循环体
+ */
+int
+test_simplify_cfg_loop()
+{
+  SUITE_START("SimplifyCFG: Loop");
+
+  IRContext *ctx = ir_context_create();
+  static const char text[] = "define i32 @f(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %i.slot: <i32> = alloc i32\n"
+                             "  %s.slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %i.slot: <i32>\n"
+                             "  store 0: i32, %s.slot: <i32>\n"
+                             "  br $pre\n"
+                             "$pre:\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %i.slot: <i32>\n"
+                             "  %c: i1 = icmp slt %i: i32, %n: i32\n"
+                             "  br %c: i1, $body, $exit\n"
+                             "$body:\n"
+                             "  %s: i32 = load %s.slot: <i32>\n"
+                             "  %s2: i32 = add %s: i32, %i: i32\n"
+                             "  store %s2: i32, %s.slot: <i32>\n"
+                             "  %i2: i32 = add %i: i32, 1: i32\n"
+                             "  store %i2: i32, %i.slot: <i32>\n"
+                             "  br $latch\n"
+                             "$latch:\n"
+                             "  br $loop\n"
+                             "$exit:\n"
+                             "  %r: i32 = load %s.slot: <i32>\n"
+                             "  ret %r: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the SimplifyCFG snippet");
+  IRFunction *func = list_entry(mod->functions.next, IRFunction, list_node);
+
+  /// 解析器不支持前向引用，循环中的 phi 由 mem2reg 生成
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote the slots");
+  ir_analysis_manager_destroy(am);
+
+  int32_t before = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 6, &before) && before == 15, "Expected 15 before SimplifyCFG, got %d", before);
+
+  SUITE_ASSERT(ir_transform_simplify_cfg_run(func), "SimplifyCFG should change the function");
+  SUITE_ASSERT(ir_verify_function(func), "Function should verify after SimplifyCFG");
+  SUITE_ASSERT(!find_block(func, "pre") && !find_block(func, "latch"), "$pre and $latch should be gone");
+  SUITE_ASSERT(count_blocks(func) == 4, "Expected $entry, $loop, $body and $exit, got %zu blocks",
+               count_blocks(func));
+  SUITE_ASSERT(count_opcode(func, IR_OP_PHI) == 2, "The loop phis must stay");
+
+  int32_t after = 0;
+  SUITE_ASSERT(run_i32(NULL, func, 6, &after) && after == before,
+               "Expected %d after SimplifyCFG, got %d", before, after);
+  SUITE_ASSERT(run_i32(NULL, func, 0, &after) && after == 0, "Expected 0 for n = 0, got %d", after);
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "SimplifyCFG";
+  __calir_total_suites_run++;
+  if (test_simplify_cfg_constant_branches() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_simplify_cfg_threading() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_simplify_cfg_loop() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+  TEST_SUMMARY();
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/bump.h"
+#include "utils/small_vec.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#include "test_utils.h"
+
+SMALL_VEC_DEFINE(U32Vec, u32_vec, uint32_t, 4)
+
+/** @brief 比指针大、对齐要求也更高的元素 */
+typedef struct Wide
+{
+  uint64_t a;
+  double b;
+  uint32_t c;
+} Wide;
+
+SMALL_VEC_DEFINE(WideVec, wide_vec, Wide, 2)
+
+int
+test_inline_and_spill(Bump *arena)
+{
+  SUITE_START("SmallVec: inline storage and spilling");
+
+  U32Vec vec;
+  u32_vec_init(&vec, arena);
+  SUITE_ASSERT(u32_vec_len(&vec) == 0 && u32_vec_is_inline(&vec), "New vector should be empty and inline");
+
+  size_t before = bump_get_allocated_bytes(arena);
+  for (uint32_t i = 0; i < 4; i++)
+    SUITE_ASSERT(u32_vec_push(&vec, i * 10), "Push #%u should succeed", i);
+  SUITE_ASSERT(u32_vec_is_inline(&vec), "4 elements should stay inline");
+  SUITE_ASSERT(bump_get_allocated_bytes(arena) == before, "Inline pushes should not touch the arena");
+
+  for (uint32_t i = 4; i < 100; i++)
+    SUITE_ASSERT(u32_vec_push(&vec, i * 10), "Push #%u should succeed", i);
+  SUITE_ASSERT(!u32_vec_is_inline(&vec), "100 elements should spill to the arena");
+  SUITE_ASSERT(u32_vec_len(&vec) == 100, "Length should be 100, got %zu", u32_vec_len(&vec));
+  bool ok = true;
+  for (uint32_t i = 0; i < 100; i++)
+    ok &= u32_vec_get(&vec, i) == i * 10;
+  SUITE_ASSERT(ok, "Elements should survive spilling and growth");
+
+  SUITE_ASSERT(u32_vec_pop(&vec) == 990, "Pop should return the last element");
+  u32_vec_truncate(&vec, 3);
+  SUITE_ASSERT(u32_vec_len(&vec) == 3, "Truncate should shorten to 3, got %zu", u32_vec_len(&vec));
+  u32_vec_truncate(&vec, 50);
+  SUITE_ASSERT(u32_vec_len(&vec) == 3, "Truncate should never lengthen");
+
+  u32_vec_shrink_to_fit(&vec);
+  SUITE_ASSERT(u32_vec_is_inline(&vec) && vec.capacity == 4, "3 elements should move back inline");
+  SUITE_ASSERT(u32_vec_data(&vec)[2] == 20, "Elements should survive moving back inline");
+
+  u32_vec_clear(&vec);
+  SUITE_ASSERT(u32_vec_len(&vec) == 0, "Clear should empty the vector");
+
+  SUITE_END();
+}
+
+int
+test_reserve(Bump *arena)
+{
+  SUITE_START("SmallVec: reserve and wide elements");
+
+  WideVec vec;
+  wide_vec_init(&vec, arena);
+  SUITE_ASSERT(wide_vec_reserve(&vec, 2) && wide_vec_is_inline(&vec), "Reserving the inline capacity is a no-op");
+  wide_vec_push(&vec, (Wide){.a = 1, .b = 1.5, .c = 7});
+
+  SUITE_ASSERT(wide_vec_reserve(&vec, 50), "Reserve 50 should succeed");
+  SUITE_ASSERT(vec.capacity >= 50 && !wide_vec_is_inline(&vec), "Reserve should spill with capacity >= 50");
+  SUITE_ASSERT(((uintptr_t)wide_vec_data(&vec) % _Alignof(Wide)) == 0, "Spilled data should be aligned");
+  size_t after_reserve = bump_get_allocated_bytes(arena);
+  const Wide *data = wide_vec_data(&vec);
+  for (uint32_t i = 1; i < 50; i++)
+    wide_vec_push(&vec, (Wide){.a = i, .b = i * 0.5, .c = i});
+  SUITE_ASSERT(wide_vec_data(&vec) == data && bump_get_allocated_bytes(arena) == after_reserve,
+               "Pushes within the reserved capacity should not reallocate");
+  SUITE_ASSERT(wide_vec_get(&vec, 0).c == 7 && wide_vec_get(&vec, 49).a == 49, "Wide elements should round-trip");
+
+  /// Arena 达到上限时 push 返回 false，已有元素不变
+  Bump limited;
+  bump_init(&limited);
+  bump_set_allocation_limit(&limited, 0);
+  U32Vec small;
+  u32_vec_init(&small, &limited);
+  for (uint32_t i = 0; i < 4; i++)
+    u32_vec_push(&small, i);
+  SUITE_ASSERT(!u32_vec_push(&small, 4), "Spilling into an exhausted arena should fail");
+  SUITE_ASSERT(u32_vec_len(&small) == 4 && u32_vec_is_inline(&small), "A failed push should leave the vector intact");
+  bump_destroy(&limited);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  Bump arena;
+  bump_init(&arena);
+
+  __calir_current_suite_name = "SmallVec";
+
+  __calir_total_suites_run++;
+  if (test_inline_and_spill(&arena) != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_reserve(&arena) != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  bump_destroy(&arena);
+
+  TEST_SUMMARY();
+}
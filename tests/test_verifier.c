@@ -0,0 +1,371 @@
+/*
+ * Copyright 2025 Karesis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis/analysis_manager.h"
+#include "ir/basicblock.h"
+#include "ir/context.h"
+#include "ir/function.h"
+#include "ir/instruction.h"
+#include "ir/module.h"
+#include "ir/parser.h"
+#include "ir/value.h"
+#include "ir/verifier.h"
+#include "transforms/mem2reg.h"
+#include "utils/string_buf.h"
+
+#include "ir_test_helpers.h"
+#include "test_utils.h"
+
+/**
+ * @brief [辅助] 删掉函数最后一个块的终结指令，让函数无法通过验证
+ */
+static void
+break_function(IRFunction *func)
+{
+  IRBasicBlock *last = list_entry(func->basic_blocks.prev, IRBasicBlock, list_node);
+  ir_instruction_erase_from_parent(list_entry(last->instructions.prev, IRInstruction, list_node));
+}
+
+/**
+ * @brief phi 的入边必须与前驱一一对应；自环的块把自己当作前驱
+ */
+int
+test_verifier_phi()
+{
+  SUITE_START("Verifier: Phi Incoming Blocks");
+
+  IRContext *ctx = ir_context_create();
+  /// 解析器不支持前向引用，自环上的 phi 由 mem2reg 生成
+  static const char loop[] = "define i32 @count(%n: i32) {\n"
+                             "$entry:\n"
+                             "  %slot: <i32> = alloc i32\n"
+                             "  store 0: i32, %slot: <i32>\n"
+                             "  br $loop\n"
+                             "$loop:\n"
+                             "  %i: i32 = load %slot: <i32>\n"
+                             "  %next: i32 = add %i: i32, 1: i32\n"
+                             "  store %next: i32, %slot: <i32>\n"
+                             "  %c: i1 = icmp slt %next: i32, %n: i32\n"
+                             "  br %c: i1, $loop, $exit\n"
+                             "$exit:\n"
+                             "  ret %next: i32\n"
+                             "}\n";
+  IRModule *mod = ir_parse_module(ctx, loop);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the loop snippet");
+  IRFunction *func = find_function(mod, "count");
+  IRAnalysisManager *am = ir_analysis_manager_create();
+  SUITE_ASSERT(ir_transform_mem2reg_run_with_analyses(func, am), "mem2reg should promote the slot");
+  SUITE_ASSERT(ir_verify_function(func), "A phi on a self-loop should verify");
+  SUITE_ASSERT(ir_verify_function_with_analyses(func, am), "A phi on a self-loop should verify with cached analyses");
+  ir_analysis_manager_destroy(am);
+
+  /// 缺少一个前驱、入边不是前驱、同一个前驱出现两次
+  static const char *const broken[] = {
+      "define i32 @f(%c: i1) {\n$entry:\n  br %c: i1, $a, $b\n$a:\n  br $m\n$b:\n  br $m\n"
+      "$m:\n  %p: i32 = phi [ 1: i32, $a ]\n  ret %p: i32\n}\n",
+      "define i32 @f(%c: i1) {\n$entry:\n  br %c: i1, $a, $b\n$a:\n  br $m\n$b:\n  br $m\n"
+      "$m:\n  %p: i32 = phi [ 1: i32, $a ], [ 2: i32, $b ], [ 3: i32, $entry ]\n  ret %p: i32\n}\n",
+      "define i32 @f(%c: i1) {\n$entry:\n  br %c: i1, $a, $b\n$a:\n  br $m\n$b:\n  br $m\n"
+      "$m:\n  %p: i32 = phi [ 1: i32, $a ], [ 2: i32, $a ]\n  ret %p: i32\n}\n",
+  };
+  for (size_t i = 0; i < sizeof(broken) / sizeof(broken[0]); i++)
+  {
+    IRContext *bad_ctx = ir_context_create();
+    SUITE_ASSERT(ir_parse_module(bad_ctx, broken[i]) == NULL, "Broken phi %zu should fail verification", i);
+    ir_context_destroy(bad_ctx);
+  }
+
+  ir_context_destroy(ctx);
+
+  SUITE_END();
+}
+
+/**
+ * @brief [辅助] 生成 count 个互相调用的小函数
+ */
+static char *
+make_module_text(size_t count)
+{
+  size_t cap = count * 512 + 64;
+  char *text = malloc(cap);
+  size_t len = (size_t)snprintf(text, cap, "module = \"many\"\n\n");
+  for (size_t i = 0; i < count; i++)
+  {
+    len += (size_t)snprintf(text + len, cap - len,
+                            "define i32 @f%zu(%%a: i32) {\n"
+                            "$entry:\n"
+                            "  %%c: i1 = icmp slt %%a: i32, 0: i32\n"
+                            "  br %%c: i1, $neg, $pos\n"
+                            "$neg:\n"
+                            "  %%n: i32 = sub 0: i32, %%a: i32\n"
+                            "  br $out\n"
+                            "$pos:\n"
+                            "  %%p: i32 = add %%a: i32, %zu: i32\n"
+                            "  br $out\n"
+                            "$out:\n"
+                            "  %%r: i32 = phi [ %%n: i32, $neg ], [ %%p: i32, $pos ]\n"
+                            "  ret %%r: i32\n"
+                            "}\n\n",
+                            i, i);
+  }
+  return text;
+}
+
+/**
+ * @brief 并行验证与串行验证的结果相同，与线程数无关；延迟加载的函数体先被物化
+ */
+int
+test_verifier_parallel()
+{
+  SUITE_START("Verifier: Parallel Module Verification");
+
+  enum
+  {
+    NUM_FUNCS = 200
+  };
+  char *text = make_module_text(NUM_FUNCS);
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the generated module");
+
+  static const size_t thread_counts[] = {0, 1, 2, 4, 8, 1000};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++)
+  {
+    SUITE_ASSERT(ir_verify_module_parallel(mod, thread_counts[i]), "A valid module should verify with %zu threads",
+                 thread_counts[i]);
+  }
+
+  /// 两个函数出错: 任何线程数都要失败
+  break_function(find_function(mod, "f150"));
+  break_function(find_function(mod, "f37"));
+  SUITE_ASSERT(!ir_verify_module(mod), "The broken module should fail serial verification");
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++)
+  {
+    SUITE_ASSERT(!ir_verify_module_parallel(mod, thread_counts[i]), "A broken module should fail with %zu threads",
+                 thread_counts[i]);
+  }
+  ir_context_destroy(ctx);
+
+  IRContext *lazy_ctx = ir_context_create();
+  IRModule *lazy = ir_parse_module_lazy(lazy_ctx, text);
+  SUITE_ASSERT(lazy != NULL, "Failed to load the generated module lazily");
+  SUITE_ASSERT(!ir_function_is_materialized(find_function(lazy, "f99")), "Bodies should start unmaterialized");
+  SUITE_ASSERT(ir_verify_module_parallel(lazy, 4), "The lazy module should verify in parallel");
+  SUITE_ASSERT(ir_function_is_materialized(find_function(lazy, "f99")), "Verification should materialize bodies");
+  ir_context_destroy(lazy_ctx);
+
+  free(text);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 增量验证只检查上次通过验证之后被修改过的函数
+ */
+int
+test_verifier_incremental()
+{
+  SUITE_START("Verifier: Incremental Verification");
+
+  char *text = make_module_text(20);
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the generated module");
+  IRFunction *f3 = find_function(mod, "f3");
+  IRFunction *f4 = find_function(mod, "f4");
+  IRFunction *f5 = find_function(mod, "f5");
+  IRFunction *f7 = find_function(mod, "f7");
+  SUITE_ASSERT(ir_function_is_verified(f3) && ir_function_is_verified(f4), "Parsing verifies every function");
+
+  /// RAUW 只标记使用方所在的函数
+  IRArgument *arg = list_entry(f3->arguments.next, IRArgument, list_node);
+  ir_value_replace_all_uses_with(&arg->value, ir_constant_get_i32(ctx, 7));
+  SUITE_ASSERT(!ir_function_is_verified(f3), "RAUW should mark @f3 as modified");
+  SUITE_ASSERT(ir_function_is_verified(f4), "@f4 was not touched");
+  SUITE_ASSERT(ir_verify_module_incremental(mod), "The module should still verify");
+  SUITE_ASSERT(ir_function_is_verified(f3), "A successful verification should clear the mark");
+
+  /// 绕过 API 的修改不会被发现 (调用者必须自己调用 ir_function_mark_modified)；完整验证总能发现
+  IRBasicBlock *last = list_entry(f7->basic_blocks.prev, IRBasicBlock, list_node);
+  list_del(last->instructions.prev);
+  SUITE_ASSERT(ir_verify_module_incremental(mod), "An unmarked edit is skipped by incremental verification");
+  SUITE_ASSERT(!ir_verify_module(mod), "Full verification should catch the unmarked edit");
+  SUITE_ASSERT(!ir_function_is_verified(f7), "A failed verification should leave the function marked");
+  SUITE_ASSERT(!ir_verify_module_incremental(mod), "@f7 should now be re-checked");
+  ir_context_destroy(ctx);
+
+  ctx = ir_context_create();
+  mod = ir_parse_module(ctx, text);
+  f5 = find_function(mod, "f5");
+  break_function(f5);
+  SUITE_ASSERT(!ir_function_is_verified(f5), "Erasing an instruction should mark @f5 as modified");
+  SUITE_ASSERT(!ir_verify_module_incremental(mod), "The broken @f5 should fail incremental verification");
+  SUITE_ASSERT(!ir_function_is_verified(f5), "@f5 is still broken");
+  ir_context_destroy(ctx);
+
+  free(text);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 结构级别不检查支配关系和 phi 与前驱的对应；以结构级别通过的函数在完整级别下重新检查
+ */
+int
+test_verifier_levels()
+{
+  SUITE_START("Verifier: Structural and Full Levels");
+
+  /// %x 定义在 $a 中，不支配 $m 中的使用；phi 缺少 $b 的入边
+  static const char text[] = "define i32 @dom(%c: i1) {\n"
+                             "$entry:\n"
+                             "  br %c: i1, $a, $b\n"
+                             "$a:\n"
+                             "  %x: i32 = add 1: i32, 2: i32\n"
+                             "  br $m\n"
+                             "$b:\n"
+                             "  br $m\n"
+                             "$m:\n"
+                             "  ret %x: i32\n"
+                             "}\n"
+                             "\n"
+                             "define i32 @phi(%c: i1) {\n"
+                             "$entry:\n"
+                             "  br %c: i1, $a, $b\n"
+                             "$a:\n"
+                             "  br $m\n"
+                             "$b:\n"
+                             "  br $m\n"
+                             "$m:\n"
+                             "  %p: i32 = phi [ 1: i32, $a ]\n"
+                             "  ret %p: i32\n"
+                             "}\n";
+  IRContext *ctx = ir_context_create();
+  SUITE_ASSERT(ir_parse_module(ctx, text) == NULL, "The default (full) level should reject the snippet");
+  ir_context_destroy(ctx);
+
+  ctx = ir_context_create();
+  ir_context_set_verify_level(ctx, IR_VERIFY_STRUCTURAL);
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "The structural level should accept the snippet");
+  IRFunction *dom = find_function(mod, "dom");
+  IRFunction *phi = find_function(mod, "phi");
+  SUITE_ASSERT(ir_function_is_verified(dom), "@dom passed the structural level");
+  SUITE_ASSERT(ir_verify_function(dom), "@dom is structurally well-formed");
+  SUITE_ASSERT(!ir_verify_function_level(dom, IR_VERIFY_FULL), "The full level should catch the dominance error");
+  SUITE_ASSERT(!ir_verify_function_level(phi, IR_VERIFY_FULL), "The full level should catch the missing phi entry");
+  SUITE_ASSERT(!ir_verify_module_level(mod, IR_VERIFY_FULL), "The module should fail the full level");
+
+  /// 结构错误在两个级别都会被发现
+  SUITE_ASSERT(ir_verify_function(phi), "@phi is structurally well-formed");
+  break_function(phi);
+  SUITE_ASSERT(!ir_verify_function(phi), "A block without a terminator should fail the structural level");
+  ir_context_destroy(ctx);
+
+  /// 以结构级别通过的函数在 Context 改为完整级别后需要重新检查
+  char *many = make_module_text(4);
+  ctx = ir_context_create();
+  ir_context_set_verify_level(ctx, IR_VERIFY_STRUCTURAL);
+  mod = ir_parse_module(ctx, many);
+  IRFunction *f1 = find_function(mod, "f1");
+  SUITE_ASSERT(ir_function_is_verified(f1), "@f1 passed the structural level");
+  ir_context_set_verify_level(ctx, IR_VERIFY_FULL);
+  SUITE_ASSERT(!ir_function_is_verified(f1), "@f1 has not passed the full level yet");
+  SUITE_ASSERT(ir_verify_module_incremental(mod), "The module is well-formed");
+  SUITE_ASSERT(ir_function_is_verified(f1), "@f1 passed the full level");
+  ir_context_set_verify_level(ctx, IR_VERIFY_STRUCTURAL);
+  SUITE_ASSERT(ir_verify_function(f1) && f1->verified_level == IR_VERIFY_FULL,
+               "A structural check of an unchanged function keeps the full level");
+  ir_context_destroy(ctx);
+  free(many);
+
+  SUITE_END();
+}
+
+/**
+ * @brief 块循环里的失败也要释放验证自己构建的 CFG (在 AddressSanitizer 构建里由泄漏检查确认)
+ */
+int
+test_verifier_failure_cleanup()
+{
+  SUITE_START("Verifier: Failures Release Their Analyses");
+
+  char *text = make_module_text(2);
+  IRContext *ctx = ir_context_create();
+  IRModule *mod = ir_parse_module(ctx, text);
+  SUITE_ASSERT(mod != NULL, "Failed to parse the generated module");
+  IRFunction *f0 = find_function(mod, "f0");
+  IRFunction *f1 = find_function(mod, "f1");
+
+  /// 在 CFG 建好之后才会检查到的错误: 块的 parent 指向别的函数
+  IRBasicBlock *last = list_entry(f1->basic_blocks.prev, IRBasicBlock, list_node);
+  last->parent = f0;
+  for (int i = 0; i < 3; i++)
+  {
+    SUITE_ASSERT(!ir_verify_function_level(f1, IR_VERIFY_FULL), "A block with the wrong parent should fail");
+    SUITE_ASSERT(!ir_function_is_verified(f1), "A failed verification should leave @f1 unverified");
+  }
+  last->parent = f1;
+  SUITE_ASSERT(ir_verify_function_level(f1, IR_VERIFY_FULL), "@f1 should verify once the parent is restored");
+  SUITE_ASSERT(ir_function_is_verified(f1), "@f1 passed the full level");
+
+  ir_context_destroy(ctx);
+  free(text);
+
+  SUITE_END();
+}
+
+int
+main()
+{
+  __calir_current_suite_name = "Verifier";
+  __calir_total_suites_run++;
+  if (test_verifier_phi() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_verifier_parallel() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_verifier_incremental() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_verifier_levels() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  __calir_total_suites_run++;
+  if (test_verifier_failure_cleanup() != 0)
+  {
+    __calir_total_suites_failed++;
+  }
+
+  TEST_SUMMARY();
+}